@@ -151,6 +151,8 @@ class PythonApiBuilder(SoftwareApiBuilder):
           ]
           fields_str = ", ".join(fields)
           return "StructType([" + fields_str + "])"
+        if mn == "array":
+          return f"ArrayType({py_type(type['element'])}, {type['size']})"
 
       assert False, "unimplemented type"
 
@@ -5,7 +5,6 @@
 import capnp
 import os
 from pathlib import Path
-import time
 import typing
 
 
@@ -76,6 +75,22 @@ class StructType(Type):
     return False
 
 
+class ArrayType(Type):
+
+  def __init__(self,
+               element_type: Type,
+               size: int,
+               type_id: typing.Optional[int] = None):
+    self.element_type = element_type
+    self.size = size
+    super().__init__(element_type.width * size, type_id)
+
+  def is_valid(self, obj) -> bool:
+    if not isinstance(obj, list) or len(obj) != self.size:
+      return False
+    return all([self.element_type.is_valid(item) for item in obj])
+
+
 class Port:
 
   def __init__(self,
@@ -95,6 +110,36 @@ class Port:
     self.write_type = write_type
 
 
+def _list_frames(frame_type: Type, items: typing.List) -> typing.List[dict]:
+  """Split 'items' into the bulk list frames of 'frame_type', a struct with a
+  list data array, an optional '<data>_size' item count, and a 'last' bit."""
+
+  if not isinstance(frame_type, StructType) or len(frame_type.fields) < 2:
+    raise ValueError(f"'{frame_type}' is not a list frame type")
+  (data_name, data_type) = frame_type.fields[0]
+  if not isinstance(data_type, ArrayType) or \
+     frame_type.fields[-1][0] != "last":
+    raise ValueError(f"'{frame_type}' is not a list frame type")
+  size_name = data_name + "_size"
+  has_size = any([fname == size_name for (fname, _) in frame_type.fields])
+  if not has_size and data_type.size != 1:
+    raise ValueError(f"'{frame_type}' is not a list frame type")
+
+  frames = []
+  items_per_frame = data_type.size
+  for start in range(0, max(len(items), 1), items_per_frame):
+    chunk = items[start:start + items_per_frame]
+    frame = {
+        # Pad the last frame. The padding is ignored by the receiver.
+        data_name: chunk + [0] * (items_per_frame - len(chunk)),
+        "last": int(start + items_per_frame >= len(items))
+    }
+    if has_size:
+      frame[size_name] = len(chunk)
+    frames.append(frame)
+  return frames
+
+
 class WritePort(Port):
 
   def write(self, msg=None) -> bool:
@@ -105,6 +150,19 @@ class WritePort(Port):
       raise ValueError("Backend does not support implementation of port")
     return self._backend.write(msg)
 
+  def write_list(self, items: typing.List) -> bool:
+    """Send a whole list through a port whose type is a bulk list frame. The
+    list is split into as many frames as needed, which are all sent at once."""
+    assert self.write_type is not None, "Expected non-None write_type"
+    if self._backend is None:
+      raise ValueError("Backend does not support implementation of port")
+    frames = _list_frames(self.write_type, items)
+    for frame in frames:
+      if not self.write_type.is_valid(frame):
+        raise ValueError(
+            f"'{frame}' cannot be converted to '{self.write_type}'")
+    return self._backend.write_many(frames)
+
 
 class ReadPort(Port):
 
@@ -299,6 +357,16 @@ class _CosimPort:
     self._endpoint.send(self._write_convert.write(msg)).wait()
     return True
 
+  def write_many(self, msgs: typing.List) -> bool:
+    """Write a list of messages to this port in one request. Either all or none
+    of the messages are sent."""
+    req = self._endpoint.sendMany_request()
+    req_msgs = req.init("msgs", len(msgs))
+    for (req_msg, msg) in zip(req_msgs, msgs):
+      req_msg.msg = self._write_convert.write(msg)
+    req.send().wait()
+    return True
+
   def read(self, blocking_time: typing.Optional[float]):
     """Read a message from this port. If 'blocking_timeout' is None, return
     immediately. Otherwise, wait up to 'blocking_timeout' for a message. Returns
@@ -308,16 +376,10 @@ class _CosimPort:
       # Non-blocking.
       recvResp = self._endpoint.recv(False).wait()
     else:
-      # Blocking. Since our cosim rpc server doesn't currently support blocking
-      # reads, use polling instead.
-      e = time.time() + blocking_time
-      recvResp = None
-      while recvResp is None or e > time.time():
-        recvResp = self._endpoint.recv(False).wait()
-        if recvResp.hasData:
-          break
-        else:
-          time.sleep(0.001)
+      # Blocking. The server waits for the message, up to the timeout. A zero
+      # timeout would make it wait forever.
+      timeout_ms = max(1, int(blocking_time * 1000))
+      recvResp = self._endpoint.recv(True, timeout_ms).wait()
     if not recvResp.hasData:
       return None
     assert recvResp.resp is not None
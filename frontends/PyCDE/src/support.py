@@ -63,6 +63,23 @@ def create_const_zero(type):
     return hw.BitcastOp(type, zero)
 
 
+def build_operations(ops, inputs=[]):
+  """Create many operations at the current insertion point with a single call
+  into C++, which is much faster than creating them one at a time from Python.
+  `ops` is a list of `(name, operands, result_types, attributes)` tuples. Each
+  operand is an `(op, result)` pair which refers to a result of an earlier
+  operation in the list or, if `op` is negative, to `inputs[result]`. Returns
+  the created operations."""
+  from .circt.dialects import hw as raw_hw
+  ip = ir.InsertionPoint.current
+  before = ip.ref_operation
+  if before is not None:
+    before = before.operation
+  values = [v.value if hasattr(v, "value") else v for v in inputs]
+  return raw_hw.build_operations(ip.block.owner.operation, before,
+                                 get_user_loc(), values, ops)
+
+
 def _infer_type(x):
   """Infer the CIRCT type from a python object. Only works on lists."""
   from .types import Array
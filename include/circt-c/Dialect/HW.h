@@ -29,6 +29,28 @@ struct HWStructFieldInfo {
 };
 typedef struct HWStructFieldInfo HWStructFieldInfo;
 
+/// A reference to a value in a bulk construction call. If `op` is
+/// non-negative, this is result `result` of the `op`th operation created by the
+/// same call. Otherwise it is the `result`th value of the inputs.
+struct HWBulkValueRef {
+  intptr_t op;
+  intptr_t result;
+};
+typedef struct HWBulkValueRef HWBulkValueRef;
+
+/// The description of an operation to be created in a bulk construction call.
+/// Operations with regions are not supported.
+struct HWBulkOperation {
+  MlirStringRef name;
+  intptr_t numOperands;
+  HWBulkValueRef const *operands;
+  intptr_t numResults;
+  MlirType const *resultTypes;
+  intptr_t numAttributes;
+  MlirNamedAttribute const *attributes;
+};
+typedef struct HWBulkOperation HWBulkOperation;
+
 //===----------------------------------------------------------------------===//
 // Dialect API.
 //===----------------------------------------------------------------------===//
@@ -140,6 +162,22 @@ MLIR_CAPI_EXPORTED MlirType hwParamDeclRefAttrGetType(MlirAttribute decl);
 MLIR_CAPI_EXPORTED bool hwAttrIsAParamVerbatimAttr(MlirAttribute);
 MLIR_CAPI_EXPORTED MlirAttribute hwParamVerbatimAttrGet(MlirAttribute text);
 
+//===----------------------------------------------------------------------===//
+// Bulk construction API.
+//===----------------------------------------------------------------------===//
+
+/// Create the `numOps` operations described by `ops`, in order, at location
+/// `loc`. They are inserted before `before` if it is not null, otherwise at the
+/// end of `block`. This builds entire netlists (instances, wires, expression
+/// DAGs) in a single call instead of one call per operation. The created
+/// operations are written to `createdOps`. Returns false and creates nothing
+/// if an operation name is not registered or a value reference is invalid.
+/// The created operations are not verified.
+MLIR_CAPI_EXPORTED bool
+hwBuildOperations(MlirBlock block, MlirOperation before, MlirLocation loc,
+                  intptr_t numInputs, MlirValue const *inputs, intptr_t numOps,
+                  HWBulkOperation const *ops, MlirOperation *createdOps);
+
 #ifdef __cplusplus
 }
 #endif
@@ -52,7 +52,8 @@ struct OMEvaluator {
 typedef struct OMEvaluator OMEvaluator;
 
 /// A value type for use in C APIs that just wraps a pointer to an Object.
-/// This is in line with the usual MLIR DEFINE_C_API_STRUCT.
+/// This is in line with the usual MLIR DEFINE_C_API_STRUCT. Objects are owned
+/// by the Evaluator that instantiated them.
 struct OMObject {
   void *ptr;
 };
@@ -105,6 +106,11 @@ MLIR_CAPI_EXPORTED MlirType omEvaluatorObjectGetType(OMObject object);
 MLIR_CAPI_EXPORTED OMObjectValue omEvaluatorObjectGetField(OMObject object,
                                                            MlirAttribute name);
 
+/// Serialize an Object and everything it refers to as JSON, which is streamed
+/// to the callback in chunks.
+MLIR_CAPI_EXPORTED MlirLogicalResult omEvaluatorObjectSerializeJSON(
+    OMObject object, MlirStringCallback callback, void *userData);
+
 //===----------------------------------------------------------------------===//
 // ObjectValue API.
 //===----------------------------------------------------------------------===//
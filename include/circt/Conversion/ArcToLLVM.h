@@ -13,7 +13,9 @@
 #include <memory>
 
 namespace circt {
-std::unique_ptr<OperationPass<ModuleOp>> createLowerArcToLLVMPass();
+std::unique_ptr<OperationPass<ModuleOp>>
+createLowerArcToLLVMPass(unsigned lanes = 1,
+                         unsigned wideVectorThreshold = 0);
 } // namespace circt
 
 #endif // CIRCT_CONVERSION_ARCTOLLVM_H
@@ -21,8 +21,12 @@ namespace circt {
 std::unique_ptr<mlir::Pass>
 createExportChiselInterfacePass(llvm::raw_ostream &os);
 
+/// Create a pass emitting the Chisel interface of each public module into
+/// `outputDirectory`. If `onlyWriteChanged` is set, files whose contents are
+/// unchanged are not rewritten.
 std::unique_ptr<mlir::Pass>
-createExportSplitChiselInterfacePass(mlir::StringRef outputDirectory = "./");
+createExportSplitChiselInterfacePass(mlir::StringRef outputDirectory = "./",
+                                     bool onlyWriteChanged = false);
 
 std::unique_ptr<mlir::Pass> createExportChiselInterfacePass();
 
@@ -25,11 +25,21 @@ std::unique_ptr<mlir::Pass> createTestApplyLoweringOptionPass();
 std::unique_ptr<mlir::Pass> createPrepareForEmissionPass();
 std::unique_ptr<mlir::Pass> createLegalizeAnonEnumsPass();
 
-std::unique_ptr<mlir::Pass> createExportVerilogPass(llvm::raw_ostream &os);
+/// Create a pass emitting the design to `os`.  If `moduleCacheDir` is given,
+/// the output of each module is cached in that directory, and reused by later
+/// runs for modules which did not change.
+std::unique_ptr<mlir::Pass>
+createExportVerilogPass(llvm::raw_ostream &os,
+                        llvm::StringRef moduleCacheDir = {});
 std::unique_ptr<mlir::Pass> createExportVerilogPass();
 
+/// Create a pass emitting one file per SV module into `directory`.  If
+/// `onlyWriteChanged` is set, files whose contents are unchanged are not
+/// rewritten, and the files that were written are listed in a
+/// `changed-files.f` manifest.
 std::unique_ptr<mlir::Pass>
-createExportSplitVerilogPass(llvm::StringRef directory = "./");
+createExportSplitVerilogPass(llvm::StringRef directory = "./",
+                             bool onlyWriteChanged = false);
 
 /// Export a module containing HW, and SV dialect code. Requires that the SV
 /// dialect is loaded in to the context.
@@ -16,7 +16,24 @@ class Pass;
 } // namespace mlir
 
 namespace circt {
-std::unique_ptr<mlir::Pass> createConvertFSMToSVPass();
+
+/// The ways in which the states of a machine can be encoded in its state
+/// register.
+enum class FSMStateEncoding {
+  /// An `hw.enum` typedef with one field per state.
+  Enum,
+  /// An integer holding the index of the state.
+  Binary,
+  /// An integer holding the Gray code of the state's index.
+  Gray,
+  /// One register bit per state, decoded with a `casez`.
+  OneHot,
+  /// One-hot or binary, depending on the number of states and transitions.
+  Auto
+};
+
+std::unique_ptr<mlir::Pass>
+createConvertFSMToSVPass(FSMStateEncoding encoding = FSMStateEncoding::Enum);
 } // namespace circt
 
 #endif // CIRCT_CONVERSION_FSMTOSV_FSMTOSV_H
@@ -182,9 +182,13 @@ public:
   // Replaces standard memory ops with their handshake version (i.e.,
   // ops which connect to memory/LSQ). Returns a map with an ordered
   // list of new ops corresponding to each memref. Later, we instantiate
-  // a memory node for each memref and connect it to its load/store ops
+  // a memory node for each memref and connect it to its load/store ops.
+  // If relaxMemoryOrdering is set, pairs of accesses within a block which
+  // provably never touch the same address are recorded as independent, such
+  // that they are not ordered with respect to each other.
   LogicalResult replaceMemoryOps(ConversionPatternRewriter &rewriter,
-                                 MemRefToMemoryAccessOp &memRefOps);
+                                 MemRefToMemoryAccessOp &memRefOps,
+                                 bool relaxMemoryOrdering);
 
   LogicalResult connectToMemory(ConversionPatternRewriter &rewriter,
                                 MemRefToMemoryAccessOp memRefOps, bool lsq);
@@ -209,6 +213,10 @@ protected:
 
 private:
   DenseMap<Block *, Value> blockEntryControlMap;
+
+  /// Pairs of memory accesses (in program order) which may execute in any
+  /// order, since they never access the same address.
+  DenseSet<std::pair<Operation *, Operation *>> independentAccesses;
 };
 
 // Driver for the HandshakeLowering class.
@@ -232,13 +240,14 @@ LogicalResult runPartialLowering(
 // type TTerm. See HandshakeLowering for the different lowering steps.
 template <typename TTerm>
 LogicalResult lowerRegion(HandshakeLowering &hl, bool sourceConstants,
-                          bool disableTaskPipelining) {
+                          bool disableTaskPipelining,
+                          bool relaxMemoryOrdering = false) {
   //  Perform initial dataflow conversion. This process allows for the use of
   //  non-deterministic merge-like operations.
   HandshakeLowering::MemRefToMemoryAccessOp memOps;
 
-  if (failed(
-          runPartialLowering(hl, &HandshakeLowering::replaceMemoryOps, memOps)))
+  if (failed(runPartialLowering(hl, &HandshakeLowering::replaceMemoryOps,
+                                memOps, relaxMemoryOrdering)))
     return failure();
   if (failed(runPartialLowering(hl,
                                 &HandshakeLowering::setControlOnlyPath<TTerm>)))
@@ -290,7 +299,8 @@ createHandshakeAnalysisPass();
 
 std::unique_ptr<mlir::OperationPass<mlir::ModuleOp>>
 createStandardToHandshakePass(bool sourceConstants = false,
-                              bool disableTaskPipelining = false);
+                              bool disableTaskPipelining = false,
+                              bool relaxMemoryOrdering = false);
 
 std::unique_ptr<mlir::OperationPass<handshake::FuncOp>>
 createHandshakeCanonicalizePass();
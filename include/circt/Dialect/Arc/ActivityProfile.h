@@ -0,0 +1,71 @@
+//===- ActivityProfile.h - Activity profiles of arc models ------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// An activity profile records how often the arcs of a model are called and how
+// often its states change while the model runs. The `arc-add-activity-counters`
+// pass adds counters for these to the model's state, whose final values form
+// the profile. Later runs of the pipeline on the same design use the profile
+// to guide their optimizations.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CIRCT_DIALECT_ARC_ACTIVITYPROFILE_H
+#define CIRCT_DIALECT_ARC_ACTIVITYPROFILE_H
+
+#include "circt/Support/LLVM.h"
+#include "llvm/ADT/StringMap.h"
+
+namespace circt {
+namespace arc {
+
+/// The name prefixes of the counter states added by
+/// `arc-add-activity-counters`. They are followed by the name of the arc or
+/// state being counted and a `.<N>` suffix that distinguishes the counters of
+/// different call sites and writes.
+constexpr llvm::StringLiteral callCounterPrefix = "arc_profile.calls.";
+constexpr llvm::StringLiteral toggleCounterPrefix = "arc_profile.toggles.";
+
+struct ActivityProfile {
+  /// The number of cycles the model ran for.
+  uint64_t numCycles = 0;
+  /// The number of times each arc was called, by arc name.
+  llvm::StringMap<uint64_t> calls;
+  /// The number of times each state changed its value, by state name.
+  llvm::StringMap<uint64_t> toggles;
+
+  /// Add the final value of the counter state `name` to the profile. Returns
+  /// false if `name` is not the name of a counter.
+  bool addCounter(StringRef name, uint64_t value);
+
+  /// Return the number of calls of an arc, or std::nullopt if the profile has
+  /// no information about the arc.
+  std::optional<uint64_t> getCalls(StringRef arcName) const;
+
+  /// Return the number of changes of a state, or std::nullopt if the profile
+  /// has no information about the state.
+  std::optional<uint64_t> getToggles(StringRef stateName) const;
+
+  /// Check whether an arc was called in at least as many cycles as the model
+  /// ran for.
+  bool isHot(StringRef arcName) const;
+
+  /// Check whether an arc was never called.
+  bool isCold(StringRef arcName) const;
+
+  /// Print the profile as JSON.
+  void print(llvm::raw_ostream &os) const;
+
+  /// Load a profile from a JSON file. Emits an error at `loc` and returns
+  /// failure if the file cannot be read or is not a valid profile.
+  static FailureOr<ActivityProfile> load(StringRef path, Location loc);
+};
+
+} // namespace arc
+} // namespace circt
+
+#endif // CIRCT_DIALECT_ARC_ACTIVITYPROFILE_H
@@ -26,4 +26,15 @@
 #define GET_OP_CLASSES
 #include "circt/Dialect/Arc/Arc.h.inc"
 
+namespace circt {
+namespace arc {
+
+/// Return the name of the function that the `index`-th clock tree of a model
+/// is lowered to, counting the clock trees that are not partitions of another
+/// in the order of the model's body.
+std::string getClockFunctionName(llvm::StringRef modelName, unsigned index);
+
+} // namespace arc
+} // namespace circt
+
 #endif // CIRCT_DIALECT_ARC_ARCOPS_H
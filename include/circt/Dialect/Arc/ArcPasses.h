@@ -19,27 +19,43 @@ class Pass;
 namespace circt {
 namespace arc {
 
+std::unique_ptr<mlir::Pass> createAddActivityCountersPass();
 std::unique_ptr<mlir::Pass>
 createAddTapsPass(llvm::Optional<bool> tapPorts = {},
                   llvm::Optional<bool> tapWires = {},
                   llvm::Optional<bool> tapNamedValues = {});
-std::unique_ptr<mlir::Pass> createAllocateStatePass();
+std::unique_ptr<mlir::Pass>
+createAllocateStatePass(llvm::Optional<unsigned> lanes = {},
+                        llvm::Optional<bool> cacheAware = {},
+                        llvm::StringRef profileFile = "",
+                        llvm::Optional<bool> packBits = {});
 std::unique_ptr<mlir::Pass> createArcCanonicalizerPass();
+std::unique_ptr<mlir::Pass> createCoalesceStateWritesPass();
 std::unique_ptr<mlir::Pass> createDedupPass();
+std::unique_ptr<mlir::Pass> createGateIdleArcsPass();
 std::unique_ptr<mlir::Pass> createGroupResetsAndEnablesPass();
-std::unique_ptr<mlir::Pass> createInferMemoriesPass();
+std::unique_ptr<mlir::Pass>
+createInferMemoriesPass(llvm::Optional<uint64_t> sparseThreshold = {});
 std::unique_ptr<mlir::Pass> createInferStatePropertiesPass();
-std::unique_ptr<mlir::Pass> createInlineArcsPass();
+std::unique_ptr<mlir::Pass>
+createInlineArcsPass(llvm::StringRef profileFile = "");
 std::unique_ptr<mlir::Pass> createInlineModulesPass();
 std::unique_ptr<mlir::Pass> createIsolateClocksPass();
 std::unique_ptr<mlir::Pass> createLatencyRetimingPass();
 std::unique_ptr<mlir::Pass> createLegalizeStateUpdatePass();
-std::unique_ptr<mlir::Pass> createLowerClocksToFuncsPass();
+std::unique_ptr<mlir::Pass>
+createLowerClocksToFuncsPass(unsigned maxOpsPerFunc = 0);
+std::unique_ptr<mlir::Pass> createLowerInteropPass();
 std::unique_ptr<mlir::Pass> createLowerLUTPass();
 std::unique_ptr<mlir::Pass> createLowerStatePass();
-std::unique_ptr<mlir::Pass> createMakeTablesPass();
+std::unique_ptr<mlir::Pass>
+createMakeTablesPass(llvm::StringRef profileFile = "");
 std::unique_ptr<mlir::Pass> createMuxToControlFlowPass();
 std::unique_ptr<mlir::Pass>
+createPartitionClocksPass(llvm::Optional<unsigned> partitions = {});
+std::unique_ptr<mlir::Pass>
+createPrintCostProfilePass(llvm::StringRef profileFile = "");
+std::unique_ptr<mlir::Pass>
 createPrintStateInfoPass(llvm::StringRef stateFile = "");
 std::unique_ptr<mlir::Pass> createSimplifyVariadicOpsPass();
 std::unique_ptr<mlir::Pass> createSplitLoopsPass();
@@ -30,6 +30,7 @@ std::unique_ptr<OperationPass<ModuleOp>> createESItoHWPass();
 std::unique_ptr<OperationPass<ModuleOp>> createESIConnectServicesPass();
 std::unique_ptr<OperationPass<ModuleOp>> createESIAddCPPAPIPass();
 std::unique_ptr<OperationPass<ModuleOp>> createESICleanMetadataPass();
+std::unique_ptr<OperationPass<ModuleOp>> createESIProfileChannelsPass();
 
 /// Generate the code for registering passes.
 #define GEN_PASS_REGISTRATION
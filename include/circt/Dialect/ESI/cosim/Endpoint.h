@@ -13,30 +13,114 @@
 #ifndef CIRCT_DIALECT_ESI_COSIM_ENDPOINT_H
 #define CIRCT_DIALECT_ESI_COSIM_ENDPOINT_H
 
+#include <atomic>
+#include <cstdint>
 #include <functional>
 #include <map>
 #include <memory>
 #include <mutex>
-#include <queue>
+#include <string>
+#include <vector>
+
+namespace esi {
+namespace runtime {
+namespace cosim {
+namespace shm {
+class Segment;
+} // namespace shm
+} // namespace cosim
+} // namespace runtime
+} // namespace esi
 
 namespace circt {
 namespace esi {
 namespace cosim {
 
+/// A bounded, lock-free queue of messages between exactly one producer thread
+/// and one consumer thread. The message buffers are allocated once up front,
+/// with room for messages of the expected maximum size, and are reused for
+/// every message passing through the queue.
+class MessageQueue {
+public:
+  using Blob = std::vector<uint8_t>;
+
+  MessageQueue(size_t capacity, size_t maxMessageSize)
+      : slots(capacity ? capacity : 1) {
+    for (auto &slot : slots)
+      slot.reserve(maxMessageSize);
+  }
+  MessageQueue(const MessageQueue &) = delete;
+
+  /// Producer side: return the buffer of the next free slot to be filled by
+  /// the caller, or nullptr if the queue is full. The message is only visible
+  /// to the consumer after a call to `push`.
+  Blob *reserve() {
+    size_t t = tail.load(std::memory_order_relaxed);
+    if (t - head.load(std::memory_order_acquire) == slots.size())
+      return nullptr;
+    return &slots[t % slots.size()];
+  }
+
+  /// Producer side: return the number of slots which may be reserved and
+  /// pushed before the queue is full.
+  size_t getNumFree() const {
+    return slots.size() - (tail.load(std::memory_order_relaxed) -
+                           head.load(std::memory_order_acquire));
+  }
+
+  /// Producer side: publish the message written to the reserved slot.
+  void push() {
+    tail.store(tail.load(std::memory_order_relaxed) + 1,
+               std::memory_order_release);
+  }
+
+  /// Consumer side: return the oldest message, or nullptr if the queue is
+  /// empty. The message stays valid until the next call to `pop`.
+  const Blob *front() {
+    size_t h = head.load(std::memory_order_relaxed);
+    if (h == tail.load(std::memory_order_acquire))
+      return nullptr;
+    return &slots[h % slots.size()];
+  }
+
+  /// Consumer side: return the number of messages which may be popped.
+  size_t getNumQueued() const {
+    return tail.load(std::memory_order_acquire) -
+           head.load(std::memory_order_relaxed);
+  }
+
+  /// Consumer side: release the oldest message for reuse.
+  void pop() {
+    head.store(head.load(std::memory_order_relaxed) + 1,
+               std::memory_order_release);
+  }
+
+private:
+  std::vector<Blob> slots;
+  /// The number of messages consumed so far. Only written by the consumer.
+  alignas(64) std::atomic<size_t> head = 0;
+  /// The number of messages produced so far. Only written by the producer.
+  alignas(64) std::atomic<size_t> tail = 0;
+};
+
 /// Implements a bi-directional, thread-safe bridge between the RPC server and
 /// DPI functions.
 ///
+/// Messages are passed through lock-free single-producer, single-consumer
+/// queues in both directions. The RPC server runs all clients on a single
+/// thread and the simulation calls the DPI functions from a single thread, so
+/// each queue has exactly one producer and one consumer.
+///
 /// Several of the methods below are inline with the declaration to make them
 /// candidates for inlining during compilation. This is particularly important
 /// on the simulation side since polling happens at each clock and we do not
 /// want to slow down the simulation any more than necessary.
 class Endpoint {
 public:
-  /// Representing messages as shared pointers to vectors may be a performance
-  /// issue in the future but it is the easiest way to ensure memory
-  /// correctness.
-  using Blob = std::vector<uint8_t>;
-  using BlobPtr = std::shared_ptr<Blob>;
+  using Blob = MessageQueue::Blob;
+
+  /// The number of messages which may be queued in each direction.
+  static constexpr size_t queueCapacity = 256;
 
   /// Construct an endpoint which knows and the type IDs in both directions.
   Endpoint(uint64_t sendTypeId, int sendTypeMaxSize, uint64_t recvTypeId,
@@ -54,55 +138,67 @@ public:
   bool setInUse();
   void returnForUse();
 
-  /// Queue message to the simulation.
-  void pushMessageToSim(BlobPtr msg) {
-    Lock g(m);
-    toCosim.push(msg);
-  }
+  /// Return a buffer to write the next message to the simulation to, or
+  /// nullptr if the queue is full. The message is queued by
+  /// `pushMessageToSim`.
+  Blob *reserveMessageToSim() { return toCosim.reserve(); }
+  void pushMessageToSim() { toCosim.push(); }
+  /// Return the number of messages which may still be queued to the
+  /// simulation.
+  size_t getNumFreeToSim() const { return toCosim.getNumFree(); }
 
-  /// Pop from the to-simulator queue. Return true if there was a message in the
-  /// queue.
-  bool getMessageToSim(BlobPtr &msg) {
-    Lock g(m);
-    if (toCosim.empty())
-      return false;
-    msg = toCosim.front();
-    toCosim.pop();
-    return true;
-  }
+  /// Return the oldest message to the simulation, or nullptr if there is none.
+  /// The message is valid until it is removed with `popMessageToSim`.
+  const Blob *peekMessageToSim() { return toCosim.front(); }
+  void popMessageToSim() { toCosim.pop(); }
 
-  /// Queue message to the RPC client.
-  void pushMessageToClient(BlobPtr msg) {
-    Lock g(m);
-    toClient.push(msg);
-  }
+  /// Return a buffer to write the next message to the RPC client to, or
+  /// nullptr if the queue is full. The message is queued by
+  /// `pushMessageToClient`.
+  Blob *reserveMessageToClient() { return toClient.reserve(); }
+  void pushMessageToClient() { toClient.push(); }
 
-  /// Pop from the to-RPC-client queue. Return true if there was a message in
-  /// the queue.
-  bool getMessageToClient(BlobPtr &msg) {
-    Lock g(m);
-    if (toClient.empty())
-      return false;
-    msg = toClient.front();
-    toClient.pop();
-    return true;
+  /// Return the oldest message to the RPC client, or nullptr if there is none.
+  /// The message is valid until it is removed with `popMessageToClient`.
+  const Blob *peekMessageToClient() { return toClient.front(); }
+  void popMessageToClient() { toClient.pop(); }
+  /// Return the number of messages queued to the RPC client.
+  size_t getNumQueuedToClient() const { return toClient.getNumQueued(); }
+
+  using SharedMemory = ::esi::runtime::cosim::shm::Segment;
+
+  /// Switch the messages of this endpoint over to a shared memory segment
+  /// until `closeSharedMemory` is called. Creates the segment on first use and
+  /// returns its name. Throws std::runtime_error on failure.
+  const std::string &openSharedMemory();
+  void closeSharedMemory() { shmOpen.store(false, std::memory_order_release); }
+
+  /// Return the shared memory segment if the client uses it instead of the
+  /// message queues, or nullptr otherwise.
+  SharedMemory *getSharedMemory() {
+    return shmOpen.load(std::memory_order_acquire) ? shm.get() : nullptr;
   }
 
 private:
   const uint64_t sendTypeId;
   const uint64_t recvTypeId;
+  const int sendTypeMaxSize;
+  const int recvTypeMaxSize;
   bool inUse;
 
   using Lock = std::lock_guard<std::mutex>;
 
-  /// This class needs to be thread-safe. All of the mutable member variables
-  /// are protected with this object-wide lock. This may be a performance issue
-  /// in the future.
+  /// Protects the inUse flag. The message queues do not need a lock.
   std::mutex m;
   /// Message queue from RPC client to the simulation.
-  std::queue<BlobPtr> toCosim;
+  MessageQueue toCosim;
   /// Message queue to RPC client from the simulation.
-  std::queue<BlobPtr> toClient;
+  MessageQueue toClient;
+  /// The shared memory segment. Only created and destroyed by the RPC server
+  /// thread, and kept until the endpoint is destroyed, so the simulation may
+  /// keep using it for the rest of a DPI call after it has been closed.
+  std::unique_ptr<SharedMemory> shm;
+  std::atomic<bool> shmOpen = false;
 };
 
 /// The Endpoint registry is where Endpoints report their existence (register)
@@ -110,10 +206,11 @@ private:
 class EndpointRegistry {
 public:
   /// Register an Endpoint. Creates the Endpoint object and owns it. Returns
-  /// false if unsuccessful.
-  bool registerEndpoint(std::string epId, uint64_t sendTypeId,
-                        int sendTypeMaxSize, uint64_t recvTypeId,
-                        int recvTypeMaxSize);
+  /// the handle of the new endpoint, or -1 if unsuccessful. Handles are
+  /// assigned consecutively from zero.
+  int registerEndpoint(std::string epId, uint64_t sendTypeId,
+                       int sendTypeMaxSize, uint64_t recvTypeId,
+                       int recvTypeMaxSize);
 
   /// Get the specified endpoint. Return nullptr if it does not exist. This
   /// method is defined inline so it can be inlined at compile time. Performance
@@ -127,6 +224,20 @@ public:
     return &it->second;
   }
 
+  /// Get the endpoint with the specified handle. Returns nullptr if it does
+  /// not exist. Endpoints are only registered by the simulation, which is also
+  /// the only user of handles, so this is lock-free to keep the per-tick DPI
+  /// calls cheap.
+  Endpoint *getByHandle(int handle) {
+    if (handle < 0 || (size_t)handle >= handles.size())
+      return nullptr;
+    return &handles[handle]->second;
+  }
+  /// Get the ID of the endpoint with the specified handle, which must exist.
+  const std::string &getId(int handle) const { return handles[handle]->first; }
+  /// Return the number of handles given out, i.e. one past the largest.
+  int getNumHandles() const { return handles.size(); }
+
   /// Iterate over the list of endpoints, calling the provided function for each
   /// endpoint.
   void iterateEndpoints(
@@ -142,6 +253,9 @@ private:
 
   /// Endpoint ID to object pointer mapping.
   std::map<std::string, Endpoint> endpoints;
+  /// Handle to endpoint mapping. Map entries are never moved, so pointing into
+  /// the map is safe.
+  std::vector<std::map<std::string, Endpoint>::value_type *> handles;
 };
 
 } // namespace cosim
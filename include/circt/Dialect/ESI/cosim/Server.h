@@ -17,6 +17,7 @@
 #define CIRCT_DIALECT_ESI_COSIM_SERVER_H
 
 #include "circt/Dialect/ESI/cosim/Endpoint.h"
+#include <atomic>
 #include <thread>
 
 namespace circt {
@@ -38,6 +39,11 @@ public:
   void run(uint16_t port);
   void stop();
 
+  /// Wake up the server thread to complete the blocking recv() calls waiting
+  /// for a message. Call this from any thread after queueing a message to a
+  /// client.
+  void wakeUp();
+
 private:
   using Lock = std::lock_guard<std::mutex>;
 
@@ -45,8 +51,11 @@ private:
   void mainLoop(uint16_t port);
 
   std::thread *mainThread;
-  volatile bool stopSig;
+  std::atomic<bool> stopSig;
   std::mutex m;
+  /// A pipe written to by `wakeUp` to wake up the server thread. Unused on
+  /// Windows.
+  int wakeupFds[2] = {-1, -1};
 };
 
 } // namespace cosim
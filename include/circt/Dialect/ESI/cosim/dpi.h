@@ -30,6 +30,10 @@ extern "C" {
 DPI int sv2cCosimserverEpRegister(char *endpointId, long long sendTypeId,
                                   int sendTypeSize, long long recvTypeId,
                                   int recvTypeSize);
+/// Register an endpoint and return its handle.
+DPI int sv2cCosimserverEpRegisterHandle(char *endpointId, long long sendTypeId,
+                                        int sendTypeSize, long long recvTypeId,
+                                        int recvTypeSize);
 /// Try to get a message from a client.
 DPI int sv2cCosimserverEpTryGet(char *endpointId,
                                 // NOLINTNEXTLINE(misc-misplaced-const)
@@ -39,6 +43,20 @@ DPI int sv2cCosimserverEpTryGet(char *endpointId,
 DPI int sv2cCosimserverEpTryPut(char *endpointId,
                                 // NOLINTNEXTLINE(misc-misplaced-const)
                                 const svOpenArrayHandle data, int dataLimit);
+/// Try to get a message from a client, by endpoint handle.
+DPI int sv2cCosimserverEpTryGetHandle(int handle,
+                                      // NOLINTNEXTLINE(misc-misplaced-const)
+                                      const svOpenArrayHandle data,
+                                      unsigned int *sizeBytes);
+/// Send a message to a client, by endpoint handle.
+DPI int sv2cCosimserverEpTryPutHandle(int handle,
+                                      // NOLINTNEXTLINE(misc-misplaced-const)
+                                      const svOpenArrayHandle data,
+                                      int dataLimit);
+/// Flag the endpoints which have a message from a client, by handle.
+DPI int sv2cCosimserverEpPollAll(
+    // NOLINTNEXTLINE(misc-misplaced-const)
+    const svOpenArrayHandle hasMsg);
 
 /// Start the server. Not required as the first endpoint registration will do
 /// this. Provided if one wants to start the server early.
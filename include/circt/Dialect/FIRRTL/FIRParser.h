@@ -32,6 +32,11 @@ struct FIRParserOptions {
   /// If this is set to true, the @info locators are ignored, and the locations
   /// are set to the location in the .fir file.
   bool ignoreInfoLocators = false;
+  /// If this is set to true, the columns of the @info locators are dropped,
+  /// such that all operations created from the same source line share one
+  /// location, and the parts of a compound locator on the same line are
+  /// merged. This keeps the number of distinct locations small.
+  bool compactInfoLocators = false;
   /// The number of annotation files that were specified on the command line.
   /// This, along with numOMIRFiles provides structure to the buffers in the
   /// source manager.
@@ -45,12 +50,22 @@ mlir::OwningOpRef<mlir::ModuleOp> importFIRFile(llvm::SourceMgr &sourceMgr,
                                                 mlir::TimingScope &ts,
                                                 FIRParserOptions options = {});
 
+/// Attach the annotation files and OMIR files in `sourceMgr`, laid out after
+/// the main file as for `importFIRFile`, to the circuits of a `module` which
+/// was parsed from another format than .fir, such as MLIR bytecode. The
+/// annotations are appended to the raw annotations of the circuits, to be
+/// handled by the LowerAnnotations pass.
+mlir::LogicalResult importAnnotationFiles(llvm::SourceMgr &sourceMgr,
+                                          mlir::ModuleOp module,
+                                          unsigned numAnnotationFiles);
+
 // Decode a source locator string `spelling`, returning a pair indicating that
 // the `spelling` was correct and an optional location attribute.  The
 // `skipParsing` option can be used to short-circuit parsing and just do
 // validation of the `spelling`.  This require both an Identifier and a
 // FileLineColLoc to use for caching purposes and context as the cache may be
-// updated with a new identifier.
+// updated with a new identifier.  The `dropColumns` option sets the column of
+// all decoded locations to zero.
 //
 // This utility exists because source locators can exist outside of normal
 // "parsing".  E.g., these can show up in annotations or in Object Model 2.0
@@ -62,7 +77,7 @@ std::pair<bool, std::optional<mlir::LocationAttr>>
 maybeStringToLocation(llvm::StringRef spelling, bool skipParsing,
                       mlir::StringAttr &locatorFilenameCache,
                       FileLineColLoc &fileLineColLocCache,
-                      MLIRContext *context);
+                      MLIRContext *context, bool dropColumns = false);
 
 void registerFromFIRFileTranslation();
 
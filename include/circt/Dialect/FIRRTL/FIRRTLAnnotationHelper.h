@@ -132,9 +132,23 @@ struct CircuitTargetCache {
 
   /// Lookup the target for 'name' in 'module'.
   AnnoTarget lookup(FModuleLike module, StringRef name) {
-    return getOrCreateCacheFor(module).getTargetForName(name);
+    ++numLookups;
+    auto it = targetCaches.find(module);
+    if (it == targetCaches.end())
+      return getOrCreateCacheFor(module).getTargetForName(name);
+    ++numHits;
+    return it->second.getTargetForName(name);
   }
 
+  /// Build the caches for all modules in the circuit up front, walking the
+  /// modules in parallel. Modules that already have a cache are skipped.
+  void populate(CircuitOp circuit);
+
+  /// The number of name lookups, and how many of them were answered without
+  /// having to walk the module first.
+  size_t numLookups = 0;
+  size_t numHits = 0;
+
   /// Clear the cache completely.
   void invalidate() { targetCaches.clear(); }
 
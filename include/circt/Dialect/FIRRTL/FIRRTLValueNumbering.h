@@ -0,0 +1,93 @@
+//===- FIRRTLValueNumbering.h - Dense SSA value numbering -------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the FIRRTL Value Numbering Analysis, which assigns a dense
+// number to every SSA value in the modules of a circuit.  Analyses that track
+// a fact per value can use these numbers to index into vectors and bitvectors
+// instead of hashing the values themselves.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CIRCT_DIALECT_FIRRTL_FIRRTLVALUENUMBERING_H
+#define CIRCT_DIALECT_FIRRTL_FIRRTLVALUENUMBERING_H
+
+#include "circt/Dialect/FIRRTL/FIRRTLOps.h"
+#include "circt/Support/LLVM.h"
+
+namespace circt {
+namespace firrtl {
+
+/// A dense numbering of the values of the modules in a circuit.  The ports of
+/// a module are numbered first, followed by the values defined in its body in
+/// pre-order.  The values of each module occupy a contiguous range of numbers.
+///
+/// Values created after the analysis was computed have no number, and users
+/// are expected to track them separately.
+///
+/// To use this class, retrieve a cached copy from the analysis manager:
+///   auto &numbering = getAnalysis<ValueNumbering>();
+class ValueNumbering {
+public:
+  explicit ValueNumbering(Operation *operation);
+
+  /// The numbering of the values of a single module.
+  struct ModuleNumbering {
+    /// The number of the first value of the module in the circuit.
+    unsigned begin = 0;
+    /// The number of values in the module.
+    unsigned count = 0;
+    /// The number of each value relative to the start of the module.
+    DenseMap<Value, unsigned> localNumbers;
+
+    /// Return the number of values in the module.
+    unsigned size() const { return count; }
+
+    /// Return the number of a value relative to the start of the module, or
+    /// none if the value is not numbered.
+    std::optional<unsigned> lookupLocal(Value value) const {
+      auto it = localNumbers.find(value);
+      if (it == localNumbers.end())
+        return std::nullopt;
+      return it->second;
+    }
+  };
+
+  /// Return the total number of values in the circuit.
+  unsigned size() const { return numValues; }
+
+  /// Return the numbering of a module, or null if the module is not numbered.
+  const ModuleNumbering *getModuleNumbering(Operation *module) const {
+    auto it = moduleIndices.find(module);
+    if (it == moduleIndices.end())
+      return nullptr;
+    return &modules[it->second];
+  }
+
+  /// Return the number of a value in the circuit, or none if the value is not
+  /// numbered.
+  std::optional<unsigned> lookup(Value value) const;
+
+  /// Forget the number of a value.  This must be called before a numbered
+  /// value is destroyed while the numbering is still in use, such that a new
+  /// value allocated in its place is not mistaken for it.
+  void erase(Value value);
+
+private:
+  /// Return the index of the module containing a value in `modules`, or none
+  /// if the value is not in a numbered module.
+  std::optional<unsigned> getModuleIndexFor(Value value) const;
+
+  SmallVector<ModuleNumbering, 0> modules;
+  DenseMap<Operation *, unsigned> moduleIndices;
+  unsigned numValues = 0;
+};
+
+} // namespace firrtl
+} // namespace circt
+
+#endif // CIRCT_DIALECT_FIRRTL_FIRRTLVALUENUMBERING_H
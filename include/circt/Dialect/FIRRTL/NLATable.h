@@ -24,6 +24,11 @@ namespace firrtl {
 
 /// This table tracks nlas and what modules participate in them.
 ///
+/// Removing an NLA from a module only records the removal.  The list of NLAs
+/// of a module is compacted the next time it is looked up, such that erasing
+/// many NLAs in a row does not repeatedly rewrite the lists of the modules
+/// they go through.
+///
 /// To use this class, retrieve a cached copy from the analysis manager:
 ///   auto &nlaTable = getAnalysis<NLATable>(getOperation());
 class NLATable {
@@ -130,6 +135,7 @@ public:
   void eraseModule(StringAttr name) {
     symToOp.erase(name);
     nodeMap.erase(name);
+    pendingRemovals.erase(name);
   }
 
   /// Replace the module `oldModule` with `newModule` in the namepath of the nla
@@ -165,30 +171,41 @@ public:
   /// Remove the NLA from the Module. This updates the module name to NLA
   /// tracking.
   void removeNLAfromModule(hw::HierPathOp nla, StringAttr mod) {
-    llvm::erase_value(nodeMap[mod], nla);
+    pendingRemovals[mod].insert(nla);
   }
 
   /// Remove all the nlas in the set `nlas` from the module. This updates the
   /// module name to NLA tracking.
   void removeNLAsfromModule(const DenseSet<hw::HierPathOp> &nlas,
                             StringAttr mod) {
-    llvm::erase_if(nodeMap[mod],
-                   [&nlas](const auto &nla) { return nlas.count(nla); });
+    pendingRemovals[mod].insert(nlas.begin(), nlas.end());
   }
 
   /// Add the nla to the module. This ensures that the list of NLAs that the
   /// module participates in is updated. This will be required if `mod` is added
   /// to the namepath of `nla`.
-  void addNLAtoModule(hw::HierPathOp nla, StringAttr mod) {
-    nodeMap[mod].push_back(nla);
-  }
+  void addNLAtoModule(hw::HierPathOp nla, StringAttr mod);
+
+  /// The number of times the NLA list of a module was compacted, and the
+  /// number of removed entries dropped from the lists while doing so.
+  size_t numCompactions = 0;
+  size_t numCompactedEntries = 0;
 
 private:
   NLATable(const NLATable &) = delete;
 
+  /// Drop the NLAs pending removal from the list of a module.
+  void compact(StringAttr mod);
+
   /// Map modules to the NLA's that target them.
   llvm::DenseMap<StringAttr, SmallVector<hw::HierPathOp, 4>> nodeMap;
 
+  /// The NLAs removed from a module which may still be in its list in
+  /// `nodeMap`.  An NLA added to a module which is pending removal from it
+  /// forces the module to be compacted first, since the operation may have
+  /// been erased and a new NLA created in its place.
+  llvm::DenseMap<StringAttr, DenseSet<hw::HierPathOp>> pendingRemovals;
+
   /// Map symbol names to module and NLA operations.
   llvm::DenseMap<StringAttr, Operation *> symToOp;
 };
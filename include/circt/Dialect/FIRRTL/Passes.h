@@ -52,7 +52,8 @@ enum PreserveMode {
 
 std::unique_ptr<mlir::Pass> createLowerFIRRTLTypesPass(
     PreserveAggregate::PreserveMode mode = PreserveAggregate::None,
-    PreserveAggregate::PreserveMode memoryMode = PreserveAggregate::None);
+    PreserveAggregate::PreserveMode memoryMode = PreserveAggregate::None,
+    bool preserveUniformVectors = false);
 
 std::unique_ptr<mlir::Pass> createLowerBundleVectorTypesPass();
 
@@ -80,7 +81,7 @@ std::unique_ptr<mlir::Pass> createVBToBVPass();
 
 std::unique_ptr<mlir::Pass> createAddSeqMemPortsPass();
 
-std::unique_ptr<mlir::Pass> createDedupPass();
+std::unique_ptr<mlir::Pass> createDedupPass(bool fastHash = false);
 
 std::unique_ptr<mlir::Pass>
 createEmitOMIRPass(mlir::StringRef outputFilename = "");
@@ -98,7 +99,8 @@ std::unique_ptr<mlir::Pass> createInferResetsPass();
 std::unique_ptr<mlir::Pass> createLowerMemoryPass();
 
 std::unique_ptr<mlir::Pass>
-createMemToRegOfVecPass(bool replSeqMem = false, bool ignoreReadEnable = false);
+createMemToRegOfVecPass(bool replSeqMem = false, bool ignoreReadEnable = false,
+                        uint64_t maxDepth = 0, uint64_t bankDepth = 0);
 
 std::unique_ptr<mlir::Pass> createPrefixModulesPass();
 
@@ -109,7 +111,8 @@ std::unique_ptr<mlir::Pass> createPrintInstanceGraphPass();
 std::unique_ptr<mlir::Pass> createPrintNLATablePass();
 
 std::unique_ptr<mlir::Pass>
-createBlackBoxReaderPass(std::optional<mlir::StringRef> inputPrefix = {});
+createBlackBoxReaderPass(std::optional<mlir::StringRef> inputPrefix = {},
+                         bool referencePaths = false);
 
 std::unique_ptr<mlir::Pass>
 createGrandCentralPass(bool instantiateCompanionOnly = false);
@@ -120,6 +123,8 @@ std::unique_ptr<mlir::Pass> createCheckCombLoopsPass();
 
 std::unique_ptr<mlir::Pass> createSFCCompatPass();
 
+std::unique_ptr<mlir::Pass> createSimplifyPass();
+
 std::unique_ptr<mlir::Pass>
 createMergeConnectionsPass(bool enableAggressiveMerging = false);
 
@@ -0,0 +1,153 @@
+//===- FSMSimulator.h - FSM machine simulator -------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines a simulator for `fsm.machine` operations. The regions of a
+// machine are compiled once into flat instruction lists over a register file,
+// which are then interpreted step by step without touching the IR again. The
+// simulator counts how often each state is visited and each transition taken.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CIRCT_DIALECT_FSM_FSMSIMULATOR_H
+#define CIRCT_DIALECT_FSM_FSMSIMULATOR_H
+
+#include "circt/Dialect/Comb/CombOps.h"
+#include "circt/Dialect/FSM/FSMOps.h"
+#include "circt/Support/LLVM.h"
+#include "llvm/ADT/APInt.h"
+
+namespace circt {
+namespace fsm {
+
+namespace detail {
+/// A single operation of a compiled region.
+struct SimInstruction {
+  enum Kind {
+    Add,
+    Sub,
+    Mul,
+    DivU,
+    DivS,
+    ModU,
+    ModS,
+    Shl,
+    ShrU,
+    ShrS,
+    And,
+    Or,
+    Xor,
+    ICmp,
+    Mux,
+    Concat,
+    Extract,
+    Replicate,
+    Parity,
+  };
+  Kind kind;
+  /// The register the result is written to.
+  unsigned result;
+  /// The registers of the operands.
+  SmallVector<unsigned, 3> operands;
+  /// The predicate of `ICmp`.
+  comb::ICmpPredicate predicate = comb::ICmpPredicate::eq;
+  /// The low bit of `Extract`.
+  unsigned lowBit = 0;
+  /// The result width of `Extract` and `Replicate`.
+  unsigned width = 0;
+};
+
+/// A compiled region.
+using SimProgram = SmallVector<SimInstruction, 0>;
+} // namespace detail
+
+/// A simulation of one instance of an `fsm.machine`.
+class FSMSimulator {
+public:
+  /// Compile a machine for simulation. Emits an error and returns failure if
+  /// the machine contains an operation or a type the simulator does not
+  /// support.
+  static FailureOr<std::unique_ptr<FSMSimulator>> create(MachineOp machine);
+
+  /// Return the machine to its initial state and variable values. Coverage
+  /// counters are kept.
+  void reset();
+
+  /// Simulate one step of the machine with the given inputs. Computes the
+  /// outputs of the current state, takes the first transition whose guard
+  /// holds, and applies the variable updates of its action.
+  void step(ArrayRef<APInt> inputs);
+
+  /// Return the outputs computed by the last step.
+  ArrayRef<APInt> getOutputs() const { return outputs; }
+
+  /// Return the index of the current state.
+  unsigned getCurrentState() const { return currentState; }
+
+  unsigned getNumStates() const { return states.size(); }
+  StringRef getStateName(unsigned state) const { return states[state].name; }
+
+  /// Return the bit widths of the machine inputs.
+  ArrayRef<unsigned> getInputWidths() const { return inputWidths; }
+
+  /// Return the number of steps simulated.
+  uint64_t getNumSteps() const { return numSteps; }
+
+  /// Return the number of steps the machine spent in a state.
+  uint64_t getStateHits(unsigned state) const { return states[state].hits; }
+
+  /// Print the number of visits of each state and the number of times each
+  /// transition was taken, followed by a summary of the coverage.
+  void printCoverage(llvm::raw_ostream &os) const;
+
+private:
+  FSMSimulator() = default;
+
+  struct Transition {
+    detail::SimProgram guard;
+    /// The register holding the guard result, or none if always taken.
+    std::optional<unsigned> guardResult;
+    detail::SimProgram action;
+    /// The variable updates of the action, as (variable, value) registers.
+    SmallVector<std::pair<unsigned, unsigned>, 2> updates;
+    unsigned nextState;
+    uint64_t hits = 0;
+  };
+
+  struct State {
+    std::string name;
+    detail::SimProgram output;
+    SmallVector<unsigned, 4> outputResults;
+    SmallVector<Transition, 2> transitions;
+    uint64_t hits = 0;
+  };
+
+  void run(const detail::SimProgram &program);
+
+  /// The register file. Machine inputs come first, followed by variables,
+  /// constants and the results of all other operations.
+  SmallVector<APInt, 0> registers;
+  SmallVector<unsigned> inputWidths;
+  /// The initial values of the variable registers.
+  SmallVector<std::pair<unsigned, APInt>> initialValues;
+  /// The operations in the machine body outside of any state.
+  detail::SimProgram body;
+  SmallVector<State, 0> states;
+  unsigned initialState = 0;
+  unsigned currentState = 0;
+  SmallVector<APInt, 4> outputs;
+  /// Scratch space for the values of variable updates.
+  SmallVector<APInt, 4> updateValues;
+  uint64_t numSteps = 0;
+
+  friend class FSMSimulatorCompiler;
+};
+
+} // namespace fsm
+} // namespace circt
+
+#endif // CIRCT_DIALECT_FSM_FSMSIMULATOR_H
@@ -172,6 +172,10 @@ class HWModulePortAccessor {
 public:
   HWModulePortAccessor(Location loc, const ModulePortInfo &info,
                        Region &bodyRegion);
+  // Provides the given values as the input ports, e.g. to build the logic of a
+  // module in place of an instance of it.
+  HWModulePortAccessor(Location loc, const ModulePortInfo &info,
+                       ValueRange inputs);
 
   // Returns the i'th/named input port of the module.
   Value getInput(unsigned i);
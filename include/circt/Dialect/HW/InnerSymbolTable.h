@@ -197,7 +197,9 @@ private:
 /// This class represents a collection of InnerSymbolTable's.
 class InnerSymbolTableCollection {
 public:
-  /// Get or create the InnerSymbolTable for the specified operation.
+  /// Get or create the InnerSymbolTable for the specified operation.  Once the
+  /// table of an operation exists, this does not modify the collection, such
+  /// that lookups may happen concurrently after the tables have been populated.
   InnerSymbolTable &getInnerSymbolTable(Operation *op);
 
   /// Populate tables in parallel for all InnerSymbolTable operations in the
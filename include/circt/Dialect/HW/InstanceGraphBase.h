@@ -169,6 +169,30 @@ private:
   friend class InstanceGraphBase;
 };
 
+/// A listener which is notified of the changes made to an InstanceGraph
+/// through its update methods.  This allows analyses built on top of the
+/// instance graph to be kept up to date incrementally.
+class InstanceGraphListener {
+public:
+  virtual ~InstanceGraphListener();
+
+  /// Called after a module has been added to the graph.
+  virtual void notifyModuleAdded(InstanceGraphNode *node) {}
+
+  /// Called before a module is removed from the graph.
+  virtual void notifyModuleErased(InstanceGraphNode *node) {}
+
+  /// Called after an instance has been added to the graph.
+  virtual void notifyInstanceAdded(InstanceRecord *record) {}
+
+  /// Called before an instance is removed from the graph.
+  virtual void notifyInstanceErased(InstanceRecord *record) {}
+
+  /// Called after the instance-like op of a record has been replaced.
+  virtual void notifyInstanceReplaced(InstanceRecord *record,
+                                      HWInstanceLike oldInstance) {}
+};
+
 /// This graph tracks modules and where they are instantiated. This is intended
 /// to be used as a cached analysis on circuits.  This class can be used
 /// to walk the modules efficiently in a bottom-up or top-down order.
@@ -239,6 +263,29 @@ public:
   /// of both InstanceOps must be the same.
   virtual void replaceInstance(HWInstanceLike inst, HWInstanceLike newInst);
 
+  /// Record a newly created instance op.  The instance must already be
+  /// inserted in the body of a module of this graph, and the instantiated
+  /// module must be part of the graph.  The new record is appended to the
+  /// instances of the parent module, regardless of its position in the IR.
+  InstanceRecord *addInstance(HWInstanceLike instance);
+
+  /// Remove an instance op from the instance graph.  This must be called
+  /// before the instance is erased, moved to another module, or changed to
+  /// instantiate another module.
+  void eraseInstance(HWInstanceLike instance);
+  void eraseInstance(InstanceRecord *record);
+
+  /// Register a listener to be notified of the changes made through the
+  /// methods above.  The listener must outlive the graph or be removed first.
+  void addListener(InstanceGraphListener *listener) {
+    listeners.push_back(listener);
+  }
+
+  /// Stop notifying a listener of changes to the graph.
+  void removeListener(InstanceGraphListener *listener) {
+    llvm::erase_value(listeners, listener);
+  }
+
 protected:
   /// Create a new module graph of a circuit.  Must be called on the parent
   /// operation of HWModuleLike ops.
@@ -260,6 +307,9 @@ protected:
 
   /// A caching of the inferred top level module(s).
   llvm::SmallVector<InstanceGraphNode *> inferredTopLevelNodes;
+
+  /// The listeners notified of changes to the graph.
+  llvm::SmallVector<InstanceGraphListener *, 1> listeners;
 };
 
 /// An absolute instance path.
@@ -279,8 +329,19 @@ static T &operator<<(T &os, const InstancePath &path) {
   return formatInstancePath(os, path);
 }
 
+/// A compact identifier of an absolute instance path within an
+/// InstancePathCache.  The empty path, which refers to the top-level module,
+/// always has the ID 0.
+using InstancePathID = uint32_t;
+
 /// A data structure that caches and provides absolute paths to module instances
 /// in the IR.
+///
+/// Paths are stored as a trie of instances, such that all paths sharing a
+/// prefix share its storage, and each path is identified by a 32-bit ID. The
+/// `getAbsolutePathIDs` method and the accessors of path IDs should be
+/// preferred over `getAbsolutePaths`, which materializes every path as an
+/// array of instances.
 struct InstancePathCache {
   /// The instance graph of the IR.
   InstanceGraphBase &instanceGraph;
@@ -289,18 +350,65 @@ struct InstancePathCache {
       : instanceGraph(instanceGraph) {}
   ArrayRef<InstancePath> getAbsolutePaths(HWModuleLike op);
 
+  /// Return the IDs of all absolute paths to a module.
+  ArrayRef<InstancePathID> getAbsolutePathIDs(HWModuleLike op);
+
+  /// Return the last instance of a path, or null for the empty path.
+  HWInstanceLike getLeafInstance(InstancePathID path) const {
+    return pathNodes[path].leaf;
+  }
+
+  /// Return the path without its last instance.
+  InstancePathID getParentPath(InstancePathID path) const {
+    return pathNodes[path].parent;
+  }
+
+  /// Return the number of instances in a path.
+  unsigned getPathSize(InstancePathID path) const {
+    return pathNodes[path].size;
+  }
+
+  /// Append the instances of a path to a vector, from the top down.
+  void getPath(InstancePathID path,
+               SmallVectorImpl<HWInstanceLike> &instances) const;
+
+  /// Compute the absolute paths of all modules up front.  Afterwards, the cache
+  /// is read-only and its path IDs may be queried concurrently.
+  /// `getAbsolutePaths` and `replaceInstance` must not be used on a frozen
+  /// cache.
+  void freeze();
+
+  /// Return true if the cache has been frozen.
+  bool isFrozen() const { return frozen; }
+
   /// Replace an InstanceOp. This is required to keep the cache updated.
   void replaceInstance(HWInstanceLike oldOp, HWInstanceLike newOp);
 
 private:
+  /// A node of the path trie, which extends the parent path with one instance.
+  struct PathNode {
+    HWInstanceLike leaf;
+    InstancePathID parent;
+    unsigned size;
+  };
+
   /// An allocator for individual instance paths and entire path lists.
   llvm::BumpPtrAllocator allocator;
 
+  /// The nodes of the path trie.  The first node is the empty path.
+  SmallVector<PathNode> pathNodes = {{{}, 0, 0}};
+
+  /// Cached absolute instance path IDs.
+  DenseMap<Operation *, ArrayRef<InstancePathID>> absolutePathIDsCache;
+
   /// Cached absolute instance paths.
   DenseMap<Operation *, ArrayRef<InstancePath>> absolutePathsCache;
 
+  /// Whether all paths have been computed, and the cache is read-only.
+  bool frozen = false;
+
   /// Append an instance to a path.
-  InstancePath appendInstance(InstancePath path, HWInstanceLike inst);
+  InstancePathID appendInstance(InstancePathID path, HWInstanceLike inst);
 };
 
 } // namespace hw
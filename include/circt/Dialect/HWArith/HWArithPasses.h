@@ -0,0 +1,32 @@
+//===- HWArithPasses.h - HWArith pass entry points --------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This header file defines prototypes that expose pass constructors.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CIRCT_DIALECT_HWARITH_HWARITHPASSES_H
+#define CIRCT_DIALECT_HWARITH_HWARITHPASSES_H
+
+#include "mlir/Pass/Pass.h"
+#include "mlir/Pass/PassRegistry.h"
+#include <memory>
+
+namespace circt {
+namespace hwarith {
+
+std::unique_ptr<mlir::Pass> createNarrowWidthsPass();
+
+/// Generate the code for registering passes.
+#define GEN_PASS_REGISTRATION
+#include "circt/Dialect/HWArith/Passes.h.inc"
+
+} // namespace hwarith
+} // namespace circt
+
+#endif // CIRCT_DIALECT_HWARITH_HWARITHPASSES_H
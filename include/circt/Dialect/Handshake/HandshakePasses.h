@@ -36,7 +36,8 @@ createHandshakeLowerExtmemToHWPass(std::optional<bool> createESIWrapper = {});
 std::unique_ptr<mlir::Pass> createHandshakeLegalizeMemrefsPass();
 std::unique_ptr<mlir::OperationPass<handshake::FuncOp>>
 createHandshakeInsertBuffersPass(const std::string &strategy = "all",
-                                 unsigned bufferSize = 2);
+                                 unsigned bufferSize = 2,
+                                 unsigned targetII = 1);
 std::unique_ptr<mlir::Pass> createHandshakeLockFunctionsPass();
 
 /// Iterates over the handshake::FuncOp's in the program to build an instance
@@ -63,9 +64,11 @@ void insertFork(Value result, bool isLazy, OpBuilder &rewriter);
 // Adds a locking mechanism around the region.
 LogicalResult lockRegion(Region &r, OpBuilder &rewriter);
 
-// Applies the spcified buffering strategy on the region r.
+// Applies the spcified buffering strategy on the region r. The throughput
+// strategy sizes its buffers for the target initiation interval instead of
+// using bufferSize.
 LogicalResult bufferRegion(Region &r, OpBuilder &rewriter, StringRef strategy,
-                           unsigned bufferSize);
+                           unsigned bufferSize, unsigned targetII = 1);
 
 /// Generate the code for registering passes.
 #define GEN_PASS_REGISTRATION
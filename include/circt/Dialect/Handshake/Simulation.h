@@ -20,10 +20,27 @@
 
 namespace circt {
 namespace handshake {
+
+/// Options of the cycle-accurate simulation of handshake functions.
+struct CycleAccurateOptions {
+  /// The number of cycles after which the simulation is aborted, or zero to
+  /// not limit the simulation.
+  uint64_t maxCycles = 0;
+  /// The stream the throughput report is written to.
+  llvm::raw_ostream *report = nullptr;
+};
+
+/// Simulate the top-level function of the module with the given arguments, and
+/// print its results. Handshake functions are simulated cycle by cycle if
+/// `cycleAccurate` is given. If `typedCore` is set, handshake functions are
+/// executed by an interpreter working on dense, typed value slots instead of
+/// maps of `llvm::Any` values; it supports the dataflow subset of the dialect.
 bool simulate(llvm::StringRef toplevelFunction,
               llvm::ArrayRef<std::string> inputArgs,
               mlir::OwningOpRef<mlir::ModuleOp> &module,
-              mlir::MLIRContext &context);
+              mlir::MLIRContext &context,
+              const CycleAccurateOptions *cycleAccurate = nullptr,
+              bool typedCore = false);
 } // namespace handshake
 } // namespace circt
 
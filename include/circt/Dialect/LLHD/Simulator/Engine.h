@@ -18,6 +18,7 @@
 
 #include "circt/Dialect/LLHD/IR/LLHDOps.h"
 #include "mlir/IR/BuiltinOps.h"
+#include "llvm/ADT/BitVector.h"
 
 namespace mlir {
 class ExecutionEngine;
@@ -25,7 +26,9 @@ class ExecutionEngine;
 
 namespace llvm {
 class Error;
+class LLVMContext;
 class Module;
+class ThreadPool;
 } // namespace llvm
 
 namespace circt {
@@ -35,19 +38,37 @@ namespace sim {
 class Engine {
 public:
   /// Initialize an LLHD simulation engine. This initializes the state, as well
-  /// as the mlir::ExecutionEngine with the given module.
+  /// as the mlir::ExecutionEngine with the given module. Units that are not
+  /// instantiated by the design root are dropped before the module is lowered
+  /// and compiled. If an `llvmModuleBuilder` is given, it replaces the default
+  /// translation of the lowered module to LLVM IR, which allows callers to
+  /// reuse previously compiled modules. If `levelize` is set, the entities
+  /// marked by `llhd-mark-combinational` are evaluated in a static order
+  /// instead of through the event queue.
   Engine(
       llvm::raw_ostream &out, ModuleOp module,
       llvm::function_ref<mlir::LogicalResult(mlir::ModuleOp)> mlirTransformer,
       llvm::function_ref<llvm::Error(llvm::Module *)> llvmTransformer,
-      std::string root, TraceMode tm, ArrayRef<StringRef> sharedLibPaths);
+      std::string root, TraceMode tm, ArrayRef<StringRef> sharedLibPaths,
+      SchedulerKind scheduler = SchedulerKind::Calendar, unsigned threads = 1,
+      TraceEncoding te = TraceEncoding::Text, bool levelize = false,
+      llvm::function_ref<std::unique_ptr<llvm::Module>(mlir::Operation *,
+                                                       llvm::LLVMContext &)>
+          llvmModuleBuilder = {});
 
   /// Default destructor
   ~Engine();
 
   /// Run simulation up to n steps or maxTime picoseconds of simulation time.
-  /// n=0 and T=0 make the simulation run indefinitely.
-  int simulate(int n, uint64_t maxTime);
+  /// n=0 and T=0 make the simulation run indefinitely. If a checkpoint is
+  /// given, the simulation resumes from the checkpointed state instead of
+  /// starting at time zero.
+  int simulate(int n, uint64_t maxTime, StringRef checkpointPath = {});
+
+  /// Write a checkpoint of the current simulation state to the given file,
+  /// which can be used to resume the simulation later on. Returns true on
+  /// failure.
+  bool saveCheckpoint(StringRef path);
 
   /// Build the instance layout of the design.
   void buildLayout(ModuleOp module);
@@ -67,12 +88,53 @@ public:
 private:
   void walkEntity(EntityOp entity, Instance &child);
 
+  /// Erase the entities and processes of the module that are not the unit of
+  /// any instance, such that they are neither lowered nor compiled.
+  void eraseUninstantiatedUnits(ModuleOp module);
+
+  /// Compute the static evaluation order of the combinational entity
+  /// instances, such that each instance comes after the instances driving the
+  /// signals it probes. Instances on or behind a combinational loop are left
+  /// to the event-driven evaluation.
+  void levelize(ModuleOp module);
+
+  /// Add the instances sensitive to a changed signal to the wakeup queue.
+  void wakeupTriggered(unsigned sigIndex, llvm::BitVector &wakeupQueue);
+
+  /// Run the woken combinational entity instances in level order. Their drives
+  /// are applied to the signals right away, such that every instance runs at
+  /// most once per delta cycle and observes the new values of the instances
+  /// before it.
+  void runLevelized(llvm::BitVector &wakeupQueue, Trace &trace,
+                    SmallVectorImpl<uint64_t> &scratch);
+
+  /// Invoke the unit of the given instance.
+  void runInstance(unsigned index);
+
+  /// Invoke the units of the given instances on the worker threads, then
+  /// commit the events they emitted to the queue.
+  void runInstancesParallel(ArrayRef<unsigned> indices);
+
   llvm::raw_ostream &out;
   std::string root;
   std::unique_ptr<State> state;
   std::unique_ptr<mlir::ExecutionEngine> engine;
   ModuleOp module;
   TraceMode traceMode;
+  TraceEncoding traceEncoding;
+  /// The worker threads used to evaluate the instances of one delta cycle.
+  std::unique_ptr<llvm::ThreadPool> threadPool;
+  /// One event buffer per worker thread.
+  SmallVector<EventBuffer, 0> eventBuffers;
+  /// The buffered events of a parallel delta cycle, sorted for commit.
+  SmallVector<std::pair<EventBuffer *, const EventBuffer::Event *>, 0>
+      pendingEvents;
+  /// The combinational entity instances in static evaluation order.
+  SmallVector<unsigned, 0> levelOrder;
+  /// The instances that are part of the static evaluation order.
+  llvm::BitVector levelized;
+  /// The buffer collecting the drives of a combinational entity instance.
+  EventBuffer levelBuffer;
 };
 
 } // namespace sim
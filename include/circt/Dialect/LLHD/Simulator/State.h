@@ -17,11 +17,17 @@
 #include "llvm/ADT/APInt.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Error.h"
 
+#include <array>
 #include <map>
 #include <queue>
 #include <regex>
 
+namespace llvm {
+class MemoryBufferRef;
+} // namespace llvm
+
 namespace circt {
 namespace llhd {
 namespace sim {
@@ -57,6 +63,10 @@ public:
 
   uint64_t getTime() const { return time; }
 
+  uint64_t getDelta() const { return delta; }
+
+  uint64_t getEps() const { return eps; }
+
 private:
   /// Simulation real time.
   uint64_t time;
@@ -122,12 +132,29 @@ public:
     return instanceIndices;
   }
 
-  void pushInstanceIndex(unsigned i) { instanceIndices.push_back(i); }
+  /// Return, for each triggered instance, the index of this signal in the
+  /// instance's sensitivity list.
+  const std::vector<unsigned> &getTriggeredSenseIndices() const {
+    return senseIndices;
+  }
+
+  /// Add an instance this signal triggers, along with the index of the signal
+  /// in the instance's sensitivity list.
+  void pushInstanceIndex(unsigned i, unsigned senseIndex) {
+    instanceIndices.push_back(i);
+    senseIndices.push_back(senseIndex);
+  }
 
   bool hasElement() const { return elements.size() > 0; }
 
   size_t getElementSize() const { return elements.size(); }
 
+  /// Return the byte offset of the i-th element in the signal value.
+  unsigned getElementOffset(unsigned i) const { return elements[i].first; }
+
+  /// Return the size in bytes of the i-th element.
+  unsigned getElementByteSize(unsigned i) const { return elements[i].second; }
+
   void pushElement(std::pair<unsigned, unsigned> val) {
     elements.push_back(val);
   }
@@ -196,13 +223,31 @@ private:
   std::string owner;
   // The list of instances this signal triggers.
   std::vector<unsigned> instanceIndices;
+  // The index of the signal in the sensitivity list of each triggered instance.
+  std::vector<unsigned> senseIndices;
   uint64_t size;
   uint8_t *value;
   std::vector<std::pair<unsigned, unsigned>> elements;
 };
 
+/// Insert `width` bits, read from the little-endian byte buffer `src`, into the
+/// little-endian byte buffer `dst`, starting at bit `bitOffset`. All other bits
+/// of `dst` are left untouched.
+void insertBits(uint8_t *dst, const uint8_t *src, uint64_t bitOffset,
+                uint64_t width);
+
 /// The simulator's internal representation of one queue slot.
 struct Slot {
+  /// A driven value, stored in the change arena of the slot.
+  struct Change {
+    /// The bit offset of the drive in the signal value.
+    uint64_t bitOffset;
+    /// The width of the driven value in bits.
+    uint64_t width;
+    /// The byte offset of the driven value in the change arena.
+    size_t arenaOffset;
+  };
+
   /// Create a new empty slot.
   Slot(Time time) : time(time) {}
 
@@ -218,11 +263,26 @@ struct Slot {
   /// Insert a scheduled process wakeup.
   void insertChange(unsigned inst);
 
+  /// Return the driven value of a change.
+  const uint8_t *getChangeBytes(const Change &change) const {
+    return arena.data() + change.arenaOffset;
+  }
+
+  /// Return the total capacity of the internal buffers. Used to keep track of
+  /// the heap allocations performed when inserting new changes.
+  size_t getCapacity() const {
+    return changes.capacity() + buffers.capacity() + arena.capacity() +
+           scheduled.capacity();
+  }
+
   // A map from signal indexes to change buffers. Makes it easy to sort the
   // changes such that we can process one signal at a time.
   llvm::SmallVector<std::pair<unsigned, unsigned>, 32> changes;
   // Buffers for the signal changes.
-  llvm::SmallVector<std::pair<unsigned, llvm::APInt>, 32> buffers;
+  llvm::SmallVector<Change, 32> buffers;
+  // The driven values of all the changes in the slot. The arena is cleared
+  // but not freed when the slot is popped, such that its storage is reused.
+  llvm::SmallVector<uint8_t, 256> arena;
   // The number of used change buffers in the slot.
   size_t changesSize = 0;
 
@@ -232,13 +292,72 @@ struct Slot {
   bool unused = false;
 };
 
+/// The scheduling strategies available for the UpdateQueue.
+enum class SchedulerKind {
+  /// Keep all the slots in a flat list and search it linearly.
+  Linear,
+  /// Keep the near-future delta steps in a time wheel and the far events in an
+  /// ordered overflow queue.
+  Calendar
+};
+
 /// This is equivalent to and std::priorityQueue<Slot> ordered using the greater
 /// operator, which adds an insertion method to add changes to a slot.
+///
+/// With the calendar scheduler, all the slots sharing the real time of the
+/// last popped slot and less than `wheelSize` delta steps ahead of it are
+/// bucketed by delta step in a time wheel, such that the common delta-cycle
+/// insertions and lookups are constant time. All other slots are kept in an
+/// ordered overflow queue and moved to the wheel once the simulation time comes
+/// close enough.
 class UpdateQueue : public llvm::SmallVector<Slot, 8> {
   unsigned topSlot = 0;
   llvm::SmallVector<unsigned, 4> unused;
 
+  SchedulerKind kind = SchedulerKind::Calendar;
+
+  /// The number of delta steps covered by the time wheel.
+  static constexpr unsigned wheelSize = 64;
+  /// The time the wheel is anchored to.
+  Time wheelBase;
+  /// One bucket per delta step, each holding slot indices sorted by eps.
+  std::array<llvm::SmallVector<unsigned, 2>, wheelSize> wheel;
+  /// Bitmask of the non-empty wheel buckets.
+  uint64_t wheelMask = 0;
+  /// Slots outside of the time wheel window, ordered by time.
+  std::map<Time, unsigned> overflow;
+
+  /// Return the index of a fresh slot for the given time, reusing an unused
+  /// slot if possible.
+  unsigned allocateSlot(Time time);
+
+  /// Return true if a slot with the given time belongs in the time wheel.
+  bool isInWheel(Time time) const;
+
+  /// Insert the slot index into its time wheel bucket, keeping the bucket
+  /// sorted.
+  void insertInWheel(unsigned index);
+
+  /// Anchor the time wheel to the given time and move all the overflow slots
+  /// falling in the new window to the wheel.
+  void rebaseWheel(Time time);
+
+  /// Calendar scheduler implementation of getOrCreateSlot.
+  Slot &getOrCreateCalendarSlot(Time time);
+
+  /// Return the index of the earliest slot in the calendar scheduler.
+  unsigned findCalendarTop() const;
+
 public:
+  /// Select the scheduling strategy. This has to happen before any slot is
+  /// added to the queue.
+  void setSchedulerKind(SchedulerKind newKind) {
+    assert(empty() && "cannot change the scheduler of a non-empty queue");
+    kind = newKind;
+  }
+
+  SchedulerKind getSchedulerKind() const { return kind; }
+
   /// Check wheter a slot for the given time already exists. If that's the case,
   /// add the new change to it, else create a new slot and push it to the queue.
   void insertOrUpdate(Time time, int index, int bitOffset, uint8_t *bytes,
@@ -263,6 +382,49 @@ public:
   void pop();
 
   unsigned events = 0;
+  /// The number of heap allocations performed to store events and to apply
+  /// signal changes, used to check that delta cycles do not allocate.
+  uint64_t allocations = 0;
+};
+
+/// Buffers the events emitted by the instances evaluated on one worker thread
+/// during a parallel delta cycle. The events are committed to the UpdateQueue
+/// in instance order once all the workers are done, such that the resulting
+/// queue is identical to the one of a serial evaluation.
+struct EventBuffer {
+  /// One buffered signal drive or process wakeup.
+  struct Event {
+    /// The instance that emitted the event.
+    unsigned inst;
+    Time time;
+    bool isWakeup;
+    int index;
+    int bitOffset;
+    unsigned width;
+    /// The byte offset of the driven value in the buffer's arena.
+    size_t arenaOffset;
+  };
+
+  /// Buffer a signal drive emitted by the current instance.
+  void insertOrUpdate(Time time, int index, int bitOffset, uint8_t *bytes,
+                      unsigned width);
+
+  /// Buffer a scheduled wakeup of the current instance.
+  void insertOrUpdate(Time time, unsigned inst);
+
+  /// Insert the buffered event into the given queue.
+  void commit(UpdateQueue &queue, const Event &event);
+
+  /// Drop all the buffered events, keeping the storage for reuse.
+  void clear() {
+    events.clear();
+    arena.clear();
+  }
+
+  /// The instance currently evaluated by the worker owning the buffer.
+  unsigned currentInst = 0;
+  std::vector<Event> events;
+  std::vector<uint8_t> arena;
 };
 
 /// State structure for process persistence across suspension.
@@ -292,6 +454,8 @@ struct Instance {
   llvm::SmallVector<SignalDetail, 0> sensitivityList;
   ProcState *procState;
   uint8_t *entityState;
+  // The size in bytes of the process or entity state.
+  uint64_t stateSize = 0;
   Time expectedWakeup;
   // A pointer to the base unit jitted function.
   void (*unitFPtr)(void **);
@@ -331,7 +495,7 @@ struct State {
   void addSignalElement(unsigned, unsigned, unsigned);
 
   /// Add a pointer to the process persistence state to a process instance.
-  void addProcPtr(std::string name, ProcState *procStatePtr);
+  void addProcPtr(std::string name, ProcState *procStatePtr, uint64_t size);
 
   /// Dump a signal to the out stream. One entry is added for every instance
   /// the signal appears in.
@@ -343,6 +507,18 @@ struct State {
   /// Dump the instances each signal triggers. Used for testing purposes.
   void dumpSignalTriggers();
 
+  /// Write a checkpoint of the simulation state to the out stream. This
+  /// includes the current time, the signal values, the process and entity
+  /// states, and all the events in the queue. The checkpoint is stored in the
+  /// host's byte order.
+  void saveCheckpoint(llvm::raw_ostream &out);
+
+  /// Restore a checkpoint written by saveCheckpoint. The state has to be fully
+  /// initialized for the same design the checkpoint was taken from, and its
+  /// event queue has to be empty. The buffer is read in place, such that it can
+  /// be backed by a memory-mapped file.
+  llvm::Error restoreCheckpoint(llvm::MemoryBufferRef buffer);
+
   Time time;
   std::string root;
   llvm::SmallVector<Instance, 0> instances;
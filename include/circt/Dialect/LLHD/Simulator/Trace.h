@@ -16,7 +16,11 @@
 
 #include "State.h"
 
+#include "llvm/ADT/DenseMap.h"
+
 #include <map>
+#include <optional>
+#include <tuple>
 #include <vector>
 
 namespace llvm {
@@ -29,6 +33,24 @@ namespace sim {
 
 enum class TraceMode { Full, Reduced, Merged, MergedReduce, NamedOnly, None };
 
+/// The encoding of the trace output stream.
+///
+/// The binary encoding starts with the magic bytes "LLHDTRC" followed by a
+/// one byte format version, then a sequence of blocks. Each block starts with a
+/// one byte flag (1 if the payload is zlib-compressed, 0 otherwise), the
+/// uncompressed and stored payload sizes as little-endian u32, and the payload.
+/// A payload is a sequence of complete records, all integers being stored in
+/// little-endian order:
+///   - 0x01 signal definition: u32 id, u32 value size in bytes, u32 name
+///     length, hierarchical name bytes. Precedes the first change of a signal.
+///   - 0x02 time step: u64 real time, u64 delta, u64 eps. All the following
+///     changes happen at this time.
+///   - 0x03 value change: u32 id, followed by the new value bytes in
+///     little-endian order.
+enum class TraceEncoding { Text, Binary };
+
+class TraceBlockWriter;
+
 class Trace {
   llvm::raw_ostream &out;
   std::unique_ptr<State> const &state;
@@ -43,8 +65,22 @@ class Trace {
   // Buffer of last dumped change for each signal.
   std::map<std::pair<std::string, int>, std::string> lastValue;
 
+  // The writer of the binary encoding, null for the textual one.
+  std::unique_ptr<TraceBlockWriter> writer;
+  // Map from (instance, signal, element) to the binary trace signal id.
+  llvm::DenseMap<std::tuple<unsigned, unsigned, int>, unsigned> binaryIds;
+  // The offset and size of the last dumped value of each binary trace signal.
+  std::vector<std::pair<size_t, unsigned>> binaryValueSlices;
+  // Storage of the last dumped value of all binary trace signals.
+  std::vector<uint8_t> binaryValues;
+  // The last time step record written to the binary trace, if any.
+  std::optional<Time> binaryTime;
+
   /// Push one change to the changes vector.
   void pushChange(unsigned inst, unsigned sigIndex, int elem);
+  /// Write one change to the binary trace, if the value changed since it was
+  /// last written.
+  void pushBinaryChange(unsigned inst, unsigned sigIndex, int elem);
   /// Push one change for each element of a signal if it is of a structured
   /// type, or the full signal otherwise.
   void pushAllChanges(unsigned inst, unsigned sigIndex);
@@ -62,16 +98,27 @@ class Trace {
 
 public:
   Trace(std::unique_ptr<State> const &state, llvm::raw_ostream &out,
-        TraceMode mode);
+        TraceMode mode, TraceEncoding encoding = TraceEncoding::Text);
+
+  /// Finish writing the trace, waiting for all pending binary blocks to be
+  /// written.
+  ~Trace();
 
   /// Add a value change to the trace changes buffer.
   void addChange(unsigned);
 
   /// Flush the changes buffer to the output stream. The flush can be forced for
   /// merged changes, flushing even if the next real-time step has not been
-  /// reached.
+  /// reached. A forced flush also waits for all pending binary blocks to be
+  /// written.
   void flush(bool force = false);
 };
+
+/// Decode a trace written with the binary encoding and print its changes to
+/// `os` in the textual format of `TraceMode::Full`, with the changes of each
+/// time step sorted by their hierarchical paths. Returns an error if `data` is
+/// not a well-formed binary trace.
+llvm::Error decodeBinaryTrace(llvm::StringRef data, llvm::raw_ostream &os);
 } // namespace sim
 } // namespace llhd
 } // namespace circt
@@ -17,11 +17,139 @@
 #include "circt/Dialect/MSFT/MSFTOps.h"
 
 #include "mlir/IR/Operation.h"
+#include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/DenseMap.h"
 
+#include <vector>
+
 namespace circt {
 namespace msft {
 
+/// A dense, column-major grid of primitive sites indexed directly by the X and
+/// Y coordinates. Each cell holds the sites at its coordinates sorted by number
+/// and primitive type, with data `T` attached to each. Each column also keeps a
+/// bitmap of its populated rows, both overall and per primitive type, so range
+/// queries skip over empty cells instead of testing each one.
+///
+/// Insertions may invalidate pointers previously returned by `lookup` and
+/// `insert`.
+template <typename T>
+class DeviceGrid {
+public:
+  struct Site {
+    uint64_t num;
+    PrimitiveType primType;
+    T data;
+  };
+
+  /// Return the data of the site at `loc`, or null if there is no such site.
+  T *lookup(PhysLocationAttr loc) {
+    uint64_t x = loc.getX(), y = loc.getY();
+    if (x >= columns.size() || y >= columns[x].cells.size())
+      return nullptr;
+    Cell &cell = columns[x].cells[y];
+    auto *it = findSite(cell, loc);
+    if (it == cell.end() || it->num != loc.getNum() ||
+        it->primType != loc.getPrimitiveType().getValue())
+      return nullptr;
+    return &it->data;
+  }
+
+  /// Return the data of the site at `loc`, creating the site if it doesn't
+  /// exist yet. `inserted` is set to whether it was created.
+  T &insert(PhysLocationAttr loc, bool &inserted) {
+    uint64_t x = loc.getX(), y = loc.getY();
+    PrimitiveType primType = loc.getPrimitiveType().getValue();
+    if (x >= columns.size())
+      columns.resize(x + 1);
+    Column &col = columns[x];
+    if (y >= col.cells.size()) {
+      col.cells.resize(y + 1);
+      col.anyRows.resize(y + 1);
+    }
+    Cell &cell = col.cells[y];
+    auto *it = findSite(cell, loc);
+    inserted = it == cell.end() || it->num != loc.getNum() ||
+               it->primType != primType;
+    if (!inserted)
+      return it->data;
+
+    it = cell.insert(it, Site{loc.getNum(), primType, T()});
+    col.anyRows.set(y);
+    llvm::BitVector &typeRows = col.typeRows[primType];
+    if (typeRows.size() <= y)
+      typeRows.resize(y + 1);
+    typeRows.set(y);
+    return it->data;
+  }
+
+  /// Call `callback(x, y, site)` on each site in the rectangle [xmin, xmax] x
+  /// [ymin, ymax] (inclusive), optionally restricted to one primitive type.
+  /// Columns and rows are visited in ascending order unless the corresponding
+  /// `desc` flag is set. The grid must not be modified during the walk.
+  void walk(uint64_t xmin, uint64_t xmax, uint64_t ymin, uint64_t ymax,
+            std::optional<PrimitiveType> primType, bool colsDesc,
+            bool rowsDesc,
+            llvm::function_ref<void(uint64_t, uint64_t, const Site &)>
+                callback) const {
+    if (columns.empty())
+      return;
+    xmax = std::min<uint64_t>(xmax, columns.size() - 1);
+    if (xmin > xmax || ymin > ymax)
+      return;
+    for (uint64_t i = 0, e = xmax - xmin + 1; i < e; ++i) {
+      uint64_t x = colsDesc ? xmax - i : xmin + i;
+      const Column &col = columns[x];
+      const llvm::BitVector *rows = &col.anyRows;
+      if (primType) {
+        auto typeRowsF = col.typeRows.find(*primType);
+        if (typeRowsF == col.typeRows.end())
+          continue;
+        rows = &typeRowsF->second;
+      }
+      if (ymin >= rows->size())
+        continue;
+      unsigned begin = ymin;
+      unsigned end = std::min<uint64_t>(ymax, rows->size() - 1) + 1;
+
+      auto visitRow = [&](unsigned y) {
+        for (const Site &site : col.cells[y])
+          if (!primType || site.primType == *primType)
+            callback(x, y, site);
+      };
+      if (rowsDesc) {
+        for (int y = rows->find_last_in(begin, end); y != -1;
+             y = rows->find_last_in(begin, y))
+          visitRow(y);
+      } else {
+        for (int y = rows->find_first_in(begin, end); y != -1;
+             y = rows->find_first_in(y + 1, end))
+          visitRow(y);
+      }
+    }
+  }
+
+private:
+  using Cell = SmallVector<Site, 1>;
+  struct Column {
+    std::vector<Cell> cells;
+    /// The rows with at least one site.
+    llvm::BitVector anyRows;
+    /// The rows with at least one site of each primitive type.
+    DenseMap<PrimitiveType, llvm::BitVector> typeRows;
+  };
+
+  /// Find the first site in `cell` not ordered before `loc`.
+  static Site *findSite(Cell &cell, PhysLocationAttr loc) {
+    auto key = std::make_pair(loc.getNum(), loc.getPrimitiveType().getValue());
+    return llvm::lower_bound(cell, key, [](const Site &site, auto key) {
+      return std::make_pair(site.num, site.primType) < key;
+    });
+  }
+
+  std::vector<Column> columns;
+};
+
 /// A data structure to contain locations of the primitives on the
 /// device.
 class PrimitiveDB {
@@ -39,17 +167,10 @@ public:
   void foreach (function_ref<void(PhysLocationAttr)> callback) const;
 
 private:
-  using DimPrimitiveType = DenseSet<PrimitiveType>;
-  using DimNumMap = DenseMap<size_t, DimPrimitiveType>;
-  using DimYMap = DenseMap<size_t, DimNumMap>;
-  using DimXMap = DenseMap<size_t, DimYMap>;
-
-  /// Get the leaf node. Abstract this out to make it easier to change the
-  /// underlying data structure.
-  DimPrimitiveType &getLeaf(PhysLocationAttr);
-  // TODO: Create read-only version of getLeaf.
+  /// The primitive sites carry no data.
+  struct NoData {};
 
-  DimXMap placements;
+  DeviceGrid<NoData> primitives;
   MLIRContext *ctxt;
 };
 
@@ -108,7 +229,8 @@ public:
 
   /// Walk the placement information in some sort of reasonable order. Bounds
   /// restricts the walk to a rectangle of [xmin, xmax, ymin, ymax] (inclusive),
-  /// with -1 meaning unbounded.
+  /// with -1 meaning unbounded. Only the cells which contain primitives are
+  /// visited. The DB must not be modified from the callback.
   void
   walkPlacements(function_ref<void(PhysLocationAttr, DynInstDataOpInterface)>,
                  std::tuple<int64_t, int64_t, int64_t, int64_t> bounds =
@@ -129,17 +251,14 @@ private:
   MLIRContext *ctxt;
   mlir::ModuleOp topMod;
 
-  using DimDevType = DenseMap<PrimitiveType, PlacementCell>;
-  using DimNumMap = DenseMap<size_t, DimDevType>;
-  using DimYMap = DenseMap<size_t, DimNumMap>;
-  using DimXMap = DenseMap<size_t, DimYMap>;
   using RegionPlacements = SmallVector<PDPhysRegionOp>;
 
-  /// Get the leaf node. Abstract this out to make it easier to change the
-  /// underlying data structure.
+  /// Get the leaf node. If the DB wasn't seeded, the leaf is created if it
+  /// doesn't exist. Otherwise only valid locations have a leaf. Creating a
+  /// leaf may invalidate previously returned leaves.
   PlacementCell *getLeaf(PhysLocationAttr);
 
-  DimXMap placements;
+  DeviceGrid<PlacementCell> placements;
   RegionPlacements regionPlacements;
   bool seeded;
 
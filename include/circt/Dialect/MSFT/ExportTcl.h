@@ -13,17 +13,37 @@
 #ifndef CIRCT_DIALECT_MSFT_EXPORTTCL_H
 #define CIRCT_DIALECT_MSFT_EXPORTTCL_H
 
+#include "circt/Dialect/HW/HWAttributes.h"
 #include "circt/Dialect/HW/HWSymCache.h"
 #include "circt/Dialect/MSFT/MSFTOpInterfaces.h"
 #include "circt/Support/LLVM.h"
 
 #include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 
 namespace circt {
 namespace msft {
 class MSFTModuleOp;
 
+/// A single assignment to an entity, as recorded in an export manifest.
+struct TclAssignment {
+  /// The Tcl command, including the assignment name if it has one.
+  std::string command;
+  std::string value;
+  /// The path to the entity and the path within it.
+  SmallVector<hw::InnerRefAttr> path;
+  std::string subpath;
+
+  /// Identifies what is being assigned to which entity.
+  std::string getKey() const;
+};
+
+/// The assignments of one Tcl proc, keyed by `TclAssignment::getKey`.
+using TclProcManifest = llvm::MapVector<std::string, TclAssignment>;
+/// The procs of one module, keyed by instance name (empty if none).
+using TclModuleManifest = llvm::MapVector<std::string, TclProcManifest>;
+
 /// Instantiate for all Tcl emissions. We want to cache the symbols and binned
 /// ops -- this helper class provides that caching.
 class TclEmitter {
@@ -35,6 +55,12 @@ public:
   const DenseSet<hw::GlobalRefOp> &getRefsUsed() { return refsUsed; }
   void usedRef(hw::GlobalRefOp ref) { refsUsed.insert(ref); }
 
+  /// Only emit the assignments which differ from `manifest`, the manifest of a
+  /// previous export, and remove the ones which are gone since.
+  LogicalResult setPreviousManifest(StringRef manifest);
+  /// Get the manifest of everything emitted so far.
+  std::string getManifest() const;
+
 private:
   mlir::ModuleOp topLevel;
 
@@ -48,6 +74,11 @@ private:
       tclOpsForModInstance;
   DenseSet<hw::GlobalRefOp> refsUsed;
 
+  /// The assignments emitted, keyed by module name.
+  llvm::MapVector<std::string, TclModuleManifest> manifest;
+  /// The assignments of the previous export, in diff mode.
+  std::optional<llvm::StringMap<TclModuleManifest>> previousManifest;
+
   LogicalResult populate();
 };
 
@@ -29,6 +29,8 @@ std::unique_ptr<mlir::Pass> createLowerInstancesPass();
 std::unique_ptr<mlir::Pass> createLowerConstructsPass();
 std::unique_ptr<mlir::Pass> createExportTclPass();
 std::unique_ptr<mlir::Pass> createDiscoverAppIDsPass();
+std::unique_ptr<mlir::Pass> createAutoPlacePass();
+std::unique_ptr<mlir::Pass> createAutoPartitionPass();
 
 /// A set of methods which are broadly useful in a number of dialects.
 struct PassCommon {
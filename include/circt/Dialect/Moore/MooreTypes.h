@@ -627,6 +627,8 @@ class UnpackedRefType;
 
 namespace detail {
 UnpackedType getIndirectTypeInner(const TypeStorage *impl);
+UnpackedType getIndirectTypeFullyResolved(const TypeStorage *impl);
+std::optional<unsigned> getIndirectTypeBitSize(const TypeStorage *impl);
 Location getIndirectTypeLoc(const TypeStorage *impl);
 StringAttr getIndirectTypeName(const TypeStorage *impl);
 } // namespace detail
@@ -670,8 +672,19 @@ public:
 
   /// Resolve all name or type reference indirections. This always returns the
   /// fully resolved inner type. See `PackedType::fullyResolved` and
-  /// `UnpackedType::fullyResolved`.
-  BaseTy fullyResolved() const { return getInner().fullyResolved(); }
+  /// `UnpackedType::fullyResolved`. The result is computed once when the
+  /// indirection is created.
+  BaseTy fullyResolved() const {
+    return detail::getIndirectTypeFullyResolved(this->impl)
+        .template cast<BaseTy>();
+  }
+
+  /// Get the size of the inner type in bits. The result is computed once when
+  /// the indirection is created. See `PackedType::getBitSize` and
+  /// `UnpackedType::getBitSize`.
+  std::optional<unsigned> getBitSize() const {
+    return detail::getIndirectTypeBitSize(this->impl);
+  }
 };
 
 /// A named type.
@@ -806,6 +819,9 @@ public:
   std::optional<Range> getRange() const;
   /// Get the dimension's size, or `None` if it is unsized.
   std::optional<unsigned> getSize() const;
+  /// Get the size of the element type in bits, or `None` if it has no fixed
+  /// size. This is computed once when the dimension is created.
+  std::optional<unsigned> getInnerBitSize() const;
 
 protected:
   using PackedType::PackedType;
@@ -891,6 +907,10 @@ public:
   /// `UnpackedType::fullyResolved`.
   UnpackedType fullyResolved() const;
 
+  /// Get the size of the element type in bits, or `None` if it has no fixed
+  /// size. This is computed once when the dimension is created.
+  std::optional<unsigned> getInnerBitSize() const;
+
 protected:
   using UnpackedType::UnpackedType;
   const detail::DimStorage *getImpl() const;
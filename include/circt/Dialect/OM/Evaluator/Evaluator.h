@@ -19,32 +19,43 @@
 #include "mlir/IR/Diagnostics.h"
 #include "mlir/IR/SymbolTable.h"
 #include "mlir/Support/LogicalResult.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/JSON.h"
 
 namespace circt {
 namespace om {
 
 /// A value of an object in memory. It is either a composite Object, or a
-/// primitive Attribute. Further refinement is expected.
-using ObjectValue = std::variant<std::shared_ptr<struct Object>, Attribute>;
+/// primitive Attribute. Objects are owned by the Evaluator that instantiated
+/// them and remain valid until it is destroyed.
+using ObjectValue = std::variant<struct Object *, Attribute>;
 
 /// The fields of a composite Object, currently represented as a map. Further
 /// refinement is expected.
 using ObjectFields = SmallDenseMap<StringAttr, ObjectValue>;
 
 /// An Evaluator, which is constructed with an IR module and can instantiate
-/// Objects. Further refinement is expected.
+/// Objects. Instantiations are hash-consed: instantiating the same class with
+/// the same actual parameters returns the same Object. The fields of an Object
+/// are only evaluated when they are first accessed.
 struct Evaluator {
   /// Construct an Evaluator with an IR module.
   Evaluator(ModuleOp mod);
 
-  /// Instantiate an Object with its class name and actual parameters.
-  FailureOr<std::shared_ptr<Object>>
-  instantiate(StringAttr className, ArrayRef<ObjectValue> actualParams);
+  Evaluator(const Evaluator &) = delete;
+  Evaluator &operator=(const Evaluator &) = delete;
+
+  /// Instantiate an Object with its class name and actual parameters. The
+  /// returned Object is owned by the Evaluator.
+  FailureOr<Object *> instantiate(StringAttr className,
+                                  ArrayRef<ObjectValue> actualParams);
 
   /// Get the Module this Evaluator is built from.
   mlir::ModuleOp getModule();
 
 private:
+  friend struct Object;
+
   /// Evaluate a Value in a Class body according to the small expression grammar
   /// described in the rationale document. The actual parameters are the values
   /// supplied at the current instantiation of the Class being evaluated.
@@ -65,9 +76,16 @@ private:
   /// Used to look up class definitions.
   SymbolTable symbolTable;
 
-  /// Object storage. Currently used for memoizing calls to evaluateValue.
-  /// Further refinement is expected.
-  mlir::DenseMap<Value, std::shared_ptr<Object>> objects;
+  /// Object storage. All Objects are freed at once with the Evaluator.
+  llvm::SpecificBumpPtrAllocator<Object> objectAllocator;
+
+  /// Storage for the instantiation keys and the actual parameters of Objects.
+  llvm::BumpPtrAllocator allocator;
+
+  /// The Objects instantiated so far, keyed on the class name followed by the
+  /// actual parameters. Since instantiations are hash-consed, an Object is
+  /// uniquely identified by its address.
+  DenseMap<ArrayRef<const void *>, Object *> instances;
 };
 
 /// A composite Object, which has a type and fields.
@@ -75,29 +93,47 @@ struct Object {
   /// Get the type of the Object.
   mlir::Type getType();
 
-  /// Get a field of the Object by name.
+  /// Get a field of the Object by name, evaluating it on first access.
   FailureOr<ObjectValue> getField(StringAttr name);
 
+  /// Get the actual parameters the Object was instantiated with.
+  ArrayRef<ObjectValue> getActualParams() { return actualParams; }
+
+  /// Get the names of the fields of the Object, in declaration order.
+  SmallVector<StringAttr> getFieldNames();
+
 private:
-  /// Allow the instantiate method as a friend to construct Objects.
-  friend FailureOr<std::shared_ptr<Object>>
-      Evaluator::instantiate(StringAttr, ArrayRef<ObjectValue>);
+  /// Allow the Evaluator to construct Objects.
+  friend struct Evaluator;
+
+  /// Construct an Object of the given Class with the given actual parameters.
+  Object(Evaluator &evaluator, ClassOp cls, ArrayRef<ObjectValue> actualParams);
 
-  /// Construct an Object of the given Class with the given fields.
-  Object(ClassOp cls, ObjectFields &fields);
+  /// The Evaluator which owns the Object, used to evaluate its fields.
+  Evaluator &evaluator;
 
   /// The Class of the Object.
   ClassOp cls;
 
-  /// The fields of the Object.
+  /// The actual parameters of the Object, allocated by the Evaluator.
+  ArrayRef<ObjectValue> actualParams;
+
+  /// The fields of the Object which have been evaluated so far.
   ObjectFields fields;
 };
 
+/// Stream an ObjectValue as JSON. An Object is written as a JSON object with a
+/// `$class` and an `$id` member, followed by its fields in declaration order.
+/// Objects may be shared and may refer to themselves, so every occurrence of an
+/// Object after the first one is written as `{"$ref": <id>}`. Fields which have
+/// not been accessed yet are evaluated along the way.
+LogicalResult serializeJSON(const ObjectValue &value, llvm::json::OStream &os);
+
 /// Helper to enable printing objects in Diagnostics.
 static inline mlir::Diagnostic &operator<<(mlir::Diagnostic &diag,
                                            const ObjectValue &objectValue) {
-  if (auto *object = std::get_if<std::shared_ptr<Object>>(&objectValue))
-    diag << *object;
+  if (auto *object = std::get_if<Object *>(&objectValue))
+    diag << (*object)->getType();
   if (auto *attribute = std::get_if<Attribute>(&objectValue))
     diag << *attribute;
   return diag;
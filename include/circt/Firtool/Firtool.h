@@ -38,6 +38,12 @@ struct FirtoolOptions {
           llvm::cl::init(circt::firrtl::PreserveAggregate::None),
           llvm::cl::cat(category)};
 
+  llvm::cl::opt<bool> preserveUniformVectors{
+      "preserve-uniform-vectors",
+      llvm::cl::desc("Preserve vectors which are only accessed as a whole or "
+                     "through dynamic subaccesses"),
+      llvm::cl::init(false), llvm::cl::cat(category)};
+
   llvm::cl::opt<firrtl::PreserveValues::PreserveMode> preserveMode{
       "preserve-values",
       llvm::cl::desc("Specify the values which can be optimized away"),
@@ -59,10 +65,30 @@ struct FirtoolOptions {
                                   "Compile with optimizations")),
       llvm::cl::cat(category)};
 
+  llvm::cl::opt<bool> compactFIRLocators{
+      "compact-fir-locators",
+      llvm::cl::desc("Drop the columns of the @info locations in the .fir "
+                     "file, such that all operations from the same source "
+                     "line share one location, to reduce memory use"),
+      llvm::cl::init(false), llvm::cl::cat(category)};
+
   llvm::cl::opt<bool> disableOptimization{
       "disable-opt", llvm::cl::desc("Disable optimizations"),
       llvm::cl::cat(category)};
 
+  llvm::cl::opt<bool> simplifyFIRRTL{
+      "simplify-firrtl",
+      llvm::cl::desc("Clean up the FIRRTL before lowering with a single-pass "
+                     "simplifier instead of the canonicalizer"),
+      llvm::cl::init(false), llvm::cl::cat(category)};
+
+  llvm::cl::opt<bool> simplifyCombAfterLowering{
+      "simplify-comb-after-lowering",
+      llvm::cl::desc("Clean up the output of LowerToHW with a single-pass "
+                     "combinational simplifier instead of CSE and "
+                     "canonicalization"),
+      llvm::cl::init(false), llvm::cl::cat(category)};
+
   llvm::cl::opt<bool> exportChiselInterface{
       "export-chisel-interface",
       llvm::cl::desc("Generate a Scala Chisel interface to the top level "
@@ -75,6 +101,12 @@ struct FirtoolOptions {
           "The output directory for generated Chisel interface files"),
       llvm::cl::init(""), llvm::cl::cat(category)};
 
+  llvm::cl::opt<bool> chiselInterfaceOnlyWriteChanged{
+      "chisel-interface-only-write-changed",
+      llvm::cl::desc("With chisel-interface-out-dir, do not rewrite interface "
+                     "files whose contents are unchanged"),
+      llvm::cl::init(false), llvm::cl::cat(category)};
+
   llvm::cl::opt<bool> vbToBV{
       "vb-to-bv",
       llvm::cl::desc("Transform vectors of bundles to bundles of vectors"),
@@ -84,6 +116,12 @@ struct FirtoolOptions {
       "dedup", llvm::cl::desc("Deduplicate structurally identical modules"),
       llvm::cl::init(false), llvm::cl::cat(category)};
 
+  llvm::cl::opt<bool> fastDedupHash{
+      "fast-dedup-hash",
+      llvm::cl::desc("Find modules to deduplicate using a non-cryptographic "
+                     "hash, confirmed by a structural comparison"),
+      llvm::cl::init(false), llvm::cl::cat(category)};
+
   llvm::cl::opt<bool> useOldCheckCombCycles{
       "use-old-check-comb-cycles",
       llvm::cl::desc(
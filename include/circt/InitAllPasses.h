@@ -23,6 +23,7 @@
 #include "circt/Dialect/FIRRTL/Passes.h"
 #include "circt/Dialect/FSM/FSMPasses.h"
 #include "circt/Dialect/HW/HWPasses.h"
+#include "circt/Dialect/HWArith/HWArithPasses.h"
 #include "circt/Dialect/Handshake/HandshakePasses.h"
 #include "circt/Dialect/LLHD/Transforms/Passes.h"
 #include "circt/Dialect/MSFT/MSFTPasses.h"
@@ -55,6 +56,7 @@ inline void registerAllPasses() {
   sv::registerPasses();
   handshake::registerPasses();
   hw::registerPasses();
+  hwarith::registerPasses();
   pipeline::registerPasses();
   ssp::registerPasses();
   systemc::registerPasses();
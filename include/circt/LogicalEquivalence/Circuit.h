@@ -22,6 +22,7 @@
 #include "mlir/IR/Value.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/Twine.h"
+#include <optional>
 #include <string>
 #include <z3++.h>
 
@@ -34,7 +35,24 @@ namespace circt {
 /// declaring new constraints over a Z3 context.
 class Solver::Circuit {
 public:
-  Circuit(llvm::Twine name, Solver &solver) : name(name.str()), solver(solver) {
+  /// A register of the circuit. Registers cut the circuit: their current state
+  /// is a free value and their next state is a function of it.
+  struct Register {
+    /// The hierarchical name of the register, through which it is matched to
+    /// its counterpart in the other circuit.
+    std::string name;
+    /// The current state.
+    z3::expr state;
+    /// The next state, which accounts for the reset if any.
+    z3::expr next;
+    /// The value taken while the reset is asserted.
+    std::optional<z3::expr> resetValue;
+  };
+
+  /// The circuits of the cycles after the first one when unrolling are given
+  /// their `cycle` number, which distinguishes their inputs.
+  Circuit(llvm::Twine name, Solver &solver, unsigned cycle = 0)
+      : name(name.str()), solver(solver), cycle(cycle) {
     assignments = 0;
   };
   /// Add an input to the circuit; internally a new value gets allocated.
@@ -45,12 +63,39 @@ public:
   llvm::ArrayRef<z3::expr> getInputs();
   /// Recover the outputs.
   llvm::ArrayRef<z3::expr> getOutputs();
+  /// Recover the structural ids of the outputs. Outputs with the same id
+  /// compute the same function of the inputs.
+  llvm::ArrayRef<unsigned> getOutputIds() { return outputIds; }
+  /// Recover the registers, including those of the instances.
+  llvm::ArrayRef<Register> getRegisters() { return registers; }
+  /// Recover the expression of a value of the exported module, if any.
+  std::optional<z3::expr> lookupExpr(mlir::Value value) {
+    auto it = exprTable.find(value);
+    if (it == exprTable.end())
+      return std::nullopt;
+    return it->second;
+  }
+
+  /// Record the top-level module the circuit was exported from, and the output
+  /// whose cone was exported if not all of them. Unrolling the circuit exports
+  /// the same logic again for each cycle.
+  void setTopModule(hw::HWModuleOp module, std::optional<unsigned> cone) {
+    topModule = module;
+    coneOutput = cone;
+  }
+  hw::HWModuleOp getTopModule() { return topModule; }
+  std::optional<unsigned> getConeOutput() { return coneOutput; }
 
   // `hw` dialect operations.
   void addConstant(mlir::Value result, const mlir::APInt &value);
   void addInstance(llvm::StringRef instanceName, circt::hw::HWModuleOp op,
                    mlir::OperandRange arguments, mlir::ResultRange results);
 
+  // `seq` dialect operations.
+  void addRegister(mlir::Value state, llvm::StringRef regName);
+  void setNextState(mlir::Value state, mlir::Value input, mlir::Value reset,
+                    mlir::Value resetValue);
+
   // `comb` dialect operations.
   void performAdd(mlir::Value result, mlir::OperandRange operands);
   void performAnd(mlir::Value result, mlir::OperandRange operands);
@@ -93,6 +138,10 @@ private:
   /// Constrains the result of a MLIR operation to be equal a given logical
   /// express, simulating an assignment.
   void constrainResult(mlir::Value &result, z3::expr &expr);
+  /// Records the structural id of `key` for a value represented by `expr`.
+  /// When another value already has the same id, the two are constrained to be
+  /// equal as they compute the same function.
+  void hashValue(mlir::Value value, const z3::expr &expr, llvm::StringRef key);
 
   /// Convert from bitvector to bool sort.
   z3::expr bvToBool(const z3::expr &condition);
@@ -107,12 +156,29 @@ private:
   unsigned assignments;
   /// The solver environment the circuit belongs to.
   Solver &solver;
+  /// The cycle the circuit represents when unrolling.
+  unsigned cycle;
   /// The list for the circuit's inputs.
   llvm::SmallVector<z3::expr> inputs;
   /// The list for the circuit's outputs.
   llvm::SmallVector<z3::expr> outputs;
   /// A map from IR values to their corresponding logical representation.
   llvm::DenseMap<mlir::Value, z3::expr> exprTable;
+  /// A map from IR values to their structural ids.
+  llvm::DenseMap<mlir::Value, unsigned> structuralIds;
+  /// The structural ids of the inputs of an instance, taken from the
+  /// arguments of the instance operation. Empty for the top-level circuits.
+  llvm::SmallVector<unsigned> inputIds;
+  /// The structural ids of the outputs.
+  llvm::SmallVector<unsigned> outputIds;
+  /// The list of the circuit's registers.
+  llvm::SmallVector<Register> registers;
+  /// A map from the current states of the registers to their index.
+  llvm::DenseMap<mlir::Value, unsigned> registerIndices;
+  /// The top-level module the circuit was exported from.
+  hw::HWModuleOp topModule;
+  /// The output whose cone was exported, if not all of them.
+  std::optional<unsigned> coneOutput;
 };
 
 } // namespace circt
@@ -41,6 +41,15 @@ public:
   mlir::LogicalResult run(mlir::ModuleOp &module);
   mlir::LogicalResult run(hw::HWModuleOp &module);
 
+  /// Only export the logic in the fan-in cone of the output with the given
+  /// index of the top-level module, and only that output.
+  void setOutputCone(unsigned output) { coneOutput = output; }
+
+  /// Find the module named `moduleName` within `module`, or its first module if
+  /// the name is empty. Emits an error if there is none.
+  static hw::HWModuleOp lookupModule(mlir::ModuleOp module,
+                                     llvm::StringRef moduleName);
+
 private:
   // For Solver::Circuit::addInstance to access Visitor::visitHW.
   friend Solver::Circuit;
@@ -50,6 +59,8 @@ private:
   /// The circuit representation to hold the logical constraints extracted
   /// from the IR.
   Solver::Circuit *circuit;
+  /// The output whose fan-in cone is exported, if not all of them.
+  std::optional<unsigned> coneOutput;
 };
 
 } // namespace circt
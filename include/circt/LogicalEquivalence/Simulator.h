@@ -0,0 +1,100 @@
+//===-- Simulator.h - Compiled simulation of circuits -----------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// This file defines a simulator which compiles two combinational circuits to
+/// native code and evaluates them on the same input vectors, to find
+/// counterexamples for the `circt-lec` tool without invoking the logical
+/// engine.
+///
+//===----------------------------------------------------------------------===//
+
+// NOLINTNEXTLINE
+#ifndef TOOLS_CIRCT_LEC_SIMULATOR_H
+#define TOOLS_CIRCT_LEC_SIMULATOR_H
+
+#include "circt/Dialect/HW/HWOps.h"
+#include "circt/Support/LLVM.h"
+#include "llvm/ADT/APInt.h"
+#include <array>
+
+namespace mlir {
+class ExecutionEngine;
+} // namespace mlir
+
+namespace circt {
+
+/// A compiled simulation of two circuits
+///
+/// Both circuits are lowered to LLVM and compiled just-in-time, each into a
+/// function from its concatenated inputs to its concatenated outputs. Only
+/// combinational modules of `comb` operations over integer ports are
+/// supported, and the two modules have to agree on their port widths.
+class Simulator {
+public:
+  /// The outcome of a simulation run.
+  enum class Result {
+    /// An input vector was found for which the outputs differ.
+    Mismatch,
+    /// All possible input vectors were simulated without a mismatch.
+    Equivalent,
+    /// Only some of the input vectors were simulated without a mismatch.
+    Inconclusive
+  };
+
+  /// Compile the two circuits for simulation. Returns null if either of
+  /// them can't be simulated.
+  static std::unique_ptr<Simulator> create(hw::HWModuleOp c1,
+                                           hw::HWModuleOp c2);
+  ~Simulator();
+
+  /// Evaluate the circuits on `numVectors` random input vectors drawn from
+  /// `seed`, after the all-zeros and all-ones vectors. Circuits with at most
+  /// `exhaustiveBits` input bits are evaluated on all input vectors instead.
+  Result run(uint64_t numVectors, unsigned exhaustiveBits, uint64_t seed);
+
+  /// Print the input vector of the last mismatch, and the outputs which
+  /// differ for it.
+  void printMismatch(llvm::raw_ostream &os) const;
+
+  /// Return the number of input vectors evaluated so far.
+  uint64_t getNumVectors() const { return numVectors; }
+
+private:
+  Simulator() = default;
+
+  /// Evaluate both circuits on an input vector. Returns false if their
+  /// outputs differ.
+  bool evaluate(const APInt &inputs);
+
+  /// The signature of the packed wrapper of a compiled circuit, which takes
+  /// pointers to the input vector and to the output vector.
+  using CircuitFn = void (*)(void **);
+
+  std::unique_ptr<mlir::ExecutionEngine> engine;
+  std::array<CircuitFn, 2> circuits = {};
+
+  /// The widths and names of the ports of the first circuit, in the order in
+  /// which they are concatenated from the least significant bit up.
+  SmallVector<unsigned> inputWidths, outputWidths;
+  SmallVector<std::string> inputNames, outputNames;
+  /// The widths of the input and output vectors, at least one bit each.
+  unsigned inputWidth = 1, outputWidth = 1;
+
+  /// Scratch space the compiled circuits read from and write to.
+  SmallVector<uint64_t> inputBuffer;
+  std::array<SmallVector<uint64_t>, 2> outputBuffers;
+
+  /// The input vector of the last mismatch and the outputs of both circuits.
+  APInt mismatchInputs;
+  std::array<APInt, 2> mismatchOutputs;
+  uint64_t numVectors = 0;
+};
+
+} // namespace circt
+
+#endif // TOOLS_CIRCT_LEC_SIMULATOR_H
@@ -17,6 +17,9 @@
 #include "circt/Support/LLVM.h"
 #include "mlir/IR/MLIRContext.h"
 #include "mlir/IR/Value.h"
+#include "llvm/ADT/StringMap.h"
+#include <array>
+#include <chrono>
 #include <z3++.h>
 
 namespace circt {
@@ -30,12 +33,35 @@ namespace circt {
 /// acting as a counterexample.
 class Solver {
 public:
-  Solver(mlir::MLIRContext *mlirCtx, bool statisticsOpt);
+  /// The logical engines which can check the circuits.
+  enum class Backend {
+    /// The SMT solver, reasoning over the theory of bitvectors.
+    SMT,
+    /// Bit-blast the constraints into a simplified and-inverter graph, which is
+    /// solved by a SAT solver. Usually faster on control logic.
+    SAT
+  };
+
+  /// A `timeout` in milliseconds applies to each check of the solver, zero
+  /// means no timeout. Circuits whose registers don't all match are unrolled
+  /// for `bound` cycles from their reset state, zero rejects them instead.
+  Solver(mlir::MLIRContext *mlirCtx, bool statisticsOpt, unsigned timeout = 0,
+         Backend backend = Backend::SMT, unsigned bound = 0);
   ~Solver() = default;
 
   /// Solve the equivalence problem between the two circuits, then present the
   /// results to the user.
   mlir::LogicalResult solve();
+  /// Solve the equivalence problem between the two circuits. Fails when their
+  /// inputs and outputs don't match.
+  mlir::FailureOr<z3::check_result> check();
+  /// Present a result of `check` to the user. Fails unless the circuits were
+  /// found to be equivalent.
+  mlir::LogicalResult report(z3::check_result result);
+  /// Check the `verif` properties of the first circuit for `bound` cycles
+  /// starting from its reset state, one cycle at a time, then present the
+  /// results to the user. Fails when an assertion can be violated.
+  mlir::LogicalResult checkProperties();
 
   class Circuit;
   /// Create a new circuit to be compared and return it.
@@ -52,17 +78,60 @@ private:
   /// and operational insight.
   void printStatistics();
 
+  /// A pair of values of the two circuits which have to be equal for the
+  /// circuits to be equivalent.
+  struct Obligation {
+    z3::expr lhs;
+    z3::expr rhs;
+    /// Whether the values are known to be equal by structural hashing.
+    bool structurallyEqual;
+    /// What the values are, for debugging purposes.
+    std::string description;
+  };
+
   /// Formulates additional constraints which are satisfiable if only if the
   /// two circuits which are being compared are NOT equivalent, in which case
   /// there would be a model acting as a counterexample.
   /// The procedure fails when detecting a mismatch of arity or type between
   /// the inputs and outputs of the circuits.
   mlir::LogicalResult constrainCircuits();
+  /// Reduces the sequential circuits to combinational ones when their
+  /// registers correspond to each other, by requiring equal current states to
+  /// produce equal next states. Otherwise the circuits are unrolled.
+  mlir::LogicalResult constrainRegisters();
+  /// Unrolls the circuits for `bound` cycles starting from their reset state,
+  /// requiring their outputs to be equal in each cycle.
+  mlir::LogicalResult unrollCircuits();
+  /// Checks the obligations one at a time. Values found to be equivalent are
+  /// constrained to be equal for the remaining checks.
+  z3::check_result checkOutputs();
+  /// Exports the logic of a circuit once more for the given cycle, with its
+  /// current states being the next states of the `previous` cycle.
+  mlir::FailureOr<Circuit *> unrollCircuit(Circuit *previous,
+                                           llvm::StringRef prefix,
+                                           unsigned cycle);
+  /// Prints the values of the inputs of the first circuit in each of the
+  /// given cycles of a counterexample.
+  void printTrace(llvm::ArrayRef<Circuit *> cycles);
 
   /// A map from internal solver symbols to the IR values they represent.
   llvm::DenseMap<mlir::StringAttr, mlir::Value> symbolTable;
+  /// The structural hashes of the values of both circuits: an operation and
+  /// the ids of its operands map to the id of its result.
+  llvm::StringMap<unsigned> structuralTable;
+  /// The first expression which was given each structural id.
+  llvm::SmallVector<z3::expr> representatives;
+  /// The number of output pairs found equivalent by structural hashing alone.
+  unsigned numStructurallyEqual = 0;
+  /// The time spent by the logical engine checking the outputs.
+  std::chrono::duration<double> checkTime{0};
   /// The two circuits to be compared.
   Circuit *circuits[2];
+  /// The circuits of the two sides for the cycles after the first one when
+  /// unrolling.
+  llvm::SmallVector<std::array<Circuit *, 2>> unrolledCircuits;
+  /// The pairs of values to be checked for equivalence.
+  llvm::SmallVector<Obligation> obligations;
   /// The MLIR context of reference, owning all the MLIR entities.
   mlir::MLIRContext *mlirCtx;
   /// The Z3 context of reference, owning all the declared values, constants
@@ -72,6 +141,8 @@ private:
   z3::solver solver;
   /// The value of the `statistics` command-line option.
   bool statisticsOpt;
+  /// The number of cycles to unroll circuits whose registers don't match.
+  unsigned bound;
 };
 
 } // namespace circt
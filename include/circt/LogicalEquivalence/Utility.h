@@ -20,26 +20,115 @@
 #include "llvm/ADT/APInt.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
+#include <mutex>
 #include <z3++.h>
 
 namespace lec {
+namespace detail {
+/// The lock held while writing to the streams shared between threads.
+inline std::mutex &getOutputMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+/// A stream of one thread writing to a stream shared between threads. While
+/// buffering, the output is collected and written to the shared stream in one
+/// go once buffering stops, such that it does not interleave with the output
+/// of other threads.
+class ThreadOutputStream : public llvm::raw_ostream {
+public:
+  explicit ThreadOutputStream(llvm::raw_ostream &os) : os(os) {
+    SetUnbuffered();
+  }
+  ~ThreadOutputStream() override { writeBuffer(); }
+
+  void startBuffering() { ++bufferingDepth; }
+  void stopBuffering() {
+    if (--bufferingDepth == 0)
+      writeBuffer();
+  }
+
+private:
+  void write_impl(const char *ptr, size_t size) override {
+    pos += size;
+    if (bufferingDepth > 0) {
+      buffer.append(ptr, size);
+      return;
+    }
+    std::lock_guard<std::mutex> lock(getOutputMutex());
+    os.write(ptr, size);
+  }
+  uint64_t current_pos() const override { return pos; }
+
+  void writeBuffer() {
+    if (buffer.empty())
+      return;
+    std::lock_guard<std::mutex> lock(getOutputMutex());
+    os << buffer;
+    os.flush();
+    buffer.clear();
+  }
+
+  llvm::raw_ostream &os;
+  std::string buffer;
+  unsigned bufferingDepth = 0;
+  uint64_t pos = 0;
+};
+
+inline ThreadOutputStream &threadDbgs() {
+  static thread_local ThreadOutputStream stream(llvm::dbgs());
+  return stream;
+}
+
+inline ThreadOutputStream &threadErrs() {
+  static thread_local ThreadOutputStream stream(llvm::errs());
+  return stream;
+}
+
+inline ThreadOutputStream &threadOuts() {
+  static thread_local ThreadOutputStream stream(llvm::outs());
+  return stream;
+}
+} // namespace detail
+
 // Defining persistent output streams such that text will be printed in
-// accordance with the globally set indentation level.
+// accordance with the set indentation level. The indentation is kept per
+// thread since the cones of the outputs may be checked in parallel.
 inline mlir::raw_indented_ostream &dbgs() {
-  static auto stream = mlir::raw_indented_ostream(llvm::dbgs());
+  static thread_local auto stream =
+      mlir::raw_indented_ostream(detail::threadDbgs());
   return stream;
 }
 
 inline mlir::raw_indented_ostream &errs() {
-  static auto stream = mlir::raw_indented_ostream(llvm::errs());
+  static thread_local auto stream =
+      mlir::raw_indented_ostream(detail::threadErrs());
   return stream;
 }
 
 inline mlir::raw_indented_ostream &outs() {
-  static auto stream = mlir::raw_indented_ostream(llvm::outs());
+  static thread_local auto stream =
+      mlir::raw_indented_ostream(detail::threadOuts());
   return stream;
 }
 
+/// RAII struct to collect the output of the current thread to the streams
+/// above, which is written in one go when it goes out of scope.
+struct BufferedOutput {
+  BufferedOutput() {
+    detail::threadDbgs().startBuffering();
+    detail::threadErrs().startBuffering();
+    detail::threadOuts().startBuffering();
+  }
+  ~BufferedOutput() {
+    detail::threadDbgs().stopBuffering();
+    detail::threadErrs().stopBuffering();
+    detail::threadOuts().stopBuffering();
+  }
+  BufferedOutput(const BufferedOutput &) = delete;
+  BufferedOutput &operator=(const BufferedOutput &) = delete;
+};
+
 /// RAII struct to indent the output streams.
 struct Scope {
   mlir::raw_indented_ostream::DelimitedScope indentDbgs = lec::dbgs().scope();
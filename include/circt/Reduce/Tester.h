@@ -53,7 +53,37 @@ public:
   /// Create a new test case for the given file already on disk.
   TestCase get(llvm::Twine filepath) const;
 
+  /// Test the test cases without running an external program: the pass
+  /// pipeline `testPipeline` is run on each of them in a forked child process,
+  /// which saves writing and parsing them again. A test case is interesting if
+  /// the pipeline emits a diagnostic matching the regular expression
+  /// `testDiagnostic`, or, if that is empty, if the pipeline crashes. The
+  /// context should have multithreading disabled.
+  void setInProcessTest(mlir::MLIRContext *context,
+                        llvm::StringRef testPipeline,
+                        llvm::StringRef testDiagnostic);
+
+  /// Whether test cases are tested in-process.
+  bool isInProcess() const { return context != nullptr; }
+
+  /// Write the test cases as MLIR bytecode rather than text.
+  void setEmitBytecode(bool emit) { emitBytecode = emit; }
+
+  /// Write a test case to `os` in the format given to the tests.
+  void print(mlir::ModuleOp module, llvm::raw_ostream &os) const;
+
 private:
+  friend class TestCase;
+
+  /// Run the test pipeline on `module`, or on the module parsed from the file
+  /// `testCase` if null, in a forked child process.
+  bool isInterestingInProcess(mlir::ModuleOp module,
+                              llvm::StringRef testCase) const;
+
+  /// The body of the child process running the test pipeline.
+  [[noreturn]] void runTestPipeline(mlir::ModuleOp module,
+                                    llvm::StringRef testCase) const;
+
   /// The binary to execute in order to check a reduction attempt for
   /// interestingness.
   llvm::StringRef testScript;
@@ -64,6 +94,19 @@ private:
   /// Consider the testcase to be interesting if it fails rather than on exit
   /// code 0.
   bool testMustFail;
+
+  /// The context of the test cases when testing in-process, null otherwise.
+  mlir::MLIRContext *context = nullptr;
+
+  /// The pass pipeline run on the test cases when testing in-process.
+  std::string testPipeline;
+
+  /// The regular expression matching the diagnostics of interest when testing
+  /// in-process. Crashes are of interest if empty.
+  std::string testDiagnostic;
+
+  /// Write test cases as MLIR bytecode.
+  bool emitBytecode = false;
 };
 
 /// A single test case to be run by a tester.
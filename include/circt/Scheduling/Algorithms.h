@@ -15,9 +15,15 @@
 
 #include "circt/Scheduling/Problems.h"
 
+#include <chrono>
+#include <optional>
+
 namespace circt {
 namespace scheduling {
 
+/// A point in time after which the iterative heuristics abandon their search.
+using Deadline = std::optional<std::chrono::steady_clock::time_point>;
+
 /// This is a simple list scheduler for solving the basic scheduling problem.
 /// Its objective is to assign each operation its earliest possible start time,
 /// or in other words, to schedule each operation as soon as possible (hence the
@@ -42,7 +48,10 @@ LogicalResult scheduleSimplex(CyclicProblem &prob, Operation *lastOp);
 /// programming-based heuristic. The approach tries to minimize the start time
 /// of the given \p lastOp, but optimality is not guaranteed. Fails if the
 /// dependence graph contains cycles, or \p prob does not include \p lastOp.
-LogicalResult scheduleSimplex(SharedOperatorsProblem &prob, Operation *lastOp);
+/// Also fails, without emitting a diagnostic, if the search is not finished
+/// by the given \p deadline.
+LogicalResult scheduleSimplex(SharedOperatorsProblem &prob, Operation *lastOp,
+                              Deadline deadline = std::nullopt);
 
 /// Solve the modulo scheduling problem using a linear programming-based
 /// heuristic. The approach tries to determine the smallest feasible initiation
@@ -53,6 +62,17 @@ LogicalResult scheduleSimplex(SharedOperatorsProblem &prob, Operation *lastOp);
 /// dependence graph.
 LogicalResult scheduleSimplex(ModuloProblem &prob, Operation *lastOp);
 
+/// Solve the modulo scheduling problem like above, but explore \p
+/// numCandidateIIs start values for the initiation interval concurrently, each
+/// on a separate copy of \p prob. Candidates are abandoned as soon as their II
+/// exceeds the best one found so far. The result is the solution with the
+/// smallest II, and never worse than the one of the sequential heuristic.
+/// Also fails, without emitting a diagnostic, if no candidate is finished by
+/// the given \p deadline.
+LogicalResult scheduleSimplex(ModuloProblem &prob, Operation *lastOp,
+                              unsigned numCandidateIIs,
+                              Deadline deadline = std::nullopt);
+
 /// Solve the acyclic, chaining-enabled problem using linear programming and a
 /// handwritten implementation of the simplex algorithm. This approach strictly
 /// adheres to the given maximum \p cycleTime. The objective is to minimize the
@@ -62,6 +82,23 @@ LogicalResult scheduleSimplex(ModuloProblem &prob, Operation *lastOp);
 LogicalResult scheduleSimplex(ChainingProblem &prob, Operation *lastOp,
                               float cycleTime);
 
+/// Solve the acyclic problem with shared operators using a priority-based list
+/// scheduler. Operations are scheduled in topological order, preferring the
+/// ones with the longest path to a sink of the dependence graph, at the
+/// earliest time step with a free operator instance. The approach runs in
+/// near-linear time, but does not minimize any particular objective. Fails if
+/// the dependence graph contains cycles.
+LogicalResult scheduleList(SharedOperatorsProblem &prob);
+
+/// Solve the modulo scheduling problem using Rau's iterative modulo scheduling
+/// heuristic. Starting at the lower bound given by the resource constraints
+/// and dependence cycles, each candidate initiation interval is attempted with
+/// a list scheduler that may evict previously scheduled operations, until a
+/// budget of scheduling steps proportional to the problem size is exhausted.
+/// Fails if the dependence graph contains cycles that do not include at least
+/// one edge with a non-zero distance.
+LogicalResult scheduleList(ModuloProblem &prob);
+
 /// Solve the basic problem using linear programming and an external LP solver.
 /// The objective is to minimize the start time of the given \p lastOp. Fails if
 /// the dependence graph contains cycles, or \p prob does not include \p lastOp.
@@ -24,6 +24,8 @@ namespace scheduling {
 
 using HandleOpFn = std::function<LogicalResult(Operation *)>;
 /// Visit \p prob's operations in topological order, using an internal worklist.
+/// The operations are sorted upfront, so that each one is visited just once in
+/// an acyclic dependence graph.
 ///
 /// \p fun is expected to report success if the given operation was handled
 /// successfully, and failure if an unhandled predecessor was detected.
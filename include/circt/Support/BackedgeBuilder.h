@@ -16,6 +16,7 @@
 #define CIRCT_SUPPORT_BACKEDGEBUILDER_H
 
 #include "mlir/IR/Location.h"
+#include "mlir/IR/TypeRange.h"
 #include "mlir/IR/Value.h"
 #include "llvm/ADT/SmallVector.h"
 
@@ -58,6 +59,12 @@ public:
   /// constructor will be used.
   Backedge get(mlir::Type resultType, mlir::LocationAttr optionalLoc = {});
 
+  /// Create typed backedges in bulk. All of them are results of a single
+  /// cursor op, which is erased once none of them is in use anymore. If no
+  /// location is provided, the one passed to the constructor will be used.
+  llvm::SmallVector<Backedge> get(mlir::TypeRange resultTypes,
+                                  mlir::LocationAttr optionalLoc = {});
+
   /// Clear the backedges, erasing any remaining cursor ops. Returns `failure`
   /// and emits diagnostic messages if a backedge is still active.
   mlir::LogicalResult clearOrEmitError();
@@ -82,6 +89,7 @@ class Backedge {
 
   /// `Backedge` is constructed exclusively by `BackedgeBuilder`.
   Backedge(mlir::Operation *op);
+  Backedge(mlir::Value value) : value(value) {}
 
 public:
   Backedge() {}
@@ -0,0 +1,51 @@
+//===- ExpressionInfo.h - Structural hashing of operations ------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines a DenseMapInfo for operations which considers two
+// operations equal if they compute the same expression, for use in hash
+// tables that deduplicate side-effect free operations.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CIRCT_SUPPORT_EXPRESSIONINFO_H
+#define CIRCT_SUPPORT_EXPRESSIONINFO_H
+
+#include "circt/Support/LLVM.h"
+#include "mlir/IR/OperationSupport.h"
+#include "llvm/ADT/DenseMapInfo.h"
+
+namespace circt {
+
+/// Hash and compare operations by their name, attributes, result types and
+/// operands, ignoring their locations.
+struct ExpressionInfo : public llvm::DenseMapInfo<Operation *> {
+  static unsigned getHashValue(const Operation *opC) {
+    return mlir::OperationEquivalence::computeHash(
+        const_cast<Operation *>(opC),
+        /*hashOperands=*/mlir::OperationEquivalence::directHashValue,
+        /*hashResults=*/mlir::OperationEquivalence::ignoreHashValue,
+        mlir::OperationEquivalence::IgnoreLocations);
+  }
+  static bool isEqual(const Operation *lhsC, const Operation *rhsC) {
+    auto *lhs = const_cast<Operation *>(lhsC);
+    auto *rhs = const_cast<Operation *>(rhsC);
+    if (lhs == rhs)
+      return true;
+    if (lhs == getTombstoneKey() || lhs == getEmptyKey() ||
+        rhs == getTombstoneKey() || rhs == getEmptyKey())
+      return false;
+    return lhs->getName() == rhs->getName() &&
+           lhs->getAttrDictionary() == rhs->getAttrDictionary() &&
+           lhs->getResultTypes() == rhs->getResultTypes() &&
+           lhs->getOperands() == rhs->getOperands();
+  }
+};
+
+} // namespace circt
+
+#endif // CIRCT_SUPPORT_EXPRESSIONINFO_H
@@ -107,7 +107,11 @@ struct DenseMapInfo<circt::FieldRef> {
     return circt::FieldRef(DenseMapInfo<mlir::Value>::getTombstoneKey(), 0);
   }
   static unsigned getHashValue(const circt::FieldRef &val) {
-    return circt::hash_value(val);
+    // Combine the hashes the same way DenseMapInfo<std::pair> does, which is
+    // much cheaper than the generic hash_combine.
+    return detail::combineHashValue(
+        DenseMapInfo<mlir::Value>::getHashValue(val.getValue()),
+        DenseMapInfo<unsigned>::getHashValue(val.getFieldID()));
   }
   static bool isEqual(const circt::FieldRef &lhs, const circt::FieldRef &rhs) {
     return lhs == rhs;
@@ -25,6 +25,21 @@ LogicalResult convertAttributeToJSON(llvm::json::OStream &json, Attribute attr);
 Attribute convertJSONToAttribute(MLIRContext *context, llvm::json::Value &value,
                                  llvm::json::Path p);
 
+/// Parse JSON text directly into an MLIR Attribute, without building an
+/// intermediate `llvm::json::Value`.  The result is the same as parsing the
+/// text with `llvm::json::parse` and calling `convertJSONToAttribute`.
+/// Returns a null attribute if the text is not valid JSON; callers that want a
+/// detailed diagnostic should re-parse it with `llvm::json::parse`.
+Attribute parseJSONToAttribute(MLIRContext *context, StringRef text);
+
+/// Parse JSON text that contains a top-level array, calling `callback` with
+/// each element converted to an Attribute as soon as it has been parsed.  The
+/// top-level array itself is never materialized.  Fails if the text is not a
+/// valid JSON array or if the callback fails.
+LogicalResult
+parseJSONArrayToAttributes(MLIRContext *context, StringRef text,
+                           function_ref<LogicalResult(Attribute)> callback);
+
 } // namespace circt
 
 #endif // CIRCT_SUPPORT_JSON_H
@@ -158,6 +158,10 @@ struct LoweringOptions {
 
   /// If true, do not emit a version comment at the top of each verilog file.
   bool omitVersionComment = false;
+
+  /// If true, emit LTL expressions shared by multiple properties in a module as
+  /// named `sequence` and `property` declarations.
+  bool emitSharedLTLDeclarations = false;
 };
 } // namespace circt
 
@@ -64,13 +64,15 @@ public:
     if (inserted.second)
       return inserted.first->getKey();
 
-    // Try different suffixes until we get a collision-free one.
-    if (tryName.empty())
-      name.toVector(tryName); // toStringRef may leave tryName unfilled
+    // Try different suffixes until we get a collision-free one.  The entry of
+    // the colliding name holds the next index to try, so there is no need to
+    // look it up again.  Entries are never moved by later insertions.  As
+    // toStringRef may leave tryName unfilled, copy the name from the entry.
+    size_t &i = inserted.first->second;
+    tryName = inserted.first->getKey();
 
-    // Indexes less than nextIndex[tryName] are lready used, so skip them.
+    // Indexes less than nextIndex[tryName] are already used, so skip them.
     // Indexes larger than nextIndex[tryName] may be used in another name.
-    size_t &i = nextIndex[tryName];
     tryName.push_back('_');
     size_t baseLength = tryName.size();
     do {
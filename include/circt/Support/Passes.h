@@ -14,6 +14,7 @@
 #include "mlir/Pass/PassInstrumentation.h"
 #include "llvm/Support/Chrono.h"
 #include "llvm/Support/Format.h"
+#include <mutex>
 
 namespace circt {
 // This class prints logs before and after of pass executions when its pass
@@ -56,6 +57,56 @@ public:
   }
 };
 
+/// A machine-readable report of the time, memory and IR size of every pass
+/// execution. Instrumentations created from the report may be added to several
+/// pass managers and record into the same report. Since nested passes run in
+/// parallel, the report is thread-safe.
+class PassPerfReport {
+public:
+  /// A single execution of a pass on an operation.
+  struct Execution {
+    /// The pass argument, or the pass name if it has no argument.
+    std::string pass;
+    /// The name of the operation the pass ran on.
+    std::string opName;
+    /// The symbol name of the operation, if it has one.
+    std::string symName;
+    bool failed = false;
+    /// The wall time in seconds.
+    double wallTime = 0;
+    /// The number of operations before and after the pass, including the
+    /// operation the pass ran on.
+    size_t numOpsBefore = 0;
+    size_t numOpsAfter = 0;
+    /// Whether no other pass executions ran concurrently, other than the ones
+    /// nested inside this one. The process-wide measurements below are only
+    /// meaningful for exclusive executions.
+    bool exclusive = false;
+    /// The CPU time in seconds spent by all threads.
+    double cpuTime = 0;
+    /// The CPU time divided by the wall time and the number of threads.
+    double parallelEfficiency = 0;
+    /// The change in the number of bytes allocated with malloc.
+    int64_t mallocDelta = 0;
+    /// The peak resident set size in bytes at the end of the pass, or 0 if it
+    /// is not available on this platform.
+    uint64_t peakRSS = 0;
+  };
+
+  /// Create an instrumentation which records into this report.
+  std::unique_ptr<mlir::PassInstrumentation> createInstrumentation();
+
+  /// Add an execution to the report.
+  void addExecution(Execution execution);
+
+  /// Print the report as JSON.
+  void print(llvm::raw_ostream &os);
+
+private:
+  std::mutex mutex;
+  std::vector<Execution> executions;
+};
+
 /// Create a simple canonicalizer pass.
 std::unique_ptr<Pass> createSimpleCanonicalizerPass();
 
@@ -27,7 +27,6 @@
 #include "llvm/Support/SaveAndRestore.h"
 
 #include <cstdint>
-#include <deque>
 #include <limits>
 
 namespace circt {
@@ -216,6 +215,45 @@ public:
   static constexpr uint32_t kInfinity = (1U << 15) - 1;
 
 private:
+  /// A FIFO queue stored in a vector.  Popped elements are reclaimed in bulk,
+  /// once the queue drains or they make up half of the storage, which avoids
+  /// the allocation churn of a deque.  Elements are indexed relative to the
+  /// front of the queue.
+  template <typename T>
+  class Queue {
+  public:
+    bool empty() const { return head == storage.size(); }
+    size_t size() const { return storage.size() - head; }
+    T &operator[](size_t index) { return storage[head + index]; }
+    T &front() { return storage[head]; }
+    T &back() { return storage.back(); }
+    auto begin() { return storage.begin() + head; }
+    auto end() { return storage.end(); }
+    void push_back(const T &value) { storage.push_back(value); }
+    void pop_back() {
+      storage.pop_back();
+      if (empty())
+        clear();
+    }
+    void pop_front() {
+      ++head;
+      if (empty())
+        clear();
+      else if (head >= 64 && head * 2 >= storage.size()) {
+        storage.erase(storage.begin(), storage.begin() + head);
+        head = 0;
+      }
+    }
+    void clear() {
+      storage.clear();
+      head = 0;
+    }
+
+  private:
+    SmallVector<T> storage;
+    size_t head = 0;
+  };
+
   /// Format token with tracked size.
   struct FormattedToken {
     Token token;  /// underlying token
@@ -265,12 +303,12 @@ private:
   int32_t rightTotal;
 
   /// Unprinted tokens, combination of 'token' and 'size' in Oppen.
-  std::deque<FormattedToken> tokens;
+  Queue<FormattedToken> tokens;
   /// index of first token, for resolving scanStack entries.
   uint32_t tokenOffset = 0;
 
   /// Stack of begin/break tokens, adjust by tokenOffset to index into tokens.
-  std::deque<uint32_t> scanStack;
+  Queue<uint32_t> scanStack;
 
   /// Stack of printing contexts (indentation + breaking behavior).
   SmallVector<PrintEntry> printStack;
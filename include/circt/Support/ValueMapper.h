@@ -40,7 +40,8 @@ public:
 
   // Get the mapped value of value 'from'. If no mapping has been registered, a
   // new backedge is created. The type of the mapped value may optionally be
-  // modified through the 'typeTransformer'.
+  // modified through the 'typeTransformer'. The backedges for a range of
+  // values are created in bulk.
   mlir::Value get(mlir::Value from,
                   TypeTransformer typeTransformer = ValueMapper::identity);
   llvm::SmallVector<mlir::Value>
@@ -53,6 +54,9 @@ public:
   void set(mlir::Value from, mlir::Value to, bool replace = false);
   void set(mlir::ValueRange from, mlir::ValueRange to, bool replace = false);
 
+  // Reserve space for mapping 'n' values.
+  void reserve(size_t n) { mapping.reserve(n); }
+
 private:
   BackedgeBuilder *bb = nullptr;
   llvm::DenseMap<mlir::Value, std::variant<mlir::Value, Backedge>> mapping;
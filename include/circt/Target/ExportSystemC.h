@@ -20,6 +20,12 @@ namespace ExportSystemC {
 
 LogicalResult exportSystemC(ModuleOp module, llvm::raw_ostream &os);
 
+/// Emits the flat HW modules in the given module as C++ structs with an 'eval'
+/// function that computes the next state of the design and its outputs without
+/// requiring a simulation kernel. Registers are advanced on the rising edges of
+/// their clocks, which have to be module inputs.
+LogicalResult exportEvalModel(ModuleOp module, llvm::raw_ostream &os);
+
 LogicalResult exportSplitSystemC(ModuleOp module, StringRef directory);
 
 void registerExportSystemCTranslation();
@@ -60,8 +60,37 @@ with Context() as ctx, Location.unknown():
 
     hw.HWModuleOp(name="test", body_builder=build)
 
+    def build_bulk(module):
+      ops = [
+          ("hw.constant", [], [i32], {
+              "value": IntegerAttr.get(i32, 3)
+          }),
+          ("comb.add", [(-1, 0), (0, 0)], [i32], {}),
+          ("comb.mul", [(1, 0), (1, 0)], [i32], {}),
+      ]
+      created = hw.build_operations(module.operation, None, Location.unknown(),
+                                    [module.entry_block.arguments[0]], ops)
+      return {"x": created[2].results[0]}
+
+    # CHECK-LABEL: hw.module @bulk(%a: i32) -> (x: i32)
+    # CHECK:         %c3_i32 = hw.constant 3 : i32
+    # CHECK:         [[SUM:%.+]] = comb.add %a, %c3_i32 : i32
+    # CHECK:         [[PROD:%.+]] = comb.mul [[SUM]], [[SUM]] : i32
+    # CHECK:         hw.output [[PROD]] : i32
+    hw.HWModuleOp(name="bulk",
+                  input_ports=[("a", i32)],
+                  output_ports=[("x", i32)],
+                  body_builder=build_bulk)
+
   print(m)
 
+  # CHECK: Invalid operation description
+  try:
+    hw.build_operations(m.operation, None, Location.unknown(), [],
+                        [("comb.add", [(5, 0)], [i32], {})])
+  except ValueError as e:
+    print(e)
+
   # CHECK: !hw.typealias<@myscope::@myname, i1>
   # CHECK: i1
   # CHECK: i1
@@ -6,6 +6,7 @@ from circt.dialects import om
 from circt.ir import Context, InsertionPoint, Location, Module
 from circt.support import var_to_attribute
 
+from array import array
 from dataclasses import dataclass
 
 with Context() as ctx, Location.unknown():
@@ -16,6 +17,12 @@ with Context() as ctx, Location.unknown():
     om.class @Test(%param: i64) {
       om.class.field @field, %param : i64
     }
+
+    om.class @Buffers(%param: tensor<4xi32>) {
+      %0 = om.constant dense<[1.5, 2.5]> : tensor<2xf64>
+      om.class.field @ints, %param : tensor<4xi32>
+      om.class.field @floats, %0 : tensor<2xf64>
+    }
   }
   """)
 
@@ -66,3 +73,22 @@ obj = evaluator.instantiate(Test, 42)
 
 # CHECK: Test(field=42)
 print(obj)
+
+# Test JSON serialization.
+
+# CHECK: {"$id":0,"$class":"Test","field":42}
+print(evaluator.instantiate_json("Test", 42))
+
+# Test dense elements, which are passed and returned through buffers.
+
+
+@dataclass
+class Buffers:
+  ints: memoryview
+  floats: memoryview
+
+
+obj = evaluator.instantiate(Buffers, array("i", [1, 2, 3, 4]))
+
+# CHECK: [1, 2, 3, 4] [1.5, 2.5]
+print(obj.ints.tolist(), obj.floats.tolist())
@@ -0,0 +1,27 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+// Step the model with the clock scheduler of the runtime header. The first
+// argument is the number of steps, followed by `<clock>=<period>` arguments as
+// passed to `arcilator --clock-period`.
+int main(int argc, char **argv) {
+  if (argc < 2)
+    return 1;
+  Counters model;
+  for (int i = 2; i < argc; ++i) {
+    std::string arg = argv[i];
+    auto split = arg.find('=');
+    if (split == std::string::npos ||
+        !model.scheduler.setPeriod(arg.substr(0, split),
+                                   std::stoull(arg.substr(split + 1)))) {
+      std::cerr << "invalid clock period `" << arg << "`\n";
+      return 1;
+    }
+  }
+  for (unsigned long steps = std::stoul(argv[1]); steps > 0; --steps)
+    model.step();
+  std::cout << std::hex << "a = 0x" << unsigned(model.view.a) << "\n"
+            << "b = 0x" << unsigned(model.view.b) << "\n";
+  return 0;
+}
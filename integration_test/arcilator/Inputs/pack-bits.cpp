@@ -0,0 +1,34 @@
+#include <iostream>
+
+int main() {
+  Bits model;
+  auto &view = model.view;
+  auto print = [&] {
+    std::cout << "ra=" << view.internal.ra << " rb=" << view.internal.rb
+              << "\n";
+  };
+
+  // Clock a one into the first register.
+  auto start = model.snapshot();
+  view.a = 1;
+  model.clock();
+  model.passthrough();
+  print();
+  for (auto &name : model.diff(start))
+    std::cout << "changed " << name << "\n";
+
+  // Writing one packed bit leaves the other one alone.
+  auto clocked = model.snapshot();
+  view.internal.rb = true;
+  print();
+  for (auto &name : model.diff(clocked))
+    std::cout << "changed " << name << "\n";
+
+  // Only the changed bit shows up in the trace.
+  auto vcd = model.vcd(std::cout);
+  view.internal.ra = false;
+  vcd.writeTimestep(1);
+  vcd.flush();
+  print();
+  return 0;
+}
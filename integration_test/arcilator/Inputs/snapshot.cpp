@@ -0,0 +1,44 @@
+#include <iostream>
+
+int main() {
+  Snap model;
+  auto &view = model.view;
+  auto print = [&] {
+    std::cout << "count=" << unsigned(view.internal.count)
+              << " mem=" << view.internal.mem.read(900) << "\n";
+  };
+  auto printDiff = [](const char *label,
+                      const std::vector<std::string> &names) {
+    std::cout << label << "\n";
+    for (auto &name : names)
+      std::cout << "changed " << name << "\n";
+  };
+
+  // Warm up the model and take a base snapshot.
+  model.clock();
+  model.passthrough();
+  auto base = model.snapshot();
+
+  // Mutate the dense state and allocate a new page of the sparse memory.
+  model.clock();
+  view.internal.mem[900] = 9;
+  model.passthrough();
+  printDiff("diff live", model.diff(base));
+  auto after = model.snapshot(&base);
+  printDiff("diff snapshots", Snap::diff(base, after));
+
+  // Restoring the base snapshot undoes both.
+  std::cout << "restore base\n";
+  model.restore(base);
+  print();
+  printDiff("diff live", model.diff(base));
+  printDiff("diff snapshots", Snap::diff(base, model.snapshot(&base)));
+
+  // Restoring the later snapshot brings the page back.
+  std::cout << "restore after\n";
+  model.restore(after);
+  print();
+  printDiff("diff snapshots", Snap::diff(after, model.snapshot()));
+  std::cout << "done\n";
+  return 0;
+}
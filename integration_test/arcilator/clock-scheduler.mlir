@@ -0,0 +1,31 @@
+// REQUIRES: python, host-cxx
+// RUN: arcilator %s --state-file=%t.json -o %t.ll
+// RUN: llc -O1 --filetype=obj --relocation-model=pic %t.ll -o %t.o
+// RUN: %PYTHON% %CIRCT_TOOLS%/arcilator-header-cpp.py %t.json > %t.h
+// RUN: %host_cxx -std=c++17 -I%CIRCT_TOOLS% -include %t.h %S/Inputs/clock-scheduler.cpp %t.o -o %t.exe
+
+// The `ClockScheduler` of the runtime header and `arcilator --run` with
+// `--clock-period` step the clock domains the same way.
+
+// RUN: %t.exe 8 | FileCheck %s --check-prefix=ALL
+// RUN: arcilator %s --run --run-cycles=8 2>/dev/null | FileCheck %s --check-prefix=ALL
+// RUN: %t.exe 8 slow=4 | FileCheck %s --check-prefix=SLOW
+// RUN: arcilator %s --run --run-cycles=8 --clock-period=slow=4 2>/dev/null | FileCheck %s --check-prefix=SLOW
+// RUN: %t.exe 6 fast=2 slow=3 | FileCheck %s --check-prefix=MIXED
+// RUN: arcilator %s --run --run-cycles=6 --clock-period=fast=2,slow=3 2>/dev/null | FileCheck %s --check-prefix=MIXED
+
+// ALL-DAG:   a = 0x8
+// ALL-DAG:   b = 0x8
+// SLOW-DAG:  a = 0x8
+// SLOW-DAG:  b = 0x2
+// MIXED-DAG: a = 0x4
+// MIXED-DAG: b = 0x3
+
+hw.module @Counters(%fast: i1, %slow: i1) -> (a: i8, b: i8) {
+  %c1_i8 = hw.constant 1 : i8
+  %0 = comb.add %a, %c1_i8 : i8
+  %a = seq.compreg %0, %fast : i8
+  %1 = comb.add %b, %c1_i8 : i8
+  %b = seq.compreg %1, %slow : i8
+  hw.output %a, %b : i8, i8
+}
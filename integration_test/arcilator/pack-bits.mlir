@@ -0,0 +1,33 @@
+// REQUIRES: python, host-cxx
+// RUN: arcilator %s --pack-bits --state-file=%t.json -o %t.ll
+// RUN: llc -O1 --filetype=obj --relocation-model=pic %t.ll -o %t.o
+// RUN: %PYTHON% %CIRCT_TOOLS%/arcilator-header-cpp.py %t.json > %t.h
+// RUN: %host_cxx -std=c++17 -I%CIRCT_TOOLS% -include %t.h %S/Inputs/pack-bits.cpp %t.o -o %t.exe
+// RUN: %t.exe | FileCheck %s
+// RUN: FileCheck %s --input-file=%t.json --check-prefix=STATE
+
+// The two internal registers are only accessed from the clock tree and share a
+// byte, which the generated view, the snapshot diffs, and the trace have to
+// mask.
+
+// STATE-DAG: "bit": 0
+// STATE-DAG: "bit": 1
+
+// CHECK:      ra=1 rb=0
+// CHECK-NEXT: changed Bits.a
+// CHECK-NEXT: changed Bits.internal.ra
+// CHECK-NEXT: ra=1 rb=1
+// CHECK-NEXT: changed Bits.internal.rb
+// CHECK:      $var reg 1 [[RA:[^ ]+]] ra $end
+// CHECK:      $enddefinitions $end
+// CHECK:      #1
+// CHECK-NEXT: 0[[RA]]
+// CHECK-NEXT: ra=0 rb=1
+
+hw.module @Bits(%clock: i1, %a: i1) -> (x: i1) {
+  %ra = seq.compreg %a, %clock : i1
+  %rb = seq.compreg %ra, %clock : i1
+  %0 = comb.xor %ra, %rb : i1
+  %rx = seq.compreg %0, %clock : i1
+  hw.output %rx : i1
+}
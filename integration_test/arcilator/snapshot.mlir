@@ -0,0 +1,36 @@
+// REQUIRES: python, host-cxx
+// RUN: arcilator %s --sparse-memory-threshold=512 --state-file=%t.json -o %t.ll
+// RUN: llc -O1 --filetype=obj --relocation-model=pic %t.ll -o %t.o
+// RUN: %PYTHON% %CIRCT_TOOLS%/arcilator-header-cpp.py %t.json > %t.h
+// RUN: %host_cxx -std=c++17 -I%CIRCT_TOOLS% -include %t.h %S/Inputs/snapshot.cpp %t.o -o %t.exe
+// RUN: %t.exe | FileCheck %s
+
+// Snapshots cover the dense state as well as the pages of the sparse memory,
+// both when diffing against the live model and between two snapshots.
+
+// CHECK-LABEL: diff live
+// CHECK-DAG:   changed Snap.n
+// CHECK-DAG:   changed Snap.internal.count
+// CHECK-DAG:   changed Snap.internal.mem
+// CHECK-LABEL: diff snapshots
+// CHECK-DAG:   changed Snap.n
+// CHECK-DAG:   changed Snap.internal.count
+// CHECK-DAG:   changed Snap.internal.mem
+// CHECK-LABEL: restore base
+// CHECK-NEXT:  count=1 mem=0
+// CHECK-NEXT:  diff live
+// CHECK-NEXT:  diff snapshots
+// CHECK-NEXT:  restore after
+// CHECK-NEXT:  count=2 mem=9
+// CHECK-NEXT:  diff snapshots
+// CHECK-NEXT:  done
+
+hw.module @Snap(%clock: i1, %en: i1, %addr: i10, %data: i16) -> (q: i16, n: i8) {
+  %c1_i8 = hw.constant 1 : i8
+  %0 = comb.add %count, %c1_i8 : i8
+  %count = seq.compreg %0, %clock : i8
+  %1 = hw.instance "mem" @Mem(R0_addr: %addr: i10, R0_en: %en: i1, R0_clk: %clock: i1, W0_addr: %addr: i10, W0_en: %en: i1, W0_clk: %clock: i1, W0_data: %data: i16) -> (R0_data: i16)
+  hw.output %1, %count : i16, i8
+}
+hw.generator.schema @FIRRTLMem, "FIRRTL_Memory", ["depth", "numReadPorts", "numWritePorts", "numReadWritePorts", "readLatency", "writeLatency", "width", "maskGran", "readUnderWrite", "writeUnderWrite", "writeClockIDs"]
+hw.module.generated @Mem, @FIRRTLMem(%R0_addr: i10, %R0_en: i1, %R0_clk: i1, %W0_addr: i10, %W0_en: i1, %W0_clk: i1, %W0_data: i16) -> (R0_data: i16) attributes {depth = 1024 : i64, maskGran = 16 : ui32, numReadPorts = 1 : ui32, numReadWritePorts = 0 : ui32, numWritePorts = 1 : ui32, readLatency = 0 : ui32, readUnderWrite = 0 : ui32, width = 16 : ui32, writeClockIDs = [], writeLatency = 1 : ui32, writeUnderWrite = 1 : i32}
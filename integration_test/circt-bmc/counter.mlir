@@ -0,0 +1,50 @@
+// These tests will be only enabled if circt-bmc is built.
+// REQUIRES: circt-lec
+
+// The counter can't reach ten within eight cycles of its reset.
+//  RUN: circt-bmc %s --module=counter --bound=8 | FileCheck %s --check-prefix=SAFE
+//  SAFE: no assertion violated within 8 cycles
+
+// It does so in cycle ten when enabled all along.
+//  RUN: not circt-bmc %s --module=counter --bound=12 2>&1 | FileCheck %s --check-prefix=UNSAFE
+//  UNSAFE: error: assertion violated in cycle 10
+//  UNSAFE: Trace:
+//  UNSAFE: cycle 0: clk = {{[0-9]+}} rst = 0 en = 1
+//  UNSAFE: cycle 9: clk = {{[0-9]+}} rst = 0 en = 1
+//  UNSAFE: cycle 10:
+
+// The counter never reaches ten when it is only enabled in the cycle after a
+// reset, but it still reaches one.
+//  RUN: circt-bmc %s --module=counterAssume --bound=12 2>&1 | FileCheck %s --check-prefix=ASSUME
+//  ASSUME: remark: cover reached in cycle 1
+//  ASSUME: no assertion violated within 12 cycles
+
+hw.module @counter(%clk: i1, %rst: i1, %en: i1) -> (count: i4) {
+  %zero = hw.constant 0 : i4
+  %one = hw.constant 1 : i4
+  %ten = hw.constant 10 : i4
+  %count = seq.compreg %next, %clk, %rst, %zero : i4
+  %inc = comb.add bin %count, %one : i4
+  %next = comb.mux bin %en, %inc, %count : i4
+  %ok = comb.icmp bin ne %count, %ten : i4
+  verif.assert %ok : i1
+  hw.output %count : i4
+}
+
+hw.module @counterAssume(%clk: i1, %rst: i1, %en: i1) -> (count: i4) {
+  %zero = hw.constant 0 : i4
+  %one = hw.constant 1 : i4
+  %ten = hw.constant 10 : i4
+  %count = seq.compreg %next, %clk, %rst, %zero : i4
+  %inc = comb.add bin %count, %one : i4
+  %next = comb.mux bin %en, %inc, %count : i4
+  // The counter is only ever enabled in the cycle after a reset.
+  %rstPrev = seq.compreg %rst, %clk : i1
+  %enabledAfterReset = comb.icmp bin ule %en, %rstPrev : i1
+  verif.assume %enabledAfterReset : i1
+  %ok = comb.icmp bin ne %count, %ten : i4
+  verif.assert %ok : i1
+  %isOne = comb.icmp bin eq %count, %one : i4
+  verif.cover %isOne : i1
+  hw.output %count : i4
+}
@@ -0,0 +1,60 @@
+// These tests will be only enabled if circt-bmc is built.
+// REQUIRES: circt-lec
+
+// An acknowledgement follows each request in the next cycle.
+//  RUN: circt-bmc %s --module=handshake --bound=6 | FileCheck %s --check-prefix=NEXT
+//  NEXT: no assertion violated within 6 cycles
+
+// A slower acknowledgement misses the next cycle, which is found as soon as
+// the cycle after the first request is unrolled.
+//  RUN: not circt-bmc %s --module=slowHandshake --bound=6 2>&1 | FileCheck %s --check-prefix=SLOW
+//  SLOW: error: assertion violated in cycle 0
+//  SLOW: Trace:
+//  SLOW-NEXT: cycle 0: clk = {{[0-9]+}} rst = {{[0-9]+}} req = 1
+//  SLOW-NEXT: cycle 1:
+//  SLOW-NOT: cycle 2:
+
+// The slower acknowledgement is still within a window of two cycles, unless a
+// reset drops the request in the meantime, which disables the property.
+//  RUN: circt-bmc %s --module=slowHandshakeWindow --bound=6 | FileCheck %s --check-prefix=WINDOW
+//  WINDOW: no assertion violated within 6 cycles
+
+// Unbounded delays can't be decided within a bounded number of cycles.
+//  RUN: not circt-bmc %s --module=unbounded 2>&1 | FileCheck %s --check-prefix=UNBOUNDED
+//  UNBOUNDED: error: 'ltl.delay' op with unbounded length not supported by the model checker
+
+hw.module @handshake(%clk: i1, %req: i1) -> () {
+  %ack = seq.compreg %req, %clk : i1
+  %next = ltl.delay %ack, 1, 0 : i1
+  %property = ltl.implication %req, %next : i1, !ltl.sequence
+  verif.assert %property : !ltl.property
+  hw.output
+}
+
+hw.module @slowHandshake(%clk: i1, %rst: i1, %req: i1) -> () {
+  %false = hw.constant false
+  %pending = seq.compreg %req, %clk, %rst, %false : i1
+  %ack = seq.compreg %pending, %clk, %rst, %false : i1
+  %next = ltl.delay %ack, 1, 0 : i1
+  %property = ltl.implication %req, %next : i1, !ltl.sequence
+  verif.assert %property : !ltl.property
+  hw.output
+}
+
+hw.module @slowHandshakeWindow(%clk: i1, %rst: i1, %req: i1) -> () {
+  %false = hw.constant false
+  %pending = seq.compreg %req, %clk, %rst, %false : i1
+  %ack = seq.compreg %pending, %clk, %rst, %false : i1
+  %window = ltl.delay %ack, 1, 1 : i1
+  %property = ltl.implication %req, %window : i1, !ltl.sequence
+  %clocked = ltl.clock %property, posedge %clk : !ltl.property
+  %disabled = ltl.disable %clocked if %rst : !ltl.property
+  verif.assert %disabled : !ltl.property
+  hw.output
+}
+
+hw.module @unbounded(%clk: i1, %req: i1) -> () {
+  %eventually = ltl.delay %req, 1 : i1
+  verif.assert %eventually : !ltl.sequence
+  hw.output
+}
@@ -0,0 +1,41 @@
+// These tests will be only enabled if circt-lec is built.
+// REQUIRES: circt-lec
+
+hw.module @twoOutputs(%a: i4, %b: i4) -> (x: i4, y: i4) {
+  %0 = comb.add bin %a, %b : i4
+  %1 = comb.xor bin %a, %b : i4
+  hw.output %0, %1 : i4, i4
+}
+
+// A mismatch of any one output is found.
+//  RUN: circt-lec %s -c1=twoOutputs -c2=secondDiffers -v=false | FileCheck %s --check-prefix=MISMATCH
+//  MISMATCH: c1 != c2
+//  RUN: circt-lec %s -c1=twoOutputs -c2=secondDiffers -parallel -v=false | FileCheck %s --check-prefix=MISMATCH
+
+hw.module @secondDiffers(%a: i4, %b: i4) -> (x: i4, y: i4) {
+  %0 = comb.add bin %b, %a : i4
+  %1 = comb.or bin %a, %b : i4
+  hw.output %0, %1 : i4, i4
+}
+
+// The first outputs are equal by structure, the second ones are left to the
+// solver.
+//  RUN: circt-lec %s -c1=twoOutputs -c2=decomposedXor -v=false -s | FileCheck %s --check-prefix=EQUIVALENT
+//  EQUIVALENT: c1 == c2
+//  EQUIVALENT: structurally equal outputs : 1
+//  RUN: circt-lec %s -c1=twoOutputs -c2=decomposedXor -parallel -v=false | FileCheck %s --check-prefix=PARALLEL
+//  PARALLEL: c1 == c2
+
+hw.module @decomposedXor(%a: i4, %b: i4) -> (x: i4, y: i4) {
+  %0 = comb.add bin %b, %a : i4
+  %or = comb.or bin %a, %b : i4
+  %and = comb.and bin %a, %b : i4
+  %ones = hw.constant -1 : i4
+  %nand = comb.xor bin %and, %ones : i4
+  %1 = comb.and bin %or, %nand : i4
+  hw.output %0, %1 : i4, i4
+}
+
+// The bit-blasting backend reaches the same conclusions.
+//  RUN: circt-lec %s -c1=twoOutputs -c2=secondDiffers -backend=sat -v=false | FileCheck %s --check-prefix=MISMATCH
+//  RUN: circt-lec %s -c1=twoOutputs -c2=decomposedXor -backend=sat -v=false | FileCheck %s --check-prefix=PARALLEL
@@ -0,0 +1,67 @@
+// These tests will be only enabled if circt-lec is built.
+// REQUIRES: circt-lec
+
+hw.module @counter(%clk: i1, %rst: i1, %en: i1) -> (count: i4) {
+  %zero = hw.constant 0 : i4
+  %one = hw.constant 1 : i4
+  %count = seq.compreg %next, %clk, %rst, %zero : i4
+  %inc = comb.add bin %count, %one : i4
+  %next = comb.mux bin %en, %inc, %count : i4
+  hw.output %count : i4
+}
+
+// Registers of the same name are matched, reducing the check to the next
+// states and the outputs.
+//  RUN: circt-lec %s -c1=counter -c2=counterDecrement -v=false | FileCheck %s --check-prefix=MATCHED
+//  MATCHED: c1 == c2
+
+hw.module @counterDecrement(%clk: i1, %rst: i1, %en: i1) -> (count: i4) {
+  %zero = hw.constant 0 : i4
+  %ones = hw.constant -1 : i4
+  %count = seq.compreg %next, %clk, %rst, %zero : i4
+  %sub = comb.sub bin %count, %ones : i4
+  %next = comb.mux bin %en, %sub, %count : i4
+  hw.output %count : i4
+}
+
+// A different reset value is found through the next state.
+//  RUN: circt-lec %s -c1=counter -c2=counterResetOne -v=false | FileCheck %s --check-prefix=RESET
+//  RESET: c1 != c2
+
+hw.module @counterResetOne(%clk: i1, %rst: i1, %en: i1) -> (count: i4) {
+  %one = hw.constant 1 : i4
+  %count = seq.compreg %next, %clk, %rst, %one : i4
+  %inc = comb.add bin %count, %one : i4
+  %next = comb.mux bin %en, %inc, %count : i4
+  hw.output %count : i4
+}
+
+// Registers without a counterpart need the circuits to be unrolled.
+//  RUN: not circt-lec %s -c1=counter -c2=counterRenamed -v=false 2>&1 | FileCheck %s --check-prefix=UNMATCHED
+//  UNMATCHED: circt-lec error: register `count` has no counterpart in the other circuit
+//  RUN: circt-lec %s -c1=counter -c2=counterRenamed -bound=4 -v=false | FileCheck %s --check-prefix=MATCHED
+
+hw.module @counterRenamed(%clk: i1, %rst: i1, %en: i1) -> (count: i4) {
+  %zero = hw.constant 0 : i4
+  %one = hw.constant 1 : i4
+  %value = seq.firreg %next clock %clk reset sync %rst, %zero : i4
+  %inc = comb.add bin %value, %one : i4
+  %next = comb.mux bin %en, %inc, %value : i4
+  hw.output %value : i4
+}
+
+// A counter which skips a value differs after a few cycles.
+//  RUN: circt-lec %s -c1=counter -c2=counterSkipping -bound=4 -v=false | FileCheck %s --check-prefix=UNROLLED
+//  UNROLLED: c1 != c2
+
+hw.module @counterSkipping(%clk: i1, %rst: i1, %en: i1) -> (count: i4) {
+  %zero = hw.constant 0 : i4
+  %one = hw.constant 1 : i4
+  %two = hw.constant 2 : i4
+  %value = seq.firreg %next clock %clk reset sync %rst, %zero : i4
+  %isOne = comb.icmp bin eq %value, %one : i4
+  %step = comb.mux bin %isOne, %two, %one : i4
+  %inc = comb.add bin %value, %step : i4
+  %next = comb.mux bin %en, %inc, %value : i4
+  hw.output %value : i4
+}
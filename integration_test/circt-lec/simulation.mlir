@@ -0,0 +1,95 @@
+// These tests will be only enabled if circt-lec is built.
+// REQUIRES: circt-lec
+
+hw.module @twoOutputs(%a: i4, %b: i4) -> (x: i4, y: i4) {
+  %0 = comb.add bin %a, %b : i4
+  %1 = comb.xor bin %a, %b : i4
+  hw.output %0, %1 : i4, i4
+}
+
+// Narrow inputs are simulated exhaustively, which finds the first mismatching
+// input vector.
+//  RUN: circt-lec %s -c1=twoOutputs -c2=secondDiffers -sim-vectors=100 -v=false | FileCheck %s --check-prefix=EXHAUSTIVE_MISMATCH
+//  EXHAUSTIVE_MISMATCH:      c1 != c2
+//  EXHAUSTIVE_MISMATCH-NEXT: Simulated inputs:
+//  EXHAUSTIVE_MISMATCH-NEXT:   a = 1
+//  EXHAUSTIVE_MISMATCH-NEXT:   b = 1
+//  EXHAUSTIVE_MISMATCH-NEXT: Mismatching outputs:
+//  EXHAUSTIVE_MISMATCH-NEXT:   y: 0 != 1
+
+hw.module @secondDiffers(%a: i4, %b: i4) -> (x: i4, y: i4) {
+  %0 = comb.add bin %b, %a : i4
+  %1 = comb.or bin %a, %b : i4
+  hw.output %0, %1 : i4, i4
+}
+
+// Covering all input vectors proves the circuits equivalent.
+//  RUN: circt-lec %s -c1=twoOutputs -c2=decomposedXor -sim-vectors=100 -v | FileCheck %s --check-prefix=EXHAUSTIVE
+//  EXHAUSTIVE:     Simulated 256 input vectors
+//  EXHAUSTIVE-NEXT: c1 == c2
+//  EXHAUSTIVE-NOT: Solving constraints
+
+hw.module @decomposedXor(%a: i4, %b: i4) -> (x: i4, y: i4) {
+  %0 = comb.add bin %b, %a : i4
+  %or = comb.or bin %a, %b : i4
+  %and = comb.and bin %a, %b : i4
+  %ones = hw.constant -1 : i4
+  %nand = comb.xor bin %and, %ones : i4
+  %1 = comb.and bin %or, %nand : i4
+  hw.output %0, %1 : i4, i4
+}
+
+// Wide inputs are simulated on random input vectors, before the logical engine
+// decides.
+//  RUN: circt-lec %s -c1=add -c2=or -sim-vectors=100 -v=false | FileCheck %s --check-prefix=RANDOM_MISMATCH
+//  RANDOM_MISMATCH:      c1 != c2
+//  RANDOM_MISMATCH-NEXT: Simulated inputs:
+//  RANDOM_MISMATCH:      Mismatching outputs:
+//  RANDOM_MISMATCH-NEXT:   out:
+//  RUN: circt-lec %s -c1=add -c2=commutedAdd -sim-vectors=100 -v | FileCheck %s --check-prefix=RANDOM
+//  RANDOM:      Simulated 102 input vectors
+//  RANDOM-NEXT: Analyzing the first circuit
+//  RANDOM:      c1 == c2
+
+hw.module @add(%a: i32, %b: i32) -> (out: i32) {
+  %0 = comb.add bin %a, %b : i32
+  hw.output %0 : i32
+}
+
+hw.module @or(%a: i32, %b: i32) -> (out: i32) {
+  %0 = comb.or bin %a, %b : i32
+  hw.output %0 : i32
+}
+
+hw.module @commutedAdd(%a: i32, %b: i32) -> (out: i32) {
+  %0 = comb.add bin %b, %a : i32
+  hw.output %0 : i32
+}
+
+// Shifting all bits out yields zero, as it does for the logical engine.
+//  RUN: circt-lec %s -c1=shl -c2=boundedShl -sim-vectors=100 -v=false | FileCheck %s --check-prefix=SHIFT
+//  SHIFT: c1 == c2
+
+hw.module @shl(%a: i8, %b: i8) -> (out: i8) {
+  %0 = comb.shl bin %a, %b : i8
+  hw.output %0 : i8
+}
+
+hw.module @boundedShl(%a: i8, %b: i8) -> (out: i8) {
+  %c8_i8 = hw.constant 8 : i8
+  %c0_i8 = hw.constant 0 : i8
+  %0 = comb.icmp bin ult %b, %c8_i8 : i8
+  %1 = comb.shl bin %a, %b : i8
+  %2 = comb.mux bin %0, %1, %c0_i8 : i8
+  hw.output %2 : i8
+}
+
+// Divisions are left to the logical engine.
+//  RUN: circt-lec %s -c1=div -c2=div -sim-vectors=100 -v | FileCheck %s --check-prefix=UNSUPPORTED
+//  UNSUPPORTED: Circuits not supported by the simulation
+//  UNSUPPORTED: c1 == c2
+
+hw.module @div(%a: i8, %b: i8) -> (out: i8) {
+  %0 = comb.divu bin %a, %b : i8
+  hw.output %0 : i8
+}
@@ -1,5 +1,6 @@
 // REQUIRES: verilator
 // RUN: circt-rtl-sim.py --cycles 2 %s | FileCheck %s
+// RUN: circt-rtl-sim.py --cycles 2 --threads 2 --objdir threads %s | FileCheck %s --check-prefixes=CHECK,THREADS
 
 module top(
   input clk,
@@ -11,5 +12,6 @@ module top(
       $display("tock");
   // CHECK:      tock
   // CHECK-NEXT: tock
+  // THREADS:    [driver] Simulated 2 cycles in {{.*}} cycles/s
 
 endmodule
@@ -0,0 +1,19 @@
+// RUN: handshake-runner %s | FileCheck %s
+// RUN: handshake-runner --typed-core %s | FileCheck %s
+// CHECK: 3
+
+// Both constants reach the control merge at once. It must forward them one at
+// a time, in the order of its operands, and hold back the second token until
+// both of its results have been consumed. The index steers each token to one
+// operand of the addition.
+
+handshake.func @main(%ctrl: none) -> (i64, none) {
+  %ctrlF:3 = fork [3] %ctrl : none
+  %c1 = constant %ctrlF#0 {value = 1 : i64} : i64
+  %c2 = constant %ctrlF#1 {value = 2 : i64} : i64
+  %d, %idx = control_merge %c1, %c2 : i64, index
+  %sel = arith.index_cast %idx : index to i1
+  %t, %f = cond_br %sel, %d : i64
+  %sum = arith.addi %t, %f : i64
+  return %sum, %ctrlF#2 : i64, none
+}
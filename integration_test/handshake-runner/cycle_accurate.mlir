@@ -0,0 +1,27 @@
+// RUN: circt-opt -lower-std-to-handshake -handshake-materialize-forks-sinks %s \
+// RUN: | circt-opt --handshake-insert-buffers="strategy=all" \
+// RUN: | handshake-runner --cycle-accurate 2> %t.report | FileCheck %s
+// RUN: FileCheck %s --input-file=%t.report --check-prefix=REPORT
+// CHECK: 42
+
+// REPORT:      Cycles: {{[0-9]+}}
+// REPORT:      Channels:
+// REPORT:      tokens={{[0-9]+}} stalls={{[0-9]+}} ii={{[0-9]+\.[0-9]+}}
+// REPORT:      Buffers:
+// REPORT-NEXT: slots={{[0-9]+}} occupancy={{[0-9]+\.[0-9]+}} max-occupancy={{[0-9]+}}
+module {
+  func.func @main() -> index {
+    %c1 = arith.constant 1 : index
+    %c42 = arith.constant 42 : index
+    %c1_0 = arith.constant 1 : index
+    cf.br ^bb1(%c1 : index)
+  ^bb1(%0: index):	// 2 preds: ^bb0, ^bb2
+    %1 = arith.cmpi slt, %0, %c42 : index
+    cf.cond_br %1, ^bb2, ^bb3
+  ^bb2:	// pred: ^bb1
+    %2 = arith.addi %0, %c1_0 : index
+    cf.br ^bb1(%2 : index)
+  ^bb3:	// pred: ^bb1
+    return %0 : index
+  }
+}
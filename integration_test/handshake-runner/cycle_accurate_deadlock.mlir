@@ -0,0 +1,17 @@
+// RUN: not handshake-runner --cycle-accurate %s 2>&1 | FileCheck %s
+
+// The merge in front of the return never receives a token. It must not count
+// as firing, such that the simulation reports the deadlock instead of running
+// forever.
+
+// CHECK: error: simulation deadlocked in cycle 1
+
+handshake.func @main(%ctrl: none) -> (i64, none) {
+  %ctrlF:3 = fork [3] %ctrl : none
+  %c0 = constant %ctrlF#0 {value = 0 : i1} : i1
+  %c1 = constant %ctrlF#1 {value = 1 : i64} : i64
+  %t, %f = cond_br %c0, %c1 : i64
+  sink %f : i64
+  %m = merge %t : i64
+  return %m, %ctrlF#2 : i64, none
+}
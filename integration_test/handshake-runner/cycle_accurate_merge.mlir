@@ -0,0 +1,36 @@
+// RUN: handshake-runner --cycle-accurate %s 2> %t.report | FileCheck %s
+// RUN: FileCheck %s --input-file=%t.report --check-prefix=REPORT
+// RUN: handshake-runner %s | FileCheck %s
+// CHECK: 2
+
+// Both constants are available to the merge in the first cycle, but the buffer
+// behind it accepts only one token per cycle. The merge must hold back the
+// second token until the first has been consumed instead of overwriting it, so
+// both tokens pass through the merge and the buffer. The default executer
+// must likewise forward the tokens one at a time.
+
+// REPORT:      Channels:
+// REPORT-NEXT: tokens=1
+// REPORT-NEXT: tokens=1
+// REPORT-NEXT: tokens=1
+// REPORT-NEXT: tokens=1
+// REPORT-NEXT: tokens=1
+// REPORT-NEXT: tokens=1
+// REPORT-NEXT: tokens=2
+// REPORT-NEXT: tokens=2
+// REPORT:      Buffers:
+// REPORT-NEXT: slots=1 {{.*}} max-occupancy=1
+
+handshake.func @main(%ctrl: none) -> (i64, none) {
+  %ctrlF:3 = fork [3] %ctrl : none
+  %c1 = constant %ctrlF#0 {value = 1 : i64} : i64
+  %c2 = constant %ctrlF#1 {value = 2 : i64} : i64
+  %m = merge %c1, %c2 : i64
+  %b = buffer [1] seq %m : i64
+  %bF:3 = fork [3] %b : i64
+  %k = constant %bF#0 {value = 2 : i64} : i64
+  %last = arith.cmpi eq, %bF#1, %k : i64
+  %t, %f = cond_br %last, %bF#2 : i64
+  sink %f : i64
+  return %t, %ctrlF#2 : i64, none
+}
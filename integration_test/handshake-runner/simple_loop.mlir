@@ -1,5 +1,6 @@
 // RUN: circt-opt -lower-std-to-handshake -handshake-materialize-forks-sinks %s | handshake-runner | FileCheck %s
 // RUN: handshake-runner %s | FileCheck %s
+// RUN: circt-opt -lower-std-to-handshake -handshake-materialize-forks-sinks %s | handshake-runner --typed-core | FileCheck %s
 // CHECK: 42
 module {
   func.func @main() -> index {
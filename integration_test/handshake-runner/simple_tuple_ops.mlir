@@ -1,5 +1,7 @@
 // RUN: handshake-runner %s "(64, 32, 64)" | FileCheck %s
+// RUN: not handshake-runner --typed-core %s "(64, 32, 64)" 2>&1 | FileCheck %s --check-prefix=TYPED
 // CHECK: (128, 32)
+// TYPED: error: 'handshake.func' op has an argument of type 'tuple<i64, i32, i64>' which the typed core does not support
 
 module {
   handshake.func @main(%arg0: tuple<i64, i32, i64>, %ctrl: none, ...) -> (tuple<i64, i32>, none) {
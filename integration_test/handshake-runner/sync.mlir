@@ -1,4 +1,5 @@
 // RUN: handshake-runner %s | FileCheck %s
+// RUN: handshake-runner --typed-core %s | FileCheck %s
 // CHECK: 0 42
 
 handshake.func @main(%ctrl: none) -> (i64, i64, none) {
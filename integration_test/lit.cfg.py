@@ -190,6 +190,14 @@ if config.clang_tidy_path != "":
   tools.append('clang-tidy')
   config.available_features.add('clang-tidy')
 
+# Enable the arcilator tests that compile a model into a C++ driver if there is
+# a host compiler.
+if config.host_cxx != "":
+  tools.append('arcilator')
+  config.available_features.add('host-cxx')
+  config.substitutions.append(('%host_cxx', config.host_cxx))
+  config.substitutions.append(('%CIRCT_TOOLS%', config.circt_tools_dir))
+
 # Enable systemc if it has been detected.
 if config.have_systemc != "":
   config.available_features.add('systemc')
@@ -197,6 +205,7 @@ if config.have_systemc != "":
 # Enable circt-lec tests if it is built.
 if config.lec_enabled != "":
   config.available_features.add('circt-lec')
+  tools.append('circt-bmc')
   tools.append('circt-lec')
 
 llvm_config.add_tool_substitutions(tools, tool_dirs)
@@ -20,34 +20,79 @@
 #include "mlir/Dialect/Affine/LoopUtils.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/Threading.h"
+#include "llvm/ADT/MapVector.h"
 
 using namespace mlir;
 using namespace mlir::affine;
 using namespace circt::analysis;
 
-/// Helper to iterate through memory operation pairs and check for dependences
-/// at a given loop nesting depth.
-static void checkMemrefDependence(SmallVectorImpl<Operation *> &memoryOps,
+namespace {
+/// The access function of a memory operation: its access map, the operands of
+/// the map, and the affine operations enclosing it which make up its iteration
+/// domain. Memory operations accessing the same memref with equal access
+/// functions have the same dependences to other memory operations.
+struct AccessFunction {
+  AffineMap map;
+  SmallVector<Value> operands;
+  SmallVector<Operation *> enclosingOps;
+
+  bool operator==(const AccessFunction &other) const {
+    return map == other.map && operands == other.operands &&
+           enclosingOps == other.enclosingOps;
+  }
+};
+
+/// The result of a dependence check between two access functions.
+struct CachedDependence {
+  DependenceResult::ResultEnum value;
+  SmallVector<DependenceComponent, 2> depComps;
+};
+} // namespace
+
+/// Helper to iterate through the pairs of memory operations accessing the same
+/// memref and check for dependences at a given loop nesting depth. The
+/// dependences of these operations are added to their existing entries in
+/// `results`. `accessClasses` maps each operation to the index of its access
+/// function, such that the check is only run once for each pair of access
+/// functions. This only holds if the depth is within the common loops of the
+/// pair, since beyond them the result depends on the order of the operations.
+static void checkMemrefDependence(ArrayRef<Operation *> memoryOps,
+                                  ArrayRef<unsigned> accessClasses,
                                   unsigned depth,
                                   MemoryDependenceResult &results) {
-  for (auto *source : memoryOps) {
-    for (auto *destination : memoryOps) {
+  DenseMap<std::pair<unsigned, unsigned>, CachedDependence> cache;
+  for (auto [source, sourceClass] : llvm::zip(memoryOps, accessClasses)) {
+    for (auto [destination, destinationClass] :
+         llvm::zip(memoryOps, accessClasses)) {
       if (source == destination)
         continue;
 
-      // Initialize the dependence list for this destination.
-      if (results.count(destination) == 0)
-        results[destination] = SmallVector<MemoryDependence>();
+      auto &destinationDeps = results.find(destination)->second;
 
       // Look for inter-iteration dependences on the same memory location.
       MemRefAccess src(source);
       MemRefAccess dst(destination);
-      FlatAffineValueConstraints dependenceConstraints;
-      SmallVector<DependenceComponent, 2> depComps;
-      DependenceResult result = checkMemrefAccessDependence(
-          src, dst, depth, &dependenceConstraints, &depComps, true);
-
-      results[destination].emplace_back(source, result.value, depComps);
+      auto checkDependence = [&](CachedDependence &dependence) {
+        FlatAffineValueConstraints dependenceConstraints;
+        DependenceResult result = checkMemrefAccessDependence(
+            src, dst, depth, &dependenceConstraints, &dependence.depComps,
+            true);
+        dependence.value = result.value;
+      };
+      if (depth > getNumCommonSurroundingLoops(*source, *destination)) {
+        CachedDependence dependence;
+        checkDependence(dependence);
+        destinationDeps.emplace_back(source, dependence.value,
+                                     dependence.depComps);
+      } else {
+        auto [it, inserted] =
+            cache.try_emplace({sourceClass, destinationClass});
+        if (inserted)
+          checkDependence(it->second);
+        destinationDeps.emplace_back(source, it->second.value,
+                                     it->second.depComps);
+      }
 
       // Also consider intra-iteration dependences on the same memory location.
       // This currently does not consider aliasing.
@@ -113,7 +158,7 @@ static void checkMemrefDependence(SmallVectorImpl<Operation *> &memoryOps,
             intraDeps.push_back(depComp);
           }
 
-          results[destination].emplace_back(
+          destinationDeps.emplace_back(
               source, DependenceResult::HasDependence, intraDeps);
         }
       }
@@ -132,16 +177,45 @@ circt::analysis::MemoryDependenceAnalysis::MemoryDependenceAnalysis(
   std::vector<SmallVector<AffineForOp, 2>> depthToLoops;
   mlir::affine::gatherLoops(funcOp, depthToLoops);
 
-  // Collect load and store operations to check.
-  SmallVector<Operation *> memoryOps;
+  // Collect load and store operations to check, grouped by the memref they
+  // access, since there are no dependences between accesses to different
+  // memrefs. Also identify the operations with equal access functions within
+  // each group.
+  llvm::MapVector<Value, SmallVector<Operation *>> memoryOps;
+  DenseMap<Value, SmallVector<unsigned>> accessClasses;
+  DenseMap<Value, SmallVector<AccessFunction>> accessFunctions;
   funcOp.walk([&](Operation *op) {
-    if (isa<AffineReadOpInterface, AffineWriteOpInterface>(op))
-      memoryOps.push_back(op);
+    if (!isa<AffineReadOpInterface, AffineWriteOpInterface>(op))
+      return;
+    results[op] = SmallVector<MemoryDependence>();
+
+    MemRefAccess access(op);
+    AffineValueMap accessMap;
+    access.getAccessMap(&accessMap);
+    AccessFunction function;
+    function.map = accessMap.getAffineMap();
+    function.operands.append(accessMap.getOperands().begin(),
+                             accessMap.getOperands().end());
+    getEnclosingAffineOps(*op, &function.enclosingOps);
+
+    auto &functions = accessFunctions[access.memref];
+    unsigned accessClass = llvm::find(functions, function) - functions.begin();
+    if (accessClass == functions.size())
+      functions.push_back(std::move(function));
+    memoryOps[access.memref].push_back(op);
+    accessClasses[access.memref].push_back(accessClass);
   });
 
-  // For each depth, check memref accesses.
-  for (unsigned depth = 1, e = depthToLoops.size(); depth <= e; ++depth)
-    checkMemrefDependence(memoryOps, depth, results);
+  // For each memref and each depth, check memref accesses. The groups are
+  // independent and only add to the existing results of their operations, so
+  // they are checked in parallel.
+  unsigned numDepths = depthToLoops.size();
+  mlir::parallelForEach(
+      funcOp.getContext(), memoryOps, [&](auto &memrefAndOps) {
+        auto &classes = accessClasses.find(memrefAndOps.first)->second;
+        for (unsigned depth = 1; depth <= numDepths; ++depth)
+          checkMemrefDependence(memrefAndOps.second, classes, depth, results);
+      });
 }
 
 /// Returns the dependences, if any, that the given Operation depends on.
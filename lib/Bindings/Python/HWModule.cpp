@@ -31,6 +31,59 @@ void circt::python::populateDialectHWSubmodule(py::module &m) {
 
   m.def("get_bitwidth", &hwGetBitWidth);
 
+  m.def(
+      "build_operations",
+      [](MlirOperation parent, std::optional<MlirOperation> before,
+         MlirLocation loc, std::vector<MlirValue> inputs, py::list pyOps) {
+        // Copy the descriptions into storage which outlives the call. Each
+        // description is a (name, [(op, result)], [type], {name: attr})
+        // tuple.
+        size_t numOps = pyOps.size();
+        std::vector<std::string> names(numOps);
+        std::vector<std::vector<HWBulkValueRef>> operands(numOps);
+        std::vector<std::vector<MlirType>> resultTypes(numOps);
+        std::vector<std::vector<MlirNamedAttribute>> attributes(numOps);
+        std::vector<HWBulkOperation> ops(numOps);
+        MlirContext ctx = mlirLocationGetContext(loc);
+        for (size_t i = 0; i < numOps; ++i) {
+          auto desc = pyOps[i].cast<py::tuple>();
+          names[i] = desc[0].cast<std::string>();
+          for (auto ref : desc[1].cast<py::list>()) {
+            auto pair = ref.cast<std::pair<intptr_t, intptr_t>>();
+            operands[i].push_back(HWBulkValueRef{pair.first, pair.second});
+          }
+          resultTypes[i] = desc[2].cast<std::vector<MlirType>>();
+          for (auto [attrName, attr] : desc[3].cast<py::dict>()) {
+            auto nameStr = attrName.cast<std::string>();
+            attributes[i].push_back(mlirNamedAttributeGet(
+                mlirIdentifierGet(ctx, mlirStringRefCreate(nameStr.data(),
+                                                           nameStr.size())),
+                attr.cast<MlirAttribute>()));
+          }
+          ops[i] = HWBulkOperation{
+              mlirStringRefCreate(names[i].data(), names[i].size()),
+              static_cast<intptr_t>(operands[i].size()),
+              operands[i].data(),
+              static_cast<intptr_t>(resultTypes[i].size()),
+              resultTypes[i].data(),
+              static_cast<intptr_t>(attributes[i].size()),
+              attributes[i].data()};
+        }
+
+        MlirBlock block =
+            mlirRegionGetFirstBlock(mlirOperationGetRegion(parent, 0));
+        std::vector<MlirOperation> created(numOps);
+        if (!hwBuildOperations(block, before.value_or(MlirOperation{nullptr}),
+                               loc, inputs.size(), inputs.data(), numOps,
+                               ops.data(), created.data()))
+          throw py::value_error("Invalid operation description");
+        return created;
+      },
+      "Create operations in bulk at the end of the first block of `parent` "
+      "or before `before`.",
+      py::arg("parent"), py::arg("before"), py::arg("loc"), py::arg("inputs"),
+      py::arg("ops"));
+
   mlir_type_subclass(m, "InOutType", hwTypeIsAInOut)
       .def_classmethod("get",
                        [](py::object cls, MlirType innerType) {
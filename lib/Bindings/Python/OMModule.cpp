@@ -48,6 +48,19 @@ struct Object {
     return omEvaluatorObjectValueGetPrimitive(result);
   }
 
+  // Serialize the Object and everything it refers to as a JSON string.
+  std::string toJSON() {
+    std::string json;
+    auto append = [](MlirStringRef str, void *userData) {
+      static_cast<std::string *>(userData)->append(str.data, str.length);
+    };
+    if (mlirLogicalResultIsFailure(
+            omEvaluatorObjectSerializeJSON(object, append, &json)))
+      throw py::value_error(
+          "unable to serialize object, see previous error(s)");
+    return json;
+  }
+
 private:
   // The underlying CAPI OMObject.
   OMObject object;
@@ -100,6 +113,8 @@ void circt::python::populateDialectOMSubmodule(py::module &m) {
   py::class_<Object>(m, "Object")
       .def("get_field", &Object::getField, "Get a field from an Object",
            py::arg("name"))
+      .def("to_json", &Object::toJSON,
+           "Serialize the Object and everything it refers to as JSON")
       .def_property_readonly("type", &Object::getType,
                              "The Type of the Object");
 
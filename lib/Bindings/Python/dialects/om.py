@@ -81,6 +81,21 @@ class Evaluator(BaseEvaluator):
     # Instantiate a Python object of the requested class.
     return cls(**object_fields)
 
+  def instantiate_json(self, class_name: str, *args: Any) -> str:
+    """Instantiate an Object with a class name and actual parameters, and
+    serialize it and everything it refers to as JSON."""
+
+    # Convert the class name and actual parameters to Attributes within the
+    # Evaluator's context.
+    with self.module.context:
+      actual_params = var_to_attribute(list(args))
+      class_name = StringAttr.get(class_name)
+
+    # Call the base instantiate method, and let the native serializer walk the
+    # Object instead of visiting each field from Python.
+    obj = super().instantiate(class_name, actual_params)
+    return obj.to_json()
+
   def _handle_diagnostic(self, diagnostic: Diagnostic) -> bool:
     """Handle MLIR Diagnostics by logging them."""
 
@@ -68,6 +68,12 @@ def var_to_attribute(obj, none_on_fail: bool = False) -> ir.Attribute:
     if all(arr):
       return ir.ArrayAttr.get(arr)
     return None
+  # Objects implementing the buffer protocol, e.g. numpy arrays, are copied
+  # into a dense elements attribute in one go instead of element by element.
+  try:
+    return ir.DenseElementsAttr.get(memoryview(obj))
+  except (TypeError, ValueError):
+    pass
   if none_on_fail:
     return None
   raise TypeError(f"Cannot convert type '{type(obj)}' to MLIR attribute")
@@ -154,6 +160,14 @@ def attribute_to_var(attr):
     return ir.TypeAttr(attr).value
   except ValueError:
     pass
+  # Dense elements are exposed through the buffer protocol, which views the
+  # storage of the attribute instead of converting each element. Wrap the view
+  # with `numpy.asarray` to get a numpy array without copying.
+  for dense_attr in (ir.DenseIntElementsAttr, ir.DenseFPElementsAttr):
+    try:
+      return memoryview(dense_attr(attr))
+    except ValueError:
+      pass
   try:
     arr = ir.ArrayAttr(attr)
     return [attribute_to_var(x) for x in arr]
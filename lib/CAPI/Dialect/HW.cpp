@@ -220,3 +220,65 @@ MLIR_CAPI_EXPORTED MlirAttribute hwParamVerbatimAttrGet(MlirAttribute text) {
   auto type = NoneType::get(ctx);
   return wrap(ParamVerbatimAttr::get(ctx, textAttr, type));
 }
+
+//===----------------------------------------------------------------------===//
+// Bulk construction API.
+//===----------------------------------------------------------------------===//
+
+bool hwBuildOperations(MlirBlock block, MlirOperation before, MlirLocation loc,
+                       intptr_t numInputs, MlirValue const *inputs,
+                       intptr_t numOps, HWBulkOperation const *ops,
+                       MlirOperation *createdOps) {
+  Location location = unwrap(loc);
+  MLIRContext *ctx = location.getContext();
+  OpBuilder builder = mlirOperationIsNull(before)
+                          ? OpBuilder::atBlockEnd(unwrap(block))
+                          : OpBuilder(unwrap(before));
+
+  SmallVector<Operation *> created;
+  created.reserve(numOps);
+  auto lookup = [&](HWBulkValueRef ref) -> Value {
+    if (ref.result < 0)
+      return {};
+    if (ref.op < 0)
+      return ref.result < numInputs ? unwrap(inputs[ref.result]) : Value();
+    if (ref.op >= static_cast<intptr_t>(created.size()))
+      return {};
+    Operation *op = created[ref.op];
+    if (ref.result >= static_cast<intptr_t>(op->getNumResults()))
+      return {};
+    return op->getResult(ref.result);
+  };
+
+  // Users are always created after their operands, so erasing in reverse
+  // order never leaves dangling uses.
+  auto fail = [&]() {
+    for (Operation *op : llvm::reverse(created))
+      op->erase();
+    return false;
+  };
+
+  for (intptr_t i = 0; i < numOps; ++i) {
+    const HWBulkOperation &desc = ops[i];
+    auto name = RegisteredOperationName::lookup(unwrap(desc.name), ctx);
+    if (!name)
+      return fail();
+    OperationState state(location, *name);
+    for (intptr_t j = 0; j < desc.numOperands; ++j) {
+      Value operand = lookup(desc.operands[j]);
+      if (!operand)
+        return fail();
+      state.operands.push_back(operand);
+    }
+    for (intptr_t j = 0; j < desc.numResults; ++j)
+      state.types.push_back(unwrap(desc.resultTypes[j]));
+    for (intptr_t j = 0; j < desc.numAttributes; ++j)
+      state.addAttribute(unwrap(desc.attributes[j].name),
+                         unwrap(desc.attributes[j].attribute));
+    created.push_back(builder.create(state));
+  }
+
+  for (auto [i, op] : llvm::enumerate(created))
+    createdOps[i] = wrap(op);
+  return true;
+}
@@ -5,10 +5,14 @@
 #include "circt-c/Dialect/HWArith.h"
 #include "circt/Conversion/Passes.h"
 #include "circt/Dialect/HWArith/HWArithDialect.h"
+#include "circt/Dialect/HWArith/HWArithPasses.h"
 #include "mlir/CAPI/IR.h"
 #include "mlir/CAPI/Registration.h"
 #include "mlir/CAPI/Support.h"
 
-void registerHWArithPasses() { circt::registerHWArithToHWPass(); }
+void registerHWArithPasses() {
+  circt::registerHWArithToHWPass();
+  circt::hwarith::registerPasses();
+}
 MLIR_DEFINE_CAPI_DIALECT_REGISTRATION(HWArith, hwarith,
                                       circt::hwarith::HWArithDialect)
@@ -14,6 +14,8 @@
 #include "circt/Dialect/OM/Evaluator/Evaluator.h"
 #include "circt/Dialect/OM/OMDialect.h"
 #include "mlir/CAPI/Registration.h"
+#include "mlir/CAPI/Support.h"
+#include "mlir/CAPI/Utils.h"
 #include "mlir/CAPI/Wrap.h"
 
 using namespace mlir;
@@ -37,7 +39,7 @@ bool omTypeIsAClassType(MlirType type) { return unwrap(type).isa<ClassType>(); }
 //===----------------------------------------------------------------------===//
 
 DEFINE_C_API_PTR_METHODS(OMEvaluator, circt::om::Evaluator)
-DEFINE_C_API_PTR_METHODS(OMObject, std::shared_ptr<circt::om::Object>)
+DEFINE_C_API_PTR_METHODS(OMObject, circt::om::Object)
 
 //===----------------------------------------------------------------------===//
 // Evaluator API.
@@ -66,7 +68,7 @@ OMObject omEvaluatorInstantiate(OMEvaluator evaluator, MlirAttribute className,
       unwrapList(nActualParams, actualParams, actualParamsTmp));
 
   // Invoke the Evaluator to instantiate the Object.
-  FailureOr<std::shared_ptr<Object>> result =
+  FailureOr<Object *> result =
       cppEvaluator->instantiate(cppClassName, cppActualParams);
 
   // If instantiation failed, return a null Object. A Diagnostic will be emitted
@@ -74,9 +76,8 @@ OMObject omEvaluatorInstantiate(OMEvaluator evaluator, MlirAttribute className,
   if (failed(result))
     return OMObject();
 
-  // Wrap and return a *new* shared pointer to the Object, to ensure the
-  // reference count is kept up to date.
-  return wrap(new std::shared_ptr<Object>(result.value()));
+  // Wrap and return the Object, which is owned by the Evaluator.
+  return wrap(result.value());
 }
 
 /// Get the Module the Evaluator is built from.
@@ -91,13 +92,13 @@ MlirModule omEvaluatorGetModule(OMEvaluator evaluator) {
 
 /// Query if the Object is null.
 bool omEvaluatorObjectIsNull(OMObject object) {
-  // Just check if the Object shared pointer is null.
+  // Just check if the Object pointer is null.
   return !object.ptr;
 }
 
 /// Get the Type from an Object, which will be a ClassType.
 MlirType omEvaluatorObjectGetType(OMObject object) {
-  return wrap((*unwrap(object))->getType());
+  return wrap(unwrap(object)->getType());
 }
 
 /// Get a field from an Object, which must contain a field of that name.
@@ -105,7 +106,7 @@ OMObjectValue omEvaluatorObjectGetField(OMObject object, MlirAttribute name) {
   // Unwrap the Object and get the field of the name, which the client must
   // supply as a StringAttr.
   FailureOr<ObjectValue> result =
-      (*unwrap(object))->getField(unwrap(name).cast<StringAttr>());
+      unwrap(object)->getField(unwrap(name).cast<StringAttr>());
 
   // If getField failed, return a null ObjectValue. A Diagnostic will be emitted
   // in this case.
@@ -113,8 +114,8 @@ OMObjectValue omEvaluatorObjectGetField(OMObject object, MlirAttribute name) {
     return OMObjectValue();
 
   // If the field is an Object, return an ObjectValue with the Object set.
-  if (auto *object = std::get_if<std::shared_ptr<Object>>(&result.value()))
-    return OMObjectValue{MlirAttribute(), wrap(object)};
+  if (auto *object = std::get_if<Object *>(&result.value()))
+    return OMObjectValue{MlirAttribute(), wrap(*object)};
 
   // If the field is an Attribute, return an ObjectValue with the Primitive set.
   if (auto *primitive = std::get_if<Attribute>(&result.value()))
@@ -125,6 +126,19 @@ OMObjectValue omEvaluatorObjectGetField(OMObject object, MlirAttribute name) {
   return OMObjectValue();
 }
 
+/// Serialize an Object and everything it refers to as JSON.
+MlirLogicalResult omEvaluatorObjectSerializeJSON(OMObject object,
+                                                 MlirStringCallback callback,
+                                                 void *userData) {
+  // Buffer the output, so the callback is not invoked for every token.
+  detail::CallbackOstream stream(callback, userData);
+  stream.SetBuffered();
+  llvm::json::OStream json(stream);
+  LogicalResult result = serializeJSON(unwrap(object), json);
+  stream.flush();
+  return wrap(result);
+}
+
 //===----------------------------------------------------------------------===//
 // ObjectValue API.
 //===----------------------------------------------------------------------===//
@@ -11,6 +11,8 @@
 #include "circt/Analysis/DependenceAnalysis.h"
 #include "circt/Analysis/SchedulingAnalysis.h"
 #include "circt/Dialect/LoopSchedule/LoopScheduleOps.h"
+#include "circt/Dialect/SSP/SSPDialect.h"
+#include "circt/Dialect/SSP/Utilities.h"
 #include "circt/Scheduling/Algorithms.h"
 #include "circt/Scheduling/Problems.h"
 #include "mlir/Conversion/AffineToStandard/AffineToStandard.h"
@@ -33,6 +35,8 @@
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/TypeSwitch.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/ToolOutputFile.h"
 #include <cassert>
 #include <limits>
 
@@ -61,6 +65,7 @@ private:
   lowerAffineStructures(MemoryDependenceAnalysis &dependenceAnalysis);
   LogicalResult populateOperatorTypes(SmallVectorImpl<AffineForOp> &loopNest,
                                       ModuloProblem &problem);
+  LogicalResult dumpSchedulingProblem(ModuloProblem &problem);
   LogicalResult solveSchedulingProblem(SmallVectorImpl<AffineForOp> &loopNest,
                                        ModuloProblem &problem);
   LogicalResult
@@ -68,6 +73,10 @@ private:
                              ModuloProblem &problem);
 
   CyclicSchedulingAnalysis *schedulingAnalysis;
+
+  /// The number of problems written to the `problemDumpDir` for the current
+  /// function, used to give each of them a unique name.
+  unsigned numDumpedProblems = 0;
 };
 
 } // namespace
@@ -101,7 +110,97 @@ ModuloProblem AffineToLoopSchedule::getModuloProblem(CyclicProblem &prob) {
   return modProb;
 }
 
+/// Cyclically partition the innermost dimension of the memory allocated by
+/// `alloc` into `numBanks` memories. This is only done if the bank of every
+/// access is known statically, i.e. the innermost index of every access is
+/// congruent to a constant modulo `numBanks`. Each bank then gets its own
+/// operator type in the scheduling problem and its own memory in the lowered
+/// design, such that accesses to different banks may happen in the same cycle.
+template <typename TAllocOp>
+static void partitionMemory(TAllocOp alloc, unsigned numBanks) {
+  MemRefType type = alloc.getType();
+  if (!type.hasStaticShape() || !type.getLayout().isIdentity() ||
+      type.getRank() == 0 || type.getShape().back() % numBanks != 0)
+    return;
+
+  // Compute the bank and the access map into the bank for every access.
+  struct BankAccess {
+    Operation *op;
+    unsigned bank;
+    AffineMap map;
+  };
+  SmallVector<BankAccess> accesses;
+  for (auto *user : alloc->getUsers()) {
+    AffineMap map;
+    if (auto load = dyn_cast<AffineLoadOp>(user))
+      map = load.getAffineMap();
+    else if (auto store = dyn_cast<AffineStoreOp>(user);
+             store && store.getMemRef() == alloc)
+      map = store.getAffineMap();
+    else
+      return;
+
+    AffineExpr index = map.getResults().back();
+    auto bank = simplifyAffineExpr(index % numBanks, map.getNumDims(),
+                                   map.getNumSymbols())
+                    .dyn_cast<AffineConstantExpr>();
+    if (!bank)
+      return;
+
+    SmallVector<AffineExpr> results(map.getResults());
+    results.back() = simplifyAffineExpr(index.floorDiv(numBanks),
+                                        map.getNumDims(), map.getNumSymbols());
+    accesses.push_back({user, static_cast<unsigned>(bank.getValue()),
+                        AffineMap::get(map.getNumDims(), map.getNumSymbols(),
+                                       results, alloc.getContext())});
+  }
+
+  // Create the banks.
+  SmallVector<int64_t> bankShape(type.getShape());
+  bankShape.back() /= numBanks;
+  auto bankType = MemRefType::get(bankShape, type.getElementType(),
+                                  MemRefLayoutAttrInterface(),
+                                  type.getMemorySpace());
+  OpBuilder builder(alloc);
+  SmallVector<Value> banks;
+  for (unsigned i = 0; i < numBanks; ++i)
+    banks.push_back(builder.create<TAllocOp>(alloc.getLoc(), bankType));
+
+  // Redirect the accesses to the banks.
+  for (auto &access : accesses) {
+    builder.setInsertionPoint(access.op);
+    Value bank = banks[access.bank];
+    if (auto load = dyn_cast<AffineLoadOp>(access.op)) {
+      auto bankLoad = builder.create<AffineLoadOp>(
+          load.getLoc(), bank, access.map, load.getMapOperands());
+      load.replaceAllUsesWith(bankLoad.getResult());
+    } else {
+      auto store = cast<AffineStoreOp>(access.op);
+      builder.create<AffineStoreOp>(store.getLoc(), store.getValueToStore(),
+                                    bank, access.map, store.getMapOperands());
+    }
+    access.op->erase();
+  }
+  alloc.erase();
+}
+
 void AffineToLoopSchedule::runOnOperation() {
+  // Partition the memories allocated in the function, before any analysis
+  // looks at their accesses.
+  if (memoryBanks > 1) {
+    SmallVector<Operation *> allocs;
+    getOperation().walk([&](Operation *op) {
+      if (isa<AllocOp, AllocaOp>(op))
+        allocs.push_back(op);
+    });
+    for (auto *op : allocs) {
+      if (auto alloc = dyn_cast<AllocOp>(op))
+        partitionMemory(alloc, memoryBanks);
+      else
+        partitionMemory(cast<AllocaOp>(op), memoryBanks);
+    }
+  }
+
   // Get dependence analysis for the whole function.
   auto dependenceAnalysis = getAnalysis<MemoryDependenceAnalysis>();
 
@@ -111,6 +210,7 @@ void AffineToLoopSchedule::runOnOperation() {
 
   // Get scheduling analysis for the whole function.
   schedulingAnalysis = &getAnalysis<CyclicSchedulingAnalysis>();
+  numDumpedProblems = 0;
 
   // Collect perfectly nested loops and work on them.
   auto outerLoops = getOperation().getOps<AffineForOp>();
@@ -353,6 +453,31 @@ LogicalResult AffineToLoopSchedule::populateOperatorTypes(
   return success();
 }
 
+/// Write the scheduling problem to an SSP file in the `problemDumpDir`, named
+/// after the function and the index of the problem within it.
+LogicalResult
+AffineToLoopSchedule::dumpSchedulingProblem(ModuloProblem &problem) {
+  auto funcOp = getOperation();
+  std::string name =
+      (funcOp.getSymName() + "_" + Twine(numDumpedProblems++)).str();
+  SmallString<128> path(problemDumpDir);
+  llvm::sys::path::append(path, name + ".mlir");
+
+  std::error_code ec;
+  llvm::ToolOutputFile outputFile(path, ec, llvm::sys::fs::OF_None);
+  if (ec)
+    return funcOp.emitError("unable to open scheduling problem dump file: ")
+           << ec.message();
+
+  problem.setInstanceName(StringAttr::get(&getContext(), name));
+  OwningOpRef<ModuleOp> moduleOp = ModuleOp::create(funcOp.getLoc());
+  auto builder = OpBuilder::atBlockBegin(moduleOp->getBody());
+  ssp::saveProblem(problem, builder);
+  moduleOp->print(outputFile.os());
+  outputFile.keep();
+  return success();
+}
+
 /// Solve the pre-computed scheduling problem.
 LogicalResult AffineToLoopSchedule::solveSchedulingProblem(
     SmallVectorImpl<AffineForOp> &loopNest, ModuloProblem &problem) {
@@ -376,8 +501,12 @@ LogicalResult AffineToLoopSchedule::solveSchedulingProblem(
   if (failed(problem.check()))
     return failure();
 
+  // Optionally write the problem to a file before solving it.
+  if (!problemDumpDir.empty() && failed(dumpSchedulingProblem(problem)))
+    return failure();
+
   auto *anchor = forOp.getBody()->getTerminator();
-  if (failed(scheduleSimplex(problem, anchor)))
+  if (failed(scheduleSimplex(problem, anchor, numCandidateIIs)))
     return failure();
 
   // Verify the solution.
@@ -17,9 +17,12 @@
 #include "mlir/Conversion/ControlFlowToLLVM/ControlFlowToLLVM.h"
 #include "mlir/Conversion/FuncToLLVM/ConvertFuncToLLVM.h"
 #include "mlir/Conversion/LLVMCommon/ConversionTarget.h"
+#include "mlir/Conversion/LLVMCommon/Pattern.h"
 #include "mlir/Conversion/LLVMCommon/TypeConverter.h"
 #include "mlir/Conversion/SCFToControlFlow/SCFToControlFlow.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/LLVMIR/FunctionCallUtils.h"
 #include "mlir/Dialect/LLVMIR/LLVMAttrs.h"
 #include "mlir/Dialect/LLVMIR/LLVMDialect.h"
 #include "mlir/Dialect/SCF/IR/SCF.h"
@@ -34,6 +37,20 @@ using namespace circt;
 using namespace arc;
 using namespace hw;
 
+/// The attribute marking the loop that iterates over the instances of a model
+/// allocated side by side in its storage.
+static constexpr StringLiteral laneLoopAttrName = "arc.lane_loop";
+
+/// Return the number of bytes between the copies of a state or memory for two
+/// consecutive instances, or zero if the type is not replicated per instance.
+static unsigned getLaneStride(Type type) {
+  if (auto stateType = type.dyn_cast<StateType>())
+    return stateType.getStride();
+  if (auto memType = type.dyn_cast<MemoryType>())
+    return memType.getStorageSize();
+  return 0;
+}
+
 //===----------------------------------------------------------------------===//
 // Lowering Patterns
 //===----------------------------------------------------------------------===//
@@ -138,12 +155,41 @@ struct AllocStateLikeOpLowering : public OpConversionPattern<ConcreteOp> {
   }
 };
 
+/// Return the bit a single-bit state occupies within the byte it shares with
+/// other states, or std::nullopt if the state is not packed.
+static std::optional<uint32_t> getPackedBit(Value state) {
+  if (auto getOp = state.getDefiningOp<arc::StorageGetOp>())
+    return getOp.getBit();
+  return std::nullopt;
+}
+
+/// Return a pointer to the byte a packed single-bit state lives in.
+static Value getPackedByte(OpBuilder &builder, Location loc, Value state) {
+  return builder.create<LLVM::BitcastOp>(
+      loc, LLVM::LLVMPointerType::get(builder.getI8Type()), state);
+}
+
 struct StateReadOpLowering : public OpConversionPattern<arc::StateReadOp> {
   using OpConversionPattern::OpConversionPattern;
   LogicalResult
   matchAndRewrite(arc::StateReadOp op, OpAdaptor adaptor,
                   ConversionPatternRewriter &rewriter) const final {
-    rewriter.replaceOpWithNewOp<LLVM::LoadOp>(op, adaptor.getState());
+    auto bit = getPackedBit(op.getState());
+    if (!bit) {
+      rewriter.replaceOpWithNewOp<LLVM::LoadOp>(op, adaptor.getState());
+      return success();
+    }
+
+    // Extract the state's bit from the byte it is packed into.
+    auto loc = op.getLoc();
+    auto i8Type = rewriter.getI8Type();
+    Value byte = rewriter.create<LLVM::LoadOp>(
+        loc, getPackedByte(rewriter, loc, adaptor.getState()));
+    Value shift = rewriter.create<LLVM::ConstantOp>(
+        loc, i8Type, rewriter.getIntegerAttr(i8Type, *bit));
+    Value shifted = rewriter.create<LLVM::LShrOp>(loc, byte, shift);
+    rewriter.replaceOpWithNewOp<LLVM::TruncOp>(op, rewriter.getI1Type(),
+                                               shifted);
     return success();
   }
 };
@@ -153,16 +199,38 @@ struct StateWriteOpLowering : public OpConversionPattern<arc::StateWriteOp> {
   LogicalResult
   matchAndRewrite(arc::StateWriteOp op, OpAdaptor adaptor,
                   ConversionPatternRewriter &rewriter) const final {
+    auto bit = getPackedBit(op.getState());
+    auto store = [&](OpBuilder &builder, Location loc) {
+      if (!bit) {
+        builder.create<LLVM::StoreOp>(loc, adaptor.getValue(),
+                                      adaptor.getState());
+        return;
+      }
+      // Replace the state's bit in the byte it is packed into.
+      auto i8Type = builder.getI8Type();
+      Value ptr = getPackedByte(builder, loc, adaptor.getState());
+      Value byte = builder.create<LLVM::LoadOp>(loc, ptr);
+      Value mask = builder.create<LLVM::ConstantOp>(
+          loc, i8Type, builder.getIntegerAttr(i8Type, 0xFF & ~(1 << *bit)));
+      Value shift = builder.create<LLVM::ConstantOp>(
+          loc, i8Type, builder.getIntegerAttr(i8Type, *bit));
+      Value value =
+          builder.create<LLVM::ZExtOp>(loc, i8Type, adaptor.getValue());
+      Value cleared = builder.create<LLVM::AndOp>(loc, byte, mask);
+      Value shifted = builder.create<LLVM::ShlOp>(loc, value, shift);
+      Value updated = builder.create<LLVM::OrOp>(loc, cleared, shifted);
+      builder.create<LLVM::StoreOp>(loc, updated, ptr);
+    };
+
     if (adaptor.getCondition()) {
       rewriter.replaceOpWithNewOp<scf::IfOp>(
           op, adaptor.getCondition(), [&](auto &builder, auto loc) {
-            builder.template create<LLVM::StoreOp>(loc, adaptor.getValue(),
-                                                   adaptor.getState());
+            store(builder, loc);
             builder.template create<scf::YieldOp>(loc);
           });
     } else {
-      rewriter.replaceOpWithNewOp<LLVM::StoreOp>(op, adaptor.getValue(),
-                                                 adaptor.getState());
+      store(rewriter, op.getLoc());
+      rewriter.eraseOp(op);
     }
     return success();
   }
@@ -199,6 +267,24 @@ struct StorageGetOpLowering : public OpConversionPattern<arc::StorageGetOp> {
     Value ptr = rewriter.create<LLVM::GEPOp>(op.getLoc(),
                                              adaptor.getStorage().getType(),
                                              adaptor.getStorage(), offset);
+
+    // If the storage holds multiple instances of the model, step to the copy
+    // of the state that belongs to the instance currently being evaluated.
+    auto laneLoop = op->getParentOfType<scf::ForOp>();
+    while (laneLoop && !laneLoop->hasAttr(laneLoopAttrName))
+      laneLoop = laneLoop->getParentOfType<scf::ForOp>();
+    if (auto laneStride = getLaneStride(op.getType()); laneStride && laneLoop) {
+      auto i64Type = rewriter.getI64Type();
+      Value lane = rewriter.create<arith::IndexCastOp>(
+          op.getLoc(), i64Type, laneLoop.getInductionVar());
+      Value stride = rewriter.create<LLVM::ConstantOp>(
+          op.getLoc(), i64Type, rewriter.getI64IntegerAttr(laneStride));
+      Value laneOffset =
+          rewriter.create<LLVM::MulOp>(op.getLoc(), lane, stride);
+      ptr = rewriter.create<LLVM::GEPOp>(op.getLoc(), ptr.getType(), ptr,
+                                         laneOffset);
+    }
+
     auto type = typeConverter->convertType(op.getType());
     if (type != ptr.getType())
       ptr = rewriter.create<LLVM::BitcastOp>(op.getLoc(), type, ptr);
@@ -207,9 +293,13 @@ struct StorageGetOpLowering : public OpConversionPattern<arc::StorageGetOp> {
   }
 };
 
+/// The location of a word in a memory. For sparse memories, `ptr` points at
+/// the entry in the page table and `wordIndex` is the index of the word within
+/// that page.
 struct MemoryAccess {
   Value ptr;
   Value withinBounds;
+  Value wordIndex;
 };
 
 static MemoryAccess prepareMemoryAccess(Location loc, Value memory,
@@ -219,13 +309,38 @@ static MemoryAccess prepareMemoryAccess(Location loc, Value memory,
       address.getType().cast<IntegerType>().getWidth() + 1);
   Value addr = rewriter.create<LLVM::ZExtOp>(loc, zextAddrType, address);
   Value addrLimit = rewriter.create<LLVM::ConstantOp>(
-      loc, zextAddrType, rewriter.getI32IntegerAttr(type.getNumWords()));
+      loc, zextAddrType,
+      rewriter.getIntegerAttr(zextAddrType, type.getNumWords()));
   Value withinBounds = rewriter.create<LLVM::ICmpOp>(
       loc, LLVM::ICmpPredicate::ult, addr, addrLimit);
+  if (!type.isSparse()) {
+    auto ptrType = LLVM::LLVMPointerType::get(type.getWordType());
+    Value ptr =
+        rewriter.create<LLVM::GEPOp>(loc, ptrType, memory, ValueRange{addr});
+    return {ptr, withinBounds, {}};
+  }
+
+  // Split the address into the index of the page and of the word within it.
+  Value pageShift = rewriter.create<LLVM::ConstantOp>(
+      loc, zextAddrType,
+      rewriter.getIntegerAttr(zextAddrType,
+                              llvm::Log2_32(type.getWordsPerPage())));
+  Value pageMask = rewriter.create<LLVM::ConstantOp>(
+      loc, zextAddrType,
+      rewriter.getIntegerAttr(zextAddrType, type.getWordsPerPage() - 1));
+  Value page = rewriter.create<LLVM::LShrOp>(loc, addr, pageShift);
+  Value wordIndex = rewriter.create<LLVM::AndOp>(loc, addr, pageMask);
+  Value ptr = rewriter.create<LLVM::GEPOp>(loc, memory.getType(), memory,
+                                           ValueRange{page});
+  return {ptr, withinBounds, wordIndex};
+}
+
+/// Compute the pointer to a word within a page of a sparse memory.
+static Value getPageWordPtr(OpBuilder &builder, Location loc, Value page,
+                            const MemoryAccess &access, MemoryType type) {
   auto ptrType = LLVM::LLVMPointerType::get(type.getWordType());
-  Value ptr =
-      rewriter.create<LLVM::GEPOp>(loc, ptrType, memory, ValueRange{addr});
-  return {ptr, withinBounds};
+  return builder.create<LLVM::GEPOp>(loc, ptrType, page,
+                                     ValueRange{access.wordIndex});
 }
 
 struct MemoryReadOpLowering : public OpConversionPattern<arc::MemoryReadOp> {
@@ -234,23 +349,41 @@ struct MemoryReadOpLowering : public OpConversionPattern<arc::MemoryReadOp> {
   matchAndRewrite(arc::MemoryReadOp op, OpAdaptor adaptor,
                   ConversionPatternRewriter &rewriter) const final {
     auto type = typeConverter->convertType(op.getType());
-    auto access = prepareMemoryAccess(
-        op.getLoc(), adaptor.getMemory(), adaptor.getAddress(),
-        op.getMemory().getType().cast<MemoryType>(), rewriter);
+    auto memType = op.getMemory().getType().cast<MemoryType>();
+    auto access = prepareMemoryAccess(op.getLoc(), adaptor.getMemory(),
+                                      adaptor.getAddress(), memType, rewriter);
+    auto buildZero = [&](OpBuilder &builder, Location loc) {
+      Value zeroValue = builder.create<LLVM::ConstantOp>(
+          loc, type, builder.getI64IntegerAttr(0));
+      builder.create<scf::YieldOp>(loc, zeroValue);
+    };
 
     // Only attempt to read the memory if the address is within bounds,
-    // otherwise produce a zero value.
+    // otherwise produce a zero value. Pages of sparse memories that have
+    // never been written read as zero as well.
     rewriter.replaceOpWithNewOp<scf::IfOp>(
         op, access.withinBounds,
-        [&](auto &builder, auto loc) {
-          Value loadOp = builder.template create<LLVM::LoadOp>(loc, access.ptr);
-          builder.template create<scf::YieldOp>(loc, loadOp);
+        [&](OpBuilder &builder, Location loc) {
+          if (!memType.isSparse()) {
+            Value loadOp = builder.create<LLVM::LoadOp>(loc, access.ptr);
+            builder.create<scf::YieldOp>(loc, loadOp);
+            return;
+          }
+          Value page = builder.create<LLVM::LoadOp>(loc, access.ptr);
+          Value null = builder.create<LLVM::NullOp>(loc, page.getType());
+          Value allocated = builder.create<LLVM::ICmpOp>(
+              loc, LLVM::ICmpPredicate::ne, page, null);
+          auto ifOp = builder.create<scf::IfOp>(
+              loc, allocated,
+              [&](OpBuilder &builder, Location loc) {
+                Value loadOp = builder.create<LLVM::LoadOp>(
+                    loc, getPageWordPtr(builder, loc, page, access, memType));
+                builder.create<scf::YieldOp>(loc, loadOp);
+              },
+              buildZero);
+          builder.create<scf::YieldOp>(loc, ifOp.getResults());
         },
-        [&](auto &builder, auto loc) {
-          Value zeroValue = builder.template create<LLVM::ConstantOp>(
-              loc, type, builder.getI64IntegerAttr(0));
-          builder.template create<scf::YieldOp>(loc, zeroValue);
-        });
+        buildZero);
     return success();
   }
 };
@@ -260,20 +393,61 @@ struct MemoryWriteOpLowering : public OpConversionPattern<arc::MemoryWriteOp> {
   LogicalResult
   matchAndRewrite(arc::MemoryWriteOp op, OpAdaptor adaptor,
                   ConversionPatternRewriter &rewriter) const final {
-    auto access = prepareMemoryAccess(
-        op.getLoc(), adaptor.getMemory(), adaptor.getAddress(),
-        op.getMemory().getType().cast<MemoryType>(), rewriter);
+    auto memType = op.getMemory().getType().cast<MemoryType>();
+    auto access = prepareMemoryAccess(op.getLoc(), adaptor.getMemory(),
+                                      adaptor.getAddress(), memType, rewriter);
     auto enable = access.withinBounds;
     if (adaptor.getEnable())
       enable = rewriter.create<LLVM::AndOp>(op.getLoc(), adaptor.getEnable(),
                                             enable);
 
+    // Sparse memories allocate the page of the written word on first write.
+    LLVM::LLVMFuncOp callocFunc;
+    if (memType.isSparse())
+      callocFunc = LLVM::lookupOrCreateFn(
+          op->getParentOfType<ModuleOp>(), "calloc",
+          {rewriter.getI64Type(), rewriter.getI64Type()},
+          LLVM::LLVMPointerType::get(rewriter.getI8Type()));
+
     // Only attempt to write the memory if the address is within bounds.
     rewriter.replaceOpWithNewOp<scf::IfOp>(
-        op, enable, [&](auto &builder, auto loc) {
-          builder.template create<LLVM::StoreOp>(loc, adaptor.getData(),
-                                                 access.ptr);
-          builder.template create<scf::YieldOp>(loc);
+        op, enable, [&](OpBuilder &builder, Location loc) {
+          if (!memType.isSparse()) {
+            builder.create<LLVM::StoreOp>(loc, adaptor.getData(), access.ptr);
+            builder.create<scf::YieldOp>(loc);
+            return;
+          }
+          Value page = builder.create<LLVM::LoadOp>(loc, access.ptr);
+          Value null = builder.create<LLVM::NullOp>(loc, page.getType());
+          Value missing = builder.create<LLVM::ICmpOp>(
+              loc, LLVM::ICmpPredicate::eq, page, null);
+          auto ifOp = builder.create<scf::IfOp>(
+              loc, missing,
+              [&](OpBuilder &builder, Location loc) {
+                Value numWords = builder.create<LLVM::ConstantOp>(
+                    loc, builder.getI64Type(),
+                    builder.getI64IntegerAttr(memType.getWordsPerPage()));
+                Value stride = builder.create<LLVM::ConstantOp>(
+                    loc, builder.getI64Type(),
+                    builder.getI64IntegerAttr(memType.getStride()));
+                Value newPage =
+                    builder
+                        .create<LLVM::CallOp>(loc, callocFunc,
+                                              ValueRange{numWords, stride})
+                        .getResult();
+                newPage = builder.create<LLVM::BitcastOp>(loc, page.getType(),
+                                                          newPage);
+                builder.create<LLVM::StoreOp>(loc, newPage, access.ptr);
+                builder.create<scf::YieldOp>(loc, newPage);
+              },
+              [&](OpBuilder &builder, Location loc) {
+                builder.create<scf::YieldOp>(loc, page);
+              });
+          builder.create<LLVM::StoreOp>(
+              loc, adaptor.getData(),
+              getPageWordPtr(builder, loc, ifOp.getResult(0), access,
+                             memType));
+          builder.create<scf::YieldOp>(loc);
         });
     return success();
   }
@@ -339,6 +513,86 @@ struct ZeroCountOpLowering : public OpConversionPattern<arc::ZeroCountOp> {
 
 } // namespace
 
+//===----------------------------------------------------------------------===//
+// Wide Integer Lowering
+//===----------------------------------------------------------------------===//
+
+/// Return the vector of 64-bit lanes an integer of the given type is split into
+/// for bitwise operations, or a null type if the integer is not wide enough.
+static VectorType getWideVectorType(Type type, unsigned threshold) {
+  auto intType = type.dyn_cast<IntegerType>();
+  if (!intType || threshold == 0 || intType.getWidth() < threshold ||
+      intType.getWidth() % 64 != 0)
+    return {};
+  return VectorType::get({intType.getWidth() / 64},
+                         IntegerType::get(type.getContext(), 64));
+}
+
+namespace {
+
+/// Lower a bitwise operation on a wide integer to the same operation on a
+/// vector of 64-bit lanes. The backend maps such vectors directly onto SIMD
+/// registers, whereas wide scalar integers are legalized into long chains of
+/// 64-bit operations.
+template <class SourceOp, class TargetOp>
+struct WideBitwiseOpLowering : public ConvertOpToLLVMPattern<SourceOp> {
+  WideBitwiseOpLowering(LLVMTypeConverter &typeConverter, unsigned threshold)
+      : ConvertOpToLLVMPattern<SourceOp>(typeConverter, /*benefit=*/2),
+        threshold(threshold) {}
+  LogicalResult
+  matchAndRewrite(SourceOp op, typename SourceOp::Adaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    auto vectorType = getWideVectorType(op.getType(), threshold);
+    if (!vectorType)
+      return failure();
+    auto loc = op.getLoc();
+    Value lhs =
+        rewriter.create<LLVM::BitcastOp>(loc, vectorType, adaptor.getLhs());
+    Value rhs =
+        rewriter.create<LLVM::BitcastOp>(loc, vectorType, adaptor.getRhs());
+    Value result = rewriter.create<TargetOp>(loc, vectorType, lhs, rhs);
+    rewriter.replaceOpWithNewOp<LLVM::BitcastOp>(op, op.getType(), result);
+    return success();
+  }
+  unsigned threshold;
+};
+
+/// Lower a mux of wide integers to a select of vectors of 64-bit lanes, such
+/// that it stays in SIMD registers alongside the bitwise operations.
+struct WideSelectOpLowering : public ConvertOpToLLVMPattern<arith::SelectOp> {
+  WideSelectOpLowering(LLVMTypeConverter &typeConverter, unsigned threshold)
+      : ConvertOpToLLVMPattern(typeConverter, /*benefit=*/2),
+        threshold(threshold) {}
+  LogicalResult
+  matchAndRewrite(arith::SelectOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    auto vectorType = getWideVectorType(op.getType(), threshold);
+    if (!vectorType || !op.getCondition().getType().isInteger(1))
+      return failure();
+    auto loc = op.getLoc();
+    Value trueValue = rewriter.create<LLVM::BitcastOp>(
+        loc, vectorType, adaptor.getTrueValue());
+    Value falseValue = rewriter.create<LLVM::BitcastOp>(
+        loc, vectorType, adaptor.getFalseValue());
+    Value result = rewriter.create<LLVM::SelectOp>(
+        loc, vectorType, adaptor.getCondition(), trueValue, falseValue);
+    rewriter.replaceOpWithNewOp<LLVM::BitcastOp>(op, op.getType(), result);
+    return success();
+  }
+  unsigned threshold;
+};
+
+} // namespace
+
+static void populateWideIntegerConversion(LLVMTypeConverter &typeConverter,
+                                          RewritePatternSet &patterns,
+                                          unsigned threshold) {
+  patterns.add<WideBitwiseOpLowering<arith::AndIOp, LLVM::AndOp>,
+               WideBitwiseOpLowering<arith::OrIOp, LLVM::OrOp>,
+               WideBitwiseOpLowering<arith::XOrIOp, LLVM::XOrOp>,
+               WideSelectOpLowering>(typeConverter, threshold);
+}
+
 static bool isArcType(Type type) {
   return type.isa<StorageType>() || type.isa<MemoryType>() ||
          type.isa<StateType>();
@@ -361,6 +615,7 @@ static void addGenericLegality(ConversionTarget &target) {
 
 static void populateLegality(ConversionTarget &target) {
   target.addLegalDialect<mlir::BuiltinDialect>();
+  target.addLegalDialect<mlir::arith::ArithDialect>();
   target.addLegalDialect<hw::HWDialect>();
   target.addLegalDialect<comb::CombDialect>();
   target.addLegalDialect<func::FuncDialect>();
@@ -389,8 +644,12 @@ static void populateTypeConversion(TypeConverter &typeConverter) {
     return LLVM::LLVMPointerType::get(IntegerType::get(type.getContext(), 8));
   });
   typeConverter.addConversion([&](MemoryType type) {
-    return LLVM::LLVMPointerType::get(
+    // Sparse memories are a table of pointers to pages of words.
+    auto wordPtrType = LLVM::LLVMPointerType::get(
         IntegerType::get(type.getContext(), type.getStride() * 8));
+    if (type.isSparse())
+      return LLVM::LLVMPointerType::get(wordPtrType);
+    return wordPtrType;
   });
   typeConverter.addConversion([&](StateType type) {
     return LLVM::LLVMPointerType::get(
@@ -434,11 +693,22 @@ static void populateOpConversion(RewritePatternSet &patterns,
 // Pass Implementation
 //===----------------------------------------------------------------------===//
 
+/// Check whether a function accesses any state in a storage directly.
+static bool accessesStorage(func::FuncOp funcOp) {
+  return funcOp
+      .walk([](arc::StorageGetOp) { return WalkResult::interrupt(); })
+      .wasInterrupted();
+}
+
 namespace {
 struct LowerArcToLLVMPass : public LowerArcToLLVMBase<LowerArcToLLVMPass> {
   void runOnOperation() override;
+  LogicalResult wrapInLaneLoop(func::FuncOp funcOp);
   LogicalResult lowerToMLIR();
   LogicalResult lowerArcToLLVM();
+
+  using LowerArcToLLVMBase::lanes;
+  using LowerArcToLLVMBase::wideVectorThreshold;
 };
 } // namespace
 
@@ -452,6 +722,18 @@ void LowerArcToLLVMPass::runOnOperation() {
   for (auto op : llvm::make_early_inc_range(getOperation().getOps<ModelOp>()))
     op.erase();
 
+  // Make every function that accesses a storage evaluate all instances
+  // allocated within it. Functions that merely forward the storage to other
+  // functions, like the clock function of a partitioned clock tree, are left
+  // alone to not evaluate the lanes multiple times.
+  if (lanes > 1)
+    for (auto funcOp : getOperation().getOps<func::FuncOp>())
+      if (llvm::any_of(funcOp.getArgumentTypes(),
+                       [](Type type) { return type.isa<StorageType>(); }) &&
+          accessesStorage(funcOp))
+        if (failed(wrapInLaneLoop(funcOp)))
+          return signalPassFailure();
+
   if (failed(lowerToMLIR()))
     return signalPassFailure();
 
@@ -459,6 +741,31 @@ void LowerArcToLLVMPass::runOnOperation() {
     return signalPassFailure();
 }
 
+/// Move the body of a function into a loop over all instances of the model.
+/// The storage accesses within the loop are offset to the current instance
+/// when they are lowered.
+LogicalResult LowerArcToLLVMPass::wrapInLaneLoop(func::FuncOp funcOp) {
+  if (!funcOp.getBody().hasOneBlock() || funcOp.getNumResults() != 0)
+    return funcOp.emitOpError("cannot be evaluated for multiple lanes; must "
+                              "have a single block and no results");
+
+  auto &block = funcOp.getBody().front();
+  auto loc = funcOp.getLoc();
+  auto builder = OpBuilder::atBlockBegin(&block);
+  Value lowerBound = builder.create<arith::ConstantIndexOp>(loc, 0);
+  Value upperBound = builder.create<arith::ConstantIndexOp>(loc, lanes);
+  Value step = builder.create<arith::ConstantIndexOp>(loc, 1);
+  auto forOp = builder.create<scf::ForOp>(loc, lowerBound, upperBound, step);
+  forOp->setAttr(laneLoopAttrName, builder.getUnitAttr());
+
+  auto *loopBody = forOp.getBody();
+  loopBody->getOperations().splice(loopBody->getTerminator()->getIterator(),
+                                   block.getOperations(),
+                                   std::next(forOp->getIterator()),
+                                   block.getTerminator()->getIterator());
+  return success();
+}
+
 /// Perform the lowering to Func and SCF.
 LogicalResult LowerArcToLLVMPass::lowerToMLIR() {
   LLVM_DEBUG(llvm::dbgs() << "Lowering arcs to Func/SCF dialects\n");
@@ -495,10 +802,16 @@ LogicalResult LowerArcToLLVMPass::lowerArcToLLVM() {
   populateHWToLLVMTypeConversions(converter);
   populateCombToLLVMConversionPatterns(converter, patterns);
   arith::populateArithToLLVMConversionPatterns(converter, patterns);
+  if (wideVectorThreshold > 0)
+    populateWideIntegerConversion(converter, patterns, wideVectorThreshold);
 
   return applyFullConversion(getOperation(), target, std::move(patterns));
 }
 
-std::unique_ptr<OperationPass<ModuleOp>> circt::createLowerArcToLLVMPass() {
-  return std::make_unique<LowerArcToLLVMPass>();
+std::unique_ptr<OperationPass<ModuleOp>>
+circt::createLowerArcToLLVMPass(unsigned lanes, unsigned wideVectorThreshold) {
+  auto pass = std::make_unique<LowerArcToLLVMPass>();
+  pass->lanes = lanes;
+  pass->wideVectorThreshold = wideVectorThreshold;
+  return pass;
 }
@@ -22,6 +22,7 @@
 #include "circt/Dialect/SV/SVOps.h"
 #include "circt/Dialect/Seq/SeqOps.h"
 #include "mlir/IR/ImplicitLocOpBuilder.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/Transforms/DialectConversion.h"
 #include "llvm/ADT/TypeSwitch.h"
 
@@ -444,6 +445,31 @@ void CalyxToHWPass::runOnOperation() {
 LogicalResult CalyxToHWPass::runOnModule(ModuleOp module) {
   MLIRContext &context = getContext();
 
+  // Turn the components into modules first. This inserts the modules into the
+  // top-level module, and therefore has to happen sequentially.
+  SmallVector<StringAttr> componentNames;
+  for (auto component : module.getOps<ComponentOp>())
+    componentNames.push_back(component.getNameAttr());
+
+  ConversionTarget componentTarget(context);
+  componentTarget.addIllegalOp<ComponentOp>();
+  componentTarget.addLegalDialect<HWDialect>();
+  componentTarget.addLegalDialect<SVDialect>();
+
+  RewritePatternSet componentPatterns(&context);
+  componentPatterns.add<ConvertComponentOp>(&context);
+  if (failed(applyPartialConversion(module, componentTarget,
+                                    std::move(componentPatterns))))
+    return failure();
+
+  // The bodies of the modules are independent of each other, so they are
+  // lowered in parallel. A single symbol table avoids scanning the top-level
+  // module for every component.
+  SymbolTable symbolTable(module);
+  SmallVector<HWModuleOp> hwModules;
+  for (auto name : componentNames)
+    hwModules.push_back(symbolTable.lookup<HWModuleOp>(name));
+
   ConversionTarget target(context);
   target.addIllegalDialect<CalyxDialect>();
   target.addLegalDialect<HWDialect>();
@@ -452,13 +478,15 @@ LogicalResult CalyxToHWPass::runOnModule(ModuleOp module) {
   target.addLegalDialect<SVDialect>();
 
   RewritePatternSet patterns(&context);
-  patterns.add<ConvertComponentOp>(&context);
   patterns.add<ConvertWiresOp>(&context);
   patterns.add<ConvertControlOp>(&context);
   patterns.add<ConvertCellOp>(&context);
   patterns.add<ConvertAssignOp>(&context);
+  FrozenRewritePatternSet frozenPatterns(std::move(patterns));
 
-  return applyPartialConversion(module, target, std::move(patterns));
+  return failableParallelForEach(&context, hwModules, [&](HWModuleOp hwMod) {
+    return applyPartialConversion(hwMod, target, frozenPatterns);
+  });
 }
 
 std::unique_ptr<mlir::Pass> circt::createCalyxToHWPass() {
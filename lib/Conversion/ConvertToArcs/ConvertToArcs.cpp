@@ -12,6 +12,7 @@
 #include "circt/Dialect/HW/HWOps.h"
 #include "circt/Dialect/Seq/SeqOps.h"
 #include "circt/Support/Namespace.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "llvm/Support/Debug.h"
 
 #define DEBUG_TYPE "convert-to-arcs"
@@ -21,10 +22,13 @@ using namespace arc;
 using namespace hw;
 using llvm::MapVector;
 
+/// Check whether an op has to stay outside of arcs. Function calls, such as
+/// lowered interop procedures, are kept out since they may call into foreign
+/// code that must not be deduplicated or tabulated like arc bodies.
 static bool isArcBreakingOp(Operation *op) {
   return op->hasTrait<OpTrait::ConstantLike>() ||
          isa<hw::InstanceOp, seq::CompRegOp, ClockGateOp, MemoryOp,
-             ClockedOpInterface>(op) ||
+             ClockedOpInterface, func::CallOp>(op) ||
          op->getNumResults() > 1;
 }
 
@@ -50,15 +54,36 @@ struct Converter {
   /// A post-order traversal of the operations in the current module.
   SmallVector<Operation *> postOrder;
 
-  /// The set of arc-breaking ops an operation in the current module
-  /// contributes to, represented as a bit mask.
-  MapVector<Operation *, APInt> faninMasks;
+  /// The distinct sets of arc-breaking ops the operations in the current
+  /// module contribute to, each represented as a bit mask. Operations refer to
+  /// these by index, such that operations with the same fan-in share one mask.
+  SmallVector<APInt> faninMasks;
+  DenseMap<APInt, unsigned> faninMaskIndices;
 
-  /// The sets of operations that contribute to the same arc-breaking ops.
-  MapVector<APInt, DenseSet<Operation *>> faninMaskGroups;
+  /// A cache of the unions of two fan-in masks, by mask index.
+  DenseMap<std::pair<unsigned, unsigned>, unsigned> faninMaskUnions;
+
+  /// The index of the fan-in mask of each operation in the current module.
+  DenseMap<Operation *, unsigned> faninMaskOfOp;
+
+  /// The groups of operations that contribute to the same arc-breaking ops,
+  /// each in post-order, and the group each operation belongs to.
+  SmallVector<SmallVector<Operation *>> faninMaskGroups;
+  DenseMap<Operation *, unsigned> groupOfOp;
 
   /// The arc uses generated by `extractArcs`.
   SmallVector<StateOp> arcUses;
+
+  /// Statistics reported by the pass.
+  unsigned numArcsCreated = 0;
+  unsigned numOpsOutlined = 0;
+
+  unsigned getFaninMask(const APInt &mask);
+  unsigned getFaninMaskUnion(unsigned a, unsigned b);
+  bool isInGroup(Operation *op, unsigned group) const {
+    auto it = groupOfOp.find(op);
+    return it != groupOfOp.end() && it->second == group;
+  }
 };
 } // namespace
 
@@ -106,15 +131,40 @@ LogicalResult Converter::runOnModule(HWModuleOp module) {
   return success();
 }
 
+/// Return the index of a fan-in mask, adding the mask if it is new.
+unsigned Converter::getFaninMask(const APInt &mask) {
+  auto [it, inserted] = faninMaskIndices.insert({mask, faninMasks.size()});
+  if (inserted)
+    faninMasks.push_back(mask);
+  return it->second;
+}
+
+/// Return the index of the union of two fan-in masks.
+unsigned Converter::getFaninMaskUnion(unsigned a, unsigned b) {
+  if (a == b)
+    return a;
+  if (a > b)
+    std::swap(a, b);
+  auto it = faninMaskUnions.find({a, b});
+  if (it != faninMaskUnions.end())
+    return it->second;
+  unsigned result = getFaninMask(faninMasks[a] | faninMasks[b]);
+  faninMaskUnions.insert({{a, b}, result});
+  return result;
+}
+
 LogicalResult Converter::analyzeFanIn() {
   SmallVector<std::tuple<Operation *, unsigned>> worklist;
 
   // Seed the worklist and fanin masks with the arc breaking operations.
   faninMasks.clear();
+  faninMaskIndices.clear();
+  faninMaskUnions.clear();
+  faninMaskOfOp.clear();
   for (auto *op : arcBreakers) {
     unsigned index = arcBreakerIndices.lookup(op);
-    auto mask = APInt::getOneBitSet(arcBreakers.size(), index);
-    faninMasks[op] = mask;
+    faninMaskOfOp[op] =
+        getFaninMask(APInt::getOneBitSet(arcBreakers.size(), index));
     worklist.push_back({op, 0});
   }
 
@@ -148,27 +198,42 @@ LogicalResult Converter::analyzeFanIn() {
   // Compute fanin masks in reverse post-order, which will compute the mask
   // for an operation's uses before it computes it for the operation itself.
   // This allows us to compute the set of arc breakers an operation
-  // contributes to in one pass.
+  // contributes to in one pass. Since the masks are shared, an operation
+  // whose users all have the same mask costs no more than a map lookup.
+  // Operations are also assigned to the group of their mask in the order in
+  // which the masks first appear.
+  SmallVector<unsigned> groupOfMask;
+  faninMaskGroups.clear();
+  groupOfOp.clear();
   for (auto *op : llvm::reverse(postOrder)) {
-    auto mask = APInt::getZero(arcBreakers.size());
+    std::optional<unsigned> mask;
     for (auto *user : op->getUsers()) {
-      auto it = faninMasks.find(user);
-      if (it != faninMasks.end())
-        mask |= it->second;
+      auto it = faninMaskOfOp.find(user);
+      if (it != faninMaskOfOp.end())
+        mask = mask ? getFaninMaskUnion(*mask, it->second) : it->second;
     }
+    if (!mask)
+      mask = getFaninMask(APInt::getZero(arcBreakers.size()));
 
-    auto duplicateOp = faninMasks.insert({op, mask});
+    auto duplicateOp = faninMaskOfOp.insert({op, *mask});
     (void)duplicateOp;
     assert(duplicateOp.second && "duplicate op in order");
+
+    if (groupOfMask.size() <= *mask)
+      groupOfMask.resize(faninMasks.size(), -1U);
+    if (groupOfMask[*mask] == -1U) {
+      groupOfMask[*mask] = faninMaskGroups.size();
+      faninMaskGroups.emplace_back();
+    }
+    groupOfOp[op] = groupOfMask[*mask];
   }
 
-  // Group the operations by their fan-in mask.
-  faninMaskGroups.clear();
-  for (auto [op, mask] : faninMasks)
-    if (!isArcBreakingOp(op) && !isa<hw::OutputOp>(op))
-      faninMaskGroups[mask].insert(op);
+  // Collect the operations of each group in post-order.
+  for (auto *op : postOrder)
+    faninMaskGroups[groupOfOp.lookup(op)].push_back(op);
   LLVM_DEBUG(llvm::dbgs() << "- Found " << faninMaskGroups.size()
-                          << " fanin mask groups\n");
+                          << " fanin mask groups among " << faninMasks.size()
+                          << " distinct fanin masks\n");
 
   return success();
 }
@@ -182,8 +247,7 @@ void Converter::extractArcs(HWModuleOp module) {
   SmallVector<std::pair<OpOperand *, unsigned>> externalUses;
 
   arcUses.clear();
-  for (auto &group : faninMaskGroups) {
-    auto &opSet = group.second;
+  for (auto [groupIdx, groupOps] : llvm::enumerate(faninMaskGroups)) {
     OpBuilder builder(module);
 
     auto block = std::make_unique<Block>();
@@ -196,15 +260,12 @@ void Converter::extractArcs(HWModuleOp module) {
     externalUses.clear();
 
     Operation *lastOp = nullptr;
-    // TODO: Remove the elements from the post order as we go.
-    for (auto *op : postOrder) {
-      if (!opSet.contains(op))
-        continue;
+    for (auto *op : groupOps) {
       lastOp = op;
       op->remove();
       builder.insert(op);
       for (auto &operand : op->getOpOperands()) {
-        if (opSet.contains(operand.get().getDefiningOp()))
+        if (isInGroup(operand.get().getDefiningOp(), groupIdx))
           continue;
         auto &mapped = valueMapping[operand.get()];
         if (!mapped) {
@@ -218,7 +279,7 @@ void Converter::extractArcs(HWModuleOp module) {
       for (auto result : op->getResults()) {
         bool anyExternal = false;
         for (auto &use : result.getUses()) {
-          if (!opSet.contains(use.getOwner())) {
+          if (!isInGroup(use.getOwner(), groupIdx)) {
             anyExternal = true;
             externalUses.push_back({&use, outputs.size()});
           }
@@ -231,6 +292,7 @@ void Converter::extractArcs(HWModuleOp module) {
     }
     assert(lastOp);
     builder.create<arc::OutputOp>(lastOp->getLoc(), outputs);
+    numOpsOutlined += groupOps.size();
 
     // Create the arc definition.
     builder.setInsertionPoint(module);
@@ -240,6 +302,7 @@ void Converter::extractArcs(HWModuleOp module) {
             globalNamespace.newName(module.getModuleName() + "_arc")),
         builder.getFunctionType(inputTypes, outputTypes));
     defOp.getBody().push_back(block.release());
+    ++numArcsCreated;
 
     // Create the call to the arc definition to replace the operations that
     // we have just extracted.
@@ -391,6 +454,7 @@ LogicalResult Converter::absorbRegs(HWModuleOp module) {
                                      module.getModuleName() + "_arc")),
                                  builder.getFunctionType(types, types));
     defOp.getBody().push_back(block.release());
+    ++numArcsCreated;
 
     builder.setInsertionPoint(module.getBodyBlock()->getTerminator());
     auto arcOp =
@@ -425,7 +489,9 @@ struct ConvertToArcsPass : public ConvertToArcsBase<ConvertToArcsPass> {
   void runOnOperation() override {
     Converter converter;
     if (failed(converter.run(getOperation())))
-      signalPassFailure();
+      return signalPassFailure();
+    numArcs = converter.numArcsCreated;
+    numOpsOutlined = converter.numOpsOutlined;
   }
 };
 } // namespace
@@ -14,11 +14,15 @@
 #include "../PassDetail.h"
 #include "circt/Dialect/FIRRTL/FIRRTLOps.h"
 #include "circt/Support/Version.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/Support/FileUtilities.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/ToolOutputFile.h"
 
+#include <atomic>
+
 using namespace circt;
 using namespace firrtl;
 
@@ -173,13 +177,17 @@ static LogicalResult emitModule(FModuleLike module, llvm::raw_ostream &os) {
   return success();
 }
 
-/// Exports a Chisel interface to the output stream.
-static LogicalResult exportChiselInterface(CircuitOp circuit,
-                                           llvm::raw_ostream &os) {
-  // Emit version, package, and import declarations
+/// Emits the version, package, and import declarations of an interface file.
+static void emitHeader(CircuitOp circuit, llvm::raw_ostream &os) {
   os << circt::getCirctVersionComment() << "package shelf."
      << circuit.getName().lower()
      << "\n\nimport chisel3._\nimport chisel3.experimental._\n\n";
+}
+
+/// Exports a Chisel interface to the output stream.
+static LogicalResult exportChiselInterface(CircuitOp circuit,
+                                           llvm::raw_ostream &os) {
+  emitHeader(circuit, os);
 
   // Emit a class for the main circuit module.
   auto topModule = circuit.getMainModule();
@@ -189,9 +197,39 @@ static LogicalResult exportChiselInterface(CircuitOp circuit,
   return success();
 }
 
-/// Exports Chisel interface files for the circuit to the specified directory.
+/// Writes `contents` to the file at `path`. If `onlyWriteChanged` is set and
+/// the file already holds exactly these contents, it is left untouched such
+/// that its modification time is preserved.
+static LogicalResult writeOutputFile(Location loc, StringRef path,
+                                     StringRef contents,
+                                     bool onlyWriteChanged) {
+  if (onlyWriteChanged) {
+    uint64_t size;
+    if (!llvm::sys::fs::file_size(path, size) && size == contents.size()) {
+      auto existing = llvm::MemoryBuffer::getFile(
+          path, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+      if (existing && (*existing)->getBuffer() == contents)
+        return success();
+    }
+  }
+
+  std::string errorMessage;
+  auto file = mlir::openOutputFile(path, &errorMessage);
+  if (!file) {
+    mlir::emitError(loc, errorMessage);
+    return failure();
+  }
+  file->os() << contents;
+  file->keep();
+  return success();
+}
+
+/// Exports Chisel interface files for the circuit to the specified directory,
+/// one for each public module. The interface of the main module is named after
+/// the circuit.
 static LogicalResult exportSplitChiselInterface(CircuitOp circuit,
-                                                StringRef outputDirectory) {
+                                                StringRef outputDirectory,
+                                                bool onlyWriteChanged) {
   // Create the output directory if needed.
   std::error_code error = llvm::sys::fs::create_directories(outputDirectory);
   if (error) {
@@ -200,22 +238,37 @@ static LogicalResult exportSplitChiselInterface(CircuitOp circuit,
     return failure();
   }
 
-  // Open the output file.
-  SmallString<128> interfaceFilePath(outputDirectory);
-  llvm::sys::path::append(interfaceFilePath, circuit.getName());
-  llvm::sys::path::replace_extension(interfaceFilePath, "scala");
-  std::string errorMessage;
-  auto interfaceFile = mlir::openOutputFile(interfaceFilePath, &errorMessage);
-  if (!interfaceFile) {
-    circuit.emitError(errorMessage);
-    return failure();
-  }
+  auto mainModule = circuit.getMainModule();
+  SmallVector<FModuleLike> modules;
+  for (auto module : circuit.getOps<FModuleLike>())
+    if (SymbolTable::getSymbolVisibility(module) ==
+        SymbolTable::Visibility::Public)
+      modules.push_back(module);
+
+  // Export the interfaces in parallel. Each of them is emitted to a buffer
+  // first, such that it is written with a single write, and can be compared to
+  // the existing file. All modules are exported even if one fails, such that
+  // the reported errors do not depend on thread scheduling.
+  std::atomic<bool> anyFailed(false);
+  mlir::parallelForEach(circuit.getContext(), modules, [&](FModuleLike module) {
+    std::string contents;
+    llvm::raw_string_ostream os(contents);
+    emitHeader(circuit, os);
+    if (failed(emitModule(module, os))) {
+      anyFailed = true;
+      return;
+    }
 
-  // Export the interface to the file.
-  auto result = exportChiselInterface(circuit, interfaceFile->os());
-  if (succeeded(result))
-    interfaceFile->keep();
-  return result;
+    SmallString<128> interfaceFilePath(outputDirectory);
+    llvm::sys::path::append(interfaceFilePath,
+                            module == mainModule ? circuit.getName()
+                                                 : module.getModuleName());
+    llvm::sys::path::replace_extension(interfaceFilePath, "scala");
+    if (failed(writeOutputFile(module.getLoc(), interfaceFilePath, os.str(),
+                               onlyWriteChanged)))
+      anyFailed = true;
+  });
+  return failure(anyFailed);
 }
 
 //===----------------------------------------------------------------------===//
@@ -240,12 +293,15 @@ private:
 struct ExportSplitChiselInterfacePass
     : public ExportSplitChiselInterfaceBase<ExportSplitChiselInterfacePass> {
 
-  explicit ExportSplitChiselInterfacePass(StringRef directory) {
+  explicit ExportSplitChiselInterfacePass(StringRef directory,
+                                          bool onlyWriteChanged) {
     directoryName = directory.str();
+    this->onlyWriteChanged = onlyWriteChanged;
   }
 
   void runOnOperation() override {
-    if (failed(exportSplitChiselInterface(getOperation(), directoryName)))
+    if (failed(exportSplitChiselInterface(getOperation(), directoryName,
+                                          onlyWriteChanged)))
       signalPassFailure();
   }
 };
@@ -257,8 +313,10 @@ circt::createExportChiselInterfacePass(llvm::raw_ostream &os) {
 }
 
 std::unique_ptr<mlir::Pass>
-circt::createExportSplitChiselInterfacePass(mlir::StringRef directory) {
-  return std::make_unique<ExportSplitChiselInterfacePass>(directory);
+circt::createExportSplitChiselInterfacePass(mlir::StringRef directory,
+                                            bool onlyWriteChanged) {
+  return std::make_unique<ExportSplitChiselInterfacePass>(directory,
+                                                          onlyWriteChanged);
 }
 
 std::unique_ptr<mlir::Pass> circt::createExportChiselInterfacePass() {
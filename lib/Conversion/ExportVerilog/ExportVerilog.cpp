@@ -42,12 +42,16 @@
 #include "mlir/Support/FileUtilities.h"
 #include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringSet.h"
 #include "llvm/ADT/TypeSwitch.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/SaveAndRestore.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/ToolOutputFile.h"
+#include "llvm/Support/raw_sha1_ostream.h"
 #include "llvm/Support/raw_ostream.h"
 
 using namespace circt;
@@ -1308,6 +1312,11 @@ public:
 
   /// This keeps track of assignments folded into wire emissions
   SmallPtrSet<Operation *, 16> assignsInlined;
+
+  /// This keeps track of the shared LTL expressions whose named `sequence` or
+  /// `property` declaration has been emitted, and which are referred to by
+  /// name from then on.
+  SmallPtrSet<Operation *, 8> ltlDeclsEmitted;
 };
 
 } // end anonymous namespace
@@ -3008,9 +3017,14 @@ class PropertyEmitter : public EmitterBase,
 public:
   /// Create a PropertyEmitter for the specified module emitter, and keeping
   /// track of any emitted expressions in the specified set.
+  /// If `declaredOp` is set, the expression of that op is emitted even if it
+  /// has a named declaration, which is what the declaration itself needs.
   PropertyEmitter(ModuleEmitter &emitter,
-                  SmallPtrSetImpl<Operation *> &emittedOps)
-      : PropertyEmitter(emitter, emittedOps, tokens) {}
+                  SmallPtrSetImpl<Operation *> &emittedOps,
+                  Operation *declaredOp = nullptr)
+      : PropertyEmitter(emitter, emittedOps, tokens) {
+    this->declaredOp = declaredOp;
+  }
   PropertyEmitter(ModuleEmitter &emitter,
                   SmallPtrSetImpl<Operation *> &emittedOps,
                   BufferingPP::BufferVec &tokens)
@@ -3056,6 +3070,9 @@ private:
   /// location information tracking.
   SmallPtrSetImpl<Operation *> &emittedOps;
 
+  /// The op whose named declaration is being emitted, if any.
+  Operation *declaredOp = nullptr;
+
   /// Tokens buffered for inserting casts/parens after emitting children.
   SmallVector<Token> tokens;
 
@@ -3097,8 +3114,16 @@ EmittedProperty PropertyEmitter::emitNestedProperty(
     return {PropertyPrecedence::Symbol};
   }
 
+  // Refer to shared expressions by the name of their declaration.
+  auto *op = property.getDefiningOp();
+  if (op != declaredOp && emitter.ltlDeclsEmitted.contains(op)) {
+    ps << PPExtString(op->getAttrOfType<StringAttr>("hw.verilogName"));
+    emittedOps.insert(op);
+    return {PropertyPrecedence::Symbol};
+  }
+
   unsigned startIndex = tokens.size();
-  auto info = dispatchLTLVisitor(property.getDefiningOp());
+  auto info = dispatchLTLVisitor(op);
 
   // If this subexpression would bind looser than the expression it is bound
   // into, then we need to parenthesize it. Insert the parentheses
@@ -3114,7 +3139,7 @@ EmittedProperty PropertyEmitter::emitNestedProperty(
   }
 
   // Remember that we emitted this.
-  emittedOps.insert(property.getDefiningOp());
+  emittedOps.insert(op);
   return info;
 }
 
@@ -3465,6 +3490,9 @@ private:
                             const SmallPtrSetImpl<Operation *> &locationOps,
                             StringRef multiLineComment = StringRef());
 
+  void emitLTLDeclarations(Value property,
+                           SmallPtrSetImpl<Operation *> &visited);
+  void emitLTLDeclaration(Operation *op);
   LogicalResult emitVerifAssertLike(Operation *op, Value property,
                                     PPExtString opName);
   LogicalResult visitVerif(verif::AssertOp op);
@@ -4175,6 +4203,46 @@ LogicalResult StmtEmitter::visitSV(CoverConcurrentOp op) {
   return emitConcurrentAssertion(op, PPExtString("cover"));
 }
 
+/// Emit the named declarations of the shared LTL expressions within a property
+/// that have not been declared yet, dependencies first. Only expressions in the
+/// module body are shared, which is where their declarations go.
+void StmtEmitter::emitLTLDeclarations(Value property,
+                                      SmallPtrSetImpl<Operation *> &visited) {
+  auto *op = property.getDefiningOp();
+  if (!op || !isa<ltl::LTLDialect>(op->getDialect()) ||
+      emitter.ltlDeclsEmitted.contains(op) || !visited.insert(op).second)
+    return;
+  for (auto operand : op->getOperands())
+    emitLTLDeclarations(operand, visited);
+  if (op->hasAttr("hw.verilogName"))
+    emitLTLDeclaration(op);
+}
+
+/// Emit a named `sequence` or `property` declaration for a shared LTL
+/// expression.
+void StmtEmitter::emitLTLDeclaration(Operation *op) {
+  auto name = op->getAttrOfType<StringAttr>("hw.verilogName");
+  PPExtString keyword(isa<ltl::SequenceType>(op->getResult(0).getType())
+                          ? "sequence"
+                          : "property");
+  SmallPtrSet<Operation *, 8> ops;
+  startStatement();
+  ps << keyword << PP::nbsp << PPExtString(name) << ";";
+  setPendingNewline();
+  ps.scopedBox(PP::bbox2, [&]() {
+    startStatement();
+    ps.scopedBox(PP::ibox2, [&]() {
+      PropertyEmitter(emitter, ops, op).emitProperty(op->getResult(0));
+      ps << ";";
+    });
+    emitLocationInfoAndNewLine(ops);
+  });
+  startStatement();
+  ps << "end" << keyword;
+  setPendingNewline();
+  emitter.ltlDeclsEmitted.insert(op);
+}
+
 /// Emit an assert-like operation from the `verif` dialect. This covers
 /// `verif.assert`, `verif.assume`, and `verif.cover`.
 LogicalResult StmtEmitter::emitVerifAssertLike(Operation *op, Value property,
@@ -4194,6 +4262,14 @@ LogicalResult StmtEmitter::emitVerifAssertLike(Operation *op, Value property,
   bool isProcedural = op->getParentOp()->hasTrait<ProceduralRegion>();
   bool emitAsImmediate = !isTemporal && isProcedural;
 
+  // Declare the shared sequences and properties this assertion refers to. This
+  // is only possible in the module body; elsewhere, the expressions of the
+  // ones not declared yet are emitted inline.
+  if (isa<HWModuleOp>(op->getParentOp())) {
+    SmallPtrSet<Operation *, 8> visited;
+    emitLTLDeclarations(property, visited);
+  }
+
   startStatement();
   SmallPtrSet<Operation *, 8> ops;
   ops.insert(op);
@@ -4837,9 +4913,15 @@ void StmtEmitter::emitStatement(Operation *op) {
     return;
 
   // Ignore LTL expressions as they are emitted as part of verification
-  // statements.
-  if (isa<ltl::LTLDialect>(op->getDialect()))
+  // statements. Shared expressions are declared where they are defined, or
+  // before their first use if that comes first.
+  if (isa<ltl::LTLDialect>(op->getDialect())) {
+    if (op->hasAttr("hw.verilogName")) {
+      SmallPtrSet<Operation *, 8> visited;
+      emitLTLDeclarations(op->getResult(0), visited);
+    }
     return;
+  }
 
   // Handle HW statements, SV statements.
   if (succeeded(dispatchStmtVisitor(op)) || succeeded(dispatchSVVisitor(op)) ||
@@ -5567,21 +5649,28 @@ void ModuleEmitter::emitHWModule(HWModuleOp module) {
 /// of an explicit output file attribute.
 void SharedEmitterState::gatherFiles(bool separateModules) {
 
-  /// Collect all the inner names from the specified module and add them to the
+  /// Collect all the inner names from the specified module, to be added to the
   /// IRCache.  Declarations (named things) only exist at the top level of the
   /// module.  Also keep track of any modules that contain bind operations.
   /// These are non-hierarchical references which we need to be careful about
-  /// during emission.
-  auto collectInstanceSymbolsAndBinds = [&](HWModuleOp moduleOp) {
+  /// during emission.  The module bodies are walked in parallel once all
+  /// top-level operations have been visited.
+  struct ModuleSymbols {
+    SmallVector<std::pair<StringAttr, Operation *>> innerNames;
+    bool containsBinds = false;
+  };
+  auto collectInstanceSymbolsAndBinds = [&](HWModuleOp moduleOp,
+                                            ModuleSymbols &symbols) {
     moduleOp.walk([&](Operation *op) {
       // Populate the symbolCache with all operations that can define a symbol.
       if (auto name = op->getAttrOfType<StringAttr>(
               hw::InnerName::getInnerNameAttrName()))
-        symbolCache.addDefinition(moduleOp.getNameAttr(), name, op);
+        symbols.innerNames.push_back({name, op});
       if (isa<BindOp>(op))
-        modulesContainingBinds.insert(moduleOp);
+        symbols.containsBinds = true;
     });
   };
+  SmallVector<HWModuleOp> modulesToWalk;
   /// Collect any port marked as being referenced via symbol.
   auto collectPorts = [&](auto moduleOp) {
     auto numArgs = moduleOp.getNumArguments();
@@ -5663,7 +5752,7 @@ void SharedEmitterState::gatherFiles(bool separateModules) {
           // Build the IR cache.
           symbolCache.addDefinition(mod.getNameAttr(), mod);
           collectPorts(mod);
-          collectInstanceSymbolsAndBinds(mod);
+          modulesToWalk.push_back(mod);
 
           // Emit into a separate file named after the module.
           if (attr || separateModules)
@@ -5737,6 +5826,19 @@ void SharedEmitterState::gatherFiles(bool separateModules) {
         });
   }
 
+  // Collect the symbols in the module bodies in parallel, and add them to the
+  // cache in the order of the modules.
+  SmallVector<ModuleSymbols, 0> moduleSymbols(modulesToWalk.size());
+  parallelFor(designOp.getContext(), 0, modulesToWalk.size(), [&](size_t i) {
+    collectInstanceSymbolsAndBinds(modulesToWalk[i], moduleSymbols[i]);
+  });
+  for (auto [moduleOp, symbols] : llvm::zip(modulesToWalk, moduleSymbols)) {
+    for (auto [name, op] : symbols.innerNames)
+      symbolCache.addDefinition(moduleOp.getNameAttr(), name, op);
+    if (symbols.containsBinds)
+      modulesContainingBinds.insert(moduleOp);
+  }
+
   // We've built the whole symbol cache.  Freeze it so things can start
   // querying it (potentially concurrently).
   symbolCache.freeze();
@@ -5809,6 +5911,111 @@ static void emitOperation(VerilogEmitterState &state, Operation *op) {
       });
 }
 
+//===----------------------------------------------------------------------===//
+// Module Cache
+//===----------------------------------------------------------------------===//
+
+/// The flags with which operations are printed to compute cache keys.  The
+/// locations are included since they are emitted as comments.
+static OpPrintingFlags getCacheKeyPrintingFlags() {
+  return OpPrintingFlags()
+      .printGenericOpForm()
+      .enableDebugInfo()
+      .useLocalScope();
+}
+
+void SharedEmitterState::prepareModuleCache() {
+  if (moduleCacheDir.empty())
+    return;
+  if (auto error = llvm::sys::fs::create_directories(moduleCacheDir)) {
+    designOp.emitWarning() << "cannot create module cache directory '"
+                           << moduleCacheDir << "': " << error.message();
+    moduleCacheDir.clear();
+    return;
+  }
+
+  // The output of a module depends on the headers of the modules it
+  // instantiates, and on the other top-level operations it refers to, such as
+  // interfaces, macros and type declarations.  These rarely change, so rather
+  // than tracking the references of each module, all of them are covered.
+  llvm::raw_sha1_ostream hasher;
+  hasher << getCirctVersion() << '\0' << options.toString() << '\0';
+  for (auto &op : *designOp.getBody()) {
+    if (isa<HWModuleOp>(op))
+      hasher << op.getName() << op.getAttrDictionary() << '\n';
+    else
+      op.print(hasher, getCacheKeyPrintingFlags());
+  }
+  moduleCacheContext = toHex(hasher.sha1(), /*LowerCase=*/true);
+}
+
+/// Check whether the output of a module can be cached, which requires it to
+/// only depend on the module and the context covered by the cache key.
+/// References into other modules, directly or through hierarchical paths,
+/// are emitted with names from the bodies of those modules.  Modules with
+/// binds are emitted along with the bound instances.
+static bool isModuleOutputCacheable(HWModuleOp module,
+                                    const SharedEmitterState &shared) {
+  if (shared.modulesContainingBinds.count(module))
+    return false;
+  bool cacheable = true;
+  module.walk([&](Operation *op) {
+    op->getAttrDictionary().walk([&](Attribute attr) {
+      if (auto innerRef = dyn_cast<InnerRefAttr>(attr))
+        cacheable &= innerRef.getModule() == module.getNameAttr();
+      else if (auto ref = dyn_cast<FlatSymbolRefAttr>(attr))
+        cacheable &= !isa_and_nonnull<HierPathOp, GlobalRefOp>(
+            shared.symbolCache.getDefinition(ref));
+    });
+    return cacheable ? WalkResult::advance() : WalkResult::interrupt();
+  });
+  return cacheable;
+}
+
+/// Emit an operation, reusing the output of a hw.module from the module cache
+/// if the module did not change since it was cached.  The output of modules
+/// not found in the cache is stored in it.
+static void emitOperationWithCache(VerilogEmitterState &state, Operation *op) {
+  auto &shared = state.shared;
+  auto module = dyn_cast<HWModuleOp>(op);
+  if (shared.moduleCacheDir.empty() || !module ||
+      !isModuleOutputCacheable(module, shared))
+    return emitOperation(state, op);
+
+  llvm::raw_sha1_ostream hasher;
+  hasher << shared.moduleCacheContext;
+  module->print(hasher, getCacheKeyPrintingFlags());
+  SmallString<128> path(shared.moduleCacheDir);
+  llvm::sys::path::append(path,
+                          toHex(hasher.sha1(), /*LowerCase=*/true) + ".v");
+
+  if (auto cached = llvm::MemoryBuffer::getFile(path)) {
+    state.os << (*cached)->getBuffer();
+    ++shared.numReusedModules;
+    return;
+  }
+
+  SmallString<256> buffer;
+  llvm::raw_svector_ostream bufferStream(buffer);
+  VerilogEmitterState bufferState(state.designOp, shared, state.options,
+                                  state.symbolCache, state.globalNames,
+                                  bufferStream);
+  emitOperation(bufferState, op);
+  state.os << buffer;
+  if (bufferState.encounteredError) {
+    state.encounteredError = true;
+    return;
+  }
+
+  // Failing to update the cache only costs a later run the reuse of this
+  // module.  The file is renamed into place once written, such that
+  // concurrent runs never read a partially written output.
+  llvm::consumeError(llvm::writeToOutput(path, [&](raw_ostream &os) {
+    os << buffer;
+    return llvm::Error::success();
+  }));
+}
+
 /// Actually emit the collected list of operations and strings to the
 /// specified file.
 void SharedEmitterState::emitOps(EmissionList &thingsToEmit, raw_ostream &os,
@@ -5826,7 +6033,7 @@ void SharedEmitterState::emitOps(EmissionList &thingsToEmit, raw_ostream &os,
                               globalNames, os);
     for (auto &entry : thingsToEmit) {
       if (auto *op = entry.getOperation())
-        emitOperation(state, op);
+        emitOperationWithCache(state, op);
       else
         os << entry.getStringData();
     }
@@ -5837,40 +6044,71 @@ void SharedEmitterState::emitOps(EmissionList &thingsToEmit, raw_ostream &os,
   }
 
   // If we are parallelizing emission, we emit each independent operation to a
-  // string buffer in parallel, then concat at the end.
-  parallelForEach(context, thingsToEmit, [&](StringOrOpToEmit &stringOrOp) {
-    auto *op = stringOrOp.getOperation();
-    if (!op)
+  // string buffer on the thread pool, and stream the buffers to the output in
+  // order as soon as they are ready.  At most `emissionWindow` entries are
+  // emitted ahead of the output, which bounds the memory held by the buffers,
+  // and the output is written while later operations are still being emitted.
+  // The diagnostics are reported in the order of the entries.
+  llvm::ThreadPool &threadPool = context->getThreadPool();
+  ParallelDiagnosticHandler diagHandler(context);
+  size_t window = std::max<size_t>(emissionWindow, 1);
+  size_t numEntries = thingsToEmit.size();
+  SmallVector<std::shared_future<void>> inFlight(std::min(window, numEntries));
+
+  // BindOp emission reaches into the hw.module of the instance, and that body
+  // may be being transformed by its own emission.  These are emitted on the
+  // output thread once every other emission has finished.  They are speedy to
+  // emit anyway.
+  auto isSerial = [&](Operation *op) {
+    return isa<BindOp>(op) || modulesContainingBinds.count(op);
+  };
+  auto submit = [&](size_t index) {
+    auto *op = thingsToEmit[index].getOperation();
+    if (!op || isSerial(op))
       return; // Ignore things that are already strings.
+    inFlight[index % window] = threadPool.async([&, index, op] {
+      diagHandler.setOrderIDForThread(index);
+      SmallString<256> buffer;
+      llvm::raw_svector_ostream tmpStream(buffer);
+      VerilogEmitterState state(designOp, *this, options, symbolCache,
+                                globalNames, tmpStream);
+      emitOperationWithCache(state, op);
+      thingsToEmit[index].setString(buffer);
+      diagHandler.eraseOrderIDForThread();
+    });
+  };
+  auto wait = [&](size_t index) {
+    auto &future = inFlight[index % window];
+    if (future.valid()) {
+      future.wait();
+      future = {};
+    }
+  };
 
-    // BindOp emission reaches into the hw.module of the instance, and that
-    // body may be being transformed by its own emission.  Defer their
-    // emission to the serial phase.  They are speedy to emit anyway.
-    if (isa<BindOp>(op) || modulesContainingBinds.count(op))
-      return;
-
-    SmallString<256> buffer;
-    llvm::raw_svector_ostream tmpStream(buffer);
-    VerilogEmitterState state(designOp, *this, options, symbolCache,
-                              globalNames, tmpStream);
-    emitOperation(state, op);
-    stringOrOp.setString(buffer);
-  });
+  for (size_t index = 0, e = inFlight.size(); index != e; ++index)
+    submit(index);
 
-  // Finally emit each entry now that we know it is a string.
-  for (auto &entry : thingsToEmit) {
+  for (size_t index = 0; index != numEntries; ++index) {
+    wait(index);
     // Almost everything is lowered to a string, just concat the strings onto
-    // the output stream.
-    auto *op = entry.getOperation();
-    if (!op) {
+    // the output stream.  The entry is released once it has been written.
+    if (auto *op = thingsToEmit[index].getOperation()) {
+      // If this wasn't emitted to a string (e.g. it is a bind) do so now, once
+      // the entries emitted ahead of it are done.
+      for (size_t ahead = index + 1, e = std::min(index + window, numEntries);
+           ahead < e; ++ahead)
+        wait(ahead);
+      diagHandler.setOrderIDForThread(index);
+      VerilogEmitterState state(designOp, *this, options, symbolCache,
+                                globalNames, os);
+      emitOperation(state, op);
+      diagHandler.eraseOrderIDForThread();
+    } else {
+      StringOrOpToEmit entry(std::move(thingsToEmit[index]));
       os << entry.getStringData();
-      continue;
     }
-
-    // If this wasn't emitted to a string (e.g. it is a bind) do so now.
-    VerilogEmitterState state(designOp, *this, options, symbolCache,
-                              globalNames, os);
-    emitOperation(state, op);
+    if (index + window < numEntries)
+      submit(index + window);
   }
 }
 
@@ -5878,12 +6116,18 @@ void SharedEmitterState::emitOps(EmissionList &thingsToEmit, raw_ostream &os,
 // Unified Emitter
 //===----------------------------------------------------------------------===//
 
-static LogicalResult exportVerilogImpl(ModuleOp module, llvm::raw_ostream &os) {
+static LogicalResult exportVerilogImpl(ModuleOp module, llvm::raw_ostream &os,
+                                       unsigned emissionWindow,
+                                       StringRef moduleCacheDir = {},
+                                       unsigned *numReusedModules = nullptr) {
   LoweringOptions options(module);
   GlobalNameTable globalNames = legalizeGlobalNames(module, options);
 
   SharedEmitterState emitter(module, options, std::move(globalNames));
+  emitter.emissionWindow = emissionWindow;
+  emitter.moduleCacheDir = moduleCacheDir.str();
   emitter.gatherFiles(false);
+  emitter.prepareModuleCache();
 
   if (emitter.options.emitReplicatedOpsToHeader)
     module.emitWarning()
@@ -5914,6 +6158,8 @@ static LogicalResult exportVerilogImpl(ModuleOp module, llvm::raw_ostream &os) {
 
   // Finally, emit all the ops we collected.
   emitter.emitOps(list, os, /*parallelize=*/true);
+  if (numReusedModules)
+    *numReusedModules = emitter.numReusedModules;
   return failure(emitter.encounteredError);
 }
 
@@ -5925,13 +6171,16 @@ LogicalResult circt::exportVerilog(ModuleOp module, llvm::raw_ostream &os) {
           module->getContext(), modulesToPrepare,
           [&](auto op) { return prepareHWModule(op, options); })))
     return failure();
-  return exportVerilogImpl(module, os);
+  return exportVerilogImpl(module, os, defaultEmissionWindow);
 }
 
 namespace {
 
 struct ExportVerilogPass : public ExportVerilogBase<ExportVerilogPass> {
-  ExportVerilogPass(raw_ostream &os) : os(os) {}
+  ExportVerilogPass(raw_ostream &os, StringRef moduleCacheDir) : os(os) {
+    if (!moduleCacheDir.empty())
+      this->moduleCacheDir = moduleCacheDir.str();
+  }
   void runOnOperation() override {
     // Prepare the ops in the module for emission.
     mlir::OpPassManager preparePM("builtin.module");
@@ -5941,8 +6190,11 @@ struct ExportVerilogPass : public ExportVerilogBase<ExportVerilogPass> {
     if (failed(runPipeline(preparePM, getOperation())))
       return signalPassFailure();
 
-    if (failed(exportVerilogImpl(getOperation(), os)))
+    unsigned numReused = 0;
+    if (failed(exportVerilogImpl(getOperation(), os, emissionWindow,
+                                 moduleCacheDir, &numReused)))
       return signalPassFailure();
+    numReusedModules += numReused;
   }
 
 private:
@@ -5951,8 +6203,9 @@ private:
 } // end anonymous namespace
 
 std::unique_ptr<mlir::Pass>
-circt::createExportVerilogPass(llvm::raw_ostream &os) {
-  return std::make_unique<ExportVerilogPass>(os);
+circt::createExportVerilogPass(llvm::raw_ostream &os,
+                               StringRef moduleCacheDir) {
+  return std::make_unique<ExportVerilogPass>(os, moduleCacheDir);
 }
 
 std::unique_ptr<mlir::Pass> circt::createExportVerilogPass() {
@@ -5963,22 +6216,39 @@ std::unique_ptr<mlir::Pass> circt::createExportVerilogPass() {
 // Split Emitter
 //===----------------------------------------------------------------------===//
 
+/// Create the output directories of all the given files up front, such that
+/// each directory is only created once rather than once per file.
+static LogicalResult createOutputDirectories(ArrayRef<StringRef> fileNames,
+                                             StringRef dirname,
+                                             SharedEmitterState &emitter) {
+  llvm::StringSet<> outputDirs;
+  for (auto fileName : fileNames) {
+    SmallString<128> outputFilename(dirname);
+    appendPossiblyAbsolutePath(outputFilename, fileName);
+    auto outputDir = llvm::sys::path::parent_path(outputFilename);
+    if (!outputDirs.insert(outputDir).second)
+      continue;
+
+    // Create the output directory if needed.
+    std::error_code error = llvm::sys::fs::create_directories(outputDir);
+    if (error) {
+      emitter.designOp.emitError("cannot create output directory \"")
+          << outputDir << "\": " << error.message();
+      emitter.encounteredError = true;
+      return failure();
+    }
+  }
+  return success();
+}
+
+/// Open an output file.  Its directory must have been created by
+/// `createOutputDirectories`.
 static std::unique_ptr<llvm::ToolOutputFile>
 createOutputFile(StringRef fileName, StringRef dirname,
                  SharedEmitterState &emitter) {
   // Determine the output path from the output directory and filename.
   SmallString<128> outputFilename(dirname);
   appendPossiblyAbsolutePath(outputFilename, fileName);
-  auto outputDir = llvm::sys::path::parent_path(outputFilename);
-
-  // Create the output directory if needed.
-  std::error_code error = llvm::sys::fs::create_directories(outputDir);
-  if (error) {
-    emitter.designOp.emitError("cannot create output directory \"")
-        << outputDir << "\": " << error.message();
-    emitter.encounteredError = true;
-    return {};
-  }
 
   // Open the output file.
   std::string errorMessage;
@@ -5990,13 +6260,38 @@ createOutputFile(StringRef fileName, StringRef dirname,
   return output;
 }
 
-static void createSplitOutputFile(StringAttr fileName, FileInfo &file,
-                                  StringRef dirname,
-                                  SharedEmitterState &emitter) {
+/// Write `contents` to the file `fileName` in `dirname`.  If
+/// `onlyWriteChanged` is set and the file already holds exactly these contents,
+/// it is left untouched such that its modification time is preserved.  Returns
+/// true if the file was written.
+static bool writeOutputFile(StringRef fileName, StringRef dirname,
+                            StringRef contents, bool onlyWriteChanged,
+                            SharedEmitterState &emitter) {
+  if (onlyWriteChanged) {
+    SmallString<128> outputFilename(dirname);
+    appendPossiblyAbsolutePath(outputFilename, fileName);
+    uint64_t size;
+    if (!llvm::sys::fs::file_size(outputFilename, size) &&
+        size == contents.size()) {
+      auto existing = llvm::MemoryBuffer::getFile(
+          outputFilename, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+      if (existing && (*existing)->getBuffer() == contents)
+        return false;
+    }
+  }
+
   auto output = createOutputFile(fileName, dirname, emitter);
   if (!output)
-    return;
+    return false;
+  output->os() << contents;
+  output->keep();
+  return true;
+}
 
+/// Emit a file of the split output.  Returns true if the file was written.
+static bool createSplitOutputFile(StringAttr fileName, FileInfo &file,
+                                  StringRef dirname, bool onlyWriteChanged,
+                                  SharedEmitterState &emitter) {
   SharedEmitterState::EmissionList list;
   emitter.collectOpsForFile(file, list,
                             emitter.options.emitReplicatedOpsToHeader);
@@ -6004,13 +6299,21 @@ static void createSplitOutputFile(StringAttr fileName, FileInfo &file,
   // Emit the file, copying the global options into the individual module
   // state.  Don't parallelize emission of the ops within this file - we
   // already parallelize per-file emission and we pay a string copy overhead
-  // for parallelization.
-  emitter.emitOps(list, output->os(), /*parallelize=*/false);
-  output->keep();
+  // for parallelization.  The file is emitted to a buffer first, such that it
+  // is written with a single write, and can be compared to the existing file.
+  std::string contents;
+  llvm::raw_string_ostream os(contents);
+  emitter.emitOps(list, os, /*parallelize=*/false);
+  return writeOutputFile(fileName, dirname, os.str(), onlyWriteChanged,
+                         emitter);
 }
 
-static LogicalResult exportSplitVerilogImpl(ModuleOp module,
-                                            StringRef dirname) {
+/// The name of the manifest listing the files written by an incremental split
+/// emission.
+static constexpr StringLiteral changedFilesManifest = "changed-files.f";
+
+static LogicalResult exportSplitVerilogImpl(ModuleOp module, StringRef dirname,
+                                            bool onlyWriteChanged) {
   // Prepare the ops in the module for emission and legalize the names that will
   // end up in the output.
   LoweringOptions options(module);
@@ -6036,38 +6339,58 @@ static LogicalResult exportSplitVerilogImpl(ModuleOp module,
     }
   }
 
-  // Emit each file in parallel if context enables it.
-  parallelForEach(module->getContext(), emitter.files.begin(),
-                  emitter.files.end(), [&](auto &it) {
-                    createSplitOutputFile(it.first, it.second, dirname,
-                                          emitter);
-                  });
-
-  // Write the file list.
-  SmallString<128> filelistPath(dirname);
-  llvm::sys::path::append(filelistPath, "filelist.f");
-
-  std::string errorMessage;
-  auto output = mlir::openOutputFile(filelistPath, &errorMessage);
-  if (!output) {
-    module->emitError(errorMessage);
+  // Create all the output directories before emitting the files.
+  SmallVector<StringRef> outputFiles;
+  for (auto &it : emitter.files)
+    outputFiles.push_back(it.first.getValue());
+  for (auto &it : emitter.fileLists)
+    outputFiles.push_back(it.first());
+  outputFiles.push_back("filelist.f");
+  if (failed(createOutputDirectories(outputFiles, dirname, emitter)))
     return failure();
-  }
 
+  // Emit each file in parallel if context enables it.  Each file is emitted
+  // with its own emitter state and written by the thread that emitted it.
+  // Record which files were written for the manifest of changed files.
+  SmallVector<char> filesWritten(emitter.files.size());
+  parallelFor(module->getContext(), 0, emitter.files.size(), [&](size_t index) {
+    auto &it = *(emitter.files.begin() + index);
+    filesWritten[index] = createSplitOutputFile(it.first, it.second, dirname,
+                                                onlyWriteChanged, emitter);
+  });
+  SmallVector<StringRef> changedFiles;
+  for (auto [it, written] : llvm::zip(emitter.files, filesWritten))
+    if (written)
+      changedFiles.push_back(it.first.getValue());
+
+  // Write the file list.
+  std::string filelist;
   for (const auto &it : emitter.files) {
     if (it.second.addToFilelist)
-      output->os() << it.first.str() << "\n";
+      filelist += it.first.str() + "\n";
   }
-  output->keep();
+  if (writeOutputFile("filelist.f", dirname, filelist, onlyWriteChanged,
+                      emitter))
+    changedFiles.push_back("filelist.f");
 
   // Emit the filelists.
   for (auto &it : emitter.fileLists) {
-    auto output = createOutputFile(it.first(), dirname, emitter);
-    if (!output)
-      continue;
+    std::string contents;
     for (auto &name : it.second)
-      output->os() << name.str() << "\n";
-    output->keep();
+      contents += name.str() + "\n";
+    if (writeOutputFile(it.first(), dirname, contents, onlyWriteChanged,
+                        emitter))
+      changedFiles.push_back(it.first());
+  }
+
+  // Write the manifest of the files that were written by this run, such that
+  // downstream tools only have to process the files that actually changed.
+  if (onlyWriteChanged) {
+    std::string manifest;
+    for (auto name : changedFiles)
+      manifest += name.str() + "\n";
+    writeOutputFile(changedFilesManifest, dirname, manifest,
+                    /*onlyWriteChanged=*/false, emitter);
   }
 
   return failure(emitter.encounteredError);
@@ -6082,15 +6405,16 @@ LogicalResult circt::exportSplitVerilog(ModuleOp module, StringRef dirname) {
           [&](auto op) { return prepareHWModule(op, options); })))
     return failure();
 
-  return exportSplitVerilogImpl(module, dirname);
+  return exportSplitVerilogImpl(module, dirname, /*onlyWriteChanged=*/false);
 }
 
 namespace {
 
 struct ExportSplitVerilogPass
     : public ExportSplitVerilogBase<ExportSplitVerilogPass> {
-  ExportSplitVerilogPass(StringRef directory) {
+  ExportSplitVerilogPass(StringRef directory, bool onlyWriteChanged) {
     directoryName = directory.str();
+    this->onlyWriteChanged = onlyWriteChanged;
   }
   void runOnOperation() override {
     // Prepare the ops in the module for emission.
@@ -6100,13 +6424,15 @@ struct ExportSplitVerilogPass
     if (failed(runPipeline(preparePM, getOperation())))
       return signalPassFailure();
 
-    if (failed(exportSplitVerilogImpl(getOperation(), directoryName)))
+    if (failed(exportSplitVerilogImpl(getOperation(), directoryName,
+                                      onlyWriteChanged)))
       return signalPassFailure();
   }
 };
 } // end anonymous namespace
 
 std::unique_ptr<mlir::Pass>
-circt::createExportSplitVerilogPass(StringRef directory) {
-  return std::make_unique<ExportSplitVerilogPass>(directory);
+circt::createExportSplitVerilogPass(StringRef directory,
+                                   bool onlyWriteChanged) {
+  return std::make_unique<ExportSplitVerilogPass>(directory, onlyWriteChanged);
 }
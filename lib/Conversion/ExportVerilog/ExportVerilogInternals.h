@@ -218,6 +218,9 @@ private:
   size_t length;
 };
 
+/// The default number of entries emitted ahead of the output stream.
+static constexpr size_t defaultEmissionWindow = 1024;
+
 /// This class tracks the top-level state for the emitters, which is built and
 /// then shared across all per-file emissions that happen in parallel.
 struct SharedEmitterState {
@@ -256,16 +259,37 @@ struct SharedEmitterState {
   /// Information about renamed global symbols, parameters, etc.
   const GlobalNameTable globalNames;
 
+  /// The maximum number of entries emitted ahead of the output stream when
+  /// emission is parallelized.
+  size_t emissionWindow = defaultEmissionWindow;
+
+  /// The directory in which the output of each hw.module is cached, or empty
+  /// if module outputs are not cached.
+  std::string moduleCacheDir;
+
+  /// The hash of the parts of the design, other than the module itself, which
+  /// the output of a cached module depends on.  Set by `prepareModuleCache`.
+  std::string moduleCacheContext;
+
+  /// The number of modules whose output was reused from the module cache.
+  mutable std::atomic<unsigned> numReusedModules = {};
+
   explicit SharedEmitterState(ModuleOp designOp, const LoweringOptions &options,
                               GlobalNameTable globalNames)
       : designOp(designOp), options(options),
         globalNames(std::move(globalNames)) {}
   void gatherFiles(bool separateModules);
 
+  /// Create the module cache directory and compute `moduleCacheContext`.  This
+  /// needs the symbol cache built by `gatherFiles`.
+  void prepareModuleCache();
+
   using EmissionList = std::vector<StringOrOpToEmit>;
 
   void collectOpsForFile(const FileInfo &fileInfo, EmissionList &thingsToEmit,
                          bool emitHeader = false);
+  /// Emit the entries to the stream, in order.  When emission is
+  /// parallelized, the entries are released once they have been written.
   void emitOps(EmissionList &thingsToEmit, raw_ostream &os, bool parallelize);
 };
 
@@ -318,11 +342,19 @@ bool isZeroBitType(Type type);
 /// that uses it.
 bool isExpressionEmittedInline(Operation *op, const LoweringOptions &options);
 
+/// Counters describing the work done while preparing a module for emission.
+struct PrepareStatistics {
+  /// The number of expressions spilled to temporary wires or logic.
+  unsigned numSpilledWires = 0;
+};
+
 /// For each module we emit, do a prepass over the structure, pre-lowering and
-/// otherwise rewriting operations we don't want to emit.
+/// otherwise rewriting operations we don't want to emit.  If `stats` is
+/// non-null, the work done on the module is added to it.
 LogicalResult prepareHWModule(Block &block, const LoweringOptions &options);
 LogicalResult prepareHWModule(hw::HWModuleOp module,
-                              const LoweringOptions &options);
+                              const LoweringOptions &options,
+                              PrepareStatistics *stats = nullptr);
 
 void pruneZeroValuedLogic(hw::HWModuleOp module);
 
@@ -14,6 +14,7 @@
 #include "ExportVerilogInternals.h"
 #include "circt/Dialect/HW/HWAttributes.h"
 #include "circt/Dialect/HW/HWOps.h"
+#include "circt/Dialect/LTL/LTLOps.h"
 #include "circt/Support/LoweringOptions.h"
 #include "mlir/IR/Threading.h"
 #include "llvm/ADT/TypeSwitch.h"
@@ -100,11 +101,10 @@ public:
   GlobalNameTable takeGlobalNameTable() { return std::move(globalNameTable); }
 
 private:
-  /// Check to see if the port names of the specified module conflict with
-  /// keywords or themselves.  If so, add the replacement names to
-  /// globalNameTable.
-  void legalizeModuleNames(HWModuleOp module);
-  void legalizeInterfaceNames(InterfaceOp interface);
+  /// Check to see if the name of the specified module conflicts with other
+  /// global names or keywords.  If so, rename it.
+  void legalizeModuleName(HWModuleOp module);
+  void legalizeInterfaceName(InterfaceOp interface);
 
   // Gathers prefixes of enum types by inspecting typescopes in the module.
   void gatherEnumPrefixes(mlir::ModuleOp topLevel);
@@ -121,6 +121,16 @@ private:
 } // namespace ExportVerilog
 } // namespace circt
 
+/// Check whether an LTL expression is shared by multiple properties in the body
+/// of a module, in which case it is emitted as a named `sequence` or
+/// `property` declaration that its users refer to.
+static bool isSharedLTLExpression(Operation *op) {
+  if (op->getNumResults() != 1 || op->hasOneUse() || op->use_empty() ||
+      !isa<ltl::SequenceType, ltl::PropertyType>(op->getResult(0).getType()))
+    return false;
+  return isa<HWModuleOp>(op->getParentOp());
+}
+
 // This function legalizes local names in the given module.
 static void legalizeModuleLocalNames(HWModuleOp module,
                                      const LoweringOptions &options,
@@ -166,6 +176,14 @@ static void legalizeModuleLocalNames(HWModuleOp module,
             op, StringAttr::get(op->getContext(), getSymOpName(op)));
       } else if (auto forOp = dyn_cast<ForOp>(op)) {
         nameEntries.emplace_back(op, forOp.getInductionVarNameAttr());
+      } else if (isa<ltl::LTLDialect>(op->getDialect())) {
+        if (options.emitSharedLTLDeclarations && isSharedLTLExpression(op))
+          nameEntries.emplace_back(
+              op, StringAttr::get(op->getContext(),
+                                  isa<ltl::SequenceType>(
+                                      op->getResult(0).getType())
+                                      ? "_SEQ"
+                                      : "_PROP"));
       } else if (isa<AssertOp, AssumeOp, CoverOp, AssertConcurrentOp,
                      AssumeConcurrentOp, CoverConcurrentOp>(op)) {
         // Notice and renamify the labels on verification statements.
@@ -198,6 +216,38 @@ static void legalizeModuleLocalNames(HWModuleOp module,
   }
 }
 
+/// Check to see if the parameter names of the specified module conflict with
+/// keywords or themselves.  If so, add the original and replacement names to
+/// `renamedParams`.
+static void legalizeParameterNames(
+    HWModuleOp module,
+    SmallVectorImpl<std::pair<StringAttr, StringAttr>> &renamedParams) {
+  NameCollisionResolver nameResolver;
+  for (auto param : module.getParameters()) {
+    auto paramAttr = param.cast<ParamDeclAttr>();
+    auto newName = nameResolver.getLegalName(paramAttr.getName());
+    if (newName != paramAttr.getName().getValue())
+      renamedParams.push_back(
+          {paramAttr.getName(), StringAttr::get(module.getContext(), newName)});
+  }
+}
+
+/// Rename the signals and modports of the specified interface if they conflict
+/// with keywords or themselves.
+static void legalizeInterfaceLocalNames(InterfaceOp interface) {
+  MLIRContext *ctxt = interface.getContext();
+  auto verilogNameAttr = StringAttr::get(ctxt, "hw.verilogName");
+  NameCollisionResolver localNames;
+  for (auto &op : *interface.getBodyBlock()) {
+    if (isa<InterfaceSignalOp, InterfaceModportOp>(op)) {
+      auto name = SymbolTable::getSymbolName(&op).getValue();
+      auto newName = localNames.getLegalName(name);
+      if (newName != name)
+        op.setAttr(verilogNameAttr, StringAttr::get(ctxt, newName));
+    }
+  }
+}
+
 /// Construct a GlobalNameResolver and do the initial scan to populate and
 /// unique the module/interfaces and port/parameter names.
 GlobalNameResolver::GlobalNameResolver(mlir::ModuleOp topLevel,
@@ -218,19 +268,38 @@ GlobalNameResolver::GlobalNameResolver(mlir::ModuleOp topLevel,
     }
   }
 
-  // Legalize module and interface names.
-  for (auto &op : *topLevel.getBody()) {
+  // Legalize the names local to modules and interfaces in parallel.  These
+  // are the parameter names of modules, and the signal and modport names of
+  // interfaces.  The renamed parameters are recorded per module and merged
+  // into the global name table in order afterwards, which keeps the table
+  // deterministic.
+  SmallVector<Operation *> modulesAndInterfaces;
+  for (auto &op : *topLevel.getBody())
+    if (isa<HWModuleOp, InterfaceOp>(op))
+      modulesAndInterfaces.push_back(&op);
+  SmallVector<SmallVector<std::pair<StringAttr, StringAttr>, 0>> renamedParams(
+      modulesAndInterfaces.size());
+  mlir::parallelFor(
+      topLevel.getContext(), 0, modulesAndInterfaces.size(), [&](size_t i) {
+        auto *op = modulesAndInterfaces[i];
+        if (auto module = dyn_cast<HWModuleOp>(op))
+          legalizeParameterNames(module, renamedParams[i]);
+        else
+          legalizeInterfaceLocalNames(cast<InterfaceOp>(op));
+      });
+
+  // Legalize module and interface names.  These share the global namespace,
+  // so this is done serially in the order of the design.
+  for (auto [op, params] : llvm::zip(modulesAndInterfaces, renamedParams)) {
     if (auto module = dyn_cast<HWModuleOp>(op)) {
-      legalizeModuleNames(module);
+      legalizeModuleName(module);
+      for (auto [oldName, newName] : params)
+        globalNameTable.addRenamedParam(module, oldName, newName.getValue());
       continue;
     }
 
-    // Legalize the name of the interface itself, as well as any signals and
-    // modports within it.
-    if (auto interface = dyn_cast<InterfaceOp>(op)) {
-      legalizeInterfaceNames(interface);
-      continue;
-    }
+    // Legalize the name of the interface itself.
+    legalizeInterfaceName(cast<InterfaceOp>(op));
   }
 
   // Legalize names in HW modules parallelly.
@@ -260,10 +329,9 @@ void GlobalNameResolver::gatherEnumPrefixes(mlir::ModuleOp topLevel) {
   }
 }
 
-/// Check to see if the port names of the specified module conflict with
-/// keywords or themselves.  If so, add the replacement names to
-/// globalNameTable.
-void GlobalNameResolver::legalizeModuleNames(HWModuleOp module) {
+/// Check to see if the name of the specified module conflicts with other
+/// global names or keywords.  If so, rename it.
+void GlobalNameResolver::legalizeModuleName(HWModuleOp module) {
   MLIRContext *ctxt = module.getContext();
   // If the module's symbol itself conflicts, then set a "verilogName" attribute
   // on the module to reflect the name we need to use.
@@ -271,34 +339,14 @@ void GlobalNameResolver::legalizeModuleNames(HWModuleOp module) {
   auto newName = globalNameResolver.getLegalName(oldName);
   if (newName != oldName)
     module->setAttr("verilogName", StringAttr::get(ctxt, newName));
-
-  NameCollisionResolver nameResolver;
-  // Legalize the parameter names.
-  for (auto param : module.getParameters()) {
-    auto paramAttr = param.cast<ParamDeclAttr>();
-    auto newName = nameResolver.getLegalName(paramAttr.getName());
-    if (newName != paramAttr.getName().getValue())
-      globalNameTable.addRenamedParam(module, paramAttr.getName(), newName);
-  }
 }
 
-void GlobalNameResolver::legalizeInterfaceNames(InterfaceOp interface) {
+void GlobalNameResolver::legalizeInterfaceName(InterfaceOp interface) {
   MLIRContext *ctxt = interface.getContext();
   auto verilogNameAttr = StringAttr::get(ctxt, "hw.verilogName");
   auto newName = globalNameResolver.getLegalName(interface.getName());
   if (newName != interface.getName())
     interface->setAttr(verilogNameAttr, StringAttr::get(ctxt, newName));
-
-  NameCollisionResolver localNames;
-  // Rename signals and modports.
-  for (auto &op : *interface.getBodyBlock()) {
-    if (isa<InterfaceSignalOp, InterfaceModportOp>(op)) {
-      auto name = SymbolTable::getSymbolName(&op).getValue();
-      auto newName = localNames.getLegalName(name);
-      if (newName != name)
-        op.setAttr(verilogNameAttr, StringAttr::get(ctxt, newName));
-    }
-  }
 }
 
 //===----------------------------------------------------------------------===//
@@ -29,6 +29,7 @@
 #include "llvm/ADT/TypeSwitch.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
+#include <chrono>
 
 #define DEBUG_TYPE "prepare-for-emission"
 
@@ -667,7 +668,8 @@ bool EmittedExpressionStateManager::shouldSpillWireBasedOnState(Operation &op) {
 /// So this function walks and prettifies verilog IR with a heuristic method
 /// specified by `options.wireSpillingHeuristic` based on the structures.
 static void prettifyAfterLegalization(
-    Block &block, EmittedExpressionStateManager &expressionStateManager) {
+    Block &block, EmittedExpressionStateManager &expressionStateManager,
+    PrepareStatistics &stats) {
   // TODO: Handle procedural regions as well.
   if (block.getParentOp()->hasTrait<ProceduralRegion>())
     return;
@@ -677,6 +679,7 @@ static void prettifyAfterLegalization(
       continue;
     if (expressionStateManager.shouldSpillWireBasedOnState(op)) {
       lowerUsersToTemporaryWire(op);
+      ++stats.numSpilledWires;
       continue;
     }
   }
@@ -685,7 +688,8 @@ static void prettifyAfterLegalization(
     // If the operations has regions, visit each of the region bodies.
     for (auto &region : op.getRegions()) {
       if (!region.empty())
-        prettifyAfterLegalization(region.front(), expressionStateManager);
+        prettifyAfterLegalization(region.front(), expressionStateManager,
+                                  stats);
     }
   }
 }
@@ -783,7 +787,8 @@ static void applyWireLowerings(Block &block,
 /// For each module we emit, do a prepass over the structure, pre-lowering and
 /// otherwise rewriting operations we don't want to emit.
 static LogicalResult legalizeHWModule(Block &block,
-                                      const LoweringOptions &options) {
+                                      const LoweringOptions &options,
+                                      PrepareStatistics &stats) {
 
   // First step, check any nested blocks that exist in this region.  This walk
   // can pull things out to our level of the hierarchy.
@@ -791,7 +796,7 @@ static LogicalResult legalizeHWModule(Block &block,
     // If the operations has regions, prepare each of the region bodies.
     for (auto &region : op.getRegions()) {
       if (!region.empty())
-        if (failed(legalizeHWModule(region.front(), options)))
+        if (failed(legalizeHWModule(region.front(), options, stats)))
           return failure();
     }
   }
@@ -979,8 +984,10 @@ static LogicalResult legalizeHWModule(Block &block,
               (isProceduralRegion && hoistNonSideEffectExpr(&op))) {
             // If op is moved to a non-procedural region, create a temporary
             // wire.
-            if (!op.getParentOp()->hasTrait<ProceduralRegion>())
+            if (!op.getParentOp()->hasTrait<ProceduralRegion>()) {
               lowerUsersToTemporaryWire(op);
+              ++stats.numSpilledWires;
+            }
 
             // If we're in a procedural region, we move on to the next op in the
             // block. The expression splitting and canonicalization below will
@@ -994,6 +1001,7 @@ static LogicalResult legalizeHWModule(Block &block,
           // expression to automatic logic declarations even when the op is in a
           // procedural region.
           lowerUsersToTemporaryWire(op);
+          ++stats.numSpilledWires;
         }
       }
     }
@@ -1133,23 +1141,30 @@ static LogicalResult legalizeHWModule(Block &block,
     // Otherwise, we need to lower this to a wire to resolve this.
     lowerUsersToTemporaryWire(op,
                               /*emitWireAtBlockBegin=*/true);
+    ++stats.numSpilledWires;
   }
   return success();
 }
 
 // NOLINTNEXTLINE(misc-no-recursion)
 LogicalResult ExportVerilog::prepareHWModule(hw::HWModuleOp module,
-                                             const LoweringOptions &options) {
+                                             const LoweringOptions &options,
+                                             PrepareStatistics *stats) {
+  PrepareStatistics localStats;
+  if (!stats)
+    stats = &localStats;
+
   // Zero-valued logic pruning.
   pruneZeroValuedLogic(module);
 
   // Legalization.
-  if (failed(legalizeHWModule(*module.getBodyBlock(), options)))
+  if (failed(legalizeHWModule(*module.getBodyBlock(), options, *stats)))
     return failure();
 
   EmittedExpressionStateManager expressionStateManager(options);
   // Spill wires to prettify verilog outputs.
-  prettifyAfterLegalization(*module.getBodyBlock(), expressionStateManager);
+  prettifyAfterLegalization(*module.getBodyBlock(), expressionStateManager,
+                            *stats);
   return success();
 }
 
@@ -1160,7 +1175,22 @@ struct PrepareForEmissionPass
   void runOnOperation() override {
     HWModuleOp module = getOperation();
     LoweringOptions options(cast<mlir::ModuleOp>(module->getParentOp()));
-    if (failed(prepareHWModule(module, options)))
+    PrepareStatistics stats;
+    auto start = std::chrono::steady_clock::now();
+    auto result = prepareHWModule(module, options, &stats);
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+    // Report the cost of each module individually, such that modules which
+    // are disproportionately expensive to prepare can be found.
+    LLVM_DEBUG(llvm::dbgs() << "Prepared module " << module.getName() << " in "
+                            << elapsed << "us, spilling "
+                            << stats.numSpilledWires << " wires\n");
+    numModules++;
+    numSpilledWires += stats.numSpilledWires;
+    prepareTime += elapsed;
+    if (failed(result))
       signalPassFailure();
   }
 };
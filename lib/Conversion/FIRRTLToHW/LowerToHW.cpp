@@ -37,7 +37,6 @@
 #include "llvm/ADT/StringSet.h"
 #include "llvm/ADT/TinyPtrVector.h"
 #include "llvm/Support/FormatVariadic.h"
-#include "llvm/Support/Parallel.h"
 
 using namespace circt;
 using namespace firrtl;
@@ -179,20 +178,6 @@ static void moveVerifAnno(ModuleOp top, AnnotationSet &annos,
   }
 }
 
-static SmallVector<FirMemory>
-mergeFIRRTLMemories(const SmallVector<FirMemory> &lhs,
-                    SmallVector<FirMemory> rhs) {
-  if (rhs.empty())
-    return lhs;
-  // lhs is always sorted and uniqued
-  llvm::sort(rhs);
-  rhs.erase(std::unique(rhs.begin(), rhs.end()), rhs.end());
-  SmallVector<FirMemory> retval;
-  std::set_union(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
-                 std::back_inserter(retval));
-  return retval;
-}
-
 static unsigned getBitWidthFromVectorSize(unsigned size) {
   return size == 1 ? 1 : llvm::Log2_64_Ceil(size);
 }
@@ -343,8 +328,11 @@ private:
   hw::OutputFileAttr testBenchDirectory;
 
   /// A mapping of instances to their forced instantiation names (if
-  /// applicable).
+  /// applicable).  This is filled in while the module headers are lowered in
+  /// parallel, and must only be modified while holding
+  /// `instanceForceNamesMutex`.
   DenseMap<std::pair<Attribute, Attribute>, Attribute> instanceForceNames;
+  std::mutex instanceForceNamesMutex;
 
   /// Map of original FirMemory name to the Generated Op name. All the deduped
   /// memories have the same FirMemory name (because it is derived from the
@@ -410,6 +398,22 @@ void CircuitLoweringState::processRemainingAnnotations(
 }
 } // end anonymous namespace
 
+/// Collect all the memories in a module. Construct the FirMemory, set the DUT
+/// flag and also record the MemOp.
+static SmallVector<FirMemory>
+collectFIRRTLMemories(FModuleOp module, CircuitLoweringState &state) {
+  SmallVector<FirMemory> retval;
+  // Check if this module is in the DUT hierarchy.
+  bool isInDut = state.isInDUT(module);
+  for (auto op : module.getBodyBlock()->getOps<MemOp>()) {
+    auto sum = op.getSummary();
+    sum.isInDut = isInDut;
+    sum.op = op;
+    retval.push_back(sum);
+  }
+  return retval;
+}
+
 namespace {
 struct FIRRTLModuleLowering : public LowerFIRRTLToHWBase<FIRRTLModuleLowering> {
 
@@ -428,13 +432,11 @@ private:
                            CircuitLoweringState &loweringState);
   bool handleForceNameAnnos(FModuleLike oldModule, AnnotationSet &annos,
                             CircuitLoweringState &loweringState);
-  hw::HWModuleOp lowerModule(FModuleOp oldModule, Block *topLevelModule,
+  hw::HWModuleOp lowerModule(FModuleOp oldModule,
                              CircuitLoweringState &loweringState);
   hw::HWModuleExternOp lowerExtModule(FExtModuleOp oldModule,
-                                      Block *topLevelModule,
                                       CircuitLoweringState &loweringState);
   hw::HWModuleExternOp lowerMemModule(FMemModuleOp oldModule,
-                                      Block *topLevelModule,
                                       CircuitLoweringState &loweringState);
 
   LogicalResult lowerModuleBody(FModuleOp oldModule,
@@ -506,39 +508,56 @@ void FIRRTLModuleLowering::runOnOperation() {
       extractAssertAnnoClass, extractAssumeAnnoClass, extractCoverageAnnoClass);
 
   state.processRemainingAnnotations(circuit, circuitAnno);
-  // Iterate through each operation in the circuit body, transforming any
-  // FModule's we come across. If any module fails to lower, return early.
-  for (auto &op : make_early_inc_range(circuitBody->getOperations())) {
-    TypeSwitch<Operation *>(&op)
-        .Case<FModuleOp>([&](auto module) {
-          auto loweredMod = lowerModule(module, topLevelModule, state);
-          if (!loweredMod)
-            return signalPassFailure();
-
-          state.oldToNewModuleMap[&op] = loweredMod;
-          modulesToProcess.push_back(module);
-        })
-        .Case<FExtModuleOp>([&](auto extModule) {
-          auto loweredMod = lowerExtModule(extModule, topLevelModule, state);
-          if (!loweredMod)
-            return signalPassFailure();
-          state.oldToNewModuleMap[&op] = loweredMod;
-        })
-        .Case<FMemModuleOp>([&](auto memModule) {
-          auto loweredMod = lowerMemModule(memModule, topLevelModule, state);
-          if (!loweredMod)
-            return signalPassFailure();
-          state.oldToNewModuleMap[&op] = loweredMod;
-        })
-        .Default([&](Operation *op) {
-          // We don't know what this op is.  If it has no illegal FIRRTL types,
-          // we can forward the operation.  Otherwise, we emit an error and drop
-          // the operation from the circuit.
-          if (succeeded(verifyOpLegality(op)))
-            op->moveBefore(topLevelModule, topLevelModule->end());
-          else
-            return signalPassFailure();
-        });
+
+  // Create the new module headers in parallel.  The new modules are created
+  // detached, and are inserted into the top level module afterwards in the
+  // order of the circuit.  The memories of each module are collected at the
+  // same time, such that the modules are only walked once before their bodies
+  // are lowered.  `parallelFor` installs a `ParallelDiagnosticHandler`, so the
+  // errors and warnings emitted while lowering the headers are reported in
+  // the order of the circuit, just as when lowering them one at a time.
+  auto ops = llvm::to_vector(llvm::make_pointer_range(*circuitBody));
+  SmallVector<Operation *> loweredModules(ops.size());
+  SmallVector<SmallVector<FirMemory>> moduleMemories(ops.size());
+  mlir::parallelFor(&getContext(), 0, ops.size(), [&](size_t index) {
+    loweredModules[index] =
+        TypeSwitch<Operation *, Operation *>(ops[index])
+            .Case<FModuleOp>([&](auto module) -> Operation * {
+              auto loweredMod = lowerModule(module, state);
+              if (loweredMod)
+                moduleMemories[index] = collectFIRRTLMemories(module, state);
+              return loweredMod;
+            })
+            .Case<FExtModuleOp>([&](auto extModule) -> Operation * {
+              return lowerExtModule(extModule, state);
+            })
+            .Case<FMemModuleOp>([&](auto memModule) -> Operation * {
+              return lowerMemModule(memModule, state);
+            })
+            .Default([](Operation *) -> Operation * { return nullptr; });
+  });
+
+  // Iterate through each operation in the circuit body, inserting the lowered
+  // modules. If any module failed to lower, the pass fails.
+  for (auto [op, loweredMod] : llvm::zip(ops, loweredModules)) {
+    if (isa<FModuleOp, FExtModuleOp, FMemModuleOp>(op)) {
+      if (!loweredMod) {
+        signalPassFailure();
+        continue;
+      }
+      topLevelModule->push_back(loweredMod);
+      state.oldToNewModuleMap[op] = loweredMod;
+      if (auto module = dyn_cast<FModuleOp>(op))
+        modulesToProcess.push_back(module);
+      continue;
+    }
+    // We don't know what this op is.  If it has no illegal FIRRTL types, we
+    // can forward the operation.  Otherwise, we emit an error and drop the
+    // operation from the circuit.
+    if (succeeded(verifyOpLegality(op)))
+      op->moveBefore(topLevelModule, topLevelModule->end());
+    else
+      signalPassFailure();
   }
   // Handle the creation of the module hierarchy metadata.
 
@@ -580,40 +599,22 @@ void FIRRTLModuleLowering::runOnOperation() {
         moduleHierarchyFileAttrName,
         ArrayAttr::get(&getContext(), testHarnessHierarchyFiles));
 
-  // Collect all the memories in the module. Construct the FirMemory, set the
-  // DUT flag and also record the Memop.
-  auto collectFIRRTLMemories =
-      [&state](FModuleOp module) -> SmallVector<FirMemory> {
-    SmallVector<FirMemory> retval;
-    // Check if this module is in the DUT hierarchy.
-    bool isInDut = state.isInDUT(module);
-    for (auto op : module.getBodyBlock()->getOps<MemOp>()) {
-      auto sum = op.getSummary();
-      sum.isInDut = isInDut;
-      sum.op = op;
-      retval.push_back(sum);
-    }
-    return retval;
-  };
-
-  // 1. First collect the memories as FirMemory, set the DUT flag and also
-  // record the MemOp.
-  // 2. Then Dedup the memories using the mergeFIRRTLMemories routine. This uses
-  // the memory parameters to merge memories with the exactly same parameters.
+  // 1. The memories were collected as FirMemory along with the module
+  // headers, with the DUT flag set and the MemOp recorded.
+  // 2. Then Dedup the memories.  This uses the memory parameters to merge
+  // memories with the exactly same parameters.  The stable sort keeps the
+  // first memory in circuit order for each set of parameters.
   // 3. Then For each of the deduped memories, create the HWModuleGeneratedOp,
   // and assign a unique name to the wrapper module based on the MemOp name. It
   // is important to use the MemOp name because appropriate prefixes have to be
   // respected, also the correct output directory needs to be set based on the
   // DUT or testbench hierarchy.
   SmallVector<FirMemory> memories;
-  if (getContext().isMultithreadingEnabled()) {
-    memories = llvm::parallelTransformReduce(
-        modulesToProcess.begin(), modulesToProcess.end(),
-        SmallVector<FirMemory>(), mergeFIRRTLMemories, collectFIRRTLMemories);
-  } else {
-    for (auto m : modulesToProcess)
-      memories = mergeFIRRTLMemories(memories, collectFIRRTLMemories(m));
-  }
+  for (auto &mems : moduleMemories)
+    memories.append(mems.begin(), mems.end());
+  std::stable_sort(memories.begin(), memories.end());
+  memories.erase(std::unique(memories.begin(), memories.end()),
+                 memories.end());
   if (!memories.empty())
     lowerMemoryDecls(memories, state);
 
@@ -1098,6 +1099,7 @@ bool FIRRTLModuleLowering::handleForceNameAnnos(
     // be applied.
     auto inst =
         nla.getNamepath().getValue().take_back(2)[0].cast<hw::InnerRefAttr>();
+    std::lock_guard<std::mutex> lock(loweringState.instanceForceNamesMutex);
     auto inserted = loweringState.instanceForceNames.insert(
         {{inst.getModule(), inst.getName()}, anno.getMember("name")});
     if (!inserted.second &&
@@ -1118,7 +1120,6 @@ bool FIRRTLModuleLowering::handleForceNameAnnos(
 
 hw::HWModuleExternOp
 FIRRTLModuleLowering::lowerExtModule(FExtModuleOp oldModule,
-                                     Block *topLevelModule,
                                      CircuitLoweringState &loweringState) {
   // Map the ports over, lowering their types as we go.
   SmallVector<PortInfo> firrtlPorts = oldModule.getPorts();
@@ -1131,8 +1132,9 @@ FIRRTLModuleLowering::lowerExtModule(FExtModuleOp oldModule,
   if (auto defName = oldModule.getDefname())
     verilogName = defName.value();
 
-  // Build the new hw.module op.
-  auto builder = OpBuilder::atBlockEnd(topLevelModule);
+  // Build the new hw.module op.  It is created detached, and is inserted into
+  // the top level module by the caller.
+  OpBuilder builder(oldModule.getContext());
   auto nameAttr = builder.getStringAttr(oldModule.getName());
   // Map over parameters if present.  Drop all values as we do so, so there are
   // no known default values in the extmodule.  This ensures that the
@@ -1151,8 +1153,10 @@ FIRRTLModuleLowering::lowerExtModule(FExtModuleOp oldModule,
     newModule->setAttr("firrtl.extract.cover.extra", builder.getUnitAttr());
 
   AnnotationSet annos(oldModule);
-  if (handleForceNameAnnos(oldModule, annos, loweringState))
+  if (handleForceNameAnnos(oldModule, annos, loweringState)) {
+    newModule.erase();
     return {};
+  }
 
   loweringState.processRemainingAnnotations(oldModule, annos);
   return newModule;
@@ -1160,7 +1164,6 @@ FIRRTLModuleLowering::lowerExtModule(FExtModuleOp oldModule,
 
 hw::HWModuleExternOp
 FIRRTLModuleLowering::lowerMemModule(FMemModuleOp oldModule,
-                                     Block *topLevelModule,
                                      CircuitLoweringState &loweringState) {
   // Map the ports over, lowering their types as we go.
   SmallVector<PortInfo> firrtlPorts = oldModule.getPorts();
@@ -1169,8 +1172,9 @@ FIRRTLModuleLowering::lowerMemModule(FMemModuleOp oldModule,
                         loweringState)))
     return {};
 
-  // Build the new hw.module op.
-  auto builder = OpBuilder::atBlockEnd(topLevelModule);
+  // Build the new hw.module op.  It is created detached, and is inserted into
+  // the top level module by the caller.
+  OpBuilder builder(oldModule.getContext());
   auto newModule = builder.create<hw::HWModuleExternOp>(
       oldModule.getLoc(), oldModule.getModuleNameAttr(), ports,
       oldModule.getModuleNameAttr());
@@ -1182,7 +1186,7 @@ FIRRTLModuleLowering::lowerMemModule(FMemModuleOp oldModule,
 /// Run on each firrtl.module, transforming it from an firrtl.module into an
 /// hw.module, then deleting the old one.
 hw::HWModuleOp
-FIRRTLModuleLowering::lowerModule(FModuleOp oldModule, Block *topLevelModule,
+FIRRTLModuleLowering::lowerModule(FModuleOp oldModule,
                                   CircuitLoweringState &loweringState) {
   // Map the ports over, lowering their types as we go.
   SmallVector<PortInfo> firrtlPorts = oldModule.getPorts();
@@ -1191,8 +1195,9 @@ FIRRTLModuleLowering::lowerModule(FModuleOp oldModule, Block *topLevelModule,
                         loweringState)))
     return {};
 
-  // Build the new hw.module op.
-  auto builder = OpBuilder::atBlockEnd(topLevelModule);
+  // Build the new hw.module op.  It is created detached, and is inserted into
+  // the top level module by the caller.
+  OpBuilder builder(oldModule.getContext());
   auto nameAttr = builder.getStringAttr(oldModule.getName());
   auto newModule =
       builder.create<hw::HWModuleOp>(oldModule.getLoc(), nameAttr, ports);
@@ -1230,8 +1235,10 @@ FIRRTLModuleLowering::lowerModule(FModuleOp oldModule, Block *topLevelModule,
           builder.getStringAttr("VCS coverage exclude_file"));
     }
 
-  if (handleForceNameAnnos(oldModule, annos, loweringState))
+  if (handleForceNameAnnos(oldModule, annos, loweringState)) {
+    newModule.erase();
     return {};
+  }
 
   loweringState.processRemainingAnnotations(oldModule, annos);
   return newModule;
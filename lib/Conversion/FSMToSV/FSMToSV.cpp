@@ -14,7 +14,10 @@
 #include "circt/Dialect/SV/SVOps.h"
 #include "circt/Dialect/Seq/SeqOps.h"
 #include "circt/Support/BackedgeBuilder.h"
+#include "circt/Support/ExpressionInfo.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
 #include "mlir/Transforms/RegionUtils.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/TypeSwitch.h"
 
 #include <memory>
@@ -80,6 +83,21 @@ static void cloneConstantsIntoRegion(Region &region, OpBuilder &builder) {
   }
 }
 
+/// Pick a state encoding for a machine. One-hot encoding trades register bits
+/// for shallow next-state and output decode logic. This pays off once the
+/// machine branches enough for the binary decode logic to get deep, and until
+/// the register gets too wide.
+static FSMStateEncoding chooseStateEncoding(MachineOp machine) {
+  size_t numStates = machine.getNumStates();
+  size_t numTransitions = 0;
+  for (auto state : machine.getBody().getOps<StateOp>())
+    numTransitions +=
+        llvm::range_size(state.getTransitions().getOps<TransitionOp>());
+  if (numStates > 4 && numStates <= 32 && numTransitions > numStates)
+    return FSMStateEncoding::OneHot;
+  return FSMStateEncoding::Binary;
+}
+
 namespace {
 
 class StateEncoding {
@@ -89,7 +107,7 @@ class StateEncoding {
 
 public:
   StateEncoding(OpBuilder &b, hw::TypeScopeOp typeScope, MachineOp machine,
-                hw::HWModuleOp hwModule);
+                hw::HWModuleOp hwModule, FSMStateEncoding kind);
 
   // Get the encoded value for a state.
   Value encode(StateOp state);
@@ -102,7 +120,19 @@ public:
   // Returns a case pattern which matches the provided state.
   std::unique_ptr<sv::CasePattern> getCasePattern(StateOp state);
 
+  // Returns the style of the case statements that select on the state.
+  CaseStmtType getCaseStyle() {
+    return kind == FSMStateEncoding::OneHot ? CaseStmtType::CaseZStmt
+                                            : CaseStmtType::CaseStmt;
+  }
+
 protected:
+  // Creates an enum typedef for the states and enum constants for each state.
+  void createEnumEncoding();
+
+  // Creates an integer constant for each state.
+  void createIntegerEncoding();
+
   // Creates a constant value in the module for the given encoded state
   // and records the state value in the mappings. An inner symbol is
   // attached to the wire to avoid it being optimized away.
@@ -123,17 +153,34 @@ protected:
   // A typescope to emit the FSM enum type within.
   hw::TypeScopeOp typeScope;
 
-  // The enum type for the states.
+  // The enum or integer type for the states.
   Type stateType;
 
+  // The encoding of the states. This is never `Auto`.
+  FSMStateEncoding kind;
+
+  // The index of each state in the machine, for integer encodings.
+  SmallDenseMap<StateOp, unsigned> stateIndices;
+
   OpBuilder &b;
   MachineOp machine;
   hw::HWModuleOp hwModule;
 };
 
 StateEncoding::StateEncoding(OpBuilder &b, hw::TypeScopeOp typeScope,
-                             MachineOp machine, hw::HWModuleOp hwModule)
-    : typeScope(typeScope), b(b), machine(machine), hwModule(hwModule) {
+                             MachineOp machine, hw::HWModuleOp hwModule,
+                             FSMStateEncoding kind)
+    : typeScope(typeScope), kind(kind), b(b), machine(machine),
+      hwModule(hwModule) {
+  if (kind == FSMStateEncoding::Auto)
+    this->kind = chooseStateEncoding(machine);
+  if (this->kind == FSMStateEncoding::Enum)
+    createEnumEncoding();
+  else
+    createIntegerEncoding();
+}
+
+void StateEncoding::createEnumEncoding() {
   Location loc = machine.getLoc();
   llvm::SmallVector<Attribute> stateNames;
 
@@ -167,6 +214,30 @@ StateEncoding::StateEncoding(OpBuilder &b, hw::TypeScopeOp typeScope,
   }
 }
 
+void StateEncoding::createIntegerEncoding() {
+  Location loc = machine.getLoc();
+  unsigned numStates = machine.getNumStates();
+  unsigned width = kind == FSMStateEncoding::OneHot
+                       ? numStates
+                       : std::max(1u, llvm::Log2_32_Ceil(numStates));
+  stateType = b.getIntegerType(width);
+
+  OpBuilder::InsertionGuard guard(b);
+  b.setInsertionPointToStart(&hwModule.getBody().front());
+  for (auto [index, state] :
+       llvm::enumerate(machine.getBody().getOps<StateOp>())) {
+    APInt value;
+    if (kind == FSMStateEncoding::OneHot)
+      value = APInt::getOneBitSet(width, index);
+    else if (kind == FSMStateEncoding::Gray)
+      value = APInt(width, index ^ (index >> 1));
+    else
+      value = APInt(width, index);
+    stateIndices[state] = index;
+    setEncoding(state, b.create<hw::ConstantOp>(loc, value), /*wire=*/true);
+  }
+}
+
 // Get the encoded value for a state.
 Value StateEncoding::encode(StateOp state) {
   auto it = stateToValue.find(state);
@@ -182,6 +253,23 @@ StateOp StateEncoding::decode(Value value) {
 
 // Returns a case pattern which matches the provided state.
 std::unique_ptr<sv::CasePattern> StateEncoding::getCasePattern(StateOp state) {
+  // A one-hot encoded state is identified by its bit alone, which keeps the
+  // decode logic of each case independent of the other bits.
+  if (kind == FSMStateEncoding::OneHot) {
+    SmallVector<sv::CasePatternBit> bits(machine.getNumStates(),
+                                         sv::CasePatternBit::AnyZ);
+    bits[stateIndices.lookup(state)] = sv::CasePatternBit::One;
+    return std::make_unique<sv::CaseBitPattern>(bits, b.getContext());
+  }
+
+  // Integer encodings match the constant of the state.
+  if (kind != FSMStateEncoding::Enum) {
+    auto constOp = cast<hw::ConstantOp>(
+        valueToSrcValue[encode(state)].getDefiningOp());
+    return std::make_unique<sv::CaseBitPattern>(constOp.getValue(),
+                                                b.getContext());
+  }
+
   // Get the field attribute for the state - fetch it through the encoding.
   auto fieldAttr =
       cast<hw::EnumConstantOp>(valueToSrcValue[encode(state)].getDefiningOp())
@@ -212,8 +300,9 @@ void StateEncoding::setEncoding(StateOp state, Value v, bool wire) {
 class MachineOpConverter {
 public:
   MachineOpConverter(OpBuilder &builder, hw::TypeScopeOp typeScope,
-                     MachineOp machineOp)
-      : machineOp(machineOp), typeScope(typeScope), b(builder) {}
+                     MachineOp machineOp, FSMStateEncoding stateEncoding)
+      : machineOp(machineOp), typeScope(typeScope),
+        stateEncoding(stateEncoding), b(builder) {}
 
   // Converts the machine op to a hardware module.
   // 1. Creates a HWModuleOp for the machine op, with the same I/O as the FSM +
@@ -259,10 +348,12 @@ private:
   // Moves operations from 'block' into module scope, failing if any op were
   // deemed illegal. Returns the final op in the block if the op was a
   // terminator. An optional 'exclude' filer can be provided to dynamically
-  // exclude some ops from being moved.
+  // exclude some ops from being moved. If 'share' is set, side-effect free ops
+  // that are equivalent to an op moved with 'share' before are replaced by
+  // that op instead of being moved.
   FailureOr<Operation *>
-  moveOps(Block *block,
-          llvm::function_ref<bool(Operation *)> exclude = nullptr);
+  moveOps(Block *block, llvm::function_ref<bool(Operation *)> exclude = nullptr,
+          bool share = false);
 
   struct CaseMuxItem;
   using StateCaseMapping =
@@ -320,12 +411,24 @@ private:
   // A typescope to emit the FSM enum type within.
   hw::TypeScopeOp typeScope;
 
+  // The requested encoding of the states.
+  FSMStateEncoding stateEncoding;
+
+  // The guard ops that have been moved into the module, such that equivalent
+  // guards of other transitions can reuse them.
+  llvm::DenseSet<Operation *, ExpressionInfo> sharedGuardOps;
+
+  // The next-state muxes created for transitions, keyed by their guard and
+  // the two next states they select between.
+  DenseMap<std::tuple<Value, Value, Value>, Value> nextStateMuxes;
+
   OpBuilder &b;
 };
 
 FailureOr<Operation *>
 MachineOpConverter::moveOps(Block *block,
-                            llvm::function_ref<bool(Operation *)> exclude) {
+                            llvm::function_ref<bool(Operation *)> exclude,
+                            bool share) {
   for (auto &op : llvm::make_early_inc_range(*block)) {
     if (!isa<comb::CombDialect, hw::HWDialect, fsm::FSMDialect>(
             op.getDialect()))
@@ -339,6 +442,18 @@ MachineOpConverter::moveOps(Block *block,
     if (op.hasTrait<OpTrait::IsTerminator>())
       return &op;
 
+    if (share && op.getNumRegions() == 0 && isMemoryEffectFree(&op)) {
+      auto it = sharedGuardOps.find(&op);
+      if (it != sharedGuardOps.end()) {
+        op.replaceAllUsesWith(*it);
+        op.erase();
+        continue;
+      }
+      op.moveBefore(&hwModuleOp.front(), b.getInsertionPoint());
+      sharedGuardOps.insert(&op);
+      continue;
+    }
+
     op.moveBefore(&hwModuleOp.front(), b.getInsertionPoint());
   }
   return nullptr;
@@ -365,7 +480,7 @@ void MachineOpConverter::buildStateCaseMux(
 
   // Case assignments.
   caseMux = b.create<sv::CaseOp>(
-      machineOp.getLoc(), CaseStmtType::CaseStmt,
+      machineOp.getLoc(), encoding->getCaseStyle(),
       /*sv::ValidationQualifierTypeEnum::ValidationQualifierUnique, */ select,
       /*numCases=*/machineOp.getNumStates() + 1, [&](size_t caseIdx) {
         // Make Verilator happy for sized enums.
@@ -427,8 +542,8 @@ LogicalResult MachineOpConverter::dispatch() {
   auto reset = hwModuleOp.front().getArgument(clkRstIdxs.resetIdx);
 
   // 2) Build state and variable registers.
-  encoding =
-      std::make_unique<StateEncoding>(b, typeScope, machineOp, hwModuleOp);
+  encoding = std::make_unique<StateEncoding>(b, typeScope, machineOp,
+                                             hwModuleOp, stateEncoding);
   auto stateType = encoding->getStateType();
 
   auto nextStateWire =
@@ -615,7 +730,8 @@ MachineOpConverter::convertTransitions( // NOLINT(misc-no-recursion)
     if (transition.hasGuard()) {
       // Not always taken; recurse and mux between the targeted next state and
       // the recursion result, selecting based on the provided guard.
-      auto guardOpRes = moveOps(&transition.getGuard().front());
+      auto guardOpRes =
+          moveOps(&transition.getGuard().front(), nullptr, /*share=*/true);
       if (failed(guardOpRes))
         return failure();
 
@@ -626,8 +742,12 @@ MachineOpConverter::convertTransitions( // NOLINT(misc-no-recursion)
           convertTransitions(currentState, transitions.drop_front());
       if (failed(otherNextState))
         return failure();
-      comb::MuxOp nextStateMux = b.create<comb::MuxOp>(
-          transition.getLoc(), guard, nextState, *otherNextState, false);
+      // Transitions with the same guard and next states share their mux.
+      auto &nextStateMux =
+          nextStateMuxes[std::make_tuple(guard, nextState, *otherNextState)];
+      if (!nextStateMux)
+        nextStateMux = b.create<comb::MuxOp>(transition.getLoc(), guard,
+                                             nextState, *otherNextState, false);
       nextState = nextStateMux;
     }
   }
@@ -663,6 +783,7 @@ MachineOpConverter::convertState(StateOp state) {
 }
 
 struct FSMToSVPass : public ConvertFSMToSVBase<FSMToSVPass> {
+  using ConvertFSMToSVBase::stateEncoding;
   void runOnOperation() override;
 };
 
@@ -687,7 +808,7 @@ void FSMToSVPass::runOnOperation() {
 
   // Traverse all machines and convert.
   for (auto machine : llvm::make_early_inc_range(module.getOps<MachineOp>())) {
-    MachineOpConverter converter(b, typeScope, machine);
+    MachineOpConverter converter(b, typeScope, machine, stateEncoding);
 
     if (failed(converter.dispatch())) {
       signalPassFailure();
@@ -729,6 +850,9 @@ void FSMToSVPass::runOnOperation() {
 
 } // end anonymous namespace
 
-std::unique_ptr<mlir::Pass> circt::createConvertFSMToSVPass() {
-  return std::make_unique<FSMToSVPass>();
+std::unique_ptr<mlir::Pass>
+circt::createConvertFSMToSVPass(FSMStateEncoding encoding) {
+  auto pass = std::make_unique<FSMToSVPass>();
+  pass->stateEncoding = encoding;
+  return pass;
 }
@@ -25,6 +25,7 @@
 #include "mlir/Dialect/Arith/IR/Arith.h"
 #include "mlir/Dialect/MemRef/IR/MemRef.h"
 #include "mlir/IR/ImplicitLocOpBuilder.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/Pass/PassManager.h"
 #include "mlir/Transforms/DialectConversion.h"
 #include "llvm/ADT/TypeSwitch.h"
@@ -49,6 +50,9 @@ static Type tupleToStruct(TypeRange types) {
 struct HandshakeLoweringState {
   ModuleOp parentModule;
   NameUniquer nameUniquer;
+  // Build the logic of each operation in place of the operation, rather than
+  // in a submodule which is instantiated.
+  bool flatten = false;
 };
 
 // A type converter is needed to perform the in-flight materialization of "raw"
@@ -725,6 +729,11 @@ public:
   matchAndRewrite(T op, OpAdaptor adaptor,
                   ConversionPatternRewriter &rewriter) const override {
 
+    // Instances of other functions always refer to the module of the
+    // function.
+    if (ls.flatten && !isa<handshake::InstanceOp>(op.getOperation()))
+      return buildInPlace(op, adaptor, rewriter);
+
     // Check if a submodule has already been created for the op. If so,
     // instantiate the submodule. Else, run the pattern-defined module
     // builder.
@@ -761,6 +770,31 @@ public:
   virtual void buildModule(T op, BackedgeBuilder &bb, RTLBuilder &builder,
                            hw::HWModulePortAccessor &ports) const = 0;
 
+  // Runs the pattern-defined module builder in place of the op, with the
+  // operands of the op as the input ports, and replaces the op with the
+  // output ports.
+  LogicalResult buildInPlace(T op, OpAdaptor adaptor,
+                             ConversionPatternRewriter &rewriter) const {
+    auto portInfo = ModulePortInfo(getPortInfoForOp(op));
+    llvm::SmallVector<Value> inputs = adaptor.getOperands();
+    addSequentialIOOperandsIfNeeded(op, inputs);
+    hw::HWModulePortAccessor ports(op.getLoc(), portInfo, inputs);
+
+    Value clk, rst;
+    if (op->template hasTrait<mlir::OpTrait::HasClock>()) {
+      clk = ports.getInput("clock");
+      rst = ports.getInput("reset");
+    }
+
+    {
+      BackedgeBuilder bb(rewriter, op.getLoc());
+      RTLBuilder s(portInfo, rewriter, op.getLoc(), clk, rst);
+      this->buildModule(op, bb, s, ports);
+    }
+    rewriter.replaceOp(op, ports.getOutputOperands());
+    return success();
+  }
+
   // Syntactic sugar functions.
   // Unwraps an ESI-interfaced module into its constituent handshake signals.
   // Backedges are created for the to-be-resolved signals, and output ports
@@ -1843,7 +1877,7 @@ public:
 static LogicalResult convertFuncOp(ESITypeConverter &typeConverter,
                                    ConversionTarget &target,
                                    handshake::FuncOp op,
-                                   OpBuilder &moduleBuilder) {
+                                   OpBuilder &moduleBuilder, bool flatten) {
 
   std::map<std::string, unsigned> instanceNameCntr;
   NameUniquer instanceUniquer = [&](Operation *op) {
@@ -1860,7 +1894,7 @@ static LogicalResult convertFuncOp(ESITypeConverter &typeConverter,
   };
 
   auto ls = HandshakeLoweringState{op->getParentOfType<mlir::ModuleOp>(),
-                                   instanceUniquer};
+                                   instanceUniquer, flatten};
   RewritePatternSet patterns(op.getContext());
   patterns.insert<FuncOpConversionPattern, ReturnConversionPattern>(
       op.getContext());
@@ -1905,6 +1939,23 @@ static LogicalResult convertFuncOp(ESITypeConverter &typeConverter,
   return success();
 }
 
+/// Connects the operations of a flattened module which communicate through a
+/// channel directly, i.e. replaces each channel which is wrapped and unwrapped
+/// within the module by its valid, ready and data signals.
+static void removeInternalChannels(hw::HWModuleOp mod) {
+  for (auto unwrap : llvm::make_early_inc_range(
+           mod.getBodyBlock()->getOps<esi::UnwrapValidReadyOp>())) {
+    auto wrap = unwrap.getChanInput().getDefiningOp<esi::WrapValidReadyOp>();
+    if (!wrap || !wrap.getChanOutput().hasOneUse())
+      continue;
+    unwrap.getRawOutput().replaceAllUsesWith(wrap.getRawInput());
+    unwrap.getValid().replaceAllUsesWith(wrap.getValid());
+    wrap.getReady().replaceAllUsesWith(unwrap.getReady());
+    unwrap.erase();
+    wrap.erase();
+  }
+}
+
 namespace {
 class HandshakeToHWPass : public HandshakeToHWBase<HandshakeToHWPass> {
 public:
@@ -1940,6 +1991,11 @@ public:
                       hw::InstanceOp>();
     target
         .addIllegalDialect<handshake::HandshakeDialect, arith::ArithDialect>();
+    // Flattening builds the logic of the operations within the modules being
+    // converted.
+    if (flatten)
+      target.addLegalDialect<hw::HWDialect, comb::CombDialect,
+                             seq::SeqDialect, esi::ESIDialect>();
 
     // Convert the handshake.func operations in post-order wrt. the instance
     // graph. This ensures that any referenced submodules (through
@@ -1950,8 +2006,8 @@ public:
     for (auto &funcName : llvm::reverse(sortedFuncs)) {
       auto funcOp = mod.lookupSymbol<handshake::FuncOp>(funcName);
       assert(funcOp && "handshake.func not found in module!");
-      if (failed(
-              convertFuncOp(typeConverter, target, funcOp, submoduleBuilder))) {
+      if (failed(convertFuncOp(typeConverter, target, funcOp, submoduleBuilder,
+                               flatten))) {
         signalPassFailure();
         return;
       }
@@ -1962,6 +2018,17 @@ public:
     for (auto hwModule : mod.getOps<hw::HWModuleOp>())
       if (failed(convertExtMemoryOps(hwModule)))
         return signalPassFailure();
+
+    // The modules of the functions are independent of each other once
+    // converted, so the channels within them are removed in parallel.
+    if (flatten) {
+      SmallVector<hw::HWModuleOp> flatModules;
+      for (auto &funcName : sortedFuncs)
+        if (auto hwModule = mod.lookupSymbol<hw::HWModuleOp>(funcName))
+          flatModules.push_back(hwModule);
+      mlir::parallelForEach(&getContext(), flatModules,
+                            removeInternalChannels);
+    }
   }
 };
 } // end anonymous namespace
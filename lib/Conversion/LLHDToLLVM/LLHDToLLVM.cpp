@@ -1044,14 +1044,14 @@ struct InstOpConversion : public ConvertToLLVMPattern {
                             "addSigStructElement", addSigStructElemFuncTy);
 
     // Get or insert allocProc library call definition.
-    auto allocProcFuncTy =
-        LLVM::LLVMFunctionType::get(voidTy, {voidPtrTy, voidPtrTy, voidPtrTy});
+    auto allocProcFuncTy = LLVM::LLVMFunctionType::get(
+        voidTy, {voidPtrTy, voidPtrTy, voidPtrTy, i64Ty});
     auto allocProcFunc = getOrInsertFunction(module, rewriter, op->getLoc(),
                                              "allocProc", allocProcFuncTy);
 
     // Get or insert allocEntity library call definition.
-    auto allocEntityFuncTy =
-        LLVM::LLVMFunctionType::get(voidTy, {voidPtrTy, voidPtrTy, voidPtrTy});
+    auto allocEntityFuncTy = LLVM::LLVMFunctionType::get(
+        voidTy, {voidPtrTy, voidPtrTy, voidPtrTy, i64Ty});
     auto allocEntityFunc = getOrInsertFunction(
         module, rewriter, op->getLoc(), "allocEntity", allocEntityFuncTy);
 
@@ -1127,7 +1127,7 @@ struct InstOpConversion : public ConvertToLLVMPattern {
       // Add reg state pointer to global state.
       initBuilder.create<LLVM::CallOp>(
           op->getLoc(), std::nullopt, SymbolRefAttr::get(allocEntityFunc),
-          ArrayRef<Value>({initStatePtr, owner, regMall}));
+          ArrayRef<Value>({initStatePtr, owner, regMall, regSize}));
 
       // Index of the signal in the entity's signal table.
       int initCounter = 0;
@@ -1345,7 +1345,8 @@ struct InstOpConversion : public ConvertToLLVMPattern {
       initBuilder.create<LLVM::StoreOp>(op->getLoc(), sensesBC,
                                         procStateSensesPtr);
 
-      std::array<Value, 3> allocProcArgs({initStatePtr, owner, procStateMall});
+      std::array<Value, 4> allocProcArgs(
+          {initStatePtr, owner, procStateMall, procStateSize});
       initBuilder.create<LLVM::CallOp>(op->getLoc(), std::nullopt,
                                        SymbolRefAttr::get(allocProcFunc),
                                        allocProcArgs);
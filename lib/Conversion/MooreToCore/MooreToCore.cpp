@@ -19,6 +19,7 @@
 #include "mlir/Dialect/ControlFlow/IR/ControlFlowOps.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/IR/BuiltinDialect.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/Transforms/DialectConversion.h"
 #include "llvm/ADT/TypeSwitch.h"
 
@@ -345,18 +346,40 @@ std::unique_ptr<OperationPass<ModuleOp>> circt::createConvertMooreToCorePass() {
   return std::make_unique<MooreToCorePass>();
 }
 
-/// This is the main entrypoint for the Moore to Core conversion pass.
-void MooreToCorePass::runOnOperation() {
-  MLIRContext &context = getContext();
-  ModuleOp module = getOperation();
-
+/// Convert the given operations. Every call sets up its own target, type
+/// converter, and patterns, such that conversions can run concurrently. The
+/// type converter caches the conversion of each type, so the normalization of
+/// a Moore type only happens once per call.
+static LogicalResult convertOps(MLIRContext &context,
+                                ArrayRef<Operation *> ops) {
   ConversionTarget target(context);
   TypeConverter typeConverter;
   RewritePatternSet patterns(&context);
   populateLegality(target);
   populateTypeConversion(typeConverter);
   populateOpConversion(patterns, typeConverter);
+  return applyFullConversion(ops, target, std::move(patterns));
+}
+
+/// This is the main entrypoint for the Moore to Core conversion pass.
+void MooreToCorePass::runOnOperation() {
+  MLIRContext &context = getContext();
+  ModuleOp module = getOperation();
+
+  // Entities and functions are isolated from above and only refer to each
+  // other through symbols, so they are converted in parallel. Everything else
+  // at the top level of the module is converted afterwards.
+  SmallVector<Operation *> isolatedOps, otherOps;
+  for (auto &op : *module.getBody()) {
+    if (op.hasTrait<OpTrait::IsIsolatedFromAbove>())
+      isolatedOps.push_back(&op);
+    else
+      otherOps.push_back(&op);
+  }
 
-  if (failed(applyFullConversion(module, target, std::move(patterns))))
+  if (failed(mlir::failableParallelForEach(
+          &context, isolatedOps,
+          [&](Operation *op) { return convertOps(context, op); })) ||
+      failed(convertOps(context, otherOps)))
     signalPassFailure();
 }
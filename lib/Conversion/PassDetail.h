@@ -10,6 +10,7 @@
 #ifndef CONVERSION_PASSDETAIL_H
 #define CONVERSION_PASSDETAIL_H
 
+#include "circt/Conversion/FSMToSV.h"
 #include "circt/Support/LoweringOptions.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/DialectRegistry.h"
@@ -113,6 +114,10 @@ namespace seq {
 class SeqDialect;
 } // namespace seq
 
+namespace ssp {
+class SSPDialect;
+} // namespace ssp
+
 namespace sv {
 class SVDialect;
 } // namespace sv
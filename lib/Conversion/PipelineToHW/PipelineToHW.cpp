@@ -17,24 +17,100 @@
 #include "circt/Dialect/Pipeline/Pipeline.h"
 #include "circt/Dialect/Seq/SeqOps.h"
 #include "mlir/IR/Builders.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/TypeSwitch.h"
 
 using namespace mlir;
 using namespace circt;
 using namespace pipeline;
 
-static LogicalResult lowerPipeline(PipelineOp pipeline, OpBuilder &builder) {
+namespace {
+/// Lowers a pipeline into the body of its parent module.
+struct PipelineLowering {
+  PipelineLowering(OpBuilder &builder, bool minimizeRegs, bool clockGateRegs)
+      : builder(builder), minimizeRegs(minimizeRegs),
+        clockGateRegs(clockGateRegs) {}
+
+  LogicalResult lower(PipelineOp pipeline);
+
+  /// Compute the register outputs that are used outside of stage registers,
+  /// or through a chain of live stage registers.
+  void computeLiveRegOuts(PipelineOp pipeline);
+
+  /// Create a register for a value. `enable` is the clock enable of the
+  /// register, or null if it loads in every cycle.
+  Value createReg(Location loc, Value input, Value enable, StringAttr name);
+
+  OpBuilder &builder;
+  bool minimizeRegs;
+  bool clockGateRegs;
+  Value clk, rst;
+  DenseSet<Value> liveRegOuts;
+
+  uint64_t numRegBits = 0;
+  uint64_t numRegBitsSaved = 0;
+};
+} // namespace
+
+static uint64_t getRegBits(Type type) {
+  return std::max<int64_t>(hw::getBitWidth(type), 0);
+}
+
+void PipelineLowering::computeLiveRegOuts(PipelineOp pipeline) {
+  // Stages usually feed later stages, so a reverse walk sees the users of a
+  // register output before the output itself. Uses by stages that have not
+  // been visited yet are feedback and conservatively keep the register live.
+  auto stages = llvm::to_vector(
+      pipeline.getBodyBlock()->getOps<PipelineStageRegisterOp>());
+  DenseSet<Operation *> visited;
+  for (auto stage : llvm::reverse(stages)) {
+    for (auto regOut : stage.getRegOuts()) {
+      bool live = llvm::any_of(regOut.getUses(), [&](OpOperand &use) {
+        auto user = dyn_cast<PipelineStageRegisterOp>(use.getOwner());
+        if (!user || !visited.contains(user) ||
+            use.getOperandNumber() >= user.getRegIns().size())
+          return true;
+        return liveRegOuts.contains(
+            user.getRegOuts()[use.getOperandNumber()]);
+      });
+      if (live)
+        liveRegOuts.insert(regOut);
+    }
+    visited.insert(stage);
+  }
+}
+
+Value PipelineLowering::createReg(Location loc, Value input, Value enable,
+                                  StringAttr name) {
+  numRegBits += getRegBits(input.getType());
+  if (enable)
+    return builder.create<seq::CompRegClockEnabledOp>(
+        loc, input.getType(), input, clk, enable, name, Value(), Value(),
+        StringAttr());
+  return builder.create<seq::CompRegOp>(loc, input.getType(), input, clk, name,
+                                        rst, Value(), StringAttr());
+}
+
+LogicalResult PipelineLowering::lower(PipelineOp pipeline) {
   if (pipeline.isLatencyInsensitive())
     return pipeline.emitOpError() << "Only latency-sensitive pipelines are "
                                      "supported at the moment";
 
   // Simply move the ops from the pipeline to the enclosing hw.module scope,
   // converting any stage ops to seq registers.
-  Value clk = pipeline.getClock();
-  Value rst = pipeline.getReset();
+  clk = pipeline.getClock();
+  rst = pipeline.getReset();
   llvm::SmallVector<Value, 4> retVals;
   builder.setInsertionPoint(pipeline);
 
+  if (minimizeRegs)
+    computeLiveRegOuts(pipeline);
+
+  // While stalled, no stage register may change.
+  Value notStalled;
+  if (auto stall = pipeline.getStall())
+    notStalled = comb::createOrFoldNot(pipeline.getLoc(), stall, builder);
+
   for (auto [arg, barg] : llvm::zip(pipeline.getOperands(),
                                     pipeline.getBodyBlock()->getArguments()))
     barg.replaceAllUsesWith(arg);
@@ -46,21 +122,43 @@ static LogicalResult lowerPipeline(PipelineOp pipeline, OpBuilder &builder) {
           unsigned stageIdx = stage.index();
           auto validRegName =
               builder.getStringAttr("s" + std::to_string(stageIdx) + "_valid");
-          auto validReg = builder.create<seq::CompRegOp>(
-              loc, builder.getI1Type(), stage.getWhen(), clk, validRegName, rst,
-              Value(), StringAttr());
+          auto validReg =
+              createReg(loc, stage.getWhen(), notStalled, validRegName);
           stage.getValid().replaceAllUsesWith(validReg);
 
+          Value dataEnable = notStalled;
+          if (clockGateRegs)
+            dataEnable = notStalled ? builder.createOrFold<comb::AndOp>(
+                                          loc, stage.getWhen(), notStalled)
+                                    : stage.getWhen();
+
+          // The registers already created for the inputs of this stage.
+          SmallDenseMap<Value, Value> sharedRegs;
           for (auto it : llvm::enumerate(stage.getRegIns())) {
             auto regIdx = it.index();
             auto regIn = it.value();
+            auto regOut = stage.getRegOuts()[regIdx];
+            if (minimizeRegs) {
+              // Constants don't change between stages, and dead or duplicate
+              // registers are not needed.
+              Value replacement;
+              if (regIn.getDefiningOp<hw::ConstantOp>())
+                replacement = regIn;
+              else if (auto shared = sharedRegs.lookup(regIn))
+                replacement = shared;
+              if (replacement || !liveRegOuts.contains(regOut)) {
+                numRegBitsSaved += getRegBits(regIn.getType());
+                if (replacement)
+                  regOut.replaceAllUsesWith(replacement);
+                continue;
+              }
+            }
             auto regName =
                 builder.getStringAttr("s" + std::to_string(stageIdx) + "_reg" +
                                       std::to_string(regIdx));
-            auto reg = builder.create<seq::CompRegOp>(loc, regIn.getType(),
-                                                      regIn, clk, regName, rst,
-                                                      Value(), StringAttr());
-            stage.getRegOuts()[regIdx].replaceAllUsesWith(reg);
+            auto reg = createReg(loc, regIn, dataEnable, regName);
+            sharedRegs[regIn] = reg;
+            regOut.replaceAllUsesWith(reg);
           }
         })
         .Case<pipeline::ReturnOp>([&](auto ret) { retVals = ret.getOutputs(); })
@@ -83,13 +181,16 @@ struct PipelineToHWPass : public PipelineToHWBase<PipelineToHWPass> {
 
 void PipelineToHWPass::runOnOperation() {
   OpBuilder builder(&getContext());
+  PipelineLowering lowering(builder, minimizeRegs, clockGateRegs);
   // Iterate over each pipeline op in the module and convert.
   // Note: This pass matches on `hw::ModuleOp`s and not directly on the
   // `PipelineOp` due to the `PipelineOp` being erased during this pass.
   for (auto pipeline :
        llvm::make_early_inc_range(getOperation().getOps<PipelineOp>()))
-    if (failed(lowerPipeline(pipeline, builder)))
+    if (failed(lowering.lower(pipeline)))
       signalPassFailure();
+  numRegBits += lowering.numRegBits;
+  numRegBitsSaved += lowering.numRegBitsSaved;
 }
 
 } // namespace
@@ -31,6 +31,7 @@
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/Diagnostics.h"
 #include "mlir/IR/Dominance.h"
+#include "mlir/IR/Matchers.h"
 #include "mlir/IR/OpImplementation.h"
 #include "mlir/IR/PatternMatch.h"
 #include "mlir/IR/Types.h"
@@ -1251,11 +1252,69 @@ static bool isMemoryOp(Operation *op) {
              AffineWriteOpInterface>(op);
 }
 
+/// Splits an index into a base value and a constant offset, looking through
+/// additions and subtractions of constants. Constant indices have a null base.
+static std::pair<Value, int64_t> getIndexBaseAndOffset(Value index) {
+  APInt constant;
+  if (matchPattern(index, m_ConstantInt(&constant)))
+    return {Value(), constant.getSExtValue()};
+
+  Operation *defOp = index.getDefiningOp();
+  if (isa_and_nonnull<arith::AddIOp, arith::SubIOp>(defOp)) {
+    bool isSub = isa<arith::SubIOp>(defOp);
+    Value lhs = defOp->getOperand(0), rhs = defOp->getOperand(1);
+    if (matchPattern(rhs, m_ConstantInt(&constant)))
+      return {lhs, isSub ? -constant.getSExtValue() : constant.getSExtValue()};
+    if (!isSub && matchPattern(lhs, m_ConstantInt(&constant)))
+      return {rhs, constant.getSExtValue()};
+  }
+  return {index, 0};
+}
+
+/// Returns true if the two accesses of the same memref, which are located in
+/// the same block with `src` preceding `dst`, can never access the same
+/// address during an execution of that block. Affine accesses are checked with
+/// the affine dependence analysis. The indices of other accesses are disjoint
+/// if they differ by a constant offset in at least one dimension.
+static bool areIndependentAccesses(Operation *src, Operation *dst) {
+  if (isa<AffineReadOpInterface, AffineWriteOpInterface>(src) &&
+      isa<AffineReadOpInterface, AffineWriteOpInterface>(dst)) {
+    // Outside of affine loops, a loop depth of one checks for dependences
+    // between the accesses as they execute within the same block.
+    DependenceResult result = checkMemrefAccessDependence(
+        MemRefAccess(src), MemRefAccess(dst), /*loopDepth=*/1);
+    return result.value == DependenceResult::NoDependence;
+  }
+
+  auto getIndices = [](Operation *op) -> std::optional<ValueRange> {
+    if (auto loadOp = dyn_cast<memref::LoadOp>(op))
+      return ValueRange(loadOp.getIndices());
+    if (auto storeOp = dyn_cast<memref::StoreOp>(op))
+      return ValueRange(storeOp.getIndices());
+    return std::nullopt;
+  };
+  auto srcIndices = getIndices(src);
+  auto dstIndices = getIndices(dst);
+  if (!srcIndices || !dstIndices)
+    return false;
+
+  for (auto [srcIndex, dstIndex] : llvm::zip(*srcIndices, *dstIndices)) {
+    auto [srcBase, srcOffset] = getIndexBaseAndOffset(srcIndex);
+    auto [dstBase, dstOffset] = getIndexBaseAndOffset(dstIndex);
+    if (srcBase == dstBase && srcOffset != dstOffset)
+      return true;
+  }
+  return false;
+}
+
 LogicalResult
 HandshakeLowering::replaceMemoryOps(ConversionPatternRewriter &rewriter,
-                                    MemRefToMemoryAccessOp &memRefOps) {
+                                    MemRefToMemoryAccessOp &memRefOps,
+                                    bool relaxMemoryOrdering) {
 
   std::vector<Operation *> opsToErase;
+  // Maps each handshake load/store to the operation it replaces.
+  DenseMap<Operation *, Operation *> originalOps;
 
   // Enrich the memRefOps context with BlockArguments, in case they aren't used.
   for (auto arg : r.getArguments()) {
@@ -1340,6 +1399,25 @@ HandshakeLowering::replaceMemoryOps(ConversionPatternRewriter &rewriter,
 
     memRefOps[memref].push_back(newOp);
     opsToErase.push_back(&op);
+    originalOps[newOp] = &op;
+  }
+
+  // Record the accesses of each memref which need not be ordered with respect
+  // to each other. Only accesses within the same block are ordered to begin
+  // with, and loads are never ordered with respect to other loads.
+  if (relaxMemoryOrdering) {
+    for (auto &[memref, accesses] : memRefOps) {
+      for (unsigned i = 0, e = accesses.size(); i < e; ++i) {
+        for (unsigned j = i + 1; j < e; ++j) {
+          Operation *src = accesses[i], *dst = accesses[j];
+          if (src->getBlock() != dst->getBlock() ||
+              (isa<handshake::LoadOp>(src) && isa<handshake::LoadOp>(dst)))
+            continue;
+          if (areIndependentAccesses(originalOps[src], originalOps[dst]))
+            independentAccesses.insert({src, dst});
+        }
+      }
+    }
   }
 
   // Erase old memory ops
@@ -1475,8 +1553,10 @@ void HandshakeLowering::setMemOpControlInputs(
       Operation *predOp = memOps[j];
       Block *predBlock = predOp->getBlock();
       if (currBlock == predBlock)
-        // Any dependency but RARs
-        if (!(isa<handshake::LoadOp>(currOp) && isa<handshake::LoadOp>(predOp)))
+        // Any dependency but RARs and accesses which are known to never alias
+        if (!(isa<handshake::LoadOp>(currOp) &&
+              isa<handshake::LoadOp>(predOp)) &&
+            !independentAccesses.contains({predOp, currOp}))
           // cntrlInd maps memOps index to correct control output index
           controlOperands.push_back(memOp->getResult(offset + cntrlInd[j]));
     }
@@ -1661,7 +1741,8 @@ static LogicalResult maximizeSSANoMem(Region &r,
 
 static LogicalResult lowerFuncOp(func::FuncOp funcOp, MLIRContext *ctx,
                                  bool sourceConstants,
-                                 bool disableTaskPipelining) {
+                                 bool disableTaskPipelining,
+                                 bool relaxMemoryOrdering) {
   // Only retain those attributes that are not constructed by build.
   SmallVector<NamedAttribute, 4> attributes;
   for (const auto &attr : funcOp->getAttrs()) {
@@ -1708,8 +1789,8 @@ static LogicalResult lowerFuncOp(func::FuncOp funcOp, MLIRContext *ctx,
 
   if (!newFuncOp.isExternal()) {
     HandshakeLowering fol(newFuncOp.getBody());
-    returnOnError(lowerRegion<func::ReturnOp>(fol, sourceConstants,
-                                              disableTaskPipelining));
+    returnOnError(lowerRegion<func::ReturnOp>(
+        fol, sourceConstants, disableTaskPipelining, relaxMemoryOrdering));
   }
 
   return success();
@@ -1724,16 +1805,18 @@ struct HandshakeRemoveBlockPass
 
 struct StandardToHandshakePass
     : public StandardToHandshakeBase<StandardToHandshakePass> {
-  StandardToHandshakePass(bool sourceConstants, bool disableTaskPipelining) {
+  StandardToHandshakePass(bool sourceConstants, bool disableTaskPipelining,
+                          bool relaxMemoryOrdering) {
     this->sourceConstants = sourceConstants;
     this->disableTaskPipelining = disableTaskPipelining;
+    this->relaxMemoryOrdering = relaxMemoryOrdering;
   }
   void runOnOperation() override {
     ModuleOp m = getOperation();
 
     for (auto funcOp : llvm::make_early_inc_range(m.getOps<func::FuncOp>())) {
       if (failed(lowerFuncOp(funcOp, &getContext(), sourceConstants,
-                             disableTaskPipelining))) {
+                             disableTaskPipelining, relaxMemoryOrdering))) {
         signalPassFailure();
         return;
       }
@@ -1750,9 +1833,10 @@ struct StandardToHandshakePass
 
 std::unique_ptr<mlir::OperationPass<mlir::ModuleOp>>
 circt::createStandardToHandshakePass(bool sourceConstants,
-                                     bool disableTaskPipelining) {
-  return std::make_unique<StandardToHandshakePass>(sourceConstants,
-                                                   disableTaskPipelining);
+                                     bool disableTaskPipelining,
+                                     bool relaxMemoryOrdering) {
+  return std::make_unique<StandardToHandshakePass>(
+      sourceConstants, disableTaskPipelining, relaxMemoryOrdering);
 }
 
 std::unique_ptr<mlir::OperationPass<handshake::FuncOp>>
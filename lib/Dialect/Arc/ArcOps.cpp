@@ -224,6 +224,25 @@ LogicalResult ClockDomainOp::verifyRegions() {
                                    getInputs().getTypes(), "input");
 }
 
+//===----------------------------------------------------------------------===//
+// ClockTreeOp
+//===----------------------------------------------------------------------===//
+
+StringAttr ClockTreeOp::getClockName() {
+  auto readOp = getClock().getDefiningOp<StateReadOp>();
+  if (!readOp)
+    return {};
+  auto inputOp = readOp.getState().getDefiningOp<RootInputOp>();
+  return inputOp ? inputOp.getNameAttr() : StringAttr{};
+}
+
+std::string arc::getClockFunctionName(StringRef modelName, unsigned index) {
+  // The first clock keeps the plain name used by models with a single clock.
+  if (index == 0)
+    return (modelName + "_clock").str();
+  return (modelName + "_clock_" + Twine(index - 1)).str();
+}
+
 //===----------------------------------------------------------------------===//
 // RootInputOp
 //===----------------------------------------------------------------------===//
@@ -257,6 +276,21 @@ LogicalResult ModelOp::verify() {
   return success();
 }
 
+//===----------------------------------------------------------------------===//
+// StorageGetOp
+//===----------------------------------------------------------------------===//
+
+LogicalResult StorageGetOp::verify() {
+  if (auto bit = getBit()) {
+    auto stateType = getType().dyn_cast<StateType>();
+    if (!stateType || stateType.getType().getWidth() != 1)
+      return emitOpError("with bit offset must access an `i1` state");
+    if (*bit >= 8)
+      return emitOpError("bit offset must be less than 8");
+  }
+  return success();
+}
+
 //===----------------------------------------------------------------------===//
 // LutOp
 //===----------------------------------------------------------------------===//
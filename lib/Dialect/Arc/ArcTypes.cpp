@@ -19,11 +19,43 @@ using namespace mlir;
 #define GET_TYPEDEF_CLASSES
 #include "circt/Dialect/Arc/ArcTypes.cpp.inc"
 
+unsigned StateType::getStride() {
+  unsigned stride = (getType().getWidth() + 7) / 8;
+  return llvm::alignToPowerOf2(stride, llvm::bit_ceil(std::min(stride, 8U)));
+}
+
 unsigned MemoryType::getStride() {
   unsigned stride = (getWordType().getWidth() + 7) / 8;
   return llvm::alignToPowerOf2(stride, llvm::bit_ceil(std::min(stride, 8U)));
 }
 
+/// Return the number of pages in the page table of a sparse memory.
+unsigned MemoryType::getNumPages() {
+  if (!isSparse())
+    return 0;
+  return llvm::divideCeil(getNumWords(), getWordsPerPage());
+}
+
+/// Return the number of bytes the memory occupies in the model's storage. For
+/// sparse memories this is the size of the page table, assuming 64 bit page
+/// pointers.
+unsigned MemoryType::getStorageSize() {
+  if (isSparse())
+    return getNumPages() * 8;
+  return getNumWords() * getStride();
+}
+
+LogicalResult
+MemoryType::verify(llvm::function_ref<InFlightDiagnostic()> emitError,
+                   unsigned numWords, IntegerType wordType,
+                   IntegerType addressType, unsigned wordsPerPage) {
+  if (wordsPerPage != 0 && !llvm::isPowerOf2_32(wordsPerPage))
+    return emitError() << "number of words per page must be a power of two, "
+                          "but got "
+                       << wordsPerPage;
+  return success();
+}
+
 void ArcDialect::registerTypes() {
   addTypes<
 #define GET_TYPEDEF_LIST
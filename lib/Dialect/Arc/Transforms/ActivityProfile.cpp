@@ -0,0 +1,135 @@
+//===- ActivityProfile.cpp ------------------------------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "circt/Dialect/Arc/ActivityProfile.h"
+#include "mlir/IR/Diagnostics.h"
+#include "mlir/IR/Location.h"
+#include "mlir/Support/FileUtilities.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+using namespace mlir;
+using namespace circt;
+using namespace arc;
+
+bool ActivityProfile::addCounter(StringRef name, uint64_t value) {
+  llvm::StringMap<uint64_t> *counts;
+  if (name.consume_front(callCounterPrefix))
+    counts = &calls;
+  else if (name.consume_front(toggleCounterPrefix))
+    counts = &toggles;
+  else
+    return false;
+
+  // Drop the suffix that distinguishes the counters of the same arc or state.
+  auto [counted, index] = name.rsplit('.');
+  if (index.empty() || !llvm::all_of(index, llvm::isDigit))
+    return false;
+  (*counts)[counted] += value;
+  return true;
+}
+
+std::optional<uint64_t> ActivityProfile::getCalls(StringRef arcName) const {
+  auto it = calls.find(arcName);
+  if (it == calls.end())
+    return std::nullopt;
+  return it->second;
+}
+
+std::optional<uint64_t>
+ActivityProfile::getToggles(StringRef stateName) const {
+  auto it = toggles.find(stateName);
+  if (it == toggles.end())
+    return std::nullopt;
+  return it->second;
+}
+
+bool ActivityProfile::isHot(StringRef arcName) const {
+  auto numCalls = getCalls(arcName);
+  return numCalls && numCycles > 0 && *numCalls >= numCycles;
+}
+
+bool ActivityProfile::isCold(StringRef arcName) const {
+  auto numCalls = getCalls(arcName);
+  return numCalls && *numCalls == 0;
+}
+
+void ActivityProfile::print(llvm::raw_ostream &os) const {
+  // Sort the entries such that the output is deterministic.
+  auto printCounts = [](llvm::json::OStream &json,
+                        const llvm::StringMap<uint64_t> &counts) {
+    SmallVector<StringRef> names;
+    for (auto &entry : counts)
+      names.push_back(entry.getKey());
+    llvm::sort(names);
+    json.object([&] {
+      for (auto name : names)
+        json.attribute(name, int64_t(counts.lookup(name)));
+    });
+  };
+  llvm::json::OStream json(os, 2);
+  json.object([&] {
+    json.attribute("cycles", int64_t(numCycles));
+    json.attributeBegin("calls");
+    printCounts(json, calls);
+    json.attributeEnd();
+    json.attributeBegin("toggles");
+    printCounts(json, toggles);
+    json.attributeEnd();
+  });
+  os << "\n";
+}
+
+FailureOr<ActivityProfile> ActivityProfile::load(StringRef path,
+                                                 Location loc) {
+  std::string errorMessage;
+  auto buffer = openInputFile(path, &errorMessage);
+  if (!buffer) {
+    emitError(loc) << "cannot read profile: " << errorMessage;
+    return failure();
+  }
+
+  auto json = llvm::json::parse(buffer->getBuffer());
+  if (!json) {
+    emitError(loc) << "cannot parse profile `" << path
+                   << "`: " << llvm::toString(json.takeError());
+    return failure();
+  }
+
+  auto invalid = [&](const Twine &message) {
+    emitError(loc) << "invalid profile `" << path << "`: " << message;
+    return failure();
+  };
+  auto *root = json->getAsObject();
+  if (!root)
+    return invalid("expected an object");
+
+  ActivityProfile profile;
+  if (auto cycles = root->getInteger("cycles"))
+    profile.numCycles = *cycles;
+  else
+    return invalid("expected an integer `cycles`");
+
+  auto loadCounts = [&](StringRef key,
+                        llvm::StringMap<uint64_t> &counts) -> LogicalResult {
+    auto *object = root->getObject(key);
+    if (!object)
+      return invalid("expected an object `" + key + "`");
+    for (auto &[name, value] : *object) {
+      auto count = value.getAsInteger();
+      if (!count || *count < 0)
+        return invalid("expected a count for `" + name.str() + "`");
+      counts[name.str()] = *count;
+    }
+    return success();
+  };
+  if (failed(loadCounts("calls", profile.calls)) ||
+      failed(loadCounts("toggles", profile.toggles)))
+    return failure();
+  return profile;
+}
@@ -0,0 +1,115 @@
+//===- AddActivityCounters.cpp --------------------------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass instruments models with counters that record how often each arc is
+// called and how often each named state changes its value. The final values of
+// the counters form an activity profile, which guides later optimizations of
+// the same design.
+//
+//===----------------------------------------------------------------------===//
+
+#include "PassDetails.h"
+#include "circt/Dialect/Arc/ActivityProfile.h"
+#include "mlir/IR/ImplicitLocOpBuilder.h"
+#include "llvm/ADT/StringMap.h"
+
+#define DEBUG_TYPE "arc-add-activity-counters"
+
+using namespace mlir;
+using namespace circt;
+using namespace arc;
+
+/// The width of the counters.
+static constexpr unsigned counterWidth = 64;
+
+namespace {
+struct AddActivityCountersPass
+    : public AddActivityCountersBase<AddActivityCountersPass> {
+  void runOnOperation() override;
+  void instrumentModel(ModelOp modelOp);
+};
+} // namespace
+
+void AddActivityCountersPass::runOnOperation() {
+  for (auto modelOp : getOperation().getOps<ModelOp>())
+    instrumentModel(modelOp);
+}
+
+void AddActivityCountersPass::instrumentModel(ModelOp modelOp) {
+  // Collect the call sites and the writes to named states before any counters
+  // are added.
+  SmallVector<CallOpInterface> calls;
+  SmallVector<std::pair<StateWriteOp, StringAttr>> writes;
+  modelOp.walk([&](Operation *op) {
+    if (isa<CallOp, StateOp>(op))
+      calls.push_back(cast<CallOpInterface>(op));
+    else if (auto writeOp = dyn_cast<StateWriteOp>(op))
+      if (auto allocOp = writeOp.getState().getDefiningOp<AllocStateOp>())
+        if (auto name = allocOp->getAttrOfType<StringAttr>("name"))
+          if (!name.getValue().empty())
+            writes.push_back({writeOp, name});
+  });
+
+  // State writes are deferred until the end of the cycle, such that multiple
+  // increments of the same counter in one cycle would only count once. Every
+  // call site and write therefore gets its own counter, which is incremented
+  // at most once per cycle.
+  Value storage = modelOp.getBody().getArgument(0);
+  auto counterType = IntegerType::get(&getContext(), counterWidth);
+  auto stateType = StateType::get(counterType);
+  llvm::StringMap<unsigned> numCounters;
+  auto allocBuilder = OpBuilder::atBlockBegin(&modelOp.getBodyBlock());
+  auto addCounter = [&](Location loc, const Twine &name) -> Value {
+    auto nameStr = name.str();
+    unsigned index = numCounters[nameStr]++;
+    auto allocOp = allocBuilder.create<AllocStateOp>(loc, stateType, storage);
+    allocOp->setAttr("name", allocBuilder.getStringAttr(
+                                 nameStr + "." + std::to_string(index)));
+    return allocOp;
+  };
+  auto increment = [&](ImplicitLocOpBuilder &builder, Value counter,
+                       Value amount) {
+    Value count = builder.create<StateReadOp>(counter);
+    Value next = builder.create<comb::AddOp>(count, amount, true);
+    builder.create<StateWriteOp>(counter, next, Value{});
+  };
+
+  for (auto callOp : calls) {
+    auto callee = callOp.getCallableForCallee()
+                      .get<mlir::SymbolRefAttr>()
+                      .getLeafReference();
+    ImplicitLocOpBuilder builder(callOp.getLoc(), callOp);
+    auto counter = addCounter(callOp.getLoc(),
+                              Twine(callCounterPrefix) + callee.getValue());
+    increment(builder, counter,
+              builder.create<hw::ConstantOp>(counterType, 1));
+    ++numCallCounters;
+  }
+
+  for (auto [writeOp, name] : writes) {
+    ImplicitLocOpBuilder builder(writeOp.getLoc(), writeOp);
+    auto counter = addCounter(writeOp.getLoc(),
+                              Twine(toggleCounterPrefix) + name.getValue());
+    // The state changes if the write is enabled and the written value differs
+    // from the current one.
+    Value current = builder.create<StateReadOp>(writeOp.getState());
+    Value changed = builder.create<comb::ICmpOp>(
+        comb::ICmpPredicate::ne, current, writeOp.getValue(), true);
+    if (auto condition = writeOp.getCondition())
+      changed = builder.create<comb::AndOp>(changed, condition, true);
+    Value zeros = builder.create<hw::ConstantOp>(
+        builder.getIntegerType(counterWidth - 1), 0);
+    increment(builder, counter,
+              builder.create<comb::ConcatOp>(zeros, changed));
+    ++numToggleCounters;
+  }
+}
+
+std::unique_ptr<Pass> arc::createAddActivityCountersPass() {
+  return std::make_unique<AddActivityCountersPass>();
+}
@@ -7,6 +7,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "PassDetails.h"
+#include "circt/Dialect/Arc/ActivityProfile.h"
 #include "llvm/Support/Debug.h"
 
 #define DEBUG_TYPE "arc-allocate-state"
@@ -15,6 +16,7 @@ using namespace mlir;
 using namespace circt;
 using namespace arc;
 
+using llvm::Optional;
 using llvm::SmallMapVector;
 
 //===----------------------------------------------------------------------===//
@@ -22,10 +24,30 @@ using llvm::SmallMapVector;
 //===----------------------------------------------------------------------===//
 
 namespace {
+/// The parts of the storage that allocations are grouped into by the
+/// cache-aware layout, in the order in which they are laid out. `Idle` holds
+/// the read states that never changed according to the activity profile.
+enum class LayoutClass { Ports, Hot, Idle, Memory, Cold };
+
 struct AllocateStatePass : public AllocateStateBase<AllocateStatePass> {
   void runOnOperation() override;
   void allocateBlock(Block *block);
   void allocateOps(Value storage, Block *block, ArrayRef<Operation *> ops);
+  void sortForLocality(SmallVectorImpl<Operation *> &ops);
+  LayoutClass getLayoutClass(Operation *op);
+  unsigned getOrder(Operation *op);
+
+  using AllocateStateBase::cacheAware;
+  using AllocateStateBase::cacheLineSize;
+  using AllocateStateBase::lanes;
+  using AllocateStateBase::packBits;
+  using AllocateStateBase::profileFile;
+
+  /// The position of each op in the model in a pre-order walk.
+  DenseMap<Operation *, unsigned> opOrder;
+
+  /// The activity profile guiding the cache-aware layout, if any.
+  std::optional<ActivityProfile> profile;
 };
 } // namespace
 
@@ -34,6 +56,19 @@ void AllocateStatePass::runOnOperation() {
   LLVM_DEBUG(llvm::dbgs() << "Allocating state in `" << modelOp.getName()
                           << "`\n");
 
+  opOrder.clear();
+  if (cacheAware)
+    modelOp.walk<WalkOrder::PreOrder>(
+        [&](Operation *op) { opOrder.insert({op, opOrder.size()}); });
+
+  profile.reset();
+  if (cacheAware && !profileFile.empty()) {
+    auto loadedProfile = ActivityProfile::load(profileFile, modelOp.getLoc());
+    if (failed(loadedProfile))
+      return signalPassFailure();
+    profile = std::move(*loadedProfile);
+  }
+
   // Walk the blocks from innermost to outermost and group all state allocations
   // in that block in one larger allocation.
   modelOp.walk([&](Block *block) { allocateBlock(block); });
@@ -57,43 +92,167 @@ void AllocateStatePass::allocateBlock(Block *block) {
     allocateOps(storage, block, ops);
 }
 
+/// Return the position of an op in the model, or of its closest ancestor that
+/// existed when the pass started.
+unsigned AllocateStatePass::getOrder(Operation *op) {
+  for (; op; op = op->getParentOp())
+    if (auto it = opOrder.find(op); it != opOrder.end())
+      return it->second;
+  return 0;
+}
+
+/// Determine which part of the storage an allocation goes into. States that
+/// are never read within the model, like taps, are only there to be observed
+/// from the outside and are kept out of the way of the frequently read states.
+/// States that never changed while profiling are only read, and are kept apart
+/// from the states whose cache lines are written to.
+LayoutClass AllocateStatePass::getLayoutClass(Operation *op) {
+  if (isa<RootInputOp, RootOutputOp>(op))
+    return LayoutClass::Ports;
+  if (isa<AllocMemoryOp>(op))
+    return LayoutClass::Memory;
+  if (auto allocOp = dyn_cast<AllocStateOp>(op)) {
+    if (allocOp.getTap() ||
+        llvm::none_of(allocOp->getUsers(),
+                      [](auto *user) { return isa<StateReadOp>(user); }))
+      return LayoutClass::Cold;
+    if (profile)
+      if (auto name = allocOp->getAttrOfType<StringAttr>("name"))
+        if (profile->getToggles(name.getValue()) == 0)
+          return LayoutClass::Idle;
+  }
+  return LayoutClass::Hot;
+}
+
+/// Return the clock tree or passthrough op in which all accesses of a state
+/// happen, null if they happen directly in the model, or std::nullopt if they
+/// are spread across several of them. Single-bit states are only packed into
+/// the same byte if they are accessed from the same place, since the
+/// partitions of a clock tree may be evaluated concurrently and their updates
+/// of a shared byte must not race.
+static std::optional<Operation *> getAccessingClock(Operation *op) {
+  std::optional<Operation *> clock;
+  for (auto *user : op->getUsers()) {
+    Operation *userClock = user->getParentOfType<ClockTreeOp>();
+    if (!userClock)
+      userClock = user->getParentOfType<PassThroughOp>();
+    if (clock && *clock != userClock)
+      return std::nullopt;
+    clock = userClock;
+  }
+  return clock;
+}
+
+/// Order allocations such that states used by the same clock tree, and within
+/// that by neighbouring ops, end up next to each other in the storage. Ports
+/// keep their order at the front of the storage.
+void AllocateStatePass::sortForLocality(SmallVectorImpl<Operation *> &ops) {
+  SmallVector<std::tuple<LayoutClass, unsigned, Operation *>> keys;
+  for (auto *op : ops) {
+    auto layoutClass = getLayoutClass(op);
+    unsigned firstAccess = -1U;
+    if (layoutClass != LayoutClass::Ports)
+      for (auto *user : op->getUsers())
+        firstAccess = std::min(firstAccess, getOrder(user));
+    keys.push_back({layoutClass, firstAccess, op});
+  }
+  llvm::stable_sort(keys, [](auto &a, auto &b) {
+    return std::make_pair(std::get<0>(a), std::get<1>(a)) <
+           std::make_pair(std::get<0>(b), std::get<1>(b));
+  });
+  for (auto [op, key] : llvm::zip(ops, keys))
+    op = std::get<2>(key);
+}
+
 void AllocateStatePass::allocateOps(Value storage, Block *block,
-                                    ArrayRef<Operation *> ops) {
-  SmallVector<std::tuple<Value, Value, IntegerAttr>> gettersToCreate;
+                                    ArrayRef<Operation *> unsortedOps) {
+  SmallVector<std::tuple<Value, Value, IntegerAttr, IntegerAttr>>
+      gettersToCreate;
+  SmallVector<Operation *> ops(unsortedOps.begin(), unsortedOps.end());
+  if (cacheAware)
+    sortForLocality(ops);
 
   // Helper function to allocate storage aligned to its own size, or 8 bytes at
-  // most.
+  // most. In the cache-aware layout, allocations that fit into a cache line
+  // are kept from straddling two lines, and larger ones start a new line.
   unsigned currentByte = 0;
   auto allocBytes = [&](unsigned numBytes) {
     currentByte = llvm::alignToPowerOf2(currentByte,
                                         llvm::bit_ceil(std::min(numBytes, 8U)));
+    if (cacheAware && cacheLineSize > 0 &&
+        (numBytes >= cacheLineSize ||
+         currentByte / cacheLineSize !=
+             (currentByte + numBytes - 1) / cacheLineSize))
+      currentByte = llvm::alignTo(currentByte, cacheLineSize);
     unsigned offset = currentByte;
     currentByte += numBytes;
     return offset;
   };
 
+  // The byte that single-bit states accessed from the same clock, and within
+  // the same part of the cache-aware layout, are currently packed into, and
+  // the next free bit in it.
+  DenseMap<std::pair<Operation *, unsigned>, std::pair<unsigned, unsigned>>
+      packedBytes;
+
   // Allocate storage for the operations.
   OpBuilder builder(block->getParentOp());
+  bool inColdRegion = false;
   for (auto *op : ops) {
+    // Start the rarely accessed states on a fresh cache line.
+    if (cacheAware && !inColdRegion &&
+        getLayoutClass(op) == LayoutClass::Cold) {
+      inColdRegion = true;
+      if (cacheLineSize > 0)
+        currentByte = llvm::alignTo(currentByte, cacheLineSize);
+    }
+
     if (isa<AllocStateOp, RootInputOp, RootOutputOp>(op)) {
       auto result = op->getResult(0);
       auto storage = op->getOperand(0);
-      auto intType = result.getType().cast<StateType>().getType();
-      unsigned numBytes = (intType.getWidth() + 7) / 8;
+      auto stateType = result.getType().cast<StateType>();
+      unsigned numBytes = (stateType.getType().getWidth() + 7) / 8;
+      // Every additional instance gets its own copy of the state, one state
+      // stride after the previous one.
+      if (lanes > 1)
+        numBytes = stateType.getStride() * lanes;
+
+      // Pack single-bit states into bytes shared with other such states.
+      std::optional<Operation *> clock;
+      if (packBits && isa<AllocStateOp>(op) &&
+          stateType.getType().getWidth() == 1)
+        clock = getAccessingClock(op);
+      if (clock) {
+        unsigned layoutClass = cacheAware ? unsigned(getLayoutClass(op)) : 0;
+        auto &[byteOffset, nextBit] =
+            packedBytes.try_emplace({*clock, layoutClass}, 0, 8).first->second;
+        if (nextBit == 8) {
+          byteOffset = allocBytes(numBytes);
+          nextBit = 0;
+        }
+        auto offset = builder.getI32IntegerAttr(byteOffset);
+        auto bit = builder.getI32IntegerAttr(nextBit++);
+        op->setAttr("offset", offset);
+        op->setAttr("bit", bit);
+        gettersToCreate.emplace_back(result, storage, offset, bit);
+        continue;
+      }
+
       auto offset = builder.getI32IntegerAttr(allocBytes(numBytes));
       op->setAttr("offset", offset);
-      gettersToCreate.emplace_back(result, storage, offset);
+      gettersToCreate.emplace_back(result, storage, offset, IntegerAttr{});
       continue;
     }
 
     if (auto memOp = dyn_cast<AllocMemoryOp>(op)) {
       auto memType = memOp.getType();
       unsigned stride = memType.getStride();
-      unsigned numBytes = memType.getNumWords() * stride;
+      unsigned numBytes = memType.getStorageSize() * lanes;
       auto offset = builder.getI32IntegerAttr(allocBytes(numBytes));
       op->setAttr("offset", offset);
       op->setAttr("stride", builder.getI32IntegerAttr(stride));
-      gettersToCreate.emplace_back(memOp, memOp.getStorage(), offset);
+      gettersToCreate.emplace_back(memOp, memOp.getStorage(), offset,
+                                   IntegerAttr{});
       continue;
     }
 
@@ -102,7 +261,7 @@ void AllocateStatePass::allocateOps(Value storage, Block *block,
           allocBytes(allocStorageOp.getType().getSize()));
       allocStorageOp.setOffsetAttr(offset);
       gettersToCreate.emplace_back(allocStorageOp, allocStorageOp.getInput(),
-                                   offset);
+                                   offset, IntegerAttr{});
       continue;
     }
 
@@ -111,7 +270,7 @@ void AllocateStatePass::allocateOps(Value storage, Block *block,
 
   // For every user of the alloc op, create a local `StorageGetOp`.
   SmallVector<StorageGetOp> getters;
-  for (auto [result, storage, offset] : gettersToCreate) {
+  for (auto [result, storage, offset, bit] : gettersToCreate) {
     SmallDenseMap<Block *, StorageGetOp> getterForBlock;
     for (auto *user : llvm::make_early_inc_range(result.getUsers())) {
       auto &getter = getterForBlock[user->getBlock()];
@@ -119,8 +278,8 @@ void AllocateStatePass::allocateOps(Value storage, Block *block,
       // `AllocStorageOp`s, for which we create a block-wider accessor.
       if (!getter || !result.getDefiningOp<AllocStorageOp>()) {
         ImplicitLocOpBuilder builder(result.getLoc(), user);
-        getter =
-            builder.create<StorageGetOp>(result.getType(), storage, offset);
+        getter = builder.create<StorageGetOp>(result.getType(), storage,
+                                              offset, bit);
         getters.push_back(getter);
       } else if (user->isBeforeInBlock(getter)) {
         // TODO: This is a very expensive operation since us inserting
@@ -152,6 +311,18 @@ void AllocateStatePass::allocateOps(Value storage, Block *block,
   }
 }
 
-std::unique_ptr<Pass> arc::createAllocateStatePass() {
-  return std::make_unique<AllocateStatePass>();
+std::unique_ptr<Pass>
+arc::createAllocateStatePass(Optional<unsigned> lanes,
+                             Optional<bool> cacheAware,
+                             StringRef profileFile, Optional<bool> packBits) {
+  auto pass = std::make_unique<AllocateStatePass>();
+  if (lanes)
+    pass->lanes = *lanes;
+  if (cacheAware)
+    pass->cacheAware = *cacheAware;
+  if (!profileFile.empty())
+    pass->profileFile.assign(profileFile);
+  if (packBits)
+    pass->packBits = *packBits;
+  return pass;
 }
@@ -0,0 +1,142 @@
+//===- CoalesceStateWrites.cpp --------------------------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass merges writes to states that are adjacent in the storage and
+// happen under the same condition into a single write of a wider state. After
+// `arc-group-resets-and-enables`, the registers reset or enabled together are
+// written one after the other within the same block, such that register files
+// end up being updated with a few wide stores instead of one store per
+// register.
+//
+//===----------------------------------------------------------------------===//
+
+#include "PassDetails.h"
+#include "mlir/IR/ImplicitLocOpBuilder.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
+#include "llvm/Support/Debug.h"
+
+#define DEBUG_TYPE "arc-coalesce-state-writes"
+
+using namespace mlir;
+using namespace circt;
+using namespace arc;
+
+namespace {
+/// A write to an allocated state, and the location of that state.
+struct WriteInfo {
+  StateWriteOp op;
+  Value storage;
+  unsigned offset;
+  unsigned numBytes;
+};
+
+struct CoalesceStateWritesPass
+    : public CoalesceStateWritesBase<CoalesceStateWritesPass> {
+  void runOnOperation() override;
+  void coalesceBlock(Block &block);
+  void coalesceWrites(ArrayRef<WriteInfo> writes);
+
+  using CoalesceStateWritesBase::lanes;
+  using CoalesceStateWritesBase::maxBytes;
+};
+} // namespace
+
+/// Return the location of the state a write goes to, or std::nullopt if the
+/// write cannot be merged with others. States whose width is not a multiple of
+/// a byte are left alone, since their padding bits are not defined.
+static std::optional<WriteInfo> getWriteInfo(StateWriteOp writeOp) {
+  auto getOp = writeOp.getState().getDefiningOp<StorageGetOp>();
+  if (!getOp || getOp.getBit())
+    return std::nullopt;
+  unsigned width = writeOp.getValue().getType().getIntOrFloatBitWidth();
+  if (width % 8 != 0)
+    return std::nullopt;
+  return WriteInfo{writeOp, getOp.getStorage(), getOp.getOffset(), width / 8};
+}
+
+void CoalesceStateWritesPass::runOnOperation() {
+  // With multiple lanes, the copies of the other instances sit between
+  // neighbouring states.
+  if (lanes > 1)
+    return;
+  getOperation().walk([&](Block *block) { coalesceBlock(*block); });
+}
+
+/// Find runs of writes to adjacent states in a block. Only side-effect free
+/// operations may sit between the writes of a run, such that the writes can be
+/// moved down to the last write in the run.
+void CoalesceStateWritesPass::coalesceBlock(Block &block) {
+  SmallVector<WriteInfo> run;
+  unsigned runBytes = 0;
+  auto flush = [&] {
+    if (run.size() > 1)
+      coalesceWrites(run);
+    run.clear();
+    runBytes = 0;
+  };
+
+  for (auto &op : llvm::make_early_inc_range(block)) {
+    auto writeOp = dyn_cast<StateWriteOp>(&op);
+    if (!writeOp) {
+      if (!isMemoryEffectFree(&op))
+        flush();
+      continue;
+    }
+    auto info = getWriteInfo(writeOp);
+    if (!info) {
+      flush();
+      continue;
+    }
+    if (!run.empty()) {
+      auto &last = run.back();
+      if (info->storage != last.storage ||
+          info->offset != last.offset + last.numBytes ||
+          writeOp.getCondition() != last.op.getCondition() ||
+          runBytes + info->numBytes > maxBytes)
+        flush();
+    }
+    run.push_back(*info);
+    runBytes += info->numBytes;
+  }
+  flush();
+}
+
+/// Replace a run of writes to adjacent states with one write of a state that
+/// spans all of them. The combined state has to be aligned like any other
+/// allocated state of its size.
+void CoalesceStateWritesPass::coalesceWrites(ArrayRef<WriteInfo> writes) {
+  auto &first = writes.front();
+  auto &last = writes.back();
+  unsigned numBytes = last.offset + last.numBytes - first.offset;
+  if (first.offset % llvm::bit_ceil(std::min(numBytes, 8U)) != 0)
+    return;
+  LLVM_DEBUG(llvm::dbgs() << "- Coalescing " << writes.size()
+                          << " writes into " << numBytes << " bytes at offset "
+                          << first.offset << "\n");
+
+  // The first state sits at the lowest address and thus forms the least
+  // significant bits of the combined value.
+  ImplicitLocOpBuilder builder(last.op.getLoc(), last.op);
+  SmallVector<Value> values;
+  for (auto &write : llvm::reverse(writes))
+    values.push_back(write.op.getValue());
+  Value value = builder.create<comb::ConcatOp>(values);
+  Value state = builder.create<StorageGetOp>(
+      StateType::get(builder.getIntegerType(numBytes * 8)), first.storage,
+      builder.getI32IntegerAttr(first.offset), IntegerAttr{});
+  builder.create<StateWriteOp>(state, value, last.op.getCondition());
+
+  for (auto &write : writes)
+    write.op.erase();
+  ++numWritesCreated;
+  numWritesCoalesced += writes.size();
+}
+
+std::unique_ptr<Pass> arc::createCoalesceStateWritesPass() {
+  return std::make_unique<CoalesceStateWritesPass>();
+}
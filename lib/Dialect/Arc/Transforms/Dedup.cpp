@@ -8,9 +8,10 @@
 
 #include "PassDetails.h"
 #include "mlir/IR/BuiltinAttributes.h"
+#include "mlir/IR/Threading.h"
 #include "llvm/ADT/SetVector.h"
 #include "llvm/Support/Debug.h"
-#include "llvm/Support/SHA256.h"
+#include "llvm/Support/xxhash.h"
 
 #define DEBUG_TYPE "arc-dedup"
 
@@ -21,8 +22,11 @@ using llvm::SmallMapVector;
 using llvm::SmallSetVector;
 
 namespace {
+/// The structural hashes of an arc. These are non-cryptographic hashes, such
+/// that arcs with the same hash are only candidates for deduplication, which
+/// have to be confirmed by comparing the arcs.
 struct StructuralHash {
-  using Hash = std::array<uint8_t, 32>;
+  using Hash = std::pair<uint64_t, uint64_t>;
   Hash hash;
   Hash constInvariant; // a hash that ignores constants
 };
@@ -33,39 +37,46 @@ struct StructuralHasher {
   StructuralHash hash(DefineOp arc) {
     reset();
     update(arc);
-    return StructuralHash{state.final(), stateConstInvariant.final()};
+    return StructuralHash{getHash(buffer), getHash(bufferConstInvariant)};
   }
 
 private:
   void reset() {
     currentIndex = 0;
+    currentIndexConstInvariant = 0;
     disableConstInvariant = 0;
     indices.clear();
     indicesConstInvariant.clear();
-    state.init();
-    stateConstInvariant.init();
+    buffer.clear();
+    bufferConstInvariant.clear();
+  }
+
+  /// Hash the bytes collected in a buffer, followed by their number.
+  static StructuralHash::Hash getHash(ArrayRef<uint8_t> bytes) {
+    return {llvm::xxHash64(bytes), bytes.size()};
+  }
+
+  void update(ArrayRef<uint8_t> bytes) {
+    buffer.append(bytes.begin(), bytes.end());
+    if (disableConstInvariant == 0)
+      bufferConstInvariant.append(bytes.begin(), bytes.end());
   }
 
   void update(const void *pointer) {
     auto *addr = reinterpret_cast<const uint8_t *>(&pointer);
-    state.update(ArrayRef<uint8_t>(addr, sizeof pointer));
-    if (disableConstInvariant == 0)
-      stateConstInvariant.update(ArrayRef<uint8_t>(addr, sizeof pointer));
+    update(ArrayRef<uint8_t>(addr, sizeof pointer));
   }
 
   void update(size_t value) {
     auto *addr = reinterpret_cast<const uint8_t *>(&value);
-    state.update(ArrayRef<uint8_t>(addr, sizeof value));
-    if (disableConstInvariant == 0)
-      stateConstInvariant.update(ArrayRef<uint8_t>(addr, sizeof value));
+    update(ArrayRef<uint8_t>(addr, sizeof value));
   }
 
   void update(size_t value, size_t valueConstInvariant) {
-    state.update(ArrayRef<uint8_t>(reinterpret_cast<const uint8_t *>(&value),
-                                   sizeof value));
-    state.update(ArrayRef<uint8_t>(
-        reinterpret_cast<const uint8_t *>(&valueConstInvariant),
-        sizeof valueConstInvariant));
+    buffer.append(reinterpret_cast<const uint8_t *>(&value),
+                  reinterpret_cast<const uint8_t *>(&value + 1));
+    buffer.append(reinterpret_cast<const uint8_t *>(&valueConstInvariant),
+                  reinterpret_cast<const uint8_t *>(&valueConstInvariant + 1));
   }
 
   void update(TypeID typeID) { update(typeID.getAsOpaquePointer()); }
@@ -160,10 +171,10 @@ private:
 
   unsigned disableConstInvariant = 0;
 
-  // This is the actual running hash calculation. This is a stateful element
-  // that should be reinitialized after each hash is produced.
-  llvm::SHA256 state;
-  llvm::SHA256 stateConstInvariant;
+  // The bytes to be hashed, which are collected while walking the arc and
+  // hashed at the end.
+  SmallVector<uint8_t, 0> buffer;
+  SmallVector<uint8_t, 0> bufferConstInvariant;
 };
 } // namespace
 
@@ -375,13 +386,39 @@ void DedupPass::runOnOperation() {
   callSites.clear();
   SymbolTableCollection symbolTable;
 
-  // Compute the structural hash for each arc definition.
-  SmallVector<ArcHash> arcHashes;
-  StructuralHasher hasher(&getContext());
+  // Compute the structural hash for each arc definition. Arcs are hashed
+  // independently of each other, so this can happen in parallel.
+  SmallVector<DefineOp> defineOps;
   for (auto defineOp : getOperation().getOps<DefineOp>()) {
-    arcHashes.emplace_back(defineOp, hasher.hash(defineOp), arcHashes.size());
+    defineOps.push_back(defineOp);
     arcByName.insert({defineOp.getSymNameAttr(), defineOp});
   }
+  SmallVector<StructuralHash> hashes(defineOps.size());
+  mlir::parallelFor(&getContext(), 0, defineOps.size(), [&](size_t index) {
+    StructuralHasher hasher(&getContext());
+    hashes[index] = hasher.hash(defineOps[index]);
+  });
+  SmallVector<ArcHash> arcHashes;
+  arcHashes.reserve(defineOps.size());
+  for (auto [defineOp, hash] : llvm::zip(defineOps, hashes))
+    arcHashes.emplace_back(defineOp, hash, arcHashes.size());
+
+  // Record the number and size of the groups of arcs with the same hash, which
+  // have to be compared with each other. The arcs must be sorted by hash.
+  auto countCandidates = [&](auto getHash) {
+    for (unsigned idx = 0, end = arcHashes.size(); idx != end;) {
+      unsigned groupEnd = idx + 1;
+      while (groupEnd != end && getHash(arcHashes[groupEnd].hash) ==
+                                    getHash(arcHashes[idx].hash))
+        ++groupEnd;
+      if (groupEnd - idx > 1) {
+        ++numCandidateGroups;
+        if (groupEnd - idx > maxCandidateGroupSize)
+          maxCandidateGroupSize = groupEnd - idx;
+      }
+      idx = groupEnd;
+    }
+  };
 
   // Collect the arc call sites.
   getOperation().walk([&](CallOpMutableInterface callOp) {
@@ -404,6 +441,7 @@ void DedupPass::runOnOperation() {
       return false;
     return a.order < b.order;
   });
+  countCandidates([](auto &hash) { return hash.hash; });
 
   // Perform deduplications that do not require modification of the arc call
   // sites. (No additional ports.)
@@ -455,6 +493,7 @@ void DedupPass::runOnOperation() {
   });
   while (!arcHashes.empty() && !arcHashes.back().defineOp)
     arcHashes.pop_back();
+  countCandidates([](auto &hash) { return hash.constInvariant; });
 
   // Perform deduplication of arcs that differ only in constant values.
   LLVM_DEBUG(llvm::dbgs() << "Check for constant-agnostic merges ("
@@ -721,6 +760,7 @@ void DedupPass::replaceArcWith(DefineOp oldArc, DefineOp newArc) {
   callSites.erase(oldArc);
   arcByName.erase(oldArc.getSymNameAttr());
   oldArc->erase();
+  ++numDedupedArcs;
 }
 
 std::unique_ptr<Pass> arc::createDedupPass() {
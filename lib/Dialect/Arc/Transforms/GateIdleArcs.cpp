@@ -0,0 +1,172 @@
+//===- GateIdleArcs.cpp ---------------------------------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "PassDetails.h"
+#include "llvm/Support/Debug.h"
+
+#define DEBUG_TYPE "arc-gate-idle-arcs"
+
+using namespace mlir;
+using namespace circt;
+using namespace arc;
+
+//===----------------------------------------------------------------------===//
+// Pass Implementation
+//===----------------------------------------------------------------------===//
+
+namespace {
+struct GateIdleArcsPass : public GateIdleArcsBase<GateIdleArcsPass> {
+  void runOnOperation() override;
+  bool isWorthGating(DefineOp defOp);
+  void gateArcUse(StateOp stateOp, ArrayRef<StateWriteOp> writes,
+                  Value storage);
+
+  using GateIdleArcsBase::minNonTrivialOps;
+
+  SymbolTableCollection symbolTable;
+  /// Whether an arc definition is expensive enough to be gated.
+  DenseMap<DefineOp, bool> worthGating;
+};
+} // namespace
+
+void GateIdleArcsPass::runOnOperation() {
+  worthGating.clear();
+  for (auto modelOp : getOperation().getOps<ModelOp>()) {
+    auto storage = modelOp.getBody().getArgument(0);
+    for (auto clockTreeOp : modelOp.getBody().getOps<ClockTreeOp>()) {
+      // Collect the latency-free uses of arcs in the clock tree whose results
+      // are only written to states in the same block. Evaluating such a use
+      // again with the same inputs would write the same values again. These
+      // may be nested in the `scf.if` ops that implement resets.
+      SmallVector<std::pair<StateOp, SmallVector<StateWriteOp>>> candidates;
+      clockTreeOp.walk([&](StateOp stateOp) {
+        if (stateOp.getLatency() != 0 || stateOp.getClock() ||
+            stateOp.getEnable() || stateOp.getReset())
+          return;
+        if (!llvm::all_of(stateOp.getInputs().getTypes(),
+                          [](Type type) { return type.isa<IntegerType>(); }))
+          return;
+        auto defOp = dyn_cast_or_null<DefineOp>(
+            cast<CallOpInterface>(stateOp.getOperation())
+                .resolveCallable(&symbolTable));
+        if (!defOp || !isWorthGating(defOp))
+          return;
+
+        SmallVector<StateWriteOp> writes;
+        bool onlyWritten = llvm::all_of(stateOp->getUsers(), [&](auto *user) {
+          auto writeOp = dyn_cast<StateWriteOp>(user);
+          if (!writeOp || writeOp->getBlock() != stateOp->getBlock() ||
+              writeOp.getValue().getDefiningOp() != stateOp)
+            return false;
+          writes.push_back(writeOp);
+          return true;
+        });
+        if (!onlyWritten || writes.empty())
+          return;
+        llvm::sort(writes,
+                   [](auto a, auto b) { return a->isBeforeInBlock(b); });
+        writes.erase(std::unique(writes.begin(), writes.end()), writes.end());
+        candidates.push_back({stateOp, std::move(writes)});
+      });
+
+      for (auto &[stateOp, writes] : candidates)
+        gateArcUse(stateOp, writes, storage);
+    }
+  }
+}
+
+/// Check whether an arc contains enough operations to make comparing its inputs
+/// on every clock tick cheaper than just evaluating it.
+bool GateIdleArcsPass::isWorthGating(DefineOp defOp) {
+  auto [it, inserted] = worthGating.insert({defOp, false});
+  if (!inserted)
+    return it->second;
+  unsigned numNonTrivialOps = 0;
+  defOp.getBodyBlock().walk([&](Operation *op) {
+    if (!op->hasTrait<OpTrait::ConstantLike>() && !isa<OutputOp>(op))
+      ++numNonTrivialOps;
+  });
+  it->second = numNonTrivialOps >= minNonTrivialOps;
+  return it->second;
+}
+
+/// Move an arc use and the state writes of its results into an `scf.if` that
+/// only executes if the arc's inputs or the write enables differ from the ones
+/// seen during the last evaluation.
+void GateIdleArcsPass::gateArcUse(StateOp stateOp,
+                                  ArrayRef<StateWriteOp> writes,
+                                  Value storage) {
+  auto loc = stateOp.getLoc();
+  LLVM_DEBUG(llvm::dbgs() << "- Gating use of " << stateOp.getArcAttr()
+                          << "\n");
+
+  // The enables of the writes decide whether the transfer function's result
+  // ends up in the state, so they need to be tracked alongside the inputs.
+  SetVector<Value> inputs;
+  inputs.insert(stateOp.getInputs().begin(), stateOp.getInputs().end());
+  for (auto writeOp : writes)
+    if (auto condition = writeOp.getCondition())
+      inputs.insert(condition);
+
+  // Allocate a shadow copy of each input, and a flag indicating whether the
+  // shadow copy is valid.
+  OpBuilder builder(stateOp->getParentOfType<ClockTreeOp>());
+  SmallVector<Value> shadows;
+  for (auto input : inputs)
+    shadows.push_back(builder.create<AllocStateOp>(
+        loc, StateType::get(input.getType().cast<IntegerType>()), storage));
+  Value valid = builder.create<AllocStateOp>(
+      loc, StateType::get(builder.getI1Type()), storage);
+
+  // Compare the inputs against the shadow copy where the last write used to
+  // be. All inputs and enables are available at that point.
+  builder.setInsertionPoint(writes.back());
+  Value constTrue = builder.create<hw::ConstantOp>(loc, APInt(1, 1));
+  SmallVector<Value> changes;
+  changes.push_back(builder.create<comb::XorOp>(
+      loc, builder.create<StateReadOp>(loc, valid), constTrue, true));
+  for (auto [input, shadow] : llvm::zip(inputs, shadows))
+    changes.push_back(builder.create<comb::ICmpOp>(
+        loc, comb::ICmpPredicate::ne, input,
+        builder.create<StateReadOp>(loc, shadow), true));
+  Value changed = builder.create<comb::OrOp>(loc, changes, true);
+
+  // Only evaluate the arc and update the shadow copy if anything changed.
+  auto ifOp = builder.create<scf::IfOp>(loc, changed, false);
+  auto thenBuilder = ifOp.getThenBodyBuilder();
+  for (auto [input, shadow] : llvm::zip(inputs, shadows))
+    thenBuilder.create<StateWriteOp>(loc, shadow, input, Value{});
+  thenBuilder.create<StateWriteOp>(loc, valid, constTrue, Value{});
+  auto *terminator = ifOp.thenBlock()->getTerminator();
+  stateOp->moveBefore(terminator);
+  for (auto writeOp : writes)
+    writeOp->moveBefore(terminator);
+
+  // Any other write to the gated states, for example a reset, makes the shadow
+  // copy stale.
+  SmallPtrSet<Operation *, 4> gatedWrites;
+  for (auto writeOp : writes)
+    gatedWrites.insert(writeOp);
+  for (auto writeOp : writes) {
+    for (auto *user : writeOp.getState().getUsers()) {
+      auto otherWrite = dyn_cast<StateWriteOp>(user);
+      if (!otherWrite || gatedWrites.contains(otherWrite))
+        continue;
+      OpBuilder writeBuilder(otherWrite);
+      writeBuilder.setInsertionPointAfter(otherWrite);
+      Value constFalse = writeBuilder.create<hw::ConstantOp>(loc, APInt(1, 0));
+      writeBuilder.create<StateWriteOp>(loc, valid, constFalse,
+                                        otherWrite.getCondition());
+    }
+  }
+  ++numGatedArcs;
+}
+
+std::unique_ptr<Pass> arc::createGateIdleArcsPass() {
+  return std::make_unique<GateIdleArcsPass>();
+}
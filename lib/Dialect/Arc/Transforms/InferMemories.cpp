@@ -25,6 +25,9 @@ struct InferMemoriesPass : public InferMemoriesBase<InferMemoriesPass> {
   SmallVector<Operation *> opsToDelete;
   SmallPtrSet<StringAttr, 2> schemaNames;
   DenseMap<StringAttr, DictionaryAttr> memoryParams;
+
+  using InferMemoriesBase::pageSize;
+  using InferMemoriesBase::sparseThreshold;
 };
 } // namespace
 
@@ -91,6 +94,18 @@ void InferMemoriesPass::runOnOperation() {
       return signalPassFailure();
     }
     auto memType = MemoryType::get(&getContext(), depth, wordType, addressTy);
+
+    // Store large memories as a table of pages that are only allocated once
+    // they are written.
+    if (sparseThreshold != 0 && depth * memType.getStride() > sparseThreshold) {
+      unsigned wordsPerPage = llvm::bit_floor(
+          std::max<unsigned>(pageSize / memType.getStride(), 1));
+      if (wordsPerPage < depth) {
+        memType = MemoryType::get(&getContext(), depth, wordType, addressTy,
+                                  wordsPerPage);
+        ++numSparseMemories;
+      }
+    }
     auto memOp = builder.create<MemoryOp>(memType);
     if (!instOp.getInstanceName().empty())
       memOp->setAttr("name", instOp.getInstanceNameAttr());
@@ -240,6 +255,10 @@ void InferMemoriesPass::runOnOperation() {
     op->erase();
 }
 
-std::unique_ptr<Pass> arc::createInferMemoriesPass() {
-  return std::make_unique<InferMemoriesPass>();
+std::unique_ptr<Pass>
+arc::createInferMemoriesPass(llvm::Optional<uint64_t> sparseThreshold) {
+  auto pass = std::make_unique<InferMemoriesPass>();
+  if (sparseThreshold)
+    pass->sparseThreshold = *sparseThreshold;
+  return pass;
 }
@@ -7,6 +7,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "PassDetails.h"
+#include "circt/Dialect/Arc/ActivityProfile.h"
 #include "mlir/IR/IRMapping.h"
 #include "mlir/Transforms/InliningUtils.h"
 #include "llvm/Support/Debug.h"
@@ -30,6 +31,11 @@ struct InlineArcsPass : public InlineArcsBase<InlineArcsPass> {
 
   void runOnOperation() override;
   bool shouldInline(DefineOp defOp, ArrayRef<mlir::CallOpInterface> users);
+
+  using InlineArcsBase::profileFile;
+
+  /// The activity profile guiding the inlining decisions, if any.
+  std::optional<ActivityProfile> profile;
 };
 
 /// A simple implementation of the `InlinerInterface` that marks all inlining as
@@ -53,6 +59,14 @@ struct ArcInliner : public InlinerInterface {
 void InlineArcsPass::runOnOperation() {
   auto module = getOperation();
 
+  profile.reset();
+  if (!profileFile.empty()) {
+    auto loadedProfile = ActivityProfile::load(profileFile, module.getLoc());
+    if (failed(loadedProfile))
+      return signalPassFailure();
+    profile = std::move(*loadedProfile);
+  }
+
   // Store the call hierarcy manually since we need to keep it updated and the
   // provided datastructures do not seem to support this
   DenseMap<DefineOp, DenseSet<DefineOp>> arcsCalledInBody;
@@ -185,15 +199,33 @@ bool InlineArcsPass::shouldInline(DefineOp defOp,
   LLVM_DEBUG(llvm::dbgs() << "Arc " << defOp.getSymName() << " has "
                           << numNonTrivialOps << " non-trivial ops\n");
 
+  // Keep arcs that are never called out of line, such that they don't take up
+  // space in the instruction cache between the frequently executed code.
+  if (profile && profile->isCold(defOp.getSymName())) {
+    ++numColdArcs;
+    return false;
+  }
+
   // Check if the arc is only ever used once.
   if (users.size() == 1) {
     ++numSingleUseArcs;
     return true;
   }
 
+  // Inline larger arcs if they are called in every cycle, which saves the call
+  // overhead on the hot path.
+  if (profile && profile->isHot(defOp.getSymName()) &&
+      numNonTrivialOps <= maxNonTrivialOpsInHotBody) {
+    ++numHotArcs;
+    return true;
+  }
+
   return false;
 }
 
-std::unique_ptr<Pass> arc::createInlineArcsPass() {
-  return std::make_unique<InlineArcsPass>();
+std::unique_ptr<Pass> arc::createInlineArcsPass(StringRef profileFile) {
+  auto pass = std::make_unique<InlineArcsPass>();
+  if (!profileFile.empty())
+    pass->profileFile.assign(profileFile);
+  return pass;
 }
@@ -24,6 +24,7 @@ using mlir::InlinerInterface;
 namespace {
 struct InlineModulesPass : public InlineModulesBase<InlineModulesPass> {
   void runOnOperation() override;
+  bool shouldInline(HWModuleOp module, unsigned numInstances);
 };
 
 /// A simple implementation of the `InlinerInterface` that marks all inlining as
@@ -76,6 +77,26 @@ struct PrefixingInliner : public InlinerInterface {
 };
 } // namespace
 
+/// Check the size of the module against the thresholds of the pass. Expects
+/// the children of the module to be inlined already.
+bool InlineModulesPass::shouldInline(HWModuleOp module, unsigned numInstances) {
+  if (maxSize == 0 && maxGrowth == 0)
+    return true;
+  uint64_t size = 0;
+  module.getBody().walk([&](Operation *) { ++size; });
+  uint64_t growth = size * (numInstances - 1);
+  if ((maxSize != 0 && size > maxSize) ||
+      (maxGrowth != 0 && growth > maxGrowth)) {
+    LLVM_DEBUG(llvm::dbgs() << "Not inlining " << module.getModuleName()
+                            << " with " << size << " ops into " << numInstances
+                            << " instances\n");
+    ++numKeptModules;
+    return false;
+  }
+  numOpsGrowth += growth;
+  return true;
+}
+
 void InlineModulesPass::runOnOperation() {
   auto &instanceGraph = getAnalysis<InstanceGraph>();
   DenseSet<Operation *> handled;
@@ -97,13 +118,13 @@ void InlineModulesPass::runOnOperation() {
       if (numUsesLeft == 0)
         continue;
 
-      for (auto *instRecord : node->uses()) {
-        // Only inline private `HWModuleOp`s (no extern or generated modules).
-        auto module =
-            dyn_cast_or_null<HWModuleOp>(node->getModule().getOperation());
-        if (!module || !module.isPrivate())
-          continue;
+      // Only inline private `HWModuleOp`s (no extern or generated modules).
+      auto module =
+          dyn_cast_or_null<HWModuleOp>(node->getModule().getOperation());
+      if (!module || !module.isPrivate() || !shouldInline(module, numUsesLeft))
+        continue;
 
+      for (auto *instRecord : node->uses()) {
         // Only inline at plain old HW `InstanceOp`s.
         auto inst = dyn_cast_or_null<InstanceOp>(
             instRecord->getInstance().getOperation());
@@ -123,6 +144,7 @@ void InlineModulesPass::runOnOperation() {
         }
 
         inst.erase();
+        ++numInlinedInstances;
         if (isLastModuleUse)
           module->erase();
       }
@@ -35,11 +35,20 @@ struct LowerClocksToFuncsPass
                            OpBuilder &funcBuilder);
   LogicalResult isolateClock(Operation *clockOp, Value modelStorageArg,
                              Value clockStorageArg);
+  void splitFunc(func::FuncOp funcOp);
 
   SymbolTable *symbolTable;
+  /// The functions created for the partitions of a clock tree and their commit
+  /// function, in the order in which they have to be called.
+  SmallVector<func::FuncOp> partitionFuncs;
+  /// The number of clock trees lowered so far which are not partitions of
+  /// another clock tree, which determines the name of the next one.
+  unsigned numClocks = 0;
 
   Statistic numOpsCopied{this, "ops-copied", "Ops copied into clock trees"};
   Statistic numOpsMoved{this, "ops-moved", "Ops moved into clock trees"};
+  Statistic numFuncsSplit{this, "funcs-split",
+                          "Functions split off large clock functions"};
 };
 } // namespace
 
@@ -63,10 +72,30 @@ LogicalResult LowerClocksToFuncsPass::lowerModel(ModelOp modelOp) {
 
   // Perform the actual extraction.
   OpBuilder funcBuilder(modelOp);
+  partitionFuncs.clear();
+  numClocks = 0;
   for (auto *op : clocks)
     if (failed(lowerClock(op, modelOp.getBody().getArgument(0), funcBuilder)))
       return failure();
 
+  // If the clock tree was partitioned, create a clock function that evaluates
+  // all partitions one after the other, followed by the commit. Runtimes may
+  // call the partition functions concurrently instead.
+  if (!partitionFuncs.empty()) {
+    auto loc = modelOp.getLoc();
+    auto storageType = modelOp.getBody().getArgument(0).getType();
+    auto funcOp = funcBuilder.create<func::FuncOp>(
+        loc, (modelOp.getName() + "_clock").str(),
+        funcBuilder.getFunctionType({storageType}, {}));
+    symbolTable->insert(funcOp);
+    auto *block = funcOp.addEntryBlock();
+    auto builder = OpBuilder::atBlockEnd(block);
+    for (auto partitionFunc : partitionFuncs)
+      builder.create<func::CallOp>(loc, partitionFunc,
+                                   ValueRange{block->getArgument(0)});
+    builder.create<func::ReturnOp>(loc);
+  }
+
   return success();
 }
 
@@ -94,11 +123,22 @@ LogicalResult LowerClocksToFuncsPass::lowerClock(Operation *clockOp,
   // Pick a name for the clock function.
   SmallString<32> funcName;
   funcName.append(clockOp->getParentOfType<ModelOp>().getName());
-  funcName.append(isa<PassThroughOp>(clockOp) ? "_passthrough" : "_clock");
+  auto partitionAttr = clockOp->getAttrOfType<IntegerAttr>("arc.partition");
+  bool isCommit = clockOp->hasAttr("arc.partition_commit");
+  if (isa<PassThroughOp>(clockOp))
+    funcName.append("_passthrough");
+  else if (partitionAttr)
+    funcName.append("_clock_part" + Twine(partitionAttr.getInt()).str());
+  else if (isCommit)
+    funcName.append("_clock_commit");
+  else
+    funcName = getClockFunctionName(funcName, numClocks++);
   auto funcOp = funcBuilder.create<func::FuncOp>(
       clockOp->getLoc(), funcName,
       builder.getFunctionType({modelStorageArg.getType()}, {}));
   symbolTable->insert(funcOp); // uniquifies the name
+  if (partitionAttr || isCommit)
+    partitionFuncs.push_back(funcOp);
   LLVM_DEBUG(llvm::dbgs() << "  - Created function `" << funcOp.getSymName()
                           << "`\n");
 
@@ -111,9 +151,118 @@ LogicalResult LowerClocksToFuncsPass::lowerClock(Operation *clockOp,
   funcOp.getBody().takeBody(clockRegion);
   clockOp->erase();
 
+  if (maxOpsPerFunc > 0)
+    splitFunc(funcOp);
+
   return success();
 }
 
+/// Split the body of a clock function into functions of at least
+/// `maxOpsPerFunc` operations each, which the clock function then calls in
+/// order. LLVM takes a long time to compile very large functions, since many of
+/// its passes are superlinear in the size of a function. A split is only made
+/// between two operations if no values other than constants are live across
+/// it; constants are copied into every function that uses them.
+void LowerClocksToFuncsPass::splitFunc(func::FuncOp funcOp) {
+  auto &block = funcOp.getBody().front();
+  SmallVector<Operation *> ops;
+  DenseMap<Operation *, unsigned> opIndices;
+  for (auto &op : block.without_terminator()) {
+    opIndices[&op] = ops.size();
+    ops.push_back(&op);
+  }
+
+  // Determine the last operation in the block that uses the results of each
+  // operation.
+  SmallVector<unsigned> lastUses(ops.size());
+  SmallVector<unsigned> opSizes(ops.size(), 0);
+  for (unsigned idx = 0; idx < ops.size(); ++idx) {
+    auto *op = ops[idx];
+    op->walk([&](Operation *) { ++opSizes[idx]; });
+    lastUses[idx] = idx;
+    if (op->hasTrait<ConstantLike>())
+      continue;
+    for (auto *user : op->getUsers())
+      if (auto *ancestor = block.findAncestorOpInBlock(*user))
+        if (auto it = opIndices.find(ancestor); it != opIndices.end())
+          lastUses[idx] = std::max(lastUses[idx], it->second);
+  }
+
+  // Greedily form chunks of at least `maxOpsPerFunc` operations.
+  SmallVector<std::pair<unsigned, unsigned>> chunks;
+  unsigned chunkBegin = 0;
+  unsigned chunkSize = 0;
+  unsigned liveUntil = 0;
+  for (unsigned idx = 0; idx < ops.size(); ++idx) {
+    chunkSize += opSizes[idx];
+    liveUntil = std::max(liveUntil, lastUses[idx]);
+    if (chunkSize >= maxOpsPerFunc && liveUntil == idx) {
+      chunks.push_back({chunkBegin, idx + 1});
+      chunkBegin = idx + 1;
+      chunkSize = 0;
+    }
+  }
+  if (chunkBegin < ops.size())
+    chunks.push_back({chunkBegin, ops.size()});
+  if (chunks.size() < 2)
+    return;
+  LLVM_DEBUG(llvm::dbgs() << "  - Splitting into " << chunks.size()
+                          << " functions\n");
+
+  // Move each chunk into a separate function and call it.
+  Value storageArg = block.getArgument(0);
+  OpBuilder builder(funcOp);
+  for (auto [chunkIdx, chunk] : llvm::enumerate(chunks)) {
+    Operation *firstOp = ops[chunk.first];
+    Operation *lastOp = ops[chunk.second - 1];
+    auto loc = firstOp->getLoc();
+    auto chunkFunc = builder.create<func::FuncOp>(
+        loc, (funcOp.getSymName() + "_split" + Twine(chunkIdx)).str(),
+        funcOp.getFunctionType());
+    symbolTable->insert(chunkFunc); // uniquifies the name
+    ++numFuncsSplit;
+
+    OpBuilder callBuilder(firstOp);
+    callBuilder.create<func::CallOp>(loc, chunkFunc, ValueRange{storageArg});
+
+    auto *chunkBlock = chunkFunc.addEntryBlock();
+    chunkBlock->getOperations().splice(chunkBlock->end(), block.getOperations(),
+                                       firstOp->getIterator(),
+                                       std::next(lastOp->getIterator()));
+    auto chunkBuilder = OpBuilder::atBlockEnd(chunkBlock);
+    chunkBuilder.create<func::ReturnOp>(loc);
+
+    // Use the function's storage argument and copy in any constants defined
+    // in other chunks.
+    SmallVector<OpOperand *> externalOperands;
+    chunkFunc.walk([&](Operation *op) {
+      for (auto &operand : op->getOpOperands()) {
+        auto *definingOp = operand.get().getDefiningOp();
+        if (!definingOp || !chunkFunc->isAncestor(definingOp))
+          externalOperands.push_back(&operand);
+      }
+    });
+    chunkBuilder.setInsertionPointToStart(chunkBlock);
+    DenseMap<Value, Value> copiedValues;
+    for (auto *operand : externalOperands) {
+      if (operand->get() == storageArg) {
+        operand->set(chunkBlock->getArgument(0));
+        continue;
+      }
+      auto &copiedValue = copiedValues[operand->get()];
+      if (!copiedValue) {
+        auto result = operand->get().cast<OpResult>();
+        assert(result.getOwner()->hasTrait<ConstantLike>() &&
+               "only constants may be live across chunks");
+        copiedValue = chunkBuilder.clone(*result.getOwner())
+                          ->getResult(result.getResultNumber());
+        ++numOpsCopied;
+      }
+      operand->set(copiedValue);
+    }
+  }
+}
+
 /// Copy any external constants that the clock tree might be using into its
 /// body. Anything besides constants should no longer exist after a proper run
 /// of the pipeline.
@@ -191,6 +340,9 @@ LogicalResult LowerClocksToFuncsPass::isolateClock(Operation *clockOp,
   return success(!result.wasInterrupted());
 }
 
-std::unique_ptr<Pass> arc::createLowerClocksToFuncsPass() {
-  return std::make_unique<LowerClocksToFuncsPass>();
+std::unique_ptr<Pass>
+arc::createLowerClocksToFuncsPass(unsigned maxOpsPerFunc) {
+  auto pass = std::make_unique<LowerClocksToFuncsPass>();
+  pass->maxOpsPerFunc = maxOpsPerFunc;
+  return pass;
 }
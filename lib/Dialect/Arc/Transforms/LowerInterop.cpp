@@ -0,0 +1,123 @@
+//===- LowerInterop.cpp ---------------------------------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "PassDetails.h"
+#include "circt/Dialect/Interop/InteropOps.h"
+#include "mlir/Transforms/RegionUtils.h"
+#include "llvm/Support/Debug.h"
+
+#define DEBUG_TYPE "arc-lower-interop"
+
+using namespace mlir;
+using namespace circt;
+using namespace arc;
+
+//===----------------------------------------------------------------------===//
+// Pass Implementation
+//===----------------------------------------------------------------------===//
+
+namespace {
+struct LowerInteropPass : public LowerInteropBase<LowerInteropPass> {
+  void runOnOperation() override;
+  LogicalResult lowerProcedure(interop::ProceduralUpdateOp updateOp,
+                               hw::HWModuleOp moduleOp);
+
+  SymbolTable *symbolTable;
+};
+} // namespace
+
+void LowerInteropPass::runOnOperation() {
+  symbolTable = &getAnalysis<SymbolTable>();
+  bool anyFailed = false;
+  for (auto moduleOp : getOperation().getOps<hw::HWModuleOp>()) {
+    SmallVector<interop::ProceduralUpdateOp> updateOps;
+    moduleOp.walk([&](Operation *op) {
+      if (isa<interop::ProceduralAllocOp, interop::ProceduralInitOp,
+              interop::ProceduralDeallocOp>(op)) {
+        op->emitOpError("is not supported in arc models; the foreign side has "
+                        "to keep its state itself");
+        anyFailed = true;
+      } else if (auto updateOp = dyn_cast<interop::ProceduralUpdateOp>(op)) {
+        updateOps.push_back(updateOp);
+      }
+    });
+    for (auto updateOp : updateOps)
+      if (failed(lowerProcedure(updateOp, moduleOp)))
+        anyFailed = true;
+  }
+  if (anyFailed)
+    return signalPassFailure();
+}
+
+/// Outline the body of an update procedure into a function, and replace the
+/// procedure with a call of that function.
+LogicalResult
+LowerInteropPass::lowerProcedure(interop::ProceduralUpdateOp updateOp,
+                                 hw::HWModuleOp moduleOp) {
+  LLVM_DEBUG(llvm::dbgs() << "Lowering procedure " << updateOp.getLoc()
+                          << "\n");
+  if (updateOp.getInteropMechanism() != interop::InteropMechanism::CFFI)
+    return updateOp.emitOpError("with a mechanism other than `cffi` is not "
+                                "supported in arc models");
+  if (!updateOp.getStates().empty())
+    return updateOp.emitOpError("with state is not supported in arc models; "
+                                "the foreign side has to keep its state "
+                                "itself");
+  // Only the results keep the call alive during state lowering, so a
+  // procedure without any would silently disappear.
+  if (updateOp.getNumResults() == 0)
+    return updateOp.emitOpError("without results is not supported in arc "
+                                "models");
+
+  // The function is isolated from the module, so constants used within the
+  // body are cloned into it. Other values have to be passed as inputs.
+  auto &region = updateOp.getUpdateRegion();
+  SetVector<Value> capturedValues;
+  getUsedValuesDefinedAbove(region, capturedValues);
+  OpBuilder builder(&getContext());
+  builder.setInsertionPointToStart(&region.front());
+  for (auto value : capturedValues) {
+    auto *defOp = value.getDefiningOp();
+    if (!defOp || !defOp->hasTrait<OpTrait::ConstantLike>()) {
+      auto d = updateOp.emitOpError("uses a non-constant value defined outside "
+                                    "of it; pass it as an input instead");
+      d.attachNote(value.getLoc()) << "value defined here";
+      return d;
+    }
+    auto *clonedOp = builder.clone(*defOp);
+    replaceAllUsesInRegionWith(value, clonedOp->getResult(0), region);
+  }
+
+  // Create the function and move the body into it.
+  builder.setInsertionPoint(moduleOp);
+  auto funcOp = builder.create<func::FuncOp>(
+      updateOp.getLoc(), (moduleOp.getName() + "_interop").str(),
+      builder.getFunctionType(updateOp.getInputs().getTypes(),
+                              updateOp.getResultTypes()));
+  funcOp.setPrivate();
+  symbolTable->insert(funcOp); // uniquifies the name
+  funcOp.getBody().takeBody(region);
+  auto returnOp = cast<interop::ReturnOp>(funcOp.front().getTerminator());
+  builder.setInsertionPoint(returnOp);
+  builder.create<func::ReturnOp>(returnOp.getLoc(),
+                                 returnOp.getReturnValues());
+  returnOp.erase();
+
+  // Call the function in place of the procedure.
+  builder.setInsertionPoint(updateOp);
+  auto callOp = builder.create<func::CallOp>(updateOp.getLoc(), funcOp,
+                                             updateOp.getInputs());
+  updateOp.replaceAllUsesWith(callOp.getResults());
+  updateOp.erase();
+  ++numProcedures;
+  return success();
+}
+
+std::unique_ptr<Pass> arc::createLowerInteropPass() {
+  return std::make_unique<LowerInteropPass>();
+}
@@ -663,6 +663,19 @@ void LowerStatePass::runOnOperation() {
 LogicalResult LowerStatePass::runOnModule(HWModuleOp moduleOp) {
   LLVM_DEBUG(llvm::dbgs() << "Lowering state in `" << moduleOp.getModuleName()
                           << "`\n");
+
+  // The hierarchy has to be flattened at this point. Instances are left behind
+  // if the module inliner ran with size limits and kept a module.
+  auto result = moduleOp.walk([&](hw::InstanceOp instOp) {
+    auto d = instOp.emitError("instance of '")
+             << instOp.getModuleName() << "' cannot be lowered to state";
+    d.attachNote() << "modules have to be inlined before lowering state; "
+                      "check the limits of `arc-inline-modules`";
+    return WalkResult::interrupt();
+  });
+  if (result.wasInterrupted())
+    return failure();
+
   ModuleLowering lowering(moduleOp, stats);
   lowering.addStorageArg();
   if (failed(lowering.lowerStates()))
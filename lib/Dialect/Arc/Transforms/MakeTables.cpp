@@ -5,10 +5,23 @@
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 //
 //===----------------------------------------------------------------------===//
+//
+// This pass replaces expensive logic in arcs with lookup tables. Rather than
+// tabulating arcs as a whole, it looks for the largest subexpressions that
+// depend on few enough input bits to be tabulated, and whose evaluation is
+// estimated to be more expensive than the table lookup. The results of these
+// lookups are then treated as inputs of the remaining logic, such that the
+// logic downstream of multiple tables may itself become a table.
+//
+//===----------------------------------------------------------------------===//
 
 #include "PassDetails.h"
+#include "circt/Dialect/Arc/ActivityProfile.h"
+#include "circt/Dialect/Arc/ArcInterfaces.h"
 #include "circt/Dialect/Comb/CombOps.h"
 #include "mlir/IR/ImplicitLocOpBuilder.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
+#include "llvm/ADT/SetVector.h"
 #include "llvm/Support/Debug.h"
 
 #define DEBUG_TYPE "arc-lookup-tables"
@@ -19,159 +32,434 @@ using namespace hw;
 
 namespace {
 
-static constexpr int tableMinOpCount = 20;
-static constexpr int tableMaxSize = 32768; // bits
+/// The table inputs a value depends on, as long as they are few enough bits to
+/// index a table.
+struct Support {
+  llvm::SmallSetVector<Value, 4> inputs;
+  unsigned numBits = 0;
+  bool tooWide = false;
+};
+
+/// The layout of a table holding the values of one subexpression.
+struct TableLayout {
+  unsigned numIndexBits;
+  unsigned valueWidth;
+  /// The number of entries packed into each 64-bit word, or zero if the table
+  /// is an array of values.
+  unsigned entriesPerWord;
+
+  uint64_t getNumEntries() const { return uint64_t(1) << numIndexBits; }
+  uint64_t getNumBits() const { return getNumEntries() * valueWidth; }
+  uint64_t getNumWords() const {
+    return (getNumEntries() + entriesPerWord - 1) / entriesPerWord;
+  }
+
+  /// Return the number of bytes the table occupies in memory once lowered.
+  uint64_t getNumBytes() const {
+    if (entriesPerWord)
+      return getNumWords() * 8;
+    return getNumEntries() * llvm::PowerOf2Ceil((valueWidth + 7) / 8);
+  }
+};
 
 struct MakeTablesPass : public MakeTablesBase<MakeTablesPass> {
   void runOnOperation() override;
   void runOnArc(DefineOp defineOp);
+  bool makeTables(DefineOp defineOp);
+  void computeSupport(Block &block);
+  std::optional<TableLayout> getLayout(Value value);
+  uint32_t getSavedCost(Value root, ArrayRef<Operation *> slice);
+  uint32_t getLookupCost(const Support &support, const TableLayout &layout);
+  LogicalResult evaluate(Value root, ArrayRef<Operation *> slice,
+                         SmallVectorImpl<APInt> &entries);
+  Value materialize(Value root, const TableLayout &layout,
+                    ArrayRef<APInt> entries);
+
+  using MakeTablesBase::maxTableBits;
+  using MakeTablesBase::profileFile;
+
+  /// The values that act as table inputs. These are the arc arguments and the
+  /// results of table lookups.
+  DenseSet<Value> tableInputs;
+  DenseMap<Value, Support> supports;
 };
 } // namespace
 
-static inline uint32_t bitsMask(uint32_t nbits) {
-  if (nbits == 32)
-    return ~0;
-  return (1 << nbits) - 1;
+/// Estimate the runtime cost of an op. Falls back to a default of 10 for ops
+/// without a cost estimate.
+static uint32_t getCost(Operation *op) {
+  if (op->hasTrait<OpTrait::ConstantLike>())
+    return 0;
+  if (auto *runtimeCostIF =
+          dyn_cast<RuntimeCostEstimateDialectInterface>(op->getDialect()))
+    return runtimeCostIF->getCostEstimate(op);
+  return 10;
 }
 
-static inline uint32_t bitsGet(uint32_t x, uint32_t lb, uint32_t ub) {
-  return (x >> lb) & bitsMask(ub - lb + 1);
+/// Check whether an op computes a single integer from integers without side
+/// effects, which allows it to be evaluated for every table entry.
+static bool isTabulable(Operation *op) {
+  return op->getNumResults() == 1 && op->getNumRegions() == 0 &&
+         op->getResult(0).getType().isa<IntegerType>() &&
+         llvm::all_of(op->getOperandTypes(),
+                      [](Type type) { return type.isa<IntegerType>(); }) &&
+         isMemoryEffectFree(op);
 }
 
 void MakeTablesPass::runOnOperation() {
   auto module = getOperation();
-  for (auto op : module.getOps<DefineOp>())
-    runOnArc(op);
-}
 
-void MakeTablesPass::runOnArc(DefineOp defineOp) {
-  // Determine the number of input bits.
-  unsigned numInputBits = 0;
-  for (auto &type : defineOp.getArgumentTypes()) {
-    auto intType = type.dyn_cast<IntegerType>();
-    if (!intType)
-      return;
-    numInputBits += intType.getWidth();
+  // Tables of arcs that are never called only take up memory.
+  std::optional<ActivityProfile> profile;
+  if (!profileFile.empty()) {
+    auto loadedProfile = ActivityProfile::load(profileFile, module.getLoc());
+    if (failed(loadedProfile))
+      return signalPassFailure();
+    profile = std::move(*loadedProfile);
   }
-  if (numInputBits == 0)
-    return;
-
-  // Count the number of non-constant operations in the block.
-  unsigned numOps = 0;
-  for (auto &op : defineOp.getBodyBlock().without_terminator())
-    if (!op.hasTrait<OpTrait::ConstantLike>())
-      ++numOps;
-
-  // Determine the number of output bits.
-  unsigned numOutputBits = 0;
-  auto outputOp = cast<arc::OutputOp>(defineOp.getBodyBlock().getTerminator());
-  for (auto type : outputOp.getOperandTypes()) {
-    auto intType = type.dyn_cast<IntegerType>();
-    if (!intType)
-      return;
-    numOutputBits += intType.getWidth();
+
+  for (auto op : module.getOps<DefineOp>()) {
+    if (profile && profile->isCold(op.getSymName())) {
+      ++numColdArcs;
+      continue;
+    }
+    runOnArc(op);
   }
-  if (numOutputBits == 0)
-    return;
+}
 
+void MakeTablesPass::runOnArc(DefineOp defineOp) {
   LLVM_DEBUG(llvm::dbgs() << "Making lookup tables in `" << defineOp.getName()
                           << "`\n");
-  LLVM_DEBUG(llvm::dbgs() << "- " << numInputBits << " input bits, "
-                          << numOutputBits << " output bits, " << numOps
-                          << " ops\n");
-
-  // Check whether the table dimensions are within bounds.
-  if (numInputBits >= 31) {
-    LLVM_DEBUG(llvm::dbgs() << "- Skip; too many input bits\n");
-    return;
+  tableInputs.clear();
+  for (auto arg : defineOp.getArguments())
+    tableInputs.insert(arg);
+
+  // Every round may turn logic into table lookups, whose results may in turn
+  // narrow down the inputs of the logic they feed into.
+  while (makeTables(defineOp))
+    ;
+}
+
+/// Replace the largest profitable subexpressions in an arc with table lookups.
+/// Returns true if any tables were created.
+bool MakeTablesPass::makeTables(DefineOp defineOp) {
+  auto &block = defineOp.getBodyBlock();
+  computeSupport(block);
+
+  // Find the largest subexpressions that can be tabulated, starting at the
+  // arc outputs.
+  SmallVector<std::pair<Value, SmallVector<Operation *>>> roots;
+  SmallVector<Value> worklist(block.getTerminator()->getOperands());
+  DenseSet<Value> visited;
+  while (!worklist.empty()) {
+    auto value = worklist.pop_back_val();
+    auto *op = value.getDefiningOp();
+    if (!op || tableInputs.contains(value) || !visited.insert(value).second ||
+        op->hasTrait<OpTrait::ConstantLike>())
+      continue;
+
+    if (auto layout = getLayout(value)) {
+      // Collect the ops computing the value from the table inputs.
+      SetVector<Operation *> slice;
+      SmallVector<Operation *> sliceWorklist;
+      sliceWorklist.push_back(op);
+      while (!sliceWorklist.empty()) {
+        auto *sliceOp = sliceWorklist.pop_back_val();
+        if (!slice.insert(sliceOp))
+          continue;
+        for (auto operand : sliceOp->getOperands())
+          if (!tableInputs.contains(operand))
+            sliceWorklist.push_back(operand.getDefiningOp());
+      }
+      auto sortedSlice = slice.takeVector();
+      llvm::sort(sortedSlice,
+                 [](auto *a, auto *b) { return a->isBeforeInBlock(b); });
+
+      auto savedCost = getSavedCost(value, sortedSlice);
+      auto lookupCost = getLookupCost(supports[value], *layout);
+      LLVM_DEBUG(llvm::dbgs() << "- " << value << ": " << layout->numIndexBits
+                              << " index bits, saves " << savedCost
+                              << ", lookup costs " << lookupCost << "\n");
+      if (savedCost > lookupCost) {
+        roots.push_back({value, std::move(sortedSlice)});
+        continue;
+      }
+    }
+    for (auto operand : op->getOperands())
+      worklist.push_back(operand);
   }
-  if (numOps < tableMinOpCount) {
-    LLVM_DEBUG(llvm::dbgs() << "- Skip; not enough ops\n");
-    return;
+
+  // Evaluate the subexpressions for every combination of their inputs. All
+  // tables are computed before any IR is changed, since the slices of
+  // different roots may overlap.
+  SmallVector<std::pair<Value, SmallVector<APInt>>> tables;
+  for (auto &[root, slice] : roots) {
+    SmallVector<APInt> entries;
+    if (failed(evaluate(root, slice, entries))) {
+      LLVM_DEBUG(llvm::dbgs() << "- Skip " << root << "; folding failed\n");
+      continue;
+    }
+    tables.push_back({root, std::move(entries)});
   }
 
-  unsigned numTableEntries = 1U << numInputBits;
-  if (numTableEntries > tableMaxSize / numOutputBits) {
-    LLVM_DEBUG(llvm::dbgs() << "- Skip; table too large\n");
-    return;
+  // Replace the subexpressions with table lookups.
+  for (auto &[root, entries] : tables) {
+    auto lookup = materialize(root, *getLayout(root), entries);
+    root.replaceAllUsesWith(lookup);
+    tableInputs.insert(lookup);
   }
-  LLVM_DEBUG(llvm::dbgs() << "- Creating table of "
-                          << numTableEntries * numOutputBits << " bits\n");
 
-  // Actually build the table.
-  SmallVector<Operation *, 64> tabularizedOps;
-  for (auto &op : defineOp.getBodyBlock().without_terminator())
-    tabularizedOps.push_back(&op);
+  // Remove the logic that has been replaced by tables.
+  for (auto &op : llvm::make_early_inc_range(llvm::reverse(block)))
+    if (isOpTriviallyDead(&op))
+      op.erase();
+  return !tables.empty();
+}
 
-  // Concatenate the inputs into a single index value.
-  auto builder = ImplicitLocOpBuilder::atBlockBegin(defineOp.getLoc(),
-                                                    &defineOp.getBodyBlock());
-  SmallVector<Value> inputsToConcat(defineOp.getArguments());
-  std::reverse(inputsToConcat.begin(), inputsToConcat.end());
-  auto concatInputs = inputsToConcat.size() > 1
-                          ? builder.create<comb::ConcatOp>(inputsToConcat)
-                          : inputsToConcat[0];
+/// Determine the table inputs each value in a block depends on.
+void MakeTablesPass::computeSupport(Block &block) {
+  auto maxIndexBits = llvm::Log2_64(std::max<uint64_t>(maxTableBits, 1));
+  supports.clear();
+  auto addInput = [&](Value value) {
+    auto &support = supports[value];
+    auto intType = value.getType().dyn_cast<IntegerType>();
+    if (!intType || intType.getWidth() > maxIndexBits) {
+      support.tooWide = true;
+      return;
+    }
+    support.inputs.insert(value);
+    support.numBits = intType.getWidth();
+  };
+  for (auto arg : block.getArguments())
+    addInput(arg);
 
-  // Compute a lookup table for every output.
-  SmallVector<SmallVector<Attribute, 0>> tables;
-  DenseMap<Value, Attribute> values;
-  tables.resize(outputOp->getNumOperands());
+  for (auto &op : block.without_terminator()) {
+    if (op.getNumResults() == 1 && tableInputs.contains(op.getResult(0))) {
+      addInput(op.getResult(0));
+      continue;
+    }
+    if (!isTabulable(&op)) {
+      for (auto result : op.getResults())
+        supports[result].tooWide = true;
+      continue;
+    }
+    Support support;
+    for (auto operand : op.getOperands()) {
+      auto &operandSupport = supports[operand];
+      if (operandSupport.tooWide) {
+        support.tooWide = true;
+        break;
+      }
+      for (auto input : operandSupport.inputs)
+        if (support.inputs.insert(input))
+          support.numBits += input.getType().getIntOrFloatBitWidth();
+      if (support.numBits > maxIndexBits) {
+        support.tooWide = true;
+        break;
+      }
+    }
+    if (support.tooWide)
+      support.inputs.clear();
+    supports[op.getResult(0)] = std::move(support);
+  }
+}
+
+/// Return the layout of a table for a value, or `std::nullopt` if the value
+/// cannot be tabulated within the size limit.
+std::optional<TableLayout> MakeTablesPass::getLayout(Value value) {
+  auto &support = supports[value];
+  if (support.tooWide || support.numBits == 0)
+    return std::nullopt;
+
+  // Values whose width is not a multiple of a byte would waste space when
+  // stored in an array. Pack as many of them as possible into 64-bit words.
+  TableLayout layout;
+  layout.numIndexBits = support.numBits;
+  layout.valueWidth = value.getType().getIntOrFloatBitWidth();
+  layout.entriesPerWord = 0;
+  if (layout.valueWidth % 8 != 0 && layout.valueWidth <= 32)
+    layout.entriesPerWord = llvm::PowerOf2Floor(64 / layout.valueWidth);
+
+  if (layout.getNumBits() > maxTableBits)
+    return std::nullopt;
+  return layout;
+}
+
+/// Estimate the cost of the ops that become obsolete once a value is looked up
+/// in a table. Ops in the slice that are also used outside of it have to be
+/// kept around.
+uint32_t MakeTablesPass::getSavedCost(Value root,
+                                      ArrayRef<Operation *> slice) {
+  SmallPtrSet<Operation *, 16> obsolete;
+  obsolete.insert(root.getDefiningOp());
+  uint32_t cost = getCost(root.getDefiningOp());
+  for (auto *op : llvm::reverse(slice.drop_back()))
+    if (llvm::all_of(op->getUsers(),
+                     [&](auto *user) { return obsolete.contains(user); })) {
+      obsolete.insert(op);
+      cost += getCost(op);
+    }
+  return cost;
+}
+
+/// Estimate the cost of a table lookup. Tables that fit into a single word are
+/// materialized as a constant and only need to be shifted. Loads from larger
+/// tables get more expensive the higher up in the cache hierarchy the table is
+/// likely to reside, assuming it competes with the model state for the caches.
+uint32_t MakeTablesPass::getLookupCost(const Support &support,
+                                       const TableLayout &layout) {
+  uint32_t cost = 0;
+  if (support.inputs.size() > 1)
+    cost += 20 * support.inputs.size(); // concatenating the index
+  if (layout.entriesPerWord)
+    cost += 20; // shifting and masking the packed entry
+  if (layout.entriesPerWord && layout.getNumWords() == 1)
+    return cost;
+  cost += 10; // the array access
+  auto numBytes = layout.getNumBytes();
+  if (numBytes <= 4096)
+    cost += 40;
+  else if (numBytes <= 65536)
+    cost += 120;
+  else
+    cost += 400;
+  return cost;
+}
 
-  for (int input = (1U << numInputBits) - 1; input >= 0; input--) {
-    // Assign the input values.
+/// Compute the value of `root` for every combination of values of its table
+/// inputs, by constant-folding the ops in `slice`.
+LogicalResult MakeTablesPass::evaluate(Value root, ArrayRef<Operation *> slice,
+                                       SmallVectorImpl<APInt> &entries) {
+  auto &support = supports[root];
+  uint64_t numEntries = uint64_t(1) << support.numBits;
+  entries.reserve(numEntries);
+
+  DenseMap<Value, Attribute> values;
+  SmallVector<Attribute> constants;
+  SmallVector<OpFoldResult, 8> resultValues;
+  for (uint64_t index = 0; index < numEntries; ++index) {
+    // Assign the input values, with the first input in the lowest index bits.
     values.clear();
     unsigned bits = 0;
-    for (auto arg : defineOp.getArguments()) {
-      auto w = arg.getType().dyn_cast<IntegerType>().getWidth();
-      values[arg] = builder.getIntegerAttr(arg.getType(),
-                                           bitsGet(input, bits, bits + w - 1));
-      bits += w;
+    for (auto input : support.inputs) {
+      auto type = input.getType().cast<IntegerType>();
+      values[input] = IntegerAttr::get(
+          type, APInt(support.numBits, index).extractBits(type.getWidth(),
+                                                          bits));
+      bits += type.getWidth();
     }
 
     // Evaluate the operations.
-    SmallVector<Attribute> constants;
-    for (auto *operation : tabularizedOps) {
+    for (auto *operation : slice) {
       constants.clear();
       for (auto operand : operation->getOperands())
-        constants.push_back(values[operand]);
+        constants.push_back(values.lookup(operand));
+      resultValues.clear();
+      if (failed(operation->fold(constants, resultValues)) ||
+          resultValues.size() != 1)
+        return failure();
+      auto attr = resultValues[0].dyn_cast<Attribute>();
+      if (!attr)
+        attr = values.lookup(resultValues[0].dyn_cast<Value>());
+      values[operation->getResult(0)] = attr;
+    }
 
-      SmallVector<OpFoldResult, 8> resultValues;
-      if (failed(operation->fold(constants, resultValues))) {
-        LLVM_DEBUG(llvm::dbgs() << "- Skip; operation folder failed\n");
-        return;
-      }
+    auto result = values.lookup(root).dyn_cast_or_null<IntegerAttr>();
+    if (!result)
+      return failure();
+    entries.push_back(result.getValue());
+  }
+  return success();
+}
 
-      for (auto [result, resultValue] :
-           llvm::zip(operation->getResults(), resultValues)) {
-        auto attr = resultValue.dyn_cast<Attribute>();
-        if (!attr)
-          attr = values[resultValue.dyn_cast<Value>()];
-        values[result] = attr;
-      }
-    }
+/// Create a table holding the given entries and look up the entry for the
+/// current value of the table inputs of `root`.
+Value MakeTablesPass::materialize(Value root, const TableLayout &layout,
+                                  ArrayRef<APInt> entries) {
+  auto &support = supports[root];
+  ImplicitLocOpBuilder builder(root.getLoc(), root.getDefiningOp());
+  LLVM_DEBUG(llvm::dbgs() << "- Creating table of " << layout.getNumBits()
+                          << " bits for " << root << "\n");
+  ++numTables;
 
-    // Add the evaluated values to the output tables.
-    for (auto [table, outputOperand] :
-         llvm::zip(tables, outputOp->getOpOperands())) {
-      table.push_back(values[outputOperand.get()].dyn_cast<Attribute>());
-    }
+  // Concatenate the inputs into a single index value.
+  SmallVector<Value> inputsToConcat(support.inputs.begin(),
+                                    support.inputs.end());
+  std::reverse(inputsToConcat.begin(), inputsToConcat.end());
+  Value index = inputsToConcat.size() > 1
+                    ? builder.create<comb::ConcatOp>(inputsToConcat)
+                    : inputsToConcat[0];
+
+  auto valueType = root.getType();
+  if (!layout.entriesPerWord) {
+    // Array elements are listed starting at the highest index.
+    SmallVector<Attribute> table;
+    table.reserve(entries.size());
+    for (auto &entry : llvm::reverse(entries))
+      table.push_back(builder.getIntegerAttr(valueType, entry));
+    auto array = builder.create<hw::AggregateConstantOp>(
+        ArrayType::get(valueType, entries.size()), builder.getArrayAttr(table));
+    return builder.create<hw::ArrayGetOp>(array, index);
   }
 
-  // Create the table lookup ops.
-  for (auto [table, outputOperand] :
-       llvm::zip(tables, outputOp->getOpOperands())) {
+  // Pack the entries into words.
+  ++numPackedTables;
+  unsigned width = layout.valueWidth;
+  unsigned wordWidth = std::min<uint64_t>(64, layout.getNumBits());
+  SmallVector<APInt> words(layout.getNumWords(), APInt(wordWidth, 0));
+  for (auto [idx, entry] : llvm::enumerate(entries))
+    words[idx / layout.entriesPerWord].insertBits(
+        entry, (idx % layout.entriesPerWord) * width);
+
+  // Select the word holding the entry.
+  unsigned laneBits = llvm::Log2_64(layout.entriesPerWord);
+  Value word, lane;
+  if (words.size() == 1) {
+    word = builder.create<hw::ConstantOp>(words[0]);
+    lane = index;
+  } else {
+    SmallVector<Attribute> table;
+    table.reserve(words.size());
+    for (auto &entry : llvm::reverse(words))
+      table.push_back(builder.getIntegerAttr(builder.getI64Type(), entry));
     auto array = builder.create<hw::AggregateConstantOp>(
-        ArrayType::get(outputOperand.get().getType(), numTableEntries),
+        ArrayType::get(builder.getI64Type(), words.size()),
         builder.getArrayAttr(table));
-    outputOperand.set(builder.create<hw::ArrayGetOp>(array, concatInputs));
+    auto wordIndex = builder.create<comb::ExtractOp>(
+        index, laneBits, layout.numIndexBits - laneBits);
+    word = builder.create<hw::ArrayGetOp>(array, wordIndex);
+    lane = builder.create<comb::ExtractOp>(index, 0, laneBits);
   }
 
-  for (auto *op : tabularizedOps) {
-    op->dropAllUses();
-    op->erase();
+  // Shift the entry down to the lowest bits. The lane index is scaled by the
+  // value width, which is a plain shift for powers of two.
+  unsigned laneWidth = lane.getType().getIntOrFloatBitWidth();
+  Value amount;
+  if (llvm::isPowerOf2_32(width)) {
+    unsigned scaleBits = llvm::Log2_32(width);
+    SmallVector<Value> parts;
+    if (wordWidth > laneWidth + scaleBits)
+      parts.push_back(builder.create<hw::ConstantOp>(
+          APInt::getZero(wordWidth - laneWidth - scaleBits)));
+    parts.push_back(lane);
+    if (scaleBits > 0)
+      parts.push_back(
+          builder.create<hw::ConstantOp>(APInt::getZero(scaleBits)));
+    amount = parts.size() > 1 ? builder.create<comb::ConcatOp>(parts) : lane;
+  } else {
+    Value zeros = builder.create<hw::ConstantOp>(
+        APInt::getZero(wordWidth - laneWidth));
+    amount = builder.create<comb::MulOp>(
+        builder.create<comb::ConcatOp>(ValueRange{zeros, lane}),
+        builder.create<hw::ConstantOp>(APInt(wordWidth, width)), true);
   }
+  Value shifted = builder.create<comb::ShrUOp>(word, amount, true);
+  return builder.create<comb::ExtractOp>(shifted, 0, width);
 }
 
-std::unique_ptr<Pass> arc::createMakeTablesPass() {
-  return std::make_unique<MakeTablesPass>();
+std::unique_ptr<Pass> arc::createMakeTablesPass(StringRef profileFile) {
+  auto pass = std::make_unique<MakeTablesPass>();
+  if (!profileFile.empty())
+    pass->profileFile.assign(profileFile);
+  return pass;
 }
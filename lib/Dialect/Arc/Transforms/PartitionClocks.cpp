@@ -0,0 +1,227 @@
+//===- PartitionClocks.cpp ------------------------------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "PassDetails.h"
+#include "circt/Dialect/Arc/ArcInterfaces.h"
+#include "mlir/IR/IRMapping.h"
+#include "llvm/ADT/EquivalenceClasses.h"
+#include "llvm/ADT/Sequence.h"
+#include "llvm/Support/Debug.h"
+
+#define DEBUG_TYPE "arc-partition-clocks"
+
+using namespace mlir;
+using namespace circt;
+using namespace arc;
+
+using llvm::Optional;
+
+//===----------------------------------------------------------------------===//
+// Pass Implementation
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// A group of side-effecting ops in a clock tree that have to end up in the
+/// same partition, alongside the ops computing their operands.
+struct SinkGroup {
+  SmallPtrSet<Operation *, 8> ops;
+  uint64_t cost = 0;
+};
+
+struct PartitionClocksPass : public PartitionClocksBase<PartitionClocksPass> {
+  void runOnOperation() override;
+  void partitionClock(ClockTreeOp clockTreeOp, Value storage);
+  uint32_t getCost(Operation *op);
+
+  using PartitionClocksBase::partitions;
+};
+} // namespace
+
+void PartitionClocksPass::runOnOperation() {
+  if (partitions <= 1)
+    return;
+  for (auto modelOp : getOperation().getOps<ModelOp>()) {
+    // Models with multiple clock domains would need one set of partitions per
+    // domain and are left alone for now.
+    auto clockTreeOps =
+        llvm::to_vector(modelOp.getBody().getOps<ClockTreeOp>());
+    if (clockTreeOps.size() != 1)
+      continue;
+    partitionClock(clockTreeOps[0], modelOp.getBody().getArgument(0));
+  }
+}
+
+/// Estimate the runtime cost of an op and all ops nested within it. Falls back
+/// to a default of 10 for ops without a cost estimate.
+uint32_t PartitionClocksPass::getCost(Operation *op) {
+  uint32_t cost = 0;
+  op->walk([&](Operation *nestedOp) {
+    if (auto *runtimeCostIF = dyn_cast<RuntimeCostEstimateDialectInterface>(
+            nestedOp->getDialect()))
+      cost += runtimeCostIF->getCostEstimate(nestedOp);
+    else
+      cost += 10;
+  });
+  return cost;
+}
+
+void PartitionClocksPass::partitionClock(ClockTreeOp clockTreeOp,
+                                         Value storage) {
+  LLVM_DEBUG(llvm::dbgs() << "Partitioning clock tree at "
+                          << clockTreeOp.getLoc() << "\n");
+  auto &body = clockTreeOp.getBody().front();
+
+  // Memory writes cannot be deferred to the commit phase, and memory reads in
+  // other partitions would race with them.
+  if (clockTreeOp.walk([](MemoryWriteOp) { return WalkResult::interrupt(); })
+          .wasInterrupted()) {
+    LLVM_DEBUG(llvm::dbgs() << "- Skipping clock tree with memory writes\n");
+    return;
+  }
+
+  // The ops without results in the clock tree are the state writes and the
+  // `scf.if` ops grouping them. Sinks writing the same state have to stay in
+  // the same partition to preserve the order of the writes.
+  SmallVector<Operation *> sinks;
+  llvm::EquivalenceClasses<Operation *> sinkClasses;
+  DenseMap<Value, Operation *> stateWriters;
+  for (auto &op : body) {
+    if (op.getNumResults() != 0)
+      continue;
+    sinks.push_back(&op);
+    sinkClasses.insert(&op);
+    op.walk([&](StateWriteOp writeOp) {
+      auto [it, inserted] = stateWriters.insert({writeOp.getState(), &op});
+      if (!inserted)
+        sinkClasses.unionSets(it->second, &op);
+    });
+  }
+
+  // Collect each group of sinks together with the ops in the clock tree that
+  // compute the values they use.
+  SmallVector<SinkGroup> groups;
+  DenseMap<Operation *, unsigned> groupIndices;
+  for (auto *sink : sinks) {
+    auto *leader = sinkClasses.getLeaderValue(sink);
+    auto [it, inserted] = groupIndices.insert({leader, groups.size()});
+    if (inserted)
+      groups.emplace_back();
+    auto &group = groups[it->second];
+
+    SmallVector<Operation *> worklist;
+    worklist.push_back(sink);
+    while (!worklist.empty()) {
+      auto *op = worklist.pop_back_val();
+      if (!group.ops.insert(op).second)
+        continue;
+      group.cost += getCost(op);
+      op->walk([&](Operation *nestedOp) {
+        for (auto operand : nestedOp->getOperands())
+          if (auto *defOp = operand.getDefiningOp();
+              defOp && defOp->getBlock() == &body)
+            worklist.push_back(defOp);
+      });
+    }
+  }
+  if (groups.size() < 2) {
+    LLVM_DEBUG(llvm::dbgs() << "- Skipping clock tree with "
+                            << groups.size() << " sink groups\n");
+    return;
+  }
+
+  // Distribute the groups across the partitions, assigning the most expensive
+  // remaining group to the least loaded partition. Ops shared between groups
+  // in different partitions are duplicated.
+  SmallVector<unsigned> order(llvm::seq<unsigned>(0, groups.size()));
+  llvm::stable_sort(order, [&](unsigned a, unsigned b) {
+    return groups[a].cost > groups[b].cost;
+  });
+  unsigned numPartitions = std::min<unsigned>(partitions, groups.size());
+  SmallVector<uint64_t> loads(numPartitions, 0);
+  SmallVector<SmallPtrSet<Operation *, 16>> partitionOps(numPartitions);
+  for (auto groupIdx : order) {
+    auto *leastLoaded = llvm::min_element(loads);
+    auto partitionIdx = leastLoaded - loads.begin();
+    *leastLoaded += groups[groupIdx].cost;
+    partitionOps[partitionIdx].insert(groups[groupIdx].ops.begin(),
+                                      groups[groupIdx].ops.end());
+  }
+  LLVM_DEBUG({
+    for (unsigned idx = 0; idx < numPartitions; ++idx)
+      llvm::dbgs() << "- Partition " << idx << ": cost " << loads[idx] << ", "
+                   << partitionOps[idx].size() << " ops\n";
+  });
+
+  // Each partition writes the next value of its states into separate storage,
+  // such that partitions can run concurrently while reading the current
+  // values. A final commit clock tree copies the next values over.
+  auto loc = clockTreeOp.getLoc();
+  OpBuilder builder(clockTreeOp);
+  MapVector<Value, Value> nextStates;
+  for (auto *sink : sinks)
+    sink->walk([&](StateWriteOp writeOp) {
+      auto state = writeOp.getState();
+      if (!nextStates.count(state))
+        nextStates.insert({state, builder.create<AllocStateOp>(
+                                      loc, state.getType(), storage)});
+    });
+
+  for (unsigned partitionIdx = 0; partitionIdx < numPartitions;
+       ++partitionIdx) {
+    auto &ops = partitionOps[partitionIdx];
+    auto treeOp = builder.create<ClockTreeOp>(loc, clockTreeOp.getClock());
+    treeOp->setAttr("arc.partition", builder.getI32IntegerAttr(partitionIdx));
+    auto treeBuilder = OpBuilder::atBlockEnd(&treeOp.getBody().emplaceBlock());
+
+    // Start out with the current value of every written state, since the
+    // writes may be conditional.
+    SetVector<Value> writtenStates;
+    for (auto &op : body)
+      if (ops.contains(&op))
+        op.walk([&](StateWriteOp writeOp) {
+          writtenStates.insert(writeOp.getState());
+        });
+    for (auto state : writtenStates) {
+      Value value = treeBuilder.create<StateReadOp>(loc, state);
+      treeBuilder.create<StateWriteOp>(loc, nextStates.lookup(state), value,
+                                       Value{});
+    }
+
+    // Copy over the ops in their original order and redirect their writes.
+    IRMapping mapping;
+    for (auto &op : body) {
+      if (!ops.contains(&op))
+        continue;
+      auto *clonedOp = treeBuilder.clone(op, mapping);
+      clonedOp->walk([&](StateWriteOp writeOp) {
+        if (auto next = nextStates.lookup(writeOp.getState()))
+          writeOp.getStateMutable().assign(next);
+      });
+    }
+  }
+
+  auto commitOp = builder.create<ClockTreeOp>(loc, clockTreeOp.getClock());
+  commitOp->setAttr("arc.partition_commit", builder.getUnitAttr());
+  auto commitBuilder =
+      OpBuilder::atBlockEnd(&commitOp.getBody().emplaceBlock());
+  for (auto [state, next] : nextStates) {
+    Value value = commitBuilder.create<StateReadOp>(loc, next);
+    commitBuilder.create<StateWriteOp>(loc, state, value, Value{});
+  }
+
+  clockTreeOp.erase();
+  ++numPartitionedClocks;
+}
+
+std::unique_ptr<Pass>
+arc::createPartitionClocksPass(Optional<unsigned> partitions) {
+  auto pass = std::make_unique<PartitionClocksPass>();
+  if (partitions)
+    pass->partitions = *partitions;
+  return pass;
+}
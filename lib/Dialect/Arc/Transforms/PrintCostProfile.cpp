@@ -0,0 +1,209 @@
+//===- PrintCostProfile.cpp -----------------------------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "PassDetails.h"
+#include "circt/Dialect/Arc/ArcInterfaces.h"
+#include "mlir/IR/Threading.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/ToolOutputFile.h"
+
+#define DEBUG_TYPE "arc-print-cost-profile"
+
+using namespace mlir;
+using namespace circt;
+using namespace arc;
+using namespace hw;
+
+//===----------------------------------------------------------------------===//
+// Pass Implementation
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// The size and cost of a module, or of a module and everything below it.
+struct ModuleCost {
+  uint64_t numOps = 0;
+  uint64_t registerBits = 0;
+  uint64_t memoryBits = 0;
+  uint64_t cost = 0;
+
+  ModuleCost &operator+=(const ModuleCost &other) {
+    numOps += other.numOps;
+    registerBits += other.registerBits;
+    memoryBits += other.memoryBits;
+    cost += other.cost;
+    return *this;
+  }
+  ModuleCost operator*(uint64_t factor) const {
+    return {numOps * factor, registerBits * factor, memoryBits * factor,
+            cost * factor};
+  }
+};
+
+struct ModuleInfo {
+  /// The cost of the module's own body.
+  ModuleCost local;
+  /// The cost of the module including all modules instantiated below it.
+  ModuleCost total;
+  /// The number of instances of each child module, in order of appearance.
+  llvm::MapVector<StringAttr, uint64_t> children;
+  /// The number of times the module occurs in the flattened design.
+  uint64_t numOccurrences = 0;
+};
+
+struct PrintCostProfilePass
+    : public PrintCostProfileBase<PrintCostProfilePass> {
+  void runOnOperation() override;
+  void printProfile(llvm::raw_ostream &os);
+
+  using PrintCostProfileBase::profileFile;
+};
+} // namespace
+
+/// Collect the size and estimated runtime cost of the body of a module.
+static void collectModuleInfo(HWModuleOp module, ModuleInfo &info) {
+  auto getBits = [](Type type) -> uint64_t {
+    auto width = hw::getBitWidth(type);
+    return width > 0 ? width : 0;
+  };
+
+  module.walk([&](Operation *op) {
+    if (op == module)
+      return;
+    ++info.local.numOps;
+    if (auto *costIF =
+            dyn_cast<RuntimeCostEstimateDialectInterface>(op->getDialect()))
+      info.local.cost += costIF->getCostEstimate(op);
+
+    if (isa<seq::CompRegOp, seq::CompRegClockEnabledOp, seq::FirRegOp>(op)) {
+      info.local.registerBits += getBits(op->getResult(0).getType());
+    } else if (auto stateOp = dyn_cast<StateOp>(op)) {
+      if (stateOp.getLatency() > 0)
+        for (auto result : stateOp.getResults())
+          info.local.registerBits += getBits(result.getType());
+    } else if (auto memOp = dyn_cast<MemoryOp>(op)) {
+      auto memType = memOp.getType();
+      info.local.memoryBits +=
+          uint64_t(memType.getNumWords()) * memType.getWordType().getWidth();
+    } else if (auto memOp = dyn_cast<seq::HLMemOp>(op)) {
+      auto memType = memOp.getMemType();
+      uint64_t numWords = 1;
+      for (auto dim : memType.getShape())
+        numWords *= dim;
+      info.local.memoryBits += numWords * getBits(memType.getElementType());
+    } else if (auto instOp = dyn_cast<InstanceOp>(op)) {
+      ++info.children[instOp.getModuleNameAttr().getAttr()];
+    }
+  });
+}
+
+void PrintCostProfilePass::runOnOperation() {
+  // Print to the output file if one was given, or stdout otherwise.
+  if (profileFile.empty()) {
+    printProfile(llvm::outs());
+    llvm::outs() << "\n";
+  } else {
+    std::error_code ec;
+    llvm::ToolOutputFile outputFile(profileFile, ec,
+                                    llvm::sys::fs::OpenFlags::OF_None);
+    if (ec) {
+      mlir::emitError(getOperation().getLoc(), "unable to open profile file: ")
+          << ec.message();
+      return signalPassFailure();
+    }
+    printProfile(outputFile.os());
+    outputFile.keep();
+  }
+  markAllAnalysesPreserved();
+}
+
+void PrintCostProfilePass::printProfile(llvm::raw_ostream &os) {
+  // Gather the size and cost of each module body in parallel.
+  auto modules = llvm::to_vector(getOperation().getOps<HWModuleOp>());
+  SmallVector<ModuleInfo> infos(modules.size());
+  mlir::parallelFor(&getContext(), 0, modules.size(), [&](size_t i) {
+    collectModuleInfo(modules[i], infos[i]);
+  });
+
+  DenseMap<StringAttr, ModuleInfo *> infoByName;
+  for (auto [module, info] : llvm::zip(modules, infos))
+    infoByName[module.getNameAttr()] = &info;
+
+  // Accumulate the totals bottom-up, recording the modules in an order where
+  // children come before their parents.
+  SmallVector<ModuleInfo *> postOrder;
+  DenseSet<ModuleInfo *> visited;
+  std::function<void(ModuleInfo *)> visit = [&](ModuleInfo *info) {
+    if (!visited.insert(info).second)
+      return;
+    info->total = info->local;
+    for (auto [childName, count] : info->children) {
+      auto *child = infoByName.lookup(childName);
+      if (!child)
+        continue;
+      visit(child);
+      info->total += child->total * count;
+    }
+    postOrder.push_back(info);
+  };
+  for (auto &info : infos)
+    visit(&info);
+
+  // Count how often each module occurs in the flattened design, top-down from
+  // the modules which are not instantiated anywhere.
+  DenseSet<ModuleInfo *> instantiated;
+  for (auto &info : infos)
+    for (auto [childName, count] : info.children)
+      if (auto *child = infoByName.lookup(childName))
+        instantiated.insert(child);
+  for (auto &info : infos)
+    if (!instantiated.contains(&info))
+      info.numOccurrences = 1;
+  for (auto *info : llvm::reverse(postOrder))
+    for (auto [childName, count] : info->children)
+      if (auto *child = infoByName.lookup(childName))
+        child->numOccurrences += info->numOccurrences * count;
+
+  ModuleCost design;
+  for (auto &info : infos)
+    design += info.local * info.numOccurrences;
+
+  auto printCost = [](llvm::json::OStream &json, const ModuleCost &cost) {
+    json.attribute("numOps", cost.numOps);
+    json.attribute("registerBits", cost.registerBits);
+    json.attribute("memoryBits", cost.memoryBits);
+    json.attribute("cost", cost.cost);
+  };
+
+  llvm::json::OStream json(os, 2);
+  json.object([&] {
+    json.attributeObject("design", [&] { printCost(json, design); });
+    json.attributeArray("modules", [&] {
+      for (auto [module, info] : llvm::zip(modules, infos)) {
+        json.object([&] {
+          json.attribute("name", module.getName());
+          json.attribute("occurrences", info.numOccurrences);
+          printCost(json, info.local);
+          json.attributeObject("total", [&] { printCost(json, info.total); });
+          json.attributeObject("children", [&] {
+            for (auto [childName, count] : info.children)
+              json.attribute(childName.getValue(), count);
+          });
+        });
+      }
+    });
+  });
+}
+
+std::unique_ptr<Pass> arc::createPrintCostProfilePass(StringRef profileFile) {
+  auto pass = std::make_unique<PrintCostProfilePass>();
+  if (!profileFile.empty())
+    pass->profileFile.assign(profileFile);
+  return pass;
+}
@@ -28,8 +28,10 @@ struct StateInfo {
   StringAttr name;
   unsigned offset;
   unsigned numBits;
-  unsigned memoryStride = 0; // byte separation between memory words
-  unsigned memoryDepth = 0;  // number of words in a memory
+  std::optional<unsigned> bit;  // bit within the byte at `offset` if packed
+  unsigned memoryStride = 0;    // byte separation between memory words
+  unsigned memoryDepth = 0;     // number of words in a memory
+  unsigned memoryPageWords = 0; // number of words per page if sparse
 };
 
 struct ModelInfo {
@@ -88,11 +90,37 @@ PrintStateInfoPass::runOnOperation(llvm::raw_ostream &outputStream) {
       json.object([&] {
         json.attribute("name", modelOp.getName());
         json.attribute("numStateBytes", storageType.getSize());
+        auto numPartitions = llvm::count_if(
+            modelOp.getBody().getOps<ClockTreeOp>(),
+            [](auto treeOp) { return treeOp->hasAttr("arc.partition"); });
+        if (numPartitions > 0)
+          json.attribute("clockPartitions", int64_t(numPartitions));
+        // List the clock domains of models with more than one clock, such
+        // that runtimes can only evaluate the domains with an active edge.
+        SmallVector<ClockTreeOp> clockTrees;
+        for (auto treeOp : modelOp.getBody().getOps<ClockTreeOp>())
+          if (!treeOp->hasAttr("arc.partition") &&
+              !treeOp->hasAttr("arc.partition_commit"))
+            clockTrees.push_back(treeOp);
+        if (clockTrees.size() > 1) {
+          json.attributeArray("clocks", [&] {
+            for (unsigned index = 0; index < clockTrees.size(); ++index) {
+              json.object([&] {
+                if (auto name = clockTrees[index].getClockName())
+                  json.attribute("name", name.getValue());
+                json.attribute("function", getClockFunctionName(
+                                               modelOp.getName(), index));
+              });
+            }
+          });
+        }
         json.attributeArray("states", [&] {
           for (const auto &state : states) {
             json.object([&] {
               json.attribute("name", state.name.getValue());
               json.attribute("offset", state.offset);
+              if (state.bit)
+                json.attribute("bit", *state.bit);
               json.attribute("numBits", state.numBits);
               auto typeStr = [](StateInfo::Type type) {
                 switch (type) {
@@ -113,6 +141,8 @@ PrintStateInfoPass::runOnOperation(llvm::raw_ostream &outputStream) {
               if (state.type == StateInfo::Memory) {
                 json.attribute("stride", state.memoryStride);
                 json.attribute("depth", state.memoryDepth);
+                if (state.memoryPageWords)
+                  json.attribute("pageWords", state.memoryPageWords);
               }
             });
           }
@@ -164,6 +194,8 @@ PrintStateInfoPass::collectStates(Value storage, unsigned offset,
       stateInfo.offset = opOffset.getValue().getZExtValue() + offset;
       stateInfo.numBits =
           result.getType().cast<StateType>().getType().getWidth();
+      if (auto bit = op->getAttrOfType<IntegerAttr>("bit"))
+        stateInfo.bit = bit.getValue().getZExtValue();
       continue;
     }
     if (auto memOp = dyn_cast<AllocMemoryOp>(op)) {
@@ -181,6 +213,7 @@ PrintStateInfoPass::collectStates(Value storage, unsigned offset,
       stateInfo.numBits = intType.getWidth();
       stateInfo.memoryStride = stride.getValue().getZExtValue();
       stateInfo.memoryDepth = memType.getNumWords();
+      stateInfo.memoryPageWords = memType.getWordsPerPage();
       continue;
     }
   }
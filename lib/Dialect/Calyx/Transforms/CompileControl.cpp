@@ -34,6 +34,9 @@ static size_t getNecessaryBitWidth(size_t numStates) {
 
 class CompileControlVisitor {
 public:
+  CompileControlVisitor(ComponentOp component, bool compileStatic)
+      : symTable(component.getWiresOp()), compileStatic(compileStatic) {}
+
   void dispatch(Operation *op, ComponentOp component) {
     TypeSwitch<Operation *>(op)
         .template Case<SeqOp, EnableOp>(
@@ -49,8 +52,62 @@ private:
   void visit(EnableOp, ComponentOp &) {
     // nothing to do
   }
+
+  /// Compiles a SeqOp whose groups all have static latencies.
+  void compileStaticSeq(SeqOp seq, ComponentOp &component,
+                        ArrayRef<GroupOp> groups, ArrayRef<uint64_t> latencies);
+
+  /// Replaces the SeqOp with an EnableOp of the group compiled from it.
+  void replaceWithEnable(OpBuilder &builder, SeqOp seq, GroupOp seqGroup);
+
+  /// Returns a constant of the given width and value, reusing the one created
+  /// for a previous request if any.
+  Value getConstant(Location loc, OpBuilder &builder, ComponentOp component,
+                    size_t width, size_t value);
+
+  /// Returns the value which is high when the given group is done.
+  Value getDoneValue(OpBuilder &builder, GroupOp group);
+
+  /// The symbol table of the component's wires, which holds the groups.
+  SymbolTable symTable;
+
+  /// Caches of the constants and group done values created so far.
+  DenseMap<std::pair<size_t, size_t>, Value> constants;
+  DenseMap<Operation *, Value> doneValues;
+
+  /// Whether to compile SeqOps of groups with static latencies into
+  /// counter-based schedules.
+  bool compileStatic;
 };
 
+Value CompileControlVisitor::getConstant(Location loc, OpBuilder &builder,
+                                         ComponentOp component, size_t width,
+                                         size_t value) {
+  auto &constant = constants[{width, value}];
+  if (!constant)
+    constant = createConstant(loc, builder, component, width, value);
+  return constant;
+}
+
+Value CompileControlVisitor::getDoneValue(OpBuilder &builder, GroupOp group) {
+  auto &doneValue = doneValues[group];
+  if (doneValue)
+    return doneValue;
+
+  // TODO(Calyx): Eventually, we should canonicalize the GroupDoneOp's guard
+  // and source.
+  OpBuilder::InsertionGuard guard(builder);
+  builder.setInsertionPoint(group);
+  auto doneOp = group.getDoneOp();
+  Value source = doneOp.getSrc();
+  doneValue = !doneOp.getGuard()
+                  ? source
+                  : builder.create<comb::AndOp>(doneOp.getLoc(),
+                                                doneOp.getGuard(), source,
+                                                false);
+  return doneValue;
+}
+
 /// Generates a latency-insensitive FSM to realize a sequential operation.
 /// This is done by initializing GroupGoOp values for the enabled groups in
 /// the SeqOp, and then creating a new Seq GroupOp with the given FSM. Each
@@ -68,6 +125,23 @@ void CompileControlVisitor::visit(SeqOp seq, ComponentOp &component) {
     return;
   }
 
+  if (compileStatic) {
+    SmallVector<GroupOp> groups;
+    SmallVector<uint64_t> latencies;
+    for (auto enable : seq.getBodyBlock()->getOps<EnableOp>()) {
+      auto group = symTable.lookup<GroupOp>(enable.getGroupName());
+      auto latency = group->getAttrOfType<IntegerAttr>("static");
+      if (!latency || latency.getValue().isZero())
+        break;
+      groups.push_back(group);
+      latencies.push_back(latency.getValue().getZExtValue());
+    }
+    if (groups.size() == seqOps.size()) {
+      compileStaticSeq(seq, component, groups, latencies);
+      return;
+    }
+  }
+
   // This should be the number of enable statements + 1 since this is the
   // maximum value the FSM register will reach.
   size_t fsmBitWidth = getNecessaryBitWidth(seqOps.size() + 1);
@@ -80,7 +154,7 @@ void CompileControlVisitor::visit(SeqOp seq, ComponentOp &component) {
   Value fsmOut = fsmRegister.getOut();
 
   builder.setInsertionPointToStart(wiresBody);
-  auto oneConstant = createConstant(wires.getLoc(), builder, component, 1, 1);
+  auto oneConstant = getConstant(wires.getLoc(), builder, component, 1, 1);
 
   // Create the new compilation group to replace this SeqOp.
   builder.setInsertionPointToEnd(wiresBody);
@@ -88,29 +162,17 @@ void CompileControlVisitor::visit(SeqOp seq, ComponentOp &component) {
       builder.create<GroupOp>(wires->getLoc(), builder.getStringAttr("seq"));
 
   // Guarantees a unique SymbolName for the group.
-  SymbolTable symTable(wires);
   symTable.insert(seqGroup);
 
   size_t fsmIndex = 0;
-  SmallVector<Attribute, 8> compiledGroups;
   Value fsmNextState;
-  seq.walk([&](EnableOp enable) {
-    StringRef groupName = enable.getGroupName();
-    compiledGroups.push_back(
-        SymbolRefAttr::get(builder.getContext(), groupName));
-    auto groupOp = symTable.lookup<GroupOp>(groupName);
+  for (auto enable : seq.getBodyBlock()->getOps<EnableOp>()) {
+    auto groupOp = symTable.lookup<GroupOp>(enable.getGroupName());
+    auto doneOpValue = getDoneValue(builder, groupOp);
 
     builder.setInsertionPoint(groupOp);
-    auto fsmCurrentState = createConstant(wires->getLoc(), builder, component,
-                                          fsmBitWidth, fsmIndex);
-
-    // TODO(Calyx): Eventually, we should canonicalize the GroupDoneOp's guard
-    // and source.
-    auto guard = groupOp.getDoneOp().getGuard();
-    Value source = groupOp.getDoneOp().getSrc();
-    auto doneOpValue = !guard ? source
-                              : builder.create<comb::AndOp>(
-                                    wires->getLoc(), guard, source, false);
+    auto fsmCurrentState = getConstant(wires->getLoc(), builder, component,
+                                       fsmBitWidth, fsmIndex);
 
     // Build the Guard for the `go` signal of the current group being walked.
     // The group should begin when:
@@ -135,8 +197,8 @@ void CompileControlVisitor::visit(SeqOp seq, ComponentOp &component) {
     goOp->setOperands({oneConstant, groupGoGuard});
 
     // Add guarded assignments to the fsm register `in` and `write_en` ports.
-    fsmNextState = createConstant(wires->getLoc(), builder, component,
-                                  fsmBitWidth, fsmIndex + 1);
+    fsmNextState = getConstant(wires->getLoc(), builder, component,
+                               fsmBitWidth, fsmIndex + 1);
     builder.setInsertionPointToEnd(seqGroup.getBodyBlock());
     builder.create<AssignOp>(wires->getLoc(), fsmIn, fsmNextState,
                              groupDoneGuard);
@@ -144,7 +206,7 @@ void CompileControlVisitor::visit(SeqOp seq, ComponentOp &component) {
                              groupDoneGuard);
     // Increment the fsm index for the next group.
     ++fsmIndex;
-  });
+  }
 
   // Build the final guard for the new Seq group's GroupDoneOp. This is
   // defined by the fsm's final state.
@@ -160,12 +222,101 @@ void CompileControlVisitor::visit(SeqOp seq, ComponentOp &component) {
   // when the SeqGroup is finished executing.
   builder.setInsertionPointToEnd(wiresBody);
   auto zeroConstant =
-      createConstant(wires->getLoc(), builder, component, fsmBitWidth, 0);
+      getConstant(wires->getLoc(), builder, component, fsmBitWidth, 0);
   builder.create<AssignOp>(wires->getLoc(), fsmIn, zeroConstant, isFinalState);
   builder.create<AssignOp>(wires->getLoc(), fsmWriteEn, oneConstant,
                            isFinalState);
 
-  // Replace the SeqOp with an EnableOp.
+  replaceWithEnable(builder, seq, seqGroup);
+}
+
+/// Generates a counter-based schedule to realize a sequential operation whose
+/// groups all have static latencies. Instead of waiting for the done signal of
+/// each group, the FSM register counts the cycles since the start of the
+/// SeqOp, and each group is enabled for the number of cycles given by its
+/// `static` attribute. This saves the cycle spent on the handshake between
+/// consecutive groups, and the compiled group itself has a static latency of
+/// the sum of the latencies of its groups.
+void CompileControlVisitor::compileStaticSeq(SeqOp seq, ComponentOp &component,
+                                             ArrayRef<GroupOp> groups,
+                                             ArrayRef<uint64_t> latencies) {
+  auto wires = component.getWiresOp();
+  Block *wiresBody = wires.getBodyBlock();
+  auto loc = wires->getLoc();
+
+  uint64_t totalLatency = 0;
+  for (auto latency : latencies)
+    totalLatency += latency;
+  size_t fsmBitWidth = getNecessaryBitWidth(totalLatency + 1);
+
+  OpBuilder builder(component->getRegion(0));
+  auto fsmRegister =
+      createRegister(seq.getLoc(), builder, component, fsmBitWidth, "fsm");
+  Value fsmIn = fsmRegister.getIn();
+  Value fsmWriteEn = fsmRegister.getWriteEn();
+  Value fsmOut = fsmRegister.getOut();
+  auto oneConstant = getConstant(loc, builder, component, 1, 1);
+
+  builder.setInsertionPointToEnd(wiresBody);
+  auto seqGroup = builder.create<GroupOp>(loc, builder.getStringAttr("seq"));
+  seqGroup->setAttr("static", builder.getI64IntegerAttr(totalLatency));
+  symTable.insert(seqGroup);
+
+  // Each group is enabled while the FSM is in [start, start + latency).
+  uint64_t start = 0;
+  for (auto [group, latency] : llvm::zip(groups, latencies)) {
+    builder.setInsertionPoint(group);
+    auto end =
+        getConstant(loc, builder, component, fsmBitWidth, start + latency);
+    Value groupGoGuard = builder.create<comb::ICmpOp>(
+        loc, comb::ICmpPredicate::ult, fsmOut, end, false);
+    if (start != 0) {
+      auto begin = getConstant(loc, builder, component, fsmBitWidth, start);
+      auto started = builder.create<comb::ICmpOp>(
+          loc, comb::ICmpPredicate::uge, fsmOut, begin, false);
+      groupGoGuard =
+          builder.create<comb::AndOp>(loc, started, groupGoGuard, false);
+    }
+
+    auto goOp = group.getGoOp();
+    assert(goOp && "The Go Insertion pass should be run before this.");
+    goOp->setOperands({oneConstant, groupGoGuard});
+    start += latency;
+  }
+
+  // Count up until the final state is reached, which is when the compiled
+  // group is done.
+  builder.setInsertionPoint(seqGroup);
+  auto finalState =
+      getConstant(loc, builder, component, fsmBitWidth, totalLatency);
+  auto isFinalState = builder.create<comb::ICmpOp>(
+      loc, comb::ICmpPredicate::eq, fsmOut, finalState, false);
+  auto notFinalState = comb::createOrFoldNot(loc, isFinalState, builder);
+  auto fsmStepConstant = getConstant(loc, builder, component, fsmBitWidth, 1);
+  auto fsmNextState =
+      builder.create<comb::AddOp>(loc, fsmOut, fsmStepConstant, false);
+
+  builder.setInsertionPointToEnd(seqGroup.getBodyBlock());
+  builder.create<AssignOp>(loc, fsmIn, fsmNextState, notFinalState);
+  builder.create<AssignOp>(loc, fsmWriteEn, oneConstant, notFinalState);
+  builder.create<GroupDoneOp>(seqGroup->getLoc(), oneConstant, isFinalState);
+
+  // Reset the fsm when the SeqGroup is finished executing.
+  builder.setInsertionPointToEnd(wiresBody);
+  auto zeroConstant = getConstant(loc, builder, component, fsmBitWidth, 0);
+  builder.create<AssignOp>(loc, fsmIn, zeroConstant, isFinalState);
+  builder.create<AssignOp>(loc, fsmWriteEn, oneConstant, isFinalState);
+
+  replaceWithEnable(builder, seq, seqGroup);
+}
+
+void CompileControlVisitor::replaceWithEnable(OpBuilder &builder, SeqOp seq,
+                                              GroupOp seqGroup) {
+  SmallVector<Attribute, 8> compiledGroups;
+  for (auto enable : seq.getBodyBlock()->getOps<EnableOp>())
+    compiledGroups.push_back(
+        SymbolRefAttr::get(builder.getContext(), enable.getGroupName()));
+
   builder.setInsertionPoint(seq);
   builder.create<EnableOp>(
       seq->getLoc(), seqGroup.getSymName(),
@@ -184,7 +335,7 @@ struct CompileControlPass : public CompileControlBase<CompileControlPass> {
 
 void CompileControlPass::runOnOperation() {
   ComponentOp component = getOperation();
-  CompileControlVisitor CompileControlVisitor;
+  CompileControlVisitor CompileControlVisitor(component, compileStatic);
   component.getControlOp().walk(
       [&](Operation *op) { CompileControlVisitor.dispatch(op, component); });
 
@@ -0,0 +1,163 @@
+//===- ShareCells.cpp - Share cells between groups --------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass merges arithmetic cells of the same kind which are used by groups
+// that never run at the same time.
+//
+//===----------------------------------------------------------------------===//
+
+#include "PassDetails.h"
+#include "circt/Dialect/Calyx/CalyxOps.h"
+#include "circt/Dialect/Calyx/CalyxPasses.h"
+#include "circt/Support/LLVM.h"
+#include "llvm/ADT/MapVector.h"
+
+using namespace circt;
+using namespace calyx;
+using namespace mlir;
+
+/// Returns true if the cell is an arithmetic cell which may be shared.
+static bool isShareableCell(Operation *op) {
+  return isa<AddLibOp, SubLibOp, MultPipeLibOp, DivSPipeLibOp, DivUPipeLibOp,
+             RemSPipeLibOp, RemUPipeLibOp>(op);
+}
+
+/// Returns the only group using the ports of the cell, or a null group if the
+/// ports are used in more than one group or outside of a group. Cells used by
+/// several groups may hold a value from one group to the next and can
+/// therefore not be shared.
+static GroupOp getOwningGroup(Operation *cell) {
+  GroupOp owner;
+  for (auto *user : cell->getUsers()) {
+    auto group = user->getParentOfType<GroupOp>();
+    if (!group || (owner && owner != group))
+      return {};
+    owner = group;
+  }
+  return owner;
+}
+
+namespace {
+
+/// The points in the control program at which groups may run in parallel. For
+/// each group, this holds the `calyx.par` operations it is enabled within,
+/// along with the child of the par that contains the enable.
+class ParallelGroups {
+public:
+  explicit ParallelGroups(ControlOp control) {
+    control.walk([&](EnableOp enable) {
+      auto &branches = parBranches[enable.getGroupNameAttr().getAttr()];
+      Operation *child = enable;
+      for (auto *parent = enable->getParentOp(); !isa<ControlOp>(parent);
+           child = parent, parent = parent->getParentOp()) {
+        // The children of a par are the operations of its body.
+        if (isa<ParOp>(parent))
+          branches.push_back({parent, child});
+      }
+    });
+  }
+
+  /// Returns true if the two groups may run at the same time.
+  bool mayRunInParallel(GroupOp lhs, GroupOp rhs) const {
+    auto lhsIt = parBranches.find(lhs.getSymNameAttr());
+    auto rhsIt = parBranches.find(rhs.getSymNameAttr());
+    if (lhsIt == parBranches.end() || rhsIt == parBranches.end())
+      return false;
+    for (auto [lhsPar, lhsChild] : lhsIt->second)
+      for (auto [rhsPar, rhsChild] : rhsIt->second)
+        if (lhsPar == rhsPar && lhsChild != rhsChild)
+          return true;
+    return false;
+  }
+
+private:
+  DenseMap<StringAttr, SmallVector<std::pair<Operation *, Operation *>>>
+      parBranches;
+};
+
+/// A cell which has been kept, along with the groups using it.
+struct SharedCell {
+  Operation *cell;
+  SmallVector<GroupOp> groups;
+};
+
+struct ShareCellsPass : public ShareCellsBase<ShareCellsPass> {
+  void runOnOperation() override;
+
+  /// Parses the `limits` option into `maxGroupsPerCell`.
+  LogicalResult parseLimits();
+
+  /// The maximum number of groups which may share a cell of a given kind. Kinds
+  /// without an entry are not limited.
+  llvm::StringMap<unsigned> maxGroupsPerCell;
+};
+
+} // end anonymous namespace
+
+LogicalResult ShareCellsPass::parseLimits() {
+  for (StringRef limit : limits) {
+    auto [kind, value] = limit.split('=');
+    unsigned maxGroups;
+    if (kind.empty() || value.getAsInteger(10, maxGroups) || maxGroups == 0)
+      return getOperation().emitError()
+             << "invalid cell sharing limit '" << limit
+             << "', expected '<cell kind>=<positive integer>'";
+    maxGroupsPerCell[kind] = maxGroups;
+  }
+  return success();
+}
+
+void ShareCellsPass::runOnOperation() {
+  ComponentOp component = getOperation();
+  if (failed(parseLimits()))
+    return signalPassFailure();
+
+  ParallelGroups parallelGroups(component.getControlOp());
+
+  // Cells are grouped by their kind and port types; only cells that agree on
+  // both may replace one another.
+  using CellKey = std::pair<OperationName, TypeRange>;
+  llvm::MapVector<CellKey, SmallVector<SharedCell>> sharedCells;
+
+  for (auto &op : llvm::make_early_inc_range(*component.getBodyBlock())) {
+    if (!isShareableCell(&op))
+      continue;
+    auto group = getOwningGroup(&op);
+    if (!group)
+      continue;
+
+    auto &candidates = sharedCells[{op.getName(), op.getResultTypes()}];
+    auto limitIt = maxGroupsPerCell.find(op.getName().stripDialect());
+    std::optional<unsigned> limit;
+    if (limitIt != maxGroupsPerCell.end())
+      limit = limitIt->second;
+
+    // Look for a cell which is not used by this group or by any group that
+    // may run at the same time.
+    auto *shared = llvm::find_if(candidates, [&](SharedCell &candidate) {
+      if (limit && candidate.groups.size() >= *limit)
+        return false;
+      return llvm::none_of(candidate.groups, [&](GroupOp other) {
+        return other == group || parallelGroups.mayRunInParallel(other, group);
+      });
+    });
+    if (shared == candidates.end()) {
+      candidates.push_back({&op, {group}});
+      continue;
+    }
+
+    op.replaceAllUsesWith(shared->cell);
+    op.erase();
+    shared->groups.push_back(group);
+    ++numCellsShared;
+  }
+}
+
+std::unique_ptr<mlir::Pass> circt::calyx::createShareCellsPass() {
+  return std::make_unique<ShareCellsPass>();
+}
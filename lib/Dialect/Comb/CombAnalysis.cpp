@@ -13,13 +13,22 @@
 using namespace circt;
 using namespace comb;
 
+/// The known bits already computed for a value at a given recursion depth.
+/// Since the recursion is capped, a value can be known less precisely the
+/// deeper it is reached, so the depth is part of the key.
+using KnownBitsCache = DenseMap<std::pair<Value, unsigned>, KnownBits>;
+
+static KnownBits computeKnownBits(Value v, unsigned depth,
+                                  KnownBitsCache &cache);
+
 /// Given an integer SSA value, check to see if we know anything about the
 /// result of the computation.  For example, we know that "and with a constant"
 /// always returns zeros for the zero bits in a constant.
 ///
 /// Expression trees can be very large, so we need ot make sure to cap our
 /// recursion, this is controlled by `depth`.
-static KnownBits computeKnownBits(Value v, unsigned depth) {
+static KnownBits computeKnownBitsImpl(Value v, unsigned depth,
+                                      KnownBitsCache &cache) {
   Operation *op = v.getDefiningOp();
   if (!op || depth == 5)
     return KnownBits(v.getType().getIntOrFloatBitWidth());
@@ -30,9 +39,10 @@ static KnownBits computeKnownBits(Value v, unsigned depth) {
 
   // `concat(x, y, z)` has whatever is known about the operands concat'd.
   if (auto concatOp = dyn_cast<ConcatOp>(op)) {
-    auto result = computeKnownBits(concatOp.getOperand(0), depth + 1);
+    auto result = computeKnownBits(concatOp.getOperand(0), depth + 1, cache);
     for (size_t i = 1, e = concatOp.getNumOperands(); i != e; ++i) {
-      auto otherBits = computeKnownBits(concatOp.getOperand(i), depth + 1);
+      auto otherBits =
+          computeKnownBits(concatOp.getOperand(i), depth + 1, cache);
       unsigned width = otherBits.getBitWidth();
       unsigned newWidth = result.getBitWidth() + width;
       result.Zero =
@@ -45,45 +55,60 @@ static KnownBits computeKnownBits(Value v, unsigned depth) {
 
   // `and(x, y, z)` has whatever is known about the operands intersected.
   if (auto andOp = dyn_cast<AndOp>(op)) {
-    auto result = computeKnownBits(andOp.getOperand(0), depth + 1);
+    auto result = computeKnownBits(andOp.getOperand(0), depth + 1, cache);
     for (size_t i = 1, e = andOp.getNumOperands(); i != e; ++i)
-      result &= computeKnownBits(andOp.getOperand(i), depth + 1);
+      result &= computeKnownBits(andOp.getOperand(i), depth + 1, cache);
     return result;
   }
 
   // `or(x, y, z)` has whatever is known about the operands unioned.
   if (auto orOp = dyn_cast<OrOp>(op)) {
-    auto result = computeKnownBits(orOp.getOperand(0), depth + 1);
+    auto result = computeKnownBits(orOp.getOperand(0), depth + 1, cache);
     for (size_t i = 1, e = orOp.getNumOperands(); i != e; ++i)
-      result |= computeKnownBits(orOp.getOperand(i), depth + 1);
+      result |= computeKnownBits(orOp.getOperand(i), depth + 1, cache);
     return result;
   }
 
   // `xor(x, cst)` inverts known bits and passes through unmodified ones.
   if (auto xorOp = dyn_cast<XorOp>(op)) {
-    auto result = computeKnownBits(xorOp.getOperand(0), depth + 1);
+    auto result = computeKnownBits(xorOp.getOperand(0), depth + 1, cache);
     for (size_t i = 1, e = xorOp.getNumOperands(); i != e; ++i) {
       // If we don't know anything, we don't need to evaluate more subexprs.
       if (result.isUnknown())
         return result;
-      result ^= computeKnownBits(xorOp.getOperand(i), depth + 1);
+      result ^= computeKnownBits(xorOp.getOperand(i), depth + 1, cache);
     }
     return result;
   }
 
   // `mux(cond, x, y)` is the intersection of the known bits of `x` and `y`.
   if (auto muxOp = dyn_cast<MuxOp>(op)) {
-    auto lhs = computeKnownBits(muxOp.getTrueValue(), depth + 1);
-    auto rhs = computeKnownBits(muxOp.getFalseValue(), depth + 1);
+    auto lhs = computeKnownBits(muxOp.getTrueValue(), depth + 1, cache);
+    auto rhs = computeKnownBits(muxOp.getFalseValue(), depth + 1, cache);
     return lhs.intersectWith(rhs);
   }
 
   return KnownBits(v.getType().getIntOrFloatBitWidth());
 }
 
+/// Return the known bits of a value, reusing the result if the value has
+/// already been visited at the same depth.  Expression trees are often DAGs with
+/// heavily shared subexpressions, which would otherwise be revisited once for
+/// every path that reaches them.
+static KnownBits computeKnownBits(Value v, unsigned depth,
+                                  KnownBitsCache &cache) {
+  auto it = cache.find({v, depth});
+  if (it != cache.end())
+    return it->second;
+  auto result = computeKnownBitsImpl(v, depth, cache);
+  cache.insert({{v, depth}, result});
+  return result;
+}
+
 /// Given an integer SSA value, check to see if we know anything about the
 /// result of the computation.  For example, we know that "and with a
 /// constant" always returns zeros for the zero bits in a constant.
 KnownBits comb::computeKnownBits(Value value) {
-  return ::computeKnownBits(value, 0);
+  KnownBitsCache cache;
+  return ::computeKnownBits(value, 0, cache);
 }
@@ -56,6 +56,18 @@ OpFoldResult JoinOp::fold(FoldAdaptor adaptor) {
     }
   }
 
+  // Remove operands which are other outputs of a fork that is already joined.
+  // The fork emits a token on each of its outputs for every incoming token, so
+  // joining one of them is enough.
+  llvm::DenseSet<Operation *> joinedForks;
+  for (OpOperand &operand : llvm::make_early_inc_range(op->getOpOperands())) {
+    auto fork = operand.get().getDefiningOp<dc::ForkOp>();
+    if (fork && !joinedForks.insert(fork).second) {
+      op->eraseOperand(operand.getOperandNumber());
+      return getOutput();
+    }
+  }
+
   // Canonicalization staggered joins where the sink join contains inputs also
   // found in the source join.
   for (OpOperand &operand : llvm::make_early_inc_range(op->getOpOperands())) {
@@ -176,10 +188,36 @@ public:
   }
 };
 
+class EliminateUnusedForkOutputsPattern : public OpRewritePattern<ForkOp> {
+  // Canonicalizes away fork outputs which are not used, e.g. after their sinks
+  // have been removed, in favor of a smaller fork.
+public:
+  using OpRewritePattern<ForkOp>::OpRewritePattern;
+  LogicalResult matchAndRewrite(ForkOp fork,
+                                PatternRewriter &rewriter) const override {
+    llvm::SmallVector<Value> usedOutputs;
+    for (auto output : fork.getOutputs())
+      if (!output.use_empty())
+        usedOutputs.push_back(output);
+
+    // Forks without any used output are removed as dead code.
+    if (usedOutputs.size() == fork.getNumResults() || usedOutputs.empty())
+      return failure();
+
+    auto newFork = rewriter.create<dc::ForkOp>(fork.getLoc(), fork.getToken(),
+                                               usedOutputs.size());
+    for (auto [output, newOutput] :
+         llvm::zip(usedOutputs, newFork.getResults()))
+      rewriter.replaceAllUsesWith(output, newOutput);
+    rewriter.eraseOp(fork);
+    return success();
+  }
+};
+
 void ForkOp::getCanonicalizationPatterns(RewritePatternSet &results,
                                          MLIRContext *context) {
-  results.insert<EliminateForkToForkPattern, EliminateForkOfSourcePattern>(
-      context);
+  results.insert<EliminateForkToForkPattern, EliminateForkOfSourcePattern,
+                 EliminateUnusedForkOutputsPattern>(context);
 }
 
 LogicalResult ForkOp::fold(FoldAdaptor adaptor,
@@ -333,6 +371,32 @@ void SelectOp::getCanonicalizationPatterns(RewritePatternSet &results,
 // BufferOp
 // =============================================================================
 
+class MergeBufferChainPattern : public OpRewritePattern<BufferOp> {
+  // Canonicalizes a buffer which is only fed into another buffer into a single
+  // buffer providing the slots of both. Buffers with initial values are kept,
+  // since they define the tokens present at reset.
+public:
+  using OpRewritePattern<BufferOp>::OpRewritePattern;
+  LogicalResult matchAndRewrite(BufferOp buffer,
+                                PatternRewriter &rewriter) const override {
+    auto inputBuffer = buffer.getInput().getDefiningOp<BufferOp>();
+    if (!inputBuffer || !inputBuffer->hasOneUse() ||
+        inputBuffer.getInitValues() || buffer.getInitValues())
+      return failure();
+
+    rewriter.replaceOpWithNewOp<BufferOp>(
+        buffer, inputBuffer.getInput(),
+        inputBuffer.getSize() + buffer.getSize());
+    rewriter.eraseOp(inputBuffer);
+    return success();
+  }
+};
+
+void BufferOp::getCanonicalizationPatterns(RewritePatternSet &results,
+                                           MLIRContext *context) {
+  results.insert<MergeBufferChainPattern>(context);
+}
+
 FailureOr<SmallVector<int64_t>> BufferOp::getInitValueArray() {
   assert(getInitValues() && "initValues attribute not set");
   SmallVector<int64_t> values;
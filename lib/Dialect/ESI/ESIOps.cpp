@@ -13,6 +13,7 @@
 #include "circt/Dialect/ESI/ESIOps.h"
 #include "circt/Dialect/HW/HWOpInterfaces.h"
 #include "circt/Dialect/HW/HWTypes.h"
+#include "circt/Dialect/MSFT/MSFTAttributes.h"
 #include "circt/Dialect/SV/SVOps.h"
 #include "circt/Dialect/SV/SVTypes.h"
 #include "circt/Support/LLVM.h"
@@ -63,6 +64,34 @@ circt::esi::ChannelType ChannelBufferOp::channelType() {
   return getInput().getType().cast<circt::esi::ChannelType>();
 }
 
+/// Check that `kind` names one of the stage implementations.
+static LogicalResult verifyStageKind(Operation *op, StringRef kind) {
+  if (kind != "skid" && kind != "register" && kind != "fifo")
+    return op->emitOpError("unknown stage kind '")
+           << kind << "', expected 'skid', 'register' or 'fifo'";
+  return success();
+}
+
+LogicalResult ChannelBufferOp::verify() {
+  if (failed(verifyStageKind(*this, getStageKind())))
+    return failure();
+
+  auto placements = getPlacements();
+  if (!placements)
+    return success();
+  if (!getName())
+    return emitOpError("placements require a name for the stages");
+  uint64_t numStages = getStageKind() == "fifo" ? 1 : getStages().value_or(1);
+  if (placements->size() != numStages)
+    return emitOpError("expected ")
+           << numStages << " placements, one for each stage, got "
+           << placements->size();
+  for (Attribute placement : *placements)
+    if (!placement.isa<msft::PhysLocationAttr>())
+      return emitOpError("placements must be #msft.physloc attributes");
+  return success();
+}
+
 //===----------------------------------------------------------------------===//
 // PipelineStageOp functions.
 //===----------------------------------------------------------------------===//
@@ -98,6 +127,16 @@ circt::esi::ChannelType PipelineStageOp::channelType() {
   return getInput().getType().cast<circt::esi::ChannelType>();
 }
 
+LogicalResult PipelineStageOp::verify() {
+  if (failed(verifyStageKind(*this, getStageKind())))
+    return failure();
+  if (getStageKind() == "fifo" && !getDepth())
+    return emitOpError("fifo stages require a depth");
+  if (getStageKind() != "fifo" && getDepth())
+    return emitOpError("only fifo stages have a depth");
+  return success();
+}
+
 //===----------------------------------------------------------------------===//
 // Wrap / unwrap.
 //===----------------------------------------------------------------------===//
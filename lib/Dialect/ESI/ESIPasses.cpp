@@ -49,7 +49,8 @@ ESIHWBuilder::ESIHWBuilder(Operation *top)
       dataIn(StringAttr::get(getContext(), "DataIn")),
       clk(StringAttr::get(getContext(), "clk")),
       rst(StringAttr::get(getContext(), "rst")),
-      width(StringAttr::get(getContext(), "WIDTH")) {
+      width(StringAttr::get(getContext(), "WIDTH")),
+      depth(StringAttr::get(getContext(), "DEPTH")) {
 
   auto regions = top->getRegions();
   if (regions.empty()) {
@@ -117,14 +118,27 @@ ArrayAttr ESIHWBuilder::getStageParameterList(Attribute value) {
   return ArrayAttr::get(width.getContext(), widthParam);
 }
 
+/// Return a parameter list for the FIFO module with the specified values.
+ArrayAttr ESIHWBuilder::getFIFOParameterList(Attribute widthValue,
+                                             Attribute depthValue) {
+  auto type = IntegerType::get(width.getContext(), 32, IntegerType::Unsigned);
+  auto widthParam =
+      ParamDeclAttr::get(width.getContext(), width, type, widthValue);
+  auto depthParam =
+      ParamDeclAttr::get(depth.getContext(), depth, type, depthValue);
+  return ArrayAttr::get(width.getContext(), {widthParam, depthParam});
+}
+
 /// Write an 'ExternModuleOp' to use a hand-coded SystemVerilog module. Said
-/// module implements pipeline stage, adding 1 cycle latency. This particular
-/// implementation is double-buffered and fully pipelines the reverse-flow ready
-/// signal.
+/// module implements pipeline stage of the kind requested by `stage`, adding 1
+/// cycle latency. The default "skid" implementation is double-buffered and
+/// fully pipelines the reverse-flow ready signal. The "register" one only
+/// registers the forward signals and the "fifo" one is a multi-entry FIFO.
 HWModuleExternOp ESIHWBuilder::declareStage(Operation *symTable,
                                             PipelineStageOp stage) {
   Type dataType = stage.innerType();
-  HWModuleExternOp &stageMod = declaredStage[dataType];
+  StringRef kind = stage.getStageKind();
+  HWModuleExternOp &stageMod = declaredStage[{dataType, kind}];
   if (stageMod)
     return stageMod;
 
@@ -146,9 +160,17 @@ HWModuleExternOp ESIHWBuilder::declareStage(Operation *symTable,
   ports.push_back({xValid, PortDirection::OUTPUT, getI1Type(), resn++});
   ports.push_back({xReady, PortDirection::INPUT, getI1Type(), argn++});
 
-  stageMod = create<HWModuleExternOp>(
-      constructUniqueSymbol(symTable, "ESI_PipelineStage"), ports,
-      "ESI_PipelineStage", getStageParameterList({}));
+  StringRef moduleName = "ESI_PipelineStage";
+  ArrayAttr params = getStageParameterList({});
+  if (kind == "register") {
+    moduleName = "ESI_RegisterStage";
+  } else if (kind == "fifo") {
+    moduleName = "ESI_FIFO";
+    params = getFIFOParameterList({}, {});
+  }
+  stageMod =
+      create<HWModuleExternOp>(constructUniqueSymbol(symTable, moduleName),
+                               ports, moduleName, params);
   return stageMod;
 }
 
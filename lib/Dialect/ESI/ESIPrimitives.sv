@@ -118,3 +118,99 @@ module ESI_PipelineStage # (
     end
   end
 endmodule
+
+/// ESI_RegisterStage: a cheaper pipeline stage which only registers the data
+/// and valid signals. The backpressure (a_ready) is a combinational function
+/// of x_ready, so use this where the forward path is the critical one. Will not
+/// introduce pipeline bubbles.
+module ESI_RegisterStage # (
+  int WIDTH = 8
+) (
+  input logic clk,
+  input logic rst,
+
+  // Input LI channel.
+  input logic a_valid,
+  input logic [WIDTH-1:0] a,
+  output logic a_ready,
+
+  // Output LI channel.
+  output logic x_valid,
+  output logic [WIDTH-1:0] x,
+  input logic x_ready
+);
+
+  // Output registers.
+  logic [WIDTH-1:0] x_reg;
+  logic x_valid_reg;
+  assign x = x_reg;
+  assign x_valid = x_valid_reg;
+
+  // We can take a token if the output register is empty or is being emptied
+  // this cycle.
+  assign a_ready = ~x_valid_reg || x_ready;
+
+  always_ff @(posedge clk) begin
+    if (rst) begin
+      x_valid_reg <= 1'b0;
+    end else if (a_ready) begin
+      x_reg <= a;
+      x_valid_reg <= a_valid;
+    end
+  end
+endmodule
+
+/// ESI_FIFO: a FIFO which holds up to DEPTH tokens. Both a_ready and x_valid
+/// come straight from registers, so there is no combinational path through the
+/// FIFO. Adds one cycle of latency.
+module ESI_FIFO # (
+  int WIDTH = 8,
+  int DEPTH = 2
+) (
+  input logic clk,
+  input logic rst,
+
+  // Input LI channel.
+  input logic a_valid,
+  input logic [WIDTH-1:0] a,
+  output logic a_ready,
+
+  // Output LI channel.
+  output logic x_valid,
+  output logic [WIDTH-1:0] x,
+  input logic x_ready
+);
+
+  localparam int PTR_WIDTH = DEPTH > 1 ? $clog2(DEPTH) : 1;
+
+  logic [WIDTH-1:0] mem [DEPTH-1:0];
+  logic [PTR_WIDTH-1:0] rd_ptr, wr_ptr;
+  // The number of tokens in the FIFO.
+  logic [PTR_WIDTH:0] count;
+
+  assign a_ready = count != DEPTH;
+  assign x_valid = count != 0;
+  assign x = mem[rd_ptr];
+
+  wire push = a_valid && a_ready;
+  wire pop = x_valid && x_ready;
+
+  always_ff @(posedge clk) begin
+    if (rst) begin
+      rd_ptr <= '0;
+      wr_ptr <= '0;
+      count <= '0;
+    end else begin
+      if (push) begin
+        mem[wr_ptr] <= a;
+        wr_ptr <= wr_ptr == PTR_WIDTH'(DEPTH - 1) ? '0 : wr_ptr + 1'b1;
+      end
+      if (pop)
+        rd_ptr <= rd_ptr == PTR_WIDTH'(DEPTH - 1) ? '0 : rd_ptr + 1'b1;
+      if (push && !pop)
+        count <= count + 1'b1;
+      else if (!push && pop)
+        count <= count - 1'b1;
+    end
+  end
+endmodule
@@ -338,35 +338,40 @@ LogicalResult ESIConnectServicesPass::process(hw::HWModuleLike mod) {
       anyServiceInst = b;
   }
 
-  // Decompose the 'inout' requests int to 'in' and 'out' requests.
-  mod.walk([&](RequestInOutChannelOp reqInOut) {
-    ImplicitLocOpBuilder b(reqInOut.getLoc(), reqInOut);
-    b.create<RequestToServerConnectionOp>(reqInOut.getServicePortAttr(),
-                                          reqInOut.getToServer(),
-                                          reqInOut.getClientNamePathAttr());
-    auto toClientReq = b.create<RequestToClientConnectionOp>(
-        reqInOut.getToClient().getType(), reqInOut.getServicePortAttr(),
-        reqInOut.getClientNamePathAttr());
-    reqInOut.getToClient().replaceAllUsesWith(toClientReq.getToClient());
-    reqInOut.erase();
-  });
-
-  // Find all of the "local" requests.
+  // Decompose the 'inout' requests into 'in' and 'out' requests, and sort all
+  // of the requests into the "local" ones, which are moved into the request
+  // block of the service instance serving them, and the ones which have to be
+  // surfaced. Modules may contain thousands of requests, so this is done in a
+  // single walk.
+  SmallVector<RequestToClientConnectionOp, 4> nonLocalToClientReqs;
+  SmallVector<RequestToServerConnectionOp, 4> nonLocalToServerReqs;
+  auto sortReq = [&](auto req, auto &nonLocalReqs) {
+    auto service = req.getServicePortAttr().getModuleRef();
+    auto implOpF = localImplReqs.find(service);
+    Block *localReqs =
+        implOpF != localImplReqs.end() ? implOpF->second : anyServiceInst;
+    if (localReqs)
+      req->moveBefore(localReqs, localReqs->end());
+    else
+      nonLocalReqs.push_back(req);
+  };
   mod.walk([&](Operation *op) {
     if (auto req = dyn_cast<RequestToClientConnectionOp>(op)) {
-      auto service = req.getServicePortAttr().getModuleRef();
-      auto implOpF = localImplReqs.find(service);
-      if (implOpF != localImplReqs.end())
-        req->moveBefore(implOpF->second, implOpF->second->end());
-      else if (anyServiceInst)
-        req->moveBefore(anyServiceInst, anyServiceInst->end());
+      sortReq(req, nonLocalToClientReqs);
     } else if (auto req = dyn_cast<RequestToServerConnectionOp>(op)) {
-      auto service = req.getServicePortAttr().getModuleRef();
-      auto implOpF = localImplReqs.find(service);
-      if (implOpF != localImplReqs.end())
-        req->moveBefore(implOpF->second, implOpF->second->end());
-      else if (anyServiceInst)
-        req->moveBefore(anyServiceInst, anyServiceInst->end());
+      sortReq(req, nonLocalToServerReqs);
+    } else if (auto reqInOut = dyn_cast<RequestInOutChannelOp>(op)) {
+      ImplicitLocOpBuilder b(reqInOut.getLoc(), reqInOut);
+      auto toServerReq = b.create<RequestToServerConnectionOp>(
+          reqInOut.getServicePortAttr(), reqInOut.getToServer(),
+          reqInOut.getClientNamePathAttr());
+      auto toClientReq = b.create<RequestToClientConnectionOp>(
+          reqInOut.getToClient().getType(), reqInOut.getServicePortAttr(),
+          reqInOut.getClientNamePathAttr());
+      reqInOut.getToClient().replaceAllUsesWith(toClientReq.getToClient());
+      reqInOut.erase();
+      sortReq(toServerReq, nonLocalToServerReqs);
+      sortReq(toClientReq, nonLocalToClientReqs);
     }
   });
 
@@ -382,23 +387,6 @@ LogicalResult ESIConnectServicesPass::process(hw::HWModuleLike mod) {
   // Copy any metadata up the instance hierarchy.
   copyMetadata(mod);
 
-  // Identify the non-local reqs which need to be surfaced from this module.
-  SmallVector<RequestToClientConnectionOp, 4> nonLocalToClientReqs;
-  SmallVector<RequestToServerConnectionOp, 4> nonLocalToServerReqs;
-  mod.walk([&](Operation *op) {
-    if (auto req = dyn_cast<RequestToClientConnectionOp>(op)) {
-      auto service = req.getServicePortAttr().getModuleRef();
-      auto implOpF = localImplReqs.find(service);
-      if (implOpF == localImplReqs.end())
-        nonLocalToClientReqs.push_back(req);
-    } else if (auto req = dyn_cast<RequestToServerConnectionOp>(op)) {
-      auto service = req.getServicePortAttr().getModuleRef();
-      auto implOpF = localImplReqs.find(service);
-      if (implOpF == localImplReqs.end())
-        nonLocalToServerReqs.push_back(req);
-    }
-  });
-
   // Surface all of the requests which cannot be fulfilled locally.
   if (nonLocalToClientReqs.empty() && nonLocalToServerReqs.empty())
     return success();
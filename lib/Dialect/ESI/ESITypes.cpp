@@ -18,6 +18,7 @@
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/TypeSwitch.h"
+#include "llvm/Support/MathExtras.h"
 
 using namespace circt;
 using namespace circt::esi;
@@ -54,8 +55,20 @@ WindowType::verify(llvm::function_ref<InFlightDiagnostic()> emitError,
       if (f == frameFields.end())
         continue;
 
-      // If 'numItems' is specified, gotta run more checks.
+      // Lists are sent in bulk frames, 'numItems' at a time.
       uint64_t numItems = f->getSecond().getNumItems();
+      if (isa<ListType>(field.type)) {
+        if (numItems == 0)
+          return emitError() << "list field " << field.name
+                             << " must specify the number of items per frame";
+        if (frame.getMembers().size() != 1)
+          return emitError() << "list fields must be in their own frame (in "
+                             << field.name << ")";
+        frameFields.erase(f);
+        continue;
+      }
+
+      // If 'numItems' is specified, gotta run more checks.
       if (numItems > 0) {
         auto arrField = hw::type_dyn_cast<hw::ArrayType>(field.type);
         if (!arrField)
@@ -99,8 +112,25 @@ hw::UnionType WindowType::getLoweredType() const {
       auto fieldTypeIter = intoFields.find(field.getFieldName());
       assert(fieldTypeIter != intoFields.end());
 
-      // If the number of items isn't specified, just use the type.
-      if (field.getNumItems() == 0) {
+      // A list is sent as a series of frames, each with up to numItems items.
+      // Every frame has the number of valid items (if there may be fewer than
+      // numItems) and is marked if it is the last one of the list.
+      if (auto list = dyn_cast<ListType>(fieldTypeIter->getSecond())) {
+        uint64_t numItems = field.getNumItems();
+        fields.push_back(
+            {field.getFieldName(),
+             hw::ArrayType::get(list.getElementType(), numItems)});
+        if (numItems > 1) {
+          auto sizeName = StringAttr::get(
+              getContext(), Twine(field.getFieldName().getValue(), "_size"));
+          auto sizeType =
+              IntegerType::get(getContext(), llvm::Log2_64_Ceil(numItems + 1));
+          fields.push_back({sizeName, sizeType});
+        }
+        fields.push_back({StringAttr::get(getContext(), "last"),
+                          IntegerType::get(getContext(), 1)});
+      } else if (field.getNumItems() == 0) {
+        // If the number of items isn't specified, just use the type.
         fields.push_back({field.getFieldName(), fieldTypeIter->getSecond()});
       } else {
         // If the number of items is specified, we can assume that it's an array
@@ -22,6 +22,7 @@
 #include "circt/Dialect/ESI/ESIPasses.h"
 #include "circt/Dialect/HW/HWDialect.h"
 #include "circt/Dialect/HW/HWOps.h"
+#include "circt/Dialect/MSFT/MSFTDialect.h"
 #include "circt/Dialect/SV/SVDialect.h"
 #include "circt/Dialect/SV/SVOps.h"
 #include "circt/Dialect/Seq/SeqDialect.h"
@@ -48,6 +49,7 @@ public:
   ESIHWBuilder(Operation *top);
 
   ArrayAttr getStageParameterList(Attribute value);
+  ArrayAttr getFIFOParameterList(Attribute widthValue, Attribute depthValue);
 
   hw::HWModuleExternOp declareStage(Operation *symTable, PipelineStageOp);
   // Will be unused when CAPNP is undefined
@@ -63,7 +65,7 @@ public:
   const StringAttr dataOutValid, dataOutReady, dataOut, dataInValid,
       dataInReady, dataIn;
   const StringAttr clk, rst;
-  const StringAttr width;
+  const StringAttr width, depth;
 
   // Various identifier strings. Keep them all here in case we rename them.
   static constexpr char dataStr[] = "data", validStr[] = "valid",
@@ -75,7 +77,9 @@ private:
   /// taken in the symbol table.
   StringAttr constructInterfaceName(ChannelType);
 
-  llvm::DenseMap<Type, hw::HWModuleExternOp> declaredStage;
+  /// Stage module declarations by data type and stage kind.
+  llvm::DenseMap<std::pair<Type, StringRef>, hw::HWModuleExternOp>
+      declaredStage;
   llvm::DenseMap<std::pair<Type, Type>, hw::HWModuleExternOp>
       declaredCosimEndpointOp;
   llvm::DenseMap<Type, sv::InterfaceOp> portTypeLookup;
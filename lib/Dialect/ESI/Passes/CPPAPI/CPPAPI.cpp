@@ -45,6 +45,16 @@ static std::string lowercase(llvm::StringRef str) {
   return s;
 }
 
+/// Returns the name of the Cap'nProto C++ accessors for a field, which
+/// capitalize the first letter of the field name.
+static std::string capnpAccessorName(llvm::StringRef prefix,
+                                     llvm::StringRef fieldName) {
+  std::string s = prefix.str() + fieldName.str();
+  if (!fieldName.empty())
+    s[prefix.size()] = llvm::toUpper(s[prefix.size()]);
+  return s;
+}
+
 static std::string joinStringAttrArray(mlir::ArrayAttr strings,
                                        llvm::StringRef delimiter) {
   std::string s;
@@ -205,7 +215,37 @@ LogicalResult CPPType::write(mlir::raw_indented_ostream &os) const {
   else
     os << name();
 
-  os << ";\n";
+  os << ";\n\n";
+
+  // Statically typed conversions to and from Cap'nProto messages. The
+  // backends prefer these to the reflection-based conversions.
+  os << "// Write this value into a Cap'nProto message\n";
+  os << "void toCapnp(CPType::Builder builder) const {\n";
+  os.indent();
+  for (auto field : fieldTypes) {
+    if (isZeroWidthInt(field.type))
+      continue;
+    auto fieldName = field.name.getValue();
+    os << "builder." << capnpAccessorName("set", fieldName) << "(" << fieldName
+       << ");\n";
+  }
+  os.unindent();
+  os << "}\n\n";
+
+  os << "// Read a value from a Cap'nProto message\n";
+  os << "static " << name() << " fromCapnp(CPType::Reader reader) {\n";
+  os.indent();
+  os << name() << " ret;\n";
+  for (auto field : fieldTypes) {
+    if (isZeroWidthInt(field.type))
+      continue;
+    auto fieldName = field.name.getValue();
+    os << "ret." << fieldName << " = reader."
+       << capnpAccessorName("get", fieldName) << "();\n";
+  }
+  os << "return ret;\n";
+  os.unindent();
+  os << "}\n";
 
   os.unindent();
   os << "};\n\n";
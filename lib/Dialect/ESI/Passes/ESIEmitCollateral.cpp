@@ -57,6 +57,11 @@ static llvm::json::Value toJSON(Type type) {
                                               {"type", toJSON(field.type)}}));
                    return Object({{"fields", Value(std::move(fields))}});
                  })
+                 .Case([&](ArrayType t) {
+                   m = "array";
+                   return Object({{"size", t.getSize()},
+                                  {"element", toJSON(t.getElementType())}});
+                 })
                  .Default([&](Type t) {
                    llvm::raw_string_ostream(m) << t;
                    return Object();
@@ -14,6 +14,7 @@
 
 #include "circt/Dialect/ESI/ESIOps.h"
 #include "circt/Dialect/HW/HWOps.h"
+#include "circt/Dialect/MSFT/MSFTOps.h"
 #include "circt/Support/BackedgeBuilder.h"
 #include "circt/Support/LLVM.h"
 
@@ -25,9 +26,9 @@ using namespace circt::esi::detail;
 using namespace circt::hw;
 
 namespace {
-/// Lower `ChannelBufferOp`s, breaking out the various options. For now, just
-/// replace with the specified number of pipeline stages (since that's the only
-/// option).
+/// Lower `ChannelBufferOp`s, breaking out the various options. Replace with the
+/// specified number of pipeline stages of the specified kind, or a single FIFO
+/// stage.
 struct ChannelBufferLowering : public OpConversionPattern<ChannelBufferOp> {
 public:
   using OpConversionPattern::OpConversionPattern;
@@ -38,6 +39,26 @@ public:
 };
 } // anonymous namespace
 
+/// Find the instance hierarchy rooted at the module containing `buffer`, or
+/// create it.
+static msft::InstanceHierarchyOp
+getOrCreateHierarchy(ChannelBufferOp buffer,
+                     ConversionPatternRewriter &rewriter) {
+  Operation *mod = buffer->getParentWithTrait<OpTrait::IsIsolatedFromAbove>();
+  auto modName = FlatSymbolRefAttr::get(SymbolTable::getSymbolName(mod));
+  auto topLevel = buffer->getParentOfType<mlir::ModuleOp>();
+  for (auto hier : topLevel.getOps<msft::InstanceHierarchyOp>())
+    if (hier.getTopModuleRefAttr() == modName && !hier.getInstName())
+      return hier;
+
+  OpBuilder::InsertionGuard guard(rewriter);
+  rewriter.setInsertionPointToEnd(topLevel.getBody());
+  auto hier = rewriter.create<msft::InstanceHierarchyOp>(buffer.getLoc(),
+                                                         modName, StringAttr());
+  rewriter.createBlock(&hier.getBody());
+  return hier;
+}
+
 LogicalResult ChannelBufferLowering::matchAndRewrite(
     ChannelBufferOp buffer, OpAdaptor adaptor,
     ConversionPatternRewriter &rewriter) const {
@@ -52,16 +73,46 @@ LogicalResult ChannelBufferLowering::matchAndRewrite(
     // Guaranteed positive by the parser.
     numStages = stages.getValue().getLimitedValue();
   }
+
+  // A FIFO is a single stage which holds all the messages.
+  StringAttr kind = buffer.getKindAttr();
+  IntegerAttr depth;
+  if (buffer.getStageKind() == "fifo") {
+    depth = rewriter.getI64IntegerAttr(numStages);
+    numStages = 1;
+  }
+
+  // Placements go into the instance hierarchy rooted at the module containing
+  // the buffer. The stage instances get symbols so they can be referred to.
+  msft::InstanceHierarchyOp hierarchy;
+  if (buffer.getPlacements())
+    hierarchy = getOrCreateHierarchy(buffer, rewriter);
+
   Value input = buffer.getInput();
   StringAttr bufferName = buffer.getNameAttr();
   for (uint64_t i = 0; i < numStages; ++i) {
     // Create the stages, connecting them up as we build.
-    auto stage = rewriter.create<PipelineStageOp>(loc, type, buffer.getClk(),
-                                                  buffer.getRst(), input);
+    auto stage = rewriter.create<PipelineStageOp>(
+        loc, type, buffer.getClk(), buffer.getRst(), input, kind, depth);
     if (bufferName) {
       SmallString<64> stageName(
           {bufferName.getValue(), "_stage", std::to_string(i)});
-      stage->setAttr("name", StringAttr::get(rewriter.getContext(), stageName));
+      auto stageNameAttr = StringAttr::get(rewriter.getContext(), stageName);
+      stage->setAttr("name", stageNameAttr);
+
+      if (hierarchy) {
+        stage->setAttr("inner_sym", stageNameAttr);
+        OpBuilder::InsertionGuard guard(rewriter);
+        rewriter.setInsertionPointToEnd(&hierarchy.getBody().front());
+        StringAttr modName = hierarchy.getTopModuleRefAttr().getAttr();
+        auto inst = rewriter.create<msft::DynamicInstanceOp>(
+            loc, hw::InnerRefAttr::get(modName, stageNameAttr));
+        rewriter.createBlock(&inst.getBody());
+        rewriter.create<msft::PDPhysLocationOp>(
+            loc,
+            (*buffer.getPlacements())[i].cast<msft::PhysLocationAttr>(),
+            StringAttr(), FlatSymbolRefAttr());
+      }
     }
     input = stage;
   }
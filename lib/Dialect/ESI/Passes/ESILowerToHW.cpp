@@ -20,6 +20,7 @@
 #include "circt/Support/LLVM.h"
 #include "circt/Support/SymCache.h"
 
+#include "mlir/IR/Threading.h"
 #include "mlir/Transforms/DialectConversion.h"
 
 #include "llvm/ADT/StringExtras.h"
@@ -69,6 +70,10 @@ LogicalResult PipelineStageLowering::matchAndRewrite(
 
   ArrayAttr stageParams =
       builder.getStageParameterList(rewriter.getUI32IntegerAttr(width));
+  if (auto depth = stage.getDepth())
+    stageParams =
+        builder.getFIFOParameterList(rewriter.getUI32IntegerAttr(width),
+                                     rewriter.getUI32IntegerAttr(*depth));
 
   // Unwrap the channel. The ready signal is a Value we haven't created yet,
   // so create a temp value and replace it later. Give this constant an
@@ -88,8 +93,10 @@ LogicalResult PipelineStageLowering::matchAndRewrite(
   operands.push_back(unwrap.getRawOutput());
   operands.push_back(unwrap.getValid());
   operands.push_back(stageReady);
-  auto stageInst = rewriter.create<InstanceOp>(loc, stageModule, pipeStageName,
-                                               operands, stageParams);
+  // Stages which get placed need a symbol to be referred to.
+  auto stageInst = rewriter.create<InstanceOp>(
+      loc, stageModule, pipeStageName, operands, stageParams,
+      stage->getAttrOfType<StringAttr>("inner_sym"));
   auto stageInstResults = stageInst.getResults();
 
   // Set a_ready (from the unwrap) back edge correctly to its output from
@@ -474,6 +481,21 @@ void ESItoHWPass::runOnOperation() {
   auto top = getOperation();
   auto *ctxt = &getContext();
 
+#ifdef CAPNP
+  // Compute the capnp schemas of the cosim endpoint types up front and in
+  // parallel. The (sequential) lowerings below then hit the schema cache.
+  SetVector<Type> cosimTypes;
+  top.walk([&](CosimEndpointOp ep) {
+    cosimTypes.insert(ep.getSend().getType());
+    cosimTypes.insert(ep.getRecv().getType());
+  });
+  mlir::parallelForEach(ctxt, cosimTypes, [](Type type) {
+    capnp::CapnpTypeSchema schema(type);
+    if (schema.isSupported())
+      (void)schema.size();
+  });
+#endif
+
   // Set up a conversion and give it a set of laws.
   ConversionTarget pass1Target(*ctxt);
   pass1Target.addLegalDialect<comb::CombDialect>();
@@ -0,0 +1,213 @@
+//===- ESIProfileChannels.cpp - Instrument ESI channels ---------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Add utilization and stall counters to the valid-ready channels of each
+// module and expose them through a cosim endpoint.
+//
+//===----------------------------------------------------------------------===//
+
+#include "../PassDetails.h"
+
+#include "circt/Dialect/Comb/CombOps.h"
+#include "circt/Dialect/ESI/ESIOps.h"
+#include "circt/Dialect/HW/HWOps.h"
+#include "circt/Dialect/Seq/SeqOps.h"
+#include "circt/Support/BackedgeBuilder.h"
+
+#include "mlir/IR/ImplicitLocOpBuilder.h"
+#include "llvm/ADT/StringSet.h"
+
+using namespace circt;
+using namespace circt::esi;
+
+/// The width of the counters.
+static constexpr unsigned counterWidth = 64;
+
+/// Turn `name` into a lower camel case identifier, which is what Cap'nProto
+/// requires for struct field names.
+static std::string getFieldName(StringRef name) {
+  std::string fieldName;
+  bool upper = false;
+  for (char c : name) {
+    if (!llvm::isAlnum(c)) {
+      upper = !fieldName.empty();
+      continue;
+    }
+    if (fieldName.empty() && llvm::isDigit(c))
+      fieldName += "ch";
+    fieldName += upper ? llvm::toUpper(c) : c;
+    upper = false;
+  }
+  if (!fieldName.empty())
+    fieldName[0] = llvm::toLower(fieldName[0]);
+  return fieldName;
+}
+
+/// Return a name for the channel, based on the port or op it comes from.
+static std::string getChannelName(Value chan) {
+  if (auto arg = chan.dyn_cast<BlockArgument>())
+    return hw::getModuleArgumentName(arg.getOwner()->getParentOp(),
+                                     arg.getArgNumber())
+        .str();
+  auto result = chan.cast<OpResult>();
+  Operation *op = result.getOwner();
+  if (auto inst = dyn_cast<hw::InstanceOp>(op))
+    return (inst.getInstanceName() + "_" +
+            inst.getResultName(result.getResultNumber()).getValue())
+        .str();
+  if (auto name = op->getAttrOfType<StringAttr>("name"))
+    return name.getValue().str();
+  return "channel";
+}
+
+namespace {
+struct ESIProfileChannelsPass
+    : public ESIProfileChannelsBase<ESIProfileChannelsPass> {
+  void runOnOperation() override;
+
+private:
+  void profileModule(hw::HWModuleOp mod);
+};
+} // anonymous namespace
+
+/// A counter which is incremented in every cycle in which `enable` is high.
+static Value buildCounter(ImplicitLocOpBuilder &b, Value enable, Value clk,
+                          Value rst, StringRef name) {
+  BackedgeBuilder bb(b, b.getLoc());
+  auto counterType = b.getIntegerType(counterWidth);
+  Value zero = b.create<hw::ConstantOp>(counterType, 0);
+  Value one = b.create<hw::ConstantOp>(counterType, 1);
+  Backedge next = bb.get(counterType);
+  Value count = b.create<seq::CompRegOp>(next, clk, rst, zero, name);
+  Value incremented = b.create<comb::AddOp>(count, one);
+  next.setValue(b.create<comb::MuxOp>(enable, incremented, count));
+  return count;
+}
+
+void ESIProfileChannelsPass::profileModule(hw::HWModuleOp mod) {
+  // Find the clock and reset.
+  Value clk, rst;
+  for (auto [idx, arg] : llvm::enumerate(mod.getBodyBlock()->getArguments())) {
+    StringRef name = hw::getModuleArgumentName(mod, idx);
+    if (name == clock && arg.getType().isInteger(1))
+      clk = arg;
+    else if (name == reset && arg.getType().isInteger(1))
+      rst = arg;
+  }
+  if (!clk || !rst)
+    return;
+
+  // Collect the valid-ready channels before any are added.
+  SmallVector<Value> channels;
+  auto collect = [&](Value value) {
+    auto chanType = value.getType().dyn_cast<ChannelType>();
+    if (chanType && chanType.getSignaling() == ChannelSignaling::ValidReady &&
+        value.hasOneUse())
+      channels.push_back(value);
+  };
+  for (auto arg : mod.getBodyBlock()->getArguments())
+    collect(arg);
+  mod.walk([&](Operation *op) {
+    for (auto result : op->getResults())
+      collect(result);
+  });
+  if (channels.empty())
+    return;
+
+  ImplicitLocOpBuilder b(mod.getLoc(), mod.getBodyBlock()->getTerminator());
+  Type i1 = b.getI1Type();
+  Value cTrue = b.create<hw::ConstantOp>(i1, 1);
+
+  SmallVector<hw::StructType::FieldInfo> fields;
+  SmallVector<Value> counters;
+  auto counterType = b.getIntegerType(counterWidth);
+  fields.push_back({b.getStringAttr("cycles"), counterType});
+  counters.push_back(buildCounter(b, cTrue, clk, rst, "esi_profile_cycles"));
+
+  llvm::StringSet<> usedNames;
+  for (Value chan : channels) {
+    // Splice an unwrap/wrap pair into the channel to get at its valid and
+    // ready signals. The pair is removed again when lowering to HW.
+    OpOperand &use = *chan.getUses().begin();
+    b.setInsertionPoint(use.getOwner());
+    BackedgeBuilder bb(b, chan.getLoc());
+    Backedge ready = bb.get(i1);
+    auto unwrap = b.create<UnwrapValidReadyOp>(chan, ready);
+    auto wrap =
+        b.create<WrapValidReadyOp>(unwrap.getRawOutput(), unwrap.getValid());
+    ready.setValue(wrap.getReady());
+    use.set(wrap.getChanOutput());
+
+    b.setInsertionPoint(mod.getBodyBlock()->getTerminator());
+    Value valid = unwrap.getValid();
+    Value transfer = b.create<comb::AndOp>(valid, wrap.getReady());
+    Value stall = b.create<comb::AndOp>(
+        valid, b.create<comb::XorOp>(wrap.getReady(), cTrue));
+
+    // Make the field names unique since the channel names may not be.
+    std::string baseName = getFieldName(getChannelName(chan));
+    if (baseName.empty())
+      baseName = "channel";
+    std::string fieldName = baseName;
+    for (unsigned i = 1; !usedNames.insert(fieldName).second; ++i)
+      fieldName = baseName + std::to_string(i);
+
+    fields.push_back({b.getStringAttr(fieldName + "Transfers"), counterType});
+    counters.push_back(buildCounter(b, transfer, clk, rst,
+                                    "esi_profile_" + fieldName + "_transfers"));
+    fields.push_back({b.getStringAttr(fieldName + "Stalls"), counterType});
+    counters.push_back(buildCounter(b, stall, clk, rst,
+                                    "esi_profile_" + fieldName + "_stalls"));
+  }
+
+  // The host requests a snapshot of the counters by sending a message to the
+  // profiling endpoint, which responds with the counter values of that cycle.
+  auto snapshotType = hw::StructType::get(&getContext(), fields);
+  BackedgeBuilder bb(b, b.getLoc());
+  Backedge requestChan = bb.get(ChannelType::get(&getContext(), i1));
+  auto request = b.create<UnwrapValidReadyOp>(requestChan, cTrue);
+  Value live = b.create<hw::StructCreateOp>(snapshotType, counters);
+
+  Backedge snapshotNext = bb.get(snapshotType);
+  Value snapshot =
+      b.create<seq::CompRegOp>(snapshotNext, clk, "esi_profile_snapshot");
+  snapshotNext.setValue(
+      b.create<comb::MuxOp>(request.getValid(), live, snapshot));
+
+  // A response is pending from the cycle after the request until it is taken.
+  Backedge pendingNext = bb.get(i1);
+  Value cFalse = b.create<hw::ConstantOp>(i1, 0);
+  Value pending = b.create<seq::CompRegOp>(pendingNext, clk, rst, cFalse,
+                                           "esi_profile_pending");
+  auto response = b.create<WrapValidReadyOp>(snapshot, pending);
+  Value taken = b.create<comb::AndOp>(pending, response.getReady());
+  Value stillPending =
+      b.create<comb::AndOp>(pending, b.create<comb::XorOp>(taken, cTrue));
+  pendingNext.setValue(
+      b.create<comb::OrOp>(request.getValid(), stillPending));
+
+  // Name the endpoint after the module so that the endpoints of different
+  // modules can be told apart. The cosim endpoint prefixes the name with its
+  // instance path, which distinguishes the instances of the same module.
+  auto endpoint = b.create<CosimEndpointOp>(
+      ChannelType::get(&getContext(), i1), clk, rst, response.getChanOutput(),
+      b.getStringAttr(Twine(endpointName) + "_" + mod.getModuleName()));
+  requestChan.setValue(endpoint.getRecv());
+  ++numModulesProfiled;
+  numChannelsProfiled += channels.size();
+}
+
+void ESIProfileChannelsPass::runOnOperation() {
+  for (auto mod : getOperation().getOps<hw::HWModuleOp>())
+    profileModule(mod);
+}
+
+std::unique_ptr<OperationPass<ModuleOp>>
+circt::esi::createESIProfileChannelsPass() {
+  return std::make_unique<ESIProfileChannelsPass>();
+}
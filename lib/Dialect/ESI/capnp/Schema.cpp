@@ -19,16 +19,25 @@
 #include "mlir/Support/IndentedOstream.h"
 
 // NOLINTNEXTLINE(clang-diagnostic-error)
+#include "capnp/schema-loader.h"
 #include "capnp/schema-parser.h"
+#include "capnp/serialize.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/IR/Builders.h"
 #include "mlir/IR/BuiltinAttributes.h"
 #include "mlir/IR/BuiltinTypes.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/IntervalMap.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/TypeSwitch.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Format.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
 
 #include <initializer_list>
+#include <mutex>
 #include <string>
 
 using namespace circt::esi::capnp::detail;
@@ -68,13 +77,11 @@ public:
   hw::HWModuleOp buildDecoder(Value clk, Value valid, Value);
 
 private:
-  ::capnp::ParsedSchema getSchema() const;
+  void writeSchemaFile(llvm::raw_ostream &os) const;
   ::capnp::StructSchema getCapnpTypeSchema() const;
 
   CapnpTypeSchema &base;
 
-  ::capnp::SchemaParser parser;
-  mutable ::capnp::ParsedSchema rootSchema;
   mutable ::capnp::StructSchema typeSchema;
 };
 } // namespace detail
@@ -144,48 +151,159 @@ static bool isPointerType(::capnp::schema::Type::Reader type) {
 
 CapnpTypeSchemaImpl::CapnpTypeSchemaImpl(CapnpTypeSchema &base) : base(base) {}
 
-/// Write a valid capnp schema to memory, then parse it out of memory using the
-/// capnp library. Writing and parsing text within a single process is ugly, but
-/// this is by far the easiest way to do this. This isn't the use case for which
-/// Cap'nProto was designed.
-::capnp::ParsedSchema CapnpTypeSchemaImpl::getSchema() const {
-  if (rootSchema != ::capnp::ParsedSchema())
-    return rootSchema;
-
-  // Write the schema to `schemaText`.
-  std::string schemaText;
-  llvm::raw_string_ostream os(schemaText);
+/// Write a complete capnp schema file containing this type.
+void CapnpTypeSchemaImpl::writeSchemaFile(llvm::raw_ostream &os) const {
   emitCapnpID(os, 0xFFFFFFFFFFFFFFFF) << ";\n";
   auto rc = write(os);
   assert(succeeded(rc) && "Failed schema text output.");
   (void)rc;
-  os.str();
-
-  // Write `schemaText` to an in-memory filesystem then parse it. Yes, this is
-  // the only way to do this.
-  kj::Own<kj::Filesystem> fs = kj::newDiskFilesystem();
-  kj::Own<kj::Directory> dir = kj::newInMemoryDirectory(kj::nullClock());
-  kj::Path fakePath = kj::Path::parse("schema.capnp");
-  { // Ensure that 'fakeFile' has flushed.
-    auto fakeFile = dir->openFile(fakePath, kj::WriteMode::CREATE);
-    fakeFile->writeAll(schemaText);
+}
+
+namespace {
+/// The capnp schema of a type, parsed either from the generated schema text
+/// or loaded from the on-disk cache. The schema readers point into the parser
+/// or loader, so entries are never freed.
+struct CachedSchema {
+  ::capnp::SchemaParser parser;
+  ::capnp::SchemaLoader loader;
+  ::capnp::StructSchema schema;
+};
+
+/// Parsed schemas keyed by type ID. Since the ID is a hash of the type's
+/// textual form, the schemas are shared between contexts and are only ever
+/// computed once per process.
+struct SchemaCache {
+  std::mutex mutex;
+  llvm::DenseMap<uint64_t, std::unique_ptr<CachedSchema>> schemas;
+};
+} // anonymous namespace
+
+static SchemaCache &getSchemaCache() {
+  static SchemaCache cache;
+  return cache;
+}
+
+/// Return the path of the on-disk cache file for `id`, or an empty string if
+/// the on-disk cache is disabled. It is enabled by pointing the
+/// ESI_CAPNP_SCHEMA_CACHE environment variable at a directory.
+static std::string getCacheFilePath(uint64_t id) {
+  std::optional<std::string> dir =
+      llvm::sys::Process::GetEnv("ESI_CAPNP_SCHEMA_CACHE");
+  if (!dir || dir->empty())
+    return "";
+  SmallString<128> path(*dir);
+  llvm::sys::path::append(path, llvm::utohexstr(id) + ".bin");
+  return std::string(path);
+}
+
+/// Try to load the schema nodes stored for `id` into `entry`.
+static bool loadCachedSchema(StringRef path, uint64_t id, CachedSchema &entry) {
+  auto buffer = llvm::MemoryBuffer::getFile(path);
+  if (!buffer || (*buffer)->getBufferSize() % sizeof(::capnp::word) != 0)
+    return false;
+  // Copy the data to ensure that it is word aligned.
+  StringRef data = (*buffer)->getBuffer();
+  auto words =
+      kj::heapArray<::capnp::word>(data.size() / sizeof(::capnp::word));
+  memcpy(words.begin(), data.data(), data.size());
+  try {
+    ::capnp::FlatArrayMessageReader reader(words);
+    auto request = reader.getRoot<::capnp::schema::CodeGeneratorRequest>();
+    for (auto node : request.getNodes())
+      entry.loader.loadOnce(node);
+    KJ_IF_MAYBE (s, entry.loader.tryGet(id)) {
+      if (s->getProto().isStruct()) {
+        entry.schema = s->asStruct();
+        return true;
+      }
+    }
+  } catch (kj::Exception &) {
+  }
+  return false;
+}
+
+/// Store the nodes of `schema` to the on-disk cache. Write to a temporary file
+/// first so that concurrent compilations never observe a partial file.
+static void storeCachedSchema(StringRef path, ::capnp::ParsedSchema schema) {
+  ::capnp::MallocMessageBuilder message;
+  auto request = message.initRoot<::capnp::schema::CodeGeneratorRequest>();
+  auto nested = schema.getAllNested();
+  auto nodes = request.initNodes(nested.size());
+  for (size_t i = 0, e = nested.size(); i < e; ++i)
+    nodes.setWithCaveats(i, nested[i].getProto());
+  kj::Array<::capnp::word> words = ::capnp::messageToFlatArray(message);
+  auto bytes = words.asBytes();
+
+  SmallString<128> tmpPath;
+  int fd;
+  if (llvm::sys::fs::createUniqueFile(path + ".%%%%%%%%.tmp", fd, tmpPath))
+    return;
+  {
+    llvm::raw_fd_ostream os(fd, /*shouldClose=*/true);
+    os.write(reinterpret_cast<const char *>(bytes.begin()), bytes.size());
+    if (os.has_error()) {
+      os.clear_error();
+      llvm::sys::fs::remove(tmpPath);
+      return;
+    }
   }
-  rootSchema = parser.parseFromDirectory(*dir, std::move(fakePath), nullptr);
-  return rootSchema;
+  if (llvm::sys::fs::rename(tmpPath, path))
+    llvm::sys::fs::remove(tmpPath);
 }
 
-/// Find the schema corresponding to `type` and return it.
+/// Find the schema corresponding to `type` and return it. Generating a schema
+/// means writing a valid capnp schema to memory, then parsing it out of memory
+/// using the capnp library. Writing and parsing text within a single process
+/// is ugly (and slow), but this is by far the easiest way to do this. This
+/// isn't the use case for which Cap'nProto was designed. So the results are
+/// cached per type ID, optionally on disk as well.
 ::capnp::StructSchema CapnpTypeSchemaImpl::getCapnpTypeSchema() const {
   if (typeSchema != ::capnp::StructSchema())
     return typeSchema;
   uint64_t id = base.typeID();
-  for (auto schemaNode : getSchema().getAllNested()) {
-    if (schemaNode.getProto().getId() == id) {
-      typeSchema = schemaNode.asStruct();
-      return typeSchema;
+
+  SchemaCache &cache = getSchemaCache();
+  {
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    auto it = cache.schemas.find(id);
+    if (it != cache.schemas.end())
+      return typeSchema = it->second->schema;
+  }
+
+  // Parse outside of the lock so that different types can be computed in
+  // parallel. If two threads race on the same type, the first one wins.
+  auto entry = std::make_unique<CachedSchema>();
+  std::string cachePath = getCacheFilePath(id);
+  if (cachePath.empty() || !loadCachedSchema(cachePath, id, *entry)) {
+    std::string schemaText;
+    llvm::raw_string_ostream os(schemaText);
+    writeSchemaFile(os);
+    os.str();
+
+    // Write `schemaText` to an in-memory filesystem then parse it. Yes, this
+    // is the only way to do this.
+    kj::Own<kj::Directory> dir = kj::newInMemoryDirectory(kj::nullClock());
+    kj::Path fakePath = kj::Path::parse("schema.capnp");
+    { // Ensure that 'fakeFile' has flushed.
+      auto fakeFile = dir->openFile(fakePath, kj::WriteMode::CREATE);
+      fakeFile->writeAll(schemaText);
     }
+    ::capnp::ParsedSchema rootSchema =
+        entry->parser.parseFromDirectory(*dir, std::move(fakePath), nullptr);
+    for (auto schemaNode : rootSchema.getAllNested())
+      if (schemaNode.getProto().getId() == id)
+        entry->schema = schemaNode.asStruct();
+    assert(entry->schema != ::capnp::StructSchema() &&
+           "A node with a matching ID should always be found.");
+    if (!cachePath.empty())
+      storeCachedSchema(cachePath, rootSchema);
   }
-  llvm_unreachable("A node with a matching ID should always be found.");
+
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  auto &cached = cache.schemas[id];
+  if (!cached)
+    cached = std::move(entry);
+  return typeSchema = cached->schema;
 }
 
 /// Returns the expected size of an array (capnp list) in 64-bit words.
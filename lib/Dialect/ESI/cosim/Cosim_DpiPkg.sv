@@ -41,6 +41,23 @@ import "DPI-C" sv2cCosimserverEpRegister =
     // The recv types max size, in bytes.
     input int recv_type_size);
 
+// Register simulated device endpoints and get a handle for the "_handle"
+// accessors below, which are cheaper than looking endpoints up by ID.
+// - return the handle (>= 0) on success, negative on failure (duplicate EP
+//   registered).
+import "DPI-C" sv2cCosimserverEpRegisterHandle =
+  function int cosim_ep_register_handle(
+    // The endpoint ID.
+    input string endpoint_id,
+    // The capnp type id which the _RPC client_ is sending us.
+    input longint send_type_id,
+    // The send types max size, in bytes.
+    input int send_type_size,
+    // The capnp type id which we are sending to the _RPC client_.
+    input longint esi_recv_type_id,
+    // The recv types max size, in bytes.
+    input int recv_type_size);
+
 // --------------------- Endpoint Accessors ------------------------------------
 
 // Attempt to send data to a client.
@@ -74,4 +91,49 @@ import "DPI-C" sv2cCosimserverEpTryGet =
     inout  int unsigned data_size
     );
 
+// Same as cosim_ep_tryput, but by endpoint handle.
+import "DPI-C" sv2cCosimserverEpTryPutHandle =
+  function int cosim_ep_tryput_handle(
+    // The handle of the endpoint to which the data should be sent.
+    input int handle,
+    // A data buffer.
+    input byte unsigned data[],
+    // (Optional) Size of the buffer. If negative, will be dynamically detected.
+    input int data_size = -1
+    );
+
+// Same as cosim_ep_tryget, but by endpoint handle.
+import "DPI-C" sv2cCosimserverEpTryGetHandle =
+  function int cosim_ep_tryget_handle(
+    // The handle of the endpoint from which data should be recieved.
+    input int handle,
+    // The buffer in which to put the data.
+    inout byte unsigned data[],
+    // Input: indicates the size of the data[] buffer. If -1, dynamically detect
+    // size.
+    // Output: the size of the message.
+    inout  int unsigned data_size
+    );
+
+// Check every endpoint for a message from a client in one call.
+//   - Returns negative when call failed, otherwise the number of endpoints with
+//     a message.
+//   - Sets has_msg[handle] to 1 if the endpoint has a message, 0 otherwise.
+import "DPI-C" sv2cCosimserverEpPollAll =
+  function int cosim_ep_poll_all(
+    inout byte unsigned has_msg[]
+    );
+
+// --------------------- Batched Polling ---------------------------------------
+
+// The number of endpoint handles covered by the batched poll. Endpoints with a
+// larger handle are polled individually every cycle.
+localparam int COSIM_MAX_POLLED_ENDPOINTS = 1024;
+
+// The results of the last batched poll, indexed by endpoint handle. Updated by
+// the endpoint with handle 0 once per cycle, so the other endpoints only need
+// a DPI call in the cycles in which they have a message. A message may be seen
+// a cycle late, depending on the order in which the endpoints are evaluated.
+byte unsigned cosim_ep_has_msg[COSIM_MAX_POLLED_ENDPOINTS];
+
 endpackage // Cosim_DpiPkg
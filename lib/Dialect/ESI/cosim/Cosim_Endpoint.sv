@@ -43,6 +43,7 @@ module Cosim_Endpoint
     assign ENDPOINT_ID = ENDPOINT_ID_BASE;
 
   bit Initialized;
+  int Handle;
 
   // Handle initialization logic.
   always@(posedge clk) begin
@@ -52,10 +53,11 @@ module Cosim_Endpoint
       rc = cosim_init();
       if (rc != 0)
         $error("Cosim init failed (%d)", rc);
-      rc = cosim_ep_register(ENDPOINT_ID, SEND_TYPE_ID, SEND_TYPE_SIZE_BYTES,
-                             RECV_TYPE_ID, RECV_TYPE_SIZE_BYTES);
-      if (rc != 0)
-        $error("Cosim endpoint (%d) register failed: %d", ENDPOINT_ID, rc);
+      Handle = cosim_ep_register_handle(ENDPOINT_ID, SEND_TYPE_ID,
+                                        SEND_TYPE_SIZE_BYTES, RECV_TYPE_ID,
+                                        RECV_TYPE_SIZE_BYTES);
+      if (Handle < 0)
+        $error("Cosim endpoint (%d) register failed: %d", ENDPOINT_ID, Handle);
       Initialized = 1'b1;
     end
   end
@@ -77,12 +79,22 @@ module Cosim_Endpoint
       if (DataOutValid && DataOutReady) // A transfer occurred.
         DataOutValid <= 1'b0;
 
-      if (!DataOutValid || DataOutReady) begin
+      // The first endpoint polls all of them for messages.
+      if (Handle == 0) begin
+        int rc;
+        rc = cosim_ep_poll_all(cosim_ep_has_msg);
+        if (rc < 0)
+          $error("cosim_ep_poll_all returned an error (%d)", rc);
+      end
+
+      if ((!DataOutValid || DataOutReady) &&
+          (Handle >= COSIM_MAX_POLLED_ENDPOINTS ||
+           cosim_ep_has_msg[Handle] != 0)) begin
         int data_limit;
         int rc;
 
         data_limit = RECV_TYPE_SIZE_BYTES;
-        rc = cosim_ep_tryget(ENDPOINT_ID, DataOutBuffer, data_limit);
+        rc = cosim_ep_tryget_handle(Handle, DataOutBuffer, data_limit);
         if (rc < 0) begin
           $error("cosim_ep_tryget(%d, *, %d -> %d) returned an error (%d)",
             ENDPOINT_ID, RECV_TYPE_SIZE_BYTES, data_limit, rc);
@@ -147,7 +159,8 @@ module Cosim_Endpoint
     if (~rst && Initialized) begin
       if (DataInValid) begin
         int rc;
-        rc = cosim_ep_tryput(ENDPOINT_ID, DataInBuffer, SEND_TYPE_SIZE_BYTES);
+        rc = cosim_ep_tryput_handle(Handle, DataInBuffer,
+                                    SEND_TYPE_SIZE_BYTES);
         if (rc != 0)
           $error("cosim_ep_tryput(%d, *, %d) = %d Error! (Data lost)",
             ENDPOINT_ID, SEND_TYPE_SIZE_BYTES, rc);
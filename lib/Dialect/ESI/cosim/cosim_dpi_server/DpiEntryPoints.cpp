@@ -18,6 +18,9 @@
 
 #include "circt/Dialect/ESI/cosim/Server.h"
 #include "circt/Dialect/ESI/cosim/dpi.h"
+#if !WIN32
+#include "esi/backends/shm.h"
+#endif
 
 #include <algorithm>
 #include <cstdlib>
@@ -32,15 +35,15 @@ static std::mutex serverMutex;
 // ---- Helper functions ----
 
 /// Emit the contents of 'msg' to the log file in hex.
-static void log(char *epId, bool toClient, const Endpoint::BlobPtr &msg) {
+static void log(const char *epId, bool toClient, const uint8_t *msg,
+                size_t msgSize) {
   std::lock_guard<std::mutex> g(serverMutex);
   if (!logFile)
     return;
 
   fprintf(logFile, "[ep: %50s to: %4s]", epId, toClient ? "host" : "sim");
-  size_t msgSize = msg->size();
   for (size_t i = 0; i < msgSize; ++i) {
-    auto b = (*msg)[i];
+    auto b = msg[i];
     // Separate 32-bit words.
     if (i % 4 == 0 && i > 0)
       fprintf(logFile, " ");
@@ -107,43 +110,30 @@ DPI int sv2cCosimserverEpRegister(char *endpointId, long long sendTypeId,
   sv2cCosimserverInit();
   // Then register with it.
   if (server->endpoints.registerEndpoint(endpointId, sendTypeId, sendTypeSize,
-                                         recvTypeId, recvTypeSize))
+                                         recvTypeId, recvTypeSize) >= 0)
     return 0;
   return -1;
 }
 
-// Attempt to recieve data from a client.
-//   - Returns negative when call failed (e.g. EP not registered).
-//   - If no message, return 0 with dataSize == 0.
-//   - Assumes buffer is large enough to contain entire message. Fails if not
-//     large enough. (In the future, will add support for getting the message
-//     into a fixed-size buffer over multiple calls.)
-DPI int sv2cCosimserverEpTryGet(char *endpointId,
-                                // NOLINTNEXTLINE(misc-misplaced-const)
-                                const svOpenArrayHandle data,
-                                unsigned int *dataSize) {
-  if (server == nullptr)
-    return -1;
-
-  Endpoint *ep = server->endpoints[endpointId];
-  if (!ep) {
-    fprintf(stderr, "Endpoint not found in registry!\n");
-    return -4;
-  }
-
-  Endpoint::BlobPtr msg;
-  // Poll for a message.
-  if (!ep->getMessageToSim(msg)) {
-    // No message.
-    *dataSize = 0;
-    return 0;
-  }
-  // Do the validation only if there's a message available. Since the
-  // simulator is going to poll up to every tick and there's not going to be
-  // a message most of the time, this is important for performance.
-
-  log(endpointId, false, msg);
+// Register simulated device endpoints and get a handle for the other DPI
+// calls, which avoids looking the endpoint up by name on every call.
+// - return the handle (>= 0) on success, negative on failure (duplicate EP
+//   registered).
+DPI int sv2cCosimserverEpRegisterHandle(char *endpointId, long long sendTypeId,
+                                        int sendTypeSize, long long recvTypeId,
+                                        int recvTypeSize) {
+  // Ensure the server has been constructed.
+  sv2cCosimserverInit();
+  return server->endpoints.registerEndpoint(endpointId, sendTypeId,
+                                            sendTypeSize, recvTypeId,
+                                            recvTypeSize);
+}
 
+/// Copy a message into the SV array 'data' for 'sv2cCosimserverEpTryGet'.
+static int copyToSvArray(const uint8_t *msg, size_t msgSize,
+                         // NOLINTNEXTLINE(misc-misplaced-const)
+                         const svOpenArrayHandle data,
+                         unsigned int *dataSize) {
   if (validateSvOpenArray(data, sizeof(int8_t)) != 0) {
     printf("ERROR: DPI-func=%s line=%d event=invalid-sv-array\n", __func__,
            __LINE__);
@@ -159,7 +149,6 @@ DPI int sv2cCosimserverEpTryGet(char *endpointId,
     return -3;
   }
   // Verify it'll fit.
-  size_t msgSize = msg->size();
   if (msgSize > *dataSize) {
     printf("ERROR: Message size too big to fit in HW buffer\n");
     return -5;
@@ -168,7 +157,7 @@ DPI int sv2cCosimserverEpTryGet(char *endpointId,
   // Copy the message data.
   size_t i;
   for (i = 0; i < msgSize; ++i) {
-    auto b = (*msg)[i];
+    auto b = msg[i];
     *(char *)svGetArrElemPtr1(data, i) = b;
   }
   // Zero out the rest of the buffer.
@@ -176,20 +165,132 @@ DPI int sv2cCosimserverEpTryGet(char *endpointId,
     *(char *)svGetArrElemPtr1(data, i) = 0;
   }
   // Set the output data size.
-  *dataSize = msg->size();
+  *dataSize = msgSize;
   return 0;
 }
 
-// Attempt to send data to a client.
-// - return 0 on success, negative on failure (unregistered EP).
-// - if dataSize is negative, attempt to dynamically determine the size of
-//   'data'.
-DPI int sv2cCosimserverEpTryPut(char *endpointId,
+/// Return true if there is a message to the simulation waiting on 'ep'.
+static bool hasMessageToSim(Endpoint *ep) {
+#if !WIN32
+  if (Endpoint::SharedMemory *shm = ep->getSharedMemory()) {
+    size_t msgSize;
+    return shm->getToSim().front(msgSize) != nullptr;
+  }
+#endif
+  return ep->peekMessageToSim() != nullptr;
+}
+
+/// Receive a message from a client for 'sv2cCosimserverEpTryGet*'.
+static int tryGet(Endpoint *ep, const char *endpointId,
+                  // NOLINTNEXTLINE(misc-misplaced-const)
+                  const svOpenArrayHandle data, unsigned int *dataSize) {
+#if !WIN32
+  // Poll the shared memory segment instead of the queue while the client uses
+  // it.
+  if (Endpoint::SharedMemory *shm = ep->getSharedMemory()) {
+    auto ring = shm->getToSim();
+    size_t msgSize;
+    const uint8_t *msg = ring.front(msgSize);
+    if (!msg) {
+      *dataSize = 0;
+      return 0;
+    }
+    log(endpointId, false, msg, msgSize);
+    int rc = copyToSvArray(msg, msgSize, data, dataSize);
+    ring.pop();
+    return rc;
+  }
+#endif
+
+  // Poll for a message.
+  const Endpoint::Blob *msg = ep->peekMessageToSim();
+  if (!msg) {
+    // No message.
+    *dataSize = 0;
+    return 0;
+  }
+  // Do the validation only if there's a message available. Since the
+  // simulator is going to poll up to every tick and there's not going to be
+  // a message most of the time, this is important for performance.
+
+  log(endpointId, false, msg->data(), msg->size());
+
+  // The message is consumed even if it cannot be copied.
+  int rc = copyToSvArray(msg->data(), msg->size(), data, dataSize);
+  ep->popMessageToSim();
+  return rc;
+}
+
+// Attempt to recieve data from a client.
+//   - Returns negative when call failed (e.g. EP not registered).
+//   - If no message, return 0 with dataSize == 0.
+//   - Assumes buffer is large enough to contain entire message. Fails if not
+//     large enough. (In the future, will add support for getting the message
+//     into a fixed-size buffer over multiple calls.)
+DPI int sv2cCosimserverEpTryGet(char *endpointId,
                                 // NOLINTNEXTLINE(misc-misplaced-const)
-                                const svOpenArrayHandle data, int dataSize) {
+                                const svOpenArrayHandle data,
+                                unsigned int *dataSize) {
+  if (server == nullptr)
+    return -1;
+
+  Endpoint *ep = server->endpoints[endpointId];
+  if (!ep) {
+    fprintf(stderr, "Endpoint not found in registry!\n");
+    return -4;
+  }
+  return tryGet(ep, endpointId, data, dataSize);
+}
+
+// Same as 'sv2cCosimserverEpTryGet', but for the endpoint with the handle
+// returned by 'sv2cCosimserverEpRegisterHandle'.
+DPI int sv2cCosimserverEpTryGetHandle(int handle,
+                                      // NOLINTNEXTLINE(misc-misplaced-const)
+                                      const svOpenArrayHandle data,
+                                      unsigned int *dataSize) {
   if (server == nullptr)
     return -1;
 
+  Endpoint *ep = server->endpoints.getByHandle(handle);
+  if (!ep) {
+    fprintf(stderr, "Endpoint handle not found in registry!\n");
+    return -4;
+  }
+  return tryGet(ep, server->endpoints.getId(handle).c_str(), data, dataSize);
+}
+
+// Check all the endpoints for messages to the simulation in one call, so that
+// the endpoints without a message need not be polled individually.
+//   - Returns negative when the call failed, otherwise the number of
+//     endpoints with a message.
+//   - Sets hasMsg[handle] to 1 for every endpoint with a message and to 0 for
+//     the others. Handles beyond the end of the array are skipped.
+DPI int sv2cCosimserverEpPollAll(
+    // NOLINTNEXTLINE(misc-misplaced-const)
+    const svOpenArrayHandle hasMsg) {
+  if (server == nullptr)
+    return -1;
+  if (validateSvOpenArray(hasMsg, sizeof(int8_t)) != 0) {
+    printf("ERROR: DPI-func=%s line=%d event=invalid-sv-array\n", __func__,
+           __LINE__);
+    return -2;
+  }
+
+  int numHandles =
+      std::min(svSize(hasMsg, 1), server->endpoints.getNumHandles());
+  int numWithMsg = 0;
+  for (int handle = 0; handle < numHandles; ++handle) {
+    bool has = hasMessageToSim(server->endpoints.getByHandle(handle));
+    *(char *)svGetArrElemPtr1(hasMsg, handle) = has;
+    numWithMsg += has;
+  }
+  return numWithMsg;
+}
+
+/// Send a message to a client for 'sv2cCosimserverEpTryPut*'.
+static int tryPut(Endpoint *ep, const char *endpointId,
+                  // NOLINTNEXTLINE(misc-misplaced-const)
+                  const svOpenArrayHandle data, int dataSize) {
   if (validateSvOpenArray(data, sizeof(int8_t)) != 0) {
     printf("ERROR: DPI-func=%s line=%d event=invalid-sv-array\n", __func__,
            __LINE__);
@@ -205,20 +306,78 @@ DPI int sv2cCosimserverEpTryPut(char *endpointId,
     return -3;
   }
 
-  Endpoint::BlobPtr blob = std::make_shared<Endpoint::Blob>(dataSize);
-  // Copy the message data into 'blob'.
+#if !WIN32
+  // Copy the message data directly into the shared memory segment while the
+  // client uses it.
+  if (Endpoint::SharedMemory *shm = ep->getSharedMemory()) {
+    auto ring = shm->getToClient();
+    if ((unsigned)dataSize > ring.getSlotSize()) {
+      fprintf(stderr, "Message too big for the shared memory slots!\n");
+      return -6;
+    }
+    uint8_t *slot = ring.reserve();
+    if (!slot) {
+      fprintf(stderr, "Endpoint queue to the client is full!\n");
+      return -5;
+    }
+    for (int i = 0; i < dataSize; ++i)
+      slot[i] = *(char *)svGetArrElemPtr1(data, i);
+    log(endpointId, true, slot, dataSize);
+    ring.push(dataSize);
+    return 0;
+  }
+#endif
+
+  // Copy the message data directly into the next free slot of the queue.
+  Endpoint::Blob *blob = ep->reserveMessageToClient();
+  if (!blob) {
+    fprintf(stderr, "Endpoint queue to the client is full!\n");
+    return -5;
+  }
+  blob->resize(dataSize);
   for (int i = 0; i < dataSize; ++i) {
     (*blob)[i] = *(char *)svGetArrElemPtr1(data, i);
   }
-  // Queue the blob.
+  log(endpointId, true, blob->data(), blob->size());
+  ep->pushMessageToClient();
+  server->wakeUp();
+  return 0;
+}
+
+// Attempt to send data to a client.
+// - return 0 on success, negative on failure (unregistered EP, full queue,
+//   message too big for the shared memory segment).
+// - if dataSize is negative, attempt to dynamically determine the size of
+//   'data'.
+DPI int sv2cCosimserverEpTryPut(char *endpointId,
+                                // NOLINTNEXTLINE(misc-misplaced-const)
+                                const svOpenArrayHandle data, int dataSize) {
+  if (server == nullptr)
+    return -1;
+
   Endpoint *ep = server->endpoints[endpointId];
   if (!ep) {
     fprintf(stderr, "Endpoint not found in registry!\n");
     return -4;
   }
-  log(endpointId, true, blob);
-  ep->pushMessageToClient(blob);
-  return 0;
+  return tryPut(ep, endpointId, data, dataSize);
+}
+
+// Same as 'sv2cCosimserverEpTryPut', but for the endpoint with the handle
+// returned by 'sv2cCosimserverEpRegisterHandle'.
+DPI int sv2cCosimserverEpTryPutHandle(int handle,
+                                      // NOLINTNEXTLINE(misc-misplaced-const)
+                                      const svOpenArrayHandle data,
+                                      int dataSize) {
+  if (server == nullptr)
+    return -1;
+
+  Endpoint *ep = server->endpoints.getByHandle(handle);
+  if (!ep) {
+    fprintf(stderr, "Endpoint handle not found in registry!\n");
+    return -4;
+  }
+  return tryPut(ep, server->endpoints.getId(handle).c_str(), data, dataSize);
 }
 
 // Teardown cosimserver (disconnects from primary server port, stops connections
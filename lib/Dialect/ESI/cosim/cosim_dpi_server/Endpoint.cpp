@@ -12,13 +12,52 @@
 
 #include "circt/Dialect/ESI/cosim/Endpoint.h"
 
+#include <algorithm>
+#include <stdexcept>
+
+#if WIN32
+// Shared memory is not supported on Windows, so there are never any segments.
+namespace esi::runtime::cosim::shm {
+class Segment {};
+} // namespace esi::runtime::cosim::shm
+#else
+#include "esi/backends/shm.h"
+#include <unistd.h>
+#endif
+
 using namespace circt::esi::cosim;
 
 Endpoint::Endpoint(uint64_t sendTypeId, int sendTypeMaxSize,
                    uint64_t recvTypeId, int recvTypeMaxSize)
-    : sendTypeId(sendTypeId), recvTypeId(recvTypeId), inUse(false) {}
+    : sendTypeId(sendTypeId), recvTypeId(recvTypeId),
+      sendTypeMaxSize(sendTypeMaxSize), recvTypeMaxSize(recvTypeMaxSize),
+      inUse(false), toCosim(queueCapacity, std::max(recvTypeMaxSize, 0)),
+      toClient(queueCapacity, std::max(sendTypeMaxSize, 0)) {}
 Endpoint::~Endpoint() {}
 
+/// Return the slot size of the shared memory rings for a message type. The
+/// size is not known for all types, so use a generous default for those.
+static uint32_t getSlotSize(int typeMaxSize) {
+  return typeMaxSize > 0 ? typeMaxSize : 4096;
+}
+
+const std::string &Endpoint::openSharedMemory() {
+#if WIN32
+  throw std::runtime_error("Shared memory is not supported on Windows");
+#else
+  if (!shm) {
+    static std::atomic<unsigned> segmentCounter = 0;
+    std::string name = "/esi-cosim-" + std::to_string(getpid()) + "-" +
+                       std::to_string(segmentCounter++);
+    shm = SharedMemory::create(name, queueCapacity,
+                               getSlotSize(recvTypeMaxSize),
+                               getSlotSize(sendTypeMaxSize));
+  }
+  shmOpen.store(true, std::memory_order_release);
+  return shm->getName();
+#endif
+}
+
 bool Endpoint::setInUse() {
   Lock g(m);
   if (inUse)
@@ -34,24 +73,25 @@ void Endpoint::returnForUse() {
   inUse = false;
 }
 
-bool EndpointRegistry::registerEndpoint(std::string epId, uint64_t sendTypeId,
-                                        int sendTypeMaxSize,
-                                        uint64_t recvTypeId,
-                                        int recvTypeMaxSize) {
+int EndpointRegistry::registerEndpoint(std::string epId, uint64_t sendTypeId,
+                                       int sendTypeMaxSize, uint64_t recvTypeId,
+                                       int recvTypeMaxSize) {
   Lock g(m);
   if (endpoints.find(epId) != endpoints.end()) {
     fprintf(stderr, "Endpoint ID already exists!\n");
-    return false;
+    return -1;
   }
   // The following ugliness adds an Endpoint to the map of Endpoints. The
   // Endpoint class has its copy constructor deleted, thus the metaprogramming.
-  endpoints.emplace(std::piecewise_construct,
-                    // Map key.
-                    std::forward_as_tuple(epId),
-                    // Endpoint constructor args.
-                    std::forward_as_tuple(sendTypeId, sendTypeMaxSize,
-                                          recvTypeId, recvTypeMaxSize));
-  return true;
+  auto it = endpoints.emplace(std::piecewise_construct,
+                              // Map key.
+                              std::forward_as_tuple(epId),
+                              // Endpoint constructor args.
+                              std::forward_as_tuple(sendTypeId, sendTypeMaxSize,
+                                                    recvTypeId,
+                                                    recvTypeMaxSize));
+  handles.push_back(&*it.first);
+  return handles.size() - 1;
 }
 
 void EndpointRegistry::iterateEndpoints(
@@ -19,11 +19,15 @@
 
 #include "circt/Dialect/ESI/cosim/Server.h"
 #include "circt/Dialect/ESI/cosim/CosimDpi.capnp.h"
+#include <algorithm>
 #include <capnp/ez-rpc.h>
+#include <list>
+#include <stdexcept>
 #include <thread>
 #if WIN32
 #include <io.h>
 #else
+#include <fcntl.h>
 #include <unistd.h>
 #endif
 
@@ -31,6 +35,50 @@ using namespace capnp;
 using namespace circt::esi::cosim;
 
 namespace {
+/// The blocking recv() calls waiting for the simulation to queue a message to
+/// the client. These are completed by the server thread whenever it is woken
+/// up by the simulation.
+class BlockedRecvs {
+public:
+  /// Set the timer used to time out the calls. Without one, the calls wait
+  /// forever.
+  void setTimer(kj::Timer &newTimer) { timer = &newTimer; }
+
+  /// Return a promise which resolves once a message to the client is available
+  /// on the endpoint, or after `timeoutMs` milliseconds unless that is zero.
+  kj::Promise<void> waitForMessage(Endpoint &endpoint, uint32_t timeoutMs) {
+    auto paf = kj::newPromiseAndFulfiller<void>();
+    waiters.push_back({&endpoint, kj::mv(paf.fulfiller)});
+    if (timeoutMs == 0 || !timer)
+      return kj::mv(paf.promise);
+    return paf.promise.exclusiveJoin(
+        timer->afterDelay(timeoutMs * kj::MILLISECONDS));
+  }
+
+  /// Complete the calls for which a message is available now and drop the ones
+  /// which have been canceled.
+  void complete() {
+    for (auto it = waiters.begin(); it != waiters.end();) {
+      if (!it->fulfiller->isWaiting()) {
+        it = waiters.erase(it);
+      } else if (it->endpoint->peekMessageToClient()) {
+        it->fulfiller->fulfill();
+        it = waiters.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+private:
+  struct Waiter {
+    Endpoint *endpoint;
+    kj::Own<kj::PromiseFulfiller<void>> fulfiller;
+  };
+  std::list<Waiter> waiters;
+  kj::Timer *timer = nullptr;
+};
+
 /// Implements the `EsiDpiEndpoint` interface from the RPC schema. Mostly a
 /// wrapper around an `Endpoint` object. Whereas the `Endpoint`s are long-lived
 /// (associated with the HW endpoint), this class is constructed/destructed
@@ -39,12 +87,14 @@ class EndpointServer final
     : public EsiDpiEndpoint<capnp::AnyPointer, capnp::AnyPointer>::Server {
   /// The wrapped endpoint.
   Endpoint &endpoint;
+  /// The blocking recv() calls of all endpoints.
+  BlockedRecvs &blockedRecvs;
   /// Signals that this endpoint has been opened by a client and hasn't been
   /// closed by said client.
   bool open;
 
 public:
-  EndpointServer(Endpoint &ep);
+  EndpointServer(Endpoint &ep, BlockedRecvs &blockedRecvs);
   /// Release the Endpoint should the client disconnect without properly closing
   /// it.
   ~EndpointServer();
@@ -55,98 +105,174 @@ public:
   kj::Promise<void> send(SendContext) override;
   kj::Promise<void> recv(RecvContext) override;
   kj::Promise<void> close(CloseContext) override;
+  kj::Promise<void> sendMany(SendManyContext) override;
+  kj::Promise<void> recvMany(RecvManyContext) override;
 };
 
 /// Implements the `CosimDpiServer` interface from the RPC schema.
 class CosimServer final : public CosimDpiServer::Server {
   /// The registry of endpoints. The RpcServer class owns this.
   EndpointRegistry &reg;
+  /// The blocking recv() calls of all endpoints.
+  BlockedRecvs &blockedRecvs;
 
 public:
-  CosimServer(EndpointRegistry &reg);
+  CosimServer(EndpointRegistry &reg, BlockedRecvs &blockedRecvs);
 
   /// List all the registered interfaces.
   kj::Promise<void> list(ListContext ctxt) override;
   /// Open a specific interface, locking it in the process.
   kj::Promise<void> open(OpenContext ctxt) override;
+  /// Like `open`, but move the messages over to shared memory.
+  kj::Promise<void> openShm(OpenShmContext ctxt) override;
 };
 } // anonymous namespace
 
 /// ------ EndpointServer definitions.
 
-EndpointServer::EndpointServer(Endpoint &ep) : endpoint(ep), open(true) {}
+EndpointServer::EndpointServer(Endpoint &ep, BlockedRecvs &blockedRecvs)
+    : endpoint(ep), blockedRecvs(blockedRecvs), open(true) {}
 EndpointServer::~EndpointServer() {
-  if (open)
+  if (open) {
+    endpoint.closeSharedMemory();
     endpoint.returnForUse();
+  }
+}
+
+/// Copy the oldest message to the client into `dest` and remove it from the
+/// queue. Returns false if there is none.
+static bool popMessageToClient(Endpoint &endpoint, AnyPointer::Builder dest) {
+  const Endpoint::Blob *blob = endpoint.peekMessageToClient();
+  if (!blob)
+    return false;
+  if (blob->size() % 8 != 0) {
+    endpoint.popMessageToClient();
+    KJ_FAIL_REQUIRE("Response msg was malformed. Size of response was not a "
+                    "multiple of 8 bytes.");
+  }
+  // Copy the blob into a single segment.
+  auto segment =
+      kj::ArrayPtr<capnp::word>((word *)blob->data(), blob->size() / 8)
+          .asConst();
+  // Create a single-element array of segments.
+  kj::Array<kj::ArrayPtr<const capnp::word>> segments =
+      kj::heapArray({segment});
+  // Create an object which will read the segments into a message on send.
+  SegmentArrayMessageReader msgReader(segments);
+  // Copy the message, so its slot can be reused afterwards.
+  dest.set(msgReader.getRoot<AnyPointer>());
+  endpoint.popMessageToClient();
+  return true;
+}
+
+/// Copy a message from the client into the next free slot of the queue to the
+/// simulation. The caller has to make sure that there is one. The only way I
+/// could figure out to copy the raw message is a double copy. I was have
+/// issues getting libkj's arrays to play nice with others.
+static void pushMessageToSim(Endpoint &endpoint, AnyPointer::Reader msg) {
+  // Copy the incoming message into a flat, single segment buffer.
+  auto msgSize = msg.targetSize();
+  MallocMessageBuilder builder(msgSize.wordCount + 1,
+                               AllocationStrategy::FIXED_SIZE);
+  builder.setRoot(msg);
+  auto segments = builder.getSegmentsForOutput();
+  KJ_REQUIRE(segments.size() == 1, "Messages must be one segment");
+
+  // Now copy it into the queue.
+  Endpoint::Blob *blob = endpoint.reserveMessageToSim();
+  auto fstSegmentData = segments[0].asBytes();
+  blob->assign(fstSegmentData.begin(), fstSegmentData.end());
+  endpoint.pushMessageToSim();
 }
 
-/// This is the client polling for a message. If one is available, send it.
-/// TODO: implement a blocking call with a timeout.
+/// This is the client asking for a message. If one is available, send it. A
+/// blocking call otherwise waits until the simulation queues one or the call
+/// times out.
 kj::Promise<void> EndpointServer::recv(RecvContext context) {
   KJ_REQUIRE(open, "EndPoint closed already");
-  KJ_REQUIRE(!context.getParams().getBlock(),
-             "Blocking recv() not supported yet");
-
-  // Try to pop a message.
-  Endpoint::BlobPtr blob;
-  auto msgPresent = endpoint.getMessageToClient(blob);
-  context.getResults().setHasData(msgPresent);
-  if (msgPresent) {
-    KJ_REQUIRE(blob->size() % 8 == 0,
-               "Response msg was malformed. Size of response was not a "
-               "multiple of 8 bytes.");
-    // Copy the blob into a single segment.
-    auto segment =
-        kj::ArrayPtr<capnp::word>((word *)blob->data(), blob->size() / 8)
-            .asConst();
-    // Create a single-element array of segments.
-    kj::Array<kj::ArrayPtr<const capnp::word>> segments =
-        kj::heapArray({segment});
-    // Create an object which will read the segments into a message on send.
-    std::unique_ptr<SegmentArrayMessageReader> msgReader =
-        std::make_unique<SegmentArrayMessageReader>(segments);
-    // Send.
-    context.getResults().getResp().set(msgReader->getRoot<AnyPointer>());
+  KJ_REQUIRE(!endpoint.getSharedMemory(), "Endpoint uses shared memory");
+
+  // Only capture the endpoint, which outlives this object.
+  Endpoint &ep = endpoint;
+  auto respond = [&ep, context]() mutable {
+    auto results = context.getResults();
+    results.setHasData(popMessageToClient(ep, results.getResp()));
+  };
+
+  auto params = context.getParams();
+  if (!params.getBlock() || ep.peekMessageToClient()) {
+    respond();
+    return kj::READY_NOW;
   }
-  return kj::READY_NOW;
+  return blockedRecvs.waitForMessage(ep, params.getTimeoutMs())
+      .then(kj::mv(respond));
+}
+
+/// Like `recv`, but send as many of the queued messages as the client asked
+/// for.
+kj::Promise<void> EndpointServer::recvMany(RecvManyContext context) {
+  KJ_REQUIRE(open, "EndPoint closed already");
+  KJ_REQUIRE(!endpoint.getSharedMemory(), "Endpoint uses shared memory");
+
+  auto params = context.getParams();
+  uint32_t maxMsgs = params.getMaxMsgs();
+  Endpoint &ep = endpoint;
+  auto respond = [&ep, maxMsgs, context]() mutable {
+    auto numMsgs = std::min<size_t>(maxMsgs, ep.getNumQueuedToClient());
+    auto resps = context.getResults().initResps(numMsgs);
+    for (size_t i = 0; i < numMsgs; ++i)
+      popMessageToClient(ep, resps[i].getMsg());
+  };
+
+  if (maxMsgs == 0 || !params.getBlock() || ep.peekMessageToClient()) {
+    respond();
+    return kj::READY_NOW;
+  }
+  return blockedRecvs.waitForMessage(ep, params.getTimeoutMs())
+      .then(kj::mv(respond));
 }
 
 /// 'Send' is from the client perspective, so this is a message we are
-/// recieving. The only way I could figure out to copy the raw message is a
-/// double copy. I was have issues getting libkj's arrays to play nice with
-/// others.
+/// recieving.
 kj::Promise<void> EndpointServer::send(SendContext context) {
   KJ_REQUIRE(open, "EndPoint closed already");
   auto capnpMsgPointer = context.getParams().getMsg();
   KJ_REQUIRE(capnpMsgPointer.isStruct(),
              "Only messages can go in the 'msg' parameter");
+  KJ_REQUIRE(!endpoint.getSharedMemory(), "Endpoint uses shared memory");
+  KJ_REQUIRE(endpoint.getNumFreeToSim() != 0,
+             "Endpoint queue to the simulation is full");
+  pushMessageToSim(endpoint, capnpMsgPointer);
+  return kj::READY_NOW;
+}
 
-  // Copy the incoming message into a flat, single segment buffer.
-  auto msgSize = capnpMsgPointer.targetSize();
-  auto builder = std::make_unique<MallocMessageBuilder>(
-      msgSize.wordCount + 1, AllocationStrategy::FIXED_SIZE);
-  builder->setRoot(capnpMsgPointer);
-  auto segments = builder->getSegmentsForOutput();
-  KJ_REQUIRE(segments.size() == 1, "Messages must be one segment");
-
-  // Now copy it into a blob and queue it.
-  auto fstSegmentData = segments[0].asBytes();
-  auto blob = std::make_shared<Endpoint::Blob>(fstSegmentData.begin(),
-                                               fstSegmentData.end());
-  endpoint.pushMessageToSim(blob);
+/// Queue all of the messages or, if they don't fit, none of them.
+kj::Promise<void> EndpointServer::sendMany(SendManyContext context) {
+  KJ_REQUIRE(open, "EndPoint closed already");
+  auto msgs = context.getParams().getMsgs();
+  for (auto msg : msgs)
+    KJ_REQUIRE(msg.getMsg().isStruct(),
+               "Only messages can go in the 'msgs' parameter");
+  KJ_REQUIRE(!endpoint.getSharedMemory(), "Endpoint uses shared memory");
+  KJ_REQUIRE(msgs.size() <= endpoint.getNumFreeToSim(),
+             "Endpoint queue to the simulation is full");
+  for (auto msg : msgs)
+    pushMessageToSim(endpoint, msg.getMsg());
   return kj::READY_NOW;
 }
 
 kj::Promise<void> EndpointServer::close(CloseContext context) {
   KJ_REQUIRE(open, "EndPoint closed already");
   open = false;
+  endpoint.closeSharedMemory();
   endpoint.returnForUse();
   return kj::READY_NOW;
 }
 
 /// ----- CosimServer definitions.
 
-CosimServer::CosimServer(EndpointRegistry &reg) : reg(reg) {}
+CosimServer::CosimServer(EndpointRegistry &reg, BlockedRecvs &blockedRecvs)
+    : reg(reg), blockedRecvs(blockedRecvs) {}
 
 kj::Promise<void> CosimServer::list(ListContext context) {
   auto ifaces = context.getResults().initIfaces((unsigned int)reg.size());
@@ -168,14 +294,68 @@ kj::Promise<void> CosimServer::open(OpenContext ctxt) {
   KJ_REQUIRE(gotLock, "Endpoint in use");
 
   ctxt.getResults().setIface(EsiDpiEndpoint<AnyPointer, AnyPointer>::Client(
-      kj::heap<EndpointServer>(*ep)));
+      kj::heap<EndpointServer>(*ep, blockedRecvs)));
+  return kj::READY_NOW;
+}
+
+kj::Promise<void> CosimServer::openShm(OpenShmContext ctxt) {
+  Endpoint *ep = reg[ctxt.getParams().getIface().getEndpointID()];
+  KJ_REQUIRE(ep != nullptr, "Could not find endpoint");
+
+  auto gotLock = ep->setInUse();
+  KJ_REQUIRE(gotLock, "Endpoint in use");
+
+  std::string shmName;
+  try {
+    shmName = ep->openSharedMemory();
+  } catch (const std::runtime_error &e) {
+    ep->returnForUse();
+    KJ_FAIL_REQUIRE("Could not open shared memory", e.what());
+  }
+
+  auto results = ctxt.getResults();
+  // The client keeps the endpoint open through this interface. Dropping or
+  // closing it switches the endpoint back to the RPC message queues.
+  results.setIface(EsiDpiEndpoint<AnyPointer, AnyPointer>::Client(
+      kj::heap<EndpointServer>(*ep, blockedRecvs)));
+  results.setShmName(shmName);
   return kj::READY_NOW;
 }
 
 /// ----- RpcServer definitions.
 
-RpcServer::RpcServer() : mainThread(nullptr), stopSig(false) {}
-RpcServer::~RpcServer() { stop(); }
+RpcServer::RpcServer() : mainThread(nullptr), stopSig(false) {
+#if !WIN32
+  if (pipe(wakeupFds) != 0) {
+    perror("[COSIM] Could not create the wake-up pipe");
+    wakeupFds[0] = wakeupFds[1] = -1;
+  } else {
+    // Never block the simulation. A full pipe already has a wake-up pending.
+    fcntl(wakeupFds[1], F_SETFL, fcntl(wakeupFds[1], F_GETFL) | O_NONBLOCK);
+  }
+#endif
+}
+
+RpcServer::~RpcServer() {
+  stop();
+#if !WIN32
+  if (wakeupFds[0] >= 0) {
+    close(wakeupFds[0]);
+    close(wakeupFds[1]);
+  }
+#endif
+}
+
+void RpcServer::wakeUp() {
+#if !WIN32
+  if (wakeupFds[1] < 0)
+    return;
+  char byte = 0;
+  // Ignore errors: the write only fails if the pipe is full, in which case the
+  // server thread is going to wake up anyway.
+  (void)!write(wakeupFds[1], &byte, 1);
+#endif
+}
 
 /// Write the port number to a file. Necessary when we allow 'EzRpcServer' to
 /// select its own port. We can't use stdout/stderr because the flushing
@@ -188,9 +368,11 @@ static void writePort(uint16_t port) {
 }
 
 void RpcServer::mainLoop(uint16_t port) {
-  capnp::EzRpcServer rpcServer(kj::heap<CosimServer>(endpoints),
+  BlockedRecvs blockedRecvs;
+  capnp::EzRpcServer rpcServer(kj::heap<CosimServer>(endpoints, blockedRecvs),
                                /* bindAddress */ "*", port);
   auto &waitScope = rpcServer.getWaitScope();
+  blockedRecvs.setTimer(rpcServer.getIoProvider().getTimer());
   // If port is 0, ExRpcSever selects one and we have to wait to get the port.
   if (port == 0) {
     auto portPromise = rpcServer.getPort();
@@ -199,18 +381,27 @@ void RpcServer::mainLoop(uint16_t port) {
   writePort(port);
   printf("[COSIM] Listening on port: %u\n", (unsigned int)port);
 
-  // OK, this is uber hacky, but it unblocks me and isn't _too_ inefficient. The
-  // problem is that I can't figure out how read the stop signal from libkj
-  // asyncrony land.
-  //
-  // IIRC the main libkj wait loop uses `select()` (or something similar on
-  // Windows) on its FDs. As a result, any code which checks the stop variable
-  // doesn't run until there is some I/O. Probably the right way is to set up a
-  // pipe to deliver a shutdown signal.
-  //
-  // TODO: Figure out how to do this properly, if possible.
+#if !WIN32
+  if (wakeupFds[0] >= 0) {
+    // Run the event loop until another thread writes to the wake-up pipe,
+    // either after queueing a message to a client or to shut the server down.
+    // RPC calls are served as soon as they arrive in the meantime.
+    auto wakeupStream =
+        rpcServer.getLowLevelIoProvider().wrapInputFd(wakeupFds[0]);
+    char buffer[64];
+    while (!stopSig) {
+      wakeupStream->tryRead(buffer, 1, sizeof(buffer)).wait(waitScope);
+      blockedRecvs.complete();
+    }
+    return;
+  }
+#endif
+
+  // Without a wake-up pipe, there is no way to notice the stop signal or
+  // queued messages from within the libkj event loop, so poll for them.
   while (!stopSig) {
     waitScope.poll();
+    blockedRecvs.complete();
     std::this_thread::sleep_for(std::chrono::milliseconds(1));
   }
 }
@@ -232,6 +423,7 @@ void RpcServer::stop() {
     fprintf(stderr, "RpcServer not Run()\n");
   } else if (!stopSig) {
     stopSig = true;
+    wakeUp();
     mainThread->join();
   }
 }
@@ -25,6 +25,18 @@
 #include <capnp/message.h>
 #include <capnp/schema.h>
 
+#include <chrono>
+#include <cstring>
+#include <optional>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#ifndef _WIN32
+#include "esi/backends/shm.h"
+#endif
+
 // Assert that an ESI_COSIM_CAPNP_H variable is defined. This is the capnp
 // header file generated from the ESI schema, containing definitions for e.g.
 // CosimDpiServer, ...
@@ -75,6 +87,50 @@ void toCapnp(TESIType &value, DynamicValue::Builder &message) {
 }
 
 namespace detail {
+// Detects the statically typed conversions which the ESI C++ API generator
+// emits for each type.
+template <typename TESIType, typename = void>
+struct HasTypedCapnp : std::false_type {};
+template <typename TESIType>
+struct HasTypedCapnp<
+    TESIType, std::void_t<decltype(TESIType::fromCapnp(
+                  std::declval<typename TESIType::CPType::Reader>()))>>
+    : std::true_type {};
+} // namespace detail
+
+// Write an ESI value into a capnp message. Uses the typed conversion of the
+// type if it has one, which avoids the dynamic API and reflection.
+template <typename TESIType>
+void encodeCapnp(const TESIType &value,
+                 typename TESIType::CPType::Builder builder) {
+  if constexpr (detail::HasTypedCapnp<TESIType>::value) {
+    value.toCapnp(builder);
+  } else {
+    auto dynBuilder = DynamicValue::Builder(builder);
+    TESIType copy = value;
+    toCapnp<TESIType>(copy, dynBuilder);
+  }
+}
+
+// Read an ESI value from a capnp message. Uses the typed conversion of the
+// type if it has one, which avoids the dynamic API and reflection.
+template <typename TESIType>
+TESIType decodeCapnp(typename TESIType::CPType::Reader reader) {
+  if constexpr (detail::HasTypedCapnp<TESIType>::value)
+    return TESIType::fromCapnp(reader);
+  else
+    return fromCapnp<TESIType>(reader);
+}
+
+namespace detail {
+// Return a size hint for RPC parameters of type `Params` holding `numMsgs`
+// values of type `CPType`. ESI messages have a fixed size, so this lets capnp
+// allocate each request in one go.
+template <typename Params, typename CPType>
+MessageSize getSizeHint(size_t numMsgs = 1) {
+  return {sizeInWords<Params>() + numMsgs * sizeInWords<CPType>(), 0};
+}
+
 // Custom type to hold the interface descriptions because i can't for the life
 // of me figure out how to cleanly keep capnproto messages around...
 struct EsiDpiInterfaceDesc {
@@ -86,6 +142,77 @@ struct EsiDpiInterfaceDesc {
 
 using EsiDpiInterfaceDesc = detail::EsiDpiInterfaceDesc;
 
+namespace detail {
+// Send a message to the endpoint.
+template <typename WriteType, typename Client>
+void write(Client &port, kj::WaitScope &waitScope, const WriteType &arg) {
+  auto req = port.sendRequest(
+      getSizeHint<typename Client::Calls::SendParams,
+                  typename WriteType::CPType>());
+  encodeCapnp(arg, req.getMsg());
+  req.send().wait(waitScope);
+}
+
+// Send all of the messages to the endpoint in a single RPC.
+template <typename WriteType, typename Client>
+void writeMany(Client &port, kj::WaitScope &waitScope,
+               const std::vector<WriteType> &args) {
+  using CPType = typename WriteType::CPType;
+  // Account for the list tag and the wrapper struct of each message.
+  auto sizeHint = getSizeHint<typename Client::Calls::SendManyParams, CPType>(
+      args.size());
+  sizeHint.wordCount +=
+      1 + args.size() * sizeInWords<::EsiDpiMessage<CPType>>();
+  auto req = port.sendManyRequest(sizeHint);
+  auto msgs = req.initMsgs(args.size());
+  for (size_t i = 0, e = args.size(); i < e; ++i)
+    encodeCapnp(args[i], msgs[i].getMsg());
+  req.send().wait(waitScope);
+}
+
+// Receive a message from the endpoint, waiting for up to `timeout` (forever if
+// zero) for one to arrive. The server does the waiting, so this is one RPC.
+template <typename ReadType, typename Client>
+std::optional<ReadType> read(Client &port, kj::WaitScope &waitScope,
+                             std::chrono::milliseconds timeout) {
+  auto recvReq = port.recvRequest();
+  recvReq.setBlock(true);
+  recvReq.setTimeoutMs(timeout.count());
+  auto resp = recvReq.send().wait(waitScope);
+  if (!resp.getHasData())
+    return std::nullopt;
+  return decodeCapnp<ReadType>(resp.getResp());
+}
+
+// Receive up to `maxMsgs` messages from the endpoint in a single RPC, waiting
+// for at least one to arrive.
+template <typename ReadType, typename Client>
+std::vector<ReadType> readMany(Client &port, kj::WaitScope &waitScope,
+                               uint32_t maxMsgs) {
+  std::vector<ReadType> ret;
+  do {
+    auto recvReq = port.recvManyRequest();
+    recvReq.setMaxMsgs(maxMsgs);
+    recvReq.setBlock(true);
+    auto resp = recvReq.send().wait(waitScope);
+    for (auto msg : resp.getResps())
+      ret.push_back(decodeCapnp<ReadType>(msg.getMsg()));
+  } while (ret.empty() && maxMsgs != 0);
+  return ret;
+}
+
+// Receive a message from the endpoint, waiting for as long as it takes.
+template <typename ReadType, typename Client>
+ReadType read(Client &port, kj::WaitScope &waitScope) {
+  std::optional<ReadType> ret;
+  // A timeout of zero makes the server wait forever, so this only loops if the
+  // server gives up on the call for some other reason.
+  while (!ret)
+    ret = read<ReadType>(port, waitScope, std::chrono::milliseconds(0));
+  return *ret;
+}
+} // namespace detail
+
 template <typename WriteType, typename ReadType>
 class CapnpReadWritePort;
 
@@ -146,6 +273,25 @@ public:
 
   template <typename CnPWriteType, typename CnPReadType>
   auto getPort(const std::vector<std::string> &clientPath) {
+    auto openReq = dpiClient->openRequest<CnPWriteType, CnPReadType>();
+    describeEndpoint(clientPath, openReq.getIface());
+
+    // Open the endpoint.
+    auto openResp = openReq.send().wait(ezClient->getWaitScope());
+    return openResp.getIface();
+  }
+
+  bool supportsImpl(const std::string &implType) {
+    // The cosim backend only supports cosim connectivity implementations
+    return implType == "cosim";
+  }
+
+  kj::WaitScope &getWaitScope() { return ezClient->getWaitScope(); }
+
+protected:
+  // Find the endpoint of the client path and fill in its description.
+  void describeEndpoint(const std::vector<std::string> &clientPath,
+                        ::EsiDpiInterfaceDesc::Builder iface) {
     // Join client path into a single string with '.' as a separator.
     std::string clientPathStr;
     for (auto &path : clientPath) {
@@ -157,38 +303,20 @@ public:
     // Everything is nested under "TOP.top"
     clientPathStr = "TOP.top." + clientPathStr;
 
-    auto openReq = dpiClient->openRequest<CnPWriteType, CnPReadType>();
-
     // Scan through the available endpoints to find the requested one.
-    bool found = false;
     for (auto &ep : list()) {
       auto epid = ep.endpointID;
       if (epid == clientPathStr) {
-        auto iface = openReq.getIface();
         iface.setEndpointID(epid);
         iface.setSendTypeID(ep.sendTypeID);
         iface.setRecvTypeID(ep.recvTypeID);
-        found = true;
-        break;
+        return;
       }
     }
 
-    if (!found)
-      throw std::runtime_error("Could not find endpoint: " + clientPathStr);
-
-    // Open the endpoint.
-    auto openResp = openReq.send().wait(ezClient->getWaitScope());
-    return openResp.getIface();
-  }
-
-  bool supportsImpl(const std::string &implType) {
-    // The cosim backend only supports cosim connectivity implementations
-    return implType == "cosim";
+    throw std::runtime_error("Could not find endpoint: " + clientPathStr);
   }
 
-  kj::WaitScope &getWaitScope() { return ezClient->getWaitScope(); }
-
-protected:
   std::unique_ptr<capnp::EzRpcClient> ezClient;
   std::unique_ptr<CosimDpiServer::Client> dpiClient;
   std::optional<std::vector<detail::EsiDpiInterfaceDesc>> endpoints;
@@ -204,22 +332,20 @@ public:
       : BasePort(clientPath, backend, implType) {}
 
   ReadType operator()(WriteType arg) {
-    auto req = port->sendRequest();
-    MallocMessageBuilder mmb;
-    auto dynBuilder = DynamicValue::Builder(req.getMsg());
-    toCapnp<WriteType>(arg, dynBuilder);
-    req.send().wait(this->backend->getWaitScope());
-    std::optional<capnp::Response<typename EsiDpiEndpoint<
-        typename WriteType::CPType, typename ReadType::CPType>::RecvResults>>
-        resp;
-    do {
-      auto recvReq = port->recvRequest();
-      recvReq.setBlock(false);
-
-      resp = recvReq.send().wait(this->backend->getWaitScope());
-    } while (!resp->getHasData());
-    auto data = resp->getResp();
-    return fromCapnp<ReadType>(data);
+    detail::write(*port, this->backend->getWaitScope(), arg);
+    return detail::read<ReadType>(*port, this->backend->getWaitScope());
+  }
+
+  // Send all of the arguments in a single RPC.
+  void writeMany(const std::vector<WriteType> &args) {
+    detail::writeMany(*port, this->backend->getWaitScope(), args);
+  }
+
+  // Receive up to `maxMsgs` responses in a single RPC, waiting for at least
+  // one.
+  std::vector<ReadType> readMany(uint32_t maxMsgs) {
+    return detail::readMany<ReadType>(*port, this->backend->getWaitScope(),
+                                      maxMsgs);
   }
 
   void initBackend() override {
@@ -249,10 +375,12 @@ public:
   }
 
   void operator()(WriteType arg) {
-    auto req = port->sendRequest();
-    auto dynBuilder = DynamicValue::Builder(req.getMsg());
-    toCapnp<WriteType>(arg, dynBuilder);
-    req.send().wait(this->backend->getWaitScope());
+    detail::write(*port, this->backend->getWaitScope(), arg);
+  }
+
+  // Send all of the arguments in a single RPC.
+  void writeMany(const std::vector<WriteType> &args) {
+    detail::writeMany(*port, this->backend->getWaitScope(), args);
   }
 
 private:
@@ -276,17 +404,21 @@ public:
   }
 
   ReadType operator()() {
-    std::optional<capnp::Response<
-        typename EsiDpiEndpoint<::I1, typename ReadType::CPType>::RecvResults>>
-        resp;
-    do {
-      auto recvReq = port->recvRequest();
-      recvReq.setBlock(false);
-
-      resp = recvReq.send().wait(this->backend->getWaitScope());
-    } while (!resp->getHasData());
-    auto data = resp->getResp();
-    return fromCapnp<ReadType>(data);
+    return detail::read<ReadType>(*port, this->backend->getWaitScope());
+  }
+
+  // Wait for up to `timeout` for a message, or forever if it is zero. Returns
+  // std::nullopt if none arrived in time.
+  std::optional<ReadType> read(std::chrono::milliseconds timeout) {
+    return detail::read<ReadType>(*port, this->backend->getWaitScope(),
+                                  timeout);
+  }
+
+  // Receive up to `maxMsgs` messages in a single RPC, waiting for at least
+  // one.
+  std::vector<ReadType> readMany(uint32_t maxMsgs) {
+    return detail::readMany<ReadType>(*port, this->backend->getWaitScope(),
+                                      maxMsgs);
   }
 
 private:
@@ -296,6 +428,168 @@ private:
       port;
 };
 
+#ifndef _WIN32
+template <typename WriteType, typename ReadType>
+class CapnpShmReadWritePort;
+
+template <typename WriteType>
+class CapnpShmWritePort;
+
+template <typename ReadType>
+class CapnpShmReadPort;
+
+// A variant of the Cap'n'proto backend for clients on the same host as the
+// simulation. The RPC connection is only used to open the endpoints, the
+// messages are exchanged through shared memory instead.
+class CapnpShmBackend : public CapnpBackend {
+public:
+  template <typename WriteType, typename ReadType>
+  using ReadWritePort = CapnpShmReadWritePort<WriteType, ReadType>;
+
+  template <typename WriteType>
+  using WritePort = CapnpShmWritePort<WriteType>;
+
+  template <typename ReadType>
+  using ReadPort = CapnpShmReadPort<ReadType>;
+
+  CapnpShmBackend(const std::string &host, uint64_t hostPort)
+      : CapnpBackend(host, hostPort) {}
+
+  // Open the endpoint for shared memory messaging. Returns the endpoint
+  // interface, which keeps the endpoint open, along with the mapped segment.
+  template <typename CnPWriteType, typename CnPReadType>
+  auto getShmPort(const std::vector<std::string> &clientPath) {
+    auto openReq = dpiClient->openShmRequest<CnPWriteType, CnPReadType>();
+    describeEndpoint(clientPath, openReq.getIface());
+    auto openResp = openReq.send().wait(ezClient->getWaitScope());
+    return std::make_pair(openResp.getIface(),
+                          shm::Segment::open(openResp.getShmName().cStr()));
+  }
+};
+
+namespace detail {
+// Build the message right in the next free slot of the ring, waiting for one
+// to become free if need be.
+template <typename WriteType>
+void shmWrite(shm::Ring ring, WriteType &arg) {
+  uint8_t *slot;
+  while (!(slot = ring.reserve()))
+    std::this_thread::yield();
+
+  // Cap'n'proto requires the first segment to be zeroed.
+  size_t numWords = ring.getSlotSize() / sizeof(word);
+  std::memset(slot, 0, numWords * sizeof(word));
+  MallocMessageBuilder builder(
+      kj::arrayPtr(reinterpret_cast<word *>(slot), numWords),
+      AllocationStrategy::FIXED_SIZE);
+  encodeCapnp(arg, builder.initRoot<typename WriteType::CPType>());
+
+  // The simulation expects a single segment.
+  auto segments = builder.getSegmentsForOutput();
+  if (segments.size() != 1 ||
+      segments[0].begin() != reinterpret_cast<word *>(slot))
+    throw std::runtime_error("Message does not fit in a shared memory slot");
+  ring.push(segments[0].asBytes().size());
+}
+
+// Decode the message right from the oldest slot of the ring, waiting for one
+// to arrive if need be.
+template <typename ReadType>
+ReadType shmRead(shm::Ring ring) {
+  const uint8_t *data;
+  size_t size;
+  while (!(data = ring.front(size)))
+    std::this_thread::yield();
+
+  kj::ArrayPtr<const word> segments[] = {
+      kj::arrayPtr(reinterpret_cast<const word *>(data), size / sizeof(word))};
+  SegmentArrayMessageReader reader(kj::arrayPtr(segments, 1));
+  ReadType ret =
+      decodeCapnp<ReadType>(reader.getRoot<typename ReadType::CPType>());
+  ring.pop();
+  return ret;
+}
+} // namespace detail
+
+template <typename WriteType, typename ReadType>
+class CapnpShmReadWritePort : public Port<CapnpShmBackend> {
+  using BasePort = Port<CapnpShmBackend>;
+
+public:
+  CapnpShmReadWritePort(const std::vector<std::string> &clientPath,
+                        CapnpShmBackend &backend, const std::string &implType)
+      : BasePort(clientPath, backend, implType) {}
+
+  ReadType operator()(WriteType arg) {
+    detail::shmWrite(segment->getToSim(), arg);
+    return detail::shmRead<ReadType>(segment->getToClient());
+  }
+
+  void initBackend() override {
+    std::tie(port, segment) =
+        backend->getShmPort<typename WriteType::CPType,
+                            typename ReadType::CPType>(clientPath);
+  }
+
+private:
+  // Handle to the underlying endpoint. Only used to keep it open.
+  std::optional<typename ::EsiDpiEndpoint<typename WriteType::CPType,
+                                          typename ReadType::CPType>::Client>
+      port;
+  std::unique_ptr<shm::Segment> segment;
+};
+
+template <typename WriteType>
+class CapnpShmWritePort : public Port<CapnpShmBackend> {
+  using BasePort = Port<CapnpShmBackend>;
+
+public:
+  CapnpShmWritePort(const std::vector<std::string> &clientPath,
+                    CapnpShmBackend &backend, const std::string &implType)
+      : BasePort(clientPath, backend, implType) {}
+
+  void initBackend() override {
+    std::tie(port, segment) =
+        backend->getShmPort<typename WriteType::CPType, ::I1>(clientPath);
+  }
+
+  void operator()(WriteType arg) { detail::shmWrite(segment->getToSim(), arg); }
+
+private:
+  // Handle to the underlying endpoint. Only used to keep it open.
+  std::optional<
+      typename ::EsiDpiEndpoint<typename WriteType::CPType, ::I1>::Client>
+      port;
+  std::unique_ptr<shm::Segment> segment;
+};
+
+template <typename ReadType>
+class CapnpShmReadPort : public Port<CapnpShmBackend> {
+  using BasePort = Port<CapnpShmBackend>;
+
+public:
+  CapnpShmReadPort(const std::vector<std::string> &clientPath,
+                   CapnpShmBackend &backend, const std::string &implType)
+      : BasePort(clientPath, backend, implType) {}
+
+  void initBackend() override {
+    std::tie(port, segment) =
+        backend->getShmPort<::I1, typename ReadType::CPType>(clientPath);
+  }
+
+  ReadType operator()() {
+    return detail::shmRead<ReadType>(segment->getToClient());
+  }
+
+private:
+  // Handle to the underlying endpoint. Only used to keep it open.
+  std::optional<
+      typename ::EsiDpiEndpoint<::I1, typename ReadType::CPType>::Client>
+      port;
+  std::unique_ptr<shm::Segment> segment;
+};
+#endif // _WIN32
+
 } // namespace cosim
 } // namespace runtime
 } // namespace esi
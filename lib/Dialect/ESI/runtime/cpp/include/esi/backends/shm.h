@@ -0,0 +1,234 @@
+//===- shm.h - ESI cosimulation shared memory transport ---------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// The layout of the shared memory segments through which a cosimulation on the
+// same host exchanges messages with its clients. Both the cosim DPI library and
+// the Cap'n'proto backend of the ESI C++ API map the segments. The RPC server
+// is only used to discover and open the endpoints.
+//
+// A segment holds one ring of message slots in each direction. Each ring has
+// exactly one producer and one consumer, so no locks are needed. POSIX only.
+//
+// DO NOT EDIT!
+// This file is distributed as part of an ESI package. The source for this file
+// should always be modified within CIRCT
+// (lib/dialect/ESI/runtime/cpp/include/esi/backends/shm.h).
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace esi {
+namespace runtime {
+namespace cosim {
+namespace shm {
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "Shared memory rings need lock-free 64-bit atomics");
+
+// The header of a ring. The head and tail counters live on their own cache
+// lines to avoid false sharing between the producer and the consumer.
+struct RingHeader {
+  uint32_t capacity;
+  // The number of message bytes which fit in a slot. A multiple of 8.
+  uint32_t slotSize;
+  // The number of messages consumed so far. Only written by the consumer.
+  alignas(64) std::atomic<uint64_t> head;
+  // The number of messages produced so far. Only written by the producer.
+  alignas(64) std::atomic<uint64_t> tail;
+};
+
+// A view of a ring of fixed-size message slots in a mapped segment. Each slot
+// starts with a 64-bit message size, followed by the message, so the message
+// data is always 8-byte aligned as Cap'n'proto requires.
+class Ring {
+public:
+  explicit Ring(void *base)
+      : hdr(static_cast<RingHeader *>(base)),
+        slots(static_cast<uint8_t *>(base) + sizeof(RingHeader)) {}
+
+  // The number of bytes taken by a ring.
+  static size_t getSize(uint32_t capacity, uint32_t slotSize) {
+    return sizeof(RingHeader) + capacity * getStride(slotSize);
+  }
+
+  // Construct an empty ring at `base`.
+  static void init(void *base, uint32_t capacity, uint32_t slotSize) {
+    auto *hdr = new (base) RingHeader();
+    hdr->capacity = capacity;
+    hdr->slotSize = (slotSize + 7) & ~7u;
+    hdr->head.store(0, std::memory_order_relaxed);
+    hdr->tail.store(0, std::memory_order_release);
+  }
+
+  uint32_t getSlotSize() const { return hdr->slotSize; }
+
+  // Producer side: return the data of the next free slot, or nullptr if the
+  // ring is full. It holds up to `getSlotSize()` bytes and is only visible to
+  // the consumer after a call to `push`.
+  uint8_t *reserve() {
+    uint64_t t = hdr->tail.load(std::memory_order_relaxed);
+    if (t - hdr->head.load(std::memory_order_acquire) == hdr->capacity)
+      return nullptr;
+    return getSlot(t) + sizeof(uint64_t);
+  }
+
+  // Producer side: publish the `size` bytes written to the reserved slot.
+  void push(size_t size) {
+    uint64_t t = hdr->tail.load(std::memory_order_relaxed);
+    *reinterpret_cast<uint64_t *>(getSlot(t)) = size;
+    hdr->tail.store(t + 1, std::memory_order_release);
+  }
+
+  // Consumer side: return the data of the oldest message and set `size` to its
+  // size, or return nullptr if the ring is empty. The data stays valid until
+  // the next call to `pop`.
+  const uint8_t *front(size_t &size) {
+    uint64_t h = hdr->head.load(std::memory_order_relaxed);
+    if (h == hdr->tail.load(std::memory_order_acquire))
+      return nullptr;
+    uint8_t *slot = getSlot(h);
+    size = *reinterpret_cast<uint64_t *>(slot);
+    return slot + sizeof(uint64_t);
+  }
+
+  // Consumer side: release the oldest message for reuse.
+  void pop() {
+    hdr->head.store(hdr->head.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_release);
+  }
+
+private:
+  static size_t getStride(uint32_t slotSize) {
+    return sizeof(uint64_t) + ((slotSize + 7) & ~7u);
+  }
+  uint8_t *getSlot(uint64_t index) {
+    return slots + (index % hdr->capacity) * getStride(hdr->slotSize);
+  }
+
+  RingHeader *hdr;
+  uint8_t *slots;
+};
+
+// A mapped shared memory segment holding the rings of one endpoint. The
+// creator of a segment removes its name once it is destroyed.
+class Segment {
+public:
+  Segment(const Segment &) = delete;
+  ~Segment() {
+    munmap(base, size);
+    if (owner)
+      shm_unlink(name.c_str());
+  }
+
+  // Create a new segment. The slot sizes are in bytes.
+  static std::unique_ptr<Segment> create(const std::string &name,
+                                         uint32_t capacity,
+                                         uint32_t toSimSlotSize,
+                                         uint32_t toClientSlotSize) {
+    size_t toSimOffset = alignTo(sizeof(Header));
+    size_t toClientOffset =
+        toSimOffset + alignTo(Ring::getSize(capacity, toSimSlotSize));
+    size_t size = toClientOffset + Ring::getSize(capacity, toClientSlotSize);
+
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0)
+      throw std::runtime_error("Could not create shared memory segment " +
+                               name);
+    if (ftruncate(fd, size) != 0) {
+      close(fd);
+      shm_unlink(name.c_str());
+      throw std::runtime_error("Could not size shared memory segment " + name);
+    }
+    std::unique_ptr<Segment> segment(new Segment(name, fd, size, true));
+
+    Ring::init(segment->base + toSimOffset, capacity, toSimSlotSize);
+    Ring::init(segment->base + toClientOffset, capacity, toClientSlotSize);
+    auto *hdr = new (segment->base) Header();
+    hdr->size = size;
+    hdr->toSimOffset = toSimOffset;
+    hdr->toClientOffset = toClientOffset;
+    // Publish the magic number last so that `open` never sees a partially
+    // initialized segment.
+    hdr->magic.store(magic, std::memory_order_release);
+    return segment;
+  }
+
+  // Map an existing segment.
+  static std::unique_ptr<Segment> open(const std::string &name) {
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0)
+      throw std::runtime_error("Could not open shared memory segment " + name);
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(Header)) {
+      close(fd);
+      throw std::runtime_error("Invalid shared memory segment " + name);
+    }
+    std::unique_ptr<Segment> segment(new Segment(name, fd, st.st_size, false));
+    auto *hdr = segment->getHeader();
+    if (hdr->magic.load(std::memory_order_acquire) != magic ||
+        hdr->size != segment->size)
+      throw std::runtime_error("Invalid shared memory segment " + name);
+    return segment;
+  }
+
+  const std::string &getName() const { return name; }
+
+  // The ring of messages from the client to the simulation.
+  Ring getToSim() { return Ring(base + getHeader()->toSimOffset); }
+  // The ring of messages from the simulation to the client.
+  Ring getToClient() { return Ring(base + getHeader()->toClientOffset); }
+
+private:
+  // "ESISHM01" in ASCII. Bump the trailing digits on layout changes.
+  static constexpr uint64_t magic = 0x45534953484d3031;
+
+  struct Header {
+    std::atomic<uint64_t> magic;
+    uint64_t size;
+    uint64_t toSimOffset;
+    uint64_t toClientOffset;
+  };
+
+  Segment(const std::string &name, int fd, size_t size, bool owner)
+      : name(name), size(size), owner(owner) {
+    void *addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+      if (owner)
+        shm_unlink(name.c_str());
+      throw std::runtime_error("Could not map shared memory segment " + name);
+    }
+    base = static_cast<uint8_t *>(addr);
+  }
+
+  static size_t alignTo(size_t size) { return (size + 63) & ~size_t(63); }
+  Header *getHeader() { return reinterpret_cast<Header *>(base); }
+
+  std::string name;
+  uint8_t *base;
+  size_t size;
+  bool owner;
+};
+
+} // namespace shm
+} // namespace cosim
+} // namespace runtime
+} // namespace esi
@@ -18,11 +18,13 @@
 #include "circt/Support/LLVM.h"
 #include "circt/Support/PrettyPrinterHelpers.h"
 #include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/Tools/mlir-translate/Translation.h"
 #include "llvm/ADT/APSInt.h"
 #include "llvm/ADT/StringSet.h"
 #include "llvm/ADT/TypeSwitch.h"
 #include "llvm/Support/Debug.h"
+#include <atomic>
 
 #define DEBUG_TYPE "export-firrtl"
 
@@ -43,8 +45,10 @@ constexpr size_t defaultTargetLineLength = 80;
 /// An emitter for FIRRTL dialect operations to .fir output.
 struct Emitter {
   Emitter(llvm::raw_ostream &os,
-          size_t targetLineLength = defaultTargetLineLength)
-      : pp(os, targetLineLength), ps(pp, saver) {
+          size_t targetLineLength = defaultTargetLineLength,
+          uint32_t baseIndent = 0)
+      : os(os), targetLineLength(targetLineLength),
+        pp(os, targetLineLength, baseIndent), ps(pp, saver) {
     pp.setListener(&saver);
   }
   LogicalResult finalize();
@@ -260,6 +264,11 @@ private:
   void startStatement() { emitPendingNewlineIfNeeded(); }
 
 private:
+  /// The output stream and target line length, used by the emitters of the
+  /// modules of a circuit.
+  llvm::raw_ostream &os;
+  size_t targetLineLength;
+
   /// String storage backing Tokens built from temporary strings.
   /// PrettyPrinter will clear this as appropriate.
   TokenStringSaver saver;
@@ -294,34 +303,55 @@ private:
     valueNames.insert({value, it.first->getKey()});
   }
 
-  /// The current circuit namespace valid within the call to `emitCircuit`.
-  CircuitNamespace circuitNamespace;
+  /// The namespace of the names emitted in the current module, used to name
+  /// invalid values.
+  Namespace moduleNamespace;
 };
 } // namespace
 
 LogicalResult Emitter::finalize() { return failure(encounteredError); }
 
 /// Emit an entire circuit.
+///
+/// The modules are independent of each other, so each of them is emitted in
+/// parallel into its own buffer by a separate emitter, indented within the
+/// circuit. The buffers are then written out in order.
 void Emitter::emitCircuit(CircuitOp op) {
-  circuitNamespace.add(op);
   startStatement();
   ps << "circuit " << PPExtString(op.getName()) << " :";
-  setPendingNewline();
-  ps.scopedBox(PP::bbox2, [&]() {
-    for (auto &bodyOp : *op.getBodyBlock()) {
-      if (encounteredError)
-        break;
-      TypeSwitch<Operation *>(&bodyOp)
-          .Case<FModuleOp, FExtModuleOp>([&](auto op) {
-            emitModule(op);
-            ps << PP::newline;
-          })
-          .Default([&](auto op) {
-            emitOpError(op, "not supported for emission inside circuit");
-          });
-    }
+
+  SmallVector<Operation *> modules;
+  for (auto &bodyOp : *op.getBodyBlock()) {
+    if (isa<FModuleOp, FExtModuleOp>(bodyOp))
+      modules.push_back(&bodyOp);
+    else
+      emitOpError(&bodyOp, "not supported for emission inside circuit");
+  }
+  if (modules.empty() || encounteredError) {
+    setPendingNewline();
+    return;
+  }
+
+  SmallVector<std::string> buffers(modules.size());
+  std::atomic<bool> anyModuleFailed{false};
+  mlir::parallelFor(op.getContext(), 0, modules.size(), [&](size_t index) {
+    llvm::raw_string_ostream moduleOS(buffers[index]);
+    Emitter emitter(moduleOS, targetLineLength, /*baseIndent=*/2);
+    TypeSwitch<Operation *>(modules[index])
+        .Case<FModuleOp, FExtModuleOp>(
+            [&](auto module) { emitter.emitModule(module); });
+    emitter.ps << PP::newline;
+    if (emitter.encounteredError)
+      anyModuleFailed = true;
   });
-  circuitNamespace.clear();
+  encounteredError |= anyModuleFailed;
+
+  // Flush the circuit header before writing out the modules, which are
+  // separated by an empty line.
+  ps << PP::newline;
+  pp.eof();
+  llvm::interleave(buffers, os, "\n");
+  setPendingNewline();
 }
 
 /// Emit an entire module.
@@ -337,11 +367,21 @@ void Emitter::emitModule(FModuleOp op) {
     if (!ports.empty() && !op.getBodyBlock()->empty())
       ps << PP::newline;
 
+    // Reserve the names of the ports and declarations of the module, such
+    // that the names of invalid values don't collide with them.
+    for (auto &port : ports)
+      moduleNamespace.newName(port.name.getValue());
+    op.walk([&](Operation *op) {
+      if (auto name = op->getAttrOfType<StringAttr>("name"))
+        moduleNamespace.newName(name.getValue());
+    });
+
     // Emit the module body.
     emitStatementsInBlock(*op.getBodyBlock());
   });
   valueNames.clear();
   valueNamesStorage.clear();
+  moduleNamespace.clear();
 }
 
 /// Emit an external module.
@@ -825,7 +865,7 @@ void Emitter::emitStatement(InvalidValueOp op) {
 
   // TODO: emitAssignLike ?
   startStatement();
-  auto name = circuitNamespace.newName("_invalid");
+  auto name = moduleNamespace.newName("_invalid");
   addValueName(op, name);
   ps << "wire " << PPExtString(name) << " : ";
   emitType(op.getType());
@@ -14,6 +14,7 @@
 #include "circt/Dialect/FIRRTL/AnnotationDetails.h"
 #include "circt/Dialect/FIRRTL/FIRRTLUtils.h"
 #include "mlir/IR/ImplicitLocOpBuilder.h"
+#include "mlir/IR/Threading.h"
 #include "llvm/Support/Debug.h"
 
 #define DEBUG_TYPE "lower-annos"
@@ -373,13 +374,32 @@ InstanceOp firrtl::addPortsToModule(
 
 void AnnoTargetCache::gatherTargets(FModuleLike mod) {
   // Add ports
-  for (const auto &p : llvm::enumerate(mod.getPorts()))
-    insertPort(mod, p.index());
+  for (size_t portNo = 0, e = getNumPorts(mod); portNo != e; ++portNo)
+    insertPort(mod, portNo);
 
   // And named things
   mod.walk([&](Operation *op) { insertOp(op); });
 }
 
+//===----------------------------------------------------------------------===//
+// CircuitTargetCache
+//===----------------------------------------------------------------------===//
+
+void CircuitTargetCache::populate(CircuitOp circuit) {
+  SmallVector<FModuleLike> modules;
+  for (auto module : circuit.getBodyBlock()->getOps<FModuleLike>())
+    if (!targetCaches.count(module))
+      modules.push_back(module);
+
+  // Walking a module only reads the IR, so the caches can be built
+  // independently and then moved into the map.
+  SmallVector<std::optional<AnnoTargetCache>> caches(modules.size());
+  mlir::parallelFor(circuit.getContext(), 0, modules.size(),
+                    [&](size_t i) { caches[i].emplace(modules[i]); });
+  for (auto [module, cache] : llvm::zip(modules, caches))
+    targetCaches.try_emplace(module, std::move(*cache));
+}
+
 //===----------------------------------------------------------------------===//
 // Code related to handling Grand Central Data/Mem Taps annotations
 //===----------------------------------------------------------------------===//
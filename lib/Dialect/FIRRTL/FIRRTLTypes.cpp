@@ -1117,9 +1117,17 @@ struct circt::firrtl::detail::BundleTypeStorage
                                                           false, false} {
     uint64_t fieldID = 0;
     fieldIDs.reserve(elements.size());
+    bitWidth = ignoreFlipBitWidth = 0;
     for (auto &element : elements) {
       auto type = element.type;
       auto eltInfo = type.getRecursiveTypeProperties();
+      auto eltWidth = getBitWidth(type);
+      if (ignoreFlipBitWidth)
+        ignoreFlipBitWidth = eltWidth ? *ignoreFlipBitWidth + *eltWidth
+                                      : std::optional<int64_t>();
+      if (bitWidth)
+        bitWidth = eltWidth && !element.isFlip ? *bitWidth + *eltWidth
+                                               : std::optional<int64_t>();
       props.isPassive &= eltInfo.isPassive & !element.isFlip;
       props.containsAnalog |= eltInfo.containsAnalog;
       props.containsReference |= eltInfo.containsReference;
@@ -1154,6 +1162,10 @@ struct circt::firrtl::detail::BundleTypeStorage
   SmallVector<uint64_t, 4> fieldIDs;
   uint64_t maxFieldID;
 
+  /// The bit width of the bundle, with and without ignoring flipped elements.
+  std::optional<int64_t> bitWidth;
+  std::optional<int64_t> ignoreFlipBitWidth;
+
   /// This holds the bits for the type's recursive properties, and can hold a
   /// pointer to a passive version of the type.
   RecursiveTypeProperties props;
@@ -1312,6 +1324,10 @@ BundleType::getSubTypeByFieldID(uint64_t fieldID) {
 
 uint64_t BundleType::getMaxFieldID() { return getImpl()->maxFieldID; }
 
+std::optional<int64_t> BundleType::getBitWidth(bool ignoreFlip) {
+  return ignoreFlip ? getImpl()->ignoreFlipBitWidth : getImpl()->bitWidth;
+}
+
 std::pair<uint64_t, bool> BundleType::rootChildFieldID(uint64_t fieldID,
                                                        uint64_t index) {
   auto childRoot = getFieldID(index);
@@ -1547,8 +1563,11 @@ struct circt::firrtl::detail::FVectorTypeStorage
                      bool isConst)
       : detail::FIRRTLBaseTypeStorage(isConst), elementType(elementType),
         numElements(numElements),
-        props(elementType.getRecursiveTypeProperties()) {
+        props(elementType.getRecursiveTypeProperties()),
+        maxFieldID(numElements * (elementType.getMaxFieldID() + 1)) {
     props.containsConst |= isConst;
+    if (auto eltWidth = getBitWidth(elementType))
+      bitWidth = *eltWidth * numElements;
   }
 
   bool operator==(const KeyTy &key) const {
@@ -1569,6 +1588,9 @@ struct circt::firrtl::detail::FVectorTypeStorage
   /// pointer to a passive version of the type.
   RecursiveTypeProperties props;
   FIRRTLBaseType passiveType;
+
+  uint64_t maxFieldID;
+  std::optional<int64_t> bitWidth;
 };
 
 FVectorType FVectorType::get(FIRRTLBaseType elementType, size_t numElements,
@@ -1644,8 +1666,10 @@ FVectorType::getSubTypeByFieldID(uint64_t fieldID) {
           getIndexForFieldID(fieldID)};
 }
 
-uint64_t FVectorType::getMaxFieldID() {
-  return getNumElements() * (getElementType().getMaxFieldID() + 1);
+uint64_t FVectorType::getMaxFieldID() { return getImpl()->maxFieldID; }
+
+std::optional<int64_t> FVectorType::getBitWidth() {
+  return getImpl()->bitWidth;
 }
 
 std::pair<uint64_t, bool> FVectorType::rootChildFieldID(uint64_t fieldID,
@@ -1798,9 +1822,14 @@ struct circt::firrtl::detail::FEnumTypeStorage : detail::FIRRTLBaseTypeStorage {
     RecursiveTypeProperties props{true, false, false, isConst, false, false};
     uint64_t fieldID = 0;
     fieldIDs.reserve(elements.size());
+    std::optional<int64_t> dataWidth = 0;
     for (auto &element : elements) {
       auto type = element.type;
       auto eltInfo = type.getRecursiveTypeProperties();
+      auto eltWidth = getBitWidth(type);
+      if (dataWidth)
+        dataWidth = eltWidth ? std::max(*dataWidth, *eltWidth)
+                             : std::optional<int64_t>();
       props.isPassive &= eltInfo.isPassive;
       props.containsAnalog |= eltInfo.containsAnalog;
       props.containsConst |= eltInfo.containsConst;
@@ -1812,6 +1841,8 @@ struct circt::firrtl::detail::FEnumTypeStorage : detail::FIRRTLBaseTypeStorage {
     }
     maxFieldID = fieldID;
     recProps = props;
+    if (dataWidth)
+      bitWidth = *dataWidth + llvm::Log2_32_Ceil(elements.size());
   }
 
   bool operator==(const KeyTy &key) const {
@@ -1833,6 +1864,7 @@ struct circt::firrtl::detail::FEnumTypeStorage : detail::FIRRTLBaseTypeStorage {
   SmallVector<FEnumType::EnumElement, 4> elements;
   SmallVector<uint64_t, 4> fieldIDs;
   uint64_t maxFieldID;
+  std::optional<int64_t> bitWidth;
 
   RecursiveTypeProperties recProps;
 };
@@ -1963,6 +1995,8 @@ FEnumType::getSubTypeByFieldID(uint64_t fieldID) {
 
 uint64_t FEnumType::getMaxFieldID() { return getImpl()->maxFieldID; }
 
+std::optional<int64_t> FEnumType::getBitWidth() { return getImpl()->bitWidth; }
+
 std::pair<uint64_t, bool> FEnumType::rootChildFieldID(uint64_t fieldID,
                                                       uint64_t index) {
   auto childRoot = getFieldID(index);
@@ -2111,40 +2145,14 @@ void FIRRTLDialect::registerTypes() {
 // unknown bit width.
 std::optional<int64_t> firrtl::getBitWidth(FIRRTLBaseType type,
                                            bool ignoreFlip) {
-  std::function<std::optional<int64_t>(FIRRTLBaseType)> getWidth =
-      [&](FIRRTLBaseType type) -> std::optional<int64_t> {
-    return TypeSwitch<FIRRTLBaseType, std::optional<int64_t>>(type)
-        .Case<BundleType>([&](BundleType bundle) -> std::optional<int64_t> {
-          int64_t width = 0;
-          for (auto &elt : bundle) {
-            if (elt.isFlip && !ignoreFlip)
-              return std::nullopt;
-            auto w = getBitWidth(elt.type);
-            if (!w.has_value())
-              return std::nullopt;
-            width += *w;
-          }
-          return width;
-        })
-        .Case<FEnumType>([&](FEnumType fenum) -> std::optional<int64_t> {
-          int64_t width = 0;
-          for (auto &elt : fenum) {
-            auto w = getBitWidth(elt.type);
-            if (!w.has_value())
-              return std::nullopt;
-            width = std::max(width, *w);
-          }
-          return width + llvm::Log2_32_Ceil(fenum.getNumElements());
-        })
-        .Case<FVectorType>([&](auto vector) -> std::optional<int64_t> {
-          auto w = getBitWidth(vector.getElementType());
-          if (!w.has_value())
-            return std::nullopt;
-          return *w * vector.getNumElements();
-        })
-        .Case<IntType>([&](IntType iType) { return iType.getWidth(); })
-        .Case<ClockType, ResetType, AsyncResetType>([](Type) { return 1; })
-        .Default([&](auto t) { return std::nullopt; });
-  };
-  return getWidth(type);
+  // The widths of aggregates are computed once when they are uniqued.
+  return TypeSwitch<FIRRTLBaseType, std::optional<int64_t>>(type)
+      .Case<BundleType>([&](BundleType bundle) {
+        return bundle.getBitWidth(ignoreFlip);
+      })
+      .Case<FEnumType, FVectorType>(
+          [](auto aggregate) { return aggregate.getBitWidth(); })
+      .Case<IntType>([&](IntType iType) { return iType.getWidth(); })
+      .Case<ClockType, ResetType, AsyncResetType>([](Type) { return 1; })
+      .Default([&](auto t) { return std::nullopt; });
 }
@@ -691,7 +691,7 @@ std::pair<bool, std::optional<mlir::LocationAttr>>
 circt::firrtl::maybeStringToLocation(StringRef spelling, bool skipParsing,
                                      StringAttr &locatorFilenameCache,
                                      FileLineColLoc &fileLineColLocCache,
-                                     MLIRContext *context) {
+                                     MLIRContext *context, bool dropColumns) {
   // The spelling of the token looks something like "@[Decoupled.scala 221:8]".
   if (!spelling.startswith("@[") || !spelling.endswith("]"))
     return {false, std::nullopt};
@@ -746,6 +746,8 @@ circt::firrtl::maybeStringToLocation(StringRef spelling, bool skipParsing,
   /// caching to reduce thrasing the MLIRContext.
   auto getFileLineColLoc = [&](StringRef filename, unsigned lineNo,
                                unsigned columnNo) -> FileLineColLoc {
+    if (dropColumns)
+      columnNo = 0;
     // Check our single-entry cache for this filename.
     StringAttr filenameId = locatorFilenameCache;
     if (filenameId.str() != filename) {
@@ -799,6 +801,8 @@ circt::firrtl::maybeStringToLocation(StringRef spelling, bool skipParsing,
     spaceLoc = filename.find_last_of(' ');
   }
 
+  // Fusing the locations drops duplicates, such as the parts of a compound
+  // locator on the same line once the columns are dropped.
   mlir::LocationAttr result = getFileLineColLoc(filename, lineNo, columnNo);
   if (!extraLocs.empty()) {
     extraLocs.push_back(result);
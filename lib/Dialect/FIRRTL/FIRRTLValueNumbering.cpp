@@ -0,0 +1,78 @@
+//===- FIRRTLValueNumbering.cpp - Dense SSA value numbering -----*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the FIRRTL Value Numbering Analysis.  Modules are numbered
+// in parallel, and the per-module numbers are then laid out back to back.
+//
+//===----------------------------------------------------------------------===//
+
+#include "circt/Dialect/FIRRTL/FIRRTLValueNumbering.h"
+#include "mlir/IR/Threading.h"
+
+using namespace circt;
+using namespace firrtl;
+
+ValueNumbering::ValueNumbering(Operation *operation) {
+  auto circuit = cast<CircuitOp>(operation);
+  SmallVector<FModuleOp, 0> fmodules(
+      circuit.getBodyBlock()->getOps<FModuleOp>());
+  modules.resize(fmodules.size());
+
+  mlir::parallelFor(circuit.getContext(), 0, fmodules.size(), [&](size_t i) {
+    auto &numbering = modules[i];
+    auto add = [&](Value value) {
+      numbering.localNumbers.insert({value, numbering.count++});
+    };
+    for (auto port : fmodules[i].getBodyBlock()->getArguments())
+      add(port);
+    fmodules[i].getBodyBlock()->walk<mlir::WalkOrder::PreOrder>(
+        [&](Operation *op) {
+          for (auto result : op->getResults())
+            add(result);
+          for (auto &region : op->getRegions())
+            for (auto &block : region)
+              for (auto arg : block.getArguments())
+                add(arg);
+        });
+  });
+
+  for (auto [i, fmodule] : llvm::enumerate(fmodules)) {
+    moduleIndices.insert({fmodule, i});
+    modules[i].begin = numValues;
+    numValues += modules[i].size();
+  }
+}
+
+std::optional<unsigned> ValueNumbering::getModuleIndexFor(Value value) const {
+  auto *region = value.getParentRegion();
+  if (!region)
+    return std::nullopt;
+  auto fmodule = region->getParentOfType<FModuleOp>();
+  if (!fmodule)
+    return std::nullopt;
+  auto it = moduleIndices.find(fmodule);
+  if (it == moduleIndices.end())
+    return std::nullopt;
+  return it->second;
+}
+
+std::optional<unsigned> ValueNumbering::lookup(Value value) const {
+  auto index = getModuleIndexFor(value);
+  if (!index)
+    return std::nullopt;
+  auto &numbering = modules[*index];
+  auto local = numbering.lookupLocal(value);
+  if (!local)
+    return std::nullopt;
+  return numbering.begin + *local;
+}
+
+void ValueNumbering::erase(Value value) {
+  if (auto index = getModuleIndexFor(value))
+    modules[*index].localNumbers.erase(value);
+}
@@ -39,14 +39,18 @@ bool circt::firrtl::fromOMIRJSON(json::Value &value, StringRef circuitTarget,
     return false;
   }
 
+  auto nodes = convertJSONToAttribute(context, value, path).cast<ArrayAttr>();
+  annotations.push_back(createOMIRAnnotation(nodes));
+  return true;
+}
+
+/// Wrap an array of OMNodes in an OMIRAnnotation.
+DictionaryAttr circt::firrtl::createOMIRAnnotation(ArrayAttr nodes) {
+  auto *context = nodes.getContext();
   NamedAttrList omirAnnoFields;
   omirAnnoFields.append("class", StringAttr::get(context, omirAnnoClass));
-  omirAnnoFields.append("nodes", convertJSONToAttribute(context, value, path));
-
-  DictionaryAttr omirAnno = DictionaryAttr::get(context, omirAnnoFields);
-  annotations.push_back(omirAnno);
-
-  return true;
+  omirAnnoFields.append("nodes", nodes);
+  return DictionaryAttr::get(context, omirAnnoFields);
 }
 
 /// Deserialize a JSON value into FIRRTL Annotations.  Annotations are
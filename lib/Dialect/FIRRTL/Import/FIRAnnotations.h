@@ -39,6 +39,9 @@ bool fromOMIRJSON(llvm::json::Value &value, StringRef circuitTarget,
                   SmallVectorImpl<Attribute> &annotations,
                   llvm::json::Path path, MLIRContext *context);
 
+/// Wrap an array of OMNodes in an OMIRAnnotation.
+DictionaryAttr createOMIRAnnotation(ArrayAttr nodes);
+
 bool fromJSONRaw(llvm::json::Value &value, StringRef circuitTarget,
                  SmallVectorImpl<Attribute> &annotations, llvm::json::Path path,
                  MLIRContext *context);
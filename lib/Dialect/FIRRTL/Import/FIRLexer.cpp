@@ -12,6 +12,8 @@
 
 #include "FIRLexer.h"
 #include "mlir/IR/Diagnostics.h"
+#include "mlir/IR/Threading.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/Support/SourceMgr.h"
@@ -555,3 +557,92 @@ FIRToken FIRLexer::lexNumber(const char *tokStart) {
     ++curPtr;
   return formToken(FIRToken::version, tokStart);
 }
+
+//===----------------------------------------------------------------------===//
+// FIRModuleBoundaryIndex
+//===----------------------------------------------------------------------===//
+
+FIRModuleBoundaryIndex::FIRModuleBoundaryIndex(MLIRContext *context,
+                                               StringRef buffer)
+    : bufferEnd(buffer.end()) {
+  // These must agree with `getIndentation` and `lexIdentifierOrKeyword`.
+  auto isHorizontalWS = [](char c) {
+    return c == ' ' || c == '\t' || c == ',';
+  };
+  auto isVerticalWS = [](char c) {
+    return c == '\n' || c == '\r' || c == '\f' || c == '\v';
+  };
+  auto isIdChar = [](char c) {
+    return llvm::isAlpha(c) || llvm::isDigit(c) || c == '_' || c == '$' ||
+           c == '-';
+  };
+
+  // Split the buffer into chunks of whole lines. Each line belongs to the
+  // chunk its first character is in.
+  constexpr size_t chunkSize = 1 << 20;
+  size_t numChunks = (buffer.size() + chunkSize - 1) / chunkSize;
+  struct Chunk {
+    std::vector<Boundary> boundaries;
+    std::vector<const char *> annotations;
+  };
+  std::vector<Chunk> chunks(numChunks);
+
+  auto findLineStart = [&](const char *ptr) {
+    while (ptr != buffer.begin() && ptr != buffer.end() &&
+           !isVerticalWS(ptr[-1]))
+      ++ptr;
+    return ptr;
+  };
+  mlir::parallelFor(context, 0, numChunks, [&](size_t chunkIdx) {
+    auto &chunk = chunks[chunkIdx];
+    const char *ptr = findLineStart(buffer.begin() + chunkIdx * chunkSize);
+    const char *chunkEnd = findLineStart(
+        buffer.begin() + std::min(buffer.size(), (chunkIdx + 1) * chunkSize));
+    while (ptr != chunkEnd) {
+      // Determine the indentation and first token of this line.
+      const char *lineStart = ptr;
+      while (ptr != buffer.end() && isHorizontalWS(*ptr))
+        ++ptr;
+      StringRef rest(ptr, buffer.end() - ptr);
+      for (StringRef keyword : {"module", "extmodule"}) {
+        if (rest.startswith(keyword) &&
+            (rest.size() == keyword.size() || !isIdChar(rest[keyword.size()])))
+          chunk.boundaries.push_back(
+              {ptr, static_cast<unsigned>(ptr - lineStart)});
+      }
+
+      // Move to the next line, taking note of any inline annotations.
+      while (ptr != buffer.end() && !isVerticalWS(*ptr)) {
+        if (*ptr == '%' && ptr + 1 != buffer.end() && ptr[1] == '[')
+          chunk.annotations.push_back(ptr);
+        ++ptr;
+      }
+      if (ptr != buffer.end())
+        ++ptr;
+    }
+  });
+
+  for (auto &chunk : chunks) {
+    boundaries.insert(boundaries.end(), chunk.boundaries.begin(),
+                      chunk.boundaries.end());
+    annotations.insert(annotations.end(), chunk.annotations.begin(),
+                       chunk.annotations.end());
+  }
+}
+
+const char *FIRModuleBoundaryIndex::findNext(const char *ptr,
+                                             unsigned indent) const {
+  auto it = llvm::partition_point(
+      boundaries, [&](const Boundary &boundary) { return boundary.ptr < ptr; });
+  while (it != boundaries.end() && it->indent != indent)
+    ++it;
+  const char *next = it != boundaries.end() ? it->ptr : bufferEnd;
+
+  // An inline annotation can span multiple lines and may hide a module
+  // keyword, or make one appear to be at the start of a line.
+  auto annoIt = llvm::partition_point(
+      annotations, [&](const char *anno) { return anno < ptr; });
+  if (annoIt != annotations.end() && *annoIt < next)
+    return nullptr;
+  return next;
+}
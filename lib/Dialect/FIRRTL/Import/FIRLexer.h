@@ -16,6 +16,7 @@
 #include "circt/Support/LLVM.h"
 #include "mlir/IR/BuiltinAttributes.h"
 #include "llvm/Support/SourceMgr.h"
+#include <vector>
 
 namespace mlir {
 class MLIRContext;
@@ -117,6 +118,13 @@ public:
   /// Get an opaque pointer into the lexer state that can be restored later.
   FIRLexerCursor getCursor() const;
 
+  /// Move the lexer to the specified position in the current buffer and lex
+  /// the token there. The position must not be in the middle of a token.
+  void resetPointer(const char *ptr) {
+    curPtr = ptr;
+    lexToken();
+  }
+
 private:
   FIRToken lexTokenImpl();
 
@@ -169,6 +177,34 @@ inline FIRLexerCursor FIRLexer::getCursor() const {
   return FIRLexerCursor(*this);
 }
 
+/// An index of the lines in a .fir buffer that start with a `module` or
+/// `extmodule` keyword. This allows the parser to skip over module bodies
+/// without lexing them, since the only token that can span multiple lines is
+/// an inline annotation. The buffer is scanned in parallel chunks.
+class FIRModuleBoundaryIndex {
+public:
+  /// Index the given buffer, which must be the entire buffer being lexed.
+  FIRModuleBoundaryIndex(mlir::MLIRContext *context, StringRef buffer);
+
+  /// Return the first `module` or `extmodule` keyword at or after `ptr` that
+  /// is the first token on its line and has the given indentation, or the end
+  /// of the buffer if there is none. Returns null if an inline annotation may
+  /// be in the way, in which case the caller has to lex to find the boundary.
+  const char *findNext(const char *ptr, unsigned indent) const;
+
+private:
+  /// A module keyword at the start of a line, and its indentation.
+  struct Boundary {
+    const char *ptr;
+    unsigned indent;
+  };
+
+  const char *bufferEnd;
+  std::vector<Boundary> boundaries;
+  /// The start of all `%[` character sequences in the buffer.
+  std::vector<const char *> annotations;
+};
+
 } // namespace firrtl
 } // namespace circt
 
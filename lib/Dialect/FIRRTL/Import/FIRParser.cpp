@@ -20,6 +20,7 @@
 #include "circt/Dialect/FIRRTL/FIRRTLUtils.h"
 #include "circt/Dialect/FIRRTL/Namespace.h"
 #include "circt/Dialect/HW/HWAttributes.h"
+#include "circt/Support/JSON.h"
 #include "circt/Support/LLVM.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/BuiltinTypes.h"
@@ -394,7 +395,8 @@ ParseResult FIRParser::parseOptionalInfoLocator(LocationAttr &result) {
 
   auto locationPair = maybeStringToLocation(
       spelling, constants.options.ignoreInfoLocators, locatorFilenameCache,
-      fileLineColLocCache, getContext());
+      fileLineColLocCache, getContext(),
+      constants.options.compactInfoLocators);
 
   // If parsing failed, then indicate that a weird info was found.
   if (!locationPair.first) {
@@ -3599,21 +3601,42 @@ private:
   SmallVector<DeferredModuleToParse, 0> deferredModules;
   ModuleOp mlirModule;
 
+  /// The lines starting a module, used to skip over module bodies quickly.
+  std::optional<FIRModuleBoundaryIndex> moduleBoundaries;
+
   /// Default Version to use when parsing.  Deviations from this version will
   /// cause different behavior.
   FIRVersion version;
 };
 
 } // end anonymous namespace
-ParseResult
-FIRCircuitParser::importAnnotationsRaw(SMLoc loc, StringRef circuitTarget,
-                                       StringRef annotationsStr,
-                                       SmallVectorImpl<Attribute> &attrs) {
+
+/// Extract Annotations from a JSON-encoded Annotation array string and add
+/// them to a vector of attributes. Errors are reported through `emitError`.
+static LogicalResult importAnnotationsRaw(
+    MLIRContext *context, StringRef circuitTarget, StringRef annotationsStr,
+    SmallVectorImpl<Attribute> &attrs,
+    llvm::function_ref<InFlightDiagnostic(const Twine &)> emitError) {
+
+  // Convert the annotations directly to attributes while parsing. This avoids
+  // holding the entire JSON document in memory, which dominates for large
+  // annotation files. If anything is wrong with the annotations, discard the
+  // partial result and go through `llvm::json` to produce a diagnostic.
+  auto numAttrs = attrs.size();
+  if (succeeded(parseJSONArrayToAttributes(
+          context, annotationsStr, [&](Attribute attr) {
+            if (!attr.isa<DictionaryAttr>())
+              return failure();
+            attrs.push_back(attr);
+            return success();
+          })))
+    return success();
+  attrs.truncate(numAttrs);
 
   auto annotations = json::parse(annotationsStr);
   if (auto err = annotations.takeError()) {
     handleAllErrors(std::move(err), [&](const json::ParseError &a) {
-      auto diag = emitError(loc, "Failed to parse JSON Annotations");
+      auto diag = emitError("Failed to parse JSON Annotations");
       diag.attachNote() << a.message();
     });
     return failure();
@@ -3621,9 +3644,8 @@ FIRCircuitParser::importAnnotationsRaw(SMLoc loc, StringRef circuitTarget,
 
   json::Path::Root root;
   llvm::StringMap<ArrayAttr> thisAnnotationMap;
-  if (!fromJSONRaw(annotations.get(), circuitTarget, attrs, root,
-                   getContext())) {
-    auto diag = emitError(loc, "Invalid/unsupported annotation format");
+  if (!fromJSONRaw(annotations.get(), circuitTarget, attrs, root, context)) {
+    auto diag = emitError("Invalid/unsupported annotation format");
     std::string jsonErrorMessage =
         "See inline comments for problem area in JSON:\n";
     llvm::raw_string_ostream s(jsonErrorMessage);
@@ -3635,24 +3657,33 @@ FIRCircuitParser::importAnnotationsRaw(SMLoc loc, StringRef circuitTarget,
   return success();
 }
 
-ParseResult FIRCircuitParser::importOMIR(CircuitOp circuit, SMLoc loc,
-                                         StringRef circuitTarget,
-                                         StringRef annotationsStr,
-                                         SmallVectorImpl<Attribute> &annos) {
+/// Generate OMIR-derived annotations from a JSON-encoded OMIR string and add
+/// them to a vector of attributes. Errors are reported through `emitError`.
+static LogicalResult
+importOMIR(MLIRContext *context, StringRef circuitTarget,
+           StringRef annotationsStr, SmallVectorImpl<Attribute> &annos,
+           llvm::function_ref<InFlightDiagnostic(const Twine &)> emitError) {
+
+  // As for annotations, avoid building the JSON document if the OMIR is
+  // well-formed.
+  if (auto nodes = parseJSONToAttribute(context, annotationsStr)
+                       .dyn_cast_or_null<ArrayAttr>()) {
+    annos.push_back(createOMIRAnnotation(nodes));
+    return success();
+  }
 
   auto annotations = json::parse(annotationsStr);
   if (auto err = annotations.takeError()) {
     handleAllErrors(std::move(err), [&](const json::ParseError &a) {
-      auto diag = emitError(loc, "Failed to parse OMIR file");
+      auto diag = emitError("Failed to parse OMIR file");
       diag.attachNote() << a.message();
     });
     return failure();
   }
 
   json::Path::Root root;
-  if (!fromOMIRJSON(annotations.get(), circuitTarget, annos, root,
-                    circuit.getContext())) {
-    auto diag = emitError(loc, "Invalid/unsupported OMIR format");
+  if (!fromOMIRJSON(annotations.get(), circuitTarget, annos, root, context)) {
+    auto diag = emitError("Invalid/unsupported OMIR format");
     std::string jsonErrorMessage =
         "See inline comments for problem area in JSON:\n";
     llvm::raw_string_ostream s(jsonErrorMessage);
@@ -3664,6 +3695,24 @@ ParseResult FIRCircuitParser::importOMIR(CircuitOp circuit, SMLoc loc,
   return success();
 }
 
+ParseResult
+FIRCircuitParser::importAnnotationsRaw(SMLoc loc, StringRef circuitTarget,
+                                       StringRef annotationsStr,
+                                       SmallVectorImpl<Attribute> &attrs) {
+  return failed(::importAnnotationsRaw(
+      getContext(), circuitTarget, annotationsStr, attrs,
+      [&](const Twine &message) { return emitError(loc, message); }));
+}
+
+ParseResult FIRCircuitParser::importOMIR(CircuitOp circuit, SMLoc loc,
+                                         StringRef circuitTarget,
+                                         StringRef annotationsStr,
+                                         SmallVectorImpl<Attribute> &annos) {
+  return failed(::importOMIR(
+      circuit.getContext(), circuitTarget, annotationsStr, annos,
+      [&](const Twine &message) { return emitError(loc, message); }));
+}
+
 /// pohwist ::= port*
 /// port     ::= dir id ':' type info? NEWLINE
 /// dir      ::= 'input' | 'output'
@@ -3814,8 +3863,16 @@ ParseResult FIRCircuitParser::parseModule(CircuitOp circuit,
         DeferredModuleToParse{moduleOp, portLocs, getLexer().getCursor(),
                               std::move(moduleTarget), indent});
 
-    // We're going to defer parsing this module, so just skip tokens until we
-    // get to the next module or the end of the file.
+    // We're going to defer parsing this module, so skip ahead to the next
+    // module or the end of the file. Prefer the boundary index, which avoids
+    // lexing the body, and fall back to skipping tokens if there's an inline
+    // annotation in the way.
+    if (!getToken().isAny(FIRToken::eof, FIRToken::error) && moduleBoundaries)
+      if (auto *next = moduleBoundaries->findNext(
+              getToken().getLoc().getPointer(), indent)) {
+        getLexer().resetPointer(next);
+        return success();
+      }
     while (true) {
       switch (getToken().getKind()) {
 
@@ -4151,6 +4208,16 @@ ParseResult FIRCircuitParser::parseCircuit(
   if (!annos.empty())
     circuit->setAttr(rawAnnotations, b.getArrayAttr(annos));
 
+  // Find the module boundaries up front, such that the outline of the modules
+  // can be parsed without lexing their bodies.
+  {
+    auto scanTimer = ts.nest("Scan module boundaries");
+    auto &sourceMgr = getLexer().getSourceMgr();
+    moduleBoundaries.emplace(
+        getContext(),
+        sourceMgr.getMemoryBuffer(sourceMgr.getMainFileID())->getBuffer());
+  }
+
   // A timer to get execution time of module parsing.
   auto parseTimer = ts.nest("Parse modules");
   deferredModules.reserve(16);
@@ -4282,6 +4349,51 @@ circt::firrtl::importFIRFile(SourceMgr &sourceMgr, MLIRContext *context,
   return module;
 }
 
+// Attach the annotation and OMIR files in the specified source manager to the
+// circuits of an already parsed module.
+LogicalResult
+circt::firrtl::importAnnotationFiles(llvm::SourceMgr &sourceMgr,
+                                     mlir::ModuleOp module,
+                                     unsigned numAnnotationFiles) {
+  SmallVector<const llvm::MemoryBuffer *> annotationsBufs, omirBufs;
+  unsigned fileID = 1;
+  for (unsigned e = numAnnotationFiles + 1; fileID < e; ++fileID)
+    annotationsBufs.push_back(
+        sourceMgr.getMemoryBuffer(sourceMgr.getMainFileID() + fileID));
+  for (unsigned e = sourceMgr.getNumBuffers(); fileID < e; ++fileID)
+    omirBufs.push_back(
+        sourceMgr.getMemoryBuffer(sourceMgr.getMainFileID() + fileID));
+  if (annotationsBufs.empty() && omirBufs.empty())
+    return success();
+
+  for (auto circuit : module.getOps<CircuitOp>()) {
+    auto *context = circuit.getContext();
+    std::string circuitTarget = ("~" + circuit.getName()).str();
+    auto emitError = [&](const Twine &message) {
+      return circuit.emitError(message);
+    };
+
+    // Append the annotations to any raw annotations already present on the
+    // circuit, just like the annotation files of a .fir file are appended to
+    // its inline annotations.
+    SmallVector<Attribute> annos;
+    if (auto existing = circuit->getAttrOfType<ArrayAttr>(rawAnnotations))
+      annos.append(existing.begin(), existing.end());
+    for (auto *annotationsBuf : annotationsBufs)
+      if (failed(::importAnnotationsRaw(context, circuitTarget,
+                                        annotationsBuf->getBuffer(), annos,
+                                        emitError)))
+        return failure();
+    for (auto *omirBuf : omirBufs)
+      if (failed(::importOMIR(context, circuitTarget, omirBuf->getBuffer(),
+                              annos, emitError)))
+        return failure();
+    if (!annos.empty())
+      circuit->setAttr(rawAnnotations, ArrayAttr::get(context, annos));
+  }
+  return success();
+}
+
 void circt::firrtl::registerFromFIRFileTranslation() {
   static mlir::TranslateToMLIRRegistration fromFIR(
       "import-firrtl", "import .fir",
@@ -31,7 +31,30 @@ NLATable::NLATable(Operation *operation) {
   }
 }
 
+void NLATable::compact(StringAttr mod) {
+  auto removals = pendingRemovals.find(mod);
+  if (removals == pendingRemovals.end())
+    return;
+  auto iter = nodeMap.find(mod);
+  if (iter != nodeMap.end()) {
+    auto &nlas = iter->second;
+    auto oldSize = nlas.size();
+    llvm::erase_if(nlas, [&](auto nla) { return removals->second.count(nla); });
+    ++numCompactions;
+    numCompactedEntries += oldSize - nlas.size();
+  }
+  pendingRemovals.erase(removals);
+}
+
+void NLATable::addNLAtoModule(hw::HierPathOp nla, StringAttr mod) {
+  auto removals = pendingRemovals.find(mod);
+  if (removals != pendingRemovals.end() && removals->second.count(nla))
+    compact(mod);
+  nodeMap[mod].push_back(nla);
+}
+
 ArrayRef<hw::HierPathOp> NLATable::lookup(StringAttr name) {
+  compact(name);
   auto iter = nodeMap.find(name);
   if (iter == nodeMap.end())
     return {};
@@ -59,9 +82,9 @@ void NLATable::addNLA(hw::HierPathOp nla) {
   symToOp[nla.getSymNameAttr()] = nla;
   for (auto ent : nla.getNamepath()) {
     if (auto mod = ent.dyn_cast<FlatSymbolRefAttr>())
-      nodeMap[mod.getAttr()].push_back(nla);
+      addNLAtoModule(nla, mod.getAttr());
     else if (auto inr = ent.dyn_cast<hw::InnerRefAttr>())
-      nodeMap[inr.getModule()].push_back(nla);
+      addNLAtoModule(nla, inr.getModule());
   }
 }
 
@@ -69,9 +92,9 @@ void NLATable::erase(hw::HierPathOp nla, SymbolTable *symbolTable) {
   symToOp.erase(nla.getSymNameAttr());
   for (auto ent : nla.getNamepath())
     if (auto mod = ent.dyn_cast<FlatSymbolRefAttr>())
-      llvm::erase_value(nodeMap[mod.getAttr()], nla);
+      removeNLAfromModule(nla, mod.getAttr());
     else if (auto inr = ent.dyn_cast<hw::InnerRefAttr>())
-      llvm::erase_value(nodeMap[inr.getModule()], nla);
+      removeNLAfromModule(nla, inr.getModule());
   if (symbolTable)
     symbolTable->erase(nla);
 }
@@ -79,13 +102,14 @@ void NLATable::erase(hw::HierPathOp nla, SymbolTable *symbolTable) {
 void NLATable::updateModuleInNLA(hw::HierPathOp nlaOp, StringAttr oldModule,
                                  StringAttr newModule) {
   nlaOp.updateModule(oldModule, newModule);
+  compact(oldModule);
   auto &nlas = nodeMap[oldModule];
   auto *iter = std::find(nlas.begin(), nlas.end(), nlaOp);
   if (iter != nlas.end()) {
     nlas.erase(iter);
     if (nlas.empty())
       nodeMap.erase(oldModule);
-    nodeMap[newModule].push_back(nlaOp);
+    addNLAtoModule(nlaOp, newModule);
   }
 }
 
@@ -101,15 +125,19 @@ void NLATable::renameModule(StringAttr oldModName, StringAttr newModName) {
   auto op = symToOp.find(oldModName);
   if (op == symToOp.end())
     return;
+  compact(oldModName);
   auto iter = nodeMap.find(oldModName);
   if (iter == nodeMap.end())
     return;
   for (auto nla : iter->second)
     nla.updateModule(oldModName, newModName);
-  nodeMap[newModName] = iter->second;
-  nodeMap.erase(oldModName);
-  symToOp[newModName] = op->second;
-  symToOp.erase(oldModName);
+  auto nlas = std::move(iter->second);
+  nodeMap.erase(iter);
+  nodeMap[newModName] = std::move(nlas);
+  pendingRemovals.erase(newModName);
+  auto *moduleOp = op->second;
+  symToOp.erase(op);
+  symToOp[newModName] = moduleOp;
 }
 
 void NLATable::renameModuleAndInnerRef(
@@ -118,10 +146,19 @@ void NLATable::renameModuleAndInnerRef(
 
   if (newModName == oldModName)
     return;
-  for (auto nla : lookup(oldModName)) {
+  compact(oldModName);
+  auto iter = nodeMap.find(oldModName);
+  if (iter == nodeMap.end())
+    return;
+  auto nlas = std::move(iter->second);
+  nodeMap.erase(iter);
+
+  // Move the NLAs over in one batch, after dropping any stale entries from the
+  // list of the new module.
+  compact(newModName);
+  auto &newNLAs = nodeMap[newModName];
+  for (auto nla : nlas) {
     nla.updateModuleAndInnerRef(oldModName, newModName, innerSymRenameMap);
-    nodeMap[newModName].push_back(nla);
+    newNLAs.push_back(nla);
   }
-  nodeMap.erase(oldModName);
-  return;
 }
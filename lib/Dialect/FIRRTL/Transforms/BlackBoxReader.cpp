@@ -23,9 +23,13 @@
 #include "circt/Dialect/SV/SVOps.h"
 #include "circt/Support/Path.h"
 #include "mlir/IR/Attributes.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/Support/FileUtilities.h"
 #include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringSet.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 
@@ -37,6 +41,13 @@ using namespace firrtl;
 using hw::OutputFileAttr;
 using sv::VerbatimOp;
 
+/// Return true if a file is a Verilog header, which is expected to be included
+/// by compiler directives in other source files.
+static bool isHeaderFile(StringRef fileName) {
+  auto ext = llvm::sys::path::extension(fileName);
+  return ext == ".h" || ext == ".vh" || ext == ".svh";
+}
+
 //===----------------------------------------------------------------------===//
 // Pass Implementation
 //===----------------------------------------------------------------------===//
@@ -47,12 +58,22 @@ struct BlackBoxReaderPass : public BlackBoxReaderBase<BlackBoxReaderPass> {
   bool runOnAnnotation(Operation *op, Annotation anno, OpBuilder &builder,
                        bool isCover);
   VerbatimOp loadFile(Operation *op, StringRef inputPath, OpBuilder &builder);
+  void readInputFiles(CircuitOp circuitOp);
+  bool isReferenced(Operation *op, StringRef fileName);
   void setOutputFile(VerbatimOp op, Operation *origOp, StringAttr fileNameAttr,
                      bool isCover = false);
   // Check if module or any of its parents in the InstanceGraph is a DUT.
   bool isDut(Operation *module);
 
   using BlackBoxReaderBase::inputPrefix;
+  using BlackBoxReaderBase::referencePaths;
+
+  /// Get the path to read the source file of a path annotation from.
+  SmallString<128> getInputPath(StringAttr path) {
+    SmallString<128> inputPath(inputPrefix);
+    appendPossiblyAbsolutePath(inputPath, path.getValue());
+    return inputPath;
+  }
 
 private:
   /// A set of the files generated so far. This is used to prevent two
@@ -63,6 +84,14 @@ private:
   /// subset of all emitted files.
   SmallVector<StringRef> fileListFiles;
 
+  /// The absolute paths of the source files which are referenced in place by
+  /// the file list, rather than copied into the IR.
+  SmallVector<std::string> referencedFiles;
+
+  /// The contents of the source files of path annotations, read ahead of
+  /// processing the annotations.
+  llvm::StringMap<std::unique_ptr<llvm::MemoryBuffer>> inputFiles;
+
   /// The target directory to output black boxes into. Can be changed
   /// through `firrtl.transforms.BlackBoxTargetDirAnno` annotations.
   StringRef targetDir;
@@ -175,6 +204,9 @@ void BlackBoxReaderPass::runOnOperation() {
       return signalPassFailure();
   }
 
+  // Read the source files of all path annotations up front.
+  readInputFiles(circuitOp);
+
   // Gather the relevant annotations on all modules in the circuit.
   for (auto &op : *circuitOp.getBodyBlock()) {
     if (!isa<FModuleOp>(op) && !isa<FExtModuleOp>(op))
@@ -206,9 +238,10 @@ void BlackBoxReaderPass::runOnOperation() {
   // If we have emitted any files, generate a file list operation that
   // documents the additional annotation-controlled file listing to be
   // created.
-  if (!fileListFiles.empty()) {
+  if (!fileListFiles.empty() || !referencedFiles.empty()) {
     // Output the file list in sorted order.
     llvm::sort(fileListFiles.begin(), fileListFiles.end());
+    llvm::sort(referencedFiles.begin(), referencedFiles.end());
 
     // Create the file list contents by prepending the file name with the target
     // directory, and putting each file on its own line.
@@ -223,6 +256,11 @@ void BlackBoxReaderPass::runOnOperation() {
           os << filePath;
         },
         "\n");
+    // The referenced files are listed by their absolute path after the files
+    // generated in the target directory.
+    if (!fileListFiles.empty() && !referencedFiles.empty())
+      os << "\n";
+    llvm::interleave(referencedFiles, os, "\n");
 
     // Put the file list in to a verbatim op.  Use "unknown location" so that no
     // file info will unnecessarily print.
@@ -243,6 +281,49 @@ void BlackBoxReaderPass::runOnOperation() {
   // Clean up.
   emittedFiles.clear();
   fileListFiles.clear();
+  referencedFiles.clear();
+  inputFiles.clear();
+}
+
+/// Read the source files of all path annotations in the circuit, in parallel.
+/// Source files of black boxes may be large vendor IP, such that reading them
+/// one by one while processing the annotations dominates the pass.
+void BlackBoxReaderPass::readInputFiles(CircuitOp circuitOp) {
+  SmallVector<std::string> inputPaths;
+  llvm::StringSet<> seenPaths;
+  for (auto &op : *circuitOp.getBodyBlock()) {
+    if (!isa<FModuleOp, FExtModuleOp>(op))
+      continue;
+    for (auto anno : AnnotationSet(&op)) {
+      if (!anno.isClass(blackBoxPathAnnoClass))
+        continue;
+      auto path = anno.getMember<StringAttr>("path");
+      if (!path || isReferenced(&op, llvm::sys::path::filename(path)))
+        continue;
+      auto inputPath = getInputPath(path);
+      if (seenPaths.insert(inputPath).second)
+        inputPaths.push_back(std::string(inputPath));
+    }
+  }
+
+  SmallVector<std::unique_ptr<llvm::MemoryBuffer>> buffers(inputPaths.size());
+  mlir::parallelFor(&getContext(), 0, inputPaths.size(), [&](size_t index) {
+    buffers[index] = mlir::openInputFile(inputPaths[index]);
+  });
+  for (auto [inputPath, buffer] : llvm::zip(inputPaths, buffers))
+    if (buffer)
+      inputFiles[inputPath] = std::move(buffer);
+}
+
+/// Return true if the source file of a path annotation is referenced in place
+/// by the file list rather than copied. Header files are always copied, since
+/// they are not part of the file list, and so are files with an explicit
+/// output file.
+bool BlackBoxReaderPass::isReferenced(Operation *op, StringRef fileName) {
+  if (!referencePaths || isHeaderFile(fileName))
+    return false;
+  auto outputFile = op->getAttrOfType<OutputFileAttr>("output_file");
+  return !outputFile || outputFile.isDirectory();
 }
 
 /// Run on an operation-annotation pair. The annotation need not be a black box
@@ -284,15 +365,34 @@ bool BlackBoxReaderPass::runOnAnnotation(Operation *op, Annotation anno,
       signalPassFailure();
       return true;
     }
-    SmallString<128> inputPath(inputPrefix);
-    appendPossiblyAbsolutePath(inputPath, path.getValue());
+    auto inputPath = getInputPath(path);
+    auto name = builder.getStringAttr(llvm::sys::path::filename(path));
+
+    // Reference the file in place instead of copying its contents.
+    if (isReferenced(op, name.getValue())) {
+      if (emittedFiles.count(name))
+        return true;
+      SmallString<128> absolutePath(inputPath);
+      if (!llvm::sys::fs::exists(absolutePath) ||
+          llvm::sys::fs::make_absolute(absolutePath)) {
+        op->emitError("Cannot find file ") << inputPath;
+        signalPassFailure();
+        return false;
+      }
+      llvm::sys::path::remove_dots(absolutePath, /*remove_dot_dot=*/true);
+      LLVM_DEBUG(llvm::dbgs() << "Reference black box source `" << absolutePath
+                              << "`\n");
+      emittedFiles.insert(name);
+      referencedFiles.push_back(std::string(absolutePath));
+      return true;
+    }
+
     auto verbatim = loadFile(op, inputPath, builder);
     if (!verbatim) {
       op->emitError("Cannot find file ") << inputPath;
       signalPassFailure();
       return false;
     }
-    auto name = builder.getStringAttr(llvm::sys::path::filename(path));
     setOutputFile(verbatim, op, name, isCover);
     return true;
   }
@@ -314,16 +414,18 @@ VerbatimOp BlackBoxReaderPass::loadFile(Operation *op, StringRef inputPath,
   if (emittedFiles.count(fileNameAttr))
     return {};
 
-  // Open and read the input file.
-  std::string errorMessage;
-  auto input = mlir::openInputFile(inputPath, &errorMessage);
-  if (!input)
+  // Look up the contents of the input file, which have been read ahead.
+  auto input = inputFiles.find(inputPath);
+  if (input == inputFiles.end())
     return {};
 
   // Create an IR node to hold the contents.  Use "unknown location" so that no
-  // file info will unnecessarily print.
-  return builder.create<VerbatimOp>(builder.getUnknownLoc(),
-                                    input->getBuffer());
+  // file info will unnecessarily print. The buffer is no longer needed once
+  // its contents are in the IR.
+  auto verbatim = builder.create<VerbatimOp>(builder.getUnknownLoc(),
+                                             input->second->getBuffer());
+  inputFiles.erase(input);
+  return verbatim;
 }
 
 /// This function is called for every file generated.  It does the following
@@ -348,8 +450,7 @@ void BlackBoxReaderPass::setOutputFile(VerbatimOp op, Operation *origOp,
   // explicitly by compiler directives in other source files.
   auto *context = &getContext();
   auto fileName = fileNameAttr.getValue();
-  auto ext = llvm::sys::path::extension(fileName);
-  bool exclude = (ext == ".h" || ext == ".vh" || ext == ".svh");
+  bool exclude = isHeaderFile(fileName);
   auto outDir = targetDir;
   // In order to output into the testbench directory, we need to have a
   // testbench dir annotation, not have a blackbox target directory annotation
@@ -411,9 +512,11 @@ bool BlackBoxReaderPass::isDut(Operation *module) {
 //===----------------------------------------------------------------------===//
 
 std::unique_ptr<mlir::Pass>
-circt::firrtl::createBlackBoxReaderPass(std::optional<StringRef> inputPrefix) {
+circt::firrtl::createBlackBoxReaderPass(std::optional<StringRef> inputPrefix,
+                                        bool referencePaths) {
   auto pass = std::make_unique<BlackBoxReaderPass>();
   if (inputPrefix)
     pass->inputPrefix = inputPrefix->str();
+  pass->referencePaths = referencePaths;
   return pass;
 }
@@ -22,7 +22,9 @@
 // 3. Start from DFS traversal from the root. Push the root to the DFS stack.
 // 4. Pop a Value from the DFS stack, add all the Values that alias with it
 //    to the Visiting set. Add all the unvisited children of the Values in the
-//    alias set to the DFS stack.
+//    alias set to the DFS stack. Each Value is given a dense node id, and its
+//    aliases and children are computed once and stored in flat arrays, such
+//    that revisiting it from another input port is cheap.
 // 5. If any child is already present in the Visiting set, then a cycle is
 //    found.
 //
@@ -33,6 +35,7 @@
 #include "circt/Dialect/FIRRTL/FIRRTLUtils.h"
 #include "circt/Dialect/FIRRTL/FIRRTLVisitors.h"
 #include "circt/Dialect/FIRRTL/Passes.h"
+#include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DepthFirstIterator.h"
 #include "llvm/ADT/PostOrderIterator.h"
@@ -47,51 +50,78 @@ using namespace firrtl;
 
 using SetOfFieldRefs = DenseSet<FieldRef>;
 
-/// A value is in VisitingSet if its subtree is still being traversed. That is,
-/// all its children have not yet been visited. If any Value is visited while
-/// its still in the `VisitingSet`, that implies a back edge and a cycle.
+/// A node is in VisitingSet if its subtree is still being traversed. That is,
+/// all its children have not yet been visited. If any node is visited while
+/// its still in the `VisitingSet`, that implies a back edge and a cycle. Nodes
+/// are identified by the dense ids assigned by `DiscoverLoops`.
 struct VisitingSet {
 private:
   /// The stack is maintained to keep track of the cycle, if one is found. This
   /// is required for an iterative DFS traversal, its implicitly recorded for a
   /// recursive version of this algorithm. Each entry in the stack is a list of
-  /// aliasing Values, which were visited at the same time.
-  SmallVector<SmallVector<Value, 2>> visitingStack;
-  /// This map of the Visiting values, is for faster query, to check if a Value
-  /// is in VisitingSet. It also records the corresponding index into the
-  /// visitingStack, for faster pop until the Value.
-  DenseMap<Value, unsigned> valToStackMap;
+  /// aliasing nodes, which were visited at the same time. The entries are
+  /// stored back to back in `stackIds`, and `entryBegins` records where each
+  /// entry starts.
+  SmallVector<unsigned> stackIds;
+  SmallVector<unsigned> entryBegins;
+  /// The index into the stack of each visiting node, indexed by node id. This
+  /// is for faster query, to check if a node is in VisitingSet, and for faster
+  /// pop until the node.
+  SmallVector<unsigned> stackPos;
+  static constexpr unsigned notVisiting = ~0u;
 
 public:
-  void appendEmpty() { visitingStack.push_back({}); }
-  void appendToEnd(SmallVector<Value> &values) {
-    auto stackSize = visitingStack.size() - 1;
-    visitingStack.back().append(values.begin(), values.end());
-    // Record the stack location where this Value is pushed.
-    llvm::for_each(values, [&](Value v) { valToStackMap[v] = stackSize; });
+  void appendEmpty() { entryBegins.push_back(stackIds.size()); }
+  void appendToEnd(ArrayRef<unsigned> ids) {
+    unsigned stackSize = entryBegins.size() - 1;
+    stackIds.append(ids.begin(), ids.end());
+    // Record the stack location where this node is pushed.
+    for (auto id : ids) {
+      if (id >= stackPos.size())
+        stackPos.resize(id + 1, notVisiting);
+      stackPos[id] = stackSize;
+    }
   }
-  bool contains(Value v) {
-    return valToStackMap.find(v) != valToStackMap.end();
+  bool contains(unsigned id) const {
+    return id < stackPos.size() && stackPos[id] != notVisiting;
   }
-  // Pop all the Values which were visited after v. Then invoke f (if present)
-  // on a popped value for each index.
-  void popUntilVal(Value v,
-                   const llvm::function_ref<void(Value poppedVal)> f = {}) {
-    auto valPos = valToStackMap[v];
-    while (visitingStack.size() != valPos) {
-      auto poppedVals = visitingStack.pop_back_val();
-      Value poppedVal;
-      llvm::for_each(poppedVals, [&](Value pv) {
-        if (!poppedVal)
-          poppedVal = pv;
-        valToStackMap.erase(pv);
-      });
-      if (f && poppedVal)
-        f(poppedVal);
+  // Pop all the nodes which were visited after id. Then invoke f (if present)
+  // on a popped node for each index.
+  void popUntilVal(unsigned id,
+                   const llvm::function_ref<void(unsigned poppedId)> f = {}) {
+    unsigned valPos = contains(id) ? stackPos[id] : 0;
+    while (entryBegins.size() != valPos) {
+      unsigned begin = entryBegins.pop_back_val();
+      for (auto pv : ArrayRef(stackIds).drop_front(begin))
+        stackPos[pv] = notVisiting;
+      bool isEmpty = begin == stackIds.size();
+      unsigned poppedId = isEmpty ? 0 : stackIds[begin];
+      stackIds.truncate(begin);
+      if (f && !isEmpty)
+        f(poppedId);
     }
   }
 };
 
+/// The entries of a node in one of the flat arrays of `DiscoverLoops`.
+struct NodeRange {
+  unsigned begin = 0, end = 0;
+
+  template <typename T>
+  ArrayRef<T> slice(const SmallVectorImpl<T> &storage) const {
+    return ArrayRef<T>(storage).slice(begin, end - begin);
+  }
+
+  template <typename T, typename RangeT>
+  static NodeRange append(SmallVectorImpl<T> &storage, const RangeT &values) {
+    NodeRange range;
+    range.begin = storage.size();
+    storage.append(values.begin(), values.end());
+    range.end = storage.size();
+    return range;
+  }
+};
+
 class DiscoverLoops {
 
 public:
@@ -107,21 +137,13 @@ public:
     // get the paths that exist between the ports of the referenced module.
     preprocess(worklist);
 
-    llvm::DenseSet<Value> visited;
     VisitingSet visiting;
-    SmallVector<Value> dfsStack;
+    SmallVector<unsigned> dfsStack;
     SmallVector<FieldRef> inputArgFields;
-    // Record all the children of Value being visited.
-    SmallVector<Value, 8> children;
-    // If this is an input port field, then record it. This is used to
-    // discover paths from input to output ports. Only the last input port
-    // that is visited on the DFS traversal is recorded.
-    SmallVector<FieldRef, 2> inputArgFieldsTemp;
-    SmallVector<Value> aliasingValues;
 
     // worklist is the list of roots, to begin the traversal from.
     for (auto root : worklist) {
-      dfsStack = {root};
+      dfsStack = {getNodeId(root)};
       inputArgFields.clear();
       LLVM_DEBUG(llvm::dbgs() << "\n Starting traversal from root :"
                               << getFieldName(FieldRef(root, 0)).first);
@@ -131,91 +153,55 @@ public:
           // If there is an overlapping path from two input ports to an output
           // port, then the already visited nodes must be re-visited to discover
           // the comb paths to the output port.
-          visited.clear();
+          visited.reset();
       }
       while (!dfsStack.empty()) {
-        auto dfsVal = dfsStack.back();
-        if (!visiting.contains(dfsVal)) {
+        auto dfsId = dfsStack.back();
+        if (!visiting.contains(dfsId)) {
           unsigned dfsSize = dfsStack.size();
 
-          LLVM_DEBUG(llvm::dbgs() << "\n Stack pop :"
-                                  << getFieldName(FieldRef(dfsVal, 0)).first
-                                  << "," << dfsVal;);
+          LLVM_DEBUG(llvm::dbgs()
+                         << "\n Stack pop :"
+                         << getFieldName(FieldRef(nodes[dfsId].value, 0)).first
+                         << "," << nodes[dfsId].value;);
+
+          // The successors of a node only depend on the IR, compute them once
+          // and reuse them when the node is visited again from another root.
+          expandNode(dfsId);
+          const Node &node = nodes[dfsId];
+
+          // If this node refers to input port fields, then record them. This
+          // is used to discover paths from input to output ports. Only the
+          // last input port that is visited on the DFS traversal is recorded.
+          auto inputArgs = node.inputArgs.slice(inputArgRefs);
+          if (!inputArgs.empty())
+            inputArgFields.assign(inputArgs.begin(), inputArgs.end());
 
           // Visiting set will contain all the values which alias with the
           // dfsVal, this is required to detect back edges to aliasing Values.
           // That is fieldRefs that can refer to the same memory location.
+          auto aliases = node.aliases.slice(aliasIds);
           visiting.appendEmpty();
-          children.clear();
-          inputArgFieldsTemp.clear();
-          // All the Values that refer to the same FieldRef are added to the
-          // aliasingValues.
-          aliasingValues = {dfsVal};
-          auto aToVIter = aliasingValuesMap.find(dfsVal);
-          if (aToVIter != aliasingValuesMap.end()) {
-            aliasingValues.append(aToVIter->getSecond().begin(),
-                                  aToVIter->getSecond().end());
-          }
-          // If `dfsVal` is a subfield, then get all the FieldRefs that it
-          // refers to and then get all the values that alias with it.
-          forallRefersTo(dfsVal, [&](FieldRef ref) {
-            // If this subfield refers to instance/mem results(input port), then
-            // add the output port FieldRefs that exist in the referenced module
-            // comb paths to the children.
-            handlePorts(ref, children);
-            // Get all the values that refer to this FieldRef, and add them to
-            // the aliasing values.
-            if (auto arg = dyn_cast<BlockArgument>(ref.getValue()))
-              if (module.getPortDirection(arg.getArgNumber()) == Direction::In)
-                inputArgFieldsTemp.push_back(ref);
-
-            return success();
-          });
-          if (!inputArgFieldsTemp.empty())
-            inputArgFields = std::move(inputArgFieldsTemp);
-
-          visiting.appendToEnd(aliasingValues);
-          visited.insert(aliasingValues.begin(), aliasingValues.end());
-          // Add the Value to `children`, to which a path exists from `dfsVal`.
-          for (auto dfsFromVal : aliasingValues) {
-
-            for (auto &use : dfsFromVal.getUses()) {
-              auto childVal =
-                  TypeSwitch<Operation *, Value>(use.getOwner())
-                      // Registers stop walk for comb loops.
-                      .Case<RegOp, RegResetOp>([](auto _) { return Value(); })
-                      // For non-register declarations, look at data result.
-                      .Case<Forceable>([](auto op) { return op.getDataRaw(); })
-                      // Handle connect ops specially.
-                      .Case<FConnectLike>([&](FConnectLike connect) -> Value {
-                        if (use.getOperandNumber() == 1) {
-                          auto dst = connect.getDest();
-                          if (handleConnects(dst, inputArgFields).succeeded())
-                            return dst;
-                        }
-                        return {};
-                      })
-                      // For everything else (e.g., expressions), if has single
-                      // result use that.
-                      .Default([](auto op) -> Value {
-                        if (op->getNumResults() == 1)
-                          return op->getResult(0);
-                        return {};
-                      });
-              if (childVal && childVal.getType().isa<FIRRTLBaseType>())
-                children.push_back(childVal);
-            }
-          }
-          for (auto childVal : children) {
+          visiting.appendToEnd(aliases);
+          for (auto id : aliases)
+            visited.set(id);
+
+          // Record the comb paths from the current input ports to the output
+          // ports that this node is connected to.
+          for (auto outPort : node.outPorts.slice(outPortRefs))
+            for (auto inArg : inputArgFields)
+              portPaths[inArg].insert(outPort);
+
+          for (auto childId : node.children.slice(childIds)) {
             // This childVal can be ignored, if
             // It is a Register or a subfield of a register.
-            if (!visited.contains(childVal))
-              dfsStack.push_back(childVal);
+            if (!visited.test(childId))
+              dfsStack.push_back(childId);
             // If the childVal is a sub, then check if it aliases with any of
             // the predecessors (the visiting set).
-            if (visiting.contains(childVal)) {
+            if (visiting.contains(childId)) {
               // Comb Cycle Detected !!
-              reportLoopFound(childVal, visiting);
+              reportLoopFound(childId, visiting);
               return failure();
             }
           }
@@ -227,13 +213,13 @@ public:
         // nodes that are no longer active predecessors, that is their sub-tree
         // is already explored. All the Values reachable from `dfsVal` have been
         // explored, remove it and its children from the visiting stack.
-        visiting.popUntilVal(dfsVal);
+        visiting.popUntilVal(dfsId);
 
         auto popped = dfsStack.pop_back_val();
         (void)popped;
         LLVM_DEBUG({
           llvm::dbgs() << "\n dfs popped :"
-                       << getFieldName(FieldRef(popped, 0)).first;
+                       << getFieldName(FieldRef(nodes[popped].value, 0)).first;
           dump();
         });
       }
@@ -242,6 +228,100 @@ public:
     return success();
   }
 
+  /// Return the id of the node for a Value, creating the node if needed.
+  unsigned getNodeId(Value val) {
+    auto [it, inserted] = nodeIds.try_emplace(val, nodes.size());
+    if (inserted) {
+      nodes.push_back({val});
+      visited.resize(nodes.size());
+    }
+    return it->second;
+  }
+
+  /// Compute the aliasing nodes, the children, the input port fields and the
+  /// output port fields connected to of a node, and store them in the flat
+  /// arrays.
+  void expandNode(unsigned id) {
+    if (nodes[id].expanded)
+      return;
+    Value dfsVal = nodes[id].value;
+
+    // All the Values that refer to the same FieldRef are added to the
+    // aliasingValues.
+    SmallVector<Value> aliasingValues = {dfsVal};
+    auto aToVIter = aliasingValuesMap.find(dfsVal);
+    if (aToVIter != aliasingValuesMap.end()) {
+      aliasingValues.append(aToVIter->getSecond().begin(),
+                            aToVIter->getSecond().end());
+    }
+
+    // Record all the children of the Value.
+    SmallVector<Value, 8> children;
+    SmallVector<FieldRef, 2> inputArgs;
+    SmallVector<FieldRef, 2> outPorts;
+    // If `dfsVal` is a subfield, then get all the FieldRefs that it
+    // refers to and then get all the values that alias with it.
+    forallRefersTo(dfsVal, [&](FieldRef ref) {
+      // If this subfield refers to instance/mem results(input port), then
+      // add the output port FieldRefs that exist in the referenced module
+      // comb paths to the children.
+      handlePorts(ref, children);
+      // Get all the values that refer to this FieldRef, and add them to
+      // the aliasing values.
+      if (auto arg = dyn_cast<BlockArgument>(ref.getValue()))
+        if (module.getPortDirection(arg.getArgNumber()) == Direction::In)
+          inputArgs.push_back(ref);
+
+      return success();
+    });
+
+    // Add the Value to `children`, to which a path exists from `dfsVal`.
+    for (auto dfsFromVal : aliasingValues) {
+
+      for (auto &use : dfsFromVal.getUses()) {
+        auto childVal =
+            TypeSwitch<Operation *, Value>(use.getOwner())
+                // Registers stop walk for comb loops.
+                .Case<RegOp, RegResetOp>([](auto _) { return Value(); })
+                // For non-register declarations, look at data result.
+                .Case<Forceable>([](auto op) { return op.getDataRaw(); })
+                // Handle connect ops specially.
+                .Case<FConnectLike>([&](FConnectLike connect) -> Value {
+                  if (use.getOperandNumber() == 1) {
+                    auto dst = connect.getDest();
+                    if (handleConnects(dst, outPorts).succeeded())
+                      return dst;
+                  }
+                  return {};
+                })
+                // For everything else (e.g., expressions), if has single
+                // result use that.
+                .Default([](auto op) -> Value {
+                  if (op->getNumResults() == 1)
+                    return op->getResult(0);
+                  return {};
+                });
+        if (childVal && childVal.getType().isa<FIRRTLBaseType>())
+          children.push_back(childVal);
+      }
+    }
+
+    // Creating nodes may grow `nodes`, so number everything before taking a
+    // reference to the node being expanded.
+    SmallVector<unsigned> aliasingIds, childrenIds;
+    for (auto val : aliasingValues)
+      aliasingIds.push_back(getNodeId(val));
+    for (auto val : children)
+      childrenIds.push_back(getNodeId(val));
+
+    Node &node = nodes[id];
+    node.expanded = true;
+    node.aliases = NodeRange::append(aliasIds, aliasingIds);
+    node.children = NodeRange::append(childIds, childrenIds);
+    node.inputArgs = NodeRange::append(inputArgRefs, inputArgs);
+    node.outPorts = NodeRange::append(outPortRefs, outPorts);
+  }
+
   // Preprocess the module ops to get the
   // 1. roots for DFS traversal,
   // 2. FieldRef corresponding to each Value.
@@ -408,7 +488,7 @@ public:
     }
   }
 
-  void reportLoopFound(Value childVal, VisitingSet visiting) {
+  void reportLoopFound(unsigned childId, VisitingSet visiting) {
     // TODO: Work harder to provide best information possible to user,
     // especially across instances or when we trace through aliasing values.
     // We're about to exit, and can afford to do some slower work here.
@@ -424,10 +504,12 @@ public:
     auto errorDiag = mlir::emitError(
         module.getLoc(), "detected combinational cycle in a FIRRTL module");
 
+    Value childVal = nodes[childId].value;
     SmallVector<Value, 16> path;
     path.push_back(childVal);
-    visiting.popUntilVal(
-        childVal, [&](Value visitingVal) { path.push_back(visitingVal); });
+    visiting.popUntilVal(childId, [&](unsigned visitingId) {
+      path.push_back(nodes[visitingId].value);
+    });
     assert(path.back() == childVal);
     path.pop_back();
 
@@ -459,8 +541,10 @@ public:
     errorDiag << "}";
   }
 
-  LogicalResult handleConnects(Value dst,
-                               SmallVector<FieldRef> &inputArgFields) {
+  /// Return failure if the walk stops at the destination of a connect. The
+  /// output port fields that the destination refers to are added to
+  /// `outPorts`.
+  LogicalResult handleConnects(Value dst, SmallVectorImpl<FieldRef> &outPorts) {
 
     bool onlyFieldZero = true;
     auto pathsToOutPort = [&](FieldRef dstFieldRef) {
@@ -470,9 +554,7 @@ public:
         return failure();
       }
       onlyFieldZero = false;
-      for (auto inArg : inputArgFields) {
-        portPaths[inArg].insert(dstFieldRef);
-      }
+      outPorts.push_back(dstFieldRef);
       return success();
     };
     forallRefersTo(dst, pathsToOutPort);
@@ -535,8 +617,33 @@ public:
     }
   }
 
+  /// A node of the graph traversed by the DFS, one per Value. The lists of a
+  /// node are computed the first time it is visited and are stored back to
+  /// back in the flat arrays below.
+  struct Node {
+    Value value;
+    bool expanded = false;
+    /// The node itself, followed by the nodes that alias with it.
+    NodeRange aliases;
+    /// The nodes to which a comb path exists from this node.
+    NodeRange children;
+    /// The input port fields this node refers to.
+    NodeRange inputArgs;
+    /// The output port fields this node is connected to.
+    NodeRange outPorts;
+  };
+
   FModuleOp module;
   InstanceGraph &instanceGraph;
+  /// The nodes of the graph, indexed by their id.
+  SmallVector<Node, 0> nodes;
+  DenseMap<Value, unsigned> nodeIds;
+  SmallVector<unsigned> aliasIds;
+  SmallVector<unsigned> childIds;
+  SmallVector<FieldRef> inputArgRefs;
+  SmallVector<FieldRef> outPortRefs;
+  /// The nodes that have been visited from the current root, indexed by id.
+  BitVector visited;
   /// Map of a Value to all the FieldRefs that it refers to.
   DenseMap<Value, SetOfFieldRefs> valRefersTo;
 
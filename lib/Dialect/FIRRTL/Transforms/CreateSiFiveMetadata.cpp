@@ -70,11 +70,11 @@ LogicalResult CreateSiFiveMetadataPass::emitMemoryMetadata() {
       instancePathCache.instanceGraph.getTopLevelNode()->getModule() == dutMod;
 
   // This lambda, writes to the given Json stream all the relevant memory
-  // attributes. Also adds the memory attrbutes to the string for creating the
-  // memmory conf file.
+  // attributes. Also appends the memory attrbutes to the stream for creating
+  // the memmory conf file.
   auto createMemMetadata = [&](FMemModuleOp mem,
                                llvm::json::OStream &jsonStream,
-                               std::string &seqMemConfStr) {
+                               llvm::raw_ostream &seqMemConf) {
     // Get the memory data width.
     auto width = mem.getDataWidth();
     // Metadata needs to be printed for memories which are candidates for
@@ -88,31 +88,26 @@ LogicalResult CreateSiFiveMetadataPass::emitMemoryMetadata() {
     // Compute the mask granularity.
     auto isMasked = mem.isMasked();
     auto maskGran = width / mem.getMaskBits();
-    // Now create the config string for the memory.
-    std::string portStr;
-    for (uint32_t i = 0; i < mem.getNumWritePorts(); ++i) {
-      if (!portStr.empty())
-        portStr += ",";
-      portStr += isMasked ? "mwrite" : "write";
-    }
-    for (uint32_t i = 0; i < mem.getNumReadPorts(); ++i) {
-      if (!portStr.empty())
-        portStr += ",";
-      portStr += "read";
-    }
-    for (uint32_t i = 0; i < mem.getNumReadWritePorts(); ++i) {
-      if (!portStr.empty())
-        portStr += ",";
-      portStr += isMasked ? "mrw" : "rw";
-    }
-
+    // Now append the config line of the memory. It is streamed directly into
+    // the conf file contents, which would otherwise be copied for each memory.
     auto memExtName = mem.getName();
-    auto maskGranStr =
-        !isMasked ? "" : " mask_gran " + std::to_string(maskGran);
-    seqMemConfStr = (StringRef(seqMemConfStr) + "name " + memExtName +
-                     " depth " + Twine(mem.getDepth()) + " width " +
-                     Twine(width) + " ports " + portStr + maskGranStr + "\n")
-                        .str();
+    seqMemConf << "name " << memExtName << " depth " << mem.getDepth()
+               << " width " << width << " ports ";
+    bool firstPort = true;
+    auto emitPorts = [&](uint32_t numPorts, StringRef kind) {
+      for (uint32_t i = 0; i < numPorts; ++i) {
+        if (!firstPort)
+          seqMemConf << ",";
+        seqMemConf << kind;
+        firstPort = false;
+      }
+    };
+    emitPorts(mem.getNumWritePorts(), isMasked ? "mwrite" : "write");
+    emitPorts(mem.getNumReadPorts(), "read");
+    emitPorts(mem.getNumReadWritePorts(), isMasked ? "mrw" : "rw");
+    if (isMasked)
+      seqMemConf << " mask_gran " << maskGran;
+    seqMemConf << "\n";
 
     // Do not emit any JSON for memories which are not in the DUT.
     if (!everythingInDUT && !dutModuleSet.contains(mem))
@@ -146,8 +141,10 @@ LogicalResult CreateSiFiveMetadataPass::emitMemoryMetadata() {
       jsonStream.attributeArray("hierarchy", [&] {
         // Get the absolute path for the parent memory, to create the
         // hierarchy names.
-        auto paths = instancePathCache.getAbsolutePaths(mem);
-        for (auto p : paths) {
+        SmallVector<circt::hw::HWInstanceLike> p;
+        for (auto path : instancePathCache.getAbsolutePathIDs(mem)) {
+          p.clear();
+          instancePathCache.getPath(path, p);
           if (p.empty())
             continue;
           auto top = p.front();
@@ -157,7 +154,8 @@ LogicalResult CreateSiFiveMetadataPass::emitMemoryMetadata() {
             auto parentModule = inst->getParentOfType<FModuleOp>();
             if (dutMod == parentModule)
               hierName = parentModule.getName().str();
-            hierName = (Twine(hierName) + "." + inst.getInstanceName()).str();
+            hierName += ".";
+            hierName += inst.getInstanceName();
           }
           hierNames.push_back(hierName);
           // Only include the memory path if it is under the DUT or we are in a
@@ -178,9 +176,10 @@ LogicalResult CreateSiFiveMetadataPass::emitMemoryMetadata() {
   llvm::json::OStream dutJson(dutOs, 2);
 
   std::string seqMemConfStr;
+  llvm::raw_string_ostream seqMemConf(seqMemConfStr);
   dutJson.array([&] {
     for (auto mem : circuitOp.getOps<FMemModuleOp>())
-      createMemMetadata(mem, dutJson, seqMemConfStr);
+      createMemMetadata(mem, dutJson, seqMemConf);
   });
 
   auto *context = &getContext();
@@ -199,8 +198,8 @@ LogicalResult CreateSiFiveMetadataPass::emitMemoryMetadata() {
       context, metadataDir, "seq_mems.json", /*excludeFromFilelist=*/true);
   dutVerbatimOp->setAttr("output_file", fileAttr);
 
-  auto confVerbatimOp =
-      builder.create<sv::VerbatimOp>(builder.getUnknownLoc(), seqMemConfStr);
+  auto confVerbatimOp = builder.create<sv::VerbatimOp>(
+      builder.getUnknownLoc(), seqMemConf.str());
   if (replSeqMemFile.empty()) {
     emitError(circuitOp->getLoc())
         << "metadata emission failed, the option "
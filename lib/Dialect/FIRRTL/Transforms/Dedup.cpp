@@ -24,6 +24,7 @@
 #include "circt/Support/LLVM.h"
 #include "mlir/IR/IRMapping.h"
 #include "mlir/IR/ImplicitLocOpBuilder.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/Support/LogicalResult.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DenseMapInfo.h"
@@ -34,6 +35,7 @@
 #include "llvm/ADT/TypeSwitch.h"
 #include "llvm/Support/Format.h"
 #include "llvm/Support/SHA256.h"
+#include "llvm/Support/xxhash.h"
 
 using namespace circt;
 using namespace firrtl;
@@ -59,9 +61,13 @@ llvm::raw_ostream &printHash(llvm::raw_ostream &stream, std::string data) {
   return printHex(stream, bytes);
 }
 
-struct StructuralHasher {
-  explicit StructuralHasher(MLIRContext *context) {
+/// The attributes and names shared by every `StructuralHasher`. These are
+/// created once, such that modules can be hashed on multiple threads without
+/// touching the context.
+struct StructuralHasherSharedConstants {
+  explicit StructuralHasherSharedConstants(MLIRContext *context) {
     portTypesAttr = StringAttr::get(context, "portTypes");
+    moduleNameAttr = StringAttr::get(context, "moduleName");
     nonessentialAttributes.insert(StringAttr::get(context, "annotations"));
     nonessentialAttributes.insert(StringAttr::get(context, "name"));
     nonessentialAttributes.insert(StringAttr::get(context, "portAnnotations"));
@@ -72,9 +78,39 @@ struct StructuralHasher {
     nonessentialAttributes.insert(StringAttr::get(context, "inner_sym"));
   };
 
+  // This is a cached "portTypes" string attr.
+  StringAttr portTypesAttr;
+
+  // This is a cached "moduleName" string attr.
+  StringAttr moduleNameAttr;
+
+  // This is a set of every attribute we should ignore.
+  DenseSet<Attribute> nonessentialAttributes;
+};
+
+struct StructuralHasher {
+  /// The hashes of the modules referenced by instances, by module name.
+  using ModuleHashes = DenseMap<StringAttr, std::array<uint8_t, 32>>;
+
+  /// If `fast` is set, the modules are hashed with a non-cryptographic hash.
+  /// Such hashes only identify candidates for deduplication, which have to be
+  /// confirmed by comparing the modules.
+  explicit StructuralHasher(const StructuralHasherSharedConstants &constants,
+                            const ModuleHashes &moduleHashes, bool fast = false)
+      : constants(constants), moduleHashes(moduleHashes), fast(fast) {}
+
   std::array<uint8_t, 32> hash(FModuleLike module) {
     update(&(*module));
-    auto hash = sha.final();
+    std::array<uint8_t, 32> hash;
+    if (fast) {
+      // Only the first 16 bytes are used, which hold the hash of the bytes
+      // followed by their number.
+      uint64_t words[2] = {llvm::xxHash64(buffer), buffer.size()};
+      hash.fill(0);
+      std::memcpy(hash.data(), words, sizeof(words));
+    } else {
+      hash = sha.final();
+    }
     reset();
     return hash;
   }
@@ -83,17 +119,25 @@ private:
   void reset() {
     currentIndex = 0;
     indexes.clear();
+    buffer.clear();
     sha.init();
   }
 
+  void update(ArrayRef<uint8_t> bytes) {
+    if (fast)
+      buffer.append(bytes.begin(), bytes.end());
+    else
+      sha.update(bytes);
+  }
+
   void update(const void *pointer) {
     auto *addr = reinterpret_cast<const uint8_t *>(&pointer);
-    sha.update(ArrayRef<uint8_t>(addr, sizeof pointer));
+    update(ArrayRef<uint8_t>(addr, sizeof pointer));
   }
 
   void update(size_t value) {
     auto *addr = reinterpret_cast<const uint8_t *>(&value);
-    sha.update(ArrayRef<uint8_t>(addr, sizeof value));
+    update(ArrayRef<uint8_t>(addr, sizeof value));
   }
 
   void update(TypeID typeID) { update(typeID.getAsOpaquePointer()); }
@@ -133,10 +177,19 @@ private:
       auto name = namedAttr.getName();
       auto value = namedAttr.getValue();
       // Skip names and annotations.
-      if (nonessentialAttributes.contains(name))
+      if (constants.nonessentialAttributes.contains(name))
         continue;
+      // Hash the instantiated module by its own hash, rather than by its
+      // name which changes as the module is deduplicated.
+      if (name == constants.moduleNameAttr) {
+        auto it = moduleHashes.find(value.cast<FlatSymbolRefAttr>().getAttr());
+        if (it != moduleHashes.end()) {
+          update(ArrayRef<uint8_t>(it->second));
+          continue;
+        }
+      }
       // Hash the port types.
-      if (name == portTypesAttr) {
+      if (name == constants.portTypesAttr) {
         auto portTypes = value.cast<ArrayAttr>().getAsValueRange<TypeAttr>();
         for (auto type : portTypes)
           update(type);
@@ -184,10 +237,16 @@ private:
   unsigned currentIndex = 0;
   DenseMap<Value, unsigned> indexes;
 
-  // This is a set of every attribute we should ignore.
-  DenseSet<Attribute> nonessentialAttributes;
-  // This is a cached "portTypes" string attr.
-  StringAttr portTypesAttr;
+  // The attributes shared across hashers.
+  const StructuralHasherSharedConstants &constants;
+
+  // The hashes of the modules that have been hashed before.
+  const ModuleHashes &moduleHashes;
+
+  // Whether to use the fast hash, which hashes the bytes collected in the
+  // buffer at the end, rather than the running SHA256 calculation.
+  bool fast;
+  SmallVector<uint8_t, 0> buffer;
 
   // This is the actual running hash calculation. This is a stateful element
   // that should be reinitialized after each hash is produced.
@@ -565,6 +624,16 @@ struct Equivalence {
     return success();
   }
 
+  /// Check whether two modules are equivalent, without reporting any of the
+  /// differences.
+  bool isEquivalent(Operation *a, Operation *b) {
+    auto diag = mlir::emitError(a->getLoc());
+    IRMapping map;
+    auto result = check(diag, map, a, b);
+    diag.abandon();
+    return succeeded(result);
+  }
+
   // NOLINTNEXTLINE(misc-no-recursion)
   void check(InFlightDiagnostic &diag, Operation *a, Operation *b) {
     IRMapping map;
@@ -750,14 +819,13 @@ private:
   void replaceInstances(FModuleLike toModule, Operation *fromModule) {
     // Replace all instances of the other module.
     auto *fromNode = instanceGraph[::cast<hw::HWModuleLike>(fromModule)];
-    auto *toNode = instanceGraph[toModule];
     auto toModuleRef = FlatSymbolRefAttr::get(toModule.getModuleNameAttr());
     for (auto *oldInstRec : llvm::make_early_inc_range(fromNode->uses())) {
       auto inst = ::cast<InstanceOp>(*oldInstRec->getInstance());
+      instanceGraph.eraseInstance(oldInstRec);
       inst.setModuleNameAttr(toModuleRef);
       inst.setPortNamesAttr(toModule.getPortNamesAttr());
-      oldInstRec->getParent()->addInstance(inst, toNode);
-      oldInstRec->erase();
+      instanceGraph.addInstance(inst);
     }
     instanceGraph.erase(fromNode);
     fromModule->erase();
@@ -1263,22 +1331,31 @@ struct SHA256HashDenseMapInfo {
 
 namespace {
 class DedupPass : public DedupBase<DedupPass> {
+public:
+  using DedupBase::fastHash;
+
+private:
   void runOnOperation() override {
     auto *context = &getContext();
     auto circuit = getOperation();
     auto &instanceGraph = getAnalysis<InstanceGraph>();
     auto *nlaTable = &getAnalysis<NLATable>();
+    auto numCompactionsBefore = nlaTable->numCompactions;
+    auto numCompactedEntriesBefore = nlaTable->numCompactedEntries;
     SymbolTable symbolTable(circuit);
     Deduper deduper(instanceGraph, symbolTable, nlaTable, circuit);
-    StructuralHasher hasher(&getContext());
+    StructuralHasherSharedConstants hasherConstants(&getContext());
     Equivalence equiv(context, instanceGraph);
     auto anythingChanged = false;
 
     // Modules annotated with this should not be considered for deduplication.
     auto noDedupClass = StringAttr::get(context, noDedupAnnoClass);
 
-    // A map of all the module hashes that we have calculated so far.
-    llvm::DenseMap<std::array<uint8_t, 32>, Operation *, SHA256HashDenseMapInfo>
+    // A map of all the module hashes that we have calculated so far, to the
+    // modules not deduplicated with that hash. With the fast hash, modules
+    // that are not equivalent may share a hash.
+    llvm::DenseMap<std::array<uint8_t, 32>, SmallVector<Operation *, 1>,
+                   SHA256HashDenseMapInfo>
         moduleHashes;
 
     // We track the name of the module that each module is deduped into, so that
@@ -1294,8 +1371,20 @@ class DedupPass : public DedupBase<DedupPass> {
           return cast<FModuleLike>(*node->getModule());
         }));
 
+    // Determine which modules may be deduplicated, and group them by their
+    // height in the instance graph. Modules only instantiate modules of lower
+    // levels, such that all modules of one level can be hashed in parallel
+    // once the lower levels are done.
+    DenseMap<Operation *, unsigned> heights;
+    SmallVector<SmallVector<FModuleLike, 0>> levels;
     for (auto module : modules) {
       auto moduleName = module.getModuleNameAttr();
+      unsigned height = 0;
+      for (auto *record : *instanceGraph.lookup(module))
+        height = std::max(
+            height, heights.lookup(record->getTarget()->getModule()) + 1);
+      heights.insert({module, height});
+
       // If the module is marked with NoDedup, just skip it.
       if (AnnotationSet(module).hasAnnotation(noDedupClass)) {
         // We record it in the dedup map to help detect errors when the user
@@ -1312,12 +1401,48 @@ class DedupPass : public DedupBase<DedupPass> {
         dedupMap[moduleName] = moduleName;
         continue;
       }
-      // Calculate the hash of the module.
-      auto h = hasher.hash(module);
-      // Check if there a module with the same hash.
-      auto it = moduleHashes.find(h);
-      if (it != moduleHashes.end()) {
-        auto original = cast<FModuleLike>(it->second);
+      if (levels.size() <= height)
+        levels.resize(height + 1);
+      levels[height].push_back(module);
+    }
+
+    // Calculate the hash of every module that may be deduplicated. Instances
+    // are hashed using the hash of the instantiated module, such that the
+    // hashes remain valid as the instantiated modules are deduplicated. The
+    // modules which are skipped are identified by their name instead.
+    StructuralHasher::ModuleHashes hashes;
+    for (auto module : modules) {
+      auto name = module.getModuleNameAttr();
+      if (dedupMap.count(name))
+        hashes.insert({name, llvm::SHA256::hash(ArrayRef<uint8_t>(
+                                 name.getValue().bytes_begin(),
+                                 name.getValue().bytes_end()))});
+    }
+    SmallVector<std::array<uint8_t, 32>, 0> levelHashes;
+    for (auto &level : levels) {
+      levelHashes.resize(level.size());
+      mlir::parallelFor(context, 0, level.size(), [&](size_t index) {
+        StructuralHasher hasher(hasherConstants, hashes, fastHash);
+        levelHashes[index] = hasher.hash(level[index]);
+      });
+      for (auto [module, h] : llvm::zip(level, levelHashes))
+        hashes.insert({module.getModuleNameAttr(), h});
+    }
+
+    for (auto module : modules) {
+      auto moduleName = module.getModuleNameAttr();
+      // Skip the modules excluded from deduplication above.
+      if (dedupMap.count(moduleName))
+        continue;
+      auto h = hashes.lookup(moduleName);
+      // Check if there a module with the same hash. The fast hash is not
+      // unique, so the modules have to be compared to confirm the match.
+      auto &candidates = moduleHashes[h];
+      auto it = llvm::find_if(candidates, [&](Operation *candidate) {
+        return !fastHash || equiv.isEquivalent(candidate, module);
+      });
+      if (it != candidates.end()) {
+        auto original = cast<FModuleLike>(*it);
         // Record the group ID of the other module.
         dedupMap[moduleName] = original.getModuleNameAttr();
         deduper.dedup(original, module);
@@ -1330,7 +1455,7 @@ class DedupPass : public DedupBase<DedupPass> {
       // Add the module to a new dedup group.
       dedupMap[moduleName] = moduleName;
       // Record the module's hash.
-      moduleHashes[h] = module;
+      candidates.push_back(module);
     }
 
     // This part verifies that all modules marked by "MustDedup" have been
@@ -1408,13 +1533,20 @@ class DedupPass : public DedupBase<DedupPass> {
     // can block the deduplication of the parent modules.
     fixupAllModules(instanceGraph);
 
-    markAnalysesPreserved<NLATable>();
+    numNLACompactions += nlaTable->numCompactions - numCompactionsBefore;
+    numNLAEntriesCompacted +=
+        nlaTable->numCompactedEntries - numCompactedEntriesBefore;
+
+    // The instance graph is kept up to date as modules are deduplicated.
+    markAnalysesPreserved<NLATable, InstanceGraph>();
     if (!anythingChanged)
       markAllAnalysesPreserved();
   }
 };
 } // end anonymous namespace
 
-std::unique_ptr<mlir::Pass> circt::firrtl::createDedupPass() {
-  return std::make_unique<DedupPass>();
+std::unique_ptr<mlir::Pass> circt::firrtl::createDedupPass(bool fastHash) {
+  auto pass = std::make_unique<DedupPass>();
+  pass->fastHash = fastHash;
+  return pass;
 }
@@ -23,6 +23,7 @@
 #include "circt/Dialect/SV/SVDialect.h"
 #include "circt/Dialect/SV/SVOps.h"
 #include "mlir/IR/ImplicitLocOpBuilder.h"
+#include "mlir/IR/Threading.h"
 #include "llvm/ADT/TypeSwitch.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/JSON.h"
@@ -57,12 +58,30 @@ struct Tracker {
   bool hasFieldID() { return fieldID > 0; }
 };
 
+/// The trackers and instances found in one operation of the circuit. These are
+/// gathered for all modules in parallel and merged afterwards.
+struct TrackerCollection {
+  /// The trackers, in the order in which they were found.
+  SmallVector<Tracker> trackers;
+  /// The instances by name.
+  SmallVector<std::pair<hw::InnerRefAttr, InstanceOp>> instances;
+  /// The instances which received a temporary symbol.
+  SmallVector<InstanceOp> tempSymInstances;
+  /// The namespace of the module, if any symbols were added to it.
+  std::optional<ModuleNamespace> moduleNamespace;
+  /// Whether the operation is the DUT module.
+  bool isDUT = false;
+};
+
 class EmitOMIRPass : public EmitOMIRBase<EmitOMIRPass> {
 public:
   using EmitOMIRBase::outputFilename;
 
 private:
   void runOnOperation() override;
+  LogicalResult collectTrackers(Operation *root,
+                                const DenseSet<Attribute> &sramIDs,
+                                TrackerCollection &collection);
   void makeTrackerAbsolute(Tracker &tracker);
 
   void emitSourceInfo(Location input, SmallString<64> &into);
@@ -605,54 +624,39 @@ void EmitOMIRPass::runOnOperation() {
   dutModuleName = {};
 
   // Traverse the IR and collect all tracker annotations that were previously
-  // scattered into the circuit.
-  circuitOp.walk([&](Operation *op) {
-    if (auto instOp = dyn_cast<InstanceOp>(op)) {
-      // This instance does not have a symbol, but we are adding one. Remove it
-      // after the pass.
-      if (!op->getAttr(hw::InnerSymbolTable::getInnerSymbolAttrName()))
-        tempSymInstances.insert(instOp);
+  // scattered into the circuit. The operations in the circuit only add symbols
+  // to themselves, so they are traversed in parallel. The results are merged in
+  // circuit order afterwards, as if the circuit had been walked sequentially.
+  SmallVector<Operation *> ops;
+  for (auto &op : *circuitOp.getBodyBlock())
+    ops.push_back(&op);
+  SmallVector<TrackerCollection> collections(ops.size() + 1);
+  if (failed(mlir::failableParallelForEachN(
+          context, 0, ops.size(), [&](size_t index) {
+            return collectTrackers(ops[index], sramIDs, collections[index]);
+          })))
+    return signalPassFailure();
+  ops.push_back(circuitOp);
+  if (failed(collectTrackers(circuitOp, sramIDs, collections.back())))
+    return signalPassFailure();
 
-      instancesByName.insert({getInnerRefTo(op), instOp});
-    }
-    auto setTracker = [&](int portNo, Annotation anno) {
-      if (!anno.isClass(omirTrackerAnnoClass))
-        return false;
-      Tracker tracker;
-      tracker.op = op;
-      tracker.id = anno.getMember<IntegerAttr>("id");
-      tracker.portNo = portNo;
-      tracker.fieldID = anno.getFieldID();
-      if (!tracker.id) {
-        op->emitError(omirTrackerAnnoClass)
-            << " annotation missing `id` integer attribute";
-        anyFailures = true;
-        return true;
-      }
-      if (auto nlaSym = anno.getMember<FlatSymbolRefAttr>("circt.nonlocal")) {
-        auto tmp = nlaTable->getNLA(nlaSym.getAttr());
-        if (!tmp) {
-          op->emitError("missing annotation ") << nlaSym.getValue();
-          anyFailures = true;
-          return true;
-        }
-        tracker.nla = cast<hw::HierPathOp>(tmp);
-      }
+  for (auto [op, collection] : llvm::zip(ops, collections)) {
+    if (collection.moduleNamespace)
+      moduleNamespaces.insert({op, std::move(*collection.moduleNamespace)});
+    instancesByName.insert(collection.instances.begin(),
+                           collection.instances.end());
+    tempSymInstances.insert(collection.tempSymInstances.begin(),
+                            collection.tempSymInstances.end());
+    if (collection.isDUT)
+      dutModuleName = cast<FModuleOp>(op).getNameAttr();
+    for (auto &tracker : collection.trackers) {
       if (sramIDs.erase(tracker.id))
         makeTrackerAbsolute(tracker);
       trackers.insert({tracker.id, tracker});
-      return true;
-    };
-    AnnotationSet::removePortAnnotations(op, setTracker);
-    AnnotationSet::removeAnnotations(
-        op, std::bind(setTracker, -1, std::placeholders::_1));
-    if (auto modOp = dyn_cast<FModuleOp>(op)) {
-      AnnotationSet annos(modOp.getAnnotations());
-      if (!annos.hasAnnotation(dutAnnoClass))
-        return;
-      dutModuleName = modOp.getNameAttr();
     }
-  });
+  }
+  if (anyFailures)
+    return signalPassFailure();
 
   // Build the output JSON.
   std::string jsonBuffer;
@@ -696,6 +700,86 @@ void EmitOMIRPass::runOnOperation() {
   markAnalysesPreserved<NLATable>();
 }
 
+/// Collect the trackers and instances in an operation of the circuit. This only
+/// modifies the operation itself, and may run concurrently for different
+/// operations. Trackers of SRAMs are made absolute once all operations have
+/// been traversed, since this adds NLAs to the circuit. The circuit itself is
+/// not traversed, only its own annotations are collected.
+LogicalResult
+EmitOMIRPass::collectTrackers(Operation *root,
+                              const DenseSet<Attribute> &sramIDs,
+                              TrackerCollection &collection) {
+  bool collectionFailed = false;
+  auto getNamespace = [&](FModuleLike module) -> ModuleNamespace & {
+    assert(module.getOperation() == root &&
+           "symbol added outside of the traversed module");
+    if (!collection.moduleNamespace)
+      collection.moduleNamespace.emplace(module);
+    return *collection.moduleNamespace;
+  };
+
+  auto collect = [&](Operation *op) {
+    if (auto instOp = dyn_cast<InstanceOp>(op)) {
+      // This instance does not have a symbol, but we are adding one. Remove it
+      // after the pass.
+      if (!op->getAttr(hw::InnerSymbolTable::getInnerSymbolAttrName()))
+        collection.tempSymInstances.push_back(instOp);
+
+      auto ref = ::getInnerRefTo(op, "omir_sym",
+                                 [&](FModuleOp module) -> ModuleNamespace & {
+                                   return getNamespace(module);
+                                 });
+      collection.instances.push_back({ref, instOp});
+    }
+    auto setTracker = [&](int portNo, Annotation anno) {
+      if (!anno.isClass(omirTrackerAnnoClass))
+        return false;
+      Tracker tracker;
+      tracker.op = op;
+      tracker.id = anno.getMember<IntegerAttr>("id");
+      tracker.portNo = portNo;
+      tracker.fieldID = anno.getFieldID();
+      if (!tracker.id) {
+        op->emitError(omirTrackerAnnoClass)
+            << " annotation missing `id` integer attribute";
+        collectionFailed = true;
+        return true;
+      }
+      if (auto nlaSym = anno.getMember<FlatSymbolRefAttr>("circt.nonlocal")) {
+        auto tmp = nlaTable->getNLA(nlaSym.getAttr());
+        if (!tmp) {
+          op->emitError("missing annotation ") << nlaSym.getValue();
+          collectionFailed = true;
+          return true;
+        }
+        tracker.nla = cast<hw::HierPathOp>(tmp);
+      }
+      // Name the SRAM right away, such that it gets the same symbol as if it
+      // had been made absolute during the traversal.
+      if (sramIDs.contains(tracker.id) && !isa<FModuleLike>(op))
+        ::getInnerRefTo(op, "omir_sym",
+                        [&](FModuleOp module) -> ModuleNamespace & {
+                          return getNamespace(module);
+                        });
+      collection.trackers.push_back(tracker);
+      return true;
+    };
+    AnnotationSet::removePortAnnotations(op, setTracker);
+    AnnotationSet::removeAnnotations(
+        op, std::bind(setTracker, -1, std::placeholders::_1));
+    if (auto modOp = dyn_cast<FModuleOp>(op)) {
+      AnnotationSet annos(modOp.getAnnotations());
+      if (annos.hasAnnotation(dutAnnoClass))
+        collection.isDUT = true;
+    }
+  };
+  if (isa<CircuitOp>(root))
+    collect(root);
+  else
+    root->walk(collect);
+  return failure(collectionFailed);
+}
+
 /// Make a tracker absolute by adding an NLA to it which starts at the root
 /// module of the circuit. Generates an error if any module along the path is
 /// instantiated multiple times.
@@ -720,7 +804,7 @@ void EmitOMIRPass::makeTrackerAbsolute(Tracker &tracker) {
     mod = tracker.op->getParentOfType<FModuleOp>();
 
   // Get all the paths instantiating this module.
-  auto paths = instancePaths->getAbsolutePaths(mod);
+  auto paths = instancePaths->getAbsolutePathIDs(mod);
   if (paths.empty()) {
     tracker.op->emitError("OMIR node targets uninstantiated component `")
         << opName.getValue() << "`";
@@ -732,8 +816,13 @@ void EmitOMIRPass::makeTrackerAbsolute(Tracker &tracker) {
                 << opName.getValue() << "`";
     diag.attachNote(tracker.op->getLoc())
         << "may refer to the following paths:";
-    for (auto path : paths)
-      formatInstancePath(diag.attachNote(tracker.op->getLoc()) << "- ", path);
+    SmallVector<hw::HWInstanceLike> instances;
+    for (auto path : paths) {
+      instances.clear();
+      instancePaths->getPath(path, instances);
+      formatInstancePath(diag.attachNote(tracker.op->getLoc()) << "- ",
+                         instances);
+    }
     anyFailures = true;
     return;
   }
@@ -745,7 +834,9 @@ void EmitOMIRPass::makeTrackerAbsolute(Tracker &tracker) {
     namepath.push_back(getInnerRefTo(op));
   };
   // Add the path up to where the NLA starts.
-  for (auto inst : paths[0])
+  SmallVector<hw::HWInstanceLike> instances;
+  instancePaths->getPath(paths[0], instances);
+  for (auto inst : instances)
     addToPath(inst, inst.getInstanceNameAttr());
   // Add the path from the NLA to the op.
   if (tracker.nla) {
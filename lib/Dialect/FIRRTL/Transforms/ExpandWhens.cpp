@@ -17,7 +17,6 @@
 #include "circt/Dialect/FIRRTL/FIRRTLVisitors.h"
 #include "circt/Dialect/FIRRTL/Passes.h"
 #include "circt/Support/FieldRef.h"
-#include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/STLExtras.h"
 
 using namespace circt;
@@ -30,85 +29,132 @@ static void mergeBlock(Block &destination, Block::iterator insertPoint,
   destination.getOperations().splice(insertPoint, source.getOperations());
 }
 
-/// This is a stack of hashtables, if lookup fails in the top-most hashtable,
-/// it will attempt to lookup in lower hashtables.  This class is used instead
-/// of a ScopedHashTable so we can manually pop off a scope and keep it around.
+/// A deterministic mapping of a FieldRef to the last operation which set a
+/// value to it, with support for nested scopes.  Lookups see the driver set in
+/// the innermost scope.
 ///
-/// This only allows inserting into the outermost scope.
-template <typename KeyT, typename ValueT>
-struct HashTableStack {
-  using ScopeT = typename llvm::MapVector<KeyT, ValueT>;
-  using StackT = typename llvm::SmallVector<ScopeT, 3>;
-
-  struct Iterator {
-    Iterator(typename StackT::iterator stackIt,
-             typename ScopeT::iterator scopeIt)
-        : stackIt(stackIt), scopeIt(scopeIt) {}
-
-    bool operator==(const Iterator &rhs) const {
-      return stackIt == rhs.stackIt && scopeIt == rhs.scopeIt;
-    }
-
-    bool operator!=(const Iterator &rhs) const { return !(*this == rhs); }
-
-    std::pair<KeyT, ValueT> &operator*() const { return *scopeIt; }
+/// Instead of keeping one hash table per scope, this keeps a single flat table
+/// of the current drivers, and an undo log of the entries changed by each open
+/// scope.  Lookups are a single hash table probe regardless of the nesting
+/// depth, and opening a scope does not allocate.  Popping a scope rolls back
+/// its changes and returns them.
+class ScopedDriverMap {
+public:
+  /// The drivers set in a popped scope, in the order they were first set.
+  /// Entries can be removed by clearing their FieldRef.
+  using Scope = SmallVector<std::pair<FieldRef, Operation *>>;
+
+  ScopedDriverMap() = default;
+  ScopedDriverMap(const ScopedDriverMap &) = delete;
+  ScopedDriverMap &operator=(const ScopedDriverMap &) = delete;
+
+  /// Return the driver of `dest` seen from the current scope, or std::nullopt
+  /// if `dest` is unknown.  Declared sinks without a driver are null.
+  std::optional<Operation *> lookup(FieldRef dest) const {
+    auto it = slotIndices.find(dest);
+    if (it == slotIndices.end())
+      return std::nullopt;
+    return slots[it->second].driver;
+  }
 
-    Iterator &operator++() {
-      if (scopeIt == stackIt->end())
-        scopeIt = (++stackIt)->begin();
-      else
-        ++scopeIt;
-      return *this;
+  /// Set the driver of `dest` in the current scope.  Returns a reference to the
+  /// driver and whether `dest` had not been set in the current scope before.
+  std::pair<Operation *&, bool> insert(FieldRef dest, Operation *driver) {
+    auto [it, inserted] = slotIndices.insert({dest, slots.size()});
+    if (inserted) {
+      slots.push_back({dest, driver, depth()});
+      if (depth() != 0)
+        undoLog.push_back({it->second, nullptr, 0, /*created=*/true});
+      return {slots.back().driver, true};
     }
-
-    typename StackT::iterator stackIt;
-    typename ScopeT::iterator scopeIt;
-  };
-
-  HashTableStack() {
-    // We require at least one scope.
-    pushScope();
+    auto &slot = slots[it->second];
+    if (slot.depth == depth())
+      return {slot.driver, false};
+    undoLog.push_back({it->second, slot.driver, slot.depth, /*created=*/false});
+    slot.driver = driver;
+    slot.depth = depth();
+    return {slot.driver, true};
   }
 
-  using iterator = Iterator;
-
-  iterator begin() {
-    return Iterator(mapStack.begin(), mapStack.first().begin());
+  /// Set the driver of `dest` in the current scope, replacing any driver.
+  void set(FieldRef dest, Operation *driver) {
+    insert(dest, driver).first = driver;
   }
 
-  iterator end() { return Iterator(mapStack.end() - 1, mapStack.back().end()); }
+  void pushScope() {
+    scopeStarts.push_back(undoLog.size());
+    maxDepth = std::max(maxDepth, depth());
+  }
 
-  iterator find(const KeyT &key) {
-    // Try to find a hashtable with the missing value.
-    for (auto i = mapStack.size(); i > 0; --i) {
-      auto &map = mapStack[i - 1];
-      auto it = map.find(key);
-      if (it != map.end())
-        return Iterator(mapStack.begin() + i - 1, it);
+  /// Pop the current scope, returning the drivers it set.
+  Scope popScope() {
+    assert(!scopeStarts.empty() && "Cannot pop the last scope");
+    auto start = scopeStarts.pop_back_val();
+    Scope scope;
+    scope.reserve(undoLog.size() - start);
+    for (auto &undo : llvm::make_range(undoLog.begin() + start, undoLog.end()))
+      scope.push_back({slots[undo.slot].key, slots[undo.slot].driver});
+    while (undoLog.size() != start) {
+      auto undo = undoLog.pop_back_val();
+      auto &slot = slots[undo.slot];
+      if (undo.created) {
+        slotIndices.erase(slot.key);
+        slot.key = {};
+        continue;
+      }
+      slot.driver = undo.driver;
+      slot.depth = undo.depth;
     }
-    return end();
+    // Drop the slots created last if they are no longer used.
+    while (!slots.empty() && !slots.back().key.getValue())
+      slots.pop_back();
+    return scope;
   }
 
-  ScopeT &getLastScope() { return mapStack.back(); }
+  /// Call `fn` with each FieldRef and driver in the outermost scope, in the
+  /// order they were set.  Must only be called when no scope is open.
+  void forEachOutermost(
+      llvm::function_ref<void(FieldRef, Operation *)> fn) const {
+    assert(scopeStarts.empty());
+    for (auto &slot : slots)
+      if (slot.key.getValue())
+        fn(slot.key, slot.driver);
+  }
 
-  void pushScope() { mapStack.emplace_back(); }
+  /// The current nesting depth, with 0 being the outermost scope.
+  unsigned depth() const { return scopeStarts.size(); }
 
-  ScopeT popScope() {
-    assert(mapStack.size() > 1 && "Cannot pop the last scope");
-    return mapStack.pop_back_val();
-  }
+  /// The deepest nesting depth seen so far.
+  unsigned maxDepth = 0;
 
-  // This class lets you insert into the top scope.
-  ValueT &operator[](const KeyT &key) { return mapStack.back()[key]; }
+  /// The number of connects visited so far.
+  size_t numConnects = 0;
 
 private:
-  StackT mapStack;
+  struct Slot {
+    /// The destination, or null if this slot is no longer in use.
+    FieldRef key;
+    Operation *driver;
+    /// The scope in which the driver was set.
+    unsigned depth;
+  };
+
+  /// The previous state of a slot before it was first changed in a scope.
+  struct UndoEntry {
+    unsigned slot;
+    Operation *driver;
+    unsigned depth;
+    /// Whether the slot was created in the scope.
+    bool created;
+  };
+
+  DenseMap<FieldRef, unsigned> slotIndices;
+  SmallVector<Slot> slots;
+  SmallVector<UndoEntry> undoLog;
+  SmallVector<size_t> scopeStarts;
 };
 
-/// This is a determistic mapping of a FieldRef to the last operation which set
-/// a value to it.
-using ScopedDriverMap = HashTableStack<FieldRef, Operation *>;
-using DriverMap = ScopedDriverMap::ScopeT;
+using DriverMap = ScopedDriverMap::Scope;
 
 //===----------------------------------------------------------------------===//
 // Last Connect Resolver
@@ -139,25 +185,23 @@ public:
   /// Returns true if an old connect was erased.
   bool recordConnect(FieldRef dest, Operation *connection) {
     // Try to insert, if it doesn't insert, replace the previous value.
-    auto itAndInserted = driverMap.getLastScope().insert({dest, connection});
+    auto [driver, inserted] = driverMap.insert(dest, connection);
     if (isStaticSingleConnect(connection)) {
       // There should be no non-null driver already, Verifier checks this.
-      assert(itAndInserted.second || !itAndInserted.first->second);
-      if (!itAndInserted.second)
-        itAndInserted.first->second = connection;
+      assert(inserted || !driver);
+      driver = connection;
       return false;
     }
     assert(isLastConnect(connection));
-    if (!std::get<1>(itAndInserted)) {
-      auto iterator = std::get<0>(itAndInserted);
+    if (!inserted) {
       auto changed = false;
       // Delete the old connection if it exists. Null connections are inserted
       // on declarations.
-      if (auto *oldConnect = iterator->second) {
+      if (auto *oldConnect = driver) {
         oldConnect->erase();
         changed = true;
       }
-      iterator->second = connection;
+      driver = connection;
       return changed;
     }
     return false;
@@ -224,7 +268,7 @@ public:
       // If it is a leaf node with Flow::Sink or Flow::Duplex, it must be
       // initialized.
       if (flow != Flow::Source)
-        driverMap[{value, id}] = nullptr;
+        driverMap.set({value, id}, nullptr);
     };
     declare(type, flow);
   }
@@ -288,7 +332,7 @@ public:
     auto builder = OpBuilder(op->getBlock(), ++Block::iterator(op));
     auto fn = [&](Value value) {
       auto connect = builder.create<ConnectOp>(value.getLoc(), value, value);
-      driverMap[getFieldRefFromValue(value)] = connect;
+      driverMap.set(getFieldRefFromValue(value), connect);
     };
     foreachSubelement(builder, op.getResult(), fn);
   }
@@ -299,7 +343,7 @@ public:
     auto builder = OpBuilder(op->getBlock(), ++Block::iterator(op));
     auto fn = [&](Value value) {
       auto connect = builder.create<ConnectOp>(value.getLoc(), value, value);
-      driverMap[getFieldRefFromValue(value)] = connect;
+      driverMap.set(getFieldRefFromValue(value), connect);
     };
     foreachSubelement(builder, op.getResult(), fn);
   }
@@ -322,14 +366,17 @@ public:
   }
 
   void visitStmt(ConnectOp op) {
+    ++driverMap.numConnects;
     recordConnect(getFieldRefFromValue(op.getDest()), op);
   }
 
   void visitStmt(StrictConnectOp op) {
+    ++driverMap.numConnects;
     recordConnect(getFieldRefFromValue(op.getDest()), op);
   }
 
   void visitStmt(RefDefineOp op) {
+    ++driverMap.numConnects;
     recordConnect(getFieldRefFromValue(op.getDest()), op);
   }
 
@@ -353,27 +400,32 @@ public:
   /// then there is an incomplete initialization error.
   void mergeScopes(Location loc, DriverMap &thenScope, DriverMap &elseScope,
                    Value thenCondition) {
+    // Index the `else` scope to find the destinations set on both sides.
+    DenseMap<FieldRef, unsigned> elseIndices;
+    for (unsigned i = 0, e = elseScope.size(); i != e; ++i)
+      elseIndices.insert({elseScope[i].first, i});
 
     // Process all connects in the `then` block.
     for (auto &destAndConnect : thenScope) {
       auto dest = std::get<0>(destAndConnect);
       auto thenConnect = std::get<1>(destAndConnect);
 
-      auto outerIt = driverMap.find(dest);
-      if (outerIt == driverMap.end()) {
+      auto outerConnectOpt = driverMap.lookup(dest);
+      if (!outerConnectOpt) {
         // `dest` is set in `then` only. This indicates it was created in the
         // `then` block, so just copy it into the outer scope.
-        driverMap[dest] = thenConnect;
+        driverMap.set(dest, thenConnect);
         continue;
       }
 
-      auto elseIt = elseScope.find(dest);
-      if (elseIt != elseScope.end()) {
+      auto elseIt = elseIndices.find(dest);
+      if (elseIt != elseIndices.end()) {
         // `dest` is set in `then` and `else`. We need to combine them into and
         // delete any previous connect.
 
         // Create a new connect with `mux(p, then, else)`.
-        auto &elseConnect = std::get<1>(*elseIt);
+        auto &elseEntry = elseScope[elseIt->second];
+        auto *elseConnect = elseEntry.second;
         OpBuilder connectBuilder(elseConnect);
         auto newConnect = flattenConditionalConnections(
             connectBuilder, loc, getDestinationValue(thenConnect),
@@ -385,11 +437,11 @@ public:
         recordConnect(dest, newConnect);
 
         // Do not process connect in the else scope.
-        elseScope.erase(dest);
+        elseEntry.first = {};
         continue;
       }
 
-      auto &outerConnect = std::get<1>(*outerIt);
+      auto *outerConnect = *outerConnectOpt;
       if (!outerConnect) {
         if (isLastConnect(thenConnect)) {
           // `dest` is null in the outer scope. This indicate an initialization
@@ -397,7 +449,7 @@ public:
           thenConnect->erase();
         } else {
           assert(isStaticSingleConnect(thenConnect));
-          driverMap[dest] = thenConnect;
+          driverMap.set(dest, thenConnect);
         }
         continue;
       }
@@ -418,16 +470,19 @@ public:
     for (auto &destAndConnect : elseScope) {
       auto dest = std::get<0>(destAndConnect);
       auto elseConnect = std::get<1>(destAndConnect);
+      // Skip connects already merged with the `then` block.
+      if (!dest.getValue())
+        continue;
 
-      auto outerIt = driverMap.find(dest);
-      if (outerIt == driverMap.end()) {
+      auto outerConnectOpt = driverMap.lookup(dest);
+      if (!outerConnectOpt) {
         // `dest` is set in `else` only. This indicates it was created in the
         // `else` block, so just copy it into the outer scope.
-        driverMap[dest] = elseConnect;
+        driverMap.set(dest, elseConnect);
         continue;
       }
 
-      auto &outerConnect = std::get<1>(*outerIt);
+      auto *outerConnect = *outerConnectOpt;
       if (!outerConnect) {
         if (isLastConnect(elseConnect)) {
           // `dest` is null in the outer scope. This indicate an initialization
@@ -435,7 +490,7 @@ public:
           elseConnect->erase();
         } else {
           assert(isStaticSingleConnect(elseConnect));
-          driverMap[dest] = elseConnect;
+          driverMap.set(dest, elseConnect);
         }
         continue;
       }
@@ -624,6 +679,12 @@ public:
   bool run(FModuleOp op);
   LogicalResult checkInitialization();
 
+  /// The number of connects in the module.
+  size_t getNumConnects() const { return driverMap.numConnects; }
+
+  /// The deepest nesting of when blocks in the module.
+  unsigned getMaxWhenDepth() const { return driverMap.maxDepth; }
+
 private:
   /// The outermost scope of the module body.
   ScopedDriverMap driverMap;
@@ -653,10 +714,12 @@ bool ModuleVisitor::run(FModuleOp module) {
 }
 
 void ModuleVisitor::visitStmt(ConnectOp op) {
+  ++driverMap.numConnects;
   anythingChanged |= recordConnect(getFieldRefFromValue(op.getDest()), op);
 }
 
 void ModuleVisitor::visitStmt(StrictConnectOp op) {
+  ++driverMap.numConnects;
   anythingChanged |= recordConnect(getFieldRefFromValue(op.getDest()), op);
 }
 
@@ -670,14 +733,12 @@ void ModuleVisitor::visitStmt(WhenOp whenOp) {
 /// running on a module. Returns failure in the event of bad initialization.
 LogicalResult ModuleVisitor::checkInitialization() {
   bool failed = false;
-  for (auto destAndConnect : driverMap.getLastScope()) {
+  driverMap.forEachOutermost([&](FieldRef dest, Operation *connect) {
     // If there is valid connection to this destination, everything is good.
-    auto *connect = std::get<1>(destAndConnect);
     if (connect)
-      continue;
+      return;
 
     // Get the op which defines the sink, and emit an error.
-    FieldRef dest = std::get<0>(destAndConnect);
     auto loc = dest.getValue().getLoc();
     auto *definingOp = dest.getDefiningOp();
     if (auto mod = dyn_cast<FModuleLike>(definingOp))
@@ -690,7 +751,7 @@ LogicalResult ModuleVisitor::checkInitialization() {
           << "\" not fully initialized in module \""
           << definingOp->getParentOfType<FModuleLike>().getModuleName() << "\"";
     failed = true;
-  }
+  });
   if (failed)
     return failure();
   return success();
@@ -710,6 +771,8 @@ void ExpandWhensPass::runOnOperation() {
   ModuleVisitor visitor;
   if (!visitor.run(getOperation()))
     markAllAnalysesPreserved();
+  numConnects += visitor.getNumConnects();
+  maxWhenDepth.updateMax(visitor.getMaxWhenDepth());
   if (failed(visitor.checkInitialization()))
     signalPassFailure();
 }
@@ -23,6 +23,7 @@
 #include "circt/Dialect/HW/HWOps.h"
 #include "circt/Dialect/SV/SVOps.h"
 #include "mlir/IR/ImplicitLocOpBuilder.h"
+#include "mlir/IR/Threading.h"
 #include "llvm/ADT/DepthFirstIterator.h"
 #include "llvm/ADT/TypeSwitch.h"
 #include "llvm/Support/Debug.h"
@@ -536,6 +537,16 @@ struct FieldAndNLA {
   FlatSymbolRefAttr nlaSym;
 };
 
+/// The leaves of views which are annotated inside one module. These are
+/// collected for all modules in parallel.
+struct ModuleLeaves {
+  SmallVector<std::pair<IntegerAttr, FieldAndNLA>> leaves;
+  /// The number of annotations removed from the module.
+  unsigned numAnnosRemoved = 0;
+  /// Whether any malformed annotations were found.
+  bool failed = false;
+};
+
 /// Stores the arguments required to construct the verbatim xmr assignment.
 struct VerbatimXMRbuilder {
   Value val;
@@ -649,6 +660,23 @@ private:
   /// Return the module associated with this value.
   HWModuleLike getEnclosingModule(Value value, FlatSymbolRefAttr sym = {});
 
+  /// Collect the leaves of views which are annotated on the operations and
+  /// ports of a module.  This only modifies the module itself and may run
+  /// concurrently for different modules.
+  void collectLeaves(FModuleOp module, ModuleLeaves &moduleLeaves);
+
+  /// Return true if a module is instantiated under the DUT.  This is memoized
+  /// since it is queried for every interface of a companion.
+  bool isUnderDUT(FModuleOp module) {
+    auto [it, inserted] = underDUT.insert({module, false});
+    if (inserted)
+      it->second = instancePaths->instanceGraph.isAncestor(module, dut);
+    return it->second;
+  }
+
+  /// The memoized results of `isUnderDUT`.
+  DenseMap<Operation *, bool> underDUT;
+
   /// Inforamtion about how the circuit should be extracted.  This will be
   /// non-empty if an extraction annotation is found.
   std::optional<ExtractionInfo> maybeExtractInfo = std::nullopt;
@@ -736,6 +764,10 @@ private:
   /// A store of the YAML representation of interfaces.
   DenseMap<Attribute, sv::InterfaceOp> interfaceMap;
 
+  /// Write the YAML representation of the interfaces to the file named by the
+  /// `GrandCentralHierarchyFileAnnotation`.
+  void emitHierarchyYAML(SmallVectorImpl<sv::InterfaceOp> &interfaces);
+
   /// Returns an operation's `inner_sym`, adding one if necessary.
   StringAttr getOrAddInnerSym(Operation *op);
 
@@ -1539,6 +1571,120 @@ HWModuleLike GrandCentralPass::getEnclosingModule(Value value,
   return op->getParentOfType<HWModuleLike>();
 }
 
+/// Collect the leaves of views which are annotated on the operations and ports
+/// of a module.  Annotations are removed as they are discovered and if they are
+/// not malformed.
+void GrandCentralPass::collectLeaves(FModuleOp module,
+                                     ModuleLeaves &moduleLeaves) {
+  // Maybe get an "id" from an Annotation.  Generate error messages on the op if
+  // no "id" exists.
+  auto getID = [&](Operation *op,
+                   Annotation annotation) -> std::optional<IntegerAttr> {
+    auto id = annotation.getMember<IntegerAttr>("id");
+    if (!id) {
+      op->emitOpError()
+          << "contained a malformed "
+             "'sifive.enterprise.grandcentral.AugmentedGroundType' annotation "
+             "that did not contain an 'id' field";
+      moduleLeaves.failed = true;
+      return std::nullopt;
+    }
+    return id;
+  };
+
+  module.walk([&](Operation *op) {
+    TypeSwitch<Operation *>(op)
+        .Case<RegOp, RegResetOp, WireOp, NodeOp>([&](auto op) {
+          AnnotationSet::removeAnnotations(op, [&](Annotation annotation) {
+            if (!annotation.isClass(augmentedGroundTypeClass))
+              return false;
+            auto maybeID = getID(op, annotation);
+            if (!maybeID)
+              return false;
+            auto sym =
+                annotation.getMember<FlatSymbolRefAttr>("circt.nonlocal");
+            moduleLeaves.leaves.push_back(
+                {*maybeID, {{op.getResult(), annotation.getFieldID()}, sym}});
+            ++moduleLeaves.numAnnosRemoved;
+            return true;
+          });
+        })
+        // TODO: Figure out what to do with this.
+        .Case<InstanceOp>([&](auto op) {
+          AnnotationSet::removePortAnnotations(op, [&](unsigned i,
+                                                       Annotation annotation) {
+            if (!annotation.isClass(augmentedGroundTypeClass))
+              return false;
+            op.emitOpError()
+                << "is marked as an interface element, but this should be "
+                   "impossible due to how the Chisel Grand Central API works";
+            moduleLeaves.failed = true;
+            return false;
+          });
+        })
+        .Case<MemOp>([&](auto op) {
+          AnnotationSet::removeAnnotations(op, [&](Annotation annotation) {
+            if (!annotation.isClass(augmentedGroundTypeClass))
+              return false;
+            op.emitOpError()
+                << "is marked as an interface element, but this does not make "
+                   "sense (is there a scattering bug or do you have a "
+                   "malformed hand-crafted MLIR circuit?)";
+            moduleLeaves.failed = true;
+            return false;
+          });
+          AnnotationSet::removePortAnnotations(
+              op, [&](unsigned i, Annotation annotation) {
+                if (!annotation.isClass(augmentedGroundTypeClass))
+                  return false;
+                op.emitOpError()
+                    << "has port '" << i
+                    << "' marked as an interface element, but this does not "
+                       "make sense (is there a scattering bug or do you have a "
+                       "malformed hand-crafted MLIR circuit?)";
+                moduleLeaves.failed = true;
+                return false;
+              });
+        });
+  });
+
+  // Handle annotations on the ports.
+  AnnotationSet::removePortAnnotations(module, [&](unsigned i,
+                                                   Annotation annotation) {
+    if (!annotation.isClass(augmentedGroundTypeClass))
+      return false;
+    auto maybeID = getID(module, annotation);
+    if (!maybeID)
+      return false;
+    auto sym = annotation.getMember<FlatSymbolRefAttr>("circt.nonlocal");
+    moduleLeaves.leaves.push_back(
+        {*maybeID, {{module.getArgument(i), annotation.getFieldID()}, sym}});
+    ++moduleLeaves.numAnnosRemoved;
+    return true;
+  });
+}
+
+/// Write the YAML representation of the interfaces to the file named by the
+/// `GrandCentralHierarchyFileAnnotation`.
+void GrandCentralPass::emitHierarchyYAML(
+    SmallVectorImpl<sv::InterfaceOp> &interfaces) {
+  std::string yamlString;
+  llvm::raw_string_ostream stream(yamlString);
+  ::yaml::Context yamlContext({interfaceMap});
+  llvm::yaml::Output yout(stream);
+  yamlize(yout, interfaces, true, yamlContext);
+  stream.flush();
+
+  auto circuitOp = getOperation();
+  auto builder = OpBuilder::atBlockBegin(circuitOp.getBodyBlock());
+  builder.create<sv::VerbatimOp>(builder.getUnknownLoc(), yamlString)
+      ->setAttr("output_file",
+                hw::OutputFileAttr::getFromFilename(
+                    &getContext(), maybeHierarchyFileYAML->getValue(),
+                    /*excludFromFileList=*/true));
+  LLVM_DEBUG({ llvm::dbgs() << "Generated YAML:" << yamlString << "\n"; });
+}
+
 /// This method contains the business logic of this pass.
 void GrandCentralPass::runOnOperation() {
   LLVM_DEBUG(llvm::dbgs() << "===- Running Grand Central Views/Interface Pass "
@@ -1684,20 +1830,8 @@ void GrandCentralPass::runOnOperation() {
   if (worklist.empty()) {
     if (!maybeHierarchyFileYAML)
       return markAllAnalysesPreserved();
-    std::string yamlString;
-    llvm::raw_string_ostream stream(yamlString);
-    ::yaml::Context yamlContext({interfaceMap});
-    llvm::yaml::Output yout(stream);
-    OpBuilder builder(circuitOp);
     SmallVector<sv::InterfaceOp, 0> interfaceVec;
-    yamlize(yout, interfaceVec, true, yamlContext);
-    builder.setInsertionPointToStart(circuitOp.getBodyBlock());
-    builder.create<sv::VerbatimOp>(builder.getUnknownLoc(), yamlString)
-        ->setAttr("output_file",
-                  hw::OutputFileAttr::getFromFilename(
-                      &getContext(), maybeHierarchyFileYAML->getValue(),
-                      /*excludFromFileList=*/true));
-    LLVM_DEBUG({ llvm::dbgs() << "Generated YAML:" << yamlString << "\n"; });
+    emitHierarchyYAML(interfaceVec);
     return;
   }
 
@@ -1707,22 +1841,6 @@ void GrandCentralPass::runOnOperation() {
   // break this.
   auto builder = OpBuilder::atBlockEnd(circuitOp.getBodyBlock());
 
-  // Maybe get an "id" from an Annotation.  Generate error messages on the op if
-  // no "id" exists.
-  auto getID = [&](Operation *op,
-                   Annotation annotation) -> std::optional<IntegerAttr> {
-    auto id = annotation.getMember<IntegerAttr>("id");
-    if (!id) {
-      op->emitOpError()
-          << "contained a malformed "
-             "'sifive.enterprise.grandcentral.AugmentedGroundType' annotation "
-             "that did not contain an 'id' field";
-      removalError = true;
-      return std::nullopt;
-    }
-    return id;
-  };
-
   /// TODO: Handle this differently to allow construction of an optionsl
   auto instancePathCache = InstancePathCache(getAnalysis<InstanceGraph>());
   instancePaths = &instancePathCache;
@@ -1780,222 +1898,165 @@ void GrandCentralPass::runOnOperation() {
   /// Walk the circuit and extract all information related to scattered Grand
   /// Central annotations.  This is used to populate: (1) the companionIDMap and
   /// (2) the leafMap.  Annotations are removed as they are discovered and if
-  /// they are not malformed.
+  /// they are not malformed.  The leaves are collected from all modules in
+  /// parallel and merged in circuit order.  Every module is visited even if
+  /// another one is malformed, and `parallelFor` reports the diagnostics in
+  /// module order, such that the errors do not depend on thread scheduling.
   removalError = false;
-  circuitOp.walk([&](Operation *op) {
-    TypeSwitch<Operation *>(op)
-        .Case<RegOp, RegResetOp, WireOp, NodeOp>([&](auto op) {
-          AnnotationSet::removeAnnotations(op, [&](Annotation annotation) {
-            if (!annotation.isClass(augmentedGroundTypeClass))
-              return false;
-            auto maybeID = getID(op, annotation);
-            if (!maybeID)
-              return false;
-            auto sym =
-                annotation.getMember<FlatSymbolRefAttr>("circt.nonlocal");
-            leafMap[*maybeID] = {{op.getResult(), annotation.getFieldID()},
-                                 sym};
-            ++numAnnosRemoved;
-            return true;
-          });
-        })
-        // TODO: Figure out what to do with this.
-        .Case<InstanceOp>([&](auto op) {
-          AnnotationSet::removePortAnnotations(op, [&](unsigned i,
-                                                       Annotation annotation) {
-            if (!annotation.isClass(augmentedGroundTypeClass))
-              return false;
-            op.emitOpError()
-                << "is marked as an interface element, but this should be "
-                   "impossible due to how the Chisel Grand Central API works";
-            removalError = true;
-            return false;
-          });
-        })
-        .Case<MemOp>([&](auto op) {
-          AnnotationSet::removeAnnotations(op, [&](Annotation annotation) {
-            if (!annotation.isClass(augmentedGroundTypeClass))
-              return false;
-            op.emitOpError()
-                << "is marked as an interface element, but this does not make "
-                   "sense (is there a scattering bug or do you have a "
-                   "malformed hand-crafted MLIR circuit?)";
-            removalError = true;
-            return false;
-          });
-          AnnotationSet::removePortAnnotations(
-              op, [&](unsigned i, Annotation annotation) {
-                if (!annotation.isClass(augmentedGroundTypeClass))
-                  return false;
-                op.emitOpError()
-                    << "has port '" << i
-                    << "' marked as an interface element, but this does not "
-                       "make sense (is there a scattering bug or do you have a "
-                       "malformed hand-crafted MLIR circuit?)";
-                removalError = true;
-                return false;
-              });
-        })
-        .Case<FModuleOp>([&](FModuleOp op) {
-          // Handle annotations on the ports.
-          AnnotationSet::removePortAnnotations(op, [&](unsigned i,
-                                                       Annotation annotation) {
-            if (!annotation.isClass(augmentedGroundTypeClass))
-              return false;
-            auto maybeID = getID(op, annotation);
-            if (!maybeID)
-              return false;
-            auto sym =
-                annotation.getMember<FlatSymbolRefAttr>("circt.nonlocal");
-            leafMap[*maybeID] = {{op.getArgument(i), annotation.getFieldID()},
-                                 sym};
-            ++numAnnosRemoved;
-            return true;
-          });
+  SmallVector<FModuleOp> modules(circuitOp.getBodyBlock()->getOps<FModuleOp>());
+  SmallVector<ModuleLeaves> moduleLeaves(modules.size());
+  mlir::parallelFor(&getContext(), 0, modules.size(), [&](size_t index) {
+    collectLeaves(modules[index], moduleLeaves[index]);
+  });
+  for (auto &leaves : moduleLeaves) {
+    for (auto &[id, leaf] : leaves.leaves)
+      leafMap[id] = leaf;
+    numAnnosRemoved += leaves.numAnnosRemoved;
+    removalError |= leaves.failed;
+  }
 
-          // Handle annotations on the module.
-          AnnotationSet::removeAnnotations(op, [&](Annotation annotation) {
-            if (!annotation.getClass().startswith(viewAnnoClass))
-              return false;
-            auto isNonlocal = annotation.getMember<FlatSymbolRefAttr>(
-                                  "circt.nonlocal") != nullptr;
-            auto name = annotation.getMember<StringAttr>("name");
-            auto id = annotation.getMember<IntegerAttr>("id");
-            if (!id) {
-              op.emitOpError()
-                  << "has a malformed "
-                     "'sifive.enterprise.grandcentral.ViewAnnotation' that did "
-                     "not contain an 'id' field with an 'IntegerAttr' value";
-              goto FModuleOp_error;
-            }
-            if (!name) {
-              op.emitOpError()
-                  << "has a malformed "
-                     "'sifive.enterprise.grandcentral.ViewAnnotation' that did "
-                     "not contain a 'name' field with a 'StringAttr' value";
-              goto FModuleOp_error;
-            }
+  // Handle the views and companions annotated on modules.  These change the
+  // attributes of instances and other modules, so they are handled
+  // sequentially.
+  for (auto op : modules) {
+    // Handle annotations on the module.
+    AnnotationSet::removeAnnotations(op, [&](Annotation annotation) {
+      if (!annotation.getClass().startswith(viewAnnoClass))
+        return false;
+      auto isNonlocal =
+          annotation.getMember<FlatSymbolRefAttr>("circt.nonlocal") != nullptr;
+      auto name = annotation.getMember<StringAttr>("name");
+      auto id = annotation.getMember<IntegerAttr>("id");
+      if (!id) {
+        op.emitOpError()
+            << "has a malformed "
+               "'sifive.enterprise.grandcentral.ViewAnnotation' that did "
+               "not contain an 'id' field with an 'IntegerAttr' value";
+        goto FModuleOp_error;
+      }
+      if (!name) {
+        op.emitOpError()
+            << "has a malformed "
+               "'sifive.enterprise.grandcentral.ViewAnnotation' that did "
+               "not contain a 'name' field with a 'StringAttr' value";
+        goto FModuleOp_error;
+      }
 
-            // If this is a companion, then:
-            //   1. Insert it into the companion map
-            //   2. Create a new mapping module.
-            //   3. Instatiate the mapping module in the companion.
-            //   4. Check that the companion is instantated exactly once.
-            //   5. Set attributes on that lone instance so it will become a
-            //      bind if extraction information was provided.  If a DUT is
-            //      known, then anything in the test harness will not be
-            //      extracted.
-            if (annotation.getClass() == companionAnnoClass) {
-              builder.setInsertionPointToEnd(circuitOp.getBodyBlock());
-
-              companionIDMap[id] = {name.getValue(), op, isNonlocal};
-
-              // Assert that the companion is instantiated once and only once.
-              auto instance = exactlyOneInstance(op, "companion");
-              if (!instance)
-                goto FModuleOp_error;
-
-              // If no extraction info was provided, exit.  Otherwise, setup the
-              // lone instance of the companion to be lowered as a bind.
-              if (!maybeExtractInfo) {
-                ++numAnnosRemoved;
-                return true;
-              }
+      // If this is a companion, then:
+      //   1. Insert it into the companion map
+      //   2. Create a new mapping module.
+      //   3. Instatiate the mapping module in the companion.
+      //   4. Check that the companion is instantated exactly once.
+      //   5. Set attributes on that lone instance so it will become a
+      //      bind if extraction information was provided.  If a DUT is
+      //      known, then anything in the test harness will not be
+      //      extracted.
+      if (annotation.getClass() == companionAnnoClass) {
+        builder.setInsertionPointToEnd(circuitOp.getBodyBlock());
+
+        companionIDMap[id] = {name.getValue(), op, isNonlocal};
+
+        // Assert that the companion is instantiated once and only once.
+        auto instance = exactlyOneInstance(op, "companion");
+        if (!instance)
+          goto FModuleOp_error;
+
+        // If no extraction info was provided, exit.  Otherwise, setup the
+        // lone instance of the companion to be lowered as a bind.
+        if (!maybeExtractInfo) {
+          ++numAnnosRemoved;
+          return true;
+        }
 
-              // If the companion is instantiated above the DUT, then don't
-              // extract it.
-              if (dut && !instancePaths->instanceGraph.isAncestor(op, dut)) {
-                ++numAnnosRemoved;
-                return true;
-              }
+        // If the companion is instantiated above the DUT, then don't
+        // extract it.
+        if (dut && !isUnderDUT(op)) {
+          ++numAnnosRemoved;
+          return true;
+        }
 
-              // Lower the companion to a bind unless the user told us
-              // explicitly not to.
-              if (!instantiateCompanionOnly)
-                (*instance)->setAttr("lowerToBind", builder.getUnitAttr());
+        // Lower the companion to a bind unless the user told us
+        // explicitly not to.
+        if (!instantiateCompanionOnly)
+          (*instance)->setAttr("lowerToBind", builder.getUnitAttr());
+
+        (*instance)->setAttr(
+            "output_file",
+            hw::OutputFileAttr::getFromFilename(
+                &getContext(), maybeExtractInfo->bindFilename.getValue(),
+                /*excludeFromFileList=*/true));
+
+        // Look for any modules/extmodules _only_ instantiated by the
+        // companion.  If these have no output file attribute, then mark
+        // them as being extracted into the Grand Central directory.
+        InstanceGraphNode *companionNode =
+            instancePaths->instanceGraph.lookup(op);
+
+        LLVM_DEBUG({
+          llvm::dbgs() << "Found companion module: "
+                       << companionNode->getModule().getModuleName() << "\n"
+                       << "  submodules exclusively instantiated "
+                          "(including companion):\n";
+        });
 
-              (*instance)->setAttr(
-                  "output_file",
-                  hw::OutputFileAttr::getFromFilename(
-                      &getContext(), maybeExtractInfo->bindFilename.getValue(),
-                      /*excludeFromFileList=*/true));
-
-              // Look for any modules/extmodules _only_ instantiated by the
-              // companion.  If these have no output file attribute, then mark
-              // them as being extracted into the Grand Central directory.
-              InstanceGraphNode *companionNode =
-                  instancePaths->instanceGraph.lookup(op);
-
-              LLVM_DEBUG({
-                llvm::dbgs()
-                    << "Found companion module: "
-                    << companionNode->getModule().getModuleName() << "\n"
-                    << "  submodules exclusively instantiated "
-                       "(including companion):\n";
-              });
+        for (auto &node : llvm::depth_first(companionNode)) {
+          auto mod = node->getModule();
+
+          // Check to see if we should change the output directory of a
+          // module.  Only update in the following conditions:
+          //   1) The module is the companion.
+          //   2) The module is NOT instantiated by the effective DUT.
+          auto *modNode = instancePaths->instanceGraph.lookup(mod);
+          SmallVector<InstanceRecord *> instances(modNode->uses());
+          if (modNode != companionNode &&
+              dutModules.count(modNode->getModule()))
+            continue;
+
+          LLVM_DEBUG({
+            llvm::dbgs() << "    - module: " << mod.getModuleName() << "\n";
+          });
 
-              for (auto &node : llvm::depth_first(companionNode)) {
-                auto mod = node->getModule();
-
-                // Check to see if we should change the output directory of a
-                // module.  Only update in the following conditions:
-                //   1) The module is the companion.
-                //   2) The module is NOT instantiated by the effective DUT.
-                auto *modNode = instancePaths->instanceGraph.lookup(mod);
-                SmallVector<InstanceRecord *> instances(modNode->uses());
-                if (modNode != companionNode &&
-                    dutModules.count(modNode->getModule()))
-                  continue;
-
-                LLVM_DEBUG({
-                  llvm::dbgs()
-                      << "    - module: " << mod.getModuleName() << "\n";
-                });
-
-                if (auto extmodule = dyn_cast<FExtModuleOp>(*mod)) {
-                  for (auto anno : AnnotationSet(extmodule)) {
-                    if (!anno.isClass(blackBoxInlineAnnoClass) &&
-                        !anno.isClass(blackBoxPathAnnoClass))
-                      continue;
-                    if (extmodule->hasAttr("output_file"))
-                      break;
-                    extmodule->setAttr(
-                        "output_file",
-                        hw::OutputFileAttr::getAsDirectory(
-                            &getContext(),
-                            maybeExtractInfo->directory.getValue()));
-                    break;
-                  }
-                  continue;
-                }
+          if (auto extmodule = dyn_cast<FExtModuleOp>(*mod)) {
+            for (auto anno : AnnotationSet(extmodule)) {
+              if (!anno.isClass(blackBoxInlineAnnoClass) &&
+                  !anno.isClass(blackBoxPathAnnoClass))
+                continue;
+              if (extmodule->hasAttr("output_file"))
+                break;
+              extmodule->setAttr(
+                  "output_file",
+                  hw::OutputFileAttr::getAsDirectory(
+                      &getContext(), maybeExtractInfo->directory.getValue()));
+              break;
+            }
+            continue;
+          }
 
-                // Move this module under the Grand Central output directory if
-                // no pre-existing output file information is present.
-                if (!mod->hasAttr("output_file")) {
-                  mod->setAttr("output_file",
-                               hw::OutputFileAttr::getAsDirectory(
-                                   &getContext(),
-                                   maybeExtractInfo->directory.getValue(),
-                                   /*excludeFromFileList=*/true,
-                                   /*includeReplicatedOps=*/true));
-                  mod->setAttr("comment", builder.getStringAttr(
-                                              "VCS coverage exclude_file"));
-                }
-              }
+          // Move this module under the Grand Central output directory if
+          // no pre-existing output file information is present.
+          if (!mod->hasAttr("output_file")) {
+            mod->setAttr("output_file",
+                         hw::OutputFileAttr::getAsDirectory(
+                             &getContext(),
+                             maybeExtractInfo->directory.getValue(),
+                             /*excludeFromFileList=*/true,
+                             /*includeReplicatedOps=*/true));
+            mod->setAttr("comment", builder.getStringAttr(
+                                        "VCS coverage exclude_file"));
+          }
+        }
 
-              ++numAnnosRemoved;
-              return true;
-            }
+        ++numAnnosRemoved;
+        return true;
+      }
 
-            op.emitOpError()
-                << "unknown annotation class: " << annotation.getDict();
+      op.emitOpError() << "unknown annotation class: " << annotation.getDict();
 
-          FModuleOp_error:
-            removalError = true;
-            return false;
-          });
-        });
-  });
+    FModuleOp_error:
+      removalError = true;
+      return false;
+    });
+  }
 
   if (removalError)
     return signalPassFailure();
@@ -2159,9 +2220,7 @@ void GrandCentralPass::runOnOperation() {
       if (!topIface)
         topIface = iface;
       ++numInterfaces;
-      if (dut &&
-          !instancePaths->instanceGraph.isAncestor(
-              companionIDMap[ifaceBuilder.id].companion, dut) &&
+      if (dut && !isUnderDUT(companionIDMap[ifaceBuilder.id].companion) &&
           testbenchDir)
         iface->setAttr("output_file",
                        hw::OutputFileAttr::getAsDirectory(
@@ -2241,29 +2300,15 @@ void GrandCentralPass::runOnOperation() {
 
     // If the interface is associated with a companion that is instantiated
     // above the DUT (e.g.., in the test harness), then don't extract it.
-    if (dut && !instancePaths->instanceGraph.isAncestor(
-                   companionIDMap[bundle.getID()].companion, dut))
+    if (dut && !isUnderDUT(companionIDMap[bundle.getID()].companion))
       continue;
   }
 
   // If a `GrandCentralHierarchyFileAnnotation` was passed in, generate a YAML
   // representation of the interfaces that we produced with the filename that
   // that annotation provided.
-  if (maybeHierarchyFileYAML) {
-    std::string yamlString;
-    llvm::raw_string_ostream stream(yamlString);
-    ::yaml::Context yamlContext({interfaceMap});
-    llvm::yaml::Output yout(stream);
-    yamlize(yout, interfaceVec, true, yamlContext);
-
-    builder.setInsertionPointToStart(circuitOp.getBodyBlock());
-    builder.create<sv::VerbatimOp>(builder.getUnknownLoc(), yamlString)
-        ->setAttr("output_file",
-                  hw::OutputFileAttr::getFromFilename(
-                      &getContext(), maybeHierarchyFileYAML->getValue(),
-                      /*excludFromFileList=*/true));
-    LLVM_DEBUG({ llvm::dbgs() << "Generated YAML:" << yamlString << "\n"; });
-  }
+  if (maybeHierarchyFileYAML)
+    emitHierarchyYAML(interfaceVec);
 
   // Signal pass failure if any errors were found while examining circuit
   // annotations.
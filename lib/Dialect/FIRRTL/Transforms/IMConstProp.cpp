@@ -17,6 +17,7 @@
 #include "circt/Dialect/FIRRTL/FIRRTLFieldSource.h"
 #include "circt/Dialect/FIRRTL/FIRRTLInstanceGraph.h"
 #include "circt/Dialect/FIRRTL/FIRRTLUtils.h"
+#include "circt/Dialect/FIRRTL/FIRRTLValueNumbering.h"
 #include "circt/Dialect/FIRRTL/Passes.h"
 #include "circt/Support/APInt.h"
 #include "mlir/IR/Threading.h"
@@ -158,19 +159,102 @@ static llvm::raw_ostream &operator<<(llvm::raw_ostream &os,
 }
 
 namespace {
-struct IMConstPropPass : public IMConstPropBase<IMConstPropPass> {
+class ModuleSolver;
+
+/// A fact one module's solver communicates to another module's solver.
+struct Message {
+  enum class Kind {
+    /// Mark the body of the receiving module as executable.
+    MarkExecutable,
+    /// Merge `value` into the lattice value of `fieldRef`, which belongs to
+    /// the receiving module.
+    MergeLattice,
+    /// Forward the lattice values of the output port `fieldRef` of the
+    /// receiving module to `instanceResult` in the sending module, now and
+    /// whenever the port is driven.
+    ForwardPort,
+  };
 
-  void runOnOperation() override;
-  void rewriteModuleBody(FModuleOp module);
+  Kind kind;
+  FieldRef fieldRef;
+  LatticeValue value;
+  Value instanceResult;
+  ModuleSolver *sender = nullptr;
+};
 
+/// The solver state of a single module.  Each module owns the lattice values
+/// of its ports and of the values defined in its body, and keeps its own
+/// worklist.  Facts that affect other modules are not applied directly, but
+/// queued in an outbox.  This allows all modules to run their worklists in
+/// parallel, exchanging their outboxes in between rounds until no more
+/// messages are sent.
+class ModuleSolver {
+public:
+  ModuleSolver(FModuleOp module, InstanceGraph &instanceGraph,
+               const ValueNumbering &valueNumbering,
+               const DenseMap<Operation *, ModuleSolver *> &solvers)
+      : module(module), instanceGraph(instanceGraph), solvers(solvers),
+        numbering(valueNumbering.getModuleNumbering(module)) {
+    if (numbering)
+      denseLatticeValues.resize(numbering->size());
+  }
+
+  /// Mark the module as executable and its ports as overdefined, as is done
+  /// for public modules.
+  void markPublic() {
+    markBlockExecutable(module.getBodyBlock());
+    for (auto port : module.getBodyBlock()->getArguments())
+      markOverdefined(port);
+  }
+
+  FModuleOp getModule() const { return module; }
+
+  /// Process all received messages, and run the worklist to a fixpoint.
+  void solve();
+
+  /// Replace values found to be constant, and delete dead operations.
+  void rewriteModuleBody();
+
+  /// Messages queued for other modules, and messages received from them.
+  SmallVector<std::pair<ModuleSolver *, Message>> outbox;
+  SmallVector<Message> inbox;
+
+  /// The number of operations folded and erased by `rewriteModuleBody`, and
+  /// whether it changed the module at all.
+  size_t numFolded = 0;
+  size_t numErased = 0;
+  bool changed = false;
+
+private:
   /// Returns true if the given block is executable.
   bool isBlockExecutable(Block *block) const {
-    return executableBlocks.count(block);
+    return executable && block == module.getBodyBlock();
+  }
+
+  /// Return the lattice value of a field, which is unknown if the field has
+  /// not been computed yet.
+  LatticeValue lookupLatticeValue(FieldRef value) const {
+    if (auto number = getDenseNumber(value))
+      return denseLatticeValues[*number];
+    return latticeValues.lookup(value);
+  }
+
+  /// Return a reference to the lattice value of a field.
+  LatticeValue &getLatticeValue(FieldRef value) {
+    if (auto number = getDenseNumber(value))
+      return denseLatticeValues[*number];
+    return latticeValues[value];
+  }
+
+  /// Return the index into `denseLatticeValues` of a field, if it has one.
+  std::optional<unsigned> getDenseNumber(FieldRef value) const {
+    if (!numbering || value.getFieldID() != 0)
+      return std::nullopt;
+    return numbering->lookupLocal(value.getValue());
   }
 
   bool isOverdefined(FieldRef value) const {
-    auto it = latticeValues.find(value);
-    return it != latticeValues.end() && it->second.isOverdefined();
+    return lookupLatticeValue(value).isOverdefined();
   }
 
   // Mark the given value as overdefined. If the value is an aggregate,
@@ -191,7 +275,7 @@ struct IMConstPropPass : public IMConstPropBase<IMConstPropPass> {
   /// Mark the given value as overdefined. This means that we cannot refine a
   /// specific constant for this value.
   void markOverdefined(FieldRef value) {
-    auto &entry = latticeValues[value];
+    auto &entry = getLatticeValue(value);
     if (!entry.isOverdefined()) {
       LLVM_DEBUG({
         logger.getOStream()
@@ -220,16 +304,13 @@ struct IMConstPropPass : public IMConstPropBase<IMConstPropPass> {
     // Don't even do a map lookup if from has no info in it.
     if (source.isUnknown())
       return;
-    mergeLatticeValue(value, latticeValues[value], source);
+    mergeLatticeValue(value, getLatticeValue(value), source);
   }
 
   void mergeLatticeValue(FieldRef result, FieldRef from) {
     // If 'from' hasn't been computed yet, then it is unknown, don't do
     // anything.
-    auto it = latticeValues.find(from);
-    if (it == latticeValues.end())
-      return;
-    mergeLatticeValue(result, it->second);
+    mergeLatticeValue(result, lookupLatticeValue(from));
   }
 
   void mergeLatticeValue(Value result, Value from) {
@@ -255,7 +336,7 @@ struct IMConstPropPass : public IMConstPropBase<IMConstPropPass> {
       return;
 
     // If we've changed this value then revisit all the users.
-    auto &valueEntry = latticeValues[value];
+    auto &valueEntry = getLatticeValue(value);
     if (valueEntry != source) {
       changedLatticeValueWorklist.push_back(value);
       valueEntry = source;
@@ -297,15 +378,36 @@ struct IMConstPropPass : public IMConstPropBase<IMConstPropPass> {
   void visitNode(NodeOp node);
   void visitOperation(Operation *op);
 
-private:
+  /// Queue a message for the solver of another module.
+  void sendMessage(ModuleSolver *target, Message message) {
+    outbox.push_back({target, message});
+  }
+
+  /// Return the solver of a module, or null for modules without a body.
+  ModuleSolver *getSolver(Operation *module) const {
+    return solvers.lookup(module);
+  }
+
+  /// The module this solver is responsible for.
+  FModuleOp module;
+
   /// This is the current instance graph for the Circuit.
-  InstanceGraph *instanceGraph = nullptr;
+  InstanceGraph &instanceGraph;
+
+  /// The solvers of all modules in the circuit.
+  const DenseMap<Operation *, ModuleSolver *> &solvers;
 
-  /// This keeps track of the current state of each tracked value.
+  /// The dense numbering of the values in the module, if available.
+  const ValueNumbering::ModuleNumbering *numbering;
+
+  /// This keeps track of the current state of each tracked value.  Whole
+  /// values are indexed by their number, and only fields of aggregates and
+  /// values created after the numbering are kept in the map.
+  SmallVector<LatticeValue, 0> denseLatticeValues;
   DenseMap<FieldRef, LatticeValue> latticeValues;
 
-  /// The set of blocks that are known to execute, or are intrinsically live.
-  SmallPtrSet<Block *, 16> executableBlocks;
+  /// Whether the body of the module is known to execute.
+  bool executable = false;
 
   /// A worklist of values whose LatticeValue recently changed, indicating the
   /// users need to be reprocessed.
@@ -319,8 +421,8 @@ private:
   llvm::DenseMap<Value, FieldRef> valueToFieldRef;
 
   /// This keeps track of users the instance results that correspond to output
-  /// ports.
-  DenseMap<BlockArgument, llvm::TinyPtrVector<Value>>
+  /// ports, and the solvers of the modules containing them.
+  DenseMap<BlockArgument, SmallVector<std::pair<Value, ModuleSolver *>, 1>>
       resultPortToInstanceResultMapping;
 
 #ifndef NDEBUG
@@ -328,24 +430,108 @@ private:
   llvm::ScopedPrinter logger{llvm::dbgs()};
 #endif
 };
+
+struct IMConstPropPass : public IMConstPropBase<IMConstPropPass> {
+  void runOnOperation() override;
+};
 } // end anonymous namespace
 
 // TODO: handle annotations: [[OptimizableExtModuleAnnotation]]
 void IMConstPropPass::runOnOperation() {
   auto circuit = getOperation();
-  LLVM_DEBUG(
-      { logger.startLine() << "IMConstProp : " << circuit.getName() << "\n"; });
+  LLVM_DEBUG({
+    llvm::dbgs() << "===- IMConstProp : " << circuit.getName() << " -===\n";
+  });
 
-  instanceGraph = &getAnalysis<InstanceGraph>();
+  auto &instanceGraph = getAnalysis<InstanceGraph>();
+  auto &valueNumbering = getAnalysis<ValueNumbering>();
 
-  // Mark the input ports of public modules as being overdefined.
+  // Create a solver for each module.
+  SmallVector<std::unique_ptr<ModuleSolver>> solverStorage;
+  DenseMap<Operation *, ModuleSolver *> solvers;
   for (auto module : circuit.getBodyBlock()->getOps<FModuleOp>()) {
-    if (module.isPublic()) {
+    solverStorage.push_back(
+        std::make_unique<ModuleSolver>(module, instanceGraph, valueNumbering,
+                                       solvers));
+    solvers.insert({module, solverStorage.back().get()});
+  }
+
+  // Public modules are executable, and their ports are overdefined.
+  SmallVector<ModuleSolver *> active;
+  for (auto &solver : solverStorage) {
+    if (solver->getModule().isPublic()) {
+      solver->markPublic();
+      active.push_back(solver.get());
+    }
+  }
+
+  // Solve the modules in rounds.  In each round, every module with pending
+  // work runs its worklist to a local fixpoint in parallel.  The messages sent
+  // in a round are delivered in a deterministic order before the next one.
+  while (!active.empty()) {
+    mlir::parallelForEach(circuit.getContext(), active,
+                          [](ModuleSolver *solver) { solver->solve(); });
+    SmallVector<ModuleSolver *> nextActive;
+    for (auto *solver : active) {
+      for (auto &[target, message] : solver->outbox) {
+        if (target->inbox.empty())
+          nextActive.push_back(target);
+        target->inbox.push_back(message);
+      }
+      solver->outbox.clear();
+    }
+    active = std::move(nextActive);
+  }
+
+  // Rewrite any constants in the modules.
+  mlir::parallelForEach(circuit.getContext(), solverStorage,
+                        [](auto &solver) { solver->rewriteModuleBody(); });
+  bool changed = false;
+  for (auto &solver : solverStorage) {
+    numFoldedOp += solver->numFolded;
+    numErasedOp += solver->numErased;
+    changed |= solver->changed;
+  }
+
+  // Keep the analyses, including the value numbering, for later passes if
+  // nothing was rewritten.
+  if (!changed)
+    markAllAnalysesPreserved();
+}
+
+void ModuleSolver::solve() {
+  for (auto &message : inbox) {
+    switch (message.kind) {
+    case Message::Kind::MarkExecutable:
       markBlockExecutable(module.getBodyBlock());
-      for (auto port : module.getBodyBlock()->getArguments())
-        markOverdefined(port);
+      break;
+    case Message::Kind::MergeLattice:
+      mergeLatticeValue(message.fieldRef, message.value);
+      break;
+    case Message::Kind::ForwardPort: {
+      auto port = message.fieldRef.getValue().cast<BlockArgument>();
+      resultPortToInstanceResultMapping[port].push_back(
+          {message.instanceResult, message.sender});
+      // If there is already a value known for the port make sure to forward
+      // it to the instance.
+      auto forward = [&](uint64_t fieldID) {
+        auto value = lookupLatticeValue(FieldRef(port, fieldID));
+        if (value.isUnknown())
+          return;
+        sendMessage(message.sender, {Message::Kind::MergeLattice,
+                                     FieldRef(message.instanceResult, fieldID),
+                                     value});
+      };
+      if (auto type = port.getType().dyn_cast<FIRRTLType>())
+        walkGroundTypes(type,
+                        [&](uint64_t fieldID, auto) { forward(fieldID); });
+      else
+        forward(0);
+      break;
+    }
     }
   }
+  inbox.clear();
 
   // If a value changed lattice state then reprocess any of its users.
   while (!changedLatticeValueWorklist.empty()) {
@@ -355,34 +541,16 @@ void IMConstPropPass::runOnOperation() {
         visitOperation(user);
     }
   }
-
-  // Rewrite any constants in the modules.
-  mlir::parallelForEach(circuit.getContext(),
-                        circuit.getBodyBlock()->getOps<FModuleOp>(),
-                        [&](auto op) { rewriteModuleBody(op); });
-
-  // Clean up our state for next time.
-  instanceGraph = nullptr;
-  latticeValues.clear();
-  executableBlocks.clear();
-  assert(changedLatticeValueWorklist.empty());
-  fieldRefToUsers.clear();
-  valueToFieldRef.clear();
-  resultPortToInstanceResultMapping.clear();
 }
 
 /// Return the lattice value for the specified SSA value, extended to the width
 /// of the specified destType.  If allowTruncation is true, then this allows
 /// truncating the lattice value to the specified type.
-LatticeValue IMConstPropPass::getExtendedLatticeValue(FieldRef value,
-                                                      FIRRTLBaseType destType,
-                                                      bool allowTruncation) {
+LatticeValue ModuleSolver::getExtendedLatticeValue(FieldRef value,
+                                                   FIRRTLBaseType destType,
+                                                   bool allowTruncation) {
   // If 'value' hasn't been computed yet, then it is unknown.
-  auto it = latticeValues.find(value);
-  if (it == latticeValues.end())
-    return LatticeValue();
-
-  auto result = it->second;
+  auto result = lookupLatticeValue(value);
   // Unknown/overdefined stay whatever they are.
   if (result.isUnknown() || result.isOverdefined())
     return result;
@@ -411,9 +579,10 @@ LatticeValue IMConstPropPass::getExtendedLatticeValue(FieldRef value,
 /// Mark a block executable if it isn't already.  This does an initial scan of
 /// the block, processing nullary operations like wires, instances, and
 /// constants that only get processed once.
-void IMConstPropPass::markBlockExecutable(Block *block) {
-  if (!executableBlocks.insert(block).second)
+void ModuleSolver::markBlockExecutable(Block *block) {
+  if (executable)
     return; // Already executable.
+  executable = true;
 
   // Mark block arguments, which are module ports, with don't touch as
   // overdefined.
@@ -484,7 +653,7 @@ void IMConstPropPass::markBlockExecutable(Block *block) {
   }
 }
 
-void IMConstPropPass::markWireOp(WireOp wire) {
+void ModuleSolver::markWireOp(WireOp wire) {
   auto type = wire.getResult().getType().dyn_cast<FIRRTLType>();
   if (!type)
     return markOverdefined(wire.getResult());
@@ -495,17 +664,17 @@ void IMConstPropPass::markWireOp(WireOp wire) {
   // Otherwise, this starts out as unknown and is upgraded by connects.
 }
 
-void IMConstPropPass::markMemOp(MemOp mem) {
+void ModuleSolver::markMemOp(MemOp mem) {
   for (auto result : mem.getResults())
     markOverdefined(result);
 }
 
-void IMConstPropPass::markConstantOp(ConstantOp constant) {
+void ModuleSolver::markConstantOp(ConstantOp constant) {
   mergeLatticeValue(getOrCacheFieldRefFromValue(constant),
                     LatticeValue(constant.getValueAttr()));
 }
 
-void IMConstPropPass::markAggregateConstantOp(AggregateConstantOp constant) {
+void ModuleSolver::markAggregateConstantOp(AggregateConstantOp constant) {
   walkGroundTypes(constant.getType(), [&](uint64_t fieldID, auto) {
     mergeLatticeValue(
         FieldRef(constant, fieldID),
@@ -514,20 +683,20 @@ void IMConstPropPass::markAggregateConstantOp(AggregateConstantOp constant) {
   });
 }
 
-void IMConstPropPass::markSpecialConstantOp(SpecialConstantOp specialConstant) {
+void ModuleSolver::markSpecialConstantOp(SpecialConstantOp specialConstant) {
   mergeLatticeValue(getOrCacheFieldRefFromValue(specialConstant),
                     LatticeValue(specialConstant.getValueAttr()));
 }
 
-void IMConstPropPass::markInvalidValueOp(InvalidValueOp invalid) {
+void ModuleSolver::markInvalidValueOp(InvalidValueOp invalid) {
   markOverdefined(invalid.getResult());
 }
 
 /// Instances have no operands, so they are visited exactly once when their
 /// enclosing block is marked live.  This sets up the def-use edges for ports.
-void IMConstPropPass::markInstanceOp(InstanceOp instance) {
+void ModuleSolver::markInstanceOp(InstanceOp instance) {
   // Get the module being reference or a null pointer if this is an extmodule.
-  Operation *op = instanceGraph->getReferencedModule(instance);
+  Operation *op = instanceGraph.getReferencedModule(instance);
 
   // If this is an extmodule, just remember that any results and inouts are
   // overdefined.
@@ -548,10 +717,12 @@ void IMConstPropPass::markInstanceOp(InstanceOp instance) {
 
   // Otherwise this is a defined module.
   auto fModule = cast<FModuleOp>(op);
-  markBlockExecutable(fModule.getBodyBlock());
+  auto *solver = getSolver(fModule);
+  sendMessage(solver, {Message::Kind::MarkExecutable});
 
-  // Ok, it is a normal internal module reference.  Populate
-  // resultPortToInstanceResultMapping, and forward any already-computed values.
+  // Ok, it is a normal internal module reference.  Have the module's solver
+  // populate its resultPortToInstanceResultMapping, and forward any
+  // already-computed values.
   for (size_t resultNo = 0, e = instance.getNumResults(); resultNo != e;
        ++resultNo) {
     auto instancePortVal = instance.getResult(resultNo);
@@ -563,16 +734,12 @@ void IMConstPropPass::markInstanceOp(InstanceOp instance) {
     // Otherwise we have a result from the instance.  We need to forward results
     // from the body to this instance result's SSA value, so remember it.
     BlockArgument modulePortVal = fModule.getArgument(resultNo);
-
-    resultPortToInstanceResultMapping[modulePortVal].push_back(instancePortVal);
-
-    // If there is already a value known for modulePortVal make sure to forward
-    // it here.
-    mergeLatticeValue(instancePortVal, modulePortVal);
+    sendMessage(solver, {Message::Kind::ForwardPort, FieldRef(modulePortVal, 0),
+                         {}, instancePortVal, this});
   }
 }
 
-void IMConstPropPass::visitConnectLike(FConnectLike connect) {
+void ModuleSolver::visitConnectLike(FConnectLike connect) {
   // Mark foreign types as overdefined.
   auto destTypeFIRRTL = connect.getDest().getType().dyn_cast<FIRRTLType>();
   if (!destTypeFIRRTL) {
@@ -608,10 +775,13 @@ void IMConstPropPass::visitConnectLike(FConnectLike connect) {
     // Driving result ports propagates the value to each instance using the
     // module.
     if (auto blockArg = fieldRefDest.getValue().dyn_cast<BlockArgument>()) {
-      for (auto userOfResultPort : resultPortToInstanceResultMapping[blockArg])
-        mergeLatticeValue(
-            FieldRef(userOfResultPort, fieldRefDestConnected.getFieldID()),
-            srcValue);
+      for (auto [userOfResultPort, solver] :
+           resultPortToInstanceResultMapping[blockArg])
+        sendMessage(
+            solver,
+            {Message::Kind::MergeLattice,
+             FieldRef(userOfResultPort, fieldRefDestConnected.getFieldID()),
+             srcValue});
       // Output ports are wire-like and may have users.
       return mergeLatticeValue(fieldRefDestConnected, srcValue);
     }
@@ -629,15 +799,17 @@ void IMConstPropPass::visitConnectLike(FConnectLike connect) {
       // Update the dest, when its an instance op.
       mergeLatticeValue(fieldRefDestConnected, srcValue);
       auto module =
-          dyn_cast<FModuleOp>(*instanceGraph->getReferencedModule(instance));
+          dyn_cast<FModuleOp>(*instanceGraph.getReferencedModule(instance));
       if (!module)
         return;
 
       BlockArgument modulePortVal = module.getArgument(dest.getResultNumber());
 
-      return mergeLatticeValue(
-          FieldRef(modulePortVal, fieldRefDestConnected.getFieldID()),
-          srcValue);
+      return sendMessage(
+          getSolver(module),
+          {Message::Kind::MergeLattice,
+           FieldRef(modulePortVal, fieldRefDestConnected.getFieldID()),
+           srcValue});
     }
 
     // Driving a memory result is ignored because these are always treated
@@ -653,18 +825,18 @@ void IMConstPropPass::visitConnectLike(FConnectLike connect) {
   walkGroundTypes(baseType, propagateElementLattice);
 }
 
-void IMConstPropPass::visitRefSend(RefSendOp send) {
+void ModuleSolver::visitRefSend(RefSendOp send) {
   // Send connects the base value (source) to the result (dest).
   return mergeLatticeValue(send.getResult(), send.getBase());
 }
 
-void IMConstPropPass::visitRefResolve(RefResolveOp resolve) {
+void ModuleSolver::visitRefResolve(RefResolveOp resolve) {
   // Resolve connects the ref value (source) to result (dest).
   // If writes are ever supported, this will need to work differently!
   return mergeLatticeValue(resolve.getResult(), resolve.getRef());
 }
 
-void IMConstPropPass::visitNode(NodeOp node) {
+void ModuleSolver::visitNode(NodeOp node) {
   // Nodes don't fold if they have interesting names, but they should still
   // propagate values.
   if (hasDontTouch(node.getResult()) ||
@@ -681,7 +853,7 @@ void IMConstPropPass::visitNode(NodeOp node) {
 ///
 /// This should update the lattice value state for any result values.
 ///
-void IMConstPropPass::visitOperation(Operation *op) {
+void ModuleSolver::visitOperation(Operation *op) {
   // If this is a operation with special handling, handle it specially.
   if (auto connectLikeOp = dyn_cast<FConnectLike>(op))
     return visitConnectLike(connectLikeOp);
@@ -714,7 +886,8 @@ void IMConstPropPass::visitOperation(Operation *op) {
   bool hasUnknown = false;
   for (Value operand : op->getOperands()) {
 
-    auto &operandLattice = latticeValues[getOrCacheFieldRefFromValue(operand)];
+    auto &operandLattice =
+        getLatticeValue(getOrCacheFieldRefFromValue(operand));
 
     // If the operand is an unknown value, then we generally don't want to
     // process it - we want to wait until the value is resolved to by the SCCP
@@ -784,8 +957,8 @@ void IMConstPropPass::visitOperation(Operation *op) {
       else // Treat non integer constants as overdefined.
         resultLattice = LatticeValue::getOverdefined();
     } else { // Folding to an operand results in its value.
-      resultLattice =
-          latticeValues[getOrCacheFieldRefFromValue(foldResult.get<Value>())];
+      resultLattice = getLatticeValue(
+          getOrCacheFieldRefFromValue(foldResult.get<Value>()));
     }
 
     // We do not "merge" the lattice value in, we set it.  This is because the
@@ -796,10 +969,10 @@ void IMConstPropPass::visitOperation(Operation *op) {
   }
 }
 
-void IMConstPropPass::rewriteModuleBody(FModuleOp module) {
+void ModuleSolver::rewriteModuleBody() {
   auto *body = module.getBodyBlock();
   // If a module is unreachable, just ignore it.
-  if (!executableBlocks.count(body))
+  if (!executable)
     return;
 
   auto builder = OpBuilder::atBlockBegin(body);
@@ -838,9 +1011,8 @@ void IMConstPropPass::rewriteModuleBody(FModuleOp module) {
     };
 
     // TODO: Replace entire aggregate.
-    auto it = latticeValues.find(getOrCacheFieldRefFromValue(value));
-    if (it == latticeValues.end() || it->second.isOverdefined() ||
-        it->second.isUnknown())
+    auto lattice = lookupLatticeValue(getOrCacheFieldRefFromValue(value));
+    if (lattice.isOverdefined() || lattice.isUnknown())
       return false;
 
     // Cannot materialize constants for non-base types.
@@ -848,9 +1020,10 @@ void IMConstPropPass::rewriteModuleBody(FModuleOp module) {
       return false;
 
     auto cstValue =
-        getConst(it->second.getValue(), value.getType(), value.getLoc());
+        getConst(lattice.getValue(), value.getType(), value.getLoc());
 
     replaceIfNotConnect(cstValue);
+    changed = true;
     return true;
   };
 
@@ -878,7 +1051,8 @@ void IMConstPropPass::rewriteModuleBody(FModuleOp module) {
           if (getBaseType(type).isGround() &&
               isDeletableWireOrRegOrNode(destOp) && !isOverdefined(fieldRef)) {
             connect.erase();
-            ++numErasedOp;
+            ++numErased;
+            changed = true;
           }
         }
       }
@@ -895,6 +1069,7 @@ void IMConstPropPass::rewriteModuleBody(FModuleOp module) {
         (wouldOpBeTriviallyDead(&op) || isDeletableWireOrRegOrNode(&op))) {
       LLVM_DEBUG({ logger.getOStream() << "Trivially dead : " << op << "\n"; });
       op.erase();
+      changed = true;
       continue;
     }
 
@@ -909,14 +1084,14 @@ void IMConstPropPass::rewriteModuleBody(FModuleOp module) {
       foldedAny |= replaceValueIfPossible(result);
 
     if (foldedAny)
-      ++numFoldedOp;
+      ++numFolded;
 
     // If the operation folded to a constant then we can probably nuke it.
     if (foldedAny && op.use_empty() &&
         (wouldOpBeTriviallyDead(&op) || isDeletableWireOrRegOrNode(&op))) {
       LLVM_DEBUG({ logger.getOStream() << "Made dead : " << op << "\n"; });
       op.erase();
-      ++numErasedOp;
+      ++numErased;
       continue;
     }
   }
@@ -9,6 +9,7 @@
 #include "PassDetails.h"
 #include "circt/Dialect/FIRRTL/AnnotationDetails.h"
 #include "circt/Dialect/FIRRTL/FIRRTLInstanceGraph.h"
+#include "circt/Dialect/FIRRTL/FIRRTLValueNumbering.h"
 #include "circt/Dialect/FIRRTL/Passes.h"
 #include "circt/Dialect/HW/InnerSymbolTable.h"
 #include "mlir/IR/ImplicitLocOpBuilder.h"
@@ -66,7 +67,9 @@ struct IMDeadCodeElimPass : public IMDeadCodeElimBase<IMDeadCodeElimPass> {
   /// Return true if the value is known alive.
   bool isKnownAlive(Value value) const {
     assert(value && "null should not be used");
-    return liveElements.count(value);
+    if (auto number = numbering->lookup(value))
+      return liveValues.test(*number);
+    return liveUnnumberedValues.contains(value);
   }
 
   /// Return true if the value is assumed dead.
@@ -91,7 +94,6 @@ struct IMDeadCodeElimPass : public IMDeadCodeElimBase<IMDeadCodeElimPass> {
     markAlive(op->getParentOfType<FModuleOp>());
   }
 
-  void markDeclaration(Operation *op);
   void markInstanceOp(InstanceOp instanceOp);
   void markUnknownSideEffectOp(Operation *op);
   void visitInstanceOp(InstanceOp instance);
@@ -99,6 +101,19 @@ struct IMDeadCodeElimPass : public IMDeadCodeElimBase<IMDeadCodeElimPass> {
   void visitModuleOp(FModuleOp module);
 
 private:
+  /// The ports and operations of a module which are alive or need to be
+  /// visited as soon as the module becomes executable. These only depend on
+  /// the module itself and are computed for all modules in parallel.
+  struct ModuleSeeds {
+    /// Ports with don't touch.
+    SmallVector<BlockArgument> dontTouchedPorts;
+    /// Undeletable declarations, instances and operations with unknown side
+    /// effects, in the order in which they appear in the module.
+    SmallVector<Operation *> ops;
+  };
+  void collectSeeds(FModuleOp module, ModuleSeeds &seeds);
+  DenseMap<Block *, ModuleSeeds> moduleSeeds;
+
   /// The set of blocks that are known to execute, or are intrinsically alive.
   DenseSet<Block *> executableBlocks;
 
@@ -113,16 +128,53 @@ private:
       std::variant<Value, FModuleOp, InstanceOp, hw::HierPathOp>;
 
   void markAlive(ElementType element) {
-    if (!liveElements.insert(element).second)
+    if (auto *value = std::get_if<Value>(&element)) {
+      if (!insertLiveValue(*value))
+        return;
+    } else if (!liveElements.insert(element).second) {
       return;
+    }
     worklist.push_back(element);
   }
 
+  /// Record a value as alive.  Returns false if it was already alive.
+  bool insertLiveValue(Value value) {
+    if (auto number = numbering->lookup(value)) {
+      if (liveValues.test(*number))
+        return false;
+      liveValues.set(*number);
+      return true;
+    }
+    return liveUnnumberedValues.insert(value).second;
+  }
+
+  /// Record a value as no longer alive.
+  void eraseLiveValue(Value value) {
+    if (auto number = numbering->lookup(value))
+      liveValues.reset(*number);
+    else
+      liveUnnumberedValues.erase(value);
+  }
+
+  /// Drop a value that is about to be destroyed from the liveness state.
+  void forgetValue(Value value) {
+    eraseLiveValue(value);
+    numbering->erase(value);
+  }
+
   /// A worklist of values whose liveness recently changed, indicating
   /// the users need to be reprocessed.
   SmallVector<ElementType, 64> worklist;
+
+  /// The live modules, instances and hierpaths.
   llvm::DenseSet<ElementType> liveElements;
 
+  /// The live values, indexed by their value number.  Values created after
+  /// the numbering was computed are tracked in `liveUnnumberedValues`.
+  ValueNumbering *numbering;
+  llvm::BitVector liveValues;
+  DenseSet<Value> liveUnnumberedValues;
+
   /// This keeps track of input ports that need to be kept if the associated
   /// instance is alive.
   DenseMap<InstanceOp, SmallVector<mlir::OpResult>> lazyLiveInputPorts;
@@ -180,15 +232,6 @@ void IMDeadCodeElimPass::visitHierPathOp(hw::HierPathOp hierPathOp) {
     markAlive(elem);
 }
 
-void IMDeadCodeElimPass::markDeclaration(Operation *op) {
-  assert(isDeclaration(op) && "only a declaration is expected");
-  if (!isDeletableDeclaration(op)) {
-    for (auto result : op->getResults())
-      markAlive(result);
-    markBlockUndeletable(op);
-  }
-}
-
 void IMDeadCodeElimPass::markUnknownSideEffectOp(Operation *op) {
   // For operations with side effects, pessimistically mark results and
   // operands as alive.
@@ -254,23 +297,45 @@ void IMDeadCodeElimPass::markBlockExecutable(Block *block) {
   if (fmodule.isPublic())
     markAlive(fmodule);
 
+  auto &seeds = moduleSeeds[block];
+
   // Mark ports with don't touch as alive.
-  for (auto blockArg : block->getArguments())
-    if (hasDontTouch(blockArg)) {
-      markAlive(blockArg);
-      markAlive(fmodule);
+  for (auto blockArg : seeds.dontTouchedPorts) {
+    markAlive(blockArg);
+    markAlive(fmodule);
+  }
+
+  for (auto *op : seeds.ops) {
+    if (isDeclaration(op)) {
+      for (auto result : op->getResults())
+        markAlive(result);
+      markBlockUndeletable(op);
+    } else if (auto instance = dyn_cast<InstanceOp>(op)) {
+      markInstanceOp(instance);
+    } else {
+      markUnknownSideEffectOp(op);
     }
+  }
+}
+
+void IMDeadCodeElimPass::collectSeeds(FModuleOp module, ModuleSeeds &seeds) {
+  auto *block = module.getBodyBlock();
+  for (auto blockArg : block->getArguments())
+    if (hasDontTouch(blockArg))
+      seeds.dontTouchedPorts.push_back(blockArg);
 
   for (auto &op : *block) {
-    if (isDeclaration(&op))
-      markDeclaration(&op);
-    else if (auto instance = dyn_cast<InstanceOp>(op))
-      markInstanceOp(instance);
-    else if (isa<FConnectLike>(op))
+    if (isDeclaration(&op)) {
+      if (!isDeletableDeclaration(&op))
+        seeds.ops.push_back(&op);
+    } else if (isa<InstanceOp>(op)) {
+      seeds.ops.push_back(&op);
+    } else if (isa<FConnectLike>(op)) {
       // Skip connect op.
       continue;
-    else if (hasUnknownSideEffect(&op))
-      markUnknownSideEffectOp(&op);
+    } else if (hasUnknownSideEffect(&op)) {
+      seeds.ops.push_back(&op);
+    }
 
     // TODO: Handle attach etc.
   }
@@ -388,6 +453,21 @@ void IMDeadCodeElimPass::runOnOperation() {
   for (auto module : modules)
     forwardConstantOutputPort(module);
 
+  // Number the values of the circuit to track their liveness in a bitvector.
+  numbering = &getChildAnalysis<ValueNumbering>(circuit);
+  liveValues.resize(numbering->size());
+
+  // Collect the seeds of all modules in parallel. The map entries are created
+  // up front so that the threads only write to their own entry.
+  for (auto module : circuit.getBodyBlock()->getOps<FModuleOp>())
+    moduleSeeds.insert({module.getBodyBlock(), {}});
+  SmallVector<std::pair<FModuleOp, ModuleSeeds *>> seedsToCollect;
+  for (auto &[block, seeds] : moduleSeeds)
+    seedsToCollect.push_back({cast<FModuleOp>(block->getParentOp()), &seeds});
+  mlir::parallelForEach(circuit.getContext(), seedsToCollect, [&](auto &entry) {
+    collectSeeds(entry.first, *entry.second);
+  });
+
   for (auto module : circuit.getBodyBlock()->getOps<FModuleOp>()) {
     // Mark the ports of public modules as alive.
     if (module.isPublic()) {
@@ -455,9 +535,13 @@ void IMDeadCodeElimPass::runOnOperation() {
     eraseEmptyModule(module);
 
   // Clean up data structures.
+  moduleSeeds.clear();
   executableBlocks.clear();
   resultPortToInstanceResultMapping.clear();
   liveElements.clear();
+  liveValues.clear();
+  liveUnnumberedValues.clear();
+  numbering = nullptr;
   lazyLiveInputPorts.clear();
   instanceToHierPaths.clear();
   hierPathToElements.clear();
@@ -643,8 +727,8 @@ void IMDeadCodeElimPass::rewriteModuleSignature(FModuleOp module) {
     // If a module port is dead but its instance result is alive, the port
     // is used as a temporary wire so make sure that a replaced wire is
     // putted into `liveSet`.
-    liveElements.erase(result);
-    liveElements.insert(wire);
+    eraseLiveValue(result);
+    insertLiveValue(wire);
   };
 
   // First, delete dead instances.
@@ -655,6 +739,8 @@ void IMDeadCodeElimPass::rewriteModuleSignature(FModuleOp module) {
       ImplicitLocOpBuilder builder(instance.getLoc(), instance);
       for (auto index : llvm::seq(0u, instance.getNumResults()))
         replaceInstanceResultWithWire(builder, index, instance);
+      for (auto result : instance.getResults())
+        forgetValue(result);
       // Make sure that we update the instance graph.
       use->erase();
       instance.erase();
@@ -701,8 +787,8 @@ void IMDeadCodeElimPass::rewriteModuleSignature(FModuleOp module) {
       auto wire = builder.create<WireOp>(argument.getType()).getResult();
 
       // Since `liveSet` contains the port, we have to erase it from the set.
-      liveElements.erase(argument);
-      liveElements.insert(wire);
+      eraseLiveValue(argument);
+      insertLiveValue(wire);
       argument.replaceAllUsesWith(wire);
       deadPortIndexes.set(index);
       continue;
@@ -727,14 +813,14 @@ void IMDeadCodeElimPass::rewriteModuleSignature(FModuleOp module) {
   // Erase arguments of the old module from liveSet to prevent from creating
   // dangling pointers.
   for (auto arg : module.getArguments())
-    liveElements.erase(arg);
+    forgetValue(arg);
 
   // Delete ports from the module.
   module.erasePorts(deadPortIndexes);
 
   // Add arguments of the new module to liveSet.
   for (auto arg : module.getArguments())
-    liveElements.insert(arg);
+    insertLiveValue(arg);
 
   // Rewrite all uses.
   for (auto *use : llvm::make_early_inc_range(instanceGraphNode->uses())) {
@@ -747,14 +833,14 @@ void IMDeadCodeElimPass::rewriteModuleSignature(FModuleOp module) {
     // Since we will rewrite instance op, it is necessary to remove old
     // instance results from liveSet.
     for (auto oldResult : instance.getResults())
-      liveElements.erase(oldResult);
+      forgetValue(oldResult);
 
     // Create a new instance op without dead ports.
     auto newInstance = instance.erasePorts(builder, deadPortIndexes);
 
     // Mark new results as alive.
     for (auto newResult : newInstance.getResults())
-      liveElements.insert(newResult);
+      insertLiveValue(newResult);
 
     instanceGraph->replaceInstance(instance, newInstance);
     if (liveElements.contains(instance)) {
@@ -17,6 +17,7 @@
 #include "circt/Dialect/FIRRTL/Namespace.h"
 #include "circt/Dialect/FIRRTL/Passes.h"
 #include "mlir/IR/ImplicitLocOpBuilder.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
 #include "llvm/ADT/APSInt.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/ADT/TypeSwitch.h"
@@ -35,9 +36,10 @@ struct InferReadWritePass : public InferReadWriteBase<InferReadWritePass> {
   ///     then, replace with a single bit mask. Create a new memory with a
   ///     1 bit mask, and replace the old memory with it. The single bit mask
   ///     memory is always lowered to an unmasked memory.
-  ///  2. If the read and write enable ports are trivially mutually exclusive,
-  ///     then create a new memory with a single read/write port, and replace
-  ///     the old memory with it.
+  ///  2. If the read and write enable ports are mutually exclusive, then
+  ///     create a new memory with a single read/write port, and replace the old
+  ///     memory with it. The enables are exclusive if one of them requires a
+  ///     condition that contradicts a condition the other requires.
   void runOnOperation() override {
     LLVM_DEBUG(llvm::dbgs() << "\n Running Infer Read Write on module:"
                             << getOperation().getName());
@@ -57,7 +59,7 @@ struct InferReadWritePass : public InferReadWriteBase<InferReadWritePass> {
       SmallVector<Type, 4> resultTypes;
       SmallVector<Attribute> portAtts;
       SmallVector<Attribute, 4> portAnnotations;
-      Value rClock, wClock;
+      Value rClock, wClock, rEnField, wEnField;
       // The memory has exactly two ports.
       SmallVector<Value> readTerms, writeTerms;
       for (const auto &portIt : llvm::enumerate(memOp.getResults())) {
@@ -85,8 +87,10 @@ struct InferReadWritePass : public InferReadWriteBase<InferReadWritePass> {
                 sf.getInput().getType().getElementName(sf.getFieldIndex());
             // If this is the enable field, record the product terms(the And
             // expression tree).
-            if (fName.equals("en"))
+            if (fName.equals("en")) {
               getProductTerms(sf, isReadPort ? readTerms : writeTerms);
+              (isReadPort ? rEnField : wEnField) = sf;
+            }
 
             else if (fName.equals("clk")) {
               if (isReadPort)
@@ -97,8 +101,10 @@ struct InferReadWritePass : public InferReadWriteBase<InferReadWritePass> {
           }
         // End of loop for getting MemOp port users.
       }
-      if (!sameDriver(rClock, wClock))
+      if (!sameDriver(rClock, wClock)) {
+        ++numUnmergedMemories;
         continue;
+      }
 
       rClock = wClock;
       LLVM_DEBUG(
@@ -117,8 +123,16 @@ struct InferReadWritePass : public InferReadWriteBase<InferReadWritePass> {
       // enable product terms are a complement of the read enable, then return
       // the write enable term.
       auto complementTerm = checkComplement(readTerms, writeTerms);
+      // Otherwise look for any write enable condition which contradicts a read
+      // enable condition, and use it or its complement as the write mode.
+      bool invertTerm = false;
       if (!complementTerm)
+        std::tie(complementTerm, invertTerm) =
+            findExclusiveLiteral(memOp, rEnField, wEnField);
+      if (!complementTerm) {
+        ++numUnmergedMemories;
         continue;
+      }
 
       // Create the merged rw port for the new memory.
       resultNames.push_back(
@@ -171,6 +185,8 @@ struct InferReadWritePass : public InferReadWriteBase<InferReadWritePass> {
       builder.create<StrictConnectOp>(
           enb, builder.create<OrPrimOp>(rEnWire, wEnWire));
       builder.setInsertionPointToEnd(wmode->getBlock());
+      if (invertTerm)
+        complementTerm = builder.create<NotPrimOp>(complementTerm);
       builder.create<StrictConnectOp>(wmode, complementTerm);
       // Now iterate over the original memory read and write ports.
       size_t dbgsIndex = 0;
@@ -314,6 +330,192 @@ private:
     return {};
   }
 
+  /// A single bit condition, which is either a value or, if the flag is set,
+  /// the complement of the value.
+  using Literal = std::pair<Value, bool>;
+
+  /// Look through nodes and wires to the value driving them.
+  Value lookThrough(Value value) {
+    for (unsigned i = 0; i != 16 && value; ++i) {
+      Operation *op = value.getDefiningOp();
+      if (auto node = dyn_cast_or_null<NodeOp>(op))
+        value = node.getInput();
+      else if (isa_and_nonnull<WireOp>(op) && getConnectSrc(value))
+        value = getConnectSrc(value);
+      else
+        break;
+    }
+    return value;
+  }
+
+  /// Check whether two values are known to be equal, because they are the same
+  /// value or are computed by the same pure operation from equal operands, up
+  /// to `depth` operations deep.
+  bool isEquivalent(Value a, Value b, unsigned depth = 4) {
+    a = lookThrough(a);
+    b = lookThrough(b);
+    if (a == b)
+      return true;
+    if (depth == 0 || a.getType() != b.getType())
+      return false;
+    auto *opA = a.getDefiningOp();
+    auto *opB = b.getDefiningOp();
+    if (!opA || !opB || opA->getName() != opB->getName() ||
+        opA->getNumResults() != 1 || opA->getNumRegions() != 0 ||
+        opA->getNumOperands() != opB->getNumOperands() ||
+        opA->getAttrDictionary() != opB->getAttrDictionary() ||
+        !mlir::isMemoryEffectFree(opA))
+      return false;
+    return llvm::all_of(llvm::zip(opA->getOperands(), opB->getOperands()),
+                        [&](auto operands) {
+                          return isEquivalent(std::get<0>(operands),
+                                              std::get<1>(operands),
+                                              depth - 1);
+                        });
+  }
+
+  /// Check whether a value is a single bit constant of the given value.
+  static bool isConstant(Value value, bool one) {
+    auto constant = value.getDefiningOp<ConstantOp>();
+    return constant && constant.getValue().getBitWidth() == 1 &&
+           constant.getValue().getBoolValue() == one;
+  }
+
+  /// Collect the single bit conditions an enable requires to be true, looking
+  /// through ands, muxes with a constant operand, nots and ors of complemented
+  /// conditions. At most `maxLiterals` conditions are collected to keep the
+  /// analysis fast on deep enable cones.
+  void getLiterals(Value enField, SmallVectorImpl<Literal> &literals) {
+    static constexpr size_t maxLiterals = 32;
+    SmallVector<Literal> worklist;
+    DenseSet<Literal> visited;
+    if (auto src = getConnectSrc(enField))
+      worklist.push_back({src, false});
+    while (!worklist.empty() && literals.size() < maxLiterals) {
+      auto literal = worklist.pop_back_val();
+      Value value = literal.first;
+      bool inverted = literal.second;
+      auto type = value ? value.getType().dyn_cast<UIntType>() : UIntType();
+      if (!type || type.getWidthOrSentinel() != 1 ||
+          !visited.insert(literal).second)
+        continue;
+      literals.push_back(literal);
+      auto *op = value.getDefiningOp();
+      if (!op)
+        continue;
+      TypeSwitch<Operation *>(op)
+          .Case<NodeOp>([&](auto node) {
+            worklist.push_back({node.getInput(), inverted});
+          })
+          .Case<WireOp>([&](auto) {
+            worklist.push_back({getConnectSrc(value), inverted});
+          })
+          .Case<NotPrimOp>([&](auto notOp) {
+            worklist.push_back({notOp.getInput(), !inverted});
+          })
+          .Case<AndPrimOp>([&](auto andOp) {
+            // a & b requires both a and b.
+            if (inverted)
+              return;
+            worklist.push_back({andOp.getLhs(), false});
+            worklist.push_back({andOp.getRhs(), false});
+          })
+          .Case<OrPrimOp>([&](auto orOp) {
+            // ~(a | b) requires both ~a and ~b.
+            if (!inverted)
+              return;
+            worklist.push_back({orOp.getLhs(), true});
+            worklist.push_back({orOp.getRhs(), true});
+          })
+          .Case<MuxPrimOp>([&](auto muxOp) {
+            auto sel = muxOp.getSel();
+            auto high = muxOp.getHigh();
+            auto low = muxOp.getLow();
+            // mux(s, h, 0) = s & h, and mux(s, 0, l) = ~s & l.
+            // ~mux(s, 1, l) = ~s & ~l, and ~mux(s, h, 1) = s & ~h.
+            if (!inverted && isConstant(low, false)) {
+              worklist.push_back({sel, false});
+              worklist.push_back({high, false});
+            } else if (!inverted && isConstant(high, false)) {
+              worklist.push_back({sel, true});
+              worklist.push_back({low, false});
+            } else if (inverted && isConstant(high, true)) {
+              worklist.push_back({sel, true});
+              worklist.push_back({low, true});
+            } else if (inverted && isConstant(low, true)) {
+              worklist.push_back({sel, false});
+              worklist.push_back({high, true});
+            }
+          });
+    }
+  }
+
+  /// If a literal is an equality or inequality test of a value against a
+  /// constant, return the value, the constant, and whether the literal requires
+  /// the value to be equal to the constant.
+  std::optional<std::tuple<Value, APSInt, bool>>
+  getConstantTest(const Literal &literal) {
+    auto *op = literal.first.getDefiningOp();
+    if (!isa_and_nonnull<EQPrimOp, NEQPrimOp>(op))
+      return std::nullopt;
+    auto lhs = lookThrough(op->getOperand(0));
+    auto rhs = lookThrough(op->getOperand(1));
+    auto constant = lhs.getDefiningOp<ConstantOp>();
+    if (constant)
+      std::swap(lhs, rhs);
+    else
+      constant = rhs.getDefiningOp<ConstantOp>();
+    if (!constant)
+      return std::nullopt;
+    return std::make_tuple(lhs, constant.getValue(),
+                           isa<EQPrimOp>(op) != literal.second);
+  }
+
+  /// Check whether the two literals can't be true at the same time.
+  bool areExclusive(const Literal &a, const Literal &b) {
+    if (a.second != b.second && isEquivalent(a.first, b.first))
+      return true;
+    auto testA = getConstantTest(a);
+    auto testB = getConstantTest(b);
+    if (!testA || !testB ||
+        !isEquivalent(std::get<0>(*testA), std::get<0>(*testB)))
+      return false;
+    bool sameConstant =
+        APSInt::isSameValue(std::get<1>(*testA), std::get<1>(*testB));
+    bool equalA = std::get<2>(*testA), equalB = std::get<2>(*testB);
+    // x == c1 and x == c2 contradict for distinct constants, and x == c and
+    // x != c always contradict.
+    return sameConstant ? equalA != equalB : equalA && equalB;
+  }
+
+  /// Find a condition required by the write enable which contradicts a
+  /// condition required by the read enable. The condition is true whenever
+  /// the memory is written and false whenever it is read, such that it can
+  /// drive the write mode of a merged read/write port. Returns a null value if
+  /// there is no such condition.
+  Literal findExclusiveLiteral(MemOp memOp, Value rEnField, Value wEnField) {
+    if (!rEnField || !wEnField)
+      return {};
+    SmallVector<Literal> readLiterals, writeLiterals;
+    getLiterals(rEnField, readLiterals);
+    getLiterals(wEnField, writeLiterals);
+    for (auto &writeLiteral : writeLiterals) {
+      // The fields of the memory are replaced, so they can't drive the write
+      // mode.
+      if (auto subfield = writeLiteral.first.getDefiningOp<SubfieldOp>();
+          subfield && subfield.getInput().getDefiningOp() == memOp)
+        continue;
+      for (auto &readLiteral : readLiterals)
+        if (areExclusive(readLiteral, writeLiteral)) {
+          LLVM_DEBUG(llvm::dbgs() << "\n exclusive write term:"
+                                  << writeLiteral.first << " inverted: "
+                                  << writeLiteral.second);
+          return writeLiteral;
+        }
+    }
+    return {};
+  }
+
   void inferUnmasked(MemOp &memOp, SmallVector<Operation *> &opsToErase) {
     bool isMasked = true;
 
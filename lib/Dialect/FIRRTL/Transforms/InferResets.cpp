@@ -20,6 +20,7 @@
 #include "circt/Support/FieldRef.h"
 #include "mlir/IR/Dominance.h"
 #include "mlir/IR/ImplicitLocOpBuilder.h"
+#include "mlir/IR/Threading.h"
 #include "llvm/ADT/EquivalenceClasses.h"
 #include "llvm/ADT/SetVector.h"
 #include "llvm/ADT/TinyPtrVector.h"
@@ -423,11 +424,13 @@ struct InferResetsPass : public InferResetsBase<InferResetsPass> {
   // Reset type inference
 
   void traceResets(CircuitOp circuit);
-  void traceResets(InstanceOp inst);
-  void traceResets(Value dst, Value src, Location loc);
-  void traceResets(Value value);
+  void traceResets(Operation *root, ResetDrives &drives);
+  void traceResets(InstanceOp inst, ResetDrives &drives);
+  void traceResets(Value dst, Value src, Location loc, ResetDrives &drives);
   void traceResets(Type dstType, Value dst, unsigned dstID, Type srcType,
-                   Value src, unsigned srcID, Location loc);
+                   Value src, unsigned srcID, Location loc,
+                   ResetDrives &drives);
+  void unifyResets(const ResetDrive &drive);
 
   LogicalResult inferAndUpdateResets();
   FailureOr<ResetKind> inferReset(ResetNetwork net);
@@ -448,9 +451,16 @@ struct InferResetsPass : public InferResetsBase<InferResetsPass> {
   void determineImpl();
   void determineImpl(FModuleOp module, ResetDomain &domain);
 
+  /// The instances replaced while implementing the async resets of a module,
+  /// as pairs of the old and the new instance.
+  using InstanceReplacements = SmallVector<std::pair<InstanceOp, InstanceOp>>;
+
   LogicalResult implementAsyncReset();
-  LogicalResult implementAsyncReset(FModuleOp module, ResetDomain &domain);
-  void implementAsyncReset(Operation *op, FModuleOp module, Value actualReset);
+  LogicalResult implementAsyncReset(FModuleOp module, ResetDomain &domain,
+                                    InstanceReplacements &replacements);
+  LogicalResult implementAsyncReset(Operation *op, FModuleOp module,
+                                    Value actualReset,
+                                    InstanceReplacements &replacements);
 
   LogicalResult verifyNoAbstractReset();
 
@@ -734,32 +744,54 @@ static bool typeContainsReset(FIRRTLType type) {
 void InferResetsPass::traceResets(CircuitOp circuit) {
   LLVM_DEBUG(
       llvm::dbgs() << "\n===----- Tracing uninferred resets -----===\n\n");
-  circuit.walk([&](Operation *op) {
+
+  // Trace the modules in parallel, each into a summary of the drives involving
+  // resets within it. The summaries are then unified into the reset networks
+  // in the order of the modules in the circuit, such that the networks and the
+  // diagnostics about them don't depend on the scheduling of the threads.
+  SmallVector<Operation *> ops;
+  for (auto &op : *circuit.getBodyBlock())
+    ops.push_back(&op);
+  SmallVector<ResetDrives> summaries(ops.size());
+  mlir::parallelFor(circuit.getContext(), 0, ops.size(),
+                    [&](size_t index) {
+                      traceResets(ops[index], summaries[index]);
+                    });
+  for (auto &drives : summaries)
+    for (auto &drive : drives)
+      unifyResets(drive);
+}
+
+/// Follow all signals with `ResetType` within an operation of the circuit,
+/// recording each drive involving a reset. This only modifies the IR within
+/// the operation, such that the operations can be traced in parallel.
+void InferResetsPass::traceResets(Operation *root, ResetDrives &drives) {
+  root->walk([&](Operation *op) {
     TypeSwitch<Operation *>(op)
         .Case<FConnectLike>([&](auto op) {
-          traceResets(op.getDest(), op.getSrc(), op.getLoc());
+          traceResets(op.getDest(), op.getSrc(), op.getLoc(), drives);
         })
-        .Case<InstanceOp>([&](auto op) { traceResets(op); })
+        .Case<InstanceOp>([&](auto op) { traceResets(op, drives); })
         .Case<RefSendOp>([&](auto op) {
           // Trace using base types.
           traceResets(op.getType().getType(), op.getResult(), 0,
                       op.getBase().getType().getPassiveType(), op.getBase(), 0,
-                      op.getLoc());
+                      op.getLoc(), drives);
         })
         .Case<RefResolveOp>([&](auto op) {
           // Trace using base types.
           traceResets(op.getType(), op.getResult(), 0,
                       op.getRef().getType().getType(), op.getRef(), 0,
-                      op.getLoc());
+                      op.getLoc(), drives);
         })
         .Case<Forceable>([&](Forceable op) {
           // Trace reset into rwprobe.  Avoid invalid IR.
           if (op.isForceable())
             traceResets(op.getDataType(), op.getData(), 0, op.getDataType(),
-                        op.getDataRef(), 0, op.getLoc());
+                        op.getDataRef(), 0, op.getLoc(), drives);
         })
         .Case<UninferredResetCastOp>([&](auto op) {
-          traceResets(op.getResult(), op.getInput(), op.getLoc());
+          traceResets(op.getResult(), op.getInput(), op.getLoc(), drives);
         })
         .Case<InvalidValueOp>([&](auto op) {
           // Uniquify `InvalidValueOp`s that are contributing to multiple reset
@@ -790,7 +822,7 @@ void InferResetsPass::traceResets(CircuitOp circuit) {
           auto index = op.getFieldIndex();
           traceResets(op.getType(), op.getResult(), 0,
                       bundleType.getElements()[index].type, op.getInput(),
-                      getFieldID(bundleType, index), op.getLoc());
+                      getFieldID(bundleType, index), op.getLoc(), drives);
         })
 
         .Case<SubindexOp, SubaccessOp>([&](auto op) {
@@ -808,7 +840,7 @@ void InferResetsPass::traceResets(CircuitOp circuit) {
           auto vectorType = op.getInput().getType();
           traceResets(op.getType(), op.getResult(), 0,
                       vectorType.getElementType(), op.getInput(),
-                      getFieldID(vectorType), op.getLoc());
+                      getFieldID(vectorType), op.getLoc(), drives);
         })
 
         .Case<RefSubOp>([&](RefSubOp op) {
@@ -821,14 +853,14 @@ void InferResetsPass::traceResets(CircuitOp circuit) {
                     return getFieldID(type, op.getIndex());
                   });
           traceResets(op.getType(), op.getResult(), 0, op.getResult().getType(),
-                      op.getInput(), fieldID, op.getLoc());
+                      op.getInput(), fieldID, op.getLoc(), drives);
         });
   });
 }
 
 /// Trace reset signals through an instance. This essentially associates the
 /// instance's port values with the target module's port values.
-void InferResetsPass::traceResets(InstanceOp inst) {
+void InferResetsPass::traceResets(InstanceOp inst, ResetDrives &drives) {
   // Lookup the referenced module. Nothing to do if its an extmodule.
   auto module = dyn_cast<FModuleOp>(*instanceGraph->getReferencedModule(inst));
   if (!module)
@@ -843,22 +875,23 @@ void InferResetsPass::traceResets(InstanceOp inst) {
     Value srcPort = it.value();
     if (dir == Direction::Out)
       std::swap(dstPort, srcPort);
-    traceResets(dstPort, srcPort, it.value().getLoc());
+    traceResets(dstPort, srcPort, it.value().getLoc(), drives);
   }
 }
 
 /// Analyze a connect of one (possibly aggregate) value to another.
 /// Each drive involving a `ResetType` is recorded.
-void InferResetsPass::traceResets(Value dst, Value src, Location loc) {
+void InferResetsPass::traceResets(Value dst, Value src, Location loc,
+                                  ResetDrives &drives) {
   // Analyze the actual connection.
-  traceResets(dst.getType(), dst, 0, src.getType(), src, 0, loc);
+  traceResets(dst.getType(), dst, 0, src.getType(), src, 0, loc, drives);
 }
 
 /// Analyze a connect of one (possibly aggregate) value to another.
 /// Each drive involving a `ResetType` is recorded.
 void InferResetsPass::traceResets(Type dstType, Value dst, unsigned dstID,
                                   Type srcType, Value src, unsigned srcID,
-                                  Location loc) {
+                                  Location loc, ResetDrives &drives) {
   if (auto dstBundle = dstType.dyn_cast<BundleType>()) {
     auto srcBundle = srcType.cast<BundleType>();
     for (unsigned dstIdx = 0, e = dstBundle.getNumElements(); dstIdx < e;
@@ -872,11 +905,11 @@ void InferResetsPass::traceResets(Type dstType, Value dst, unsigned dstID,
       if (dstElt.isFlip) {
         traceResets(srcElt.type, src, srcID + getFieldID(srcBundle, *srcIdx),
                     dstElt.type, dst, dstID + getFieldID(dstBundle, dstIdx),
-                    loc);
+                    loc, drives);
       } else {
         traceResets(dstElt.type, dst, dstID + getFieldID(dstBundle, dstIdx),
                     srcElt.type, src, srcID + getFieldID(srcBundle, *srcIdx),
-                    loc);
+                    loc, drives);
       }
     }
     return;
@@ -899,7 +932,7 @@ void InferResetsPass::traceResets(Type dstType, Value dst, unsigned dstID,
     // the field ID and make sure in `updateType` that we handle vectors
     // accordingly.
     traceResets(dstElType, dst, dstID + getFieldID(dstVector), srcElType, src,
-                srcID + getFieldID(srcVector), loc);
+                srcID + getFieldID(srcVector), loc, drives);
     return;
   }
 
@@ -907,7 +940,7 @@ void InferResetsPass::traceResets(Type dstType, Value dst, unsigned dstID,
   if (auto dstRef = dstType.dyn_cast<RefType>()) {
     auto srcRef = srcType.cast<RefType>();
     return traceResets(dstRef.getType(), dst, dstID, srcRef.getType(), src,
-                       srcID, loc);
+                       srcID, loc, drives);
   }
 
   // Handle reset connections.
@@ -920,17 +953,22 @@ void InferResetsPass::traceResets(Type dstType, Value dst, unsigned dstID,
 
   FieldRef dstField(dst, dstID);
   FieldRef srcField(src, srcID);
-  LLVM_DEBUG(llvm::dbgs() << "Visiting driver '" << dstField << "' = '"
-                          << srcField << "' (" << dstType << " = " << srcType
-                          << ")\n");
+  drives.push_back({{dstField, dstBase}, {srcField, srcBase}, loc});
+}
+
+/// Unify the reset networks of the two ends of a drive involving a reset.
+void InferResetsPass::unifyResets(const ResetDrive &drive) {
+  const ResetSignal &dst = drive.dst;
+  const ResetSignal &src = drive.src;
+  LLVM_DEBUG(llvm::dbgs() << "Visiting driver '" << dst.field << "' = '"
+                          << src.field << "' (" << dst.type << " = "
+                          << src.type << ")\n");
 
   // Determine the leaders for the dst and src reset networks before we make
   // the connection. This will allow us to later detect if dst got merged
   // into src, or src into dst.
-  ResetSignal dstLeader =
-      *resetClasses.findLeader(resetClasses.insert({dstField, dstBase}));
-  ResetSignal srcLeader =
-      *resetClasses.findLeader(resetClasses.insert({srcField, srcBase}));
+  ResetSignal dstLeader = *resetClasses.findLeader(resetClasses.insert(dst));
+  ResetSignal srcLeader = *resetClasses.findLeader(resetClasses.insert(src));
 
   // Unify the two reset networks.
   ResetSignal unionLeader = *resetClasses.unionSets(dstLeader, srcLeader);
@@ -951,8 +989,7 @@ void InferResetsPass::traceResets(Type dstType, Value dst, unsigned dstID,
 
   // Keep note of this drive so we can point the user at the right location
   // in case something goes wrong.
-  resetDrives[unionLeader].push_back(
-      {{dstField, dstBase}, {srcField, srcBase}, loc});
+  resetDrives[unionLeader].push_back(drive);
 }
 
 //===----------------------------------------------------------------------===//
@@ -1559,11 +1596,25 @@ void InferResetsPass::determineImpl(FModuleOp module, ResetDomain &domain) {
 /// Implement the async resets gathered in the pass' `domains` map.
 LogicalResult InferResetsPass::implementAsyncReset() {
   LLVM_DEBUG(llvm::dbgs() << "\n===----- Implement async resets -----===\n\n");
-  for (auto &it : domains)
-    if (failed(implementAsyncReset(cast<FModuleOp>(it.first),
-                                   it.second.back().first)))
-      return failure();
-  return success();
+
+  // Implement the modules in parallel. Each module only modifies its own body
+  // and ports, but the instance graph is shared, so the instances replaced
+  // along the way are only swapped in the graph once all modules are done.
+  SmallVector<InstanceReplacements> replacements(domains.size());
+  auto result = mlir::failableParallelForEachN(
+      &getContext(), 0, domains.size(), [&](size_t index) {
+        auto &it = domains.begin()[index];
+        return implementAsyncReset(cast<FModuleOp>(it.first),
+                                   it.second.back().first,
+                                   replacements[index]);
+      });
+  for (auto &moduleReplacements : replacements) {
+    for (auto [oldInst, newInst] : moduleReplacements) {
+      instanceGraph->replaceInstance(oldInst, newInst);
+      oldInst->erase();
+    }
+  }
+  return result;
 }
 
 /// Implement the async resets for a specific module.
@@ -1571,8 +1622,9 @@ LogicalResult InferResetsPass::implementAsyncReset() {
 /// This will add ports to the module as appropriate, update the register ops
 /// in the module, and update any instantiated submodules with their
 /// corresponding reset implementation details.
-LogicalResult InferResetsPass::implementAsyncReset(FModuleOp module,
-                                                   ResetDomain &domain) {
+LogicalResult
+InferResetsPass::implementAsyncReset(FModuleOp module, ResetDomain &domain,
+                                     InstanceReplacements &replacements) {
   LLVM_DEBUG(llvm::dbgs() << "Implementing async reset for " << module.getName()
                           << "\n");
 
@@ -1683,16 +1735,21 @@ LogicalResult InferResetsPass::implementAsyncReset(FModuleOp module,
   }
 
   // Update the operations.
+  bool anyFailed = false;
   for (auto *op : opsToUpdate)
-    implementAsyncReset(op, module, actualReset);
+    if (failed(implementAsyncReset(op, module, actualReset, replacements)))
+      anyFailed = true;
 
-  return success();
+  return failure(anyFailed);
 }
 
 /// Modify an operation in a module to implement an async reset for that
-/// module.
-void InferResetsPass::implementAsyncReset(Operation *op, FModuleOp module,
-                                          Value actualReset) {
+/// module. Replaced instances are recorded in `replacements` and left in place,
+/// for the caller to update the instance graph and erase them.
+LogicalResult
+InferResetsPass::implementAsyncReset(Operation *op, FModuleOp module,
+                                     Value actualReset,
+                                     InstanceReplacements &replacements) {
   ImplicitLocOpBuilder builder(op->getLoc(), op);
 
   // Handle instances.
@@ -1703,13 +1760,13 @@ void InferResetsPass::implementAsyncReset(Operation *op, FModuleOp module,
     auto refModule =
         dyn_cast<FModuleOp>(*instanceGraph->getReferencedModule(instOp));
     if (!refModule)
-      return;
+      return success();
     auto domainIt = domains.find(refModule);
     if (domainIt == domains.end())
-      return;
+      return success();
     auto &domain = domainIt->second.back().first;
     if (!domain.reset)
-      return;
+      return success();
     LLVM_DEBUG(llvm::dbgs()
                << "- Update instance '" << instOp.getName() << "'\n");
 
@@ -1726,8 +1783,7 @@ void InferResetsPass::implementAsyncReset(Operation *op, FModuleOp module,
 
       // Update the uses over to the new instance and drop the old instance.
       instOp.replaceAllUsesWith(newInstOp.getResults().drop_front());
-      instanceGraph->replaceInstance(instOp, newInstOp);
-      instOp->erase();
+      replacements.push_back({instOp, newInstOp});
       instOp = newInstOp;
     } else if (domain.existingPort.has_value()) {
       auto idx = *domain.existingPort;
@@ -1739,19 +1795,19 @@ void InferResetsPass::implementAsyncReset(Operation *op, FModuleOp module,
     // can happen if the instantiated module has a reset domain, but that
     // domain is e.g. rooted at an internal wire.
     if (!instReset)
-      return;
+      return success();
 
     // Connect the instance's reset to the actual reset.
     assert(instReset && actualReset);
     builder.setInsertionPointAfter(instOp);
     builder.create<StrictConnectOp>(instReset, actualReset);
-    return;
+    return success();
   }
 
   // Handle reset-less registers.
   if (auto regOp = dyn_cast<RegOp>(op)) {
     if (AnnotationSet::removeAnnotations(regOp, excludeMemToRegAnnoClass))
-      return;
+      return success();
 
     LLVM_DEBUG(llvm::dbgs() << "- Adding async reset to " << regOp << "\n");
     auto zero = createZeroValue(builder, regOp.getResult().getType());
@@ -1763,7 +1819,7 @@ void InferResetsPass::implementAsyncReset(Operation *op, FModuleOp module,
     if (regOp.getForceable())
       regOp.getRef().replaceAllUsesWith(newRegOp.getRef());
     regOp->erase();
-    return;
+    return success();
   }
 
   // Handle registers with reset.
@@ -1774,9 +1830,7 @@ void InferResetsPass::implementAsyncReset(Operation *op, FModuleOp module,
                  << "- Skipping (has async reset) " << regOp << "\n");
       // The following performs the logic of `CheckResets` in the original
       // Scala source code.
-      if (failed(regOp.verifyInvariants()))
-        signalPassFailure();
-      return;
+      return regOp.verifyInvariants();
     }
     LLVM_DEBUG(llvm::dbgs() << "- Updating reset of " << regOp << "\n");
 
@@ -1797,6 +1851,8 @@ void InferResetsPass::implementAsyncReset(Operation *op, FModuleOp module,
     regOp.getResetSignalMutable().assign(actualReset);
     regOp.getResetValueMutable().assign(zero);
   }
+
+  return success();
 }
 
 LogicalResult InferResetsPass::verifyNoAbstractReset() {
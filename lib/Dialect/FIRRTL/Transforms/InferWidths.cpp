@@ -18,15 +18,18 @@
 #include "circt/Dialect/FIRRTL/Passes.h"
 #include "circt/Support/FieldRef.h"
 #include "mlir/IR/ImplicitLocOpBuilder.h"
+#include "mlir/IR/Threading.h"
 #include "llvm/ADT/APSInt.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/GraphTraits.h"
-#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/IntEqClasses.h"
 #include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/ADT/Sequence.h"
 #include "llvm/ADT/SetVector.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
+#include <chrono>
 
 #define DEBUG_TYPE "infer-widths"
 
@@ -63,289 +66,179 @@ static void diagnoseUninferredType(InFlightDiagnostic &diag, Type t,
 //===----------------------------------------------------------------------===//
 
 namespace {
-struct Expr;
-} // namespace
-
-/// Allow rvalue refs to `Expr` and subclasses to be printed to streams.
-template <typename T, typename std::enable_if<std::is_base_of<Expr, T>::value,
-                                              int>::type = 0>
-inline llvm::raw_ostream &operator<<(llvm::raw_ostream &os, const T &e) {
-  e.print(os);
-  return os;
-}
-
-// Allow expression subclasses to be hashed.
-namespace mlir {
-template <typename T, typename std::enable_if<std::is_base_of<Expr, T>::value,
-                                              int>::type = 0>
-inline llvm::hash_code hash_value(const T &e) {
-  return e.hash_value();
-}
-} // namespace mlir
-
-namespace {
-#define EXPR_NAMES(x)                                                          \
-  Root##x, Var##x, Derived##x, Id##x, Known##x, Add##x, Pow##x, Max##x, Min##x
-#define EXPR_KINDS EXPR_NAMES()
-#define EXPR_CLASSES EXPR_NAMES(Expr)
-
-/// An expression on the right-hand side of a constraint.
-struct Expr {
-  enum class Kind { EXPR_KINDS };
-  std::optional<int32_t> solution;
-  Kind kind;
-
-  /// Print a human-readable representation of this expr.
-  void print(llvm::raw_ostream &os) const;
-
-protected:
-  Expr(Kind kind) : kind(kind) {}
-  llvm::hash_code hash_value() const { return llvm::hash_value(kind); }
-};
-
-/// Helper class to CRTP-derive common functions.
-template <class DerivedT, Expr::Kind DerivedKind>
-struct ExprBase : public Expr {
-  ExprBase() : Expr(DerivedKind) {}
-  static bool classof(const Expr *e) { return e->kind == DerivedKind; }
-  bool operator==(const Expr &other) const {
-    if (auto otherSame = dyn_cast<DerivedT>(other))
-      return *static_cast<DerivedT *>(this) == otherSame;
-    return false;
-  }
-};
-
-/// The root containing all expressions.
-struct RootExpr : public ExprBase<RootExpr, Expr::Kind::Root> {
-  RootExpr(std::vector<Expr *> &exprs) : exprs(exprs) {}
-  void print(llvm::raw_ostream &os) const { os << "root"; }
-  std::vector<Expr *> &exprs;
+/// The identifier of an expression in an `ExprPool`. Expressions are numbered
+/// in the order they are created in, starting at one. The operands of an
+/// expression are therefore always numbered lower than the expression itself.
+/// The zero identifier indicates the absence of an expression.
+using ExprId = uint32_t;
+constexpr ExprId noExpr = 0;
+
+/// The kinds of expressions on the right-hand side of a constraint.
+enum class ExprKind : uint8_t {
+  /// A free variable. Its operands are the constraint expression the variable
+  /// is supposed to be greater than or equal to, and the upper bound it is
+  /// supposed to be smaller than or equal to. Neither is part of the
+  /// variable's identity.
+  Var,
+  /// A derived width.
+  ///
+  /// These are generated for `InvalidValueOp`s which want to derived their
+  /// width from connect operations that they are on the right hand side of.
+  /// Its operand is the expression this derived width is equivalent to.
+  Derived,
+  /// An identity expression.
+  ///
+  /// This expression evaluates to its inner expression. It is used in a very
+  /// specific case of constraints on variables, in order to be able to track
+  /// where the constraint was imposed. Constraints on variables are
+  /// represented as `var >= <expr>`. When the first constraint `a` is imposed,
+  /// it is stored as the constraint expression (`var >= a`). When the second
+  /// constraint `b` is imposed, a *new* max expression is allocated
+  /// (`var >= max(a, b)`). Expressions are annotated with a location when they
+  /// are created, which in this case are connect ops. Since imposing the first
+  /// constraint does not create any new expression, the location information
+  /// of that connect would be lost. With an identity expression, imposing the
+  /// first constraint becomes `var >= identity(a)`, which is a *new*
+  /// expression and properly tracks the location info.
+  Id,
+  /// A known constant value.
+  Known,
+  /// An addition.
+  Add,
+  /// A power of two.
+  Pow,
+  /// The maximum of two expressions.
+  Max,
+  /// The minimum of two expressions.
+  Min,
 };
 
-/// A free variable.
-struct VarExpr : public ExprBase<VarExpr, Expr::Kind::Var> {
-  void print(llvm::raw_ostream &os) const {
-    // Hash the `this` pointer into something somewhat human readable. Since
-    // this is just for debug dumping, we wrap around at 4096 variables.
-    os << "var" << ((size_t)this / llvm::PowerOf2Ceil(sizeof(*this)) & 0xFFF);
+/// A pool of constraint expressions. The expressions are stored as a struct of
+/// arrays indexed by their `ExprId`, which takes 14 bytes per expression and
+/// keeps the expressions visited while solving close together in memory.
+/// Expressions other than variables and derived widths are hash-consed, such
+/// that every distinct expression exists only once.
+class ExprPool {
+public:
+  ExprPool() {
+    // Reserve the zero identifier for `noExpr`.
+    kinds.push_back(ExprKind::Known);
+    operands.push_back({noExpr, noExpr});
+    solutions.push_back(0);
+    solved.push_back(false);
   }
 
-  /// The constraint expression this variable is supposed to be greater than or
-  /// equal to. This is not part of the variable's hash and equality property.
-  Expr *constraint = nullptr;
-
-  /// The upper bound this variable is supposed to be smaller than or equal to.
-  Expr *upperBound = nullptr;
-  std::optional<int32_t> upperBoundSolution;
-};
-
-/// A derived width.
-///
-/// These are generated for `InvalidValueOp`s which want to derived their width
-/// from connect operations that they are on the right hand side of.
-struct DerivedExpr : public ExprBase<DerivedExpr, Expr::Kind::Derived> {
-  void print(llvm::raw_ostream &os) const {
-    // Hash the `this` pointer into something somewhat human readable.
-    os << "derive"
-       << ((size_t)this / llvm::PowerOf2Ceil(sizeof(*this)) & 0xFFF);
+  /// Create a new expression that is never reused.
+  ExprId create(ExprKind kind) { return append(kind, noExpr, noExpr); }
+
+  /// Return the existing expression with the given kind and operands, or
+  /// create it if it does not exist yet. The second element of the result
+  /// indicates whether a new expression was created.
+  std::pair<ExprId, bool> intern(ExprKind kind, ExprId lhs, ExprId rhs) {
+    auto key = std::make_tuple(static_cast<uint8_t>(kind), lhs, rhs);
+    auto [it, inserted] = interned.insert({key, noExpr});
+    if (inserted)
+      it->second = append(kind, lhs, rhs);
+    return {it->second, inserted};
   }
 
-  /// The expression this derived width is equivalent to.
-  Expr *assigned = nullptr;
-};
-
-/// An identity expression.
-///
-/// This expression evaluates to its inner expression. It is used in a very
-/// specific case of constraints on variables, in order to be able to track
-/// where the constraint was imposed. Constraints on variables are represented
-/// as `var >= <expr>`. When the first constraint `a` is imposed, it is stored
-/// as the constraint expression (`var >= a`). When the second constraint `b` is
-/// imposed, a *new* max expression is allocated (`var >= max(a, b)`).
-/// Expressions are annotated with a location when they are created, which in
-/// this case are connect ops. Since imposing the first constraint does not
-/// create any new expression, the location information of that connect would be
-/// lost. With an identity expression, imposing the first constraint becomes
-/// `var >= identity(a)`, which is a *new* expression and properly tracks the
-/// location info.
-struct IdExpr : public ExprBase<IdExpr, Expr::Kind::Id> {
-  IdExpr(Expr *arg) : arg(arg) { assert(arg); }
-  void print(llvm::raw_ostream &os) const { os << "*" << *arg; }
-  bool operator==(const IdExpr &other) const {
-    return kind == other.kind && arg == other.arg;
-  }
-  llvm::hash_code hash_value() const {
-    return llvm::hash_combine(Expr::hash_value(), arg);
-  }
+  /// Return the number of expressions in the pool.
+  size_t size() const { return kinds.size() - 1; }
 
-  /// The inner expression.
-  Expr *const arg;
-};
+  /// Return the range of identifiers of all expressions in the pool.
+  auto getIds() const { return llvm::seq<ExprId>(1, kinds.size()); }
 
-/// A known constant value.
-struct KnownExpr : public ExprBase<KnownExpr, Expr::Kind::Known> {
-  KnownExpr(int32_t value) : ExprBase() { solution = value; }
-  void print(llvm::raw_ostream &os) const { os << *solution; }
-  bool operator==(const KnownExpr &other) const {
-    return *solution == *other.solution;
-  }
-  llvm::hash_code hash_value() const {
-    return llvm::hash_combine(Expr::hash_value(), *solution);
-  }
-};
+  ExprKind getKind(ExprId id) const { return kinds[id]; }
+  ExprId getLhs(ExprId id) const { return operands[id][0]; }
+  ExprId getRhs(ExprId id) const { return operands[id][1]; }
+  void setLhs(ExprId id, ExprId lhs) { operands[id][0] = lhs; }
+  void setRhs(ExprId id, ExprId rhs) { operands[id][1] = rhs; }
 
-/// A unary expression. Contains the actual data. Concrete subclasses are merely
-/// there for show and ease of use.
-struct UnaryExpr : public Expr {
-  bool operator==(const UnaryExpr &other) const {
-    return kind == other.kind && arg == other.arg;
+  std::optional<int32_t> getSolution(ExprId id) const {
+    if (!solved[id])
+      return std::nullopt;
+    return solutions[id];
   }
-  llvm::hash_code hash_value() const {
-    return llvm::hash_combine(Expr::hash_value(), arg);
+  void setSolution(ExprId id, std::optional<int32_t> solution) {
+    solved[id] = solution.has_value();
+    if (solution)
+      solutions[id] = *solution;
   }
 
-  /// The child expression.
-  Expr *const arg;
-
-protected:
-  UnaryExpr(Kind kind, Expr *arg) : Expr(kind), arg(arg) { assert(arg); }
-};
-
-/// Helper class to CRTP-derive common functions.
-template <class DerivedT, Expr::Kind DerivedKind>
-struct UnaryExprBase : public UnaryExpr {
-  template <typename... Args>
-  UnaryExprBase(Args &&...args)
-      : UnaryExpr(DerivedKind, std::forward<Args>(args)...) {}
-  static bool classof(const Expr *e) { return e->kind == DerivedKind; }
-};
-
-/// A power of two.
-struct PowExpr : public UnaryExprBase<PowExpr, Expr::Kind::Pow> {
-  using UnaryExprBase::UnaryExprBase;
-  void print(llvm::raw_ostream &os) const { os << "2^" << arg; }
-};
-
-/// A binary expression. Contains the actual data. Concrete subclasses are
-/// merely there for show and ease of use.
-struct BinaryExpr : public Expr {
-  bool operator==(const BinaryExpr &other) const {
-    return kind == other.kind && lhs() == other.lhs() && rhs() == other.rhs();
-  }
-  llvm::hash_code hash_value() const {
-    return llvm::hash_combine(Expr::hash_value(), *args);
+  /// Return the number of bytes allocated for the expressions.
+  size_t getMemorySize() const {
+    return kinds.capacity() * sizeof(ExprKind) +
+           operands.capacity() * sizeof(operands[0]) +
+           solutions.capacity() * sizeof(int32_t) +
+           solved.capacity() * sizeof(uint8_t) + interned.getMemorySize();
   }
-  Expr *lhs() const { return args[0]; }
-  Expr *rhs() const { return args[1]; }
 
-  /// The child expressions.
-  Expr *const args[2];
+  /// Print a human-readable representation of an expression.
+  void print(llvm::raw_ostream &os, ExprId id) const;
 
-protected:
-  BinaryExpr(Kind kind, Expr *lhs, Expr *rhs) : Expr(kind), args{lhs, rhs} {
-    assert(lhs);
-    assert(rhs);
+private:
+  ExprId append(ExprKind kind, ExprId lhs, ExprId rhs) {
+    assert(kinds.size() < std::numeric_limits<ExprId>::max());
+    ExprId id = kinds.size();
+    kinds.push_back(kind);
+    operands.push_back({lhs, rhs});
+    solutions.push_back(0);
+    solved.push_back(false);
+    return id;
   }
-};
 
-/// Helper class to CRTP-derive common functions.
-template <class DerivedT, Expr::Kind DerivedKind>
-struct BinaryExprBase : public BinaryExpr {
-  template <typename... Args>
-  BinaryExprBase(Args &&...args)
-      : BinaryExpr(DerivedKind, std::forward<Args>(args)...) {}
-  static bool classof(const Expr *e) { return e->kind == DerivedKind; }
-};
+  std::vector<ExprKind> kinds;
+  std::vector<std::array<ExprId, 2>> operands;
+  std::vector<int32_t> solutions;
+  // Not a `std::vector<bool>`, since the solutions of different variables are
+  // computed concurrently.
+  std::vector<uint8_t> solved;
 
-/// An addition.
-struct AddExpr : public BinaryExprBase<AddExpr, Expr::Kind::Add> {
-  using BinaryExprBase::BinaryExprBase;
-  void print(llvm::raw_ostream &os) const {
-    os << "(" << *lhs() << " + " << *rhs() << ")";
-  }
+  /// The hash-consed expressions. Known constants store their value in place
+  /// of the first operand.
+  DenseMap<std::tuple<uint8_t, ExprId, ExprId>, ExprId> interned;
 };
 
-/// The maximum of two expressions.
-struct MaxExpr : public BinaryExprBase<MaxExpr, Expr::Kind::Max> {
-  using BinaryExprBase::BinaryExprBase;
-  void print(llvm::raw_ostream &os) const {
-    os << "max(" << *lhs() << ", " << *rhs() << ")";
-  }
+/// An expression paired with the pool it lives in, for printing to streams.
+struct PrintableExpr {
+  const ExprPool &pool;
+  ExprId id;
 };
 
-/// The minimum of two expressions.
-struct MinExpr : public BinaryExprBase<MinExpr, Expr::Kind::Min> {
-  using BinaryExprBase::BinaryExprBase;
-  void print(llvm::raw_ostream &os) const {
-    os << "min(" << *lhs() << ", " << *rhs() << ")";
-  }
-};
-
-void Expr::print(llvm::raw_ostream &os) const {
-  TypeSwitch<const Expr *>(this).Case<EXPR_CLASSES>(
-      [&](auto *e) { e->print(os); });
+llvm::raw_ostream &operator<<(llvm::raw_ostream &os, PrintableExpr expr) {
+  expr.pool.print(os, expr.id);
+  return os;
 }
 
-} // namespace
-
-//===----------------------------------------------------------------------===//
-// Fast bump allocator with optional interning
-//===----------------------------------------------------------------------===//
-
-namespace {
-
-/// An allocation slot in the `InternedAllocator`.
-template <typename T>
-struct InternedSlot {
-  T *ptr;
-  InternedSlot(T *ptr) : ptr(ptr) {}
-};
-
-/// A simple bump allocator that ensures only ever one copy per object exists.
-/// The allocated objects must not have a destructor.
-template <typename T, typename std::enable_if_t<
-                          std::is_trivially_destructible<T>::value, int> = 0>
-class InternedAllocator {
-  using Slot = InternedSlot<T>;
-  llvm::DenseSet<Slot> interned;
-  llvm::BumpPtrAllocator &allocator;
-
-public:
-  InternedAllocator(llvm::BumpPtrAllocator &allocator) : allocator(allocator) {}
-
-  /// Allocate a new object if it does not yet exist, or return a pointer to the
-  /// existing one. `R` is the type of the object to be allocated. `R` must be
-  /// derived from or be the type `T`.
-  template <typename R = T, typename... Args>
-  std::pair<R *, bool> alloc(Args &&...args) {
-    auto stack_value = R(std::forward<Args>(args)...);
-    auto stack_slot = Slot(&stack_value);
-    auto it = interned.find(stack_slot);
-    if (it != interned.end())
-      return std::make_pair(static_cast<R *>(it->ptr), false);
-    auto heap_value = new (allocator) R(std::move(stack_value));
-    interned.insert(Slot(heap_value));
-    return std::make_pair(heap_value, true);
+void ExprPool::print(llvm::raw_ostream &os, ExprId id) const {
+  PrintableExpr lhs{*this, getLhs(id)}, rhs{*this, getRhs(id)};
+  switch (getKind(id)) {
+  case ExprKind::Var:
+    os << "var" << id;
+    break;
+  case ExprKind::Derived:
+    os << "derive" << id;
+    break;
+  case ExprKind::Id:
+    os << "*" << lhs;
+    break;
+  case ExprKind::Known:
+    os << solutions[id];
+    break;
+  case ExprKind::Add:
+    os << "(" << lhs << " + " << rhs << ")";
+    break;
+  case ExprKind::Pow:
+    os << "2^" << lhs;
+    break;
+  case ExprKind::Max:
+    os << "max(" << lhs << ", " << rhs << ")";
+    break;
+  case ExprKind::Min:
+    os << "min(" << lhs << ", " << rhs << ")";
+    break;
   }
-};
-
-/// A simple bump allocator. The allocated objects must not have a destructor.
-/// This allocator is mainly there for symmetry with the `InternedAllocator`.
-template <typename T, typename std::enable_if_t<
-                          std::is_trivially_destructible<T>::value, int> = 0>
-class Allocator {
-  llvm::BumpPtrAllocator &allocator;
-
-public:
-  Allocator(llvm::BumpPtrAllocator &allocator) : allocator(allocator) {}
-
-  /// Allocate a new object. `R` is the type of the object to be allocated. `R`
-  /// must be derived from or be the type `T`.
-  template <typename R = T, typename... Args>
-  R *alloc(Args &&...args) {
-    return new (allocator) R(std::forward<Args>(args)...);
-  }
-};
+}
 
 } // namespace
 
@@ -573,120 +466,189 @@ struct LinIneq {
   }
 };
 
+/// The solution of an expression, and whether a cycle was broken to arrive at
+/// it.
+using ExprSolution = std::pair<std::optional<int32_t>, bool>;
+
 /// A simple solver for width constraints.
 class ConstraintSolver {
 public:
   ConstraintSolver() = default;
 
-  VarExpr *var() {
-    auto v = vars.alloc();
-    exprs.push_back(v);
-    if (currentInfo)
-      info[v].insert(currentInfo);
-    if (currentLoc)
-      locs[v].insert(*currentLoc);
-    return v;
+  ExprId var() { return record(exprs.create(ExprKind::Var)); }
+  ExprId derived() { return exprs.create(ExprKind::Derived); }
+  ExprId known(int32_t value) {
+    auto [expr, created] =
+        exprs.intern(ExprKind::Known, static_cast<ExprId>(value), noExpr);
+    if (created)
+      exprs.setSolution(expr, value);
+    return record(expr);
   }
-  DerivedExpr *derived() {
-    auto *d = derivs.alloc();
-    exprs.push_back(d);
-    return d;
+  ExprId id(ExprId arg) { return intern(ExprKind::Id, arg); }
+  ExprId pow(ExprId arg) { return intern(ExprKind::Pow, arg); }
+  ExprId add(ExprId lhs, ExprId rhs) { return intern(ExprKind::Add, lhs, rhs); }
+  ExprId max(ExprId lhs, ExprId rhs) { return intern(ExprKind::Max, lhs, rhs); }
+  ExprId min(ExprId lhs, ExprId rhs) { return intern(ExprKind::Min, lhs, rhs); }
+
+  bool isVar(ExprId expr) const {
+    return exprs.getKind(expr) == ExprKind::Var;
+  }
+  bool isDerived(ExprId expr) const {
+    return exprs.getKind(expr) == ExprKind::Derived;
+  }
+
+  /// Assign the expression a derived width is equivalent to.
+  void derive(ExprId derived, ExprId assigned) {
+    assert(isDerived(derived));
+    exprs.setLhs(derived, assigned);
   }
-  KnownExpr *known(int32_t value) { return alloc<KnownExpr>(knowns, value); }
-  IdExpr *id(Expr *arg) { return alloc<IdExpr>(ids, arg); }
-  PowExpr *pow(Expr *arg) { return alloc<PowExpr>(uns, arg); }
-  AddExpr *add(Expr *lhs, Expr *rhs) { return alloc<AddExpr>(bins, lhs, rhs); }
-  MaxExpr *max(Expr *lhs, Expr *rhs) { return alloc<MaxExpr>(bins, lhs, rhs); }
-  MinExpr *min(Expr *lhs, Expr *rhs) { return alloc<MinExpr>(bins, lhs, rhs); }
 
   /// Add a constraint `lhs >= rhs`. Multiple constraints on the same variable
   /// are coalesced into a `max(a, b)` expr.
-  Expr *addGeqConstraint(VarExpr *lhs, Expr *rhs) {
-    if (lhs->constraint)
-      lhs->constraint = max(lhs->constraint, rhs);
-    else
-      lhs->constraint = id(rhs);
-    return lhs->constraint;
+  ExprId addGeqConstraint(ExprId lhs, ExprId rhs) {
+    assert(isVar(lhs));
+    auto constraint = exprs.getLhs(lhs);
+    constraint = constraint ? max(constraint, rhs) : id(rhs);
+    exprs.setLhs(lhs, constraint);
+    return constraint;
   }
 
   /// Add a constraint `lhs <= rhs`. Multiple constraints on the same variable
   /// are coalesced into a `min(a, b)` expr.
-  Expr *addLeqConstraint(VarExpr *lhs, Expr *rhs) {
-    if (lhs->upperBound)
-      lhs->upperBound = min(lhs->upperBound, rhs);
-    else
-      lhs->upperBound = id(rhs);
-    return lhs->upperBound;
+  ExprId addLeqConstraint(ExprId lhs, ExprId rhs) {
+    assert(isVar(lhs));
+    auto upperBound = exprs.getRhs(lhs);
+    upperBound = upperBound ? min(upperBound, rhs) : id(rhs);
+    exprs.setRhs(lhs, upperBound);
+    return upperBound;
   }
 
+  std::optional<int32_t> getSolution(ExprId expr) const {
+    return exprs.getSolution(expr);
+  }
+  PrintableExpr printable(ExprId expr) const { return {exprs, expr}; }
+
   void dumpConstraints(llvm::raw_ostream &os);
-  LogicalResult solve();
+  LogicalResult solve(MLIRContext *context);
+
+  /// Return the number of independent groups of variables solved, and the
+  /// number of variables in the largest one.
+  size_t getNumGroups() const { return numGroups; }
+  size_t getLargestGroupSize() const { return largestGroupSize; }
+
+  /// Return the number of expressions created, and the number of bytes
+  /// allocated for them and their context information.
+  size_t getNumExprs() const { return exprs.size(); }
+  size_t getMemorySize() const {
+    return exprs.getMemorySize() + info.capacity() * sizeof(info[0]) +
+           locs.capacity() * sizeof(locs[0]);
+  }
 
-  using ContextInfo = DenseMap<Expr *, llvm::SmallSetVector<FieldRef, 1>>;
-  const ContextInfo &getContextInfo() const { return info; }
   void setCurrentContextInfo(FieldRef fieldRef) { currentInfo = fieldRef; }
   void setCurrentLocation(std::optional<Location> loc) { currentLoc = loc; }
 
 private:
-  // Allocator for constraint expressions.
-  llvm::BumpPtrAllocator allocator;
-  Allocator<VarExpr> vars = {allocator};
-  Allocator<DerivedExpr> derivs = {allocator};
-  InternedAllocator<KnownExpr> knowns = {allocator};
-  InternedAllocator<IdExpr> ids = {allocator};
-  InternedAllocator<UnaryExpr> uns = {allocator};
-  InternedAllocator<BinaryExpr> bins = {allocator};
-
-  /// A list of expressions in the order they were created.
-  std::vector<Expr *> exprs;
-  RootExpr root = {exprs};
-
-  /// Add an allocated expression to the list above.
-  template <typename R, typename T, typename... Args>
-  R *alloc(InternedAllocator<T> &allocator, Args &&...args) {
-    auto it = allocator.template alloc<R>(std::forward<Args>(args)...);
-    if (it.second)
-      exprs.push_back(it.first);
-    if (currentInfo)
-      info[it.first].insert(currentInfo);
-    if (currentLoc)
-      locs[it.first].insert(*currentLoc);
-    return it.first;
+  /// The constraint expressions.
+  ExprPool exprs;
+
+  /// Create or reuse an expression and record the current context for it.
+  ExprId intern(ExprKind kind, ExprId lhs, ExprId rhs = noExpr) {
+    assert(lhs && (rhs || kind == ExprKind::Id || kind == ExprKind::Pow));
+    return record(exprs.intern(kind, lhs, rhs).first);
   }
+  ExprId record(ExprId expr);
 
   /// Contextual information for each expression, indicating which values in the
-  /// IR lead to this expression.
-  ContextInfo info;
+  /// IR lead to this expression. These are only needed to report errors, and
+  /// are kept as flat lists that are sorted by expression on first use.
+  std::vector<std::pair<ExprId, FieldRef>> info;
+  std::vector<std::pair<ExprId, Location>> locs;
+  bool contextSorted = true;
   FieldRef currentInfo = {};
-  DenseMap<Expr *, llvm::SmallSetVector<Location, 1>> locs;
   std::optional<Location> currentLoc;
 
-  // Forbid copyign or moving the solver, which would invalidate the refs to
-  // allocator held by the allocators.
-  ConstraintSolver(ConstraintSolver &&) = delete;
-  ConstraintSolver(const ConstraintSolver &) = delete;
-  ConstraintSolver &operator=(ConstraintSolver &&) = delete;
-  ConstraintSolver &operator=(const ConstraintSolver &) = delete;
+  void sortContext();
+  llvm::SmallSetVector<FieldRef, 1> getInfo(ExprId expr);
+  llvm::SmallSetVector<Location, 1> getLocs(ExprId expr);
+
+  void emitUninferredWidthError(ExprId var);
 
-  void emitUninferredWidthError(VarExpr *var);
+  using SeenVars = llvm::SmallDenseSet<ExprId, 16>;
+  using VarGroups = std::vector<SmallVector<ExprId, 0>>;
+  VarGroups partitionVars();
+  bool solveVar(ExprId var, SeenVars &seenVars);
 
-  LinIneq checkCycles(VarExpr *var, Expr *expr,
-                      SmallPtrSetImpl<Expr *> &seenVars,
+  /// Statistics about the last call to `solve`.
+  size_t numGroups = 0;
+  size_t largestGroupSize = 0;
+
+  LinIneq checkCycles(ExprId var, ExprId expr, SeenVars &seenVars,
                       InFlightDiagnostic *reportInto = nullptr,
                       unsigned indent = 1);
+
+  ExprSolution solveExpr(ExprId expr, SeenVars &seenVars, unsigned indent = 1);
 };
 
 } // namespace
 
+/// Record the current context information and location for an expression,
+/// skipping repetitions of the last recorded entry.
+ExprId ConstraintSolver::record(ExprId expr) {
+  if (currentInfo &&
+      (info.empty() || info.back() != std::make_pair(expr, currentInfo))) {
+    contextSorted &= info.empty() || info.back().first <= expr;
+    info.push_back({expr, currentInfo});
+  }
+  if (currentLoc &&
+      (locs.empty() || locs.back() != std::make_pair(expr, *currentLoc))) {
+    contextSorted &= locs.empty() || locs.back().first <= expr;
+    locs.push_back({expr, *currentLoc});
+  }
+  return expr;
+}
+
+/// Collect the entries recorded for an expression in a sorted context list, in
+/// the order they were recorded in.
+template <typename T>
+static llvm::SmallSetVector<T, 1>
+lookupContext(ArrayRef<std::pair<ExprId, T>> entries, ExprId expr) {
+  auto *it = llvm::partition_point(
+      entries, [&](auto &entry) { return entry.first < expr; });
+  llvm::SmallSetVector<T, 1> result;
+  for (; it != entries.end() && it->first == expr; ++it)
+    result.insert(it->second);
+  return result;
+}
+
+/// Sort the context lists by expression, keeping the entries of each
+/// expression in the order they were recorded in.
+void ConstraintSolver::sortContext() {
+  if (contextSorted)
+    return;
+  llvm::stable_sort(info, llvm::less_first());
+  llvm::stable_sort(locs, llvm::less_first());
+  contextSorted = true;
+}
+
+llvm::SmallSetVector<FieldRef, 1> ConstraintSolver::getInfo(ExprId expr) {
+  sortContext();
+  return lookupContext<FieldRef>(info, expr);
+}
+
+llvm::SmallSetVector<Location, 1> ConstraintSolver::getLocs(ExprId expr) {
+  sortContext();
+  return lookupContext<Location>(locs, expr);
+}
+
 /// Print all constraints in the solver to an output stream.
 void ConstraintSolver::dumpConstraints(llvm::raw_ostream &os) {
-  for (auto *e : exprs) {
-    if (auto *v = dyn_cast<VarExpr>(e)) {
-      if (v->constraint)
-        os << "- " << *v << " >= " << *v->constraint << "\n";
-      else
-        os << "- " << *v << " unconstrained\n";
-    }
+  for (auto expr : exprs.getIds()) {
+    if (!isVar(expr))
+      continue;
+    if (auto constraint = exprs.getLhs(expr))
+      os << "- " << printable(expr) << " >= " << printable(constraint) << "\n";
+    else
+      os << "- " << printable(expr) << " unconstrained\n";
   }
 }
 
@@ -702,67 +664,65 @@ inline llvm::raw_ostream &operator<<(llvm::raw_ostream &os, const LinIneq &l) {
 /// used as a recursion breaker. Occurrences of `var` itself within the
 /// expression are mapped to the `a` coefficient in the inequality. Any other
 /// variables are substituted and, in the presence of a recursion in a variable
-/// other than `var`, treated as zero. `info` is a mapping from constraint
-/// expressions to values and operations that produced the expression, and is
-/// used during error reporting. If `reportInto` is present, the function will
-/// additionally attach unsatisfiable inequalities as notes to the diagnostic as
-/// it encounters them.
-LinIneq ConstraintSolver::checkCycles(VarExpr *var, Expr *expr,
-                                      SmallPtrSetImpl<Expr *> &seenVars,
+/// other than `var`, treated as zero. If `reportInto` is present, the function
+/// will additionally attach unsatisfiable inequalities as notes to the
+/// diagnostic as it encounters them, using the locations recorded for the
+/// constraint expressions.
+LinIneq ConstraintSolver::checkCycles(ExprId var, ExprId expr,
+                                      SeenVars &seenVars,
                                       InFlightDiagnostic *reportInto,
                                       unsigned indent) {
-  auto ineq =
-      TypeSwitch<Expr *, LinIneq>(expr)
-          .Case<KnownExpr>([&](auto *expr) { return LinIneq(*expr->solution); })
-          .Case<VarExpr>([&](auto *expr) {
-            if (expr == var)
-              return LinIneq(1, 0); // x >= 1*x + 0
-            if (!seenVars.insert(expr).second)
-              // Count recursions in other variables as 0. This is sane
-              // since the cycle is either breakable, in which case the
-              // recursion does not modify the resulting value of the
-              // variable, or it is not breakable and will be caught by
-              // this very function once it is called on that variable.
-              return LinIneq(0);
-            if (!expr->constraint)
-              // Count unconstrained variables as `x >= 0`.
-              return LinIneq(0);
-            auto l = checkCycles(var, expr->constraint, seenVars, reportInto,
-                                 indent + 1);
-            seenVars.erase(expr);
-            return l;
-          })
-          .Case<IdExpr>([&](auto *expr) {
-            return checkCycles(var, expr->arg, seenVars, reportInto,
-                               indent + 1);
-          })
-          .Case<PowExpr>([&](auto *expr) {
-            // If we can evaluate `2**arg` to a sensible constant, do
-            // so. This is the case if a == 0 and c < 31 such that 2**c is
-            // representable.
-            auto arg =
-                checkCycles(var, expr->arg, seenVars, reportInto, indent + 1);
-            if (arg.rec_scale != 0 || arg.nonrec_bias < 0 ||
-                arg.nonrec_bias >= 31)
-              return LinIneq::unsat();
-            return LinIneq(1 << arg.nonrec_bias); // x >= 2**arg
-          })
-          .Case<AddExpr>([&](auto *expr) {
-            return LinIneq::add(
-                checkCycles(var, expr->lhs(), seenVars, reportInto, indent + 1),
-                checkCycles(var, expr->rhs(), seenVars, reportInto,
-                            indent + 1));
-          })
-          .Case<MaxExpr, MinExpr>([&](auto *expr) {
-            // Combine the inequalities of the LHS and RHS into a single overly
-            // pessimistic inequality. We treat `MinExpr` the same as `MaxExpr`,
-            // since `max(a,b)` is an upper bound to `min(a,b)`.
-            return LinIneq::max(
-                checkCycles(var, expr->lhs(), seenVars, reportInto, indent + 1),
-                checkCycles(var, expr->rhs(), seenVars, reportInto,
-                            indent + 1));
-          })
-          .Default([](auto) { return LinIneq::unsat(); });
+  auto recurse = [&](ExprId expr) {
+    return checkCycles(var, expr, seenVars, reportInto, indent + 1);
+  };
+  auto lhs = exprs.getLhs(expr), rhs = exprs.getRhs(expr);
+  LinIneq ineq = LinIneq::unsat();
+  switch (exprs.getKind(expr)) {
+  case ExprKind::Known:
+    ineq = LinIneq(*exprs.getSolution(expr));
+    break;
+  case ExprKind::Var:
+    if (expr == var) {
+      ineq = LinIneq(1, 0); // x >= 1*x + 0
+    } else if (!seenVars.insert(expr).second) {
+      // Count recursions in other variables as 0. This is sane since the cycle
+      // is either breakable, in which case the recursion does not modify the
+      // resulting value of the variable, or it is not breakable and will be
+      // caught by this very function once it is called on that variable.
+      ineq = LinIneq(0);
+    } else if (!lhs) {
+      // Count unconstrained variables as `x >= 0`.
+      ineq = LinIneq(0);
+      seenVars.erase(expr);
+    } else {
+      ineq = recurse(lhs);
+      seenVars.erase(expr);
+    }
+    break;
+  case ExprKind::Derived:
+    break;
+  case ExprKind::Id:
+    ineq = recurse(lhs);
+    break;
+  case ExprKind::Pow: {
+    // If we can evaluate `2**arg` to a sensible constant, do so. This is the
+    // case if a == 0 and c < 31 such that 2**c is representable.
+    auto arg = recurse(lhs);
+    if (arg.rec_scale == 0 && arg.nonrec_bias >= 0 && arg.nonrec_bias < 31)
+      ineq = LinIneq(1 << arg.nonrec_bias); // x >= 2**arg
+    break;
+  }
+  case ExprKind::Add:
+    ineq = LinIneq::add(recurse(lhs), recurse(rhs));
+    break;
+  case ExprKind::Max:
+  case ExprKind::Min:
+    // Combine the inequalities of the LHS and RHS into a single overly
+    // pessimistic inequality. We treat `min` the same as `max`, since
+    // `max(a,b)` is an upper bound to `min(a,b)`.
+    ineq = LinIneq::max(recurse(lhs), recurse(rhs));
+    break;
+  }
 
   // If we were passed an in-flight diagnostic and the current inequality is
   // unsatisfiable, attach notes to the diagnostic indicating the values or
@@ -782,20 +742,16 @@ LinIneq ConstraintSolver::checkCycles(VarExpr *var, Expr *expr,
         note << "+" << ineq.rec_bias;
       note << " here:";
     };
-    auto it = locs.find(expr);
-    if (it != locs.end())
-      for (auto loc : it->second)
-        report(loc);
+    for (auto loc : getLocs(expr))
+      report(loc);
   }
   if (!reportInto)
     LLVM_DEBUG(llvm::dbgs().indent(indent * 2)
-               << "- Visited " << *expr << ": " << ineq << "\n");
+               << "- Visited " << printable(expr) << ": " << ineq << "\n");
 
   return ineq;
 }
 
-using ExprSolution = std::pair<std::optional<int32_t>, bool>;
-
 static ExprSolution
 computeUnary(ExprSolution arg, llvm::function_ref<int32_t(int32_t)> operation) {
   if (arg.first)
@@ -821,147 +777,233 @@ computeBinary(ExprSolution lhs, ExprSolution rhs,
 /// and a boolean indicating whether a recursion was detected. This may be used
 /// to memoize the result of expressions in case they were not involved in a
 /// cycle (which may alter their value from the perspective of a variable).
-static ExprSolution solveExpr(Expr *expr, SmallPtrSetImpl<Expr *> &seenVars,
-                              unsigned indent = 1) {
+ExprSolution
+ConstraintSolver::solveExpr(ExprId expr, SeenVars &seenVars, unsigned indent) {
+  auto kind = exprs.getKind(expr);
+
   // See if we have a memoized result we can return.
-  if (expr->solution) {
+  if (auto solution = exprs.getSolution(expr)) {
     LLVM_DEBUG({
-      if (!isa<KnownExpr>(expr))
-        llvm::dbgs().indent(indent * 2)
-            << "- Cached " << *expr << " = " << *expr->solution << "\n";
+      if (kind != ExprKind::Known)
+        llvm::dbgs().indent(indent * 2) << "- Cached " << printable(expr)
+                                        << " = " << *solution << "\n";
     });
-    return {*expr->solution, false};
+    return {*solution, false};
   }
 
   // Otherwise compute the value of the expression.
-  LLVM_DEBUG({
-    if (!isa<KnownExpr>(expr))
-      llvm::dbgs().indent(indent * 2) << "- Solving " << *expr << "\n";
-  });
-  auto solution =
-      TypeSwitch<Expr *, ExprSolution>(expr)
-          .Case<KnownExpr>([&](auto *expr) {
-            return ExprSolution{*expr->solution, false};
-          })
-          .Case<VarExpr>([&](auto *expr) {
-            // Unconstrained variables produce no solution.
-            if (!expr->constraint)
-              return ExprSolution{std::nullopt, false};
-            // Return no solution for recursions in the variables. This is sane
-            // and will cause the expression to be ignored when computing the
-            // parent, e.g. `a >= max(a, 1)` will become just `a >= 1`.
-            if (!seenVars.insert(expr).second)
-              return ExprSolution{std::nullopt, true};
-            auto solution = solveExpr(expr->constraint, seenVars, indent + 1);
-            if (expr->upperBound)
-              expr->upperBoundSolution =
-                  solveExpr(expr->upperBound, seenVars, indent + 1).first;
-            seenVars.erase(expr);
-            // Constrain variables >= 0.
-            if (solution.first && *solution.first < 0)
-              solution.first = 0;
-            return solution;
-          })
-          .Case<IdExpr>([&](auto *expr) {
-            return solveExpr(expr->arg, seenVars, indent + 1);
-          })
-          .Case<PowExpr>([&](auto *expr) {
-            auto arg = solveExpr(expr->arg, seenVars, indent + 1);
-            return computeUnary(arg, [](int32_t arg) { return 1 << arg; });
-          })
-          .Case<AddExpr>([&](auto *expr) {
-            auto lhs = solveExpr(expr->lhs(), seenVars, indent + 1);
-            auto rhs = solveExpr(expr->rhs(), seenVars, indent + 1);
-            return computeBinary(
-                lhs, rhs, [](int32_t lhs, int32_t rhs) { return lhs + rhs; });
-          })
-          .Case<MaxExpr>([&](auto *expr) {
-            auto lhs = solveExpr(expr->lhs(), seenVars, indent + 1);
-            auto rhs = solveExpr(expr->rhs(), seenVars, indent + 1);
-            return computeBinary(lhs, rhs, [](int32_t lhs, int32_t rhs) {
-              return std::max(lhs, rhs);
-            });
-          })
-          .Case<MinExpr>([&](auto *expr) {
-            auto lhs = solveExpr(expr->lhs(), seenVars, indent + 1);
-            auto rhs = solveExpr(expr->rhs(), seenVars, indent + 1);
-            return computeBinary(lhs, rhs, [](int32_t lhs, int32_t rhs) {
-              return std::min(lhs, rhs);
-            });
-          })
-          .Default([](auto) {
-            return ExprSolution{std::nullopt, false};
-          });
+  LLVM_DEBUG(llvm::dbgs().indent(indent * 2)
+             << "- Solving " << printable(expr) << "\n");
+  auto recurse = [&](ExprId expr) {
+    return solveExpr(expr, seenVars, indent + 1);
+  };
+  auto lhs = exprs.getLhs(expr), rhs = exprs.getRhs(expr);
+  ExprSolution solution = {std::nullopt, false};
+  switch (kind) {
+  case ExprKind::Known:
+  case ExprKind::Derived:
+    break;
+  case ExprKind::Var:
+    // Unconstrained variables produce no solution.
+    if (!lhs)
+      break;
+    // Return no solution for recursions in the variables. This is sane and
+    // will cause the expression to be ignored when computing the parent, e.g.
+    // `a >= max(a, 1)` will become just `a >= 1`.
+    if (!seenVars.insert(expr).second) {
+      solution.second = true;
+      break;
+    }
+    solution = recurse(lhs);
+    seenVars.erase(expr);
+    // Constrain variables >= 0.
+    if (solution.first && *solution.first < 0)
+      solution.first = 0;
+    break;
+  case ExprKind::Id:
+    solution = recurse(lhs);
+    break;
+  case ExprKind::Pow:
+    solution =
+        computeUnary(recurse(lhs), [](int32_t arg) { return 1 << arg; });
+    break;
+  case ExprKind::Add:
+    solution = computeBinary(
+        recurse(lhs), recurse(rhs),
+        [](int32_t lhs, int32_t rhs) { return lhs + rhs; });
+    break;
+  case ExprKind::Max:
+    solution = computeBinary(
+        recurse(lhs), recurse(rhs),
+        [](int32_t lhs, int32_t rhs) { return std::max(lhs, rhs); });
+    break;
+  case ExprKind::Min:
+    solution = computeBinary(
+        recurse(lhs), recurse(rhs),
+        [](int32_t lhs, int32_t rhs) { return std::min(lhs, rhs); });
+    break;
+  }
 
   // Memoize the result.
   if (solution.first && !solution.second)
-    expr->solution = *solution.first;
+    exprs.setSolution(expr, *solution.first);
 
   // Produce some useful debug prints.
   LLVM_DEBUG({
-    if (!isa<KnownExpr>(expr)) {
-      if (solution.first)
-        llvm::dbgs().indent(indent * 2)
-            << "= Solved " << *expr << " = " << *solution.first;
-      else
-        llvm::dbgs().indent(indent * 2) << "= Skipped " << *expr;
-      llvm::dbgs() << " (" << (solution.second ? "cycle broken" : "unique")
-                   << ")\n";
-    }
+    if (solution.first)
+      llvm::dbgs().indent(indent * 2)
+          << "= Solved " << printable(expr) << " = " << *solution.first;
+    else
+      llvm::dbgs().indent(indent * 2) << "= Skipped " << printable(expr);
+    llvm::dbgs() << " (" << (solution.second ? "cycle broken" : "unique")
+                 << ")\n";
   });
 
   return solution;
 }
 
+/// Partition the variables into groups that share no expressions other than
+/// constants. Solving a variable only ever memoizes expressions in its own
+/// group, such that the groups can be solved independently of each other.
+/// Most modules have no width variables crossing their ports and end up in
+/// groups of their own. The variables in each group are in the order they were
+/// created in.
+ConstraintSolver::VarGroups ConstraintSolver::partitionVars() {
+  // Expressions without any variables evaluate to the same value for every
+  // variable using them. Evaluate them upfront, such that they are only read
+  // while solving and do not tie together the groups of their users. The
+  // operands of an expression are always created before it.
+  auto isConstant = [&](ExprId expr) {
+    return exprs.getSolution(expr) && !isVar(expr) && !isDerived(expr);
+  };
+  SeenVars noVars;
+  for (auto expr : exprs.getIds()) {
+    switch (exprs.getKind(expr)) {
+    case ExprKind::Id:
+    case ExprKind::Pow:
+      if (isConstant(exprs.getLhs(expr)))
+        solveExpr(expr, noVars);
+      break;
+    case ExprKind::Add:
+    case ExprKind::Max:
+    case ExprKind::Min:
+      if (isConstant(exprs.getLhs(expr)) && isConstant(exprs.getRhs(expr)))
+        solveExpr(expr, noVars);
+      break;
+    default:
+      break;
+    }
+  }
+
+  // Join every expression with its non-constant operands. The operands of
+  // variables and derived widths are their constraints and assigned widths.
+  llvm::IntEqClasses classes(exprs.size() + 1);
+  auto join = [&](ExprId expr, ExprId operand) {
+    if (operand && !isConstant(operand))
+      classes.join(expr, operand);
+  };
+  for (auto expr : exprs.getIds()) {
+    if (exprs.getKind(expr) == ExprKind::Known)
+      continue;
+    join(expr, exprs.getLhs(expr));
+    join(expr, exprs.getRhs(expr));
+  }
+  classes.compress();
+
+  // Collect the variables of each group, dropping the groups without any.
+  SmallVector<unsigned> groupIndices(classes.getNumClasses(), -1U);
+  VarGroups groups;
+  for (auto expr : exprs.getIds()) {
+    if (!isVar(expr))
+      continue;
+    auto &groupIndex = groupIndices[classes[expr]];
+    if (groupIndex == -1U) {
+      groupIndex = groups.size();
+      groups.emplace_back();
+    }
+    groups[groupIndex].push_back(expr);
+  }
+  return groups;
+}
+
 /// Solve the constraint problem. This is a very simple implementation that
 /// does not fully solve the problem if there are weird dependency cycles
-/// present.
-LogicalResult ConstraintSolver::solve() {
+/// present. Independent groups of variables are checked and solved in
+/// parallel. Diagnostics are emitted afterwards, in the order in which the
+/// variables were created.
+LogicalResult ConstraintSolver::solve(MLIRContext *context) {
   LLVM_DEBUG({
     llvm::dbgs() << "\n===----- Constraints -----===\n\n";
     dumpConstraints(llvm::dbgs());
   });
 
+  auto groups = partitionVars();
+  numGroups = groups.size();
+  largestGroupSize = 0;
+  for (auto &group : groups)
+    largestGroupSize = std::max(largestGroupSize, group.size());
+  LLVM_DEBUG(llvm::dbgs() << "\nSolving " << numGroups
+                          << " independent groups of variables, the largest "
+                          << "with " << largestGroupSize << " variables\n");
+
+  // Helper to emit diagnostics for the variables collected in parallel, in the
+  // order the variables were created in.
+  VarGroups failedVars(groups.size());
+  auto forEachFailedVar = [&](llvm::function_ref<void(ExprId)> callback) {
+    SmallVector<ExprId> failed;
+    for (auto &vars : failedVars) {
+      failed.append(vars.begin(), vars.end());
+      vars.clear();
+    }
+    llvm::sort(failed);
+    for (auto var : failed)
+      callback(var);
+    return !failed.empty();
+  };
+
   // Ensure that there are no adverse cycles around.
   LLVM_DEBUG(
       llvm::dbgs() << "\n===----- Checking for unbreakable loops -----===\n\n");
-  SmallPtrSet<Expr *, 16> seenVars;
-  bool anyFailed = false;
-
-  for (auto *expr : exprs) {
-    // Only work on variables.
-    auto *var = dyn_cast<VarExpr>(expr);
-    if (!var || !var->constraint)
-      continue;
-    LLVM_DEBUG(llvm::dbgs()
-               << "- Checking " << *var << " >= " << *var->constraint << "\n");
+  mlir::parallelFor(context, 0, groups.size(), [&](size_t groupIdx) {
+    SeenVars seenVars;
+    for (auto var : groups[groupIdx]) {
+      auto constraint = exprs.getLhs(var);
+      if (!constraint)
+        continue;
+      LLVM_DEBUG(llvm::dbgs() << "- Checking " << printable(var) << " >= "
+                              << printable(constraint) << "\n");
+
+      // Canonicalize the variable's constraint expression into a form that
+      // allows us to easily determine if any recursion leads to an
+      // unsatisfiable constraint. The `seenVars` set acts as a recursion
+      // breaker.
+      seenVars.insert(var);
+      auto ineq = checkCycles(var, constraint, seenVars);
+      seenVars.clear();
 
-    // Canonicalize the variable's constraint expression into a form that allows
-    // us to easily determine if any recursion leads to an unsatisfiable
-    // constraint. The `seenVars` set acts as a recursion breaker.
-    seenVars.insert(var);
-    auto ineq = checkCycles(var, var->constraint, seenVars);
-    seenVars.clear();
-
-    // If the constraint is satisfiable, we're done.
-    // TODO: It's possible that this result is already sufficient to arrive at a
-    // solution for the constraint, and the second pass further down is not
-    // necessary. This would require more proper handling of `MinExpr` in the
-    // cycle checking code.
-    if (ineq.sat()) {
+      // If the constraint is satisfiable, we're done.
+      // TODO: It's possible that this result is already sufficient to arrive
+      // at a solution for the constraint, and the second pass further down is
+      // not necessary. This would require more proper handling of `min`
+      // expressions in the cycle checking code.
+      if (ineq.sat()) {
+        LLVM_DEBUG(llvm::dbgs()
+                   << "  = Breakable since " << ineq << " satisfiable\n");
+        continue;
+      }
       LLVM_DEBUG(llvm::dbgs()
-                 << "  = Breakable since " << ineq << " satisfiable\n");
-      continue;
+                 << "  = UNBREAKABLE since " << ineq << " unsatisfiable\n");
+      failedVars[groupIdx].push_back(var);
     }
+  });
 
-    // If we arrive here, the constraint is not satisfiable at all. To provide
-    // some guidance to the user, we call the cycle checking code again, but
-    // this time with an in-flight diagnostic to attach notes indicating
-    // unsatisfiable paths in the cycle.
-    LLVM_DEBUG(llvm::dbgs()
-               << "  = UNBREAKABLE since " << ineq << " unsatisfiable\n");
-    anyFailed = true;
-    for (auto fieldRef : info.find(var)->second) {
+  // If we arrive here with failed variables, the constraint is not satisfiable
+  // at all. To provide some guidance to the user, we call the cycle checking
+  // code again, but this time with an in-flight diagnostic to attach notes
+  // indicating unsatisfiable paths in the cycle.
+  bool anyFailed = forEachFailedVar([&](ExprId var) {
+    SeenVars seenVars;
+    for (auto fieldRef : getInfo(var)) {
       // Depending on whether this value stems from an operation or not, create
       // an appropriate diagnostic identifying the value.
       auto op = fieldRef.getDefiningOp();
@@ -972,10 +1014,10 @@ LogicalResult ConstraintSolver::solve() {
 
       // Re-run the cycle checking, but this time reporting into the diagnostic.
       seenVars.insert(var);
-      checkCycles(var, var->constraint, seenVars, &diag);
+      checkCycles(var, exprs.getLhs(var), seenVars, &diag);
       seenVars.clear();
     }
-  }
+  });
 
   // If there were cycles, return now to avoid complaining to the user about
   // dependent widths not being inferred.
@@ -984,80 +1026,87 @@ LogicalResult ConstraintSolver::solve() {
 
   // Iterate over the constraint variables and solve each.
   LLVM_DEBUG(llvm::dbgs() << "\n===----- Solving constraints -----===\n\n");
-  for (auto *expr : exprs) {
-    // Only work on variables.
-    auto *var = dyn_cast<VarExpr>(expr);
-    if (!var)
-      continue;
-
-    // Complain about unconstrained variables.
-    if (!var->constraint) {
-      LLVM_DEBUG(llvm::dbgs() << "- Unconstrained " << *var << "\n");
-      emitUninferredWidthError(var);
-      anyFailed = true;
-      continue;
-    }
-
-    // Compute the value for the variable.
-    LLVM_DEBUG(llvm::dbgs()
-               << "- Solving " << *var << " >= " << *var->constraint << "\n");
-    seenVars.insert(var);
-    auto solution = solveExpr(var->constraint, seenVars);
-    if (var->upperBound)
-      var->upperBoundSolution = solveExpr(var->upperBound, seenVars).first;
-    seenVars.clear();
-
-    // Constrain variables >= 0.
-    if (solution.first && *solution.first < 0)
-      solution.first = 0;
-    var->solution = solution.first;
-
-    // In case the width could not be inferred, complain to the user. This might
-    // be the case if the width depends on an unconstrained variable.
-    if (!solution.first) {
-      LLVM_DEBUG(llvm::dbgs() << "  - UNSOLVED " << *var << "\n");
-      emitUninferredWidthError(var);
-      anyFailed = true;
-      continue;
-    }
-    LLVM_DEBUG(llvm::dbgs()
-               << "  = Solved " << *var << " = " << solution.first << " ("
-               << (solution.second ? "cycle broken" : "unique") << ")\n");
-
-    // Check if the solution we have found violates an upper bound.
-    if (var->upperBoundSolution && var->upperBoundSolution < *solution.first) {
-      LLVM_DEBUG(llvm::dbgs() << "  ! Unsatisfiable " << *var
-                              << " <= " << var->upperBoundSolution << "\n");
-      emitUninferredWidthError(var);
-      anyFailed = true;
-    }
-  }
+  mlir::parallelFor(context, 0, groups.size(), [&](size_t groupIdx) {
+    SeenVars seenVars;
+    for (auto var : groups[groupIdx])
+      if (!solveVar(var, seenVars))
+        failedVars[groupIdx].push_back(var);
+  });
+  anyFailed =
+      forEachFailedVar([&](ExprId var) { emitUninferredWidthError(var); });
 
   // Copy over derived widths.
-  for (auto *expr : exprs) {
+  for (auto derived : exprs.getIds()) {
     // Only work on derived values.
-    auto *derived = dyn_cast<DerivedExpr>(expr);
-    if (!derived)
+    if (!isDerived(derived))
       continue;
 
-    auto *assigned = derived->assigned;
-    if (!assigned || !assigned->solution) {
-      LLVM_DEBUG(llvm::dbgs() << "- Unused " << *derived << " set to 0\n");
-      derived->solution = 0;
+    auto assigned = exprs.getLhs(derived);
+    auto solution = assigned ? exprs.getSolution(assigned) : std::nullopt;
+    if (!solution) {
+      LLVM_DEBUG(llvm::dbgs()
+                 << "- Unused " << printable(derived) << " set to 0\n");
+      exprs.setSolution(derived, 0);
     } else {
-      LLVM_DEBUG(llvm::dbgs() << "- Deriving " << *derived << " = "
-                              << assigned->solution << "\n");
-      derived->solution = *assigned->solution;
+      LLVM_DEBUG(llvm::dbgs() << "- Deriving " << printable(derived) << " = "
+                              << *solution << "\n");
+      exprs.setSolution(derived, *solution);
     }
   }
 
   return failure(anyFailed);
 }
 
+/// Compute the value of a single variable. Returns false if the width could
+/// not be inferred, in which case an error should be reported for the
+/// variable.
+bool ConstraintSolver::solveVar(ExprId var, SeenVars &seenVars) {
+  // Complain about unconstrained variables.
+  auto constraint = exprs.getLhs(var), upperBound = exprs.getRhs(var);
+  if (!constraint) {
+    LLVM_DEBUG(llvm::dbgs() << "- Unconstrained " << printable(var) << "\n");
+    return false;
+  }
+
+  // Compute the value for the variable.
+  LLVM_DEBUG(llvm::dbgs() << "- Solving " << printable(var) << " >= "
+                          << printable(constraint) << "\n");
+  seenVars.insert(var);
+  auto solution = solveExpr(constraint, seenVars);
+  std::optional<int32_t> upperBoundSolution;
+  if (upperBound)
+    upperBoundSolution = solveExpr(upperBound, seenVars).first;
+  seenVars.clear();
+
+  // Constrain variables >= 0.
+  if (solution.first && *solution.first < 0)
+    solution.first = 0;
+  exprs.setSolution(var, solution.first);
+
+  // In case the width could not be inferred, complain to the user. This might
+  // be the case if the width depends on an unconstrained variable.
+  if (!solution.first) {
+    LLVM_DEBUG(llvm::dbgs() << "  - UNSOLVED " << printable(var) << "\n");
+    return false;
+  }
+  LLVM_DEBUG(llvm::dbgs() << "  = Solved " << printable(var) << " = "
+                          << solution.first << " ("
+                          << (solution.second ? "cycle broken" : "unique")
+                          << ")\n");
+
+  // Check if the solution we have found violates an upper bound.
+  if (upperBoundSolution && upperBoundSolution < *solution.first) {
+    LLVM_DEBUG(llvm::dbgs() << "  ! Unsatisfiable " << printable(var)
+                            << " <= " << upperBoundSolution << "\n");
+    return false;
+  }
+  return true;
+}
+
 // Emits the diagnostic to inform the user about an uninferred width in the
 // design. Returns true if an error was reported, false otherwise.
-void ConstraintSolver::emitUninferredWidthError(VarExpr *var) {
-  FieldRef fieldRef = info.find(var)->second.back();
+void ConstraintSolver::emitUninferredWidthError(ExprId var) {
+  FieldRef fieldRef = getInfo(var).back();
   Value value = fieldRef.getValue();
 
   auto diag = mlir::emitError(value.getLoc(), "uninferred width:");
@@ -1083,23 +1132,33 @@ void ConstraintSolver::emitUninferredWidthError(VarExpr *var) {
     diag << " \"" << fieldName << "\"";
   }
 
-  if (!var->constraint) {
+  // The solution of the upper bound is not memoized if it depends on a cycle,
+  // so recompute it here.
+  auto constraint = exprs.getLhs(var), upperBound = exprs.getRhs(var);
+  auto solution = exprs.getSolution(var);
+  std::optional<int32_t> upperBoundSolution;
+  if (solution && upperBound) {
+    SeenVars seenVars;
+    seenVars.insert(var);
+    upperBoundSolution = solveExpr(upperBound, seenVars).first;
+  }
+
+  if (!constraint) {
     diag << " is unconstrained";
-  } else if (var->solution && var->upperBoundSolution &&
-             var->solution > var->upperBoundSolution) {
+  } else if (solution && upperBoundSolution && solution > upperBoundSolution) {
     diag << " cannot satisfy all width requirements";
-    LLVM_DEBUG(llvm::dbgs() << *var->constraint << "\n");
-    LLVM_DEBUG(llvm::dbgs() << *var->upperBound << "\n");
-    auto loc = locs.find(var->constraint)->second.back();
-    diag.attachNote(loc) << "width is constrained to be at least "
-                         << *var->solution << " here:";
-    loc = locs.find(var->upperBound)->second.back();
+    LLVM_DEBUG(llvm::dbgs() << printable(constraint) << "\n");
+    LLVM_DEBUG(llvm::dbgs() << printable(upperBound) << "\n");
+    auto loc = getLocs(constraint).back();
+    diag.attachNote(loc) << "width is constrained to be at least " << *solution
+                         << " here:";
+    loc = getLocs(upperBound).back();
     diag.attachNote(loc) << "width is constrained to be at most "
-                         << *var->upperBoundSolution << " here:";
+                         << *upperBoundSolution << " here:";
   } else {
     diag << " width cannot be determined";
-    LLVM_DEBUG(llvm::dbgs() << *var->constraint << "\n");
-    auto loc = locs.find(var->constraint)->second.back();
+    LLVM_DEBUG(llvm::dbgs() << printable(constraint) << "\n");
+    auto loc = getLocs(constraint).back();
     diag.attachNote(loc) << "width is constrained by an uninferred width here:";
   }
 }
@@ -1126,11 +1185,11 @@ public:
   void declareVars(Value value, Location loc, bool isDerived = false);
 
   /// Declare a variable associated with a specific field of an aggregate.
-  Expr *declareVar(FieldRef fieldRef, Location loc);
+  ExprId declareVar(FieldRef fieldRef, Location loc);
 
   /// Declarate a variable for a type with an unknown width.  The type must be a
   /// non-aggregate.
-  Expr *declareVar(FIRRTLType type, Location loc);
+  ExprId declareVar(FIRRTLType type, Location loc);
 
   /// Assign the constraint expressions of the fields in the `result` argument
   /// as the max of expressions in the `rhs` and `lhs` arguments. Both fields
@@ -1143,7 +1202,7 @@ public:
 
   /// Constrain the expression "larger" to be greater than or equals to
   /// the expression "smaller".
-  void constrainTypes(Expr *larger, Expr *smaller,
+  void constrainTypes(ExprId larger, ExprId smaller,
                       bool imposeUpperBounds = false);
 
   /// Assign the constraint expressions of the fields in the `src` argument as
@@ -1153,21 +1212,24 @@ public:
 
   /// Get the expr associated with the value.  The value must be a non-aggregate
   /// type.
-  Expr *getExpr(Value value);
+  ExprId getExpr(Value value);
 
   /// Get the expr associated with a specific field in a value.
-  Expr *getExpr(FieldRef fieldRef);
+  ExprId getExpr(FieldRef fieldRef);
 
   /// Get the expr associated with a specific field in a value. If value is
-  /// NULL, then this returns NULL.
-  Expr *getExprOrNull(FieldRef fieldRef);
+  /// NULL, then this returns `noExpr`.
+  ExprId getExprOrNull(FieldRef fieldRef);
+
+  /// Get the inferred width of a specific field in a value, if there is one.
+  std::optional<int32_t> getSolution(FieldRef fieldRef);
 
   /// Set the expr associated with the value. The value must be a non-aggregate
   /// type.
-  void setExpr(Value value, Expr *expr);
+  void setExpr(Value value, ExprId expr);
 
   /// Set the expr associated with a specific field in a value.
-  void setExpr(FieldRef fieldRef, Expr *expr);
+  void setExpr(FieldRef fieldRef, ExprId expr);
 
   /// Return whether a module was skipped due to being fully inferred already.
   bool isModuleSkipped(ModuleOp module) { return skippedModules.count(module); }
@@ -1180,7 +1242,7 @@ private:
   ConstraintSolver &solver;
 
   /// The constraint exprs for each result type of an operation.
-  DenseMap<FieldRef, Expr *> opExprs;
+  DenseMap<FieldRef, ExprId> opExprs;
 
   /// The fully inferred modules that were skipped entirely.
   SmallPtrSet<Operation *, 16> skippedModules;
@@ -1253,9 +1315,9 @@ LogicalResult InferenceMapping::map(CircuitOp op) {
 LogicalResult InferenceMapping::mapOperation(Operation *op) {
   // In case the operation result has a type without uninferred widths, don't
   // even bother to populate the constraint problem and treat that as a known
-  // size directly. This is done in `declareVars`, which will generate
-  // `KnownExpr` nodes for all known widths -- which are the only ones in this
-  // case.
+  // size directly. This is done in `declareVars`, which will generate known
+  // constant expressions for all known widths -- which are the only ones in
+  // this case.
   bool allWidthsKnown = true;
   for (auto result : op->getResults()) {
     if (auto mux = dyn_cast<MuxPrimOp>(op))
@@ -1283,7 +1345,7 @@ LogicalResult InferenceMapping::mapOperation(Operation *op) {
       .Case<ConstantOp>([&](auto op) {
         // If the constant has a known width, use that. Otherwise pick the
         // smallest number of bits necessary to represent the constant.
-        Expr *e;
+        ExprId e;
         if (auto width = op.getType().getWidth())
           e = solver.known(*width);
         else {
@@ -1385,7 +1447,7 @@ LogicalResult InferenceMapping::mapOperation(Operation *op) {
       })
       .Case<DivPrimOp>([&](auto op) {
         auto lhs = getExpr(op.getLhs());
-        Expr *e;
+        ExprId e;
         if (op.getType().isSigned()) {
           e = solver.add(lhs, solver.known(1));
         } else {
@@ -1719,7 +1781,7 @@ void InferenceMapping::maximumOfTypes(Value result, Value rhs, Value lhs) {
       for (auto &element : enumType.getElements())
         maximize(element.type);
     } else if (type.isGround()) {
-      auto *e = solver.max(getExpr(FieldRef(rhs, fieldID)),
+      auto e = solver.max(getExpr(FieldRef(rhs, fieldID)),
                            getExpr(FieldRef(lhs, fieldID)));
       setExpr(FieldRef(result, fieldID), e);
       fieldID++;
@@ -1782,34 +1844,34 @@ void InferenceMapping::constrainTypes(Value larger, Value smaller) {
 
 /// Establishes constraints to ensure the sizes in the `larger` type are greater
 /// than or equal to the sizes in the `smaller` type.
-void InferenceMapping::constrainTypes(Expr *larger, Expr *smaller,
+void InferenceMapping::constrainTypes(ExprId larger, ExprId smaller,
                                       bool imposeUpperBounds) {
   assert(larger && "Larger expression should be specified");
   assert(smaller && "Smaller expression should be specified");
 
-  // If one of the sides is `DerivedExpr`, simply assign the other side as the
+  // If one of the sides is a derived width, simply assign the other side as the
   // derived width. This allows `InvalidValueOp`s to properly infer their width
   // from the connects they are used in, but also be inferred to something
   // useful on their own.
-  if (auto *largerDerived = dyn_cast<DerivedExpr>(larger)) {
-    largerDerived->assigned = smaller;
-    LLVM_DEBUG(llvm::dbgs() << "Deriving " << *largerDerived << " from "
-                            << *smaller << "\n");
+  if (solver.isDerived(larger)) {
+    solver.derive(larger, smaller);
+    LLVM_DEBUG(llvm::dbgs() << "Deriving " << solver.printable(larger)
+                            << " from " << solver.printable(smaller) << "\n");
     return;
   }
-  if (auto *smallerDerived = dyn_cast<DerivedExpr>(smaller)) {
-    smallerDerived->assigned = larger;
-    LLVM_DEBUG(llvm::dbgs() << "Deriving " << *smallerDerived << " from "
-                            << *larger << "\n");
+  if (solver.isDerived(smaller)) {
+    solver.derive(smaller, larger);
+    LLVM_DEBUG(llvm::dbgs() << "Deriving " << solver.printable(smaller)
+                            << " from " << solver.printable(larger) << "\n");
     return;
   }
 
   // If the larger expr is a free variable, create a `expr >= x` constraint for
   // it that we can try to satisfy with the smallest width.
-  if (auto largerVar = dyn_cast<VarExpr>(larger)) {
-    LLVM_ATTRIBUTE_UNUSED auto *c = solver.addGeqConstraint(largerVar, smaller);
-    LLVM_DEBUG(llvm::dbgs()
-               << "Constrained " << *largerVar << " >= " << *c << "\n");
+  if (solver.isVar(larger)) {
+    LLVM_ATTRIBUTE_UNUSED auto c = solver.addGeqConstraint(larger, smaller);
+    LLVM_DEBUG(llvm::dbgs() << "Constrained " << solver.printable(larger)
+                            << " >= " << solver.printable(c) << "\n");
     return;
   }
 
@@ -1818,12 +1880,11 @@ void InferenceMapping::constrainTypes(Expr *larger, Expr *smaller,
   // satisfied. Since we are always picking the smallest width to satisfy all
   // `>=` constraints, any `<=` constraints have no effect on the solution
   // besides indicating that a width is unsatisfiable.
-  if (auto *smallerVar = dyn_cast<VarExpr>(smaller)) {
+  if (solver.isVar(smaller)) {
     if (imposeUpperBounds) {
-      LLVM_ATTRIBUTE_UNUSED auto *c =
-          solver.addLeqConstraint(smallerVar, larger);
-      LLVM_DEBUG(llvm::dbgs()
-                 << "Constrained " << *smallerVar << " <= " << *c << "\n");
+      LLVM_ATTRIBUTE_UNUSED auto c = solver.addLeqConstraint(smaller, larger);
+      LLVM_DEBUG(llvm::dbgs() << "Constrained " << solver.printable(smaller)
+                              << " <= " << solver.printable(c) << "\n");
     }
   }
 }
@@ -1847,7 +1908,7 @@ void InferenceMapping::unifyTypes(FieldRef lhs, FieldRef rhs, FIRRTLType type) {
                  << "Unify " << getFieldName(lhsFieldRef).first << " = "
                  << getFieldName(rhsFieldRef).first << "\n");
       // Abandon variables becoming unconstrainable by the unification.
-      if (auto *var = dyn_cast_or_null<VarExpr>(getExprOrNull(lhsFieldRef)))
+      if (auto var = getExprOrNull(lhsFieldRef); var && solver.isVar(var))
         solver.addGeqConstraint(var, solver.known(0));
       setExpr(lhsFieldRef, getExpr(rhsFieldRef));
       fieldID++;
@@ -1876,35 +1937,40 @@ void InferenceMapping::unifyTypes(FieldRef lhs, FieldRef rhs, FIRRTLType type) {
 }
 
 /// Get the constraint expression for a value.
-Expr *InferenceMapping::getExpr(Value value) {
+ExprId InferenceMapping::getExpr(Value value) {
   assert(getBaseType(value.getType().cast<FIRRTLType>()).isGround());
   // A field ID of 0 indicates the entire value.
   return getExpr(FieldRef(value, 0));
 }
 
 /// Get the constraint expression for a value.
-Expr *InferenceMapping::getExpr(FieldRef fieldRef) {
+ExprId InferenceMapping::getExpr(FieldRef fieldRef) {
   auto expr = getExprOrNull(fieldRef);
   assert(expr && "constraint expr should have been constructed for value");
   return expr;
 }
 
-Expr *InferenceMapping::getExprOrNull(FieldRef fieldRef) {
-  auto it = opExprs.find(fieldRef);
-  return it != opExprs.end() ? it->second : nullptr;
+ExprId InferenceMapping::getExprOrNull(FieldRef fieldRef) {
+  return opExprs.lookup(fieldRef);
+}
+
+std::optional<int32_t> InferenceMapping::getSolution(FieldRef fieldRef) {
+  auto expr = getExprOrNull(fieldRef);
+  return expr ? solver.getSolution(expr) : std::nullopt;
 }
 
 /// Associate a constraint expression with a value.
-void InferenceMapping::setExpr(Value value, Expr *expr) {
+void InferenceMapping::setExpr(Value value, ExprId expr) {
   assert(getBaseType(value.getType().cast<FIRRTLType>()).isGround());
   // A field ID of 0 indicates the entire value.
   setExpr(FieldRef(value, 0), expr);
 }
 
 /// Associate a constraint expression with a value.
-void InferenceMapping::setExpr(FieldRef fieldRef, Expr *expr) {
+void InferenceMapping::setExpr(FieldRef fieldRef, ExprId expr) {
   LLVM_DEBUG({
-    llvm::dbgs() << "Expr " << *expr << " for " << fieldRef.getValue();
+    llvm::dbgs() << "Expr " << solver.printable(expr) << " for "
+                 << fieldRef.getValue();
     if (fieldRef.getFieldID())
       llvm::dbgs() << " '" << getFieldName(fieldRef).first << "'";
     llvm::dbgs() << "\n";
@@ -2169,8 +2235,8 @@ FIRRTLBaseType InferenceTypeUpdate::updateType(FieldRef fieldRef,
   assert(type.isGround() && "Can only pass in ground types.");
   auto value = fieldRef.getValue();
   // Get the inferred width.
-  Expr *expr = mapping.getExprOrNull(fieldRef);
-  if (!expr || !expr->solution) {
+  auto solution = mapping.getSolution(fieldRef);
+  if (!solution) {
     // It should not be possible to arrive at an uninferred width at this point.
     // In case the constraints are not resolvable, checks before the calls to
     // `updateType` must have already caught the issues and aborted the pass
@@ -2179,41 +2245,10 @@ FIRRTLBaseType InferenceTypeUpdate::updateType(FieldRef fieldRef,
     mlir::emitError(value.getLoc(), "width should have been inferred");
     return type;
   }
-  int32_t solution = *expr->solution;
-  assert(solution >= 0); // The solver infers variables to be 0 or greater.
-  return resizeType(type, solution);
+  assert(*solution >= 0); // The solver infers variables to be 0 or greater.
+  return resizeType(type, *solution);
 }
 
-//===----------------------------------------------------------------------===//
-// Hashing
-//===----------------------------------------------------------------------===//
-
-// Hash slots in the interned allocator as if they were the pointed-to value
-// itself.
-namespace llvm {
-template <typename T>
-struct DenseMapInfo<InternedSlot<T>> {
-  using Slot = InternedSlot<T>;
-  static Slot getEmptyKey() {
-    auto pointer = llvm::DenseMapInfo<void *>::getEmptyKey();
-    return Slot(static_cast<T *>(pointer));
-  }
-  static Slot getTombstoneKey() {
-    auto pointer = llvm::DenseMapInfo<void *>::getTombstoneKey();
-    return Slot(static_cast<T *>(pointer));
-  }
-  static unsigned getHashValue(Slot val) { return mlir::hash_value(*val.ptr); }
-  static bool isEqual(Slot LHS, Slot RHS) {
-    auto empty = getEmptyKey().ptr;
-    auto tombstone = getTombstoneKey().ptr;
-    if (LHS.ptr == empty || RHS.ptr == empty || LHS.ptr == tombstone ||
-        RHS.ptr == tombstone)
-      return LHS.ptr == RHS.ptr;
-    return *LHS.ptr == *RHS.ptr;
-  }
-};
-} // namespace llvm
-
 //===----------------------------------------------------------------------===//
 // Pass Infrastructure
 //===----------------------------------------------------------------------===//
@@ -2222,6 +2257,22 @@ namespace {
 class InferWidthsPass : public InferWidthsBase<InferWidthsPass> {
   void runOnOperation() override;
 };
+
+/// Adds the time spent in its scope to a statistic, in microseconds.
+class ScopedTimer {
+public:
+  explicit ScopedTimer(mlir::Pass::Statistic &statistic)
+      : statistic(statistic), start(std::chrono::steady_clock::now()) {}
+  ~ScopedTimer() {
+    statistic += std::chrono::duration_cast<std::chrono::microseconds>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+  }
+
+private:
+  mlir::Pass::Statistic &statistic;
+  std::chrono::steady_clock::time_point start;
+};
 } // namespace
 
 void InferWidthsPass::runOnOperation() {
@@ -2229,9 +2280,12 @@ void InferWidthsPass::runOnOperation() {
   ConstraintSolver solver;
   SymbolTable symtbl(getOperation());
   InferenceMapping mapping(solver, symtbl);
-  if (failed(mapping.map(getOperation()))) {
-    signalPassFailure();
-    return;
+  {
+    ScopedTimer timer(mappingTime);
+    if (failed(mapping.map(getOperation()))) {
+      signalPassFailure();
+      return;
+    }
   }
   if (mapping.areAllModulesSkipped()) {
     markAllAnalysesPreserved();
@@ -2239,12 +2293,21 @@ void InferWidthsPass::runOnOperation() {
   }
 
   // Solve the constraints.
-  if (failed(solver.solve())) {
-    signalPassFailure();
-    return;
+  {
+    ScopedTimer timer(solvingTime);
+    auto result = solver.solve(&getContext());
+    numGroups += solver.getNumGroups();
+    largestGroupSize += solver.getLargestGroupSize();
+    numExprs += solver.getNumExprs();
+    exprMemory += solver.getMemorySize();
+    if (failed(result)) {
+      signalPassFailure();
+      return;
+    }
   }
 
   // Update the types with the inferred widths.
+  ScopedTimer timer(updatingTime);
   if (failed(InferenceTypeUpdate(mapping).update(getOperation())))
     signalPassFailure();
 }
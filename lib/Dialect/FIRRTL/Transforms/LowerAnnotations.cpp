@@ -1082,6 +1082,9 @@ void LowerAnnotationsPass::runOnOperation() {
   };
   InstancePathCache instancePathCache(getAnalysis<InstanceGraph>());
   ApplyState state{circuit, modules, addToWorklist, instancePathCache};
+  // Most annotations target something inside a module. Index the named things
+  // of all modules once, in parallel, instead of on first use.
+  state.targetCaches.populate(circuit);
   LLVM_DEBUG(llvm::dbgs() << "Processing annotations:\n");
   while (!worklistAttrs.empty()) {
     auto attr = worklistAttrs.pop_back_val();
@@ -1100,6 +1103,8 @@ void LowerAnnotationsPass::runOnOperation() {
   numAddedAnnos += numAdded;
   numAnnos += numAdded + annotations.size();
   numReusedHierPathOps += state.numReusedHierPaths;
+  numTargetLookups += state.targetCaches.numLookups;
+  numTargetCacheHits += state.targetCaches.numHits;
 
   if (numFailures)
     signalPassFailure();
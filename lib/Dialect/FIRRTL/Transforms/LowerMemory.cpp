@@ -18,11 +18,11 @@
 #include "circt/Dialect/FIRRTL/Passes.h"
 #include "circt/Dialect/Seq/SeqAttributes.h"
 #include "mlir/IR/Dominance.h"
+#include "mlir/IR/Threading.h"
 #include "llvm/ADT/DepthFirstIterator.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/STLFunctionalExtras.h"
 #include "llvm/ADT/SmallPtrSet.h"
-#include "llvm/Support/Parallel.h"
 #include <optional>
 #include <set>
 
@@ -91,6 +91,23 @@ FirMemory getSummary(MemOp op) {
 }
 
 namespace {
+/// A seq mem to be lowered, along with the modules created for it.
+struct MemoryToLower {
+  MemOp op;
+  FirMemory summary;
+  /// The wrapper module replacing the memory, and the memory module it
+  /// instantiates. The memory module may be shared with other memories.
+  FModuleOp wrapper = {};
+  FMemModuleOp memModule = {};
+  /// The instance of the memory module in the wrapper, and the instance of
+  /// the wrapper replacing the memory.
+  InstanceOp memInst = {};
+  InstanceOp inst = {};
+  /// The names of the clones of the non-local annotation paths through the
+  /// memory, which get the wrapper module appended.
+  llvm::SmallDenseMap<StringAttr, StringAttr> nlaNames = {};
+};
+
 struct LowerMemoryPass : public LowerMemoryBase<LowerMemoryPass> {
 
   /// Get the cached namespace for a module.
@@ -104,12 +121,13 @@ struct LowerMemoryPass : public LowerMemoryBase<LowerMemoryPass> {
   FMemModuleOp getOrCreateMemModule(MemOp op, const FirMemory &summary,
                                     const SmallVectorImpl<PortInfo> &ports,
                                     bool shouldDedup);
-  FModuleOp createWrapperModule(MemOp op, const FirMemory &summary,
-                                bool shouldDedup);
   InstanceOp emitMemoryInstance(MemOp op, FModuleOp module,
                                 const FirMemory &summary);
-  void lowerMemory(MemOp mem, const FirMemory &summary, bool shouldDedup);
-  LogicalResult runOnModule(FModuleOp module, bool shouldDedup);
+  LogicalResult collectMemories(FModuleOp module,
+                                SmallVectorImpl<MemoryToLower> &mems);
+  void createModules(MemoryToLower &mem, bool shouldDedup);
+  void lowerMemory(MemoryToLower &mem);
+  void updateNonLocalAnnotations(MemoryToLower &mem);
   void runOnOperation() override;
 
   /// Cached module namespaces.
@@ -202,8 +220,10 @@ LowerMemoryPass::getOrCreateMemModule(MemOp op, const FirMemory &summary,
   // shouldDedup is true, we will just generate a new memory module.
   if (shouldDedup) {
     auto it = memories.find(summary);
-    if (it != memories.end())
+    if (it != memories.end()) {
+      ++numDedupedMems;
       return it->second;
+    }
   }
 
   // Create a new module for this memory. This can update the name recorded in
@@ -218,53 +238,89 @@ LowerMemoryPass::getOrCreateMemModule(MemOp op, const FirMemory &summary,
   return module;
 }
 
-void LowerMemoryPass::lowerMemory(MemOp mem, const FirMemory &summary,
-                                  bool shouldDedup) {
+/// Create the wrapper module of a memory and find or create the memory module
+/// it instantiates. This allocates names in the circuit namespace, so it runs
+/// in circuit order to keep the names deterministic.
+void LowerMemoryPass::createModules(MemoryToLower &mem, bool shouldDedup) {
   auto *context = &getContext();
-  auto ports = getMemoryModulePorts(summary);
+  auto ports = getMemoryModulePorts(mem.summary);
 
   // Get a non-colliding name for the memory module, and update the summary.
-  auto newName = circuitNamespace.newName(mem.getName());
+  auto newName = circuitNamespace.newName(mem.op.getName());
   auto wrapperName = StringAttr::get(&getContext(), newName);
 
   // Create the wrapper module, inserting it into the bottom of the circuit.
   auto b = OpBuilder::atBlockEnd(getOperation().getBodyBlock());
-  auto wrapper = b.create<FModuleOp>(
-      mem->getLoc(), wrapperName,
+  mem.wrapper = b.create<FModuleOp>(
+      mem.op->getLoc(), wrapperName,
       ConventionAttr::get(context, Convention::Internal), ports);
-  SymbolTable::setSymbolVisibility(wrapper, SymbolTable::Visibility::Private);
+  SymbolTable::setSymbolVisibility(mem.wrapper,
+                                   SymbolTable::Visibility::Private);
+
+  mem.memModule = getOrCreateMemModule(mem.op, mem.summary, ports, shouldDedup);
+
+  // Name the clones of the non-local annotation paths along with the wrapper,
+  // so that the names do not depend on the other memories.
+  auto nonlocalAttr = StringAttr::get(context, "circt.nonlocal");
+  for (auto anno : AnnotationSet(mem.op)) {
+    auto nlaSym = anno.getMember<FlatSymbolRefAttr>(nonlocalAttr);
+    if (!nlaSym || mem.nlaNames.count(nlaSym.getAttr()))
+      continue;
+    mem.nlaNames[nlaSym.getAttr()] = StringAttr::get(
+        context, circuitNamespace.newName(nlaSym.getValue()));
+  }
+}
+
+/// Fill in the wrapper module of a memory and replace the memory with an
+/// instance of it. This only modifies the wrapper and the module containing
+/// the memory, such that the memories of different modules can be lowered in
+/// parallel.
+void LowerMemoryPass::lowerMemory(MemoryToLower &mem) {
+  auto wrapper = mem.wrapper;
+  auto memModule = mem.memModule;
 
   // Create an instance of the external memory module. The instance has the
   // same name as the target module.
-  auto memModule = getOrCreateMemModule(mem, summary, ports, shouldDedup);
-  b.setInsertionPointToStart(wrapper.getBodyBlock());
-
-  auto memInst =
-      b.create<InstanceOp>(mem->getLoc(), memModule, memModule.getModuleName(),
-                           mem.getNameKind(), mem.getAnnotations().getValue());
+  auto b = OpBuilder::atBlockBegin(wrapper.getBodyBlock());
+  auto memInst = b.create<InstanceOp>(
+      mem.op->getLoc(), memModule, memModule.getModuleName(),
+      mem.op.getNameKind(), mem.op.getAnnotations().getValue());
 
   // Wire all the ports together.
   for (auto [dst, src] : llvm::zip(wrapper.getBodyBlock()->getArguments(),
                                    memInst.getResults())) {
     if (wrapper.getPortDirection(dst.getArgNumber()) == Direction::Out)
-      b.create<StrictConnectOp>(mem->getLoc(), dst, src);
+      b.create<StrictConnectOp>(mem.op->getLoc(), dst, src);
     else
-      b.create<StrictConnectOp>(mem->getLoc(), src, dst);
+      b.create<StrictConnectOp>(mem.op->getLoc(), src, dst);
   }
 
   // Create an instance of the wrapper memory module, which will replace the
   // original mem op.
-  auto inst = emitMemoryInstance(mem, wrapper, summary);
+  mem.memInst = memInst;
+  mem.inst = emitMemoryInstance(mem.op, wrapper, mem.summary);
+  mem.op->erase();
+  ++numLoweredMems;
+}
+
+/// Move the non-local annotations of a lowered memory onto the instance of the
+/// memory module. This creates new hierarchical paths in the circuit, so it
+/// runs serially after all memories are lowered. The paths are named when the
+/// wrapper is created.
+void LowerMemoryPass::updateNonLocalAnnotations(MemoryToLower &mem) {
+  auto *context = &getContext();
+  auto memInst = mem.memInst;
+  auto inst = mem.inst;
 
   // We fixup the annotations here. We will be copying all annotations on to the
   // module op, so we have to fix up the NLA to have the module as the leaf
   // element.
 
-  auto leafSym = memModule.getModuleNameAttr();
-  auto leafAttr = FlatSymbolRefAttr::get(wrapper.getModuleNameAttr());
+  auto leafSym = mem.memModule.getModuleNameAttr();
+  auto leafAttr = FlatSymbolRefAttr::get(mem.wrapper.getModuleNameAttr());
 
   // NLAs that we have already processed.
-  llvm::SmallDenseMap<StringAttr, StringAttr> processedNLAs;
+  DenseSet<StringAttr> processedNLAs;
   auto nonlocalAttr = StringAttr::get(context, "circt.nonlocal");
   bool nlaUpdated = false;
   SmallVector<Annotation> newMemModAnnos;
@@ -276,9 +332,8 @@ void LowerMemoryPass::lowerMemory(MemOp mem, const FirMemory &summary,
     if (!nlaSym)
       return false;
     // If we have already seen this NLA, don't re-process it.
-    auto newNLAIter = processedNLAs.find(nlaSym.getAttr());
-    StringAttr newNLAName;
-    if (newNLAIter == processedNLAs.end()) {
+    auto newNLAName = mem.nlaNames.lookup(nlaSym.getAttr());
+    if (processedNLAs.insert(nlaSym.getAttr()).second) {
 
       // Update the NLA path to have the additional wrapper module.
       auto nla =
@@ -294,13 +349,9 @@ void LowerMemoryPass::lowerMemory(MemOp mem, const FirMemory &summary,
 
       nlaBuilder.setInsertionPointAfter(nla);
       auto newNLA = cast<hw::HierPathOp>(nlaBuilder.clone(*nla));
-      newNLA.setSymNameAttr(StringAttr::get(
-          context, circuitNamespace.newName(nla.getNameAttr().getValue())));
+      newNLA.setSymNameAttr(newNLAName);
       newNLA.setNamepathAttr(ArrayAttr::get(context, newNamepath));
-      newNLAName = newNLA.getNameAttr();
-      processedNLAs[nlaSym.getAttr()] = newNLAName;
-    } else
-      newNLAName = newNLAIter->getSecond();
+    }
     anno.setMember("circt.nonlocal", FlatSymbolRefAttr::get(newNLAName));
     nlaUpdated = true;
     newMemModAnnos.push_back(anno);
@@ -312,8 +363,6 @@ void LowerMemoryPass::lowerMemory(MemOp mem, const FirMemory &summary,
     newAnnos.addAnnotations(newMemModAnnos);
     newAnnos.applyToOperation(memInst);
   }
-  mem->erase();
-  ++numLoweredMems;
 }
 
 static SmallVector<SubfieldOp> getAllFieldAccesses(Value structValue,
@@ -486,9 +535,11 @@ InstanceOp LowerMemoryPass::emitMemoryInstance(MemOp op, FModuleOp module,
   return inst;
 }
 
-LogicalResult LowerMemoryPass::runOnModule(FModuleOp module, bool shouldDedup) {
-  for (auto op :
-       llvm::make_early_inc_range(module.getBodyBlock()->getOps<MemOp>())) {
+/// Collect the seq mems of a module along with their summaries.
+LogicalResult
+LowerMemoryPass::collectMemories(FModuleOp module,
+                                 SmallVectorImpl<MemoryToLower> &mems) {
+  for (auto op : module.getBodyBlock()->getOps<MemOp>()) {
     // Check that the memory has been properly lowered already.
     if (!op.getDataType().isa<UIntType>())
       return op->emitError(
@@ -498,7 +549,7 @@ LogicalResult LowerMemoryPass::runOnModule(FModuleOp module, bool shouldDedup) {
     if (!summary.isSeqMem())
       continue;
 
-    lowerMemory(op, summary, shouldDedup);
+    mems.push_back({op, std::move(summary)});
   }
   return success();
 }
@@ -525,15 +576,35 @@ void LowerMemoryPass::runOnOperation() {
     dutModuleSet.insert(node->getModule());
   });
 
-  // We iterate the circuit from top-to-bottom to make sure that we get
-  // consistent memory names.
-  for (auto module : body->getOps<FModuleOp>()) {
+  // Summarize the memories of the modules in parallel.
+  auto modules = llvm::to_vector(body->getOps<FModuleOp>());
+  SmallVector<SmallVector<MemoryToLower>> moduleMems(modules.size());
+  if (failed(mlir::failableParallelForEachN(
+          &getContext(), 0, modules.size(), [&](size_t index) {
+            return collectMemories(modules[index], moduleMems[index]);
+          })))
+    return signalPassFailure();
+
+  // Deduplicate the memories by shape and create their modules. We iterate the
+  // circuit from top-to-bottom to make sure that we get consistent memory
+  // names.
+  for (auto [module, mems] : llvm::zip(modules, moduleMems)) {
     // We don't dedup memories in the testharness with any other memories.
     auto shouldDedup = dutModuleSet.contains(module);
-    if (failed(runOnModule(module, shouldDedup)))
-      return signalPassFailure();
+    for (auto &mem : mems)
+      createModules(mem, shouldDedup);
   }
 
+  // Lower the memories of the modules in parallel, then update their
+  // non-local annotations.
+  mlir::parallelForEach(&getContext(), moduleMems, [&](auto &mems) {
+    for (auto &mem : mems)
+      lowerMemory(mem);
+  });
+  for (auto &mems : moduleMems)
+    for (auto &mem : mems)
+      updateNonLocalAnnotations(mem);
+
   circuitNamespace.clear();
   symbolTable = nullptr;
   memories.clear();
@@ -46,6 +46,8 @@
 #include "llvm/ADT/BitVector.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/Parallel.h"
+#include "llvm/Support/RWMutex.h"
+#include "llvm/Support/StringSaver.h"
 
 #define DEBUG_TYPE "firrtl-lower-types"
 
@@ -62,8 +64,9 @@ struct FlatBundleFieldEntry {
   size_t index;
   /// The fieldID
   unsigned fieldID;
-  /// This is a suffix to add to the field name to make it unique.
-  SmallString<16> suffix;
+  /// This is a suffix to add to the field name to make it unique. It is owned
+  /// by the `PeeledTypeCache` the entry was created by.
+  StringRef suffix;
   /// This indicates whether the field was flipped to be an output.
   bool isOutput;
 
@@ -163,10 +166,27 @@ static bool isPreservableAggregateType(Type type,
   }
 }
 
+/// Return true if the value is a vector only accessed as a whole or through
+/// dynamic subaccesses, which can be kept as a single array.
+static bool isUniformlyAccessedVector(Value value) {
+  auto vectorType = value.getType().dyn_cast<FVectorType>();
+  if (!vectorType ||
+      !isPreservableAggregateType(vectorType, PreserveAggregate::All))
+    return false;
+  return llvm::all_of(value.getUsers(), [&](Operation *user) {
+    if (isa<ConnectOp, StrictConnectOp>(user))
+      return true;
+    auto subaccess = dyn_cast<SubaccessOp>(user);
+    return subaccess && subaccess.getInput() == value;
+  });
+}
+
 /// Peel one layer of an aggregate type into its components.  Type may be
 /// complex, but empty, in which case fields is empty, but the return is true.
+/// The suffixes of the fields are stored in `saver`.
 static bool peelType(Type type, SmallVectorImpl<FlatBundleFieldEntry> &fields,
-                     PreserveAggregate::PreserveMode mode) {
+                     PreserveAggregate::PreserveMode mode,
+                     llvm::StringSaver &saver) {
   // If the aggregate preservation is enabled and the type is preservable,
   // then just return.
   if (isPreservableAggregateType(type, mode))
@@ -176,15 +196,12 @@ static bool peelType(Type type, SmallVectorImpl<FlatBundleFieldEntry> &fields,
     type = refType.getType();
   return TypeSwitch<Type, bool>(type)
       .Case<BundleType>([&](auto bundle) {
-        SmallString<16> tmpSuffix;
         // Otherwise, we have a bundle type.  Break it down.
         for (size_t i = 0, e = bundle.getNumElements(); i < e; ++i) {
           auto elt = bundle.getElement(i);
           // Construct the suffix to pass down.
-          tmpSuffix.resize(0);
-          tmpSuffix.push_back('_');
-          tmpSuffix.append(elt.name.getValue());
-          fields.emplace_back(elt.type, i, bundle.getFieldID(i), tmpSuffix,
+          fields.emplace_back(elt.type, i, bundle.getFieldID(i),
+                              saver.save("_" + elt.name.getValue()),
                               elt.isFlip);
         }
         return true;
@@ -193,13 +210,56 @@ static bool peelType(Type type, SmallVectorImpl<FlatBundleFieldEntry> &fields,
         // Increment the field ID to point to the first element.
         for (size_t i = 0, e = vector.getNumElements(); i != e; ++i) {
           fields.emplace_back(vector.getElementType(), i, vector.getFieldID(i),
-                              "_" + std::to_string(i), false);
+                              saver.save("_" + Twine(i)), false);
         }
         return true;
       })
       .Default([](auto op) { return false; });
 }
 
+namespace {
+/// The peeled types seen by the lowerings of all modules, which share them
+/// across threads. The same types tend to be used by many ports and values
+/// throughout a design, so each one is only peeled once and the fields of all
+/// types are kept in one arena instead of a vector per use.
+struct PeeledTypeCache {
+  /// Peel one layer of an aggregate type off, as `peelType` does. Returns none
+  /// if the type is not peeled.
+  std::optional<ArrayRef<FlatBundleFieldEntry>>
+  peel(Type type, PreserveAggregate::PreserveMode mode);
+
+private:
+  llvm::sys::SmartRWMutex<true> mutex;
+  DenseMap<std::pair<Type, unsigned>,
+           std::optional<ArrayRef<FlatBundleFieldEntry>>>
+      entries;
+  llvm::BumpPtrAllocator allocator;
+  llvm::StringSaver saver{allocator};
+};
+} // end anonymous namespace
+
+std::optional<ArrayRef<FlatBundleFieldEntry>>
+PeeledTypeCache::peel(Type type, PreserveAggregate::PreserveMode mode) {
+  auto key = std::make_pair(type, unsigned(mode));
+  {
+    llvm::sys::SmartScopedReader<true> lock(mutex);
+    auto it = entries.find(key);
+    if (it != entries.end())
+      return it->second;
+  }
+
+  // The fields are allocated from the shared arena, so the type is peeled
+  // while holding the lock. This only happens once per type.
+  llvm::sys::SmartScopedWriter<true> lock(mutex);
+  auto [it, inserted] = entries.try_emplace(key);
+  if (!inserted)
+    return it->second;
+  SmallVector<FlatBundleFieldEntry, 8> fields;
+  if (peelType(type, fields, mode, saver))
+    it->second = ArrayRef<FlatBundleFieldEntry>(fields).copy(allocator);
+  return it->second;
+}
+
 /// Return if something is not a normal subaccess.  Non-normal includes
 /// zero-length vectors and constant indexes (which are really subindexes).
 static bool isNotSubAccess(Operation *op) {
@@ -357,11 +417,14 @@ struct TypeLoweringVisitor : public FIRRTLVisitor<TypeLoweringVisitor, bool> {
   TypeLoweringVisitor(
       MLIRContext *context, PreserveAggregate::PreserveMode preserveAggregate,
       PreserveAggregate::PreserveMode memoryPreservationMode,
-      SymbolTable &symTbl, const AttrCache &cache,
+      bool preserveUniformVectors, SymbolTable &symTbl, const AttrCache &cache,
+      PeeledTypeCache &peeledTypes,
       const llvm::DenseMap<FModuleLike, Convention> &conventionTable)
       : context(context), aggregatePreservationMode(preserveAggregate),
-        memoryPreservationMode(memoryPreservationMode), symTbl(symTbl),
-        cache(cache), conventionTable(conventionTable) {}
+        memoryPreservationMode(memoryPreservationMode),
+        preserveUniformVectors(preserveUniformVectors), symTbl(symTbl),
+        cache(cache), peeledTypes(peeledTypes),
+        conventionTable(conventionTable) {}
   using FIRRTLVisitor<TypeLoweringVisitor, bool>::visitDecl;
   using FIRRTLVisitor<TypeLoweringVisitor, bool>::visitExpr;
   using FIRRTLVisitor<TypeLoweringVisitor, bool>::visitStmt;
@@ -445,6 +508,11 @@ private:
   PreserveAggregate::PreserveMode aggregatePreservationMode;
   PreserveAggregate::PreserveMode memoryPreservationMode;
 
+  /// Whether to keep uniformly accessed vector declarations, and the
+  /// declarations of the current module which are kept.
+  bool preserveUniformVectors;
+  DenseSet<Operation *> uniformVectorDecls;
+
   /// The builder is set and maintained in the main loop.
   ImplicitLocOpBuilder *builder;
 
@@ -454,6 +522,9 @@ private:
   // Cache some attributes
   const AttrCache &cache;
 
+  // The peeled types shared by all modules
+  PeeledTypeCache &peeledTypes;
+
   const llvm::DenseMap<FModuleLike, Convention> &conventionTable;
 
   // Set true if the lowering failed.
@@ -587,11 +658,10 @@ bool TypeLoweringVisitor::lowerProducer(
   if (!srcType)
     srcType = op->getResult(0).getType();
   auto srcFType = dyn_cast<FIRRTLType>(srcType);
-  if (!srcFType)
+  if (!srcFType || uniformVectorDecls.contains(op))
     return false;
-  SmallVector<FlatBundleFieldEntry, 8> fieldTypes;
-
-  if (!peelType(srcFType, fieldTypes, aggregatePreservationMode))
+  auto fieldTypes = peeledTypes.peel(srcFType, aggregatePreservationMode);
+  if (!fieldTypes)
     return false;
 
   // If an aggregate value has a symbol, emit errors.
@@ -612,7 +682,7 @@ bool TypeLoweringVisitor::lowerProducer(
   auto baseNameLen = loweredName.size();
   auto oldAnno = op->getAttr("annotations").dyn_cast_or_null<ArrayAttr>();
 
-  for (auto field : fieldTypes) {
+  for (auto field : *fieldTypes) {
     if (!loweredName.empty()) {
       loweredName.resize(baseNameLen);
       loweredName += field.suffix;
@@ -749,12 +819,13 @@ bool TypeLoweringVisitor::lowerArg(FModuleLike module, size_t argIndex,
                                    SmallVectorImpl<Value> &lowering) {
 
   // Flatten any bundle types.
-  SmallVector<FlatBundleFieldEntry> fieldTypes;
   auto srcType = newArgs[argIndex].type.cast<FIRRTLType>();
-  if (!peelType(srcType, fieldTypes, getPreservationModeForModule(module)))
+  auto fieldTypes =
+      peeledTypes.peel(srcType, getPreservationModeForModule(module));
+  if (!fieldTypes)
     return false;
 
-  for (const auto &field : llvm::enumerate(fieldTypes)) {
+  for (const auto &field : llvm::enumerate(*fieldTypes)) {
     auto newValue = addArg(module, 1 + argIndex + field.index(), argsRemoved,
                            srcType, field.value(), newArgs[argIndex]);
     newArgs.insert(newArgs.begin() + 1 + argIndex + field.index(),
@@ -805,14 +876,14 @@ bool TypeLoweringVisitor::visitStmt(ConnectOp op) {
     return true;
 
   // Attempt to get the bundle types.
-  SmallVector<FlatBundleFieldEntry> fields;
-
   // We have to expand connections even if the aggregate preservation is true.
-  if (!peelType(op.getDest().getType(), fields, PreserveAggregate::None))
+  auto fields =
+      peeledTypes.peel(op.getDest().getType(), PreserveAggregate::None);
+  if (!fields)
     return false;
 
   // Loop over the leaf aggregates.
-  for (const auto &field : llvm::enumerate(fields)) {
+  for (const auto &field : llvm::enumerate(*fields)) {
     Value src = getSubWhatever(op.getSrc(), field.index());
     Value dest = getSubWhatever(op.getDest(), field.index());
     if (field.value().isOutput)
@@ -828,14 +899,14 @@ bool TypeLoweringVisitor::visitStmt(StrictConnectOp op) {
     return true;
 
   // Attempt to get the bundle types.
-  SmallVector<FlatBundleFieldEntry> fields;
-
   // We have to expand connections even if the aggregate preservation is true.
-  if (!peelType(op.getDest().getType(), fields, PreserveAggregate::None))
+  auto fields =
+      peeledTypes.peel(op.getDest().getType(), PreserveAggregate::None);
+  if (!fields)
     return false;
 
   // Loop over the leaf aggregates.
-  for (const auto &field : llvm::enumerate(fields)) {
+  for (const auto &field : llvm::enumerate(*fields)) {
     Value src = getSubWhatever(op.getSrc(), field.index());
     Value dest = getSubWhatever(op.getDest(), field.index());
     if (field.value().isOutput)
@@ -848,13 +919,13 @@ bool TypeLoweringVisitor::visitStmt(StrictConnectOp op) {
 // Expand connects of references-of-aggregates
 bool TypeLoweringVisitor::visitStmt(RefDefineOp op) {
   // Attempt to get the bundle types.
-  SmallVector<FlatBundleFieldEntry> fields;
-
-  if (!peelType(op.getDest().getType(), fields, aggregatePreservationMode))
+  auto fields =
+      peeledTypes.peel(op.getDest().getType(), aggregatePreservationMode);
+  if (!fields)
     return false;
 
   // Loop over the leaf aggregates.
-  for (const auto &field : llvm::enumerate(fields)) {
+  for (const auto &field : llvm::enumerate(*fields)) {
     Value src = getSubWhatever(op.getSrc(), field.index());
     Value dest = getSubWhatever(op.getDest(), field.index());
     assert(!field.value().isOutput && "unexpected flip in reftype destination");
@@ -881,10 +952,9 @@ bool TypeLoweringVisitor::visitStmt(WhenOp op) {
 /// element in a memory's data type.
 bool TypeLoweringVisitor::visitDecl(MemOp op) {
   // Attempt to get the bundle types.
-  SmallVector<FlatBundleFieldEntry> fields;
-
   // MemOp should have ground types so we can't preserve aggregates.
-  if (!peelType(op.getDataType(), fields, memoryPreservationMode))
+  auto fields = peeledTypes.peel(op.getDataType(), memoryPreservationMode);
+  if (!fields)
     return false;
 
   SmallVector<MemOp> newMemories;
@@ -908,7 +978,7 @@ bool TypeLoweringVisitor::visitDecl(MemOp op) {
   // Do not overwrite the pass flag!
 
   // Memory for each field
-  for (const auto &field : fields)
+  for (const auto &field : *fields)
     newMemories.push_back(cloneMemWithNewType(builder, op, field));
   // Hook up the new memories to the wires the old memory was replaced with.
   for (size_t index = 0, rend = op.getNumResults(); index < rend; ++index) {
@@ -922,7 +992,7 @@ bool TypeLoweringVisitor::visitDecl(MemOp op) {
       // go both directions, depending on the port direction.
       if (name == "data" || name == "mask" || name == "wdata" ||
           name == "wmask" || name == "rdata") {
-        for (const auto &field : fields) {
+        for (const auto &field : *fields) {
           auto realOldField = getSubWhatever(oldField, field.index);
           auto newField = getSubWhatever(
               newMemories[field.index].getResult(index), fieldIndex);
@@ -1022,6 +1092,15 @@ bool TypeLoweringVisitor::visitDecl(FModuleOp module) {
   ImplicitLocOpBuilder theBuilder(module.getLoc(), context);
   builder = &theBuilder;
 
+  // Find the vector declarations to keep before lowering rewrites their uses.
+  uniformVectorDecls.clear();
+  if (preserveUniformVectors)
+    module.walk([&](Operation *op) {
+      if (isa<WireOp, RegOp, RegResetOp, NodeOp>(op) &&
+          isUniformlyAccessedVector(op->getResult(0)))
+        uniformVectorDecls.insert(op);
+    });
+
   // Lower the operations.
   lowerBlock(body);
 
@@ -1194,12 +1273,12 @@ bool TypeLoweringVisitor::visitExpr(BitCastOp op) {
   // If the input is of aggregate type, then cat all the leaf fields to form a
   // UInt type result. That is, first bitcast the aggregate type to a UInt.
   // Attempt to get the bundle types.
-  SmallVector<FlatBundleFieldEntry> fields;
-  if (peelType(op.getInput().getType(), fields, PreserveAggregate::None)) {
+  if (auto fields = peeledTypes.peel(op.getInput().getType(),
+                                     PreserveAggregate::None)) {
     size_t uptoBits = 0;
     // Loop over the leaf aggregates and concat each of them to get a UInt.
     // Bitcast the fields to handle nested aggregate types.
-    for (const auto &field : llvm::enumerate(fields)) {
+    for (const auto &field : llvm::enumerate(*fields)) {
       auto fieldBitwidth = *getBitWidth(field.value().type);
       // Ignore zero width fields, like empty bundles.
       if (fieldBitwidth == 0)
@@ -1289,8 +1368,8 @@ bool TypeLoweringVisitor::visitDecl(InstanceOp op) {
     auto srcType = op.getType(i).cast<FIRRTLType>();
 
     // Flatten any nested bundle types the usual way.
-    SmallVector<FlatBundleFieldEntry, 8> fieldTypes;
-    if (!peelType(srcType, fieldTypes, mode)) {
+    auto fieldTypes = peeledTypes.peel(srcType, mode);
+    if (!fieldTypes) {
       newDirs.push_back(op.getPortDirection(i));
       newNames.push_back(op.getPortName(i));
       resultTypes.push_back(srcType);
@@ -1300,7 +1379,7 @@ bool TypeLoweringVisitor::visitDecl(InstanceOp op) {
       auto oldName = op.getPortNameStr(i);
       auto oldDir = op.getPortDirection(i);
       // Store the flat type for the new bundle type.
-      for (const auto &field : fieldTypes) {
+      for (const auto &field : *fieldTypes) {
         newDirs.push_back(direction::get((unsigned)oldDir ^ field.isOutput));
         newNames.push_back(builder->getStringAttr(oldName + field.suffix));
         resultTypes.push_back(
@@ -1360,6 +1439,11 @@ bool TypeLoweringVisitor::visitExpr(SubaccessOp op) {
   auto input = op.getInput();
   auto vType = input.getType();
 
+  // Reads of a kept vector stay dynamic accesses of the array.
+  if (auto *inputOp = input.getDefiningOp();
+      inputOp && uniformVectorDecls.contains(inputOp))
+    return false;
+
   // Check for empty vectors
   if (vType.getNumElements() == 0) {
     Value inv = builder->create<InvalidValueOp>(vType.getElementType());
@@ -1467,9 +1551,11 @@ namespace {
 struct LowerTypesPass : public LowerFIRRTLTypesBase<LowerTypesPass> {
   LowerTypesPass(
       circt::firrtl::PreserveAggregate::PreserveMode preserveAggregateFlag,
-      circt::firrtl::PreserveAggregate::PreserveMode preserveMemoriesFlag) {
+      circt::firrtl::PreserveAggregate::PreserveMode preserveMemoriesFlag,
+      bool preserveUniformVectorsFlag) {
     preserveAggregate = preserveAggregateFlag;
     preserveMemories = preserveMemoriesFlag;
+    preserveUniformVectors = preserveUniformVectorsFlag;
   }
   void runOnOperation() override;
 };
@@ -1485,6 +1571,8 @@ void LowerTypesPass::runOnOperation() {
   SymbolTable symTbl(getOperation());
   // Cached attr
   AttrCache cache(&getContext());
+  // Peeled types, shared by all modules
+  PeeledTypeCache peeledTypes;
 
   DenseMap<FModuleLike, Convention> conventionTable;
   auto circuit = getOperation();
@@ -1497,7 +1585,8 @@ void LowerTypesPass::runOnOperation() {
   auto lowerModules = [&](FModuleLike op) -> LogicalResult {
     auto tl =
         TypeLoweringVisitor(&getContext(), preserveAggregate, preserveMemories,
-                            symTbl, cache, conventionTable);
+                            preserveUniformVectors, symTbl, cache, peeledTypes,
+                            conventionTable);
     tl.lowerModule(op);
 
     return LogicalResult::failure(tl.isFailed());
@@ -1512,6 +1601,7 @@ void LowerTypesPass::runOnOperation() {
 /// This is the pass constructor.
 std::unique_ptr<mlir::Pass> circt::firrtl::createLowerFIRRTLTypesPass(
     PreserveAggregate::PreserveMode mode,
-    PreserveAggregate::PreserveMode memoryMode) {
-  return std::make_unique<LowerTypesPass>(mode, memoryMode);
+    PreserveAggregate::PreserveMode memoryMode, bool preserveUniformVectors) {
+  return std::make_unique<LowerTypesPass>(mode, memoryMode,
+                                          preserveUniformVectors);
 }
@@ -279,6 +279,7 @@ class LowerXMRPass : public LowerXMRBase<LowerXMRPass> {
     xmrPathSuffix.clear();
     circuitNamespace = nullptr;
     pathCache.clear();
+    resolvedPaths.clear();
     pathInsertPoint = {};
   }
 
@@ -305,26 +306,36 @@ class LowerXMRPass : public LowerXMRBase<LowerXMRPass> {
     auto remoteOpPath = getRemoteRefSend(refVal);
     if (!remoteOpPath)
       return failure();
+
+    // All the references reaching the same RefSend share its resolved path,
+    // so the path is only walked and its HierPathOp looked up once.
+    auto cached = resolvedPaths.find(*remoteOpPath);
+    if (cached != resolvedPaths.end()) {
+      ref = cached->second.first;
+      stringLeaf.append(cached->second.second);
+      return success();
+    }
+
     SmallVector<Attribute> refSendPath;
-    SmallVector<Attribute> refSendSimplePath;
     size_t lastIndex;
-    while (remoteOpPath) {
-      lastIndex = *remoteOpPath;
-      auto entr = refSendPathList[*remoteOpPath];
+    for (auto index = remoteOpPath; index;) {
+      lastIndex = *index;
+      auto entr = refSendPathList[*index];
       // If the path is a singular verbatim expression, the attribute of the
       // send path list entry will be null
       if (entr.first)
         refSendPath.push_back(entr.first);
-      remoteOpPath = entr.second;
+      index = entr.second;
     }
     auto iter = xmrPathSuffix.find(lastIndex);
 
     // If this xmr has a suffix string (internal path into a module, that is not
     // yet generated).
+    SmallString<128> leaf;
     if (iter != xmrPathSuffix.end()) {
       if (!refSendPath.empty())
-        stringLeaf.append(".");
-      stringLeaf.append(iter->getSecond());
+        leaf.append(".");
+      leaf.append(iter->getSecond());
     }
 
     if (!refSendPath.empty())
@@ -333,6 +344,8 @@ class LowerXMRPass : public LowerXMRBase<LowerXMRPass> {
           getOrCreatePath(builder.getArrayAttr(refSendPath), builder)
               .getSymNameAttr());
 
+    stringLeaf.append(leaf);
+    resolvedPaths.insert({*remoteOpPath, {ref, std::move(leaf)}});
     return success();
   }
 
@@ -662,6 +675,7 @@ class LowerXMRPass : public LowerXMRBase<LowerXMRPass> {
     refPortsToRemoveMap.clear();
     dataflowAt.clear();
     refSendPathList.clear();
+    resolvedPaths.clear();
   }
 
   bool isZeroWidth(FIRRTLBaseType t) { return t.getBitWidthOrSentinel() == 0; }
@@ -748,6 +762,12 @@ private:
   /// creating the same HierPathOp.
   DenseMap<Attribute, hw::HierPathOp> pathCache;
 
+  /// A cache of the resolved paths of entries of `refSendPathList`, as the
+  /// symbol of the HierPathOp to the referenced op, if any, and the internal
+  /// path suffix.
+  DenseMap<size_t, std::pair<FlatSymbolRefAttr, SmallString<128>>>
+      resolvedPaths;
+
   /// The insertion point where the pass inserts HierPathOps.
   OpBuilder::InsertPoint pathInsertPoint = {};
 };
@@ -31,8 +31,12 @@ using namespace firrtl;
 
 namespace {
 struct MemToRegOfVecPass : public MemToRegOfVecBase<MemToRegOfVecPass> {
-  MemToRegOfVecPass(bool replSeqMem, bool ignoreReadEnable)
-      : replSeqMem(replSeqMem), ignoreReadEnable(ignoreReadEnable){};
+  MemToRegOfVecPass(bool replSeqMem, bool ignoreReadEnable, uint64_t maxDepth,
+                    uint64_t bankDepth)
+      : replSeqMem(replSeqMem), ignoreReadEnable(ignoreReadEnable) {
+    this->maxDepth = maxDepth;
+    this->bankDepth = bankDepth;
+  };
 
   void runOnOperation() override {
     auto circtOp = getOperation();
@@ -83,6 +87,10 @@ struct MemToRegOfVecPass : public MemToRegOfVecBase<MemToRegOfVecPass> {
            (firMem.numWritePorts + firMem.numReadWritePorts == 1) &&
            (firMem.numReadPorts <= 1) && firMem.dataWidth > 0))
         return;
+      // Keep deep memories as memories, which simulators can model natively
+      // instead of evaluating the mux trees of a register of vector.
+      if (maxDepth != 0 && firMem.depth > maxDepth)
+        return;
 
       generateMemory(memOp, firMem);
       ++numConvertedMems;
@@ -108,6 +116,24 @@ struct MemToRegOfVecPass : public MemToRegOfVecBase<MemToRegOfVecPass> {
     return pipeInput;
   }
 
+  /// Access the entry at an address of the register implementing a memory. The
+  /// entries of banked registers are accessed in two levels, selecting the bank
+  /// by the upper address bits and the entry within the bank by the lower ones.
+  Value getEntry(ImplicitLocOpBuilder &builder, const FirMemory &firMem,
+                 Value regOfVec, Value addr) {
+    // A banked register has fewer elements than the memory has entries.
+    auto regType = regOfVec.getType().cast<FVectorType>();
+    if (regType.getNumElements() == firMem.depth)
+      return builder.create<SubaccessOp>(regOfVec, addr);
+    auto bankType = regType.getElementType().cast<FVectorType>();
+    auto addrWidth = addr.getType().cast<UIntType>().getWidthOrSentinel();
+    auto bankBits = llvm::Log2_64(bankType.getNumElements());
+    auto bankAddr = builder.create<BitsPrimOp>(addr, addrWidth - 1, bankBits);
+    auto entryAddr = builder.create<BitsPrimOp>(addr, bankBits - 1, 0);
+    auto bank = builder.create<SubaccessOp>(regOfVec, bankAddr);
+    return builder.create<SubaccessOp>(bank, entryAddr);
+  }
+
   Value getClock(ImplicitLocOpBuilder &builder, Value bundle) {
     return builder.create<SubfieldOp>(bundle, "clk");
   }
@@ -163,7 +189,7 @@ struct MemToRegOfVecPass : public MemToRegOfVecBase<MemToRegOfVecPass> {
     }
 
     // Read the register[address] into a temporary.
-    Value rdata = builder.create<SubaccessOp>(regOfVec, addr);
+    Value rdata = getEntry(builder, firMem, regOfVec, addr);
     if (!ignoreReadEnable) {
       // Initialize read data out with invalid.
       builder.create<StrictConnectOp>(
@@ -190,7 +216,7 @@ struct MemToRegOfVecPass : public MemToRegOfVecBase<MemToRegOfVecPass> {
     wdataIn = addPipelineStages(builder, numStages, clock, wdataIn, "wdata");
     maskBits = addPipelineStages(builder, numStages, clock, maskBits, "wmask");
     // Create the register access.
-    FIRRTLBaseValue rdata = builder.create<SubaccessOp>(regOfVec, addr);
+    Value rdata = getEntry(builder, firMem, regOfVec, addr);
 
     // The tuple for the access to individual fields of an aggregate data type.
     // Tuple::<register, data, mask>
@@ -247,7 +273,7 @@ struct MemToRegOfVecPass : public MemToRegOfVecBase<MemToRegOfVecPass> {
     maskBits = addPipelineStages(builder, numStages, clock, maskBits, "wmask");
 
     // Read the register[address] into a temporary.
-    Value rdata = builder.create<SubaccessOp>(regOfVec, addr);
+    Value rdata = getEntry(builder, firMem, regOfVec, addr);
 
     SmallVector<std::tuple<Value, Value, Value>, 8> loweredRegDataMaskFields;
     if (!getFields(rdata, wdataIn, maskBits, loweredRegDataMaskFields,
@@ -346,22 +372,28 @@ struct MemToRegOfVecPass : public MemToRegOfVecBase<MemToRegOfVecPass> {
     return false;
   }
 
-  void scatterMemTapAnno(RegOp op, ArrayAttr attr,
+  void scatterMemTapAnno(RegOp op, ArrayAttr attr, uint64_t depth,
                          ImplicitLocOpBuilder &builder) {
     AnnotationSet annos(attr);
     SmallVector<Attribute> regAnnotations;
     auto vecType = op.getResult().getType().cast<FVectorType>();
+    // Get the field ID of a memory entry, which is nested in a bank if the
+    // register is banked, i.e. has fewer elements than the memory has entries.
+    auto getEntryFieldID = [&](size_t i) -> uint64_t {
+      if (vecType.getNumElements() == depth)
+        return vecType.getFieldID(i);
+      auto bankType = vecType.getElementType().cast<FVectorType>();
+      auto bankDepth = bankType.getNumElements();
+      return vecType.getFieldID(i / bankDepth) +
+             bankType.getFieldID(i % bankDepth);
+    };
     for (auto anno : annos) {
       if (anno.isClass(memTapSourceClass)) {
-        for (size_t i = 0, e = op.getResult()
-                                   .getType()
-                                   .cast<FVectorType>()
-                                   .getNumElements();
-             i != e; ++i) {
+        for (size_t i = 0; i != depth; ++i) {
           NamedAttrList newAnno;
           newAnno.append("class", anno.getMember("class"));
           newAnno.append("circt.fieldID",
-                         builder.getI64IntegerAttr(vecType.getFieldID(i)));
+                         builder.getI64IntegerAttr(getEntryFieldID(i)));
           newAnno.append("id", anno.getMember("id"));
           if (auto nla = anno.getMember("circt.nonlocal"))
             newAnno.append("circt.nonlocal", nla);
@@ -385,6 +417,20 @@ struct MemToRegOfVecPass : public MemToRegOfVecBase<MemToRegOfVecPass> {
     auto innerSym = memOp.getInnerSym();
     SmallVector<Value> debugPorts;
 
+    // Split deep memories into banks, unless the register is probed through a
+    // debug port, which has to keep the type of the memory.
+    FIRRTLBaseType regType = FVectorType::get(dataType, firMem.depth);
+    if (bankDepth > 1 && llvm::isPowerOf2_64(bankDepth) &&
+        firMem.depth > bankDepth &&
+        llvm::none_of(memOp.getResults(), [](Value result) {
+          return isa<RefType>(result.getType());
+        })) {
+      auto numBanks = llvm::divideCeil(firMem.depth, bankDepth);
+      regType = FVectorType::get(FVectorType::get(dataType, bankDepth),
+                                 numBanks);
+      ++numBankedMems;
+    }
+
     RegOp regOfVec = {};
     for (size_t index = 0, rend = memOp.getNumResults(); index < rend;
          ++index) {
@@ -409,12 +455,12 @@ struct MemToRegOfVecPass : public MemToRegOfVecBase<MemToRegOfVecPass> {
       // IF the register is not yet created.
       if (!regOfVec) {
         // Create the register corresponding to the memory.
-        regOfVec = builder.create<RegOp>(
-            FVectorType::get(dataType, firMem.depth), clk, memOp.getNameAttr());
+        regOfVec = builder.create<RegOp>(regType, clk, memOp.getNameAttr());
 
         // Copy all the memory annotations.
         if (!memOp.getAnnotationsAttr().empty())
-          scatterMemTapAnno(regOfVec, memOp.getAnnotationsAttr(), builder);
+          scatterMemTapAnno(regOfVec, memOp.getAnnotationsAttr(), firMem.depth,
+                            builder);
         if (innerSym)
           regOfVec.setInnerSymAttr(memOp.getInnerSymAttr());
       }
@@ -448,6 +494,8 @@ private:
 } // end anonymous namespace
 
 std::unique_ptr<mlir::Pass>
-circt::firrtl::createMemToRegOfVecPass(bool replSeqMem, bool ignoreReadEnable) {
-  return std::make_unique<MemToRegOfVecPass>(replSeqMem, ignoreReadEnable);
+circt::firrtl::createMemToRegOfVecPass(bool replSeqMem, bool ignoreReadEnable,
+                                       uint64_t maxDepth, uint64_t bankDepth) {
+  return std::make_unique<MemToRegOfVecPass>(replSeqMem, ignoreReadEnable,
+                                             maxDepth, bankDepth);
 }
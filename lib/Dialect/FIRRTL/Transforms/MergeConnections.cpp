@@ -26,6 +26,7 @@
 #include "circt/Dialect/FIRRTL/Passes.h"
 #include "mlir/IR/ImplicitLocOpBuilder.h"
 #include "llvm/ADT/TypeSwitch.h"
+#include "llvm/Support/Allocator.h"
 #include "llvm/Support/Debug.h"
 
 #define DEBUG_TYPE "firrtl-merge-connections"
@@ -61,10 +62,19 @@ struct MergeConnection {
   // Return true if the given connect op is merged.
   bool peelConnect(StrictConnectOp connect);
 
-  // A map from a destination FieldRef to a pair of (i) the number of
-  // connections seen so far and (ii) the vector to store subconnections.
-  DenseMap<FieldRef, std::pair<unsigned, SmallVector<StrictConnectOp>>>
-      connections;
+  // The connections to the elements of an aggregate destination.
+  struct SubConnections {
+    // The number of connections seen so far.
+    unsigned count = 0;
+    // The connection to each element, allocated in `allocator`.
+    MutableArrayRef<StrictConnectOp> connects;
+  };
+
+  // A map from a destination FieldRef to its subconnections. The entries are
+  // small and the subconnections are allocated in an arena, so that growing
+  // the map does not move or reallocate any vectors.
+  DenseMap<FieldRef, SubConnections> connections;
+  llvm::BumpPtrAllocator allocator;
 
   FModuleOp moduleOp;
   ImplicitLocOpBuilder *builder = nullptr;
@@ -102,17 +112,21 @@ bool MergeConnection::peelConnect(StrictConnectOp connect) {
   else
     llvm_unreachable("unexpected destination");
 
-  auto &countAndSubConnections = connections[getFieldRefFromValue(parent)];
-  auto &count = countAndSubConnections.first;
-  auto &subConnections = countAndSubConnections.second;
+  auto &entry = connections[getFieldRefFromValue(parent)];
+  auto &count = entry.count;
+  auto &subConnections = entry.connects;
 
-  // If it is the first time to visit the parent op, then allocate the vector
-  // for subconnections.
+  // If it is the first time to visit the parent op, then allocate the
+  // subconnections.
   if (count == 0) {
+    size_t numElements = 0;
     if (auto bundle = parent.getType().dyn_cast<BundleType>())
-      subConnections.resize(bundle.getNumElements());
+      numElements = bundle.getNumElements();
     if (auto vector = parent.getType().dyn_cast<FVectorType>())
-      subConnections.resize(vector.getNumElements());
+      numElements = vector.getNumElements();
+    auto *storage = allocator.Allocate<StrictConnectOp>(numElements);
+    std::uninitialized_fill_n(storage, numElements, StrictConnectOp());
+    subConnections = MutableArrayRef<StrictConnectOp>(storage, numElements);
   }
   ++count;
   subConnections[index] = connect;
@@ -235,6 +249,13 @@ bool MergeConnection::run() {
   ImplicitLocOpBuilder theBuilder(moduleOp.getLoc(), moduleOp.getContext());
   builder = &theBuilder;
   auto *body = moduleOp.getBodyBlock();
+
+  // Size the map up front, since most connections are to aggregate elements.
+  unsigned numConnects = 0;
+  for (auto &op : *body)
+    numConnects += isa<StrictConnectOp>(op);
+  connections.reserve(numConnects);
+
   // Merge connections by forward iterations.
   for (auto it = body->begin(), e = body->end(); it != e;) {
     auto connectOp = dyn_cast<StrictConnectOp>(*it);
@@ -14,6 +14,7 @@
 #include "circt/Dialect/FIRRTL/AnnotationDetails.h"
 #include "circt/Dialect/FIRRTL/CHIRRTLDialect.h"
 #include "circt/Dialect/FIRRTL/FIRRTLAnnotations.h"
+#include "circt/Dialect/FIRRTL/FIRRTLInstanceGraph.h"
 #include "circt/Dialect/FIRRTL/FIRRTLOps.h"
 #include "circt/Dialect/FIRRTL/FIRRTLTypes.h"
 #include "circt/Dialect/FIRRTL/FIRRTLUtils.h"
@@ -26,6 +27,7 @@
 #include "circt/Support/LLVM.h"
 #include "mlir/IR/IRMapping.h"
 #include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/PostOrderIterator.h"
 #include "llvm/ADT/SetOperations.h"
 #include "llvm/ADT/SetVector.h"
 #include "llvm/ADT/SmallPtrSet.h"
@@ -503,12 +505,20 @@ static void replaceRefEdges(SmallVectorImpl<Backedge> &edges) {
 namespace {
 class Inliner {
 public:
-  /// Initialize the inliner to run on this circuit.
-  Inliner(CircuitOp circuit);
+  /// Initialize the inliner to run on this circuit. If `maxInlineSize` is not
+  /// zero, unannotated modules up to that size are inlined as well, as long as
+  /// the circuit grows by at most `maxInlineGrowth` operations per module.
+  Inliner(CircuitOp circuit, unsigned maxInlineSize = 0,
+          unsigned maxInlineGrowth = 0);
 
   /// Run the inliner.
   void run();
 
+  /// The number of unannotated modules selected for inlining, and the number
+  /// of operations this is estimated to add to the circuit.
+  unsigned numCostModelInlined = 0;
+  uint64_t numCostModelGrowth = 0;
+
 private:
   /// Returns true if the NLA matches the current path.  This will only return
   /// false if there is a mismatch indicating that the NLA definitely is
@@ -575,6 +585,9 @@ private:
   /// Identify all module-only NLA's, marking their MutableNLA's accordingly.
   void identifyNLAsTargetingOnlyModules();
 
+  /// Select the unannotated modules which are small enough to be inlined.
+  void selectModulesByCost();
+
   /// Populate the activeHierpaths with the HierPaths that are active given the
   /// current hierarchy. This is the set of HierPaths that were active in the
   /// parent, and on the current instance. Also HierPaths that are rooted at
@@ -600,6 +613,13 @@ private:
   CircuitOp circuit;
   MLIRContext *context;
 
+  /// The thresholds of the cost model.
+  unsigned maxInlineSize;
+  unsigned maxInlineGrowth;
+
+  /// The unannotated modules selected for inlining by the cost model.
+  DenseSet<Operation *> costModelInlined;
+
   // A symbol table with references to each module in a circuit.
   SymbolTable symbolTable;
 
@@ -902,7 +922,8 @@ bool Inliner::shouldFlatten(Operation *op) {
 }
 
 bool Inliner::shouldInline(Operation *op) {
-  return AnnotationSet(op).hasAnnotation(inlineAnnoClass);
+  return costModelInlined.contains(op) ||
+         AnnotationSet(op).hasAnnotation(inlineAnnoClass);
 }
 
 // NOLINTNEXTLINE(misc-no-recursion)
@@ -1298,8 +1319,75 @@ void Inliner::identifyNLAsTargetingOnlyModules() {
   }
 }
 
-Inliner::Inliner(CircuitOp circuit)
-    : circuit(circuit), context(circuit.getContext()), symbolTable(circuit) {}
+void Inliner::selectModulesByCost() {
+  if (maxInlineSize == 0)
+    return;
+
+  // Modules on a hierarchical path are left alone, since their instances are
+  // referenced by name.
+  DenseSet<Attribute> pathModules;
+  for (auto &[_, mnla] : nlaMap)
+    for (auto elem : mnla.getNLA().getNamepath()) {
+      if (auto ref = elem.dyn_cast<InnerRefAttr>())
+        pathModules.insert(ref.getModule());
+      else if (auto sym = elem.dyn_cast<FlatSymbolRefAttr>())
+        pathModules.insert(sym.getAttr());
+    }
+
+  auto innerSymName = hw::InnerSymbolTable::getInnerSymbolAttrName();
+  auto isCandidate = [&](FModuleOp module) {
+    if (module.isPublic() || !AnnotationSet(module).empty() ||
+        pathModules.contains(module.getNameAttr()))
+      return false;
+    for (auto port : module.getPorts())
+      if (port.sym || !port.annotations.empty())
+        return false;
+    return true;
+  };
+
+  // Visit the modules bottom-up such that the size of a module includes the
+  // children which will be inlined into it.
+  InstanceGraph instanceGraph(circuit);
+  DenseMap<Operation *, uint64_t> sizes;
+  for (auto *node : llvm::post_order(&instanceGraph)) {
+    auto module = dyn_cast<FModuleOp>(*node->getModule());
+    if (!module)
+      continue;
+    uint64_t size = 0;
+    bool hasInnerSym = false;
+    module.getBodyBlock()->walk([&](Operation *op) {
+      ++size;
+      hasInnerSym |= op->hasAttr(innerSymName);
+      if (auto instance = dyn_cast<InstanceOp>(op)) {
+        auto *child = symbolTable.lookup(instance.getModuleName());
+        if (shouldInline(child))
+          size += sizes.lookup(child);
+      }
+    });
+    sizes[module] = size;
+
+    unsigned numInstances = node->getNumUses();
+    if (hasInnerSym || numInstances == 0 || size > maxInlineSize ||
+        !isCandidate(module))
+      continue;
+    uint64_t growth = size * (numInstances - 1);
+    if (maxInlineGrowth && growth > maxInlineGrowth)
+      continue;
+
+    LLVM_DEBUG(llvm::dbgs() << "Inlining " << module.getName() << " with "
+                            << size << " ops into " << numInstances
+                            << " instances\n");
+    costModelInlined.insert(module);
+    ++numCostModelInlined;
+    numCostModelGrowth += growth;
+  }
+}
+
+Inliner::Inliner(CircuitOp circuit, unsigned maxInlineSize,
+                 unsigned maxInlineGrowth)
+    : circuit(circuit), context(circuit.getContext()),
+      maxInlineSize(maxInlineSize), maxInlineGrowth(maxInlineGrowth),
+      symbolTable(circuit) {}
 
 void Inliner::run() {
   CircuitNamespace circuitNamespace(circuit);
@@ -1317,6 +1405,9 @@ void Inliner::run() {
   // These may be deleted when their module is inlined/flattened.
   identifyNLAsTargetingOnlyModules();
 
+  // Pick the unannotated modules to inline.
+  selectModulesByCost();
+
   // Mark the top module as live, so it doesn't get deleted.
   for (auto module : circuit.getOps<FModuleLike>()) {
     if (!module.isPublic())
@@ -1458,8 +1549,10 @@ class InlinerPass : public InlinerBase<InlinerPass> {
     LLVM_DEBUG(llvm::dbgs()
                << "===- Running Module Inliner Pass "
                   "--------------------------------------------===\n");
-    Inliner inliner(getOperation());
+    Inliner inliner(getOperation(), maxInlineSize, maxInlineGrowth);
     inliner.run();
+    numCostModelInlined = inliner.numCostModelInlined;
+    numCostModelGrowth = inliner.numCostModelGrowth;
     LLVM_DEBUG(llvm::dbgs() << "===--------------------------------------------"
                                "------------------------------===\n");
   }
@@ -37,10 +37,17 @@ namespace {
 struct RegisterOptimizerPass
     : public RegisterOptimizerBase<RegisterOptimizerPass> {
   void runOnOperation() override;
+  void indexConnects(FModuleOp mod);
   void checkRegReset(mlir::DominanceInfo &dom,
                      SmallVector<Operation *> &toErase, RegResetOp reg);
   void checkReg(mlir::DominanceInfo &dom, SmallVector<Operation *> &toErase,
                 RegOp reg);
+
+  /// The single strict connect to each register, or null if the register is
+  /// connected more than once, by a non-strict connect, or used by an attach.
+  /// Registers which are never connected have no entry. This matches
+  /// `getSingleConnectUserOf`, but is computed in one walk over the module.
+  DenseMap<Value, StrictConnectOp> regConnects;
 };
 
 } // namespace
@@ -50,7 +57,7 @@ void RegisterOptimizerPass::checkReg(mlir::DominanceInfo &dom,
                                      RegOp reg) {
   if (!canErase(reg))
     return;
-  auto con = getSingleConnectUserOf(reg.getResult());
+  auto con = regConnects.lookup(reg.getResult());
   if (!con)
     return;
 
@@ -105,7 +112,7 @@ void RegisterOptimizerPass::checkRegReset(mlir::DominanceInfo &dom,
                                           RegResetOp reg) {
   if (!canErase(reg))
     return;
-  auto con = getSingleConnectUserOf(reg.getResult());
+  auto con = regConnects.lookup(reg.getResult());
   if (!con)
     return;
 
@@ -130,6 +137,28 @@ void RegisterOptimizerPass::checkRegReset(mlir::DominanceInfo &dom,
   }
 }
 
+void RegisterOptimizerPass::indexConnects(FModuleOp mod) {
+  auto isReg = [](Value value) {
+    return isa_and_nonnull<RegOp, RegResetOp>(value.getDefiningOp());
+  };
+  mod.walk([&](Operation *op) {
+    if (auto attach = dyn_cast<AttachOp>(op)) {
+      for (auto operand : attach.getAttached())
+        if (isReg(operand))
+          regConnects[operand] = {};
+      return;
+    }
+    auto connect = dyn_cast<FConnectLike>(op);
+    if (!connect || !isReg(connect.getDest()))
+      return;
+    auto strictConnect = dyn_cast<StrictConnectOp>(op);
+    auto [it, inserted] =
+        regConnects.insert({connect.getDest(), strictConnect});
+    if (!inserted)
+      it->second = {};
+  });
+}
+
 void RegisterOptimizerPass::runOnOperation() {
   auto mod = getOperation();
   LLVM_DEBUG(llvm::dbgs() << "===----- Running RegisterOptimizer "
@@ -138,6 +167,8 @@ void RegisterOptimizerPass::runOnOperation() {
 
   SmallVector<Operation *> toErase;
   mlir::DominanceInfo dom(mod);
+  regConnects.clear();
+  indexConnects(mod);
 
   for (auto &op : *mod.getBodyBlock()) {
     if (auto reg = dyn_cast<RegResetOp>(&op))
@@ -147,6 +178,7 @@ void RegisterOptimizerPass::runOnOperation() {
   }
   for (auto *op : toErase)
     op->erase();
+  regConnects.clear();
 
   if (!toErase.empty())
     return markAllAnalysesPreserved();
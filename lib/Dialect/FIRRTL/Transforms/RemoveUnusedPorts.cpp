@@ -15,6 +15,7 @@
 #include "llvm/ADT/APSInt.h"
 #include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/ADT/SetVector.h"
 #include "llvm/Support/Debug.h"
 
 #define DEBUG_TYPE "firrtl-remove-unused-ports"
@@ -29,6 +30,16 @@ struct RemoveUnusedPortsPass
   void removeUnusedModulePorts(FModuleOp module,
                                InstanceGraphNode *instanceGraphNode);
 
+  /// Revisit the module instantiated by `instance`, if it is not public.
+  void enqueueInstantiated(InstanceOp instance);
+
+  InstanceGraph *instanceGraph;
+
+  /// The modules whose ports have to be (re)checked. Removing the ports of a
+  /// module may leave ports of its parents, and of the modules instantiated
+  /// next to it, unused. Only those are revisited.
+  llvm::SetVector<FModuleOp> worklist;
+
   /// If true, the pass will remove unused ports even if they have carry a
   /// symbol or annotations. This is likely to break the IR, but may be useful
   /// for `circt-reduce` where preserving functional correctness of the IR is
@@ -38,16 +49,31 @@ struct RemoveUnusedPortsPass
 } // namespace
 
 void RemoveUnusedPortsPass::runOnOperation() {
-  auto &instanceGraph = getAnalysis<InstanceGraph>();
+  instanceGraph = &getAnalysis<InstanceGraph>();
   LLVM_DEBUG(llvm::dbgs() << "===----- Remove unused ports -----==="
                           << "\n");
-  // Iterate in the reverse order of instance graph iterator, i.e. from leaves
-  // to top.
-  for (auto *node : llvm::post_order(&instanceGraph))
+  // Visit the modules in the reverse order of instance graph iterator, i.e.
+  // from leaves to top. The worklist is popped from the back.
+  SmallVector<FModuleOp> modules;
+  for (auto *node : llvm::post_order(instanceGraph))
     if (auto module = dyn_cast<FModuleOp>(*node->getModule()))
       // Don't prune the main module.
       if (!module.isPublic())
-        removeUnusedModulePorts(module, node);
+        modules.push_back(module);
+  worklist.insert(modules.rbegin(), modules.rend());
+
+  // Iterate until no more ports can be removed.
+  while (!worklist.empty()) {
+    auto module = worklist.pop_back_val();
+    removeUnusedModulePorts(module, instanceGraph->lookup(module));
+  }
+}
+
+void RemoveUnusedPortsPass::enqueueInstantiated(InstanceOp instance) {
+  auto module =
+      dyn_cast<FModuleOp>(*instanceGraph->getReferencedModule(instance));
+  if (module && !module.isPublic())
+    worklist.insert(module);
 }
 
 void RemoveUnusedPortsPass::removeUnusedModulePorts(
@@ -163,8 +189,12 @@ void RemoveUnusedPortsPass::removeUnusedModulePorts(
         });
 
         result.replaceUsesWithIf(wire.getResult(), [&](OpOperand &op) -> bool {
-          // Connects can be deleted directly.
+          // Connects can be deleted directly. This may leave an output port
+          // of another instance unused.
           if (onlyWritten && isa<FConnectLike>(op.getOwner())) {
+            auto src = cast<FConnectLike>(op.getOwner()).getSrc();
+            if (auto srcInstance = src.getDefiningOp<InstanceOp>())
+              enqueueInstantiated(srcInstance);
             op.getOwner()->erase();
             return false;
           }
@@ -191,9 +221,15 @@ void RemoveUnusedPortsPass::removeUnusedModulePorts(
     }
 
     // Create a new instance op without unused ports.
-    instance.erasePorts(builder, removalPortIndexes);
+    auto newInstance = instance.erasePorts(builder, removalPortIndexes);
+    instanceGraph->replaceInstance(instance, newInstance);
     // Remove old one.
     instance.erase();
+
+    // The ports of the parent may have become unused.
+    auto parent = dyn_cast<FModuleOp>(*use->getParent()->getModule());
+    if (parent && !parent.isPublic())
+      worklist.insert(parent);
   }
 
   numRemovedPorts += removalPortIndexes.count();
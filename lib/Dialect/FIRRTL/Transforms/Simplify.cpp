@@ -0,0 +1,292 @@
+//===- Simplify.cpp - Single-pass FIRRTL simplifier -------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass simplifies the body of a FIRRTL module in a single walk over it, in
+// order.  Every expression is folded with the folders of FIRRTLFolds.cpp, and
+// then hashed against the structurally identical expressions already seen,
+// such that duplicates are replaced on the spot.  Nodes with droppable names
+// fold into their input, and wires with a droppable name and a single strict
+// connect are replaced with the connected value as soon as the connect is
+// reached.  Forwarding a wire changes the operands of expressions that have
+// already been visited, which are put on a small worklist and simplified again
+// right away.  Operations left without uses are erased at the end.
+//
+// This covers the cleanups the canonicalizer spends most of its time on before
+// LowerToHW, without the repeated sweeps of the greedy rewrite driver.  The
+// canonicalization patterns of the operations are not applied.
+//
+//===----------------------------------------------------------------------===//
+
+#include "PassDetails.h"
+#include "circt/Dialect/FIRRTL/FIRRTLOps.h"
+#include "circt/Dialect/FIRRTL/Passes.h"
+#include "circt/Support/ExpressionInfo.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/SetVector.h"
+
+using namespace mlir;
+using namespace circt;
+using namespace firrtl;
+
+namespace {
+struct SimplifyPass : public SimplifyBase<SimplifyPass> {
+  void runOnOperation() override;
+
+private:
+  void simplifyBlock(Block &block);
+  void simplifyOperation(Operation *op, bool revisit = false);
+  LogicalResult foldOperation(Operation *op, bool revisit);
+  void forwardNode(NodeOp node);
+  void forwardWire(StrictConnectOp connect);
+  void replaceAllUsesWith(Operation *op, ValueRange values);
+  bool untrack(Operation *op);
+  void eraseDeadOperations();
+
+  /// The expressions visible at the current point of the walk.  Unlike a
+  /// scoped hash table, this allows expressions to be removed again when
+  /// their operands change.
+  DenseSet<Operation *, ExpressionInfo> knownExpressions;
+
+  /// The expressions added to `knownExpressions` in each enclosing block, which
+  /// are removed again once the walk leaves the block.
+  SmallVector<SmallVector<Operation *>> scopes;
+
+  /// Visited expressions whose operands changed, and which have to be
+  /// simplified again.
+  llvm::SetVector<Operation *> worklist;
+
+  /// Operations whose uses have been removed, and which may now be dead.
+  SmallVector<Operation *> maybeDead;
+};
+} // namespace
+
+/// Return true if this operation is an expression which may be folded and
+/// deduplicated.
+static bool isSimplifiableExpression(Operation *op) {
+  return isa<FIRRTLDialect>(op->getDialect()) && op->getNumRegions() == 0 &&
+         op->getNumResults() > 0 && !isa<FNamableOp>(op) &&
+         mlir::isMemoryEffectFree(op);
+}
+
+/// Return true if a node or wire only exists for its droppable name, such that
+/// it can be replaced with its value.
+template <typename OpTy>
+static bool isRemovableDecl(OpTy op) {
+  return op.hasDroppableName() && !op.getInnerSym() &&
+         op.getAnnotations().empty() && !op.isForceable();
+}
+
+/// Return true if `a` is defined before `b` within the same block or one of
+/// the blocks enclosing `b`.
+static bool properlyDominates(Operation *a, Operation *b) {
+  auto *ancestor = a->getBlock()->findAncestorOpInBlock(*b);
+  return ancestor && ancestor != a && a->isBeforeInBlock(ancestor);
+}
+
+void SimplifyPass::simplifyBlock(Block &block) {
+  scopes.emplace_back();
+  for (auto &op : llvm::make_early_inc_range(block)) {
+    if (isSimplifiableExpression(&op))
+      simplifyOperation(&op);
+    else if (auto node = dyn_cast<NodeOp>(op))
+      forwardNode(node);
+    else if (auto connect = dyn_cast<StrictConnectOp>(op))
+      forwardWire(connect);
+    else
+      for (auto &region : op.getRegions())
+        for (auto &nestedBlock : region)
+          simplifyBlock(nestedBlock);
+
+    while (!worklist.empty())
+      simplifyOperation(worklist.pop_back_val(), /*revisit=*/true);
+  }
+  for (auto *op : scopes.pop_back_val())
+    untrack(op);
+}
+
+/// Remove an expression from the known expressions, before its operands are
+/// changed.  Returns true if it was known.
+bool SimplifyPass::untrack(Operation *op) {
+  auto it = knownExpressions.find(op);
+  if (it == knownExpressions.end() || *it != op)
+    return false;
+  knownExpressions.erase(it);
+  return true;
+}
+
+/// Replace the results of an operation, and queue the known expressions using
+/// them to be simplified again.
+void SimplifyPass::replaceAllUsesWith(Operation *op, ValueRange values) {
+  for (auto *user : op->getUsers())
+    if (untrack(user))
+      worklist.insert(user);
+  op->replaceAllUsesWith(values);
+  maybeDead.push_back(op);
+}
+
+/// Fold an operation, replacing its results with the folded values.  Returns
+/// success if the operation has been replaced and should not be visited any
+/// further.  The new constants are materialized in place of the operation, so
+/// when it is simplified again they are placed before expressions that have
+/// been visited already.
+LogicalResult SimplifyPass::foldOperation(Operation *op, bool revisit) {
+  // Constants fold to themselves.
+  if (op->hasTrait<OpTrait::ConstantLike>())
+    return failure();
+
+  SmallVector<Attribute> operandConstants;
+  operandConstants.reserve(op->getNumOperands());
+  for (auto operand : op->getOperands()) {
+    Attribute constant;
+    matchPattern(operand, m_Constant(&constant));
+    operandConstants.push_back(constant);
+  }
+
+  SmallVector<OpFoldResult> foldResults;
+  if (failed(op->fold(operandConstants, foldResults)))
+    return failure();
+
+  // The operation was updated in place.
+  if (foldResults.empty()) {
+    ++numFolded;
+    return failure();
+  }
+
+  // Materialize the folded constants right before the operation.
+  OpBuilder builder(op);
+  SmallVector<Value> replacements;
+  SmallVector<Operation *> newConstants;
+  for (auto [result, foldResult] : llvm::zip(op->getResults(), foldResults)) {
+    if (auto value = foldResult.dyn_cast<Value>()) {
+      replacements.push_back(value);
+      continue;
+    }
+    auto *constant = op->getDialect()->materializeConstant(
+        builder, foldResult.get<Attribute>(), result.getType(), op->getLoc());
+    if (!constant) {
+      for (auto *newConstant : newConstants)
+        newConstant->erase();
+      return failure();
+    }
+    newConstants.push_back(constant);
+    replacements.push_back(constant->getResult(0));
+  }
+
+  ++numFolded;
+  replaceAllUsesWith(op, replacements);
+
+  // Deduplicate the new constants with the ones seen before.
+  for (auto *newConstant : newConstants)
+    if (isSimplifiableExpression(newConstant))
+      simplifyOperation(newConstant, revisit);
+  return success();
+}
+
+void SimplifyPass::simplifyOperation(Operation *op, bool revisit) {
+  if (succeeded(foldOperation(op, revisit)))
+    return;
+
+  // Replace the operation with an identical one seen before, if any.  When an
+  // operation is simplified again, the identical one may also come after it,
+  // in which case that one is replaced instead.
+  auto [it, inserted] = knownExpressions.insert(op);
+  if (inserted) {
+    scopes.back().push_back(op);
+    return;
+  }
+  auto *existing = *it;
+  if (existing == op)
+    return;
+  if (revisit && !properlyDominates(existing, op)) {
+    if (!properlyDominates(op, existing))
+      return;
+    knownExpressions.erase(it);
+    ++numDeduplicated;
+    replaceAllUsesWith(existing, op->getResults());
+    knownExpressions.insert(op);
+    scopes.back().push_back(op);
+    return;
+  }
+  ++numDeduplicated;
+  replaceAllUsesWith(op, existing->getResults());
+}
+
+/// Replace a node with its input.
+void SimplifyPass::forwardNode(NodeOp node) {
+  if (!isRemovableDecl(node))
+    return;
+  ++numForwarded;
+  replaceAllUsesWith(node, node.getInput());
+}
+
+/// Replace a wire that is only driven by a single strict connect with the
+/// connected value, if that value is available at every use of the wire.
+void SimplifyPass::forwardWire(StrictConnectOp connect) {
+  auto wire = connect.getDest().getDefiningOp<WireOp>();
+  if (!wire || wire->getBlock() != connect->getBlock())
+    return;
+  if (!isRemovableDecl(wire))
+    return;
+  auto type = wire.getResult().getType().dyn_cast<FIRRTLBaseType>();
+  auto src = connect.getSrc();
+  if (!type || !type.isGround() || src.getType() != wire.getResult().getType())
+    return;
+  if (getSingleConnectUserOf(wire.getResult()) != connect)
+    return;
+
+  // The connected value has to be defined before every read of the wire.
+  if (auto *srcOp = src.getDefiningOp()) {
+    if (srcOp == wire)
+      return;
+    for (auto *user : wire->getUsers())
+      if (user != connect && !properlyDominates(srcOp, user))
+        return;
+  }
+
+  ++numForwarded;
+  connect.erase();
+  replaceAllUsesWith(wire, src);
+}
+
+/// Erase the operations that have been replaced, along with any operands that
+/// become unused as a result.
+void SimplifyPass::eraseDeadOperations() {
+  // An operation may be added to the worklist several times, so remember which
+  // ones have been erased already.
+  SmallPtrSet<Operation *, 32> erased;
+  while (!maybeDead.empty()) {
+    auto *op = maybeDead.pop_back_val();
+    if (erased.contains(op) || !op->use_empty())
+      continue;
+    auto node = dyn_cast<NodeOp>(op);
+    auto wire = dyn_cast<WireOp>(op);
+    if (!isSimplifiableExpression(op) && !(node && isRemovableDecl(node)) &&
+        !(wire && isRemovableDecl(wire)))
+      continue;
+    for (auto operand : op->getOperands())
+      if (auto *defOp = operand.getDefiningOp())
+        if (defOp != op)
+          maybeDead.push_back(defOp);
+    erased.insert(op);
+    op->erase();
+    ++numErased;
+  }
+}
+
+void SimplifyPass::runOnOperation() {
+  simplifyBlock(*getOperation().getBodyBlock());
+  eraseDeadOperations();
+  knownExpressions.clear();
+  assert(scopes.empty() && worklist.empty());
+}
+
+std::unique_ptr<mlir::Pass> circt::firrtl::createSimplifyPass() {
+  return std::make_unique<SimplifyPass>();
+}
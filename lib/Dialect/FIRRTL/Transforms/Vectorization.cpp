@@ -9,6 +9,11 @@
 // vector_create (or a[0], b[0]), (or a[1], b[1]), (or a[2], b[2])
 // => elementwise_or a, b
 //
+// Muxes with a common select are vectorized into a single mux of vectors. The
+// `vector_create`s of the operands are vectorized in turn, such that whole
+// expression trees over the elements of vectors collapse into vector
+// operations.
+//
 //===----------------------------------------------------------------------===//
 
 #include "PassDetails.h"
@@ -33,6 +38,21 @@ namespace {
 
 namespace {
 
+/// Collect the operations defining the operands of a `vector_create`. Returns
+/// false if any operand is not defined by an `OpTy`.
+template <typename OpTy>
+bool getOperandOps(VectorCreateOp op, SmallVectorImpl<OpTy> &ops) {
+  if (op->getNumOperands() == 0)
+    return false;
+  for (auto operand : op->getOperands()) {
+    auto operandOp = operand.getDefiningOp<OpTy>();
+    if (!operandOp)
+      return false;
+    ops.push_back(operandOp);
+  }
+  return true;
+}
+
 template <typename OpTy, typename ResultOpType>
 class VectorCreateToLogicElementwise : public mlir::RewritePattern {
 public:
@@ -47,26 +67,69 @@ public:
     if (type.hasUninferredWidth() || !isa<UIntType>(type.getElementType()))
       return failure();
 
+    // Vectorize if all operands are `OpTy` over operands of the element type.
+    // The elementwise operations are lowered bitwise on the whole vectors, so
+    // the operands must not be extended. Currently there is no other
+    // condition so it could be too aggressive.
+    SmallVector<OpTy> ops;
+    if (!getOperandOps(vectorCreateOp, ops))
+      return failure();
     SmallVector<Value> lhs, rhs;
+    for (auto operandOp : ops) {
+      if (operandOp.getLhs().getType() != type.getElementType() ||
+          operandOp.getRhs().getType() != type.getElementType())
+        return failure();
+      lhs.push_back(operandOp.getLhs());
+      rhs.push_back(operandOp.getRhs());
+    }
 
-    // Vectorize if all operands are `OpTy`. Currently there is no other
-    // condition so it could be too aggressive.
-    if (llvm::all_of(op->getOperands(), [&](Value operand) {
-          auto op = operand.getDefiningOp<OpTy>();
-          if (!op)
-            return false;
-          lhs.push_back(op.getLhs());
-          rhs.push_back(op.getRhs());
-          return true;
-        })) {
-      auto lhsVec = rewriter.createOrFold<VectorCreateOp>(
-          op->getLoc(), vectorCreateOp.getType(), lhs);
-      auto rhsVec = rewriter.createOrFold<VectorCreateOp>(
-          op->getLoc(), vectorCreateOp.getType(), rhs);
-      rewriter.replaceOpWithNewOp<ResultOpType>(op, lhsVec, rhsVec);
-      return success();
+    auto lhsVec =
+        rewriter.createOrFold<VectorCreateOp>(op->getLoc(), type, lhs);
+    auto rhsVec =
+        rewriter.createOrFold<VectorCreateOp>(op->getLoc(), type, rhs);
+    rewriter.replaceOpWithNewOp<ResultOpType>(op, lhsVec, rhsVec);
+    return success();
+  }
+};
+
+/// Vectorize a `vector_create` of muxes with the same select into a mux of
+/// `vector_create`s, e.g:
+/// vector_create (mux s, a[0], b[0]), (mux s, a[1], b[1]) => mux s, a, b
+class VectorCreateToMux : public mlir::RewritePattern {
+public:
+  VectorCreateToMux(MLIRContext *context)
+      : RewritePattern(VectorCreateOp::getOperationName(), 0, context) {}
+
+  LogicalResult
+  matchAndRewrite(Operation *op,
+                  mlir::PatternRewriter &rewriter) const override {
+    auto vectorCreateOp = cast<VectorCreateOp>(op);
+    auto type = vectorCreateOp.getType();
+    if (type.hasUninferredWidth())
+      return failure();
+
+    // All muxes have to share the select, and mux values of the element type
+    // such that the mux of the vectors doesn't have to extend them.
+    SmallVector<MuxPrimOp> muxes;
+    if (!getOperandOps(vectorCreateOp, muxes))
+      return failure();
+    Value sel = muxes.front().getSel();
+    SmallVector<Value> high, low;
+    for (auto mux : muxes) {
+      if (mux.getSel() != sel ||
+          mux.getHigh().getType() != type.getElementType() ||
+          mux.getLow().getType() != type.getElementType())
+        return failure();
+      high.push_back(mux.getHigh());
+      low.push_back(mux.getLow());
     }
-    return failure();
+
+    auto highVec =
+        rewriter.createOrFold<VectorCreateOp>(op->getLoc(), type, high);
+    auto lowVec =
+        rewriter.createOrFold<VectorCreateOp>(op->getLoc(), type, low);
+    rewriter.replaceOpWithNewOp<MuxPrimOp>(op, type, sel, highVec, lowVec);
+    return success();
   }
 };
 } // namespace
@@ -87,8 +150,8 @@ void VectorizationPass::runOnOperation() {
   patterns
       .insert<VectorCreateToLogicElementwise<OrPrimOp, ElementwiseOrPrimOp>,
               VectorCreateToLogicElementwise<AndPrimOp, ElementwiseAndPrimOp>,
-              VectorCreateToLogicElementwise<XorPrimOp, ElementwiseXorPrimOp>>(
-          &getContext());
+              VectorCreateToLogicElementwise<XorPrimOp, ElementwiseXorPrimOp>,
+              VectorCreateToMux>(&getContext());
   mlir::FrozenRewritePatternSet frozenPatterns(std::move(patterns));
   (void)applyPatternsAndFoldGreedily(getOperation(), frozenPatterns);
 }
@@ -0,0 +1,455 @@
+//===- FSMSimulator.cpp - FSM machine simulator ---------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "circt/Dialect/FSM/FSMSimulator.h"
+#include "circt/Dialect/HW/HWOps.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "llvm/ADT/TypeSwitch.h"
+
+using namespace mlir;
+using namespace circt;
+using namespace fsm;
+using detail::SimInstruction;
+using detail::SimProgram;
+
+//===----------------------------------------------------------------------===//
+// Compilation
+//===----------------------------------------------------------------------===//
+
+namespace circt {
+namespace fsm {
+/// Assigns registers to the values of a machine and translates its regions
+/// into instruction lists.
+class FSMSimulatorCompiler {
+public:
+  FSMSimulatorCompiler(FSMSimulator &sim) : sim(sim) {}
+
+  LogicalResult compile(MachineOp machine);
+
+private:
+  /// Compile the operations of a block up to its terminator. `updates`
+  /// collects the variable updates of transition actions.
+  LogicalResult
+  compileBlock(Block &block, SimProgram &program,
+               SmallVectorImpl<std::pair<unsigned, unsigned>> *updates);
+  LogicalResult compileOp(Operation *op, SimProgram &program);
+
+  /// Allocate a register for a value, which must be of integer type.
+  FailureOr<unsigned> addRegister(Value value, Location loc);
+
+  /// Return the register of a value defined earlier.
+  unsigned lookup(Value value) { return registers.lookup(value); }
+
+  FSMSimulator &sim;
+  DenseMap<Value, unsigned> registers;
+};
+} // namespace fsm
+} // namespace circt
+
+FailureOr<unsigned> FSMSimulatorCompiler::addRegister(Value value,
+                                                      Location loc) {
+  auto type = value.getType().dyn_cast<IntegerType>();
+  if (!type)
+    return mlir::emitError(loc) << "value of type " << value.getType()
+                                << " is not supported by the simulator";
+  unsigned reg = sim.registers.size();
+  sim.registers.push_back(APInt(type.getWidth(), 0));
+  registers[value] = reg;
+  return reg;
+}
+
+LogicalResult FSMSimulatorCompiler::compile(MachineOp machine) {
+  // Machine inputs occupy the first registers.
+  for (auto arg : machine.getArguments()) {
+    auto reg = addRegister(arg, machine.getLoc());
+    if (failed(reg))
+      return failure();
+    sim.inputWidths.push_back(arg.getType().getIntOrFloatBitWidth());
+  }
+  for (auto type : machine.getResultTypes()) {
+    auto intType = type.dyn_cast<IntegerType>();
+    if (!intType)
+      return machine.emitOpError()
+             << "output of type " << type
+             << " is not supported by the simulator";
+    sim.outputs.push_back(APInt(intType.getWidth(), 0));
+  }
+
+  // Variables and the other operations in the machine body are shared by all
+  // states. The states are numbered before their regions are compiled, such
+  // that transitions can refer to later states.
+  DenseMap<StateOp, unsigned> stateIndices;
+  for (auto &op : machine.getBody().front()) {
+    if (auto stateOp = dyn_cast<StateOp>(op)) {
+      stateIndices[stateOp] = sim.states.size();
+      sim.states.emplace_back().name = stateOp.getSymName().str();
+      continue;
+    }
+    if (auto variableOp = dyn_cast<VariableOp>(op)) {
+      auto reg = addRegister(variableOp, variableOp.getLoc());
+      if (failed(reg))
+        return failure();
+      auto initValue = variableOp.getInitValue().dyn_cast<IntegerAttr>();
+      if (!initValue)
+        return variableOp.emitOpError()
+               << "initial value is not supported by the simulator";
+      sim.initialValues.push_back({*reg, initValue.getValue()});
+      continue;
+    }
+    if (failed(compileOp(&op, sim.body)))
+      return failure();
+  }
+  sim.initialState = stateIndices.lookup(machine.getInitialStateOp());
+
+  for (auto stateOp : machine.getBody().getOps<StateOp>()) {
+    auto &state = sim.states[stateIndices.lookup(stateOp)];
+    if (!stateOp.getOutput().empty()) {
+      if (failed(compileBlock(stateOp.getOutput().front(), state.output,
+                              nullptr)))
+        return failure();
+      for (auto output : stateOp.getOutputOp().getOperands())
+        state.outputResults.push_back(lookup(output));
+    }
+
+    for (auto transitionOp :
+         stateOp.getTransitions().getOps<TransitionOp>()) {
+      auto &transition = state.transitions.emplace_back();
+      transition.nextState = stateIndices.lookup(transitionOp.getNextStateOp());
+      if (transitionOp.hasGuard()) {
+        auto &guard = transitionOp.getGuard().front();
+        if (failed(compileBlock(guard, transition.guard, nullptr)))
+          return failure();
+        auto returnOp = transitionOp.getGuardReturn();
+        if (returnOp.getNumOperands() != 0)
+          transition.guardResult = lookup(returnOp.getOperand());
+      }
+      if (transitionOp.hasAction())
+        if (failed(compileBlock(transitionOp.getAction().front(),
+                                transition.action, &transition.updates)))
+          return failure();
+    }
+  }
+  return success();
+}
+
+LogicalResult FSMSimulatorCompiler::compileBlock(
+    Block &block, SimProgram &program,
+    SmallVectorImpl<std::pair<unsigned, unsigned>> *updates) {
+  for (auto &op : block) {
+    if (op.hasTrait<OpTrait::IsTerminator>())
+      break;
+    if (auto updateOp = dyn_cast<UpdateOp>(op)) {
+      if (!updates)
+        return updateOp.emitOpError("is only supported in transition actions");
+      updates->push_back(
+          {lookup(updateOp.getVariable()), lookup(updateOp.getValue())});
+      continue;
+    }
+    if (failed(compileOp(&op, program)))
+      return failure();
+  }
+  return success();
+}
+
+/// Map an `arith.cmpi` predicate to the equivalent `comb.icmp` predicate.
+static comb::ICmpPredicate convertPredicate(arith::CmpIPredicate predicate) {
+  switch (predicate) {
+  case arith::CmpIPredicate::eq:
+    return comb::ICmpPredicate::eq;
+  case arith::CmpIPredicate::ne:
+    return comb::ICmpPredicate::ne;
+  case arith::CmpIPredicate::slt:
+    return comb::ICmpPredicate::slt;
+  case arith::CmpIPredicate::sle:
+    return comb::ICmpPredicate::sle;
+  case arith::CmpIPredicate::sgt:
+    return comb::ICmpPredicate::sgt;
+  case arith::CmpIPredicate::sge:
+    return comb::ICmpPredicate::sge;
+  case arith::CmpIPredicate::ult:
+    return comb::ICmpPredicate::ult;
+  case arith::CmpIPredicate::ule:
+    return comb::ICmpPredicate::ule;
+  case arith::CmpIPredicate::ugt:
+    return comb::ICmpPredicate::ugt;
+  case arith::CmpIPredicate::uge:
+    return comb::ICmpPredicate::uge;
+  }
+  llvm_unreachable("unknown cmpi predicate");
+}
+
+LogicalResult FSMSimulatorCompiler::compileOp(Operation *op,
+                                              SimProgram &program) {
+  // Constants are written into their register once and never change.
+  if (auto constOp = dyn_cast<hw::ConstantOp>(op)) {
+    auto reg = addRegister(constOp, constOp.getLoc());
+    if (failed(reg))
+      return failure();
+    sim.registers[*reg] = constOp.getValue();
+    return success();
+  }
+  if (auto constOp = dyn_cast<arith::ConstantOp>(op)) {
+    auto value = constOp.getValue().dyn_cast<IntegerAttr>();
+    if (!value)
+      return constOp.emitOpError("is not supported by the simulator");
+    auto reg = addRegister(constOp, constOp.getLoc());
+    if (failed(reg))
+      return failure();
+    sim.registers[*reg] = value.getValue();
+    return success();
+  }
+
+  auto kind =
+      TypeSwitch<Operation *, std::optional<SimInstruction::Kind>>(op)
+          .Case<comb::AddOp, arith::AddIOp>(
+              [](auto) { return SimInstruction::Add; })
+          .Case<comb::SubOp, arith::SubIOp>(
+              [](auto) { return SimInstruction::Sub; })
+          .Case<comb::MulOp, arith::MulIOp>(
+              [](auto) { return SimInstruction::Mul; })
+          .Case<comb::DivUOp>([](auto) { return SimInstruction::DivU; })
+          .Case<comb::DivSOp>([](auto) { return SimInstruction::DivS; })
+          .Case<comb::ModUOp>([](auto) { return SimInstruction::ModU; })
+          .Case<comb::ModSOp>([](auto) { return SimInstruction::ModS; })
+          .Case<comb::ShlOp>([](auto) { return SimInstruction::Shl; })
+          .Case<comb::ShrUOp>([](auto) { return SimInstruction::ShrU; })
+          .Case<comb::ShrSOp>([](auto) { return SimInstruction::ShrS; })
+          .Case<comb::AndOp, arith::AndIOp>(
+              [](auto) { return SimInstruction::And; })
+          .Case<comb::OrOp, arith::OrIOp>(
+              [](auto) { return SimInstruction::Or; })
+          .Case<comb::XorOp, arith::XOrIOp>(
+              [](auto) { return SimInstruction::Xor; })
+          .Case<comb::ICmpOp, arith::CmpIOp>(
+              [](auto) { return SimInstruction::ICmp; })
+          .Case<comb::MuxOp, arith::SelectOp>(
+              [](auto) { return SimInstruction::Mux; })
+          .Case<comb::ConcatOp>([](auto) { return SimInstruction::Concat; })
+          .Case<comb::ExtractOp>([](auto) { return SimInstruction::Extract; })
+          .Case<comb::ReplicateOp>(
+              [](auto) { return SimInstruction::Replicate; })
+          .Case<comb::ParityOp>([](auto) { return SimInstruction::Parity; })
+          .Default([](auto) { return std::nullopt; });
+  if (!kind || op->getNumResults() != 1)
+    return op->emitOpError("is not supported by the simulator");
+
+  auto result = addRegister(op->getResult(0), op->getLoc());
+  if (failed(result))
+    return failure();
+  SimInstruction inst;
+  inst.kind = *kind;
+  inst.result = *result;
+  inst.width = op->getResult(0).getType().getIntOrFloatBitWidth();
+  for (auto operand : op->getOperands())
+    inst.operands.push_back(lookup(operand));
+  if (auto icmpOp = dyn_cast<comb::ICmpOp>(op))
+    inst.predicate = icmpOp.getPredicate();
+  if (auto cmpOp = dyn_cast<arith::CmpIOp>(op))
+    inst.predicate = convertPredicate(cmpOp.getPredicate());
+  if (auto extractOp = dyn_cast<comb::ExtractOp>(op))
+    inst.lowBit = extractOp.getLowBit();
+  program.push_back(std::move(inst));
+  return success();
+}
+
+FailureOr<std::unique_ptr<FSMSimulator>>
+FSMSimulator::create(MachineOp machine) {
+  std::unique_ptr<FSMSimulator> sim(new FSMSimulator());
+  if (failed(FSMSimulatorCompiler(*sim).compile(machine)))
+    return failure();
+  sim->reset();
+  return sim;
+}
+
+//===----------------------------------------------------------------------===//
+// Simulation
+//===----------------------------------------------------------------------===//
+
+void FSMSimulator::reset() {
+  currentState = initialState;
+  for (auto &[reg, value] : initialValues)
+    registers[reg] = value;
+}
+
+static bool evaluatePredicate(comb::ICmpPredicate predicate, const APInt &lhs,
+                              const APInt &rhs) {
+  switch (predicate) {
+  case comb::ICmpPredicate::eq:
+  case comb::ICmpPredicate::ceq:
+  case comb::ICmpPredicate::weq:
+    return lhs.eq(rhs);
+  case comb::ICmpPredicate::ne:
+  case comb::ICmpPredicate::cne:
+  case comb::ICmpPredicate::wne:
+    return lhs.ne(rhs);
+  case comb::ICmpPredicate::slt:
+    return lhs.slt(rhs);
+  case comb::ICmpPredicate::sle:
+    return lhs.sle(rhs);
+  case comb::ICmpPredicate::sgt:
+    return lhs.sgt(rhs);
+  case comb::ICmpPredicate::sge:
+    return lhs.sge(rhs);
+  case comb::ICmpPredicate::ult:
+    return lhs.ult(rhs);
+  case comb::ICmpPredicate::ule:
+    return lhs.ule(rhs);
+  case comb::ICmpPredicate::ugt:
+    return lhs.ugt(rhs);
+  case comb::ICmpPredicate::uge:
+    return lhs.uge(rhs);
+  }
+  llvm_unreachable("unknown icmp predicate");
+}
+
+void FSMSimulator::run(const SimProgram &program) {
+  for (auto &inst : program) {
+    APInt &result = registers[inst.result];
+    auto operand = [&](unsigned i) -> const APInt & {
+      return registers[inst.operands[i]];
+    };
+    unsigned numOperands = inst.operands.size();
+
+    switch (inst.kind) {
+    case SimInstruction::Add:
+      result = operand(0);
+      for (unsigned i = 1; i < numOperands; ++i)
+        result += operand(i);
+      break;
+    case SimInstruction::Sub:
+      result = operand(0) - operand(1);
+      break;
+    case SimInstruction::Mul:
+      result = operand(0);
+      for (unsigned i = 1; i < numOperands; ++i)
+        result *= operand(i);
+      break;
+    // Division by zero is undefined; the simulator produces zero.
+    case SimInstruction::DivU:
+      result = operand(1).isZero() ? APInt(inst.width, 0)
+                                   : operand(0).udiv(operand(1));
+      break;
+    case SimInstruction::DivS:
+      result = operand(1).isZero() ? APInt(inst.width, 0)
+                                   : operand(0).sdiv(operand(1));
+      break;
+    case SimInstruction::ModU:
+      result = operand(1).isZero() ? APInt(inst.width, 0)
+                                   : operand(0).urem(operand(1));
+      break;
+    case SimInstruction::ModS:
+      result = operand(1).isZero() ? APInt(inst.width, 0)
+                                   : operand(0).srem(operand(1));
+      break;
+    case SimInstruction::Shl:
+      result = operand(0).shl(operand(1));
+      break;
+    case SimInstruction::ShrU:
+      result = operand(0).lshr(operand(1));
+      break;
+    case SimInstruction::ShrS:
+      result = operand(0).ashr(operand(1));
+      break;
+    case SimInstruction::And:
+      result = operand(0);
+      for (unsigned i = 1; i < numOperands; ++i)
+        result &= operand(i);
+      break;
+    case SimInstruction::Or:
+      result = operand(0);
+      for (unsigned i = 1; i < numOperands; ++i)
+        result |= operand(i);
+      break;
+    case SimInstruction::Xor:
+      result = operand(0);
+      for (unsigned i = 1; i < numOperands; ++i)
+        result ^= operand(i);
+      break;
+    case SimInstruction::ICmp:
+      result = APInt(1, evaluatePredicate(inst.predicate, operand(0),
+                                          operand(1)));
+      break;
+    case SimInstruction::Mux:
+      result = operand(0).getBoolValue() ? operand(1) : operand(2);
+      break;
+    case SimInstruction::Concat:
+      // The first operand holds the most significant bits.
+      result = operand(0);
+      for (unsigned i = 1; i < numOperands; ++i)
+        result = result.concat(operand(i));
+      break;
+    case SimInstruction::Extract:
+      result = operand(0).extractBits(inst.width, inst.lowBit);
+      break;
+    case SimInstruction::Replicate:
+      result = APInt::getSplat(inst.width, operand(0));
+      break;
+    case SimInstruction::Parity:
+      result = APInt(1, operand(0).popcount() & 1);
+      break;
+    }
+  }
+}
+
+void FSMSimulator::step(ArrayRef<APInt> inputs) {
+  assert(inputs.size() == inputWidths.size() && "wrong number of inputs");
+  for (auto [reg, input] : llvm::enumerate(inputs))
+    registers[reg] = input;
+  run(body);
+
+  auto &state = states[currentState];
+  ++state.hits;
+  ++numSteps;
+  run(state.output);
+  for (auto [output, reg] : llvm::zip(outputs, state.outputResults))
+    output = registers[reg];
+
+  for (auto &transition : state.transitions) {
+    if (transition.guardResult) {
+      run(transition.guard);
+      if (registers[*transition.guardResult].isZero())
+        continue;
+    }
+
+    // All updates observe the variable values from before the transition.
+    run(transition.action);
+    updateValues.clear();
+    for (auto &update : transition.updates)
+      updateValues.push_back(registers[update.second]);
+    for (auto [update, value] : llvm::zip(transition.updates, updateValues))
+      registers[update.first] = value;
+
+    ++transition.hits;
+    currentState = transition.nextState;
+    return;
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// Coverage
+//===----------------------------------------------------------------------===//
+
+void FSMSimulator::printCoverage(llvm::raw_ostream &os) const {
+  unsigned numStatesHit = 0, numTransitions = 0, numTransitionsHit = 0;
+  for (auto &state : states) {
+    os << "state " << state.name << ": " << state.hits << "\n";
+    if (state.hits)
+      ++numStatesHit;
+    for (auto [index, transition] : llvm::enumerate(state.transitions)) {
+      os << "  transition " << index << " to "
+         << states[transition.nextState].name << ": " << transition.hits
+         << "\n";
+      ++numTransitions;
+      if (transition.hits)
+        ++numTransitionsHit;
+    }
+  }
+  os << "states covered: " << numStatesHit << "/" << states.size() << "\n";
+  os << "transitions covered: " << numTransitionsHit << "/" << numTransitions
+     << "\n";
+}
@@ -260,11 +260,16 @@ InnerSymAttr hw::getResultSym(Operation *op, unsigned i) {
 HWModulePortAccessor::HWModulePortAccessor(Location loc,
                                            const ModulePortInfo &info,
                                            Region &bodyRegion)
+    : HWModulePortAccessor(loc, info, bodyRegion.getArguments()) {}
+
+HWModulePortAccessor::HWModulePortAccessor(Location loc,
+                                           const ModulePortInfo &info,
+                                           ValueRange inputs)
     : info(info) {
   inputArgs.resize(info.inputs.size());
-  for (auto [i, barg] : llvm::enumerate(bodyRegion.getArguments())) {
+  for (auto [i, input] : llvm::enumerate(inputs)) {
     inputIdx[info.inputs[i].name.str()] = i;
-    inputArgs[i] = barg;
+    inputArgs[i] = input;
   }
 
   outputOperands.resize(info.outputs.size());
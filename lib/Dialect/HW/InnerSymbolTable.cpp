@@ -160,10 +160,14 @@ StringAttr InnerSymbolTable::getInnerSymbol(const InnerSymTarget &target) {
 
 InnerSymbolTable &
 InnerSymbolTableCollection::getInnerSymbolTable(Operation *op) {
-  auto it = symbolTables.try_emplace(op, nullptr);
-  if (it.second)
-    it.first->second = ::std::make_unique<InnerSymbolTable>(op);
-  return *it.first->second;
+  // Avoid touching the map if the table exists, which keeps lookups free of
+  // side effects once the tables have been populated.
+  auto it = symbolTables.find(op);
+  if (it != symbolTables.end() && it->second)
+    return *it->second;
+  auto &table = symbolTables[op];
+  table = ::std::make_unique<InnerSymbolTable>(op);
+  return *table;
 }
 
 LogicalResult
@@ -8,6 +8,8 @@
 
 #include "circt/Dialect/HW/InstanceGraphBase.h"
 #include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/Threading.h"
+#include <limits>
 
 using namespace circt;
 using namespace hw;
@@ -51,18 +53,35 @@ InstanceGraphNode *InstanceGraphBase::getOrAddNode(StringAttr name) {
 }
 
 InstanceGraphBase::InstanceGraphBase(Operation *parent) : parent(parent) {
-  parent->walk([&](HWModuleLike module) {
-    auto name = module.getModuleNameAttr();
-    auto *currentNode = getOrAddNode(name);
-    currentNode->module = module;
+  SmallVector<HWModuleLike, 0> modules;
+  parent->walk<mlir::WalkOrder::PreOrder>([&](Operation *op) {
+    if (auto module = dyn_cast<HWModuleLike>(op)) {
+      modules.push_back(module);
+      return WalkResult::skip();
+    }
+    return WalkResult::advance();
+  });
+
+  // Find all instance operations in the module bodies in parallel.
+  SmallVector<SmallVector<HWInstanceLike, 0>, 0> moduleInstances(
+      modules.size());
+  mlir::parallelFor(parent->getContext(), 0, modules.size(), [&](size_t i) {
+    modules[i].walk([&](HWInstanceLike instanceOp) {
+      moduleInstances[i].push_back(instanceOp);
+    });
+  });
 
-    // Find all instance operations in the module body.
-    module.walk([&](HWInstanceLike instanceOp) {
+  // Link up the graph serially, in the order of the IR, such that the order of
+  // the nodes is deterministic.
+  for (auto [module, instances] : llvm::zip(modules, moduleInstances)) {
+    auto *currentNode = getOrAddNode(module.getModuleNameAttr());
+    currentNode->module = module;
+    for (auto instanceOp : instances) {
       // Add an edge to indicate that this module instantiates the target.
       auto *targetNode = getOrAddNode(instanceOp.getReferencedModuleNameAttr());
       currentNode->addInstance(instanceOp, targetNode);
-    });
-  });
+    }
+  }
 }
 
 InstanceGraphNode *InstanceGraphBase::addModule(HWModuleLike module) {
@@ -71,17 +90,61 @@ InstanceGraphNode *InstanceGraphBase::addModule(HWModuleLike module) {
   node->module = module;
   nodeMap[module.getModuleNameAttr()] = node;
   nodes.push_back(node);
+  inferredTopLevelNodes.clear();
+  for (auto *listener : listeners)
+    listener->notifyModuleAdded(node);
   return node;
 }
 
 void InstanceGraphBase::erase(InstanceGraphNode *node) {
   assert(node->noUses() &&
          "all instances of this module must have been erased.");
+  for (auto *listener : listeners)
+    listener->notifyModuleErased(node);
   // Erase all instances inside this module.
-  for (auto *instance : llvm::make_early_inc_range(*node))
+  for (auto *instance : llvm::make_early_inc_range(*node)) {
+    for (auto *listener : listeners)
+      listener->notifyInstanceErased(instance);
     instance->erase();
+  }
   nodeMap.erase(node->getModule().getModuleNameAttr());
   nodes.erase(node);
+  inferredTopLevelNodes.clear();
+}
+
+/// Find the record of an instance op in the use list of the module it
+/// instantiates.
+static InstanceRecord *findInstanceRecord(InstanceGraphNode *target,
+                                          HWInstanceLike inst) {
+  auto it = llvm::find_if(target->uses(), [&](InstanceRecord *record) {
+    return record->getInstance() == inst;
+  });
+  assert(it != target->usesEnd() && "Instance of module not recorded in graph");
+  return *it;
+}
+
+InstanceRecord *InstanceGraphBase::addInstance(HWInstanceLike instance) {
+  auto parentModule = instance->getParentOfType<HWModuleLike>();
+  assert(parentModule && "instance must be nested in a module");
+  auto *parentNode = lookup(parentModule);
+  auto *targetNode = lookup(instance.getReferencedModuleNameAttr());
+  auto *record = parentNode->addInstance(instance, targetNode);
+  inferredTopLevelNodes.clear();
+  for (auto *listener : listeners)
+    listener->notifyInstanceAdded(record);
+  return record;
+}
+
+void InstanceGraphBase::eraseInstance(HWInstanceLike instance) {
+  eraseInstance(findInstanceRecord(
+      lookup(instance.getReferencedModuleNameAttr()), instance));
+}
+
+void InstanceGraphBase::eraseInstance(InstanceRecord *record) {
+  for (auto *listener : listeners)
+    listener->notifyInstanceErased(record);
+  record->erase();
+  inferredTopLevelNodes.clear();
 }
 
 InstanceGraphNode *InstanceGraphBase::lookup(StringAttr name) {
@@ -100,21 +163,22 @@ HWModuleLike InstanceGraphBase::getReferencedModule(HWInstanceLike op) {
 
 InstanceGraphBase::~InstanceGraphBase() {}
 
+InstanceGraphListener::~InstanceGraphListener() = default;
+
 void InstanceGraphBase::replaceInstance(HWInstanceLike inst,
                                         HWInstanceLike newInst) {
   assert(inst.getReferencedModuleName() == newInst.getReferencedModuleName() &&
          "Both instances must be targeting the same module");
 
   // Find the instance record of this instance.
-  auto *node = lookup(inst.getReferencedModuleNameAttr());
-  auto it = llvm::find_if(node->uses(), [&](InstanceRecord *record) {
-    return record->getInstance() == inst;
-  });
-  assert(it != node->usesEnd() && "Instance of module not recorded in graph");
+  auto *record =
+      findInstanceRecord(lookup(inst.getReferencedModuleNameAttr()), inst);
 
   // We can just replace the instance op in the InstanceRecord without updating
   // any instance lists.
-  (*it)->instance = newInst;
+  record->instance = newInst;
+  for (auto *listener : listeners)
+    listener->notifyInstanceReplaced(record, inst);
 }
 
 bool InstanceGraphBase::isAncestor(HWModuleLike child, HWModuleLike parent) {
@@ -202,59 +266,108 @@ InstanceGraphBase::getInferredTopLevelNodes() {
   return {inferredTopLevelNodes};
 }
 
-ArrayRef<InstancePath> InstancePathCache::getAbsolutePaths(HWModuleLike op) {
+ArrayRef<InstancePathID>
+InstancePathCache::getAbsolutePathIDs(HWModuleLike op) {
   InstanceGraphNode *node = instanceGraph[op];
 
   // If we have reached the circuit root, we're done.
   if (node == instanceGraph.getTopLevelNode()) {
-    static InstancePath empty{};
+    static const InstancePathID empty = 0;
     return empty; // array with single empty path
   }
 
   // Fast path: hit the cache.
-  auto cached = absolutePathsCache.find(op);
-  if (cached != absolutePathsCache.end())
+  auto cached = absolutePathIDsCache.find(op);
+  if (cached != absolutePathIDsCache.end())
     return cached->second;
+  assert(!frozen && "all paths of a frozen cache must already be computed");
 
   // For each instance, collect the instance paths to its parent and append the
   // instance itself to each.
-  SmallVector<InstancePath, 8> extendedPaths;
+  SmallVector<InstancePathID, 8> extendedPaths;
   for (auto *inst : node->uses()) {
     if (auto module = inst->getParent()->getModule()) {
-      auto instPaths = getAbsolutePaths(module);
-      extendedPaths.reserve(instPaths.size());
-      for (auto path : instPaths) {
-        extendedPaths.push_back(
-            appendInstance(path, cast<HWInstanceLike>(*inst->getInstance())));
-      }
+      auto instPaths = getAbsolutePathIDs(module);
+      extendedPaths.reserve(extendedPaths.size() + instPaths.size());
+      for (auto path : instPaths)
+        extendedPaths.push_back(appendInstance(path, inst->getInstance()));
     }
   }
 
   // Move the list of paths into the bump allocator for later quick retrieval.
-  ArrayRef<InstancePath> pathList;
+  ArrayRef<InstancePathID> pathList;
   if (!extendedPaths.empty()) {
-    auto *paths = allocator.Allocate<InstancePath>(extendedPaths.size());
-    std::copy(extendedPaths.begin(), extendedPaths.end(), paths);
-    pathList = ArrayRef<InstancePath>(paths, extendedPaths.size());
+    auto *paths = allocator.Allocate<InstancePathID>(extendedPaths.size());
+    llvm::copy(extendedPaths, paths);
+    pathList = ArrayRef<InstancePathID>(paths, extendedPaths.size());
+  }
+  absolutePathIDsCache.insert({op, pathList});
+  return pathList;
+}
+
+ArrayRef<InstancePath> InstancePathCache::getAbsolutePaths(HWModuleLike op) {
+  assert(!frozen && "cannot materialize the paths of a frozen cache");
+
+  // Fast path: hit the cache.
+  auto cached = absolutePathsCache.find(op);
+  if (cached != absolutePathsCache.end())
+    return cached->second;
+
+  // Materialize each path into the bump allocator.
+  auto pathIDs = getAbsolutePathIDs(op);
+  ArrayRef<InstancePath> pathList;
+  if (!pathIDs.empty()) {
+    auto *paths = allocator.Allocate<InstancePath>(pathIDs.size());
+    for (size_t i = 0, e = pathIDs.size(); i != e; ++i) {
+      auto pathID = pathIDs[i];
+      unsigned size = getPathSize(pathID);
+      auto *path = allocator.Allocate<HWInstanceLike>(size);
+      for (unsigned j = size; j > 0; --j, pathID = getParentPath(pathID))
+        path[j - 1] = getLeafInstance(pathID);
+      paths[i] = InstancePath(path, size);
+    }
+    pathList = ArrayRef<InstancePath>(paths, pathIDs.size());
   }
   absolutePathsCache.insert({op, pathList});
   return pathList;
 }
 
-InstancePath InstancePathCache::appendInstance(InstancePath path,
-                                               HWInstanceLike inst) {
-  size_t n = path.size() + 1;
-  auto *newPath = allocator.Allocate<HWInstanceLike>(n);
-  std::copy(path.begin(), path.end(), newPath);
-  newPath[path.size()] = inst;
-  return InstancePath(newPath, n);
+void InstancePathCache::getPath(
+    InstancePathID path, SmallVectorImpl<HWInstanceLike> &instances) const {
+  unsigned size = getPathSize(path);
+  auto begin = instances.size();
+  instances.resize(begin + size);
+  for (unsigned i = size; i > 0; --i, path = getParentPath(path))
+    instances[begin + i - 1] = getLeafInstance(path);
+}
+
+void InstancePathCache::freeze() {
+  for (auto *node : instanceGraph)
+    if (auto module = node->getModule())
+      getAbsolutePathIDs(module);
+  frozen = true;
+}
+
+InstancePathID InstancePathCache::appendInstance(InstancePathID path,
+                                                 HWInstanceLike inst) {
+  assert(pathNodes.size() < std::numeric_limits<InstancePathID>::max() &&
+         "too many instance paths");
+  pathNodes.push_back({inst, path, getPathSize(path) + 1});
+  return pathNodes.size() - 1;
 }
 
 void InstancePathCache::replaceInstance(HWInstanceLike oldOp,
                                         HWInstanceLike newOp) {
 
+  assert(!frozen && "cannot update a frozen cache");
   instanceGraph.replaceInstance(oldOp, newOp);
 
+  // All paths through the old instance share the same trie nodes, which can
+  // simply be updated in place.
+  for (auto &node : pathNodes)
+    if (node.leaf == oldOp)
+      node.leaf = newOp;
+
   // Iterate over all the paths, and search for the old HWInstanceLike. If
   // found, then replace it with the new HWInstanceLike, and create a new copy
   // of the paths and update the cache.
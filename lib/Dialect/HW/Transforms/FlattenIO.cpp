@@ -5,346 +5,354 @@
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 //
 //===----------------------------------------------------------------------===//
+//
+// This pass flattens the struct typed ports of modules into one port per
+// struct field. Module signatures, module bodies, and instances are all
+// rewritten in place in a single pass over the design, with the bodies
+// processed in parallel.
+//
+//===----------------------------------------------------------------------===//
 
 #include "PassDetails.h"
 #include "circt/Dialect/HW/HWOps.h"
 #include "circt/Dialect/HW/HWPasses.h"
-#include "mlir/Transforms/DialectConversion.h"
-#include "llvm/ADT/TypeSwitch.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/Threading.h"
 
 using namespace mlir;
 using namespace circt;
 
-static bool isStructType(Type type) {
-  return hw::getCanonicalType(type).isa<hw::StructType>();
-}
-
 static hw::StructType getStructType(Type type) {
   return hw::getCanonicalType(type).dyn_cast<hw::StructType>();
 }
 
-// Legal if no in- or output type is a struct.
-static bool isLegalFuncLikeOp(FunctionOpInterface moduleLikeOp) {
-  bool legalResults =
-      llvm::none_of(moduleLikeOp.getResultTypes(), isStructType);
-  bool legalArgs = llvm::none_of(moduleLikeOp.getArgumentTypes(), isStructType);
-
-  return legalResults && legalArgs;
+/// Append the types and names of the ports a port of type `type` named `name`
+/// is flattened into. Only the top-level struct is flattened unless
+/// `recursive` is set.
+static void flattenPort(Type type, StringAttr name, bool recursive,
+                        SmallVectorImpl<Type> &types,
+                        SmallVectorImpl<Attribute> &names) {
+  auto structType = getStructType(type);
+  if (!structType) {
+    types.push_back(type);
+    names.push_back(name);
+    return;
+  }
+  for (auto field : structType.getElements()) {
+    auto fieldName =
+        StringAttr::get(name.getContext(), name.getValue() + "." +
+                                               field.name.getValue());
+    if (recursive) {
+      flattenPort(field.type, fieldName, recursive, types, names);
+    } else {
+      types.push_back(field.type);
+      names.push_back(fieldName);
+    }
+  }
 }
 
-static llvm::SmallVector<Type> getInnerTypes(hw::StructType t) {
-  llvm::SmallVector<Type> inner;
-  t.getInnerTypes(inner);
-  for (auto [index, innerType] : llvm::enumerate(inner))
-    inner[index] = hw::getCanonicalType(innerType);
-  return inner;
+/// Return the number of values a value of type `type` is flattened into.
+static unsigned getNumFlatValues(Type type, bool recursive) {
+  auto structType = getStructType(type);
+  if (!structType)
+    return 1;
+  if (!recursive)
+    return structType.getElements().size();
+  unsigned count = 0;
+  for (auto field : structType.getElements())
+    count += getNumFlatValues(field.type, recursive);
+  return count;
 }
 
-namespace {
+/// Append the values `value` is flattened into. The fields of a struct built
+/// by a `hw.struct_create` are used directly, and other structs are exploded.
+/// The forwarded `hw.struct_create` ops are added to `forwarded`, such that
+/// they can be removed once they are unused.
+static void flattenValue(OpBuilder &builder, Location loc, Value value,
+                         bool recursive, SmallVectorImpl<Value> &values,
+                         SmallVectorImpl<Operation *> &forwarded) {
+  auto structType = getStructType(value.getType());
+  if (!structType) {
+    values.push_back(value);
+    return;
+  }
+  if (auto create = value.getDefiningOp<hw::StructCreateOp>()) {
+    forwarded.push_back(create);
+    for (auto field : create.getInput()) {
+      if (recursive)
+        flattenValue(builder, loc, field, recursive, values, forwarded);
+      else
+        values.push_back(field);
+    }
+    return;
+  }
+  SmallVector<Type> fieldTypes;
+  for (auto field : structType.getElements())
+    fieldTypes.push_back(field.type);
+  auto explode = builder.create<hw::StructExplodeOp>(loc, fieldTypes, value);
+  for (auto field : explode.getResults()) {
+    if (recursive)
+      flattenValue(builder, loc, field, recursive, values, forwarded);
+    else
+      values.push_back(field);
+  }
+}
 
-// Replaces an output op with a new output with flattened (exploded) structs.
-struct OutputOpConversion : public OpConversionPattern<hw::OutputOp> {
-  OutputOpConversion(TypeConverter &typeConverter, MLIRContext *context,
-                     DenseSet<Operation *> *opVisited)
-      : OpConversionPattern(typeConverter, context), opVisited(opVisited) {}
-
-  LogicalResult
-  matchAndRewrite(hw::OutputOp op, OpAdaptor adaptor,
-                  ConversionPatternRewriter &rewriter) const override {
-    llvm::SmallVector<Value> convOperands;
-
-    // Flatten the operands.
-    for (auto operand : adaptor.getOperands()) {
-      if (auto structType = getStructType(operand.getType())) {
-        auto explodedStruct = rewriter.create<hw::StructExplodeOp>(
-            op.getLoc(), getInnerTypes(structType), operand);
-        llvm::copy(explodedStruct.getResults(),
-                   std::back_inserter(convOperands));
-      } else
-        convOperands.push_back(operand);
+/// Reassemble a value of type `type` from the front of the flattened `values`,
+/// which are dropped from the range.
+static Value unflattenValue(OpBuilder &builder, Location loc, Type type,
+                            bool recursive, ArrayRef<Value> &values) {
+  auto structType = getStructType(type);
+  if (!structType) {
+    auto value = values.front();
+    values = values.drop_front();
+    return value;
+  }
+  SmallVector<Value> fields;
+  for (auto field : structType.getElements()) {
+    if (recursive) {
+      fields.push_back(
+          unflattenValue(builder, loc, field.type, recursive, values));
+    } else {
+      fields.push_back(values.front());
+      values = values.drop_front();
     }
+  }
+  return builder.create<hw::StructCreateOp>(loc, type, fields);
+}
 
-    // And replace.
-    rewriter.replaceOpWithNewOp<hw::OutputOp>(op, convOperands);
-    opVisited->insert(op->getParentOp());
-    return success();
+/// Replace the uses of `value` with the flattened `values` it consists of. The
+/// `hw.struct_extract` and `hw.struct_explode` ops using a struct are replaced
+/// by the flattened fields directly, and the struct is only reassembled for
+/// the remaining uses.
+static void replaceWithFlatValues(OpBuilder &builder, Location loc,
+                                  Value value, bool recursive,
+                                  ArrayRef<Value> values) {
+  auto structType = getStructType(value.getType());
+  if (!structType) {
+    value.replaceAllUsesWith(values.front());
+    return;
   }
-  mutable DenseSet<Operation *> *opVisited;
-};
 
-struct StructExplodeOpConversion
-    : public OpConversionPattern<hw::StructExplodeOp> {
-  StructExplodeOpConversion(TypeConverter &typeConverter, MLIRContext *context)
-      : OpConversionPattern(typeConverter, context) {}
+  SmallVector<ArrayRef<Value>> fieldValues;
+  ArrayRef<Value> remaining = values;
+  for (auto field : structType.getElements()) {
+    unsigned count = recursive ? getNumFlatValues(field.type, recursive) : 1;
+    fieldValues.push_back(remaining.take_front(count));
+    remaining = remaining.drop_front(count);
+  }
+  auto replaceField = [&](Value field, ArrayRef<Value> flatField) {
+    if (recursive)
+      replaceWithFlatValues(builder, loc, field, recursive, flatField);
+    else
+      field.replaceAllUsesWith(flatField.front());
+  };
 
-  LogicalResult
-  matchAndRewrite(hw::StructExplodeOp op, OpAdaptor adaptor,
-                  ConversionPatternRewriter &rewriter) const override {
-    rewriter.replaceOp(op, adaptor.getOperands());
-    return success();
+  for (auto *user : llvm::make_early_inc_range(value.getUsers())) {
+    if (auto extract = dyn_cast<hw::StructExtractOp>(user)) {
+      auto index = structType.getFieldIndex(extract.getFieldAttr());
+      replaceField(extract.getResult(), fieldValues[*index]);
+      extract.erase();
+    } else if (auto explode = dyn_cast<hw::StructExplodeOp>(user)) {
+      for (auto [field, flatField] :
+           llvm::zip(explode.getResults(), fieldValues))
+        replaceField(field, flatField);
+      explode.erase();
+    }
   }
-};
+  if (value.use_empty())
+    return;
+  value.replaceAllUsesWith(
+      unflattenValue(builder, loc, value.getType(), recursive, values));
+}
 
-using IOTypes = std::pair<TypeRange, TypeRange>;
+/// Erase the forwarded `hw.struct_create` ops that are no longer used. Users
+/// precede the structs they use in `forwarded`.
+static void eraseUnusedStructs(ArrayRef<Operation *> forwarded) {
+  SmallPtrSet<Operation *, 8> erased;
+  for (auto *op : forwarded)
+    if (!erased.count(op) && op->use_empty()) {
+      erased.insert(op);
+      op->erase();
+    }
+}
 
-struct IOInfo {
-  // A mapping between an arg/res index and the struct type of the given field.
-  DenseMap<unsigned, hw::StructType> argStructs, resStructs;
+namespace {
 
-  // Records of the original arg/res types.
-  TypeRange argTypes, resTypes;
+/// The flattened port names of a module, which instances of it adopt.
+struct FlatPortNames {
+  ArrayAttr argNames, resultNames;
 };
 
-class FlattenIOTypeConverter : public TypeConverter {
+class FlattenIOPass : public circt::hw::FlattenIOBase<FlattenIOPass> {
 public:
-  FlattenIOTypeConverter() {
-    addConversion([](Type type, SmallVectorImpl<Type> &results) {
-      auto structType = getStructType(type);
-      if (!structType)
-        results.push_back(type);
-      else {
-        for (auto field : structType.getElements())
-          results.push_back(field.type);
-      }
-      return success();
-    });
-
-    addTargetMaterialization([](OpBuilder &builder, hw::StructType type,
-                                ValueRange inputs, Location loc) {
-      auto result = builder.create<hw::StructCreateOp>(loc, type, inputs);
-      return result.getResult();
-    });
-
-    addTargetMaterialization([](OpBuilder &builder, hw::TypeAliasType type,
-                                ValueRange inputs, Location loc) {
-      auto structType = getStructType(type);
-      assert(structType && "expected struct type");
-      auto result = builder.create<hw::StructCreateOp>(loc, structType, inputs);
-      return result.getResult();
-    });
-  }
+  void runOnOperation() override;
+
+private:
+  void flattenSignature(Operation *module);
+  void flattenBody(hw::HWModuleOp module);
+  void flattenInstance(hw::InstanceOp inst, const FlatPortNames &names);
+
+  /// The modules with struct ports, by name.
+  DenseMap<StringAttr, FlatPortNames> flattenedModules;
 };
 
 } // namespace
 
-template <typename... TOp>
-static void addSignatureConversion(DenseMap<Operation *, IOInfo> &ioMap,
-                                   ConversionTarget &target,
-                                   RewritePatternSet &patterns,
-                                   FlattenIOTypeConverter &typeConverter) {
-  (mlir::populateFunctionOpInterfaceTypeConversionPattern<TOp>(patterns,
-                                                               typeConverter),
-   ...);
-
-  // Legality is defined by a module having been processed once. This is due to
-  // that a pattern cannot be applied multiple times (a 'pattern was already
-  // applied' error - a case that would occur for nested structs). Additionally,
-  // if a pattern could be applied multiple times, this would complicate
-  // updating arg/res names.
-
-  // Instead, we define legality as when a module has had a modification to its
-  // top-level i/o. This ensures that only a single level of structs are
-  // processed during signature conversion, which then allows us to use the
-  // signature conversion in a recursive manner.
-  target.addDynamicallyLegalOp<TOp...>([&](FunctionOpInterface moduleLikeOp) {
-    if (isLegalFuncLikeOp(moduleLikeOp))
-      return true;
-
-    // This op is involved in conversion. Check if the signature has changed.
-    auto ioInfoIt = ioMap.find(moduleLikeOp);
-    if (ioInfoIt == ioMap.end()) {
-      // Op wasn't primed in the map. Do the safe thing, assume
-      // that it's not considered in this pass, and mark it as legal
-      return true;
+/// Replace the struct ports in the signature of a module with their flattened
+/// ports. The body of the module is left as is.
+void FlattenIOPass::flattenSignature(Operation *module) {
+  SmallVector<std::pair<unsigned, hw::PortInfo>> insertInputs, insertOutputs;
+  SmallVector<unsigned> removeInputs, removeOutputs;
+  SmallVector<Attribute> argNames, resultNames;
+
+  auto flattenPorts = [&](ArrayRef<Type> portTypes, hw::PortDirection direction,
+                          SmallVectorImpl<Attribute> &allNames,
+                          auto &&getName, auto &&getLoc, auto &inserts,
+                          auto &removes) {
+    for (auto [idx, portType] : llvm::enumerate(portTypes)) {
+      auto name = getName(module, idx);
+      if (!getStructType(portType)) {
+        allNames.push_back(name);
+        continue;
+      }
+      SmallVector<Type> flatTypes;
+      SmallVector<Attribute> flatNames;
+      flattenPort(portType, name, recursive, flatTypes, flatNames);
+      auto loc = getLoc(module, idx);
+      for (auto [flatType, flatName] : llvm::zip(flatTypes, flatNames))
+        inserts.push_back({unsigned(idx),
+                           {flatName.cast<StringAttr>(), direction, flatType,
+                            ~0U, {}, loc}});
+      allNames.append(flatNames);
+      removes.push_back(idx);
     }
-    auto ioInfo = ioInfoIt->second;
-
-    auto compareTypes = [&](TypeRange oldTypes, TypeRange newTypes) {
-      return llvm::any_of(llvm::zip(oldTypes, newTypes), [&](auto typePair) {
-        auto oldType = std::get<0>(typePair);
-        auto newType = std::get<1>(typePair);
-        return oldType != newType;
-      });
-    };
-    if (compareTypes(moduleLikeOp.getResultTypes(), ioInfo.resTypes) ||
-        compareTypes(moduleLikeOp.getArgumentTypes(), ioInfo.argTypes))
-      return true;
-
-    // We're pre-conversion for an op that was primed in the map - it will
-    // always be illegal since it has to-be-converted struct types at its I/O.
-    return false;
-  });
-}
-
-template <typename T>
-static bool hasUnconvertedOps(mlir::ModuleOp module) {
-  return llvm::any_of(module.getBody()->getOps<T>(),
-                      [](T op) { return !isLegalFuncLikeOp(op); });
-}
-
-template <typename T>
-static DenseMap<Operation *, IOTypes> populateIOMap(mlir::ModuleOp module) {
-  DenseMap<Operation *, IOTypes> ioMap;
-  for (auto op : module.getOps<T>())
-    ioMap[op] = {op.getArgumentTypes(), op.getResultTypes()};
-  return ioMap;
-}
+  };
 
-static void updateNameAttribute(FunctionOpInterface op, StringRef attrName,
-                                DenseMap<unsigned, hw::StructType> &structMap) {
-  llvm::SmallVector<Attribute> newNames;
-  auto oldNames = op.getOperation()
-                      ->getAttrOfType<ArrayAttr>(attrName)
-                      .getAsValueRange<StringAttr>();
-  for (auto [i, oldName] : llvm::enumerate(oldNames)) {
-    // Was this arg/res index a struct?
-    auto it = structMap.find(i);
-    if (it == structMap.end()) {
-      // No, keep old name.
-      newNames.push_back(StringAttr::get(op.getContext(), oldName));
-      continue;
-    }
+  auto moduleType = hw::getModuleType(module);
+  flattenPorts(moduleType.getInputs(), hw::PortDirection::INPUT, argNames,
+               hw::getModuleArgumentNameAttr, hw::getModuleArgumentLocAttr,
+               insertInputs, removeInputs);
+  flattenPorts(moduleType.getResults(), hw::PortDirection::OUTPUT, resultNames,
+               hw::getModuleResultNameAttr, hw::getModuleResultLocAttr,
+               insertOutputs, removeOutputs);
+  if (removeInputs.empty() && removeOutputs.empty())
+    return;
 
-    // Yes - create new names from the struct fields and the old name at the
-    // index.
-    auto structType = it->second;
-    for (auto field : structType.getElements())
-      newNames.push_back(
-          StringAttr::get(op.getContext(), oldName + "." + field.name.str()));
-  }
-  op.getOperation()->setAttr(attrName,
-                             ArrayAttr::get(op.getContext(), newNames));
+  hw::modifyModulePorts(module, insertInputs, insertOutputs, removeInputs,
+                        removeOutputs);
+  auto *context = module->getContext();
+  flattenedModules[SymbolTable::getSymbolName(module)] = {
+      ArrayAttr::get(context, argNames), ArrayAttr::get(context, resultNames)};
 }
 
-static void updateLocAttribute(FunctionOpInterface op, StringRef attrName,
-                               DenseMap<unsigned, hw::StructType> &structMap) {
-  llvm::SmallVector<Attribute> newLocs;
-  auto oldLocs = op.getOperation()->getAttrOfType<ArrayAttr>(attrName);
-  if (!oldLocs)
-    return;
-  for (auto [i, oldLoc] : llvm::enumerate(oldLocs)) {
-    // Was this arg/res index a struct?
-    auto it = structMap.find(i);
-    if (it == structMap.end()) {
-      // No, keep old name.
-      newLocs.push_back(oldLoc);
+/// Flatten the struct block arguments and output operands of a module body,
+/// and the ports of the instances it contains.
+void FlattenIOPass::flattenBody(hw::HWModuleOp module) {
+  auto *block = module.getBodyBlock();
+  OpBuilder builder(module.getContext());
+
+  // Replace each struct argument with its flattened arguments, and rebuild
+  // the struct from them for the existing uses. The struct ops are created in
+  // the order of the arguments since each argument prepends its ops.
+  for (unsigned idx = block->getNumArguments(); idx-- > 0;) {
+    auto arg = block->getArgument(idx);
+    if (!getStructType(arg.getType()))
       continue;
-    }
-
-    auto structType = it->second;
-    for (size_t i = 0, e = structType.getElements().size(); i < e; ++i)
-      newLocs.push_back(oldLoc);
+    SmallVector<Type> types;
+    SmallVector<Attribute> names;
+    flattenPort(arg.getType(), builder.getStringAttr(""), recursive, types,
+                names);
+    SmallVector<Value> flatArgs;
+    for (auto [offset, type] : llvm::enumerate(types))
+      flatArgs.push_back(
+          block->insertArgument(idx + 1 + offset, type, arg.getLoc()));
+    builder.setInsertionPointToStart(block);
+    replaceWithFlatValues(builder, arg.getLoc(), arg, recursive, flatArgs);
+    block->eraseArgument(idx);
   }
-  op.getOperation()->setAttr(attrName,
-                             ArrayAttr::get(op.getContext(), newLocs));
-}
 
-/// The conversion framework seems to throw away block argument locations.  We
-/// use this function to copy the location from the original argument to the
-/// set of flattened arguments.
-static void
-updateBlockLocations(FunctionOpInterface op, StringRef attrName,
-                     DenseMap<unsigned, hw::StructType> &structMap) {
-  auto locs = op.getOperation()->getAttrOfType<ArrayAttr>(attrName);
-  if (!locs)
-    return;
-  for (auto [arg, loc] :
-       llvm::zip(op.getArguments(), locs.getAsRange<LocationAttr>()))
-    arg.setLoc(loc);
+  // Explode the struct operands of the output op.
+  auto output = cast<hw::OutputOp>(block->getTerminator());
+  builder.setInsertionPoint(output);
+  SmallVector<Value> outputs;
+  SmallVector<Operation *> forwarded;
+  for (auto operand : output.getOperands())
+    flattenValue(builder, output.getLoc(), operand, recursive, outputs,
+                 forwarded);
+  output->setOperands(outputs);
+  eraseUnusedStructs(forwarded);
+
+  // Update the instances of modules with flattened ports.
+  SmallVector<std::pair<hw::InstanceOp, const FlatPortNames *>> instances;
+  module.walk([&](hw::InstanceOp inst) {
+    auto it = flattenedModules.find(inst.getModuleNameAttr().getAttr());
+    if (it != flattenedModules.end())
+      instances.push_back({inst, &it->second});
+  });
+  for (auto [inst, names] : instances)
+    flattenInstance(inst, *names);
 }
 
-template <typename T>
-static DenseMap<Operation *, IOInfo> populateIOInfoMap(mlir::ModuleOp module) {
-  DenseMap<Operation *, IOInfo> ioInfoMap;
-  for (auto op : module.getOps<T>()) {
-    IOInfo ioInfo;
-    ioInfo.argTypes = op.getArgumentTypes();
-    ioInfo.resTypes = op.getResultTypes();
-    for (auto [i, arg] : llvm::enumerate(ioInfo.argTypes)) {
-      if (auto structType = getStructType(arg))
-        ioInfo.argStructs[i] = structType;
-    }
-    for (auto [i, res] : llvm::enumerate(ioInfo.resTypes)) {
-      if (auto structType = getStructType(res))
-        ioInfo.resStructs[i] = structType;
-    }
-    ioInfoMap[op] = ioInfo;
+/// Replace an instance of a module with flattened ports by one with the
+/// flattened ports, exploding the struct operands and rebuilding the struct
+/// results around it.
+void FlattenIOPass::flattenInstance(hw::InstanceOp inst,
+                                    const FlatPortNames &names) {
+  OpBuilder builder(inst);
+  auto loc = inst.getLoc();
+  SmallVector<Value> operands;
+  SmallVector<Operation *> forwarded;
+  for (auto operand : inst.getOperands())
+    flattenValue(builder, loc, operand, recursive, operands, forwarded);
+
+  SmallVector<Type> resultTypes;
+  SmallVector<Attribute> resultNames;
+  for (auto result : inst.getResults())
+    flattenPort(result.getType(), builder.getStringAttr(""), recursive,
+                resultTypes, resultNames);
+
+  OperationState state(loc, inst->getName());
+  state.addOperands(operands);
+  state.addTypes(resultTypes);
+  state.addAttributes(inst->getAttrs());
+  auto *newInst = builder.create(state);
+  newInst->setAttr("argNames", names.argNames);
+  newInst->setAttr("resultNames", names.resultNames);
+
+  SmallVector<Value> flatResultValues(newInst->getResults());
+  ArrayRef<Value> flatResults = flatResultValues;
+  for (auto result : inst.getResults()) {
+    unsigned count = getNumFlatValues(result.getType(), recursive);
+    replaceWithFlatValues(builder, loc, result, recursive,
+                          flatResults.take_front(count));
+    flatResults = flatResults.drop_front(count);
   }
-  return ioInfoMap;
+  inst.erase();
+  eraseUnusedStructs(forwarded);
 }
 
-template <typename T>
-static LogicalResult flattenOpsOfType(ModuleOp module, bool recursive) {
-  auto *ctx = module.getContext();
-  FlattenIOTypeConverter typeConverter;
-
-  // Recursively (in case of nested structs) lower the module. We do this one
-  // conversion at a time to allow for updating the arg/res names of the
-  // module in between flattening each level of structs.
-  while (hasUnconvertedOps<T>(module)) {
-    ConversionTarget target(*ctx);
-    RewritePatternSet patterns(ctx);
-    target.addLegalDialect<hw::HWDialect>();
-
-    // Record any struct types at the module signature. This will be used
-    // post-conversion to update the argument and result names.
-    auto ioInfoMap = populateIOInfoMap<T>(module);
-
-    // Signature conversion and legalization patterns.
-    addSignatureConversion<T>(ioInfoMap, target, patterns, typeConverter);
-
-    // Argument conversion for output ops. Similarly to the signature
-    // conversion, legality is based on the op having been visited once, due to
-    // the possibility of nested structs.
-    DenseSet<Operation *> opVisited;
-    patterns.add<OutputOpConversion>(typeConverter, ctx, &opVisited);
-    // patterns.add<StructExplodeOpConversion>(typeConverter, ctx);
-    target.addDynamicallyLegalOp<hw::OutputOp>(
-        [&](auto op) { return opVisited.contains(op->getParentOp()); });
-
-    if (failed(applyPartialConversion(module, target, std::move(patterns))))
-      return failure();
-
-    // Update the arg/res names of the module.
-    for (auto op : module.getOps<T>()) {
-      auto ioInfo = ioInfoMap[op];
-      updateNameAttribute(op, "argNames", ioInfo.argStructs);
-      updateNameAttribute(op, "resultNames", ioInfo.resStructs);
-      updateLocAttribute(op, "argLocs", ioInfo.argStructs);
-      updateLocAttribute(op, "resultLocs", ioInfo.resStructs);
-      updateBlockLocations(op, "argLocs", ioInfo.argStructs);
-    }
+void FlattenIOPass::runOnOperation() {
+  ModuleOp top = getOperation();
+  flattenedModules.clear();
 
-    // Break if we've only lowering a single level of structs.
-    if (!recursive)
-      break;
+  // Update the signatures first, which determines the ports instances have to
+  // adopt.
+  SmallVector<hw::HWModuleOp> bodies;
+  for (auto &op : *top.getBody()) {
+    if (!isa<hw::HWModuleOp, hw::HWModuleExternOp, hw::HWModuleGeneratedOp>(
+            op))
+      continue;
+    flattenSignature(&op);
+    if (auto module = dyn_cast<hw::HWModuleOp>(op))
+      bodies.push_back(module);
   }
-  return success();
-}
-
-//===----------------------------------------------------------------------===//
-// Pass driver
-//===----------------------------------------------------------------------===//
 
-template <typename... TOps>
-static bool flattenIO(ModuleOp module, bool recursive) {
-  return (failed(flattenOpsOfType<TOps>(module, recursive)) || ...);
+  // Every body only touches its own ops, so they can be updated in parallel.
+  mlir::parallelForEach(&getContext(), bodies,
+                        [&](hw::HWModuleOp module) { flattenBody(module); });
 }
 
-namespace {
-
-class FlattenIOPass : public circt::hw::FlattenIOBase<FlattenIOPass> {
-public:
-  void runOnOperation() override {
-    ModuleOp module = getOperation();
-    if (flattenIO<hw::HWModuleOp, hw::HWModuleExternOp,
-                  hw::HWModuleGeneratedOp>(module, recursive))
-      signalPassFailure();
-  };
-};
-
-} // namespace
-
 //===----------------------------------------------------------------------===//
 // Pass initialization
 //===----------------------------------------------------------------------===//
@@ -22,6 +22,7 @@
 #include "mlir/IR/Builders.h"
 #include "mlir/IR/IRMapping.h"
 #include "mlir/IR/PatternMatch.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/Transforms/DialectConversion.h"
 #include "llvm/ADT/TypeSwitch.h"
 
@@ -76,7 +77,7 @@ static FailureOr<Value> narrowValueToArrayWidth(OpBuilder &builder, Value array,
 static hw::HWModuleOp targetModuleOp(hw::InstanceOp instanceOp,
                                      const SymbolCache &sc) {
   auto *targetOp = sc.getDefinition(instanceOp.getModuleNameAttr());
-  auto targetHWModule = dyn_cast<hw::HWModuleOp>(targetOp);
+  auto targetHWModule = dyn_cast_or_null<hw::HWModuleOp>(targetOp);
   if (!targetHWModule)
     return {}; // Won't specialize external modules.
 
@@ -86,22 +87,6 @@ static hw::HWModuleOp targetModuleOp(hw::InstanceOp instanceOp,
   return targetHWModule;
 }
 
-// Stores unique module parameters and references to them
-struct ParameterSpecializationRegistry {
-  llvm::MapVector<hw::HWModuleOp, llvm::SetVector<ArrayAttr>>
-      uniqueModuleParameters;
-
-  bool isRegistered(hw::HWModuleOp moduleOp, ArrayAttr parameters) const {
-    auto it = uniqueModuleParameters.find(moduleOp);
-    return it != uniqueModuleParameters.end() &&
-           it->second.contains(parameters);
-  }
-
-  void registerModuleOp(hw::HWModuleOp moduleOp, ArrayAttr parameters) {
-    uniqueModuleParameters[moduleOp].insert(parameters);
-  }
-};
-
 struct EliminateParamValueOpPattern : public OpRewritePattern<ParamValueOp> {
   EliminateParamValueOpPattern(MLIRContext *context, ArrayAttr parameters)
       : OpRewritePattern<ParamValueOp>(context), parameters(parameters) {}
@@ -206,29 +191,48 @@ static void populateTypeConversion(Location loc, TypeConverter &typeConverter,
   typeConverter.addConversion([](mlir::IntegerType type) { return type; });
 }
 
-// Registers any nested parametric instance ops of `target` for the next
-// specialization loop
-static LogicalResult registerNestedParametricInstanceOps(
-    HWModuleOp target, ArrayAttr parameters, SymbolCache &sc,
-    const ParameterSpecializationRegistry &currentRegistry,
-    ParameterSpecializationRegistry &nextRegistry,
-    llvm::DenseMap<hw::HWModuleOp,
-                   llvm::DenseMap<ArrayAttr, llvm::SmallVector<hw::InstanceOp>>>
-        &parametersUsers) {
-  // Register any nested parametric instance ops for the next loop
-  auto walkResult = target->walk([&](InstanceOp instanceOp) -> WalkResult {
+/// A parametric instance which is to be rewritten to instantiate the
+/// specialization of its target module for its parameters.
+struct ParametricInstance {
+  HWModuleOp target;
+  /// The parameters of the instance, with all values evaluated. Equal sets of
+  /// parameters are the same attribute.
+  ArrayAttr parameters;
+  InstanceOp instanceOp;
+};
+
+/// A specialization of a parametric module, whose body is yet to be filled in.
+struct Specialization {
+  HWModuleOp source;
+  ArrayAttr parameters;
+  HWModuleOp target;
+  /// The parametric instances in the body of the specialization.
+  SmallVector<ParametricInstance> instances;
+};
+
+// Collects the parametric instances within 'op', evaluating their parameters
+// in the context of the 'parameters' of the module being specialized.
+static LogicalResult
+collectParametricInstances(Operation *op, ArrayAttr parameters,
+                           const SymbolCache &sc,
+                           SmallVectorImpl<ParametricInstance> &instances) {
+  auto walkResult = op->walk([&](InstanceOp instanceOp) -> WalkResult {
     auto instanceParameters = instanceOp.getParameters();
     // We can ignore non-parametric instances
     if (instanceParameters.empty())
       return WalkResult::advance();
+    auto targetHWModule = targetModuleOp(instanceOp, sc);
+    if (!targetHWModule)
+      return WalkResult::advance();
 
-    // Replace instance parameters with evaluated versions
+    // Replace instance parameters with evaluated versions, such that equal
+    // parameter values written differently share a specialization.
     llvm::SmallVector<Attribute> evaluatedInstanceParameters;
     evaluatedInstanceParameters.reserve(instanceParameters.size());
     for (auto instanceParameter : instanceParameters) {
       auto instanceParameterDecl = instanceParameter.cast<hw::ParamDeclAttr>();
       auto instanceParameterValue = instanceParameterDecl.getValue();
-      auto evaluated = evaluateParametricAttr(target.getLoc(), parameters,
+      auto evaluated = evaluateParametricAttr(instanceOp.getLoc(), parameters,
                                               instanceParameterValue);
       if (failed(evaluated))
         return WalkResult::interrupt();
@@ -236,40 +240,27 @@ static LogicalResult registerNestedParametricInstanceOps(
           hw::ParamDeclAttr::get(instanceParameterDecl.getName(), *evaluated));
     }
 
-    auto evaluatedInstanceParametersAttr =
-        ArrayAttr::get(target.getContext(), evaluatedInstanceParameters);
-
-    if (auto targetHWModule = targetModuleOp(instanceOp, sc)) {
-      if (!currentRegistry.isRegistered(targetHWModule,
-                                        evaluatedInstanceParametersAttr))
-        nextRegistry.registerModuleOp(targetHWModule,
-                                      evaluatedInstanceParametersAttr);
-      parametersUsers[targetHWModule][evaluatedInstanceParametersAttr]
-          .push_back(instanceOp);
-    }
-
+    instances.push_back(
+        {targetHWModule,
+         ArrayAttr::get(op->getContext(), evaluatedInstanceParameters),
+         instanceOp});
     return WalkResult::advance();
   });
 
   return failure(walkResult.wasInterrupted());
 }
 
-// Specializes the provided 'base' module into the 'target' module. By doing
-// so, we create a new module which
+// Creates the module specializing the provided 'source' module for the
+// 'parameters'. The new module
 // 1. has no parameters
-// 2. has a name composing the name of 'base' as well as the 'parameters'
+// 2. has a name composing the name of 'source' as well as the 'parameters'
 // parameters.
 // 3. Has a top-level interface with any parametric types resolved.
-// 4. Any references to module parameters have been replaced with the
-// parameter value.
-static LogicalResult specializeModule(
-    OpBuilder builder, ArrayAttr parameters, SymbolCache &sc, Namespace &ns,
-    HWModuleOp source, HWModuleOp &target,
-    const ParameterSpecializationRegistry &currentRegistry,
-    ParameterSpecializationRegistry &nextRegistry,
-    llvm::DenseMap<hw::HWModuleOp,
-                   llvm::DenseMap<ArrayAttr, llvm::SmallVector<hw::InstanceOp>>>
-        &parametersUsers) {
+// Its body is left empty, to be filled in by 'specializeModuleBody'.
+static FailureOr<HWModuleOp> createSpecializedModule(OpBuilder &builder,
+                                                     ArrayAttr parameters,
+                                                     Namespace &ns,
+                                                     HWModuleOp source) {
   auto *ctx = builder.getContext();
   // Update the types of the source module ports based on evaluating any
   // parametric in/output ports.
@@ -290,16 +281,31 @@ static LogicalResult specializeModule(
   }
 
   // Create the specialized module using the evaluated port info.
-  target = builder.create<HWModuleOp>(
+  auto target = builder.create<HWModuleOp>(
       source.getLoc(),
       StringAttr::get(ctx, generateModuleName(ns, source, parameters)), ports);
 
   // Erase the default created hw.output op - we'll copy the correct operation
   // during body elaboration.
   (*target.getOps<hw::OutputOp>().begin()).erase();
+  return target;
+}
+
+// Fills in the body of a specialization created by 'createSpecializedModule',
+// such that any references to module parameters have been replaced with the
+// parameter value, and collects the parametric instances within it. Only
+// touches the specialization itself, such that distinct specializations can
+// be filled in in parallel.
+static LogicalResult specializeModuleBody(Specialization &specialization,
+                                          const SymbolCache &sc) {
+  auto source = specialization.source;
+  auto target = specialization.target;
+  auto parameters = specialization.parameters;
+  auto *ctx = target.getContext();
 
   // Clone body of the source into the target. Use ValueMapper to ensure safe
   // cloning in the presence of backedges.
+  OpBuilder builder(ctx);
   BackedgeBuilder bb(builder, source.getLoc());
   ValueMapper mapper(&bb);
   for (auto &&[src, dst] :
@@ -317,10 +323,9 @@ static LogicalResult specializeModule(
       mapper.set(oldRes, newRes);
   }
 
-  // Register any nested parametric instance ops for the next loop
-  auto nestedRegistrationResult = registerNestedParametricInstanceOps(
-      target, parameters, sc, currentRegistry, nextRegistry, parametersUsers);
-  if (failed(nestedRegistrationResult))
+  // Collect any nested parametric instance ops for the next loop
+  if (failed(collectParametricInstances(target, parameters, sc,
+                                        specialization.instances)))
     return failure();
 
   // We've now created a separate copy of the source module with a rewritten
@@ -346,81 +351,75 @@ static LogicalResult specializeModule(
 void HWSpecializePass::runOnOperation() {
   ModuleOp module = getOperation();
 
-  // Record unique module parameters and references to these.
-  llvm::DenseMap<hw::HWModuleOp,
-                 llvm::DenseMap<ArrayAttr, llvm::SmallVector<hw::InstanceOp>>>
-      parametersUsers;
-  ParameterSpecializationRegistry registry;
-
   // Maintain a symbol cache for fast lookup during module specialization.
   SymbolCache sc;
   sc.addDefinitions(module);
   Namespace ns;
   ns.add(sc);
 
+  // Collect the parametric instances outside of parametric modules. The
+  // instances within a parametric module are collected once the module is
+  // specialized.
+  SmallVector<ParametricInstance> instances;
+  auto noParameters = ArrayAttr::get(&getContext(), {});
   for (auto hwModule : module.getOps<hw::HWModuleOp>()) {
-    // If this module is parametric, defer registering its parametric
-    // instantiations until this module is specialized
     if (!hwModule.getParameters().empty())
       continue;
-    for (auto instanceOp : hwModule.getOps<hw::InstanceOp>()) {
-      if (auto targetHWModule = targetModuleOp(instanceOp, sc)) {
-        auto parameters = instanceOp.getParameters();
-        registry.registerModuleOp(targetHWModule, parameters);
-
-        parametersUsers[targetHWModule][parameters].push_back(instanceOp);
-      }
-    }
+    if (failed(
+            collectParametricInstances(hwModule, noParameters, sc, instances)))
+      return signalPassFailure();
   }
 
-  // Create specialized modules.
+  // The specializations created so far, memoized by their source module and
+  // evaluated parameters.
+  llvm::DenseMap<std::pair<HWModuleOp, ArrayAttr>, HWModuleOp> specializations;
   OpBuilder builder = OpBuilder(&getContext());
   builder.setInsertionPointToStart(module.getBody());
-  llvm::DenseMap<hw::HWModuleOp, llvm::DenseMap<ArrayAttr, hw::HWModuleOp>>
-      specializations;
-
-  // For every module specialization, any nested parametric modules will be
-  // registered for the next loop. We loop until no new nested modules have been
-  // registered.
-  while (!registry.uniqueModuleParameters.empty()) {
-    // The registry for the next specialization loop
-    ParameterSpecializationRegistry nextRegistry;
-    for (auto it : registry.uniqueModuleParameters) {
-      for (auto parameters : it.second) {
-        HWModuleOp specializedModule;
-        if (failed(specializeModule(builder, parameters, sc, ns, it.first,
-                                    specializedModule, registry, nextRegistry,
-                                    parametersUsers))) {
-          signalPassFailure();
-          return;
-        }
+
+  // Every specialization exposes the parametric instances in its body, which
+  // are handled in the next loop. We loop until no new parametric instances
+  // have been found.
+  while (!instances.empty()) {
+    // Create the interfaces of the specializations not seen before and rewrite
+    // the instances. Symbols are only created here, such that the bodies can
+    // be filled in in parallel.
+    SmallVector<Specialization> worklist;
+    for (auto &instance : instances) {
+      auto &specializedModule =
+          specializations[{instance.target, instance.parameters}];
+      if (specializedModule) {
+        ++numReused;
+      } else {
+        auto target = createSpecializedModule(builder, instance.parameters, ns,
+                                              instance.target);
+        if (failed(target))
+          return signalPassFailure();
+        specializedModule = *target;
 
         // Extend the symbol cache with the newly created module.
         sc.addDefinition(specializedModule.getNameAttr(), specializedModule);
-
-        // Add the specialization
-        specializations[it.first][parameters] = specializedModule;
+        worklist.push_back(
+            {instance.target, instance.parameters, specializedModule, {}});
+        ++numSpecialized;
       }
+
+      // Rewrite the instance to the specialized module.
+      instance.instanceOp->setAttr("moduleName",
+                                   FlatSymbolRefAttr::get(specializedModule));
+      instance.instanceOp->setAttr("parameters",
+                                   ArrayAttr::get(&getContext(), {}));
     }
 
-    // Transfer newly registered specializations to iterate over
-    registry.uniqueModuleParameters =
-        std::move(nextRegistry.uniqueModuleParameters);
-  }
+    if (failed(failableParallelForEach(
+            &getContext(), worklist, [&](Specialization &specialization) {
+              return specializeModuleBody(specialization, sc);
+            })))
+      return signalPassFailure();
 
-  // Rewrite instances of specialized modules to the specialized module.
-  for (auto it : specializations) {
-    auto unspecialized = it.getFirst();
-    auto &users = parametersUsers[unspecialized];
-    for (auto specialization : it.getSecond()) {
-      auto parameters = specialization.getFirst();
-      auto specializedModule = specialization.getSecond();
-      for (auto instanceOp : users[parameters]) {
-        instanceOp->setAttr("moduleName",
-                            FlatSymbolRefAttr::get(specializedModule));
-        instanceOp->setAttr("parameters", ArrayAttr::get(&getContext(), {}));
-      }
-    }
+    // Transfer newly found parametric instances to iterate over
+    instances.clear();
+    for (auto &specialization : worklist)
+      instances.append(specialization.instances);
   }
 }
 
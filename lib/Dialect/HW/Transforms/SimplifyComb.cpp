@@ -0,0 +1,199 @@
+//===- SimplifyComb.cpp - Single-pass combinational simplifier ------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass simplifies the combinational logic of a module in a single walk
+// over its body.  Every combinational operation is folded, and then hashed
+// against the structurally identical operations already seen, such that
+// duplicates are replaced on the spot.  Operations left without uses are
+// erased at the end.
+//
+// This is a cheap subset of what canonicalize and CSE do together: it applies
+// the folders but not the rewrite patterns, and it never revisits operations.
+// It avoids the worklist of the greedy rewrite driver, which makes it a good
+// first cleanup of the large bodies produced by lowering.
+//
+//===----------------------------------------------------------------------===//
+
+#include "PassDetails.h"
+#include "circt/Dialect/Comb/CombDialect.h"
+#include "circt/Dialect/HW/HWOps.h"
+#include "circt/Dialect/HW/HWPasses.h"
+#include "circt/Support/ExpressionInfo.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
+#include "llvm/ADT/ScopedHashTable.h"
+#include "llvm/Support/RecyclingAllocator.h"
+
+using namespace mlir;
+using namespace circt;
+using namespace hw;
+
+namespace {
+struct SimplifyCombPass : public SimplifyCombBase<SimplifyCombPass> {
+  void runOnOperation() override;
+
+private:
+  using AllocatorTy = llvm::RecyclingAllocator<
+      llvm::BumpPtrAllocator,
+      llvm::ScopedHashTableVal<Operation *, Operation *>>;
+  using ScopedMapTy = llvm::ScopedHashTable<Operation *, Operation *,
+                                            ExpressionInfo, AllocatorTy>;
+
+  void simplifyBlock(Block &block);
+  void simplifyOperation(Operation *op);
+  LogicalResult foldOperation(Operation *op);
+  void replaceUses(Operation *op, ValueRange values);
+  void eraseDeadOperations();
+
+  /// The expressions visible at the current point of the walk.  Nested blocks
+  /// open a new scope, such that their expressions are not used to replace
+  /// expressions outside of them.
+  ScopedMapTy knownExpressions;
+
+  /// The operations which have been inserted into `knownExpressions`.  Their
+  /// operands must not change, since that would change their hash.
+  DenseSet<Operation *> knownOps;
+
+  /// Operations whose uses have been removed, and which may now be dead.
+  SmallVector<Operation *> maybeDead;
+};
+} // namespace
+
+/// Return true if this operation is a combinational expression which may be
+/// folded and deduplicated.
+static bool isSimplifiableExpression(Operation *op) {
+  return (isa<comb::CombDialect>(op->getDialect()) || isa<ConstantOp>(op)) &&
+         op->getNumRegions() == 0 && mlir::isMemoryEffectFree(op);
+}
+
+void SimplifyCombPass::simplifyBlock(Block &block) {
+  ScopedMapTy::ScopeTy scope(knownExpressions);
+  for (auto &op : llvm::make_early_inc_range(block)) {
+    if (isSimplifiableExpression(&op)) {
+      simplifyOperation(&op);
+      continue;
+    }
+    for (auto &region : op.getRegions())
+      for (auto &nestedBlock : region)
+        simplifyBlock(nestedBlock);
+  }
+}
+
+/// Replace the uses of the results of an operation.  Module bodies are graph
+/// regions, so an operation visited before may use a value defined after it.
+/// Like MLIR's CSE, such uses are left alone: the operation is a key of
+/// `knownExpressions` and changing its operands would leave a stale hash
+/// behind.  The replaced operation is kept alive by these uses.
+void SimplifyCombPass::replaceUses(Operation *op, ValueRange values) {
+  for (auto [result, value] : llvm::zip(op->getResults(), values))
+    result.replaceUsesWithIf(value, [&](OpOperand &operand) {
+      return !knownOps.contains(operand.getOwner());
+    });
+  maybeDead.push_back(op);
+}
+
+/// Fold an operation, replacing its results with the folded values.  Returns
+/// success if the operation has been replaced and should not be visited any
+/// further.
+LogicalResult SimplifyCombPass::foldOperation(Operation *op) {
+  // Constants fold to themselves.
+  if (op->hasTrait<OpTrait::ConstantLike>())
+    return failure();
+
+  SmallVector<Attribute> operandConstants;
+  operandConstants.reserve(op->getNumOperands());
+  for (auto operand : op->getOperands()) {
+    Attribute constant;
+    matchPattern(operand, m_Constant(&constant));
+    operandConstants.push_back(constant);
+  }
+
+  SmallVector<OpFoldResult> foldResults;
+  if (failed(op->fold(operandConstants, foldResults)))
+    return failure();
+
+  // The operation was updated in place.
+  if (foldResults.empty()) {
+    ++numFolded;
+    return failure();
+  }
+
+  // Materialize the folded constants right before the operation.
+  OpBuilder builder(op);
+  SmallVector<Value> replacements;
+  SmallVector<Operation *> newConstants;
+  for (auto [result, foldResult] : llvm::zip(op->getResults(), foldResults)) {
+    if (auto value = foldResult.dyn_cast<Value>()) {
+      replacements.push_back(value);
+      continue;
+    }
+    auto *constant = op->getDialect()->materializeConstant(
+        builder, foldResult.get<Attribute>(), result.getType(), op->getLoc());
+    if (!constant) {
+      for (auto *newConstant : newConstants)
+        newConstant->erase();
+      return failure();
+    }
+    newConstants.push_back(constant);
+    replacements.push_back(constant->getResult(0));
+  }
+
+  ++numFolded;
+  replaceUses(op, replacements);
+
+  // Deduplicate the new constants with the ones seen before.
+  for (auto *newConstant : newConstants)
+    if (isSimplifiableExpression(newConstant))
+      simplifyOperation(newConstant);
+  return success();
+}
+
+void SimplifyCombPass::simplifyOperation(Operation *op) {
+  if (succeeded(foldOperation(op)))
+    return;
+
+  // Replace the operation with an identical one seen before, if any.
+  if (auto *existing = knownExpressions.lookup(op)) {
+    ++numDeduplicated;
+    replaceUses(op, existing->getResults());
+    return;
+  }
+  knownExpressions.insert(op, op);
+  knownOps.insert(op);
+}
+
+/// Erase the operations that have been replaced, along with any operands that
+/// become unused as a result.
+void SimplifyCombPass::eraseDeadOperations() {
+  // An operation may be added to the worklist several times, so remember which
+  // ones have been erased already.
+  SmallPtrSet<Operation *, 32> erased;
+  while (!maybeDead.empty()) {
+    auto *op = maybeDead.pop_back_val();
+    if (erased.contains(op) || !op->use_empty() ||
+        !isSimplifiableExpression(op))
+      continue;
+    for (auto operand : op->getOperands())
+      if (auto *defOp = operand.getDefiningOp())
+        if (defOp != op)
+          maybeDead.push_back(defOp);
+    erased.insert(op);
+    op->erase();
+    ++numErased;
+  }
+}
+
+void SimplifyCombPass::runOnOperation() {
+  simplifyBlock(*getOperation().getBodyBlock());
+  eraseDeadOperations();
+  knownOps.clear();
+}
+
+std::unique_ptr<Pass> circt::hw::createSimplifyCombPass() {
+  return std::make_unique<SimplifyCombPass>();
+}
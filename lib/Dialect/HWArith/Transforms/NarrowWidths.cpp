@@ -0,0 +1,297 @@
+//===- NarrowWidths.cpp - Narrow arithmetic to operand ranges -------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass computes the interval of values each `hwarith` value can take and
+// recreates arithmetic operations on the narrowest operand types that hold
+// these intervals.
+//
+//===----------------------------------------------------------------------===//
+
+#include "PassDetails.h"
+#include "circt/Dialect/HWArith/HWArithPasses.h"
+#include "mlir/IR/Builders.h"
+#include "llvm/ADT/TypeSwitch.h"
+
+#define DEBUG_TYPE "hwarith-narrow-widths"
+
+using namespace mlir;
+using namespace circt;
+using namespace hwarith;
+
+namespace {
+/// An inclusive interval of values. The bounds are signed integers one bit
+/// wider than the type of the value, such that both signed and unsigned
+/// values fit.
+struct Interval {
+  APInt lo, hi;
+};
+} // namespace
+
+static Interval getTypeInterval(IntegerType type) {
+  unsigned width = type.getWidth();
+  if (type.isSigned())
+    return {APInt::getSignedMinValue(width).sext(width + 1),
+            APInt::getSignedMaxValue(width).sext(width + 1)};
+  return {APInt::getZero(width + 1), APInt::getMaxValue(width).zext(width + 1)};
+}
+
+/// Sign-extend or truncate the bounds of an interval to a width.
+static Interval resize(const Interval &interval, unsigned width) {
+  return {interval.lo.sextOrTrunc(width), interval.hi.sextOrTrunc(width)};
+}
+
+/// Check whether all values of an interval fit into a type.
+static bool fits(const Interval &interval, IntegerType type) {
+  auto typeInterval = getTypeInterval(type);
+  unsigned width =
+      std::max(interval.lo.getBitWidth(), typeInterval.lo.getBitWidth());
+  auto a = resize(interval, width);
+  auto b = resize(typeInterval, width);
+  return a.lo.sge(b.lo) && a.hi.sle(b.hi);
+}
+
+/// Return the smallest and largest of a set of values.
+static Interval getHull(ArrayRef<APInt> values) {
+  Interval result{values[0], values[0]};
+  for (auto &value : values.drop_front()) {
+    if (value.slt(result.lo))
+      result.lo = value;
+    if (value.sgt(result.hi))
+      result.hi = value;
+  }
+  return result;
+}
+
+/// Return the smallest integer type with the signedness of `type` that holds
+/// all values of an interval.
+static IntegerType getNarrowType(const Interval &interval, IntegerType type) {
+  unsigned width;
+  if (type.isSigned())
+    width = std::max(interval.lo.getSignificantBits(),
+                     interval.hi.getSignificantBits());
+  else
+    width = interval.hi.getActiveBits();
+  return IntegerType::get(type.getContext(), std::max(width, 1u),
+                          type.getSignedness());
+}
+
+/// Clamp an interval to the range of a type, at the width of the intervals of
+/// that type.
+static Interval clampToType(Interval interval, IntegerType type) {
+  auto typeInterval = getTypeInterval(type);
+  unsigned width = std::max(interval.lo.getBitWidth(), type.getWidth() + 1);
+  interval = resize(interval, width);
+  auto bounds = resize(typeInterval, width);
+  if (interval.lo.slt(bounds.lo))
+    interval.lo = bounds.lo;
+  if (interval.hi.sgt(bounds.hi))
+    interval.hi = bounds.hi;
+  return resize(interval, type.getWidth() + 1);
+}
+
+/// Return the operands whose intervals the interval of a value is computed
+/// from.
+static ValueRange getIntervalOperands(Operation *op) {
+  if (isa<AddOp, SubOp, MulOp, DivOp>(op))
+    return op->getOperands();
+  if (auto castOp = dyn_cast<CastOp>(op))
+    if (!castOp.getIn().getType().cast<IntegerType>().isSignless())
+      return op->getOperands();
+  return {};
+}
+
+/// Return the result width of an arithmetic operation on the given operand
+/// types.
+static unsigned getResultWidth(Operation *op, IntegerType lhs,
+                               IntegerType rhs) {
+  return TypeSwitch<Operation *, unsigned>(op)
+      .Case<AddOp, SubOp>([&](auto) {
+        IntegerType::SignednessSemantics signedness;
+        return inferAddResultType(signedness, lhs, rhs);
+      })
+      .Case<MulOp>([&](auto) { return lhs.getWidth() + rhs.getWidth(); })
+      .Case<DivOp>([&](auto) {
+        return rhs.isSigned() ? lhs.getWidth() + 1 : lhs.getWidth();
+      });
+}
+
+namespace {
+struct NarrowWidthsPass : public NarrowWidthsBase<NarrowWidthsPass> {
+  void runOnOperation() override;
+
+  Interval getInterval(Value value);
+  Interval computeInterval(Value value);
+
+  /// The intervals computed so far.
+  DenseMap<Value, Interval> intervals;
+};
+} // namespace
+
+Interval NarrowWidthsPass::getInterval(Value value) {
+  if (auto it = intervals.find(value); it != intervals.end())
+    return it->second;
+
+  // Compute the intervals of the operands before those of their users. This
+  // uses an explicit stack since the fan-in of a value can be arbitrarily
+  // deep. Each entry is visited twice: once to queue the operands of its value,
+  // and once to compute its interval after theirs.
+  SmallVector<std::pair<Value, bool>> stack;
+  stack.push_back({value, false});
+  while (!stack.empty()) {
+    auto [current, operandsDone] = stack.back();
+    auto type = current.getType().cast<IntegerType>();
+    if (operandsDone) {
+      stack.pop_back();
+      // The interval can never exceed the range of the type.
+      intervals[current] = clampToType(computeInterval(current), type);
+      continue;
+    }
+
+    // Values queued several times are only computed once.
+    if (intervals.count(current)) {
+      stack.pop_back();
+      continue;
+    }
+
+    // Values in graph regions may depend on themselves. Assume the full range
+    // of the type until the actual interval is known.
+    stack.back().second = true;
+    intervals[current] = getTypeInterval(type);
+    if (auto *op = current.getDefiningOp())
+      for (auto operand : llvm::reverse(getIntervalOperands(op)))
+        if (!intervals.count(operand))
+          stack.push_back({operand, false});
+  }
+  return intervals.lookup(value);
+}
+
+/// Compute the interval of a value from the intervals of the operands returned
+/// by `getIntervalOperands`, which have to be known already.
+Interval NarrowWidthsPass::computeInterval(Value value) {
+  auto type = value.getType().cast<IntegerType>();
+  auto *op = value.getDefiningOp();
+  if (!op)
+    return getTypeInterval(type);
+
+  // The operations below never overflow their result type, so a margin of two
+  // bits over the result and operand widths is enough to compute their bounds
+  // exactly.
+  auto binaryOperands = [&]() {
+    auto a = intervals.lookup(op->getOperand(0));
+    auto b = intervals.lookup(op->getOperand(1));
+    unsigned width = std::max({type.getWidth(), a.lo.getBitWidth(),
+                               b.lo.getBitWidth()}) +
+                     2;
+    return std::make_pair(resize(a, width), resize(b, width));
+  };
+
+  return TypeSwitch<Operation *, Interval>(op)
+      .Case<ConstantOp>([&](auto op) {
+        APInt value = op.getConstantValue().extend(type.getWidth() + 1);
+        return Interval{value, value};
+      })
+      .Case<CastOp>([&](auto op) {
+        // Casts preserve the value if it fits into the result type, and wrap
+        // around otherwise.
+        auto inType = op.getIn().getType().template cast<IntegerType>();
+        if (inType.isSignless())
+          return getTypeInterval(type);
+        auto interval = intervals.lookup(op.getIn());
+        if (!fits(interval, type))
+          return getTypeInterval(type);
+        return interval;
+      })
+      .Case<AddOp>([&](auto) {
+        auto [a, b] = binaryOperands();
+        return Interval{a.lo + b.lo, a.hi + b.hi};
+      })
+      .Case<SubOp>([&](auto) {
+        auto [a, b] = binaryOperands();
+        return Interval{a.lo - b.hi, a.hi - b.lo};
+      })
+      .Case<MulOp>([&](auto) {
+        auto [a, b] = binaryOperands();
+        return getHull({a.lo * b.lo, a.lo * b.hi, a.hi * b.lo, a.hi * b.hi});
+      })
+      .Case<DivOp>([&](auto) {
+        // The quotient is monotonic in both operands as long as the divisor
+        // does not change its sign.
+        auto [a, b] = binaryOperands();
+        if (!(b.lo.isStrictlyPositive() || b.hi.isNegative()))
+          return getTypeInterval(type);
+        return getHull({a.lo.sdiv(b.lo), a.lo.sdiv(b.hi), a.hi.sdiv(b.lo),
+                        a.hi.sdiv(b.hi)});
+      })
+      .Default([&](auto) { return getTypeInterval(type); });
+}
+
+void NarrowWidthsPass::runOnOperation() {
+  intervals.clear();
+
+  // Compute the operand intervals of all arithmetic operations before any
+  // of them are changed.
+  SmallVector<std::pair<Operation *, std::array<Interval, 2>>> worklist;
+  getOperation()->walk([&](Operation *op) {
+    if (isa<AddOp, SubOp, MulOp, DivOp>(op))
+      worklist.push_back({op,
+                          {getInterval(op->getOperand(0)),
+                           getInterval(op->getOperand(1))}});
+  });
+
+  OpBuilder builder(&getContext());
+  for (auto &[op, operandIntervals] : worklist) {
+    auto resultType = op->getResult(0).getType().cast<IntegerType>();
+    SmallVector<IntegerType, 2> narrowTypes;
+    for (auto [operand, interval] :
+         llvm::zip(op->getOperands(), operandIntervals))
+      narrowTypes.push_back(
+          getNarrowType(interval, operand.getType().cast<IntegerType>()));
+    unsigned narrowWidth = getResultWidth(op, narrowTypes[0], narrowTypes[1]);
+    if (narrowWidth >= resultType.getWidth())
+      continue;
+
+    builder.setInsertionPoint(op);
+    auto loc = op->getLoc();
+    SmallVector<Value, 2> narrowOperands;
+    for (auto [operand, narrowType] :
+         llvm::zip(op->getOperands(), narrowTypes)) {
+      if (operand.getType() == narrowType) {
+        narrowOperands.push_back(operand);
+        continue;
+      }
+      if (auto constOp = operand.getDefiningOp<ConstantOp>()) {
+        auto value = constOp.getConstantValue().trunc(narrowType.getWidth());
+        narrowOperands.push_back(builder.create<ConstantOp>(
+            loc, builder.getIntegerAttr(narrowType, value)));
+        continue;
+      }
+      narrowOperands.push_back(
+          builder.create<CastOp>(loc, narrowType, operand));
+    }
+
+    // The narrow operation has the same result signedness, since that only
+    // depends on the signedness of the operands.
+    auto narrowResultType = IntegerType::get(&getContext(), narrowWidth,
+                                             resultType.getSignedness());
+    auto *narrowOp =
+        builder.create(loc, op->getName().getIdentifier(), narrowOperands,
+                       narrowResultType, op->getAttrs());
+    auto cast =
+        builder.create<CastOp>(loc, resultType, narrowOp->getResult(0));
+    op->getResult(0).replaceAllUsesWith(cast);
+    op->erase();
+
+    ++numOpsNarrowed;
+    numBitsSaved += resultType.getWidth() - narrowWidth;
+  }
+  intervals.clear();
+}
+
+std::unique_ptr<Pass> circt::hwarith::createNarrowWidthsPass() {
+  return std::make_unique<NarrowWidthsPass>();
+}
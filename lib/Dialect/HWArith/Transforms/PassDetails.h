@@ -0,0 +1,31 @@
+//===- PassDetails.h - HWArith pass class details ---------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Stuff shared between the different HWArith passes.
+//
+//===----------------------------------------------------------------------===//
+
+// clang-tidy seems to expect the absolute path in the header guard on some
+// systems, so just disable it.
+// NOLINTNEXTLINE(llvm-header-guard)
+#ifndef DIALECT_HWARITH_TRANSFORMS_PASSDETAILS_H
+#define DIALECT_HWARITH_TRANSFORMS_PASSDETAILS_H
+
+#include "circt/Dialect/HWArith/HWArithOps.h"
+#include "mlir/Pass/Pass.h"
+
+namespace circt {
+namespace hwarith {
+
+#define GEN_PASS_CLASSES
+#include "circt/Dialect/HWArith/Passes.h.inc"
+
+} // namespace hwarith
+} // namespace circt
+
+#endif // DIALECT_HWARITH_TRANSFORMS_PASSDETAILS_H
@@ -114,21 +114,19 @@ bool MergeOp::tryExecute(llvm::DenseMap<mlir::Value, llvm::Any> &valueMap,
                          llvm::DenseMap<mlir::Value, double> &timeMap,
                          std::vector<std::vector<llvm::Any>> & /*store*/,
                          std::vector<mlir::Value> &scheduleList) {
-  bool found = false;
-  for (mlir::Value in : getOperands()) {
-    if (valueMap.count(in) == 1) {
-      if (found)
-        emitOpError("More than one valid input to Merge!");
-      auto t = valueMap[in];
-      valueMap[getResult()] = t;
-      timeMap[getResult()] = timeMap[in];
-      // Consume the inputs.
-      valueMap.erase(in);
-      found = true;
-    }
-  }
-  if (!found)
-    emitOpError("No valid input to Merge!");
+  // The merge forwards one token at a time, and only once the previous one has
+  // been consumed. Tokens on the other inputs wait for a later execution.
+  if (valueMap.count(getResult()))
+    return false;
+  auto it = llvm::find_if(getOperands(),
+                          [&](mlir::Value in) { return valueMap.count(in); });
+  if (it == getOperands().end())
+    return false;
+  mlir::Value in = *it;
+  valueMap[getResult()] = valueMap[in];
+  timeMap[getResult()] = timeMap[in];
+  // Consume the input.
+  valueMap.erase(in);
   scheduleList.push_back(getResult());
   return true;
 }
@@ -147,7 +145,7 @@ bool MuxOp::tryExecute(llvm::DenseMap<mlir::Value, llvm::Any> &valueMap,
          "Trying to select a non-existing mux operand");
 
   mlir::Value in = getDataOperands()[opIdx];
-  if (valueMap.count(in) == 0)
+  if (valueMap.count(in) == 0 || valueMap.count(getResult()))
     return false;
   auto inValue = valueMap[in];
   auto inTime = timeMap[in];
@@ -167,27 +165,24 @@ bool ControlMergeOp::tryExecute(
     llvm::DenseMap<mlir::Value, double> &timeMap,
     std::vector<std::vector<llvm::Any>> & /*store*/,
     std::vector<mlir::Value> &scheduleList) {
-  bool found = false;
+  // Like the merge, forward one token at a time once both results are free.
+  if (valueMap.count(getResult()) || valueMap.count(getIndex()))
+    return false;
   for (auto in : llvm::enumerate(getOperands())) {
-    if (valueMap.count(in.value()) == 1) {
-      if (found)
-        emitOpError("More than one valid input to CMerge!");
-      valueMap[getResult()] = valueMap[in.value()];
-      timeMap[getResult()] = timeMap[in.value()];
-
-      valueMap[getIndex()] = APInt(INDEX_WIDTH, in.index());
-      timeMap[getIndex()] = timeMap[in.value()];
+    if (valueMap.count(in.value()) == 0)
+      continue;
+    valueMap[getResult()] = valueMap[in.value()];
+    timeMap[getResult()] = timeMap[in.value()];
 
-      // Consume the inputs.
-      valueMap.erase(in.value());
+    valueMap[getIndex()] = APInt(INDEX_WIDTH, in.index());
+    timeMap[getIndex()] = timeMap[in.value()];
 
-      found = true;
-    }
+    // Consume the input.
+    valueMap.erase(in.value());
+    scheduleList = toVector(getResults());
+    return true;
   }
-  if (!found)
-    emitOpError("No valid input to CMerge!");
-  scheduleList = toVector(getResults());
-  return true;
+  return false;
 }
 
 void BranchOp::execute(std::vector<llvm::Any> &ins,
@@ -221,6 +216,8 @@ bool ConditionalBranchOp::tryExecute(
   auto inTime = timeMap[in];
   mlir::Value out = llvm::any_cast<APInt>(controlValue) != 0 ? getTrueResult()
                                                              : getFalseResult();
+  if (valueMap.count(out))
+    return false;
   double time = std::max(controlTime, inTime);
   valueMap[out] = inValue;
   timeMap[out] = time;
@@ -237,8 +234,7 @@ bool SinkOp::tryExecute(llvm::DenseMap<mlir::Value, llvm::Any> &valueMap,
                         llvm::DenseMap<mlir::Value, double> & /*timeMap*/,
                         std::vector<std::vector<llvm::Any>> & /*store*/,
                         std::vector<mlir::Value> & /*scheduleList*/) {
-  valueMap.erase(getOperand());
-  return true;
+  return valueMap.erase(getOperand());
 }
 
 void BufferOp::execute(std::vector<llvm::Any> &ins,
@@ -282,7 +278,8 @@ executeMemoryOperation(TMemOp op, unsigned buffer, int opIndex,
     mlir::Value data = op->getOperand(opIndex++);
     mlir::Value address = op->getOperand(opIndex++);
     mlir::Value nonceOut = op->getResult(op.getLdCount() + i);
-    if ((!valueMap.count(data) || !valueMap.count(address))) {
+    if (!valueMap.count(data) || !valueMap.count(address) ||
+        valueMap.count(nonceOut)) {
       notReady = true;
       continue;
     }
@@ -312,7 +309,8 @@ executeMemoryOperation(TMemOp op, unsigned buffer, int opIndex,
     mlir::Value address = op->getOperand(opIndex++);
     mlir::Value dataOut = op->getResult(i);
     mlir::Value nonceOut = op->getResult(op.getLdCount() + op.getStCount() + i);
-    if (!valueMap.count(address)) {
+    if (!valueMap.count(address) || valueMap.count(dataOut) ||
+        valueMap.count(nonceOut)) {
       notReady = true;
       continue;
     }
@@ -362,7 +360,8 @@ bool LoadOp::tryExecute(llvm::DenseMap<mlir::Value, llvm::Any> &valueMap,
       (!valueMap.count(address) && !valueMap.count(nonce) &&
        !valueMap.count(data)))
     return false;
-  if (valueMap.count(address) && valueMap.count(nonce)) {
+  if (valueMap.count(address) && valueMap.count(nonce) &&
+      !valueMap.count(addressOut)) {
     auto addressValue = valueMap[address];
     auto addressTime = timeMap[address];
     auto nonceValue = valueMap[nonce];
@@ -374,7 +373,7 @@ bool LoadOp::tryExecute(llvm::DenseMap<mlir::Value, llvm::Any> &valueMap,
     // Consume the inputs.
     valueMap.erase(address);
     valueMap.erase(nonce);
-  } else if (valueMap.count(data)) {
+  } else if (valueMap.count(data) && !valueMap.count(dataOut)) {
     auto dataValue = valueMap[data];
     auto dataTime = timeMap[data];
     valueMap[dataOut] = dataValue;
@@ -383,7 +382,8 @@ bool LoadOp::tryExecute(llvm::DenseMap<mlir::Value, llvm::Any> &valueMap,
     // Consume the inputs.
     valueMap.erase(data);
   } else {
-    llvm_unreachable("why?");
+    // The results are still waiting to be consumed.
+    return false;
   }
   return true;
 }
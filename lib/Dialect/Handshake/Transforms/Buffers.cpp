@@ -13,13 +13,19 @@
 #include "PassDetails.h"
 #include "circt/Dialect/Handshake/HandshakeOps.h"
 #include "circt/Dialect/Handshake/HandshakePasses.h"
+#include "circt/Scheduling/Algorithms.h"
+#include "circt/Scheduling/Problems.h"
 #include "mlir/IR/PatternMatch.h"
 #include "mlir/Rewrite/FrozenRewritePatternSet.h"
 #include "mlir/Transforms/DialectConversion.h"
+#include "llvm/Support/MathExtras.h"
+
+#include <limits>
 
 using namespace circt;
 using namespace handshake;
 using namespace mlir;
+using namespace circt::scheduling;
 
 namespace {
 
@@ -168,9 +174,163 @@ static void bufferAllFIFOStrategy(Region &r, OpBuilder &builder,
                     /*bufferType=*/BufferTypeEnum::fifo);
 }
 
+// Returns the uses which close a dataflow cycle. These are the back edges of a
+// depth-first search over the operations of the region, such that the channels
+// which are not returned form an acyclic graph.
+static DenseSet<OpOperand *> getBackEdges(Region &r) {
+  struct Frame {
+    Operation *op;
+    SmallVector<OpOperand *> uses;
+    unsigned nextUse = 0;
+  };
+  auto getFrame = [](Operation *op) {
+    Frame frame{op, {}};
+    for (auto res : op->getResults())
+      for (auto &use : res.getUses())
+        frame.uses.push_back(&use);
+    return frame;
+  };
+
+  DenseSet<OpOperand *> backEdges;
+  DenseSet<Operation *> visited, onStack;
+  SmallVector<Frame> stack;
+  for (auto &root : r.getOps()) {
+    if (!visited.insert(&root).second)
+      continue;
+    stack.push_back(getFrame(&root));
+    onStack.insert(&root);
+
+    while (!stack.empty()) {
+      Frame &frame = stack.back();
+      if (frame.nextUse == frame.uses.size()) {
+        onStack.erase(frame.op);
+        stack.pop_back();
+        continue;
+      }
+      OpOperand *use = frame.uses[frame.nextUse++];
+      Operation *user = use->getOwner();
+      if (onStack.contains(user)) {
+        backEdges.insert(use);
+        continue;
+      }
+      if (!visited.insert(user).second)
+        continue;
+      stack.push_back(getFrame(user));
+      onStack.insert(user);
+    }
+  }
+  return backEdges;
+}
+
+// Place buffers such that the region sustains the given initiation interval,
+// i.e. accepts a new token every 'targetII' cycles, with as few slots as the
+// schedule allows.
+//
+// The region is modeled as a cyclic scheduling problem in which every channel
+// is a dependence, and the channels closing a dataflow cycle carry a token to
+// the next iteration. As in the cycles strategy, a single-slot sequential
+// buffer is placed at the output of the merge-like operations in a cycle, which
+// makes them the only operations with a latency, besides existing sequential
+// buffers. Once scheduled, a token waits on a channel until the last operand
+// of its consumer arrives, while a new token arrives every 'targetII' cycles.
+// Each channel therefore gets a FIFO buffer large enough to hold the tokens in
+// flight, such that the producer never stalls on a consumer which is still
+// waiting for its other operands.
+static LogicalResult bufferThroughputStrategy(Region &r, OpBuilder &builder,
+                                              unsigned targetII) {
+  auto isSeqBuffer = [](auto op) {
+    auto bufferOp = dyn_cast<handshake::BufferOp>(op);
+    return bufferOp && bufferOp.isSequential();
+  };
+
+  Operation *funcOp = r.getParentOp();
+  if (targetII == 0)
+    return funcOp->emitOpError() << "target initiation interval must be "
+                                    "positive";
+
+  auto prob = CyclicProblem::get(funcOp);
+  auto combOpr = prob.getOrInsertOperatorType("comb");
+  prob.setLatency(combOpr, 0);
+  auto seqOpr = prob.getOrInsertOperatorType("seq");
+  prob.setLatency(seqOpr, 1);
+
+  SmallVector<Operation *> cycleMerges;
+  for (auto &op : r.getOps()) {
+    prob.insertOperation(&op);
+    auto opr = combOpr;
+    if (isa<MergeLikeOpInterface>(op) && inCycle(&op, isSeqBuffer)) {
+      cycleMerges.push_back(&op);
+      opr = seqOpr;
+    } else if (auto bufferOp = dyn_cast<handshake::BufferOp>(op);
+               bufferOp && bufferOp.isSequential()) {
+      unsigned numSlots = bufferOp.getNumSlots();
+      opr = prob.getOrInsertOperatorType("seq" + std::to_string(numSlots));
+      prob.setLatency(opr, numSlots);
+    }
+    prob.setLinkedOperatorType(&op, opr);
+  }
+
+  for (auto *use : getBackEdges(r))
+    prob.setDistance(use, 1);
+
+  if (failed(prob.check()) ||
+      failed(scheduleSimplex(prob, r.front().getTerminator())) ||
+      failed(prob.verify()))
+    return failure();
+
+  unsigned minII = *prob.getInitiationInterval();
+  if (minII > targetII)
+    return funcOp->emitOpError()
+           << "cannot sustain an initiation interval of " << targetII
+           << ", the dataflow cycles require at least " << minII;
+
+  // Determine the slots of every channel before materializing any buffer, as
+  // the new buffers are not part of the problem. Merges consume one input at a
+  // time and the results of the region are separate channels, so their inputs
+  // never wait for one another.
+  auto getArrival = [&](Problem::Dependence dep) -> int64_t {
+    Operation *src = dep.getSource();
+    return *prob.getStartTime(src) +
+           *prob.getLatency(*prob.getLinkedOperatorType(src)) -
+           int64_t(targetII) * prob.getDistance(dep).value_or(0);
+  };
+  SmallVector<std::pair<OpOperand *, unsigned>> channelSlots;
+  for (auto *op : prob.getOperations()) {
+    if (isa<MergeOp, ControlMergeOp, handshake::ReturnOp>(op))
+      continue;
+    int64_t lastArrival = std::numeric_limits<int64_t>::min();
+    for (auto dep : prob.getDependences(op))
+      lastArrival = std::max(lastArrival, getArrival(dep));
+
+    for (auto dep : prob.getDependences(op)) {
+      int64_t slack = lastArrival - getArrival(dep);
+      if (slack == 0 || !isUnbufferedChannel(dep.getSource(), op))
+        continue;
+      channelSlots.push_back(
+          {&op->getOpOperand(*dep.getDestinationIndex()),
+           static_cast<unsigned>(llvm::divideCeil(slack, targetII))});
+    }
+  }
+
+  for (auto *mergeOp : cycleMerges)
+    bufferResults(builder, mergeOp, /*numSlots=*/1, BufferTypeEnum::seq);
+
+  for (auto [use, numSlots] : channelSlots) {
+    // The channels of the merge-like operations in a cycle now start at their
+    // sequential buffer, which the FIFO buffer is placed after.
+    Value channel = use->get();
+    insertBuffer(channel.getLoc(), channel, builder, numSlots,
+                 BufferTypeEnum::fifo);
+  }
+  return success();
+}
+
 LogicalResult circt::handshake::bufferRegion(Region &r, OpBuilder &builder,
                                              StringRef strategy,
-                                             unsigned bufferSize) {
+                                             unsigned bufferSize,
+                                             unsigned targetII) {
+  if (strategy == "throughput")
+    return bufferThroughputStrategy(r, builder, targetII);
   if (strategy == "cycles")
     bufferCyclesStrategy(r, builder, bufferSize);
   else if (strategy == "all")
@@ -187,9 +347,11 @@ LogicalResult circt::handshake::bufferRegion(Region &r, OpBuilder &builder,
 namespace {
 struct HandshakeInsertBuffersPass
     : public HandshakeInsertBuffersBase<HandshakeInsertBuffersPass> {
-  HandshakeInsertBuffersPass(const std::string &strategy, unsigned bufferSize) {
+  HandshakeInsertBuffersPass(const std::string &strategy, unsigned bufferSize,
+                             unsigned targetII) {
     this->strategy = strategy;
     this->bufferSize = bufferSize;
+    this->targetII = targetII;
   }
 
   void runOnOperation() override {
@@ -199,7 +361,8 @@ struct HandshakeInsertBuffersPass
 
     OpBuilder builder(f.getContext());
 
-    if (failed(bufferRegion(f.getBody(), builder, strategy, bufferSize)))
+    if (failed(bufferRegion(f.getBody(), builder, strategy, bufferSize,
+                            targetII)))
       signalPassFailure();
   }
 };
@@ -213,6 +376,8 @@ circt::handshake::createHandshakeRemoveBuffersPass() {
 
 std::unique_ptr<mlir::OperationPass<handshake::FuncOp>>
 circt::handshake::createHandshakeInsertBuffersPass(const std::string &strategy,
-                                                   unsigned bufferSize) {
-  return std::make_unique<HandshakeInsertBuffersPass>(strategy, bufferSize);
+                                                   unsigned bufferSize,
+                                                   unsigned targetII) {
+  return std::make_unique<HandshakeInsertBuffersPass>(strategy, bufferSize,
+                                                      targetII);
 }
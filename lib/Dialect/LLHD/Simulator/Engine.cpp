@@ -12,11 +12,18 @@
 
 #include "circt/Dialect/LLHD/Simulator/Engine.h"
 #include "circt/Conversion/LLHDToLLVM.h"
+#include "signals-runtime-wrappers.h"
 
 #include "mlir/ExecutionEngine/ExecutionEngine.h"
 #include "mlir/IR/Builders.h"
 
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/ThreadPool.h"
+
+#include <atomic>
 
 using namespace circt::llhd::sim;
 
@@ -24,12 +31,27 @@ Engine::Engine(
     llvm::raw_ostream &out, ModuleOp module,
     llvm::function_ref<mlir::LogicalResult(mlir::ModuleOp)> mlirTransformer,
     llvm::function_ref<llvm::Error(llvm::Module *)> llvmTransformer,
-    std::string root, TraceMode tm, ArrayRef<StringRef> sharedLibPaths)
-    : out(out), root(root), traceMode(tm) {
+    std::string root, TraceMode tm, ArrayRef<StringRef> sharedLibPaths,
+    SchedulerKind scheduler, unsigned threads, TraceEncoding te,
+    bool levelize,
+    llvm::function_ref<std::unique_ptr<llvm::Module>(mlir::Operation *,
+                                                     llvm::LLVMContext &)>
+        llvmModuleBuilder)
+    : out(out), root(root), traceMode(tm), traceEncoding(te) {
   state = std::make_unique<State>();
   state->root = root + '.' + root;
+  state->queue.setSchedulerKind(scheduler);
+
+  if (threads > 1) {
+    threadPool =
+        std::make_unique<llvm::ThreadPool>(llvm::hardware_concurrency(threads));
+    eventBuffers.resize(threads);
+  }
 
   buildLayout(module);
+  eraseUninstantiatedUnits(module);
+  if (levelize)
+    this->levelize(module);
 
   auto rootEntity = module.lookupSymbol<EntityOp>(root);
 
@@ -53,6 +75,7 @@ Engine::Engine(
   mlir::ExecutionEngineOptions options;
   options.transformer = llvmTransformer;
   options.sharedLibPaths = sharedLibPaths;
+  options.llvmModuleBuilder = llvmModuleBuilder;
   auto maybeEngine = mlir::ExecutionEngine::create(this->module, options);
   assert(maybeEngine && "failed to create JIT");
   engine = std::move(*maybeEngine);
@@ -64,12 +87,12 @@ void Engine::dumpStateLayout() { state->dumpLayout(); }
 
 void Engine::dumpStateSignalTriggers() { state->dumpSignalTriggers(); }
 
-int Engine::simulate(int n, uint64_t maxTime) {
+int Engine::simulate(int n, uint64_t maxTime, StringRef checkpointPath) {
   assert(engine && "engine not found");
   assert(state && "state not found");
 
   auto tm = static_cast<TraceMode>(traceMode);
-  Trace trace(state, out, tm);
+  Trace trace(state, out, tm, traceEncoding);
 
   SmallVector<void *, 1> arg({&state});
   // Initialize tbe simulation state.
@@ -79,6 +102,20 @@ int Engine::simulate(int n, uint64_t maxTime) {
     return -1;
   }
 
+  // Resume from a checkpoint if requested.
+  if (!checkpointPath.empty()) {
+    auto buffer = llvm::MemoryBuffer::getFile(checkpointPath);
+    if (!buffer) {
+      llvm::errs() << "Could not open checkpoint " << checkpointPath << ": "
+                   << buffer.getError().message() << "\n";
+      return -1;
+    }
+    if (auto err = state->restoreCheckpoint(**buffer)) {
+      llvm::errs() << toString(std::move(err)) << "\n";
+      return -1;
+    }
+  }
+
   if (traceMode != TraceMode::None) {
     // Add changes for all the signals' initial values.
     for (size_t i = 0, e = state->signals.size(); i < e; ++i) {
@@ -87,16 +124,25 @@ int Engine::simulate(int n, uint64_t maxTime) {
   }
 
   // Add a dummy event to get the simulation started.
-  state->queue.push_back(Slot(Time()));
-  ++state->queue.events;
+  if (checkpointPath.empty())
+    state->queue.getOrCreateSlot(Time());
+
+  // Keep track of the instances that need to wakeup. Using a bitset dedupes
+  // the wakeups and runs the instances in index order.
+  llvm::BitVector wakeupQueue(state->instances.size());
 
-  // Keep track of the instances that need to wakeup.
-  llvm::SmallVector<unsigned, 8> wakeupQueue;
+  // Scratch buffer used to apply the changes to a signal value.
+  llvm::SmallVector<uint64_t, 8> scratch;
+
+  // The instances to wake up, in order, when running in parallel.
+  llvm::SmallVector<unsigned, 0> woken;
 
   // Add all instances to the wakeup queue for the first run and add the jitted
   // function pointers to all of the instances to make them readily available.
+  // A resumed simulation only wakes up instances through its restored events.
   for (size_t i = 0, e = state->instances.size(); i < e; ++i) {
-    wakeupQueue.push_back(i);
+    if (checkpointPath.empty())
+      wakeupQueue.set(i);
     auto &inst = state->instances[i];
     auto expectedFPtr = engine->lookupPacked(inst.unit);
     if (!expectedFPtr) {
@@ -127,44 +173,30 @@ int Engine::simulate(int n, uint64_t maxTime) {
     while (i < e) {
       const auto sigIndex = pop.changes[i].first;
       auto &curr = state->signals[sigIndex];
-      APInt buff(curr.getSize() * 8, 0);
-      llvm::LoadIntFromMemory(buff, curr.getValue(), curr.getSize());
+
+      // Gather the new value of the signal in the scratch buffer, which is
+      // only grown when a wider signal than seen so far changes.
+      auto numWords = llvm::divideCeil(curr.getSize(), 8);
+      if (numWords > scratch.capacity())
+        ++state->queue.allocations;
+      if (numWords > scratch.size())
+        scratch.resize(numWords);
+      auto *buff = reinterpret_cast<uint8_t *>(scratch.data());
+      std::memcpy(buff, curr.getValue(), curr.getSize());
 
       // Apply the changes to the buffer until we reach the next signal.
       while (i < e && pop.changes[i].first == sigIndex) {
         const auto &change = pop.buffers[pop.changes[i].second];
-        const auto offset = change.first;
-        const auto &drive = change.second;
-        if (drive.getBitWidth() < buff.getBitWidth())
-          buff.insertBits(drive, offset);
-        else
-          buff = drive;
-
+        insertBits(buff, pop.getChangeBytes(change), change.bitOffset,
+                   change.width);
         ++i;
       }
 
-      if (!curr.updateWhenChanged(buff.getRawData()))
+      if (!curr.updateWhenChanged(scratch.data()))
         continue;
 
       // Add sensitive instances.
-      for (auto inst : curr.getTriggeredInstanceIndices()) {
-        // Skip if the process is not currently sensible to the signal.
-        if (!state->instances[inst].isEntity) {
-          const auto &sensList = state->instances[inst].sensitivityList;
-          auto it = std::find_if(sensList.begin(), sensList.end(),
-                                 [sigIndex](const SignalDetail &sig) {
-                                   return sig.globalIndex == sigIndex;
-                                 });
-          if (sensList.end() != it &&
-              state->instances[inst].procState->senses[it - sensList.begin()] ==
-                  0)
-            continue;
-
-          // Invalidate scheduled wakeup
-          state->instances[inst].expectedWakeup = Time();
-        }
-        wakeupQueue.push_back(inst);
-      }
+      wakeupTriggered(sigIndex, wakeupQueue);
 
       // Dump the updated signal.
       if (traceMode != TraceMode::None)
@@ -174,33 +206,28 @@ int Engine::simulate(int n, uint64_t maxTime) {
     // Add scheduled process resumes to the wakeup queue.
     for (auto inst : pop.scheduled) {
       if (state->time == state->instances[inst].expectedWakeup)
-        wakeupQueue.push_back(inst);
+        wakeupQueue.set(inst);
     }
 
     state->queue.pop();
 
-    std::sort(wakeupQueue.begin(), wakeupQueue.end());
-    wakeupQueue.erase(std::unique(wakeupQueue.begin(), wakeupQueue.end()),
-                      wakeupQueue.end());
+    // Settle the combinational entities before the remaining instances run.
+    if (!levelOrder.empty())
+      runLevelized(wakeupQueue, trace, scratch);
 
     // Run the instances present in the wakeup queue.
-    for (auto i : wakeupQueue) {
-      auto &inst = state->instances[i];
-      auto signalTable = inst.sensitivityList.data();
-
-      // Gather the instance arguments for unit invocation.
-      SmallVector<void *, 3> args;
-      if (inst.isEntity)
-        args.assign({&state, &inst.entityState, &signalTable});
-      else {
-        args.assign({&state, &inst.procState, &signalTable});
-      }
-      // Run the unit.
-      (*inst.unitFPtr)(args.data());
+    if (threadPool && wakeupQueue.count() > 1) {
+      woken.clear();
+      for (auto i : wakeupQueue.set_bits())
+        woken.push_back(i);
+      runInstancesParallel(woken);
+    } else {
+      for (auto i : wakeupQueue.set_bits())
+        runInstance(i);
     }
 
     // Clear wakeup queue.
-    wakeupQueue.clear();
+    wakeupQueue.reset();
     ++cycle;
   }
 
@@ -210,10 +237,136 @@ int Engine::simulate(int n, uint64_t maxTime) {
   }
 
   llvm::errs() << "Finished at " << state->time.toString() << " (" << cycle
-               << " cycles)\n";
+               << " cycles, " << state->queue.allocations
+               << " heap allocations)\n";
   return 0;
 }
 
+bool Engine::saveCheckpoint(StringRef path) {
+  std::error_code ec;
+  llvm::raw_fd_ostream os(path, ec);
+  if (ec) {
+    llvm::errs() << "Could not open checkpoint " << path << ": "
+                 << ec.message() << "\n";
+    return true;
+  }
+  state->saveCheckpoint(os);
+  return false;
+}
+
+void Engine::runInstance(unsigned index) {
+  auto &inst = state->instances[index];
+  auto signalTable = inst.sensitivityList.data();
+
+  // Gather the instance arguments for unit invocation.
+  SmallVector<void *, 3> args;
+  if (inst.isEntity)
+    args.assign({&state, &inst.entityState, &signalTable});
+  else {
+    args.assign({&state, &inst.procState, &signalTable});
+  }
+  // Run the unit.
+  (*inst.unitFPtr)(args.data());
+}
+
+void Engine::wakeupTriggered(unsigned sigIndex, llvm::BitVector &wakeupQueue) {
+  const auto &sig = state->signals[sigIndex];
+  const auto &triggered = sig.getTriggeredInstanceIndices();
+  const auto &senses = sig.getTriggeredSenseIndices();
+  for (size_t j = 0, f = triggered.size(); j < f; ++j) {
+    auto inst = triggered[j];
+    auto &instance = state->instances[inst];
+    // Skip if the process is not currently sensible to the signal.
+    if (!instance.isEntity) {
+      if (instance.procState->senses[senses[j]] == 0)
+        continue;
+
+      // Invalidate scheduled wakeup
+      instance.expectedWakeup = Time();
+    }
+    wakeupQueue.set(inst);
+  }
+}
+
+void Engine::runLevelized(llvm::BitVector &wakeupQueue, Trace &trace,
+                          SmallVectorImpl<uint64_t> &scratch) {
+  setEventBuffer(&levelBuffer);
+  for (auto inst : levelOrder) {
+    if (!wakeupQueue.test(inst))
+      continue;
+    levelBuffer.currentInst = inst;
+    runInstance(inst);
+
+    for (const auto &event : levelBuffer.events) {
+      // Combinational entities only drive with an epsilon delay, which is
+      // dropped here. Anything else goes through the queue as usual.
+      if (event.isWakeup ||
+          event.time.getTime() != state->time.getTime() ||
+          event.time.getDelta() != state->time.getDelta()) {
+        levelBuffer.commit(state->queue, event);
+        continue;
+      }
+
+      auto &sig = state->signals[event.index];
+      auto numWords = llvm::divideCeil(sig.getSize(), 8);
+      if (numWords > scratch.size())
+        scratch.resize(numWords);
+      auto *buff = reinterpret_cast<uint8_t *>(scratch.data());
+      std::memcpy(buff, sig.getValue(), sig.getSize());
+      insertBits(buff, levelBuffer.arena.data() + event.arenaOffset,
+                 event.bitOffset, event.width);
+      if (!sig.updateWhenChanged(scratch.data()))
+        continue;
+
+      // The instances probing the signal come later in the order, or are
+      // evaluated by the event-driven loop.
+      wakeupTriggered(event.index, wakeupQueue);
+      if (traceMode != TraceMode::None)
+        trace.addChange(event.index);
+    }
+    levelBuffer.clear();
+  }
+  setEventBuffer(nullptr);
+
+  // The levelized instances that were woken by their own drives have nothing
+  // left to compute.
+  wakeupQueue.reset(levelized);
+}
+
+void Engine::runInstancesParallel(ArrayRef<unsigned> indices) {
+  // Each worker repeatedly grabs the next instance to run, such that the load
+  // balances itself across workers. The events emitted by the units are
+  // collected in the worker's buffer instead of the shared queue.
+  std::atomic<size_t> next(0);
+  for (auto &buffer : eventBuffers) {
+    threadPool->async([&] {
+      setEventBuffer(&buffer);
+      for (size_t i = next++, e = indices.size(); i < e; i = next++) {
+        buffer.currentInst = indices[i];
+        runInstance(indices[i]);
+      }
+      setEventBuffer(nullptr);
+    });
+  }
+  threadPool->wait();
+
+  // Commit the buffered events in instance order. All the events of an
+  // instance are contiguous in one buffer, so a stable sort preserves the
+  // order in which each instance emitted them.
+  pendingEvents.clear();
+  for (auto &buffer : eventBuffers)
+    for (const auto &event : buffer.events)
+      pendingEvents.push_back(std::make_pair(&buffer, &event));
+  llvm::stable_sort(pendingEvents, [](const auto &lhs, const auto &rhs) {
+    return lhs.second->inst < rhs.second->inst;
+  });
+  for (auto [buffer, event] : pendingEvents)
+    buffer->commit(state->queue, *event);
+
+  for (auto &buffer : eventBuffers)
+    buffer.clear();
+}
+
 void Engine::buildLayout(ModuleOp module) {
   // Start from the root entity.
   auto rootEntity = module.lookupSymbol<EntityOp>(root);
@@ -236,12 +389,123 @@ void Engine::buildLayout(ModuleOp module) {
   // Add triggers to signals.
   for (size_t i = 0, e = state->instances.size(); i < e; ++i) {
     auto &inst = state->instances[i];
-    for (auto trigger : inst.sensitivityList) {
-      state->signals[trigger.globalIndex].pushInstanceIndex(i);
+    for (size_t j = 0, f = inst.sensitivityList.size(); j < f; ++j) {
+      auto globalIndex = inst.sensitivityList[j].globalIndex;
+      state->signals[globalIndex].pushInstanceIndex(i, j);
     }
   }
 }
 
+void Engine::eraseUninstantiatedUnits(ModuleOp module) {
+  llvm::StringSet<> units;
+  for (auto &inst : state->instances)
+    units.insert(inst.unit);
+
+  SmallVector<Operation *> unused;
+  for (auto &op : *module.getBody())
+    if (isa<EntityOp, ProcOp>(op) &&
+        !units.contains(SymbolTable::getSymbolName(&op).getValue()))
+      unused.push_back(&op);
+  for (auto *op : unused)
+    op->erase();
+}
+
+/// Collect the global indices of the signals an entity instance probes and
+/// drives. Fails if a signal cannot be traced back to the instance's
+/// sensitivity list.
+static LogicalResult collectSignalUses(EntityOp entity, const Instance &inst,
+                                       SmallVectorImpl<unsigned> &reads,
+                                       SmallVectorImpl<unsigned> &drives) {
+  // The sensitivity list holds the unit's arguments followed by the signals
+  // the unit defines, in order.
+  DenseMap<Value, unsigned> sensIndices;
+  for (auto arg : entity.getArguments())
+    sensIndices.insert({arg, sensIndices.size()});
+  for (auto sigOp : entity.getBodyBlock()->getOps<SigOp>())
+    sensIndices.insert({sigOp, sensIndices.size()});
+  if (sensIndices.size() != inst.sensitivityList.size())
+    return failure();
+
+  auto resolve = [&](Value sig, SmallVectorImpl<unsigned> &indices) {
+    // Look through the extractions of signal slices and elements.
+    while (auto *op = sig.getDefiningOp()) {
+      if (isa<SigOp>(op))
+        break;
+      if (op->getNumOperands() == 0 ||
+          !op->getOperand(0).getType().isa<SigType>())
+        return failure();
+      sig = op->getOperand(0);
+    }
+    auto it = sensIndices.find(sig);
+    if (it == sensIndices.end())
+      return failure();
+    indices.push_back(inst.sensitivityList[it->second].globalIndex);
+    return success();
+  };
+
+  auto result = entity.walk([&](Operation *op) {
+    if (auto prbOp = dyn_cast<PrbOp>(op))
+      if (failed(resolve(prbOp.getSignal(), reads)))
+        return WalkResult::interrupt();
+    if (auto drvOp = dyn_cast<DrvOp>(op))
+      if (failed(resolve(drvOp.getSignal(), drives)))
+        return WalkResult::interrupt();
+    return WalkResult::advance();
+  });
+  return failure(result.wasInterrupted());
+}
+
+void Engine::levelize(ModuleOp module) {
+  auto numInsts = state->instances.size();
+  SmallVector<SmallVector<unsigned, 4>, 0> reads(numInsts), drives(numInsts);
+  SmallVector<unsigned> candidates;
+  for (unsigned i = 0; i < numInsts; ++i) {
+    auto &inst = state->instances[i];
+    if (!inst.isEntity)
+      continue;
+    auto entity = module.lookupSymbol<EntityOp>(inst.unit);
+    if (!entity || !entity->hasAttr(EntityOp::getCombinationalAttrName()))
+      continue;
+    if (succeeded(collectSignalUses(entity, inst, reads[i], drives[i])))
+      candidates.push_back(i);
+  }
+
+  // Add an edge from every candidate driving a signal to every candidate
+  // probing it. A candidate probing its own output is its own predecessor and
+  // is never ordered.
+  DenseMap<unsigned, SmallVector<unsigned, 2>> driversOf;
+  for (auto inst : candidates)
+    for (auto sigIndex : drives[inst])
+      driversOf[sigIndex].push_back(inst);
+  SmallVector<unsigned, 0> numPreds(numInsts, 0);
+  SmallVector<SmallVector<unsigned, 2>, 0> succs(numInsts);
+  for (auto inst : candidates) {
+    for (auto sigIndex : reads[inst]) {
+      auto it = driversOf.find(sigIndex);
+      if (it == driversOf.end())
+        continue;
+      for (auto driver : it->second) {
+        succs[driver].push_back(inst);
+        ++numPreds[inst];
+      }
+    }
+  }
+
+  // Order the candidates topologically. The candidates that are never reached
+  // stay event-driven.
+  for (auto inst : candidates)
+    if (numPreds[inst] == 0)
+      levelOrder.push_back(inst);
+  for (size_t i = 0; i < levelOrder.size(); ++i)
+    for (auto succ : succs[levelOrder[i]])
+      if (--numPreds[succ] == 0)
+        levelOrder.push_back(succ);
+
+  levelized.resize(numInsts);
+  for (auto inst : levelOrder)
+    levelized.set(inst);
+}
+
 void Engine::walkEntity(EntityOp entity, Instance &child) {
   entity.walk([&](Operation *op) {
     assert(op);
@@ -14,8 +14,12 @@
 #include "circt/Dialect/LLHD/Simulator/State.h"
 
 #include "llvm/Support/Format.h"
+#include "llvm/Support/MemoryBufferRef.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <cstddef>
+#include <cstring>
 #include <string>
 
 using namespace llvm;
@@ -66,26 +70,49 @@ Signal::~Signal() {
 // Slot
 //===----------------------------------------------------------------------===//
 
+void circt::llhd::sim::insertBits(uint8_t *dst, const uint8_t *src,
+                                  uint64_t bitOffset, uint64_t width) {
+  // Byte-aligned drives are copied directly, only the trailing partial byte
+  // needs to be masked in.
+  if (bitOffset % 8 == 0) {
+    auto *base = dst + bitOffset / 8;
+    auto bytes = width / 8;
+    std::memcpy(base, src, bytes);
+    if (auto rem = width % 8) {
+      uint8_t mask = (1u << rem) - 1;
+      base[bytes] = (base[bytes] & ~mask) | (src[bytes] & mask);
+    }
+    return;
+  }
+
+  // Otherwise insert the drive bit by bit.
+  for (uint64_t i = 0; i < width; ++i) {
+    auto dstBit = bitOffset + i;
+    uint8_t bit = (src[i / 8] >> (i % 8)) & 1;
+    auto &dstByte = dst[dstBit / 8];
+    dstByte = (dstByte & ~(1u << (dstBit % 8))) | (bit << (dstBit % 8));
+  }
+}
+
 bool Slot::operator<(const Slot &rhs) const { return time < rhs.time; }
 
 bool Slot::operator>(const Slot &rhs) const { return rhs.time < time; }
 
 void Slot::insertChange(int index, int bitOffset, uint8_t *bytes,
                         unsigned width) {
-  // Get the amount of 64 bit words required to store the value in an APInt.
+  // Copy the driven value to the end of the change arena.
   auto size = llvm::divideCeil(width, 8);
+  auto arenaOffset = arena.size();
+  arena.append(bytes, bytes + size);
 
-  APInt buffer(width, 0);
-  llvm::LoadIntFromMemory(buffer, bytes, size);
-  auto offsetBufferPair = std::make_pair(bitOffset, buffer);
-
+  Change change{static_cast<uint64_t>(bitOffset), width, arenaOffset};
   if (changesSize >= buffers.size()) {
     // Create a new change buffer if we don't have any unused one available for
     // reuse.
-    buffers.push_back(offsetBufferPair);
+    buffers.push_back(change);
   } else {
     // Reuse the first available buffer.
-    buffers[changesSize] = offsetBufferPair;
+    buffers[changesSize] = change;
   }
 
   // Map the signal index to the change buffer so we can retrieve
@@ -102,15 +129,32 @@ void Slot::insertChange(unsigned inst) { scheduled.push_back(inst); }
 void UpdateQueue::insertOrUpdate(Time time, int index, int bitOffset,
                                  uint8_t *bytes, unsigned width) {
   auto &slot = getOrCreateSlot(time);
+  auto capacity = slot.getCapacity();
   slot.insertChange(index, bitOffset, bytes, width);
+  if (slot.getCapacity() != capacity)
+    ++allocations;
 }
 
 void UpdateQueue::insertOrUpdate(Time time, unsigned inst) {
   auto &slot = getOrCreateSlot(time);
+  auto capacity = slot.getCapacity();
   slot.insertChange(inst);
+  if (slot.getCapacity() != capacity)
+    ++allocations;
 }
 
 Slot &UpdateQueue::getOrCreateSlot(Time time) {
+  if (kind == SchedulerKind::Calendar)
+    return getOrCreateCalendarSlot(time);
+
+  // Spawn the very first event.
+  if (empty()) {
+    push_back(Slot(time));
+    topSlot = 0;
+    ++events;
+    return back();
+  }
+
   auto &top = begin()[topSlot];
 
   // Directly add to top slot.
@@ -146,19 +190,127 @@ Slot &UpdateQueue::getOrCreateSlot(Time time) {
     return newSlot;
   }
 
+  // Check whether the top has to be updated before pushing the new slot, as
+  // this might invalidate the reference to the current top.
+  bool isNewTop = top.unused || time < top.time;
+
   // We do not have pre-allocated slots available, generate a new one.
+  if (size() == capacity())
+    ++allocations;
   push_back(Slot(time));
 
   // Update the top of the queue either if it is currently unused or the new
   // timestamp is earlier than it.
-  if (top.unused || time < top.time)
+  if (isNewTop)
     topSlot = size() - 1;
 
   ++events;
   return back();
 }
 
+unsigned UpdateQueue::allocateSlot(Time time) {
+  ++events;
+
+  // Reuse an existing slot if available.
+  if (!unused.empty()) {
+    auto index = unused.pop_back_val();
+    auto &slot = begin()[index];
+    slot.unused = false;
+    slot.time = time;
+    return index;
+  }
+
+  // We do not have pre-allocated slots available, generate a new one.
+  if (size() == capacity())
+    ++allocations;
+  push_back(Slot(time));
+  return size() - 1;
+}
+
+bool UpdateQueue::isInWheel(Time time) const {
+  return time.getTime() == wheelBase.getTime() &&
+         time.getDelta() >= wheelBase.getDelta() &&
+         time.getDelta() - wheelBase.getDelta() < wheelSize;
+}
+
+void UpdateQueue::insertInWheel(unsigned index) {
+  const auto &time = begin()[index].time;
+  unsigned bucketIndex = time.getDelta() % wheelSize;
+  auto &bucket = wheel[bucketIndex];
+  if (bucket.size() == bucket.capacity())
+    ++allocations;
+  auto *it = llvm::lower_bound(bucket, time.getEps(),
+                               [&](unsigned slot, uint64_t eps) {
+                                 return begin()[slot].time.getEps() < eps;
+                               });
+  bucket.insert(it, index);
+  wheelMask |= uint64_t(1) << bucketIndex;
+}
+
+void UpdateQueue::rebaseWheel(Time time) {
+  // Moving to a new real time step is only possible once the wheel has been
+  // drained, as all its slots share the real time of the current base.
+  assert((wheelMask == 0 || time.getTime() == wheelBase.getTime()) &&
+         "cannot move a non-empty time wheel to a new real time step");
+  wheelBase = time;
+
+  // The overflow queue is ordered, so all the slots that fall into the new
+  // window are at its front.
+  while (!overflow.empty() && isInWheel(overflow.begin()->first)) {
+    insertInWheel(overflow.begin()->second);
+    overflow.erase(overflow.begin());
+  }
+}
+
+Slot &UpdateQueue::getOrCreateCalendarSlot(Time time) {
+  // Far events are looked up in the ordered overflow queue.
+  if (!isInWheel(time)) {
+    auto it = overflow.find(time);
+    if (it != overflow.end())
+      return begin()[it->second];
+
+    auto index = allocateSlot(time);
+    overflow.insert(std::make_pair(time, index));
+    ++allocations;
+    return begin()[index];
+  }
+
+  // Near events only require a lookup in the bucket of their delta step, which
+  // usually only contains very few slots.
+  auto &bucket = wheel[time.getDelta() % wheelSize];
+  for (auto index : bucket)
+    if (begin()[index].time == time)
+      return begin()[index];
+
+  auto index = allocateSlot(time);
+  insertInWheel(index);
+  return begin()[index];
+}
+
+unsigned UpdateQueue::findCalendarTop() const {
+  assert(events > 0 && "the event queue is empty");
+
+  // All the slots in the wheel are earlier than the ones in the overflow
+  // queue. Rotate the bucket mask such that the wheel base is at bit zero, the
+  // first set bit then denotes the earliest non-empty delta step.
+  if (wheelMask != 0) {
+    unsigned baseBucket = wheelBase.getDelta() % wheelSize;
+    uint64_t rotated = wheelMask >> baseBucket;
+    if (baseBucket != 0)
+      rotated |= wheelMask << (wheelSize - baseBucket);
+    unsigned bucketIndex =
+        (baseBucket + llvm::countTrailingZeros(rotated)) % wheelSize;
+    return wheel[bucketIndex].front();
+  }
+
+  assert(!overflow.empty() && "event count and slots are out of sync");
+  return overflow.begin()->second;
+}
+
 const Slot &UpdateQueue::top() {
+  if (kind == SchedulerKind::Calendar)
+    topSlot = findCalendarTop();
+
   assert(topSlot < size() && "top is pointing out of bounds!");
 
   // Sort the changes of the top slot such that all changes to the same signal
@@ -169,18 +321,42 @@ const Slot &UpdateQueue::top() {
 }
 
 void UpdateQueue::pop() {
+  Time popTime;
+  if (kind == SchedulerKind::Calendar) {
+    // Remove the top slot from the wheel or the overflow queue.
+    topSlot = findCalendarTop();
+    popTime = begin()[topSlot].time;
+    if (isInWheel(popTime)) {
+      unsigned bucketIndex = popTime.getDelta() % wheelSize;
+      auto &bucket = wheel[bucketIndex];
+      bucket.erase(bucket.begin());
+      if (bucket.empty())
+        wheelMask &= ~(uint64_t(1) << bucketIndex);
+    } else {
+      overflow.erase(overflow.begin());
+    }
+  }
+
   // Reset internal structures and decrease the event counter.
   auto &curr = begin()[topSlot];
   curr.unused = true;
   curr.changesSize = 0;
   curr.scheduled.clear();
   curr.changes.clear();
+  curr.arena.clear();
   curr.time = Time();
   --events;
 
   // Add to unused slots list for easy retrieval.
   unused.push_back(topSlot);
 
+  if (kind == SchedulerKind::Calendar) {
+    // All the following events are scheduled at or after the popped time, so
+    // the wheel window can be moved forward.
+    rebaseWheel(popTime);
+    return;
+  }
+
   // Update the current top of the queue.
   topSlot = std::distance(
       begin(),
@@ -191,6 +367,31 @@ void UpdateQueue::pop() {
       }));
 }
 
+//===----------------------------------------------------------------------===//
+// EventBuffer
+//===----------------------------------------------------------------------===//
+
+void EventBuffer::insertOrUpdate(Time time, int index, int bitOffset,
+                                 uint8_t *bytes, unsigned width) {
+  auto size = llvm::divideCeil(width, 8);
+  auto arenaOffset = arena.size();
+  arena.insert(arena.end(), bytes, bytes + size);
+  events.push_back(
+      Event{currentInst, time, false, index, bitOffset, width, arenaOffset});
+}
+
+void EventBuffer::insertOrUpdate(Time time, unsigned inst) {
+  events.push_back(Event{inst, time, true, 0, 0, 0, 0});
+}
+
+void EventBuffer::commit(UpdateQueue &queue, const Event &event) {
+  if (event.isWakeup)
+    queue.insertOrUpdate(event.time, event.inst);
+  else
+    queue.insertOrUpdate(event.time, event.index, event.bitOffset,
+                         arena.data() + event.arenaOffset, event.width);
+}
+
 //===----------------------------------------------------------------------===//
 // Instance
 //===----------------------------------------------------------------------===//
@@ -243,12 +444,14 @@ int State::addSignal(std::string name, std::string owner) {
   return signals.size() - 1;
 }
 
-void State::addProcPtr(std::string name, ProcState *procStatePtr) {
+void State::addProcPtr(std::string name, ProcState *procStatePtr,
+                       uint64_t size) {
   auto it = getInstanceIterator(name);
 
   // Store instance index in process state.
   procStatePtr->inst = it - instances.begin();
   (*it).procState = procStatePtr;
+  (*it).stateSize = size;
 }
 
 int State::addSignalData(int index, std::string owner, uint8_t *value,
@@ -263,13 +466,10 @@ int State::addSignalData(int index, std::string owner, uint8_t *value,
 
   // Add the value pointer to the signal detail struct for each instance this
   // signal appears in.
-  for (auto inst : signals[globalIdx].getTriggeredInstanceIndices()) {
-    for (auto &detail : instances[inst].sensitivityList) {
-      if (detail.globalIndex == globalIdx) {
-        detail.value = sig.getValue();
-      }
-    }
-  }
+  const auto &triggered = sig.getTriggeredInstanceIndices();
+  const auto &senses = sig.getTriggeredSenseIndices();
+  for (size_t i = 0, e = triggered.size(); i < e; ++i)
+    instances[triggered[i]].sensitivityList[senses[i]].value = sig.getValue();
   return globalIdx;
 }
 
@@ -312,3 +512,284 @@ void State::dumpSignalTriggers() {
   }
   llvm::errs() << "::----------------------------------------------::\n";
 }
+
+//===----------------------------------------------------------------------===//
+// Checkpointing
+//===----------------------------------------------------------------------===//
+
+/// The magic bytes starting a checkpoint, including the format version.
+static constexpr char checkpointMagic[8] = {'L', 'L', 'H', 'D',
+                                            'C', 'K', 'P', '1'};
+
+namespace {
+/// A pointer found in a process or entity state, pointing into the value of a
+/// signal. Such pointers are stored relative to the signal, as the signal
+/// values live at different addresses when the checkpoint is restored.
+struct Relocation {
+  uint64_t stateOffset;
+  uint64_t sigIndex;
+  uint64_t sigOffset;
+};
+
+/// Sequential reader over a checkpoint buffer.
+class CheckpointReader {
+public:
+  CheckpointReader(StringRef data) : data(data) {}
+
+  const uint8_t *readBytes(uint64_t size) {
+    if (failed || size > data.size() - pos) {
+      failed = true;
+      return nullptr;
+    }
+    auto *ptr = reinterpret_cast<const uint8_t *>(data.data() + pos);
+    pos += size;
+    return ptr;
+  }
+
+  uint64_t readU64() {
+    uint64_t value = 0;
+    if (auto *bytes = readBytes(sizeof(value)))
+      std::memcpy(&value, bytes, sizeof(value));
+    return value;
+  }
+
+  Time readTime() {
+    auto time = readU64();
+    auto delta = readU64();
+    auto eps = readU64();
+    return Time(time, delta, eps);
+  }
+
+  bool failed = false;
+
+private:
+  StringRef data;
+  size_t pos = 0;
+};
+} // namespace
+
+/// Return the process or entity state of an instance.
+static uint8_t *getStateBlob(const Instance &inst) {
+  if (inst.isEntity)
+    return inst.entityState;
+  return reinterpret_cast<uint8_t *>(inst.procState);
+}
+
+void State::saveCheckpoint(llvm::raw_ostream &out) {
+  auto writeU64 = [&](uint64_t value) {
+    out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+  };
+  auto writeTime = [&](const Time &time) {
+    writeU64(time.getTime());
+    writeU64(time.getDelta());
+    writeU64(time.getEps());
+  };
+
+  out.write(checkpointMagic, sizeof(checkpointMagic));
+  writeTime(time);
+
+  // Signal values.
+  writeU64(signals.size());
+  for (auto &sig : signals) {
+    writeU64(sig.getSize());
+    out.write(reinterpret_cast<const char *>(sig.getValue()), sig.getSize());
+  }
+
+  // Sort the signal values by address, to find the pointers into them.
+  SmallVector<std::pair<const uint8_t *, unsigned>> sigAddresses;
+  for (size_t i = 0, e = signals.size(); i < e; ++i)
+    sigAddresses.push_back(std::make_pair(signals[i].getValue(), i));
+  llvm::sort(sigAddresses);
+
+  // Process and entity states.
+  writeU64(instances.size());
+  SmallVector<Relocation> relocations;
+  for (auto &inst : instances) {
+    auto *blob = getStateBlob(inst);
+    uint64_t size = blob ? inst.stateSize : 0;
+    writeU64(inst.isEntity);
+    writeTime(inst.expectedWakeup);
+    writeU64(size);
+    out.write(reinterpret_cast<const char *>(blob), size);
+
+    if (!inst.isEntity) {
+      auto numSenses = inst.procState ? inst.sensitivityList.size() : 0;
+      writeU64(numSenses);
+      if (numSenses)
+        out.write(reinterpret_cast<const char *>(inst.procState->senses),
+                  numSenses);
+    }
+
+    // Find all the pointer-aligned words pointing into a signal value, which
+    // are signal structs persisted across process suspension.
+    relocations.clear();
+    for (uint64_t offset = 0; offset + sizeof(void *) <= size;
+         offset += alignof(void *)) {
+      if (!inst.isEntity && offset == offsetof(ProcState, senses))
+        continue;
+      const uint8_t *ptr;
+      std::memcpy(&ptr, blob + offset, sizeof(ptr));
+      auto *it = llvm::upper_bound(
+          sigAddresses, ptr, [](const uint8_t *ptr, const auto &entry) {
+            return ptr < entry.first;
+          });
+      if (it == sigAddresses.begin())
+        continue;
+      --it;
+      auto &sig = signals[it->second];
+      if (ptr >= sig.getValue() + sig.getSize())
+        continue;
+      relocations.push_back(Relocation{
+          offset, it->second, static_cast<uint64_t>(ptr - sig.getValue())});
+    }
+    writeU64(relocations.size());
+    for (auto &reloc : relocations) {
+      writeU64(reloc.stateOffset);
+      writeU64(reloc.sigIndex);
+      writeU64(reloc.sigOffset);
+    }
+  }
+
+  // Pending events.
+  writeU64(queue.events);
+  SmallVector<unsigned> sigOfChange;
+  for (auto &slot : queue) {
+    if (slot.unused)
+      continue;
+    writeTime(slot.time);
+
+    // Write the changes in insertion order, such that restoring them keeps the
+    // order in which drives to the same signal are applied.
+    sigOfChange.assign(slot.changesSize, 0);
+    for (auto [sigIndex, change] : slot.changes)
+      sigOfChange[change] = sigIndex;
+    writeU64(slot.changesSize);
+    for (size_t i = 0; i < slot.changesSize; ++i) {
+      const auto &change = slot.buffers[i];
+      writeU64(sigOfChange[i]);
+      writeU64(change.bitOffset);
+      writeU64(change.width);
+      out.write(reinterpret_cast<const char *>(slot.getChangeBytes(change)),
+                llvm::divideCeil(change.width, 8));
+    }
+
+    writeU64(slot.scheduled.size());
+    for (auto inst : slot.scheduled)
+      writeU64(inst);
+  }
+}
+
+llvm::Error State::restoreCheckpoint(llvm::MemoryBufferRef buffer) {
+  auto error = [&](const Twine &message) -> llvm::Error {
+    return llvm::make_error<llvm::StringError>(
+        "checkpoint " + buffer.getBufferIdentifier() + " " + message,
+        llvm::inconvertibleErrorCode());
+  };
+  auto mismatch = [&](const Twine &what) {
+    return error("does not match the design: " + what);
+  };
+
+  CheckpointReader reader(buffer.getBuffer());
+  auto *magic = reader.readBytes(sizeof(checkpointMagic));
+  if (!magic || std::memcmp(magic, checkpointMagic, sizeof(checkpointMagic)))
+    return error("is not an llhd-sim checkpoint");
+  assert(queue.events == 0 && "can only restore into an empty queue");
+  time = reader.readTime();
+
+  // Signal values.
+  if (reader.readU64() != signals.size())
+    return mismatch("different number of signals");
+  for (auto &sig : signals) {
+    auto size = reader.readU64();
+    if (size != sig.getSize())
+      return mismatch("different size of signal " + sig.getOwner() + "/" +
+                      sig.getName());
+    if (auto *bytes = reader.readBytes(size))
+      std::memcpy(sig.getValue(), bytes, size);
+  }
+
+  // Process and entity states.
+  if (reader.readU64() != instances.size())
+    return mismatch("different number of instances");
+  for (auto &inst : instances) {
+    if (reader.readU64() != inst.isEntity)
+      return mismatch("different kind of instance " + inst.name);
+    inst.expectedWakeup = reader.readTime();
+
+    auto *blob = getStateBlob(inst);
+    auto size = reader.readU64();
+    if (size != (blob ? inst.stateSize : 0))
+      return mismatch("different state size of instance " + inst.name);
+    auto *bytes = reader.readBytes(size);
+    if (reader.failed)
+      break;
+
+    if (inst.isEntity) {
+      if (size)
+        std::memcpy(blob, bytes, size);
+    } else {
+      auto numSenses = reader.readU64();
+      auto *sensesBytes = reader.readBytes(numSenses);
+      if (reader.failed)
+        break;
+
+      if (inst.procState) {
+        if (numSenses != inst.sensitivityList.size())
+          return mismatch("different number of senses of instance " +
+                          inst.name);
+
+        // Keep the senses table allocated for this run and restore its
+        // content.
+        auto *senses = inst.procState->senses;
+        std::memcpy(blob, bytes, size);
+        inst.procState->senses = senses;
+        std::memcpy(senses, sensesBytes, numSenses);
+      }
+    }
+
+    // Point the persisted signal pointers to the signal values of this run.
+    auto numRelocations = reader.readU64();
+    for (uint64_t i = 0; i < numRelocations && !reader.failed; ++i) {
+      auto stateOffset = reader.readU64();
+      auto sigIndex = reader.readU64();
+      auto sigOffset = reader.readU64();
+      if (stateOffset + sizeof(void *) > size || sigIndex >= signals.size())
+        return mismatch("invalid state of instance " + inst.name);
+      uint8_t *ptr = signals[sigIndex].getValue() + sigOffset;
+      std::memcpy(blob + stateOffset, &ptr, sizeof(ptr));
+    }
+  }
+
+  // Pending events.
+  auto numSlots = reader.readU64();
+  for (uint64_t i = 0; i < numSlots && !reader.failed; ++i) {
+    auto slotTime = reader.readTime();
+    auto numChanges = reader.readU64();
+    for (uint64_t j = 0; j < numChanges && !reader.failed; ++j) {
+      auto sigIndex = reader.readU64();
+      auto bitOffset = reader.readU64();
+      auto width = reader.readU64();
+      auto *bytes = reader.readBytes(llvm::divideCeil(width, 8));
+      if (reader.failed)
+        break;
+      if (sigIndex >= signals.size())
+        return mismatch("invalid event");
+      queue.insertOrUpdate(slotTime, static_cast<int>(sigIndex),
+                           static_cast<int>(bitOffset),
+                           const_cast<uint8_t *>(bytes),
+                           static_cast<unsigned>(width));
+    }
+
+    auto numScheduled = reader.readU64();
+    for (uint64_t j = 0; j < numScheduled && !reader.failed; ++j) {
+      auto inst = reader.readU64();
+      if (inst >= instances.size())
+        return mismatch("invalid event");
+      queue.insertOrUpdate(slotTime, static_cast<unsigned>(inst));
+    }
+  }
+
+  if (reader.failed)
+    return error("is truncated");
+  return llvm::Error::success();
+}
@@ -13,12 +13,184 @@
 
 #include "circt/Dialect/LLHD/Simulator/Trace.h"
 
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/Compression.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+
 using namespace circt::llhd::sim;
 
+//===----------------------------------------------------------------------===//
+// TraceBlockWriter
+//===----------------------------------------------------------------------===//
+
+namespace circt {
+namespace llhd {
+namespace sim {
+
+/// Collects the records of the binary trace in fixed-size blocks, which are
+/// compressed and written to the output stream on a background thread such
+/// that the simulation does not wait on I/O.
+class TraceBlockWriter {
+public:
+  TraceBlockWriter(llvm::raw_ostream &out);
+  ~TraceBlockWriter() { finish(); }
+
+  void writeU8(uint8_t value) { current.push_back(value); }
+
+  void writeU32(uint32_t value) {
+    for (unsigned i = 0; i < 4; ++i)
+      current.push_back(value >> (8 * i));
+  }
+
+  void writeU64(uint64_t value) {
+    for (unsigned i = 0; i < 8; ++i)
+      current.push_back(value >> (8 * i));
+  }
+
+  void writeBytes(const uint8_t *bytes, size_t size) {
+    current.insert(current.end(), bytes, bytes + size);
+  }
+
+  /// Mark the end of a record. Records never span multiple blocks, so this is
+  /// where a full block is handed off to the background thread.
+  void endRecord() {
+    if (current.size() >= blockSize)
+      submit();
+  }
+
+  /// Write all pending blocks and stop the background thread.
+  void finish();
+
+private:
+  /// Hand the current block off to the background thread.
+  void submit();
+
+  /// Encode a block and write it to the output stream.
+  void writeBlock(const std::vector<uint8_t> &payload);
+
+  /// The background thread routine.
+  void run();
+
+  /// The payload size above which a block is submitted.
+  static constexpr size_t blockSize = 64 * 1024;
+  /// The maximum number of blocks waiting to be written before the simulation
+  /// thread blocks.
+  static constexpr size_t maxPendingBlocks = 8;
+
+  llvm::raw_ostream &out;
+  std::vector<uint8_t> current;
+  std::deque<std::vector<uint8_t>> pending;
+  std::vector<std::vector<uint8_t>> recycled;
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool done = false;
+  std::thread thread;
+};
+
+} // namespace sim
+} // namespace llhd
+} // namespace circt
+
+TraceBlockWriter::TraceBlockWriter(llvm::raw_ostream &out) : out(out) {
+  out << "LLHDTRC";
+  out << static_cast<char>(1);
+  current.reserve(blockSize);
+  thread = std::thread([this] { run(); });
+}
+
+void TraceBlockWriter::submit() {
+  if (current.empty())
+    return;
+
+  std::unique_lock<std::mutex> lock(mutex);
+  cv.wait(lock, [&] { return pending.size() < maxPendingBlocks; });
+  pending.push_back(std::move(current));
+
+  // Reuse the storage of an already written block for the next one.
+  if (!recycled.empty()) {
+    current = std::move(recycled.back());
+    recycled.pop_back();
+  } else {
+    current = std::vector<uint8_t>();
+    current.reserve(blockSize);
+  }
+  current.clear();
+  lock.unlock();
+  cv.notify_all();
+}
+
+void TraceBlockWriter::finish() {
+  if (!thread.joinable())
+    return;
+
+  submit();
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    done = true;
+  }
+  cv.notify_all();
+  thread.join();
+  out.flush();
+}
+
+void TraceBlockWriter::writeBlock(const std::vector<uint8_t> &payload) {
+  auto writeU32 = [&](uint32_t value) {
+    for (unsigned i = 0; i < 4; ++i)
+      out << static_cast<char>((value >> (8 * i)) & 0xff);
+  };
+
+  llvm::ArrayRef<uint8_t> stored(payload);
+  llvm::SmallVector<uint8_t, 0> compressed;
+  bool isCompressed = false;
+  if (llvm::compression::zlib::isAvailable()) {
+    llvm::compression::zlib::compress(
+        payload, compressed, llvm::compression::zlib::BestSpeedCompression);
+    if (compressed.size() < payload.size()) {
+      stored = compressed;
+      isCompressed = true;
+    }
+  }
+
+  out << static_cast<char>(isCompressed);
+  writeU32(payload.size());
+  writeU32(stored.size());
+  out.write(reinterpret_cast<const char *>(stored.data()), stored.size());
+}
+
+void TraceBlockWriter::run() {
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    cv.wait(lock, [&] { return done || !pending.empty(); });
+    if (pending.empty())
+      return;
+
+    auto block = std::move(pending.front());
+    pending.pop_front();
+    cv.notify_all();
+
+    // Encode and write the block without holding the lock, such that the
+    // simulation can keep on filling the next one.
+    lock.unlock();
+    writeBlock(block);
+    lock.lock();
+    recycled.push_back(std::move(block));
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// Trace
+//===----------------------------------------------------------------------===//
+
 Trace::Trace(std::unique_ptr<State> const &state, llvm::raw_ostream &out,
-             TraceMode mode)
+             TraceMode mode, TraceEncoding encoding)
     : out(out), state(state), mode(mode) {
   auto root = state->root;
   for (auto &sig : state->signals) {
@@ -27,13 +199,21 @@ Trace::Trace(std::unique_ptr<State> const &state, llvm::raw_ostream &out,
                 (mode == TraceMode::NamedOnly && sig.isValidSigName());
     isTraced.push_back(!done);
   }
+
+  if (encoding == TraceEncoding::Binary && mode != TraceMode::None)
+    writer = std::make_unique<TraceBlockWriter>(out);
 }
 
+Trace::~Trace() = default;
+
 //===----------------------------------------------------------------------===//
 // Changes gathering methods
 //===----------------------------------------------------------------------===//
 
 void Trace::pushChange(unsigned inst, unsigned sigIndex, int elem = -1) {
+  if (writer)
+    return pushBinaryChange(inst, sigIndex, elem);
+
   auto &sig = state->signals[sigIndex];
   std::string valueDump;
   std::string path;
@@ -59,6 +239,65 @@ void Trace::pushChange(unsigned inst, unsigned sigIndex, int elem = -1) {
   }
 }
 
+void Trace::pushBinaryChange(unsigned inst, unsigned sigIndex, int elem) {
+  auto &sig = state->signals[sigIndex];
+  const uint8_t *value = sig.getValue();
+  unsigned size = sig.getSize();
+  if (elem >= 0) {
+    value += sig.getElementOffset(elem);
+    size = sig.getElementByteSize(elem);
+  }
+
+  // Assign an id to the signal and define it on its first change.
+  auto [it, inserted] = binaryIds.insert(
+      {std::make_tuple(inst, sigIndex, elem), binaryValueSlices.size()});
+  auto id = it->second;
+  if (inserted) {
+    std::string path;
+    llvm::raw_string_ostream ss(path);
+    ss << state->instances[inst].path << '/' << sig.getName();
+    if (elem >= 0)
+      ss << '[' << elem << ']';
+    ss.flush();
+
+    writer->writeU8(0x01);
+    writer->writeU32(id);
+    writer->writeU32(size);
+    writer->writeU32(path.size());
+    writer->writeBytes(reinterpret_cast<const uint8_t *>(path.data()),
+                       path.size());
+    writer->endRecord();
+
+    binaryValueSlices.push_back(std::make_pair(binaryValues.size(), size));
+    binaryValues.insert(binaryValues.end(), value, value + size);
+  } else {
+    // Check wheter we have an actual change from last value.
+    auto *last = binaryValues.data() + binaryValueSlices[id].first;
+    if (std::memcmp(last, value, size) == 0)
+      return;
+    std::memcpy(last, value, size);
+  }
+
+  // Open a new time step if needed. The merged formats only dump real-time
+  // steps.
+  Time time = currentTime;
+  if (mode != TraceMode::Full && mode != TraceMode::Reduced)
+    time = Time(currentTime.getTime(), 0, 0);
+  if (!binaryTime || !(*binaryTime == time)) {
+    writer->writeU8(0x02);
+    writer->writeU64(time.getTime());
+    writer->writeU64(time.getDelta());
+    writer->writeU64(time.getEps());
+    writer->endRecord();
+    binaryTime = time;
+  }
+
+  writer->writeU8(0x03);
+  writer->writeU32(id);
+  writer->writeBytes(value, size);
+  writer->endRecord();
+}
+
 void Trace::pushAllChanges(unsigned inst, unsigned sigIndex) {
   auto &sig = state->signals[sigIndex];
   if (sig.hasElement()) {
@@ -93,6 +332,17 @@ void Trace::addChange(unsigned sigIndex) {
 
 void Trace::addChangeMerged(unsigned sigIndex) {
   auto &sig = state->signals[sigIndex];
+
+  // The binary trace reads the values when flushing, only record the keys.
+  if (writer) {
+    if (sig.hasElement())
+      for (size_t i = 0, e = sig.getElementSize(); i < e; ++i)
+        mergedChanges[std::make_pair(sigIndex, i)];
+    else
+      mergedChanges[std::make_pair(sigIndex, -1)];
+    return;
+  }
+
   if (sig.hasElement()) {
     // Add a change for all sub-elements
     for (size_t i = 0, e = sig.getElementSize(); i < e; ++i) {
@@ -125,6 +375,9 @@ void Trace::flush(bool force) {
            mode == TraceMode::NamedOnly)
     if (state->time.getTime() > currentTime.getTime() || force)
       flushMerged();
+
+  if (writer && force)
+    writer->finish();
 }
 
 void Trace::flushFull() {
@@ -158,6 +411,9 @@ void Trace::flushMerged() {
     }
   }
 
+  if (writer)
+    mergedChanges.clear();
+
   if (changes.size() > 0) {
     sortChanges();
 
@@ -170,3 +426,128 @@ void Trace::flushMerged() {
     changes.clear();
   }
 }
+
+//===----------------------------------------------------------------------===//
+// Binary trace decoding
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// Reads the little-endian integers of the binary trace from a byte range.
+/// Reading past the end of the range yields zeros and marks the reader as
+/// failed.
+struct TraceReader {
+  llvm::ArrayRef<uint8_t> data;
+  bool failed = false;
+
+  llvm::ArrayRef<uint8_t> readBytes(size_t size) {
+    if (data.size() < size) {
+      failed = true;
+      data = {};
+      return {};
+    }
+    auto bytes = data.take_front(size);
+    data = data.drop_front(size);
+    return bytes;
+  }
+
+  uint64_t readInt(unsigned size) {
+    uint64_t value = 0;
+    auto bytes = readBytes(size);
+    for (unsigned i = 0, e = bytes.size(); i < e; ++i)
+      value |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+    return value;
+  }
+
+  uint8_t readU8() { return readInt(1); }
+  uint32_t readU32() { return readInt(4); }
+  uint64_t readU64() { return readInt(8); }
+};
+} // namespace
+
+llvm::Error circt::llhd::sim::decodeBinaryTrace(llvm::StringRef data,
+                                                llvm::raw_ostream &os) {
+  auto malformed = [](const llvm::Twine &message) {
+    return llvm::createStringError(llvm::inconvertibleErrorCode(),
+                                   "malformed binary trace: " + message);
+  };
+  if (!data.consume_front("LLHDTRC"))
+    return malformed("missing magic bytes");
+  TraceReader file{llvm::arrayRefFromStringRef(data)};
+  if (file.readU8() != 1)
+    return malformed("unsupported format version");
+
+  // The hierarchical path and value size of each defined signal, and the
+  // changes of the current time step.
+  std::vector<std::pair<std::string, unsigned>> signals;
+  std::vector<std::pair<std::string, std::string>> changes;
+  std::string timeDump;
+  auto flushChanges = [&]() {
+    std::sort(changes.begin(), changes.end(),
+              [](auto &lhs, auto &rhs) { return lhs.first < rhs.first; });
+    for (auto &change : changes)
+      os << timeDump << "  " << change.first << "  " << change.second << "\n";
+    changes.clear();
+  };
+
+  while (!file.data.empty()) {
+    bool isCompressed = file.readU8();
+    uint32_t payloadSize = file.readU32();
+    auto stored = file.readBytes(file.readU32());
+    if (file.failed)
+      return malformed("truncated block");
+
+    llvm::SmallVector<uint8_t, 0> decompressed;
+    TraceReader block{stored};
+    if (isCompressed) {
+      if (!llvm::compression::zlib::isAvailable())
+        return malformed("compressed block, but zlib is not available");
+      if (auto error = llvm::compression::zlib::decompress(
+              stored, decompressed, payloadSize))
+        return error;
+      block.data = decompressed;
+    }
+    if (block.data.size() != payloadSize)
+      return malformed("block size mismatch");
+
+    while (!block.data.empty() && !block.failed) {
+      switch (block.readU8()) {
+      case 0x01: {
+        uint32_t id = block.readU32();
+        uint32_t size = block.readU32();
+        auto name = llvm::toStringRef(block.readBytes(block.readU32()));
+        if (id != signals.size())
+          return malformed("out of order signal definition");
+        signals.push_back({name.str(), size});
+        break;
+      }
+      case 0x02: {
+        flushChanges();
+        uint64_t time = block.readU64();
+        uint64_t delta = block.readU64();
+        uint64_t eps = block.readU64();
+        timeDump = Time(time, delta, eps).toString();
+        break;
+      }
+      case 0x03: {
+        uint32_t id = block.readU32();
+        if (id >= signals.size())
+          return malformed("change of an undefined signal");
+        auto value = block.readBytes(signals[id].second);
+        std::string valueDump;
+        llvm::raw_string_ostream ss(valueDump);
+        ss << "0x";
+        for (auto byte : llvm::reverse(value))
+          ss << llvm::format_hex_no_prefix(byte, 2);
+        changes.push_back({signals[id].first, ss.str()});
+        break;
+      }
+      default:
+        return malformed("unknown record kind");
+      }
+    }
+    if (block.failed)
+      return malformed("truncated record");
+  }
+  flushChanges();
+  return llvm::Error::success();
+}
@@ -18,6 +18,10 @@
 using namespace llvm;
 using namespace circt::llhd::sim;
 
+/// The buffer collecting the events emitted on the current thread, if the
+/// engine evaluates the instances in parallel.
+static thread_local EventBuffer *eventBuffer = nullptr;
+
 //===----------------------------------------------------------------------===//
 // Runtime interface
 //===----------------------------------------------------------------------===//
@@ -41,16 +45,19 @@ void addSigStructElement(State *state, unsigned index, unsigned offset,
   state->addSignalElement(index, offset, size);
 }
 
-void allocProc(State *state, char *owner, ProcState *procState) {
+void allocProc(State *state, char *owner, ProcState *procState,
+               int64_t size) {
   assert(state && "alloc_proc: state not found");
   std::string sOwner(owner);
-  state->addProcPtr(sOwner, procState);
+  state->addProcPtr(sOwner, procState, size);
 }
 
-void allocEntity(State *state, char *owner, uint8_t *entityState) {
+void allocEntity(State *state, char *owner, uint8_t *entityState,
+                 int64_t size) {
   assert(state && "alloc_entity: state not found");
   auto it = state->getInstanceIterator(owner);
   (*it).entityState = entityState;
+  (*it).stateSize = size;
 }
 
 void driveSignal(State *state, SignalDetail *detail, uint8_t *value,
@@ -64,8 +71,13 @@ void driveSignal(State *state, SignalDetail *detail, uint8_t *value,
       (detail->value - state->signals[globalIndex].getValue()) * 8 + offset;
 
   // Spawn a new event.
-  state->queue.insertOrUpdate(state->time + Time(time, delta, eps), globalIndex,
-                              bitOffset, value, width);
+  auto eventTime = state->time + Time(time, delta, eps);
+  if (eventBuffer) {
+    eventBuffer->insertOrUpdate(eventTime, globalIndex, bitOffset, value,
+                                width);
+    return;
+  }
+  state->queue.insertOrUpdate(eventTime, globalIndex, bitOffset, value, width);
 }
 
 void llhdSuspend(State *state, ProcState *procState, int time, int delta,
@@ -73,6 +85,18 @@ void llhdSuspend(State *state, ProcState *procState, int time, int delta,
   // Add a new scheduled wake up if a time is specified.
   if (time || delta || eps) {
     Time sTime(time, delta, eps);
+    if (eventBuffer) {
+      Time wakeupTime = state->time + sTime;
+      eventBuffer->insertOrUpdate(wakeupTime, procState->inst);
+      state->instances[procState->inst].expectedWakeup = wakeupTime;
+      return;
+    }
     state->pushQueue(sTime, procState->inst);
   }
 }
+
+//===----------------------------------------------------------------------===//
+// Engine interface
+//===----------------------------------------------------------------------===//
+
+void setEventBuffer(EventBuffer *buffer) { eventBuffer = buffer; }
@@ -36,13 +36,15 @@ void addSigArrayElements(circt::llhd::sim::State *state, unsigned index,
 void addSigStructElement(circt::llhd::sim::State *state, unsigned index,
                          unsigned offset, unsigned size);
 
-/// Add allocated constructs to a process instance.
+/// Add allocated constructs to a process instance. The size of the process
+/// state is recorded for checkpointing.
 void allocProc(circt::llhd::sim::State *state, char *owner,
-               circt::llhd::sim::ProcState *procState);
+               circt::llhd::sim::ProcState *procState, int64_t size);
 
-/// Add allocated entity state to the given instance.
+/// Add allocated entity state to the given instance. The size of the entity
+/// state is recorded for checkpointing.
 void allocEntity(circt::llhd::sim::State *state, char *owner,
-                 uint8_t *entityState);
+                 uint8_t *entityState, int64_t size);
 
 /// Drive a value onto a signal.
 void driveSignal(circt::llhd::sim::State *state,
@@ -53,6 +55,15 @@ void driveSignal(circt::llhd::sim::State *state,
 void llhdSuspend(circt::llhd::sim::State *state,
                  circt::llhd::sim::ProcState *procState, int time, int delta,
                  int eps);
+
+//===----------------------------------------------------------------------===//
+// Engine interfaces
+//===----------------------------------------------------------------------===//
+
+/// Redirect the events emitted by the units running on the calling thread to
+/// the given buffer instead of the state's queue. Passing null restores the
+/// direct insertion into the queue.
+void setEventBuffer(circt::llhd::sim::EventBuffer *buffer);
 }
 
 #endif // CIRCT_DIALECT_LLHD_SIMULATOR_SIGNALS_RUNTIME_WRAPPERS_H
@@ -0,0 +1,63 @@
+//===- MarkCombinationalPass.cpp - Mark combinational entities ------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Implement pass to mark the entities whose outputs only depend on the current
+// values of their inputs.
+//
+//===----------------------------------------------------------------------===//
+
+#include "PassDetails.h"
+#include "circt/Dialect/LLHD/IR/LLHDOps.h"
+#include "circt/Dialect/LLHD/Transforms/Passes.h"
+
+using namespace circt;
+
+namespace {
+
+struct MarkCombinationalPass
+    : public llhd::MarkCombinationalBase<MarkCombinationalPass> {
+  void runOnOperation() override;
+};
+
+/// Check whether a drive takes effect without advancing the real time or the
+/// delta step of the simulation.
+static bool isEpsilonDrive(llhd::DrvOp op) {
+  auto timeOp = op.getTime().getDefiningOp<llhd::ConstantTimeOp>();
+  if (!timeOp)
+    return false;
+  auto time = timeOp.getValue();
+  return time.getTime() == 0 && time.getDelta() == 0;
+}
+
+void MarkCombinationalPass::runOnOperation() {
+  llhd::EntityOp entity = getOperation();
+
+  // Registers hold state across triggers, and any drive with a real-time or
+  // delta delay lets the entity observe its own past outputs.
+  WalkResult result = entity.walk([](Operation *op) -> WalkResult {
+    if (isa<llhd::RegOp, llhd::OutputOp>(op))
+      return WalkResult::interrupt();
+    if (auto drvOp = dyn_cast<llhd::DrvOp>(op))
+      if (!isEpsilonDrive(drvOp))
+        return WalkResult::interrupt();
+    return WalkResult::advance();
+  });
+
+  if (result.wasInterrupted())
+    entity->removeAttr(llhd::EntityOp::getCombinationalAttrName());
+  else
+    entity->setAttr(llhd::EntityOp::getCombinationalAttrName(),
+                    UnitAttr::get(&getContext()));
+  markAllAnalysesPreserved();
+}
+} // namespace
+
+std::unique_ptr<OperationPass<llhd::EntityOp>>
+circt::llhd::createMarkCombinationalPass() {
+  return std::make_unique<MarkCombinationalPass>();
+}
@@ -47,6 +47,44 @@ static SmallVector<Value> flattenConcats(ValueRange values) {
   return flatInputs;
 }
 
+/// Fold an `and` or `or` with a single input of the same type to that input.
+static OpFoldResult foldSingleInput(Operation *op) {
+  if (op->getNumOperands() == 1 &&
+      op->getOperand(0).getType() == op->getResult(0).getType())
+    return op->getOperand(0);
+  return {};
+}
+
+/// Inline the inputs of nested ops of the same kind, and drop duplicate
+/// inputs. Nested ops with multiple uses are kept such that they can still be
+/// shared between properties.
+template <typename OpTy>
+static LogicalResult canonicalizeAssocOp(OpTy op, PatternRewriter &rewriter) {
+  SmallVector<Value> inputs;
+  SmallDenseSet<Value> seen;
+  bool changed = false;
+  auto addInput = [&](Value input) {
+    if (seen.insert(input).second)
+      inputs.push_back(input);
+    else
+      changed = true;
+  };
+  for (auto input : op.getInputs()) {
+    auto nestedOp = input.template getDefiningOp<OpTy>();
+    if (nestedOp && nestedOp != op && nestedOp->hasOneUse()) {
+      changed = true;
+      for (auto nestedInput : nestedOp.getInputs())
+        addInput(nestedInput);
+      continue;
+    }
+    addInput(input);
+  }
+  if (!changed)
+    return failure();
+  rewriter.replaceOpWithNewOp<OpTy>(op, inputs);
+  return success();
+}
+
 //===----------------------------------------------------------------------===//
 // Declarative Rewrites
 //===----------------------------------------------------------------------===//
@@ -55,6 +93,30 @@ namespace patterns {
 #include "circt/Dialect/LTL/LTLFolds.cpp.inc"
 } // namespace patterns
 
+//===----------------------------------------------------------------------===//
+// AndOp and OrOp
+//===----------------------------------------------------------------------===//
+
+OpFoldResult AndOp::fold(FoldAdaptor adaptor) {
+  // and(s) -> s
+  return foldSingleInput(*this);
+}
+
+LogicalResult AndOp::canonicalize(AndOp op, PatternRewriter &rewriter) {
+  // and(a, and(b, c), a) -> and(a, b, c)
+  return canonicalizeAssocOp(op, rewriter);
+}
+
+OpFoldResult OrOp::fold(FoldAdaptor adaptor) {
+  // or(s) -> s
+  return foldSingleInput(*this);
+}
+
+LogicalResult OrOp::canonicalize(OrOp op, PatternRewriter &rewriter) {
+  // or(a, or(b, c), a) -> or(a, b, c)
+  return canonicalizeAssocOp(op, rewriter);
+}
+
 //===----------------------------------------------------------------------===//
 // DelayOp
 //===----------------------------------------------------------------------===//
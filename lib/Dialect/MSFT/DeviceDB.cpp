@@ -19,55 +19,37 @@ using namespace msft;
 //===----------------------------------------------------------------------===//
 // PrimitiveDB.
 //===----------------------------------------------------------------------===//
-// NOTE: Nothing in this implementation is in any way the most optimal
-// implementation. We put off deciding what the correct data structure is until
-// we have a better handle of the operations it must accelerate. Performance is
-// not an immediate goal.
-//===----------------------------------------------------------------------===//
 
 PrimitiveDB::PrimitiveDB(MLIRContext *ctxt) : ctxt(ctxt) {}
 
 /// Assign an instance to a primitive. Return false if another instance is
 /// already placed at that location.
 LogicalResult PrimitiveDB::addPrimitive(PhysLocationAttr loc) {
-  DenseSet<PrimitiveType> &primsAtLoc = getLeaf(loc);
-  PrimitiveType prim = loc.getPrimitiveType().getValue();
-  if (primsAtLoc.contains(prim))
-    return failure();
-  primsAtLoc.insert(prim);
-  return success();
+  bool inserted;
+  (void)primitives.insert(loc, inserted);
+  return success(inserted);
 }
 
-/// Assign an instance to a primitive. Return false if another instance is
-/// already placed at that location.
 /// Check to see if a primitive exists.
 bool PrimitiveDB::isValidLocation(PhysLocationAttr loc) {
-  DenseSet<PrimitiveType> primsAtLoc = getLeaf(loc);
-  return primsAtLoc.contains(loc.getPrimitiveType().getValue());
-}
-
-PrimitiveDB::DimPrimitiveType &PrimitiveDB::getLeaf(PhysLocationAttr loc) {
-  return placements[loc.getX()][loc.getY()][loc.getNum()];
+  return primitives.lookup(loc) != nullptr;
 }
 
 void PrimitiveDB::foreach (
     function_ref<void(PhysLocationAttr)> callback) const {
-  for (const auto &x : placements)
-    for (const auto &y : x.second)
-      for (const auto &n : y.second)
-        for (auto p : n.second)
-          callback(PhysLocationAttr::get(ctxt, PrimitiveTypeAttr::get(ctxt, p),
-                                         x.first, y.first, n.first));
+  uint64_t max = std::numeric_limits<uint64_t>::max();
+  primitives.walk(
+      0, max, 0, max, {}, /*colsDesc=*/false, /*rowsDesc=*/false,
+      [&](uint64_t x, uint64_t y, const DeviceGrid<NoData>::Site &site) {
+        callback(PhysLocationAttr::get(
+            ctxt, PrimitiveTypeAttr::get(ctxt, site.primType), x, y,
+            site.num));
+      });
 }
 
 //===----------------------------------------------------------------------===//
 // PlacementDB.
 //===----------------------------------------------------------------------===//
-// NOTE: Nothing in this implementation is in any way the most optimal
-// implementation. We put off deciding what the correct data structure is until
-// we have a better handle of the operations it must accelerate. Performance is
-// not an immediate goal.
-//===----------------------------------------------------------------------===//
 
 PlacementDB::PlacementDB(mlir::ModuleOp topMod)
     : ctxt(topMod->getContext()), topMod(topMod), seeded(false) {
@@ -76,7 +58,10 @@ PlacementDB::PlacementDB(mlir::ModuleOp topMod)
 PlacementDB::PlacementDB(mlir::ModuleOp topMod, const PrimitiveDB &seed)
     : ctxt(topMod->getContext()), topMod(topMod), seeded(false) {
 
-  seed.foreach ([this](PhysLocationAttr loc) { (void)getLeaf(loc); });
+  seed.foreach ([this](PhysLocationAttr loc) {
+    bool inserted;
+    (void)placements.insert(loc, inserted);
+  });
   seeded = true;
   addDesignPlacements();
 }
@@ -140,7 +125,8 @@ PDPhysRegionOp PlacementDB::placeIn(DynamicInstanceOp inst,
   PDPhysRegionOp regOp =
       OpBuilder::atBlockEnd(&inst.getBody().front())
           .create<PDPhysRegionOp>(srcLoc, FlatSymbolRefAttr::get(physregion),
-                                  subPathAttr, FlatSymbolRefAttr());
+                                  subPathAttr, PrimitiveTypeAttr(),
+                                  FlatSymbolRefAttr());
   regionPlacements.push_back(regOp);
   return regOp;
 }
@@ -177,8 +163,9 @@ size_t PlacementDB::addPlacements(DynamicInstanceOp inst) {
 /// Walk the entire design adding placements.
 size_t PlacementDB::addDesignPlacements() {
   size_t failed = 0;
-  for (auto inst : topMod.getOps<DynamicInstanceOp>())
-    failed += addPlacements(inst);
+  for (auto hier : topMod.getOps<InstanceHierarchyOp>())
+    for (auto inst : hier.getOps<DynamicInstanceOp>())
+      failed += addPlacements(inst);
   return failed;
 }
 
@@ -263,13 +250,14 @@ LogicalResult PlacementDB::movePlacementCheck(DynInstDataOpInterface op,
   if (from == to)
     return success();
 
-  PlacementCell *oldLeaf = getLeaf(from);
+  // Getting the new leaf may create it, so look up the old one afterwards.
   PlacementCell *newLeaf = getLeaf(to);
+  PlacementCell *oldLeaf = placements.lookup(from);
 
-  if (!oldLeaf || !newLeaf)
+  if (!newLeaf || (!oldLeaf && seeded))
     return failure();
 
-  if (oldLeaf->locOp == nullptr)
+  if (!oldLeaf || oldLeaf->locOp == nullptr)
     return op.emitError("cannot move from a location not occupied by "
                         "specified op. Currently unoccupied");
   if (oldLeaf->locOp != op)
@@ -298,13 +286,10 @@ void PlacementDB::movePlacement(DynInstDataOpInterface op,
 
 /// Lookup the instance at a particular location.
 DynInstDataOpInterface PlacementDB::getInstanceAt(PhysLocationAttr loc) {
-  auto innerMap = placements[loc.getX()][loc.getY()][loc.getNum()];
-  auto instF = innerMap.find(loc.getPrimitiveType().getValue());
-  if (instF == innerMap.end())
-    return {};
-  if (!instF->getSecond().locOp)
+  PlacementCell *leaf = placements.lookup(loc);
+  if (!leaf)
     return {};
-  return instF->getSecond().locOp;
+  return leaf->locOp;
 }
 
 PhysLocationAttr PlacementDB::getNearestFreeInColumn(PrimitiveType prim,
@@ -331,21 +316,13 @@ PhysLocationAttr PlacementDB::getNearestFreeInColumn(PrimitiveType prim,
 }
 
 PlacementDB::PlacementCell *PlacementDB::getLeaf(PhysLocationAttr loc) {
-  PrimitiveType primType = loc.getPrimitiveType().getValue();
-
-  DimNumMap &nums = placements[loc.getX()][loc.getY()];
-  if (!seeded)
-    return &nums[loc.getNum()][primType];
-  if (!nums.count(loc.getNum()))
-    return {};
-
-  DimDevType &primitives = nums[loc.getNum()];
-  if (primitives.count(primType) == 0)
-    return {};
-  return &primitives[primType];
+  if (seeded)
+    return placements.lookup(loc);
+  bool inserted;
+  return &placements.insert(loc, inserted);
 }
 
-/// Walker for placements.
+/// Walker for placements. Only the populated rows of each column are visited.
 void PlacementDB::walkPlacements(
     function_ref<void(PhysLocationAttr, DynInstDataOpInterface)> callback,
     std::tuple<int64_t, int64_t, int64_t, int64_t> bounds,
@@ -357,66 +334,19 @@ void PlacementDB::walkPlacements(
   uint64_t ymax = std::get<3>(bounds) < 0 ? std::numeric_limits<uint64_t>::max()
                                           : (uint64_t)std::get<3>(bounds);
 
-  // TODO: Since the data structures we're using aren't sorted, the best we can
-  // do is iterate and filter. If a specific order is requested, we sort the
-  // keys by that as we go. Once we get to performance, we'll figure out the
-  // right data structure.
-
-  auto maybeSort = [](auto &container, auto direction) {
-    if (!direction.has_value())
-      return;
-    if (*direction == Direction::NONE)
-      return;
-
-    llvm::sort(container, [direction](auto colA, auto colB) {
-      if (*direction == Direction::ASC)
-        return colA.first < colB.first;
-
-      return colA.first > colB.first;
-    });
-  };
-
-  // X loop.
-  SmallVector<std::pair<size_t, DimYMap>> cols(placements.begin(),
-                                               placements.end());
-  maybeSort(cols, llvm::transformOptional(walkOrder,
-                                          [](auto wo) { return wo.columns; }));
-  for (const auto &colF : cols) {
-    size_t x = colF.first;
-    if (x < xmin || x > xmax)
-      continue;
-    DimYMap yMap = colF.second;
-
-    // Y loop.
-    SmallVector<std::pair<size_t, DimNumMap>> rows(yMap.begin(), yMap.end());
-    maybeSort(rows, llvm::transformOptional(walkOrder,
-                                            [](auto wo) { return wo.rows; }));
-    for (const auto &rowF : rows) {
-      size_t y = rowF.first;
-      if (y < ymin || y > ymax)
-        continue;
-      DimNumMap numMap = rowF.second;
-
-      // Num loop.
-      for (auto &numF : numMap) {
-        size_t num = numF.getFirst();
-        DimDevType devMap = numF.getSecond();
-
-        // DevType loop.
-        for (auto &devF : devMap) {
-          PrimitiveType devtype = devF.getFirst();
-          if (primType && devtype != *primType)
-            continue;
-          PlacementCell &inst = devF.getSecond();
-
-          // Marshall and run the callback.
-          PhysLocationAttr loc = PhysLocationAttr::get(
-              ctxt, PrimitiveTypeAttr::get(ctxt, devtype), x, y, num);
-          callback(loc, inst.locOp);
-        }
-      }
-    }
-  }
+  // The grid is sorted, so an unspecified order is ascending.
+  bool colsDesc = walkOrder && walkOrder->columns == Direction::DESC;
+  bool rowsDesc = walkOrder && walkOrder->rows == Direction::DESC;
+  placements.walk(
+      xmin, xmax, ymin, ymax, primType, colsDesc, rowsDesc,
+      [&](uint64_t x, uint64_t y,
+          const DeviceGrid<PlacementCell>::Site &site) {
+        // Marshall and run the callback.
+        PhysLocationAttr loc = PhysLocationAttr::get(
+            ctxt, PrimitiveTypeAttr::get(ctxt, site.primType), x, y,
+            site.num);
+        callback(loc, site.data.locOp);
+      });
 }
 
 /// Walk the region placement information.
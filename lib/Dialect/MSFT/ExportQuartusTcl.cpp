@@ -25,6 +25,8 @@
 #include "mlir/Tools/mlir-translate/Translation.h"
 #include "llvm/ADT/StringSet.h"
 #include "llvm/ADT/TypeSwitch.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/JSON.h"
 #include "llvm/Support/raw_ostream.h"
 
 using namespace circt;
@@ -70,6 +72,102 @@ LogicalResult TclEmitter::populate() {
   return success();
 }
 
+std::string TclAssignment::getKey() const {
+  std::string key;
+  llvm::raw_string_ostream os(key);
+  os << command << " -to ";
+  llvm::interleave(
+      path, os,
+      [&](hw::InnerRefAttr part) {
+        os << part.getModule().getValue() << "::" << part.getName().getValue();
+      },
+      "|");
+  os << subpath;
+  return key;
+}
+
+LogicalResult TclEmitter::setPreviousManifest(StringRef manifestText) {
+  MLIRContext *ctxt = topLevel.getContext();
+  auto invalid = [&]() { return topLevel.emitError("invalid Tcl manifest"); };
+
+  auto json = llvm::json::parse(manifestText);
+  if (!json)
+    return invalid() << ": " << llvm::toString(json.takeError());
+  const llvm::json::Object *root = json->getAsObject();
+  const llvm::json::Array *procs = root ? root->getArray("procs") : nullptr;
+  if (!procs)
+    return invalid();
+
+  previousManifest.emplace();
+  for (const llvm::json::Value &procValue : *procs) {
+    const llvm::json::Object *proc = procValue.getAsObject();
+    if (!proc)
+      return invalid();
+    auto module = proc->getString("module");
+    auto instance = proc->getString("instance");
+    const llvm::json::Array *assignments = proc->getArray("assignments");
+    if (!module || !instance || !assignments)
+      return invalid();
+
+    TclProcManifest &procManifest =
+        (*previousManifest)[*module][instance->str()];
+    for (const llvm::json::Value &entry : *assignments) {
+      const llvm::json::Object *obj = entry.getAsObject();
+      if (!obj)
+        return invalid();
+      auto command = obj->getString("command");
+      auto value = obj->getString("value");
+      auto subpath = obj->getString("subpath");
+      const llvm::json::Array *path = obj->getArray("path");
+      if (!command || !value || !subpath || !path)
+        return invalid();
+
+      TclAssignment assignment{command->str(), value->str(), {},
+                               subpath->str()};
+      for (const llvm::json::Value &part : *path) {
+        auto partStr = part.getAsString();
+        if (!partStr || !partStr->contains("::"))
+          return invalid();
+        auto [partModule, partName] = partStr->split("::");
+        assignment.path.push_back(
+            hw::InnerRefAttr::get(StringAttr::get(ctxt, partModule),
+                                  StringAttr::get(ctxt, partName)));
+      }
+      std::string key = assignment.getKey();
+      procManifest[key] = std::move(assignment);
+    }
+  }
+  return success();
+}
+
+std::string TclEmitter::getManifest() const {
+  llvm::json::Array procs;
+  for (const auto &moduleKV : manifest) {
+    for (const auto &procKV : moduleKV.second) {
+      llvm::json::Array assignments;
+      for (const auto &assignmentKV : procKV.second) {
+        const TclAssignment &assignment = assignmentKV.second;
+        llvm::json::Array path;
+        for (hw::InnerRefAttr part : assignment.path)
+          path.push_back(
+              (part.getModule().getValue() + "::" + part.getName().getValue())
+                  .str());
+        assignments.push_back(llvm::json::Object{
+            {"command", assignment.command},
+            {"value", assignment.value},
+            {"path", std::move(path)},
+            {"subpath", assignment.subpath}});
+      }
+      procs.push_back(
+          llvm::json::Object{{"module", moduleKV.first},
+                             {"instance", procKV.first},
+                             {"assignments", std::move(assignments)}});
+    }
+  }
+  llvm::json::Value root(llvm::json::Object{{"procs", std::move(procs)}});
+  return llvm::formatv("{0:2}\n", root).str();
+}
+
 Operation *TclEmitter::getDefinition(FlatSymbolRefAttr sym) {
   if (failed(populate()))
     return nullptr;
@@ -93,17 +191,23 @@ struct TclOutputState {
   TclEmitter &emitter;
   SmallVector<Attribute> symbolRefs;
 
-  void emit(PhysLocationAttr);
-  LogicalResult emitLocationAssignment(DynInstDataOpInterface refOp,
-                                       PhysLocationAttr,
-                                       std::optional<StringRef> subpath);
+  /// The assignments of the proc being emitted.
+  TclProcManifest *procManifest = nullptr;
+  /// The assignments of the proc in the previous export, if diffing against
+  /// one.
+  const TclProcManifest *previousProcManifest = nullptr;
+
+  void emit(llvm::raw_ostream &os, PhysLocationAttr);
+  LogicalResult emitAssignment(DynInstDataOpInterface refOp, StringRef command,
+                               StringRef value, StringRef subpath);
+  void emitRemoval(const TclAssignment &assignment);
 
   LogicalResult emit(PDPhysRegionOp region);
   LogicalResult emit(PDPhysLocationOp loc);
   LogicalResult emit(PDRegPhysLocationOp);
   LogicalResult emit(DynamicInstanceVerbatimAttrOp attr);
 
-  void emitPath(hw::GlobalRefOp ref, std::optional<StringRef> subpath);
+  void emitPath(ArrayRef<hw::InnerRefAttr> path, StringRef subpath);
   void emitInnerRefPart(hw::InnerRefAttr innerRef);
 
   /// Get the GlobalRefOp to which the given operation is pointing. Add it to
@@ -130,23 +234,17 @@ void TclOutputState::emitInnerRefPart(hw::InnerRefAttr innerRef) {
   symbolRefs.push_back(innerRef);
 }
 
-void TclOutputState::emitPath(hw::GlobalRefOp ref,
-                              std::optional<StringRef> subpath) {
+void TclOutputState::emitPath(ArrayRef<hw::InnerRefAttr> path,
+                              StringRef subpath) {
   // Traverse each part of the path.
-  auto parts = ref.getNamepathAttr().getAsRange<hw::InnerRefAttr>();
-  auto lastPart = std::prev(parts.end());
-  for (auto part : parts) {
-    emitInnerRefPart(part);
-    if (part != *lastPart)
-      os << '|';
-  }
+  llvm::interleave(
+      path, os, [&](hw::InnerRefAttr part) { emitInnerRefPart(part); }, "|");
 
   // Some placements don't require subpaths.
-  if (subpath)
-    os << subpath;
+  os << subpath;
 }
 
-void TclOutputState::emit(PhysLocationAttr pla) {
+void TclOutputState::emit(llvm::raw_ostream &os, PhysLocationAttr pla) {
   // Different devices have different 'number' letters (the 'N' in 'N0'). M20Ks
   // and DSPs happen to have the same one, probably because they never co-exist
   // at the same location.
@@ -172,27 +270,58 @@ void TclOutputState::emit(PhysLocationAttr pla) {
 }
 
 /// Emit tcl in the form of:
-/// "set_location_assignment MPDSP_X34_Y285_N0 -to
-/// $parent|fooInst|entityName(subpath)"
-LogicalResult
-TclOutputState::emitLocationAssignment(DynInstDataOpInterface refOp,
-                                       PhysLocationAttr loc,
-                                       std::optional<StringRef> subpath) {
-  indent() << "set_location_assignment ";
-  emit(loc);
+/// "COMMAND VALUE -to $parent|fooInst|entityName(subpath)"
+/// unless the previous export made the same assignment.
+LogicalResult TclOutputState::emitAssignment(DynInstDataOpInterface refOp,
+                                             StringRef command,
+                                             StringRef value,
+                                             StringRef subpath) {
+  GlobalRefOp ref = getRefOp(refOp);
+  if (!ref)
+    return failure();
+
+  TclAssignment assignment{
+      command.str(), value.str(),
+      SmallVector<hw::InnerRefAttr>(
+          ref.getNamepathAttr().getAsRange<hw::InnerRefAttr>()),
+      subpath.str()};
+  std::string key = assignment.getKey();
+  bool unchanged = false;
+  if (previousProcManifest) {
+    auto prev = previousProcManifest->find(key);
+    unchanged = prev != previousProcManifest->end() &&
+                prev->second.value == assignment.value;
+  }
+  (*procManifest)[key] = assignment;
+  if (unchanged)
+    return success();
+
+  indent() << command << ' ' << value;
 
   // To which entity does this apply?
   os << " -to $parent|";
-  emitPath(getRefOp(refOp), subpath);
-
+  emitPath(assignment.path, subpath);
+  os << '\n';
   return success();
 }
 
+/// Emit tcl in the form of:
+/// "COMMAND -to $parent|fooInst|entityName(subpath) -remove"
+void TclOutputState::emitRemoval(const TclAssignment &assignment) {
+  indent() << assignment.command << " -to $parent|";
+  emitPath(assignment.path, assignment.subpath);
+  os << " -remove\n";
+}
+
+/// Emit tcl in the form of:
+/// "set_location_assignment MPDSP_X34_Y285_N0 -to
+/// $parent|fooInst|entityName(subpath)"
 LogicalResult TclOutputState::emit(PDPhysLocationOp loc) {
-  if (failed(emitLocationAssignment(loc, loc.getLoc(), loc.getSubPath())))
-    return failure();
-  os << '\n';
-  return success();
+  std::string value;
+  llvm::raw_string_ostream valueOS(value);
+  emit(valueOS, loc.getLoc());
+  return emitAssignment(loc, "set_location_assignment", valueOS.str(),
+                        loc.getSubPath().value_or(""));
 }
 
 LogicalResult TclOutputState::emit(PDRegPhysLocationOp locs) {
@@ -201,9 +330,12 @@ LogicalResult TclOutputState::emit(PDRegPhysLocationOp locs) {
     PhysLocationAttr pla = locArr[i];
     if (!pla)
       continue;
-    if (failed(emitLocationAssignment(locs, pla, {})))
+    std::string value;
+    llvm::raw_string_ostream valueOS(value);
+    emit(valueOS, pla);
+    if (failed(emitAssignment(locs, "set_location_assignment", valueOS.str(),
+                              "[" + std::to_string(i) + "]")))
       return failure();
-    os << "[" << i << "]\n";
   }
   return success();
 }
@@ -211,15 +343,10 @@ LogicalResult TclOutputState::emit(PDRegPhysLocationOp locs) {
 /// Emit tcl in the form of:
 /// "set_global_assignment -name NAME VALUE -to $parent|fooInst|entityName"
 LogicalResult TclOutputState::emit(DynamicInstanceVerbatimAttrOp attr) {
-  GlobalRefOp ref = getRefOp(attr);
-  indent() << "set_instance_assignment -name " << attr.getName() << " "
-           << attr.getValue();
-
-  // To which entity does this apply?
-  os << " -to $parent|";
-  emitPath(ref, attr.getSubPath());
-  os << '\n';
-  return success();
+  std::string command =
+      ("set_instance_assignment -name " + attr.getName()).str();
+  return emitAssignment(attr, command, attr.getValue(),
+                        attr.getSubPath().value_or(""));
 }
 
 /// Emit tcl in the form of:
@@ -228,8 +355,6 @@ LogicalResult TclOutputState::emit(DynamicInstanceVerbatimAttrOp attr) {
 /// set_instance_assignment -name CORE_ONLY_PLACE_REGION ON -to $parent|a|b|c
 /// set_instance_assignment -name REGION_NAME test_region -to $parent|a|b|c
 LogicalResult TclOutputState::emit(PDPhysRegionOp region) {
-  GlobalRefOp ref = getRefOp(region);
-
   auto physicalRegion = dyn_cast_or_null<DeclPhysicalRegionOp>(
       emitter.getDefinition(region.getPhysRegionRefAttr()));
   if (!physicalRegion)
@@ -238,42 +363,36 @@ LogicalResult TclOutputState::emit(PDPhysRegionOp region) {
            << region.getPhysRegionRefAttr();
 
   // PLACE_REGION directive.
-  indent() << "set_instance_assignment -name PLACE_REGION \"";
+  std::string bounds;
+  llvm::raw_string_ostream boundsOS(bounds);
+  boundsOS << '"';
   auto physicalBounds =
       physicalRegion.getBounds().getAsRange<PhysicalBoundsAttr>();
   llvm::interleave(
-      physicalBounds, os,
+      physicalBounds, boundsOS,
       [&](PhysicalBoundsAttr bounds) {
-        os << 'X' << bounds.getXMin() << ' ';
-        os << 'Y' << bounds.getYMin() << ' ';
-        os << 'X' << bounds.getXMax() << ' ';
-        os << 'Y' << bounds.getYMax();
+        boundsOS << 'X' << bounds.getXMin() << ' ';
+        boundsOS << 'Y' << bounds.getYMin() << ' ';
+        boundsOS << 'X' << bounds.getXMax() << ' ';
+        boundsOS << 'Y' << bounds.getYMax();
       },
       ";");
-  os << '"';
-
-  os << " -to $parent|";
-  emitPath(ref, region.getSubPath());
-  os << '\n';
-
-  // RESERVE_PLACE_REGION directive.
-  indent() << "set_instance_assignment -name RESERVE_PLACE_REGION OFF";
-  os << " -to $parent|";
-  emitPath(ref, region.getSubPath());
-  os << '\n';
-
-  // CORE_ONLY_PLACE_REGION directive.
-  indent() << "set_instance_assignment -name CORE_ONLY_PLACE_REGION ON";
-  os << " -to $parent|";
-  emitPath(ref, region.getSubPath());
-  os << '\n';
-
-  // REGION_NAME directive.
-  indent() << "set_instance_assignment -name REGION_NAME ";
-  os << physicalRegion.getName();
-  os << " -to $parent|";
-  emitPath(ref, region.getSubPath());
-  os << '\n';
+  boundsOS << '"';
+
+  StringRef subpath = region.getSubPath().value_or("");
+  StringRef command = "set_instance_assignment -name ";
+  if (failed(emitAssignment(region, (command + "PLACE_REGION").str(),
+                            boundsOS.str(), subpath)) ||
+      // RESERVE_PLACE_REGION directive.
+      failed(emitAssignment(region, (command + "RESERVE_PLACE_REGION").str(),
+                            "OFF", subpath)) ||
+      // CORE_ONLY_PLACE_REGION directive.
+      failed(emitAssignment(region, (command + "CORE_ONLY_PLACE_REGION").str(),
+                            "ON", subpath)) ||
+      // REGION_NAME directive.
+      failed(emitAssignment(region, (command + "REGION_NAME").str(),
+                            physicalRegion.getName(), subpath)))
+    return failure();
   return success();
 }
 
@@ -289,33 +408,88 @@ LogicalResult TclEmitter::emit(Operation *hwMod, StringRef outputFile) {
   llvm::raw_string_ostream os(s);
   TclOutputState state(*this, os);
 
+  // In diff mode, "instances" which the previous export had procs for but
+  // which have no ops anymore still need a proc to remove the assignments.
+  auto &tclOpsForInstances = tclOpsForModInstance[hwMod];
+  std::string modName = mlir::SymbolTable::getSymbolName(hwMod).str();
+  TclModuleManifest &modManifest = manifest[modName];
+  const TclModuleManifest *prevModManifest = nullptr;
+  if (previousManifest) {
+    auto prev = previousManifest->find(modName);
+    if (prev != previousManifest->end())
+      prevModManifest = &prev->second;
+  }
+  SmallVector<StringAttr> instNames;
+  for (const auto &tclOpsForInstancesKV : tclOpsForInstances)
+    instNames.push_back(tclOpsForInstancesKV.first);
+  if (prevModManifest)
+    for (const auto &prevKV : *prevModManifest) {
+      StringAttr instName;
+      if (!prevKV.first.empty())
+        instName = StringAttr::get(hwMod->getContext(), prevKV.first);
+      if (!tclOpsForInstances.count(instName))
+        instNames.push_back(instName);
+    }
+
   // Iterate through all the "instances" for 'hwMod' and produce a tcl proc for
   // each one.
-  for (const auto &tclOpsForInstancesKV : tclOpsForModInstance[hwMod]) {
-    StringAttr instName = tclOpsForInstancesKV.first;
+  for (StringAttr instName : instNames) {
     os << "proc {{" << state.symbolRefs.size() << "}}";
     if (instName)
       os << '_' << instName.getValue();
     os << "_config { parent } {\n";
     state.symbolRefs.push_back(SymbolRefAttr::get(hwMod));
 
+    // Record the assignments in the manifest and find the ones of the previous
+    // export to diff against.
+    std::string instKey = instName ? instName.getValue().str() : "";
+    TclProcManifest &procManifest = modManifest[instKey];
+    state.procManifest = &procManifest;
+    state.previousProcManifest = nullptr;
+    if (prevModManifest) {
+      auto prev = prevModManifest->find(instKey);
+      if (prev != prevModManifest->end())
+        state.previousProcManifest = &prev->second;
+    }
+
     // Loop through the ops relevant to the specified root module "instance".
     LogicalResult ret = success();
-    const auto &tclOpsForMod = tclOpsForInstancesKV.second;
-    for (Operation *tclOp : tclOpsForMod) {
-      LogicalResult rc =
-          TypeSwitch<Operation *, LogicalResult>(tclOp)
-              .Case([&](PDPhysLocationOp op) { return state.emit(op); })
-              .Case([&](PDRegPhysLocationOp op) { return state.emit(op); })
-              .Case([&](PDPhysRegionOp op) { return state.emit(op); })
-              .Case([&](DynamicInstanceVerbatimAttrOp op) {
-                return state.emit(op);
-              })
-              .Default([](Operation *op) {
-                return op->emitOpError("could not determine how to output tcl");
-              });
-      if (failed(rc))
-        ret = failure();
+    auto tclOpsForMod = tclOpsForInstances.find(instName);
+    if (tclOpsForMod != tclOpsForInstances.end()) {
+      for (Operation *tclOp : tclOpsForMod->second) {
+        LogicalResult rc =
+            TypeSwitch<Operation *, LogicalResult>(tclOp)
+                .Case([&](PDPhysLocationOp op) { return state.emit(op); })
+                .Case([&](PDRegPhysLocationOp op) { return state.emit(op); })
+                .Case([&](PDPhysRegionOp op) { return state.emit(op); })
+                .Case([&](DynamicInstanceVerbatimAttrOp op) {
+                  return state.emit(op);
+                })
+                .Default([](Operation *op) {
+                  return op->emitOpError(
+                      "could not determine how to output tcl");
+                });
+        if (failed(rc))
+          ret = failure();
+      }
+    }
+
+    // Remove the assignments which the previous export made and this one
+    // doesn't. Entities in modules which no longer exist can't be referred to.
+    if (state.previousProcManifest) {
+      for (const auto &prevKV : *state.previousProcManifest) {
+        if (procManifest.count(prevKV.first))
+          continue;
+        const TclAssignment &assignment = prevKV.second;
+        if (llvm::all_of(assignment.path, [&](hw::InnerRefAttr part) {
+              return topLevelSymbols.getDefinition(part.getModuleRef());
+            }))
+          state.emitRemoval(assignment);
+        else
+          hwMod->emitWarning("cannot remove the previous assignment to an "
+                             "entity in a missing module: ")
+              << prevKV.first;
+      }
     }
     os << "}\n\n";
   }
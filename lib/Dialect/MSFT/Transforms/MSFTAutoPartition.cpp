@@ -0,0 +1,597 @@
+//===- MSFTAutoPartition.cpp - Automatic partitioning pass ------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Assign the untagged entities of a module to its design partitions. The
+// netlist is partitioned by recursive multilevel bisection: it is coarsened by
+// matching strongly connected entities, bisected and then refined with
+// Fiduccia-Mattheyses passes while it is uncoarsened again.
+//
+//===----------------------------------------------------------------------===//
+
+#include "PassDetails.h"
+#include "circt/Dialect/HW/HWTypes.h"
+#include "circt/Dialect/MSFT/MSFTOps.h"
+#include "circt/Dialect/MSFT/MSFTPasses.h"
+#include "circt/Support/SymCache.h"
+
+#include <array>
+#include <queue>
+#include <random>
+
+using namespace circt;
+using namespace msft;
+
+/// Stop coarsening once a graph has this few nodes.
+static constexpr unsigned coarsestSize = 64;
+/// Nets with more nodes than this are ignored while coarsening.
+static constexpr unsigned maxMatchNetSize = 64;
+/// The number of random initial bisections of the coarsest graph to try.
+static constexpr unsigned numInitialTries = 8;
+/// The maximum number of refinement passes per level.
+static constexpr unsigned maxRefinePasses = 8;
+
+/// Shuffle `order`. Uses the raw engine output rather than `std::shuffle` so
+/// that the result is the same with every standard library.
+static void shuffle(SmallVectorImpl<unsigned> &order, std::mt19937 &rng) {
+  for (size_t i = order.size(); i > 1; --i)
+    std::swap(order[i - 1], order[rng() % i]);
+}
+
+namespace {
+/// A hypergraph to be bisected.
+struct Hypergraph {
+  SmallVector<uint64_t> nodeWeights;
+  /// The side each node is fixed to, or -1 if it is free.
+  SmallVector<int8_t> fixed;
+  /// The nodes connected by each net.
+  SmallVector<SmallVector<unsigned, 4>> nets;
+  SmallVector<uint64_t> netWeights;
+  /// The nets each node is connected to. Computed by `computeNodeNets`.
+  SmallVector<SmallVector<unsigned, 4>> nodeNets;
+
+  unsigned size() const { return nodeWeights.size(); }
+  void computeNodeNets();
+  /// The total weight of the nets cut by `side`.
+  uint64_t getCut(ArrayRef<int8_t> side) const;
+};
+
+/// Bisects a hypergraph so that the weight of each side stays below a bound.
+class Bisector {
+public:
+  Bisector(std::mt19937 &rng, const uint64_t maxWeight[2]) : rng(rng) {
+    this->maxWeight[0] = maxWeight[0];
+    this->maxWeight[1] = maxWeight[1];
+  }
+
+  /// Bisect `graph`, returning the side of each node.
+  SmallVector<int8_t> bisect(const Hypergraph &graph);
+
+private:
+  /// Build a coarser graph by merging pairs of connected nodes. `map` is set to
+  /// the coarse node of each node of `graph`.
+  Hypergraph coarsen(const Hypergraph &graph, SmallVectorImpl<unsigned> &map);
+  /// Bisect the coarsest graph by growing one side from a random node.
+  SmallVector<int8_t> initialBisect(const Hypergraph &graph);
+  /// Improve `side` with Fiduccia-Mattheyses passes.
+  void refine(const Hypergraph &graph, SmallVectorImpl<int8_t> &side);
+  /// The amount by which the side weights exceed their bounds.
+  uint64_t getViolation(const uint64_t weight[2]) const;
+
+  std::mt19937 &rng;
+  uint64_t maxWeight[2];
+};
+
+struct AutoPartitionPass : public AutoPartitionBase<AutoPartitionPass> {
+  void runOnOperation() override;
+
+private:
+  /// The estimated resource usage of an operation.
+  uint64_t getWeight(Operation *op);
+  /// The estimated resource usage of a module's body.
+  uint64_t getModuleWeight(Operation *mod);
+  void partition(MSFTModuleOp mod);
+  /// Assign the nodes in `nodeIds` to the partitions [lo, hi).
+  void partition(ArrayRef<unsigned> nodeIds, unsigned lo, unsigned hi);
+
+  SymbolCache topSyms;
+  DenseMap<Operation *, uint64_t> moduleWeights;
+  std::unique_ptr<std::mt19937> rng;
+
+  /// The netlist of the module being partitioned.
+  Hypergraph netlist;
+  /// The partition index of each node. Preset for the fixed nodes.
+  SmallVector<int> nodeParts;
+};
+} // anonymous namespace
+
+void Hypergraph::computeNodeNets() {
+  nodeNets.clear();
+  nodeNets.resize(size());
+  for (auto [netIdx, net] : llvm::enumerate(nets))
+    for (unsigned node : net)
+      nodeNets[node].push_back(netIdx);
+}
+
+uint64_t Hypergraph::getCut(ArrayRef<int8_t> side) const {
+  uint64_t cut = 0;
+  for (auto [net, weight] : llvm::zip(nets, netWeights)) {
+    int8_t first = side[net.front()];
+    if (llvm::any_of(net, [&](unsigned n) { return side[n] != first; }))
+      cut += weight;
+  }
+  return cut;
+}
+
+uint64_t Bisector::getViolation(const uint64_t weight[2]) const {
+  uint64_t violation = 0;
+  for (unsigned s = 0; s < 2; ++s)
+    if (weight[s] > maxWeight[s])
+      violation += weight[s] - maxWeight[s];
+  return violation;
+}
+
+Hypergraph Bisector::coarsen(const Hypergraph &graph,
+                             SmallVectorImpl<unsigned> &map) {
+  unsigned n = graph.size();
+  // Don't create nodes which are too heavy to be moved between the sides.
+  uint64_t maxNodeWeight = std::min(maxWeight[0], maxWeight[1]) / 4 + 1;
+
+  SmallVector<unsigned> order = makeSequentialRange(n);
+  shuffle(order, rng);
+
+  constexpr unsigned unmatched = ~0u;
+  map.assign(n, unmatched);
+  Hypergraph coarse;
+  SmallVector<double> scores(n, 0.0);
+  SmallVector<unsigned> touched;
+  for (unsigned u : order) {
+    if (map[u] != unmatched)
+      continue;
+
+    // Score the unmatched neighbors by the strength of their connection.
+    touched.clear();
+    for (unsigned netIdx : graph.nodeNets[u]) {
+      const auto &net = graph.nets[netIdx];
+      if (net.size() > maxMatchNetSize)
+        continue;
+      double score = (double)graph.netWeights[netIdx] / (net.size() - 1);
+      for (unsigned v : net) {
+        if (v == u || map[v] != unmatched)
+          continue;
+        if (graph.fixed[u] >= 0 && graph.fixed[v] >= 0 &&
+            graph.fixed[u] != graph.fixed[v])
+          continue;
+        if (graph.nodeWeights[u] + graph.nodeWeights[v] > maxNodeWeight)
+          continue;
+        if (scores[v] == 0.0)
+          touched.push_back(v);
+        scores[v] += score;
+      }
+    }
+
+    int best = -1;
+    for (unsigned v : touched)
+      if (best < 0 || scores[v] > scores[best])
+        best = v;
+    for (unsigned v : touched)
+      scores[v] = 0.0;
+
+    unsigned coarseNode = coarse.size();
+    map[u] = coarseNode;
+    coarse.nodeWeights.push_back(graph.nodeWeights[u]);
+    coarse.fixed.push_back(graph.fixed[u]);
+    if (best >= 0) {
+      map[best] = coarseNode;
+      coarse.nodeWeights.back() += graph.nodeWeights[best];
+      coarse.fixed.back() = std::max(graph.fixed[u], graph.fixed[best]);
+    }
+  }
+
+  // Map the nets, dropping the ones which are now internal to a node.
+  for (auto [net, weight] : llvm::zip(graph.nets, graph.netWeights)) {
+    SmallVector<unsigned, 4> coarseNet;
+    for (unsigned node : net)
+      coarseNet.push_back(map[node]);
+    llvm::sort(coarseNet);
+    coarseNet.erase(std::unique(coarseNet.begin(), coarseNet.end()),
+                    coarseNet.end());
+    if (coarseNet.size() < 2)
+      continue;
+    coarse.nets.push_back(std::move(coarseNet));
+    coarse.netWeights.push_back(weight);
+  }
+  coarse.computeNodeNets();
+  return coarse;
+}
+
+SmallVector<int8_t> Bisector::initialBisect(const Hypergraph &graph) {
+  unsigned n = graph.size();
+  uint64_t total = 0;
+  for (uint64_t weight : graph.nodeWeights)
+    total += weight;
+  // Grow side 0 to its share of the total weight.
+  uint64_t target = total * maxWeight[0] / (maxWeight[0] + maxWeight[1]);
+
+  SmallVector<int8_t> best;
+  uint64_t bestViolation = 0, bestCut = 0;
+  for (unsigned i = 0; i < numInitialTries; ++i) {
+    SmallVector<int8_t> side(n, 1);
+    uint64_t weight = 0;
+    for (unsigned node = 0; node < n; ++node) {
+      if (graph.fixed[node] == 0) {
+        side[node] = 0;
+        weight += graph.nodeWeights[node];
+      }
+    }
+
+    // Breadth first from random seed nodes until the target is reached.
+    SmallVector<unsigned> order = makeSequentialRange(n);
+    shuffle(order, rng);
+    SmallVector<bool> visited(n, false);
+    std::queue<unsigned> worklist;
+    for (unsigned seed : order) {
+      if (weight >= target)
+        break;
+      if (visited[seed])
+        continue;
+      visited[seed] = true;
+      worklist.push(seed);
+      while (!worklist.empty() && weight < target) {
+        unsigned node = worklist.front();
+        worklist.pop();
+        if (graph.fixed[node] < 0 && side[node] == 1) {
+          side[node] = 0;
+          weight += graph.nodeWeights[node];
+        }
+        for (unsigned netIdx : graph.nodeNets[node])
+          for (unsigned next : graph.nets[netIdx])
+            if (!visited[next]) {
+              visited[next] = true;
+              worklist.push(next);
+            }
+      }
+      worklist = {};
+    }
+
+    refine(graph, side);
+    uint64_t sideWeights[2] = {0, 0};
+    for (unsigned node = 0; node < n; ++node)
+      sideWeights[side[node]] += graph.nodeWeights[node];
+    uint64_t violation = getViolation(sideWeights);
+    uint64_t cut = graph.getCut(side);
+    if (best.empty() || violation < bestViolation ||
+        (violation == bestViolation && cut < bestCut)) {
+      best = std::move(side);
+      bestViolation = violation;
+      bestCut = cut;
+    }
+  }
+  return best;
+}
+
+void Bisector::refine(const Hypergraph &graph, SmallVectorImpl<int8_t> &side) {
+  unsigned n = graph.size();
+  if (n == 0)
+    return;
+  uint64_t maxNodeWeight =
+      *std::max_element(graph.nodeWeights.begin(), graph.nodeWeights.end());
+  for (unsigned pass = 0; pass < maxRefinePasses; ++pass) {
+    // The number of nodes of each net on either side.
+    SmallVector<std::array<unsigned, 2>> pins(graph.nets.size(), {0, 0});
+    for (auto [netIdx, net] : llvm::enumerate(graph.nets))
+      for (unsigned node : net)
+        ++pins[netIdx][side[node]];
+    uint64_t weight[2] = {0, 0};
+    for (unsigned node = 0; node < n; ++node)
+      weight[side[node]] += graph.nodeWeights[node];
+
+    // The reduction of the cut if a node is moved to the other side.
+    SmallVector<int64_t> gains(n, 0);
+    for (unsigned node = 0; node < n; ++node) {
+      int8_t from = side[node];
+      for (unsigned netIdx : graph.nodeNets[node]) {
+        auto netWeight = (int64_t)graph.netWeights[netIdx];
+        if (pins[netIdx][from] == 1)
+          gains[node] += netWeight;
+        if (pins[netIdx][1 - from] == 0)
+          gains[node] -= netWeight;
+      }
+    }
+
+    // A max-heap of (gain, node), invalidated lazily when a gain changes.
+    using Entry = std::pair<int64_t, unsigned>;
+    std::priority_queue<Entry> heap;
+    SmallVector<bool> locked(n, false);
+    for (unsigned node = 0; node < n; ++node) {
+      if (graph.fixed[node] >= 0)
+        locked[node] = true;
+      else
+        heap.push({gains[node], node});
+    }
+    auto updateGain = [&](unsigned node, int64_t delta) {
+      if (locked[node])
+        return;
+      gains[node] += delta;
+      heap.push({gains[node], node});
+    };
+
+    SmallVector<unsigned> moves;
+    int64_t gain = 0, bestGain = 0;
+    uint64_t bestViolation = getViolation(weight);
+    size_t bestMoves = 0;
+    while (!heap.empty()) {
+      auto [entryGain, node] = heap.top();
+      heap.pop();
+      if (locked[node] || entryGain != gains[node])
+        continue;
+      int8_t from = side[node], to = 1 - from;
+      uint64_t nodeWeight = graph.nodeWeights[node];
+      // Let the balance slip by up to one node to get out of local minima, or
+      // arbitrarily when leaving an overfull side. The most balanced state
+      // with the highest gain is kept in the end.
+      if (weight[to] + nodeWeight > maxWeight[to] + maxNodeWeight &&
+          weight[from] <= maxWeight[from])
+        continue;
+
+      locked[node] = true;
+      side[node] = to;
+      weight[from] -= nodeWeight;
+      weight[to] += nodeWeight;
+      gain += gains[node];
+      moves.push_back(node);
+
+      for (unsigned netIdx : graph.nodeNets[node]) {
+        const auto &net = graph.nets[netIdx];
+        auto netWeight = (int64_t)graph.netWeights[netIdx];
+        auto &netPins = pins[netIdx];
+        // The usual FM gain updates, before and after moving the node.
+        if (netPins[to] == 0) {
+          for (unsigned other : net)
+            if (other != node)
+              updateGain(other, netWeight);
+        } else if (netPins[to] == 1) {
+          for (unsigned other : net)
+            if (other != node && side[other] == to)
+              updateGain(other, -netWeight);
+        }
+        --netPins[from];
+        ++netPins[to];
+        if (netPins[from] == 0) {
+          for (unsigned other : net)
+            if (other != node)
+              updateGain(other, -netWeight);
+        } else if (netPins[from] == 1) {
+          for (unsigned other : net)
+            if (side[other] == from)
+              updateGain(other, netWeight);
+        }
+      }
+
+      uint64_t violation = getViolation(weight);
+      if (violation < bestViolation ||
+          (violation == bestViolation && gain > bestGain)) {
+        bestViolation = violation;
+        bestGain = gain;
+        bestMoves = moves.size();
+      }
+    }
+
+    // Undo the moves past the best point seen.
+    for (unsigned node : llvm::drop_begin(moves, bestMoves))
+      side[node] = 1 - side[node];
+    if (bestMoves == 0)
+      break;
+  }
+}
+
+SmallVector<int8_t> Bisector::bisect(const Hypergraph &graph) {
+  // Coarsen until the graph is small or stops shrinking.
+  SmallVector<Hypergraph> levels;
+  SmallVector<SmallVector<unsigned>> maps;
+  const Hypergraph *current = &graph;
+  while (current->size() > coarsestSize) {
+    SmallVector<unsigned> map;
+    Hypergraph coarse = coarsen(*current, map);
+    if (coarse.size() * 10 > current->size() * 9)
+      break;
+    levels.push_back(std::move(coarse));
+    maps.push_back(std::move(map));
+    current = &levels.back();
+  }
+
+  SmallVector<int8_t> side = initialBisect(*current);
+
+  // Project the bisection back onto the finer graphs, refining on the way.
+  for (size_t level = levels.size(); level > 0; --level) {
+    const Hypergraph &fine = level == 1 ? graph : levels[level - 2];
+    const auto &map = maps[level - 1];
+    SmallVector<int8_t> fineSide;
+    for (unsigned coarseNode : map)
+      fineSide.push_back(side[coarseNode]);
+    side = std::move(fineSide);
+    refine(fine, side);
+  }
+  return side;
+}
+
+uint64_t AutoPartitionPass::getModuleWeight(Operation *mod) {
+  auto it = moduleWeights.find(mod);
+  if (it != moduleWeights.end())
+    return it->second;
+  // External modules have no body, so count them as one unit.
+  uint64_t weight = 0;
+  mod->walk([&](Operation *op) { weight += getWeight(op); });
+  weight = std::max<uint64_t>(weight, 1);
+  moduleWeights[mod] = weight;
+  return weight;
+}
+
+uint64_t AutoPartitionPass::getWeight(Operation *op) {
+  if (isWireManipulationOp(op) || op->hasTrait<OpTrait::IsTerminator>() ||
+      op->getNumRegions() > 0)
+    return 0;
+  if (auto inst = dyn_cast<InstanceOp>(op)) {
+    Operation *mod = topSyms.getDefinition(inst.getModuleNameAttr());
+    return mod ? getModuleWeight(mod) : 1;
+  }
+  if (auto hwInst = dyn_cast<hw::InstanceOp>(op)) {
+    Operation *mod = topSyms.getDefinition(hwInst.getModuleNameAttr());
+    return mod ? getModuleWeight(mod) : 1;
+  }
+  // Otherwise, assume that the resources scale with the width of the results.
+  uint64_t weight = 0;
+  for (Type type : op->getResultTypes())
+    weight += std::max<int64_t>(hw::getBitWidth(type), 1);
+  return std::max<uint64_t>(weight, 1);
+}
+
+void AutoPartitionPass::partition(ArrayRef<unsigned> nodeIds, unsigned lo,
+                                  unsigned hi) {
+  if (hi - lo == 1) {
+    for (unsigned id : nodeIds)
+      nodeParts[id] = lo;
+    return;
+  }
+  unsigned mid = (lo + hi) / 2;
+
+  // Build the subgraph of the nodes, keeping the nets between them.
+  Hypergraph graph;
+  DenseMap<unsigned, unsigned> local;
+  uint64_t total = 0;
+  for (unsigned id : nodeIds) {
+    local[id] = graph.size();
+    graph.nodeWeights.push_back(netlist.nodeWeights[id]);
+    total += netlist.nodeWeights[id];
+    if (nodeParts[id] < 0)
+      graph.fixed.push_back(-1);
+    else
+      graph.fixed.push_back(nodeParts[id] < (int)mid ? 0 : 1);
+  }
+  SmallVector<bool> netSeen(netlist.nets.size(), false);
+  for (unsigned id : nodeIds) {
+    for (unsigned netIdx : netlist.nodeNets[id]) {
+      if (netSeen[netIdx])
+        continue;
+      netSeen[netIdx] = true;
+      SmallVector<unsigned, 4> net;
+      for (unsigned node : netlist.nets[netIdx]) {
+        auto it = local.find(node);
+        if (it != local.end())
+          net.push_back(it->second);
+      }
+      if (net.size() < 2)
+        continue;
+      graph.nets.push_back(std::move(net));
+      graph.netWeights.push_back(netlist.netWeights[netIdx]);
+    }
+  }
+  graph.computeNodeNets();
+
+  // Split the weight in proportion to the number of partitions on each side.
+  uint64_t slack = total * imbalance / 100;
+  uint64_t maxWeight[2] = {
+      llvm::divideCeil(total * (mid - lo), hi - lo) + slack,
+      llvm::divideCeil(total * (hi - mid), hi - lo) + slack};
+  Bisector bisector(*rng, maxWeight);
+  SmallVector<int8_t> side = bisector.bisect(graph);
+  cutBits += graph.getCut(side);
+
+  SmallVector<unsigned> halves[2];
+  for (auto [id, s] : llvm::zip(nodeIds, side))
+    halves[s].push_back(id);
+  partition(halves[0], lo, mid);
+  partition(halves[1], mid, hi);
+}
+
+void AutoPartitionPass::partition(MSFTModuleOp mod) {
+  SmallVector<DesignPartitionOp> parts(mod.getOps<DesignPartitionOp>());
+  if (parts.size() < 2)
+    return;
+  StringAttr modSymbol = SymbolTable::getSymbolName(mod);
+  SmallVector<SymbolRefAttr> partRefs;
+  DenseMap<SymbolRefAttr, int> partIndex;
+  for (auto part : parts) {
+    auto ref = SymbolRefAttr::get(modSymbol, {SymbolRefAttr::get(part)});
+    partIndex[ref] = partRefs.size();
+    partRefs.push_back(ref);
+  }
+
+  // Every op which uses resources is a node. Ops tagged for a partition of
+  // this module stay where they are, those tagged for elsewhere are ignored.
+  netlist = Hypergraph();
+  nodeParts.clear();
+  SmallVector<Operation *> nodeOps;
+  DenseMap<Operation *, unsigned> nodeOfOp;
+  for (Operation &op : *mod.getBodyBlock()) {
+    if (isa<DesignPartitionOp>(op) || getWeight(&op) == 0)
+      continue;
+    int part = -1;
+    if (auto ref = op.getAttrOfType<SymbolRefAttr>("targetDesignPartition")) {
+      auto it = partIndex.find(ref);
+      if (it == partIndex.end())
+        continue;
+      part = it->second;
+    }
+    nodeOfOp[&op] = nodeOps.size();
+    nodeOps.push_back(&op);
+    nodeParts.push_back(part);
+    netlist.nodeWeights.push_back(getWeight(&op));
+  }
+
+  // Each result is a net connecting its driver to the nodes using it, seen
+  // through any wire ops in between. Cutting it costs its bit width.
+  for (auto [driver, op] : llvm::enumerate(nodeOps)) {
+    for (Value result : op->getResults()) {
+      SmallVector<unsigned, 4> net = {(unsigned)driver};
+      SmallVector<Value> worklist = {result};
+      DenseSet<Operation *> visited;
+      while (!worklist.empty()) {
+        Value value = worklist.pop_back_val();
+        for (Operation *user : value.getUsers()) {
+          if (!visited.insert(user).second)
+            continue;
+          auto it = nodeOfOp.find(user);
+          if (it != nodeOfOp.end())
+            net.push_back(it->second);
+          else if (isWireManipulationOp(user))
+            worklist.append(user->result_begin(), user->result_end());
+        }
+      }
+      llvm::sort(net);
+      net.erase(std::unique(net.begin(), net.end()), net.end());
+      if (net.size() < 2)
+        continue;
+      netlist.nets.push_back(std::move(net));
+      netlist.netWeights.push_back(
+          std::max<int64_t>(hw::getBitWidth(result.getType()), 1));
+    }
+  }
+  netlist.computeNodeNets();
+
+  partition(makeSequentialRange(nodeOps.size()), 0, parts.size());
+
+  for (auto [op, part] : llvm::zip(nodeOps, nodeParts)) {
+    if (op->hasAttr("targetDesignPartition"))
+      continue;
+    op->setAttr("targetDesignPartition", partRefs[part]);
+    ++numTagged;
+  }
+}
+
+void AutoPartitionPass::runOnOperation() {
+  ModuleOp top = getOperation();
+  topSyms.addDefinitions(top);
+  rng = std::make_unique<std::mt19937>(seed);
+
+  for (auto mod : top.getOps<MSFTModuleOp>())
+    partition(mod);
+}
+
+std::unique_ptr<Pass> circt::msft::createAutoPartitionPass() {
+  return std::make_unique<AutoPartitionPass>();
+}
@@ -0,0 +1,382 @@
+//===- MSFTAutoPlace.cpp - Automatic placement pass -------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Place the primitives which are constrained to a physical region at specific
+// locations by simulated annealing on the estimated wirelength.
+//
+//===----------------------------------------------------------------------===//
+
+#include "PassDetails.h"
+#include "circt/Dialect/HW/HWTypes.h"
+#include "circt/Dialect/MSFT/DeviceDB.h"
+#include "circt/Dialect/MSFT/MSFTOps.h"
+#include "circt/Dialect/MSFT/MSFTPasses.h"
+#include "circt/Support/SymCache.h"
+
+#include <cmath>
+#include <random>
+
+using namespace circt;
+using namespace msft;
+
+namespace {
+/// A primitive to be placed.
+struct Node {
+  PDPhysRegionOp regionOp;
+  PrimitiveType primType;
+  /// The rectangles making up the physical region.
+  SmallVector<PhysicalBoundsAttr> bounds;
+  /// The number of cells in the region.
+  uint64_t numCells = 0;
+  /// The current location.
+  uint64_t x = 0, y = 0;
+};
+
+/// A connection to a node or a fixed location.
+struct Link {
+  /// The node on the other end, or -1 if it is fixed at (x, y).
+  int node;
+  uint64_t x, y;
+  uint64_t weight;
+};
+
+/// A cell on the device, identified by the primitive type and coordinates.
+using CellKey = std::tuple<unsigned, uint64_t, uint64_t>;
+
+struct AutoPlacePass : public AutoPlaceBase<AutoPlacePass> {
+  void runOnOperation() override;
+
+private:
+  /// Find the static instance a dynamic instance refers to.
+  Operation *getStaticInstance(DynamicInstanceOp inst);
+  /// Collect the connections between the nodes and to fixed locations.
+  void collectLinks(PlacementDB &db);
+  /// Return the cell of `node` with index `index` within its region.
+  std::pair<uint64_t, uint64_t> getCell(const Node &node, uint64_t index);
+  /// Pick an initial location for each node. Fails if a region is full.
+  LogicalResult placeInitial();
+  /// Try to improve the placement by simulated annealing.
+  void anneal();
+
+  /// The estimated wirelength of the links of one node.
+  uint64_t getCost(const Node &node, const Link &link);
+  uint64_t getCost(unsigned nodeIdx);
+  uint64_t getTotalCost();
+
+  CellKey getKey(const Node &node) {
+    return {static_cast<unsigned>(node.primType), node.x, node.y};
+  }
+
+  SmallVector<Node> nodes;
+  SmallVector<SmallVector<Link>> links;
+  /// The cells occupied by existing placements.
+  DenseSet<CellKey> fixedCells;
+  /// The cells occupied by nodes.
+  DenseMap<CellKey, unsigned> nodeCells;
+
+  SymbolCache topSyms;
+  DenseMap<Operation *, SymbolCache> perModSyms;
+};
+} // anonymous namespace
+
+Operation *AutoPlacePass::getStaticInstance(DynamicInstanceOp inst) {
+  hw::InnerRefAttr ref = inst.getInstanceRef();
+  Operation *mod = topSyms.getDefinition(ref.getModule());
+  if (!mod)
+    return nullptr;
+  auto symsFound = perModSyms.find(mod);
+  if (symsFound == perModSyms.end()) {
+    SymbolCache &syms = perModSyms[mod];
+    mod->walk([&syms, mod](Operation *op) {
+      if (op == mod)
+        return;
+      if (auto name =
+              op->getAttrOfType<StringAttr>(SymbolTable::getSymbolAttrName()))
+        syms.addDefinition(name, op);
+    });
+    symsFound = perModSyms.find(mod);
+  }
+  return symsFound->second.getDefinition(ref.getName());
+}
+
+/// The weight of a connection carrying `value`.
+static uint64_t getWeight(Value value) {
+  int64_t width = hw::getBitWidth(value.getType());
+  return width > 0 ? width : 1;
+}
+
+void AutoPlacePass::collectLinks(PlacementDB &db) {
+  // Index the static instances of the nodes and of the existing placements
+  // under each parent, since only siblings in the instance hierarchy can be
+  // directly connected.
+  using Endpoint = std::pair<Operation *, Operation *>;
+  DenseMap<Endpoint, SmallVector<unsigned, 1>> nodesAt;
+  DenseMap<Endpoint, std::pair<uint64_t, uint64_t>> fixedAt;
+  for (auto [idx, node] : llvm::enumerate(nodes)) {
+    auto inst = cast<DynamicInstanceOp>(node.regionOp->getParentOp());
+    if (Operation *staticInst = getStaticInstance(inst))
+      nodesAt[{inst->getParentOp(), staticInst}].push_back(idx);
+  }
+  db.walkPlacements([&](PhysLocationAttr loc, DynInstDataOpInterface locOp) {
+    if (!locOp)
+      return;
+    fixedCells.insert({static_cast<unsigned>(loc.getPrimitiveType().getValue()),
+                       loc.getX(), loc.getY()});
+    auto inst = dyn_cast<DynamicInstanceOp>(locOp->getParentOp());
+    if (!inst)
+      return;
+    if (Operation *staticInst = getStaticInstance(inst))
+      fixedAt.try_emplace({inst->getParentOp(), staticInst}, loc.getX(),
+                          loc.getY());
+  });
+
+  links.resize(nodes.size());
+  for (auto &[endpoint, srcNodes] : nodesAt) {
+    auto [parent, staticInst] = endpoint;
+    for (Value result : staticInst->getResults()) {
+      uint64_t weight = getWeight(result);
+      for (Operation *user : result.getUsers()) {
+        auto dstNodes = nodesAt.find({parent, user});
+        if (dstNodes != nodesAt.end()) {
+          for (unsigned src : srcNodes)
+            for (unsigned dst : dstNodes->second) {
+              if (src == dst)
+                continue;
+              links[src].push_back({static_cast<int>(dst), 0, 0, weight});
+              links[dst].push_back({static_cast<int>(src), 0, 0, weight});
+            }
+          continue;
+        }
+
+        auto dstFixed = fixedAt.find({parent, user});
+        if (dstFixed != fixedAt.end())
+          for (unsigned src : srcNodes)
+            links[src].push_back({-1, dstFixed->second.first,
+                                  dstFixed->second.second, weight});
+      }
+    }
+  }
+
+  // Connections from fixed locations to nodes.
+  for (auto &[endpoint, loc] : fixedAt) {
+    auto [parent, staticInst] = endpoint;
+    for (Value result : staticInst->getResults()) {
+      uint64_t weight = getWeight(result);
+      for (Operation *user : result.getUsers()) {
+        auto dstNodes = nodesAt.find({parent, user});
+        if (dstNodes == nodesAt.end())
+          continue;
+        for (unsigned dst : dstNodes->second)
+          links[dst].push_back({-1, loc.first, loc.second, weight});
+      }
+    }
+  }
+}
+
+std::pair<uint64_t, uint64_t> AutoPlacePass::getCell(const Node &node,
+                                                     uint64_t index) {
+  for (PhysicalBoundsAttr bounds : node.bounds) {
+    uint64_t width = bounds.getXMax() - bounds.getXMin() + 1;
+    uint64_t size = width * (bounds.getYMax() - bounds.getYMin() + 1);
+    if (index < size)
+      return {bounds.getXMin() + index % width,
+              bounds.getYMin() + index / width};
+    index -= size;
+  }
+  llvm_unreachable("cell index out of range");
+}
+
+LogicalResult AutoPlacePass::placeInitial() {
+  for (auto [idx, node] : llvm::enumerate(nodes)) {
+    bool placed = false;
+    for (uint64_t i = 0; i < node.numCells && !placed; ++i) {
+      std::tie(node.x, node.y) = getCell(node, i);
+      CellKey key = getKey(node);
+      if (fixedCells.contains(key) || nodeCells.contains(key))
+        continue;
+      nodeCells[key] = idx;
+      placed = true;
+    }
+    if (!placed)
+      return node.regionOp.emitOpError("no free location in region ")
+             << node.regionOp.getPhysRegionRefAttr();
+  }
+  return success();
+}
+
+/// The estimated wirelength of `link` from `node`.
+uint64_t AutoPlacePass::getCost(const Node &node, const Link &link) {
+  uint64_t x = link.node < 0 ? link.x : nodes[link.node].x;
+  uint64_t y = link.node < 0 ? link.y : nodes[link.node].y;
+  uint64_t dist = (x > node.x ? x - node.x : node.x - x) +
+                  (y > node.y ? y - node.y : node.y - y);
+  return dist * link.weight;
+}
+
+uint64_t AutoPlacePass::getCost(unsigned nodeIdx) {
+  uint64_t cost = 0;
+  for (const Link &link : links[nodeIdx])
+    cost += getCost(nodes[nodeIdx], link);
+  return cost;
+}
+
+uint64_t AutoPlacePass::getTotalCost() {
+  // Links between nodes are in the lists of both ends, those to fixed
+  // locations only in one.
+  uint64_t cost = 0;
+  for (unsigned i = 0, e = nodes.size(); i < e; ++i)
+    for (const Link &link : links[i])
+      cost += getCost(nodes[i], link) * (link.node < 0 ? 2 : 1);
+  return cost / 2;
+}
+
+void AutoPlacePass::anneal() {
+  // Use the raw output of the engine since the distributions are
+  // implementation defined, and the results should be the same everywhere.
+  std::mt19937 rng(seed);
+  auto randomReal = [&]() { return (rng() >> 8) * (1.0 / (1 << 24)); };
+
+  uint64_t cost = getTotalCost();
+  uint64_t bestCost = cost;
+  SmallVector<std::pair<uint64_t, uint64_t>> best;
+  for (const Node &node : nodes)
+    best.emplace_back(node.x, node.y);
+
+  // Start at a temperature at which a move of average cost is likely to be
+  // accepted and cool down geometrically to nearly zero.
+  uint64_t numMoves = static_cast<uint64_t>(movesPerInstance) * nodes.size();
+  double temperature = 1.0 + static_cast<double>(cost) / nodes.size();
+  double cooling = std::pow(1e-3 / temperature, 1.0 / (numMoves + 1));
+
+  for (uint64_t move = 0; move < numMoves && cost > 0; ++move) {
+    temperature *= cooling;
+    unsigned idx = rng() % nodes.size();
+    Node &node = nodes[idx];
+    auto [oldX, oldY] = std::make_pair(node.x, node.y);
+    auto [newX, newY] = getCell(node, rng() % node.numCells);
+    CellKey oldKey = getKey(node);
+    CellKey newKey = {static_cast<unsigned>(node.primType), newX, newY};
+    if (newKey == oldKey || fixedCells.contains(newKey))
+      continue;
+
+    // Swap with the node at the new location if there is one which may move
+    // to the old location.
+    int other = -1;
+    auto otherF = nodeCells.find(newKey);
+    if (otherF != nodeCells.end()) {
+      other = otherF->second;
+      bool fits = false;
+      for (PhysicalBoundsAttr bounds : nodes[other].bounds)
+        fits |= oldX >= bounds.getXMin() && oldX <= bounds.getXMax() &&
+                oldY >= bounds.getYMin() && oldY <= bounds.getYMax();
+      if (!fits)
+        continue;
+    }
+
+    int64_t before = getCost(idx) + (other >= 0 ? getCost(other) : 0);
+    node.x = newX;
+    node.y = newY;
+    if (other >= 0) {
+      nodes[other].x = oldX;
+      nodes[other].y = oldY;
+    }
+    int64_t after = getCost(idx) + (other >= 0 ? getCost(other) : 0);
+    // A link between the two swapped nodes keeps its length, so counting it
+    // twice doesn't change the delta.
+    int64_t delta = after - before;
+
+    if (delta > 0 && randomReal() >= std::exp(-delta / temperature)) {
+      // Reject.
+      node.x = oldX;
+      node.y = oldY;
+      if (other >= 0) {
+        nodes[other].x = newX;
+        nodes[other].y = newY;
+      }
+      continue;
+    }
+
+    // Accept.
+    nodeCells.erase(oldKey);
+    nodeCells[newKey] = idx;
+    if (other >= 0)
+      nodeCells[oldKey] = other;
+    cost += delta;
+    if (cost < bestCost) {
+      bestCost = cost;
+      for (auto [n, loc] : llvm::zip(nodes, best))
+        loc = {n.x, n.y};
+    }
+  }
+
+  for (auto [n, loc] : llvm::zip(nodes, best))
+    std::tie(n.x, n.y) = loc;
+}
+
+void AutoPlacePass::runOnOperation() {
+  ModuleOp top = getOperation();
+  topSyms.addDefinitions(top);
+
+  // Collect the primitives to place.
+  WalkResult walk = top.walk([&](PDPhysRegionOp regionOp) {
+    std::optional<PrimitiveType> primType = regionOp.getPlaceType();
+    if (!primType)
+      return WalkResult::advance();
+    if (!isa<DynamicInstanceOp>(regionOp->getParentOp())) {
+      regionOp.emitOpError("can only be placed within a dynamic instance");
+      return WalkResult::interrupt();
+    }
+    auto region = dyn_cast_or_null<DeclPhysicalRegionOp>(
+        topSyms.getDefinition(regionOp.getPhysRegionRefAttr()));
+    if (!region) {
+      regionOp.emitOpError("could not find physical region declaration named ")
+          << regionOp.getPhysRegionRefAttr();
+      return WalkResult::interrupt();
+    }
+
+    Node &node = nodes.emplace_back();
+    node.regionOp = regionOp;
+    node.primType = *primType;
+    for (auto bounds : region.getBounds().getAsRange<PhysicalBoundsAttr>()) {
+      node.bounds.push_back(bounds);
+      node.numCells += (bounds.getXMax() - bounds.getXMin() + 1) *
+                       (bounds.getYMax() - bounds.getYMin() + 1);
+    }
+    return WalkResult::advance();
+  });
+  if (walk.wasInterrupted())
+    return signalPassFailure();
+  if (nodes.empty())
+    return markAllAnalysesPreserved();
+
+  PlacementDB db(top);
+  collectLinks(db);
+  if (failed(placeInitial()))
+    return signalPassFailure();
+  anneal();
+  finalCost = getTotalCost();
+
+  // Replace the region constraints with the locations.
+  for (Node &node : nodes) {
+    auto inst = cast<DynamicInstanceOp>(node.regionOp->getParentOp());
+    auto loc = PhysLocationAttr::get(
+        &getContext(), PrimitiveTypeAttr::get(&getContext(), node.primType),
+        node.x, node.y, 0);
+    StringRef subPath;
+    if (auto subPathAttr = node.regionOp.getSubPathAttr())
+      subPath = subPathAttr.getValue();
+    if (!db.place(inst, loc, subPath, node.regionOp.getLoc()))
+      return signalPassFailure();
+    node.regionOp.erase();
+    ++numPlaced;
+  }
+}
+
+std::unique_ptr<Pass> circt::msft::createAutoPlacePass() {
+  return std::make_unique<AutoPlacePass>();
+}
@@ -21,8 +21,10 @@
 #include "mlir/IR/PatternMatch.h"
 #include "mlir/Pass/Pass.h"
 #include "mlir/Pass/PassRegistry.h"
+#include "mlir/Support/FileUtilities.h"
 #include "mlir/Transforms/DialectConversion.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+#include "llvm/Support/MemoryBuffer.h"
 
 using namespace circt;
 using namespace msft;
@@ -57,6 +59,22 @@ void ExportTclPass::runOnOperation() {
   auto *ctxt = &getContext();
   TclEmitter emitter(top);
 
+  // In diff mode, only the assignments which changed since the previous export
+  // are emitted.
+  if (!previousManifest.empty()) {
+    std::string errorMessage;
+    auto input = mlir::openInputFile(previousManifest, &errorMessage);
+    if (!input) {
+      top.emitError(errorMessage);
+      signalPassFailure();
+      return;
+    }
+    if (failed(emitter.setPreviousManifest(input->getBuffer()))) {
+      signalPassFailure();
+      return;
+    }
+  }
+
   // Traverse MSFT location attributes and export the required Tcl into
   // templated `sv::VerbatimOp`s with symbolic references to the instance paths.
   for (const std::string &moduleName : tops) {
@@ -74,6 +92,16 @@ void ExportTclPass::runOnOperation() {
     }
   }
 
+  // The manifest is written along with the Tcl so that the next export can be
+  // diffed against it.
+  if (!manifestFile.empty()) {
+    OpBuilder builder = OpBuilder::atBlockEnd(top.getBody());
+    auto verbatim = builder.create<sv::VerbatimOp>(builder.getUnknownLoc(),
+                                                   emitter.getManifest());
+    verbatim->setAttr("output_file",
+                      hw::OutputFileAttr::getFromFilename(ctxt, manifestFile));
+  }
+
   ConversionTarget target(*ctxt);
   target.addIllegalDialect<msft::MSFTDialect>();
   target.addLegalDialect<hw::HWDialect>();
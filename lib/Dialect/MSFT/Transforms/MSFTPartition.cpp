@@ -28,14 +28,6 @@
 using namespace circt;
 using namespace msft;
 
-/// Is this operation "free" and copy-able?
-static bool isWireManipulationOp(Operation *op) {
-  return isa<hw::ArrayConcatOp, hw::ArrayCreateOp, hw::ArrayGetOp,
-             hw::ArraySliceOp, hw::StructCreateOp, hw::StructExplodeOp,
-             hw::StructExtractOp, hw::StructInjectOp, hw::StructCreateOp,
-             hw::ConstantOp>(op);
-}
-
 static SymbolRefAttr getPart(Operation *op) {
   return op->getAttrOfType<SymbolRefAttr>("targetDesignPartition");
 }
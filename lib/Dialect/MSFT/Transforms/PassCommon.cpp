@@ -7,6 +7,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "PassDetails.h"
+#include "circt/Dialect/HW/HWOps.h"
 #include "circt/Dialect/MSFT/MSFTPasses.h"
 
 using namespace mlir;
@@ -26,6 +27,13 @@ hw::ModulePortInfo circt::msft::getModulePortInfo(Operation *op) {
   return hw::getModulePortInfo(op);
 }
 
+bool circt::msft::isWireManipulationOp(Operation *op) {
+  return isa<hw::ArrayConcatOp, hw::ArrayCreateOp, hw::ArrayGetOp,
+             hw::ArraySliceOp, hw::StructCreateOp, hw::StructExplodeOp,
+             hw::StructExtractOp, hw::StructInjectOp, hw::StructCreateOp,
+             hw::ConstantOp>(op);
+}
+
 SmallVector<unsigned> circt::msft::makeSequentialRange(unsigned size) {
   SmallVector<unsigned> seq;
   for (size_t i = 0; i < size; ++i)
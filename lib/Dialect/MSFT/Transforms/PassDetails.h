@@ -30,6 +30,9 @@ namespace msft {
 bool isAnyModule(Operation *module);
 hw::ModulePortInfo getModulePortInfo(Operation *op);
 
+/// Is this operation "free" and copy-able?
+bool isWireManipulationOp(Operation *op);
+
 /// Utility for creating {0, 1, 2, ..., size}.
 SmallVector<unsigned> makeSequentialRange(unsigned size);
 
@@ -133,17 +133,16 @@ std::optional<unsigned> UnpackedType::getBitSize() const {
       .Case<PackedType, RealType>([](auto type) { return type.getBitSize(); })
       .Case<UnpackedUnsizedDim>([](auto) { return std::nullopt; })
       .Case<UnpackedArrayDim>([](auto type) -> std::optional<unsigned> {
-        if (auto size = type.getInner().getBitSize())
+        if (auto size = type.getInnerBitSize())
           return (*size) * type.getSize();
         return {};
       })
       .Case<UnpackedRangeDim>([](auto type) -> std::optional<unsigned> {
-        if (auto size = type.getInner().getBitSize())
+        if (auto size = type.getInnerBitSize())
           return (*size) * type.getRange().size;
         return {};
       })
-      .Case<UnpackedIndirectType>(
-          [](auto type) { return type.getInner().getBitSize(); })
+      .Case<UnpackedIndirectType>([](auto type) { return type.getBitSize(); })
       .Case<UnpackedStructType>(
           [](auto type) { return type.getStruct().bitSize; })
       .Default([](auto) { return std::nullopt; });
@@ -279,12 +278,11 @@ std::optional<unsigned> PackedType::getBitSize() const {
       .Case<IntType>([](auto type) { return type.getBitSize(); })
       .Case<PackedUnsizedDim>([](auto) { return std::nullopt; })
       .Case<PackedRangeDim>([](auto type) -> std::optional<unsigned> {
-        if (auto size = type.getInner().getBitSize())
+        if (auto size = type.getInnerBitSize())
           return (*size) * type.getRange().size;
         return {};
       })
-      .Case<PackedIndirectType>(
-          [](auto type) { return type.getInner().getBitSize(); })
+      .Case<PackedIndirectType>([](auto type) { return type.getBitSize(); })
       .Case<EnumType>([](auto type) { return type.getBase().getBitSize(); })
       .Case<PackedStructType>(
           [](auto type) { return type.getStruct().bitSize; });
@@ -574,7 +572,8 @@ struct IndirectTypeStorage : TypeStorage {
       : IndirectTypeStorage(std::get<0>(key), std::get<1>(key),
                             std::get<2>(key)) {}
   IndirectTypeStorage(UnpackedType inner, StringAttr name, LocationAttr loc)
-      : inner(inner), name(name), loc(loc) {}
+      : inner(inner), name(name), loc(loc),
+        fullyResolved(inner.fullyResolved()), bitSize(inner.getBitSize()) {}
   bool operator==(const KeyTy &key) const {
     return std::get<0>(key) == inner && std::get<1>(key) == name &&
            std::get<2>(key) == loc;
@@ -588,12 +587,26 @@ struct IndirectTypeStorage : TypeStorage {
   UnpackedType inner;
   StringAttr name;
   LocationAttr loc;
+  /// The fully resolved inner type and its bit size. The inner type is
+  /// complete by the time the indirection is created, such that these can be
+  /// computed once up front instead of walking the chain of indirections on
+  /// every query.
+  UnpackedType fullyResolved;
+  std::optional<unsigned> bitSize;
 };
 
 UnpackedType getIndirectTypeInner(const TypeStorage *impl) {
   return static_cast<const IndirectTypeStorage *>(impl)->inner;
 }
 
+UnpackedType getIndirectTypeFullyResolved(const TypeStorage *impl) {
+  return static_cast<const IndirectTypeStorage *>(impl)->fullyResolved;
+}
+
+std::optional<unsigned> getIndirectTypeBitSize(const TypeStorage *impl) {
+  return static_cast<const IndirectTypeStorage *>(impl)->bitSize;
+}
+
 Location getIndirectTypeLoc(const TypeStorage *impl) {
   return static_cast<const IndirectTypeStorage *>(impl)->loc;
 }
@@ -643,7 +656,7 @@ namespace detail {
 struct DimStorage : TypeStorage {
   using KeyTy = UnpackedType;
 
-  DimStorage(KeyTy key) : inner(key) {}
+  DimStorage(KeyTy key) : inner(key), innerBitSize(key.getBitSize()) {}
   bool operator==(const KeyTy &key) const { return key == inner; }
   static DimStorage *construct(TypeStorageAllocator &allocator,
                                const KeyTy &key) {
@@ -697,6 +710,9 @@ struct DimStorage : TypeStorage {
   UnpackedType inner;
   UnpackedType resolved;
   UnpackedType fullyResolved;
+  /// The bit size of the inner type, computed once such that the size of
+  /// nested dimensions does not have to be recomputed recursively.
+  std::optional<unsigned> innerBitSize;
 };
 
 struct UnsizedDimStorage : DimStorage {
@@ -774,6 +790,10 @@ std::optional<unsigned> PackedDim::getSize() const {
   return llvm::transformOptional(getRange(), [](auto r) { return r.size; });
 }
 
+std::optional<unsigned> PackedDim::getInnerBitSize() const {
+  return getImpl()->innerBitSize;
+}
+
 const detail::DimStorage *PackedDim::getImpl() const {
   return static_cast<detail::DimStorage *>(this->impl);
 }
@@ -891,6 +911,10 @@ UnpackedType UnpackedDim::fullyResolved() const {
   return getImpl()->fullyResolved;
 }
 
+std::optional<unsigned> UnpackedDim::getInnerBitSize() const {
+  return getImpl()->innerBitSize;
+}
+
 const detail::DimStorage *UnpackedDim::getImpl() const {
   return static_cast<detail::DimStorage *>(this->impl);
 }
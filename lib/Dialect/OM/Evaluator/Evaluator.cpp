@@ -26,10 +26,29 @@ ModuleOp circt::om::Evaluator::getModule() {
   return cast<ModuleOp>(symbolTable.getOp());
 }
 
+/// Get a pointer which uniquely identifies an ObjectValue. Attributes are
+/// uniqued by the context and Objects are hash-consed by the Evaluator, so two
+/// ObjectValues are equal if and only if their pointers are.
+static const void *getOpaquePointer(const ObjectValue &value) {
+  if (auto *object = std::get_if<Object *>(&value))
+    return *object;
+  return std::get<Attribute>(value).getAsOpaquePointer();
+}
+
 /// Instantiate an Object with its class name and actual parameters.
-FailureOr<std::shared_ptr<Object>>
+FailureOr<Object *>
 circt::om::Evaluator::instantiate(StringAttr className,
                                   ArrayRef<ObjectValue> actualParams) {
+  // Return the existing Object if this class was already instantiated with the
+  // same actual parameters.
+  SmallVector<const void *> key;
+  key.push_back(className.getAsOpaquePointer());
+  for (auto &actualParam : actualParams)
+    key.push_back(getOpaquePointer(actualParam));
+  auto existingInstance = instances.find(key);
+  if (existingInstance != instances.end())
+    return existingInstance->second;
+
   ClassOp cls = symbolTable.lookup<ClassOp>(className);
   if (!cls)
     return symbolTable.getOp()->emitError("unknown class name ") << className;
@@ -54,8 +73,8 @@ circt::om::Evaluator::instantiate(StringAttr className,
     if (auto *attr = std::get_if<Attribute>(&actualParam))
       if (auto typedActualParam = attr->dyn_cast_or_null<TypedAttr>())
         actualParamType = typedActualParam.getType();
-    if (auto *object = std::get_if<std::shared_ptr<Object>>(&actualParam))
-      actualParamType = object->get()->getType();
+    if (auto *object = std::get_if<Object *>(&actualParam))
+      actualParamType = (*object)->getType();
 
     if (!actualParamType)
       return cls.emitError("actual parameter for ")
@@ -70,23 +89,15 @@ circt::om::Evaluator::instantiate(StringAttr className,
     }
   }
 
-  // Instantiate the fields.
-  ObjectFields fields;
-  for (auto field : cls.getOps<ClassFieldOp>()) {
-    StringAttr name = field.getSymNameAttr();
-    Value value = field.getValue();
-
-    FailureOr<ObjectValue> result = evaluateValue(value, actualParams);
-    if (failed(result))
-      return failure();
-
-    fields[name] = result.value();
-  }
-
-  // Allocate the Object. Further refinement is expected.
-  auto *object = new Object(cls, fields);
+  // Allocate the Object. Its fields are evaluated lazily, so this does not
+  // recurse into the Objects it refers to.
+  auto *params = allocator.Allocate<ObjectValue>(actualParams.size());
+  std::uninitialized_copy(actualParams.begin(), actualParams.end(), params);
+  auto *object = new (objectAllocator.Allocate())
+      Object(*this, cls, ArrayRef<ObjectValue>(params, actualParams.size()));
 
-  return success(std::shared_ptr<Object>(object));
+  instances[ArrayRef<const void *>(key).copy(allocator)] = object;
+  return object;
 }
 
 /// Evaluate a Value in a Class body according to the semantics of the IR. The
@@ -136,14 +147,8 @@ circt::om::Evaluator::evaluateConstant(ConstantOp op,
 /// Evaluator dispatch function for Object instances.
 FailureOr<ObjectValue> circt::om::Evaluator::evaluateObjectInstance(
     ObjectOp op, ArrayRef<ObjectValue> actualParams) {
-  // First, check if we have already evaluated this object, and return it if so.
-  auto existingInstance = objects.find(op);
-  if (existingInstance != objects.end())
-    return success(existingInstance->second);
-
-  // If we need to instantiate a new object, evaluate values for all of its
-  // actual parameters. Note that this is eager evaluation, which precludes
-  // creating cycles in the object model. Further refinement is expected.
+  // Evaluate the actual parameters of the new Object. Instantiation does not
+  // evaluate any fields, so an Object may refer to itself through them.
   SmallVector<ObjectValue> objectParams;
   for (auto param : op.getActualParams()) {
     FailureOr<ObjectValue> result = evaluateValue(param, actualParams);
@@ -152,11 +157,12 @@ FailureOr<ObjectValue> circt::om::Evaluator::evaluateObjectInstance(
     objectParams.push_back(result.value());
   }
 
-  // Instantiate and return the new Object, saving the instance for later.
-  auto newInstance = instantiate(op.getClassNameAttr(), objectParams);
-  if (succeeded(newInstance))
-    objects[op.getResult()] = newInstance.value();
-  return newInstance;
+  // Instantiate and return the Object, which is shared by all instantiations
+  // of the class with the same actual parameters.
+  auto instance = instantiate(op.getClassNameAttr(), objectParams);
+  if (failed(instance))
+    return failure();
+  return success(ObjectValue(instance.value()));
 }
 
 /// Evaluator dispatch function for Object fields.
@@ -169,16 +175,17 @@ circt::om::Evaluator::evaluateObjectField(ObjectFieldOp op,
   if (failed(currentObjectResult))
     return currentObjectResult;
 
-  std::shared_ptr<Object> currentObject =
-      std::get<std::shared_ptr<Object>>(currentObjectResult.value());
+  Object *currentObject = std::get<Object *>(currentObjectResult.value());
 
   // Iteratively access nested fields through the path until we reach the final
   // field in the path.
   ObjectValue finalField;
   for (auto field : op.getFieldPath().getAsRange<FlatSymbolRefAttr>()) {
     auto currentField = currentObject->getField(field.getAttr());
+    if (failed(currentField))
+      return currentField;
     finalField = currentField.value();
-    if (auto *nextObject = std::get_if<std::shared_ptr<Object>>(&finalField))
+    if (auto *nextObject = std::get_if<Object *>(&finalField))
       currentObject = *nextObject;
   }
 
@@ -186,9 +193,10 @@ circt::om::Evaluator::evaluateObjectField(ObjectFieldOp op,
   return finalField;
 }
 
-/// Construct an Object of the given type with the given fields.
-circt::om::Object::Object(ClassOp cls, ObjectFields &fields)
-    : cls(cls), fields(fields) {}
+/// Construct an Object of the given Class with the given actual parameters.
+circt::om::Object::Object(Evaluator &evaluator, ClassOp cls,
+                          ArrayRef<ObjectValue> actualParams)
+    : evaluator(evaluator), cls(cls), actualParams(actualParams) {}
 
 /// Get the type of the Object.
 Type circt::om::Object::getType() {
@@ -196,10 +204,133 @@ Type circt::om::Object::getType() {
                         FlatSymbolRefAttr::get(cls.getNameAttr()));
 }
 
-/// Get a field of the Object by name.
+/// Get a field of the Object by name, evaluating it on first access.
 FailureOr<ObjectValue> circt::om::Object::getField(StringAttr name) {
-  auto field = fields.find(name);
-  if (field == fields.end())
-    return cls.emitError("field ") << name << " does not exist";
-  return success(fields[name]);
+  auto cachedField = fields.find(name);
+  if (cachedField != fields.end()) {
+    // A null Attribute marks a field which is currently being evaluated.
+    auto *attr = std::get_if<Attribute>(&cachedField->second);
+    if (attr && !*attr)
+      return cls.emitError("field ")
+             << name << " is defined in terms of itself";
+    return success(cachedField->second);
+  }
+
+  for (auto field : cls.getOps<ClassFieldOp>()) {
+    if (field.getSymNameAttr() != name)
+      continue;
+
+    // The map may grow while the field is evaluated, so look it up again to
+    // store the result.
+    fields[name] = Attribute();
+    FailureOr<ObjectValue> result =
+        evaluator.evaluateValue(field.getValue(), actualParams);
+    if (failed(result)) {
+      fields.erase(name);
+      return failure();
+    }
+    fields[name] = result.value();
+    return result;
+  }
+
+  return cls.emitError("field ") << name << " does not exist";
+}
+
+/// Get the names of the fields of the Object, in declaration order.
+SmallVector<StringAttr> circt::om::Object::getFieldNames() {
+  SmallVector<StringAttr> names;
+  for (auto field : cls.getOps<ClassFieldOp>())
+    names.push_back(field.getSymNameAttr());
+  return names;
+}
+
+//===----------------------------------------------------------------------===//
+// JSON Serialization
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// Streams ObjectValues as JSON, numbering the Objects in the order in which
+/// they are first encountered.
+struct JSONSerializer {
+  JSONSerializer(llvm::json::OStream &os) : os(os) {}
+
+  LogicalResult serialize(const ObjectValue &value);
+
+private:
+  LogicalResult serializeObject(Object *object);
+  void serializeAttribute(Attribute attr);
+
+  llvm::json::OStream &os;
+
+  /// The IDs of the Objects written so far.
+  DenseMap<Object *, unsigned> ids;
+};
+} // namespace
+
+LogicalResult JSONSerializer::serialize(const ObjectValue &value) {
+  if (auto *object = std::get_if<Object *>(&value))
+    return serializeObject(*object);
+  serializeAttribute(std::get<Attribute>(value));
+  return success();
+}
+
+LogicalResult JSONSerializer::serializeObject(Object *object) {
+  // Refer back to Objects which have already been written, which also breaks
+  // cycles.
+  auto [it, inserted] = ids.insert({object, ids.size()});
+  unsigned id = it->second;
+  if (!inserted) {
+    os.object([&] { os.attribute("$ref", id); });
+    return success();
+  }
+
+  LogicalResult result = success();
+  os.object([&] {
+    os.attribute("$id", id);
+    os.attribute(
+        "$class",
+        object->getType().cast<ClassType>().getClassName().getValue());
+    for (auto name : object->getFieldNames()) {
+      auto field = object->getField(name);
+      if (failed(field)) {
+        result = failure();
+        return;
+      }
+      os.attributeBegin(name.getValue());
+      result = serialize(field.value());
+      os.attributeEnd();
+      if (failed(result))
+        return;
+    }
+  });
+  return result;
+}
+
+void JSONSerializer::serializeAttribute(Attribute attr) {
+  if (auto boolAttr = attr.dyn_cast<BoolAttr>())
+    return os.value(boolAttr.getValue());
+  if (auto intAttr = attr.dyn_cast<IntegerAttr>()) {
+    // Write the digits directly, since integers may exceed 64 bits.
+    SmallString<16> digits;
+    if (intAttr.getType().isUnsignedInteger())
+      intAttr.getValue().toStringUnsigned(digits);
+    else
+      intAttr.getValue().toStringSigned(digits);
+    return os.rawValue(digits);
+  }
+  if (auto floatAttr = attr.dyn_cast<FloatAttr>())
+    return os.value(floatAttr.getValueAsDouble());
+  if (auto stringAttr = attr.dyn_cast<StringAttr>())
+    return os.value(stringAttr.getValue());
+
+  // Fall back to the textual form of any other Attribute.
+  std::string str;
+  llvm::raw_string_ostream(str) << attr;
+  os.value(str);
+}
+
+/// Stream an ObjectValue as JSON.
+LogicalResult circt::om::serializeJSON(const ObjectValue &value,
+                                       llvm::json::OStream &os) {
+  return JSONSerializer(os).serialize(value);
 }
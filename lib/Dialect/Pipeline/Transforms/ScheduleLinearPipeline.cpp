@@ -41,40 +41,17 @@ static bool ignoreOp(Operation *op) {
   return op->hasTrait<OpTrait::ConstantLike>();
 }
 
-void ScheduleLinearPipelinePass::runOnOperation() {
-  auto pipeline = getOperation();
-
-  // Get operator library for the pipeline.
-  auto opLibAttr = pipeline->getAttrOfType<FlatSymbolRefAttr>("operator_lib");
-  if (!opLibAttr) {
-    pipeline.emitError("missing 'operator_lib' attribute");
-    return signalPassFailure();
-  }
-  auto opLib = dyn_cast_or_null<ssp::OperatorLibraryOp>(
-      SymbolTable::lookupNearestSymbolFrom(pipeline->getParentOp(), opLibAttr));
-  if (!opLib) {
-    pipeline.emitError("operator library '") << opLibAttr << "' not found";
-    return signalPassFailure();
-  }
-
-  auto stageOpIt = pipeline.getOps<PipelineStageOp>();
-  auto stageRegOpIt = pipeline.getOps<PipelineStageRegisterOp>();
-
-  if (stageOpIt.begin() != stageOpIt.end() ||
-      stageRegOpIt.begin() != stageRegOpIt.end()) {
-    pipeline.emitError("Pipeline cannot have any stages or stage registers.");
-    return signalPassFailure();
-  }
-
-  // Load operator info from attribute.
-  auto problem = Problem::get(pipeline);
-
+// Populate the scheduling \p problem with the operations of the \p pipeline,
+// loading the given operator type properties from the \p opLib.
+template <typename ProblemT, typename... OperatorTypePropertyTs>
+static LogicalResult buildProblem(PipelineOp pipeline,
+                                  ssp::OperatorLibraryOp opLib,
+                                  pipeline::ReturnOp returnOp,
+                                  ProblemT &problem) {
   DenseMap<SymbolRefAttr, Problem::OperatorType> operatorTypes;
   SmallDenseMap<StringAttr, unsigned> oprIds;
 
   // Set operation operator types.
-  auto returnOp =
-      cast<pipeline::ReturnOp>(pipeline.getBodyBlock()->getTerminator());
   for (auto &op : pipeline.getOps()) {
     // Skip if is a known non-functional operator
     if (ignoreOp(&op))
@@ -87,6 +64,10 @@ void ScheduleLinearPipelinePass::runOnOperation() {
       // operator type since it is intrinsic to this pass).
       operatorType = problem.getOrInsertOperatorType("return");
       problem.setLatency(operatorType, 0);
+      if constexpr (std::is_same_v<ProblemT, ChainingProblem>) {
+        problem.setIncomingDelay(operatorType, 0.0f);
+        problem.setOutgoingDelay(operatorType, 0.0f);
+      }
     } else {
       // Lookup operator info.
       auto operatorTypeAttr =
@@ -94,7 +75,7 @@ void ScheduleLinearPipelinePass::runOnOperation() {
       if (!operatorTypeAttr) {
         op.emitError()
             << "Expected 'ssp.operator_type' attribute on operation.";
-        return signalPassFailure();
+        return failure();
       }
 
       auto operatorTypeIt = operatorTypes.find(operatorTypeAttr);
@@ -105,12 +86,13 @@ void ScheduleLinearPipelinePass::runOnOperation() {
         if (!opTypeOp) {
           op.emitError() << "Operator type '" << operatorTypeAttr
                          << "' not found in operator library.";
-          return signalPassFailure();
+          return failure();
         }
 
         auto insertRes = operatorTypes.try_emplace(
-            operatorTypeAttr, ssp::loadOperatorType<Problem, ssp::LatencyAttr>(
-                                  problem, opTypeOp, oprIds));
+            operatorTypeAttr,
+            ssp::loadOperatorType<ProblemT, OperatorTypePropertyTs...>(
+                problem, opTypeOp, oprIds));
         operatorTypeIt = insertRes.first;
       }
       operatorType = operatorTypeIt->second;
@@ -127,18 +109,75 @@ void ScheduleLinearPipelinePass::runOnOperation() {
       if (failed(problem.insertDependence({&op, returnOp.getOperation()}))) {
         op.emitError()
             << "Failed to insert dependence from operation to return op.";
-        return signalPassFailure();
+        return failure();
       }
     }
   }
 
-  // Solve!
-  assert(succeeded(problem.check()));
-  if (failed(scheduling::scheduleSimplex(problem, returnOp.getOperation()))) {
-    pipeline.emitError("Failed to schedule pipeline.");
+  return success();
+}
+
+void ScheduleLinearPipelinePass::runOnOperation() {
+  auto pipeline = getOperation();
+
+  // Get operator library for the pipeline.
+  auto opLibAttr = pipeline->getAttrOfType<FlatSymbolRefAttr>("operator_lib");
+  if (!opLibAttr) {
+    pipeline.emitError("missing 'operator_lib' attribute");
+    return signalPassFailure();
+  }
+  auto opLib = dyn_cast_or_null<ssp::OperatorLibraryOp>(
+      SymbolTable::lookupNearestSymbolFrom(pipeline->getParentOp(), opLibAttr));
+  if (!opLib) {
+    pipeline.emitError("operator library '") << opLibAttr << "' not found";
+    return signalPassFailure();
+  }
+
+  auto stageOpIt = pipeline.getOps<PipelineStageOp>();
+  auto stageRegOpIt = pipeline.getOps<PipelineStageRegisterOp>();
+
+  if (stageOpIt.begin() != stageOpIt.end() ||
+      stageRegOpIt.begin() != stageRegOpIt.end()) {
+    pipeline.emitError("Pipeline cannot have any stages or stage registers.");
     return signalPassFailure();
   }
-  assert(succeeded(problem.verify()));
+
+  auto returnOp =
+      cast<pipeline::ReturnOp>(pipeline.getBodyBlock()->getTerminator());
+
+  // Set up and solve the scheduling problem. If a target cycle time is given,
+  // the operator delays are taken into account as well, such that the
+  // combinational chains within each stage meet the cycle time.
+  std::unique_ptr<Problem> problem;
+  if (cycleTime > 0.0f) {
+    auto chainingProblem =
+        std::make_unique<ChainingProblem>(ChainingProblem::get(pipeline));
+    if (failed(buildProblem<ChainingProblem, ssp::LatencyAttr,
+                            ssp::IncomingDelayAttr, ssp::OutgoingDelayAttr>(
+            pipeline, opLib, returnOp, *chainingProblem)) ||
+        failed(chainingProblem->check()))
+      return signalPassFailure();
+    if (failed(scheduling::scheduleSimplex(
+            *chainingProblem, returnOp.getOperation(), cycleTime))) {
+      pipeline.emitError("Failed to schedule pipeline.");
+      return signalPassFailure();
+    }
+    assert(succeeded(chainingProblem->verify()));
+    problem = std::move(chainingProblem);
+  } else {
+    auto basicProblem = std::make_unique<Problem>(Problem::get(pipeline));
+    if (failed(buildProblem<Problem, ssp::LatencyAttr>(
+            pipeline, opLib, returnOp, *basicProblem)))
+      return signalPassFailure();
+    assert(succeeded(basicProblem->check()));
+    if (failed(scheduling::scheduleSimplex(*basicProblem,
+                                           returnOp.getOperation()))) {
+      pipeline.emitError("Failed to schedule pipeline.");
+      return signalPassFailure();
+    }
+    assert(succeeded(basicProblem->verify()));
+    problem = std::move(basicProblem);
+  }
 
   // Gather stage results.
   using StageIdx = unsigned;
@@ -161,11 +200,11 @@ void ScheduleLinearPipelinePass::runOnOperation() {
       otherOps.push_back(&op);
       continue;
     }
-    unsigned startTime = *problem.getStartTime(&op);
+    unsigned startTime = *problem->getStartTime(&op);
     stageMap[startTime].push_back(&op);
 
     auto oldEndTime = currentEndTime;
-    currentEndTime = std::max(currentEndTime, *problem.getEndTime(&op));
+    currentEndTime = std::max(currentEndTime, *problem->getEndTime(&op));
     for (unsigned i = oldEndTime; i < currentEndTime; ++i) {
       auto nextStage = b.create<PipelineStageOp>(loc, stageValid);
       stageValid = nextStage.getValid();
@@ -14,8 +14,11 @@
 
 #include "circt/Scheduling/Algorithms.h"
 
+#include "mlir/IR/Threading.h"
 #include "llvm/ADT/StringExtras.h"
 
+#include <atomic>
+
 using namespace circt;
 using namespace scheduling;
 using namespace ssp;
@@ -50,6 +53,18 @@ static std::optional<float> getCycleTime(StringRef options) {
   return std::nullopt;
 }
 
+// Determine the number of candidate IIs to explore concurrently (only relevant
+// for `ModuloProblem` instances).
+static unsigned getNumCandidateIIs(StringRef options) {
+  for (StringRef option : llvm::split(options, ',')) {
+    unsigned numCandidateIIs;
+    if (option.consume_front("candidate-iis=") &&
+        !option.getAsInteger(10, numCandidateIIs))
+      return numCandidateIIs;
+  }
+  return 1;
+}
+
 //===----------------------------------------------------------------------===//
 // ASAP scheduler
 //===----------------------------------------------------------------------===//
@@ -57,8 +72,8 @@ static std::optional<float> getCycleTime(StringRef options) {
 static InstanceOp scheduleWithASAP(InstanceOp instOp, OpBuilder &builder) {
   auto problemName = instOp.getProblemName();
   if (!problemName.equals("Problem")) {
-    llvm::errs() << "ssp-schedule: Unsupported problem '" << problemName
-                 << "' for ASAP scheduler\n";
+    instOp.emitError() << "unsupported problem '" << problemName
+                       << "' for ASAP scheduler";
     return {};
   }
 
@@ -69,6 +84,32 @@ static InstanceOp scheduleWithASAP(InstanceOp instOp, OpBuilder &builder) {
   return saveProblem(prob, builder);
 }
 
+//===----------------------------------------------------------------------===//
+// List schedulers
+//===----------------------------------------------------------------------===//
+
+template <typename ProblemT>
+static InstanceOp scheduleProblemTWithList(InstanceOp instOp,
+                                           OpBuilder &builder) {
+  auto prob = loadProblem<ProblemT>(instOp);
+  if (failed(prob.check()) || failed(scheduling::scheduleList(prob)) ||
+      failed(prob.verify()))
+    return {};
+  return saveProblem(prob, builder);
+}
+
+static InstanceOp scheduleWithList(InstanceOp instOp, OpBuilder &builder) {
+  auto problemName = instOp.getProblemName();
+  if (problemName.equals("SharedOperatorsProblem"))
+    return scheduleProblemTWithList<SharedOperatorsProblem>(instOp, builder);
+  if (problemName.equals("ModuloProblem"))
+    return scheduleProblemTWithList<ModuloProblem>(instOp, builder);
+
+  instOp.emitError() << "unsupported problem '" << problemName
+                     << "' for list scheduler";
+  return {};
+}
+
 //===----------------------------------------------------------------------===//
 // Simplex schedulers
 //===----------------------------------------------------------------------===//
@@ -85,6 +126,31 @@ static InstanceOp scheduleProblemTWithSimplex(InstanceOp instOp,
   return saveProblem(prob, builder);
 }
 
+static InstanceOp scheduleSharedOperatorsProblemWithSimplex(
+    InstanceOp instOp, Operation *lastOp, Deadline deadline,
+    OpBuilder &builder) {
+  auto prob = loadProblem<SharedOperatorsProblem>(instOp);
+  if (failed(prob.check()) ||
+      failed(scheduling::scheduleSimplex(prob, lastOp, deadline)) ||
+      failed(prob.verify()))
+    return {};
+  return saveProblem(prob, builder);
+}
+
+static InstanceOp scheduleModuloProblemWithSimplex(InstanceOp instOp,
+                                                   Operation *lastOp,
+                                                   unsigned numCandidateIIs,
+                                                   Deadline deadline,
+                                                   OpBuilder &builder) {
+  auto prob = loadProblem<ModuloProblem>(instOp);
+  if (failed(prob.check()) ||
+      failed(scheduling::scheduleSimplex(prob, lastOp, numCandidateIIs,
+                                         deadline)) ||
+      failed(prob.verify()))
+    return {};
+  return saveProblem(prob, builder);
+}
+
 static InstanceOp scheduleChainingProblemWithSimplex(InstanceOp instOp,
                                                      Operation *lastOp,
                                                      float cycleTime,
@@ -98,13 +164,11 @@ static InstanceOp scheduleChainingProblemWithSimplex(InstanceOp instOp,
 }
 
 static InstanceOp scheduleWithSimplex(InstanceOp instOp, StringRef options,
-                                      OpBuilder &builder) {
+                                      Deadline deadline, OpBuilder &builder) {
   auto lastOp = getLastOp(instOp, options);
   if (!lastOp) {
-    auto instName = instOp.getSymName().value_or("unnamed");
-    llvm::errs()
-        << "ssp-schedule: Ambiguous objective for simplex scheduler: Instance '"
-        << instName << "' has no designated last operation\n";
+    instOp.emitError() << "ambiguous objective for simplex scheduler: instance "
+                          "has no designated last operation";
     return {};
   }
 
@@ -114,21 +178,22 @@ static InstanceOp scheduleWithSimplex(InstanceOp instOp, StringRef options,
   if (problemName.equals("CyclicProblem"))
     return scheduleProblemTWithSimplex<CyclicProblem>(instOp, lastOp, builder);
   if (problemName.equals("SharedOperatorsProblem"))
-    return scheduleProblemTWithSimplex<SharedOperatorsProblem>(instOp, lastOp,
-                                                               builder);
+    return scheduleSharedOperatorsProblemWithSimplex(instOp, lastOp, deadline,
+                                                     builder);
   if (problemName.equals("ModuloProblem"))
-    return scheduleProblemTWithSimplex<ModuloProblem>(instOp, lastOp, builder);
+    return scheduleModuloProblemWithSimplex(
+        instOp, lastOp, getNumCandidateIIs(options), deadline, builder);
   if (problemName.equals("ChainingProblem")) {
     if (auto cycleTime = getCycleTime(options))
       return scheduleChainingProblemWithSimplex(instOp, lastOp,
                                                 cycleTime.value(), builder);
-    llvm::errs() << "ssp-schedule: Missing option 'cycle-time' for "
-                    "ChainingProblem simplex scheduler\n";
+    instOp.emitError() << "missing option 'cycle-time' for "
+                          "ChainingProblem simplex scheduler";
     return {};
   }
 
-  llvm::errs() << "ssp-schedule: Unsupported problem '" << problemName
-               << "' for simplex scheduler\n";
+  instOp.emitError() << "unsupported problem '" << problemName
+                     << "' for simplex scheduler";
   return {};
 }
 
@@ -152,10 +217,8 @@ static InstanceOp scheduleWithLP(InstanceOp instOp, StringRef options,
                                  OpBuilder &builder) {
   auto lastOp = getLastOp(instOp, options);
   if (!lastOp) {
-    auto instName = instOp.getSymName().value_or("unnamed");
-    llvm::errs()
-        << "ssp-schedule: Ambiguous objective for LP scheduler: Instance '"
-        << instName << "' has no designated last operation\n";
+    instOp.emitError() << "ambiguous objective for LP scheduler: instance "
+                          "has no designated last operation";
     return {};
   }
 
@@ -165,8 +228,8 @@ static InstanceOp scheduleWithLP(InstanceOp instOp, StringRef options,
   if (problemName.equals("CyclicProblem"))
     return scheduleProblemTWithLP<CyclicProblem>(instOp, lastOp, builder);
 
-  llvm::errs() << "ssp-schedule: Unsupported problem '" << problemName
-               << "' for LP scheduler\n";
+  instOp.emitError() << "unsupported problem '" << problemName
+                     << "' for LP scheduler";
   return {};
 }
 
@@ -178,17 +241,15 @@ static InstanceOp scheduleWithCPSAT(InstanceOp instOp, StringRef options,
                                     OpBuilder &builder) {
   auto lastOp = getLastOp(instOp, options);
   if (!lastOp) {
-    auto instName = instOp.getSymName().value_or("unnamed");
-    llvm::errs()
-        << "ssp-schedule: Ambiguous objective for CPSAT scheduler: Instance '"
-        << instName << "' has no designated last operation\n";
+    instOp.emitError() << "ambiguous objective for CPSAT scheduler: instance "
+                          "has no designated last operation";
     return {};
   }
 
   auto problemName = instOp.getProblemName();
   if (!problemName.equals("SharedOperatorsProblem")) {
-    llvm::errs() << "ssp-schedule: Unsupported problem '" << problemName
-                 << "' for CPSAT scheduler\n";
+    instOp.emitError() << "unsupported problem '" << problemName
+                       << "' for CPSAT scheduler";
     return {};
   }
 
@@ -206,11 +267,14 @@ static InstanceOp scheduleWithCPSAT(InstanceOp instOp, StringRef options,
 //===----------------------------------------------------------------------===//
 
 static InstanceOp scheduleWith(InstanceOp instOp, StringRef scheduler,
-                               StringRef options, OpBuilder &builder) {
+                               StringRef options, Deadline deadline,
+                               OpBuilder &builder) {
   if (scheduler.empty() || scheduler.equals("simplex"))
-    return scheduleWithSimplex(instOp, options, builder);
+    return scheduleWithSimplex(instOp, options, deadline, builder);
   if (scheduler.equals("asap"))
     return scheduleWithASAP(instOp, builder);
+  if (scheduler.equals("list"))
+    return scheduleWithList(instOp, builder);
 #ifdef SCHEDULING_OR_TOOLS
   if (scheduler.equals("lp"))
     return scheduleWithLP(instOp, options, builder);
@@ -218,8 +282,8 @@ static InstanceOp scheduleWith(InstanceOp instOp, StringRef scheduler,
     return scheduleWithCPSAT(instOp, options, builder);
 #endif
 
-  llvm::errs() << "ssp-schedule: Unsupported scheduler '" << scheduler
-               << "' requested\n";
+  instOp.emitError() << "unsupported scheduler '" << scheduler
+                     << "' requested";
   return {};
 }
 
@@ -235,19 +299,64 @@ struct SchedulePass : public ScheduleBase<SchedulePass> {
 
 void SchedulePass::runOnOperation() {
   auto moduleOp = getOperation();
+  auto instanceOps = llvm::to_vector(moduleOp.getOps<InstanceOp>());
+
+  // Schedule the instances in parallel. They only share the operator type
+  // libraries at the module level, which are merely read. The scheduled
+  // instances are built detached from the module, and inserted afterwards.
+  // All instances are attempted even if one fails, such that the diagnostics
+  // do not depend on the order in which the workers pick up the instances.
+  SmallVector<InstanceOp> scheduledOps(instanceOps.size());
+  std::atomic<bool> anyFailed(false);
+  mlir::parallelFor(&getContext(), 0, instanceOps.size(), [&](size_t i) {
+    auto instOp = instanceOps[i];
+    OpBuilder builder(&getContext());
+    auto start = std::chrono::steady_clock::now();
+    Deadline deadline;
+    if (timeout != 0)
+      deadline = start + std::chrono::milliseconds(timeout.getValue());
 
-  SmallVector<InstanceOp> instanceOps;
-  OpBuilder builder(&getContext());
-  for (auto instOp : moduleOp.getOps<InstanceOp>()) {
-    builder.setInsertionPoint(instOp);
     auto scheduledOp = scheduleWith(instOp, scheduler.getValue(),
-                                    schedulerOptions.getValue(), builder);
-    if (!scheduledOp)
-      return signalPassFailure();
-    instanceOps.push_back(instOp);
+                                    schedulerOptions.getValue(), deadline,
+                                    builder);
+
+    // Fall back to the list scheduler if the simplex heuristics ran out
+    // of time. They fail silently in that case.
+    auto problemName = instOp.getProblemName();
+    if (!scheduledOp && deadline &&
+        std::chrono::steady_clock::now() > *deadline &&
+        (scheduler.empty() || scheduler == "simplex") &&
+        (problemName == "SharedOperatorsProblem" ||
+         problemName == "ModuloProblem")) {
+      ++numTimeouts;
+      scheduledOp = scheduleWithList(instOp, builder);
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    totalSolveTime += elapsed.count();
+    maxSolveTime.updateMax(elapsed.count());
+    if (!scheduledOp) {
+      anyFailed = true;
+      return;
+    }
+    ++numInstances;
+    scheduledOps[i] = scheduledOp;
+  });
+
+  if (anyFailed) {
+    for (auto scheduledOp : scheduledOps)
+      if (scheduledOp)
+        scheduledOp.erase();
+    return signalPassFailure();
   }
 
-  llvm::for_each(instanceOps, [](InstanceOp op) { op.erase(); });
+  OpBuilder builder(&getContext());
+  for (auto [instOp, scheduledOp] : llvm::zip(instanceOps, scheduledOps)) {
+    builder.setInsertionPoint(instOp);
+    builder.insert(scheduledOp);
+    instOp.erase();
+  }
 }
 
 std::unique_ptr<mlir::Pass> circt::ssp::createSchedulePass() {
@@ -66,26 +66,25 @@ struct AlwaysLikeOpInfo : public llvm::DenseMapInfo<Operation *> {
 
 } // end anonymous namespace
 
-// Merge two regions together. These regions must only have a one block.
-static void mergeRegions(Region *region1, Region *region2) {
+// Append the contents of the second region to the first one. These regions
+// must only have a one block.
+static void appendRegion(Region *region1, Region *region2) {
   assert(region1->getBlocks().size() <= 1 && region2->getBlocks().size() <= 1 &&
          "Can only merge regions with a single block");
+  // If the second region is empty, there is nothing to move.
+  if (region2->empty())
+    return;
+
+  // If the first region has no block, move the second region's block over.
   if (region1->empty()) {
-    // If both regions are empty, move on to the next pair of regions
-    if (region2->empty())
-      return;
-    // If the first region has no block, move the second region's block over.
     region1->getBlocks().splice(region1->end(), region2->getBlocks());
     return;
   }
 
-  // If the second region is not empty, splice its block into the start of the
-  // first region.
-  if (!region2->empty()) {
-    auto &block1 = region1->front();
-    auto &block2 = region2->front();
-    block1.getOperations().splice(block1.begin(), block2.getOperations());
-  }
+  // Otherwise, splice the second block onto the end of the first one.
+  auto &block1 = region1->front();
+  auto &block2 = region2->front();
+  block1.getOperations().splice(block1.end(), block2.getOperations());
 }
 
 //===----------------------------------------------------------------------===//
@@ -103,18 +102,29 @@ struct HWCleanupPass : public sv::HWCleanupBase<HWCleanupPass> {
   void runOnProceduralRegion(Region &region);
 
 private:
-  /// Inline all regions from the second operation into the first and delete the
-  /// second operation.
-  void mergeOperationsIntoFrom(Operation *op1, Operation *op2) {
+  /// Merge the earlier operation `op2` into the later operation `op1`: the
+  /// merged operation takes the place, location and attributes of `op1`, and
+  /// its regions hold the contents of `op2` followed by those of `op1`.
+  /// Returns the merged operation, or `op1` if the operations can't be merged.
+  ///
+  /// Instead of moving the contents of `op2` into `op1`, this moves `op2` to
+  /// the position of `op1` and appends the contents of `op1` to it.  When many
+  /// operations are merged one after another, the merged body keeps growing,
+  /// and moving it on every merge would be quadratic.
+  Operation *mergeOperationsIntoFrom(Operation *op1, Operation *op2) {
     // If either op1 or op2 has SV attributues, we cannot merge the ops.
     if (sv::hasSVAttributes(op1) || sv::hasSVAttributes(op2))
-      return;
+      return op1;
     assert(op1 != op2 && "Cannot merge an op into itself");
+    op2->moveBefore(op1);
     for (size_t i = 0, e = op1->getNumRegions(); i != e; ++i)
-      mergeRegions(&op1->getRegion(i), &op2->getRegion(i));
+      appendRegion(&op2->getRegion(i), &op1->getRegion(i));
+    op2->setLoc(op1->getLoc());
+    op2->setAttrs(op1->getAttrDictionary());
 
-    op2->erase();
+    op1->erase();
     anythingChanged = true;
+    return op2;
   }
 
   bool anythingChanged;
@@ -167,27 +177,35 @@ void HWCleanupPass::runOnGraphRegion(Region &region) {
       if (itAndInserted.second)
         continue;
       auto *existingAlways = *itAndInserted.first;
-      mergeOperationsIntoFrom(&op, existingAlways);
+      auto *merged = mergeOperationsIntoFrom(&op, existingAlways);
+      if (merged == existingAlways)
+        ++numAlwaysMerged;
 
-      *itAndInserted.first = &op;
+      *itAndInserted.first = merged;
       continue;
     }
 
     // Merge graph ifdefs anywhere in the module.
     if (auto ifdefOp = dyn_cast<sv::IfDefOp>(op)) {
       auto *&entry = ifdefOps[ifdefOp.getCondAttr()];
+      Operation *merged = ifdefOp;
       if (entry)
-        mergeOperationsIntoFrom(ifdefOp, entry);
+        merged = mergeOperationsIntoFrom(ifdefOp, entry);
+      if (merged == entry)
+        ++numIfDefsMerged;
 
-      entry = ifdefOp;
+      entry = merged;
       continue;
     }
 
     // Merge initial ops anywhere in the module.
     if (auto initialOp = dyn_cast<sv::InitialOp>(op)) {
+      Operation *merged = initialOp;
       if (initialOpSeen)
-        mergeOperationsIntoFrom(initialOp, initialOpSeen);
-      initialOpSeen = initialOp;
+        merged = mergeOperationsIntoFrom(initialOp, initialOpSeen);
+      if (merged == initialOpSeen)
+        ++numInitialsMerged;
+      initialOpSeen = cast<sv::InitialOp>(merged);
       continue;
     }
   }
@@ -206,7 +224,9 @@ void HWCleanupPass::runOnProceduralRegion(Region &region) {
   Block &body = region.front();
 
   Operation *lastSideEffectingOp = nullptr;
-  for (Operation &op : llvm::make_early_inc_range(body)) {
+  for (Operation &nextOp : llvm::make_early_inc_range(body)) {
+    Operation *op = &nextOp;
+
     // Merge procedural ifdefs with neighbors in the procedural region.
     if (auto ifdef = dyn_cast<sv::IfDefProceduralOp>(op)) {
       if (auto prevIfDef =
@@ -214,7 +234,9 @@ void HWCleanupPass::runOnProceduralRegion(Region &region) {
         if (ifdef.getCond() == prevIfDef.getCond()) {
           // We know that there are no side effective operations between the
           // two, so merge the first one into this one.
-          mergeOperationsIntoFrom(ifdef, prevIfDef);
+          op = mergeOperationsIntoFrom(ifdef, prevIfDef);
+          if (op == prevIfDef)
+            ++numProceduralMerged;
         }
       }
     }
@@ -225,14 +247,16 @@ void HWCleanupPass::runOnProceduralRegion(Region &region) {
         if (ifop.getCond() == prevIf.getCond()) {
           // We know that there are no side effective operations between the
           // two, so merge the first one into this one.
-          mergeOperationsIntoFrom(ifop, prevIf);
+          op = mergeOperationsIntoFrom(ifop, prevIf);
+          if (op == prevIf)
+            ++numProceduralMerged;
         }
       }
     }
 
     // Keep track of the last side effecting operation we've seen.
-    if (!mlir::isMemoryEffectFree(&op))
-      lastSideEffectingOp = &op;
+    if (!mlir::isMemoryEffectFree(op))
+      lastSideEffectingOp = op;
   }
 
   for (Operation &op : llvm::make_early_inc_range(body)) {
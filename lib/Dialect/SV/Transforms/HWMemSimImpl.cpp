@@ -19,7 +19,9 @@
 #include "circt/Dialect/HW/Namespace.h"
 #include "circt/Dialect/SV/SVPasses.h"
 #include "circt/Dialect/Seq/SeqAttributes.h"
+#include "mlir/IR/IRMapping.h"
 #include "mlir/IR/ImplicitLocOpBuilder.h"
+#include "mlir/IR/Threading.h"
 #include "llvm/ADT/TypeSwitch.h"
 #include "llvm/Support/Path.h"
 
@@ -47,8 +49,61 @@ struct FirMemory {
   bool initIsBinary;
   bool initIsInline;
 };
+
+/// Everything that determines the body generated for a memory module: the
+/// memory configuration and the port signature of the module.  Memories with
+/// the same shape get identical bodies.
+struct MemoryShape {
+  FirMemory mem;
+  Attribute functionType;
+  Attribute argNames;
+  Attribute resultNames;
+  Attribute argAttrs;
+  Attribute resultAttrs;
+
+  auto getAsTuple() const {
+    return std::make_tuple(
+        mem.numReadPorts, mem.numWritePorts, mem.numReadWritePorts,
+        mem.dataWidth, mem.depth, mem.maskGran, mem.readLatency,
+        mem.writeLatency, mem.readUnderWrite, mem.writeUnderWrite,
+        ArrayRef<int32_t>(mem.writeClockIDs), mem.initFilename,
+        mem.initIsBinary, mem.initIsInline, functionType, argNames,
+        resultNames, argAttrs, resultAttrs);
+  }
+};
 } // end anonymous namespace
 
+namespace llvm {
+template <>
+struct DenseMapInfo<MemoryShape> {
+  static MemoryShape getEmptyKey() {
+    MemoryShape shape{};
+    shape.functionType = DenseMapInfo<Attribute>::getEmptyKey();
+    return shape;
+  }
+  static MemoryShape getTombstoneKey() {
+    MemoryShape shape{};
+    shape.functionType = DenseMapInfo<Attribute>::getTombstoneKey();
+    return shape;
+  }
+  static unsigned getHashValue(const MemoryShape &shape) {
+    const auto &mem = shape.mem;
+    return llvm::hash_combine(
+        mem.numReadPorts, mem.numWritePorts, mem.numReadWritePorts,
+        mem.dataWidth, mem.depth, mem.maskGran, mem.readLatency,
+        mem.writeLatency, mem.readUnderWrite, mem.writeUnderWrite,
+        llvm::hash_combine_range(mem.writeClockIDs.begin(),
+                                 mem.writeClockIDs.end()),
+        mem.initFilename, mem.initIsBinary, mem.initIsInline,
+        shape.functionType, shape.argNames, shape.resultNames, shape.argAttrs,
+        shape.resultAttrs);
+  }
+  static bool isEqual(const MemoryShape &lhs, const MemoryShape &rhs) {
+    return lhs.getAsTuple() == rhs.getAsTuple();
+  }
+};
+} // namespace llvm
+
 namespace {
 
 class HWMemSimImpl {
@@ -703,6 +758,17 @@ void HWMemSimImplPass::runOnOperation() {
   SmallVector<HWModuleGeneratedOp> toErase;
   bool anythingChanged = false;
 
+  // The simulation models to generate, grouped by the shape of the memory.
+  // The first module of each group gets its body generated, and the others
+  // get a copy of it.
+  SmallVector<std::pair<HWModuleOp, FirMemory>> representatives;
+  SmallVector<std::pair<HWModuleOp, unsigned>> duplicates;
+  DenseMap<MemoryShape, unsigned> shapeToRepresentative;
+
+  // Memories initialized from a separate file create new top-level modules
+  // and symbols, so they are generated serially.
+  SmallVector<std::pair<HWModuleOp, FirMemory>> serialMemories;
+
   for (auto op :
        llvm::make_early_inc_range(topModule.getOps<HWModuleGeneratedOp>())) {
     auto oldModule = cast<HWModuleGeneratedOp>(op);
@@ -731,11 +797,22 @@ void HWMemSimImplPass::runOnOperation() {
         newModule.setCommentAttr(
             builder.getStringAttr("VCS coverage exclude_file"));
 
-        HWMemSimImpl(ignoreReadEnable, addMuxPragmas, disableMemRandomization,
-                     disableRegRandomization,
-                     addVivadoRAMAddressConflictSynthesisBugWorkaround,
-                     mlirModuleNamespace)
-            .generateMemory(newModule, mem);
+        if (!mem.initFilename.empty() && !mem.initIsInline) {
+          serialMemories.push_back({newModule, mem});
+        } else {
+          MemoryShape shape{mem,
+                            oldModule.getFunctionTypeAttr(),
+                            oldModule.getArgNamesAttr(),
+                            oldModule.getResultNamesAttr(),
+                            oldModule.getArgAttrsAttr(),
+                            oldModule.getResAttrsAttr()};
+          auto [it, inserted] = shapeToRepresentative.insert(
+              {std::move(shape), representatives.size()});
+          if (inserted)
+            representatives.push_back({newModule, mem});
+          else
+            duplicates.push_back({newModule, it->second});
+        }
       }
 
       oldModule.erase();
@@ -743,6 +820,57 @@ void HWMemSimImplPass::runOnOperation() {
     }
   }
 
+  auto generateMemory = [&](HWModuleOp module, const FirMemory &mem) {
+    HWMemSimImpl(ignoreReadEnable, addMuxPragmas, disableMemRandomization,
+                 disableRegRandomization,
+                 addVivadoRAMAddressConflictSynthesisBugWorkaround,
+                 mlirModuleNamespace)
+        .generateMemory(module, mem);
+  };
+
+  // Generate one body per unique memory shape.  Each body is built inside its
+  // own module, so the bodies can be generated in parallel.
+  mlir::parallelForEach(&getContext(), representatives, [&](auto &entry) {
+    generateMemory(entry.first, entry.second);
+  });
+
+  // Copy the bodies into the memories with the same shape.  The generated
+  // operations all carry the location of their module, and verbatim
+  // randomization code refers to inner symbols of its module by name, so both
+  // have to be updated to the new module.
+  mlir::parallelForEach(&getContext(), duplicates, [&](auto &entry) {
+    auto [module, representativeIndex] = entry;
+    auto representative = representatives[representativeIndex].first;
+    auto &body = module.getBody();
+    body.getBlocks().clear();
+    IRMapping mapping;
+    representative.getBody().cloneInto(&body, mapping);
+
+    auto oldName = representative.getNameAttr();
+    auto newName = module.getNameAttr();
+    auto loc = module.getLoc();
+    module.walk([&](Operation *op) {
+      op->setLoc(loc);
+      auto verbatim = dyn_cast<sv::VerbatimOp>(op);
+      if (!verbatim || verbatim.getSymbols().empty())
+        return;
+      SmallVector<Attribute> symbols;
+      for (auto symbol : verbatim.getSymbols()) {
+        auto innerRef = symbol.dyn_cast<hw::InnerRefAttr>();
+        if (innerRef && innerRef.getModule() == oldName)
+          symbol = hw::InnerRefAttr::get(newName, innerRef.getName());
+        symbols.push_back(symbol);
+      }
+      verbatim.setSymbolsAttr(ArrayAttr::get(op->getContext(), symbols));
+    });
+  });
+
+  for (auto &[module, mem] : serialMemories)
+    generateMemory(module, mem);
+
+  numMemoriesGenerated += representatives.size() + serialMemories.size();
+  numMemoriesDeduplicated += duplicates.size();
+
   if (!anythingChanged)
     markAllAnalysesPreserved();
 }
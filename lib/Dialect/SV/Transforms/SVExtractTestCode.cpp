@@ -43,10 +43,56 @@ struct InstanceInfo {
 // StubExternalModules Helpers
 //===----------------------------------------------------------------------===//
 
+namespace {
+/// An insertion-ordered set of operations which supports constant-time
+/// removal.  The slices of all the roots in a module are accumulated into one
+/// of these, and each root is removed from it again once its slice has been
+/// computed.  A `SetVector` would have to shift its whole vector for each of
+/// these removals, which is quadratic in modules with many roots.
+class SliceSet {
+public:
+  explicit SliceSet(const SetVector<Operation *> &ops) {
+    for (auto *op : ops)
+      insert(op);
+  }
+
+  bool contains(Operation *op) const { return positions.count(op); }
+
+  void insert(Operation *op) {
+    if (positions.try_emplace(op, order.size()).second)
+      order.push_back(op);
+  }
+
+  /// Remove an operation, leaving a hole in the order which is skipped when
+  /// the set is read back.
+  void remove(Operation *op) {
+    auto it = positions.find(op);
+    if (it == positions.end())
+      return;
+    order[it->second] = nullptr;
+    positions.erase(it);
+  }
+
+  /// Replace the contents of `ops` with the operations in this set, in
+  /// insertion order.
+  void moveTo(SetVector<Operation *> &ops) {
+    ops.clear();
+    for (auto *op : order)
+      if (op)
+        ops.insert(op);
+    order.clear();
+    positions.clear();
+  }
+
+private:
+  SmallVector<Operation *> order;
+  DenseMap<Operation *, unsigned> positions;
+};
+} // namespace
+
 // Reimplemented from SliceAnalysis to use a worklist rather than recursion and
 // non-insert ordered set.
-static void getBackwardSliceSimple(Operation *rootOp,
-                                   SetVector<Operation *> &backwardSlice,
+static void getBackwardSliceSimple(Operation *rootOp, SliceSet &backwardSlice,
                                    std::function<bool(Operation *)> filter) {
   SmallVector<Operation *> worklist;
   worklist.push_back(rootOp);
@@ -134,12 +180,14 @@ static bool getForwardSliceSimple(Operation *rootOp,
 // Compute the dataflow for a set of ops.
 static void dataflowSlice(SetVector<Operation *> &ops,
                           SetVector<Operation *> &results) {
+  SliceSet slice(results);
   for (auto op : ops) {
-    getBackwardSliceSimple(op, results, [](Operation *testOp) -> bool {
+    getBackwardSliceSimple(op, slice, [](Operation *testOp) -> bool {
       return !isa<sv::ReadInOutOp>(testOp) && !isa<hw::InstanceOp>(testOp) &&
              !isa<sv::PAssignOp>(testOp) && !isa<sv::BPAssignOp>(testOp);
     });
   }
+  slice.moveTo(results);
 }
 
 // Compute the ops defining the blocks a set of ops are in.
@@ -187,7 +235,7 @@ static void addInstancesToCloneSet(
   SmallVector<Value> inputsToAdd;
 
   // Track inputs to remove, which come from instances that will be extracted.
-  SmallVector<Value> inputsToRemove;
+  DenseSet<Value> inputsToRemove;
 
   // Track instances to potentially extract.
   llvm::SmallDenseSet<hw::InstanceOp> instancesToExtract;
@@ -253,7 +301,7 @@ static void addInstancesToCloneSet(
 
     // Mark the instance results to be removed from the input set.
     for (auto result : instance.getResults())
-      inputsToRemove.push_back(result);
+      inputsToRemove.insert(result);
 
     // Add the instance to the map of extracted instances by module.
     extractedInstances[instance.getModuleNameAttr().getAttr()].insert(instance);
@@ -277,8 +325,7 @@ static void addInstancesToCloneSet(
   }
 
   // Remove any inputs marked for removal.
-  for (auto v : inputsToRemove)
-    inputs.remove(v);
+  inputs.remove_if([&](Value v) { return inputsToRemove.contains(v); });
 
   // Add any inputs marked for addition.
   for (auto v : inputsToAdd)
@@ -0,0 +1,202 @@
+//===- SVTraceSignals.cpp - Selective waveform dumping ----------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass adds the instrumentation dumping the signals of a selection of
+// scopes of the design to a waveform file during simulation, optionally only
+// within a window of clock cycles.
+//
+//===----------------------------------------------------------------------===//
+
+#include "PassDetail.h"
+#include "circt/Dialect/HW/HWInstanceGraph.h"
+#include "circt/Dialect/HW/HWOps.h"
+#include "circt/Dialect/SV/SVPasses.h"
+#include "mlir/IR/Builders.h"
+#include "llvm/Support/GlobPattern.h"
+
+using namespace circt;
+using namespace sv;
+using namespace hw;
+
+//===----------------------------------------------------------------------===//
+// SVTraceSignalsPass
+//===----------------------------------------------------------------------===//
+
+namespace {
+
+struct SVTraceSignalsPass : public sv::SVTraceSignalsBase<SVTraceSignalsPass> {
+  void runOnOperation() override;
+
+private:
+  bool isSelected(Operation *op, StringRef path);
+  void collectScopes(HWModuleOp module, std::string &path);
+
+  /// The attribute marking instances and modules to be traced.
+  static constexpr StringLiteral traceAttrName = "sv.trace";
+
+  SymbolTable *symbolTable;
+  SmallVector<llvm::GlobPattern> patterns;
+  /// The hierarchical names of the scopes to dump, in the order they are
+  /// encountered in the design.
+  SmallVector<std::string> scopes;
+};
+
+} // end anonymous namespace
+
+/// Check whether the scope of an instance or of the top module is selected,
+/// either through an attribute on it or on its module, or through a pattern
+/// matching its hierarchical name.
+bool SVTraceSignalsPass::isSelected(Operation *op, StringRef path) {
+  if (op->hasAttr(traceAttrName))
+    return true;
+  if (auto inst = dyn_cast<InstanceOp>(op))
+    if (auto *module = symbolTable->lookup(inst.getModuleNameAttr().getAttr());
+        module && module->hasAttr(traceAttrName))
+      return true;
+  return llvm::any_of(patterns, [&](const llvm::GlobPattern &pattern) {
+    return pattern.match(path);
+  });
+}
+
+/// Collect the selected scopes below the instances of a module, where `path`
+/// is the hierarchical name of the module's scope.
+void SVTraceSignalsPass::collectScopes(HWModuleOp module, std::string &path) {
+  for (auto inst : module.getOps<InstanceOp>()) {
+    // Only module ops have scopes to dump; the internals of extern and
+    // generated modules are opaque.
+    auto child = dyn_cast_or_null<HWModuleOp>(
+        symbolTable->lookup(inst.getModuleNameAttr().getAttr()));
+    if (!child)
+      continue;
+
+    size_t size = path.size();
+    path += ".";
+    path += inst.getInstanceName();
+    bool selected = isSelected(inst, path);
+    if (selected)
+      scopes.push_back(path);
+    // Dumping all levels of a scope already includes the scopes below it.
+    if (!selected || levels != 0)
+      collectScopes(child, path);
+    path.resize(size);
+  }
+}
+
+void SVTraceSignalsPass::runOnOperation() {
+  mlir::ModuleOp mod = getOperation();
+  scopes.clear();
+  patterns.clear();
+
+  if (format != "vcd" && format != "fsdb") {
+    mod.emitError("unknown trace format \"") << format << "\"";
+    return signalPassFailure();
+  }
+  for (auto &select : selectPatterns) {
+    auto pattern = llvm::GlobPattern::create(select);
+    if (!pattern) {
+      mod.emitError("invalid trace selection pattern \"")
+          << select << "\": " << llvm::toString(pattern.takeError());
+      return signalPassFailure();
+    }
+    patterns.push_back(std::move(*pattern));
+  }
+
+  // Find the top module, which holds the instrumentation.
+  HWModuleOp top;
+  if (targetModuleName.empty()) {
+    auto graph = InstanceGraph(mod);
+    auto topLevelNodes = graph.getInferredTopLevelNodes();
+    if (failed(topLevelNodes) || topLevelNodes->size() != 1) {
+      mod.emitError("Expected exactly one top level node");
+      return signalPassFailure();
+    }
+    top = dyn_cast_or_null<HWModuleOp>(*topLevelNodes->front()->getModule());
+  } else {
+    top = mod.lookupSymbol<HWModuleOp>(targetModuleName);
+  }
+  if (!top) {
+    mod.emitError("top module is not a HWModuleOp");
+    return signalPassFailure();
+  }
+
+  // Collect the scopes to dump. The whole design is dumped when nothing is
+  // selected.
+  SymbolTable symbols(mod);
+  symbolTable = &symbols;
+  std::string path = top.getName().str();
+  if (isSelected(top, path))
+    scopes.push_back(path);
+  if (scopes.empty() || levels != 0)
+    collectScopes(top, path);
+  if (scopes.empty() && patterns.empty())
+    scopes.push_back(path);
+  if (scopes.empty()) {
+    top.emitWarning("no scopes selected for tracing");
+    return markAllAnalysesPreserved();
+  }
+  numScopes += scopes.size();
+
+  // Find the clock counting the cycles of the dump window.
+  Value clockValue;
+  if (!clock.empty()) {
+    auto names = top.getArgNames();
+    auto it = llvm::find_if(names, [&](Attribute name) {
+      return name.cast<StringAttr>().getValue() == clock;
+    });
+    if (it != names.end())
+      clockValue = top.getBodyBlock()->getArgument(it - names.begin());
+    if (!clockValue || !clockValue.getType().isInteger(1)) {
+      top.emitError("no clock port \"") << clock << "\" to trace by";
+      return signalPassFailure();
+    }
+  }
+
+  bool fsdb = format == "fsdb";
+  StringRef dumpFileTask = fsdb ? "$fsdbDumpfile" : "$dumpfile";
+  StringRef dumpVars = fsdb ? "$fsdbDumpvars" : "$dumpvars";
+  StringRef dumpOn = fsdb ? "$fsdbDumpon" : "$dumpon";
+  StringRef dumpOff = fsdb ? "$fsdbDumpoff" : "$dumpoff";
+  std::string dumpFile = fileName;
+  if (dumpFile.empty())
+    dumpFile = (top.getName() + (fsdb ? ".fsdb" : ".vcd")).str();
+
+  std::string trace;
+  llvm::raw_string_ostream ss(trace);
+  ss << "initial begin\n";
+  ss << "  " << dumpFileTask << " (\"" << dumpFile << "\");\n";
+  for (auto &scope : scopes)
+    ss << "  " << dumpVars << " (" << levels << ", " << scope << ");\n";
+  bool window = clockValue && (startCycle != 0 || numCycles != 0);
+  if (window && startCycle != 0)
+    ss << "  " << dumpOff << ";\n";
+  ss << "end\n";
+
+  // Count the cycles of the clock, and only dump within the window.
+  SmallVector<Value> operands;
+  if (window) {
+    operands.push_back(clockValue);
+    ss << "reg [63:0] _trace_cycle = 64'd0;\n"
+       << "always @(posedge {{0}}) begin\n"
+       << "  _trace_cycle <= _trace_cycle + 64'd1;\n";
+    if (startCycle != 0)
+      ss << "  if (_trace_cycle == 64'd" << startCycle << ") " << dumpOn
+         << ";\n";
+    if (numCycles != 0)
+      ss << "  if (_trace_cycle == 64'd" << uint64_t(startCycle) + numCycles
+         << ") " << dumpOff << ";\n";
+    ss << "end\n";
+  }
+
+  OpBuilder builder(top.getBodyBlock(), top.getBodyBlock()->begin());
+  builder.create<sv::VerbatimOp>(top.getLoc(), ss.str(), operands,
+                                 builder.getArrayAttr({}));
+}
+
+std::unique_ptr<Pass> circt::sv::createSVTraceSignalsPass() {
+  return std::make_unique<SVTraceSignalsPass>();
+}
@@ -12,22 +12,34 @@
 //===----------------------------------------------------------------------===//
 
 #include "PassDetails.h"
+#include "circt/Dialect/Comb/CombOps.h"
 #include "circt/Dialect/SV/SVOps.h"
 #include "circt/Dialect/Seq/SeqOps.h"
 #include "circt/Dialect/Seq/SeqPasses.h"
 #include "mlir/Transforms/DialectConversion.h"
 #include "llvm/ADT/TypeSwitch.h"
+#include "llvm/Support/MathExtras.h"
 
 using namespace circt;
 using namespace seq;
 
 namespace {
 
+/// The name of the attribute on a seq.hlmem which requests the memory to be
+/// split into the given number of banks.
+static constexpr const char *numBanksAttrName = "seq.num_banks";
+
 struct SimpleBehavioralMemoryLowering
     : public OpConversionPattern<seq::HLMemOp> {
   // A simple behavioral SV implementation of a HLMemOp. This is intended as a
   // fall-back pattern if any other higher benefit/target-specific patterns
   // failed to match.
+  //
+  // If the memory carries a `seq.num_banks` attribute, the memory is split
+  // into that many banks, interleaved on the low bits of the address.  Each
+  // bank is a separate array with its own write logic, and reads select the
+  // bank after reading all of them.  Writes to the same bank in the same cycle
+  // are resolved like in the unbanked memory: the last write port wins.
 public:
   using OpConversionPattern::OpConversionPattern;
 
@@ -42,6 +54,16 @@ public:
           mem, "only unidimensional memories are supported");
     auto size = memType.getShape()[0];
 
+    // Determine the number of banks.
+    uint64_t numBanks = 1;
+    if (auto banksAttr = mem->getAttrOfType<IntegerAttr>(numBanksAttrName)) {
+      numBanks = banksAttr.getValue().getZExtValue();
+      if (!llvm::isPowerOf2_64(numBanks) || size % numBanks != 0)
+        return rewriter.notifyMatchFailure(
+            mem, "number of banks must be a power of two dividing the size");
+    }
+    unsigned bankSelWidth = llvm::Log2_64(numBanks);
+
     // Gather up the referencing ops.
     llvm::SmallVector<seq::ReadPortOp> readOps;
     llvm::SmallVector<seq::WritePortOp> writeOps;
@@ -64,12 +86,39 @@ public:
     auto rst = mem.getRst();
     auto memName = mem.getName();
 
-    // Create the SV memory.
-    hw::UnpackedArrayType memArrType =
-        hw::UnpackedArrayType::get(memType.getElementType(), size);
-    auto svMem =
-        rewriter.create<sv::RegOp>(mem.getLoc(), memArrType, mem.getNameAttr())
-            .getResult();
+    // Create the SV memory, or one for each bank.
+    SmallVector<Value> svMems;
+    if (numBanks == 1) {
+      hw::UnpackedArrayType memArrType =
+          hw::UnpackedArrayType::get(memType.getElementType(), size);
+      svMems.push_back(rewriter
+                           .create<sv::RegOp>(mem.getLoc(), memArrType,
+                                              mem.getNameAttr())
+                           .getResult());
+    } else {
+      hw::UnpackedArrayType bankArrType =
+          hw::UnpackedArrayType::get(memType.getElementType(), size / numBanks);
+      for (uint64_t bank = 0; bank < numBanks; ++bank)
+        svMems.push_back(rewriter
+                             .create<sv::RegOp>(
+                                 mem.getLoc(), bankArrType,
+                                 rewriter.getStringAttr(
+                                     memName + "_bank" + std::to_string(bank)))
+                             .getResult());
+    }
+
+    // Split an address into the index within a bank and the bank number.
+    auto splitAddress = [&](Location loc,
+                            Value address) -> std::pair<Value, Value> {
+      if (numBanks == 1)
+        return {address, {}};
+      unsigned width = address.getType().getIntOrFloatBitWidth();
+      Value bank =
+          rewriter.create<comb::ExtractOp>(loc, address, 0, bankSelWidth);
+      Value index = rewriter.create<comb::ExtractOp>(
+          loc, address, bankSelWidth, width - bankSelWidth);
+      return {index, bank};
+    };
 
     // Create write ports by gathering up the write port inputs and
     // materializing the writes inside a single always ff block.
@@ -77,32 +126,48 @@ public:
       Location loc;
       Value addr;
       Value data;
-      Value en;
+      // The write enable of each bank.
+      SmallVector<Value> bankEns;
     };
     llvm::SmallVector<WriteTuple> writeTuples;
     for (auto writeOp : writeOps) {
       if (writeOp.getLatency() != 1)
         return rewriter.notifyMatchFailure(
             writeOp, "only supports write ports with latency == 1");
-      auto addr = writeOp.getAddresses()[0];
+      auto [addr, bank] =
+          splitAddress(writeOp.getLoc(), writeOp.getAddresses()[0]);
       auto data = writeOp.getInData();
       auto en = writeOp.getWrEn();
-      writeTuples.push_back({writeOp.getLoc(), addr, data, en});
+      // Only write to the bank the address falls into.
+      SmallVector<Value> bankEns;
+      if (!bank)
+        bankEns.push_back(en);
+      for (uint64_t bankIdx = 0; bank && bankIdx < numBanks; ++bankIdx) {
+        auto loc = writeOp.getLoc();
+        auto bankIdxValue =
+            rewriter.create<hw::ConstantOp>(loc, APInt(bankSelWidth, bankIdx));
+        auto isBank = rewriter.create<comb::ICmpOp>(
+            loc, comb::ICmpPredicate::eq, bank, bankIdxValue);
+        bankEns.push_back(rewriter.create<comb::AndOp>(loc, en, isBank));
+      }
+      writeTuples.push_back({writeOp.getLoc(), addr, data, bankEns});
       rewriter.eraseOp(writeOp);
     }
 
     rewriter.create<sv::AlwaysFFOp>(
         mem.getLoc(), sv::EventControl::AtPosEdge, clk, ResetType::SyncReset,
         sv::EventControl::AtPosEdge, rst, [&] {
-          for (auto [loc, address, data, en] : writeTuples) {
+          for (auto &[loc, address, data, bankEns] : writeTuples) {
             Value a = address, d = data; // So the lambda can capture.
             Location l = loc;
             // Perform write upon write enable being high.
-            rewriter.create<sv::IfOp>(loc, en, [&] {
-              Value memLoc =
-                  rewriter.create<sv::ArrayIndexInOutOp>(l, svMem, a);
-              rewriter.create<sv::PAssignOp>(l, memLoc, d);
-            });
+            for (auto [svMem, en] : llvm::zip(svMems, bankEns)) {
+              Value m = svMem;
+              rewriter.create<sv::IfOp>(loc, en, [&] {
+                Value memLoc = rewriter.create<sv::ArrayIndexInOutOp>(l, m, a);
+                rewriter.create<sv::PAssignOp>(l, memLoc, d);
+              });
+            }
           }
         });
 
@@ -129,10 +194,22 @@ public:
         }
       }
 
-      // Create a combinational read.
-      Value memLoc =
-          rewriter.create<sv::ArrayIndexInOutOp>(loc, svMem, readAddress);
-      Value readData = rewriter.create<sv::ReadInOutOp>(loc, memLoc);
+      // Create a combinational read of each bank, and select the one the
+      // address falls into.
+      auto [index, bank] = splitAddress(loc, readAddress);
+      SmallVector<Value> bankData;
+      for (auto svMem : svMems) {
+        Value memLoc =
+            rewriter.create<sv::ArrayIndexInOutOp>(loc, svMem, index);
+        bankData.push_back(rewriter.create<sv::ReadInOutOp>(loc, memLoc));
+      }
+      Value readData = bankData[0];
+      if (bank) {
+        // The first operand of an array_create is the last array element.
+        std::reverse(bankData.begin(), bankData.end());
+        auto banks = rewriter.create<hw::ArrayCreateOp>(loc, bankData);
+        readData = rewriter.create<hw::ArrayGetOp>(loc, banks, bank);
+      }
       if (latency > 0) {
         // Register the read data.
         readData = rewriter.create<seq::CompRegOp>(
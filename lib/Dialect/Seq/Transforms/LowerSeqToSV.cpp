@@ -161,7 +161,8 @@ private:
 
   RegLowerInfo lower(FirRegOp reg);
 
-  void initialize(OpBuilder &builder, RegLowerInfo reg, ArrayRef<Value> rands);
+  void initialize(OpBuilder &builder, RegLowerInfo reg, ArrayRef<Value> rands,
+                  MutableArrayRef<Value> randReads);
   void initializeRegisterElements(Location loc, OpBuilder &builder, Value reg,
                                   Value rand, unsigned &pos);
 
@@ -332,9 +333,11 @@ void FirRegLower::lower() {
               randValues.push_back(lhs.getResult());
             }
 
-            // Create initialisers for all registers.
+            // Create initialisers for all registers.  The reads of the random
+            // words are shared by all registers initialized from them.
+            SmallVector<Value> randReads(numRandomCalls);
             for (auto &svReg : toInit)
-              initialize(builder, svReg, randValues);
+              initialize(builder, svReg, randValues, randReads);
           });
         }
 
@@ -644,7 +647,8 @@ void FirRegLower::initializeRegisterElements(Location loc, OpBuilder &builder,
 }
 
 void FirRegLower::initialize(OpBuilder &builder, RegLowerInfo reg,
-                             ArrayRef<Value> rands) {
+                             ArrayRef<Value> rands,
+                             MutableArrayRef<Value> randReads) {
   auto loc = reg.reg.getLoc();
   SmallVector<Value> nibbles;
   if (reg.width == 0)
@@ -656,7 +660,9 @@ void FirRegLower::initialize(OpBuilder &builder, RegLowerInfo reg,
     auto index = offset / 32;
     auto start = offset % 32;
     auto nwidth = std::min(32 - start, width);
-    auto elemVal = builder.create<sv::ReadInOutOp>(loc, rands[index]);
+    auto &elemVal = randReads[index];
+    if (!elemVal)
+      elemVal = builder.create<sv::ReadInOutOp>(loc, rands[index]);
     auto elem =
         builder.createOrFold<comb::ExtractOp>(loc, elemVal, start, nwidth);
     nibbles.push_back(elem);
@@ -10,6 +10,7 @@
 #include "circt/Conversion/Passes.h"
 #include "circt/Dialect/FIRRTL/FIRRTLOps.h"
 #include "circt/Dialect/FIRRTL/Passes.h"
+#include "circt/Dialect/HW/HWPasses.h"
 #include "circt/Dialect/SV/SVPasses.h"
 #include "circt/Dialect/Seq/SeqPasses.h"
 #include "circt/Support/Passes.h"
@@ -56,14 +57,16 @@ LogicalResult firtool::populateCHIRRTLToLowFIRRTL(mlir::PassManager &pm,
       pm.nest<firrtl::CircuitOp>().addPass(createExportChiselInterfacePass());
     } else {
       pm.nest<firrtl::CircuitOp>().addPass(createExportSplitChiselInterfacePass(
-          opt.chiselInterfaceOutDirectory));
+          opt.chiselInterfaceOutDirectory,
+          opt.chiselInterfaceOnlyWriteChanged));
     }
   }
 
   pm.nest<firrtl::CircuitOp>().nestAny().addPass(firrtl::createDropConstPass());
 
   if (opt.dedup)
-    pm.nest<firrtl::CircuitOp>().addPass(firrtl::createDedupPass());
+    pm.nest<firrtl::CircuitOp>().addPass(
+        firrtl::createDedupPass(opt.fastDedupHash));
 
   pm.nest<firrtl::CircuitOp>().addPass(firrtl::createWireDFTPass());
 
@@ -80,7 +83,8 @@ LogicalResult firtool::populateCHIRRTLToLowFIRRTL(mlir::PassManager &pm,
   // The input mlir file could be firrtl dialect so we might need to clean
   // things up.
   pm.addNestedPass<firrtl::CircuitOp>(firrtl::createLowerFIRRTLTypesPass(
-      opt.preserveAggregate, firrtl::PreserveAggregate::None));
+      opt.preserveAggregate, firrtl::PreserveAggregate::None,
+      opt.preserveUniformVectors));
   // Only enable expand whens if lower types is also enabled.
   auto &modulePM = pm.nest<firrtl::CircuitOp>().nest<firrtl::FModuleOp>();
   modulePM.addPass(firrtl::createExpandWhensPass());
@@ -97,7 +101,8 @@ LogicalResult firtool::populateCHIRRTLToLowFIRRTL(mlir::PassManager &pm,
         firrtl::createRandomizeRegisterInitPass());
 
   if (opt.useOldCheckCombCycles) {
-    if (opt.preserveAggregate == firrtl::PreserveAggregate::None)
+    if (opt.preserveAggregate == firrtl::PreserveAggregate::None &&
+        !opt.preserveUniformVectors)
       pm.nest<firrtl::CircuitOp>().addPass(firrtl::createCheckCombCyclesPass());
     else
       emitWarning(module.getLoc())
@@ -109,7 +114,8 @@ LogicalResult firtool::populateCHIRRTLToLowFIRRTL(mlir::PassManager &pm,
   // If we parsed a FIRRTL file and have optimizations enabled, clean it up.
   if (!opt.disableOptimization)
     pm.nest<firrtl::CircuitOp>().nest<firrtl::FModuleOp>().addPass(
-        createSimpleCanonicalizerPass());
+        opt.simplifyFIRRTL ? firrtl::createSimplifyPass()
+                           : createSimpleCanonicalizerPass());
 
   // Run the infer-rw pass, which merges read and write ports of a memory with
   // mutually exclusive enables.
@@ -158,7 +164,8 @@ LogicalResult firtool::populateCHIRRTLToLowFIRRTL(mlir::PassManager &pm,
   // proceed to output-specific pipelines.
   if (!opt.disableOptimization) {
     pm.nest<firrtl::CircuitOp>().nest<firrtl::FModuleOp>().addPass(
-        createSimpleCanonicalizerPass());
+        opt.simplifyFIRRTL ? firrtl::createSimplifyPass()
+                           : createSimpleCanonicalizerPass());
     pm.nest<firrtl::CircuitOp>().nest<firrtl::FModuleOp>().addPass(
         circt::firrtl::createRegisterOptimizerPass());
     pm.addPass(firrtl::createIMDeadCodeElimPass());
@@ -203,8 +210,12 @@ LogicalResult firtool::populateLowFIRRTLToHW(mlir::PassManager &pm,
 
   if (!opt.disableOptimization) {
     auto &modulePM = pm.nest<hw::HWModuleOp>();
-    modulePM.addPass(mlir::createCSEPass());
-    modulePM.addPass(createSimpleCanonicalizerPass());
+    if (opt.simplifyCombAfterLowering) {
+      modulePM.addPass(hw::createSimplifyCombPass());
+    } else {
+      modulePM.addPass(mlir::createCSEPass());
+      modulePM.addPass(createSimpleCanonicalizerPass());
+    }
   }
 
   return success();
@@ -27,6 +27,17 @@ void Solver::Circuit::addInput(Value value) {
   LLVM_DEBUG(lec::dbgs() << name << " addInput\n");
   lec::Scope indent;
   z3::expr input = allocateValue(value);
+  // The inputs of an instance are its arguments, those of the top-level
+  // circuits are identified by position since they are constrained to be
+  // equal.
+  if (!inputIds.empty())
+    structuralIds[value] = inputIds[inputs.size()];
+  else
+    hashValue(value, input,
+              ("input " + Twine(inputs.size()) + " : " +
+               std::to_string(input.get_sort().bv_size()) +
+               (cycle ? " @ cycle " + std::to_string(cycle) : ""))
+                  .str());
   inputs.insert(inputs.end(), input);
 }
 
@@ -36,6 +47,7 @@ void Solver::Circuit::addOutput(Value value) {
   // Referenced value already assigned, fetching from expression table.
   z3::expr output = fetchExpr(value);
   outputs.insert(outputs.end(), output);
+  outputIds.push_back(structuralIds.lookup(value));
 }
 
 /// Recover the inputs.
@@ -65,6 +77,8 @@ void Solver::Circuit::addInstance(llvm::StringRef instanceName,
   // As an hack, a suffix is used to differentiate them.
   std::string suffix = "_" + std::to_string(assignments);
   Circuit instance(name + "@" + instanceName + suffix, solver);
+  for (Value argument : arguments)
+    instance.inputIds.push_back(structuralIds.lookup(argument));
   // Export logic to the instance's circuit by visiting the IR of the
   // instanced module.
   auto res = LogicExporter(op.getModuleName(), &instance).run(op);
@@ -86,11 +100,51 @@ void Solver::Circuit::addInstance(llvm::StringRef instanceName,
     LLVM_DEBUG(lec::dbgs() << "instance results:\n");
     lec::Scope indent;
     auto *output = instance.outputs.begin();
+    const auto *outputId = instance.outputIds.begin();
     for (circt::OpResult result : results) {
       z3::expr resultExpr = allocateValue(result);
       solver.solver.add(resultExpr == *output++);
+      structuralIds[result] = *outputId++;
     }
   }
+
+  // The registers of the instance belong to the circuit as well.
+  for (Register &reg : instance.registers)
+    registers.push_back({(instanceName + "/" + reg.name).str(), reg.state,
+                         reg.next, reg.resetValue});
+}
+
+//===----------------------------------------------------------------------===//
+// `seq` dialect operations
+//===----------------------------------------------------------------------===//
+
+void Solver::Circuit::addRegister(Value state, llvm::StringRef regName) {
+  LLVM_DEBUG(lec::dbgs() << name << " addRegister\n");
+  lec::Scope indent;
+  LLVM_DEBUG(lec::dbgs() << "register name: " << regName << "\n");
+  z3::expr expr = allocateValue(state);
+  // The current state is only known to be equal to that of another register
+  // when the solver constrains it to be.
+  hashValue(state, expr, "register " + expr.to_string());
+  registerIndices[state] = registers.size();
+  registers.push_back({regName.str(), expr, expr, std::nullopt});
+}
+
+void Solver::Circuit::setNextState(Value state, Value input, Value reset,
+                                   Value resetValue) {
+  LLVM_DEBUG(lec::dbgs() << name << " setNextState\n");
+  lec::Scope indent;
+  Register &reg = registers[registerIndices.lookup(state)];
+  LLVM_DEBUG(lec::dbgs() << "input:\n");
+  reg.next = fetchExpr(input);
+  if (reset) {
+    LLVM_DEBUG(lec::dbgs() << "reset:\n");
+    z3::expr resetExpr = fetchExpr(reset);
+    LLVM_DEBUG(lec::dbgs() << "reset value:\n");
+    z3::expr resetValueExpr = fetchExpr(resetValue);
+    reg.next = z3::ite(bvToBool(resetExpr), resetValueExpr, reg.next);
+    reg.resetValue = resetValueExpr;
+  }
 }
 
 //===----------------------------------------------------------------------===//
@@ -410,6 +464,9 @@ void Solver::Circuit::allocateConstant(Value result, const APInt &value) {
       solver.context.bv_val(value.getZExtValue(), value.getBitWidth());
   auto insertion = exprTable.insert(std::pair(result, constant));
   assert(insertion.second && "Constant not inserted in expression table");
+  hashValue(result, constant,
+            "hw.constant " + llvm::toString(value, 16, false) + " : " +
+                std::to_string(value.getBitWidth()));
   LLVM_DEBUG(lec::printExpr(constant));
   LLVM_DEBUG(lec::printValue(result));
 }
@@ -441,6 +498,46 @@ void Solver::Circuit::constrainResult(Value &result, z3::expr &expr) {
     LLVM_DEBUG(lec::dbgs() << constraint.to_string() << "\n");
   }
   solver.solver.add(constraint);
+
+  // Hash the operation along with the structural ids of its operands.
+  Operation *op = result.getDefiningOp();
+  std::string key;
+  llvm::raw_string_ostream os(key);
+  os << op->getName();
+  for (NamedAttribute attr : op->getAttrs()) {
+    // Skip the discardable attributes, which don't affect the function.
+    if (attr.getName().getValue().contains('.'))
+      continue;
+    os << ' ' << attr.getName().getValue() << " = " << attr.getValue();
+  }
+  SmallVector<unsigned> operandIds;
+  for (Value operand : op->getOperands()) {
+    assert(structuralIds.count(operand) && "Operand not hashed");
+    operandIds.push_back(structuralIds.lookup(operand));
+  }
+  if (op->hasTrait<OpTrait::IsCommutative>())
+    llvm::sort(operandIds);
+  os << '(';
+  llvm::interleaveComma(operandIds, os);
+  os << ") : " << result.getType();
+  hashValue(result, resExpr, os.str());
+}
+
+/// Records the structural id of `key` for a value represented by `expr`.
+/// When another value already has the same id, the two are constrained to be
+/// equal as they compute the same function.
+void Solver::Circuit::hashValue(Value value, const z3::expr &expr,
+                                llvm::StringRef key) {
+  auto insertion =
+      solver.structuralTable.try_emplace(key, solver.representatives.size());
+  unsigned id = insertion.first->second;
+  if (insertion.second) {
+    solver.representatives.push_back(expr);
+  } else {
+    LLVM_DEBUG(lec::dbgs() << "structurally equal to value #" << id << "\n");
+    solver.solver.add(expr == solver.representatives[id]);
+  }
+  structuralIds[value] = id;
 }
 
 /// Convert from bitvector to bool sort.
@@ -11,6 +11,9 @@
 //===----------------------------------------------------------------------===//
 
 #include "circt/LogicalEquivalence/LogicExporter.h"
+#include "circt/Dialect/LTL/LTLDialect.h"
+#include "circt/Dialect/Seq/SeqOps.h"
+#include "circt/Dialect/Verif/VerifDialect.h"
 #include "circt/LogicalEquivalence/Circuit.h"
 #include "circt/LogicalEquivalence/Solver.h"
 #include "circt/LogicalEquivalence/Utility.h"
@@ -21,6 +24,15 @@
 using namespace circt;
 using namespace mlir;
 
+static std::optional<StringRef> getRegisterSymbol(seq::CompRegOp op) {
+  return op.getSymName();
+}
+static std::optional<StringRef> getRegisterSymbol(seq::FirRegOp op) {
+  return op.getInnerSym();
+}
+static Value getRegisterInput(seq::CompRegOp op) { return op.getInput(); }
+static Value getRegisterInput(seq::FirRegOp op) { return op.getNext(); }
+
 namespace {
 
 /// This class provides logic-exporting functions for the implemented
@@ -39,35 +51,125 @@ struct Visitor : public hw::StmtVisitor<Visitor, LogicalResult>,
   Solver::Circuit *circuit;
 
   /// Handles `builtin.module` logic exporting.
-  LogicalResult visit(ModuleOp op, llvm::StringRef targetModule) {
-    for (auto hwModule : op.getOps<hw::HWModuleOp>()) {
-      if (targetModule.empty() || hwModule.getName() == targetModule) {
-        LLVM_DEBUG(llvm::dbgs()
-                   << "Using module `" << hwModule.getName() << "`\n");
-        return visit(hwModule);
-      }
-    }
-    op.emitError("module not found");
-    return failure();
+  LogicalResult visit(ModuleOp op, llvm::StringRef targetModule,
+                      std::optional<unsigned> coneOutput) {
+    hw::HWModuleOp hwModule = LogicExporter::lookupModule(op, targetModule);
+    if (!hwModule)
+      return failure();
+    circuit->setTopModule(hwModule, coneOutput);
+    if (coneOutput)
+      return visitCone(hwModule, *coneOutput);
+    return visit(hwModule);
   }
 
   /// Handles `hw.module` logic exporting.
   LogicalResult visit(hw::HWModuleOp op) {
     for (auto argument : op.getArguments())
       circuit->addInput(argument);
+    SmallVector<Operation *> registers;
+    for (auto &op : op.getOps())
+      if (isa<seq::CompRegOp, seq::FirRegOp>(op))
+        registers.push_back(&op);
+    if (failed(addRegisters(registers)))
+      return failure();
     for (auto &op : op.getOps())
       if (failed(dispatch(&op)))
         return failure();
+    setNextStates(registers);
+    return success();
+  }
+
+  /// Handles `hw.module` logic exporting of a single output and its fan-in
+  /// cone.
+  LogicalResult visitCone(hw::HWModuleOp op, unsigned output) {
+    auto outputOp = cast<hw::OutputOp>(op.getBodyBlock()->getTerminator());
+    if (output >= outputOp.getNumOperands()) {
+      op.emitError("output #") << output + 1 << " not found";
+      return failure();
+    }
+    Value outputValue = outputOp.getOperand(output);
+
+    // Collect the operations the output depends on.
+    DenseSet<Operation *> cone;
+    SmallVector<Value> worklist = {outputValue};
+    while (!worklist.empty()) {
+      Operation *defOp = worklist.pop_back_val().getDefiningOp();
+      if (!defOp || !cone.insert(defOp).second)
+        continue;
+      worklist.append(defOp->operand_begin(), defOp->operand_end());
+    }
+    LLVM_DEBUG(lec::dbgs() << "cone of output #" << output + 1 << ": "
+                           << cone.size() << " operations\n");
+
+    for (auto argument : op.getArguments())
+      circuit->addInput(argument);
+    SmallVector<Operation *> registers;
+    for (auto &op : op.getOps())
+      if (cone.contains(&op) && isa<seq::CompRegOp, seq::FirRegOp>(op))
+        registers.push_back(&op);
+    if (failed(addRegisters(registers)))
+      return failure();
+    for (auto &op : op.getOps())
+      if (cone.contains(&op) && failed(dispatch(&op)))
+        return failure();
+    setNextStates(registers);
+    circuit->addOutput(outputValue);
     return success();
   }
 
+  /// Adds the registers of a module before any of its logic, since their
+  /// states may be used before the registers in a graph region.
+  LogicalResult addRegisters(ArrayRef<Operation *> registers) {
+    for (Operation *op : registers) {
+      auto result = TypeSwitch<Operation *, LogicalResult>(op)
+                        .Case<seq::CompRegOp, seq::FirRegOp>(
+                            [&](auto reg) { return addRegister(reg); });
+      if (failed(result))
+        return failure();
+    }
+    return success();
+  }
+
+  /// Adds a register, matched to its counterpart by name, or by inner symbol
+  /// if unnamed.
+  template <typename OpTy>
+  LogicalResult addRegister(OpTy reg) {
+    if (!reg.getType().isSignlessInteger())
+      return reg.emitOpError("of non-integer type unsupported");
+    StringRef regName = reg.getName();
+    if (regName.empty())
+      regName = getRegisterSymbol(reg).value_or("");
+    circuit->addRegister(reg.getResult(), regName);
+    return success();
+  }
+
+  /// Sets the next states of the registers, once the logic they depend on has
+  /// been exported. An asynchronous reset is treated like a synchronous one.
+  void setNextStates(ArrayRef<Operation *> registers) {
+    for (Operation *op : registers)
+      TypeSwitch<Operation *>(op).Case<seq::CompRegOp, seq::FirRegOp>(
+          [&](auto reg) {
+            circuit->setNextState(reg.getResult(), getRegisterInput(reg),
+                                  reg.getReset(), reg.getResetValue());
+          });
+  }
+
   LogicalResult visitUnhandledOp(Operation *op) {
     op->emitOpError("not supported");
     return failure();
   }
 
   /// Dispatches an operation to the appropriate visit function.
-  LogicalResult dispatch(Operation *op) { return dispatchStmtVisitor(op); }
+  LogicalResult dispatch(Operation *op) {
+    // Registers are handled before and after the rest of the logic.
+    if (isa<seq::CompRegOp, seq::FirRegOp>(op))
+      return success();
+    // Properties don't contribute to the logic; they are checked over the
+    // exported circuits by `Solver::checkProperties`.
+    if (isa<verif::VerifDialect, ltl::LTLDialect>(op->getDialect()))
+      return success();
+    return dispatchStmtVisitor(op);
+  }
 
   //===--------------------------------------------------------------------===//
   // hw::StmtVisitor
@@ -220,9 +322,22 @@ struct Visitor : public hw::StmtVisitor<Visitor, LogicalResult>,
 } // namespace
 
 LogicalResult LogicExporter::run(ModuleOp &builtinModule) {
-  return Visitor(circuit).visit(builtinModule, moduleName);
+  return Visitor(circuit).visit(builtinModule, moduleName, coneOutput);
 }
 
 LogicalResult LogicExporter::run(hw::HWModuleOp &module) {
   return Visitor(circuit).visit(module);
 }
+
+hw::HWModuleOp LogicExporter::lookupModule(ModuleOp module,
+                                           llvm::StringRef moduleName) {
+  for (auto hwModule : module.getOps<hw::HWModuleOp>()) {
+    if (moduleName.empty() || hwModule.getName() == moduleName) {
+      LLVM_DEBUG(llvm::dbgs()
+                 << "Using module `" << hwModule.getName() << "`\n");
+      return hwModule;
+    }
+  }
+  module.emitError("module not found");
+  return {};
+}
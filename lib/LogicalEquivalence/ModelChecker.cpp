@@ -0,0 +1,404 @@
+//===-- ModelChecker.cpp - Bounded model checking of properties -*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// This file implements the bounded model checking of the `verif` properties
+/// of a circuit, which is unrolled one cycle at a time by the solver.
+///
+//===----------------------------------------------------------------------===//
+
+#include "circt/Dialect/HW/HWOps.h"
+#include "circt/Dialect/LTL/LTLDialect.h"
+#include "circt/Dialect/LTL/LTLOps.h"
+#include "circt/Dialect/LTL/LTLTypes.h"
+#include "circt/Dialect/Verif/VerifOps.h"
+#include "circt/LogicalEquivalence/Circuit.h"
+#include "circt/LogicalEquivalence/Solver.h"
+#include "circt/LogicalEquivalence/Utility.h"
+#include "mlir/IR/SymbolTable.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/TypeSwitch.h"
+#include <z3++.h>
+
+#define DEBUG_TYPE "lec-model-checker"
+
+using namespace circt;
+using namespace mlir;
+
+namespace {
+/// A match of a sequence, which ends `offset` cycles after the cycle it
+/// started in if `condition` holds.
+struct SequenceMatch {
+  unsigned offset;
+  z3::expr condition;
+};
+
+/// A `verif` operation of the checked module.
+struct Property {
+  Operation *op;
+  /// The number of cycles after the cycle it starts in which the property
+  /// depends on.
+  unsigned lookahead;
+  /// Whether a cover was found to be reachable.
+  bool covered = false;
+};
+
+/// Encodes the properties starting in a given cycle over the circuits of the
+/// cycles exported so far.
+class PropertyEncoder {
+public:
+  PropertyEncoder(z3::context &context,
+                  const SmallVectorImpl<Solver::Circuit *> &cycles)
+      : context(context), cycles(cycles) {}
+
+  z3::expr encodeProperty(Value value, unsigned cycle);
+  SmallVector<SequenceMatch> encodeSequence(Value value, unsigned cycle);
+
+private:
+  z3::expr encodeBool(Value value, unsigned cycle);
+
+  z3::context &context;
+  const SmallVectorImpl<Solver::Circuit *> &cycles;
+};
+} // namespace
+
+/// Check whether a value is a boolean of the circuit logic, as opposed to the
+/// `ltl` operations which also combine booleans.
+static bool isBoolean(Value value) {
+  if (!value.getType().isInteger(1))
+    return false;
+  Operation *op = value.getDefiningOp();
+  return !op || !isa<ltl::LTLDialect>(op->getDialect());
+}
+
+/// Compute the number of cycles a property or sequence looks ahead of the
+/// cycle it starts in. Fails on the constructs which can't be decided within
+/// a bounded number of cycles.
+static FailureOr<unsigned> getLookahead(Value value,
+                                        Solver::Circuit *circuit) {
+  if (isBoolean(value)) {
+    if (!circuit->lookupExpr(value)) {
+      mlir::emitError(value.getLoc(), "condition not supported by the model "
+                                      "checker");
+      return failure();
+    }
+    return 0u;
+  }
+
+  Operation *op = value.getDefiningOp();
+  if (!op) {
+    mlir::emitError(value.getLoc(), "property arguments not supported by the "
+                                    "model checker");
+    return failure();
+  }
+  auto maxLookahead = [&](ValueRange inputs) -> FailureOr<unsigned> {
+    unsigned result = 0;
+    for (auto input : inputs) {
+      auto lookahead = getLookahead(input, circuit);
+      if (failed(lookahead))
+        return failure();
+      result = std::max(result, *lookahead);
+    }
+    return result;
+  };
+  return TypeSwitch<Operation *, FailureOr<unsigned>>(op)
+      .Case<ltl::DelayOp>([&](auto op) -> FailureOr<unsigned> {
+        if (!op.getLength()) {
+          op.emitOpError("with unbounded length not supported by the model "
+                         "checker");
+          return failure();
+        }
+        auto input = getLookahead(op.getInput(), circuit);
+        if (failed(input))
+          return failure();
+        return *input + op.getDelay() + *op.getLength();
+      })
+      .Case<ltl::ConcatOp>([&](auto op) -> FailureOr<unsigned> {
+        unsigned result = 0;
+        for (auto input : op.getInputs()) {
+          auto lookahead = getLookahead(input, circuit);
+          if (failed(lookahead))
+            return failure();
+          result += *lookahead;
+        }
+        return result;
+      })
+      .Case<ltl::AndOp, ltl::OrOp>(
+          [&](auto op) { return maxLookahead(op.getInputs()); })
+      .Case<ltl::NotOp, ltl::ClockOp>(
+          [&](auto op) { return getLookahead(op.getInput(), circuit); })
+      .Case<ltl::DisableOp>([&](auto op) -> FailureOr<unsigned> {
+        if (failed(getLookahead(op.getCondition(), circuit)))
+          return failure();
+        return getLookahead(op.getInput(), circuit);
+      })
+      .Case<ltl::ImplicationOp>([&](auto op) -> FailureOr<unsigned> {
+        auto antecedent = getLookahead(op.getAntecedent(), circuit);
+        if (failed(antecedent))
+          return failure();
+        auto consequent = getLookahead(op.getConsequent(), circuit);
+        if (failed(consequent))
+          return failure();
+        return *antecedent + *consequent;
+      })
+      .Default([](Operation *op) -> FailureOr<unsigned> {
+        op->emitOpError("not supported by the model checker");
+        return failure();
+      });
+}
+
+z3::expr PropertyEncoder::encodeBool(Value value, unsigned cycle) {
+  auto expr = cycles[cycle]->lookupExpr(value);
+  assert(expr && "condition was not exported");
+  return *expr == context.bv_val(1, 1);
+}
+
+SmallVector<SequenceMatch> PropertyEncoder::encodeSequence(Value value,
+                                                           unsigned cycle) {
+  if (isBoolean(value))
+    return {{0, encodeBool(value, cycle)}};
+
+  SmallVector<SequenceMatch> matches;
+  TypeSwitch<Operation *>(value.getDefiningOp())
+      .Case<ltl::DelayOp>([&](auto op) {
+        for (uint64_t extra = 0; extra <= *op.getLength(); ++extra) {
+          unsigned delay = op.getDelay() + extra;
+          for (auto &match : encodeSequence(op.getInput(), cycle + delay))
+            matches.push_back({delay + match.offset, match.condition});
+        }
+      })
+      .Case<ltl::ConcatOp>([&](auto op) {
+        // Each input starts in the cycle the previous one ended in.
+        matches.push_back({0, context.bool_val(true)});
+        for (auto input : op.getInputs()) {
+          SmallVector<SequenceMatch> next;
+          for (auto &prefix : matches)
+            for (auto &match : encodeSequence(input, cycle + prefix.offset))
+              next.push_back({prefix.offset + match.offset,
+                              prefix.condition && match.condition});
+          matches = std::move(next);
+        }
+      })
+      .Case<ltl::OrOp>([&](auto op) {
+        for (auto input : op.getInputs())
+          matches.append(encodeSequence(input, cycle));
+      })
+      .Case<ltl::AndOp>([&](auto op) {
+        // All inputs start together, and the sequence ends with the last one.
+        matches.push_back({0, context.bool_val(true)});
+        for (auto input : op.getInputs()) {
+          SmallVector<SequenceMatch> next;
+          auto inputMatches = encodeSequence(input, cycle);
+          for (auto &prefix : matches)
+            for (auto &match : inputMatches)
+              next.push_back({std::max(prefix.offset, match.offset),
+                              prefix.condition && match.condition});
+          matches = std::move(next);
+        }
+      })
+      .Case<ltl::ClockOp>(
+          [&](auto op) { matches = encodeSequence(op.getInput(), cycle); });
+  return matches;
+}
+
+z3::expr PropertyEncoder::encodeProperty(Value value, unsigned cycle) {
+  // A sequence holds if any of its matches does.
+  if (!value.getType().isa<ltl::PropertyType>()) {
+    z3::expr_vector conditions(context);
+    for (auto &match : encodeSequence(value, cycle))
+      conditions.push_back(match.condition);
+    return z3::mk_or(conditions);
+  }
+
+  auto encodeInputs = [&](ValueRange inputs) {
+    z3::expr_vector exprs(context);
+    for (auto input : inputs)
+      exprs.push_back(encodeProperty(input, cycle));
+    return exprs;
+  };
+  return TypeSwitch<Operation *, z3::expr>(value.getDefiningOp())
+      .Case<ltl::AndOp>(
+          [&](auto op) { return z3::mk_and(encodeInputs(op.getInputs())); })
+      .Case<ltl::OrOp>(
+          [&](auto op) { return z3::mk_or(encodeInputs(op.getInputs())); })
+      .Case<ltl::NotOp>(
+          [&](auto op) { return !encodeProperty(op.getInput(), cycle); })
+      .Case<ltl::ClockOp>(
+          [&](auto op) { return encodeProperty(op.getInput(), cycle); })
+      .Case<ltl::DisableOp>([&](auto op) {
+        // The property is disabled if the condition holds in any of the
+        // cycles it is evaluated over.
+        z3::expr_vector disabled(context);
+        unsigned lookahead = *getLookahead(op.getInput(), cycles.front());
+        for (unsigned i = 0; i <= lookahead; ++i)
+          disabled.push_back(encodeBool(op.getCondition(), cycle + i));
+        return z3::mk_or(disabled) || encodeProperty(op.getInput(), cycle);
+      })
+      .Case<ltl::ImplicationOp>([&](auto op) {
+        // The consequent has to hold from the end of each antecedent match.
+        z3::expr_vector implications(context);
+        for (auto &match : encodeSequence(op.getAntecedent(), cycle))
+          implications.push_back(z3::implies(
+              match.condition,
+              encodeProperty(op.getConsequent(), cycle + match.offset)));
+        return z3::mk_and(implications);
+      })
+      .Default([](Operation *) -> z3::expr {
+        llvm_unreachable("property not supported by the model checker");
+      });
+}
+
+/// Warn about the properties of instantiated modules, which are not checked.
+static void warnInstanceProperties(hw::HWModuleOp module,
+                                   DenseSet<Operation *> &visited) {
+  auto parent = module->getParentOfType<ModuleOp>();
+  for (auto instance : module.getOps<hw::InstanceOp>()) {
+    auto child = dyn_cast_or_null<hw::HWModuleOp>(
+        SymbolTable::lookupSymbolIn(parent, instance.getModuleNameAttr()));
+    if (!child || !visited.insert(child).second)
+      continue;
+    auto ops = child.getOps();
+    if (llvm::any_of(ops, [](Operation &op) {
+          return isa<verif::VerifDialect>(op.getDialect());
+        }))
+      instance.emitWarning("properties of instantiated module `")
+          << child.getName() << "` are not checked";
+    warnInstanceProperties(child, visited);
+  }
+}
+
+/// Check the `verif` properties of the first circuit for `bound` cycles
+/// starting from its reset state, one cycle at a time, then present the
+/// results to the user. Fails when an assertion can be violated.
+LogicalResult Solver::checkProperties() {
+  Circuit *circuit = circuits[0];
+  hw::HWModuleOp module = circuit->getTopModule();
+
+  // Collect the properties of the top-level module, along with the number of
+  // cycles until they can be decided.
+  SmallVector<Property> properties;
+  for (auto &op : module.getOps()) {
+    if (!isa<verif::AssertOp, verif::AssumeOp, verif::CoverOp>(op))
+      continue;
+    auto lookahead = getLookahead(op.getOperand(0), circuit);
+    if (failed(lookahead))
+      return failure();
+    properties.push_back({&op, *lookahead});
+  }
+  DenseSet<Operation *> visited;
+  warnInstanceProperties(module, visited);
+
+  // Registers with a reset start from their reset value, the others from an
+  // arbitrary value.
+  for (const Circuit::Register &reg : circuit->getRegisters())
+    if (reg.resetValue)
+      solver.add(reg.state == *reg.resetValue);
+
+  auto timedCheck = [&]() {
+    auto start = std::chrono::steady_clock::now();
+    z3::check_result result = solver.check();
+    checkTime += std::chrono::steady_clock::now() - start;
+    return result;
+  };
+
+  SmallVector<Circuit *> cycles = {circuit};
+  PropertyEncoder encoder(context, cycles);
+  for (unsigned depth = 0; depth < bound; ++depth) {
+    if (depth > 0) {
+      auto next = unrollCircuit(cycles.back(), "c1@", depth);
+      if (failed(next))
+        return failure();
+      cycles.push_back(*next);
+    }
+    LLVM_DEBUG(lec::dbgs() << "checking depth " << depth << "\n");
+
+    // Only the properties starting early enough to be decided within the
+    // cycles exported so far are encoded. Each of them is encoded once, in
+    // the depth it becomes decidable.
+    SmallVector<std::pair<Property *, z3::expr>> assertions, covers;
+    for (Property &property : properties) {
+      if (property.lookahead > depth || property.covered)
+        continue;
+      unsigned start = depth - property.lookahead;
+      z3::expr expr = encoder.encodeProperty(property.op->getOperand(0), start);
+      if (isa<verif::AssumeOp>(property.op))
+        solver.add(expr);
+      else if (isa<verif::AssertOp>(property.op))
+        assertions.push_back({&property, expr});
+      else
+        covers.push_back({&property, expr});
+    }
+
+    // Look for inputs violating any of the assertions. The constraint is
+    // scoped so that it can be dropped once it is unsatisfiable.
+    if (!assertions.empty()) {
+      z3::expr_vector holds(context);
+      for (auto &assertion : assertions)
+        holds.push_back(assertion.second);
+      solver.push();
+      solver.add(!z3::mk_and(holds));
+      z3::check_result result = timedCheck();
+      if (result == z3::unknown) {
+        lec::errs() << "circt-bmc error: solver ran out of time\n";
+        return failure();
+      }
+      if (result == z3::sat) {
+        z3::model model = solver.get_model();
+        for (auto &[property, expr] : assertions)
+          if (model.eval(expr, true).is_false())
+            property->op->emitError("assertion violated in cycle ")
+                << depth - property->lookahead;
+        printTrace(cycles);
+        if (statisticsOpt)
+          printStatistics();
+        return failure();
+      }
+      solver.pop();
+
+      // The assertions hold, which simplifies the checks of the later cycles.
+      solver.add(z3::mk_and(holds));
+    }
+
+    // Look for inputs reaching each of the remaining covers.
+    for (auto &[property, expr] : covers) {
+      solver.push();
+      solver.add(expr);
+      if (timedCheck() == z3::sat) {
+        property->covered = true;
+        property->op->emitRemark("cover reached in cycle ")
+            << depth - property->lookahead;
+      }
+      solver.pop();
+    }
+  }
+
+  for (Property &property : properties)
+    if (isa<verif::CoverOp>(property.op) && !property.covered)
+      property.op->emitWarning("cover not reached within ")
+          << bound << " cycles";
+  lec::outs() << "no assertion violated within " << bound << " cycles\n";
+  if (statisticsOpt)
+    printStatistics();
+  return success();
+}
+
+/// Prints the values of the inputs of the first circuit in each of the given
+/// cycles of a counterexample.
+void Solver::printTrace(ArrayRef<Circuit *> cycles) {
+  lec::outs() << "Trace:\n";
+  lec::Scope indent;
+  z3::model model = solver.get_model();
+  hw::HWModuleOp module = cycles.front()->getTopModule();
+  for (auto [cycle, circuit] : llvm::enumerate(cycles)) {
+    lec::outs() << "cycle " << cycle << ":";
+    for (auto [name, input] :
+         llvm::zip(module.getArgNames(), circuit->getInputs()))
+      lec::outs() << " " << name.cast<StringAttr>().getValue() << " = "
+                  << model.eval(input, true).get_decimal_string(0);
+    lec::outs() << "\n";
+  }
+}
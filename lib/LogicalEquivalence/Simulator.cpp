@@ -0,0 +1,325 @@
+//===-- Simulator.cpp - Compiled simulation of circuits ---------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// This file implements the compiled simulation of two circuits. Each circuit
+/// is cloned into a function over integers, lowered to the LLVM dialect
+/// without going through the Arc pipeline, and compiled by the MLIR execution
+/// engine.
+///
+//===----------------------------------------------------------------------===//
+
+#include "circt/LogicalEquivalence/Simulator.h"
+#include "circt/Conversion/CombToArith.h"
+#include "circt/Conversion/CombToLLVM.h"
+#include "circt/Dialect/Comb/CombOps.h"
+#include "circt/LogicalEquivalence/Utility.h"
+#include "mlir/Conversion/ArithToLLVM/ArithToLLVM.h"
+#include "mlir/Conversion/FuncToLLVM/ConvertFuncToLLVM.h"
+#include "mlir/Conversion/LLVMCommon/ConversionTarget.h"
+#include "mlir/Conversion/LLVMCommon/TypeConverter.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/LLVMIR/LLVMDialect.h"
+#include "mlir/ExecutionEngine/ExecutionEngine.h"
+#include "mlir/ExecutionEngine/OptUtils.h"
+#include "mlir/IR/IRMapping.h"
+#include "mlir/Pass/PassManager.h"
+#include "mlir/Target/LLVMIR/Dialect/Builtin/BuiltinToLLVMIRTranslation.h"
+#include "mlir/Target/LLVMIR/Dialect/LLVMIR/LLVMToLLVMIRTranslation.h"
+#include "mlir/Transforms/DialectConversion.h"
+#include "mlir/Transforms/TopologicalSortUtils.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/TargetSelect.h"
+#include <random>
+
+#define DEBUG_TYPE "lec-simulator"
+
+using namespace mlir;
+using namespace circt;
+
+/// The names of the compiled functions of the two circuits.
+static constexpr std::array<StringLiteral, 2> circuitNames = {"c1", "c2"};
+
+/// Collect the widths of integer ports. Fails on other types and on zero-width
+/// ports.
+static LogicalResult getPortWidths(TypeRange types,
+                                   SmallVectorImpl<unsigned> &widths) {
+  for (auto type : types) {
+    auto intType = type.dyn_cast<IntegerType>();
+    if (!intType || intType.getWidth() == 0)
+      return failure();
+    widths.push_back(intType.getWidth());
+  }
+  return success();
+}
+
+/// Return the width of a vector of concatenated ports, at least one bit.
+static unsigned getVectorWidth(ArrayRef<unsigned> widths) {
+  unsigned width = 0;
+  for (auto portWidth : widths)
+    width += portWidth;
+  return std::max(width, 1u);
+}
+
+/// Check whether an operation can be simulated. Divisions are rejected since
+/// they are undefined for a zero divisor in the compiled code, while the
+/// logical engine gives them a defined result.
+static bool isSupportedOp(Operation *op) {
+  if (isa<comb::DivUOp, comb::DivSOp, comb::ModUOp, comb::ModSOp>(op))
+    return false;
+  if (!isa<hw::ConstantOp>(op) && !isa<comb::CombDialect>(op->getDialect()))
+    return false;
+  auto isInteger = [](Type type) { return type.isa<IntegerType>(); };
+  return llvm::all_of(op->getOperandTypes(), isInteger) &&
+         llvm::all_of(op->getResultTypes(), isInteger);
+}
+
+/// Clone a shift into the function. Shifting by the bit width or more yields a
+/// poison value in LLVM, while `comb` shifts every bit out, so such shift
+/// amounts select the result explicitly.
+static Value cloneShift(OpBuilder &builder, Operation *op, IRMapping &mapping) {
+  auto loc = op->getLoc();
+  Value lhs = mapping.lookup(op->getOperand(0));
+  Value rhs = mapping.lookup(op->getOperand(1));
+  unsigned width = lhs.getType().cast<IntegerType>().getWidth();
+  Value shift = builder.clone(*op, mapping)->getResult(0);
+  Value limit = builder.create<hw::ConstantOp>(loc, APInt(width, width));
+  Value outOfRange = builder.create<comb::ICmpOp>(
+      loc, comb::ICmpPredicate::uge, rhs, limit, true);
+  Value fill;
+  if (isa<comb::ShrSOp>(op))
+    fill = builder.create<comb::ShrSOp>(
+        loc, lhs, builder.create<hw::ConstantOp>(loc, APInt(width, width - 1)),
+        true);
+  else
+    fill = builder.create<hw::ConstantOp>(loc, APInt::getZero(width));
+  return builder.create<comb::MuxOp>(loc, outOfRange, fill, shift, true);
+}
+
+/// Clone the body of a combinational module into a function from its
+/// concatenated inputs to its concatenated outputs, with the first port in the
+/// least significant bits. Fails if the module contains an unsupported
+/// operation or a combinational loop.
+static LogicalResult buildFunction(OpBuilder &builder, hw::HWModuleOp hwModule,
+                                   StringRef name, unsigned inputWidth,
+                                   unsigned outputWidth) {
+  auto loc = hwModule.getLoc();
+  auto inputType = builder.getIntegerType(inputWidth);
+  auto outputType = builder.getIntegerType(outputWidth);
+  auto funcOp = builder.create<func::FuncOp>(
+      loc, name, builder.getFunctionType(inputType, outputType));
+  auto bodyBuilder = OpBuilder::atBlockBegin(funcOp.addEntryBlock());
+
+  IRMapping mapping;
+  Value inputs = funcOp.getArgument(0);
+  unsigned offset = 0;
+  for (auto arg : hwModule.getArguments()) {
+    mapping.map(arg, bodyBuilder.create<comb::ExtractOp>(loc, arg.getType(),
+                                                         inputs, offset));
+    offset += arg.getType().getIntOrFloatBitWidth();
+  }
+
+  // The body is a graph region, while the function needs its operations in
+  // dominance order.
+  SmallVector<Operation *> ops;
+  for (auto &op : hwModule.getBodyBlock()->without_terminator()) {
+    if (!isSupportedOp(&op)) {
+      LLVM_DEBUG(lec::dbgs() << "Unsupported operation " << op.getName()
+                             << " in `" << hwModule.getName() << "`\n");
+      return failure();
+    }
+    ops.push_back(&op);
+  }
+  if (!computeTopologicalSorting(ops)) {
+    LLVM_DEBUG(lec::dbgs() << "Combinational loop in `" << hwModule.getName()
+                           << "`\n");
+    return failure();
+  }
+  for (auto *op : ops) {
+    if (isa<comb::ShlOp, comb::ShrUOp, comb::ShrSOp>(op))
+      mapping.map(op->getResult(0), cloneShift(bodyBuilder, op, mapping));
+    else
+      bodyBuilder.clone(*op, mapping);
+  }
+
+  auto outputOp = cast<hw::OutputOp>(hwModule.getBodyBlock()->getTerminator());
+  SmallVector<Value> outputs;
+  for (auto output : llvm::reverse(outputOp.getOperands()))
+    outputs.push_back(mapping.lookup(output));
+  Value result;
+  if (outputs.empty())
+    result = bodyBuilder.create<hw::ConstantOp>(loc, APInt(1, 0));
+  else if (outputs.size() == 1)
+    result = outputs[0];
+  else
+    result = bodyBuilder.create<comb::ConcatOp>(loc, outputs);
+  bodyBuilder.create<func::ReturnOp>(loc, result);
+  return success();
+}
+
+/// Lower the functions of the circuits to the LLVM dialect.
+static LogicalResult lowerToLLVM(ModuleOp module) {
+  auto *context = module.getContext();
+  PassManager pm(context);
+  pm.addPass(createConvertCombToArithPass());
+  if (failed(pm.run(module)))
+    return failure();
+
+  LLVMConversionTarget target(*context);
+  LLVMTypeConverter converter(context);
+  RewritePatternSet patterns(context);
+  target.addLegalOp<ModuleOp>();
+  populateFuncToLLVMConversionPatterns(converter, patterns);
+  populateCombToLLVMConversionPatterns(converter, patterns);
+  arith::populateArithToLLVMConversionPatterns(converter, patterns);
+  return applyFullConversion(module, target, std::move(patterns));
+}
+
+std::unique_ptr<Simulator> Simulator::create(hw::HWModuleOp c1,
+                                             hw::HWModuleOp c2) {
+  std::unique_ptr<Simulator> sim(new Simulator());
+  SmallVector<unsigned> inputWidths2, outputWidths2;
+  if (failed(getPortWidths(c1.getArgumentTypes(), sim->inputWidths)) ||
+      failed(getPortWidths(c1.getResultTypes(), sim->outputWidths)) ||
+      failed(getPortWidths(c2.getArgumentTypes(), inputWidths2)) ||
+      failed(getPortWidths(c2.getResultTypes(), outputWidths2))) {
+    LLVM_DEBUG(lec::dbgs() << "Unsupported port types\n");
+    return {};
+  }
+  if (sim->inputWidths != inputWidths2 || sim->outputWidths != outputWidths2) {
+    LLVM_DEBUG(lec::dbgs() << "Mismatching port widths\n");
+    return {};
+  }
+  for (auto name : c1.getArgNames())
+    sim->inputNames.push_back(name.cast<StringAttr>().str());
+  for (auto name : c1.getResultNames())
+    sim->outputNames.push_back(name.cast<StringAttr>().str());
+  sim->inputWidth = getVectorWidth(sim->inputWidths);
+  sim->outputWidth = getVectorWidth(sim->outputWidths);
+
+  auto *context = c1.getContext();
+  context->loadDialect<arith::ArithDialect, func::FuncDialect,
+                       LLVM::LLVMDialect>();
+  registerBuiltinDialectTranslation(*context);
+  registerLLVMDialectTranslation(*context);
+
+  auto loc = UnknownLoc::get(context);
+  OwningOpRef<ModuleOp> module(ModuleOp::create(loc));
+  auto builder = OpBuilder::atBlockBegin(module->getBody());
+  for (auto [hwModule, name] : llvm::zip(std::array{c1, c2}, circuitNames))
+    if (failed(buildFunction(builder, hwModule, name, sim->inputWidth,
+                             sim->outputWidth)))
+      return {};
+  if (failed(lowerToLLVM(*module)))
+    return {};
+
+  llvm::InitializeNativeTarget();
+  llvm::InitializeNativeTargetAsmPrinter();
+  ExecutionEngineOptions options;
+  options.transformer = makeOptimizingTransformer(
+      /*optLevel=*/2, /*sizeLevel=*/0, /*targetMachine=*/nullptr);
+  auto engine = ExecutionEngine::create(*module, options);
+  if (!engine) {
+    LLVM_DEBUG(lec::dbgs() << "Failed to compile the circuits: "
+                           << llvm::toString(engine.takeError()) << "\n");
+    llvm::consumeError(engine.takeError());
+    return {};
+  }
+  sim->engine = std::move(*engine);
+  for (auto [circuit, name] : llvm::zip(sim->circuits, circuitNames)) {
+    auto fn = sim->engine->lookupPacked(name);
+    if (!fn) {
+      LLVM_DEBUG(lec::dbgs() << "Failed to look up `" << name << "`\n");
+      llvm::consumeError(fn.takeError());
+      return {};
+    }
+    circuit = *fn;
+  }
+
+  // The compiled functions load and store their integer vectors in the
+  // memory layout of `APInt` words, which holds on little-endian hosts.
+  sim->inputBuffer.resize(APInt::getNumWords(sim->inputWidth));
+  for (auto &buffer : sim->outputBuffers)
+    buffer.resize(APInt::getNumWords(sim->outputWidth));
+  return sim;
+}
+
+Simulator::~Simulator() = default;
+
+bool Simulator::evaluate(const APInt &inputs) {
+  ++numVectors;
+  std::copy_n(inputs.getRawData(), inputs.getNumWords(), inputBuffer.begin());
+  for (auto [circuit, buffer] : llvm::zip(circuits, outputBuffers)) {
+    std::fill(buffer.begin(), buffer.end(), 0);
+    void *args[] = {inputBuffer.data(), buffer.data()};
+    circuit(args);
+  }
+  // The bits above the output width are left undefined by the stores.
+  APInt output1(outputWidth, outputBuffers[0]);
+  APInt output2(outputWidth, outputBuffers[1]);
+  if (output1 == output2)
+    return true;
+  mismatchInputs = inputs;
+  mismatchOutputs = {output1, output2};
+  return false;
+}
+
+Simulator::Result Simulator::run(uint64_t numRandomVectors,
+                                 unsigned exhaustiveBits, uint64_t seed) {
+  // Covering all input vectors proves the circuits equivalent. A circuit
+  // without inputs has a single, empty input vector.
+  unsigned numInputBits = 0;
+  for (auto width : inputWidths)
+    numInputBits += width;
+  if (numInputBits <= exhaustiveBits && numInputBits < 64) {
+    LLVM_DEBUG(lec::dbgs() << "Simulating all input vectors\n");
+    APInt inputs(inputWidth, 0);
+    for (uint64_t i = 0, e = uint64_t(1) << numInputBits; i < e; ++i, ++inputs)
+      if (!evaluate(inputs))
+        return Result::Mismatch;
+    return Result::Equivalent;
+  }
+
+  if (!evaluate(APInt::getZero(inputWidth)) ||
+      !evaluate(APInt::getAllOnes(inputWidth)))
+    return Result::Mismatch;
+  std::mt19937_64 rng(seed);
+  SmallVector<uint64_t> words(APInt::getNumWords(inputWidth));
+  for (uint64_t i = 0; i < numRandomVectors; ++i) {
+    for (auto &word : words)
+      word = rng();
+    if (!evaluate(APInt(inputWidth, words)))
+      return Result::Mismatch;
+  }
+  return Result::Inconclusive;
+}
+
+void Simulator::printMismatch(llvm::raw_ostream &os) const {
+  os << "Simulated inputs:\n";
+  unsigned offset = 0;
+  for (auto [name, width] : llvm::zip(inputNames, inputWidths)) {
+    os << "  " << name << " = ";
+    mismatchInputs.extractBits(width, offset).print(os, /*isSigned=*/false);
+    os << "\n";
+    offset += width;
+  }
+  os << "Mismatching outputs:\n";
+  offset = 0;
+  for (auto [name, width] : llvm::zip(outputNames, outputWidths)) {
+    APInt output1 = mismatchOutputs[0].extractBits(width, offset);
+    APInt output2 = mismatchOutputs[1].extractBits(width, offset);
+    offset += width;
+    if (output1 == output2)
+      continue;
+    os << "  " << name << ": ";
+    output1.print(os, /*isSigned=*/false);
+    os << " != ";
+    output2.print(os, /*isSigned=*/false);
+    os << "\n";
+  }
+}
@@ -15,6 +15,8 @@
 #include "circt/LogicalEquivalence/LogicExporter.h"
 #include "circt/LogicalEquivalence/Utility.h"
 #include "mlir/IR/Builders.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/StringSet.h"
 #include <string>
 #include <z3++.h>
 
@@ -23,23 +25,60 @@
 using namespace circt;
 using namespace mlir;
 
-Solver::Solver(MLIRContext *mlirCtx, bool statisticsOpt)
-    : circuits{}, mlirCtx(mlirCtx), context(), solver(context),
-      statisticsOpt(statisticsOpt) {}
+/// Build the solver of the given backend.
+static z3::solver makeSolver(z3::context &context, Solver::Backend backend) {
+  if (backend == Solver::Backend::SMT)
+    return z3::solver(context);
+  // Lower the bitvector constraints to propositional logic, then simplify them
+  // through an and-inverter graph with structural hashing before handing them
+  // to the SAT solver.
+  z3::tactic tactic = z3::tactic(context, "simplify") &
+                      z3::tactic(context, "bit-blast") &
+                      z3::tactic(context, "aig") & z3::tactic(context, "sat");
+  return tactic.mk_solver();
+}
+
+Solver::Solver(MLIRContext *mlirCtx, bool statisticsOpt, unsigned timeout,
+               Backend backend, unsigned bound)
+    : circuits{}, mlirCtx(mlirCtx), context(),
+      solver(makeSolver(context, backend)), statisticsOpt(statisticsOpt),
+      bound(bound) {
+  if (timeout) {
+    z3::params params(context);
+    params.set("timeout", timeout);
+    solver.set(params);
+  }
+}
 
 /// Solve the equivalence problem between the two circuits, then present the
 /// results to the user.
 LogicalResult Solver::solve() {
+  auto result = check();
+  if (failed(result))
+    return failure();
+  return report(*result);
+}
+
+/// Solve the equivalence problem between the two circuits. Fails when their
+/// inputs and outputs don't match.
+FailureOr<z3::check_result> Solver::check() {
   // Constrain the circuits for equivalence checking to be made:
   // require them to produce different outputs starting from the same inputs.
-  if (constrainCircuits().failed())
+  if (constrainCircuits().failed() || constrainRegisters().failed())
     return failure();
 
-  // Instruct the logical engine to solve the constraints:
-  // if they can't be satisfied it must mean the two circuits are functionally
-  // equivalent. Otherwise, print a model to act as a counterexample.
+  // Instruct the logical engine to solve the constraints.
+  return checkOutputs();
+}
+
+/// Present a result of `check` to the user. Fails unless the circuits were
+/// found to be equivalent.
+LogicalResult Solver::report(z3::check_result result) {
+  // If the constraints can't be satisfied it must mean the two circuits are
+  // functionally equivalent. Otherwise, print a model to act as a
+  // counterexample.
   LogicalResult outcome = success();
-  switch (solver.check()) {
+  switch (result) {
   case z3::unsat:
     lec::outs() << "c1 == c2\n";
     break;
@@ -125,6 +164,13 @@ void Solver::printAssertions() {
 void Solver::printStatistics() {
   lec::outs() << "SMT solver statistics:\n";
   lec::Scope indent;
+  lec::outs() << "structurally equal outputs : " << numStructurallyEqual
+              << "\n";
+  lec::outs() << "check time (ms) : "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(
+                     checkTime)
+                     .count()
+              << "\n";
   z3::stats stats = solver.statistics();
   for (unsigned i = 0; i < stats.size(); i++) {
     lec::outs() << stats.key(i) << " : " << stats.uint_value(i) << "\n";
@@ -173,17 +219,182 @@ LogicalResult Solver::constrainCircuits() {
     return failure();
   }
 
-  const auto *c1outIt = c1Outputs.begin();
-  const auto *c2outIt = c2Outputs.begin();
+  auto c1OutputIds = circuits[0]->getOutputIds();
+  auto c2OutputIds = circuits[1]->getOutputIds();
   for (unsigned i = 0; i < nc1Outputs; i++) {
     // Can't compare two circuits when their ith outputs differ in type.
-    if (c1outIt->get_sort().bv_size() != c2outIt->get_sort().bv_size()) {
+    unsigned width = c1Outputs[i].get_sort().bv_size();
+    if (width != c2Outputs[i].get_sort().bv_size()) {
       lec::errs() << "circt-lec error: output #" << i + 1 << " type mismatch\n";
       return failure();
     }
-    // Their ith outputs have to be equivalent.
-    solver.add(*c1outIt++ != *c2outIt++);
+    obligations.push_back({c1Outputs[i], c2Outputs[i],
+                           c1OutputIds[i] == c2OutputIds[i],
+                           "output #" + std::to_string(i + 1)});
   }
 
   return success();
 }
+
+/// Reduces the sequential circuits to combinational ones when their
+/// registers correspond to each other, by requiring equal current states to
+/// produce equal next states. Otherwise the circuits are unrolled.
+LogicalResult Solver::constrainRegisters() {
+  auto c1Registers = circuits[0]->getRegisters();
+  auto c2Registers = circuits[1]->getRegisters();
+  if (c1Registers.empty() && c2Registers.empty())
+    return success();
+
+  // Match the registers of the second circuit by name; unnamed and ambiguous
+  // registers have no counterpart.
+  llvm::StringMap<unsigned> c2Indices;
+  for (auto [i, reg] : llvm::enumerate(c2Registers))
+    if (!reg.name.empty() && !c2Indices.try_emplace(reg.name, i).second)
+      c2Indices[reg.name] = ~0u;
+  SmallVector<unsigned> counterparts;
+  llvm::StringSet<> c1Names;
+  std::optional<std::string> unmatched;
+  for (const Circuit::Register &reg : c1Registers) {
+    auto it = c2Indices.find(reg.name);
+    if (reg.name.empty() || !c1Names.insert(reg.name).second ||
+        it == c2Indices.end() || it->second == ~0u ||
+        c2Registers[it->second].state.get_sort().bv_size() !=
+            reg.state.get_sort().bv_size()) {
+      unmatched = reg.name;
+      break;
+    }
+    counterparts.push_back(it->second);
+  }
+  if (!unmatched && c1Registers.size() != c2Registers.size()) {
+    llvm::SmallDenseSet<unsigned> matched(counterparts.begin(),
+                                          counterparts.end());
+    for (auto [i, reg] : llvm::enumerate(c2Registers))
+      if (!matched.contains(i)) {
+        unmatched = reg.name;
+        break;
+      }
+  }
+
+  if (unmatched) {
+    LLVM_DEBUG(lec::dbgs() << "register `" << *unmatched
+                           << "` has no counterpart\n");
+    if (bound)
+      return unrollCircuits();
+    lec::errs() << "circt-lec error: register `" << *unmatched
+                << "` has no counterpart in the other circuit, a bound is "
+                   "needed to unroll the circuits\n";
+    return failure();
+  }
+
+  // If the corresponding registers hold the same states, they must transition
+  // to the same next states, reset values included.
+  for (auto [reg, counterpart] : llvm::zip(c1Registers, counterparts)) {
+    const Circuit::Register &other = c2Registers[counterpart];
+    solver.add(reg.state == other.state);
+    obligations.push_back({reg.next, other.next, false,
+                           "next state of register `" + reg.name + "`"});
+  }
+  return success();
+}
+
+/// Unrolls the circuits for `bound` cycles starting from their reset state,
+/// requiring their outputs to be equal in each cycle.
+LogicalResult Solver::unrollCircuits() {
+  // Registers with a reset start from their reset value. The others start
+  // from an arbitrary value, the same for both circuits when they match by
+  // name.
+  llvm::StringMap<z3::expr> initialStates;
+  for (Circuit *circuit : circuits) {
+    for (const Circuit::Register &reg : circuit->getRegisters()) {
+      if (reg.resetValue) {
+        solver.add(reg.state == *reg.resetValue);
+        continue;
+      }
+      if (reg.name.empty())
+        continue;
+      auto it = initialStates.try_emplace(reg.name, reg.state).first;
+      if (it->second.get_sort().bv_size() == reg.state.get_sort().bv_size())
+        solver.add(reg.state == it->second);
+    }
+  }
+
+  // Export the logic of the circuits once more for each of the following
+  // cycles, with their current states being the next states of the previous
+  // cycle.
+  std::array<Circuit *, 2> previous = {circuits[0], circuits[1]};
+  for (unsigned cycle = 1; cycle < bound; ++cycle) {
+    std::array<Circuit *, 2> current;
+    for (unsigned n = 0; n < 2; ++n) {
+      auto circuit = unrollCircuit(previous[n], n == 0 ? "c1@" : "c2@", cycle);
+      if (failed(circuit))
+        return failure();
+      current[n] = *circuit;
+    }
+    unrolledCircuits.push_back(current);
+
+    for (auto [lhs, rhs] :
+         llvm::zip(current[0]->getInputs(), current[1]->getInputs()))
+      solver.add(lhs == rhs);
+    auto lhsOutputs = current[0]->getOutputs();
+    auto rhsOutputs = current[1]->getOutputs();
+    auto lhsIds = current[0]->getOutputIds();
+    auto rhsIds = current[1]->getOutputIds();
+    for (unsigned i = 0, e = lhsOutputs.size(); i < e; ++i)
+      obligations.push_back({lhsOutputs[i], rhsOutputs[i],
+                             lhsIds[i] == rhsIds[i],
+                             "output #" + std::to_string(i + 1) +
+                                 " in cycle " + std::to_string(cycle)});
+    previous = current;
+  }
+  return success();
+}
+
+/// Exports the logic of a circuit once more for the given cycle, with its
+/// current states being the next states of the `previous` cycle.
+FailureOr<Solver::Circuit *>
+Solver::unrollCircuit(Circuit *previous, StringRef prefix, unsigned cycle) {
+  hw::HWModuleOp module = previous->getTopModule();
+  auto *circuit = new Solver::Circuit(
+      Twine(prefix) + module.getName() + "#" + Twine(cycle), *this, cycle);
+  LogicExporter exporter(module.getName(), circuit);
+  if (auto cone = previous->getConeOutput())
+    exporter.setOutputCone(*cone);
+  if (failed(exporter.run(module)))
+    return failure();
+  for (auto [reg, prev] :
+       llvm::zip(circuit->getRegisters(), previous->getRegisters()))
+    solver.add(reg.state == prev.next);
+  return circuit;
+}
+
+/// Checks the pairs of outputs for equivalence one at a time. Outputs found
+/// to be equivalent are constrained to be equal for the remaining checks.
+z3::check_result Solver::checkOutputs() {
+  for (const Obligation &obligation : obligations) {
+    // Values with the same structure are equivalent without asking the
+    // solver.
+    if (obligation.structurallyEqual) {
+      LLVM_DEBUG(lec::dbgs() << obligation.description
+                             << " is structurally equal\n");
+      ++numStructurallyEqual;
+      continue;
+    }
+
+    // Look for inputs for which the values differ. The constraint is scoped
+    // so that it can be dropped once it is unsatisfiable.
+    LLVM_DEBUG(lec::dbgs() << "checking " << obligation.description << "\n");
+    solver.push();
+    solver.add(obligation.lhs != obligation.rhs);
+    auto start = std::chrono::steady_clock::now();
+    z3::check_result result = solver.check();
+    checkTime += std::chrono::steady_clock::now() - start;
+    if (result != z3::unsat)
+      return result;
+    solver.pop();
+
+    // The values are equivalent, which simplifies the remaining checks when
+    // their logic cones overlap.
+    solver.add(obligation.lhs == obligation.rhs);
+  }
+  return z3::unsat;
+}
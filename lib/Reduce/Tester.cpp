@@ -11,13 +11,39 @@
 //===----------------------------------------------------------------------===//
 
 #include "circt/Reduce/Tester.h"
+#include "mlir/Bytecode/BytecodeWriter.h"
+#include "mlir/IR/Diagnostics.h"
 #include "mlir/IR/Verifier.h"
+#include "mlir/Parser/Parser.h"
+#include "mlir/Pass/PassManager.h"
+#include "mlir/Pass/PassRegistry.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/Errno.h"
+#include "llvm/Support/Regex.h"
 #include "llvm/Support/ToolOutputFile.h"
 
+#ifdef LLVM_ON_UNIX
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 using namespace llvm;
 using namespace mlir;
 using namespace circt;
 
+/// The exit codes of the child process running an in-process test. The child
+/// terminating in any other way counts as a crash, which includes the exit
+/// code 1 of a `report_fatal_error` that does not abort.
+enum : int {
+  /// A diagnostic matching the test pattern was emitted.
+  diagnosticMatchedExitCode = 0,
+  /// The pipeline ran to completion, successfully or not.
+  pipelineDoneExitCode = 2,
+  /// The test case or the pipeline could not be parsed.
+  setupFailedExitCode = 3,
+};
+
 //===----------------------------------------------------------------------===//
 // Tester
 //===----------------------------------------------------------------------===//
@@ -36,6 +62,9 @@ std::pair<bool, size_t> Tester::isInteresting(ModuleOp module) const {
 /// true if the interesting behavior is present in the test case or false
 /// otherwise.
 bool Tester::isInteresting(StringRef testCase) const {
+  if (isInProcess())
+    return isInterestingInProcess({}, testCase);
+
   // Assemble the arguments to the tester. Note that the first one has to be the
   // name of the program.
   SmallVector<StringRef> testerArgs;
@@ -58,6 +87,89 @@ bool Tester::isInteresting(StringRef testCase) const {
   return result == 0;
 }
 
+void Tester::setInProcessTest(MLIRContext *context, StringRef testPipeline,
+                              StringRef testDiagnostic) {
+  this->context = context;
+  this->testPipeline = testPipeline.str();
+  this->testDiagnostic = testDiagnostic.str();
+}
+
+/// Write a test case to `os` in the format given to the tests.
+void Tester::print(ModuleOp module, raw_ostream &os) const {
+  if (emitBytecode)
+    (void)writeBytecodeToFile(module, os);
+  else
+    module.print(os);
+}
+
+/// Run the test pipeline on `module`, or on the module parsed from the file
+/// `testCase` if null, in a forked child process.
+bool Tester::isInterestingInProcess(ModuleOp module, StringRef testCase) const {
+#ifdef LLVM_ON_UNIX
+  pid_t pid = fork();
+  if (pid < 0)
+    llvm::report_fatal_error(
+        Twine("Error forking the interestingness test: ") + sys::StrError(),
+        false);
+  if (pid == 0)
+    runTestPipeline(module, testCase);
+
+  int status;
+  while (waitpid(pid, &status, 0) < 0)
+    if (errno != EINTR)
+      llvm::report_fatal_error(
+          Twine("Error waiting for the interestingness test: ") +
+              sys::StrError(),
+          false);
+  bool exited = WIFEXITED(status);
+  int exitCode = exited ? WEXITSTATUS(status) : -1;
+  if (testDiagnostic.empty())
+    return !exited || (exitCode != pipelineDoneExitCode &&
+                       exitCode != setupFailedExitCode &&
+                       exitCode != diagnosticMatchedExitCode);
+  return exited && exitCode == diagnosticMatchedExitCode;
+#else
+  llvm::report_fatal_error(
+      "In-process interestingness tests are not supported on this platform",
+      false);
+#endif
+}
+
+/// The body of the child process running the test pipeline. Exits as soon as a
+/// diagnostic of interest is emitted, or after the pipeline has run.
+void Tester::runTestPipeline(ModuleOp module, StringRef testCase) const {
+#ifdef LLVM_ON_UNIX
+  // Silence the pipeline, and the stack trace printed if it crashes.
+  int devNull = ::open("/dev/null", O_WRONLY);
+  if (devNull >= 0) {
+    ::dup2(devNull, STDOUT_FILENO);
+    ::dup2(devNull, STDERR_FILENO);
+  }
+
+  OwningOpRef<ModuleOp> parsedModule;
+  if (!module) {
+    parsedModule = parseSourceFile<ModuleOp>(testCase, context);
+    if (!parsedModule)
+      ::_exit(setupFailedExitCode);
+    module = parsedModule.get();
+  }
+
+  Regex regex(testDiagnostic);
+  ScopedDiagnosticHandler handler(context, [&](Diagnostic &diag) {
+    if (!testDiagnostic.empty() && regex.match(diag.str()))
+      ::_exit(diagnosticMatchedExitCode);
+    return success();
+  });
+  PassManager pm(context);
+  if (failed(parsePassPipeline(testPipeline, pm)))
+    ::_exit(setupFailedExitCode);
+  (void)pm.run(module);
+  ::_exit(pipelineDoneExitCode);
+#else
+  llvm_unreachable("in-process tests are not supported on this platform");
+#endif
+}
+
 /// Create a new test case for the given `module`.
 TestCase Tester::get(mlir::ModuleOp module) const {
   return TestCase(*this, module);
@@ -72,6 +184,19 @@ TestCase Tester::get(llvm::Twine filepath) const {
 // Test Case
 //===----------------------------------------------------------------------===//
 
+namespace {
+/// A stream which only counts the bytes written to it.
+class CountingOStream : public raw_ostream {
+public:
+  ~CountingOStream() override { flush(); }
+
+private:
+  void write_impl(const char *ptr, size_t size) override { pos += size; }
+  uint64_t current_pos() const override { return pos; }
+  uint64_t pos = 0;
+};
+} // namespace
+
 /// Check whether the MLIR module is valid. Actual validation is only
 /// performed on the first call; subsequent calls return the cached result.
 bool TestCase::isValid() {
@@ -97,6 +222,15 @@ StringRef TestCase::getFilepath() {
 size_t TestCase::getSize() {
   if (!isValid())
     return 0;
+  // In-process tests don't need the test case on disk.
+  if (module && tester.isInProcess()) {
+    if (!size) {
+      CountingOStream os;
+      tester.print(module, os);
+      size = os.tell();
+    }
+    return *size;
+  }
   ensureFileOnDisk();
   return *size;
 }
@@ -107,6 +241,11 @@ size_t TestCase::getSize() {
 bool TestCase::isInteresting() {
   if (!isValid())
     return false;
+  if (module && tester.isInProcess()) {
+    if (!interesting)
+      interesting = tester.isInterestingInProcess(module, "");
+    return *interesting;
+  }
   ensureFileOnDisk();
   if (!interesting)
     interesting = tester.isInteresting(filepath);
@@ -124,14 +263,14 @@ void TestCase::ensureFileOnDisk() {
     // Pick a temporary output file path.
     int fd;
     std::error_code ec = llvm::sys::fs::createTemporaryFile(
-        "circt-reduce", "mlir", fd, filepath);
+        "circt-reduce", tester.emitBytecode ? "mlirbc" : "mlir", fd, filepath);
     if (ec)
       llvm::report_fatal_error(
           Twine("Error making unique filename: ") + ec.message(), false);
 
     // Write to the output.
     file = std::make_unique<llvm::ToolOutputFile>(filepath, fd);
-    module.print(file->os());
+    tester.print(module, file->os());
     file->os().close();
     if (file->os().has_error())
       llvm::report_fatal_error(llvm::Twine("Error emitting the IR to file `") +
@@ -40,8 +40,16 @@ LogicalResult scheduling::computeChainBreakingDependences(
   // Do a simple DFA-style pass over the dependence graph to determine
   // combinational chains and their respective accumulated delays.
   return handleOperationsInTopologicalOrder(prob, [&](Operation *op) {
+    // Make sure all predecessors have been handled before recording anything
+    // for `op`, as other operations take the presence of `op`'s chains as a
+    // sign that it has been handled.
+    for (auto dep : prob.getDependences(op))
+      if (!dep.isAuxiliary() && !chains.count(dep.getSource()))
+        return failure(); // Predecessor hasn't been handled yet.
+
     // Mark `op` to be the origin of its own chain.
-    chains[op][op] = 0.0f;
+    auto &opChains = chains[op];
+    opChains[op] = 0.0f;
 
     for (auto dep : prob.getDependences(op)) {
       // Skip auxiliary deps, as these don't carry values.
@@ -49,40 +57,39 @@ LogicalResult scheduling::computeChainBreakingDependences(
         continue;
 
       Operation *pred = dep.getSource();
-      if (!chains.count(pred))
-        return failure(); // Predecessor hasn't been handled yet.
-
       auto predOpr = *prob.getLinkedOperatorType(pred);
+      float predOutgoingDelay = *prob.getOutgoingDelay(predOpr);
       if (*prob.getLatency(predOpr) > 0) {
         // `pred` is not combinational, so none of its incoming chains are
         // extended. Hence, it only contributes its outgoing delay to `op`'s
         // incoming delay.
-        chains[op][pred] = *prob.getOutgoingDelay(predOpr);
+        opChains[pred] = predOutgoingDelay;
         continue;
       }
 
       // Otherwise, `pred` is combinational. This means that all of its incoming
       // chains, extended by `pred`, are incoming chains for `op`.
-      for (auto incomingChain : chains[pred]) {
+      for (auto incomingChain : chains.find(pred)->second) {
         Operation *origin = incomingChain.first;
         float delay = incomingChain.second;
-        chains[op][origin] = std::max(delay + *prob.getOutgoingDelay(predOpr),
-                                      chains[op][origin]);
+        float &opDelay = opChains[origin];
+        opDelay = std::max(delay + predOutgoingDelay, opDelay);
       }
     }
 
     // All chains/accumulated delays incoming at `op` are now known.
     auto opr = *prob.getLinkedOperatorType(op);
-    for (auto incomingChain : chains[op]) {
+    float incomingDelay = *prob.getIncomingDelay(opr);
+    for (auto incomingChain : opChains) {
       Operation *origin = incomingChain.first;
       float delay = incomingChain.second;
       // Check whether `op` could be appended to the incoming chain without
       // violating the cycle time constraint.
-      if (delay + *prob.getIncomingDelay(opr) > cycleTime) {
+      if (delay + incomingDelay > cycleTime) {
         // If not, add a chain-breaking auxiliary dep ...
         result.emplace_back(origin, op);
         // ... and end the chain here.
-        chains[op].erase(origin);
+        opChains.erase(origin);
       }
     }
 
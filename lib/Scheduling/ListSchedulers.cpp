@@ -0,0 +1,394 @@
+//===- ListSchedulers.cpp - Priority-based list schedulers ----------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Implementation of priority-based list schedulers for resource-constrained
+// problems. In contrast to the LP-based schedulers, these run in near-linear
+// time in the size of the dependence graph, and are therefore suited for large
+// problem instances.
+//
+// The modulo scheduler implements the approach described in:
+//  [1] B. R. Rau, "Iterative Modulo Scheduling", MICRO-27, 1994.
+//
+//===----------------------------------------------------------------------===//
+
+#include "circt/Scheduling/Algorithms.h"
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/Debug.h"
+
+#include <algorithm>
+#include <queue>
+
+#define DEBUG_TYPE "list-schedulers"
+
+using namespace circt;
+using namespace circt::scheduling;
+
+using llvm::dbgs;
+
+namespace {
+
+/// A dense representation of a problem's dependence graph, in which the
+/// operations are identified by their index in the problem.
+struct DependenceGraph {
+  struct Edge {
+    /// The other end of the dependence.
+    unsigned op;
+    /// The latency of the dependence's source operation.
+    unsigned latency;
+    /// The dependence distance, or zero in acyclic problems.
+    unsigned distance;
+  };
+
+  SmallVector<Operation *> ops;
+  SmallVector<unsigned> latencies;
+  SmallVector<SmallVector<Edge, 2>> preds, succs;
+
+  /// The index of each operation's limited operator type into the reservation
+  /// tables, or `none` if the operator type is not limited.
+  SmallVector<unsigned> resources;
+  SmallVector<unsigned> limits;
+  static constexpr unsigned none = ~0U;
+
+  DependenceGraph(SharedOperatorsProblem &prob, CyclicProblem *cyclicProb);
+};
+
+} // namespace
+
+DependenceGraph::DependenceGraph(SharedOperatorsProblem &prob,
+                                 CyclicProblem *cyclicProb) {
+  DenseMap<Operation *, unsigned> ids;
+  DenseMap<Problem::OperatorType, unsigned> resourceIds;
+  for (auto *op : prob.getOperations()) {
+    ids[op] = ops.size();
+    ops.push_back(op);
+    auto opr = *prob.getLinkedOperatorType(op);
+    latencies.push_back(*prob.getLatency(opr));
+    unsigned limit = prob.getLimit(opr).value_or(0);
+    if (limit == 0) {
+      resources.push_back(none);
+      continue;
+    }
+    auto [it, inserted] = resourceIds.try_emplace(opr, limits.size());
+    if (inserted)
+      limits.push_back(limit);
+    resources.push_back(it->second);
+  }
+
+  preds.resize(ops.size());
+  succs.resize(ops.size());
+  for (auto [dst, op] : llvm::enumerate(ops)) {
+    for (auto &dep : prob.getDependences(op)) {
+      unsigned src = ids.lookup(dep.getSource());
+      unsigned distance =
+          cyclicProb ? cyclicProb->getDistance(dep).value_or(0) : 0;
+      preds[dst].push_back({src, latencies[src], distance});
+      succs[src].push_back({(unsigned)dst, latencies[src], distance});
+    }
+  }
+}
+
+/// The priority queue of the list schedulers. Operations with a higher priority
+/// are scheduled first, and ties are broken by the order of the operations in
+/// the problem to keep the result deterministic.
+using PriorityQueue =
+    std::priority_queue<std::pair<int64_t, int64_t>,
+                        std::vector<std::pair<int64_t, int64_t>>>;
+
+//===----------------------------------------------------------------------===//
+// Acyclic list scheduler
+//===----------------------------------------------------------------------===//
+
+/// Return the first time step not before \p time in which another operation
+/// can be started on a resource, where \p nextFree maps the resource's full
+/// time steps to the next candidate. Full time steps are skipped in amortized
+/// constant time by compressing the paths through \p nextFree.
+static unsigned findFreeTimeStep(DenseMap<unsigned, unsigned> &nextFree,
+                                 unsigned time) {
+  unsigned free = time;
+  while (true) {
+    auto it = nextFree.find(free);
+    if (it == nextFree.end())
+      break;
+    free = it->second;
+  }
+  // Compress the path to point directly to the free time step.
+  while (time != free) {
+    auto &next = nextFree[time];
+    time = next;
+    next = free;
+  }
+  return free;
+}
+
+LogicalResult scheduling::scheduleList(SharedOperatorsProblem &prob) {
+  DependenceGraph graph(prob, /*cyclicProb=*/nullptr);
+  unsigned numOps = graph.ops.size();
+
+  // Compute a topological order of the operations.
+  SmallVector<unsigned> order, numUnhandledPreds(numOps);
+  order.reserve(numOps);
+  for (unsigned i = 0; i < numOps; ++i) {
+    numUnhandledPreds[i] = graph.preds[i].size();
+    if (numUnhandledPreds[i] == 0)
+      order.push_back(i);
+  }
+  for (unsigned next = 0; next < order.size(); ++next)
+    for (auto &succ : graph.succs[order[next]])
+      if (--numUnhandledPreds[succ.op] == 0)
+        order.push_back(succ.op);
+  if (order.size() != numOps)
+    return prob.getContainingOp()->emitError() << "dependence cycle detected";
+
+  // The priority of an operation is the length of the longest path from it to
+  // any sink of the dependence graph, i.e. operations on the critical path are
+  // scheduled first.
+  SmallVector<int64_t> heights(numOps, 0);
+  for (unsigned i : llvm::reverse(order)) {
+    int64_t height = 0;
+    for (auto &succ : graph.succs[i])
+      height = std::max(height, heights[succ.op]);
+    heights[i] = height + graph.latencies[i];
+  }
+
+  // Schedule the ready operations in priority order. Each limited resource has
+  // a reservation table that counts the operations started in each time step.
+  SmallVector<unsigned> startTimes(numOps, 0);
+  SmallVector<DenseMap<unsigned, unsigned>> usage(graph.limits.size());
+  SmallVector<DenseMap<unsigned, unsigned>> nextFree(graph.limits.size());
+  PriorityQueue ready;
+  for (unsigned i = 0; i < numOps; ++i) {
+    numUnhandledPreds[i] = graph.preds[i].size();
+    if (numUnhandledPreds[i] == 0)
+      ready.push({heights[i], -(int64_t)i});
+  }
+
+  while (!ready.empty()) {
+    unsigned i = -ready.top().second;
+    ready.pop();
+
+    unsigned time = 0;
+    for (auto &pred : graph.preds[i])
+      time = std::max(time, startTimes[pred.op] + pred.latency);
+
+    unsigned res = graph.resources[i];
+    if (res != DependenceGraph::none) {
+      time = findFreeTimeStep(nextFree[res], time);
+      if (++usage[res][time] == graph.limits[res])
+        nextFree[res][time] = time + 1;
+    }
+    startTimes[i] = time;
+
+    for (auto &succ : graph.succs[i])
+      if (--numUnhandledPreds[succ.op] == 0)
+        ready.push({heights[succ.op], -(int64_t)succ.op});
+  }
+
+  for (auto [op, time] : llvm::zip(graph.ops, startTimes))
+    prob.setStartTime(op, time);
+  return success();
+}
+
+//===----------------------------------------------------------------------===//
+// Iterative modulo scheduler
+//===----------------------------------------------------------------------===//
+
+/// Compute the heights of the operations for the given \p ii, i.e. the length
+/// of the longest path to any sink, where each dependence is shortened by
+/// \p ii times its distance. Fails if the graph contains a cycle of positive
+/// length, in which case \p ii is infeasible.
+static LogicalResult computeHeights(DependenceGraph &graph, unsigned ii,
+                                    SmallVectorImpl<int64_t> &heights) {
+  unsigned numOps = graph.ops.size();
+  heights.assign(numOps, 0);
+  for (unsigned i = 0; i < numOps; ++i)
+    heights[i] = graph.latencies[i];
+
+  // Relax the dependences in reverse problem order until a fixed point is
+  // reached, which should take few rounds for the usual mostly-ordered
+  // problems. A positive cycle prevents convergence within |ops| rounds.
+  for (unsigned round = 0; round <= numOps; ++round) {
+    bool changed = false;
+    for (unsigned i = numOps; i-- > 0;) {
+      for (auto &succ : graph.succs[i]) {
+        int64_t height = heights[succ.op] + succ.latency -
+                         (int64_t)ii * succ.distance;
+        if (height > heights[i]) {
+          heights[i] = height;
+          changed = true;
+        }
+      }
+    }
+    if (!changed)
+      return success();
+  }
+  return failure();
+}
+
+namespace {
+/// A single attempt of the iterative modulo scheduling algorithm for a fixed
+/// II, following [1].
+struct IterativeModuloScheduler {
+  IterativeModuloScheduler(DependenceGraph &graph, unsigned ii)
+      : graph(graph), ii(ii), startTimes(graph.ops.size()),
+        mrt(graph.limits.size()) {
+    for (auto &table : mrt)
+      table.resize(ii);
+  }
+
+  LogicalResult schedule(ArrayRef<int64_t> heights, unsigned budget);
+
+  DependenceGraph &graph;
+  unsigned ii;
+
+  /// The current start time of each operation, if it is scheduled.
+  SmallVector<std::optional<int64_t>> startTimes;
+
+  /// The modulo reservation table of each limited resource, which lists the
+  /// operations occupying each congruence class.
+  SmallVector<SmallVector<SmallVector<unsigned, 2>>> mrt;
+
+private:
+  void unschedule(unsigned op, PriorityQueue &queue,
+                  ArrayRef<int64_t> heights);
+  bool hasFreeSlot(unsigned op, int64_t time);
+};
+} // namespace
+
+bool IterativeModuloScheduler::hasFreeSlot(unsigned op, int64_t time) {
+  unsigned res = graph.resources[op];
+  return res == DependenceGraph::none ||
+         mrt[res][time % ii].size() < graph.limits[res];
+}
+
+void IterativeModuloScheduler::unschedule(unsigned op, PriorityQueue &queue,
+                                          ArrayRef<int64_t> heights) {
+  unsigned res = graph.resources[op];
+  if (res != DependenceGraph::none) {
+    auto &slot = mrt[res][*startTimes[op] % ii];
+    slot.erase(llvm::find(slot, op));
+  }
+  startTimes[op] = std::nullopt;
+  queue.push({heights[op], -(int64_t)op});
+}
+
+LogicalResult IterativeModuloScheduler::schedule(ArrayRef<int64_t> heights,
+                                                 unsigned budget) {
+  unsigned numOps = graph.ops.size();
+  SmallVector<std::optional<int64_t>> prevStartTimes(numOps);
+  PriorityQueue queue;
+  for (unsigned i = 0; i < numOps; ++i)
+    queue.push({heights[i], -(int64_t)i});
+
+  while (!queue.empty()) {
+    unsigned op = -queue.top().second;
+    queue.pop();
+    if (startTimes[op])
+      continue; // Stale entry of an operation that was scheduled again.
+    if (budget-- == 0)
+      return failure();
+
+    // Determine the earliest start time w.r.t. the scheduled predecessors.
+    int64_t earliest = 0;
+    for (auto &pred : graph.preds[op])
+      if (pred.op != op && startTimes[pred.op])
+        earliest = std::max(earliest, *startTimes[pred.op] + pred.latency -
+                                          (int64_t)ii * pred.distance);
+
+    // Look for a conflict-free time step within one II of the earliest one.
+    // Otherwise, force the operation into a time step, and evict whatever
+    // conflicts with it.
+    std::optional<int64_t> time;
+    for (int64_t t = earliest; t < earliest + ii && !time; ++t)
+      if (hasFreeSlot(op, t))
+        time = t;
+    if (!time) {
+      auto &prev = prevStartTimes[op];
+      time = (!prev || earliest > *prev) ? earliest : *prev + 1;
+    }
+
+    // Evict an operation holding the resource in the chosen congruence class.
+    unsigned res = graph.resources[op];
+    if (!hasFreeSlot(op, *time))
+      unschedule(mrt[res][*time % ii].front(), queue, heights);
+
+    // Evict the successors whose dependences are now violated.
+    for (auto &succ : graph.succs[op])
+      if (succ.op != op && startTimes[succ.op] &&
+          *startTimes[succ.op] <
+              *time + succ.latency - (int64_t)ii * succ.distance)
+        unschedule(succ.op, queue, heights);
+
+    startTimes[op] = *time;
+    prevStartTimes[op] = *time;
+    if (res != DependenceGraph::none)
+      mrt[res][*time % ii].push_back(op);
+  }
+  return success();
+}
+
+LogicalResult scheduling::scheduleList(ModuloProblem &prob) {
+  DependenceGraph graph(prob, &prob);
+  unsigned numOps = graph.ops.size();
+
+  // The resource-constrained lower bound of the II.
+  SmallVector<unsigned> uses(graph.limits.size(), 0);
+  for (unsigned res : graph.resources)
+    if (res != DependenceGraph::none)
+      ++uses[res];
+  unsigned resMinII = 1;
+  for (auto [numUses, limit] : llvm::zip(uses, graph.limits))
+    resMinII = std::max(resMinII, (numUses + limit - 1) / limit);
+
+  // A dependence cycle has a positive length for all IIs if its total distance
+  // is zero, which makes the problem infeasible. Otherwise, the cycles' lengths
+  // are non-positive if the II is larger than the sum of all latencies.
+  unsigned maxII = resMinII + numOps;
+  for (unsigned latency : graph.latencies)
+    maxII += latency;
+  SmallVector<int64_t> heights;
+  if (failed(computeHeights(graph, maxII, heights)))
+    return prob.getContainingOp()->emitError()
+           << "dependence cycle with zero distance detected";
+
+  // Find the recurrence-constrained lower bound of the II by bisection, as the
+  // feasibility w.r.t. the dependence cycles is monotonic in the II.
+  unsigned minII = resMinII, feasibleII = maxII;
+  while (minII < feasibleII) {
+    unsigned ii = minII + (feasibleII - minII) / 2;
+    if (succeeded(computeHeights(graph, ii, heights)))
+      feasibleII = ii;
+    else
+      minII = ii + 1;
+  }
+  LLVM_DEBUG(dbgs() << "ResMinII = " << resMinII << ", MinII = " << minII
+                    << '\n');
+
+  // Attempt to schedule with increasing IIs. Each attempt is limited to a
+  // number of scheduling steps proportional to the number of operations.
+  constexpr unsigned budgetRatio = 6;
+  for (unsigned ii = minII; ii <= maxII; ++ii) {
+    auto heightsFound = computeHeights(graph, ii, heights);
+    assert(succeeded(heightsFound));
+    (void)heightsFound;
+
+    IterativeModuloScheduler ims(graph, ii);
+    if (failed(ims.schedule(heights, budgetRatio * numOps + 1))) {
+      LLVM_DEBUG(dbgs() << "Budget exhausted for II = " << ii << '\n');
+      continue;
+    }
+
+    prob.setInitiationInterval(ii);
+    for (auto [op, time] : llvm::zip(graph.ops, ims.startTimes))
+      prob.setStartTime(op, *time);
+    return success();
+  }
+
+  return prob.getContainingOp()->emitError()
+         << "no feasible initiation interval found";
+}
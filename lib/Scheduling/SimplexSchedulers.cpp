@@ -15,12 +15,15 @@
 #include "circt/Scheduling/Utilities.h"
 
 #include "mlir/IR/Operation.h"
+#include "mlir/IR/Threading.h"
 
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/Format.h"
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <limits>
 
 #define DEBUG_TYPE "simplex-schedulers"
@@ -164,7 +167,8 @@ protected:
   std::optional<unsigned> findPrimalPivotColumn();
   std::optional<unsigned> findPrimalPivotRow(unsigned pivotColumn);
   void multiplyRow(unsigned row, int factor);
-  void addMultipleOfRow(unsigned sourceRow, int factor, unsigned targetRow);
+  void addMultipleOfRow(unsigned sourceRow, int factor, unsigned targetRow,
+                        ArrayRef<unsigned> sourceColumns);
   void pivot(unsigned pivotRow, unsigned pivotColumn);
   LogicalResult solveTableau();
   LogicalResult restoreDualFeasibility();
@@ -177,8 +181,17 @@ protected:
 
   void dumpTableau();
 
+  /// If set, the iterative heuristics abandon their search at this point in
+  /// time.
+  Deadline deadline;
+
+  bool isPastDeadline() {
+    return deadline && std::chrono::steady_clock::now() > *deadline;
+  }
+
 public:
-  explicit SimplexSchedulerBase(Operation *lastOp) : lastOp(lastOp) {}
+  explicit SimplexSchedulerBase(Operation *lastOp, Deadline deadline = {})
+      : lastOp(lastOp), deadline(deadline) {}
   virtual ~SimplexSchedulerBase() = default;
   virtual LogicalResult schedule() = 0;
 };
@@ -213,8 +226,9 @@ protected:
                          Problem::Dependence dep) override;
 
 public:
-  CyclicSimplexScheduler(CyclicProblem &prob, Operation *lastOp)
-      : SimplexSchedulerBase(lastOp), prob(prob) {}
+  CyclicSimplexScheduler(CyclicProblem &prob, Operation *lastOp,
+                         Deadline deadline = {})
+      : SimplexSchedulerBase(lastOp, deadline), prob(prob) {}
   LogicalResult schedule() override;
 };
 
@@ -229,8 +243,8 @@ protected:
 
 public:
   SharedOperatorsSimplexScheduler(SharedOperatorsProblem &prob,
-                                  Operation *lastOp)
-      : SimplexSchedulerBase(lastOp), prob(prob) {}
+                                  Operation *lastOp, Deadline deadline = {})
+      : SimplexSchedulerBase(lastOp, deadline), prob(prob) {}
   LogicalResult schedule() override;
 };
 
@@ -256,6 +270,14 @@ private:
   SmallVector<Operation *> unscheduled, scheduled;
   MRT mrt;
 
+  /// The II to start the search at, if it is larger than the lower bound
+  /// determined by the resource constraints.
+  unsigned startII;
+
+  /// If set, the search is abandoned once the II exceeds this bound, because a
+  /// concurrently running scheduler already found a better solution.
+  const std::atomic<unsigned> *bestII;
+
 protected:
   Problem &getProblem() override { return prob; }
   LogicalResult checkLastOp() override;
@@ -264,11 +286,24 @@ protected:
   void updateMargins();
   void scheduleOperation(Operation *n);
   unsigned computeResMinII();
+  bool isCancelled() {
+    return (bestII && (unsigned)parameterT > bestII->load()) ||
+           isPastDeadline();
+  }
 
 public:
-  ModuloSimplexScheduler(ModuloProblem &prob, Operation *lastOp)
-      : CyclicSimplexScheduler(prob, lastOp), prob(prob), mrt(*this) {}
+  ModuloSimplexScheduler(ModuloProblem &prob, Operation *lastOp,
+                         unsigned startII = 1,
+                         const std::atomic<unsigned> *bestII = nullptr,
+                         Deadline deadline = {})
+      : CyclicSimplexScheduler(prob, lastOp, deadline), prob(prob),
+        mrt(*this), startII(startII), bestII(bestII) {}
+  LogicalResult initialize();
+  LogicalResult run();
   LogicalResult schedule() override;
+
+  /// Return the current II, e.g. after the initial solve.
+  unsigned getII() const { return parameterT; }
 };
 
 // This class solves the `ChainingProblem` by relying on pre-computed
@@ -499,11 +534,17 @@ void SimplexSchedulerBase::multiplyRow(unsigned row, int factor) {
   implicitBasicVariableColumnVector[row] *= factor;
 }
 
+/// Add \p factor times the \p sourceRow to the \p targetRow. Only the
+/// \p sourceColumns are visited, which must include all columns in which the
+/// source row has a non-zero entry.
 void SimplexSchedulerBase::addMultipleOfRow(unsigned sourceRow, int factor,
-                                            unsigned targetRow) {
+                                            unsigned targetRow,
+                                            ArrayRef<unsigned> sourceColumns) {
   assert(factor != 0 && sourceRow != targetRow);
-  for (unsigned col = 0; col < nColumns; ++col)
-    tableau[targetRow][col] += tableau[sourceRow][col] * factor;
+  auto &sourceRowVec = tableau[sourceRow];
+  auto &targetRowVec = tableau[targetRow];
+  for (unsigned col : sourceColumns)
+    targetRowVec[col] += sourceRowVec[col] * factor;
   // Again, perform row operation on the temporary column vector as well.
   implicitBasicVariableColumnVector[targetRow] +=
       implicitBasicVariableColumnVector[sourceRow] * factor;
@@ -524,6 +565,15 @@ void SimplexSchedulerBase::pivot(unsigned pivotRow, unsigned pivotColumn) {
   // Make `tableau[pivotRow][pivotColumn]` := 1
   multiplyRow(pivotRow, 1 / pivotElem);
 
+  // The constraint rows are sparse, as each dependence only involves two
+  // operations. Collect the non-zero entries of the pivot row once, so that the
+  // row operations below only need to visit these columns rather than the
+  // entire row.
+  SmallVector<unsigned> pivotRowColumns;
+  for (unsigned col = 0; col < nColumns; ++col)
+    if (tableau[pivotRow][col] != 0)
+      pivotRowColumns.push_back(col);
+
   for (unsigned row = 0; row < nRows; ++row) {
     if (row == pivotRow)
       continue;
@@ -533,7 +583,7 @@ void SimplexSchedulerBase::pivot(unsigned pivotRow, unsigned pivotColumn) {
       continue; // nothing to do
 
     // Make `tableau[row][pivotColumn]` := 0.
-    addMultipleOfRow(pivotRow, -elem, row);
+    addMultipleOfRow(pivotRow, -elem, row, pivotRowColumns);
   }
 
   // Swap the pivot column with the implicitly constructed column vector.
@@ -928,6 +978,9 @@ LogicalResult SharedOperatorsSimplexScheduler::schedule() {
     LLVM_DEBUG(dbgs() << "After scheduling " << startTimeVar
                       << " to t=" << candTime << ":\n";
                dumpTableau());
+
+    if (isPastDeadline())
+      return failure();
   }
 
   assert(parameterT == 0);
@@ -1155,13 +1208,15 @@ unsigned ModuloSimplexScheduler::computeResMinII() {
   return resMinII;
 }
 
-LogicalResult ModuloSimplexScheduler::schedule() {
+/// Build the tableau and solve the resource-free problem.
+LogicalResult ModuloSimplexScheduler::initialize() {
   if (failed(checkLastOp()))
     return failure();
 
   parameterS = 0;
   parameterT = computeResMinII();
   LLVM_DEBUG(dbgs() << "ResMinII = " << parameterT << "\n");
+  parameterT = std::max<int>(parameterT, startII);
   buildTableau();
   asapTimes.resize(startTimeLocations.size());
   alapTimes.resize(startTimeLocations.size());
@@ -1170,7 +1225,12 @@ LogicalResult ModuloSimplexScheduler::schedule() {
 
   if (failed(solveTableau()))
     return prob.getContainingOp()->emitError() << "problem is infeasible";
+  return success();
+}
 
+/// Iteratively schedule the operations subject to resource constraints. Fails
+/// only if the search has been cancelled.
+LogicalResult ModuloSimplexScheduler::run() {
   // Determine which operations are subject to resource constraints.
   auto &ops = prob.getOperations();
   for (auto *op : ops)
@@ -1198,6 +1258,9 @@ LogicalResult ModuloSimplexScheduler::schedule() {
 
     scheduleOperation(op);
     scheduled.push_back(op);
+
+    if (isCancelled())
+      return failure();
   }
 
   LLVM_DEBUG(dbgs() << "Final tableau:\n"; dumpTableau();
@@ -1212,6 +1275,12 @@ LogicalResult ModuloSimplexScheduler::schedule() {
   return success();
 }
 
+LogicalResult ModuloSimplexScheduler::schedule() {
+  if (failed(initialize()))
+    return failure();
+  return run();
+}
+
 //===----------------------------------------------------------------------===//
 // ChainingSimplexScheduler
 //===----------------------------------------------------------------------===//
@@ -1270,8 +1339,9 @@ LogicalResult scheduling::scheduleSimplex(CyclicProblem &prob,
 }
 
 LogicalResult scheduling::scheduleSimplex(SharedOperatorsProblem &prob,
-                                          Operation *lastOp) {
-  SharedOperatorsSimplexScheduler simplex(prob, lastOp);
+                                          Operation *lastOp,
+                                          Deadline deadline) {
+  SharedOperatorsSimplexScheduler simplex(prob, lastOp, deadline);
   return simplex.schedule();
 }
 
@@ -1281,6 +1351,79 @@ LogicalResult scheduling::scheduleSimplex(ModuloProblem &prob,
   return simplex.schedule();
 }
 
+LogicalResult scheduling::scheduleSimplex(ModuloProblem &prob,
+                                          Operation *lastOp,
+                                          unsigned numCandidateIIs,
+                                          Deadline deadline) {
+  if (numCandidateIIs <= 1) {
+    ModuloSimplexScheduler simplex(prob, lastOp, /*startII=*/1,
+                                   /*bestII=*/nullptr, deadline);
+    return simplex.schedule();
+  }
+
+  // Every candidate works on its own copy of the problem.
+  SmallVector<ModuloProblem> problems(numCandidateIIs, prob);
+  std::atomic<unsigned> bestII(std::numeric_limits<unsigned>::max());
+  SmallVector<std::unique_ptr<ModuloSimplexScheduler>> schedulers;
+
+  // The first candidate starts at the II of the resource-free solution. Its
+  // initialization is done upfront, as it reports any problems with the input.
+  // The other candidates only differ in their start II, so they cannot fail
+  // to initialize afterwards.
+  schedulers.push_back(std::make_unique<ModuloSimplexScheduler>(
+      problems[0], lastOp, /*startII=*/1, &bestII, deadline));
+  if (failed(schedulers[0]->initialize()))
+    return failure();
+  unsigned minII = schedulers[0]->getII();
+  for (unsigned i = 1; i < numCandidateIIs; ++i)
+    schedulers.push_back(std::make_unique<ModuloSimplexScheduler>(
+        problems[i], lastOp, minII + i, &bestII, deadline));
+
+  // Schedule all candidates concurrently. A candidate is abandoned once its II
+  // exceeds the best one found so far. Candidates that tie with the best II
+  // run to completion unless the deadline passes, so the result below does
+  // not depend on the order in which the candidates finish.
+  SmallVector<bool> found(numCandidateIIs, false);
+  mlir::parallelFor(
+      prob.getContainingOp()->getContext(), 0, numCandidateIIs, [&](size_t i) {
+        auto &simplex = *schedulers[i];
+        if (i != 0) {
+          auto initialized = simplex.initialize();
+          assert(succeeded(initialized));
+          (void)initialized;
+        }
+        if (failed(simplex.run())) {
+          LLVM_DEBUG(dbgs() << "Candidate II " << minII + i
+                            << " cancelled\n");
+          return;
+        }
+        found[i] = true;
+        unsigned ii = *problems[i].getInitiationInterval();
+        unsigned current = bestII.load();
+        while (ii < current && !bestII.compare_exchange_weak(current, ii))
+          ;
+        LLVM_DEBUG(dbgs() << "Candidate II " << minII + i
+                          << " found II = " << ii << "\n");
+      });
+
+  // Pick the candidate with the smallest II, preferring earlier ones on ties.
+  std::optional<unsigned> best;
+  for (unsigned i = 0; i < numCandidateIIs; ++i)
+    if (found[i] && (!best || *problems[i].getInitiationInterval() <
+                                  *problems[*best].getInitiationInterval()))
+      best = i;
+  if (!best) {
+    assert(deadline && "at least one candidate runs to completion");
+    return failure();
+  }
+
+  auto &bestProb = problems[*best];
+  prob.setInitiationInterval(*bestProb.getInitiationInterval());
+  for (auto *op : prob.getOperations())
+    prob.setStartTime(op, *bestProb.getStartTime(op));
+  return success();
+}
+
 LogicalResult scheduling::scheduleSimplex(ChainingProblem &prob,
                                           Operation *lastOp, float cycleTime) {
   ChainingSimplexScheduler simplex(prob, lastOp, cycleTime);
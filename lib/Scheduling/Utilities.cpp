@@ -21,8 +21,38 @@ using namespace circt::scheduling;
 LogicalResult scheduling::handleOperationsInTopologicalOrder(Problem &prob,
                                                              HandleOpFn fun) {
   auto &allOps = prob.getOperations();
+
+  // Start with the operations sorted topologically, such that all operations
+  // can be handled in the first attempt unless the graph contains cycles. The
+  // operations of any cycles, and the ones depending on them, are appended in
+  // their original order, and are then subject to the retry loop below.
+  DenseMap<Operation *, unsigned> numPreds;
+  DenseMap<Operation *, SmallVector<Operation *, 2>> succs;
+  for (auto *op : allOps) {
+    unsigned &num = numPreds[op];
+    for (auto &dep : prob.getDependences(op)) {
+      ++num;
+      succs[dep.getSource()].push_back(op);
+    }
+  }
+
   SmallVector<Operation *> unhandledOps;
-  unhandledOps.insert(unhandledOps.begin(), allOps.begin(), allOps.end());
+  unhandledOps.reserve(allOps.size());
+  for (auto *op : allOps)
+    if (numPreds[op] == 0)
+      unhandledOps.push_back(op);
+  for (unsigned i = 0; i < unhandledOps.size(); ++i) {
+    auto it = succs.find(unhandledOps[i]);
+    if (it == succs.end())
+      continue;
+    for (auto *succ : it->second)
+      if (--numPreds[succ] == 0)
+        unhandledOps.push_back(succ);
+  }
+  if (unhandledOps.size() != allOps.size())
+    for (auto *op : allOps)
+      if (numPreds[op] != 0)
+        unhandledOps.push_back(op);
 
   while (!unhandledOps.empty()) {
     // Remember how many unhandled operations we have at the beginning of this
@@ -16,10 +16,16 @@
 using namespace circt;
 
 APInt circt::sextZeroWidth(APInt value, unsigned width) {
+  // Avoid copying the value, which allocates for wide integers, if the width
+  // does not change.
+  if (value.getBitWidth() == width)
+    return value;
   return value.getBitWidth() ? value.sext(width) : value.zext(width);
 }
 
 APSInt circt::extOrTruncZeroWidth(APSInt value, unsigned width) {
+  if (value.getBitWidth() == width)
+    return value;
   return value.getBitWidth()
              ? value.extOrTrunc(width)
              : APSInt(value.zextOrTrunc(width), value.isUnsigned());
@@ -38,11 +38,15 @@ LogicalResult BackedgeBuilder::clearOrEmitError() {
   unsigned numInUse = 0;
   for (Operation *op : edges) {
     if (!op->use_empty()) {
-      auto diag = op->emitError("backedge of type `")
-                  << op->getResult(0).getType() << "`still in use";
-      for (auto user : op->getUsers())
-        diag.attachNote(user->getLoc()) << "used by " << *user;
-      ++numInUse;
+      for (auto result : op->getResults()) {
+        if (result.use_empty())
+          continue;
+        auto diag = op->emitError("backedge of type `")
+                    << result.getType() << "`still in use";
+        for (auto user : result.getUsers())
+          diag.attachNote(user->getLoc()) << "used by " << *user;
+        ++numInUse;
+      }
       continue;
     }
     if (rewriter)
@@ -70,3 +74,19 @@ Backedge BackedgeBuilder::get(Type t, mlir::LocationAttr optionalLoc) {
   edges.push_back(op);
   return Backedge(op);
 }
+
+SmallVector<Backedge> BackedgeBuilder::get(TypeRange resultTypes,
+                                           mlir::LocationAttr optionalLoc) {
+  SmallVector<Backedge> backedges;
+  if (resultTypes.empty())
+    return backedges;
+  if (!optionalLoc)
+    optionalLoc = loc;
+  Operation *op = builder.create<mlir::UnrealizedConversionCastOp>(
+      optionalLoc, resultTypes, ValueRange{});
+  edges.push_back(op);
+  backedges.reserve(resultTypes.size());
+  for (auto result : op->getResults())
+    backedges.push_back(Backedge(result));
+  return backedges;
+}
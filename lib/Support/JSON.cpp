@@ -11,8 +11,14 @@
 #include "mlir/IR/BuiltinTypes.h"
 #include "mlir/IR/Diagnostics.h"
 #include "mlir/IR/OperationSupport.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/ADT/TypeSwitch.h"
+#include "llvm/Support/ConvertUTF.h"
+#include <cerrno>
+#include <cmath>
+#include <limits>
 
 namespace json = llvm::json;
 
@@ -124,3 +130,356 @@ Attribute circt::convertJSONToAttribute(MLIRContext *context,
   llvm_unreachable("Impossible unhandled JSON type");
 }
 // NOLINTEND(misc-no-recursion)
+
+//===----------------------------------------------------------------------===//
+// Direct JSON-to-Attribute Parsing
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// A recursive descent JSON parser that produces MLIR attributes as it goes,
+/// instead of building an `llvm::json::Value` first.  This mirrors the grammar
+/// accepted by `llvm::json::parse` and the conversion performed by
+/// `convertJSONToAttribute`, such that the two always agree on the result.
+/// The parser does not produce diagnostics; it simply fails on malformed input.
+class JSONAttributeParser {
+public:
+  JSONAttributeParser(MLIRContext *context, StringRef text)
+      : context(context), ptr(text.begin()), end(text.end()) {}
+
+  /// Parse a single JSON value spanning the entire text. The text must be
+  /// valid UTF-8.
+  Attribute parseTopLevel();
+
+  /// Parse a top-level JSON array spanning the entire text, passing each of
+  /// its elements to `callback`. The text must be valid UTF-8.
+  LogicalResult
+  parseTopLevelArray(function_ref<LogicalResult(Attribute)> callback);
+
+private:
+  Attribute parseValue();
+  Attribute parseNumber();
+  Attribute parseObject();
+  Attribute parseArray();
+  Attribute convertString(StringRef str);
+  bool parseString(SmallVectorImpl<char> &storage, StringRef &result);
+  bool parseUnicode(SmallVectorImpl<char> &out);
+  bool parseHex4(uint16_t &result);
+
+  void skipWhitespace() {
+    while (ptr != end &&
+           (*ptr == ' ' || *ptr == '\r' || *ptr == '\n' || *ptr == '\t'))
+      ++ptr;
+  }
+  bool consume(char c) {
+    if (ptr == end || *ptr != c)
+      return false;
+    ++ptr;
+    return true;
+  }
+  bool consume(StringRef str) {
+    if (StringRef(ptr, end - ptr).startswith(str)) {
+      ptr += str.size();
+      return true;
+    }
+    return false;
+  }
+
+  MLIRContext *context;
+  const char *ptr;
+  const char *end;
+};
+} // namespace
+
+Attribute JSONAttributeParser::parseTopLevel() {
+  skipWhitespace();
+  auto attr = parseValue();
+  skipWhitespace();
+  if (ptr != end)
+    return {};
+  return attr;
+}
+
+LogicalResult JSONAttributeParser::parseTopLevelArray(
+    function_ref<LogicalResult(Attribute)> callback) {
+  skipWhitespace();
+  if (!consume('['))
+    return failure();
+  skipWhitespace();
+  if (!consume(']')) {
+    do {
+      skipWhitespace();
+      auto attr = parseValue();
+      if (!attr || failed(callback(attr)))
+        return failure();
+      skipWhitespace();
+    } while (consume(','));
+    if (!consume(']'))
+      return failure();
+  }
+  skipWhitespace();
+  return success(ptr == end);
+}
+
+// NOLINTBEGIN(misc-no-recursion)
+Attribute JSONAttributeParser::parseValue() {
+  if (ptr == end)
+    return {};
+  switch (*ptr) {
+  case 'n':
+    if (consume("null"))
+      return UnitAttr::get(context);
+    return {};
+  case 't':
+    if (consume("true"))
+      return BoolAttr::get(context, true);
+    return {};
+  case 'f':
+    if (consume("false"))
+      return BoolAttr::get(context, false);
+    return {};
+  case '"': {
+    SmallString<32> storage;
+    StringRef str;
+    if (!parseString(storage, str))
+      return {};
+    return convertString(str);
+  }
+  case '[':
+    return parseArray();
+  case '{':
+    return parseObject();
+  default:
+    return parseNumber();
+  }
+}
+
+Attribute JSONAttributeParser::parseArray() {
+  ++ptr;
+  SmallVector<Attribute> elements;
+  skipWhitespace();
+  if (consume(']'))
+    return ArrayAttr::get(context, elements);
+  do {
+    skipWhitespace();
+    auto attr = parseValue();
+    if (!attr)
+      return {};
+    elements.push_back(attr);
+    skipWhitespace();
+  } while (consume(','));
+  if (!consume(']'))
+    return {};
+  return ArrayAttr::get(context, elements);
+}
+
+Attribute JSONAttributeParser::parseObject() {
+  ++ptr;
+  NamedAttrList fields;
+  skipWhitespace();
+  if (consume('}'))
+    return DictionaryAttr::get(context, fields);
+  do {
+    skipWhitespace();
+    SmallString<32> storage;
+    StringRef key;
+    if (ptr == end || *ptr != '"' || !parseString(storage, key))
+      return {};
+    auto name = StringAttr::get(context, key);
+    skipWhitespace();
+    if (!consume(':'))
+      return {};
+    skipWhitespace();
+    auto attr = parseValue();
+    if (!attr)
+      return {};
+    fields.append(name, attr);
+    skipWhitespace();
+  } while (consume(','));
+  if (!consume('}'))
+    return {};
+  // Duplicate keys cannot be represented in a dictionary. Leave them to the
+  // JSON library to handle.
+  if (fields.findDuplicate())
+    return {};
+  return DictionaryAttr::get(context, fields);
+}
+
+/// Convert a parsed string to an attribute. Strings that themselves contain
+/// JSON, other than a plain number, are unquoted and converted recursively.
+/// See `convertJSONToAttribute` for the rationale.
+Attribute JSONAttributeParser::convertString(StringRef str) {
+  if (auto attr = JSONAttributeParser(context, str).parseTopLevel())
+    if (!attr.isa<IntegerAttr, FloatAttr>())
+      return attr;
+  return StringAttr::get(context, str);
+}
+// NOLINTEND(misc-no-recursion)
+
+/// Parse a number the same way `llvm::json::parse` does. Numbers that are
+/// integral and fit into 64 bits become integers, everything else becomes a
+/// double.
+Attribute JSONAttributeParser::parseNumber() {
+  auto isNumberChar = [](char c) {
+    return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' ||
+           c == 'e' || c == 'E';
+  };
+  SmallString<24> str;
+  while (ptr != end && isNumberChar(*ptr))
+    str.push_back(*ptr++);
+  if (str.empty())
+    return {};
+  auto i64Type = IntegerType::get(context, 64);
+
+  char *numEnd;
+  errno = 0;
+  int64_t intValue = std::strtoll(str.c_str(), &numEnd, 10);
+  if (numEnd == str.end() && errno != ERANGE)
+    return IntegerAttr::get(i64Type, intValue);
+
+  double value;
+  errno = 0;
+  uint64_t uintValue = std::strtoull(str.c_str(), &numEnd, 10);
+  if (str[0] != '-' && numEnd == str.end() && errno != ERANGE) {
+    value = uintValue;
+  } else {
+    value = std::strtod(str.c_str(), &numEnd);
+    if (numEnd != str.end())
+      return {};
+  }
+
+  double intPart;
+  if (std::modf(value, &intPart) == 0.0 &&
+      value >= double(std::numeric_limits<int64_t>::min()) &&
+      value <= double(std::numeric_limits<int64_t>::max()))
+    return IntegerAttr::get(i64Type, int64_t(value));
+  return FloatAttr::get(mlir::FloatType::getF64(context), value);
+}
+
+/// Parse a quoted string. If the string contains no escape sequences, `result`
+/// points directly into the parsed text; otherwise it points into `storage`.
+bool JSONAttributeParser::parseString(SmallVectorImpl<char> &storage,
+                                      StringRef &result) {
+  ++ptr;
+  const char *start = ptr;
+  while (ptr != end && *ptr != '"' && *ptr != '\\') {
+    if (static_cast<unsigned char>(*ptr) < 0x20)
+      return false;
+    ++ptr;
+  }
+  if (ptr == end)
+    return false;
+  if (*ptr == '"') {
+    result = StringRef(start, ptr - start);
+    ++ptr;
+    return true;
+  }
+
+  // Slow path for strings with escape sequences.
+  storage.assign(start, ptr);
+  while (ptr != end && *ptr != '"') {
+    char c = *ptr++;
+    if (static_cast<unsigned char>(c) < 0x20)
+      return false;
+    if (c != '\\') {
+      storage.push_back(c);
+      continue;
+    }
+    if (ptr == end)
+      return false;
+    switch (*ptr++) {
+    case '"':
+    case '\\':
+    case '/':
+      storage.push_back(ptr[-1]);
+      break;
+    case 'b':
+      storage.push_back('\b');
+      break;
+    case 'f':
+      storage.push_back('\f');
+      break;
+    case 'n':
+      storage.push_back('\n');
+      break;
+    case 'r':
+      storage.push_back('\r');
+      break;
+    case 't':
+      storage.push_back('\t');
+      break;
+    case 'u':
+      if (!parseUnicode(storage))
+        return false;
+      break;
+    default:
+      return false;
+    }
+  }
+  if (!consume('"'))
+    return false;
+  result = StringRef(storage.data(), storage.size());
+  return true;
+}
+
+bool JSONAttributeParser::parseHex4(uint16_t &result) {
+  if (end - ptr < 4)
+    return false;
+  result = 0;
+  for (unsigned i = 0; i < 4; ++i) {
+    char c = *ptr++;
+    unsigned digit = llvm::hexDigitValue(c);
+    if (digit == -1U)
+      return false;
+    result = (result << 4) | digit;
+  }
+  return true;
+}
+
+/// Decode a `\uXXXX` escape, following surrogate pairs. Unpaired surrogates
+/// are replaced with U+FFFD, as `llvm::json::parse` does.
+bool JSONAttributeParser::parseUnicode(SmallVectorImpl<char> &out) {
+  auto append = [&](unsigned codePoint) {
+    char buffer[UNI_MAX_UTF8_BYTES_PER_CODE_POINT];
+    char *bufferPtr = buffer;
+    llvm::ConvertCodePointToUTF8(codePoint, bufferPtr);
+    out.append(buffer, bufferPtr);
+  };
+  uint16_t first;
+  if (!parseHex4(first))
+    return false;
+  while (true) {
+    if (first < 0xD800 || first >= 0xE000) {
+      append(first);
+      return true;
+    }
+    if (first >= 0xDC00 || end - ptr < 2 || ptr[0] != '\\' || ptr[1] != 'u') {
+      append(0xFFFD);
+      return true;
+    }
+    ptr += 2;
+    uint16_t second;
+    if (!parseHex4(second))
+      return false;
+    if (second < 0xDC00 || second >= 0xE000) {
+      append(0xFFFD);
+      first = second;
+      continue;
+    }
+    append(0x10000 | ((first - 0xD800) << 10) | (second - 0xDC00));
+    return true;
+  }
+}
+
+Attribute circt::parseJSONToAttribute(MLIRContext *context, StringRef text) {
+  if (!json::isUTF8(text))
+    return {};
+  return JSONAttributeParser(context, text).parseTopLevel();
+}
+
+LogicalResult circt::parseJSONArrayToAttributes(
+    MLIRContext *context, StringRef text,
+    function_ref<LogicalResult(Attribute)> callback) {
+  if (!json::isUTF8(text))
+    return failure();
+  return JSONAttributeParser(context, text).parseTopLevelArray(callback);
+}
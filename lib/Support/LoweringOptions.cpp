@@ -117,6 +117,8 @@ void LoweringOptions::parse(StringRef text, ErrorHandlerT errorHandler) {
       emitBindComments = true;
     } else if (option == "omitVersionComment") {
       omitVersionComment = true;
+    } else if (option == "emitSharedLTLDeclarations") {
+      emitSharedLTLDeclarations = true;
     } else {
       errorHandler(llvm::Twine("unknown style option \'") + option + "\'");
       // We continue parsing options after a failure.
@@ -172,6 +174,8 @@ std::string LoweringOptions::toString() const {
     options += "emitBindComments,";
   if (omitVersionComment)
     options += "omitVersionComment,";
+  if (emitSharedLTLDeclarations)
+    options += "emitSharedLTLDeclarations,";
 
   // Remove a trailing comma if present.
   if (!options.empty()) {
@@ -7,8 +7,17 @@
 //===----------------------------------------------------------------------===//
 
 #include "circt/Support/Passes.h"
+#include "mlir/IR/SymbolTable.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
 #include "mlir/Transforms/Passes.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/Process.h"
+
+#ifdef LLVM_ON_UNIX
+#include <sys/resource.h>
+#endif
 
 using namespace circt;
 
@@ -18,3 +27,178 @@ std::unique_ptr<Pass> circt::createSimpleCanonicalizerPass() {
   config.enableRegionSimplification = false;
   return mlir::createCanonicalizerPass(config);
 }
+
+//===----------------------------------------------------------------------===//
+// PassPerfReport
+//===----------------------------------------------------------------------===//
+
+/// Return the peak resident set size of the process in bytes, or 0 if it is
+/// not available.
+static uint64_t getPeakRSS() {
+#ifdef LLVM_ON_UNIX
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+#ifdef __APPLE__
+  return usage.ru_maxrss;
+#else
+  return uint64_t(usage.ru_maxrss) * 1024;
+#endif
+#else
+  return 0;
+#endif
+}
+
+/// Return the CPU time spent by all threads of the process.
+static std::chrono::nanoseconds getCPUTime() {
+  llvm::sys::TimePoint<> elapsed;
+  std::chrono::nanoseconds user, sys;
+  llvm::sys::Process::GetTimeUsage(elapsed, user, sys);
+  return user + sys;
+}
+
+static size_t countOps(Operation *op) {
+  size_t numOps = 0;
+  op->walk([&](Operation *) { ++numOps; });
+  return numOps;
+}
+
+namespace {
+/// Records the executions of passes into a `PassPerfReport`.
+class PerfReportInstrumentation : public mlir::PassInstrumentation {
+public:
+  PerfReportInstrumentation(PassPerfReport &report) : report(report) {}
+
+  void runBeforePass(Pass *pass, Operation *op) override;
+  void runAfterPass(Pass *pass, Operation *op) override {
+    finish(pass, op, /*failed=*/false);
+  }
+  void runAfterPassFailed(Pass *pass, Operation *op) override {
+    finish(pass, op, /*failed=*/true);
+  }
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  /// The measurements taken at the start of an execution.
+  struct Start {
+    Clock::time_point wallTime;
+    std::chrono::nanoseconds cpuTime;
+    size_t mallocUsage;
+    size_t numOps;
+    bool exclusive;
+  };
+
+  void finish(Pass *pass, Operation *op, bool failed);
+
+  PassPerfReport &report;
+
+  /// The executions which are currently running.
+  std::mutex mutex;
+  llvm::DenseMap<std::pair<Pass *, Operation *>, Start> running;
+};
+} // namespace
+
+void PerfReportInstrumentation::runBeforePass(Pass *pass, Operation *op) {
+  Start start;
+  start.numOps = countOps(op);
+  start.exclusive = true;
+  {
+    // Any running execution which does not contain this one runs concurrently
+    // with it.
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto &[key, other] : running) {
+      if (key.second->isAncestor(op))
+        continue;
+      other.exclusive = false;
+      start.exclusive = false;
+    }
+    start.mallocUsage = llvm::sys::Process::GetMallocUsage();
+    start.cpuTime = getCPUTime();
+    start.wallTime = Clock::now();
+    running.insert({{pass, op}, start});
+  }
+}
+
+void PerfReportInstrumentation::finish(Pass *pass, Operation *op,
+                                       bool failed) {
+  auto wallTime = Clock::now();
+  auto cpuTime = getCPUTime();
+  size_t mallocUsage = llvm::sys::Process::GetMallocUsage();
+
+  Start start;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = running.find({pass, op});
+    assert(it != running.end() && "pass finished without starting");
+    start = it->second;
+    running.erase(it);
+  }
+
+  PassPerfReport::Execution execution;
+  execution.pass = pass->getArgument().empty() ? pass->getName().str()
+                                               : pass->getArgument().str();
+  execution.opName = op->getName().getStringRef().str();
+  if (auto symName = op->getAttrOfType<StringAttr>(
+          mlir::SymbolTable::getSymbolAttrName()))
+    execution.symName = symName.getValue().str();
+  execution.failed = failed;
+  execution.wallTime =
+      std::chrono::duration<double>(wallTime - start.wallTime).count();
+  execution.numOpsBefore = start.numOps;
+  execution.numOpsAfter = countOps(op);
+  execution.exclusive = start.exclusive;
+  if (start.exclusive) {
+    execution.cpuTime =
+        std::chrono::duration<double>(cpuTime - start.cpuTime).count();
+    auto numThreads = op->getContext()->isMultithreadingEnabled()
+                          ? op->getContext()->getNumThreads()
+                          : 1;
+    if (execution.wallTime > 0)
+      execution.parallelEfficiency =
+          execution.cpuTime / (execution.wallTime * numThreads);
+    execution.mallocDelta = int64_t(mallocUsage) - int64_t(start.mallocUsage);
+    execution.peakRSS = getPeakRSS();
+  }
+  report.addExecution(std::move(execution));
+}
+
+std::unique_ptr<mlir::PassInstrumentation>
+PassPerfReport::createInstrumentation() {
+  return std::make_unique<PerfReportInstrumentation>(*this);
+}
+
+void PassPerfReport::addExecution(Execution execution) {
+  std::lock_guard<std::mutex> lock(mutex);
+  executions.push_back(std::move(execution));
+}
+
+void PassPerfReport::print(llvm::raw_ostream &os) {
+  std::lock_guard<std::mutex> lock(mutex);
+  llvm::json::OStream json(os, 2);
+  json.object([&] {
+    json.attributeArray("passes", [&] {
+      for (auto &execution : executions) {
+        json.object([&] {
+          json.attribute("pass", execution.pass);
+          json.attribute("op", execution.opName);
+          if (!execution.symName.empty())
+            json.attribute("symName", execution.symName);
+          json.attribute("failed", execution.failed);
+          json.attribute("wallTime", execution.wallTime);
+          json.attribute("numOpsBefore", int64_t(execution.numOpsBefore));
+          json.attribute("numOpsAfter", int64_t(execution.numOpsAfter));
+          json.attribute("exclusive", execution.exclusive);
+          if (!execution.exclusive)
+            return;
+          json.attribute("cpuTime", execution.cpuTime);
+          json.attribute("parallelEfficiency", execution.parallelEfficiency);
+          json.attribute("mallocDelta", execution.mallocDelta);
+          if (execution.peakRSS)
+            json.attribute("peakRSS", int64_t(execution.peakRSS));
+        });
+      }
+    });
+  });
+  os << "\n";
+}
@@ -97,10 +97,15 @@ void PrettyPrinter::add(Token t) {
         checkStream();
       })
       .Case([&](BreakToken *b) {
+        if (!scanStack.empty()) {
+          checkStack();
+          // If this resolved the sizes of everything buffered, print it now
+          // rather than holding on to it until the line overflows.
+          if (scanStack.empty() && !tokens.empty())
+            advanceLeft();
+        }
         if (scanStack.empty())
           clear();
-        else
-          checkStack();
         addScanToken(-rightTotal);
         rightTotal += b->spaces();
         assert(rightTotal > 0);
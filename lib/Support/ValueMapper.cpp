@@ -14,6 +14,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "circt/Support/ValueMapper.h"
+#include "llvm/ADT/SetVector.h"
 
 using namespace mlir;
 using namespace circt;
@@ -37,7 +38,20 @@ mlir::Value ValueMapper::get(Value from, TypeTransformer typeTransformer) {
 
 llvm::SmallVector<Value> ValueMapper::get(ValueRange from,
                                           TypeTransformer typeTransformer) {
+  // Create the backedges for all values without a mapping at once.
+  if (bb) {
+    llvm::SetVector<Value> unmapped;
+    llvm::SmallVector<Type> types;
+    for (auto f : from)
+      if (!mapping.count(f) && unmapped.insert(f))
+        types.push_back(typeTransformer(f.getType()));
+    if (unmapped.size() > 1)
+      for (auto [f, backedge] : llvm::zip(unmapped, bb->get(types)))
+        mapping[f] = backedge;
+  }
+
   llvm::SmallVector<Value> to;
+  to.reserve(from.size());
   for (auto f : from)
     to.push_back(get(f, typeTransformer));
   return to;
@@ -301,6 +301,15 @@ public:
     return impl->nativeOpSpecificPatternMap;
   }
 
+  /// Return the native patterns registered for the given key in the order they
+  /// were added. This does not copy the pattern list.
+  ArrayRef<PatternTy *> getSpecificNativePatterns(KeyTy key) const {
+    auto it = impl->nativeOpSpecificPatternMap.find(key);
+    if (it == impl->nativeOpSpecificPatternMap.end())
+      return {};
+    return it->second;
+  }
+
 private:
   /// The internal implementation of the frozen pattern set.
   struct Impl {
@@ -17,8 +17,7 @@ using namespace circt::ExportSystemC;
 
 void EmissionPrinter::emitOp(Operation *op) {
   currentLoc = op->getLoc();
-  auto patterns = opPatterns.getSpecificNativePatterns().lookup(op->getName());
-  for (auto *pat : patterns) {
+  for (auto *pat : opPatterns.getSpecificNativePatterns(op->getName())) {
     if (pat->matchStatement(op)) {
       pat->emitStatement(op, *this);
       return;
@@ -34,14 +33,21 @@ void EmissionPrinter::emitOp(Operation *op) {
 }
 
 void EmissionPrinter::emitType(Type type) {
-  auto patterns =
-      typePatterns.getSpecificNativePatterns().lookup(type.getTypeID());
-  for (auto *pat : patterns) {
-    if (pat->match(type)) {
-      pat->emitType(type, *this);
-      return;
+  // Types are uniqued and the patterns only match on the type itself, such that
+  // the pattern found for a type can be reused for all later emissions of it.
+  auto [it, inserted] = typePatternCache.insert({type, nullptr});
+  if (inserted) {
+    for (auto *pat : typePatterns.getSpecificNativePatterns(type.getTypeID())) {
+      if (pat->match(type)) {
+        it->second = pat;
+        break;
+      }
     }
   }
+  if (auto *pat = it->second) {
+    pat->emitType(type, *this);
+    return;
+  }
 
   // Emit a placeholder to the output and an error to stderr in case no valid
   // emission pattern was found.
@@ -52,14 +58,20 @@ void EmissionPrinter::emitType(Type type) {
 }
 
 void EmissionPrinter::emitAttr(Attribute attr) {
-  auto patterns =
-      attrPatterns.getSpecificNativePatterns().lookup(attr.getTypeID());
-  for (auto *pat : patterns) {
-    if (pat->match(attr)) {
-      pat->emitAttr(attr, *this);
-      return;
+  // Attributes are uniqued as well, see 'emitType'.
+  auto [it, inserted] = attrPatternCache.insert({attr, nullptr});
+  if (inserted) {
+    for (auto *pat : attrPatterns.getSpecificNativePatterns(attr.getTypeID())) {
+      if (pat->match(attr)) {
+        it->second = pat;
+        break;
+      }
     }
   }
+  if (auto *pat = it->second) {
+    pat->emitAttr(attr, *this);
+    return;
+  }
 
   mlir::emitError(currentLoc, "no emission pattern found for attribute ")
       << attr << "\n";
@@ -72,8 +84,7 @@ InlineEmitter EmissionPrinter::getInlinable(Value value) {
                                         : value.getDefiningOp();
   Location requestLoc = currentLoc;
   currentLoc = op->getLoc();
-  auto patterns = opPatterns.getSpecificNativePatterns().lookup(op->getName());
-  for (auto *pat : patterns) {
+  for (auto *pat : opPatterns.getSpecificNativePatterns(op->getName())) {
     MatchResult match = pat->matchInlinable(value);
     if (!match.failed()) {
       return InlineEmitter([=]() { pat->emitInlined(value, *this); },
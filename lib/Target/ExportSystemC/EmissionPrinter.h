@@ -119,6 +119,11 @@ private:
   mlir::raw_indented_ostream &os;
   bool emissionFailed;
   Location currentLoc;
+
+  /// The pattern found for each type and attribute emitted so far, or null if
+  /// none matched.
+  DenseMap<Type, TypeEmissionPatternBase *> typePatternCache;
+  DenseMap<Attribute, AttrEmissionPatternBase *> attrPatternCache;
 };
 
 /// This class is returned to a pattern that requested inlined emission of a
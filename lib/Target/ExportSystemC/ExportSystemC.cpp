@@ -12,12 +12,16 @@
 
 #include "circt/Target/ExportSystemC.h"
 #include "EmissionPrinter.h"
+#include "Patterns/EvalModelEmissionPatterns.h"
 #include "RegisterAllEmitters.h"
 #include "circt/Dialect/Comb/CombDialect.h"
 #include "circt/Dialect/HW/HWDialect.h"
+#include "circt/Dialect/Seq/SeqDialect.h"
 #include "circt/Dialect/SystemC/SystemCDialect.h"
 #include "mlir/Dialect/EmitC/IR/EmitC.h"
 #include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/Diagnostics.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/Support/FileUtilities.h"
 #include "mlir/Tools/mlir-translate/Translation.h"
 #include "llvm/Support/FileSystem.h"
@@ -41,33 +45,93 @@ static std::string pathToMacroName(StringRef path) {
   return std::regex_replace(str, std::regex("[^a-zA-Z0-9_$]+"), "");
 }
 
+namespace {
+/// The emission patterns of all supported dialects. These are collected and
+/// frozen once and then shared by all printers, also across threads.
+struct FrozenEmissionPatterns {
+  FrozenOpEmissionPatternSet opPatterns;
+  FrozenTypeEmissionPatternSet typePatterns;
+  FrozenAttrEmissionPatternSet attrPatterns;
+};
+} // namespace
+
+/// Collects the emission patterns of all supported dialects. If an eval model
+/// state is passed, HW modules are emitted as kernel-free evaluation models.
+static FrozenEmissionPatterns
+getEmissionPatterns(MLIRContext *context,
+                    EvalModelState *evalModel = nullptr) {
+  OpEmissionPatternSet opPatterns;
+  TypeEmissionPatternSet typePatterns;
+  if (evalModel) {
+    populateEvalModelOpEmitters(opPatterns, context, *evalModel);
+    populateEvalModelTypeEmitters(typePatterns);
+  }
+  registerAllOpEmitters(opPatterns, context);
+  registerAllTypeEmitters(typePatterns);
+  AttrEmissionPatternSet attrPatterns;
+  registerAllAttrEmitters(attrPatterns);
+  return {std::move(opPatterns), std::move(typePatterns),
+          std::move(attrPatterns)};
+}
+
 /// Emits the given operation to a file represented by the passed ostream and
-/// file-path.
+/// file-path. The children of builtin modules are independent of each other.
+/// If `parallelize` is set, they are emitted into separate buffers on the
+/// thread pool of the context, which are then written out in order.
 static LogicalResult emitFile(ArrayRef<Operation *> operations,
-                              StringRef filePath, raw_ostream &os) {
+                              StringRef filePath, raw_ostream &os,
+                              const FrozenEmissionPatterns &patterns,
+                              bool parallelize, bool evalModel = false) {
   mlir::raw_indented_ostream ios(os);
 
   ios << "// " << filePath << "\n";
   std::string macroname = pathToMacroName(filePath);
   ios << "#ifndef " << macroname << "\n";
   ios << "#define " << macroname << "\n\n";
+  if (evalModel)
+    ios << "#include <cstdint>\n";
 
-  bool failed = false;
+  SmallVector<Operation *> ops;
+  for (auto *op : operations) {
+    if (auto module = dyn_cast<ModuleOp>(op)) {
+      for (Operation &child : *module.getBody())
+        ops.push_back(&child);
+      continue;
+    }
+    ops.push_back(op);
+  }
 
-  if (!operations.empty()) {
-    OpEmissionPatternSet opPatterns;
-    registerAllOpEmitters(opPatterns, operations[0]->getContext());
-    TypeEmissionPatternSet typePatterns;
-    registerAllTypeEmitters(typePatterns);
-    AttrEmissionPatternSet attrPatterns;
-    registerAllAttrEmitters(attrPatterns);
-    EmissionPrinter printer(ios, opPatterns, typePatterns, attrPatterns,
-                            operations[0]->getLoc());
+  bool failed = false;
 
-    for (auto *op : operations)
-      printer.emitOp(op);
+  if (!ops.empty()) {
+    MLIRContext *context = ops[0]->getContext();
+    if (parallelize && ops.size() > 1 && context->isMultithreadingEnabled()) {
+      // Diagnostics are reported in the order of the operations.
+      mlir::ParallelDiagnosticHandler diagHandler(context);
+      SmallVector<std::string> buffers(ops.size());
+      SmallVector<char> opFailed(ops.size());
+      mlir::parallelFor(context, 0, ops.size(), [&](size_t i) {
+        diagHandler.setOrderIDForThread(i);
+        llvm::raw_string_ostream bufferStream(buffers[i]);
+        mlir::raw_indented_ostream bufferIos(bufferStream);
+        EmissionPrinter printer(bufferIos, patterns.opPatterns,
+                                patterns.typePatterns, patterns.attrPatterns,
+                                ops[i]->getLoc());
+        printer.emitOp(ops[i]);
+        opFailed[i] = printer.exitState().failed();
+        diagHandler.eraseOrderIDForThread();
+      });
 
-    failed = printer.exitState().failed();
+      for (auto &buffer : buffers)
+        ios << buffer;
+      failed = llvm::is_contained(opFailed, true);
+    } else {
+      EmissionPrinter printer(ios, patterns.opPatterns, patterns.typePatterns,
+                              patterns.attrPatterns, ops[0]->getLoc());
+      for (auto *op : ops)
+        printer.emitOp(op);
+      failed = printer.exitState().failed();
+    }
   }
 
   ios << "\n#endif // " << macroname << "\n\n";
@@ -75,13 +139,52 @@ static LogicalResult emitFile(ArrayRef<Operation *> operations,
   return failure(failed);
 }
 
+/// Emits the given symbol along with the includes to a file named after the
+/// symbol in the given directory.
+static LogicalResult emitSplitFile(mlir::SymbolOpInterface symbolOp,
+                                   ArrayRef<Operation *> includes,
+                                   StringRef directory,
+                                   const FrozenEmissionPatterns &patterns) {
+  // Open or create the output file.
+  std::string fileName = symbolOp.getName().str() + ".h";
+  SmallString<128> filePath(directory);
+  llvm::sys::path::append(filePath, fileName);
+  std::string errorMessage;
+  auto output = mlir::openOutputFile(filePath, &errorMessage);
+  if (!output)
+    return symbolOp->emitError(errorMessage);
+
+  // Emit the content to the file.
+  SmallVector<Operation *> opsInThisFile(includes);
+  opsInThisFile.push_back(symbolOp);
+  if (failed(emitFile(opsInThisFile, filePath, output->os(), patterns,
+                      /*parallelize=*/false)))
+    return symbolOp->emitError("failed to emit to file \"")
+           << filePath << "\"";
+
+  // Do not delete the file if emission was successful.
+  output->keep();
+  return success();
+}
+
 //===----------------------------------------------------------------------===//
 // Unified and Split Emitter implementation
 //===----------------------------------------------------------------------===//
 
 LogicalResult ExportSystemC::exportSystemC(ModuleOp module,
                                            llvm::raw_ostream &os) {
-  return emitFile({module}, "stdout.h", os);
+  return emitFile({module}, "stdout.h", os,
+                  getEmissionPatterns(module.getContext()),
+                  /*parallelize=*/true);
+}
+
+LogicalResult ExportSystemC::exportEvalModel(ModuleOp module,
+                                             llvm::raw_ostream &os) {
+  // The patterns of the eval model share state and cannot run in parallel.
+  EvalModelState state;
+  return emitFile({module}, "stdout.h", os,
+                  getEmissionPatterns(module.getContext(), &state),
+                  /*parallelize=*/false, /*evalModel=*/true);
 }
 
 LogicalResult ExportSystemC::exportSplitSystemC(ModuleOp module,
@@ -90,35 +193,30 @@ LogicalResult ExportSystemC::exportSplitSystemC(ModuleOp module,
   SmallVector<Operation *> includes;
   module->walk([&](mlir::emitc::IncludeOp op) { includes.push_back(op); });
 
-  for (Operation &op : module.getRegion().front()) {
-    if (auto symbolOp = dyn_cast<mlir::SymbolOpInterface>(op)) {
-      // Create the output directory if needed.
-      if (std::error_code error = llvm::sys::fs::create_directories(directory))
-        return module.emitError("cannot create output directory \"")
-               << directory << "\": " << error.message();
-
-      // Open or create the output file.
-      std::string fileName = symbolOp.getName().str() + ".h";
-      SmallString<128> filePath(directory);
-      llvm::sys::path::append(filePath, fileName);
-      std::string errorMessage;
-      auto output = mlir::openOutputFile(filePath, &errorMessage);
-      if (!output)
-        return module.emitError(errorMessage);
-
-      // Emit the content to the file.
-      SmallVector<Operation *> opsInThisFile(includes);
-      opsInThisFile.push_back(symbolOp);
-      if (failed(emitFile(opsInThisFile, filePath, output->os())))
-        return symbolOp->emitError("failed to emit to file \"")
-               << filePath << "\"";
-
-      // Do not delete the file if emission was successful.
-      output->keep();
-    }
-  }
+  SmallVector<mlir::SymbolOpInterface> symbolOps;
+  for (Operation &op : module.getRegion().front())
+    if (auto symbolOp = dyn_cast<mlir::SymbolOpInterface>(op))
+      symbolOps.push_back(symbolOp);
+  if (symbolOps.empty())
+    return success();
 
-  return success();
+  // Create the output directory if needed.
+  if (std::error_code error = llvm::sys::fs::create_directories(directory))
+    return module.emitError("cannot create output directory \"")
+           << directory << "\": " << error.message();
+
+  // The files are independent of each other and emitted in parallel.
+  auto patterns = getEmissionPatterns(module.getContext());
+  mlir::ParallelDiagnosticHandler diagHandler(module.getContext());
+  SmallVector<char> fileFailed(symbolOps.size());
+  mlir::parallelFor(module.getContext(), 0, symbolOps.size(), [&](size_t i) {
+    diagHandler.setOrderIDForThread(i);
+    fileFailed[i] =
+        failed(emitSplitFile(symbolOps[i], includes, directory, patterns));
+    diagHandler.eraseOrderIDForThread();
+  });
+
+  return failure(llvm::is_contained(fileFailed, true));
 }
 
 //===----------------------------------------------------------------------===//
@@ -141,6 +239,16 @@ void ExportSystemC::registerExportSystemCTranslation() {
                         systemc::SystemCDialect, mlir::emitc::EmitCDialect>();
       });
 
+  static mlir::TranslateFromMLIRRegistration toEvalModel(
+      "export-systemc-eval", "export a kernel-free C++ eval model",
+      [](ModuleOp module, raw_ostream &output) {
+        return ExportSystemC::exportEvalModel(module, output);
+      },
+      [](mlir::DialectRegistry &registry) {
+        registry.insert<hw::HWDialect, comb::CombDialect, seq::SeqDialect,
+                        mlir::emitc::EmitCDialect>();
+      });
+
   static mlir::TranslateFromMLIRRegistration toSplitSystemC(
       "export-split-systemc", "export SystemC (split)",
       [](ModuleOp module, raw_ostream &output) {
@@ -0,0 +1,811 @@
+//===- EvalModelEmissionPatterns.cpp - Eval Model Emission Patterns -------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This implements the emission patterns of the kernel-free evaluation model.
+// Every flat HW module is emitted as a plain C++ struct holding its ports and
+// registers, and an 'eval' function that advances the registers on the rising
+// edges of their clocks and settles the combinational logic afterwards. No
+// simulation kernel is required to run the model.
+//
+//===----------------------------------------------------------------------===//
+
+#include "EvalModelEmissionPatterns.h"
+#include "../EmissionPrinter.h"
+#include "circt/Dialect/Comb/CombOps.h"
+#include "circt/Dialect/HW/HWOps.h"
+#include "circt/Dialect/Seq/SeqOps.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringSet.h"
+
+using namespace mlir;
+using namespace circt;
+using namespace circt::ExportSystemC;
+
+//===----------------------------------------------------------------------===//
+// Utilities.
+//===----------------------------------------------------------------------===//
+
+/// Integers of up to 64 bits are held in the smallest native unsigned integer
+/// type they fit into. Wider types are not supported.
+static bool isSupportedType(Type type) {
+  auto intType = type.dyn_cast<IntegerType>();
+  return intType && intType.getWidth() > 0 && intType.getWidth() <= 64;
+}
+
+static unsigned getWidth(Value value) {
+  return value.getType().getIntOrFloatBitWidth();
+}
+
+/// Returns whether C++ arithmetic on the native type holding a value of the
+/// given width wraps around like the hardware does. Narrower types are promoted
+/// to 'int' and have to be truncated explicitly.
+static bool wrapsNatively(unsigned width) { return width == 32 || width == 64; }
+
+/// Returns an unsigned integer literal with the lowest `width` bits set.
+static std::string getMaskLiteral(unsigned width) {
+  SmallString<24> str("0x");
+  APInt::getLowBitsSet(64, width).toString(str, 16, /*Signed=*/false);
+  str += width > 32 ? "ull" : "u";
+  return std::string(str);
+}
+
+/// Emits the given value sign-extended to a native signed integer type.
+static void emitSignExtended(Value value, EmissionPrinter &p) {
+  unsigned width = getWidth(value);
+  if (width == 8 || width == 16 || width == 32 || width == 64) {
+    p << "int" << width << "_t(";
+    p.getInlinable(value).emit();
+    p << ")";
+    return;
+  }
+
+  unsigned shift = 64 - width;
+  p << "(int64_t(uint64_t(";
+  p.getInlinable(value).emit();
+  p << ") << " << shift << ") >> " << shift << ")";
+}
+
+/// Emits the expression produced by `emitExpr` truncated to the given width.
+/// This is used for expressions on sign-extended operands.
+static void emitTruncated(unsigned width, EmissionPrinter &p,
+                          llvm::function_ref<void()> emitExpr) {
+  p << "uint64_t(";
+  emitExpr();
+  p << ")";
+  if (width < 64)
+    p << " & " << getMaskLiteral(width);
+}
+
+static Precedence getTruncatedPrecedence(unsigned width) {
+  return width < 64 ? Precedence::BITWISE_AND : Precedence::FUNCTIONAL_CAST;
+}
+
+/// Emits the concatenation of the given values, the first one being the most
+/// significant.
+static void emitConcatenation(ArrayRef<Value> operands, EmissionPrinter &p) {
+  unsigned shift = 0;
+  for (Value operand : operands)
+    shift += getWidth(operand);
+
+  llvm::interleave(
+      operands,
+      [&](Value operand) {
+        shift -= getWidth(operand);
+        if (shift == 0) {
+          p.getInlinable(operand).emitWithParensOnLowerPrecedence(
+              Precedence::BITWISE_OR);
+          return;
+        }
+        p << "(uint64_t(";
+        p.getInlinable(operand).emit();
+        p << ") << " << shift << ")";
+      },
+      [&]() { p << " | "; });
+}
+
+/// Returns the operations computing the given values, stopping at ports and
+/// registers, such that every operation comes after its operands. Fails if the
+/// values depend on a combinational cycle.
+static LogicalResult sortCombinationalLogic(ArrayRef<Value> roots,
+                                            SmallVectorImpl<Operation *> &order,
+                                            EmissionPrinter &p) {
+  DenseSet<Operation *> visited, finished;
+  SmallVector<std::pair<Operation *, unsigned>> worklist;
+  auto visit = [&](Value value) {
+    auto *op = value.getDefiningOp();
+    if (!op || isa<seq::CompRegOp>(op) || finished.contains(op))
+      return success();
+    // Operations visited but not finished are on the current path.
+    if (!visited.insert(op).second) {
+      p.emitError(op, "combinational cycle")
+          << "is part of a combinational cycle, which cannot be evaluated";
+      return failure();
+    }
+    worklist.push_back({op, 0});
+    return success();
+  };
+
+  for (Value root : roots) {
+    if (failed(visit(root)))
+      return failure();
+    while (!worklist.empty()) {
+      auto &[op, operandIdx] = worklist.back();
+      if (operandIdx < op->getNumOperands()) {
+        Value operand = op->getOperand(operandIdx++);
+        if (failed(visit(operand)))
+          return failure();
+        continue;
+      }
+      finished.insert(op);
+      order.push_back(op);
+      worklist.pop_back();
+    }
+  }
+  return success();
+}
+
+//===----------------------------------------------------------------------===//
+// Operation emission patterns.
+//===----------------------------------------------------------------------===//
+
+namespace {
+
+/// The base class of all patterns emitting combinational logic. Values bound to
+/// a local variable of the eval function are referred to by its name, all
+/// others are inlined.
+template <typename Op>
+struct EvalExprEmitter : OpEmissionPattern<Op> {
+  EvalExprEmitter(MLIRContext *context, EvalModelState &state)
+      : OpEmissionPattern<Op>(context), state(state) {}
+
+  MatchResult matchInlinable(Value value) override {
+    auto op = value.getDefiningOp<Op>();
+    if (!op || !isSupportedType(value.getType()) ||
+        !llvm::all_of(op->getOperandTypes(), isSupportedType))
+      return {};
+    if (state.localNames.count(value))
+      return Precedence::VAR;
+    return getPrecedence(op);
+  }
+
+  void emitInlined(Value value, EmissionPrinter &p) override {
+    auto it = state.localNames.find(value);
+    if (it != state.localNames.end()) {
+      p << it->second;
+      return;
+    }
+    emitExpression(value.getDefiningOp<Op>(), p);
+  }
+
+  /// Returns the precedence of the expression emitted for the operation.
+  virtual Precedence getPrecedence(Op op) = 0;
+
+  /// Emits the expression computing the result of the operation.
+  virtual void emitExpression(Op op, EmissionPrinter &p) = 0;
+
+protected:
+  EvalModelState &state;
+};
+
+/// Emit arithmetic and bitwise operations as the corresponding C++ operators.
+/// Results that may exceed their width are computed in 64 bits and truncated.
+/// Examples:
+/// * comb.add %a, %b : i8 ==> (uint64_t(a) + b) & 0xFFu
+/// * comb.add %a, %b : i32 ==> a + b
+/// * comb.xor %a, %b : i8 ==> a ^ b
+template <typename Op>
+struct ArithmeticEmitter : EvalExprEmitter<Op> {
+  ArithmeticEmitter(MLIRContext *context, EvalModelState &state,
+                    StringRef symbol, Precedence precedence, bool mayOverflow)
+      : EvalExprEmitter<Op>(context, state), symbol(symbol),
+        precedence(precedence), mayOverflow(mayOverflow) {}
+
+  Precedence getPrecedence(Op op) override {
+    return needsTruncation(op) ? Precedence::BITWISE_AND : precedence;
+  }
+
+  void emitExpression(Op op, EmissionPrinter &p) override {
+    bool truncate = needsTruncation(op);
+    auto operands = op->getOperands();
+    if (truncate) {
+      p << "(uint64_t(";
+      p.getInlinable(operands[0]).emit();
+      p << ")";
+    } else {
+      p.getInlinable(operands[0]).emitWithParensOnLowerPrecedence(precedence);
+    }
+    for (Value operand : operands.drop_front()) {
+      p << " " << symbol << " ";
+      p.getInlinable(operand).emitWithParensOnLowerPrecedence(precedence);
+    }
+    if (truncate)
+      p << ") & " << getMaskLiteral(getWidth(op.getResult()));
+  }
+
+private:
+  bool needsTruncation(Op op) {
+    return mayOverflow && !wrapsNatively(getWidth(op.getResult()));
+  }
+
+  StringRef symbol;
+  Precedence precedence;
+  bool mayOverflow;
+};
+
+/// Emit signed division and remainder on sign-extended operands. Example:
+/// * comb.divs %a, %b : i8 ==> uint64_t(int8_t(a) / int8_t(b)) & 0xFFu
+template <typename Op>
+struct SignedArithmeticEmitter : EvalExprEmitter<Op> {
+  SignedArithmeticEmitter(MLIRContext *context, EvalModelState &state,
+                          StringRef symbol)
+      : EvalExprEmitter<Op>(context, state), symbol(symbol) {}
+
+  Precedence getPrecedence(Op op) override {
+    return getTruncatedPrecedence(getWidth(op.getResult()));
+  }
+
+  void emitExpression(Op op, EmissionPrinter &p) override {
+    emitTruncated(getWidth(op.getResult()), p, [&]() {
+      emitSignExtended(op.getLhs(), p);
+      p << " " << symbol << " ";
+      emitSignExtended(op.getRhs(), p);
+    });
+  }
+
+private:
+  StringRef symbol;
+};
+
+/// Emit a left shift, which yields zero if the whole value is shifted out.
+/// Example:
+/// * comb.shl %a, %b : i8 ==> b >= 8 ? 0 : (uint64_t(a) << b) & 0xFFu
+struct ShlEmitter : EvalExprEmitter<comb::ShlOp> {
+  using EvalExprEmitter::EvalExprEmitter;
+
+  Precedence getPrecedence(comb::ShlOp op) override {
+    return Precedence::TERNARY;
+  }
+
+  void emitExpression(comb::ShlOp op, EmissionPrinter &p) override {
+    unsigned width = getWidth(op.getResult());
+    p.getInlinable(op.getRhs())
+        .emitWithParensOnLowerPrecedence(Precedence::RELATIONAL);
+    p << " >= " << width << " ? 0 : (uint64_t(";
+    p.getInlinable(op.getLhs()).emit();
+    p << ") << ";
+    p.getInlinable(op.getRhs())
+        .emitWithParensOnLowerPrecedence(Precedence::SHL);
+    p << ")";
+    if (width < 64)
+      p << " & " << getMaskLiteral(width);
+  }
+};
+
+/// Emit a logical right shift, which yields zero if the whole value is shifted
+/// out. Example:
+/// * comb.shru %a, %b : i8 ==> b >= 8 ? 0 : a >> b
+struct ShrUEmitter : EvalExprEmitter<comb::ShrUOp> {
+  using EvalExprEmitter::EvalExprEmitter;
+
+  Precedence getPrecedence(comb::ShrUOp op) override {
+    return Precedence::TERNARY;
+  }
+
+  void emitExpression(comb::ShrUOp op, EmissionPrinter &p) override {
+    p.getInlinable(op.getRhs())
+        .emitWithParensOnLowerPrecedence(Precedence::RELATIONAL);
+    p << " >= " << getWidth(op.getResult()) << " ? 0 : ";
+    p.getInlinable(op.getLhs())
+        .emitWithParensOnLowerPrecedence(Precedence::SHR);
+    p << " >> ";
+    p.getInlinable(op.getRhs())
+        .emitWithParensOnLowerPrecedence(Precedence::SHR);
+  }
+};
+
+/// Emit an arithmetic right shift on the sign-extended value, which yields the
+/// sign bit in every position if the whole value is shifted out. Example:
+/// * comb.shrs %a, %b : i8 ==> uint64_t(int8_t(a) >> (b >= 8 ? 7 : b)) & 0xFFu
+struct ShrSEmitter : EvalExprEmitter<comb::ShrSOp> {
+  using EvalExprEmitter::EvalExprEmitter;
+
+  Precedence getPrecedence(comb::ShrSOp op) override {
+    return getTruncatedPrecedence(getWidth(op.getResult()));
+  }
+
+  void emitExpression(comb::ShrSOp op, EmissionPrinter &p) override {
+    unsigned width = getWidth(op.getResult());
+    emitTruncated(width, p, [&]() {
+      emitSignExtended(op.getLhs(), p);
+      p << " >> (";
+      p.getInlinable(op.getRhs())
+          .emitWithParensOnLowerPrecedence(Precedence::RELATIONAL);
+      p << " >= " << width << " ? " << (width - 1) << " : ";
+      p.getInlinable(op.getRhs())
+          .emitWithParensOnLowerPrecedence(Precedence::TERNARY);
+      p << ")";
+    });
+  }
+};
+
+/// Returns the C++ operator implementing the comparison predicate.
+static StringRef getComparisonSymbol(comb::ICmpPredicate predicate) {
+  switch (predicate) {
+  case comb::ICmpPredicate::eq:
+  case comb::ICmpPredicate::ceq:
+  case comb::ICmpPredicate::weq:
+    return "==";
+  case comb::ICmpPredicate::ne:
+  case comb::ICmpPredicate::cne:
+  case comb::ICmpPredicate::wne:
+    return "!=";
+  case comb::ICmpPredicate::slt:
+  case comb::ICmpPredicate::ult:
+    return "<";
+  case comb::ICmpPredicate::sle:
+  case comb::ICmpPredicate::ule:
+    return "<=";
+  case comb::ICmpPredicate::sgt:
+  case comb::ICmpPredicate::ugt:
+    return ">";
+  case comb::ICmpPredicate::sge:
+  case comb::ICmpPredicate::uge:
+    return ">=";
+  }
+  llvm_unreachable("unknown comparison predicate");
+}
+
+/// Emit an integer comparison. Signed comparisons are performed on the
+/// sign-extended operands. Examples:
+/// * comb.icmp ult %a, %b : i8 ==> a < b
+/// * comb.icmp slt %a, %b : i8 ==> int8_t(a) < int8_t(b)
+struct ICmpEmitter : EvalExprEmitter<comb::ICmpOp> {
+  using EvalExprEmitter::EvalExprEmitter;
+
+  Precedence getPrecedence(comb::ICmpOp op) override {
+    StringRef symbol = getComparisonSymbol(op.getPredicate());
+    return symbol == "==" || symbol == "!=" ? Precedence::EQUALITY
+                                            : Precedence::RELATIONAL;
+  }
+
+  void emitExpression(comb::ICmpOp op, EmissionPrinter &p) override {
+    bool isSigned = comb::ICmpOp::isPredicateSigned(op.getPredicate());
+    Precedence precedence = getPrecedence(op);
+    auto emitOperand = [&](Value operand) {
+      if (isSigned)
+        emitSignExtended(operand, p);
+      else
+        p.getInlinable(operand).emitWithParensOnLowerPrecedence(precedence);
+    };
+    emitOperand(op.getLhs());
+    p << " " << getComparisonSymbol(op.getPredicate()) << " ";
+    emitOperand(op.getRhs());
+  }
+};
+
+/// Emit a multiplexer as a conditional expression. Example:
+/// * comb.mux %c, %a, %b : i8 ==> c ? a : b
+struct MuxEmitter : EvalExprEmitter<comb::MuxOp> {
+  using EvalExprEmitter::EvalExprEmitter;
+
+  Precedence getPrecedence(comb::MuxOp op) override {
+    return Precedence::TERNARY;
+  }
+
+  void emitExpression(comb::MuxOp op, EmissionPrinter &p) override {
+    p.getInlinable(op.getCond())
+        .emitWithParensOnLowerPrecedence(Precedence::TERNARY);
+    p << " ? ";
+    p.getInlinable(op.getTrueValue())
+        .emitWithParensOnLowerPrecedence(Precedence::TERNARY);
+    p << " : ";
+    p.getInlinable(op.getFalseValue())
+        .emitWithParensOnLowerPrecedence(Precedence::TERNARY);
+  }
+};
+
+/// Emit a bit range extraction as a shift and mask. Examples:
+/// * comb.extract %a from 2 : (i8) -> i3 ==> (a >> 2) & 0x7u
+/// * comb.extract %a from 4 : (i8) -> i4 ==> a >> 4
+struct ExtractEmitter : EvalExprEmitter<comb::ExtractOp> {
+  using EvalExprEmitter::EvalExprEmitter;
+
+  Precedence getPrecedence(comb::ExtractOp op) override {
+    if (needsMask(op))
+      return Precedence::BITWISE_AND;
+    return op.getLowBit() == 0 ? Precedence::TERNARY : Precedence::SHR;
+  }
+
+  void emitExpression(comb::ExtractOp op, EmissionPrinter &p) override {
+    bool mask = needsMask(op);
+    if (op.getLowBit() == 0) {
+      p.getInlinable(op.getInput())
+          .emitWithParensOnLowerPrecedence(mask ? Precedence::BITWISE_AND
+                                                : Precedence::TERNARY);
+    } else {
+      if (mask)
+        p << "(";
+      p.getInlinable(op.getInput())
+          .emitWithParensOnLowerPrecedence(Precedence::SHR);
+      p << " >> " << op.getLowBit();
+      if (mask)
+        p << ")";
+    }
+    if (mask)
+      p << " & " << getMaskLiteral(getWidth(op.getResult()));
+  }
+
+private:
+  /// The upper bits have to be masked unless they are all extracted.
+  bool needsMask(comb::ExtractOp op) {
+    return op.getLowBit() + getWidth(op.getResult()) < getWidth(op.getInput());
+  }
+};
+
+/// Emit a concatenation as shifted operands combined with a bitwise or.
+/// Example:
+/// * comb.concat %a, %b : i4, i4 ==> (uint64_t(a) << 4) | b
+struct ConcatEmitter : EvalExprEmitter<comb::ConcatOp> {
+  using EvalExprEmitter::EvalExprEmitter;
+
+  Precedence getPrecedence(comb::ConcatOp op) override {
+    return Precedence::BITWISE_OR;
+  }
+
+  void emitExpression(comb::ConcatOp op, EmissionPrinter &p) override {
+    SmallVector<Value> operands(op.getInputs());
+    emitConcatenation(operands, p);
+  }
+};
+
+/// Emit a replication as the concatenation of the repeated operand. Example:
+/// * comb.replicate %a : (i2) -> i4 ==> (uint64_t(a) << 2) | a
+struct ReplicateEmitter : EvalExprEmitter<comb::ReplicateOp> {
+  using EvalExprEmitter::EvalExprEmitter;
+
+  Precedence getPrecedence(comb::ReplicateOp op) override {
+    return Precedence::BITWISE_OR;
+  }
+
+  void emitExpression(comb::ReplicateOp op, EmissionPrinter &p) override {
+    SmallVector<Value> operands(op.getMultiple(), op.getInput());
+    emitConcatenation(operands, p);
+  }
+};
+
+/// Emit a parity reduction with the corresponding compiler builtin. Example:
+/// * comb.parity %a : i8 ==> __builtin_parityll(a)
+struct ParityEmitter : EvalExprEmitter<comb::ParityOp> {
+  using EvalExprEmitter::EvalExprEmitter;
+
+  Precedence getPrecedence(comb::ParityOp op) override {
+    return Precedence::FUNCTION_CALL;
+  }
+
+  void emitExpression(comb::ParityOp op, EmissionPrinter &p) override {
+    p << "__builtin_parityll(";
+    p.getInlinable(op.getInput()).emit();
+    p << ")";
+  }
+};
+
+/// Emit a constant as an unsigned integer literal. Examples:
+/// * hw.constant 5 : i8 ==> 5u
+/// * hw.constant 5 : i40 ==> 5ull
+/// * hw.constant true ==> true
+struct ConstantEmitter : OpEmissionPattern<hw::ConstantOp> {
+  using OpEmissionPattern::OpEmissionPattern;
+
+  MatchResult matchInlinable(Value value) override {
+    if (value.getDefiningOp<hw::ConstantOp>() &&
+        isSupportedType(value.getType()))
+      return Precedence::LIT;
+    return {};
+  }
+
+  void emitInlined(Value value, EmissionPrinter &p) override {
+    const APInt &constant = value.getDefiningOp<hw::ConstantOp>().getValue();
+    if (constant.getBitWidth() == 1) {
+      p << (constant.getBoolValue() ? "true" : "false");
+      return;
+    }
+    SmallString<24> str;
+    constant.toString(str, 10, /*Signed=*/false);
+    str += constant.getBitWidth() > 32 ? "ull" : "u";
+    p << str;
+  }
+};
+
+/// Registers are held in fields of the model and referred to by their name.
+struct CompRegEmitter : OpEmissionPattern<seq::CompRegOp> {
+  CompRegEmitter(MLIRContext *context, EvalModelState &state)
+      : OpEmissionPattern(context), state(state) {}
+
+  MatchResult matchInlinable(Value value) override {
+    if (state.registerNames.count(value))
+      return Precedence::VAR;
+    return {};
+  }
+
+  void emitInlined(Value value, EmissionPrinter &p) override {
+    p << state.registerNames.lookup(value);
+  }
+
+private:
+  EvalModelState &state;
+};
+
+/// Emit a flat HW module as a struct with a field for each port and register,
+/// and an 'eval' function. After setting the inputs, calling 'eval' samples
+/// the inputs of all registers whose clock rose since the last call, then
+/// updates those registers, and finally recomputes the outputs. Values used
+/// more than once are bound to local variables to compute them only once.
+struct EvalModuleEmitter : OpEmissionPattern<hw::HWModuleOp> {
+  EvalModuleEmitter(MLIRContext *context, EvalModelState &state)
+      : OpEmissionPattern(context), state(state) {}
+
+  MatchResult matchInlinable(Value value) override {
+    if (value.isa<BlockArgument>() &&
+        isa<hw::HWModuleOp>(value.getParentRegion()->getParentOp()))
+      return Precedence::VAR;
+    return {};
+  }
+
+  void emitInlined(Value value, EmissionPrinter &p) override {
+    auto *module = value.getParentRegion()->getParentOp();
+    p << hw::getModuleArgumentName(module,
+                                   value.cast<BlockArgument>().getArgNumber());
+  }
+
+  void emitStatement(hw::HWModuleOp module, EmissionPrinter &p) override {
+    Block *body = module.getBodyBlock();
+    SmallVector<seq::CompRegOp> registers;
+    SmallVector<Value> clocks;
+    for (Operation &op : *body) {
+      if (isa<hw::InstanceOp>(op)) {
+        p.emitError(&op, "instances are not supported")
+            << "cannot be part of an eval model, the module hierarchy has to "
+               "be flattened first";
+        return;
+      }
+      if (auto reg = dyn_cast<seq::CompRegOp>(op)) {
+        if (!reg.getClk().isa<BlockArgument>()) {
+          p.emitError(reg, "clock must be a module input")
+              << "clock has to be a module input in an eval model";
+          return;
+        }
+        registers.push_back(reg);
+        if (!llvm::is_contained(clocks, reg.getClk()))
+          clocks.push_back(reg.getClk());
+      }
+    }
+
+    // Ports keep their names, all other fields and locals are uniqued against
+    // them.
+    llvm::StringSet<> usedNames;
+    auto getUniqueName = [&](const Twine &base) {
+      std::string name = base.str();
+      for (unsigned i = 0; !usedNames.insert(name).second; ++i)
+        name = (base + "_" + Twine(i)).str();
+      return name;
+    };
+    FunctionType moduleType = hw::getModuleType(module);
+    for (size_t i = 0, e = moduleType.getNumInputs(); i < e; ++i)
+      usedNames.insert(hw::getModuleArgumentName(module, i));
+    for (size_t i = 0, e = moduleType.getNumResults(); i < e; ++i)
+      usedNames.insert(hw::getModuleResultName(module, i));
+
+    state.registerNames.clear();
+    for (auto reg : registers)
+      state.registerNames[reg.getData()] =
+          getUniqueName(reg.getName().empty() ? "_reg" : reg.getName());
+
+    SmallVector<std::string> lastClockNames, edgeNames;
+    for (Value clock : clocks) {
+      StringRef clockName = hw::getModuleArgumentName(
+          module, clock.cast<BlockArgument>().getArgNumber());
+      lastClockNames.push_back(getUniqueName(clockName + "_last"));
+      edgeNames.push_back(getUniqueName(clockName + "_posedge"));
+    }
+
+    // Emit a newline at the start to ensure an empty line before the struct
+    // for better readability.
+    p << "\nstruct " << module.getName() << " ";
+    auto scope = p.getOstream().scope("{\n", "};\n");
+
+    auto emitField = [&](Type type, StringRef name) {
+      p.emitType(type);
+      p << " " << name << " = 0;\n";
+    };
+    if (moduleType.getNumInputs() != 0)
+      p << "// Inputs\n";
+    for (auto [i, type] : llvm::enumerate(moduleType.getInputs()))
+      emitField(type, hw::getModuleArgumentName(module, i));
+    if (moduleType.getNumResults() != 0)
+      p << "// Outputs\n";
+    for (auto [i, type] : llvm::enumerate(moduleType.getResults()))
+      emitField(type, hw::getModuleResultName(module, i));
+    if (!registers.empty())
+      p << "// Registers\n";
+    for (auto reg : registers)
+      emitField(reg.getData().getType(), state.registerNames[reg.getData()]);
+    if (!clocks.empty())
+      p << "// Clock values at the previous evaluation\n";
+    for (auto [clock, name] : llvm::zip(clocks, lastClockNames))
+      emitField(clock.getType(), name);
+
+    p << "\nvoid eval() ";
+    unsigned numLocals = 0;
+    auto evalScope = p.getOstream().scope("{\n", "}\n");
+
+    // Detect the clock edges.
+    for (auto [clock, lastName, edgeName] :
+         llvm::zip(clocks, lastClockNames, edgeNames)) {
+      p << "bool " << edgeName << " = ";
+      p.getInlinable(clock).emit();
+      p << " && !" << lastName << ";\n";
+      p << lastName << " = ";
+      p.getInlinable(clock).emit();
+      p << ";\n";
+    }
+
+    // Compute the next values of all registers before updating any of them,
+    // such that all of them observe the values from before the clock edge.
+    if (!registers.empty()) {
+      p << "if (" << llvm::join(edgeNames, " || ") << ") ";
+      auto edgeScope = p.getOstream().scope("{\n", "}\n");
+
+      SmallVector<Value> roots;
+      for (auto reg : registers) {
+        roots.push_back(reg.getInput());
+        if (reg.getReset()) {
+          roots.push_back(reg.getReset());
+          roots.push_back(reg.getResetValue());
+        }
+      }
+      if (failed(emitLocals(roots, p, numLocals, getUniqueName)))
+        return;
+
+      SmallVector<std::string> nextNames;
+      for (auto reg : registers) {
+        nextNames.push_back(
+            getUniqueName(state.registerNames[reg.getData()] + "_next"));
+        p.emitType(reg.getData().getType());
+        p << " " << nextNames.back() << " = ";
+        if (reg.getReset()) {
+          p.getInlinable(reg.getReset())
+              .emitWithParensOnLowerPrecedence(Precedence::TERNARY);
+          p << " ? ";
+          p.getInlinable(reg.getResetValue())
+              .emitWithParensOnLowerPrecedence(Precedence::TERNARY);
+          p << " : ";
+          p.getInlinable(reg.getInput())
+              .emitWithParensOnLowerPrecedence(Precedence::TERNARY);
+        } else {
+          p.getInlinable(reg.getInput()).emit();
+        }
+        p << ";\n";
+      }
+
+      for (auto [reg, nextName] : llvm::zip(registers, nextNames)) {
+        if (clocks.size() > 1) {
+          auto *clockIt = llvm::find(clocks, reg.getClk());
+          p << "if (" << edgeNames[clockIt - clocks.begin()] << ") ";
+        }
+        p << state.registerNames[reg.getData()] << " = " << nextName
+          << ";\n";
+      }
+    }
+
+    // Settle the combinational logic driving the outputs.
+    auto outputs = body->getTerminator()->getOperands();
+    SmallVector<Value> roots(outputs.begin(), outputs.end());
+    if (failed(emitLocals(roots, p, numLocals, getUniqueName)))
+      return;
+    for (auto [i, output] : llvm::enumerate(outputs)) {
+      p << hw::getModuleResultName(module, i) << " = ";
+      p.getInlinable(output).emit();
+      p << ";\n";
+    }
+  }
+
+private:
+  /// Binds all values with more than one use in the combinational logic
+  /// computing the roots to local variables in topological order.
+  LogicalResult
+  emitLocals(ArrayRef<Value> roots, EmissionPrinter &p, unsigned &numLocals,
+             llvm::function_ref<std::string(const Twine &)> getUniqueName) {
+    state.localNames.clear();
+    SmallVector<Operation *> order;
+    if (failed(sortCombinationalLogic(roots, order, p)))
+      return failure();
+
+    for (auto *op : order) {
+      if (isa<hw::ConstantOp>(op))
+        continue;
+      for (Value result : op->getResults()) {
+        if (result.hasOneUse() || result.use_empty())
+          continue;
+        std::string name = getUniqueName("_" + Twine(numLocals++));
+        p.emitType(result.getType());
+        p << " " << name << " = ";
+        p.getInlinable(result).emit();
+        p << ";\n";
+        state.localNames[result] = name;
+      }
+    }
+    return success();
+  }
+
+  EvalModelState &state;
+};
+
+} // namespace
+
+//===----------------------------------------------------------------------===//
+// Type emission patterns.
+//===----------------------------------------------------------------------===//
+
+namespace {
+
+/// Emit integer types as the smallest native unsigned integer type holding all
+/// their bits. Examples:
+/// * i1 ==> bool
+/// * i12 ==> uint16_t
+struct IntegerTypeEmitter : TypeEmissionPattern<IntegerType> {
+  bool match(Type type) override { return isSupportedType(type); }
+
+  void emitType(IntegerType type, EmissionPrinter &p) override {
+    unsigned width = type.getWidth();
+    if (width == 1) {
+      p << "bool";
+      return;
+    }
+    p << "uint" << std::max<int64_t>(8, llvm::PowerOf2Ceil(width)) << "_t";
+  }
+};
+
+} // namespace
+
+//===----------------------------------------------------------------------===//
+// Register Operation and Type emission patterns.
+//===----------------------------------------------------------------------===//
+
+void circt::ExportSystemC::populateEvalModelOpEmitters(
+    OpEmissionPatternSet &patterns, MLIRContext *context,
+    EvalModelState &state) {
+  patterns.add<EvalModuleEmitter, CompRegEmitter, ShlEmitter, ShrUEmitter,
+               ShrSEmitter, ICmpEmitter, MuxEmitter, ExtractEmitter,
+               ConcatEmitter, ReplicateEmitter, ParityEmitter>(context, state);
+  patterns.add<ConstantEmitter>(context);
+
+  patterns.add<ArithmeticEmitter<comb::AddOp>>(context, state, "+",
+                                               Precedence::ADD, true);
+  patterns.add<ArithmeticEmitter<comb::SubOp>>(context, state, "-",
+                                               Precedence::SUB, true);
+  patterns.add<ArithmeticEmitter<comb::MulOp>>(context, state, "*",
+                                               Precedence::MUL, true);
+  patterns.add<ArithmeticEmitter<comb::DivUOp>>(context, state, "/",
+                                                Precedence::DIV, false);
+  patterns.add<ArithmeticEmitter<comb::ModUOp>>(context, state, "%",
+                                                Precedence::MOD, false);
+  patterns.add<ArithmeticEmitter<comb::AndOp>>(context, state, "&",
+                                               Precedence::BITWISE_AND, false);
+  patterns.add<ArithmeticEmitter<comb::OrOp>>(context, state, "|",
+                                              Precedence::BITWISE_OR, false);
+  patterns.add<ArithmeticEmitter<comb::XorOp>>(context, state, "^",
+                                               Precedence::BITWISE_XOR, false);
+  patterns.add<SignedArithmeticEmitter<comb::DivSOp>>(context, state, "/");
+  patterns.add<SignedArithmeticEmitter<comb::ModSOp>>(context, state, "%");
+}
+
+void circt::ExportSystemC::populateEvalModelTypeEmitters(
+    TypeEmissionPatternSet &patterns) {
+  patterns.add<IntegerTypeEmitter>();
+}
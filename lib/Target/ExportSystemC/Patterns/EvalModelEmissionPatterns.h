@@ -0,0 +1,46 @@
+//===- EvalModelEmissionPatterns.h - Eval Model Emission Patterns ---------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This exposes the emission patterns of the kernel-free evaluation model for
+// registration.
+//
+//===----------------------------------------------------------------------===//
+
+// NOLINTNEXTLINE(llvm-header-guard)
+#ifndef CIRCT_TARGET_EXPORTSYSTEMC_PATTERNS_EVALMODELEMISSIONPATTERNS_H
+#define CIRCT_TARGET_EXPORTSYSTEMC_PATTERNS_EVALMODELEMISSIONPATTERNS_H
+
+#include "../EmissionPatternSupport.h"
+#include "llvm/ADT/DenseMap.h"
+
+namespace circt {
+namespace ExportSystemC {
+
+/// The state shared between the emission patterns of the evaluation model.
+struct EvalModelState {
+  /// The names of the struct fields holding the register values.
+  DenseMap<Value, std::string> registerNames;
+  /// The names of the local variables bound in the current block of the eval
+  /// function. Values with a name are referred to by it instead of being
+  /// inlined again.
+  DenseMap<Value, std::string> localNames;
+};
+
+/// Register the operation emission patterns of the evaluation model. These
+/// have to be registered before the regular patterns to take precedence.
+void populateEvalModelOpEmitters(OpEmissionPatternSet &patterns,
+                                 MLIRContext *context, EvalModelState &state);
+
+/// Register the type emission patterns of the evaluation model. These have to
+/// be registered before the regular patterns to take precedence.
+void populateEvalModelTypeEmitters(TypeEmissionPatternSet &patterns);
+
+} // namespace ExportSystemC
+} // namespace circt
+
+#endif // CIRCT_TARGET_EXPORTSYSTEMC_PATTERNS_EVALMODELEMISSIONPATTERNS_H
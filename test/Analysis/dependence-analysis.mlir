@@ -147,3 +147,17 @@ func.func @test8(%arg0: memref<?xi32>) {
   }
   return
 }
+
+// CHECK-LABEL: func @test9
+func.func @test9(%arg0: memref<?xi32>) {
+  %c0_i32 = arith.constant 0 : i32
+  // CHECK: affine.load %arg0[0] {dependences = []}
+  %0 = affine.load %arg0[0] : memref<?xi32>
+  // CHECK{LITERAL}: affine.store %c0_i32, %arg0[0] {dependences = [[]]}
+  affine.store %c0_i32, %arg0[0] : memref<?xi32>
+  // CHECK{LITERAL}: affine.load %arg0[0] {dependences = [[], []]}
+  %1 = affine.load %arg0[0] : memref<?xi32>
+  affine.for %arg1 = 0 to 10 {
+  }
+  return
+}
@@ -17,6 +17,11 @@
 #include <mlir-c/Support.h>
 #include <stdio.h>
 
+void printToStderr(MlirStringRef str, void *userData) {
+  (void)userData;
+  fwrite(str.data, 1, str.length, stderr);
+}
+
 void testEvaluator(MlirContext ctx) {
   const char *testIR = "module {"
                        "  om.class @Test(%param: i8) {"
@@ -92,6 +97,16 @@ void testEvaluator(MlirContext ctx) {
 
   // CHECK: 42 : i8
   mlirAttributeDump(fieldValue);
+
+  // Test JSON serialization.
+
+  // CHECK: {"$id":0,"$class":"Test","field":42}
+  MlirLogicalResult serialized =
+      omEvaluatorObjectSerializeJSON(object, printToStderr, NULL);
+  fprintf(stderr, "\n");
+
+  // CHECK: serialized: 1
+  fprintf(stderr, "serialized: %d\n", mlirLogicalResultIsSuccess(serialized));
 }
 
 int main() {
@@ -0,0 +1,41 @@
+// RUN: circt-opt -convert-affine-to-loopschedule=memory-banks=2 %s | FileCheck %s
+// RUN: circt-opt -convert-affine-to-loopschedule %s | FileCheck %s --check-prefix=NOBANKS
+
+// The two loads access different banks, so they can be issued in the same
+// cycle once the memory is partitioned.
+// CHECK-LABEL: func @banked
+// CHECK:     %[[BANK0:.+]] = memref.alloca() : memref<32xi32>
+// CHECK:     %[[BANK1:.+]] = memref.alloca() : memref<32xi32>
+// CHECK-NOT: memref.alloca
+// CHECK:     loopschedule.pipeline II = 1
+// CHECK-DAG: memref.load %[[BANK0]]
+// CHECK-DAG: memref.load %[[BANK1]]
+// NOBANKS-LABEL: func @banked
+// NOBANKS:       memref.alloca() : memref<64xi32>
+// NOBANKS:       loopschedule.pipeline II = 2
+func.func @banked() -> i32 {
+  %mem = memref.alloca() : memref<64xi32>
+  %c0_i32 = arith.constant 0 : i32
+  %0 = affine.for %i = 0 to 32 iter_args(%acc = %c0_i32) -> (i32) {
+    %1 = affine.load %mem[%i * 2] : memref<64xi32>
+    %2 = affine.load %mem[%i * 2 + 1] : memref<64xi32>
+    %3 = arith.addi %1, %2 : i32
+    %4 = arith.addi %acc, %3 : i32
+    affine.yield %4 : i32
+  }
+  return %0 : i32
+}
+
+// The bank of the access is not known statically, so the memory is kept.
+// CHECK-LABEL: func @not_banked
+// CHECK:       memref.alloca() : memref<64xi32>
+func.func @not_banked() -> i32 {
+  %mem = memref.alloca() : memref<64xi32>
+  %c0_i32 = arith.constant 0 : i32
+  %0 = affine.for %i = 0 to 64 iter_args(%acc = %c0_i32) -> (i32) {
+    %1 = affine.load %mem[%i] : memref<64xi32>
+    %2 = arith.addi %acc, %1 : i32
+    affine.yield %2 : i32
+  }
+  return %0 : i32
+}
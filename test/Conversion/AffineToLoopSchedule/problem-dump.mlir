@@ -0,0 +1,18 @@
+// RUN: rm -rf %t && mkdir -p %t
+// RUN: circt-opt -convert-affine-to-loopschedule=problem-dump-dir=%t %s
+// RUN: cat %t/minimal_0.mlir | FileCheck %s
+// RUN: circt-opt %t/minimal_0.mlir -ssp-schedule=scheduler=simplex | FileCheck %s --check-prefix=SCHEDULED
+
+// CHECK: ssp.instance @minimal_0 of "ModuloProblem" {
+// CHECK:   library {
+// CHECK:     operator_type @{{.+}} [latency<{{[0-9]+}}>
+// CHECK:   graph {
+// CHECK:     operation<@{{.+}}>
+
+// SCHEDULED: ssp.instance @minimal_0 of "ModuloProblem" [II<1>]
+func.func @minimal(%arg0 : memref<10xindex>) {
+  affine.for %arg1 = 0 to 10 {
+    affine.store %arg1, %arg0[%arg1] : memref<10xindex>
+  }
+  return
+}
@@ -0,0 +1,18 @@
+// RUN: circt-opt %s --lower-arc-to-llvm=lanes=4 | FileCheck %s
+
+// CHECK-LABEL: llvm.func @Top_clock(%arg0: !llvm.ptr<i8>) {
+func.func @Top_clock(%arg0: !arc.storage<48>) {
+  // CHECK:      llvm.mlir.constant(4 : index)
+  // CHECK:      llvm.icmp "slt"
+  // CHECK:      [[PTR:%.+]] = llvm.getelementptr %arg0[{{%.+}}]
+  // CHECK-NEXT: [[STRIDE:%.+]] = llvm.mlir.constant(2 : i64)
+  // CHECK-NEXT: [[OFFSET:%.+]] = llvm.mul {{%.+}}, [[STRIDE]]
+  // CHECK-NEXT: [[LANEPTR:%.+]] = llvm.getelementptr [[PTR]][[[OFFSET]]]
+  // CHECK-NEXT: [[STATE:%.+]] = llvm.bitcast [[LANEPTR]] : !llvm.ptr<i8> to !llvm.ptr<i16>
+  // CHECK-NEXT: [[VALUE:%.+]] = llvm.load [[STATE]]
+  // CHECK-NEXT: llvm.store [[VALUE]], [[STATE]]
+  %0 = arc.storage.get %arg0[8] : !arc.storage<48> -> !arc.state<i16>
+  %1 = arc.state_read %0 : <i16>
+  arc.state_write %0 = %1 : <i16>
+  return
+}
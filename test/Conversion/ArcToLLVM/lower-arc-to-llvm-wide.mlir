@@ -0,0 +1,29 @@
+// RUN: circt-opt %s --lower-arc-to-llvm=wide-vector-threshold=256 | FileCheck %s
+
+// CHECK-LABEL: llvm.func @Bitwise(
+func.func @Bitwise(%arg0: i512, %arg1: i512, %arg2: i1) -> i512 {
+  // CHECK-DAG: [[A:%.+]] = llvm.bitcast %arg0 : i512 to vector<8xi64>
+  // CHECK-DAG: [[B:%.+]] = llvm.bitcast %arg1 : i512 to vector<8xi64>
+  // CHECK:     [[AND:%.+]] = llvm.and [[A]], [[B]] : vector<8xi64>
+  // CHECK:     [[R0:%.+]] = llvm.bitcast [[AND]] : vector<8xi64> to i512
+  %0 = arith.andi %arg0, %arg1 : i512
+  // CHECK:     llvm.or {{%.+}}, {{%.+}} : vector<8xi64>
+  %1 = arith.ori %0, %arg1 : i512
+  // CHECK:     llvm.xor {{%.+}}, {{%.+}} : vector<8xi64>
+  %2 = arith.xori %1, %arg0 : i512
+  // CHECK:     llvm.select %arg2, {{%.+}}, {{%.+}} : i1, vector<8xi64>
+  %3 = arith.select %arg2, %2, %arg0 : i512
+  return %3 : i512
+}
+
+// Integers narrower than the threshold or not a multiple of 64 bits wide are
+// left as scalars.
+// CHECK-LABEL: llvm.func @Narrow(
+func.func @Narrow(%arg0: i128, %arg1: i300) -> i300 {
+  // CHECK-NOT: vector
+  // CHECK:     llvm.and %arg0, %arg0 : i128
+  // CHECK:     llvm.and %arg1, %arg1 : i300
+  %0 = arith.andi %arg0, %arg0 : i128
+  %1 = arith.andi %arg1, %arg1 : i300
+  return %1 : i300
+}
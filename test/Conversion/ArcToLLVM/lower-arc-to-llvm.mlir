@@ -1,5 +1,7 @@
 // RUN: circt-opt %s --lower-arc-to-llvm | FileCheck %s
 
+// CHECK: llvm.func @calloc(i64, i64) -> !llvm.ptr<i8>
+
 // CHECK-LABEL: llvm.func internal @EmptyArc() {
 arc.define @EmptyArc() {
   arc.output
@@ -143,6 +145,40 @@ func.func @MemoryUpdates(%arg0: !arc.storage<24>, %enable: i1) {
 }
 // CHECK-NEXT: }
 
+// CHECK-LABEL: llvm.func @SparseMemoryUpdates(%arg0: !llvm.ptr<i8>, %arg1: i1) {
+func.func @SparseMemoryUpdates(%arg0: !arc.storage<32>, %enable: i1) {
+  %0 = arc.alloc_memory %arg0 {offset = 0, stride = 4} : (!arc.storage<32>) -> !arc.memory<1024 x i32, i10, sparse 256>
+  // CHECK-NEXT: [[RAW_PTR:%.+]] = llvm.getelementptr %arg0[0]
+  // CHECK-NEXT: [[TABLE:%.+]] = llvm.bitcast [[RAW_PTR]] : !llvm.ptr<i8> to !llvm.ptr<ptr<i32>>
+  %c3_i10 = hw.constant 3 : i10
+
+  %1 = arc.memory_read %0[%c3_i10] : <1024 x i32, i10, sparse 256>
+  // CHECK:      [[ADDR:%.+]] = llvm.zext {{%.+}} : i10 to i11
+  // CHECK:      [[SHIFT:%.+]] = llvm.mlir.constant(8 : i11)
+  // CHECK-NEXT: [[MASK:%.+]] = llvm.mlir.constant(255 : i11)
+  // CHECK-NEXT: [[PAGE_IDX:%.+]] = llvm.lshr [[ADDR]], [[SHIFT]]
+  // CHECK-NEXT: [[WORD_IDX:%.+]] = llvm.and [[ADDR]], [[MASK]]
+  // CHECK-NEXT: [[ENTRY:%.+]] = llvm.getelementptr [[TABLE]][[[PAGE_IDX]]]
+  // CHECK:      [[PAGE:%.+]] = llvm.load [[ENTRY]]
+  // CHECK-NEXT: [[NULL:%.+]] = llvm.mlir.null
+  // CHECK-NEXT: llvm.icmp "ne" [[PAGE]], [[NULL]]
+  // CHECK:      [[WORD:%.+]] = llvm.getelementptr [[PAGE]][[[WORD_IDX]]]
+  // CHECK-NEXT: llvm.load [[WORD]]
+
+  arc.memory_write %0[%c3_i10], %1 if %enable : <1024 x i32, i10, sparse 256>
+  // CHECK:      [[ENTRY:%.+]] = llvm.getelementptr [[TABLE]]
+  // CHECK:      [[PAGE:%.+]] = llvm.load [[ENTRY]]
+  // CHECK-NEXT: [[NULL:%.+]] = llvm.mlir.null
+  // CHECK-NEXT: llvm.icmp "eq" [[PAGE]], [[NULL]]
+  // CHECK:      [[RAW_PAGE:%.+]] = llvm.call @calloc
+  // CHECK-NEXT: [[NEW_PAGE:%.+]] = llvm.bitcast [[RAW_PAGE]] : !llvm.ptr<i8> to !llvm.ptr<i32>
+  // CHECK-NEXT: llvm.store [[NEW_PAGE]], [[ENTRY]]
+  // CHECK:      llvm.store
+  return
+  // CHECK:      llvm.return
+}
+// CHECK-NEXT: }
+
 // CHECK-LABEL: llvm.func @zeroCount
 func.func @zeroCount(%arg0 : i32) {
   // CHECK-NEXT: [[TRUE1:%.+]] = llvm.mlir.constant(true) : i1
@@ -190,3 +226,25 @@ func.func @funcCallOp(%arg0: i32) -> (i32, i32) {
 func.func @dummyFuncCallee(%arg0: i32) -> (i32, i32) {
   func.return %arg0, %arg0 : i32, i32
 }
+
+// CHECK-LABEL: llvm.func @packedBits(
+func.func @packedBits(%arg0: !arc.storage<8>, %arg1: i1) {
+  %0 = arc.storage.get %arg0[2] {bit = 3 : i32} : !arc.storage<8> -> !arc.state<i1>
+  // CHECK:      [[BYTEPTR:%.+]] = llvm.bitcast {{%.+}} : !llvm.ptr<i1> to !llvm.ptr<i8>
+  // CHECK-NEXT: [[BYTE:%.+]] = llvm.load [[BYTEPTR]] : !llvm.ptr<i8>
+  // CHECK-NEXT: [[SHIFT:%.+]] = llvm.mlir.constant(3 : i8)
+  // CHECK-NEXT: [[SHIFTED:%.+]] = llvm.lshr [[BYTE]], [[SHIFT]]
+  // CHECK-NEXT: llvm.trunc [[SHIFTED]] : i8 to i1
+  %1 = arc.state_read %0 : <i1>
+  // CHECK:      [[BYTEPTR:%.+]] = llvm.bitcast {{%.+}} : !llvm.ptr<i1> to !llvm.ptr<i8>
+  // CHECK-NEXT: [[BYTE:%.+]] = llvm.load [[BYTEPTR]] : !llvm.ptr<i8>
+  // CHECK-NEXT: [[MASK:%.+]] = llvm.mlir.constant(-9 : i8)
+  // CHECK-NEXT: [[SHIFT:%.+]] = llvm.mlir.constant(3 : i8)
+  // CHECK-NEXT: [[VALUE:%.+]] = llvm.zext %arg1 : i1 to i8
+  // CHECK-NEXT: [[CLEARED:%.+]] = llvm.and [[BYTE]], [[MASK]]
+  // CHECK-NEXT: [[SHIFTED:%.+]] = llvm.shl [[VALUE]], [[SHIFT]]
+  // CHECK-NEXT: [[UPDATED:%.+]] = llvm.or [[CLEARED]], [[SHIFTED]]
+  // CHECK-NEXT: llvm.store [[UPDATED]], [[BYTEPTR]] : !llvm.ptr<i8>
+  arc.state_write %0 = %arg1 : <i1>
+  return
+}
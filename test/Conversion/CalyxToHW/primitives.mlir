@@ -91,3 +91,37 @@ module attributes {calyx.entrypoint = "main"} {
     calyx.control {}
   }
 }
+
+// -----
+
+// Every component is lowered to its own module.
+// CHECK-LABEL: hw.module @main(%in0: i8, %in1: i8, %clk: i1, %reset: i1, %go: i1) -> (out: i8, done: i1) {
+// CHECK:   comb.add
+// CHECK:   hw.output
+// CHECK-LABEL: hw.module @helper(%in0: i8, %in1: i8, %clk: i1, %reset: i1, %go: i1) -> (out: i8, done: i1) {
+// CHECK:   comb.xor
+// CHECK:   hw.output
+module attributes {calyx.entrypoint = "main"} {
+  calyx.component @main(%in0: i8, %in1: i8, %clk: i1 {clk}, %reset: i1 {reset}, %go: i1 {go}) -> (%out: i8, %done: i1 {done}) {
+    %true = hw.constant true
+    %std_add.left, %std_add.right, %std_add.out = calyx.std_add @std_add : i8, i8, i8
+    calyx.wires {
+      calyx.assign %std_add.left = %in0 : i8
+      calyx.assign %std_add.right = %in1 : i8
+      calyx.assign %out = %std_add.out : i8
+      calyx.assign %done = %true : i1
+    }
+    calyx.control {}
+  }
+  calyx.component @helper(%in0: i8, %in1: i8, %clk: i1 {clk}, %reset: i1 {reset}, %go: i1 {go}) -> (%out: i8, %done: i1 {done}) {
+    %true = hw.constant true
+    %std_xor.left, %std_xor.right, %std_xor.out = calyx.std_xor @std_xor : i8, i8, i8
+    calyx.wires {
+      calyx.assign %std_xor.left = %in0 : i8
+      calyx.assign %std_xor.right = %in1 : i8
+      calyx.assign %out = %std_xor.out : i8
+      calyx.assign %done = %true : i1
+    }
+    calyx.control {}
+  }
+}
@@ -0,0 +1,12 @@
+// RUN: rm -rf %t
+// RUN: circt-opt %s --export-split-chisel-interface='dir-name=%t' --verify-diagnostics
+
+// Every public module is exported, and reports its errors, even if others fail.
+
+firrtl.circuit "Top" {
+  // expected-error @+1 {{Expected reset type to be inferred for exported port}}
+  firrtl.module @Top(in %reset: !firrtl.reset) {}
+  // expected-error @+1 {{Expected width to be inferred for exported port}}
+  firrtl.module @Public(in %in: !firrtl.uint) {}
+  firrtl.module @Fine(in %in: !firrtl.uint<1>) {}
+}
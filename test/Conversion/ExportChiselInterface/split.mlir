@@ -0,0 +1,25 @@
+// RUN: rm -rf %t
+// RUN: circt-opt %s --export-split-chisel-interface='dir-name=%t'
+// RUN: FileCheck %s --check-prefix=TOP --input-file=%t/Top.scala
+// RUN: FileCheck %s --check-prefix=PUBLIC --input-file=%t/Public.scala
+// RUN: not ls %t/Private.scala
+
+// Rerunning with unchanged contents leaves the files in place.
+// RUN: circt-opt %s --export-split-chisel-interface='dir-name=%t only-write-changed=true'
+// RUN: FileCheck %s --check-prefix=TOP --input-file=%t/Top.scala
+
+// TOP-LABEL: package shelf.top
+// TOP-LABEL: class Top extends ExtModule {
+// TOP-NEXT:    val in = IO(Input(UInt(1.W)))
+// TOP-NEXT:  }
+
+// PUBLIC-LABEL: package shelf.top
+// PUBLIC-LABEL: class Public extends ExtModule {
+// PUBLIC-NEXT:    val out = IO(Output(UInt(2.W)))
+// PUBLIC-NEXT:  }
+
+firrtl.circuit "Top" {
+  firrtl.module @Top(in %in: !firrtl.uint<1>) {}
+  firrtl.module @Public(out %out: !firrtl.uint<2>) {}
+  firrtl.module private @Private(in %in: !firrtl.uint<3>) {}
+}
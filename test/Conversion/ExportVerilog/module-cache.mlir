@@ -0,0 +1,40 @@
+// RUN: rm -rf %t && mkdir -p %t
+// RUN: circt-opt --export-verilog='module-cache-dir=%t/cache' %s -o /dev/null > %t/first.v
+// RUN: circt-opt --export-verilog='module-cache-dir=%t/cache' --mlir-pass-statistics %s -o /dev/null > %t/second.v 2> %t/second.stats
+// RUN: diff %t/first.v %t/second.v
+// RUN: FileCheck %s < %t/second.v
+// RUN: FileCheck %s --check-prefix=STATS < %t/second.stats
+
+// Changing a lowering option must not reuse the cached output.
+// RUN: circt-opt --test-apply-lowering-options='options=emittedLineLength=40' --export-verilog='module-cache-dir=%t/cache' --mlir-pass-statistics %s -o /dev/null > /dev/null 2> %t/options.stats
+// RUN: FileCheck %s --check-prefix=OPTIONS < %t/options.stats
+
+// The output of @Top refers to a wire inside @Child, and is not cached.
+// STATS: 2 num-reused-modules
+// OPTIONS: 0 num-reused-modules
+
+// CHECK-LABEL: module Leaf(
+// CHECK:         assign b = ~a;
+hw.module @Leaf(%a: i1) -> (b: i1) {
+  %true = hw.constant true
+  %0 = comb.xor %a, %true : i1
+  hw.output %0 : i1
+}
+
+// CHECK-LABEL: module Child(
+// CHECK:         Leaf leaf (
+hw.module @Child(%a: i1) -> (b: i1) {
+  %w = sv.wire sym @w : !hw.inout<i1>
+  sv.assign %w, %a : i1
+  %0 = sv.read_inout %w : !hw.inout<i1>
+  %leaf.b = hw.instance "leaf" @Leaf(a: %0: i1) -> (b: i1)
+  hw.output %leaf.b : i1
+}
+
+// CHECK-LABEL: module Top(
+// CHECK:         // Top.child.w
+hw.module @Top(%a: i1) -> (b: i1) {
+  %child.b = hw.instance "child" sym @child @Child(a: %a: i1) -> (b: i1)
+  sv.verbatim "// {{0}}.{{1}}.{{2}}" {symbols = [@Top, #hw.innerNameRef<@Top::@child>, #hw.innerNameRef<@Child::@w>]}
+  hw.output %child.b : i1
+}
@@ -0,0 +1,25 @@
+// RUN: circt-opt %s -prepare-for-emission -mlir-pass-statistics -o /dev/null 2>&1 | FileCheck %s
+
+// The preparation time is accumulated over all modules, whose counts are
+// reported alongside it.
+
+// CHECK:     PrepareForEmission
+// CHECK-DAG:   (S) 2 num-modules
+// CHECK-DAG:   (S) 1 num-spilled-wires
+// CHECK-DAG:   (S) {{[0-9]+}} prepare-time-us
+
+hw.module @NoSpill(%a: i4, %b: i4) -> (c: i4) {
+  %0 = comb.add %a, %b : i4
+  hw.output %0 : i4
+}
+
+// The result of the addition is extracted from, which has to be spilled to a
+// temporary in the procedural region.
+hw.module @SpillTemporaryInProceduralRegion(%a: i4, %b: i4) -> () {
+  %r = sv.reg : !hw.inout<i1>
+  sv.initial {
+    %0 = comb.add %a, %b : i4
+    %1 = comb.extract %0 from 3 : (i4) -> i1
+    sv.passign %r, %1: i1
+  }
+}
@@ -0,0 +1,32 @@
+// RUN: rm -rf %t
+// RUN: circt-opt %s --export-split-verilog='dir-name=%t only-write-changed=true'
+// RUN: FileCheck %s --check-prefix=FIRST < %t/changed-files.f
+// RUN: circt-opt %s --export-split-verilog='dir-name=%t only-write-changed=true'
+// RUN: FileCheck %s --check-prefix=SECOND --allow-empty < %t/changed-files.f
+// RUN: rm %t/Bar.sv
+// RUN: circt-opt %s --export-split-verilog='dir-name=%t only-write-changed=true'
+// RUN: FileCheck %s --check-prefix=THIRD < %t/changed-files.f
+// RUN: FileCheck %s --check-prefix=BAR < %t/Bar.sv
+
+// All the files are written by the first run.
+// FIRST:      Foo.sv
+// FIRST-NEXT: Bar.sv
+// FIRST-NEXT: filelist.f
+
+// Nothing changed, so nothing is written by the second run.
+// SECOND-NOT: {{.+}}
+
+// Only the removed file is written again.
+// THIRD-NOT:  Foo.sv
+// THIRD:      Bar.sv
+// THIRD-NOT:  {{.+}}
+
+// BAR: module Bar(
+
+hw.module @Foo(%a: i1) -> (b: i1) {
+  hw.output %a : i1
+}
+
+hw.module @Bar(%x: i1) -> (y: i1) {
+  hw.output %x : i1
+}
@@ -0,0 +1,39 @@
+// RUN: circt-opt %s --test-apply-lowering-options="options=emitSharedLTLDeclarations" --export-verilog --verify-diagnostics | FileCheck %s
+
+// CHECK-LABEL: module Shared
+hw.module @Shared(%clk: i1, %a: i1, %b: i1) {
+  // CHECK:      sequence _SEQ;
+  // CHECK-NEXT:   a ##1 b;
+  // CHECK-NEXT: endsequence
+  // CHECK:      property _PROP;
+  // CHECK-NEXT:   @(posedge clk) _SEQ |-> not a;
+  // CHECK-NEXT: endproperty
+  // CHECK:      assert property (_PROP);
+  // CHECK-NEXT: assume property (_PROP);
+  // CHECK-NEXT: cover property (_SEQ);
+  %d = ltl.delay %b, 1, 0 : i1
+  %s = ltl.concat %a, %d : i1, !ltl.sequence
+  %n = ltl.not %a : i1
+  %i = ltl.implication %s, %n : !ltl.sequence, !ltl.property
+  %p = ltl.clock %i, posedge %clk : !ltl.property
+  verif.assert %p : !ltl.property
+  verif.assume %p : !ltl.property
+  verif.cover %s : !ltl.sequence
+
+  // Procedural assertions refer to the declarations made in the module body.
+  // CHECK: initial begin
+  // CHECK-NEXT: assert property (_PROP);
+  sv.initial {
+    verif.assert %p : !ltl.property
+  }
+  // CHECK: end
+}
+
+// CHECK-LABEL: module NotShared
+hw.module @NotShared(%a: i1, %b: i1) {
+  // CHECK-NOT: sequence
+  // CHECK: assert property (a ##1 b);
+  %d = ltl.delay %b, 1, 0 : i1
+  %s = ltl.concat %a, %d : i1, !ltl.sequence
+  verif.assert %s : !ltl.sequence
+}
@@ -0,0 +1,71 @@
+// RUN: circt-opt -convert-fsm-to-sv=state-encoding=binary %s | FileCheck %s --check-prefix=BINARY
+// RUN: circt-opt -convert-fsm-to-sv=state-encoding=gray %s | FileCheck %s --check-prefix=GRAY
+// RUN: circt-opt -convert-fsm-to-sv=state-encoding=one-hot %s | FileCheck %s --check-prefix=ONEHOT
+// RUN: circt-opt -convert-fsm-to-sv %s | FileCheck %s --check-prefix=SHARE
+
+// BINARY-NOT:   hw.type_scope
+// BINARY-LABEL: hw.module @top
+// BINARY-DAG:     %{{.+}} = hw.constant 0 : i2
+// BINARY-DAG:     %{{.+}} = hw.constant 1 : i2
+// BINARY-DAG:     %{{.+}} = hw.constant -2 : i2
+// BINARY:         %state_reg = seq.compreg
+// BINARY-SAME:      : i2
+// BINARY:         sv.case %state_reg : i2
+// BINARY-NEXT:    case b00: {
+// BINARY:         case b01: {
+// BINARY:         case b10: {
+
+// GRAY-LABEL: hw.module @top
+// GRAY-DAG:     %{{.+}} = hw.constant 0 : i2
+// GRAY-DAG:     %{{.+}} = hw.constant 1 : i2
+// GRAY-DAG:     %{{.+}} = hw.constant -1 : i2
+// GRAY:         sv.case %state_reg : i2
+// GRAY-NEXT:    case b00: {
+// GRAY:         case b01: {
+// GRAY:         case b11: {
+
+// ONEHOT-LABEL: hw.module @top
+// ONEHOT-DAG:     %{{.+}} = hw.constant 1 : i3
+// ONEHOT-DAG:     %{{.+}} = hw.constant 2 : i3
+// ONEHOT-DAG:     %{{.+}} = hw.constant -4 : i3
+// ONEHOT:         sv.case casez %state_reg : i3
+// ONEHOT-NEXT:    case bzz1: {
+// ONEHOT:         case bz1z: {
+// ONEHOT:         case b1zz: {
+
+// The guard shared by the transitions of A and B is only moved once.
+// SHARE-LABEL: hw.module @top
+// SHARE:         comb.and %a0, %a1 : i1
+// SHARE-NOT:     comb.and %a0, %a1 : i1
+
+fsm.machine @top(%a0: i1, %a1: i1) -> (i8) attributes {initialState = "A"} {
+  %c_0 = hw.constant 0 : i8
+  %c_1 = hw.constant 1 : i8
+  %c_2 = hw.constant 2 : i8
+
+  fsm.state @A output {
+    fsm.output %c_0 : i8
+  } transitions {
+    fsm.transition @C guard {
+      %g = comb.and %a0, %a1 : i1
+      fsm.return %g
+    }
+    fsm.transition @B
+  }
+
+  fsm.state @B output {
+    fsm.output %c_1 : i8
+  } transitions {
+    fsm.transition @C guard {
+      %g = comb.and %a0, %a1 : i1
+      fsm.return %g
+    }
+    fsm.transition @A
+  }
+
+  fsm.state @C output {
+    fsm.output %c_2 : i8
+  } transitions {
+    fsm.transition @A
+  }
+}
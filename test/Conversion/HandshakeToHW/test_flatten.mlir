@@ -0,0 +1,44 @@
+// RUN: circt-opt -lower-handshake-to-hw=flatten -split-input-file %s | FileCheck %s
+
+// The fork and the join are built within the module of the function, and are
+// connected through their signals instead of a channel.
+
+// CHECK-NOT:     hw.module @handshake_
+// CHECK-LABEL:   hw.module @test_fork_join(
+// CHECK-SAME:                              %[[IN0:.*]]: !esi.channel<i0>, %[[IN1:.*]]: !esi.channel<i0>, %[[CLOCK:.*]]: i1, %[[RESET:.*]]: i1) -> (out0: !esi.channel<i0>, out1: !esi.channel<i0>) {
+// CHECK-NOT:       hw.instance
+// CHECK:           %[[DATA:.*]], %[[VALID:.*]] = esi.unwrap.vr %[[IN0]], %[[FORK_READY:.*]] : i0
+// CHECK:           seq.compreg {{.*}}, %[[CLOCK]], %[[RESET]]
+// CHECK:           %[[FORK_VALID0:.*]] = comb.and %{{.*}}, %[[VALID]] : i1
+// CHECK:           seq.compreg {{.*}}, %[[CLOCK]], %[[RESET]]
+// CHECK:           %[[FORK_VALID1:.*]] = comb.and %{{.*}}, %[[VALID]] : i1
+// CHECK:           %[[FORK_READY]] = comb.and {{.*}} {sv.namehint = "allDone"} : i1
+// CHECK-NOT:       esi.unwrap.vr
+// CHECK:           %[[OUT0:.*]], %{{.*}} = esi.wrap.vr %{{.*}}, %[[JOIN_VALID:.*]] : i0
+// CHECK-NOT:       esi.wrap.vr
+// CHECK:           %[[JOIN_VALID]] = comb.and %[[FORK_VALID0]], %[[FORK_VALID1]] : i1
+// CHECK:           hw.output %[[OUT0]], %[[IN1]] : !esi.channel<i0>, !esi.channel<i0>
+// CHECK:         }
+// CHECK-NOT:     hw.module @handshake_
+
+handshake.func @test_fork_join(%arg0: none, %arg1: none, ...) -> (none, none) {
+  %0:2 = fork [2] %arg0 : none
+  %1 = join %0#0, %0#1 : none, none
+  return %1, %arg1 : none, none
+}
+
+// -----
+
+// Instances of other functions are kept.
+
+// CHECK-LABEL:   hw.module @foo(
+// CHECK-LABEL:   hw.module @bar(
+// CHECK:           hw.instance "foo0" @foo(
+handshake.func @foo(%in : i32) -> (i32) {
+    handshake.return %in : i32
+}
+
+handshake.func @bar(%in : i32) -> (i32) {
+    %out = handshake.instance @foo(%in) : (i32) -> (i32)
+    handshake.return %out : i32
+}
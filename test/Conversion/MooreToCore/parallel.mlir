@@ -0,0 +1,48 @@
+// RUN: circt-opt %s --convert-moore-to-core --verify-diagnostics | FileCheck %s
+// RUN: circt-opt %s --convert-moore-to-core --verify-diagnostics --mlir-disable-threading | FileCheck %s
+
+// Entities and functions are converted concurrently, each with its own type
+// converter. They refer to each other through symbols only, and share the
+// same typedef chains, whose cached sizes and resolved types are used for the
+// conversion.
+
+// CHECK-LABEL: func @Leaf
+// CHECK-SAME: (%arg0: i8, %arg1: i8, %arg2: i4) -> i8
+func.func @Leaf(%arg0: !moore.packed<named<"Byte", range<bit, 7:0>, loc("a.sv":1:1)>>,
+                %arg1: !moore.packed<ref<named<"Byte", range<bit, 7:0>, loc("a.sv":1:1)>, loc("a.sv":2:1)>>,
+                %arg2: !moore.packed<range<named<"Bit", logic, loc("a.sv":3:1)>, 3:0>>)
+    -> !moore.packed<named<"Byte", range<bit, 7:0>, loc("a.sv":1:1)>> {
+  // CHECK-NEXT: return %arg0 : i8
+  return %arg0 : !moore.packed<named<"Byte", range<bit, 7:0>, loc("a.sv":1:1)>>
+}
+
+// CHECK-LABEL: func @Caller
+// CHECK-SAME: (%arg0: i8, %arg1: i4) -> i8
+func.func @Caller(%arg0: !moore.packed<ref<named<"Byte", range<bit, 7:0>, loc("a.sv":1:1)>, loc("a.sv":2:1)>>,
+                  %arg1: !moore.packed<range<named<"Bit", logic, loc("a.sv":3:1)>, 3:0>>)
+    -> !moore.packed<named<"Byte", range<bit, 7:0>, loc("a.sv":1:1)>> {
+  // CHECK-NEXT: [[TMP:%.+]] = call @Leaf(%arg0, %arg0, %arg1) : (i8, i8, i4) -> i8
+  // CHECK-NEXT: return [[TMP]] : i8
+  %0 = call @Leaf(%arg0, %arg0, %arg1) : (!moore.packed<ref<named<"Byte", range<bit, 7:0>, loc("a.sv":1:1)>, loc("a.sv":2:1)>>, !moore.packed<ref<named<"Byte", range<bit, 7:0>, loc("a.sv":1:1)>, loc("a.sv":2:1)>>, !moore.packed<range<named<"Bit", logic, loc("a.sv":3:1)>, 3:0>>) -> !moore.packed<named<"Byte", range<bit, 7:0>, loc("a.sv":1:1)>>
+  return %0 : !moore.packed<named<"Byte", range<bit, 7:0>, loc("a.sv":1:1)>>
+}
+
+// CHECK-LABEL: llhd.entity @First
+llhd.entity @First() -> () {
+  // CHECK-NEXT: %c5_i32 = hw.constant 5 : i32
+  // CHECK-NEXT: %c3_i32 = hw.constant 3 : i32
+  // CHECK-NEXT: {{%.+}} = llhd.sig "a" %c3_i32 : i32
+  %0 = moore.mir.constant 5 : !moore.int
+  %1 = moore.mir.vardecl "a" = 3 : !moore.int
+  moore.mir.assign %1, %0 : !moore.int
+}
+
+// CHECK-LABEL: llhd.entity @Second
+llhd.entity @Second() -> () {
+  // CHECK-NEXT: %c7_i32 = hw.constant 7 : i32
+  // CHECK-NEXT: %c1_i32 = hw.constant 1 : i32
+  // CHECK-NEXT: {{%.+}} = llhd.sig "b" %c1_i32 : i32
+  %0 = moore.mir.constant 7 : !moore.int
+  %1 = moore.mir.vardecl "b" = 1 : !moore.int
+  moore.mir.assign %1, %0 : !moore.int
+}
@@ -0,0 +1,45 @@
+// RUN: circt-opt --lower-pipeline-to-hw="minimize-regs" %s | FileCheck %s
+// RUN: circt-opt --lower-pipeline-to-hw="minimize-regs clock-gate-regs" %s | FileCheck %s --check-prefix=GATE
+
+// CHECK-LABEL:  hw.module @test0(%arg0: i32, %go: i1, %stall: i1, %clk: i1, %rst: i1) -> (out: i32) {
+// CHECK-NEXT:     %true = hw.constant true
+// CHECK-NEXT:     [[EN:%.+]] = comb.xor %stall, %true : i1
+// CHECK-NEXT:     %c1_i32 = hw.constant 1 : i32
+// CHECK-NEXT:     [[ADD0:%.+]] = comb.add %arg0, %c1_i32 : i32
+// CHECK-NEXT:     %s0_valid = seq.compreg.ce %go, %clk, [[EN]] : i1
+// CHECK-NEXT:     %s0_reg0 = seq.compreg.ce [[ADD0]], %clk, [[EN]] : i32
+// CHECK-NEXT:     %s0_reg1 = seq.compreg.ce %arg0, %clk, [[EN]] : i32
+// CHECK-NEXT:     [[ADD1:%.+]] = comb.add %s0_reg0, %c1_i32 : i32
+// CHECK-NEXT:     %s1_valid = seq.compreg.ce %s0_valid, %clk, [[EN]] : i1
+// CHECK-NEXT:     %s1_reg0 = seq.compreg.ce [[ADD1]], %clk, [[EN]] : i32
+// CHECK-NEXT:     %s1_reg1 = seq.compreg.ce %s0_reg1, %clk, [[EN]] : i32
+// CHECK-NEXT:     [[ADD2:%.+]] = comb.add %s1_reg0, %s1_reg1 : i32
+// CHECK-NEXT:     hw.output [[ADD2]] : i32
+// CHECK-NEXT:   }
+
+// GATE-LABEL:  hw.module @test0
+// GATE:          [[EN:%.+]] = comb.xor %stall, %true : i1
+// GATE:          %s0_valid = seq.compreg.ce %go, %clk, [[EN]] : i1
+// GATE-NEXT:     [[EN0:%.+]] = comb.and %go, [[EN]] : i1
+// GATE-NEXT:     %s0_reg0 = seq.compreg.ce {{%.+}}, %clk, [[EN0]] : i32
+// GATE-NEXT:     %s0_reg1 = seq.compreg.ce %arg0, %clk, [[EN0]] : i32
+// GATE:          %s1_valid = seq.compreg.ce %s0_valid, %clk, [[EN]] : i1
+// GATE-NEXT:     [[EN1:%.+]] = comb.and %s0_valid, [[EN]] : i1
+// GATE-NEXT:     %s1_reg0 = seq.compreg.ce {{%.+}}, %clk, [[EN1]] : i32
+// GATE-NEXT:     %s1_reg1 = seq.compreg.ce %s0_reg1, %clk, [[EN1]] : i32
+
+hw.module @test0(%arg0: i32, %go: i1, %stall: i1, %clk: i1, %rst: i1) -> (out: i32) {
+  %0 = pipeline.pipeline(%arg0, %go) stall %stall clock %clk reset %rst : (i32, i1) -> i32 {
+  ^bb0(%a: i32, %g: i1):
+    %c1 = hw.constant 1 : i32
+    %1 = comb.add %a, %c1 : i32
+    // The constant is forwarded and the second copy of %a is shared.
+    %r:4, %v = pipeline.stage.register when %g regs %1, %a, %a, %c1 : i32, i32, i32, i32
+    %2 = comb.add %r#0, %r#3 : i32
+    // The pass-through copy of %a is shared, and dropped since it is unused.
+    %r2:3, %v2 = pipeline.stage.register when %v regs %2, %r#1, %r#2 : i32, i32, i32
+    %3 = comb.add %r2#0, %r2#1 : i32
+    pipeline.return %3 valid %v2 : i32
+  }
+  hw.output %0 : i32
+}
@@ -0,0 +1,66 @@
+// RUN: circt-opt -lower-std-to-handshake="relax-memory-ordering" %s --split-input-file | FileCheck %s
+
+// The load reads the element next to the one written by the store, so it does
+// not wait for the store to complete.
+
+// CHECK-LABEL:   handshake.func @store_load_offset(
+// CHECK-SAME:                                      %[[VAL_0:.*]]: index,
+// CHECK-SAME:                                      %[[VAL_1:.*]]: none, ...) -> none
+// CHECK:           %[[MEM:.*]]:3 = memory[ld = 1, st = 1]
+// CHECK:           %[[CTRL:.*]] = merge %[[VAL_1]] : none
+// CHECK:           join %[[CTRL]], %[[MEM]]#1, %[[MEM]]#2 : none, none, none
+// CHECK:           store {{\[}}%{{.*}}] %{{.*}}, %[[CTRL]] : index, i32
+// CHECK-NOT:       join
+// CHECK:           load {{\[}}%{{.*}}] %[[MEM]]#0, %[[CTRL]] : index, i32
+// CHECK:           return
+func.func @store_load_offset(%i : index) {
+  %0 = memref.alloc() : memref<4xi32>
+  %c1 = arith.constant 1 : index
+  %c11 = arith.constant 11 : i32
+  %j = arith.addi %i, %c1 : index
+  memref.store %c11, %0[%i] : memref<4xi32>
+  %1 = memref.load %0[%j] : memref<4xi32>
+  return
+}
+
+// -----
+
+// The accesses may alias, so the load still waits for the store.
+
+// CHECK-LABEL:   handshake.func @store_load_unknown(
+// CHECK-SAME:                                       %[[VAL_0:.*]]: index,
+// CHECK-SAME:                                       %[[VAL_1:.*]]: index,
+// CHECK-SAME:                                       %[[VAL_2:.*]]: none, ...) -> none
+// CHECK:           %[[MEM:.*]]:3 = memory[ld = 1, st = 1]
+// CHECK:           %[[CTRL:.*]] = merge %[[VAL_2]] : none
+// CHECK:           store {{\[}}%{{.*}}] %{{.*}}, %[[CTRL]] : index, i32
+// CHECK:           %[[JOIN:.*]] = join %[[CTRL]], %[[MEM]]#1 : none, none
+// CHECK:           load {{\[}}%{{.*}}] %[[MEM]]#0, %[[JOIN]] : index, i32
+func.func @store_load_unknown(%i : index, %j : index) {
+  %0 = memref.alloc() : memref<4xi32>
+  %c11 = arith.constant 11 : i32
+  memref.store %c11, %0[%i] : memref<4xi32>
+  %1 = memref.load %0[%j] : memref<4xi32>
+  return
+}
+
+// -----
+
+// Affine accesses are checked with the affine dependence analysis.
+
+// CHECK-LABEL:   handshake.func @affine_store_store(
+// CHECK-SAME:                                       %[[VAL_0:.*]]: index,
+// CHECK-SAME:                                       %[[VAL_1:.*]]: none, ...) -> none
+// CHECK:           %[[MEM:.*]]:2 = memory[ld = 0, st = 2]
+// CHECK:           %[[CTRL:.*]] = merge %[[VAL_1]] : none
+// CHECK:           store {{\[}}%{{.*}}] %{{.*}}, %[[CTRL]] : index, i32
+// CHECK-NOT:       join
+// CHECK:           store {{\[}}%{{.*}}] %{{.*}}, %[[CTRL]] : index, i32
+// CHECK:           return
+func.func @affine_store_store(%i : index) {
+  %0 = memref.alloc() : memref<8xi32>
+  %c11 = arith.constant 11 : i32
+  affine.store %c11, %0[%i * 2] : memref<8xi32>
+  affine.store %c11, %0[%i * 2 + 1] : memref<8xi32>
+  return
+}
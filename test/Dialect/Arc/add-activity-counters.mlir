@@ -0,0 +1,53 @@
+// RUN: circt-opt %s --arc-add-activity-counters | FileCheck %s
+
+arc.define @Inc(%arg0: i4) -> i4 {
+  %c1_i4 = hw.constant 1 : i4
+  %0 = comb.add %arg0, %c1_i4 : i4
+  arc.output %0 : i4
+}
+
+// CHECK-LABEL: arc.model "Counters"
+arc.model "Counters" {
+^bb0(%arg0: !arc.storage):
+  // CHECK-NEXT: ^bb0
+  // CHECK-NEXT: [[C0:%.+]] = arc.alloc_state %arg0 {name = "arc_profile.calls.Inc.0"} : (!arc.storage) -> !arc.state<i64>
+  // CHECK-NEXT: [[C1:%.+]] = arc.alloc_state %arg0 {name = "arc_profile.calls.Inc.1"} : (!arc.storage) -> !arc.state<i64>
+  // CHECK-NEXT: [[T:%.+]] = arc.alloc_state %arg0 {name = "arc_profile.toggles.r.0"} : (!arc.storage) -> !arc.state<i64>
+  %in_clk = arc.root_input "clk", %arg0 : (!arc.storage) -> !arc.state<i1>
+  %in_en = arc.root_input "en", %arg0 : (!arc.storage) -> !arc.state<i1>
+  %r = arc.alloc_state %arg0 {name = "r"} : (!arc.storage) -> !arc.state<i4>
+  %s = arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i4>
+  %0 = arc.state_read %in_clk : <i1>
+  // CHECK: arc.clock_tree
+  arc.clock_tree %0 {
+    // CHECK-NEXT: [[R:%.+]] = arc.state_read %r
+    // CHECK-NEXT: [[COUNT:%.+]] = arc.state_read [[C0]]
+    // CHECK-NEXT: [[ONE:%.+]] = hw.constant 1 : i64
+    // CHECK-NEXT: [[NEXT:%.+]] = comb.add bin [[COUNT]], [[ONE]] : i64
+    // CHECK-NEXT: arc.state_write [[C0]] = [[NEXT]] : <i64>
+    // CHECK-NEXT: [[X:%.+]] = arc.state @Inc([[R]]) lat 0
+    // CHECK-NEXT: [[COUNT:%.+]] = arc.state_read [[C1]]
+    // CHECK-NEXT: [[ONE:%.+]] = hw.constant 1 : i64
+    // CHECK-NEXT: [[NEXT:%.+]] = comb.add bin [[COUNT]], [[ONE]] : i64
+    // CHECK-NEXT: arc.state_write [[C1]] = [[NEXT]] : <i64>
+    // CHECK-NEXT: [[Y:%.+]] = arc.call @Inc([[X]])
+    // CHECK-NEXT: [[EN:%.+]] = arc.state_read %in_en
+    // CHECK-NEXT: [[OLD:%.+]] = arc.state_read %r
+    // CHECK-NEXT: [[NE:%.+]] = comb.icmp bin ne [[OLD]], [[X]] : i4
+    // CHECK-NEXT: [[CHANGED:%.+]] = comb.and bin [[NE]], [[EN]] : i1
+    // CHECK-NEXT: [[ZEROS:%.+]] = hw.constant 0 : i63
+    // CHECK-NEXT: [[AMOUNT:%.+]] = comb.concat [[ZEROS]], [[CHANGED]] : i63, i1
+    // CHECK-NEXT: [[COUNT:%.+]] = arc.state_read [[T]]
+    // CHECK-NEXT: [[NEXT:%.+]] = comb.add bin [[COUNT]], [[AMOUNT]] : i64
+    // CHECK-NEXT: arc.state_write [[T]] = [[NEXT]] : <i64>
+    // CHECK-NEXT: arc.state_write %r = [[X]] if [[EN]] : <i4>
+    // CHECK-NEXT: arc.state_write %s = [[Y]] : <i4>
+    // CHECK-NEXT: }
+    %1 = arc.state_read %r : <i4>
+    %2 = arc.state @Inc(%1) lat 0 : (i4) -> i4
+    %3 = arc.call @Inc(%2) : (i4) -> i4
+    %4 = arc.state_read %in_en : <i1>
+    arc.state_write %r = %2 if %4 : <i4>
+    arc.state_write %s = %3 : <i4>
+  }
+}
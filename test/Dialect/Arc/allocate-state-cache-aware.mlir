@@ -0,0 +1,34 @@
+// RUN: circt-opt %s --pass-pipeline='builtin.module(arc.model(arc-allocate-state{cache-aware=true cache-line-size=16}))' | FileCheck %s
+
+// CHECK-LABEL: arc.model "CacheAware"
+arc.model "CacheAware" {
+^bb0(%arg0: !arc.storage):
+  // CHECK-NEXT: ({{%.+}}: !arc.storage<66>):
+  // CHECK-NEXT: arc.root_input "clk", {{%.+}} {offset = 0 : i32}
+  // CHECK-NEXT: arc.alloc_state {{%.+}} tap {offset = 64 : i32}
+  // CHECK-NEXT: arc.alloc_state {{%.+}} {offset = 65 : i32}
+  // CHECK-NEXT: arc.alloc_state {{%.+}} {offset = 32 : i32}
+  // CHECK-NEXT: arc.alloc_state {{%.+}} {offset = 48 : i32}
+  // CHECK-NEXT: arc.alloc_state {{%.+}} {offset = 1 : i32}
+  // CHECK-NEXT: arc.alloc_state {{%.+}} {offset = 16 : i32}
+  // CHECK-NEXT: arc.alloc_memory {{%.+}} {offset = 60 : i32, stride = 1 : i32}
+  %clk = arc.root_input "clk", %arg0 : (!arc.storage) -> !arc.state<i1>
+  %tap = arc.alloc_state %arg0 tap : (!arc.storage) -> !arc.state<i8>
+  %w = arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i8>
+  %a = arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i8>
+  %c = arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i96>
+  %b = arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i8>
+  %wide = arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i128>
+  %mem = arc.alloc_memory %arg0 : (!arc.storage) -> !arc.memory<4 x i8, i2>
+  %0 = arc.state_read %clk : <i1>
+  arc.clock_tree %0 {
+    %1 = arc.state_read %b : <i8>
+    %2 = arc.state_read %wide : <i128>
+    arc.state_write %tap = %1 : <i8>
+  }
+  arc.clock_tree %0 {
+    %1 = arc.state_read %a : <i8>
+    %2 = arc.state_read %c : <i96>
+    arc.state_write %w = %1 : <i8>
+  }
+}
@@ -0,0 +1,15 @@
+// RUN: circt-opt %s --pass-pipeline='builtin.module(arc.model(arc-allocate-state{lanes=4}))' | FileCheck %s
+
+// CHECK-LABEL: arc.model "lanes"
+arc.model "lanes" {
+^bb0(%arg0: !arc.storage):
+  // CHECK-NEXT: ({{%.+}}: !arc.storage<48>):
+  // CHECK-NEXT: arc.root_input "a", {{%.+}} {offset = 0 : i32}
+  // CHECK-NEXT: arc.alloc_state {{%.+}} {offset = 8 : i32}
+  // CHECK-NEXT: arc.alloc_state {{%.+}} {offset = 16 : i32}
+  // CHECK-NEXT: arc.alloc_memory {{%.+}} {offset = 32 : i32, stride = 1 : i32}
+  arc.root_input "a", %arg0 : (!arc.storage) -> !arc.state<i1>
+  arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i16>
+  arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i24>
+  arc.alloc_memory %arg0 : (!arc.storage) -> !arc.memory<4 x i8, i2>
+}
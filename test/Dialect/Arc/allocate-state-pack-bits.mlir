@@ -0,0 +1,41 @@
+// RUN: circt-opt %s --pass-pipeline='builtin.module(arc.model(arc-allocate-state{pack-bits}))' | FileCheck %s
+
+// CHECK-LABEL: arc.model "bits"
+arc.model "bits" {
+^bb0(%arg0: !arc.storage):
+  // CHECK-NEXT: ({{%.+}}: !arc.storage<5>):
+  // CHECK-NEXT: arc.root_input "a", {{%.+}} {offset = 0 : i32}
+  // CHECK-NEXT: arc.alloc_state {{%.+}} {bit = 0 : i32, offset = 1 : i32}
+  // CHECK-NEXT: arc.alloc_state {{%.+}} {bit = 1 : i32, offset = 1 : i32}
+  // CHECK-NEXT: arc.alloc_state {{%.+}} {offset = 2 : i32}
+  // CHECK-NEXT: arc.alloc_state {{%.+}} {bit = 0 : i32, offset = 3 : i32}
+  // CHECK-NEXT: arc.alloc_state {{%.+}} {offset = 4 : i32}
+  %in = arc.root_input "a", %arg0 : (!arc.storage) -> !arc.state<i1>
+  %0 = arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i1>
+  %1 = arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i1>
+  %2 = arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i8>
+  %3 = arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i1>
+  %4 = arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i1>
+  %true = hw.constant true
+
+  // CHECK: arc.clock_tree
+  arc.clock_tree %true {
+    // CHECK-NEXT: [[S0:%.+]] = arc.storage.get {{%.+}}[1] {bit = 0 : i32} : !arc.storage<5> -> !arc.state<i1>
+    // CHECK-NEXT: [[V:%.+]] = arc.state_read [[S0]]
+    // CHECK-NEXT: [[S1:%.+]] = arc.storage.get {{%.+}}[1] {bit = 1 : i32} : !arc.storage<5> -> !arc.state<i1>
+    // CHECK-NEXT: arc.state_write [[S1]] = [[V]]
+    %5 = arc.state_read %0 : <i1>
+    arc.state_write %1 = %5 : <i1>
+    // Accessed from two clock trees, so not packed.
+    // CHECK-NEXT: arc.storage.get {{%.+}}[4] : !arc.storage<5> -> !arc.state<i1>
+    arc.state_write %4 = %5 : <i1>
+  }
+
+  // States accessed from another clock tree get their own byte.
+  // CHECK: arc.clock_tree
+  arc.clock_tree %true {
+    // CHECK-NEXT: arc.storage.get {{%.+}}[3] {bit = 0 : i32} : !arc.storage<5> -> !arc.state<i1>
+    %6 = arc.state_read %3 : <i1>
+    arc.state_write %4 = %6 : <i1>
+  }
+}
@@ -77,3 +77,13 @@ arc.model "test" {
   }
   // CHECK-NEXT: }
 }
+
+// CHECK-LABEL: arc.model "sparse"
+arc.model "sparse" {
+^bb0(%arg0: !arc.storage):
+  // CHECK-NEXT: ({{%.+}}: !arc.storage<33>):
+  // CHECK-NEXT: arc.alloc_memory {{%.+}} {offset = 0 : i32, stride = 4 : i32}
+  // CHECK-NEXT: arc.alloc_state {{%.+}} {offset = 32 : i32}
+  arc.alloc_memory %arg0 : (!arc.storage) -> !arc.memory<1024 x i32, i10, sparse 256>
+  arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i1>
+}
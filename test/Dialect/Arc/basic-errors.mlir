@@ -337,3 +337,26 @@ arc.define @outputOpVerifier () -> i32 {
   // expected-note @+1 {{actual type: 'i16'}}
   arc.output %0 : i16
 }
+
+// -----
+
+// expected-error @+1 {{number of words per page must be a power of two, but got 3}}
+func.func @sparseMemoryPageSize(%arg0: !arc.memory<16 x i8, i4, sparse 3>) {
+  return
+}
+
+// -----
+
+func.func @packedBitOfWideState(%arg0: !arc.storage<8>) {
+  // expected-error @+1 {{'arc.storage.get' op with bit offset must access an `i1` state}}
+  %0 = arc.storage.get %arg0[0] {bit = 0 : i32} : !arc.storage<8> -> !arc.state<i8>
+  return
+}
+
+// -----
+
+func.func @packedBitOutOfRange(%arg0: !arc.storage<8>) {
+  // expected-error @+1 {{'arc.storage.get' op bit offset must be less than 8}}
+  %0 = arc.storage.get %arg0[0] {bit = 8 : i32} : !arc.storage<8> -> !arc.state<i1>
+  return
+}
@@ -59,9 +59,11 @@ func.func @StorageAccess(%arg0: !arc.storage<10000>) {
   // CHECK-NEXT: arc.storage.get %arg0[42] : !arc.storage<10000> -> !arc.state<i9>
   // CHECK-NEXT: arc.storage.get %arg0[1337] : !arc.storage<10000> -> !arc.memory<4 x i19, i32>
   // CHECK-NEXT: arc.storage.get %arg0[9001] : !arc.storage<10000> -> !arc.storage<123>
+  // CHECK-NEXT: arc.storage.get %arg0[9002] : !arc.storage<10000> -> !arc.memory<65536 x i19, i32, sparse 1024>
   %0 = arc.storage.get %arg0[42] : !arc.storage<10000> -> !arc.state<i9>
   %1 = arc.storage.get %arg0[1337] : !arc.storage<10000> -> !arc.memory<4 x i19, i32>
   %2 = arc.storage.get %arg0[9001] : !arc.storage<10000> -> !arc.storage<123>
+  %3 = arc.storage.get %arg0[9002] : !arc.storage<10000> -> !arc.memory<65536 x i19, i32, sparse 1024>
   return
 }
 
@@ -0,0 +1,67 @@
+// RUN: circt-opt %s --pass-pipeline='builtin.module(arc.model(arc-coalesce-state-writes))' | FileCheck %s
+
+// CHECK-LABEL: arc.model "Adjacent"
+arc.model "Adjacent" {
+^bb0(%arg0: !arc.storage<16>):
+  %true = hw.constant true
+  %c0_i8 = hw.constant 0 : i8
+  %c0_i16 = hw.constant 0 : i16
+  // CHECK: scf.if
+  scf.if %true {
+    // CHECK-NEXT: [[V:%.+]] = comb.concat %c0_i16, %c0_i8, %c0_i8 : i16, i8, i8
+    // CHECK-NEXT: [[S:%.+]] = arc.storage.get %arg0[0] : !arc.storage<16> -> !arc.state<i32>
+    // CHECK-NEXT: arc.state_write [[S]] = [[V]] : <i32>
+    // CHECK-NEXT: }
+    %0 = arc.storage.get %arg0[0] : !arc.storage<16> -> !arc.state<i8>
+    arc.state_write %0 = %c0_i8 : <i8>
+    %1 = arc.storage.get %arg0[1] : !arc.storage<16> -> !arc.state<i8>
+    arc.state_write %1 = %c0_i8 : <i8>
+    %2 = arc.storage.get %arg0[2] : !arc.storage<16> -> !arc.state<i16>
+    arc.state_write %2 = %c0_i16 : <i16>
+  }
+}
+
+// CHECK-LABEL: arc.model "NotMerged"
+arc.model "NotMerged" {
+^bb0(%arg0: !arc.storage<16>):
+  %en = hw.constant false
+  %c0_i8 = hw.constant 0 : i8
+  %c0_i5 = hw.constant 0 : i5
+  // A gap between the states.
+  // CHECK: arc.state_write {{%.+}} = %c0_i8 : <i8>
+  // CHECK: arc.state_write {{%.+}} = %c0_i8 : <i8>
+  %0 = arc.storage.get %arg0[0] : !arc.storage<16> -> !arc.state<i8>
+  arc.state_write %0 = %c0_i8 : <i8>
+  %1 = arc.storage.get %arg0[2] : !arc.storage<16> -> !arc.state<i8>
+  arc.state_write %1 = %c0_i8 : <i8>
+  // Different conditions.
+  // CHECK: arc.state_write {{%.+}} = %c0_i8 if %false : <i8>
+  // CHECK: arc.state_write {{%.+}} = %c0_i8 : <i8>
+  %2 = arc.storage.get %arg0[4] : !arc.storage<16> -> !arc.state<i8>
+  arc.state_write %2 = %c0_i8 if %en : <i8>
+  %3 = arc.storage.get %arg0[5] : !arc.storage<16> -> !arc.state<i8>
+  arc.state_write %3 = %c0_i8 : <i8>
+  // A read in between.
+  // CHECK: arc.state_write {{%.+}} = %c0_i8 : <i8>
+  // CHECK: arc.state_read
+  // CHECK: arc.state_write {{%.+}} = %c0_i8 : <i8>
+  %4 = arc.storage.get %arg0[6] : !arc.storage<16> -> !arc.state<i8>
+  arc.state_write %4 = %c0_i8 : <i8>
+  %5 = arc.state_read %4 : <i8>
+  %6 = arc.storage.get %arg0[7] : !arc.storage<16> -> !arc.state<i8>
+  arc.state_write %6 = %c0_i8 : <i8>
+  // Not a whole number of bytes.
+  // CHECK: arc.state_write {{%.+}} = %c0_i5 : <i5>
+  // CHECK: arc.state_write {{%.+}} = %c0_i8 : <i8>
+  %7 = arc.storage.get %arg0[8] : !arc.storage<16> -> !arc.state<i5>
+  arc.state_write %7 = %c0_i5 : <i5>
+  %8 = arc.storage.get %arg0[9] : !arc.storage<16> -> !arc.state<i8>
+  arc.state_write %8 = %c0_i8 : <i8>
+  // Misaligned for the combined size.
+  // CHECK: arc.state_write {{%.+}} = %c0_i8 : <i8>
+  // CHECK: arc.state_write {{%.+}} = %c0_i8 : <i8>
+  %9 = arc.storage.get %arg0[11] : !arc.storage<16> -> !arc.state<i8>
+  arc.state_write %9 = %c0_i8 : <i8>
+  %10 = arc.storage.get %arg0[12] : !arc.storage<16> -> !arc.state<i8>
+  arc.state_write %10 = %c0_i8 : <i8>
+}
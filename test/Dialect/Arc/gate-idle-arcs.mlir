@@ -0,0 +1,89 @@
+// RUN: circt-opt %s --arc-gate-idle-arcs=min-body-ops=2 | FileCheck %s
+
+arc.define @Expensive(%arg0: i4) -> i4 {
+  %0 = comb.add %arg0, %arg0 : i4
+  %1 = comb.mul %0, %arg0 : i4
+  arc.output %1 : i4
+}
+
+arc.define @Cheap(%arg0: i4) -> i4 {
+  %0 = comb.add %arg0, %arg0 : i4
+  arc.output %0 : i4
+}
+
+// CHECK-LABEL: arc.model "Enables"
+arc.model "Enables" {
+^bb0(%arg0: !arc.storage):
+  %in_clk = arc.root_input "clk", %arg0 : (!arc.storage) -> !arc.state<i1>
+  %in_en = arc.root_input "en", %arg0 : (!arc.storage) -> !arc.state<i1>
+  %0 = arc.state_read %in_clk : <i1>
+  // CHECK:      [[SHADOW_X:%.+]] = arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i4>
+  // CHECK-NEXT: [[SHADOW_EN:%.+]] = arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i1>
+  // CHECK-NEXT: [[VALID:%.+]] = arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i1>
+  // CHECK-NEXT: arc.clock_tree
+  arc.clock_tree %0 {
+    // CHECK-NEXT: [[X:%.+]] = arc.state_read [[S0:%.+]] : <i4>
+    // CHECK-NEXT: [[EN:%.+]] = arc.state_read %in_en : <i1>
+    // CHECK-NEXT: [[TRUE:%.+]] = hw.constant true
+    // CHECK-NEXT: [[V:%.+]] = arc.state_read [[VALID]] : <i1>
+    // CHECK-NEXT: [[NOTV:%.+]] = comb.xor bin [[V]], [[TRUE]] : i1
+    // CHECK-NEXT: [[OLDX:%.+]] = arc.state_read [[SHADOW_X]] : <i4>
+    // CHECK-NEXT: [[CX:%.+]] = comb.icmp bin ne [[X]], [[OLDX]] : i4
+    // CHECK-NEXT: [[OLDEN:%.+]] = arc.state_read [[SHADOW_EN]] : <i1>
+    // CHECK-NEXT: [[CEN:%.+]] = comb.icmp bin ne [[EN]], [[OLDEN]] : i1
+    // CHECK-NEXT: [[CHANGED:%.+]] = comb.or bin [[NOTV]], [[CX]], [[CEN]] : i1
+    // CHECK-NEXT: scf.if [[CHANGED]] {
+    // CHECK-NEXT:   arc.state_write [[SHADOW_X]] = [[X]] : <i4>
+    // CHECK-NEXT:   arc.state_write [[SHADOW_EN]] = [[EN]] : <i1>
+    // CHECK-NEXT:   arc.state_write [[VALID]] = [[TRUE]] : <i1>
+    // CHECK-NEXT:   [[Y:%.+]] = arc.state @Expensive([[X]]) lat 0
+    // CHECK-NEXT:   arc.state_write [[S0]] = [[Y]] if [[EN]] : <i4>
+    // CHECK-NEXT: }
+    // CHECK-NEXT: [[Z:%.+]] = arc.state @Cheap([[X]]) lat 0
+    // CHECK-NEXT: arc.state_write [[S1:%.+]] = [[Z]] : <i4>
+    // CHECK-NEXT: }
+    %1 = arc.state_read %s0 : <i4>
+    %2 = arc.state @Expensive(%1) lat 0 : (i4) -> i4
+    %3 = arc.state_read %in_en : <i1>
+    arc.state_write %s0 = %2 if %3 : <i4>
+    %4 = arc.state @Cheap(%1) lat 0 : (i4) -> i4
+    arc.state_write %s1 = %4 : <i4>
+  }
+  %s0 = arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i4>
+  %s1 = arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i4>
+}
+
+// CHECK-LABEL: arc.model "Resets"
+arc.model "Resets" {
+^bb0(%arg0: !arc.storage):
+  %in_clk = arc.root_input "clk", %arg0 : (!arc.storage) -> !arc.state<i1>
+  %in_rst = arc.root_input "rst", %arg0 : (!arc.storage) -> !arc.state<i1>
+  %0 = arc.state_read %in_clk : <i1>
+  // CHECK:      [[SHADOW_X:%.+]] = arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i4>
+  // CHECK-NEXT: [[VALID:%.+]] = arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i1>
+  // CHECK-NEXT: arc.clock_tree
+  arc.clock_tree %0 {
+    // CHECK:      scf.if {{%.+}} {
+    // CHECK-NEXT:   arc.state_write [[S0:%.+]] = {{%.+}} : <i4>
+    // CHECK-NEXT:   [[FALSE:%.+]] = hw.constant false
+    // CHECK-NEXT:   arc.state_write [[VALID]] = [[FALSE]] : <i1>
+    // CHECK-NEXT: } else {
+    // CHECK:        scf.if {{%.+}} {
+    // CHECK-NEXT:     arc.state_write [[SHADOW_X]] = {{%.+}} : <i4>
+    // CHECK-NEXT:     arc.state_write [[VALID]] = {{%.+}} : <i1>
+    // CHECK-NEXT:     [[Y:%.+]] = arc.state @Expensive({{%.+}}) lat 0
+    // CHECK-NEXT:     arc.state_write [[S0]] = [[Y]] : <i4>
+    // CHECK-NEXT:   }
+    // CHECK-NEXT: }
+    %1 = arc.state_read %in_rst : <i1>
+    %2 = arc.state_read %s0 : <i4>
+    scf.if %1 {
+      %c0_i4 = hw.constant 0 : i4
+      arc.state_write %s0 = %c0_i4 : <i4>
+    } else {
+      %3 = arc.state @Expensive(%2) lat 0 : (i4) -> i4
+      arc.state_write %s0 = %3 : <i4>
+    }
+  }
+  %s0 = arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i4>
+}
@@ -0,0 +1,16 @@
+// RUN: circt-opt %s --arc-infer-memories='sparse-threshold=512 page-size=64' | FileCheck %s
+
+hw.generator.schema @FIRRTLMem, "FIRRTL_Memory", ["depth", "numReadPorts", "numWritePorts", "numReadWritePorts", "readLatency", "writeLatency", "width", "maskGran", "readUnderWrite", "writeUnderWrite", "writeClockIDs"]
+
+// CHECK-LABEL: hw.module @TestSparse(
+hw.module @TestSparse(%clock: i1, %addr: i10, %enable: i1) -> (large: i16, small: i16) {
+  // CHECK-NEXT: [[LARGE:%.+]] = arc.memory <1024 x i16, i10, sparse 32> {name = "large"}
+  // CHECK-NEXT: arc.memory_read_port [[LARGE]][%addr] : <1024 x i16, i10, sparse 32>
+  // CHECK-NEXT: [[SMALL:%.+]] = arc.memory <256 x i16, i10> {name = "small"}
+  // CHECK-NEXT: arc.memory_read_port [[SMALL]][%addr] : <256 x i16, i10>
+  %0 = hw.instance "large" @LargeMemory(R0_addr: %addr: i10, R0_en: %enable: i1, R0_clk: %clock: i1) -> (R0_data: i16)
+  %1 = hw.instance "small" @SmallMemory(R0_addr: %addr: i10, R0_en: %enable: i1, R0_clk: %clock: i1) -> (R0_data: i16)
+  hw.output %0, %1 : i16, i16
+}
+hw.module.generated @LargeMemory, @FIRRTLMem(%R0_addr: i10, %R0_en: i1, %R0_clk: i1) -> (R0_data: i16) attributes {depth = 1024 : i64, maskGran = 16 : ui32, numReadPorts = 1 : ui32, numReadWritePorts = 0 : ui32, numWritePorts = 0 : ui32, readLatency = 0 : ui32, readUnderWrite = 0 : ui32, width = 16 : ui32, writeClockIDs = [], writeLatency = 1 : ui32, writeUnderWrite = 1 : i32}
+hw.module.generated @SmallMemory, @FIRRTLMem(%R0_addr: i10, %R0_en: i1, %R0_clk: i1) -> (R0_data: i16) attributes {depth = 256 : i64, maskGran = 16 : ui32, numReadPorts = 1 : ui32, numReadWritePorts = 0 : ui32, numWritePorts = 0 : ui32, readLatency = 0 : ui32, readUnderWrite = 0 : ui32, width = 16 : ui32, writeClockIDs = [], writeLatency = 1 : ui32, writeUnderWrite = 1 : i32}
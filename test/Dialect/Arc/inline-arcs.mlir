@@ -183,3 +183,61 @@ arc.define @sub2(%arg0: i4, %arg1: i4) -> i4 {
   %0 = comb.add %arg0, %arg1 : i4
   arc.output %0 : i4
 }
+
+//--- profile
+// RUN: circt-opt %t/profile --arc-inline=profile=%t/profile.json | FileCheck %t/profile
+// RUN: not circt-opt %t/profile --arc-inline=profile=%t/missing.json 2>&1 | FileCheck %t/profile --check-prefix=ERR
+
+// ERR: error: cannot read profile
+
+// CHECK-LABEL: hw.module @profile
+hw.module @profile(%arg0: i4, %arg1: i4) -> (out0: i4, out1: i4, out2: i4, out3: i4, out4: i4) {
+  // CHECK-NEXT: arc.state @Cold(%arg0, %arg1)
+  // CHECK-NEXT: comb.mul
+  // CHECK-NEXT: comb.mul
+  // CHECK-NEXT: comb.mul
+  // CHECK-NEXT: comb.mul
+  // CHECK-NEXT: comb.mul
+  // CHECK-NEXT: comb.mul
+  // CHECK-NEXT: comb.mul
+  // CHECK-NEXT: comb.mul
+  // CHECK-NEXT: arc.state @Warm(%arg0, %arg1)
+  // CHECK-NEXT: arc.state @Warm(%arg1, %arg0)
+  %0 = arc.state @Cold(%arg0, %arg1) lat 0 : (i4, i4) -> i4
+  %1 = arc.state @Hot(%arg0, %arg1) lat 0 : (i4, i4) -> i4
+  %2 = arc.state @Hot(%arg1, %arg0) lat 0 : (i4, i4) -> i4
+  %3 = arc.state @Warm(%arg0, %arg1) lat 0 : (i4, i4) -> i4
+  %4 = arc.state @Warm(%arg1, %arg0) lat 0 : (i4, i4) -> i4
+  hw.output %0, %1, %2, %3, %4 : i4, i4, i4, i4, i4
+}
+// CHECK-LABEL: arc.define @Cold
+arc.define @Cold(%arg0: i4, %arg1: i4) -> i4 {
+  %0 = comb.mul %arg0, %arg1 : i4
+  %1 = comb.mul %0, %arg1 : i4
+  %2 = comb.mul %1, %arg1 : i4
+  %3 = comb.mul %2, %arg1 : i4
+  arc.output %3 : i4
+}
+// CHECK-NOT: arc.define @Hot
+arc.define @Hot(%arg0: i4, %arg1: i4) -> i4 {
+  %0 = comb.mul %arg0, %arg1 : i4
+  %1 = comb.mul %0, %arg1 : i4
+  %2 = comb.mul %1, %arg1 : i4
+  %3 = comb.mul %2, %arg1 : i4
+  arc.output %3 : i4
+}
+// CHECK-LABEL: arc.define @Warm
+arc.define @Warm(%arg0: i4, %arg1: i4) -> i4 {
+  %0 = comb.mul %arg0, %arg1 : i4
+  %1 = comb.mul %0, %arg1 : i4
+  %2 = comb.mul %1, %arg1 : i4
+  %3 = comb.mul %2, %arg1 : i4
+  arc.output %3 : i4
+}
+
+//--- profile.json
+{
+  "cycles": 10,
+  "calls": {"Cold": 0, "Hot": 20, "Warm": 5},
+  "toggles": {}
+}
@@ -0,0 +1,32 @@
+// RUN: circt-opt %s --arc-inline-modules=max-size=3 | FileCheck %s
+// RUN: circt-opt %s --arc-inline-modules="max-size=3 max-growth=2" | FileCheck %s --check-prefix=GROWTH
+
+// CHECK-LABEL: hw.module @Top
+// CHECK-NOT:     hw.instance "small
+// CHECK:         hw.instance "big" @Big
+// CHECK-NOT:   hw.module private @Small
+// CHECK:       hw.module private @Big
+
+// GROWTH-LABEL: hw.module @Top
+// GROWTH:         hw.instance "small0" @Small
+// GROWTH:         hw.instance "small1" @Small
+// GROWTH:         hw.instance "big" @Big
+hw.module @Top(%x: i4) -> (y: i4) {
+  %0 = hw.instance "small0" @Small(x: %x: i4) -> (y: i4)
+  %1 = hw.instance "small1" @Small(x: %0: i4) -> (y: i4)
+  %2 = hw.instance "big" @Big(x: %1: i4) -> (y: i4)
+  hw.output %2 : i4
+}
+
+hw.module private @Small(%x: i4) -> (y: i4) {
+  %0 = comb.add %x, %x : i4
+  %1 = comb.mul %0, %x : i4
+  hw.output %1 : i4
+}
+
+hw.module private @Big(%x: i4) -> (y: i4) {
+  %0 = comb.add %x, %x : i4
+  %1 = comb.mul %0, %x : i4
+  %2 = comb.xor %1, %x : i4
+  hw.output %2 : i4
+}
@@ -0,0 +1,63 @@
+// RUN: circt-opt %s --arc-lower-clocks-to-funcs=max-ops-per-func=2 | FileCheck %s
+
+// CHECK-LABEL: func.func @Split_passthrough_split0(%arg0: !arc.storage<42>) {
+// CHECK-NEXT:    %c1_i8 = hw.constant 1 : i8
+// CHECK-NEXT:    [[S0:%.+]] = arc.storage.get %arg0[0]
+// CHECK-NEXT:    [[R0:%.+]] = arc.state_read [[S0]]
+// CHECK-NEXT:    [[V0:%.+]] = comb.add [[R0]], %c1_i8
+// CHECK-NEXT:    arc.state_write [[S0]] = [[V0]]
+// CHECK-NEXT:    return
+// CHECK-NEXT:  }
+
+// CHECK-LABEL: func.func @Split_passthrough_split1(%arg0: !arc.storage<42>) {
+// CHECK-NEXT:    %c1_i8 = hw.constant 1 : i8
+// CHECK-NEXT:    [[S1:%.+]] = arc.storage.get %arg0[1]
+// CHECK-NEXT:    [[R1:%.+]] = arc.state_read [[S1]]
+// CHECK-NEXT:    [[V1:%.+]] = comb.xor [[R1]], %c1_i8
+// CHECK-NEXT:    arc.state_write [[S1]] = [[V1]]
+// CHECK-NEXT:    return
+// CHECK-NEXT:  }
+
+// CHECK-LABEL: func.func @Split_passthrough(%arg0: !arc.storage<42>) {
+// CHECK-NEXT:    call @Split_passthrough_split0(%arg0)
+// CHECK-NEXT:    call @Split_passthrough_split1(%arg0)
+// CHECK-NEXT:    return
+// CHECK-NEXT:  }
+
+arc.model "Split" {
+^bb0(%arg0: !arc.storage<42>):
+  arc.passthrough {
+    %c1_i8 = hw.constant 1 : i8
+    %0 = arc.storage.get %arg0[0] : !arc.storage<42> -> !arc.state<i8>
+    %1 = arc.state_read %0 : <i8>
+    %2 = comb.add %1, %c1_i8 : i8
+    arc.state_write %0 = %2 : <i8>
+    %3 = arc.storage.get %arg0[1] : !arc.storage<42> -> !arc.state<i8>
+    %4 = arc.state_read %3 : <i8>
+    %5 = comb.xor %4, %c1_i8 : i8
+    arc.state_write %3 = %5 : <i8>
+  }
+}
+
+//===----------------------------------------------------------------------===//
+
+// Values other than constants live across a potential split point prevent the
+// split.
+
+// CHECK-LABEL: func.func @NoSplit_passthrough(%arg0: !arc.storage<42>) {
+// CHECK-NOT:     call
+// CHECK:         comb.add
+// CHECK-NOT:     call
+// CHECK:         return
+
+arc.model "NoSplit" {
+^bb0(%arg0: !arc.storage<42>):
+  arc.passthrough {
+    %0 = arc.storage.get %arg0[0] : !arc.storage<42> -> !arc.state<i8>
+    %1 = arc.state_read %0 : <i8>
+    %2 = comb.xor %1, %1 : i8
+    %3 = comb.xor %2, %1 : i8
+    %4 = comb.add %3, %1 : i8
+    arc.state_write %0 = %4 : <i8>
+  }
+}
@@ -86,3 +86,86 @@ arc.model "InsertionOrderProblem" {
     }
   }
 }
+
+//===----------------------------------------------------------------------===//
+
+// The partitions of a clock tree get their own functions, and the clock
+// function evaluates them in order.
+
+// CHECK-LABEL: func.func @Partitioned_clock_part0(%arg0: !arc.storage<42>) {
+// CHECK-NEXT:    hw.constant 0 : i42
+// CHECK-NEXT:    return
+// CHECK-NEXT:  }
+
+// CHECK-LABEL: func.func @Partitioned_clock_part1(%arg0: !arc.storage<42>) {
+// CHECK-NEXT:    hw.constant 1 : i42
+// CHECK-NEXT:    return
+// CHECK-NEXT:  }
+
+// CHECK-LABEL: func.func @Partitioned_clock_commit(%arg0: !arc.storage<42>) {
+// CHECK-NEXT:    hw.constant 2 : i42
+// CHECK-NEXT:    return
+// CHECK-NEXT:  }
+
+// CHECK-LABEL: func.func @Partitioned_clock(%arg0: !arc.storage<42>) {
+// CHECK-NEXT:    call @Partitioned_clock_part0(%arg0) : (!arc.storage<42>) -> ()
+// CHECK-NEXT:    call @Partitioned_clock_part1(%arg0) : (!arc.storage<42>) -> ()
+// CHECK-NEXT:    call @Partitioned_clock_commit(%arg0) : (!arc.storage<42>) -> ()
+// CHECK-NEXT:    return
+// CHECK-NEXT:  }
+
+// CHECK-LABEL: arc.model "Partitioned" {
+arc.model "Partitioned" {
+^bb0(%arg0: !arc.storage<42>):
+  %true = hw.constant true
+  arc.clock_tree %true attributes {arc.partition = 0 : i32} {
+    hw.constant 0 : i42
+  }
+  arc.clock_tree %true attributes {arc.partition = 1 : i32} {
+    hw.constant 1 : i42
+  }
+  arc.clock_tree %true attributes {arc.partition_commit} {
+    hw.constant 2 : i42
+  }
+}
+
+//===----------------------------------------------------------------------===//
+
+// CHECK-LABEL: func.func @MultiClock_clock(%arg0: !arc.storage<42>) {
+// CHECK-NEXT:    %true = hw.constant true
+// CHECK-NEXT:    hw.constant 0 : i42
+// CHECK-NEXT:    return
+// CHECK-NEXT:  }
+
+// CHECK-LABEL: func.func @MultiClock_clock_0(%arg0: !arc.storage<42>) {
+// CHECK-NEXT:    %true = hw.constant true
+// CHECK-NEXT:    hw.constant 1 : i42
+// CHECK-NEXT:    return
+// CHECK-NEXT:  }
+
+// CHECK-LABEL: func.func @MultiClock_clock_1(%arg0: !arc.storage<42>) {
+// CHECK-NEXT:    %true = hw.constant true
+// CHECK-NEXT:    hw.constant 2 : i42
+// CHECK-NEXT:    return
+// CHECK-NEXT:  }
+
+// CHECK-LABEL: arc.model "MultiClock" {
+// CHECK-NEXT:  ^bb0(%arg0: !arc.storage<42>):
+// CHECK-NEXT:    func.call @MultiClock_clock(%arg0)
+// CHECK-NEXT:    func.call @MultiClock_clock_0(%arg0)
+// CHECK-NEXT:    func.call @MultiClock_clock_1(%arg0)
+// CHECK-NEXT:  }
+
+arc.model "MultiClock" {
+^bb0(%arg0: !arc.storage<42>):
+  %true = hw.constant true
+  arc.clock_tree %true {
+    hw.constant 0 : i42
+  }
+  arc.clock_tree %true {
+    hw.constant 1 : i42
+  }
+  arc.clock_tree %true {
+    hw.constant 2 : i42
+  }
+}
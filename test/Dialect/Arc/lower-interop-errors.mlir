@@ -0,0 +1,42 @@
+// RUN: circt-opt %s --arc-lower-interop --split-input-file --verify-diagnostics
+
+hw.module @Mechanism(%x: i32) -> (y: i32) {
+  // expected-error @below {{with a mechanism other than `cffi` is not supported in arc models}}
+  %0 = interop.procedural.update cpp (%x) : (i32) -> i32 {
+  ^bb0(%arg0: i32):
+    interop.return %arg0 : i32
+  }
+  hw.output %0 : i32
+}
+
+// -----
+
+hw.module @State(%x: i32) -> (y: i32) {
+  // expected-error @below {{'interop.procedural.alloc' op is not supported in arc models; the foreign side has to keep its state itself}}
+  %state = interop.procedural.alloc cffi : !llvm.ptr
+  hw.output %x : i32
+}
+
+// -----
+
+hw.module @NoResults(%x: i32) {
+  // expected-error @below {{without results is not supported in arc models}}
+  interop.procedural.update cffi (%x) : (i32) -> () {
+  ^bb0(%arg0: i32):
+    interop.return
+  }
+}
+
+// -----
+
+hw.module @Captured(%x: i32) -> (y: i32) {
+  // expected-note @below {{value defined here}}
+  %z = comb.mul %x, %x : i32
+  // expected-error @below {{uses a non-constant value defined outside of it; pass it as an input instead}}
+  %0 = interop.procedural.update cffi (%x) : (i32) -> i32 {
+  ^bb0(%arg0: i32):
+    %1 = comb.add %arg0, %z : i32
+    interop.return %1 : i32
+  }
+  hw.output %0 : i32
+}
@@ -0,0 +1,34 @@
+// RUN: circt-opt %s --arc-lower-interop | FileCheck %s
+
+func.func private @dram_read(i32, i1) -> i32
+
+// CHECK-LABEL: func.func private @Foo_interop(%arg0: i32, %arg1: i1) -> i32 {
+// CHECK-NEXT:    [[R:%.+]] = call @dram_read(%arg0, %arg1) : (i32, i1) -> i32
+// CHECK-NEXT:    return [[R]] : i32
+// CHECK-NEXT:  }
+
+// CHECK-LABEL: func.func private @Foo_interop_0(%arg0: i8) -> (i8, i8) {
+// CHECK-NEXT:    %c1_i8 = hw.constant 1 : i8
+// CHECK-NEXT:    [[X:%.+]] = comb.add %arg0, %c1_i8 : i8
+// CHECK-NEXT:    return [[X]], %arg0 : i8, i8
+// CHECK-NEXT:  }
+
+// CHECK-LABEL: hw.module @Foo
+hw.module @Foo(%addr: i32, %en: i1, %x: i8) -> (data: i32, y: i8, z: i8) {
+  // CHECK-NEXT: [[DATA:%.+]] = func.call @Foo_interop(%addr, %en) : (i32, i1) -> i32
+  %0 = interop.procedural.update cffi (%addr, %en) : (i32, i1) -> i32 {
+  ^bb0(%arg0: i32, %arg1: i1):
+    %1 = func.call @dram_read(%arg0, %arg1) : (i32, i1) -> i32
+    interop.return %1 : i32
+  }
+  // CHECK-NEXT: %c1_i8 = hw.constant 1 : i8
+  // CHECK-NEXT: [[Y:%.+]]:2 = func.call @Foo_interop_0(%x) : (i8) -> (i8, i8)
+  %c1_i8 = hw.constant 1 : i8
+  %2:2 = interop.procedural.update cffi (%x) : (i8) -> (i8, i8) {
+  ^bb0(%arg0: i8):
+    %3 = comb.add %arg0, %c1_i8 : i8
+    interop.return %3, %arg0 : i8, i8
+  }
+  // CHECK-NEXT: hw.output [[DATA]], [[Y]]#0, [[Y]]#1
+  hw.output %0, %2#0, %2#1 : i32, i8, i8
+}
@@ -0,0 +1,12 @@
+// RUN: circt-opt %s --arc-lower-state --verify-diagnostics
+
+hw.module @Top(%x: i4) -> (y: i4) {
+  // expected-error @below {{instance of 'Kept' cannot be lowered to state}}
+  // expected-note @below {{modules have to be inlined before lowering state}}
+  %0 = hw.instance "kept" @Kept(x: %x: i4) -> (y: i4)
+  hw.output %0 : i4
+}
+
+hw.module private @Kept(%x: i4) -> (y: i4) {
+  hw.output %x : i4
+}
@@ -1,10 +1,15 @@
 // RUN: circt-opt %s --arc-make-tables | FileCheck %s
 
+// The 16 entries of 4 bits fit into a single 64-bit constant.
 // CHECK-LABEL: arc.define @Simple
 arc.define @Simple(%arg0: i4) -> i4 {
-  // CHECK-NEXT: %0 = hw.aggregate_constant [7 : i4, -2 : i4, -3 : i4, -4 : i4, -5 : i4, -6 : i4, -7 : i4, -8 : i4, 7 : i4, 6 : i4, 5 : i4, 4 : i4, 3 : i4, 2 : i4, 1 : i4, 0 : i4] : !hw.array<16xi4>
-  // CHECK-NEXT: hw.array_get %0[%arg0]
-  // CHECK-NEXT: arc.output %1
+  // CHECK-NEXT: [[TABLE:%.+]] = hw.constant 9141386507638288912 : i64
+  // CHECK-NEXT: [[ZEROS_HI:%.+]] = hw.constant 0 : i58
+  // CHECK-NEXT: [[ZEROS_LO:%.+]] = hw.constant 0 : i2
+  // CHECK-NEXT: [[AMOUNT:%.+]] = comb.concat [[ZEROS_HI]], %arg0, [[ZEROS_LO]] : i58, i4, i2
+  // CHECK-NEXT: [[SHIFTED:%.+]] = comb.shru bin [[TABLE]], [[AMOUNT]] : i64
+  // CHECK-NEXT: [[ENTRY:%.+]] = comb.extract [[SHIFTED]] from 0 : (i64) -> i4
+  // CHECK-NEXT: arc.output [[ENTRY]]
   %c0_i3 = hw.constant 0 : i3
   %c0_i2 = hw.constant 0 : i2
   %false = hw.constant false
@@ -62,3 +67,112 @@ arc.define @TooManyBits(%arg0: i30) -> i30 {
   arc.output %20 : i30
 }
 // CHECK-NEXT: }
+
+// CHECK-LABEL: arc.define @Cheap
+arc.define @Cheap(%arg0: i4) -> i4 {
+  // CHECK-NEXT: comb.add
+  // CHECK-NEXT: comb.xor
+  // CHECK-NEXT: arc.output
+  %0 = comb.add %arg0, %arg0 : i4
+  %1 = comb.xor %0, %arg0 : i4
+  arc.output %1 : i4
+}
+
+// Byte-sized entries are stored in an array.
+// CHECK-LABEL: arc.define @Bytes
+arc.define @Bytes(%arg0: i3) -> i8 {
+  // CHECK-NEXT: [[TABLE:%.+]] = hw.aggregate_constant [{{.+}}] : !hw.array<8xi8>
+  // CHECK-NEXT: [[ENTRY:%.+]] = hw.array_get [[TABLE]][%arg0] : !hw.array<8xi8>, i3
+  // CHECK-NEXT: arc.output [[ENTRY]] : i8
+  %c0_i5 = hw.constant 0 : i5
+  %0 = comb.concat %c0_i5, %arg0 : i5, i3
+  %1 = comb.mul %0, %0 : i8
+  %2 = comb.add %1, %0 : i8
+  %3 = comb.mul %2, %2 : i8
+  %4 = comb.xor %3, %1 : i8
+  %5 = comb.add %4, %2 : i8
+  arc.output %5 : i8
+}
+
+// Entries narrower than a byte are packed into words.
+// CHECK-LABEL: arc.define @Bits
+arc.define @Bits(%arg0: i8) -> i1 {
+  // CHECK-NEXT: [[TABLE:%.+]] = hw.aggregate_constant [{{.+}} : i64, {{.+}} : i64, {{.+}} : i64, {{.+}} : i64] : !hw.array<4xi64>
+  // CHECK-NEXT: [[WORD_IDX:%.+]] = comb.extract %arg0 from 6 : (i8) -> i2
+  // CHECK-NEXT: [[WORD:%.+]] = hw.array_get [[TABLE]][[[WORD_IDX]]] : !hw.array<4xi64>, i2
+  // CHECK-NEXT: [[LANE:%.+]] = comb.extract %arg0 from 0 : (i8) -> i6
+  // CHECK-NEXT: [[ZEROS:%.+]] = hw.constant 0 : i58
+  // CHECK-NEXT: [[AMOUNT:%.+]] = comb.concat [[ZEROS]], [[LANE]] : i58, i6
+  // CHECK-NEXT: [[SHIFTED:%.+]] = comb.shru bin [[WORD]], [[AMOUNT]] : i64
+  // CHECK-NEXT: [[ENTRY:%.+]] = comb.extract [[SHIFTED]] from 0 : (i64) -> i1
+  // CHECK-NEXT: arc.output [[ENTRY]] : i1
+  %0 = comb.mul %arg0, %arg0 : i8
+  %1 = comb.add %0, %arg0 : i8
+  %2 = comb.mul %1, %1 : i8
+  %3 = comb.xor %2, %0 : i8
+  %4 = comb.add %3, %1 : i8
+  %5 = comb.mul %4, %3 : i8
+  %6 = comb.xor %5, %arg0 : i8
+  %7 = comb.parity %6 : i8
+  arc.output %7 : i1
+}
+
+// Only the logic depending on few enough input bits is tabulated.
+// CHECK-LABEL: arc.define @Partial
+arc.define @Partial(%arg0: i4, %arg1: i32) -> i32 {
+  // CHECK-NEXT: [[TABLE:%.+]] = hw.aggregate_constant [{{.+}}] : !hw.array<16xi32>
+  // CHECK-NEXT: [[ENTRY:%.+]] = hw.array_get [[TABLE]][%arg0] : !hw.array<16xi32>, i4
+  // CHECK-NEXT: [[SUM:%.+]] = comb.add [[ENTRY]], %arg1 : i32
+  // CHECK-NEXT: arc.output [[SUM]] : i32
+  %c0_i28 = hw.constant 0 : i28
+  %0 = comb.mul %arg0, %arg0 : i4
+  %1 = comb.add %0, %arg0 : i4
+  %2 = comb.mul %1, %1 : i4
+  %3 = comb.xor %2, %0 : i4
+  %4 = comb.add %3, %1 : i4
+  %5 = comb.mul %4, %3 : i4
+  %6 = comb.concat %c0_i28, %5 : i28, i4
+  %7 = comb.add %6, %arg1 : i32
+  arc.output %7 : i32
+}
+
+// The results of tables narrow down the inputs of downstream logic, which can
+// then be tabulated as well.
+// CHECK-LABEL: arc.define @Cascade
+arc.define @Cascade(%arg0: i10, %arg1: i10) -> i4 {
+  // CHECK-NOT: comb.mul
+  // CHECK:     hw.aggregate_constant {{.+}} : !hw.array<32xi64>
+  // CHECK:     [[F:%.+]] = comb.extract {{%.+}} from 0 : (i64) -> i2
+  // CHECK:     hw.aggregate_constant {{.+}} : !hw.array<32xi64>
+  // CHECK:     [[G:%.+]] = comb.extract {{%.+}} from 0 : (i64) -> i2
+  // CHECK:     [[IDX:%.+]] = comb.concat [[G]], [[F]] : i2, i2
+  // CHECK:     [[SHIFTED:%.+]] = comb.shru bin {{%.+}}, {{%.+}} : i64
+  // CHECK-NEXT: [[H:%.+]] = comb.extract [[SHIFTED]] from 0 : (i64) -> i4
+  // CHECK-NEXT: arc.output [[H]] : i4
+  %0 = comb.mul %arg0, %arg0 : i10
+  %1 = comb.add %0, %arg0 : i10
+  %2 = comb.mul %1, %1 : i10
+  %3 = comb.xor %2, %0 : i10
+  %4 = comb.add %3, %1 : i10
+  %5 = comb.mul %4, %3 : i10
+  %6 = comb.xor %5, %arg0 : i10
+  %f = comb.extract %6 from 3 : (i10) -> i2
+
+  %7 = comb.mul %arg1, %arg1 : i10
+  %8 = comb.add %7, %arg1 : i10
+  %9 = comb.mul %8, %8 : i10
+  %10 = comb.xor %9, %7 : i10
+  %11 = comb.add %10, %8 : i10
+  %12 = comb.mul %11, %10 : i10
+  %13 = comb.xor %12, %arg1 : i10
+  %g = comb.extract %13 from 5 : (i10) -> i2
+
+  %14 = comb.concat %f, %g : i2, i2
+  %15 = comb.mul %14, %14 : i4
+  %16 = comb.add %15, %14 : i4
+  %17 = comb.xor %16, %15 : i4
+  %18 = comb.mul %17, %16 : i4
+  %19 = comb.add %18, %17 : i4
+  %20 = comb.xor %19, %14 : i4
+  arc.output %20 : i4
+}
@@ -0,0 +1,102 @@
+// RUN: circt-opt %s --arc-partition-clocks=partitions=2 | FileCheck %s
+
+// CHECK-LABEL: arc.model "Independent"
+arc.model "Independent" {
+^bb0(%arg0: !arc.storage):
+  %in_clk = arc.root_input "clk", %arg0 : (!arc.storage) -> !arc.state<i1>
+  %in_en = arc.root_input "en", %arg0 : (!arc.storage) -> !arc.state<i1>
+  // CHECK: [[A:%.+]] = arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i4>
+  // CHECK: [[B:%.+]] = arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i4>
+  %a = arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i4>
+  %b = arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i4>
+  %0 = arc.state_read %in_clk : <i1>
+
+  // CHECK:      [[NEXT_A:%.+]] = arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i4>
+  // CHECK-NEXT: [[NEXT_B:%.+]] = arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i4>
+
+  // The more expensive update of `b` goes into the first partition.
+  // CHECK-NEXT: arc.clock_tree %0 attributes {arc.partition = 0 : i32} {
+  // CHECK-NEXT:   [[OLD_B:%.+]] = arc.state_read [[B]] : <i4>
+  // CHECK-NEXT:   arc.state_write [[NEXT_B]] = [[OLD_B]] : <i4>
+  // CHECK-NEXT:   [[X:%.+]] = arc.state_read [[B]] : <i4>
+  // CHECK-NEXT:   [[EN:%.+]] = arc.state_read %in_en : <i1>
+  // CHECK-NEXT:   [[MUL:%.+]] = comb.mul [[X]], [[X]], [[X]] : i4
+  // CHECK-NEXT:   arc.state_write [[NEXT_B]] = [[MUL]] if [[EN]] : <i4>
+  // CHECK-NEXT: }
+
+  // CHECK-NEXT: arc.clock_tree %0 attributes {arc.partition = 1 : i32} {
+  // CHECK-NEXT:   [[OLD_A:%.+]] = arc.state_read [[A]] : <i4>
+  // CHECK-NEXT:   arc.state_write [[NEXT_A]] = [[OLD_A]] : <i4>
+  // CHECK-NEXT:   [[Y:%.+]] = arc.state_read [[A]] : <i4>
+  // CHECK-NEXT:   [[ADD:%.+]] = comb.add [[Y]], [[Y]] : i4
+  // CHECK-NEXT:   arc.state_write [[NEXT_A]] = [[ADD]] : <i4>
+  // CHECK-NEXT: }
+
+  // CHECK-NEXT: arc.clock_tree %0 attributes {arc.partition_commit} {
+  // CHECK-NEXT:   [[NEW_A:%.+]] = arc.state_read [[NEXT_A]] : <i4>
+  // CHECK-NEXT:   arc.state_write [[A]] = [[NEW_A]] : <i4>
+  // CHECK-NEXT:   [[NEW_B:%.+]] = arc.state_read [[NEXT_B]] : <i4>
+  // CHECK-NEXT:   arc.state_write [[B]] = [[NEW_B]] : <i4>
+  // CHECK-NEXT: }
+  // CHECK-NOT: arc.clock_tree
+  arc.clock_tree %0 {
+    %1 = arc.state_read %a : <i4>
+    %2 = comb.add %1, %1 : i4
+    arc.state_write %a = %2 : <i4>
+    %3 = arc.state_read %b : <i4>
+    %4 = arc.state_read %in_en : <i1>
+    %5 = comb.mul %3, %3, %3 : i4
+    arc.state_write %b = %5 if %4 : <i4>
+  }
+}
+
+// Writes to the same state keep their sinks in the same partition, and logic
+// shared between partitions is duplicated.
+// CHECK-LABEL: arc.model "Shared"
+arc.model "Shared" {
+^bb0(%arg0: !arc.storage):
+  %in_clk = arc.root_input "clk", %arg0 : (!arc.storage) -> !arc.state<i1>
+  %in_x = arc.root_input "x", %arg0 : (!arc.storage) -> !arc.state<i4>
+  %a = arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i4>
+  %b = arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i4>
+  %c = arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i4>
+  %0 = arc.state_read %in_clk : <i1>
+  // CHECK:      arc.clock_tree %0 attributes {arc.partition = 0 : i32} {
+  // CHECK:        comb.xor
+  // CHECK-NOT:    comb.sub
+  // CHECK:        arc.state_write
+  // CHECK-NOT:    arc.state_write
+  // CHECK-NOT:    comb.sub
+  // CHECK:        arc.state_write
+  // CHECK:      arc.clock_tree %0 attributes {arc.partition = 1 : i32} {
+  // CHECK:        comb.xor
+  // CHECK:        comb.sub
+  // CHECK:      arc.clock_tree %0 attributes {arc.partition_commit} {
+  arc.clock_tree %0 {
+    %1 = arc.state_read %in_x : <i4>
+    %2 = comb.xor %1, %1 : i4
+    arc.state_write %a = %2 : <i4>
+    %3 = comb.mul %2, %2, %2, %2 : i4
+    arc.state_write %a = %3 : <i4>
+    %4 = comb.sub %2, %1 : i4
+    arc.state_write %c = %4 : <i4>
+  }
+}
+
+// Memory writes cannot be deferred to the commit phase.
+// CHECK-LABEL: arc.model "Memory"
+arc.model "Memory" {
+^bb0(%arg0: !arc.storage):
+  %in_clk = arc.root_input "clk", %arg0 : (!arc.storage) -> !arc.state<i1>
+  %mem = arc.alloc_memory %arg0 : (!arc.storage) -> !arc.memory<4 x i4, i2>
+  %a = arc.alloc_state %arg0 : (!arc.storage) -> !arc.state<i4>
+  %0 = arc.state_read %in_clk : <i1>
+  // CHECK:     arc.clock_tree %0 {
+  // CHECK-NOT: arc.partition
+  arc.clock_tree %0 {
+    %c0_i2 = hw.constant 0 : i2
+    %c0_i4 = hw.constant 0 : i4
+    arc.memory_write %mem[%c0_i2], %c0_i4 : <4 x i4, i2>
+    arc.state_write %a = %c0_i4 : <i4>
+  }
+}
@@ -45,3 +45,26 @@ arc.model "Bar" {
   // CHECK-NEXT: "type": "wire"
   arc.alloc_state %arg0 tap {name = "z", offset = 92} : (!arc.storage<9001>) -> !arc.state<i1337>
 }
+
+// CHECK-LABEL: "name": "Baz"
+// CHECK:      "clocks": [
+// CHECK-NEXT:   {
+// CHECK-NEXT:     "name": "fast"
+// CHECK-NEXT:     "function": "Baz_clock"
+// CHECK-NEXT:   }
+// CHECK-NEXT:   {
+// CHECK-NEXT:     "name": "slow"
+// CHECK-NEXT:     "function": "Baz_clock_0"
+// CHECK-NEXT:   }
+// CHECK-NEXT: ]
+arc.model "Baz" {
+^bb0(%arg0: !arc.storage<2>):
+  %fast = arc.root_input "fast", %arg0 {offset = 0} : (!arc.storage<2>) -> !arc.state<i1>
+  %slow = arc.root_input "slow", %arg0 {offset = 1} : (!arc.storage<2>) -> !arc.state<i1>
+  %0 = arc.state_read %fast : <i1>
+  arc.clock_tree %0 {
+  }
+  %1 = arc.state_read %slow : <i1>
+  arc.clock_tree %1 {
+  }
+}
@@ -0,0 +1,65 @@
+// RUN: circt-opt -pass-pipeline='builtin.module(calyx.component(calyx-compile-control{static=true}))' %s | FileCheck %s
+
+module attributes {calyx.entrypoint = "main"} {
+  calyx.component @main(%go : i1 {go}, %reset : i1 {reset}, %clk : i1 {clk}) -> (%done : i1 {done}) {
+    // CHECK: %[[FSM_RESET:.+]] = hw.constant 0 : i2
+    // CHECK: %[[FSM_STEP:.+]] = hw.constant 1 : i2
+    // CHECK: %[[FSM_FINAL:.+]] = hw.constant -1 : i2
+    // CHECK: %[[GROUP_B_BEGIN:.+]] = hw.constant -2 : i2
+    // CHECK: %[[SIGNAL_ON:.+]] = hw.constant true
+    // CHECK: %fsm_reg.in, %fsm_reg.write_en, %fsm_reg.clk, %fsm_reg.reset, %fsm_reg.out, %fsm_reg.done = calyx.register @fsm_reg : i2
+    %r.in, %r.write_en, %r.clk, %r.reset, %r.out, %r.done = calyx.register @r : i8, i1, i1, i1, i8, i1
+    %c1_i8 = hw.constant 1 : i8
+    %true = hw.constant true
+    calyx.wires {
+      %undef = calyx.undef : i1
+      // Group A takes two cycles and is enabled while the FSM is below 2.
+      // CHECK: %[[GROUP_A_GO_GUARD:.+]] = comb.icmp ult %fsm_reg.out, %[[GROUP_B_BEGIN]] : i2
+      // CHECK: calyx.group @A {
+      // CHECK:   %A.go = calyx.group_go %[[GROUP_A_GO_GUARD]] ? %[[SIGNAL_ON]] : i1
+      calyx.group @A {
+        %A.go = calyx.group_go %undef : i1
+        calyx.assign %r.in = %A.go ? %c1_i8 : i8
+        calyx.assign %r.write_en = %A.go ? %true : i1
+        calyx.group_done %r.done : i1
+      } {static = 2}
+
+      // Group B takes one cycle and starts right after group A, without
+      // waiting for its done signal.
+      // CHECK: %[[BEFORE_END:.+]] = comb.icmp ult %fsm_reg.out, %[[FSM_FINAL]] : i2
+      // CHECK: %[[STARTED:.+]] = comb.icmp uge %fsm_reg.out, %[[GROUP_B_BEGIN]] : i2
+      // CHECK: %[[GROUP_B_GO_GUARD:.+]] = comb.and %[[STARTED]], %[[BEFORE_END]] : i1
+      // CHECK: calyx.group @B {
+      // CHECK:   %B.go = calyx.group_go %[[GROUP_B_GO_GUARD]] ? %[[SIGNAL_ON]] : i1
+      calyx.group @B {
+        %B.go = calyx.group_go %undef : i1
+        calyx.assign %r.in = %B.go ? %r.out : i8
+        calyx.assign %r.write_en = %B.go ? %true : i1
+        calyx.group_done %r.done : i1
+      } {static = 1}
+
+      // CHECK: %[[IS_FINAL:.+]] = comb.icmp eq %fsm_reg.out, %[[FSM_FINAL]] : i2
+      // CHECK: %[[NOT_FINAL:.+]] = comb.xor %[[IS_FINAL]], {{.+}} : i1
+      // CHECK: %[[NEXT:.+]] = comb.add %fsm_reg.out, %[[FSM_STEP]] : i2
+
+      // CHECK-LABEL: calyx.group @seq {
+      // CHECK-NEXT:    calyx.assign %fsm_reg.in = %[[NOT_FINAL]] ? %[[NEXT]] : i2
+      // CHECK-NEXT:    calyx.assign %fsm_reg.write_en = %[[NOT_FINAL]] ? %[[SIGNAL_ON]] : i1
+      // CHECK-NEXT:    calyx.group_done %[[IS_FINAL]] ? %[[SIGNAL_ON]] : i1
+      // CHECK-NEXT:  } {static = 3 : i64}
+
+      // CHECK: calyx.assign %fsm_reg.in = %[[IS_FINAL]] ? %[[FSM_RESET]] : i2
+      // CHECK: calyx.assign %fsm_reg.write_en = %[[IS_FINAL]] ? %[[SIGNAL_ON]] : i1
+    }
+
+    // CHECK-LABEL: calyx.control {
+    // CHECK-NEXT:    calyx.enable @seq {compiledGroups = [@A, @B]}
+    // CHECK-NEXT:  }
+    calyx.control {
+      calyx.seq {
+        calyx.enable @A
+        calyx.enable @B
+      }
+    }
+  }
+}
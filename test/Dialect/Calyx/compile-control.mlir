@@ -8,17 +8,15 @@ module attributes {calyx.entrypoint = "main"} {
   }
 
   calyx.component @main(%go : i1 {go}, %reset : i1 {reset}, %clk : i1 {clk}) -> (%done : i1 {done}) {
-    // CHECK: %[[FSM_RESET:.+]] = hw.constant 0 : i2
     // CHECK: %[[FSM_STEP_2:.+]] = hw.constant -2 : i2
-    // CHECK: %[[GROUP_B_FSM_BEGIN:.+]] = hw.constant 1 : i2
     // CHECK: %[[FSM_STEP_1:.+]] = hw.constant 1 : i2
-    // CHECK: %[[GROUP_A_FSM_BEGIN:.+]] = hw.constant 0 : i2
+    // CHECK: %[[FSM_RESET:.+]] = hw.constant 0 : i2
     // CHECK: %[[SIGNAL_ON:.+]] = hw.constant true
     // CHECK:  %fsm_reg.in, %fsm_reg.write_en, %fsm_reg.clk, %fsm_reg.reset, %fsm_reg.out, %fsm_reg.done = calyx.register @fsm_reg : i2
     %z.go, %z.reset, %z.clk, %z.flag, %z.done = calyx.instance @z of @Z : i1, i1, i1, i1, i1
     calyx.wires {
       %undef = calyx.undef : i1
-      // CHECK: %[[FSM_IS_GROUP_A_BEGIN_STATE:.+]] = comb.icmp eq %fsm_reg.out, %[[GROUP_A_FSM_BEGIN]] : i2
+      // CHECK: %[[FSM_IS_GROUP_A_BEGIN_STATE:.+]] = comb.icmp eq %fsm_reg.out, %[[FSM_RESET]] : i2
       // CHECK: %[[GROUP_A_NOT_DONE:.+]] = comb.xor %z.done, {{.+}} : i1
       // CHECK: %[[GROUP_A_GO_GUARD:.+]] = comb.and %[[FSM_IS_GROUP_A_BEGIN_STATE]], %[[GROUP_A_NOT_DONE]] : i1
       calyx.group @A {
@@ -30,7 +28,7 @@ module attributes {calyx.entrypoint = "main"} {
       }
 
       // CHECK: %[[GROUP_B_DONE:.+]] = comb.and %z.flag, %z.done : i1
-      // CHECK: %[[FSM_IS_GROUP_B_BEGIN_STATE:.+]] = comb.icmp eq %fsm_reg.out, %[[GROUP_B_FSM_BEGIN]] : i2
+      // CHECK: %[[FSM_IS_GROUP_B_BEGIN_STATE:.+]] = comb.icmp eq %fsm_reg.out, %[[FSM_STEP_1]] : i2
       // CHECK: %[[GROUP_B_NOT_DONE:.+]] = comb.xor %[[GROUP_B_DONE]], {{.+}} : i1
       // CHECK: %[[GROUP_B_GO_GUARD:.+]] = comb.and %[[FSM_IS_GROUP_B_BEGIN_STATE]], %[[GROUP_B_NOT_DONE]] : i1
       calyx.group @B {
@@ -0,0 +1,91 @@
+// RUN: circt-opt -pass-pipeline='builtin.module(calyx.component(calyx-share-cells))' %s | FileCheck %s
+// RUN: circt-opt -pass-pipeline='builtin.module(calyx.component(calyx-share-cells{limits=std_mult_pipe=2}))' %s | FileCheck %s --check-prefix=LIMIT
+
+module attributes {calyx.entrypoint = "main"} {
+  // CHECK-LABEL: calyx.component @main
+  // LIMIT-LABEL: calyx.component @main
+  calyx.component @main(%go: i1 {go}, %clk: i1 {clk}, %reset: i1 {reset}) -> (%done: i1 {done}) {
+    // The multipliers of A, B and C are merged, as these groups run one after
+    // the other. D runs in parallel with C and keeps its own multiplier.
+    // CHECK:     %mul0.clk, %mul0.reset, %mul0.go, %mul0.left, %mul0.right, %mul0.out, %mul0.done = calyx.std_mult_pipe @mul0
+    // CHECK-NOT: calyx.std_mult_pipe @mul1
+    // CHECK-NOT: calyx.std_mult_pipe @mul2
+    // CHECK:     calyx.std_mult_pipe @mul3
+    // LIMIT:     calyx.std_mult_pipe @mul0
+    // LIMIT-NOT: calyx.std_mult_pipe @mul1
+    // LIMIT:     calyx.std_mult_pipe @mul2
+    // LIMIT:     calyx.std_mult_pipe @mul3
+    %mul0.clk, %mul0.reset, %mul0.go, %mul0.left, %mul0.right, %mul0.out, %mul0.done = calyx.std_mult_pipe @mul0 : i1, i1, i1, i32, i32, i32, i1
+    %mul1.clk, %mul1.reset, %mul1.go, %mul1.left, %mul1.right, %mul1.out, %mul1.done = calyx.std_mult_pipe @mul1 : i1, i1, i1, i32, i32, i32, i1
+    %mul2.clk, %mul2.reset, %mul2.go, %mul2.left, %mul2.right, %mul2.out, %mul2.done = calyx.std_mult_pipe @mul2 : i1, i1, i1, i32, i32, i32, i1
+    %mul3.clk, %mul3.reset, %mul3.go, %mul3.left, %mul3.right, %mul3.out, %mul3.done = calyx.std_mult_pipe @mul3 : i1, i1, i1, i32, i32, i32, i1
+    // The adder is used outside of a group and is not shared.
+    // CHECK: calyx.std_add @add0
+    // CHECK: calyx.std_add @add1
+    %add0.left, %add0.right, %add0.out = calyx.std_add @add0 : i32, i32, i32
+    %add1.left, %add1.right, %add1.out = calyx.std_add @add1 : i32, i32, i32
+    %r.in, %r.write_en, %r.clk, %r.reset, %r.out, %r.done = calyx.register @r : i32, i1, i1, i1, i32, i1
+    %s.in, %s.write_en, %s.clk, %s.reset, %s.out, %s.done = calyx.register @s : i32, i1, i1, i1, i32, i1
+    %true = hw.constant true
+    calyx.wires {
+      calyx.assign %add0.left = %r.out : i32
+      // CHECK-LABEL: calyx.group @A
+      // CHECK:         calyx.assign %mul0.left = %r.out : i32
+      calyx.group @A {
+        calyx.assign %mul0.left = %r.out : i32
+        calyx.assign %mul0.right = %r.out : i32
+        calyx.assign %mul0.go = %true : i1
+        calyx.assign %r.in = %mul0.out : i32
+        calyx.assign %r.write_en = %mul0.done : i1
+        calyx.group_done %r.done : i1
+      }
+      // CHECK-LABEL: calyx.group @B
+      // CHECK:         calyx.assign %mul0.left = %s.out : i32
+      // CHECK:         calyx.assign %r.in = %mul0.out : i32
+      // LIMIT-LABEL: calyx.group @B
+      // LIMIT:         calyx.assign %mul0.left = %s.out : i32
+      calyx.group @B {
+        calyx.assign %mul1.left = %s.out : i32
+        calyx.assign %mul1.right = %add1.out : i32
+        calyx.assign %add1.left = %s.out : i32
+        calyx.assign %add1.right = %s.out : i32
+        calyx.assign %mul1.go = %true : i1
+        calyx.assign %r.in = %mul1.out : i32
+        calyx.assign %r.write_en = %mul1.done : i1
+        calyx.group_done %r.done : i1
+      }
+      // CHECK-LABEL: calyx.group @C
+      // CHECK:         calyx.assign %mul0.left = %r.out : i32
+      // LIMIT-LABEL: calyx.group @C
+      // LIMIT:         calyx.assign %mul2.left = %r.out : i32
+      calyx.group @C {
+        calyx.assign %mul2.left = %r.out : i32
+        calyx.assign %mul2.right = %add0.out : i32
+        calyx.assign %mul2.go = %true : i1
+        calyx.assign %r.in = %mul2.out : i32
+        calyx.assign %r.write_en = %mul2.done : i1
+        calyx.group_done %r.done : i1
+      }
+      // CHECK-LABEL: calyx.group @D
+      // CHECK:         calyx.assign %mul3.left = %s.out : i32
+      calyx.group @D {
+        calyx.assign %mul3.left = %s.out : i32
+        calyx.assign %mul3.right = %s.out : i32
+        calyx.assign %mul3.go = %true : i1
+        calyx.assign %s.in = %mul3.out : i32
+        calyx.assign %s.write_en = %mul3.done : i1
+        calyx.group_done %s.done : i1
+      }
+    }
+    calyx.control {
+      calyx.seq {
+        calyx.enable @A
+        calyx.enable @B
+        calyx.par {
+          calyx.enable @C
+          calyx.enable @D
+        }
+      }
+    }
+  }
+}
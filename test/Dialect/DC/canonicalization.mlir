@@ -83,8 +83,8 @@ func.func @csePack(%a: !dc.token, %b : i32, %c : i1) -> (!dc.value<i32, i1>, !dc
 
 // CHECK-LABEL:   func.func @forkToFork(
 // CHECK-SAME:                          %[[VAL_0:.*]]: !dc.token) -> (!dc.token, !dc.token, !dc.token) {
-// CHECK:           %[[VAL_1:.*]]:3 = dc.fork [3] %[[VAL_0]]
-// CHECK:           return %[[VAL_1]]#1, %[[VAL_1]]#1, %[[VAL_1]]#2 : !dc.token, !dc.token, !dc.token
+// CHECK:           %[[VAL_1:.*]]:2 = dc.fork [2] %[[VAL_0]]
+// CHECK:           return %[[VAL_1]]#0, %[[VAL_1]]#0, %[[VAL_1]]#1 : !dc.token, !dc.token, !dc.token
 // CHECK:         }
 func.func @forkToFork(%a: !dc.token) -> (!dc.token, !dc.token, !dc.token) {
     %0, %1 = dc.fork [2] %a
@@ -137,3 +137,49 @@ func.func @forkOfSource() -> (!dc.token, !dc.token) {
     %1:2 = dc.fork [2] %0
     return %1#0, %1#1 : !dc.token, !dc.token
 }
+
+// CHECK-LABEL:   func.func @unusedForkOutputs(
+// CHECK-SAME:                                 %[[VAL_0:.*]]: !dc.token) -> (!dc.token, !dc.token) {
+// CHECK:           %[[VAL_1:.*]]:2 = dc.fork [2] %[[VAL_0]]
+// CHECK:           return %[[VAL_1]]#0, %[[VAL_1]]#1 : !dc.token, !dc.token
+// CHECK:         }
+func.func @unusedForkOutputs(%a: !dc.token) -> (!dc.token, !dc.token) {
+    %0:3 = dc.fork [3] %a
+    dc.sink %0#1
+    return %0#0, %0#2 : !dc.token, !dc.token
+}
+
+// CHECK-LABEL:   func.func @joinForkOutputs(
+// CHECK-SAME:                               %[[VAL_0:.*]]: !dc.token,
+// CHECK-SAME:                               %[[VAL_1:.*]]: !dc.token) -> !dc.token {
+// CHECK:           %[[VAL_2:.*]] = dc.join %[[VAL_0]], %[[VAL_1]]
+// CHECK:           return %[[VAL_2]] : !dc.token
+// CHECK:         }
+func.func @joinForkOutputs(%a: !dc.token, %b: !dc.token) -> (!dc.token) {
+    %0:3 = dc.fork [3] %a
+    %1 = dc.join %0#0, %b, %0#2, %0#1
+    return %1 : !dc.token
+}
+
+// CHECK-LABEL:   func.func @bufferChain(
+// CHECK-SAME:                           %[[VAL_0:.*]]: !dc.token) -> !dc.token {
+// CHECK:           %[[VAL_1:.*]] = dc.buffer[5] %[[VAL_0]] : !dc.token
+// CHECK:           return %[[VAL_1]] : !dc.token
+// CHECK:         }
+func.func @bufferChain(%a: !dc.token) -> (!dc.token) {
+    %0 = dc.buffer [2] %a : !dc.token
+    %1 = dc.buffer [3] %0 : !dc.token
+    return %1 : !dc.token
+}
+
+// CHECK-LABEL:   func.func @bufferChainInitValues(
+// CHECK-SAME:                                     %[[VAL_0:.*]]: !dc.value<i1>) -> !dc.value<i1> {
+// CHECK:           %[[VAL_1:.*]] = dc.buffer[2] %[[VAL_0]] : !dc.value<i1>
+// CHECK:           %[[VAL_2:.*]] = dc.buffer[1] %[[VAL_1]] [1] : !dc.value<i1>
+// CHECK:           return %[[VAL_2]] : !dc.value<i1>
+// CHECK:         }
+func.func @bufferChainInitValues(%a: !dc.value<i1>) -> (!dc.value<i1>) {
+    %0 = dc.buffer [2] %a : !dc.value<i1>
+    %1 = dc.buffer [1] %0 [1] : !dc.value<i1>
+    return %1 : !dc.value<i1>
+}
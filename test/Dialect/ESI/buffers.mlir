@@ -0,0 +1,37 @@
+// RUN: circt-opt %s --lower-esi-to-physical -verify-diagnostics | circt-opt -verify-diagnostics | FileCheck %s
+// RUN: circt-opt %s --lower-esi-to-physical --lower-esi-ports --lower-esi-to-hw -verify-diagnostics | FileCheck --check-prefix=HW %s
+
+// CHECK-LABEL: hw.module @buffers(
+hw.module @buffers(%clk: i1, %rst: i1, %a: !esi.channel<i8>, %b: !esi.channel<i8>, %c: !esi.channel<i8>) -> (x: !esi.channel<i8>, y: !esi.channel<i8>, z: !esi.channel<i8>) {
+  // CHECK-NEXT: %0 = esi.stage %clk, %rst, %a {kind = "register"} : i8
+  // CHECK-NEXT: %1 = esi.stage %clk, %rst, %0 {kind = "register"} : i8
+  %x = esi.buffer %clk, %rst, %a { stages = 2, kind = "register" } : i8
+
+  // CHECK-NEXT: %2 = esi.stage %clk, %rst, %b {depth = 16 : i64, kind = "fifo"} : i8
+  %y = esi.buffer %clk, %rst, %b { stages = 16, kind = "fifo" } : i8
+
+  // CHECK-NEXT: %3 = esi.stage %clk, %rst, %c {inner_sym = "long_stage0", name = "long_stage0"} : i8
+  // CHECK-NEXT: %4 = esi.stage %clk, %rst, %3 {inner_sym = "long_stage1", name = "long_stage1"} : i8
+  %z = esi.buffer %clk, %rst, %c {
+    stages = 2, name = "long",
+    placements = [#msft.physloc<FF, 4, 10, 0>, #msft.physloc<FF, 4, 50, 0>]
+  } : i8
+  hw.output %x, %y, %z : !esi.channel<i8>, !esi.channel<i8>, !esi.channel<i8>
+}
+
+// CHECK-LABEL: msft.instance.hierarchy @buffers {
+// CHECK-NEXT:    msft.instance.dynamic @buffers::@long_stage0 {
+// CHECK-NEXT:      msft.pd.location FF x: 4 y: 10 n: 0
+// CHECK-NEXT:    }
+// CHECK-NEXT:    msft.instance.dynamic @buffers::@long_stage1 {
+// CHECK-NEXT:      msft.pd.location FF x: 4 y: 50 n: 0
+
+// HW-DAG:  hw.module.extern @ESI_PipelineStage<WIDTH: ui32>
+// HW-DAG:  hw.module.extern @ESI_RegisterStage<WIDTH: ui32>
+// HW-DAG:  hw.module.extern @ESI_FIFO<WIDTH: ui32, DEPTH: ui32>
+// HW-LABEL: hw.module @buffers(
+// HW:        hw.instance "pipelineStage" @ESI_RegisterStage<WIDTH: ui32 = 8>
+// HW:        hw.instance "pipelineStage" @ESI_RegisterStage<WIDTH: ui32 = 8>
+// HW:        hw.instance "pipelineStage" @ESI_FIFO<WIDTH: ui32 = 8, DEPTH: ui32 = 16>
+// HW:        hw.instance "long_stage0" sym @long_stage0 @ESI_PipelineStage<WIDTH: ui32 = 8>
+// HW:        hw.instance "long_stage1" sym @long_stage1 @ESI_PipelineStage<WIDTH: ui32 = 8>
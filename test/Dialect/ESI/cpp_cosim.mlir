@@ -62,6 +62,14 @@ hw.module @Loopback(%clk: i1, %loopback_tohw: !esi.channel<i8>) -> (loopback_fro
 // CHECK:     return os;
 // CHECK:   }
 // CHECK:   using CPType = ::I8;
+// CHECK:   void toCapnp(CPType::Builder builder) const {
+// CHECK:     builder.setI(i);
+// CHECK:   }
+// CHECK:   static I8 fromCapnp(CPType::Reader reader) {
+// CHECK:     I8 ret;
+// CHECK:     ret.i = reader.getI();
+// CHECK:     return ret;
+// CHECK:   }
 
 // CHECK: struct Struct17656501409672388976 {
 // CHECK:   uint32_t addr;      // MLIR type is i32
@@ -83,6 +91,16 @@ hw.module @Loopback(%clk: i1, %loopback_tohw: !esi.channel<i8>) -> (loopback_fro
 // CHECK:     return os;
 // CHECK:   }
 // CHECK:   using CPType = ::Struct17656501409672388976;
+// CHECK:   void toCapnp(CPType::Builder builder) const {
+// CHECK:     builder.setAddr(addr);
+// CHECK:     builder.setData(data);
+// CHECK:   }
+// CHECK:   static Struct17656501409672388976 fromCapnp(CPType::Reader reader) {
+// CHECK:     Struct17656501409672388976 ret;
+// CHECK:     ret.addr = reader.getAddr();
+// CHECK:     ret.data = reader.getData();
+// CHECK:     return ret;
+// CHECK:   }
 
 // =============================================================================
 // Verify service declarations
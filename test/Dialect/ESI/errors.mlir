@@ -170,3 +170,32 @@ hw.module.extern @TypeAModuleDst(%windowed: !TypeAwin1)
   ]>
 
 hw.module.extern @TypeAModuleDst(%windowed: !TypeAwin1)
+
+// -----
+
+hw.module @badBufferKind(%clk: i1, %rst: i1, %a: !esi.channel<i8>) -> (x: !esi.channel<i8>) {
+  // expected-error @+1 {{'esi.buffer' op unknown stage kind 'shift', expected 'skid', 'register' or 'fifo'}}
+  %x = esi.buffer %clk, %rst, %a { kind = "shift" } : i8
+  hw.output %x : !esi.channel<i8>
+}
+
+// -----
+
+hw.module @badPlacements(%clk: i1, %rst: i1, %a: !esi.channel<i8>) -> (x: !esi.channel<i8>) {
+  // expected-error @+1 {{'esi.buffer' op expected 2 placements, one for each stage, got 1}}
+  %x = esi.buffer %clk, %rst, %a { name = "buf", stages = 2, placements = [#msft.physloc<FF, 0, 0, 0>] } : i8
+  hw.output %x : !esi.channel<i8>
+}
+
+// -----
+
+hw.module @fifoStageDepth(%clk: i1, %rst: i1, %a: !esi.channel<i8>) -> (x: !esi.channel<i8>) {
+  // expected-error @+1 {{'esi.stage' op fifo stages require a depth}}
+  %x = esi.stage %clk, %rst, %a { kind = "fifo" } : i8
+  hw.output %x : !esi.channel<i8>
+}
+
+// -----
+
+// expected-error @+1 {{list field "data" must specify the number of items per frame}}
+hw.module.extern @listWithoutNumItems(%windowed: !esi.window<"win", !hw.struct<data: !esi.list<i32>>, [<"Data", [<"data">]>]>)
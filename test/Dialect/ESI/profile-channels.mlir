@@ -0,0 +1,40 @@
+// RUN: circt-opt %s --esi-profile-channels | FileCheck %s
+
+hw.module.extern @Sender() -> (x: !esi.channel<i8>)
+hw.module.extern @Reciever(%a: !esi.channel<i8>)
+
+// CHECK-LABEL: hw.module @top(%clk: i1, %rst: i1, %in: !esi.channel<i8>) -> (out: !esi.channel<i8>) {
+hw.module @top(%clk: i1, %rst: i1, %in: !esi.channel<i8>) -> (out: !esi.channel<i8>) {
+  // CHECK:      %[[IN_DATA:.+]], %[[IN_VALID:.+]] = esi.unwrap.vr %in, %[[IN_READY:.+]]
+  // CHECK-NEXT: %[[IN_CHAN:.+]], %[[IN_READY]] = esi.wrap.vr %[[IN_DATA]], %[[IN_VALID]]
+  // CHECK:      hw.instance "recv" @Reciever(a: %[[IN_CHAN]]: !esi.channel<i8>) -> ()
+  hw.instance "recv" @Reciever (a: %in: !esi.channel<i8>) -> ()
+
+  // CHECK:      %send.x = hw.instance "send" @Sender() -> (x: !esi.channel<i8>)
+  %send.x = hw.instance "send" @Sender () -> (x: !esi.channel<i8>)
+
+  // CHECK:      %esi_profile_cycles = seq.compreg sym @esi_profile_cycles
+  // CHECK:      comb.and %[[IN_VALID]], %[[IN_READY]]
+  // CHECK:      %esi_profile_in_transfers = seq.compreg
+  // CHECK:      %esi_profile_in_stalls = seq.compreg
+  // CHECK:      %[[X_DATA:.+]], %[[X_VALID:.+]] = esi.unwrap.vr %send.x, %[[X_READY:.+]]
+  // CHECK-NEXT: %[[X_CHAN:.+]], %[[X_READY]] = esi.wrap.vr %[[X_DATA]], %[[X_VALID]]
+  // CHECK:      comb.and %[[X_VALID]], %[[X_READY]]
+  // CHECK:      %esi_profile_sendX_transfers = seq.compreg
+  // CHECK:      %esi_profile_sendX_stalls = seq.compreg
+
+  // CHECK:      %[[REQ_DATA:.+]], %[[REQ_VALID:.+]] = esi.unwrap.vr %[[REQ:.+]], %true
+  // CHECK:      %[[LIVE:.+]] = hw.struct_create (%esi_profile_cycles, %esi_profile_in_transfers, %esi_profile_in_stalls, %esi_profile_sendX_transfers, %esi_profile_sendX_stalls) : !hw.struct<cycles: i64, inTransfers: i64, inStalls: i64, sendXTransfers: i64, sendXStalls: i64>
+  // CHECK:      %esi_profile_snapshot = seq.compreg sym @esi_profile_snapshot
+  // CHECK:      %[[RESP:.+]], %[[RESP_READY:.+]] = esi.wrap.vr %esi_profile_snapshot, %esi_profile_pending
+  // CHECK:      %[[REQ]] = esi.cosim %clk, %rst, %[[RESP]], "esi_profile_top" : !esi.channel<!hw.struct<cycles: i64, inTransfers: i64, inStalls: i64, sendXTransfers: i64, sendXStalls: i64>> -> !esi.channel<i1>
+  // CHECK:      hw.output %[[X_CHAN]] : !esi.channel<i8>
+  hw.output %send.x : !esi.channel<i8>
+}
+
+// Modules without a clock and reset are left alone.
+// CHECK-LABEL: hw.module @noClock(%in: !esi.channel<i8>) -> (out: !esi.channel<i8>) {
+// CHECK-NEXT:    hw.output %in : !esi.channel<i8>
+hw.module @noClock(%in: !esi.channel<i8>) -> (out: !esi.channel<i8>) {
+  hw.output %in : !esi.channel<i8>
+}
@@ -60,3 +60,21 @@ hw.module @TypeAModulePassthrough(%a: !TypeAwin1) -> (x: !TypeAwin1) {
   %x = hw.instance "foo" @TypeAModuleUnwrapWrap(a: %a: !TypeAwin1) -> (x: !TypeAwin1)
   hw.output %x : !TypeAwin1
 }
+
+!TypeB = !hw.struct<header: i16, data: !esi.list<i32>>
+!TypeBwin = !esi.window<
+  "TypeBwin", !TypeB, [
+    <"Header", [<"header">]>,
+    <"Data", [<"data", 4>]>
+  ]>
+
+// LOW-LABEL:  hw.module.extern @TypeBModuleDst(%windowed: !hw.union<Header: !hw.struct<header: i16>, Data: !hw.struct<data: !hw.array<4xi32>, data_size: i3, last: i1>>)
+hw.module.extern @TypeBModuleDst(%windowed: !TypeBwin)
+
+!TypeBwin1 = !esi.window<
+  "TypeBwin1", !TypeB, [
+    <"Data", [<"data", 1>]>
+  ]>
+
+// LOW-LABEL:  hw.module.extern @TypeBModuleDst1(%windowed: !hw.union<Data: !hw.struct<data: !hw.array<1xi32>, last: i1>>)
+hw.module.extern @TypeBModuleDst1(%windowed: !TypeBwin1)
@@ -2,9 +2,14 @@
 // RUN: cd %t
 // RUN: circt-opt --pass-pipeline='builtin.module(firrtl.circuit(firrtl-blackbox-reader))' Foo.mlir | FileCheck Foo.mlir
 // RUN: circt-opt --pass-pipeline='builtin.module(firrtl.circuit(firrtl-blackbox-reader))' NoDUT.mlir | FileCheck NoDUT.mlir
+// RUN: circt-opt --pass-pipeline='builtin.module(firrtl.circuit(firrtl-blackbox-reader{reference-paths}))' Reference.mlir | FileCheck Reference.mlir
 
 //--- Baz.sv
 /* Baz */
+//--- Baz.svh
+/* Baz header */
+//--- Qux.sv
+/* Qux */
 //--- Foo.mlir
 firrtl.circuit "Foo" attributes {annotations = [
 {class = "sifive.enterprise.firrtl.TestBenchDirAnnotation", dirname = "../testbench"},
@@ -79,3 +84,25 @@ firrtl.circuit "NoDUT" attributes {annotations = [
   // CHECK-SAME:   #hw.output_file<".{{/|\\\\}}NoDUTBlackBox.sv">
   // CHECK:      sv.verbatim "NoDUTBlackBox.sv"
 }
+//--- Reference.mlir
+// Check that path annotations are referenced in place by the file list, except
+// for header files and files with an explicit output file.
+//
+// CHECK: firrtl.circuit "Reference"
+firrtl.circuit "Reference" {
+  firrtl.extmodule @Baz() attributes {annotations = [
+    {class = "firrtl.transforms.BlackBoxPathAnno", path = "Baz.sv"},
+    {class = "firrtl.transforms.BlackBoxPathAnno", path = "Baz.svh"}
+  ]}
+  firrtl.extmodule @Qux() attributes {annotations = [{class = "firrtl.transforms.BlackBoxPathAnno", path = "Qux.sv"}], output_file = #hw.output_file<"qux/Qux.sv">}
+  firrtl.module @Reference() {
+    firrtl.instance baz @Baz()
+    firrtl.instance qux @Qux()
+  }
+  // CHECK-NOT:  "/* Baz */
+  // CHECK:      sv.verbatim "/* Baz header */{{(\\0D)?}}\0A" {output_file = #hw.output_file<".{{/|\\\\}}Baz.svh", excludeFromFileList>}
+  // CHECK:      sv.verbatim "/* Qux */{{(\\0D)?}}\0A" {output_file = #hw.output_file<"qux{{/|\\\\}}Qux.sv">}
+  // CHECK:      sv.verbatim "qux{{/|\\\\}}Qux.sv\0A
+  // CHECK-SAME:   {{.+}}Baz.sv"
+  // CHECK-SAME:   output_file = #hw.output_file<"firrtl_black_box_resource_files.f", excludeFromFileList>
+}
@@ -1,4 +1,5 @@
 // RUN: circt-opt --pass-pipeline='builtin.module(firrtl.circuit(firrtl-dedup))' %s | FileCheck %s
+// RUN: circt-opt --pass-pipeline='builtin.module(firrtl.circuit(firrtl-dedup{fast-hash=true}))' %s | FileCheck %s
 
 // CHECK-LABEL: firrtl.circuit "Empty"
 firrtl.circuit "Empty" {
@@ -624,6 +625,30 @@ firrtl.circuit "NoDedup" {
   }
 }
 
+// Don't deduplicate the parents of modules with NoDedup, even if they are
+// otherwise equivalent.
+// CHECK-LABEL: firrtl.circuit "NoDedupParents"
+firrtl.circuit "NoDedupParents" {
+  // CHECK: firrtl.module @Leaf0
+  firrtl.module @Leaf0() attributes {annotations = [{class = "firrtl.transforms.NoDedupAnnotation"}]} { }
+  // CHECK: firrtl.module @Leaf1
+  firrtl.module @Leaf1() attributes {annotations = [{class = "firrtl.transforms.NoDedupAnnotation"}]} { }
+  // CHECK: firrtl.module @Parent0
+  firrtl.module @Parent0() {
+    // CHECK: firrtl.instance leaf @Leaf0()
+    firrtl.instance leaf @Leaf0()
+  }
+  // CHECK: firrtl.module @Parent1
+  firrtl.module @Parent1() {
+    // CHECK: firrtl.instance leaf @Leaf1()
+    firrtl.instance leaf @Leaf1()
+  }
+  firrtl.module @NoDedupParents() {
+    firrtl.instance parent0 @Parent0()
+    firrtl.instance parent1 @Parent1()
+  }
+}
+
 // Don't deduplicate modules with input RefType ports.
 // CHECK-LABEL:   firrtl.circuit "InputRefTypePorts"
 // CHECK-COUNT-3: firrtl.module
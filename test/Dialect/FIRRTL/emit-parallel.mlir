@@ -0,0 +1,49 @@
+// RUN: circt-translate --export-firrtl --verify-diagnostics %s -o %t
+// RUN: cat %t | FileCheck %s --strict-whitespace
+// RUN: circt-translate --export-firrtl --mlir-disable-threading %s | diff - %t
+
+// The modules of a circuit are emitted in parallel. The output keeps the order
+// and indentation of the modules, and invalid values are named per module.
+
+// CHECK-LABEL: {{^}}circuit Foo :
+firrtl.circuit "Foo" {
+  // CHECK-NEXT: {{^}}  module A :
+  // CHECK-NEXT: {{^}}    output o : UInt<1>
+  // CHECK-EMPTY:
+  // CHECK-NEXT: {{^}}    wire _invalid : UInt<1>
+  // CHECK-NEXT: {{^}}    _invalid is invalid
+  // CHECK-NEXT: {{^}}    node n = _invalid
+  // CHECK-NEXT: {{^}}    o <= n
+  // CHECK-EMPTY:
+  firrtl.module @A(out %o: !firrtl.uint<1>) {
+    %invalid_ui1 = firrtl.invalidvalue : !firrtl.uint<1>
+    %n = firrtl.node %invalid_ui1 : !firrtl.uint<1>
+    firrtl.connect %o, %n : !firrtl.uint<1>, !firrtl.uint<1>
+  }
+
+  // CHECK-NEXT: {{^}}  extmodule B :
+  // CHECK-NEXT: {{^}}    input i : UInt<1>
+  firrtl.extmodule @B(in i: !firrtl.uint<1>)
+
+  // The name of the port is reserved, so the invalid value of this module is
+  // named differently.
+  // CHECK:      {{^}}  module Foo :
+  // CHECK-NEXT: {{^}}    input _invalid : UInt<1>
+  // CHECK-NEXT: {{^}}    output o : UInt<1>
+  // CHECK-EMPTY:
+  // CHECK-NEXT: {{^}}    inst a of A
+  // CHECK-NEXT: {{^}}    inst b of B
+  // CHECK-NEXT: {{^}}    wire _invalid_0 : UInt<1>
+  // CHECK-NEXT: {{^}}    _invalid_0 is invalid
+  // CHECK-NEXT: {{^}}    node n = _invalid_0
+  // CHECK-NEXT: {{^}}    b.i <= n
+  // CHECK-NEXT: {{^}}    o <= a.o
+  firrtl.module @Foo(in %_invalid: !firrtl.uint<1>, out %o: !firrtl.uint<1>) {
+    %a_o = firrtl.instance a @A(out o: !firrtl.uint<1>)
+    %b_i = firrtl.instance b @B(in i: !firrtl.uint<1>)
+    %invalid_ui1 = firrtl.invalidvalue : !firrtl.uint<1>
+    %n = firrtl.node %invalid_ui1 : !firrtl.uint<1>
+    firrtl.connect %b_i, %n : !firrtl.uint<1>, !firrtl.uint<1>
+    firrtl.connect %o, %a_o : !firrtl.uint<1>, !firrtl.uint<1>
+  }
+}
@@ -0,0 +1,74 @@
+// RUN: circt-opt --firrtl-extract-instances %s | FileCheck %s
+// RUN: circt-opt --firrtl-extract-instances -mlir-pass-statistics %s -o /dev/null 2>&1 | FileCheck %s --check-prefix=STATS
+
+// The two black boxes in `Leaf` are moved out of it at once. `Leaf` is
+// instantiated in both `Mid0` and `Mid1`, and the copies moved into each of
+// them are moved out of it at once again, rather than alternating between the
+// two parents. This rewrites `Leaf`, `Mid0`, `Mid1`, and twice the DUT.
+
+// STATS:     ExtractInstances
+// STATS-DAG:   (S) 5 num-parent-rewrites
+// STATS-DAG:   (S) 10 num-moved-instances
+
+// CHECK-LABEL: firrtl.circuit "Batching"
+firrtl.circuit "Batching" {
+  firrtl.extmodule private @BBA(in in: !firrtl.uint<8>, out out: !firrtl.uint<8>) attributes {annotations = [{class = "sifive.enterprise.firrtl.ExtractBlackBoxAnnotation", filename = "BlackBoxes.txt", prefix = "bb"}], defname = "BBA"}
+  firrtl.extmodule private @BBB(in in: !firrtl.uint<8>, out out: !firrtl.uint<8>) attributes {annotations = [{class = "sifive.enterprise.firrtl.ExtractBlackBoxAnnotation", filename = "BlackBoxes.txt", prefix = "bb"}], defname = "BBB"}
+
+  // CHECK-LABEL: firrtl.module private @Leaf
+  // CHECK-SAME:    out %bb_{{[0-9]}}_in
+  // CHECK-SAME:    in %bb_{{[0-9]}}_out
+  // CHECK-SAME:    out %bb_{{[0-9]}}_in
+  // CHECK-SAME:    in %bb_{{[0-9]}}_out
+  // CHECK-NOT:   firrtl.instance
+  // CHECK:       }
+  firrtl.module private @Leaf(in %in: !firrtl.uint<8>, out %out: !firrtl.uint<8>) {
+    %a_in, %a_out = firrtl.instance a @BBA(in in: !firrtl.uint<8>, out out: !firrtl.uint<8>)
+    %b_in, %b_out = firrtl.instance b @BBB(in in: !firrtl.uint<8>, out out: !firrtl.uint<8>)
+    firrtl.strictconnect %a_in, %in : !firrtl.uint<8>
+    firrtl.strictconnect %b_in, %a_out : !firrtl.uint<8>
+    firrtl.strictconnect %out, %b_out : !firrtl.uint<8>
+  }
+
+  // CHECK-LABEL: firrtl.module private @Mid0
+  // CHECK-NOT:   firrtl.instance {{a|b}} {{.*}}@BB
+  // CHECK:       }
+  firrtl.module private @Mid0(in %in: !firrtl.uint<8>, out %out: !firrtl.uint<8>) {
+    %leaf_in, %leaf_out = firrtl.instance leaf @Leaf(in in: !firrtl.uint<8>, out out: !firrtl.uint<8>)
+    firrtl.strictconnect %leaf_in, %in : !firrtl.uint<8>
+    firrtl.strictconnect %out, %leaf_out : !firrtl.uint<8>
+  }
+
+  // CHECK-LABEL: firrtl.module private @Mid1
+  // CHECK-NOT:   firrtl.instance {{a|b}} {{.*}}@BB
+  // CHECK:       }
+  firrtl.module private @Mid1(in %in: !firrtl.uint<8>, out %out: !firrtl.uint<8>) {
+    %leaf_in, %leaf_out = firrtl.instance leaf @Leaf(in in: !firrtl.uint<8>, out out: !firrtl.uint<8>)
+    firrtl.strictconnect %leaf_in, %in : !firrtl.uint<8>
+    firrtl.strictconnect %out, %leaf_out : !firrtl.uint<8>
+  }
+
+  // CHECK-LABEL: firrtl.module private @DUT
+  // CHECK-NOT:   firrtl.instance {{a|b}} {{.*}}@BB
+  // CHECK:       }
+  firrtl.module private @DUT(in %in: !firrtl.uint<8>, out %out: !firrtl.uint<8>) attributes {annotations = [{class = "sifive.enterprise.firrtl.MarkDUTAnnotation"}]} {
+    %mid0_in, %mid0_out = firrtl.instance mid0 @Mid0(in in: !firrtl.uint<8>, out out: !firrtl.uint<8>)
+    %mid1_in, %mid1_out = firrtl.instance mid1 @Mid1(in in: !firrtl.uint<8>, out out: !firrtl.uint<8>)
+    firrtl.strictconnect %mid0_in, %in : !firrtl.uint<8>
+    firrtl.strictconnect %mid1_in, %mid0_out : !firrtl.uint<8>
+    firrtl.strictconnect %out, %mid1_out : !firrtl.uint<8>
+  }
+
+  // All four copies of the black boxes end up next to the DUT.
+  // CHECK-LABEL: firrtl.module @Batching
+  // CHECK:         firrtl.instance dut
+  // CHECK-DAG:     firrtl.instance a {{.*}}@BBA
+  // CHECK-DAG:     firrtl.instance a {{.*}}@BBA
+  // CHECK-DAG:     firrtl.instance b {{.*}}@BBB
+  // CHECK-DAG:     firrtl.instance b {{.*}}@BBB
+  firrtl.module @Batching(in %in: !firrtl.uint<8>, out %out: !firrtl.uint<8>) {
+    %dut_in, %dut_out = firrtl.instance dut @DUT(in in: !firrtl.uint<8>, out out: !firrtl.uint<8>)
+    firrtl.strictconnect %dut_in, %in : !firrtl.uint<8>
+    firrtl.strictconnect %out, %dut_out : !firrtl.uint<8>
+  }
+}
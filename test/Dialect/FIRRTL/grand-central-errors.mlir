@@ -144,6 +144,52 @@ firrtl.circuit "Foo" attributes {
 
 // -----
 
+// The leaves of all modules are collected, and the malformed ones reported, even
+// if they are spread over several modules.
+
+firrtl.circuit "Foo" attributes {
+  annotations = [
+    {class = "sifive.enterprise.grandcentral.AugmentedBundleType",
+     defName = "View",
+     elements = [
+       {class = "sifive.enterprise.grandcentral.AugmentedGroundType",
+        id = 1 : i64,
+        name = "foo"}],
+     id = 0 : i64},
+    {class = "sifive.enterprise.grandcentral.ExtractGrandCentralAnnotation",
+     directory = "gct-dir",
+     filename = "gct-dir/bindings.sv"}]}  {
+  firrtl.module private @View_companion() attributes {
+    annotations = [
+      {class = "sifive.enterprise.grandcentral.ViewAnnotation.companion",
+       defName = "Foo",
+       id = 0 : i64,
+       name = "View"}]} {}
+  firrtl.module private @Bar() {
+    // expected-error @+1 {{'firrtl.wire' op contained a malformed 'sifive.enterprise.grandcentral.AugmentedGroundType' annotation that did not contain an 'id' field}}
+    %b = firrtl.wire {
+      annotations = [
+        {class = "sifive.enterprise.grandcentral.AugmentedGroundType"}]
+    } : !firrtl.uint<1>
+  }
+  // expected-error @+1 {{'firrtl.module' op contained a malformed 'sifive.enterprise.grandcentral.AugmentedGroundType' annotation that did not contain an 'id' field}}
+  firrtl.module private @DUT(in %a: !firrtl.uint<1> [
+      {class = "sifive.enterprise.grandcentral.AugmentedGroundType"}]) {
+    // expected-error @+1 {{'firrtl.node' op contained a malformed 'sifive.enterprise.grandcentral.AugmentedGroundType' annotation that did not contain an 'id' field}}
+    %c = firrtl.node %a {
+      annotations = [
+        {class = "sifive.enterprise.grandcentral.AugmentedGroundType"}]
+    } : !firrtl.uint<1>
+    firrtl.instance bar @Bar()
+    firrtl.instance View_companion @View_companion()
+  }
+  firrtl.module @Foo() {
+    %dut_a = firrtl.instance dut @DUT(in a: !firrtl.uint<1>)
+  }
+}
+
+// -----
+
 // expected-error @+1 {{'firrtl.circuit' op has an AugmentedGroundType with 'id == 42' that does not have a scattered leaf to connect to in the circuit}}
 firrtl.circuit "Foo" attributes {
   annotations = [
@@ -0,0 +1,72 @@
+// RUN: circt-opt -pass-pipeline='builtin.module(firrtl.circuit(firrtl-imconstprop))' %s | FileCheck %s
+
+// Constants have to cross several instance boundaries in both directions, and
+// modules are discovered at different depths of the hierarchy. The per-module
+// solvers exchange these facts over multiple rounds.
+
+firrtl.circuit "Top" {
+  // CHECK-LABEL: firrtl.module private @Leaf
+  firrtl.module private @Leaf(in %in: !firrtl.uint<4>, out %out: !firrtl.uint<4>) {
+    // CHECK-NEXT: [[C5:%.+]] = firrtl.constant 5 : !firrtl.uint<4>
+    // CHECK-NEXT: firrtl.strictconnect %out, [[C5]]
+    // CHECK-NEXT: }
+    firrtl.strictconnect %out, %in : !firrtl.uint<4>
+  }
+
+  // The output of @Const is already known when @Middle instantiates it, one
+  // round after @Top did.
+  // CHECK-LABEL: firrtl.module private @Const
+  firrtl.module private @Const(out %out: !firrtl.uint<4>) {
+    %c3_ui4 = firrtl.constant 3 : !firrtl.uint<4>
+    firrtl.strictconnect %out, %c3_ui4 : !firrtl.uint<4>
+  }
+
+  // Instances driven with different constants leave the port overdefined.
+  // CHECK-LABEL: firrtl.module private @Shared
+  firrtl.module private @Shared(in %in: !firrtl.uint<4>, out %out: !firrtl.uint<4>) {
+    // CHECK-NEXT: firrtl.strictconnect %out, %in
+    // CHECK-NEXT: }
+    firrtl.strictconnect %out, %in : !firrtl.uint<4>
+  }
+
+  // CHECK-LABEL: firrtl.module private @Middle
+  firrtl.module private @Middle(in %in: !firrtl.uint<4>, out %out: !firrtl.uint<4>,
+                                out %out2: !firrtl.uint<4>) {
+    // CHECK-DAG: [[C5:%.+]] = firrtl.constant 5 : !firrtl.uint<4>
+    // CHECK-DAG: [[C3:%.+]] = firrtl.constant 3 : !firrtl.uint<4>
+    // CHECK-DAG: firrtl.strictconnect %leaf_in, [[C5]]
+    // CHECK-DAG: firrtl.strictconnect %out, [[C5]]
+    // CHECK-DAG: firrtl.strictconnect %out2, [[C3]]
+    %leaf_in, %leaf_out = firrtl.instance leaf @Leaf(in in: !firrtl.uint<4>, out out: !firrtl.uint<4>)
+    firrtl.strictconnect %leaf_in, %in : !firrtl.uint<4>
+    firrtl.strictconnect %out, %leaf_out : !firrtl.uint<4>
+    %const_out = firrtl.instance const @Const(out out: !firrtl.uint<4>)
+    firrtl.strictconnect %out2, %const_out : !firrtl.uint<4>
+  }
+
+  // CHECK-LABEL: firrtl.module @Top
+  firrtl.module @Top(out %a: !firrtl.uint<4>, out %b: !firrtl.uint<4>,
+                     out %c: !firrtl.uint<4>, out %d: !firrtl.uint<4>,
+                     out %e: !firrtl.uint<4>) {
+    %c1_ui4 = firrtl.constant 1 : !firrtl.uint<4>
+    %c2_ui4 = firrtl.constant 2 : !firrtl.uint<4>
+    %c5_ui4 = firrtl.constant 5 : !firrtl.uint<4>
+    %middle_in, %middle_out, %middle_out2 = firrtl.instance middle @Middle(in in: !firrtl.uint<4>, out out: !firrtl.uint<4>, out out2: !firrtl.uint<4>)
+    firrtl.strictconnect %middle_in, %c5_ui4 : !firrtl.uint<4>
+    %const_out = firrtl.instance const @Const(out out: !firrtl.uint<4>)
+    %shared1_in, %shared1_out = firrtl.instance shared1 @Shared(in in: !firrtl.uint<4>, out out: !firrtl.uint<4>)
+    firrtl.strictconnect %shared1_in, %c1_ui4 : !firrtl.uint<4>
+    %shared2_in, %shared2_out = firrtl.instance shared2 @Shared(in in: !firrtl.uint<4>, out out: !firrtl.uint<4>)
+    firrtl.strictconnect %shared2_in, %c2_ui4 : !firrtl.uint<4>
+    // CHECK-DAG: firrtl.strictconnect %a, %c5_ui4{{(_[0-9]+)?}} :
+    // CHECK-DAG: firrtl.strictconnect %b, %c3_ui4{{(_[0-9]+)?}} :
+    // CHECK-DAG: firrtl.strictconnect %c, %c3_ui4{{(_[0-9]+)?}} :
+    // CHECK-DAG: firrtl.strictconnect %d, %shared1_out :
+    // CHECK-DAG: firrtl.strictconnect %e, %shared2_out :
+    firrtl.strictconnect %a, %middle_out : !firrtl.uint<4>
+    firrtl.strictconnect %b, %middle_out2 : !firrtl.uint<4>
+    firrtl.strictconnect %c, %const_out : !firrtl.uint<4>
+    firrtl.strictconnect %d, %shared1_out : !firrtl.uint<4>
+    firrtl.strictconnect %e, %shared2_out : !firrtl.uint<4>
+  }
+}
@@ -282,5 +282,107 @@ firrtl.circuit "TLRAM" {
       firrtl.connect %auto_0, %11 : !firrtl.uint<8>, !firrtl.uint<8>
 
     }
-}
 
+// Test enables testing a state against distinct constants.
+// CHECK-LABEL: firrtl.module @StateExclusive
+  firrtl.module @StateExclusive(in %clock: !firrtl.clock, in %addr: !firrtl.uint<4>, in %s: !firrtl.uint<1>, in %state: !firrtl.uint<2>, in %ren: !firrtl.uint<1>, in %wen: !firrtl.uint<1>, in %wdata: !firrtl.uint<8>, out %rdata: !firrtl.uint<8>) {
+    %c0_ui1 = firrtl.constant 0 : !firrtl.uint<1>
+    %c1_ui1 = firrtl.constant 1 : !firrtl.uint<1>
+    %c1_ui2 = firrtl.constant 1 : !firrtl.uint<2>
+    %c2_ui2 = firrtl.constant 2 : !firrtl.uint<2>
+    %isRead = firrtl.eq %state, %c1_ui2 : (!firrtl.uint<2>, !firrtl.uint<2>) -> !firrtl.uint<1>
+    %isWrite = firrtl.eq %state, %c2_ui2 : (!firrtl.uint<2>, !firrtl.uint<2>) -> !firrtl.uint<1>
+    %0 = firrtl.and %isRead, %ren : (!firrtl.uint<1>, !firrtl.uint<1>) -> !firrtl.uint<1>
+    %read = firrtl.node %0 : !firrtl.uint<1>
+    %1 = firrtl.and %wen, %isWrite : (!firrtl.uint<1>, !firrtl.uint<1>) -> !firrtl.uint<1>
+// CHECK: %mem_rw = firrtl.mem Undefined {depth = 16 : i64, name = "mem", portNames = ["rw"]
+// CHECK: %[[wmode:.+]] = firrtl.subfield %mem_rw[wmode]
+// CHECK: firrtl.strictconnect %[[wmode]], %isWrite : !firrtl.uint<1>
+    %r, %w = firrtl.mem Undefined {depth = 16 : i64, name = "mem", portNames = ["r", "w"], readLatency = 1 : i32, writeLatency = 1 : i32} : !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data flip: uint<8>>, !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data: uint<8>, mask: uint<1>>
+    %r_addr = firrtl.subfield %r[addr] : !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data flip: uint<8>>
+    %r_en = firrtl.subfield %r[en] : !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data flip: uint<8>>
+    %r_clk = firrtl.subfield %r[clk] : !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data flip: uint<8>>
+    %r_data = firrtl.subfield %r[data] : !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data flip: uint<8>>
+    %w_addr = firrtl.subfield %w[addr] : !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data: uint<8>, mask: uint<1>>
+    %w_en = firrtl.subfield %w[en] : !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data: uint<8>, mask: uint<1>>
+    %w_clk = firrtl.subfield %w[clk] : !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data: uint<8>, mask: uint<1>>
+    %w_data = firrtl.subfield %w[data] : !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data: uint<8>, mask: uint<1>>
+    %w_mask = firrtl.subfield %w[mask] : !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data: uint<8>, mask: uint<1>>
+    firrtl.strictconnect %r_addr, %addr : !firrtl.uint<4>
+    firrtl.strictconnect %r_en, %read : !firrtl.uint<1>
+    firrtl.strictconnect %r_clk, %clock : !firrtl.clock
+    firrtl.strictconnect %rdata, %r_data : !firrtl.uint<8>
+    firrtl.strictconnect %w_addr, %addr : !firrtl.uint<4>
+    firrtl.strictconnect %w_en, %1 : !firrtl.uint<1>
+    firrtl.strictconnect %w_clk, %clock : !firrtl.clock
+    firrtl.strictconnect %w_data, %wdata : !firrtl.uint<8>
+    firrtl.strictconnect %w_mask, %c1_ui1 : !firrtl.uint<1>
+  }
+
+// Test a write enable requiring the complement of a read enable select.
+// CHECK-LABEL: firrtl.module @MuxExclusive
+  firrtl.module @MuxExclusive(in %clock: !firrtl.clock, in %addr: !firrtl.uint<4>, in %s: !firrtl.uint<1>, in %state: !firrtl.uint<2>, in %ren: !firrtl.uint<1>, in %wen: !firrtl.uint<1>, in %wdata: !firrtl.uint<8>, out %rdata: !firrtl.uint<8>) {
+    %c0_ui1 = firrtl.constant 0 : !firrtl.uint<1>
+    %c1_ui1 = firrtl.constant 1 : !firrtl.uint<1>
+    %c1_ui2 = firrtl.constant 1 : !firrtl.uint<2>
+    %c2_ui2 = firrtl.constant 2 : !firrtl.uint<2>
+    %0 = firrtl.and %s, %ren : (!firrtl.uint<1>, !firrtl.uint<1>) -> !firrtl.uint<1>
+    %1 = firrtl.mux(%s, %c0_ui1, %wen) : (!firrtl.uint<1>, !firrtl.uint<1>, !firrtl.uint<1>) -> !firrtl.uint<1>
+// CHECK: %mem_rw = firrtl.mem Undefined {depth = 16 : i64, name = "mem", portNames = ["rw"]
+// CHECK: %[[wmode:.+]] = firrtl.subfield %mem_rw[wmode]
+// CHECK: %[[notS:.+]] = firrtl.not %s
+// CHECK-NEXT: firrtl.strictconnect %[[wmode]], %[[notS]] : !firrtl.uint<1>
+    %r, %w = firrtl.mem Undefined {depth = 16 : i64, name = "mem", portNames = ["r", "w"], readLatency = 1 : i32, writeLatency = 1 : i32} : !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data flip: uint<8>>, !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data: uint<8>, mask: uint<1>>
+    %r_addr = firrtl.subfield %r[addr] : !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data flip: uint<8>>
+    %r_en = firrtl.subfield %r[en] : !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data flip: uint<8>>
+    %r_clk = firrtl.subfield %r[clk] : !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data flip: uint<8>>
+    %r_data = firrtl.subfield %r[data] : !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data flip: uint<8>>
+    %w_addr = firrtl.subfield %w[addr] : !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data: uint<8>, mask: uint<1>>
+    %w_en = firrtl.subfield %w[en] : !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data: uint<8>, mask: uint<1>>
+    %w_clk = firrtl.subfield %w[clk] : !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data: uint<8>, mask: uint<1>>
+    %w_data = firrtl.subfield %w[data] : !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data: uint<8>, mask: uint<1>>
+    %w_mask = firrtl.subfield %w[mask] : !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data: uint<8>, mask: uint<1>>
+    firrtl.strictconnect %r_addr, %addr : !firrtl.uint<4>
+    firrtl.strictconnect %r_en, %0 : !firrtl.uint<1>
+    firrtl.strictconnect %r_clk, %clock : !firrtl.clock
+    firrtl.strictconnect %rdata, %r_data : !firrtl.uint<8>
+    firrtl.strictconnect %w_addr, %addr : !firrtl.uint<4>
+    firrtl.strictconnect %w_en, %1 : !firrtl.uint<1>
+    firrtl.strictconnect %w_clk, %clock : !firrtl.clock
+    firrtl.strictconnect %w_data, %wdata : !firrtl.uint<8>
+    firrtl.strictconnect %w_mask, %c1_ui1 : !firrtl.uint<1>
+  }
+
+// Test that enables which may be true at the same time are not merged.
+// CHECK-LABEL: firrtl.module @NotExclusive
+  firrtl.module @NotExclusive(in %clock: !firrtl.clock, in %addr: !firrtl.uint<4>, in %s: !firrtl.uint<1>, in %state: !firrtl.uint<2>, in %ren: !firrtl.uint<1>, in %wen: !firrtl.uint<1>, in %wdata: !firrtl.uint<8>, out %rdata: !firrtl.uint<8>) {
+    %c0_ui1 = firrtl.constant 0 : !firrtl.uint<1>
+    %c1_ui1 = firrtl.constant 1 : !firrtl.uint<1>
+    %c1_ui2 = firrtl.constant 1 : !firrtl.uint<2>
+    %c2_ui2 = firrtl.constant 2 : !firrtl.uint<2>
+    %isRead = firrtl.eq %state, %c1_ui2 : (!firrtl.uint<2>, !firrtl.uint<2>) -> !firrtl.uint<1>
+    %isWrite = firrtl.neq %state, %c2_ui2 : (!firrtl.uint<2>, !firrtl.uint<2>) -> !firrtl.uint<1>
+    %0 = firrtl.and %isRead, %ren : (!firrtl.uint<1>, !firrtl.uint<1>) -> !firrtl.uint<1>
+    %1 = firrtl.and %wen, %isWrite : (!firrtl.uint<1>, !firrtl.uint<1>) -> !firrtl.uint<1>
+// CHECK: firrtl.mem Undefined {depth = 16 : i64, name = "mem", portNames = ["r", "w"]
+    %r, %w = firrtl.mem Undefined {depth = 16 : i64, name = "mem", portNames = ["r", "w"], readLatency = 1 : i32, writeLatency = 1 : i32} : !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data flip: uint<8>>, !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data: uint<8>, mask: uint<1>>
+    %r_addr = firrtl.subfield %r[addr] : !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data flip: uint<8>>
+    %r_en = firrtl.subfield %r[en] : !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data flip: uint<8>>
+    %r_clk = firrtl.subfield %r[clk] : !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data flip: uint<8>>
+    %r_data = firrtl.subfield %r[data] : !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data flip: uint<8>>
+    %w_addr = firrtl.subfield %w[addr] : !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data: uint<8>, mask: uint<1>>
+    %w_en = firrtl.subfield %w[en] : !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data: uint<8>, mask: uint<1>>
+    %w_clk = firrtl.subfield %w[clk] : !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data: uint<8>, mask: uint<1>>
+    %w_data = firrtl.subfield %w[data] : !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data: uint<8>, mask: uint<1>>
+    %w_mask = firrtl.subfield %w[mask] : !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data: uint<8>, mask: uint<1>>
+    firrtl.strictconnect %r_addr, %addr : !firrtl.uint<4>
+    firrtl.strictconnect %r_en, %0 : !firrtl.uint<1>
+    firrtl.strictconnect %r_clk, %clock : !firrtl.clock
+    firrtl.strictconnect %rdata, %r_data : !firrtl.uint<8>
+    firrtl.strictconnect %w_addr, %addr : !firrtl.uint<4>
+    firrtl.strictconnect %w_en, %1 : !firrtl.uint<1>
+    firrtl.strictconnect %w_clk, %clock : !firrtl.clock
+    firrtl.strictconnect %w_data, %wdata : !firrtl.uint<8>
+    firrtl.strictconnect %w_mask, %c1_ui1 : !firrtl.uint<1>
+  }
+}
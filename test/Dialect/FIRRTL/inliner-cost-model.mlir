@@ -0,0 +1,72 @@
+// RUN: circt-opt --pass-pipeline='builtin.module(firrtl.circuit(firrtl-inliner{max-inline-size=3}))' %s | FileCheck %s
+// RUN: circt-opt --pass-pipeline='builtin.module(firrtl.circuit(firrtl-inliner{max-inline-size=3 max-inline-growth=2}))' %s | FileCheck %s --check-prefix=GROWTH
+// RUN: circt-opt --pass-pipeline='builtin.module(firrtl.circuit(firrtl-inliner))' %s | FileCheck %s --check-prefix=DISABLED
+
+firrtl.circuit "Top" {
+  // CHECK-LABEL: firrtl.module @Top
+  // CHECK-NOT:     firrtl.instance small
+  // CHECK:         %small0_w = firrtl.wire
+  // CHECK:         %small1_w = firrtl.wire
+  // CHECK:         firrtl.instance big @Big
+  // CHECK:         firrtl.instance sym @Sym
+  // CHECK:         firrtl.instance anno @Anno
+
+  // GROWTH-LABEL: firrtl.module @Top
+  // GROWTH:         firrtl.instance small0 @Small
+  // GROWTH:         firrtl.instance small1 @Small
+
+  // DISABLED-LABEL: firrtl.module @Top
+  // DISABLED:         firrtl.instance small0 @Small
+  // DISABLED:         firrtl.instance small1 @Small
+  firrtl.module @Top(in %a: !firrtl.uint<1>, out %b: !firrtl.uint<1>,
+                     out %c: !firrtl.uint<1>, out %d: !firrtl.uint<1>,
+                     out %e: !firrtl.uint<1>, out %f: !firrtl.uint<1>) {
+    %small0_a, %small0_b = firrtl.instance small0 @Small(in a: !firrtl.uint<1>, out b: !firrtl.uint<1>)
+    %small1_a, %small1_b = firrtl.instance small1 @Small(in a: !firrtl.uint<1>, out b: !firrtl.uint<1>)
+    %big_a, %big_b = firrtl.instance big @Big(in a: !firrtl.uint<1>, out b: !firrtl.uint<1>)
+    %sym_a, %sym_b = firrtl.instance sym @Sym(in a: !firrtl.uint<1>, out b: !firrtl.uint<1>)
+    %anno_a, %anno_b = firrtl.instance anno @Anno(in a: !firrtl.uint<1>, out b: !firrtl.uint<1>)
+    firrtl.strictconnect %small0_a, %a : !firrtl.uint<1>
+    firrtl.strictconnect %small1_a, %a : !firrtl.uint<1>
+    firrtl.strictconnect %big_a, %a : !firrtl.uint<1>
+    firrtl.strictconnect %sym_a, %a : !firrtl.uint<1>
+    firrtl.strictconnect %anno_a, %a : !firrtl.uint<1>
+    firrtl.strictconnect %b, %small0_b : !firrtl.uint<1>
+    firrtl.strictconnect %c, %small1_b : !firrtl.uint<1>
+    firrtl.strictconnect %d, %big_b : !firrtl.uint<1>
+    firrtl.strictconnect %e, %sym_b : !firrtl.uint<1>
+    firrtl.strictconnect %f, %anno_b : !firrtl.uint<1>
+  }
+
+  // Small enough to be inlined into both instances.
+  // CHECK-NOT: firrtl.module private @Small
+  // GROWTH: firrtl.module private @Small
+  firrtl.module private @Small(in %a: !firrtl.uint<1>, out %b: !firrtl.uint<1>) {
+    %w = firrtl.wire : !firrtl.uint<1>
+    firrtl.strictconnect %w, %a : !firrtl.uint<1>
+    firrtl.strictconnect %b, %w : !firrtl.uint<1>
+  }
+
+  // Too many operations.
+  // CHECK: firrtl.module private @Big
+  firrtl.module private @Big(in %a: !firrtl.uint<1>, out %b: !firrtl.uint<1>) {
+    %w = firrtl.wire : !firrtl.uint<1>
+    %x = firrtl.not %a : (!firrtl.uint<1>) -> !firrtl.uint<1>
+    firrtl.strictconnect %w, %x : !firrtl.uint<1>
+    firrtl.strictconnect %b, %w : !firrtl.uint<1>
+  }
+
+  // Modules with symbols are left alone.
+  // CHECK: firrtl.module private @Sym
+  firrtl.module private @Sym(in %a: !firrtl.uint<1>, out %b: !firrtl.uint<1>) {
+    %w = firrtl.wire sym @w : !firrtl.uint<1>
+    firrtl.strictconnect %b, %a : !firrtl.uint<1>
+  }
+
+  // Modules with annotations are left alone.
+  // CHECK: firrtl.module private @Anno
+  firrtl.module private @Anno(in %a: !firrtl.uint<1>, out %b: !firrtl.uint<1>)
+      attributes {annotations = [{class = "circt.test"}]} {
+    firrtl.strictconnect %b, %a : !firrtl.uint<1>
+  }
+}
@@ -0,0 +1,22 @@
+// RUN: circt-opt -firrtl-lower-memory -mlir-pass-statistics %s -o /dev/null 2>&1 | FileCheck %s
+
+// CHECK:     LowerMemory
+// CHECK-DAG:   (S) 2 num-created-mem-modules
+// CHECK-DAG:   (S) 3 num-deduped-mems
+// CHECK-DAG:   (S) 5 num-lowered-mems
+
+// The three memories with the same shape share a memory module.
+firrtl.circuit "Statistics" {
+firrtl.module @Statistics() {
+  %mem0_write = firrtl.mem Undefined {depth = 12 : i64, name = "mem0", portNames = ["write"], readLatency = 1 : i32, writeLatency = 1 : i32} : !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data: uint<42>, mask: uint<1>>
+  %mem1_write = firrtl.mem Undefined {depth = 12 : i64, name = "mem1", portNames = ["write"], readLatency = 1 : i32, writeLatency = 1 : i32} : !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data: uint<42>, mask: uint<1>>
+  %mem2_write = firrtl.mem Undefined {depth = 12 : i64, name = "mem2", portNames = ["write"], readLatency = 1 : i32, writeLatency = 1 : i32} : !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data: uint<42>, mask: uint<1>>
+  firrtl.instance child @Child()
+}
+// The memory with a different shape gets its own memory module, and the one
+// with the same shape as above shares it.
+firrtl.module @Child() {
+  %mem3_write = firrtl.mem Undefined {depth = 24 : i64, name = "mem3", portNames = ["write"], readLatency = 1 : i32, writeLatency = 1 : i32} : !firrtl.bundle<addr: uint<5>, en: uint<1>, clk: clock, data: uint<42>, mask: uint<1>>
+  %mem4_write = firrtl.mem Undefined {depth = 12 : i64, name = "mem4", portNames = ["write"], readLatency = 1 : i32, writeLatency = 1 : i32} : !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data: uint<42>, mask: uint<1>>
+}
+}
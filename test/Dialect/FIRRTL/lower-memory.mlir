@@ -275,3 +275,23 @@ firrtl.module @DUT() {
 // CHECK-SAME:  {annotations = [{circt.nonlocal = @[[nla_1]], class = "test1"}]}
 // CHECK-SAME:  @mem0_ext(
 }
+
+// Check that the clones of the non-local paths are named along with the wrapper
+// of their memory, before the wrappers of the memories that follow.
+// CHECK-LABEL: firrtl.circuit "NonLocalAnnotationNames"
+firrtl.circuit "NonLocalAnnotationNames" {
+// CHECK: hw.hierpath private @nla_0 [@NonLocalAnnotationNames::@a, @A::@x, @x]
+hw.hierpath private @nla [@NonLocalAnnotationNames::@a, @A::@x]
+firrtl.module @NonLocalAnnotationNames() {
+  firrtl.instance a sym @a @A()
+  firrtl.instance b @B()
+}
+firrtl.module @A() {
+  %x_write = firrtl.mem sym @x Undefined {annotations = [{circt.nonlocal = @nla, class = "test"}], depth = 12 : i64, name = "x", portNames = ["write"], readLatency = 1 : i32, writeLatency = 1 : i32} : !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data: uint<42>, mask: uint<1>>
+}
+// CHECK: firrtl.module @B()
+// CHECK-NEXT: firrtl.instance nla {{.*}}@nla_1(
+firrtl.module @B() {
+  %nla_write = firrtl.mem Undefined {depth = 12 : i64, name = "nla", portNames = ["write"], readLatency = 1 : i32, writeLatency = 1 : i32} : !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data: uint<42>, mask: uint<1>>
+}
+}
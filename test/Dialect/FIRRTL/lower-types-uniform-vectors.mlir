@@ -0,0 +1,33 @@
+// RUN: circt-opt -pass-pipeline='builtin.module(firrtl.circuit(firrtl-lower-types{preserve-uniform-vectors=true}))' %s | FileCheck %s
+
+firrtl.circuit "Uniform" {
+  // A vector register that is only connected as a whole and read through a
+  // dynamic subaccess is kept as a vector, and the read is not expanded.
+  // CHECK-LABEL: firrtl.module @Uniform
+  // CHECK-SAME: in %in_0_a: !firrtl.uint<8>
+  firrtl.module @Uniform(in %clock: !firrtl.clock, in %sel: !firrtl.uint<2>,
+                         in %in: !firrtl.vector<bundle<a: uint<8>, b: uint<1>>, 4>,
+                         out %out: !firrtl.bundle<a: uint<8>, b: uint<1>>) {
+    // CHECK: %r = firrtl.reg %clock : !firrtl.clock, !firrtl.vector<bundle<a: uint<8>, b: uint<1>>, 4>
+    %r = firrtl.reg %clock : !firrtl.clock, !firrtl.vector<bundle<a: uint<8>, b: uint<1>>, 4>
+    firrtl.strictconnect %r, %in : !firrtl.vector<bundle<a: uint<8>, b: uint<1>>, 4>
+    // CHECK-NOT: firrtl.multibit_mux
+    // CHECK: %[[ACCESS:.+]] = firrtl.subaccess %r[%sel]
+    // CHECK: firrtl.subfield %[[ACCESS]][a]
+    // CHECK: firrtl.subfield %[[ACCESS]][b]
+    %0 = firrtl.subaccess %r[%sel] : !firrtl.vector<bundle<a: uint<8>, b: uint<1>>, 4>, !firrtl.uint<2>
+    firrtl.strictconnect %out, %0 : !firrtl.bundle<a: uint<8>, b: uint<1>>
+  }
+
+  // A vector wire with a static access is lowered as usual.
+  // CHECK-LABEL: firrtl.module @StaticAccess
+  firrtl.module @StaticAccess(in %in: !firrtl.vector<uint<1>, 2>,
+                              out %out: !firrtl.uint<1>) {
+    // CHECK: %w_0 = firrtl.wire
+    // CHECK: %w_1 = firrtl.wire
+    %w = firrtl.wire : !firrtl.vector<uint<1>, 2>
+    firrtl.strictconnect %w, %in : !firrtl.vector<uint<1>, 2>
+    %0 = firrtl.subindex %w[0] : !firrtl.vector<uint<1>, 2>
+    firrtl.strictconnect %out, %0 : !firrtl.uint<1>
+  }
+}
@@ -0,0 +1,57 @@
+// RUN: circt-opt %s --firrtl-lower-xmr -split-input-file | FileCheck %s
+
+// A probe resolved several times shares a single resolved path.
+
+// CHECK-LABEL: firrtl.circuit "Top"
+firrtl.circuit "Top" {
+  // CHECK:      hw.hierpath private @[[path:[a-zA-Z0-9_]+]]
+  // CHECK-SAME:   [@Top::@bar, @Bar::@barXMR, @XmrSrcMod::@[[xmrSym:[a-zA-Z0-9_]+]]]
+  // CHECK-NOT:  hw.hierpath
+  firrtl.module @XmrSrcMod(out %_a: !firrtl.probe<uint<1>>) {
+    %zero = firrtl.constant 0 : !firrtl.uint<1>
+    %1 = firrtl.ref.send %zero : !firrtl.uint<1>
+    firrtl.ref.define %_a, %1 : !firrtl.probe<uint<1>>
+  }
+  firrtl.module @Bar(out %_a: !firrtl.probe<uint<1>>) {
+    %xmr = firrtl.instance bar sym @barXMR @XmrSrcMod(out _a: !firrtl.probe<uint<1>>)
+    firrtl.ref.define %_a, %xmr : !firrtl.probe<uint<1>>
+  }
+  // CHECK-LABEL: firrtl.module @Top(
+  firrtl.module @Top(out %a: !firrtl.uint<1>, out %b: !firrtl.uint<1>,
+                     out %c: !firrtl.uint<1>) {
+    %bar_a = firrtl.instance bar sym @bar @Bar(out _a: !firrtl.probe<uint<1>>)
+    // CHECK-COUNT-3: sv.xmr.ref @[[path]] : !hw.inout<i1>
+    // CHECK-NOT:     sv.xmr.ref
+    %0 = firrtl.ref.resolve %bar_a : !firrtl.probe<uint<1>>
+    firrtl.strictconnect %a, %0 : !firrtl.uint<1>
+    %1 = firrtl.ref.resolve %bar_a : !firrtl.probe<uint<1>>
+    firrtl.strictconnect %b, %1 : !firrtl.uint<1>
+    %2 = firrtl.ref.resolve %bar_a : !firrtl.probe<uint<1>>
+    firrtl.strictconnect %c, %2 : !firrtl.uint<1>
+  }
+}
+
+// -----
+
+// The internal path suffix of a probe is kept for every resolution after the
+// first one.
+
+// CHECK-LABEL: firrtl.circuit "InternalPaths"
+firrtl.circuit "InternalPaths" {
+  firrtl.extmodule private @RefExt(out r: !firrtl.probe<uint<1>>)
+    attributes {convention = #firrtl<convention scalarized>,
+                internalPaths = ["path.to.internal.signal"]}
+  // CHECK:     hw.hierpath private @xmrPath [@InternalPaths::@xmr_sym]
+  // CHECK-NOT: hw.hierpath
+  // CHECK:     module public @InternalPaths(
+  firrtl.module public @InternalPaths() {
+    %ext_r = firrtl.instance ext @RefExt(out r: !firrtl.probe<uint<1>>)
+    // CHECK:     sv.xmr.ref @xmrPath ".path.to.internal.signal" : !hw.inout<i1>
+    // CHECK:     sv.xmr.ref @xmrPath ".path.to.internal.signal" : !hw.inout<i1>
+    // CHECK-NOT: sv.xmr.ref
+    %read0 = firrtl.ref.resolve %ext_r : !firrtl.probe<uint<1>>
+    %node0 = firrtl.node %read0 : !firrtl.uint<1>
+    %read1 = firrtl.ref.resolve %ext_r : !firrtl.probe<uint<1>>
+    %node1 = firrtl.node %read1 : !firrtl.uint<1>
+  }
+}
@@ -0,0 +1,30 @@
+// RUN: circt-opt -pass-pipeline='builtin.module(firrtl.circuit(firrtl-mem-to-reg-of-vec{bank-depth=4 max-depth=64}))' %s | FileCheck %s
+
+firrtl.circuit "Banks" attributes {annotations = [{class = "sifive.enterprise.firrtl.ConvertMemToRegOfVecAnnotation$"}]}{
+  // CHECK-LABEL: firrtl.module @Banks
+  firrtl.module @Banks() {
+    // Memories deeper than the bank depth are split into banks, with the
+    // upper address bits selecting the bank.
+    // CHECK:      %mem = firrtl.reg %{{.+}} : !firrtl.clock, !firrtl.vector<vector<uint<8>, 4>, 3>
+    // CHECK:      [[BANK:%.+]] = firrtl.bits [[ADDR:%.+]] 3 to 2 : (!firrtl.uint<4>) -> !firrtl.uint<2>
+    // CHECK-NEXT: [[ENTRY:%.+]] = firrtl.bits [[ADDR]] 1 to 0 : (!firrtl.uint<4>) -> !firrtl.uint<2>
+    // CHECK-NEXT: [[V0:%.+]] = firrtl.subaccess %mem{{\[}}[[BANK]]{{\]}} : !firrtl.vector<vector<uint<8>, 4>, 3>, !firrtl.uint<2>
+    // CHECK-NEXT: [[V1:%.+]] = firrtl.subaccess [[V0]]{{\[}}[[ENTRY]]{{\]}} : !firrtl.vector<uint<8>, 4>, !firrtl.uint<2>
+    // CHECK:      firrtl.strictconnect %{{.+}}, [[V1]] : !firrtl.uint<8>
+    // CHECK:      firrtl.subaccess %mem[
+    // CHECK:      firrtl.subaccess
+    %mem_read, %mem_write = firrtl.mem Undefined {depth = 10 : i64, name = "mem", portNames = ["read", "write"], readLatency = 0 : i32, writeLatency = 1 : i32} :
+      !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data flip: uint<8>>,
+      !firrtl.bundle<addr: uint<4>, en: uint<1>, clk: clock, data: uint<8>, mask: uint<1>>
+
+    // Memories up to the bank depth are not split.
+    // CHECK: %small = firrtl.reg %{{.+}} : !firrtl.clock, !firrtl.vector<uint<8>, 4>
+    %small_read = firrtl.mem Undefined {depth = 4 : i64, name = "small", portNames = ["read"], readLatency = 1 : i32, writeLatency = 1 : i32} :
+      !firrtl.bundle<addr: uint<2>, en: uint<1>, clk: clock, data flip: uint<8>>
+
+    // Memories deeper than the maximum depth are kept as memories.
+    // CHECK: %large_read = firrtl.mem Undefined {depth = 128 : i64, name = "large"
+    %large_read = firrtl.mem Undefined {depth = 128 : i64, name = "large", portNames = ["read"], readLatency = 1 : i32, writeLatency = 1 : i32} :
+      !firrtl.bundle<addr: uint<7>, en: uint<1>, clk: clock, data flip: uint<8>>
+  }
+}
@@ -180,3 +180,29 @@ firrtl.circuit "UnusedOutput"  {
     firrtl.strictconnect %b, %singleDriver_b : !firrtl.uint<1>
   }
 }
+
+// -----
+
+// Removing an input port of one instance may leave an output port of another
+// instance unused, even if that module was visited first.
+
+// CHECK-LABEL: "Siblings"
+firrtl.circuit "Siblings"  {
+  // CHECK-LABEL: firrtl.module private @Source(in %x: !firrtl.uint<1>)
+  firrtl.module private @Source(in %x: !firrtl.uint<1>, out %o: !firrtl.uint<1>) {
+    firrtl.strictconnect %o, %x : !firrtl.uint<1>
+  }
+  // CHECK-LABEL: firrtl.module private @Sink()
+  firrtl.module private @Sink(in %a: !firrtl.uint<1>) {
+  }
+  // CHECK-LABEL: firrtl.module @Siblings
+  firrtl.module @Siblings(in %x: !firrtl.uint<1>) {
+    // CHECK:      %source_x = firrtl.instance source @Source(in x: !firrtl.uint<1>)
+    // CHECK-NEXT: firrtl.instance sink @Sink()
+    // CHECK-NEXT: firrtl.strictconnect %source_x, %x
+    %source_x, %source_o = firrtl.instance source @Source(in x: !firrtl.uint<1>, out o: !firrtl.uint<1>)
+    %sink_a = firrtl.instance sink @Sink(in a: !firrtl.uint<1>)
+    firrtl.strictconnect %source_x, %x : !firrtl.uint<1>
+    firrtl.strictconnect %sink_a, %source_o : !firrtl.uint<1>
+  }
+}
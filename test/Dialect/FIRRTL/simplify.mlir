@@ -0,0 +1,94 @@
+// RUN: circt-opt --pass-pipeline='builtin.module(firrtl.circuit(firrtl.module(firrtl-simplify)))' %s | FileCheck %s
+
+firrtl.circuit "Fold" {
+
+// CHECK-LABEL: firrtl.module @Fold
+firrtl.module @Fold(in %a: !firrtl.uint<4>, out %out0: !firrtl.uint<4>,
+                    out %out1: !firrtl.uint<4>) {
+  // CHECK-NEXT: %c1_ui4 = firrtl.constant 1 : !firrtl.uint<4>
+  // CHECK-NEXT: firrtl.strictconnect %out0, %a : !firrtl.uint<4>
+  // CHECK-NEXT: firrtl.strictconnect %out1, %c1_ui4 : !firrtl.uint<4>
+  // CHECK-NEXT: }
+  %c1_ui4 = firrtl.constant 1 : !firrtl.uint<4>
+  %c0_ui4 = firrtl.constant 0 : !firrtl.uint<4>
+  %0 = firrtl.and %a, %a : (!firrtl.uint<4>, !firrtl.uint<4>) -> !firrtl.uint<4>
+  %1 = firrtl.or %c1_ui4, %c0_ui4 : (!firrtl.uint<4>, !firrtl.uint<4>) -> !firrtl.uint<4>
+  firrtl.strictconnect %out0, %0 : !firrtl.uint<4>
+  firrtl.strictconnect %out1, %1 : !firrtl.uint<4>
+}
+
+// CHECK-LABEL: firrtl.module @Deduplicate
+firrtl.module @Deduplicate(in %a: !firrtl.uint<4>, in %b: !firrtl.uint<4>,
+                           out %out: !firrtl.uint<8>) {
+  // CHECK-NEXT: %0 = firrtl.xor %a, %b
+  // CHECK-NEXT: %1 = firrtl.mul %0, %0
+  // CHECK-NEXT: firrtl.strictconnect %out, %1 : !firrtl.uint<8>
+  // CHECK-NEXT: }
+  %0 = firrtl.xor %a, %b : (!firrtl.uint<4>, !firrtl.uint<4>) -> !firrtl.uint<4>
+  %1 = firrtl.xor %a, %b : (!firrtl.uint<4>, !firrtl.uint<4>) -> !firrtl.uint<4>
+  %2 = firrtl.mul %0, %1 : (!firrtl.uint<4>, !firrtl.uint<4>) -> !firrtl.uint<8>
+  firrtl.strictconnect %out, %2 : !firrtl.uint<8>
+}
+
+// Forwarding a wire changes the operands of an expression visited before it,
+// which is then deduplicated with an identical expression that follows it.
+// CHECK-LABEL: firrtl.module @Forward
+firrtl.module @Forward(in %a: !firrtl.uint<4>, in %b: !firrtl.uint<4>,
+                       out %out0: !firrtl.uint<4>, out %out1: !firrtl.uint<4>) {
+  // CHECK-NEXT: %0 = firrtl.xor %a, %b
+  // CHECK-NEXT: firrtl.strictconnect %out0, %0 : !firrtl.uint<4>
+  // CHECK-NEXT: firrtl.strictconnect %out1, %0 : !firrtl.uint<4>
+  // CHECK-NEXT: }
+  %_w = firrtl.wire droppable_name : !firrtl.uint<4>
+  %0 = firrtl.xor %_w, %b : (!firrtl.uint<4>, !firrtl.uint<4>) -> !firrtl.uint<4>
+  %1 = firrtl.xor %a, %b : (!firrtl.uint<4>, !firrtl.uint<4>) -> !firrtl.uint<4>
+  %_n = firrtl.node droppable_name %1 : !firrtl.uint<4>
+  firrtl.strictconnect %_w, %a : !firrtl.uint<4>
+  firrtl.strictconnect %out0, %0 : !firrtl.uint<4>
+  firrtl.strictconnect %out1, %_n : !firrtl.uint<4>
+}
+
+// Folding an expression again after forwarding a wire creates a constant in
+// front of an identical constant visited before, which has to be replaced with
+// the new one rather than the other way around.
+// CHECK-LABEL: firrtl.module @FoldForward
+firrtl.module @FoldForward(in %a: !firrtl.uint<1>, out %out0: !firrtl.uint<1>,
+                           out %out1: !firrtl.uint<1>) {
+  // CHECK-NEXT: %[[C0:.+]] = firrtl.constant 0 : !firrtl.uint<1>
+  // CHECK-NEXT: firrtl.strictconnect %out0, %[[C0]] : !firrtl.uint<1>
+  // CHECK-NEXT: firrtl.strictconnect %out1, %[[C0]] : !firrtl.uint<1>
+  // CHECK-NEXT: }
+  %c1_ui1 = firrtl.constant 1 : !firrtl.uint<1>
+  %_w = firrtl.wire droppable_name : !firrtl.uint<1>
+  %0 = firrtl.not %_w : (!firrtl.uint<1>) -> !firrtl.uint<1>
+  %1 = firrtl.and %0, %a : (!firrtl.uint<1>, !firrtl.uint<1>) -> !firrtl.uint<1>
+  %c0_ui1 = firrtl.constant 0 : !firrtl.uint<1>
+  firrtl.strictconnect %_w, %c1_ui1 : !firrtl.uint<1>
+  firrtl.strictconnect %out0, %1 : !firrtl.uint<1>
+  firrtl.strictconnect %out1, %c0_ui1 : !firrtl.uint<1>
+}
+
+// Wires and nodes with an interesting name or annotations are kept.
+// CHECK-LABEL: firrtl.module @Keep
+firrtl.module @Keep(in %a: !firrtl.uint<4>, out %out0: !firrtl.uint<4>,
+                    out %out1: !firrtl.uint<4>, out %out2: !firrtl.uint<4>) {
+  // CHECK-NEXT: %w = firrtl.wire interesting_name
+  // CHECK-NEXT: %_x = firrtl.wire {annotations
+  // CHECK-NEXT: %n = firrtl.node interesting_name %a
+  // CHECK-NEXT: firrtl.strictconnect %w, %a
+  // CHECK-NEXT: firrtl.strictconnect %_x, %a
+  // CHECK-NEXT: firrtl.strictconnect %out0, %w
+  // CHECK-NEXT: firrtl.strictconnect %out1, %_x
+  // CHECK-NEXT: firrtl.strictconnect %out2, %n
+  // CHECK-NEXT: }
+  %w = firrtl.wire interesting_name : !firrtl.uint<4>
+  %_x = firrtl.wire {annotations = [{class = "firrtl.transforms.DontTouchAnnotation"}]} : !firrtl.uint<4>
+  %n = firrtl.node interesting_name %a : !firrtl.uint<4>
+  firrtl.strictconnect %w, %a : !firrtl.uint<4>
+  firrtl.strictconnect %_x, %a : !firrtl.uint<4>
+  firrtl.strictconnect %out0, %w : !firrtl.uint<4>
+  firrtl.strictconnect %out1, %_x : !firrtl.uint<4>
+  firrtl.strictconnect %out2, %n : !firrtl.uint<4>
+}
+
+}
@@ -26,5 +26,49 @@ firrtl.module @ElementWise(in %a: !firrtl.vector<uint<1>, 2>, in %b: !firrtl.vec
   %12 = firrtl.vectorcreate %10, %11 : (!firrtl.uint<1>, !firrtl.uint<1>) -> !firrtl.vector<uint<1>, 2>
   firrtl.strictconnect %c_2, %12 : !firrtl.vector<uint<1>, 2>
 }
+
+// CHECK-LABEL: @Tree
+firrtl.module @Tree(in %s: !firrtl.uint<1>, in %a: !firrtl.vector<uint<2>, 2>, in %b: !firrtl.vector<uint<2>, 2>, in %c: !firrtl.vector<uint<2>, 2>, out %d: !firrtl.vector<uint<2>, 2>) {
+  // CHECK-NEXT: [[AND:%.+]] = firrtl.elementwise_and %a, %b
+  // CHECK-NEXT: [[OR:%.+]] = firrtl.elementwise_or [[AND]], %c
+  // CHECK-NEXT: [[MUX:%.+]] = firrtl.mux(%s, [[OR]], %c) : (!firrtl.uint<1>, !firrtl.vector<uint<2>, 2>, !firrtl.vector<uint<2>, 2>) -> !firrtl.vector<uint<2>, 2>
+  // CHECK-NEXT: firrtl.strictconnect %d, [[MUX]] : !firrtl.vector<uint<2>, 2>
+  %a0 = firrtl.subindex %a[0] : !firrtl.vector<uint<2>, 2>
+  %a1 = firrtl.subindex %a[1] : !firrtl.vector<uint<2>, 2>
+  %b0 = firrtl.subindex %b[0] : !firrtl.vector<uint<2>, 2>
+  %b1 = firrtl.subindex %b[1] : !firrtl.vector<uint<2>, 2>
+  %c0 = firrtl.subindex %c[0] : !firrtl.vector<uint<2>, 2>
+  %c1 = firrtl.subindex %c[1] : !firrtl.vector<uint<2>, 2>
+  %0 = firrtl.and %a0, %b0 : (!firrtl.uint<2>, !firrtl.uint<2>) -> !firrtl.uint<2>
+  %1 = firrtl.and %a1, %b1 : (!firrtl.uint<2>, !firrtl.uint<2>) -> !firrtl.uint<2>
+  %2 = firrtl.or %0, %c0 : (!firrtl.uint<2>, !firrtl.uint<2>) -> !firrtl.uint<2>
+  %3 = firrtl.or %1, %c1 : (!firrtl.uint<2>, !firrtl.uint<2>) -> !firrtl.uint<2>
+  %4 = firrtl.mux(%s, %2, %c0) : (!firrtl.uint<1>, !firrtl.uint<2>, !firrtl.uint<2>) -> !firrtl.uint<2>
+  %5 = firrtl.mux(%s, %3, %c1) : (!firrtl.uint<1>, !firrtl.uint<2>, !firrtl.uint<2>) -> !firrtl.uint<2>
+  %6 = firrtl.vectorcreate %4, %5 : (!firrtl.uint<2>, !firrtl.uint<2>) -> !firrtl.vector<uint<2>, 2>
+  firrtl.strictconnect %d, %6 : !firrtl.vector<uint<2>, 2>
 }
 
+// Muxes with different selects and operations over extended operands are not
+// vectorized.
+// CHECK-LABEL: @NoVectorization
+firrtl.module @NoVectorization(in %s: !firrtl.vector<uint<1>, 2>, in %a: !firrtl.vector<uint<1>, 2>, in %b: !firrtl.vector<uint<2>, 2>, out %c_0: !firrtl.vector<uint<1>, 2>, out %c_1: !firrtl.vector<uint<2>, 2>) {
+  // CHECK-NOT: firrtl.elementwise
+  // CHECK: firrtl.vectorcreate
+  // CHECK: firrtl.vectorcreate
+  %s0 = firrtl.subindex %s[0] : !firrtl.vector<uint<1>, 2>
+  %s1 = firrtl.subindex %s[1] : !firrtl.vector<uint<1>, 2>
+  %a0 = firrtl.subindex %a[0] : !firrtl.vector<uint<1>, 2>
+  %a1 = firrtl.subindex %a[1] : !firrtl.vector<uint<1>, 2>
+  %b0 = firrtl.subindex %b[0] : !firrtl.vector<uint<2>, 2>
+  %b1 = firrtl.subindex %b[1] : !firrtl.vector<uint<2>, 2>
+  %0 = firrtl.mux(%s0, %a0, %a1) : (!firrtl.uint<1>, !firrtl.uint<1>, !firrtl.uint<1>) -> !firrtl.uint<1>
+  %1 = firrtl.mux(%s1, %a1, %a0) : (!firrtl.uint<1>, !firrtl.uint<1>, !firrtl.uint<1>) -> !firrtl.uint<1>
+  %2 = firrtl.vectorcreate %0, %1 : (!firrtl.uint<1>, !firrtl.uint<1>) -> !firrtl.vector<uint<1>, 2>
+  firrtl.strictconnect %c_0, %2 : !firrtl.vector<uint<1>, 2>
+  %3 = firrtl.or %a0, %b0 : (!firrtl.uint<1>, !firrtl.uint<2>) -> !firrtl.uint<2>
+  %4 = firrtl.or %a1, %b1 : (!firrtl.uint<1>, !firrtl.uint<2>) -> !firrtl.uint<2>
+  %5 = firrtl.vectorcreate %3, %4 : (!firrtl.uint<2>, !firrtl.uint<2>) -> !firrtl.vector<uint<2>, 2>
+  firrtl.strictconnect %c_1, %5 : !firrtl.vector<uint<2>, 2>
+}
+}
@@ -1,4 +1,5 @@
 // RUN: circt-opt --hw-flatten-io="recursive=true" %s | FileCheck %s
+// RUN: circt-opt --hw-flatten-io %s | FileCheck %s --check-prefix=SHALLOW
 
 // Ensure that non-struct-using modules pass cleanly through the pass.
 
@@ -9,24 +10,22 @@ hw.module @level0(%arg0 : i32) -> (out0 : i32) {
     hw.output %arg0: i32
 }
 
+// Structs passed from an input to an output are forwarded field by field,
+// without rebuilding and exploding them.
+
 // CHECK-LABEL: hw.module @level1(%arg0: i32, %in.a: i1, %in.b: i2, %arg1: i32) -> (out0: i32, out.a: i1, out.b: i2, out1: i32) {
-// CHECK-NEXT:    %0 = hw.struct_create (%in.a, %in.b) : !hw.struct<a: i1, b: i2>
-// CHECK-NEXT:    %a, %b = hw.struct_explode %0 : !hw.struct<a: i1, b: i2>
-// CHECK-NEXT:    hw.output %arg0, %a, %b, %arg1 : i32, i1, i2, i32
+// CHECK-NEXT:    hw.output %arg0, %in.a, %in.b, %arg1 : i32, i1, i2, i32
 // CHECK-NEXT:  }
 !Struct1 = !hw.struct<a: i1, b: i2>
 hw.module @level1(%arg0 : i32, %in : !Struct1, %arg1: i32) -> (out0 : i32,out: !Struct1, out1: i32) {
     hw.output %arg0, %in, %arg1 : i32, !Struct1, i32
 }
 
+// SHALLOW-LABEL: hw.module @level2(%in.aa: !hw.struct<a: i1, b: i2>, %in.bb: !hw.struct<a: i1, b: i2>) -> (out.aa: !hw.struct<a: i1, b: i2>, out.bb: !hw.struct<a: i1, b: i2>) {
+// SHALLOW-NEXT:    hw.output %in.aa, %in.bb
+
 // CHECK-LABEL: hw.module @level2(%in.aa.a: i1, %in.aa.b: i2, %in.bb.a: i1, %in.bb.b: i2) -> (out.aa.a: i1, out.aa.b: i2, out.bb.a: i1, out.bb.b: i2) {
-// CHECK-NEXT:    %0 = hw.struct_create (%in.aa.a, %in.aa.b) : !hw.struct<a: i1, b: i2>
-// CHECK-NEXT:    %1 = hw.struct_create (%in.bb.a, %in.bb.b) : !hw.struct<a: i1, b: i2>
-// CHECK-NEXT:    %2 = hw.struct_create (%0, %1) : !hw.struct<aa: !hw.struct<a: i1, b: i2>, bb: !hw.struct<a: i1, b: i2>>
-// CHECK-NEXT:    %aa, %bb = hw.struct_explode %2 : !hw.struct<aa: !hw.struct<a: i1, b: i2>, bb: !hw.struct<a: i1, b: i2>>
-// CHECK-NEXT:    %a, %b = hw.struct_explode %aa : !hw.struct<a: i1, b: i2>
-// CHECK-NEXT:    %a_0, %b_1 = hw.struct_explode %bb : !hw.struct<a: i1, b: i2>
-// CHECK-NEXT:    hw.output %a, %b, %a_0, %b_1 : i1, i2, i1, i2
+// CHECK-NEXT:    hw.output %in.aa.a, %in.aa.b, %in.bb.a, %in.bb.b : i1, i2, i1, i2
 // CHECK-NEXT:  }
 !Struct2 = !hw.struct<aa: !Struct1, bb: !Struct1>
 hw.module @level2(%in : !Struct2) -> (out: !Struct2) {
@@ -43,10 +42,38 @@ hw.type_scope @foo {
 !ScopedStruct = !hw.typealias<@foo::@bar,!Struct1>
 
 // CHECK-LABEL: hw.module @scoped(%arg0: i32, %in.a: i1, %in.b: i2, %arg1: i32) -> (out0: i32, out.a: i1, out.b: i2, out1: i32) {
-// CHECK-NEXT:    %0 = hw.struct_create (%in.a, %in.b) : !hw.struct<a: i1, b: i2>
-// CHECK-NEXT:    %a, %b = hw.struct_explode %0 : !hw.struct<a: i1, b: i2>
-// CHECK-NEXT:    hw.output %arg0, %a, %b, %arg1 : i32, i1, i2, i32
+// CHECK-NEXT:    hw.output %arg0, %in.a, %in.b, %arg1 : i32, i1, i2, i32
 // CHECK-NEXT:  }
   hw.module @scoped(%arg0 : i32, %in : !ScopedStruct, %arg1: i32) -> (out0 : i32,out: !ScopedStruct, out1: i32) {
   hw.output %arg0, %in, %arg1 : i32, !ScopedStruct, i32
 }
+
+// Instances adopt the flattened ports of the modules they instantiate. The
+// explodes of the struct ports and the structs rebuilt from the struct ports
+// of the instances are forwarded, too.
+
+// CHECK-LABEL: hw.module @instances(%arg0: i32, %in.aa.a: i1, %in.aa.b: i2, %in.bb.a: i1, %in.bb.b: i2) -> (out.a: i1, out.b: i2, out2.aa.a: i1, out2.aa.b: i2, out2.bb.a: i1, out2.bb.b: i2) {
+// CHECK-NEXT:    %l1.out0, %l1.out.a, %l1.out.b, %l1.out1 = hw.instance "l1" @level1(arg0: %arg0: i32, in.a: %in.aa.a: i1, in.b: %in.aa.b: i2, arg1: %arg0: i32) -> (out0: i32, out.a: i1, out.b: i2, out1: i32)
+// CHECK-NEXT:    %l2.out.aa.a, %l2.out.aa.b, %l2.out.bb.a, %l2.out.bb.b = hw.instance "l2" @level2(in.aa.a: %in.aa.a: i1, in.aa.b: %in.aa.b: i2, in.bb.a: %in.bb.a: i1, in.bb.b: %in.bb.b: i2) -> (out.aa.a: i1, out.aa.b: i2, out.bb.a: i1, out.bb.b: i2)
+// CHECK-NEXT:    hw.output %l1.out.a, %l1.out.b, %l2.out.aa.a, %l2.out.aa.b, %l2.out.bb.a, %l2.out.bb.b : i1, i2, i1, i2, i1, i2
+// CHECK-NEXT:  }
+hw.module @instances(%arg0 : i32, %in : !Struct2) -> (out: !Struct1, out2: !Struct2) {
+  %aa, %bb = hw.struct_explode %in : !Struct2
+  %l1.out0, %l1.out, %l1.out1 = hw.instance "l1" @level1(arg0: %arg0: i32, in: %aa: !Struct1, arg1: %arg0: i32) -> (out0: i32, out: !Struct1, out1: i32)
+  %l2.out = hw.instance "l2" @level2(in: %in: !Struct2) -> (out: !Struct2)
+  hw.output %l1.out, %l2.out : !Struct1, !Struct2
+}
+
+// Structs with other uses are still rebuilt for them.
+
+// CHECK-LABEL: hw.module @otherUses(%in.a: i1, %in.b: i2) -> (out: i1) {
+// CHECK-NEXT:    [[S:%.+]] = hw.struct_create (%in.a, %in.b) : !hw.struct<a: i1, b: i2>
+// CHECK-NEXT:    [[W:%.+]] = sv.wire
+// CHECK-NEXT:    sv.assign [[W]], [[S]]
+// CHECK-NEXT:    hw.output %in.a : i1
+hw.module @otherUses(%in : !Struct1) -> (out: i1) {
+  %w = sv.wire : !hw.inout<!Struct1>
+  sv.assign %w, %in : !Struct1
+  %a = hw.struct_extract %in["a"] : !Struct1
+  hw.output %a : i1
+}
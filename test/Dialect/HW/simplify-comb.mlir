@@ -0,0 +1,69 @@
+// RUN: circt-opt --pass-pipeline='builtin.module(hw.module(hw-simplify-comb))' %s | FileCheck %s
+
+// CHECK-LABEL: hw.module @Fold
+hw.module @Fold(%a: i4) -> (out0: i4, out1: i4) {
+  // CHECK-NEXT: %c3_i4 = hw.constant 3 : i4
+  // CHECK-NEXT: hw.output %a, %c3_i4 : i4, i4
+  %c1_i4 = hw.constant 1 : i4
+  %c2_i4 = hw.constant 2 : i4
+  %c3_i4 = hw.constant 3 : i4
+  %0 = comb.and %a, %a : i4
+  %1 = comb.add %c1_i4, %c2_i4 : i4
+  %2 = comb.or %1, %c3_i4 : i4
+  hw.output %0, %2 : i4, i4
+}
+
+// CHECK-LABEL: hw.module @Deduplicate
+hw.module @Deduplicate(%a: i4, %b: i4) -> (out0: i4, out1: i4) {
+  // CHECK-NEXT: %0 = comb.xor %a, %b : i4
+  // CHECK-NEXT: %1 = comb.mul %0, %0 : i4
+  // CHECK-NEXT: hw.output %1, %1 : i4, i4
+  %0 = comb.xor %a, %b : i4
+  %1 = comb.xor %a, %b : i4
+  %2 = comb.mul %0, %1 : i4
+  %3 = comb.mul %0, %0 : i4
+  hw.output %2, %3 : i4, i4
+}
+
+// Expressions in nested regions are replaced with the ones outside, but not
+// the other way around.
+// CHECK-LABEL: hw.module @Nested
+hw.module @Nested(%a: i4, %b: i4, %clock: i1) -> (out: i4) {
+  // CHECK-NEXT: %r = sv.reg
+  // CHECK-NEXT: [[XOR:%.+]] = comb.xor %a, %b : i4
+  // CHECK-NEXT: sv.always posedge %clock {
+  // CHECK-NEXT:   [[INNER:%.+]] = comb.or %a, %b : i4
+  // CHECK-NEXT:   sv.passign %r, [[XOR]] : i4
+  // CHECK-NEXT:   sv.passign %r, [[INNER]] : i4
+  // CHECK-NEXT: }
+  // CHECK-NEXT: [[OUTER:%.+]] = comb.or %a, %b : i4
+  // CHECK-NEXT: hw.output [[OUTER]] : i4
+  %r = sv.reg : !hw.inout<i4>
+  %0 = comb.xor %a, %b : i4
+  sv.always posedge %clock {
+    %2 = comb.xor %a, %b : i4
+    %3 = comb.or %a, %b : i4
+    sv.passign %r, %2 : i4
+    sv.passign %r, %3 : i4
+  }
+  %1 = comb.or %a, %b : i4
+  hw.output %1 : i4
+}
+
+// Module bodies are graph regions. Operations which use a value defined after
+// them have already been hashed, so they keep using the replaced value.
+// CHECK-LABEL: hw.module @ForwardReference
+hw.module @ForwardReference(%a: i4, %b: i4) -> (out0: i4, out1: i4, out2: i4) {
+  // CHECK-NEXT: %c0_i4 = hw.constant 0 : i4
+  // CHECK-NEXT: %0 = comb.and %2, %3 : i4
+  // CHECK-NEXT: %1 = comb.xor %a, %b : i4
+  // CHECK-NEXT: %2 = comb.xor %a, %b : i4
+  // CHECK-NEXT: %3 = comb.and %a, %c0_i4 : i4
+  // CHECK-NEXT: hw.output %0, %1, %c0_i4 : i4, i4, i4
+  %c0_i4 = hw.constant 0 : i4
+  %0 = comb.and %2, %3 : i4
+  %1 = comb.xor %a, %b : i4
+  %2 = comb.xor %a, %b : i4
+  %3 = comb.and %a, %c0_i4 : i4
+  hw.output %0, %2, %3 : i4, i4, i4
+}
@@ -168,3 +168,43 @@ module {
     hw.output %0 : i32
   }
 }
+
+// -----
+
+// Test that instances with equal parameters share a specialization, also when
+// they are found several levels down in other specializations.
+
+module {
+  hw.module @constantGen<V: i32>() -> (out: i32) {
+    %0 = hw.param.value i32 = #hw.param.decl.ref<"V">
+    hw.output %0 : i32
+  }
+
+  hw.module @inner<W: i32>() -> (out: i32) {
+    %0 = hw.instance "gen" @constantGen<V: i32 = #hw.param.decl.ref<"W">> () -> (out: i32)
+    hw.output %0 : i32
+  }
+
+  hw.module @outer<X: i32>() -> (out: i32) {
+    %0 = hw.instance "inner" @inner<W: i32 = #hw.param.decl.ref<"X">> () -> (out: i32)
+    hw.output %0 : i32
+  }
+
+  // CHECK-LABEL: hw.module @constantGen_V_8() -> (out: i32) {
+  // CHECK-LABEL: hw.module @outer_X_8() -> (out: i32) {
+  // CHECK:         hw.instance "inner" @inner_W_8() -> (out: i32)
+  // CHECK-LABEL: hw.module @inner_W_8() -> (out: i32) {
+  // CHECK:         hw.instance "gen" @constantGen_V_8() -> (out: i32)
+  // CHECK-NOT:   hw.module @constantGen_V_8_
+
+  // CHECK-LABEL: hw.module @top() -> (out1: i32, out2: i32, out3: i32) {
+  // CHECK:         hw.instance "inst1" @constantGen_V_8() -> (out: i32)
+  // CHECK:         hw.instance "inst2" @outer_X_8() -> (out: i32)
+  // CHECK:         hw.instance "inst3" @constantGen_V_8() -> (out: i32)
+  hw.module @top() -> (out1: i32, out2: i32, out3: i32) {
+    %0 = hw.instance "inst1" @constantGen<V: i32 = 8> () -> (out: i32)
+    %1 = hw.instance "inst2" @outer<X: i32 = 8> () -> (out: i32)
+    %2 = hw.instance "inst3" @constantGen<V: i32 = 8> () -> (out: i32)
+    hw.output %0, %1, %2 : i32, i32, i32
+  }
+}
@@ -0,0 +1,61 @@
+// RUN: circt-opt %s --hwarith-narrow-widths | FileCheck %s
+
+// CHECK-LABEL: hw.module @add
+// CHECK-NEXT:    [[A:%.+]] = hwarith.cast %x : (ui4) -> ui8
+// CHECK-NEXT:    [[B:%.+]] = hwarith.cast %y : (ui4) -> ui8
+// CHECK-NEXT:    [[NA:%.+]] = hwarith.cast [[A]] : (ui8) -> ui4
+// CHECK-NEXT:    [[NB:%.+]] = hwarith.cast [[B]] : (ui8) -> ui4
+// CHECK-NEXT:    [[ADD:%.+]] = hwarith.add [[NA]], [[NB]] : (ui4, ui4) -> ui5
+// CHECK-NEXT:    [[OUT:%.+]] = hwarith.cast [[ADD]] : (ui5) -> ui9
+// CHECK-NEXT:    hw.output [[OUT]] : ui9
+hw.module @add(%x: ui4, %y: ui4) -> (out: ui9) {
+  %a = hwarith.cast %x : (ui4) -> ui8
+  %b = hwarith.cast %y : (ui4) -> ui8
+  %0 = hwarith.add %a, %b : (ui8, ui8) -> ui9
+  hw.output %0 : ui9
+}
+
+// Constants are recreated at their narrow type.
+// CHECK-LABEL: hw.module @mulConst
+// CHECK:         [[C:%.+]] = hwarith.constant 3 : ui2
+// CHECK:         [[MUL:%.+]] = hwarith.mul {{%.+}}, [[C]] : (ui4, ui2) -> ui6
+// CHECK:         hwarith.cast [[MUL]] : (ui6) -> ui16
+hw.module @mulConst(%x: ui4) -> (out: ui16) {
+  %a = hwarith.cast %x : (ui4) -> ui8
+  %c3 = hwarith.constant 3 : ui8
+  %0 = hwarith.mul %a, %c3 : (ui8, ui8) -> ui16
+  hw.output %0 : ui16
+}
+
+// Narrowing propagates through chains of operations.
+// CHECK-LABEL: hw.module @chain
+// CHECK:         hwarith.add {{%.+}}, {{%.+}} : (ui4, ui4) -> ui5
+// CHECK:         hwarith.sub {{%.+}}, {{%.+}} : (ui5, si3) -> si7
+// CHECK:         hwarith.cast {{%.+}} : (si7) -> si11
+hw.module @chain(%x: ui4, %y: ui4, %z: si3) -> (out: si11) {
+  %a = hwarith.cast %x : (ui4) -> ui8
+  %b = hwarith.cast %y : (ui4) -> ui8
+  %c = hwarith.cast %z : (si3) -> si8
+  %0 = hwarith.add %a, %b : (ui8, ui8) -> ui9
+  %1 = hwarith.sub %0, %c : (ui9, si8) -> si11
+  hw.output %1 : si11
+}
+
+// Operands that use their full range are left alone.
+// CHECK-LABEL: hw.module @full
+// CHECK-NEXT:    [[ADD:%.+]] = hwarith.add %a, %b : (ui8, ui8) -> ui9
+// CHECK-NEXT:    hw.output [[ADD]] : ui9
+hw.module @full(%a: ui8, %b: ui8) -> (out: ui9) {
+  %0 = hwarith.add %a, %b : (ui8, ui8) -> ui9
+  hw.output %0 : ui9
+}
+
+// Casts that truncate values wrap around and lose the interval.
+// CHECK-LABEL: hw.module @truncate
+// CHECK-NEXT:    hwarith.cast
+// CHECK-NEXT:    hwarith.add {{%.+}}, %b : (ui4, ui4) -> ui5
+hw.module @truncate(%a: ui8, %b: ui4) -> (out: ui5) {
+  %0 = hwarith.cast %a : (ui8) -> ui4
+  %1 = hwarith.add %0, %b : (ui4, ui4) -> ui5
+  hw.output %1 : ui5
+}
@@ -0,0 +1,14 @@
+// RUN: circt-opt -handshake-insert-buffers="strategy=throughput target-ii=1" %s -verify-diagnostics
+
+// The existing two-slot buffer already breaks the cycle, and takes two cycles
+// for each iteration.
+
+// expected-error @+1 {{'handshake.func' op cannot sustain an initiation interval of 1, the dataflow cycles require at least 2}}
+handshake.func @slow_loop(%arg0: none, ...) -> none {
+  %0 = merge %arg0, %3 : none
+  %1 = buffer [2] seq %0 : none
+  %2:2 = fork [2] %1 : none
+  %c = constant %2#0 {value = true} : i1
+  %3, %4 = cond_br %c, %2#1 : none
+  return %4 : none
+}
@@ -0,0 +1,52 @@
+// RUN: circt-opt -handshake-insert-buffers="strategy=throughput" %s | FileCheck %s
+// RUN: circt-opt -handshake-insert-buffers="strategy=throughput target-ii=2" %s | FileCheck %s --check-prefix=II2
+
+// The short path of the fork must hold the tokens issued while the long path
+// is still in flight.
+
+// CHECK-LABEL: handshake.func @reconvergent(
+// CHECK-SAME:                               %[[ARG0:.*]]: i32, %[[CTRL:.*]]: none, ...) -> (i32, none)
+// CHECK:         %[[FORK:.*]]:2 = fork [2] %[[ARG0]] : i32
+// CHECK:         %[[SHORT:.*]] = buffer [2] fifo %[[FORK]]#1 : i32
+// CHECK:         %[[LONG:.*]] = buffer [2] seq %[[FORK]]#0 : i32
+// CHECK:         %[[SUM:.*]] = arith.addi %[[LONG]], %[[SHORT]] : i32
+// CHECK:         return %[[SUM]], %[[CTRL]] : i32, none
+
+// II2-LABEL: handshake.func @reconvergent(
+// II2:         %[[FORK:.*]]:2 = fork [2] %{{.*}} : i32
+// II2:         %[[SHORT:.*]] = buffer [1] fifo %[[FORK]]#1 : i32
+// II2:         %[[LONG:.*]] = buffer [2] seq %[[FORK]]#0 : i32
+// II2:         arith.addi %[[LONG]], %[[SHORT]] : i32
+handshake.func @reconvergent(%arg0: i32, %ctrl: none, ...) -> (i32, none) {
+  %0:2 = fork [2] %arg0 : i32
+  %1 = buffer [2] seq %0#0 : i32
+  %2 = arith.addi %1, %0#1 : i32
+  return %2, %ctrl : i32, none
+}
+
+// The merge of a cycle gets a sequential buffer, and the channels whose
+// operands arrive together are left unbuffered.
+
+// CHECK-LABEL: handshake.func @loop(
+// CHECK:         %[[RESULT:.*]], %[[INDEX:.*]] = control_merge %{{.*}}, %[[TRUE:.*]] : none, index
+// CHECK:         %[[INDEX_BUF:.*]] = buffer [1] seq %[[INDEX]] : index
+// CHECK:         %[[RESULT_BUF:.*]] = buffer [1] seq %[[RESULT]] : none
+// CHECK:         sink %[[INDEX_BUF]] : index
+// CHECK:         %[[FORK:.*]]:2 = fork [2] %[[RESULT_BUF]] : none
+// CHECK:         %[[COND:.*]] = constant %[[FORK]]#0 {value = true} : i1
+// CHECK:         %[[TRUE]], %[[FALSE:.*]] = cond_br %[[COND]], %[[FORK]]#1 : none
+// CHECK-NOT:     buffer
+// CHECK:         return %[[FALSE]] : none
+
+// II2-LABEL: handshake.func @loop(
+// II2-COUNT-2:   buffer [1] seq
+// II2-NOT:       buffer
+// II2:           return
+handshake.func @loop(%arg0: none, ...) -> none {
+  %0:2 = control_merge %arg0, %3 : none, index
+  sink %0#1 : index
+  %1:2 = fork [2] %0#0 : none
+  %2 = constant %1#0 {value = true} : i1
+  %3, %4 = cond_br %2, %1#1 : none
+  return %4 : none
+}
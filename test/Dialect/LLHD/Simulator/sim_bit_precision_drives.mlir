@@ -1,5 +1,8 @@
 // REQUIRES: llhd-sim
 // RUN: llhd-sim %s -shared-libs=%shlibdir/libcirct-llhd-signals-runtime-wrappers%shlibext | FileCheck %s
+// RUN: llhd-sim %s -shared-libs=%shlibdir/libcirct-llhd-signals-runtime-wrappers%shlibext 2>&1 >/dev/null | FileCheck %s --check-prefix=SUMMARY
+
+// SUMMARY: Finished at {{.*}} cycles, {{[0-9]+}} heap allocations)
 
 // CHECK: 0ps 0d 0e  root/sameByte  0xffffffff
 // CHECK-NEXT: 0ps 0d 0e  root/spanBytes  0xffffffff
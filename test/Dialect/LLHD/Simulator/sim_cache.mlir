@@ -0,0 +1,29 @@
+// REQUIRES: llhd-sim
+// RUN: rm -rf %t.cache
+// RUN: llhd-sim %s -T 5000 --cache-dir=%t.cache -shared-libs=%shlibdir/libcirct-llhd-signals-runtime-wrappers%shlibext > %t.first
+// RUN: ls %t.cache | FileCheck %s
+// RUN: llhd-sim %s -T 5000 --cache-dir=%t.cache -shared-libs=%shlibdir/libcirct-llhd-signals-runtime-wrappers%shlibext > %t.second
+// RUN: diff %t.first %t.second
+
+// CHECK: {{^[0-9a-f]+}}.bc
+llhd.entity @root () -> () {
+  %0 = hw.constant 1 : i8
+  %s = llhd.sig "s" %0 : i8
+  llhd.inst "foo" @foo () -> (%s) : () -> (!llhd.sig<i8>)
+}
+
+llhd.proc @foo () -> (%s : !llhd.sig<i8>) {
+  cf.br ^entry
+^entry:
+  %1 = llhd.prb %s : !llhd.sig<i8>
+  %2 = comb.add %1, %1 : i8
+  %t0 = llhd.constant_time #llhd.time<1ns, 0d, 1e>
+  llhd.drv %s, %2 after %t0 : !llhd.sig<i8>
+  %t1 = llhd.constant_time #llhd.time<1ns, 0d, 0e>
+  llhd.wait for %t1, ^entry
+}
+
+// This process is not instantiated and is never compiled.
+llhd.proc @unused () -> (%s : !llhd.sig<i8>) {
+  llhd.halt
+}
@@ -0,0 +1,35 @@
+// REQUIRES: llhd-sim
+// RUN: llhd-sim %s -T 2000 --trace-format=none --save-state=%t.ckpt -shared-libs=%shlibdir/libcirct-llhd-signals-runtime-wrappers%shlibext
+// RUN: llhd-sim %s -T 5000 --restore-state=%t.ckpt -shared-libs=%shlibdir/libcirct-llhd-signals-runtime-wrappers%shlibext | FileCheck %s
+
+// CHECK: 2000ps 0d 2e  root/1  0x01
+// CHECK-NEXT: 2000ps 0d 2e  root/foo/s  0x1b
+// CHECK-NEXT: 2000ps 0d 2e  root/s  0x1b
+// CHECK-NEXT: 3000ps 0d 1e  root/foo/s  0x36
+// CHECK-NEXT: 3000ps 0d 1e  root/s  0x36
+// CHECK-NEXT: 3000ps 0d 2e  root/foo/s  0x51
+// CHECK-NEXT: 3000ps 0d 2e  root/s  0x51
+// CHECK-NEXT: 4000ps 0d 1e  root/foo/s  0xa2
+// CHECK-NEXT: 4000ps 0d 1e  root/s  0xa2
+// CHECK-NEXT: 4000ps 0d 2e  root/foo/s  0xf3
+// CHECK-NEXT: 4000ps 0d 2e  root/s  0xf3
+llhd.entity @root () -> () {
+  %0 = hw.constant 1 : i8
+  %s = llhd.sig "s" %0 : i8
+  %1 = llhd.sig "1" %0 : i8
+  llhd.inst "foo" @foo () -> (%s) : () -> (!llhd.sig<i8>)
+}
+
+llhd.proc @foo () -> (%s : !llhd.sig<i8>) {
+  cf.br ^entry
+^entry:
+  %1 = llhd.prb %s : !llhd.sig<i8>
+  %2 = comb.add %1, %1 : i8
+  %t0 = llhd.constant_time #llhd.time<0ns, 0d, 1e>
+  llhd.drv %s, %2 after %t0 : !llhd.sig<i8>
+  %3 = comb.add %2, %1 : i8
+  %t1 = llhd.constant_time #llhd.time<0ns, 0d, 2e>
+  llhd.drv %s, %3 after %t1 : !llhd.sig<i8>
+  %t2= llhd.constant_time #llhd.time<1ns, 0d, 0e>
+  llhd.wait for %t2, ^entry
+}
@@ -1,9 +1,17 @@
 // REQUIRES: llhd-sim
 // RUN: llhd-sim %s -T 5000 --trace-format=full -shared-libs=%shlibdir/libcirct-llhd-signals-runtime-wrappers%shlibext | FileCheck %s --check-prefix=FULL
+// RUN: llhd-sim %s -T 5000 --trace-format=full --threads=2 -shared-libs=%shlibdir/libcirct-llhd-signals-runtime-wrappers%shlibext | FileCheck %s --check-prefix=FULL
 // RUN: llhd-sim %s -T 5000 --trace-format=reduced -shared-libs=%shlibdir/libcirct-llhd-signals-runtime-wrappers%shlibext | FileCheck %s --check-prefix=REDUCED
 // RUN: llhd-sim %s -T 5000 --trace-format=merged -shared-libs=%shlibdir/libcirct-llhd-signals-runtime-wrappers%shlibext | FileCheck %s --check-prefix=MERGED
 // RUN: llhd-sim %s -T 5000 --trace-format=merged-reduce -shared-libs=%shlibdir/libcirct-llhd-signals-runtime-wrappers%shlibext | FileCheck %s --check-prefix=MERGEDRED
 // RUN: llhd-sim %s -T 5000 --trace-format=named-only -shared-libs=%shlibdir/libcirct-llhd-signals-runtime-wrappers%shlibext | FileCheck %s --check-prefix=NAMED
+// RUN: llhd-sim %s -T 5000 --trace-format=full --trace-encoding=binary -shared-libs=%shlibdir/libcirct-llhd-signals-runtime-wrappers%shlibext -o %t.bin
+// RUN: head -c 7 %t.bin | FileCheck %s --check-prefix=BINARY
+// RUN: llhd-sim --decode-trace %t.bin | FileCheck %s --check-prefix=FULL
+// RUN: llhd-sim %s -T 5000 --trace-format=full -shared-libs=%shlibdir/libcirct-llhd-signals-runtime-wrappers%shlibext -o %t.txt
+// RUN: llhd-sim --decode-trace %t.bin | diff - %t.txt
+
+// BINARY: LLHDTRC
 
 // FULL: 0ps 0d 0e  root/1  0x01
 // FULL: 0ps 0d 0e  root/foo/s  0x01
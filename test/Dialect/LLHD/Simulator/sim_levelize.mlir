@@ -0,0 +1,54 @@
+// REQUIRES: llhd-sim
+// RUN: llhd-sim %s -T 3000 --trace-format=merged -shared-libs=%shlibdir/libcirct-llhd-signals-runtime-wrappers%shlibext > %t.events
+// RUN: llhd-sim %s -T 3000 --trace-format=merged --levelize -shared-libs=%shlibdir/libcirct-llhd-signals-runtime-wrappers%shlibext > %t.levels
+// RUN: diff %t.events %t.levels
+// RUN: FileCheck %s --input-file=%t.levels
+
+// CHECK: 1000ps
+// CHECK-DAG: root/a{{ +}}0x01
+// CHECK-DAG: root/b{{ +}}0x02
+// CHECK-DAG: root/c{{ +}}0x03
+// CHECK: 2000ps
+// CHECK-DAG: root/a{{ +}}0x02
+// CHECK-DAG: root/b{{ +}}0x03
+// CHECK-DAG: root/c{{ +}}0x05
+llhd.entity @root () -> () {
+  %0 = hw.constant 0 : i8
+  %a = llhd.sig "a" %0 : i8
+  %b = llhd.sig "b" %0 : i8
+  %c = llhd.sig "c" %0 : i8
+  llhd.inst "counter" @counter () -> (%a) : () -> (!llhd.sig<i8>)
+  llhd.inst "sum" @sum (%a, %b) -> (%c) : (!llhd.sig<i8>, !llhd.sig<i8>) -> (!llhd.sig<i8>)
+  llhd.inst "inc" @inc (%a) -> (%b) : (!llhd.sig<i8>) -> (!llhd.sig<i8>)
+}
+
+// Depends on @inc, which is instantiated after it.
+llhd.entity @sum (%a : !llhd.sig<i8>, %b : !llhd.sig<i8>) -> (%c : !llhd.sig<i8>) {
+  %0 = llhd.prb %a : !llhd.sig<i8>
+  %1 = llhd.prb %b : !llhd.sig<i8>
+  %2 = comb.add %0, %1 : i8
+  %t = llhd.constant_time #llhd.time<0ns, 0d, 1e>
+  llhd.drv %c, %2 after %t : !llhd.sig<i8>
+}
+
+llhd.entity @inc (%a : !llhd.sig<i8>) -> (%b : !llhd.sig<i8>) {
+  %0 = llhd.prb %a : !llhd.sig<i8>
+  %1 = hw.constant 1 : i8
+  %2 = comb.add %0, %1 : i8
+  %t = llhd.constant_time #llhd.time<0ns, 0d, 1e>
+  llhd.drv %b, %2 after %t : !llhd.sig<i8>
+}
+
+llhd.proc @counter () -> (%a : !llhd.sig<i8>) {
+  cf.br ^entry
+^entry:
+  %t = llhd.constant_time #llhd.time<1ns, 0d, 0e>
+  llhd.wait for %t, ^tick
+^tick:
+  %0 = llhd.prb %a : !llhd.sig<i8>
+  %1 = hw.constant 1 : i8
+  %2 = comb.add %0, %1 : i8
+  %d = llhd.constant_time #llhd.time<0ns, 0d, 1e>
+  llhd.drv %a, %2 after %d : !llhd.sig<i8>
+  cf.br ^entry
+}
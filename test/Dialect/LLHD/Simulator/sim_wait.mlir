@@ -1,5 +1,7 @@
 // REQUIRES: llhd-sim
 // RUN: llhd-sim %s -shared-libs=%shlibdir/libcirct-llhd-signals-runtime-wrappers%shlibext | FileCheck %s
+// RUN: llhd-sim %s --threads=4 -shared-libs=%shlibdir/libcirct-llhd-signals-runtime-wrappers%shlibext | FileCheck %s
+// RUN: llhd-sim %s --scheduler=linear -shared-libs=%shlibdir/libcirct-llhd-signals-runtime-wrappers%shlibext | FileCheck %s
 
 // CHECK: 0ps 0d 0e  root/proc/s1  0x00000000
 // CHECK-NEXT: 0ps 0d 0e  root/proc/s2  0x00000000
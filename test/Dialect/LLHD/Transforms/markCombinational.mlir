@@ -0,0 +1,39 @@
+// RUN: circt-opt %s -llhd-mark-combinational | FileCheck %s
+
+// CHECK-LABEL: llhd.entity @comb
+// CHECK-SAME: attributes {llhd.combinational}
+llhd.entity @comb (%a : !llhd.sig<i8>, %b : !llhd.sig<i8>) -> (%c : !llhd.sig<i8>) {
+  %0 = llhd.prb %a : !llhd.sig<i8>
+  %1 = llhd.prb %b : !llhd.sig<i8>
+  %2 = comb.add %0, %1 : i8
+  %t = llhd.constant_time #llhd.time<0ns, 0d, 1e>
+  llhd.drv %c, %2 after %t : !llhd.sig<i8>
+}
+
+// CHECK-LABEL: llhd.entity @delayed
+// CHECK-NOT: llhd.combinational
+// CHECK: llhd.drv
+llhd.entity @delayed (%a : !llhd.sig<i8>) -> (%c : !llhd.sig<i8>) {
+  %0 = llhd.prb %a : !llhd.sig<i8>
+  %t = llhd.constant_time #llhd.time<0ns, 1d, 0e>
+  llhd.drv %c, %0 after %t : !llhd.sig<i8>
+}
+
+// CHECK-LABEL: llhd.entity @register
+// CHECK-NOT: llhd.combinational
+// CHECK: llhd.reg
+llhd.entity @register (%clk : !llhd.sig<i1>, %d : !llhd.sig<i8>) -> (%q : !llhd.sig<i8>) {
+  %0 = llhd.prb %clk : !llhd.sig<i1>
+  %1 = llhd.prb %d : !llhd.sig<i8>
+  %t = llhd.constant_time #llhd.time<0ns, 0d, 1e>
+  llhd.reg %q, (%1, "rise" %0 after %t : i8) : !llhd.sig<i8>
+}
+
+// CHECK-LABEL: llhd.entity @stale
+// CHECK-NOT: llhd.combinational
+// CHECK: llhd.drv
+llhd.entity @stale (%a : !llhd.sig<i8>) -> (%c : !llhd.sig<i8>) attributes {llhd.combinational} {
+  %0 = llhd.prb %a : !llhd.sig<i8>
+  %t = llhd.constant_time #llhd.time<1ns, 0d, 0e>
+  llhd.drv %c, %0 after %t : !llhd.sig<i8>
+}
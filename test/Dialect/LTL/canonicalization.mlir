@@ -103,3 +103,45 @@ func.func @ClockingFolds(%arg0: !ltl.property) {
   call @Prop(%0) : (!ltl.property) -> ()
   return
 }
+
+// CHECK-LABEL: @AndOrFolds
+func.func @AndOrFolds(%arg0: !ltl.sequence, %arg1: !ltl.sequence, %arg2: !ltl.sequence, %arg3: i1) {
+  // and(s) -> s
+  // or(s) -> s
+  // CHECK-NEXT: call @Seq(%arg0)
+  // CHECK-NEXT: call @Seq(%arg0)
+  %0 = ltl.and %arg0 : !ltl.sequence
+  %1 = ltl.or %arg0 : !ltl.sequence
+  call @Seq(%0) : (!ltl.sequence) -> ()
+  call @Seq(%1) : (!ltl.sequence) -> ()
+
+  // and(b) is a sequence and does not fold to the boolean b
+  // CHECK-NEXT: [[TMP:%.+]] = ltl.and %arg3 : i1
+  // CHECK-NEXT: call @Seq([[TMP]])
+  %2 = ltl.and %arg3 : i1
+  call @Seq(%2) : (!ltl.sequence) -> ()
+
+  // and(s0, and(s1, s2), s0) -> and(s0, s1, s2)
+  // or(s0, or(s1, s2), s0) -> or(s0, s1, s2)
+  // CHECK-NEXT: ltl.and %arg0, %arg1, %arg2 :
+  // CHECK-NEXT: ltl.or %arg0, %arg1, %arg2 :
+  // CHECK-NEXT: call
+  // CHECK-NEXT: call
+  %3 = ltl.and %arg1, %arg2 : !ltl.sequence, !ltl.sequence
+  %4 = ltl.and %arg0, %3, %arg0 : !ltl.sequence, !ltl.sequence, !ltl.sequence
+  %5 = ltl.or %arg1, %arg2 : !ltl.sequence, !ltl.sequence
+  %6 = ltl.or %arg0, %5, %arg0 : !ltl.sequence, !ltl.sequence, !ltl.sequence
+  call @Seq(%4) : (!ltl.sequence) -> ()
+  call @Seq(%6) : (!ltl.sequence) -> ()
+
+  // Nested ops with multiple uses are kept to share them.
+  // CHECK-NEXT: [[TMP:%.+]] = ltl.and %arg1, %arg2 :
+  // CHECK-NEXT: ltl.and %arg0, [[TMP]] :
+  // CHECK-NEXT: call @Seq([[TMP]])
+  // CHECK-NEXT: call
+  %7 = ltl.and %arg1, %arg2 : !ltl.sequence, !ltl.sequence
+  %8 = ltl.and %arg0, %7 : !ltl.sequence, !ltl.sequence
+  call @Seq(%7) : (!ltl.sequence) -> ()
+  call @Seq(%8) : (!ltl.sequence) -> ()
+  return
+}
@@ -0,0 +1,38 @@
+// RUN: circt-opt %s --msft-auto-partition | FileCheck %s
+
+// CHECK-LABEL: msft.module @top
+// CHECK:         [[A0:%.+]] = seq.compreg %in, %clk {targetDesignPartition = @top::@part1} : i8
+// CHECK:         [[A1:%.+]] = seq.compreg [[A0]], %clk {targetDesignPartition = @top::@part1} : i8
+// CHECK:         [[A2:%.+]] = seq.compreg [[A1]], %clk {targetDesignPartition = @top::@part2} : i8
+// CHECK:         [[A3:%.+]] = seq.compreg [[A2]], %clk {targetDesignPartition = @top::@part2} : i8
+// CHECK:         msft.output [[A3]] : i8
+msft.module @top {} (%clk : i1, %in : i8) -> (out: i8) {
+  msft.partition @part1, "dp1"
+  msft.partition @part2, "dp2"
+  %a0 = seq.compreg %in, %clk {targetDesignPartition = @top::@part1} : i8
+  %a1 = seq.compreg %a0, %clk : i8
+  %a2 = seq.compreg %a1, %clk : i8
+  %a3 = seq.compreg %a2, %clk : i8
+  msft.output %a3 : i8
+}
+
+// The wide connections are kept within a partition, only the narrow one is
+// cut.
+// CHECK-LABEL: msft.module @clusters
+// CHECK:         msft.instance @x0 @Wide(%in)  {targetDesignPartition = @clusters::@p0}
+// CHECK:         msft.instance @x1 @Wide({{.+}})  {targetDesignPartition = @clusters::@p0}
+// CHECK:         comb.extract {{.+}} {targetDesignPartition = @clusters::@p0}
+// CHECK:         msft.instance @y0 @Narrow({{.+}})  {targetDesignPartition = @clusters::@p1}
+// CHECK:         msft.instance @y1 @Wide({{.+}})  {targetDesignPartition = @clusters::@p1}
+msft.module.extern @Wide (%x: i32) -> (y: i32)
+msft.module.extern @Narrow (%x: i1) -> (y: i32)
+msft.module @clusters {} (%in : i32) -> (out: i32) {
+  msft.partition @p0, "dp0"
+  msft.partition @p1, "dp1"
+  %x0 = msft.instance @x0 @Wide(%in) {targetDesignPartition = @clusters::@p0} : (i32) -> (i32)
+  %x1 = msft.instance @x1 @Wide(%x0) : (i32) -> (i32)
+  %bit = comb.extract %x1 from 0 : (i32) -> i1
+  %y0 = msft.instance @y0 @Narrow(%bit) : (i1) -> (i32)
+  %y1 = msft.instance @y1 @Wide(%y0) : (i32) -> (i32)
+  msft.output %y1 : i32
+}
@@ -0,0 +1,59 @@
+// RUN: circt-opt %s --msft-auto-place --split-input-file --verify-diagnostics | FileCheck %s
+
+hw.module.extern @Mem(%in: i8) -> (out: i8)
+
+msft.module @top {} (%in: i8) -> (out: i8) {
+  %a.out = msft.instance @a @Mem(%in) : (i8) -> i8
+  %b.out = msft.instance @b @Mem(%a.out) : (i8) -> i8
+  %c.out = msft.instance @c @Mem(%b.out) : (i8) -> i8
+  msft.output %c.out : i8
+}
+
+msft.physical_region @region, [#msft.physical_bounds<x: [1, 3], y: [0, 0]>]
+
+// The initial placement puts @c next to the fixed @a. Annealing should swap
+// them to shorten the chain.
+// CHECK-LABEL: msft.instance.hierarchy @top {
+// CHECK:         msft.instance.dynamic @top::@c {
+// CHECK-NEXT:      msft.pd.location M20K x: 2 y: 0 n: 0
+// CHECK-NEXT:    }
+// CHECK:         msft.instance.dynamic @top::@b {
+// CHECK-NEXT:      msft.pd.location M20K x: 1 y: 0 n: 0
+// CHECK-NEXT:    }
+// CHECK:         msft.instance.dynamic @top::@a {
+// CHECK-NEXT:      msft.pd.location M20K x: 0 y: 0 n: 0
+// CHECK-NEXT:    }
+// CHECK-NOT:     msft.pd.physregion
+msft.instance.hierarchy @top {
+  msft.instance.dynamic @top::@c {
+    msft.pd.physregion @region place M20K
+  }
+  msft.instance.dynamic @top::@b {
+    msft.pd.physregion @region place M20K
+  }
+  msft.instance.dynamic @top::@a {
+    msft.pd.location M20K x: 0 y: 0 n: 0
+  }
+}
+
+// -----
+
+hw.module.extern @Mem(%in: i8) -> (out: i8)
+
+msft.module @top {} (%in: i8) -> (out: i8) {
+  %a.out = msft.instance @a @Mem(%in) : (i8) -> i8
+  %b.out = msft.instance @b @Mem(%a.out) : (i8) -> i8
+  msft.output %b.out : i8
+}
+
+msft.physical_region @region, [#msft.physical_bounds<x: [1, 1], y: [0, 0]>]
+
+msft.instance.hierarchy @top {
+  msft.instance.dynamic @top::@a {
+    msft.pd.physregion @region place M20K
+  }
+  msft.instance.dynamic @top::@b {
+    // expected-error @+1 {{'msft.pd.physregion' op no free location in region @region}}
+    msft.pd.physregion @region place M20K
+  }
+}
@@ -0,0 +1,37 @@
+// RUN: circt-opt %s --lower-msft-to-hw --msft-export-tcl="tops=top previous-manifest=%S/Inputs/tcl-manifest.json manifest-file=manifest.json" --export-verilog | FileCheck %s
+
+hw.globalRef @ref1 [#hw.innerNameRef<@top::@a>]
+msft.pd.location @ref1 M20K x: 1 y: 2 n: 0
+
+hw.globalRef @ref2 [#hw.innerNameRef<@top::@b>]
+msft.pd.location @ref2 M20K x: 3 y: 4 n: 0
+
+hw.module.extern @Foo()
+
+// Only the moved placement of `b` and the removal of the placement of `c` are
+// emitted.
+// CHECK-LABEL: proc top_config
+// CHECK-NOT:     M20K_X1_Y2_N0
+// CHECK:         set_location_assignment M20K_X3_Y4_N0 -to $parent|b
+// CHECK-NEXT:    set_location_assignment -to $parent|c -remove
+// CHECK-NEXT:  }
+msft.module @top {} () -> () {
+  msft.instance @a @Foo() { circt.globalRef = [#hw.globalNameRef<@ref1>], inner_sym = "a" } : () -> ()
+  msft.instance @b @Foo() { circt.globalRef = [#hw.globalNameRef<@ref2>], inner_sym = "b" } : () -> ()
+  msft.instance @c @Foo() { inner_sym = "c" } : () -> ()
+  msft.output
+}
+
+// The manifest has all of the current placements.
+// CHECK-LABEL: FILE "manifest.json"
+// CHECK:         "command": "set_location_assignment",
+// CHECK-NEXT:    "path": [
+// CHECK-NEXT:      "top::a"
+// CHECK:         "value": "M20K_X1_Y2_N0"
+// CHECK:         "command": "set_location_assignment",
+// CHECK-NEXT:    "path": [
+// CHECK-NEXT:      "top::b"
+// CHECK:         "value": "M20K_X3_Y4_N0"
+// CHECK-NOT:     "top::c"
+// CHECK:         "instance": "",
+// CHECK-NEXT:    "module": "top"
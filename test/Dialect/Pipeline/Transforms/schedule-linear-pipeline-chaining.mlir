@@ -0,0 +1,35 @@
+// RUN: circt-opt --pass-pipeline='builtin.module(hw.module(pipeline.pipeline(pipeline-schedule-linear{cycle-time=5.0})))' %s | FileCheck %s
+
+// A chain of four combinational adders, of which only two fit into a cycle.
+
+// CHECK-LABEL:   hw.module @chain(
+// CHECK:           ^bb0(%[[A0:.*]]: i32, %[[A1:.*]]: i32):
+// CHECK:             %[[TRUE:.*]] = hw.constant true
+// CHECK:             %[[ADD0:.*]] = comb.add %[[A0]], %[[A1]] {ssp.operator_type = @add} : i32
+// CHECK:             %[[ADD1:.*]] = comb.add %[[ADD0]], %[[A1]] {ssp.operator_type = @add} : i32
+// CHECK:             %[[STAGE0:.*]] = pipeline.stage when %[[TRUE]]
+// CHECK:             %[[ADD2:.*]] = comb.add %[[ADD1]], %[[A1]] {ssp.operator_type = @add} : i32
+// CHECK:             %[[ADD3:.*]] = comb.add %[[ADD2]], %[[A1]] {ssp.operator_type = @add} : i32
+// CHECK-NOT:         pipeline.stage
+// CHECK:             pipeline.return %[[ADD3]] valid %[[STAGE0]] : i32
+
+module {
+  ssp.library @lib {
+    operator_type @add [latency<0>, incDelay<2.0>, outDelay<2.0>]
+  }
+
+  hw.module @chain(%arg0 : i32, %arg1 : i32, %clk : i1, %rst : i1) -> (out: i32) {
+    %0 = pipeline.pipeline(%arg0, %arg1) clock %clk reset %rst
+      {operator_lib = @lib}
+    : (i32, i32) -> (i32) {
+    ^bb0(%a0 : i32, %a1: i32):
+      %0 = comb.add %a0, %a1 {ssp.operator_type = @add} : i32
+      %1 = comb.add %0, %a1 {ssp.operator_type = @add} : i32
+      %2 = comb.add %1, %a1 {ssp.operator_type = @add} : i32
+      %3 = comb.add %2, %a1 {ssp.operator_type = @add} : i32
+      %c1_i1 = hw.constant 1 : i1
+      pipeline.return %3 valid %c1_i1 : i32
+    }
+    hw.output %0 : i32
+  }
+}
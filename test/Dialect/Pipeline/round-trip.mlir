@@ -35,3 +35,15 @@ hw.module @retimeable3(%arg0 : !esi.channel<i32>, %arg1 : !esi.channel<i32>, %cl
   }
   hw.output %0 : !esi.channel<i32>
 }
+
+// CHECK-LABEL: hw.module @stallable
+// CHECK:         pipeline.pipeline(%arg0) stall %stall clock %clk reset %rst
+hw.module @stallable(%arg0 : i32, %stall : i1, %clk : i1, %rst : i1) -> (out: i32) {
+  %0 = pipeline.pipeline(%arg0) stall %stall clock %clk reset %rst : (i32) -> (i32) {
+   ^bb0(%a0 : i32):
+    %c1_i1 = hw.constant 1 : i1
+    %r_0, %s0_valid = pipeline.stage.register when %c1_i1 regs %a0 : i32
+    pipeline.return %r_0 valid %s0_valid : i32
+  }
+  hw.output %0 : i32
+}
@@ -0,0 +1,32 @@
+// RUN: circt-opt %s -ssp-schedule=scheduler=asap -verify-diagnostics
+
+// All instances are scheduled, and report their errors, even if others fail.
+
+// expected-error@+1 {{unsupported problem 'CyclicProblem' for ASAP scheduler}}
+ssp.instance @cyclic of "CyclicProblem" {
+  library {
+    operator_type @_1 [latency<1>]
+  }
+  graph {
+    operation<@_1> @last()
+  }
+}
+
+// expected-error@+1 {{unsupported problem 'SharedOperatorsProblem' for ASAP scheduler}}
+ssp.instance @shared of "SharedOperatorsProblem" {
+  library {
+    operator_type @_1 [latency<1>]
+  }
+  graph {
+    operation<@_1> @last()
+  }
+}
+
+ssp.instance @fine of "Problem" {
+  library {
+    operator_type @_1 [latency<1>]
+  }
+  graph {
+    operation<@_1> @last()
+  }
+}
@@ -0,0 +1,258 @@
+// RUN: circt-opt %s -ssp-schedule="timeout=1" -mlir-pass-statistics -o %t.mlir 2>&1 | FileCheck %s
+// RUN: circt-opt %t.mlir -ssp-roundtrip=verify
+
+// The simplex heuristic needs far longer than a millisecond for this instance,
+// which is therefore scheduled by the list scheduler.
+
+// CHECK: 1 num-instances
+// CHECK: 1 num-timeouts
+ssp.instance @wide_tree of "SharedOperatorsProblem" {
+  library {
+    operator_type @L1_1 [latency<1>, limit<1>]
+    operator_type @L2_2 [latency<2>, limit<2>]
+    operator_type @_1 [latency<1>]
+  }
+  graph {
+    %0 = operation<@_1>()
+    %1 = operation<@L1_1>(%0)
+    %2 = operation<@L2_2>(%0)
+    %3 = operation<@L1_1>(%1, %0)
+    %4 = operation<@L2_2>(%1)
+    %5 = operation<@L1_1>(%2, %1)
+    %6 = operation<@L2_2>(%2, %1)
+    %7 = operation<@L1_1>(%3, %2)
+    %8 = operation<@L2_2>(%3, %2)
+    %9 = operation<@L1_1>(%4, %2)
+    %10 = operation<@L2_2>(%4, %3)
+    %11 = operation<@L1_1>(%5, %3)
+    %12 = operation<@L2_2>(%5, %3)
+    %13 = operation<@L1_1>(%6, %4)
+    %14 = operation<@L2_2>(%6, %4)
+    %15 = operation<@L1_1>(%7, %4)
+    %16 = operation<@L2_2>(%7, %5)
+    %17 = operation<@L1_1>(%8, %5)
+    %18 = operation<@L2_2>(%8, %5)
+    %19 = operation<@L1_1>(%9, %6)
+    %20 = operation<@L2_2>(%9, %6)
+    %21 = operation<@L1_1>(%10, %6)
+    %22 = operation<@L2_2>(%10, %7)
+    %23 = operation<@L1_1>(%11, %7)
+    %24 = operation<@L2_2>(%11, %7)
+    %25 = operation<@L1_1>(%12, %8)
+    %26 = operation<@L2_2>(%12, %8)
+    %27 = operation<@L1_1>(%13, %8)
+    %28 = operation<@L2_2>(%13, %9)
+    %29 = operation<@L1_1>(%14, %9)
+    %30 = operation<@L2_2>(%14, %9)
+    %31 = operation<@L1_1>(%15, %10)
+    %32 = operation<@L2_2>(%15, %10)
+    %33 = operation<@L1_1>(%16, %10)
+    %34 = operation<@L2_2>(%16, %11)
+    %35 = operation<@L1_1>(%17, %11)
+    %36 = operation<@L2_2>(%17, %11)
+    %37 = operation<@L1_1>(%18, %12)
+    %38 = operation<@L2_2>(%18, %12)
+    %39 = operation<@L1_1>(%19, %12)
+    %40 = operation<@L2_2>(%19, %13)
+    %41 = operation<@L1_1>(%20, %13)
+    %42 = operation<@L2_2>(%20, %13)
+    %43 = operation<@L1_1>(%21, %14)
+    %44 = operation<@L2_2>(%21, %14)
+    %45 = operation<@L1_1>(%22, %14)
+    %46 = operation<@L2_2>(%22, %15)
+    %47 = operation<@L1_1>(%23, %15)
+    %48 = operation<@L2_2>(%23, %15)
+    %49 = operation<@L1_1>(%24, %16)
+    %50 = operation<@L2_2>(%24, %16)
+    %51 = operation<@L1_1>(%25, %16)
+    %52 = operation<@L2_2>(%25, %17)
+    %53 = operation<@L1_1>(%26, %17)
+    %54 = operation<@L2_2>(%26, %17)
+    %55 = operation<@L1_1>(%27, %18)
+    %56 = operation<@L2_2>(%27, %18)
+    %57 = operation<@L1_1>(%28, %18)
+    %58 = operation<@L2_2>(%28, %19)
+    %59 = operation<@L1_1>(%29, %19)
+    %60 = operation<@L2_2>(%29, %19)
+    %61 = operation<@L1_1>(%30, %20)
+    %62 = operation<@L2_2>(%30, %20)
+    %63 = operation<@L1_1>(%31, %20)
+    %64 = operation<@L2_2>(%31, %21)
+    %65 = operation<@L1_1>(%32, %21)
+    %66 = operation<@L2_2>(%32, %21)
+    %67 = operation<@L1_1>(%33, %22)
+    %68 = operation<@L2_2>(%33, %22)
+    %69 = operation<@L1_1>(%34, %22)
+    %70 = operation<@L2_2>(%34, %23)
+    %71 = operation<@L1_1>(%35, %23)
+    %72 = operation<@L2_2>(%35, %23)
+    %73 = operation<@L1_1>(%36, %24)
+    %74 = operation<@L2_2>(%36, %24)
+    %75 = operation<@L1_1>(%37, %24)
+    %76 = operation<@L2_2>(%37, %25)
+    %77 = operation<@L1_1>(%38, %25)
+    %78 = operation<@L2_2>(%38, %25)
+    %79 = operation<@L1_1>(%39, %26)
+    %80 = operation<@L2_2>(%39, %26)
+    %81 = operation<@L1_1>(%40, %26)
+    %82 = operation<@L2_2>(%40, %27)
+    %83 = operation<@L1_1>(%41, %27)
+    %84 = operation<@L2_2>(%41, %27)
+    %85 = operation<@L1_1>(%42, %28)
+    %86 = operation<@L2_2>(%42, %28)
+    %87 = operation<@L1_1>(%43, %28)
+    %88 = operation<@L2_2>(%43, %29)
+    %89 = operation<@L1_1>(%44, %29)
+    %90 = operation<@L2_2>(%44, %29)
+    %91 = operation<@L1_1>(%45, %30)
+    %92 = operation<@L2_2>(%45, %30)
+    %93 = operation<@L1_1>(%46, %30)
+    %94 = operation<@L2_2>(%46, %31)
+    %95 = operation<@L1_1>(%47, %31)
+    %96 = operation<@L2_2>(%47, %31)
+    %97 = operation<@L1_1>(%48, %32)
+    %98 = operation<@L2_2>(%48, %32)
+    %99 = operation<@L1_1>(%49, %32)
+    %100 = operation<@L2_2>(%49, %33)
+    %101 = operation<@L1_1>(%50, %33)
+    %102 = operation<@L2_2>(%50, %33)
+    %103 = operation<@L1_1>(%51, %34)
+    %104 = operation<@L2_2>(%51, %34)
+    %105 = operation<@L1_1>(%52, %34)
+    %106 = operation<@L2_2>(%52, %35)
+    %107 = operation<@L1_1>(%53, %35)
+    %108 = operation<@L2_2>(%53, %35)
+    %109 = operation<@L1_1>(%54, %36)
+    %110 = operation<@L2_2>(%54, %36)
+    %111 = operation<@L1_1>(%55, %36)
+    %112 = operation<@L2_2>(%55, %37)
+    %113 = operation<@L1_1>(%56, %37)
+    %114 = operation<@L2_2>(%56, %37)
+    %115 = operation<@L1_1>(%57, %38)
+    %116 = operation<@L2_2>(%57, %38)
+    %117 = operation<@L1_1>(%58, %38)
+    %118 = operation<@L2_2>(%58, %39)
+    %119 = operation<@L1_1>(%59, %39)
+    %120 = operation<@L2_2>(%59, %39)
+    %121 = operation<@L1_1>(%60, %40)
+    %122 = operation<@L2_2>(%60, %40)
+    %123 = operation<@L1_1>(%61, %40)
+    %124 = operation<@L2_2>(%61, %41)
+    %125 = operation<@L1_1>(%62, %41)
+    %126 = operation<@L2_2>(%62, %41)
+    %127 = operation<@L1_1>(%63, %42)
+    %128 = operation<@L2_2>(%63, %42)
+    %129 = operation<@L1_1>(%64, %42)
+    %130 = operation<@L2_2>(%64, %43)
+    %131 = operation<@L1_1>(%65, %43)
+    %132 = operation<@L2_2>(%65, %43)
+    %133 = operation<@L1_1>(%66, %44)
+    %134 = operation<@L2_2>(%66, %44)
+    %135 = operation<@L1_1>(%67, %44)
+    %136 = operation<@L2_2>(%67, %45)
+    %137 = operation<@L1_1>(%68, %45)
+    %138 = operation<@L2_2>(%68, %45)
+    %139 = operation<@L1_1>(%69, %46)
+    %140 = operation<@L2_2>(%69, %46)
+    %141 = operation<@L1_1>(%70, %46)
+    %142 = operation<@L2_2>(%70, %47)
+    %143 = operation<@L1_1>(%71, %47)
+    %144 = operation<@L2_2>(%71, %47)
+    %145 = operation<@L1_1>(%72, %48)
+    %146 = operation<@L2_2>(%72, %48)
+    %147 = operation<@L1_1>(%73, %48)
+    %148 = operation<@L2_2>(%73, %49)
+    %149 = operation<@L1_1>(%74, %49)
+    %150 = operation<@L2_2>(%74, %49)
+    %151 = operation<@L1_1>(%75, %50)
+    %152 = operation<@L2_2>(%75, %50)
+    %153 = operation<@L1_1>(%76, %50)
+    %154 = operation<@L2_2>(%76, %51)
+    %155 = operation<@L1_1>(%77, %51)
+    %156 = operation<@L2_2>(%77, %51)
+    %157 = operation<@L1_1>(%78, %52)
+    %158 = operation<@L2_2>(%78, %52)
+    %159 = operation<@L1_1>(%79, %52)
+    %160 = operation<@L2_2>(%79, %53)
+    %161 = operation<@L1_1>(%80, %53)
+    %162 = operation<@L2_2>(%80, %53)
+    %163 = operation<@L1_1>(%81, %54)
+    %164 = operation<@L2_2>(%81, %54)
+    %165 = operation<@L1_1>(%82, %54)
+    %166 = operation<@L2_2>(%82, %55)
+    %167 = operation<@L1_1>(%83, %55)
+    %168 = operation<@L2_2>(%83, %55)
+    %169 = operation<@L1_1>(%84, %56)
+    %170 = operation<@L2_2>(%84, %56)
+    %171 = operation<@L1_1>(%85, %56)
+    %172 = operation<@L2_2>(%85, %57)
+    %173 = operation<@L1_1>(%86, %57)
+    %174 = operation<@L2_2>(%86, %57)
+    %175 = operation<@L1_1>(%87, %58)
+    %176 = operation<@L2_2>(%87, %58)
+    %177 = operation<@L1_1>(%88, %58)
+    %178 = operation<@L2_2>(%88, %59)
+    %179 = operation<@L1_1>(%89, %59)
+    %180 = operation<@L2_2>(%89, %59)
+    %181 = operation<@L1_1>(%90, %60)
+    %182 = operation<@L2_2>(%90, %60)
+    %183 = operation<@L1_1>(%91, %60)
+    %184 = operation<@L2_2>(%91, %61)
+    %185 = operation<@L1_1>(%92, %61)
+    %186 = operation<@L2_2>(%92, %61)
+    %187 = operation<@L1_1>(%93, %62)
+    %188 = operation<@L2_2>(%93, %62)
+    %189 = operation<@L1_1>(%94, %62)
+    %190 = operation<@L2_2>(%94, %63)
+    %191 = operation<@L1_1>(%95, %63)
+    %192 = operation<@L2_2>(%95, %63)
+    %193 = operation<@L1_1>(%96, %64)
+    %194 = operation<@L2_2>(%96, %64)
+    %195 = operation<@L1_1>(%97, %64)
+    %196 = operation<@L2_2>(%97, %65)
+    %197 = operation<@L1_1>(%98, %65)
+    %198 = operation<@L2_2>(%98, %65)
+    %199 = operation<@L1_1>(%99, %66)
+    %200 = operation<@L2_2>(%99, %66)
+    %201 = operation<@L1_1>(%100, %66)
+    %202 = operation<@L2_2>(%100, %67)
+    %203 = operation<@L1_1>(%101, %67)
+    %204 = operation<@L2_2>(%101, %67)
+    %205 = operation<@L1_1>(%102, %68)
+    %206 = operation<@L2_2>(%102, %68)
+    %207 = operation<@L1_1>(%103, %68)
+    %208 = operation<@L2_2>(%103, %69)
+    %209 = operation<@L1_1>(%104, %69)
+    %210 = operation<@L2_2>(%104, %69)
+    %211 = operation<@L1_1>(%105, %70)
+    %212 = operation<@L2_2>(%105, %70)
+    %213 = operation<@L1_1>(%106, %70)
+    %214 = operation<@L2_2>(%106, %71)
+    %215 = operation<@L1_1>(%107, %71)
+    %216 = operation<@L2_2>(%107, %71)
+    %217 = operation<@L1_1>(%108, %72)
+    %218 = operation<@L2_2>(%108, %72)
+    %219 = operation<@L1_1>(%109, %72)
+    %220 = operation<@L2_2>(%109, %73)
+    %221 = operation<@L1_1>(%110, %73)
+    %222 = operation<@L2_2>(%110, %73)
+    %223 = operation<@L1_1>(%111, %74)
+    %224 = operation<@L2_2>(%111, %74)
+    %225 = operation<@L1_1>(%112, %74)
+    %226 = operation<@L2_2>(%112, %75)
+    %227 = operation<@L1_1>(%113, %75)
+    %228 = operation<@L2_2>(%113, %75)
+    %229 = operation<@L1_1>(%114, %76)
+    %230 = operation<@L2_2>(%114, %76)
+    %231 = operation<@L1_1>(%115, %76)
+    %232 = operation<@L2_2>(%115, %77)
+    %233 = operation<@L1_1>(%116, %77)
+    %234 = operation<@L2_2>(%116, %77)
+    %235 = operation<@L1_1>(%117, %78)
+    %236 = operation<@L2_2>(%117, %78)
+    %237 = operation<@L1_1>(%118, %78)
+    %238 = operation<@L2_2>(%118, %79)
+    %239 = operation<@L1_1>(%119, %79)
+    operation<@_1> @last(%120, %128, %136, %144, %152, %160, %168, %176, %184, %192, %200, %208, %216, %224, %232)
+  }
+}
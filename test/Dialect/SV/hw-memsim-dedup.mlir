@@ -0,0 +1,29 @@
+// RUN: circt-opt -hw-memory-sim %s | FileCheck %s
+
+hw.generator.schema @FIRRTLMem, "FIRRTL_Memory", ["depth", "numReadPorts", "numWritePorts", "numReadWritePorts", "readLatency", "writeLatency", "width", "readUnderWrite", "writeUnderWrite", "writeClockIDs", "initFilename", "initIsBinary", "initIsInline"]
+
+sv.macro.decl @RANDOM
+
+// Memories with the same shape get the same body.  Register randomization
+// refers to the registers of its own module.
+
+// CHECK-LABEL: hw.module @First
+// CHECK:         %Memory = sv.reg
+// CHECK:         sv.verbatim {{.+}} {symbols = [#hw.innerNameRef<@First::[[SYM:@[^>]+]]>, #hw.innerNameRef<@First::
+// CHECK:         hw.output
+hw.module.generated @First, @FIRRTLMem(%ro_addr_0: i4, %ro_en_0: i1, %ro_clock_0: i1) -> (ro_data_0: i8) attributes {depth = 16 : i64, numReadPorts = 1 : ui32, numReadWritePorts = 0 : ui32, numWritePorts = 0 : ui32, readLatency = 1 : ui32, readUnderWrite = 0 : i32, width = 8 : ui32, writeClockIDs = [], writeLatency = 1 : ui32, writeUnderWrite = 0 : i32, initFilename = "", initIsBinary = false, initIsInline = false}
+
+// CHECK-LABEL: hw.module @Second
+// CHECK:         %Memory = sv.reg
+// CHECK-NOT:     @First::
+// CHECK:         sv.verbatim {{.+}} {symbols = [#hw.innerNameRef<@Second::[[SYM]]>, #hw.innerNameRef<@Second::
+// CHECK-NOT:     @First::
+// CHECK:         hw.output
+hw.module.generated @Second, @FIRRTLMem(%ro_addr_0: i4, %ro_en_0: i1, %ro_clock_0: i1) -> (ro_data_0: i8) attributes {depth = 16 : i64, numReadPorts = 1 : ui32, numReadWritePorts = 0 : ui32, numWritePorts = 0 : ui32, readLatency = 1 : ui32, readUnderWrite = 0 : i32, width = 8 : ui32, writeClockIDs = [], writeLatency = 1 : ui32, writeUnderWrite = 0 : i32, initFilename = "", initIsBinary = false, initIsInline = false}
+
+// Memories with a different shape get their own body.
+
+// CHECK-LABEL: hw.module @Deeper
+// CHECK:         %Memory = sv.reg
+// CHECK-SAME:      !hw.inout<uarray<32xi8>>
+hw.module.generated @Deeper, @FIRRTLMem(%ro_addr_0: i5, %ro_en_0: i1, %ro_clock_0: i1) -> (ro_data_0: i8) attributes {depth = 32 : i64, numReadPorts = 1 : ui32, numReadWritePorts = 0 : ui32, numWritePorts = 0 : ui32, readLatency = 1 : ui32, readUnderWrite = 0 : i32, width = 8 : ui32, writeClockIDs = [], writeLatency = 1 : ui32, writeUnderWrite = 0 : i32, initFilename = "", initIsBinary = false, initIsInline = false}
@@ -0,0 +1,35 @@
+// RUN: circt-opt --sv-trace-signals %s | FileCheck %s --check-prefix=ANNO
+// RUN: circt-opt --sv-trace-signals='select=Top.core.* levels=1' %s | FileCheck %s --check-prefix=GLOB
+// RUN: circt-opt --sv-trace-signals='format=fsdb clock=clk start-cycle=10 num-cycles=5' %s | FileCheck %s --check-prefix=WINDOW
+// RUN: circt-opt --sv-trace-signals='module=Core' %s | FileCheck %s --check-prefix=WHOLE
+// RUN: circt-opt --sv-trace-signals='module=Core select=Nothing' %s 2>&1 | FileCheck %s --check-prefix=NONE
+
+// Annotated instances are dumped, along with all the scopes below them.
+// ANNO-LABEL: hw.module @Top
+// ANNO-NEXT:    sv.verbatim "initial begin\0A  $dumpfile (\22Top.vcd\22);\0A  $dumpvars (0, Top.core);\0Aend\0A"
+
+// Patterns select additional scopes by their hierarchical name.
+// GLOB-LABEL: hw.module @Top
+// GLOB-NEXT:    sv.verbatim "initial begin\0A  $dumpfile (\22Top.vcd\22);\0A  $dumpvars (1, Top.core);\0A  $dumpvars (1, Top.core.alu);\0A  $dumpvars (1, Top.core.regs);\0Aend\0A"
+
+// WINDOW-LABEL: hw.module @Top
+// WINDOW-NEXT:   sv.verbatim "initial begin\0A  $fsdbDumpfile (\22Top.fsdb\22);\0A  $fsdbDumpvars (0, Top.core);\0A  $fsdbDumpoff;\0Aend\0Areg [63:0] _trace_cycle = 64'd0;\0Aalways @(posedge {{[{][{]0[}][}]}}) begin\0A  _trace_cycle <= _trace_cycle + 64'd1;\0A  if (_trace_cycle == 64'd10) $fsdbDumpon;\0A  if (_trace_cycle == 64'd15) $fsdbDumpoff;\0Aend\0A"(%clk) : i1
+
+// Without any selection, the whole design is dumped.
+// WHOLE-LABEL: hw.module @Core
+// WHOLE-NEXT:    sv.verbatim "initial begin\0A  $dumpfile (\22Core.vcd\22);\0A  $dumpvars (0, Core);\0Aend\0A"
+
+// NONE: warning: no scopes selected for tracing
+// NONE-NOT: sv.verbatim
+
+hw.module @Leaf() {}
+
+hw.module @Core() {
+  hw.instance "alu" @Leaf() -> ()
+  hw.instance "regs" @Leaf() -> ()
+}
+
+hw.module @Top(%clk: i1) {
+  hw.instance "core" @Core() -> () {sv.trace}
+  hw.instance "uncore" @Leaf() -> ()
+}
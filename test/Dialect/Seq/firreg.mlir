@@ -727,3 +727,17 @@ hw.module @NestedSubaccess(%clock: i1, %en_0: i1, %en_1: i1, %en_2: i1, %addr_0:
   // CHECK-NEXT: }
   hw.output
 }
+
+// Registers which are initialized from the same random word share its read.
+// COMMON-LABEL: hw.module private @SharedRandomWord
+hw.module private @SharedRandomWord(%clock: i1, %a: i8) {
+  %r0 = seq.firreg %a clock %clock : i8
+  %r1 = seq.firreg %a clock %clock : i8
+  // CHECK:      %[[WORD:.+]] = sv.array_index_inout %_RANDOM[%c0_i0]
+  // CHECK-NEXT: %[[READ:.+]] = sv.read_inout %[[WORD]] : !hw.inout<i32>
+  // CHECK-NEXT: %[[R0:.+]] = comb.extract %[[READ]] from 0 : (i32) -> i8
+  // CHECK-NEXT: sv.bpassign %r0, %[[R0]] : i8
+  // CHECK-NEXT: %[[R1:.+]] = comb.extract %[[READ]] from 8 : (i32) -> i8
+  // CHECK-NEXT: sv.bpassign %r1, %[[R1]] : i8
+  hw.output
+}
@@ -34,3 +34,43 @@ hw.module @d1(%clk : i1, %rst : i1) -> () {
   %myMemory_rdata2 = seq.read %myMemory[%c0_i2] rden %c1_i1 { latency = 2} : !seq.hlmem<4xi32>
   hw.output
 }
+
+// CHECK-LABEL:   hw.module @banked(
+// CHECK-SAME:                      %[[CLK:.*]]: i1, %[[RST:.*]]: i1, %[[ADDR:.*]]: i3, %[[DATA:.*]]: i32, %[[EN:.*]]: i1) -> (out: i32) {
+// CHECK:           %[[BANK0:.*]] = sv.reg : !hw.inout<uarray<4xi32>>
+// CHECK:           %[[BANK1:.*]] = sv.reg : !hw.inout<uarray<4xi32>>
+// CHECK:           %[[WBANK:.*]] = comb.extract %[[ADDR]] from 0 : (i3) -> i1
+// CHECK:           %[[WIDX:.*]] = comb.extract %[[ADDR]] from 1 : (i3) -> i2
+// CHECK:           %[[FALSE:.*]] = hw.constant false
+// CHECK:           %[[IS0:.*]] = comb.icmp eq %[[WBANK]], %[[FALSE]] : i1
+// CHECK:           %[[EN0:.*]] = comb.and %[[EN]], %[[IS0]] : i1
+// CHECK:           %[[TRUE:.*]] = hw.constant true
+// CHECK:           %[[IS1:.*]] = comb.icmp eq %[[WBANK]], %[[TRUE]] : i1
+// CHECK:           %[[EN1:.*]] = comb.and %[[EN]], %[[IS1]] : i1
+// CHECK:           sv.alwaysff(posedge %[[CLK]]) {
+// CHECK:             sv.if %[[EN0]] {
+// CHECK:               %[[LOC0:.*]] = sv.array_index_inout %[[BANK0]]{{\[}}%[[WIDX]]] : !hw.inout<uarray<4xi32>>, i2
+// CHECK:               sv.passign %[[LOC0]], %[[DATA]] : i32
+// CHECK:             }
+// CHECK:             sv.if %[[EN1]] {
+// CHECK:               %[[LOC1:.*]] = sv.array_index_inout %[[BANK1]]{{\[}}%[[WIDX]]] : !hw.inout<uarray<4xi32>>, i2
+// CHECK:               sv.passign %[[LOC1]], %[[DATA]] : i32
+// CHECK:             }
+// CHECK:           }(syncreset : posedge %[[RST]]) {
+// CHECK:           }
+// CHECK:           %[[RBANK:.*]] = comb.extract %[[ADDR]] from 0 : (i3) -> i1
+// CHECK:           %[[RIDX:.*]] = comb.extract %[[ADDR]] from 1 : (i3) -> i2
+// CHECK:           %[[RLOC0:.*]] = sv.array_index_inout %[[BANK0]]{{\[}}%[[RIDX]]] : !hw.inout<uarray<4xi32>>, i2
+// CHECK:           %[[RD0:.*]] = sv.read_inout %[[RLOC0]] : !hw.inout<i32>
+// CHECK:           %[[RLOC1:.*]] = sv.array_index_inout %[[BANK1]]{{\[}}%[[RIDX]]] : !hw.inout<uarray<4xi32>>, i2
+// CHECK:           %[[RD1:.*]] = sv.read_inout %[[RLOC1]] : !hw.inout<i32>
+// CHECK:           %[[BANKS:.*]] = hw.array_create %[[RD1]], %[[RD0]] : i32
+// CHECK:           %[[RD:.*]] = hw.array_get %[[BANKS]]{{\[}}%[[RBANK]]] : !hw.array<2xi32>, i1
+// CHECK:           hw.output %[[RD]] : i32
+// CHECK:         }
+hw.module @banked(%clk : i1, %rst : i1, %addr : i3, %data : i32, %en : i1) -> (out: i32) {
+  %mem = seq.hlmem @mem %clk, %rst {seq.num_banks = 2 : i64} : <8xi32>
+  seq.write %mem[%addr] %data wren %en { latency = 1 } : !seq.hlmem<8xi32>
+  %rdata = seq.read %mem[%addr] rden %en { latency = 0 } : !seq.hlmem<8xi32>
+  hw.output %rdata : i32
+}
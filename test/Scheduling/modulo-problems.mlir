@@ -1,5 +1,8 @@
 // RUN: circt-opt %s -ssp-roundtrip=verify
 // RUN: circt-opt %s -ssp-schedule=scheduler=simplex | FileCheck %s -check-prefixes=CHECK,SIMPLEX
+// RUN: circt-opt %s -ssp-schedule="scheduler=simplex options=candidate-iis=4" | FileCheck %s -check-prefixes=CHECK,SIMPLEX
+// RUN: circt-opt %s -ssp-schedule="scheduler=simplex options=candidate-iis=4 timeout=60000" | FileCheck %s -check-prefixes=CHECK,SIMPLEX
+// RUN: circt-opt %s -ssp-schedule=scheduler=list | FileCheck %s -check-prefix=CHECK
 
 // CHECK-LABEL: canis14_fig2
 // SIMPLEX-SAME: [II<4>]
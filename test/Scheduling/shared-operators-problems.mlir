@@ -1,5 +1,6 @@
 // RUN: circt-opt %s -ssp-roundtrip=verify
 // RUN: circt-opt %s -ssp-schedule=scheduler=simplex | FileCheck %s -check-prefixes=CHECK,SIMPLEX
+// RUN: circt-opt %s -ssp-schedule=scheduler=list | FileCheck %s -check-prefixes=CHECK,LIST
 // RUN: %if or-tools %{ circt-opt %s -ssp-schedule=scheduler=cpsat | FileCheck %s -check-prefixes=CHECK,CPSAT %} 
 
 // CHECK-LABEL: full_load
@@ -17,6 +18,7 @@ ssp.instance @full_load of "SharedOperatorsProblem" {
     %5 = operation<@_1>(%0, %1, %2, %3, %4) [t<7>]
     // SIMPLEX: @last(%{{.*}}) [t<8>]
     // CPSAT: @last(%{{.*}}) [t<8>]
+    // LIST: @last(%{{.*}}) [t<8>]
     operation<@_1> @last(%5) [t<8>]
   }
 }
@@ -36,6 +38,7 @@ ssp.instance @partial_load of "SharedOperatorsProblem" {
     %5 = operation<@_1>(%0, %1, %2, %3, %4) [t<10>]
     // SIMPLEX: @last(%{{.*}}) [t<5>]
     // CPSAT: @last(%{{.*}}) [t<5>]
+    // LIST: @last(%{{.*}}) [t<5>]
     operation<@_1> @last(%5) [t<11>]
   }
 }
@@ -56,6 +59,7 @@ ssp.instance @multiple of "SharedOperatorsProblem" {
     %5 = operation<@_1>(%0, %1, %2, %3, %4) [t<10>]
     // SIMPLEX: @last(%{{.*}}) [t<5>]
     // CPSAT: @last(%{{.*}}) [t<5>]
+    // LIST: @last(%{{.*}}) [t<5>]
     operation<@_1> @last(%5) [t<11>]
   }
 }
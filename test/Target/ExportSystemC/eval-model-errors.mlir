@@ -0,0 +1,30 @@
+// RUN: circt-translate %s --export-systemc-eval --verify-diagnostics --split-input-file
+
+hw.module @sub(%a: i1) -> (b: i1) {
+  hw.output %a : i1
+}
+
+hw.module @top(%a: i1) -> (b: i1) {
+  // expected-error @+1 {{'hw.instance' op cannot be part of an eval model, the module hierarchy has to be flattened first}}
+  %0 = hw.instance "sub" @sub(a: %a: i1) -> (b: i1)
+  hw.output %0 : i1
+}
+
+// -----
+
+hw.module @derivedClock(%clk: i1, %d: i8) -> (q: i8) {
+  %true = hw.constant true
+  %0 = comb.xor %clk, %true : i1
+  // expected-error @+1 {{'seq.compreg' op clock has to be a module input in an eval model}}
+  %r = seq.compreg %d, %0 : i8
+  hw.output %r : i8
+}
+
+// -----
+
+hw.module @cycle(%a: i1) -> (b: i1) {
+  %0 = comb.and %a, %1 : i1
+  // expected-error @+1 {{'comb.xor' op is part of a combinational cycle, which cannot be evaluated}}
+  %1 = comb.xor %0, %a : i1
+  hw.output %1 : i1
+}
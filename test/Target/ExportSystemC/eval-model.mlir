@@ -0,0 +1,115 @@
+// RUN: circt-translate %s --export-systemc-eval | FileCheck %s
+
+// CHECK-LABEL: // stdout.h
+// CHECK-NEXT: #ifndef STDOUT_H
+// CHECK-NEXT: #define STDOUT_H
+// CHECK-EMPTY:
+// CHECK-NEXT: #include <cstdint>
+
+// CHECK-EMPTY:
+// CHECK-LABEL: struct counter {
+// CHECK-NEXT:   // Inputs
+// CHECK-NEXT:   bool clk = 0;
+// CHECK-NEXT:   bool rst = 0;
+// CHECK-NEXT:   bool en = 0;
+// CHECK-NEXT:   uint8_t inc = 0;
+// CHECK-NEXT:   // Outputs
+// CHECK-NEXT:   uint8_t count = 0;
+// CHECK-NEXT:   bool wrapped = 0;
+// CHECK-NEXT:   // Registers
+// CHECK-NEXT:   uint8_t cnt = 0;
+// CHECK-NEXT:   // Clock values at the previous evaluation
+// CHECK-NEXT:   bool clk_last = 0;
+// CHECK-EMPTY:
+// CHECK-NEXT:   void eval() {
+// CHECK-NEXT:     bool clk_posedge = clk && !clk_last;
+// CHECK-NEXT:     clk_last = clk;
+// CHECK-NEXT:     if (clk_posedge) {
+// CHECK-NEXT:       uint8_t _0 = (uint64_t(cnt) + inc) & 0xFFu;
+// CHECK-NEXT:       uint8_t cnt_next = rst ? 0u : (en ? _0 : cnt);
+// CHECK-NEXT:       cnt = cnt_next;
+// CHECK-NEXT:     }
+// CHECK-NEXT:     uint8_t _1 = (uint64_t(cnt) + inc) & 0xFFu;
+// CHECK-NEXT:     count = cnt;
+// CHECK-NEXT:     wrapped = _1 < cnt;
+// CHECK-NEXT:   }
+// CHECK-NEXT: };
+hw.module @counter(%clk: i1, %rst: i1, %en: i1, %inc: i8) -> (count: i8, wrapped: i1) {
+  %c0_i8 = hw.constant 0 : i8
+  %sum = comb.add %cnt, %inc : i8
+  %next = comb.mux %en, %sum, %cnt : i8
+  %cnt = seq.compreg %next, %clk, %rst, %c0_i8 : i8
+  %wrapped = comb.icmp ult %sum, %cnt : i8
+  hw.output %cnt, %wrapped : i8, i1
+}
+
+// CHECK-LABEL: struct twoClocks {
+// CHECK:        void eval() {
+// CHECK-NEXT:     bool clkA_posedge = clkA && !clkA_last;
+// CHECK-NEXT:     clkA_last = clkA;
+// CHECK-NEXT:     bool clkB_posedge = clkB && !clkB_last;
+// CHECK-NEXT:     clkB_last = clkB;
+// CHECK-NEXT:     if (clkA_posedge || clkB_posedge) {
+// CHECK-NEXT:       uint16_t ra_next = d;
+// CHECK-NEXT:       uint16_t rb_next = ra;
+// CHECK-NEXT:       if (clkA_posedge) ra = ra_next;
+// CHECK-NEXT:       if (clkB_posedge) rb = rb_next;
+// CHECK-NEXT:     }
+// CHECK-NEXT:     q = rb;
+// CHECK-NEXT:   }
+hw.module @twoClocks(%clkA: i1, %clkB: i1, %d: i16) -> (q: i16) {
+  %ra = seq.compreg %d, %clkA : i16
+  %rb = seq.compreg %ra, %clkB : i16
+  hw.output %rb : i16
+}
+
+// CHECK-LABEL: struct ops {
+// CHECK-NEXT:   // Inputs
+// CHECK-NEXT:   uint8_t a = 0;
+// CHECK-NEXT:   uint8_t b = 0;
+// CHECK-NEXT:   uint8_t n = 0;
+// CHECK-NEXT:   uint32_t w = 0;
+// CHECK-NEXT:   // Outputs
+// CHECK-NEXT:   uint32_t o0 = 0;
+// CHECK-NEXT:   uint8_t o1 = 0;
+// CHECK-NEXT:   uint16_t o2 = 0;
+// CHECK-NEXT:   bool o3 = 0;
+// CHECK-NEXT:   bool o4 = 0;
+// CHECK-NEXT:   uint8_t o5 = 0;
+// CHECK-NEXT:   uint8_t o6 = 0;
+// CHECK-NEXT:   uint8_t o7 = 0;
+// CHECK-NEXT:   bool o8 = 0;
+// CHECK-NEXT:   uint8_t o9 = 0;
+// CHECK-NEXT:   uint64_t o10 = 0;
+// CHECK-EMPTY:
+// CHECK-NEXT:   void eval() {
+// CHECK-NEXT:     o0 = (w + w) * w;
+// CHECK-NEXT:     o1 = (uint64_t(n) + n) & 0xFu;
+// CHECK-NEXT:     o2 = (uint64_t(n) << 8) | a;
+// CHECK-NEXT:     o3 = int8_t(a) < int8_t(b);
+// CHECK-NEXT:     o4 = (int64_t(uint64_t(n) << 60) >> 60) >= (int64_t(uint64_t(3u) << 60) >> 60);
+// CHECK-NEXT:     o5 = b >= 8 ? 0 : (uint64_t(a) << b) & 0xFFu;
+// CHECK-NEXT:     o6 = uint64_t(int8_t(a) / int8_t(b)) & 0xFFu;
+// CHECK-NEXT:     o7 = (a >> 2) & 0xFu;
+// CHECK-NEXT:     o8 = __builtin_parityll(a);
+// CHECK-NEXT:     o9 = a ^ b ^ 255u;
+// CHECK-NEXT:     o10 = (uint64_t(w) << 32) | w;
+// CHECK-NEXT:   }
+// CHECK-NEXT: };
+hw.module @ops(%a: i8, %b: i8, %n: i4, %w: i32) -> (o0: i32, o1: i4, o2: i12, o3: i1, o4: i1, o5: i8, o6: i8, o7: i4, o8: i1, o9: i8, o10: i64) {
+  %c3_i4 = hw.constant 3 : i4
+  %ones = hw.constant -1 : i8
+  %0 = comb.add %w, %w : i32
+  %1 = comb.mul %0, %w : i32
+  %2 = comb.add %n, %n : i4
+  %3 = comb.concat %n, %a : i4, i8
+  %4 = comb.icmp slt %a, %b : i8
+  %5 = comb.icmp sge %n, %c3_i4 : i4
+  %6 = comb.shl %a, %b : i8
+  %7 = comb.divs %a, %b : i8
+  %8 = comb.extract %a from 2 : (i8) -> i4
+  %9 = comb.parity %a : i8
+  %10 = comb.xor %a, %b, %ones : i8
+  %11 = comb.replicate %w : (i32) -> i64
+  hw.output %1, %2, %3, %4, %5, %6, %7, %8, %9, %10, %11 : i32, i4, i12, i1, i1, i8, i8, i4, i1, i8, i64
+}
@@ -0,0 +1,24 @@
+// RUN: rm -rf %t.cache %t.json
+// RUN: arcilator %s --cache-dir=%t.cache --state-file=%t.json --mlir-timing 2> %t.miss | FileCheck %s
+// RUN: FileCheck %s --check-prefix=MISS < %t.miss
+// RUN: rm %t.json
+// RUN: arcilator %s --cache-dir=%t.cache --state-file=%t.json --mlir-timing 2> %t.hit | FileCheck %s
+// RUN: FileCheck %s --check-prefix=HIT < %t.hit
+// RUN: FileCheck %s --check-prefix=STATE < %t.json
+
+// Changing a pipeline option must not reuse the cached output.
+// RUN: arcilator %s --cache-dir=%t.cache --state-file=%t.json --lanes=2 --mlir-timing 2> %t.lanes > /dev/null
+// RUN: FileCheck %s --check-prefix=MISS < %t.lanes
+
+// CHECK: define void @Counter_clock
+// MISS: Parse MLIR input
+// HIT: Load cached output
+// HIT-NOT: Parse MLIR input
+// STATE: "name": "Counter"
+
+hw.module @Counter(%clock: i1, %en: i1, %inc: i8) -> (count: i8) {
+  %0 = comb.add %r, %inc : i8
+  %1 = comb.mux %en, %0, %r : i8
+  %r = seq.compreg %1, %clock : i8
+  hw.output %r : i8
+}
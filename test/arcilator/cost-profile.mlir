@@ -0,0 +1,53 @@
+// RUN: arcilator %s --until-after=preproc --cost-profile-file=%t > /dev/null
+// RUN: FileCheck %s < %t
+
+// CHECK:      "design": {
+// CHECK-NEXT:   "numOps": 15,
+// CHECK-NEXT:   "registerBits": 24,
+// CHECK-NEXT:   "memoryBits": 0,
+
+// CHECK:      "name": "Counter",
+// CHECK-NEXT: "occurrences": 3,
+// CHECK-NEXT: "numOps": 3,
+// CHECK-NEXT: "registerBits": 8,
+// CHECK:      "children": {}
+
+// CHECK:      "name": "Top",
+// CHECK-NEXT: "occurrences": 1,
+// CHECK-NEXT: "numOps": 3,
+// CHECK-NEXT: "registerBits": 0,
+// CHECK:      "total": {
+// CHECK-NEXT:   "numOps": 15,
+// CHECK-NEXT:   "registerBits": 24,
+// CHECK:      "children": {
+// CHECK-NEXT:   "Counter": 1,
+// CHECK-NEXT:   "Pair": 1
+// CHECK-NEXT: }
+
+// CHECK:      "name": "Pair",
+// CHECK-NEXT: "occurrences": 1,
+// CHECK-NEXT: "numOps": 3,
+// CHECK:      "total": {
+// CHECK-NEXT:   "numOps": 9,
+// CHECK-NEXT:   "registerBits": 16,
+// CHECK:      "children": {
+// CHECK-NEXT:   "Counter": 2
+// CHECK-NEXT: }
+
+hw.module @Counter(%clock: i1, %inc: i8) -> (count: i8) {
+  %0 = comb.add %r, %inc : i8
+  %r = seq.compreg %0, %clock : i8
+  hw.output %r : i8
+}
+
+hw.module @Top(%clock: i1, %inc: i8) -> (a: i8, b: i8) {
+  %a = hw.instance "a" @Counter(clock: %clock: i1, inc: %inc: i8) -> (count: i8)
+  %b = hw.instance "b" @Pair(clock: %clock: i1, inc: %inc: i8) -> (count: i8)
+  hw.output %a, %b : i8, i8
+}
+
+hw.module @Pair(%clock: i1, %inc: i8) -> (count: i8) {
+  %x = hw.instance "x" @Counter(clock: %clock: i1, inc: %inc: i8) -> (count: i8)
+  %y = hw.instance "y" @Counter(clock: %clock: i1, inc: %x: i8) -> (count: i8)
+  hw.output %y : i8
+}
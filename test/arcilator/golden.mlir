@@ -0,0 +1,126 @@
+// RUN: split-file %s %t
+// RUN: arcilator %t/counter.mlir --run --stimulus=%t/stim.vcd --golden=%t/golden.vcd 2>/dev/null | FileCheck %s
+// RUN: arcilator %t/counter.mlir --run --stimulus=%t/clocked.vcd --golden=%t/clocked-golden.vcd --trace-clock=clock 2>/dev/null | FileCheck %s
+// RUN: arcilator %t/counter.mlir --run --stimulus=%t/stim.vcd --golden=%t/golden.txt 2>/dev/null | FileCheck %s
+// RUN: not arcilator %t/counter.mlir --run --stimulus=%t/stim.vcd --golden=%t/bad.vcd 2>&1 | FileCheck %s --check-prefix=MISMATCH
+
+// The binary trace equivalent of stim.vcd, with an additional zero-width signal.
+// RUN: printf 'ARCTRC\001' > %t/stim.arctrc
+// RUN: printf '\001\000\000\000\000\001\000\000\000\006\000\000\000TOP.en' >> %t/stim.arctrc
+// RUN: printf '\001\001\000\000\000\010\000\000\000\007\000\000\000TOP.inc' >> %t/stim.arctrc
+// RUN: printf '\001\002\000\000\000\000\000\000\000\011\000\000\000TOP.empty' >> %t/stim.arctrc
+// RUN: printf '\002\000\000\000\000\000\000\000\000\003\000\000\000\000\001\003\001\000\000\000\001\003\002\000\000\000' >> %t/stim.arctrc
+// RUN: printf '\002\001\000\000\000\000\000\000\000\003\000\000\000\000\000\003\002\000\000\000' >> %t/stim.arctrc
+// RUN: printf '\002\002\000\000\000\000\000\000\000\003\000\000\000\000\001\003\001\000\000\000\020' >> %t/stim.arctrc
+// RUN: arcilator %t/counter.mlir --run --stimulus=%t/stim.arctrc --golden=%t/golden.vcd 2>/dev/null | FileCheck %s
+
+// A value change that is cut off before its value bytes.
+// RUN: printf 'ARCTRC\001\001\000\000\000\000\010\000\000\000\007\000\000\000TOP.inc\002\000\000\000\000\000\000\000\000\003\000\000\000\000' > %t/truncated.arctrc
+// RUN: not arcilator %t/counter.mlir --run --stimulus=%t/truncated.arctrc 2>&1 | FileCheck %s --check-prefix=TRUNCATED
+
+// CHECK: count = 0x11
+// MISMATCH: bad.vcd: mismatch in cycle 2: `count` is 0x11 but the golden value is 0x10
+// TRUNCATED: truncated.arctrc: truncated value change
+
+//--- counter.mlir
+hw.module @Counter(%clock: i1, %en: i1, %inc: i8) -> (count: i8) {
+  %0 = comb.add %r, %inc : i8
+  %1 = comb.mux %en, %0, %r : i8
+  %r = seq.compreg %1, %clock : i8
+  hw.output %r : i8
+}
+
+//--- stim.vcd
+$timescale 1ns $end
+$scope module TOP $end
+$var wire 1 ! en $end
+$var wire 8 " inc [7:0] $end
+$upscope $end
+$enddefinitions $end
+#0
+$dumpvars
+1!
+b1 "
+$end
+#1
+0!
+#2
+1!
+b10000 "
+
+//--- golden.vcd
+$scope module TOP $end
+$var wire 8 # count [7:0] $end
+$scope module Counter $end
+$var wire 8 $ count [7:0] $end
+$upscope $end
+$upscope $end
+$enddefinitions $end
+#0
+b1 #
+b0 $
+#1
+#2
+b10001 #
+
+//--- golden.txt
+count=1
+count=1
+count=0x11
+
+//--- bad.vcd
+$scope module TOP $end
+$var wire 8 # count [7:0] $end
+$upscope $end
+$enddefinitions $end
+#0
+b1 #
+#1
+#2
+b10000 #
+
+//--- clocked.vcd
+$scope module TOP $end
+$var wire 1 c clock $end
+$var wire 1 ! en $end
+$var wire 8 " inc [7:0] $end
+$upscope $end
+$enddefinitions $end
+#0
+0c
+1!
+b1 "
+#1
+1c
+#2
+0c
+0!
+#3
+1c
+#4
+0c
+1!
+b10000 "
+#5
+1c
+
+//--- clocked-golden.vcd
+$scope module TOP $end
+$var wire 1 c clock $end
+$var wire 8 # count [7:0] $end
+$upscope $end
+$enddefinitions $end
+#0
+0c
+#1
+1c
+b1 #
+#2
+0c
+#3
+1c
+#4
+0c
+#5
+1c
+b10001 #
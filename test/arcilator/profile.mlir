@@ -0,0 +1,18 @@
+// RUN: printf 'en=1 inc=1\n\nen=0\n# hold the increment\ninc=0x10 en=1\n' > %t.stim
+// RUN: arcilator %s --run --stimulus=%t.stim --profile-generate=%t.profile 2>/dev/null | FileCheck %s
+// RUN: FileCheck %s --check-prefix=PROFILE < %t.profile
+// RUN: arcilator %s --run --stimulus=%t.stim --profile-use=%t.profile 2>/dev/null | FileCheck %s
+// RUN: arcilator %s --run --stimulus=%t.stim --profile-use=%t.profile --cache-aware-layout 2>/dev/null | FileCheck %s
+
+// CHECK: count = 0x11
+
+// PROFILE: "cycles": 3
+// PROFILE: "calls": {
+// PROFILE: "toggles": {
+
+hw.module @Counter(%clock: i1, %en: i1, %inc: i8) -> (count: i8) {
+  %0 = comb.add %r, %inc : i8
+  %1 = comb.mux %en, %0, %r : i8
+  %r = seq.compreg %1, %clock : i8
+  hw.output %r : i8
+}
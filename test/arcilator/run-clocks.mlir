@@ -0,0 +1,29 @@
+// RUN: arcilator %s --run --run-cycles=8 2>/dev/null | FileCheck %s --check-prefix=ALL
+// RUN: arcilator %s --run --run-cycles=8 --clock-period=slow=4 2>/dev/null | FileCheck %s
+// RUN: arcilator %s --run --run-cycles=8 --clock-period=fast=1,slow=4 2>/dev/null | FileCheck %s
+// RUN: arcilator %s --run --run-cycles=6 --clock-period=fast=2,slow=3 2>/dev/null | FileCheck %s --check-prefix=MIXED
+// RUN: not arcilator %s --run --run-cycles=8 --clock-period=medium=2 2>&1 | FileCheck %s --check-prefix=UNKNOWN
+// RUN: arcilator %s --state-file=%t.json --emit-mlir > /dev/null
+// RUN: FileCheck %s --check-prefix=STATE < %t.json
+
+// ALL-DAG: a = 0x8
+// ALL-DAG: b = 0x8
+// CHECK-DAG: a = 0x8
+// CHECK-DAG: b = 0x2
+// MIXED-DAG: a = 0x4
+// MIXED-DAG: b = 0x3
+// UNKNOWN: unknown clock `medium` in --clock-period
+// STATE:      "clocks": [
+// STATE:        "name": "fast"
+// STATE-NEXT:   "function": "Counters_clock"
+// STATE:        "name": "slow"
+// STATE-NEXT:   "function": "Counters_clock_0"
+
+hw.module @Counters(%fast: i1, %slow: i1) -> (a: i8, b: i8) {
+  %c1_i8 = hw.constant 1 : i8
+  %0 = comb.add %a, %c1_i8 : i8
+  %a = seq.compreg %0, %fast : i8
+  %1 = comb.add %b, %c1_i8 : i8
+  %b = seq.compreg %1, %slow : i8
+  hw.output %a, %b : i8, i8
+}
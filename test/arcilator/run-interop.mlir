@@ -0,0 +1,25 @@
+// RUN: printf 'x=0xfffffffb\n' > %t.stim
+// RUN: arcilator %s --run --stimulus=%t.stim 2>/dev/null | FileCheck %s
+// RUN: arcilator %s | FileCheck %s --check-prefix=LLVM
+
+// CHECK-DAG: y = 0x5
+// CHECK-DAG: r = 0x5
+// LLVM:      declare i32 @abs(i32)
+// LLVM:      define internal i32 @Abs_interop(i32
+// LLVM-NEXT:   call i32 @abs(i32
+// LLVM:      define void @Abs_clock(ptr
+// LLVM:        call i32 @Abs_interop(i32
+
+// The interop procedure calls `abs` of the C library, which the JIT finds in
+// the running process.
+func.func private @abs(i32) -> i32
+
+hw.module @Abs(%clock: i1, %x: i32) -> (y: i32, r: i32) {
+  %0 = interop.procedural.update cffi (%x) : (i32) -> i32 {
+  ^bb0(%arg0: i32):
+    %1 = func.call @abs(%arg0) : (i32) -> i32
+    interop.return %1 : i32
+  }
+  %r = seq.compreg %0, %clock : i32
+  hw.output %0, %r : i32, i32
+}
@@ -0,0 +1,23 @@
+// RUN: arcilator %s --run --run-cycles=5 2>/dev/null | FileCheck %s
+// RUN: arcilator %s --run --run-cycles=5 --clock-partitions=2 2>/dev/null | FileCheck %s
+// RUN: arcilator %s --run --run-cycles=5 --clock-partitions=2 --lanes=2 2>/dev/null | FileCheck %s
+// RUN: arcilator %s --run --run-cycles=5 --max-ops-per-func=1 2>/dev/null | FileCheck %s
+// RUN: arcilator %s --run --run-cycles=5 --max-ops-per-func=1 --print-compile-stats 2>&1 >/dev/null | FileCheck %s --check-prefix=STATS
+// RUN: arcilator %s --clock-partitions=2 --state-file=%t.json --emit-mlir > /dev/null
+// RUN: FileCheck %s --check-prefix=STATE < %t.json
+
+// CHECK-DAG: a = 0x5
+// CHECK-DAG: b = 0x14
+// STATE: "clockPartitions": 2
+// STATS: function Counters_clock{{.*}}: {{[0-9]+}} ops
+// STATS: compiled at -O3 in {{.*}} s
+
+hw.module @Counters(%clock: i1) -> (a: i8, b: i8) {
+  %c1_i8 = hw.constant 1 : i8
+  %c4_i8 = hw.constant 4 : i8
+  %0 = comb.add %a, %c1_i8 : i8
+  %a = seq.compreg %0, %clock : i8
+  %1 = comb.add %b, %c4_i8 : i8
+  %b = seq.compreg %1, %clock : i8
+  hw.output %a, %b : i8, i8
+}
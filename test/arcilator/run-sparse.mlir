@@ -0,0 +1,15 @@
+// RUN: printf 'en=1 addr=3 data=9\nen=1\n' > %t.stim
+// RUN: arcilator %s --run --stimulus=%t.stim --sparse-memory-threshold=512 2>/dev/null | FileCheck %s
+// RUN: arcilator %s --run --stimulus=%t.stim --sparse-memory-threshold=512 --lanes=2 2>/dev/null | FileCheck %s
+
+// The pages of the sparse memory are allocated by the model while it runs, and
+// released once the run ends.
+
+// CHECK: q = 0x9
+
+hw.module @Sparse(%clock: i1, %en: i1, %addr: i10, %data: i16) -> (q: i16) {
+  %0 = hw.instance "mem" @Mem(R0_addr: %addr: i10, R0_en: %en: i1, R0_clk: %clock: i1, W0_addr: %addr: i10, W0_en: %en: i1, W0_clk: %clock: i1, W0_data: %data: i16) -> (R0_data: i16)
+  hw.output %0 : i16
+}
+hw.generator.schema @FIRRTLMem, "FIRRTL_Memory", ["depth", "numReadPorts", "numWritePorts", "numReadWritePorts", "readLatency", "writeLatency", "width", "maskGran", "readUnderWrite", "writeUnderWrite", "writeClockIDs"]
+hw.module.generated @Mem, @FIRRTLMem(%R0_addr: i10, %R0_en: i1, %R0_clk: i1, %W0_addr: i10, %W0_en: i1, %W0_clk: i1, %W0_data: i16) -> (R0_data: i16) attributes {depth = 1024 : i64, maskGran = 16 : ui32, numReadPorts = 1 : ui32, numReadWritePorts = 0 : ui32, numWritePorts = 1 : ui32, readLatency = 0 : ui32, readUnderWrite = 0 : ui32, width = 16 : ui32, writeClockIDs = [], writeLatency = 1 : ui32, writeUnderWrite = 1 : i32}
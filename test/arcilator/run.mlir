@@ -0,0 +1,17 @@
+// RUN: printf 'en=1 inc=1\n\nen=0\n# hold the increment\ninc=0x10 en=1\n' > %t.stim
+// RUN: arcilator %s --run --stimulus=%t.stim 2> %t.err | FileCheck %s
+// RUN: FileCheck %s --check-prefix=STATS < %t.err
+// RUN: arcilator %s --run --stimulus=%t.stim --gate-idle-arcs 2>/dev/null | FileCheck %s
+// RUN: arcilator %s --run --stimulus=%t.stim --lanes=4 2>/dev/null | FileCheck %s
+// RUN: arcilator %s --run --stimulus=%t.stim --run-cycles=5 2>/dev/null | FileCheck %s --check-prefix=HOLD
+
+// CHECK: count = 0x11
+// STATS: ran 3 cycles in {{.*}} s ({{[0-9]+}} cycles/s)
+// HOLD: count = 0x31
+
+hw.module @Counter(%clock: i1, %en: i1, %inc: i8) -> (count: i8) {
+  %0 = comb.add %r, %inc : i8
+  %1 = comb.mux %en, %0, %r : i8
+  %r = seq.compreg %1, %clock : i8
+  hw.output %r : i8
+}
@@ -0,0 +1,36 @@
+// RUN: circt-as %s -o - | circt-dis --module=Bar --module=Qux | FileCheck %s --implicit-check-not=@Top( --implicit-check-not="hw.module @Foo"
+// RUN: circt-opt %s -emit-bytecode | not circt-dis --module=Baz 2>&1 | FileCheck %s --check-prefix=MISSING
+// RUN: not circt-dis %s --module=Bar 2>&1 | FileCheck %s --check-prefix=TEXT
+
+// CHECK-LABEL: hw.module @Bar(%a: i1) -> (b: i1) {
+// CHECK-NEXT:    %inst.b = hw.instance "inst" @Foo(a: %a: i1) -> (b: i1)
+// CHECK-NEXT:    hw.output %inst.b : i1
+// CHECK-NEXT:  }
+// CHECK-LABEL: firrtl.circuit "Top" {
+// CHECK-NEXT:    firrtl.module @Qux(in %in: !firrtl.uint<8>, out %out: !firrtl.uint<8>) {
+// CHECK-NEXT:      firrtl.strictconnect %out, %in : !firrtl.uint<8>
+// CHECK-NEXT:    }
+// CHECK-NEXT:  }
+
+// MISSING: error: module 'Baz' not found in the input
+// TEXT: error: module selection requires bytecode input
+
+hw.module @Foo(%a: i1) -> (b: i1) {
+  hw.output %a : i1
+}
+
+hw.module @Bar(%a: i1) -> (b: i1) {
+  %inst.b = hw.instance "inst" @Foo(a: %a: i1) -> (b: i1)
+  hw.output %inst.b : i1
+}
+
+firrtl.circuit "Top" {
+  firrtl.module @Top(in %in : !firrtl.uint<8>,
+                     out %out : !firrtl.uint<8>) {
+    firrtl.instance qux @Qux(in in : !firrtl.uint<8>, out out : !firrtl.uint<8>)
+  }
+  firrtl.module @Qux(in %in : !firrtl.uint<8>,
+                     out %out : !firrtl.uint<8>) {
+    firrtl.strictconnect %out, %in : !firrtl.uint<8>
+  }
+}
@@ -0,0 +1,34 @@
+// RUN: circt-lsp-server --incremental -lit-test < %s | FileCheck %s
+{"jsonrpc":"2.0","id":0,"method":"initialize","params":{"processId":123,"rootPath":"circt","capabilities":{},"trace":"off"}}
+// CHECK: "documentSymbolProvider": true
+// CHECK: "hoverProvider": true
+// -----
+// Opening the document only indexes its modules.
+{"jsonrpc":"2.0","method":"textDocument/didOpen","params":{"textDocument":{"uri":"test:///foo.mlir","languageId":"mlir","version":1,"text":"hw.module @Good(%a: i1) -> (b: i1) {\n  hw.output %a : i1\n}\nhw.module @Bad(%a: i1) -> (b: i1) {\n  hw.output %c : i1\n}\n"}}}
+// CHECK: "method": "textDocument/publishDiagnostics"
+// CHECK: "diagnostics": []
+// CHECK: "version": 1
+// -----
+{"jsonrpc":"2.0","id":1,"method":"textDocument/documentSymbol","params":{"textDocument":{"uri":"test:///foo.mlir"}}}
+// CHECK: "id": 1
+// CHECK: "name": "Good"
+// CHECK: "name": "Bad"
+// -----
+// Viewing a module checks it.
+{"jsonrpc":"2.0","id":2,"method":"textDocument/hover","params":{"textDocument":{"uri":"test:///foo.mlir"},"position":{"line":4,"character":5}}}
+// CHECK: "method": "textDocument/publishDiagnostics"
+// CHECK: "message": "use of undeclared SSA value name"
+// CHECK: "line": 4
+// CHECK: "version": 1
+// CHECK: "id": 2
+// CHECK: Module `@Bad`
+// -----
+// Edits within a module only check that module again.
+{"jsonrpc":"2.0","method":"textDocument/didChange","params":{"textDocument":{"uri":"test:///foo.mlir","version":2},"contentChanges":[{"range":{"start":{"line":4,"character":12},"end":{"line":4,"character":14}},"text":"%a"}]}}
+// CHECK: "method": "textDocument/publishDiagnostics"
+// CHECK: "diagnostics": []
+// CHECK: "version": 2
+// -----
+{"jsonrpc":"2.0","id":3,"method":"shutdown"}
+// -----
+{"jsonrpc":"2.0","method":"exit"}
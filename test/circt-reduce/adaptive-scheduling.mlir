@@ -0,0 +1,17 @@
+// UNSUPPORTED: system-windows
+//   See https://github.com/llvm/circt/issues/4129
+// RUN: circt-reduce %s --test /usr/bin/env --test-arg grep --test-arg -q --test-arg "hw.module @Foo" --keep-best=0 --adaptive --include operation-pruner --include hw-module-externalizer 2>%t.log | FileCheck %s
+// RUN: FileCheck %s --input-file %t.log --check-prefix=REPORT
+
+// REPORT: Reduction statistics:
+// REPORT: operation-pruner {{ *}}{{[0-9]+}} tests {{ *}}{{[0-9]+}} accepted {{ *}}{{[0-9]+}} bytes removed
+
+// CHECK-LABEL: hw.module @Foo
+hw.module @Foo(%arg0: i32) -> (out: i32) {
+  hw.output %arg0 : i32
+}
+
+// CHECK-NOT: hw.module @Bar
+hw.module @Bar(%arg0: i32) -> (out: i32) {
+  hw.output %arg0 : i32
+}
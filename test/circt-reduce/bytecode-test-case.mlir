@@ -0,0 +1,12 @@
+// UNSUPPORTED: system-windows
+// RUN: circt-reduce %s --emit-bytecode --test /usr/bin/env --test-arg sh --test-arg -c --test-arg 'head -c 2 "$0" | grep -q ML && circt-opt "$0" | grep -q "hw.module @Foo"' --keep-best=0 --include operation-pruner | FileCheck %s
+
+// The test cases handed to the test are bytecode, which starts with the magic
+// bytes "ML\xefR", and still decode into the module. The final output is text.
+
+// CHECK-LABEL: hw.module @Foo
+// CHECK-NOT:   hw.constant
+hw.module @Foo() {
+  %0 = hw.constant 0 : i32
+  %1 = hw.constant 1 : i32
+}
@@ -0,0 +1,28 @@
+// UNSUPPORTED: system-windows
+// RUN: circt-reduce %s --test-pipeline='builtin.module(firrtl.circuit(firrtl-check-comb-loops))' --test-diagnostic='detected combinational cycle' --keep-best=0 --include operation-pruner | FileCheck %s
+// RUN: circt-reduce %s --test-pipeline='builtin.module(firrtl.circuit(firrtl-check-comb-loops))' --test-diagnostic='detected combinational cycle' --emit-bytecode --keep-best=0 --include operation-pruner | FileCheck %s
+// RUN: not circt-reduce %s --test /usr/bin/env --test-pipeline='builtin.module(cse)' 2>&1 | FileCheck %s --check-prefix=ERROR
+// RUN: not circt-reduce %s --test-pipeline='builtin.module(firrtl.circuit(firrtl-check-comb-loops))' --include operation-pruner 2>&1 | FileCheck %s --check-prefix=NOCRASH
+// RUN: not circt-reduce %s --test-pipeline='builtin.module(cse)' -j 2 2>&1 | FileCheck %s --check-prefix=JOBS
+
+// ERROR: exactly one of `--test` and `--test-pipeline` is needed
+// JOBS: `--test-pipeline` cannot be used with `-j` > 1
+
+// A pipeline failing with an error does not count as a crash.
+// NOCRASH: input is not interesting
+
+// CHECK-LABEL: firrtl.circuit "Loop"
+firrtl.circuit "Loop" {
+  // CHECK-NOT: firrtl.module @Unrelated
+  firrtl.module @Unrelated(in %a: !firrtl.uint<1>, out %b: !firrtl.uint<1>) {
+    firrtl.connect %b, %a : !firrtl.uint<1>, !firrtl.uint<1>
+  }
+  // CHECK: firrtl.module @Loop
+  firrtl.module @Loop(in %a: !firrtl.uint<1>, out %b: !firrtl.uint<1>) {
+    %y = firrtl.wire : !firrtl.uint<1>
+    %z = firrtl.wire : !firrtl.uint<1>
+    firrtl.connect %z, %y : !firrtl.uint<1>, !firrtl.uint<1>
+    firrtl.connect %y, %z : !firrtl.uint<1>, !firrtl.uint<1>
+    firrtl.connect %b, %a : !firrtl.uint<1>, !firrtl.uint<1>
+  }
+}
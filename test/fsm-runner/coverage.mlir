@@ -0,0 +1,82 @@
+// RUN: split-file %s %t
+// RUN: fsm-runner %t/counter.mlir --stimulus=%t/stimulus.txt --trace --coverage | FileCheck %s
+// RUN: fsm-runner %t/counter.mlir --steps=10000 --seed=1 --coverage | FileCheck %s --check-prefix=RANDOM
+
+// CHECK:      0 IDLE 0
+// CHECK-NEXT: 1 IDLE 0
+// CHECK-NEXT: 2 BUSY 1
+// CHECK-NEXT: 3 BUSY 1
+// CHECK-NEXT: 4 BUSY 1
+// CHECK-NEXT: 5 DONE 2
+// CHECK-NEXT: 6 IDLE 0
+// CHECK-NEXT: state IDLE: 3
+// CHECK-NEXT:   transition 0 to BUSY: 1
+// CHECK-NEXT:   transition 1 to IDLE: 2
+// CHECK-NEXT: state BUSY: 3
+// CHECK-NEXT:   transition 0 to DONE: 1
+// CHECK-NEXT:   transition 1 to BUSY: 2
+// CHECK-NEXT: state DONE: 1
+// CHECK-NEXT:   transition 0 to IDLE: 1
+// CHECK-NEXT: state UNUSED: 0
+// CHECK-NEXT: states covered: 3/4
+// CHECK-NEXT: transitions covered: 5/5
+
+// RANDOM: states covered: 3/4
+// RANDOM: transitions covered: 5/5
+
+//--- counter.mlir
+fsm.machine @counter(%go: i1) -> (i2) attributes {initialState = "IDLE"} {
+  %cnt = fsm.variable "cnt" {initValue = 0 : i8} : i8
+  %c0_i2 = hw.constant 0 : i2
+  %c1_i2 = hw.constant 1 : i2
+  %c2_i2 = hw.constant 2 : i2
+  %c0_i8 = hw.constant 0 : i8
+  %c1_i8 = hw.constant 1 : i8
+  %c2_i8 = hw.constant 2 : i8
+
+  fsm.state @IDLE output {
+    fsm.output %c0_i2 : i2
+  } transitions {
+    fsm.transition @BUSY guard {
+      fsm.return %go
+    } action {
+      fsm.update %cnt, %c0_i8 : i8
+    }
+    fsm.transition @IDLE
+  }
+
+  fsm.state @BUSY output {
+    fsm.output %c1_i2 : i2
+  } transitions {
+    fsm.transition @DONE guard {
+      %eq = comb.icmp eq %cnt, %c2_i8 : i8
+      fsm.return %eq
+    }
+    fsm.transition @BUSY action {
+      %next = comb.add %cnt, %c1_i8 : i8
+      fsm.update %cnt, %next : i8
+    }
+  }
+
+  fsm.state @DONE output {
+    fsm.output %c2_i2 : i2
+  } transitions {
+    fsm.transition @IDLE
+  }
+
+  fsm.state @UNUSED output {
+    fsm.output %c0_i2 : i2
+  } transitions {
+    fsm.transition @IDLE
+  }
+}
+
+//--- stimulus.txt
+# go
+0
+1
+0
+0
+0
+0
+0
@@ -46,10 +46,23 @@ class StateInfo:
   typ: StateType
   stride: Optional[int]
   depth: Optional[int]
+  pageWords: Optional[int]
+  # The hierarchical name, which `name` is shortened to within its hierarchy.
+  path: Optional[str] = None
+  # The bit within the byte at `offset` of single-bit states packed with
+  # others.
+  bit: Optional[int] = None
 
   def decode(d: dict) -> "StateInfo":
     return StateInfo(d["name"], d["offset"], d["numBits"], StateType(d["type"]),
-                     d.get("stride"), d.get("depth"))
+                     d.get("stride"), d.get("depth"), d.get("pageWords"),
+                     d["name"], d.get("bit"))
+
+  def is_packed(self) -> bool:
+    return self.bit is not None
+
+  def is_sparse(self) -> bool:
+    return self.typ == StateType.MEMORY and bool(self.pageWords)
 
 
 @dataclass
@@ -66,10 +79,16 @@ class ModelInfo:
   states: List[StateInfo]
   io: List[StateInfo]
   hierarchy: List[StateHierarchy]
+  clockPartitions: int
+  # The clock domains of models with several clocks, as `(input, function)`.
+  clocks: List[Tuple[str, str]]
 
   def decode(d: dict) -> "ModelInfo":
     return ModelInfo(d["name"], d["numStateBytes"],
-                     [StateInfo.decode(d) for d in d["states"]], list(), list())
+                     [StateInfo.decode(d) for d in d["states"]], list(), list(),
+                     d.get("clockPartitions", 0),
+                     [(c.get("name", ""), c["function"])
+                      for c in d.get("clocks", [])])
 
 
 with open(args.state_json, "r") as f:
@@ -138,12 +157,16 @@ def format_signal(state: StateInfo) -> str:
   ]
   if state.typ == StateType.MEMORY:
     fields += [state.stride, state.depth]
+  elif state.is_packed():
+    fields += [0, 0, state.bit]
   fields = ", ".join((str(f) for f in fields))
   return f"Signal{{{fields}}}"
 
 
 def format_hierarchy(hierarchy: StateHierarchy) -> str:
-  states = ",\n  ".join((format_signal(s) for s in hierarchy.states))
+  # Sparse memories are not laid out in the storage and cannot be traced.
+  traced = [s for s in hierarchy.states if not s.is_sparse()]
+  states = ",\n  ".join((format_signal(s) for s in traced))
   if states:
     states = "\n  " + states + "\n"
   states = "{" + states + "}"
@@ -152,7 +175,7 @@ def format_hierarchy(hierarchy: StateHierarchy) -> str:
   if children:
     children = "\n  " + children + "\n"
   children = "{" + children + "}"
-  return f"Hierarchy{{\"{hierarchy.name}\", {len(hierarchy.states)}, {len(hierarchy.children)}, (Signal[]){states}, (Hierarchy[]){children}}}"
+  return f"Hierarchy{{\"{hierarchy.name}\", {len(traced)}, {len(hierarchy.children)}, (Signal[]){states}, (Hierarchy[]){children}}}"
 
 
 def state_cpp_type_nonmemory(state: StateInfo) -> str:
@@ -164,6 +187,9 @@ def state_cpp_type_nonmemory(state: StateInfo) -> str:
 
 
 def state_cpp_type(state: StateInfo) -> str:
+  if state.is_sparse():
+    return (f"SparseMemory<{state_cpp_type_nonmemory(state)}, {state.stride}, "
+            f"{state.depth}, {state.pageWords}>")
   if state.typ == StateType.MEMORY:
     return f"Memory<{state_cpp_type_nonmemory(state)}, {state.stride}, {state.depth}>"
   return state_cpp_type_nonmemory(state)
@@ -190,10 +216,18 @@ def clean_name(name: str) -> str:
   return name
 
 
+# Packed bits only share their byte, so they are exposed through a `PackedBit`
+# that masks the accesses, rather than a reference to the byte.
+def state_cpp_member(state: StateInfo, name: str) -> str:
+  if state.is_packed():
+    return f"PackedBit {name};"
+  return f"{state_cpp_type(state)} &{name};"
+
+
 def format_view_hierarchy(hierarchy: StateHierarchy, depth: int) -> str:
   lines = []
   for state in hierarchy.states:
-    lines.append(f"{state_cpp_type(state)} &{clean_name(state.name)};")
+    lines.append(state_cpp_member(state, clean_name(state.name)))
   if depth > 0:
     for child in hierarchy.children:
       lines.append(
@@ -206,6 +240,8 @@ def format_view_hierarchy(hierarchy: StateHierarchy, depth: int) -> str:
 
 
 def state_cpp_ref(state: StateInfo) -> str:
+  if state.is_packed():
+    return f"PackedBit{{state[{state.offset}], {1 << state.bit}}}"
   return f"*({state_cpp_type(state)}*)(state+{state.offset})"
 
 
@@ -242,6 +278,12 @@ for model in models:
   print('extern "C" {')
   print(f"void {model.name}_clock(void* state);")
   print(f"void {model.name}_passthrough(void* state);")
+  for _, function in model.clocks[1:]:
+    print(f"void {function}(void* state);")
+  for i in range(model.clockPartitions):
+    print(f"void {model.name}_clock_part{i}(void* state);")
+  if model.clockPartitions > 0:
+    print(f"void {model.name}_clock_commit(void* state);")
   print('}')
 
   # Generate the model layout.
@@ -275,7 +317,7 @@ for model in models:
   print(f"class {model.name}View {{")
   print("public:")
   for io in model.io:
-    print(f"  {state_cpp_type(io)} &{io.name};")
+    print(f"  {state_cpp_member(io, io.name)}")
   print(
       f"  {indent(format_view_hierarchy(model.hierarchy[0], args.view_depth))} {model.hierarchy[0].name};"
   )
@@ -300,16 +342,78 @@ for model in models:
   print(
       f"  {model.name}() : storage({model.name}Layout::numStateBytes, 0), view(&storage[0]) {{}}"
   )
+  sparse = [state for state in model.states if state.is_sparse()]
+  if sparse:
+    print(f"  {model.name}(const {model.name} &) = delete;")
+    print(f"  ~{model.name}() {{")
+    for state in sparse:
+      print(f"    (({state_cpp_type(state)}*)(&storage[0]+{state.offset}))"
+            f"->release();")
+    print("  }")
   print(f"  void clock() {{ {model.name}_clock(&storage[0]); }}")
   print(f"  void passthrough() {{ {model.name}_passthrough(&storage[0]); }}")
-  print(
-      f"  ValueChangeDump<{model.name}Layout> vcd(std::basic_ostream<char> &os) {{"
-  )
-  print(f"    ValueChangeDump<{model.name}Layout> vcd(os, &storage[0]);")
+  if model.clockPartitions > 0:
+    parts = ", ".join(f"{model.name}_clock_part{i}"
+                      for i in range(model.clockPartitions))
+    print(f"  ClockPartitionPool clockPool{{{{{parts}}}, "
+          f"{model.name}_clock_commit}};")
+    print(f"  void clockParallel() {{ clockPool.run(&storage[0]); }}")
+  if model.clocks:
+    domains = ", ".join(
+        f"{{\"{name}\", {function}}}" for name, function in model.clocks)
+    print(f"  ClockScheduler scheduler{{{{{domains}}}, "
+          f"{model.name}_passthrough}};")
+    print("  uint64_t step() { return scheduler.step(&storage[0]); }")
+  print(f"  ValueChangeDump<{model.name}Layout> vcd(std::basic_ostream<char> &os,"
+        f" TraceEncoding encoding = TraceEncoding::VCD) {{")
+  print(f"    ValueChangeDump<{model.name}Layout> vcd(os, &storage[0], "
+        f"encoding);")
   print("    vcd.writeHeader();")
   print("    vcd.writeDumpvars();")
   print("    return vcd;")
   print("  }")
+
+  # Generate the snapshot helpers. The page tables of sparse memories are part
+  # of the storage but are owned by the memories, so they are left alone.
+  def sparse_ref(state: StateInfo, const: str = "") -> str:
+    return (f"(({const}{state_cpp_type(state)}*)(&storage[0]+{state.offset}))")
+
+  ignored = ", ".join(
+      f"{{{s.offset}, {s.offset}+sizeof({state_cpp_type(s)})}}" for s in sparse)
+  print("  StateSnapshot snapshot(const StateSnapshot *base = nullptr) const {")
+  print("    StateSnapshot snapshot(&storage[0], storage.size(), "
+        f"{{{ignored}}}, base);")
+  if sparse:
+    print(f"    snapshot.sparsePages.resize({len(sparse)});")
+  for i, state in enumerate(sparse):
+    print(f"    {sparse_ref(state, 'const ')}->snapshot(snapshot.sparsePages[{i}], "
+          f"base ? &base->sparsePages[{i}] : nullptr);")
+  print("    return snapshot;")
+  print("  }")
+  print("  void restore(const StateSnapshot &snapshot) {")
+  print("    snapshot.restore(&storage[0]);")
+  for i, state in enumerate(sparse):
+    print(f"    {sparse_ref(state)}->restore(snapshot.sparsePages[{i}]);")
+  print("  }")
+  print("  std::vector<std::string> diff(const StateSnapshot &snapshot) const {")
+  print(f"    auto names = diffSignals<{model.name}Layout>(snapshot, "
+        f"&storage[0]);")
+  for i, state in enumerate(sparse):
+    name = f"{model.name}.internal.{(state.path or '').replace('/', '.')}"
+    print(f"    if ({sparse_ref(state, 'const ')}->differs("
+          f"snapshot.sparsePages[{i}]))")
+    print(f"      names.push_back(\"{name}\");")
+  print("    return names;")
+  print("  }")
+  print("  static std::vector<std::string> diff(const StateSnapshot &a, "
+        "const StateSnapshot &b) {")
+  print(f"    auto names = diffSignals<{model.name}Layout>(a, b);")
+  for i, state in enumerate(sparse):
+    name = f"{model.name}.internal.{(state.path or '').replace('/', '.')}"
+    print(f"    if (a.sparseMemoryDiffers(b, {i}))")
+    print(f"      names.push_back(\"{name}\");")
+  print("    return names;")
+  print("  }")
   print("};")
 
   # Generate a port name macro.
@@ -1,10 +1,16 @@
 // NOLINTBEGIN
 #pragma once
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <functional>
+#include <memory>
 #include <ostream>
+#include <string>
+#include <thread>
 #include <vector>
 
 struct Signal {
@@ -15,6 +21,25 @@ struct Signal {
   // for memories:
   unsigned stride;
   unsigned depth;
+  // for single-bit states packed into a byte shared with other states, the bit
+  // within the byte at `offset`:
+  int bit = -1;
+
+  /// The bits of the bytes at `offset` that hold the value of the signal.
+  uint8_t getMask() const { return bit < 0 ? 0xff : uint8_t(1) << bit; }
+};
+
+/// A reference to a single-bit state packed into a byte shared with other
+/// states. Assignments only change the bit of this state.
+struct PackedBit {
+  uint8_t &byte;
+  uint8_t mask;
+
+  operator bool() const { return byte & mask; }
+  PackedBit &operator=(bool value) {
+    byte = value ? byte | mask : byte & ~mask;
+    return *this;
+  }
 };
 
 struct Hierarchy {
@@ -37,54 +62,388 @@ struct Memory {
   } words[Depth];
 };
 
+/// A page of a state snapshot. Pages are immutable once taken, which lets
+/// snapshots share the pages that are the same across them.
+using SnapshotPage = std::shared_ptr<const std::vector<uint8_t>>;
+
+/// Take a snapshot page of the `size` bytes at `data`. If the page `base` holds
+/// the same bytes it is shared instead of copying them.
+inline SnapshotPage takeSnapshotPage(const uint8_t *data, size_t size,
+                                     const SnapshotPage *base) {
+  if (base && *base && (*base)->size() == size &&
+      std::memcmp((*base)->data(), data, size) == 0)
+    return *base;
+  return std::make_shared<const std::vector<uint8_t>>(data, data + size);
+}
+
+/// A memory stored as a table of pages of `PageWords` words each. Pages are
+/// allocated by the model on the first write to one of their words; words in
+/// pages that have not been allocated yet read as zero.
+template <typename T, unsigned Stride, unsigned Depth, unsigned PageWords>
+struct SparseMemory {
+  static constexpr unsigned numPages = (Depth + PageWords - 1) / PageWords;
+  union Word {
+    T data;
+    uint8_t stride[Stride];
+  };
+  Word *pages[numPages];
+
+  T read(unsigned address) const {
+    const Word *page = pages[address / PageWords];
+    return page ? page[address % PageWords].data : T{};
+  }
+
+  T &operator[](unsigned address) {
+    Word *&page = pages[address / PageWords];
+    if (!page)
+      page = static_cast<Word *>(calloc(PageWords, Stride));
+    return page[address % PageWords].data;
+  }
+
+  /// Free all allocated pages. The model storage does not own the pages, so
+  /// this has to be called before the storage is discarded.
+  void release() {
+    for (auto *&page : pages) {
+      free(page);
+      page = nullptr;
+    }
+  }
+
+  /// Take a snapshot of the allocated pages, with null for the unallocated
+  /// ones. Pages which did not change since the snapshot `base` are shared
+  /// with it.
+  void snapshot(std::vector<SnapshotPage> &snapshotPages,
+                const std::vector<SnapshotPage> *base = nullptr) const {
+    snapshotPages.resize(numPages);
+    for (unsigned i = 0; i < numPages; ++i)
+      snapshotPages[i] =
+          pages[i] ? takeSnapshotPage(reinterpret_cast<uint8_t *>(pages[i]),
+                                      PageWords * Stride,
+                                      base ? &(*base)[i] : nullptr)
+                   : nullptr;
+  }
+
+  /// Restore the pages of a snapshot, freeing the pages it did not have.
+  void restore(const std::vector<SnapshotPage> &snapshotPages) {
+    for (unsigned i = 0; i < numPages; ++i) {
+      if (!snapshotPages[i]) {
+        free(pages[i]);
+        pages[i] = nullptr;
+        continue;
+      }
+      if (!pages[i])
+        pages[i] = static_cast<Word *>(malloc(PageWords * Stride));
+      std::memcpy(pages[i], snapshotPages[i]->data(), PageWords * Stride);
+    }
+  }
+
+  /// Check whether the memory holds different values than a snapshot of it.
+  bool differs(const std::vector<SnapshotPage> &snapshotPages) const {
+    for (unsigned i = 0; i < numPages; ++i) {
+      if (!pages[i] && !snapshotPages[i])
+        continue;
+      const uint8_t *live = reinterpret_cast<const uint8_t *>(pages[i]);
+      const uint8_t *saved =
+          snapshotPages[i] ? snapshotPages[i]->data() : nullptr;
+      for (unsigned j = 0; j < PageWords * Stride; ++j)
+        if ((live ? live[j] : 0) != (saved ? saved[j] : 0))
+          return true;
+    }
+    return false;
+  }
+};
+
+/// A copy of the state of a model, which the model can be restored to later.
+/// Restoring a snapshot into a new instance of a model forks the simulation.
+///
+/// The state is copied in pages of `pageSize` bytes. A snapshot taken from a
+/// `base` snapshot shares the pages that did not change since then, so that
+/// the snapshots of a campaign branching off the same warmed-up state only
+/// take the memory of the pages they changed. Snapshots also take the pages of
+/// the sparse memories of the model, which are stored outside of it.
+class StateSnapshot {
+public:
+  static constexpr size_t pageSize = 4096;
+
+  StateSnapshot() = default;
+
+  /// Take a snapshot of the `numBytes` of state at `state`. The byte ranges in
+  /// `ignored` are not part of the snapshot and are kept as is on a restore.
+  StateSnapshot(const uint8_t *state, size_t numBytes,
+                std::vector<std::pair<size_t, size_t>> ignored = {},
+                const StateSnapshot *base = nullptr)
+      : numBytes(numBytes), ignored(std::move(ignored)) {
+    if (base && base->numBytes != numBytes)
+      base = nullptr;
+    for (size_t offset = 0, i = 0; offset < numBytes; offset += pageSize, ++i) {
+      size_t size = std::min(pageSize, numBytes - offset);
+      pages.push_back(takeSnapshotPage(state + offset, size,
+                                       base ? &base->pages[i] : nullptr));
+    }
+  }
+
+  /// Copy the snapshot back into `state`.
+  void restore(uint8_t *state) const {
+    size_t begin = 0;
+    for (auto [ignoredBegin, ignoredEnd] : ignored) {
+      copyTo(state, begin, ignoredBegin);
+      begin = ignoredEnd;
+    }
+    copyTo(state, begin, numBytes);
+  }
+
+  /// Return the byte at `offset` of the snapshot, or zero beyond its end.
+  uint8_t getByte(size_t offset) const {
+    if (offset >= numBytes)
+      return 0;
+    return (*pages[offset / pageSize])[offset % pageSize];
+  }
+
+  /// Mark the pages whose bytes differ from those of `state`.
+  void getChangedPages(const uint8_t *state, std::vector<bool> &changed) const {
+    changed.resize(pages.size());
+    for (size_t i = 0; i < pages.size(); ++i)
+      changed[i] = std::memcmp(pages[i]->data(), state + i * pageSize,
+                               pages[i]->size()) != 0;
+  }
+
+  /// Mark the pages whose bytes differ from those of another snapshot. Pages
+  /// shared between the snapshots are not compared at all, and pages only one
+  /// of the snapshots has are always marked.
+  void getChangedPages(const StateSnapshot &other,
+                       std::vector<bool> &changed) const {
+    changed.assign(std::max(pages.size(), other.pages.size()), true);
+    for (size_t i = 0; i < std::min(pages.size(), other.pages.size()); ++i)
+      changed[i] = pages[i] != other.pages[i] && *pages[i] != *other.pages[i];
+  }
+
+  /// Check whether the pages of the sparse memory `index` differ from those in
+  /// another snapshot. Unallocated and missing pages compare as zeros.
+  bool sparseMemoryDiffers(const StateSnapshot &other, size_t index) const {
+    static const std::vector<SnapshotPage> none;
+    const auto &a = index < sparsePages.size() ? sparsePages[index] : none;
+    const auto &b =
+        index < other.sparsePages.size() ? other.sparsePages[index] : none;
+    for (size_t i = 0; i < std::max(a.size(), b.size()); ++i) {
+      const SnapshotPage *pageA = i < a.size() && a[i] ? &a[i] : nullptr;
+      const SnapshotPage *pageB = i < b.size() && b[i] ? &b[i] : nullptr;
+      if (!pageA && !pageB)
+        continue;
+      if (pageA && pageB && *pageA == *pageB)
+        continue;
+      size_t size = std::max(pageA ? (*pageA)->size() : 0,
+                             pageB ? (*pageB)->size() : 0);
+      for (size_t j = 0; j < size; ++j) {
+        uint8_t byteA = pageA && j < (*pageA)->size() ? (**pageA)[j] : 0;
+        uint8_t byteB = pageB && j < (*pageB)->size() ? (**pageB)[j] : 0;
+        if (byteA != byteB)
+          return true;
+      }
+    }
+    return false;
+  }
+
+  /// The number of pages which are shared with another snapshot.
+  size_t getNumSharedPages(const StateSnapshot &other) const {
+    size_t count = 0;
+    for (size_t i = 0; i < std::min(pages.size(), other.pages.size()); ++i)
+      count += pages[i] == other.pages[i];
+    return count;
+  }
+
+  /// The pages of each sparse memory of the model, filled in by the model.
+  std::vector<std::vector<SnapshotPage>> sparsePages;
+
+private:
+  void copyTo(uint8_t *state, size_t begin, size_t end) const {
+    while (begin < end) {
+      size_t page = begin / pageSize, pageOffset = begin % pageSize;
+      size_t size = std::min(end - begin, pageSize - pageOffset);
+      std::memcpy(state + begin, pages[page]->data() + pageOffset, size);
+      begin += size;
+    }
+  }
+
+  size_t numBytes = 0;
+  std::vector<std::pair<size_t, size_t>> ignored;
+  std::vector<SnapshotPage> pages;
+};
+
+/// Return the hierarchical names of the signals of a model whose values differ
+/// between two states. `getA` and `getB` return the byte at an offset of each
+/// state, and `changedPages` marks the snapshot pages in which they differ at
+/// all; signals in other pages are not compared.
+template <class ModelLayout, typename GetA, typename GetB>
+std::vector<std::string> diffSignals(const std::vector<bool> &changedPages,
+                                     GetA getA, GetB getB) {
+  std::vector<std::string> names;
+  auto differs = [&](unsigned offset, unsigned numBytes, uint8_t mask) {
+    if (numBytes == 0)
+      return false;
+    size_t firstPage = offset / StateSnapshot::pageSize;
+    size_t lastPage = (offset + numBytes - 1) / StateSnapshot::pageSize;
+    bool anyChanged = false;
+    for (size_t page = firstPage; page <= lastPage; ++page)
+      anyChanged |= page < changedPages.size() && changedPages[page];
+    if (!anyChanged)
+      return false;
+    for (unsigned i = offset; i < offset + numBytes; ++i)
+      if ((getA(i) ^ getB(i)) & mask)
+        return true;
+    return false;
+  };
+
+  std::string scope = std::string(ModelLayout::name) + ".";
+  auto diffSignal = [&](const Signal &state) {
+    unsigned numBytes = (state.numBits + 7) / 8;
+    if (state.type != Signal::Memory) {
+      if (differs(state.offset, numBytes, state.getMask()))
+        names.push_back(scope + state.name);
+      return;
+    }
+    for (unsigned i = 0; i < state.depth; ++i)
+      if (differs(state.offset + i * state.stride, numBytes, 0xff))
+        names.push_back(scope + state.name + "[" + std::to_string(i) + "]");
+  };
+
+  std::function<void(const Hierarchy &)> diffHierarchy =
+      [&](const Hierarchy &hierarchy) {
+        size_t size = scope.size();
+        scope += hierarchy.name;
+        scope += '.';
+        for (unsigned i = 0; i < hierarchy.numStates; ++i)
+          diffSignal(hierarchy.states[i]);
+        for (unsigned i = 0; i < hierarchy.numChildren; ++i)
+          diffHierarchy(hierarchy.children[i]);
+        scope.resize(size);
+      };
+
+  for (auto &port : ModelLayout::io)
+    diffSignal(port);
+  diffHierarchy(ModelLayout::hierarchy);
+  return names;
+}
+
+/// Return the hierarchical names of the signals of a model whose values differ
+/// between a snapshot and the current state.
+template <class ModelLayout>
+std::vector<std::string> diffSignals(const StateSnapshot &snapshot,
+                                     const uint8_t *state) {
+  std::vector<bool> changedPages;
+  snapshot.getChangedPages(state, changedPages);
+  return diffSignals<ModelLayout>(
+      changedPages, [&](size_t i) { return snapshot.getByte(i); },
+      [&](size_t i) { return state[i]; });
+}
+
+/// Return the hierarchical names of the signals of a model whose values differ
+/// between two snapshots.
+template <class ModelLayout>
+std::vector<std::string> diffSignals(const StateSnapshot &a,
+                                     const StateSnapshot &b) {
+  std::vector<bool> changedPages;
+  a.getChangedPages(b, changedPages);
+  return diffSignals<ModelLayout>(
+      changedPages, [&](size_t i) { return a.getByte(i); },
+      [&](size_t i) { return b.getByte(i); });
+}
+
+/// The encoding of a `ValueChangeDump`.
+///
+/// The binary encoding starts with the magic bytes "ARCTRC" followed by a one
+/// byte format version, then a sequence of records. All integers are stored in
+/// little-endian order:
+///   - 0x01 signal definition: u32 id, u32 number of bits, u32 name length,
+///     hierarchical name bytes. All definitions precede the first time step.
+///   - 0x02 time step: u64 time. All the following changes happen at this
+///     time.
+///   - 0x03 value change: u32 id, followed by the new value bytes.
+enum class TraceEncoding { VCD, Binary };
+
 template <class ModelLayout>
 class ValueChangeDump {
 public:
-  ValueChangeDump(std::basic_ostream<char> &os, const uint8_t *state)
-      : os(os), state(state) {}
+  ValueChangeDump(std::basic_ostream<char> &os, const uint8_t *state,
+                  TraceEncoding encoding = TraceEncoding::VCD)
+      : os(os), state(state), encoding(encoding),
+        previousValues(ModelLayout::numStateBytes, 0) {
+    buffer.reserve(bufferSize);
+  }
+
+  ValueChangeDump(ValueChangeDump &&) = default;
+  ~ValueChangeDump() { flush(); }
 
   void writeHeader(bool withHierarchy = true) {
-    os << "$date\n    October 21, 2015\n$end\n";
-    os << "$version\n    Some cryptic MLIR magic\n$end\n";
-    os << "$timescale 1ns $end\n";
+    if (encoding == TraceEncoding::Binary) {
+      buffer.append("ARCTRC\x01", 7);
+    } else {
+      buffer += "$date\n    October 21, 2015\n$end\n";
+      buffer += "$version\n    Some cryptic MLIR magic\n$end\n";
+      buffer += "$timescale 1ns $end\n";
+    }
+
+    std::string scope;
+    auto enterScope = [&](const char *name) {
+      if (encoding == TraceEncoding::Binary) {
+        scope += name;
+        scope += '.';
+      } else {
+        buffer += "$scope module ";
+        buffer += name;
+        buffer += " $end\n";
+      }
+    };
+    auto leaveScope = [&] {
+      if (encoding == TraceEncoding::Binary) {
+        scope.pop_back();
+        scope.erase(scope.find_last_of('.') + 1);
+      } else {
+        buffer += "$upscope $end\n";
+      }
+    };
+    auto defineSignal = [&](const Signal &state, unsigned offset,
+                            const std::string &index) {
+      auto &signal = allocSignal(state, offset);
+      if (encoding == TraceEncoding::Binary) {
+        std::string name = scope + state.name + index;
+        appendInt<uint8_t>(0x01);
+        appendInt<uint32_t>(signals.size() - 1);
+        appendInt<uint32_t>(state.numBits);
+        appendInt<uint32_t>(name.size());
+        buffer += name;
+        return;
+      }
+      buffer += state.type == Signal::Wire || state.type == Signal::Input ||
+                        state.type == Signal::Output
+                    ? "$var wire "
+                    : "$var reg ";
+      buffer += std::to_string(state.numBits) + " " + signal.abbrev + " ";
+      buffer += state.name + index;
+      if (state.numBits > 1)
+        buffer += " [" + std::to_string(state.numBits - 1) + ":0]";
+      buffer += " $end\n";
+    };
 
-    os << "$scope module " << ModelLayout::name << " $end\n";
+    enterScope(ModelLayout::name);
 
     auto writeSignal = [&](const Signal &state) {
       if (state.type != Signal::Memory) {
-        auto &signal =
-            allocSignal(state, state.offset, (state.numBits + 7) / 8);
-        if (state.type == Signal::Register) {
-          os << "$var reg " << state.numBits << " " << signal.abbrev << " "
-             << state.name;
-        } else {
-          os << "$var wire " << state.numBits << " " << signal.abbrev << " "
-             << state.name;
-        }
-        if (state.numBits > 1)
-          os << " [" << (state.numBits - 1) << ":0]";
-        os << " $end\n";
+        defineSignal(state, state.offset, "");
       } else {
-        for (unsigned i = 0; i < state.depth; ++i) {
-          auto &signal = allocSignal(state, state.offset + i * state.stride,
-                                     (state.numBits + 7) / 8);
-          os << "$var reg " << state.numBits << " " << signal.abbrev << " "
-             << state.name << "[" << i << "]";
-          if (state.numBits > 1)
-            os << " [" << (state.numBits - 1) << ":0]";
-          os << " $end\n";
-        }
+        for (unsigned i = 0; i < state.depth; ++i)
+          defineSignal(state, state.offset + i * state.stride,
+                       "[" + std::to_string(i) + "]");
       }
     };
 
     std::function<void(const Hierarchy &)> writeHierarchy =
         [&](const Hierarchy &hierarchy) {
-          os << "$scope module " << hierarchy.name << " $end\n";
+          enterScope(hierarchy.name);
           for (unsigned i = 0; i < hierarchy.numStates; ++i)
             writeSignal(hierarchy.states[i]);
           for (unsigned i = 0; i < hierarchy.numChildren; ++i)
             writeHierarchy(hierarchy.children[i]);
-          os << "$upscope $end\n";
+          leaveScope();
         };
 
     for (auto &port : ModelLayout::io)
@@ -92,40 +451,78 @@ public:
     if (withHierarchy)
       writeHierarchy(ModelLayout::hierarchy);
 
-    os << "$upscope $end\n";
-    os << "$enddefinitions $end\n";
+    leaveScope();
+    if (encoding == TraceEncoding::VCD)
+      buffer += "$enddefinitions $end\n";
+    buildIndex();
+    flushIfFull();
   }
 
+  /// Write the signals whose value changed since the last call. Instead of
+  /// comparing each signal individually, the state is compared against a copy
+  /// from the last call in blocks of 64 bytes, and unchanged blocks are skipped
+  /// entirely. Only the signals overlapping a changed 64-bit word are looked at
+  /// in detail.
   void writeValues(bool includeUnchanged = false) {
-    for (auto &signal : signals) {
-      const uint8_t *valNew = state + signal.offset;
-      uint8_t *valOld = &previousValues[0] + signal.previousOffset;
-      size_t numBytes = (signal.state.numBits + 7) / 8;
-      bool unchanged = std::equal(valNew, valNew + numBytes, valOld);
-      if (unchanged && !includeUnchanged)
-        continue;
-      if (signal.state.numBits > 1)
-        os << 'b';
-      for (unsigned n = signal.state.numBits; n > 0; --n)
-        os << (valNew[(n - 1) / 8] & (1 << ((n - 1) % 8)) ? '1' : '0');
-      if (signal.state.numBits > 1)
-        os << ' ';
-      os << signal.abbrev << "\n";
-      std::copy(valNew, valNew + numBytes, valOld);
+    if (includeUnchanged) {
+      for (auto idx : order)
+        writeSignalValue(signals[idx]);
+      for (auto [begin, end] : tracedRanges)
+        std::memcpy(&previousValues[begin], state + begin, end - begin);
+      flushIfFull();
+      return;
+    }
+
+    ++generation;
+    for (auto [rangeBegin, rangeEnd] : tracedRanges) {
+      for (size_t block = rangeBegin; block < rangeEnd; block += blockSize) {
+        size_t blockEnd = std::min(block + blockSize, rangeEnd);
+        if (std::memcmp(state + block, &previousValues[block],
+                        blockEnd - block) == 0)
+          continue;
+        for (size_t word = block; word < blockEnd; word += 8) {
+          size_t wordEnd = std::min(word + 8, blockEnd);
+          uint64_t valNew = 0, valOld = 0;
+          std::memcpy(&valNew, state + word, wordEnd - word);
+          std::memcpy(&valOld, &previousValues[word], wordEnd - word);
+          if (valNew != valOld)
+            writeChangedSignals(word, wordEnd);
+        }
+        std::memcpy(&previousValues[block], state + block, blockEnd - block);
+        flushIfFull();
+      }
     }
   }
 
   void writeDumpvars() {
-    os << "$dumpvars\n";
+    if (encoding == TraceEncoding::Binary) {
+      writeTimeRecord();
+    } else {
+      buffer += "$dumpvars\n";
+    }
     writeValues(true);
   }
 
   void writeTimestep(size_t timeIncrement) {
     time += timeIncrement;
-    os << "#" << time << "\n";
+    if (encoding == TraceEncoding::Binary) {
+      writeTimeRecord();
+    } else {
+      buffer += '#';
+      buffer += std::to_string(time);
+      buffer += '\n';
+    }
     writeValues();
   }
 
+  /// Write all buffered output to the output stream.
+  void flush() {
+    if (buffer.empty())
+      return;
+    os.write(buffer.data(), buffer.size());
+    buffer.clear();
+  }
+
   size_t time = 0;
 
 private:
@@ -133,11 +530,16 @@ private:
     std::string abbrev;
     unsigned offset;
     const Signal &state;
-    unsigned previousOffset;
+    unsigned numBytes;
+    unsigned id;
+    /// The last `generation` in which this signal was checked for changes.
+    unsigned generation = 0;
   };
 
-  VcdSignal &allocSignal(const Signal &state, unsigned offset,
-                         unsigned numBytes) {
+  static constexpr size_t bufferSize = 1 << 20;
+  static constexpr size_t blockSize = 64;
+
+  VcdSignal &allocSignal(const Signal &state, unsigned offset) {
     std::string abbrev;
     unsigned rest = signals.size() + 1;
     while (rest != 0) {
@@ -147,16 +549,265 @@ private:
       abbrev += c;
       rest /= 84;
     }
-    signals.push_back(
-        VcdSignal{abbrev, offset, state, unsigned(previousValues.size())});
-    previousValues.resize(previousValues.size() + numBytes);
+    signals.push_back(VcdSignal{abbrev, offset, state,
+                                (state.numBits + 7) / 8,
+                                unsigned(signals.size())});
     return signals.back();
   }
 
+  /// Sort the signals by offset and determine which parts of the state are
+  /// covered by any signal.
+  void buildIndex() {
+    order.resize(signals.size());
+    for (unsigned i = 0; i < signals.size(); ++i)
+      order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](unsigned a, unsigned b) {
+      return signals[a].offset < signals[b].offset;
+    });
+
+    // For each 64-bit word, find the first signal in offset order that may
+    // overlap it. All signals before it end before the word.
+    size_t numWords = (previousValues.size() + 7) / 8;
+    firstSignal.assign(numWords + 1, order.size());
+    size_t maxEnd = 0;
+    size_t word = 0;
+    for (unsigned i = 0; i < order.size(); ++i) {
+      auto &signal = signals[order[i]];
+      maxEnd = std::max<size_t>(maxEnd, signal.offset + signal.numBytes);
+      for (; word < numWords && word * 8 < maxEnd; ++word)
+        firstSignal[word] = i;
+    }
+
+    // Merge the byte ranges of the signals, rounded to whole blocks.
+    tracedRanges.clear();
+    for (auto idx : order) {
+      auto &signal = signals[idx];
+      size_t begin = signal.offset / blockSize * blockSize;
+      size_t end = std::min(
+          (signal.offset + signal.numBytes + blockSize - 1) / blockSize *
+              blockSize,
+          previousValues.size());
+      if (!tracedRanges.empty() && begin <= tracedRanges.back().second)
+        tracedRanges.back().second = std::max(tracedRanges.back().second, end);
+      else
+        tracedRanges.push_back({begin, end});
+    }
+  }
+
+  /// Write the signals overlapping the changed bytes `[begin, end)` whose
+  /// value differs from the last written one.
+  void writeChangedSignals(size_t begin, size_t end) {
+    for (unsigned i = firstSignal[begin / 8];
+         i < order.size() && signals[order[i]].offset < end; ++i) {
+      auto &signal = signals[order[i]];
+      if (signal.offset + signal.numBytes <= begin ||
+          signal.generation == generation)
+        continue;
+      signal.generation = generation;
+      if (signal.state.bit >= 0
+              ? (state[signal.offset] ^ previousValues[signal.offset]) &
+                    signal.state.getMask()
+              : std::memcmp(state + signal.offset,
+                            &previousValues[signal.offset],
+                            signal.numBytes) != 0)
+        writeSignalValue(signal);
+    }
+  }
+
+  void writeSignalValue(const VcdSignal &signal) {
+    const uint8_t *value = state + signal.offset;
+    // Packed bits are written as if they had a byte of their own.
+    uint8_t unpacked;
+    if (signal.state.bit >= 0) {
+      unpacked = (*value >> signal.state.bit) & 1;
+      value = &unpacked;
+    }
+    if (encoding == TraceEncoding::Binary) {
+      appendInt<uint8_t>(0x03);
+      appendInt<uint32_t>(signal.id);
+      buffer.append(reinterpret_cast<const char *>(value), signal.numBytes);
+      return;
+    }
+
+    // Format the value most significant byte first, using a table that maps
+    // each byte to its eight binary digits.
+    const auto &digits = getBinaryDigits();
+    unsigned numBits = signal.state.numBits;
+    if (numBits > 1)
+      buffer += 'b';
+    unsigned topBits = (numBits - 1) % 8 + 1;
+    buffer.append(&digits[value[signal.numBytes - 1]][8 - topBits], topBits);
+    for (unsigned i = signal.numBytes - 1; i > 0; --i)
+      buffer.append(&digits[value[i - 1]][0], 8);
+    if (numBits > 1)
+      buffer += ' ';
+    buffer += signal.abbrev;
+    buffer += '\n';
+  }
+
+  static const std::array<std::array<char, 8>, 256> &getBinaryDigits() {
+    static const auto digits = [] {
+      std::array<std::array<char, 8>, 256> digits;
+      for (unsigned byte = 0; byte < 256; ++byte)
+        for (unsigned bit = 0; bit < 8; ++bit)
+          digits[byte][7 - bit] = (byte >> bit) & 1 ? '1' : '0';
+      return digits;
+    }();
+    return digits;
+  }
+
+  void writeTimeRecord() {
+    appendInt<uint8_t>(0x02);
+    appendInt<uint64_t>(time);
+  }
+
+  template <typename T>
+  void appendInt(T value) {
+    for (unsigned i = 0; i < sizeof(T); ++i)
+      buffer += char((uint64_t(value) >> (8 * i)) & 0xff);
+  }
+
+  void flushIfFull() {
+    if (buffer.size() >= bufferSize)
+      flush();
+  }
+
   std::basic_ostream<char> &os;
   const uint8_t *state;
+  TraceEncoding encoding;
   std::vector<VcdSignal> signals;
+  /// The state as of the last call to `writeValues`.
   std::vector<uint8_t> previousValues;
+  /// The signal indices sorted by offset.
+  std::vector<unsigned> order;
+  /// The position in `order` of the first signal overlapping each word.
+  std::vector<unsigned> firstSignal;
+  /// The byte ranges of the state covered by signals.
+  std::vector<std::pair<size_t, size_t>> tracedRanges;
+  unsigned generation = 0;
+  std::string buffer;
+};
+
+/// A set of worker threads that evaluate the partitions of a model's clock
+/// function concurrently. The calling thread evaluates the first partition
+/// itself, waits for the workers to finish theirs, and then runs the commit
+/// function that makes the new state values visible. Workers spin on a
+/// generation counter between clock ticks, which avoids the latency of waking
+/// up sleeping threads for every cycle.
+class ClockPartitionPool {
+public:
+  using Function = void (*)(void *);
+
+  ClockPartitionPool(std::vector<Function> partitions, Function commit)
+      : partitions(std::move(partitions)), commit(commit) {
+    for (unsigned i = 1; i < this->partitions.size(); ++i)
+      workers.emplace_back([this, i] { work(i); });
+  }
+
+  ~ClockPartitionPool() {
+    stopping.store(true, std::memory_order_relaxed);
+    generation.fetch_add(1, std::memory_order_release);
+    for (auto &worker : workers)
+      worker.join();
+  }
+
+  ClockPartitionPool(const ClockPartitionPool &) = delete;
+  ClockPartitionPool &operator=(const ClockPartitionPool &) = delete;
+
+  void run(void *state) {
+    currentState = state;
+    pending.store(workers.size(), std::memory_order_relaxed);
+    generation.fetch_add(1, std::memory_order_release);
+    partitions[0](state);
+    while (pending.load(std::memory_order_acquire) != 0)
+      std::this_thread::yield();
+    commit(state);
+  }
+
+private:
+  void work(unsigned index) {
+    unsigned seen = 0;
+    while (true) {
+      unsigned current;
+      while ((current = generation.load(std::memory_order_acquire)) == seen)
+        std::this_thread::yield();
+      seen = current;
+      if (stopping.load(std::memory_order_relaxed))
+        return;
+      partitions[index](currentState);
+      pending.fetch_sub(1, std::memory_order_release);
+    }
+  }
+
+  std::vector<Function> partitions;
+  Function commit;
+  std::vector<std::thread> workers;
+  void *currentState = nullptr;
+  std::atomic<unsigned> generation{0};
+  std::atomic<unsigned> pending{0};
+  std::atomic<bool> stopping{false};
+};
+
+/// A scheduler for models with several clocks, which evaluates only the clock
+/// domains with an edge at each point in time. Every domain has a period and
+/// the time of its next edge. A step advances the time to the earliest next
+/// edge, calls the clock functions of all domains with an edge at that time in
+/// the order of the model, and finally the passthrough function.
+class ClockScheduler {
+public:
+  using Function = void (*)(void *);
+
+  struct Domain {
+    const char *name;
+    Function clock;
+    uint64_t period = 1;
+    uint64_t nextEdge = 1;
+  };
+
+  ClockScheduler(std::vector<Domain> domains, Function passthrough)
+      : domains(std::move(domains)), passthrough(passthrough) {}
+
+  /// Set the period of the domain called `name`. Its next edge is `phase`
+  /// after the current time, or one period after it if `phase` is zero.
+  /// Returns false if there is no such domain.
+  bool setPeriod(const std::string &name, uint64_t period, uint64_t phase = 0) {
+    for (auto &domain : domains) {
+      if (name != domain.name)
+        continue;
+      domain.period = std::max<uint64_t>(period, 1);
+      domain.nextEdge = time + (phase ? phase : domain.period);
+      return true;
+    }
+    return false;
+  }
+
+  /// Advance to the next clock edge and evaluate the model at that time.
+  /// Returns the new time.
+  uint64_t step(void *state) {
+    uint64_t next = time + 1;
+    if (!domains.empty()) {
+      next = domains[0].nextEdge;
+      for (auto &domain : domains)
+        next = std::min(next, domain.nextEdge);
+    }
+    time = next;
+    for (auto &domain : domains) {
+      if (domain.nextEdge != time)
+        continue;
+      domain.clock(state);
+      domain.nextEdge += domain.period;
+    }
+    passthrough(state);
+    return time;
+  }
+
+  uint64_t getTime() const { return time; }
+  const std::vector<Domain> &getDomains() const { return domains; }
+
+private:
+  std::vector<Domain> domains;
+  Function passthrough;
+  uint64_t time = 0;
 };
 
 // NOLINTEND
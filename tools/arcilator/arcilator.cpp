@@ -12,6 +12,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "circt/Conversion/CombToArith.h"
+#include "circt/Dialect/Arc/ActivityProfile.h"
 #include "circt/Dialect/Arc/ArcDialect.h"
 #include "circt/Dialect/Arc/ArcInterfaces.h"
 #include "circt/Dialect/Arc/ArcOps.h"
@@ -27,6 +28,8 @@
 #include "mlir/Dialect/LLVMIR/LLVMDialect.h"
 #include "mlir/Dialect/LLVMIR/Transforms/Passes.h"
 #include "mlir/Dialect/SCF/IR/SCF.h"
+#include "mlir/ExecutionEngine/ExecutionEngine.h"
+#include "mlir/ExecutionEngine/OptUtils.h"
 #include "mlir/IR/AsmState.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/OperationSupport.h"
@@ -42,14 +45,23 @@
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
 #include "mlir/Transforms/Passes.h"
 #include "llvm/IR/LLVMContext.h"
+#include "llvm/ADT/ScopeExit.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/IR/Module.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/SHA256.h"
 #include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/TargetSelect.h"
 #include "llvm/Support/ToolOutputFile.h"
 
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <optional>
 
@@ -89,6 +101,12 @@ static cl::opt<std::string> stateFile("state-file", cl::desc("State file"),
                                       cl::value_desc("filename"), cl::init(""),
                                       cl::cat(mainCategory));
 
+static cl::opt<std::string>
+    costProfileFile("cost-profile-file",
+                    cl::desc("Emit the size and cost of the module hierarchy"),
+                    cl::value_desc("filename"), cl::init(""),
+                    cl::cat(mainCategory));
+
 static cl::opt<bool> shouldInline("inline", cl::desc("Inline arcs"),
                                   cl::init(true), cl::cat(mainCategory));
 
@@ -97,6 +115,68 @@ static cl::opt<bool>
                    cl::desc("Optimize arcs into lookup tables"), cl::init(true),
                    cl::cat(mainCategory));
 
+static cl::opt<bool>
+    shouldGateIdleArcs("gate-idle-arcs",
+                       cl::desc("Skip the evaluation of arcs whose inputs did "
+                                "not change since the last clock tick"),
+                       cl::init(false), cl::cat(mainCategory));
+
+static cl::opt<unsigned>
+    numLanes("lanes",
+             cl::desc("Number of model instances to evaluate side by side in "
+                      "a structure-of-arrays state layout"),
+             cl::init(1), cl::cat(mainCategory));
+
+static cl::opt<unsigned> wideVectorThreshold(
+    "wide-vector-threshold",
+    cl::desc("Lower bitwise operations and muxes on integers at least this "
+             "many bits wide to vectors of 64-bit lanes (0 disables)"),
+    cl::init(0), cl::cat(mainCategory));
+
+static cl::opt<unsigned> numClockPartitions(
+    "clock-partitions",
+    cl::desc("Split the clock tree into this many partitions that can be "
+             "evaluated concurrently"),
+    cl::init(1), cl::cat(mainCategory));
+
+static cl::opt<uint64_t> sparseMemoryThreshold(
+    "sparse-memory-threshold",
+    cl::desc("Store memories larger than this many bytes as lazily allocated "
+             "pages (0 disables)"),
+    cl::init(0), cl::cat(mainCategory));
+
+static cl::opt<bool> cacheAwareLayout(
+    "cache-aware-layout",
+    cl::desc("Lay out the model state for cache locality, grouping states by "
+             "the clock tree accessing them and moving rarely used ones out "
+             "of the way"),
+    cl::init(false), cl::cat(mainCategory));
+
+static cl::opt<bool>
+    packBits("pack-bits",
+             cl::desc("Pack single-bit states accessed by the same clock into "
+                      "shared bytes"),
+             cl::init(false), cl::cat(mainCategory));
+
+static cl::opt<bool> coalesceStateWrites(
+    "coalesce-state-writes",
+    cl::desc("Merge writes to adjacent states under the same condition into "
+             "wider writes"),
+    cl::init(false), cl::cat(mainCategory));
+
+static cl::opt<std::string> profileGenerate(
+    "profile-generate",
+    cl::desc("Instrument the model with counters of arc calls and state "
+             "changes; with --run, write the resulting activity profile to "
+             "this file, otherwise the counters are listed in the state file"),
+    cl::value_desc("filename"), cl::init(""), cl::cat(mainCategory));
+
+static cl::opt<std::string> profileUse(
+    "profile-use",
+    cl::desc("Guide inlining, lookup tables, and the cache-aware layout with "
+             "an activity profile written by --profile-generate"),
+    cl::value_desc("filename"), cl::init(""), cl::cat(mainCategory));
+
 static cl::opt<bool> printDebugInfo("print-debug-info",
                                     cl::desc("Print debug information"),
                                     cl::init(false), cl::cat(mainCategory));
@@ -155,13 +235,93 @@ static cl::opt<OutputFormat> outputFormat(
                           "Do not output anything")),
     cl::init(OutputLLVM), cl::cat(mainCategory));
 
+// Options to control in-process execution of the model.
+static cl::opt<bool>
+    runJIT("run",
+           cl::desc("JIT-compile the model and run it in-process instead of "
+                    "emitting output"),
+           cl::init(false), cl::cat(mainCategory));
+
+static cl::opt<std::string> stimulusFile(
+    "stimulus",
+    cl::desc("Stimulus file for --run; either a VCD or binary trace of the "
+             "inputs, or a text file whose lines list `input=value` "
+             "assignments applied before one clock cycle"),
+    cl::value_desc("filename"), cl::init(""), cl::cat(mainCategory));
+
+static cl::opt<std::string> goldenFile(
+    "golden",
+    cl::desc("Golden trace or text file of the outputs to compare against "
+             "after each cycle of --run, stopping at the first mismatch"),
+    cl::value_desc("filename"), cl::init(""), cl::cat(mainCategory));
+
+static cl::opt<std::string> traceClock(
+    "trace-clock",
+    cl::desc("Signal of the --stimulus and --golden traces whose rising edges "
+             "mark the cycles; by default every time step is one cycle"),
+    cl::value_desc("name"), cl::init(""), cl::cat(mainCategory));
+
+static cl::opt<unsigned>
+    runCycles("run-cycles",
+              cl::desc("Number of cycles to run with --run; inputs hold their "
+                       "last stimulus value past the end of the stimulus "
+                       "(defaults to the number of stimulus lines)"),
+              cl::init(0), cl::cat(mainCategory));
+
+static cl::list<std::string> clockPeriods(
+    "clock-period",
+    cl::desc("Period of a clock input of a model with several clocks, as "
+             "`name=period`; each cycle of --run then advances to the next "
+             "clock edge and only evaluates the clocks with an edge. Clocks "
+             "without a period have a period of 1"),
+    cl::value_desc("name=period"), cl::CommaSeparated, cl::cat(mainCategory));
+
+static cl::list<std::string> sharedLibs(
+    "shared-libs",
+    cl::desc("Libraries to load for --run, which provide the foreign "
+             "functions called by interop procedures of the model"),
+    cl::value_desc("filename"), cl::CommaSeparated, cl::cat(mainCategory));
+
+static cl::opt<unsigned>
+    runOptLevel("run-opt-level",
+                cl::desc("LLVM optimization level used to JIT the model"),
+                cl::init(3), cl::cat(mainCategory));
+
+static cl::opt<unsigned> maxOpsPerFunc(
+    "max-ops-per-func",
+    cl::desc("Split clock functions into functions of about this many "
+             "operations to reduce LLVM compile time (0 disables)"),
+    cl::init(0), cl::cat(mainCategory));
+
+static cl::opt<bool> printCompileStats(
+    "print-compile-stats",
+    cl::desc("With --run, print the size of each function and the time taken "
+             "to JIT the model to stderr"),
+    cl::init(false), cl::cat(mainCategory));
+
+static cl::opt<std::string> cacheDir(
+    "cache-dir",
+    cl::desc("Directory in which to cache the LLVM output and state file "
+             "for each input and set of pipeline options"),
+    cl::value_desc("directory"), cl::init(""), cl::cat(mainCategory));
+
 //===----------------------------------------------------------------------===//
 // Main Tool Logic
 //===----------------------------------------------------------------------===//
 
+/// Populate a pass manager with the lowering of allocated models to LLVM.
+static void populateLLVMLoweringPipeline(PassManager &pm) {
+  pm.addPass(arc::createLowerClocksToFuncsPass(maxOpsPerFunc));
+  pm.addPass(createConvertCombToArithPass());
+  pm.addPass(createLowerArcToLLVMPass(numLanes, wideVectorThreshold));
+  pm.addPass(createCSEPass());
+  pm.addPass(arc::createArcCanonicalizerPass());
+}
+
 /// Populate a pass manager with the arc simulator pipeline for the given
-/// command line options.
-static void populatePipeline(PassManager &pm) {
+/// command line options. The final lowering to LLVM is only added if
+/// `lowerToLLVM` is set.
+static void populatePipeline(PassManager &pm, bool lowerToLLVM = true) {
   auto untilReached = [](Until until) {
     return until >= runUntilBefore || until > runUntilAfter;
   };
@@ -174,9 +334,12 @@ static void populatePipeline(PassManager &pm) {
   pm.addPass(
       arc::createAddTapsPass(observePorts, observeWires, observeNamedValues));
   pm.addPass(arc::createStripSVPass());
-  pm.addPass(arc::createInferMemoriesPass());
+  pm.addPass(arc::createLowerInteropPass());
+  pm.addPass(arc::createInferMemoriesPass(sparseMemoryThreshold));
   pm.addPass(createCSEPass());
   pm.addPass(arc::createArcCanonicalizerPass());
+  if (!costProfileFile.empty())
+    pm.addPass(arc::createPrintCostProfilePass(costProfileFile));
 
   // Restructure the input from a `hw.module` hierarchy to a collection of arcs.
   if (untilReached(UntilArcConversion))
@@ -196,7 +359,7 @@ static void populatePipeline(PassManager &pm) {
   pm.addPass(createCSEPass());
   pm.addPass(arc::createArcCanonicalizerPass());
   if (shouldMakeLUTs)
-    pm.addPass(arc::createMakeTablesPass());
+    pm.addPass(arc::createMakeTablesPass(profileUse));
   pm.addPass(createCSEPass());
   pm.addPass(arc::createArcCanonicalizerPass());
 
@@ -223,6 +386,12 @@ static void populatePipeline(PassManager &pm) {
   pm.addPass(arc::createLowerStatePass());
   pm.addPass(createCSEPass());
   pm.addPass(arc::createArcCanonicalizerPass());
+  // Count the arc calls and state changes at the point where the profile is
+  // used, such that the arc and state names match.
+  if (!profileGenerate.empty())
+    pm.addPass(arc::createAddActivityCountersPass());
+  if (shouldGateIdleArcs)
+    pm.addPass(arc::createGateIdleArcsPass());
 
   // TODO: LowerClocksToFuncsPass might not properly consider scf.if operations
   // (or nested regions in general) and thus errors out when muxes are also
@@ -232,7 +401,7 @@ static void populatePipeline(PassManager &pm) {
   // pm.addPass(arc::createMuxToControlFlowPass());
 
   if (shouldInline) {
-    pm.addPass(arc::createInlineArcsPass());
+    pm.addPass(arc::createInlineArcsPass(profileUse));
     pm.addPass(arc::createArcCanonicalizerPass());
     pm.addPass(createCSEPass());
   }
@@ -241,29 +410,856 @@ static void populatePipeline(PassManager &pm) {
   pm.addPass(createCSEPass());
   pm.addPass(arc::createArcCanonicalizerPass());
 
+  if (numClockPartitions > 1) {
+    pm.addPass(arc::createPartitionClocksPass(numClockPartitions));
+    pm.addPass(createCSEPass());
+    pm.addPass(arc::createArcCanonicalizerPass());
+  }
+
   // Allocate states.
   if (untilReached(UntilStateAlloc))
     return;
   pm.addPass(arc::createLegalizeStateUpdatePass());
-  pm.nest<arc::ModelOp>().addPass(arc::createAllocateStatePass());
+  pm.nest<arc::ModelOp>().addPass(
+      arc::createAllocateStatePass(numLanes, cacheAwareLayout, profileUse,
+                                   packBits));
   if (!stateFile.empty())
     pm.addPass(arc::createPrintStateInfoPass(stateFile));
   pm.addPass(createCSEPass());
   pm.addPass(arc::createArcCanonicalizerPass());
+  if (coalesceStateWrites && numLanes == 1)
+    pm.nest<arc::ModelOp>().addPass(arc::createCoalesceStateWritesPass());
 
   // Lower the arcs and update functions to LLVM.
-  if (untilReached(UntilLLVMLowering))
+  if (untilReached(UntilLLVMLowering) || !lowerToLLVM)
     return;
-  pm.addPass(arc::createLowerClocksToFuncsPass());
-  pm.addPass(createConvertCombToArithPass());
-  pm.addPass(createLowerArcToLLVMPass());
-  pm.addPass(createCSEPass());
-  pm.addPass(arc::createArcCanonicalizerPass());
+  populateLLVMLoweringPipeline(pm);
 }
 
+//===----------------------------------------------------------------------===//
+// In-Process Execution
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// A primary input or output of a model and its location in the state.
+struct PortInfo {
+  std::string name;
+  unsigned offset;
+  unsigned stride;
+  unsigned numBits;
+  bool isInput;
+};
+
+/// The layout of a model, captured after state allocation since the model op
+/// itself does not survive the lowering to LLVM. Ports are located at `offset`
+/// for the first instance of the model, and `stride` bytes apart for each
+/// subsequent instance.
+struct ModelLayout {
+  std::string name;
+  uint64_t numStateBytes;
+  SmallVector<PortInfo> ports;
+  /// The activity counters added by `--profile-generate`, as `(name, offset)`
+  /// pairs.
+  SmallVector<std::pair<std::string, unsigned>> counters;
+  /// The page tables of sparse memories, as `(offset, number of pages)` pairs
+  /// covering all lanes. The pages are allocated by the model on first write.
+  SmallVector<std::pair<unsigned, unsigned>> pageTables;
+  /// The clock inputs of the clock trees which are not partitions of another,
+  /// in the order of their clock functions. Empty if a clock tree is not
+  /// clocked by a primary input.
+  SmallVector<std::string> clocks;
+};
+
+/// The input assignments applied before each cycle, as `(port, value)` pairs.
+using Stimulus = SmallVector<SmallVector<std::pair<unsigned, APInt>>>;
+} // namespace
+
+/// Collect the primary inputs and outputs, the activity counters, and the page
+/// tables of sparse memories allocated within `storage`, which lives at
+/// `offset` within the model's state.
+static LogicalResult collectPorts(Value storage, unsigned offset,
+                                  ModelLayout &layout) {
+  for (auto *op : storage.getUsers()) {
+    if (auto substorage = dyn_cast<arc::AllocStorageOp>(op)) {
+      if (!substorage.getOffset().has_value())
+        return substorage.emitOpError("without allocated offset");
+      if (failed(collectPorts(substorage.getOutput(),
+                              *substorage.getOffset() + offset, layout)))
+        return failure();
+      continue;
+    }
+    if (auto allocOp = dyn_cast<arc::AllocStateOp>(op)) {
+      auto name = allocOp->getAttrOfType<StringAttr>("name");
+      if (!name || !(name.getValue().startswith(arc::callCounterPrefix) ||
+                     name.getValue().startswith(arc::toggleCounterPrefix)))
+        continue;
+      auto opOffset = op->getAttrOfType<IntegerAttr>("offset");
+      if (!opOffset)
+        return op->emitOpError("without allocated offset");
+      layout.counters.push_back(
+          {name.getValue().str(),
+           unsigned(opOffset.getValue().getZExtValue() + offset)});
+      continue;
+    }
+    if (auto memOp = dyn_cast<arc::AllocMemoryOp>(op)) {
+      auto memType = memOp.getType();
+      if (!memType.isSparse())
+        continue;
+      auto opOffset = op->getAttrOfType<IntegerAttr>("offset");
+      if (!opOffset)
+        return op->emitOpError("without allocated offset");
+      layout.pageTables.push_back(
+          {unsigned(opOffset.getValue().getZExtValue() + offset),
+           memType.getNumPages() * numLanes});
+      continue;
+    }
+    if (!isa<arc::RootInputOp, arc::RootOutputOp>(op))
+      continue;
+    auto opOffset = op->getAttrOfType<IntegerAttr>("offset");
+    if (!opOffset)
+      return op->emitOpError("without allocated offset");
+    auto &port = layout.ports.emplace_back();
+    port.name = op->getAttrOfType<StringAttr>("name").getValue().str();
+    port.offset = opOffset.getValue().getZExtValue() + offset;
+    auto stateType = op->getResult(0).getType().cast<arc::StateType>();
+    port.stride = stateType.getStride();
+    port.numBits = stateType.getType().getWidth();
+    port.isInput = isa<arc::RootInputOp>(op);
+  }
+  return success();
+}
+
+/// Capture the layout of the single model in `module`.
+static FailureOr<ModelLayout> collectModelLayout(ModuleOp module) {
+  auto modelOps = module.getOps<arc::ModelOp>();
+  if (modelOps.empty()) {
+    module.emitError("--run requires a model to execute");
+    return failure();
+  }
+  if (std::next(modelOps.begin()) != modelOps.end()) {
+    module.emitError("--run supports only a single model");
+    return failure();
+  }
+  auto modelOp = *modelOps.begin();
+
+  ModelLayout layout;
+  auto storageArg = modelOp.getBody().getArgument(0);
+  layout.name = modelOp.getName().str();
+  layout.numStateBytes =
+      storageArg.getType().cast<arc::StorageType>().getSize();
+  if (failed(collectPorts(storageArg, 0, layout)))
+    return failure();
+  for (auto treeOp : modelOp.getBody().getOps<arc::ClockTreeOp>()) {
+    if (treeOp->hasAttr("arc.partition") ||
+        treeOp->hasAttr("arc.partition_commit"))
+      continue;
+    auto name = treeOp.getClockName();
+    layout.clocks.push_back(name ? name.getValue().str() : "");
+  }
+  llvm::sort(layout.ports,
+             [](auto &a, auto &b) { return a.offset < b.offset; });
+  return layout;
+}
+
+/// Parse a text stimulus file into one list of assignments per cycle. Empty
+/// lines and everything after a `#` are ignored. The assignments are to the
+/// inputs of the model, or to its outputs if `inputs` is not set.
+static LogicalResult parseStimulus(StringRef filename, StringRef buffer,
+                                   const ModelLayout &layout, bool inputs,
+                                   Stimulus &cycles) {
+  unsigned lineNumber = 0;
+  SmallVector<StringRef> lines;
+  buffer.split(lines, '\n');
+  for (auto line : lines) {
+    ++lineNumber;
+    line = line.split('#').first.trim();
+    if (line.empty())
+      continue;
+    auto &assignments = cycles.emplace_back();
+    while (!line.empty()) {
+      StringRef token;
+      std::tie(token, line) = line.split(' ');
+      line = line.ltrim();
+      StringRef name, valueStr;
+      std::tie(name, valueStr) = token.split('=');
+      auto *port = llvm::find_if(layout.ports, [&](auto &port) {
+        return port.isInput == inputs && port.name == name;
+      });
+      if (port == layout.ports.end()) {
+        llvm::errs() << filename << ":" << lineNumber << ": unknown "
+                     << (inputs ? "input" : "output") << " `" << name
+                     << "`\n";
+        return failure();
+      }
+      APInt value;
+      if (valueStr.getAsInteger(0, value) ||
+          value.getActiveBits() > port->numBits) {
+        llvm::errs() << filename << ":" << lineNumber
+                     << ": invalid value `" << valueStr << "` for " << name
+                     << " (" << port->numBits << " bits)\n";
+        return failure();
+      }
+      assignments.push_back(
+          {port - layout.ports.begin(), value.zextOrTrunc(port->numBits)});
+    }
+  }
+  return success();
+}
+
+namespace {
+/// A reader of value change traces, either in the VCD format or in the binary
+/// format written by the `ValueChangeDump` of `arcilator-runtime.h`. It maps
+/// the traced signals onto the inputs of a model, or onto its outputs if
+/// `inputs` is not set, and splits their changes into cycles.
+///
+/// Traced signals are matched to ports by name. If several signals in the
+/// hierarchy of the trace have the name of a port, the one closest to the top
+/// is used. A cycle is either every time step of the trace, or the time steps
+/// at which the signal named by `--trace-clock` rises. Inputs are sampled just
+/// before such an edge, and outputs right after it.
+class TraceReader {
+public:
+  TraceReader(StringRef filename, const ModelLayout &layout, bool inputs,
+              Stimulus &cycles)
+      : filename(filename), layout(layout), inputs(inputs), cycles(cycles),
+        portCandidates(layout.ports.size()) {}
+
+  /// Check whether a file is a trace rather than a text stimulus file.
+  static bool isTrace(StringRef filename, StringRef buffer) {
+    return buffer.startswith("ARCTRC") || filename.endswith(".vcd") ||
+           buffer.ltrim().startswith("$");
+  }
+
+  LogicalResult read(StringRef buffer) {
+    if (buffer.startswith("ARCTRC") ? failed(readBinary(buffer))
+                                    : failed(readVCD(buffer)))
+      return failure();
+    if (seenTimeStep || !stepChanges.empty())
+      finishStep();
+    return success();
+  }
+
+private:
+  struct TraceSignal {
+    unsigned numBits;
+    std::optional<unsigned> port;
+    bool isClock = false;
+  };
+
+  LogicalResult readVCD(StringRef buffer);
+  LogicalResult readBinary(StringRef buffer);
+  unsigned defineSignal(ArrayRef<StringRef> scopes, StringRef name,
+                        unsigned numBits);
+  void finishDefinitions();
+  void change(unsigned signal, APInt value);
+  void beginStep();
+  void finishStep();
+  LogicalResult error(const Twine &message) {
+    llvm::errs() << filename << ": " << message << "\n";
+    return failure();
+  }
+
+  StringRef filename;
+  const ModelLayout &layout;
+  bool inputs;
+  Stimulus &cycles;
+
+  SmallVector<TraceSignal> signals;
+  /// The shallowest signal found for each port so far, as `(depth, index)`.
+  SmallVector<std::optional<std::pair<unsigned, unsigned>>> portCandidates;
+  std::optional<std::pair<unsigned, unsigned>> clockCandidate;
+  bool definitionsFinished = false;
+
+  /// The changes of the current time step, and whether the clock rose in it.
+  SmallVector<std::pair<unsigned, APInt>> stepChanges;
+  bool clockRose = false;
+  bool clockValue = false;
+  bool seenTimeStep = false;
+  /// The changes since the last clock edge.
+  SmallVector<std::pair<unsigned, APInt>> pending;
+};
+} // namespace
+
+unsigned TraceReader::defineSignal(ArrayRef<StringRef> scopes, StringRef name,
+                                   unsigned numBits) {
+  unsigned index = signals.size();
+  signals.push_back({numBits, {}});
+  auto consider = [&](std::optional<std::pair<unsigned, unsigned>> &best) {
+    if (!best || best->first > scopes.size())
+      best = {scopes.size(), index};
+  };
+  for (auto [portIndex, port] : llvm::enumerate(layout.ports))
+    if (port.isInput == inputs && port.name == name)
+      consider(portCandidates[portIndex]);
+  if (!traceClock.empty() && name == traceClock)
+    consider(clockCandidate);
+  return index;
+}
+
+/// Settle which signal each port and the clock are mapped onto, once all
+/// signals have been defined.
+void TraceReader::finishDefinitions() {
+  if (definitionsFinished)
+    return;
+  definitionsFinished = true;
+  for (auto [portIndex, candidate] : llvm::enumerate(portCandidates))
+    if (candidate)
+      signals[candidate->second].port = portIndex;
+  if (clockCandidate)
+    signals[clockCandidate->second].isClock = true;
+}
+
+void TraceReader::change(unsigned signal, APInt value) {
+  auto &info = signals[signal];
+  if (info.isClock) {
+    bool newValue = !value.isZero();
+    clockRose |= newValue && !clockValue;
+    clockValue = newValue;
+  }
+  if (info.port) {
+    auto numBits = layout.ports[*info.port].numBits;
+    stepChanges.push_back({*info.port, value.zextOrTrunc(numBits)});
+  }
+}
+
+void TraceReader::beginStep() {
+  finishDefinitions();
+  if (seenTimeStep)
+    finishStep();
+  seenTimeStep = true;
+}
+
+void TraceReader::finishStep() {
+  if (traceClock.empty()) {
+    cycles.push_back(std::move(stepChanges));
+  } else if (clockRose && inputs) {
+    // The changes at the edge itself only take effect in the next cycle.
+    cycles.push_back(std::move(pending));
+    pending = std::move(stepChanges);
+  } else if (clockRose) {
+    pending.append(stepChanges);
+    cycles.push_back(std::move(pending));
+    pending.clear();
+  } else {
+    pending.append(stepChanges);
+  }
+  stepChanges.clear();
+  clockRose = false;
+}
+
+LogicalResult TraceReader::readVCD(StringRef buffer) {
+  auto next = [&] {
+    buffer = buffer.ltrim();
+    auto token = buffer.take_until(llvm::isSpace);
+    buffer = buffer.drop_front(token.size());
+    return token;
+  };
+  auto skipToEnd = [&] {
+    while (!buffer.empty() && next() != "$end")
+      ;
+  };
+
+  SmallVector<StringRef> scopes;
+  StringMap<SmallVector<unsigned, 1>> ids;
+  for (auto token = next(); !token.empty(); token = next()) {
+    if (token == "$scope") {
+      next();
+      scopes.push_back(next());
+      skipToEnd();
+    } else if (token == "$upscope") {
+      if (!scopes.empty())
+        scopes.pop_back();
+      skipToEnd();
+    } else if (token == "$var") {
+      next();
+      unsigned numBits;
+      if (next().getAsInteger(10, numBits))
+        return error("invalid size of $var");
+      auto id = next();
+      auto name = next();
+      skipToEnd();
+      ids[id].push_back(defineSignal(scopes, name, numBits));
+    } else if (token == "$enddefinitions") {
+      skipToEnd();
+      finishDefinitions();
+    } else if (token == "$dumpvars" || token == "$dumpall" ||
+               token == "$dumpon" || token == "$dumpoff" || token == "$end") {
+      // The value changes within these are read like any others.
+    } else if (token.startswith("$")) {
+      skipToEnd();
+    } else if (token.startswith("#")) {
+      beginStep();
+    } else if (token[0] == 'r' || token[0] == 'R') {
+      next();
+    } else {
+      StringRef value, id;
+      if (token[0] == 'b' || token[0] == 'B') {
+        value = token.drop_front();
+        id = next();
+      } else {
+        value = token.take_front();
+        id = token.drop_front();
+      }
+      auto it = ids.find(id);
+      if (it == ids.end())
+        return error("value change of unknown signal `" + id + "`");
+      // Unknown and high-impedance bits are read as zero.
+      std::string bits = value.empty() ? "0" : value.str();
+      for (auto &c : bits)
+        if (c != '0' && c != '1')
+          c = '0';
+      for (auto signal : it->second) {
+        auto numBits = std::max<unsigned>(signals[signal].numBits, 1);
+        change(signal, APInt(std::max<unsigned>(bits.size(), numBits), bits, 2)
+                           .zextOrTrunc(numBits));
+      }
+    }
+  }
+  return success();
+}
+
+LogicalResult TraceReader::readBinary(StringRef buffer) {
+  if (!buffer.consume_front("ARCTRC\x01"))
+    return error("unsupported binary trace version");
+  auto readInt = [&](auto &value) {
+    using IntType = std::remove_reference_t<decltype(value)>;
+    if (buffer.size() < sizeof(value))
+      return false;
+    value = 0;
+    for (unsigned i = 0; i < sizeof(value); ++i)
+      value |= IntType(uint8_t(buffer[i])) << (8 * i);
+    buffer = buffer.drop_front(sizeof(value));
+    return true;
+  };
+
+  SmallVector<StringRef> scopes;
+  while (!buffer.empty()) {
+    uint8_t kind = buffer.front();
+    buffer = buffer.drop_front();
+    if (kind == 0x01) {
+      uint32_t id, numBits, nameLength;
+      if (!readInt(id) || !readInt(numBits) || !readInt(nameLength) ||
+          buffer.size() < nameLength || id != signals.size())
+        return error("invalid signal definition");
+      StringRef name = buffer.take_front(nameLength);
+      buffer = buffer.drop_front(nameLength);
+      scopes.clear();
+      name.split(scopes, '.');
+      name = scopes.pop_back_val();
+      defineSignal(scopes, name, numBits);
+    } else if (kind == 0x02) {
+      uint64_t time;
+      if (!readInt(time))
+        return error("invalid time step");
+      beginStep();
+    } else if (kind == 0x03) {
+      finishDefinitions();
+      uint32_t id;
+      if (!readInt(id) || id >= signals.size())
+        return error("value change of unknown signal");
+      unsigned numBits = signals[id].numBits;
+      // Zero-width signals carry no value bytes and always read as zero.
+      if (numBits == 0) {
+        change(id, APInt(1, 0));
+        continue;
+      }
+      unsigned numBytes = (numBits + 7) / 8;
+      if (buffer.size() < numBytes)
+        return error("truncated value change");
+      SmallVector<uint64_t> words((numBytes + 7) / 8, 0);
+      std::memcpy(words.data(), buffer.data(), numBytes);
+      buffer = buffer.drop_front(numBytes);
+      change(id, APInt(numBits, words));
+    } else {
+      return error("invalid record");
+    }
+  }
+  return success();
+}
+
+/// Read the stimulus or golden file `filename` into one list of assignments
+/// per cycle, to the inputs or outputs of the model respectively.
+static LogicalResult readCycles(StringRef filename, const ModelLayout &layout,
+                                bool inputs, Stimulus &cycles) {
+  std::string errorMessage;
+  auto buffer = openInputFile(filename, &errorMessage);
+  if (!buffer) {
+    llvm::errs() << errorMessage << "\n";
+    return failure();
+  }
+  if (TraceReader::isTrace(filename, buffer->getBuffer()))
+    return TraceReader(filename, layout, inputs, cycles)
+        .read(buffer->getBuffer());
+  return parseStimulus(filename, buffer->getBuffer(), layout, inputs, cycles);
+}
+
+/// JIT-compile the lowered `module` and run the model described by `layout`
+/// on the stimulus given on the command line. Each cycle applies that cycle's
+/// input assignments, calls all of the model's clock functions, or only those
+/// with the next edge if `--clock-period` is given, and finally the
+/// passthrough function. With a golden file, the outputs are then compared
+/// against the golden values of the cycle, and the run stops at the first
+/// mismatch. The final output values are printed to `os` and the achieved
+/// throughput to stderr. If multiple lanes are allocated, all of them receive
+/// the same stimulus and the outputs of the first one are printed and compared.
+static LogicalResult runModel(ModuleOp module, const ModelLayout &layout,
+                              raw_ostream &os) {
+  // Read the stimulus and the golden outputs.
+  Stimulus cycles, golden;
+  if (!stimulusFile.empty() &&
+      failed(readCycles(stimulusFile, layout, /*inputs=*/true, cycles)))
+    return failure();
+  if (!goldenFile.empty() &&
+      failed(readCycles(goldenFile, layout, /*inputs=*/false, golden)))
+    return failure();
+  uint64_t numCycles = runCycles ? runCycles : cycles.size();
+  if (numCycles == 0)
+    numCycles = golden.size();
+  if (numCycles == 0) {
+    llvm::errs() << "--run requires a --stimulus file or --run-cycles\n";
+    return failure();
+  }
+
+  // Parse the clock periods, which are given per clock domain.
+  SmallVector<uint64_t> periods(layout.clocks.size(), 1);
+  for (auto &clockPeriod : clockPeriods) {
+    auto [name, periodStr] = StringRef(clockPeriod).split('=');
+    auto it = llvm::find(layout.clocks, name);
+    uint64_t period;
+    if (periodStr.getAsInteger(0, period) || period == 0) {
+      llvm::errs() << "invalid clock period `" << clockPeriod << "`\n";
+      return failure();
+    }
+    if (name.empty() || it == layout.clocks.end()) {
+      llvm::errs() << "unknown clock `" << name << "` in --clock-period\n";
+      return failure();
+    }
+    periods[it - layout.clocks.begin()] = period;
+  }
+
+  // Find the functions generated for the model's clocks. Clocks beyond the
+  // first one get a uniquified `_clock_<N>` name.
+  std::string clockPrefix = layout.name + "_clock";
+  std::string passthroughName = layout.name + "_passthrough";
+  SmallVector<std::string> clockNames;
+  bool hasPassthrough = false;
+  for (auto funcOp : module.getOps<LLVM::LLVMFuncOp>()) {
+    auto name = funcOp.getSymName();
+    if (name == passthroughName)
+      hasPassthrough = true;
+    else if (name.consume_front(clockPrefix) &&
+             (name.empty() ||
+              (name.consume_front("_") && llvm::all_of(name, llvm::isDigit))))
+      clockNames.push_back(funcOp.getSymName().str());
+  }
+
+  // Report the size of each function, largest first, since the largest
+  // functions tend to dominate the compile time.
+  if (printCompileStats) {
+    SmallVector<std::pair<uint64_t, StringRef>> funcSizes;
+    for (auto funcOp : module.getOps<LLVM::LLVMFuncOp>()) {
+      if (funcOp.isExternal())
+        continue;
+      uint64_t numOps = 0;
+      funcOp.walk([&](Operation *) { ++numOps; });
+      funcSizes.push_back({numOps, funcOp.getSymName()});
+    }
+    llvm::sort(funcSizes, [](auto &a, auto &b) {
+      return a.first > b.first || (a.first == b.first && a.second < b.second);
+    });
+    for (auto &[numOps, name] : funcSizes)
+      llvm::errs() << "function " << name << ": " << numOps << " ops\n";
+  }
+
+  // Create the JIT.
+  auto compileStartTime = std::chrono::steady_clock::now();
+  llvm::InitializeNativeTarget();
+  llvm::InitializeNativeTargetAsmPrinter();
+  mlir::ExecutionEngineOptions options;
+  options.transformer = mlir::makeOptimizingTransformer(
+      runOptLevel, /*sizeLevel=*/0, /*targetMachine=*/nullptr);
+  SmallVector<StringRef> sharedLibPaths(sharedLibs.begin(), sharedLibs.end());
+  options.sharedLibPaths = sharedLibPaths;
+  auto maybeEngine = mlir::ExecutionEngine::create(module, options);
+  if (!maybeEngine) {
+    llvm::errs() << "failed to create JIT: "
+                 << toString(maybeEngine.takeError()) << "\n";
+    return failure();
+  }
+  auto &engine = *maybeEngine;
+
+  using ModelFn = void (*)(void *);
+  auto lookup = [&](StringRef name) -> ModelFn {
+    auto fn = engine->lookup(name);
+    if (!fn) {
+      llvm::errs() << "failed to look up `" << name
+                   << "`: " << toString(fn.takeError()) << "\n";
+      return nullptr;
+    }
+    return reinterpret_cast<ModelFn>(*fn);
+  };
+  SmallVector<ModelFn> clockFns;
+  for (auto &name : clockNames) {
+    clockFns.push_back(lookup(name));
+    if (!clockFns.back())
+      return failure();
+  }
+  ModelFn passthroughFn = nullptr;
+  if (hasPassthrough && !(passthroughFn = lookup(passthroughName)))
+    return failure();
+
+  // With clock periods, each cycle advances to the next edge of any clock and
+  // only calls the functions of the clocks with an edge at that time. The
+  // first edge of each clock is one period in.
+  struct ClockDomain {
+    ModelFn fn;
+    uint64_t period;
+    uint64_t nextEdge;
+  };
+  SmallVector<ClockDomain> domains;
+  if (!clockPeriods.empty()) {
+    for (auto [index, period] : llvm::enumerate(periods)) {
+      auto fn = lookup(arc::getClockFunctionName(layout.name, index));
+      if (!fn)
+        return failure();
+      domains.push_back({fn, period, period});
+    }
+  }
+
+  // The JIT compiles the module when the first function is looked up.
+  if (printCompileStats) {
+    std::chrono::duration<double> compileSeconds =
+        std::chrono::steady_clock::now() - compileStartTime;
+    llvm::errs() << "compiled at -O" << runOptLevel << " in "
+                 << llvm::format("%.6f", compileSeconds.count()) << " s\n";
+  }
+
+  auto readPort = [&](const PortInfo &port, const uint8_t *state) {
+    SmallVector<uint64_t> words((port.numBits + 63) / 64, 0);
+    std::memcpy(words.data(), state + port.offset, (port.numBits + 7) / 8);
+    return APInt(port.numBits, words);
+  };
+
+  // The golden value of each output as of the current cycle, and the outputs
+  // that have one.
+  SmallVector<std::optional<APInt>> expected(layout.ports.size());
+  SmallVector<unsigned> comparedPorts;
+
+  // Run the model on a zero-initialized state.
+  std::vector<uint64_t> storage((layout.numStateBytes + 7) / 8, 0);
+  auto *state = reinterpret_cast<uint8_t *>(storage.data());
+  // Release the pages the model allocated for sparse memories, however the run
+  // ends. They are allocated with `calloc`.
+  auto freePages = llvm::make_scope_exit([&] {
+    for (auto [offset, numPages] : layout.pageTables) {
+      for (unsigned i = 0; i < numPages; ++i) {
+        void *page;
+        std::memcpy(&page, state + offset + i * sizeof(page), sizeof(page));
+        free(page);
+      }
+    }
+  });
+  auto startTime = std::chrono::steady_clock::now();
+  for (uint64_t cycle = 0; cycle < numCycles; ++cycle) {
+    if (cycle < cycles.size()) {
+      for (auto &[portIndex, value] : cycles[cycle]) {
+        auto &port = layout.ports[portIndex];
+        for (unsigned lane = 0; lane < numLanes; ++lane)
+          std::memcpy(state + port.offset + lane * port.stride,
+                      value.getRawData(), (port.numBits + 7) / 8);
+      }
+    }
+    if (domains.empty()) {
+      for (auto fn : clockFns)
+        fn(state);
+    } else {
+      uint64_t time = domains[0].nextEdge;
+      for (auto &domain : domains)
+        time = std::min(time, domain.nextEdge);
+      for (auto &domain : domains) {
+        if (domain.nextEdge != time)
+          continue;
+        domain.fn(state);
+        domain.nextEdge += domain.period;
+      }
+    }
+    if (passthroughFn)
+      passthroughFn(state);
+
+    if (golden.empty())
+      continue;
+    if (cycle < golden.size()) {
+      for (auto &[portIndex, value] : golden[cycle]) {
+        if (!expected[portIndex])
+          comparedPorts.push_back(portIndex);
+        expected[portIndex] = value;
+      }
+    }
+    for (auto portIndex : comparedPorts) {
+      auto &port = layout.ports[portIndex];
+      auto actual = readPort(port, state);
+      if (actual == *expected[portIndex])
+        continue;
+      SmallString<32> actualStr, expectedStr;
+      actual.toStringUnsigned(actualStr, 16);
+      expected[portIndex]->toStringUnsigned(expectedStr, 16);
+      llvm::errs() << goldenFile << ": mismatch in cycle " << cycle << ": `"
+                   << port.name << "` is 0x" << actualStr
+                   << " but the golden value is 0x" << expectedStr << "\n";
+      return failure();
+    }
+  }
+  std::chrono::duration<double> seconds =
+      std::chrono::steady_clock::now() - startTime;
+
+  // Report the final output values.
+  for (auto &port : layout.ports) {
+    if (port.isInput)
+      continue;
+    SmallString<32> str;
+    readPort(port, state).toStringUnsigned(str, 16);
+    os << port.name << " = 0x" << str << "\n";
+  }
+  // Write the activity profile, counted in the first lane.
+  if (!profileGenerate.empty()) {
+    arc::ActivityProfile profile;
+    profile.numCycles = numCycles;
+    for (auto &[name, offset] : layout.counters) {
+      uint64_t count;
+      std::memcpy(&count, state + offset, sizeof(count));
+      profile.addCounter(name, count);
+    }
+    std::string errorMessage;
+    auto profileFile = openOutputFile(profileGenerate, &errorMessage);
+    if (!profileFile) {
+      llvm::errs() << errorMessage << "\n";
+      return failure();
+    }
+    profile.print(profileFile->os());
+    profileFile->keep();
+  }
+
+  llvm::errs() << "ran " << numCycles << " cycles";
+  if (numLanes > 1)
+    llvm::errs() << " x " << numLanes << " lanes";
+  llvm::errs() << " in "
+               << llvm::format("%.6f", seconds.count()) << " s ("
+               << llvm::format("%.0f", numCycles * numLanes / seconds.count())
+               << " cycles/s)\n";
+  return success();
+}
+
+//===----------------------------------------------------------------------===//
+// Compile Cache
+//===----------------------------------------------------------------------===//
+
+/// Compute the key under which the output for an input is cached. This covers
+/// the input itself, the tool version, and all options that affect the
+/// pipeline or the LLVM output.
+static std::string getCacheKey(StringRef input) {
+  std::string options;
+  llvm::raw_string_ostream os(options);
+  os << getCirctVersion() << "\n"
+     << observePorts << observeWires << observeNamedValues << shouldInline
+     << shouldMakeLUTs << shouldGateIdleArcs << printDebugInfo
+     << !stateFile.empty() << "," << numLanes << "," << numClockPartitions
+     << "," << cacheAwareLayout << "," << sparseMemoryThreshold << ","
+     << !profileGenerate.empty() << "," << wideVectorThreshold << ","
+     << maxOpsPerFunc << "," << packBits << "," << coalesceStateWrites
+     << "\n";
+
+  llvm::SHA256 hasher;
+  hasher.update(os.str());
+  hasher.update(input);
+  // The output depends on the contents of the profile, not just its name.
+  if (!profileUse.empty()) {
+    auto profile = llvm::MemoryBuffer::getFile(profileUse);
+    hasher.update(profile ? (*profile)->getBuffer() : "<unreadable profile>");
+  }
+  return llvm::toHex(hasher.final(), /*LowerCase=*/true);
+}
+
+/// Return the path of a file of the cache entry with the given key.
+static std::string getCachePath(StringRef key, StringRef extension) {
+  SmallString<128> path(cacheDir);
+  llvm::sys::path::append(path, key + extension);
+  return std::string(path);
+}
+
+/// Copy the cached output and state file for a key to their destinations.
+/// Fails if there is no complete cache entry for the key.
+static LogicalResult loadFromCache(StringRef key, raw_ostream &os) {
+  auto output = llvm::MemoryBuffer::getFile(getCachePath(key, ".ll"));
+  if (!output)
+    return failure();
+  if (!stateFile.empty()) {
+    auto state = llvm::MemoryBuffer::getFile(getCachePath(key, ".json"));
+    if (!state)
+      return failure();
+    std::string errorMessage;
+    auto stateOutput = openOutputFile(stateFile, &errorMessage);
+    if (!stateOutput) {
+      llvm::errs() << errorMessage << "\n";
+      return failure();
+    }
+    stateOutput->os() << (*state)->getBuffer();
+    stateOutput->keep();
+  }
+  os << (*output)->getBuffer();
+  return success();
+}
+
+/// Store the output and state file for a key in the cache. Every file is
+/// written to a temporary file first and then renamed, such that concurrent
+/// runs never observe partially written entries. The output is renamed last,
+/// since its presence marks a complete entry. Failing to update the cache is
+/// not an error.
+static void storeInCache(StringRef key, StringRef output) {
+  if (auto error = llvm::sys::fs::create_directories(cacheDir)) {
+    llvm::errs() << "warning: cannot create cache directory `" << cacheDir
+                 << "`: " << error.message() << "\n";
+    return;
+  }
+  auto store = [&](StringRef extension, StringRef contents) {
+    auto path = getCachePath(key, extension);
+    auto error = llvm::writeToOutput(path, [&](raw_ostream &os) {
+      os << contents;
+      return llvm::Error::success();
+    });
+    if (!error)
+      return true;
+    llvm::errs() << "warning: cannot write cache file `" << path
+                 << "`: " << toString(std::move(error)) << "\n";
+    return false;
+  };
+  if (!stateFile.empty()) {
+    auto state = llvm::MemoryBuffer::getFile(stateFile);
+    if (!state || !store(".json", (*state)->getBuffer()))
+      return;
+  }
+  store(".ll", output);
+}
+
+//===----------------------------------------------------------------------===//
+// Tool Driver
+//===----------------------------------------------------------------------===//
+
 static LogicalResult
 processBuffer(MLIRContext &context, TimingScope &ts, llvm::SourceMgr &sourceMgr,
               Optional<std::unique_ptr<llvm::ToolOutputFile>> &outputFile) {
+  // Reuse the LLVM output for this input from the cache if possible. Other
+  // outputs are mainly used for debugging and are not cached.
+  std::optional<std::string> cacheKey;
+  if (!cacheDir.empty() && !runJIT && !verifyDiagnostics &&
+      costProfileFile.empty() && outputFormat == OutputLLVM &&
+      runUntilBefore == UntilEnd && runUntilAfter == UntilEnd) {
+    cacheKey = getCacheKey(
+        sourceMgr.getMemoryBuffer(sourceMgr.getMainFileID())->getBuffer());
+    auto cacheTimer = ts.nest("Load cached output");
+    if (succeeded(loadFromCache(*cacheKey, outputFile.value()->os())))
+      return success();
+  }
+
   mlir::OwningOpRef<mlir::ModuleOp> module;
   {
     auto parserTimer = ts.nest("Parse MLIR input");
@@ -277,6 +1273,29 @@ processBuffer(MLIRContext &context, TimingScope &ts, llvm::SourceMgr &sourceMgr,
   pm.enableTiming(ts);
   if (failed(applyPassManagerCLOptions(pm)))
     return failure();
+  // Execute the model in-process if requested. The model's layout has to be
+  // captured before it is lowered to LLVM.
+  if (runJIT) {
+    if (runUntilBefore != UntilEnd || runUntilAfter != UntilEnd) {
+      llvm::errs() << "--run cannot be combined with --until-before or "
+                      "--until-after\n";
+      return failure();
+    }
+    populatePipeline(pm, /*lowerToLLVM=*/false);
+    if (failed(pm.run(module.get())))
+      return failure();
+    auto layout = collectModelLayout(module.get());
+    if (failed(layout))
+      return failure();
+    PassManager llvmPM(&context);
+    llvmPM.enableVerifier(verifyPasses);
+    llvmPM.enableTiming(ts);
+    populateLLVMLoweringPipeline(llvmPM);
+    if (failed(llvmPM.run(module.get())))
+      return failure();
+    auto runTimer = ts.nest("Run model");
+    return runModel(module.get(), *layout, outputFile.value()->os());
+  }
   populatePipeline(pm);
 
   if (printDebugInfo && outputFormat == OutputLLVM)
@@ -305,7 +1324,15 @@ processBuffer(MLIRContext &context, TimingScope &ts, llvm::SourceMgr &sourceMgr,
     auto llvmModule = mlir::translateModuleToLLVMIR(module.get(), llvmContext);
     if (!llvmModule)
       return failure();
-    llvmModule->print(outputFile.value()->os(), nullptr);
+    if (!cacheKey) {
+      llvmModule->print(outputFile.value()->os(), nullptr);
+      return success();
+    }
+    std::string output;
+    llvm::raw_string_ostream os(output);
+    llvmModule->print(os, nullptr);
+    outputFile.value()->os() << os.str();
+    storeInCache(*cacheKey, output);
     return success();
   }
 
@@ -0,0 +1,146 @@
+//===- circt-bmc.cpp - The circt-bmc driver ---------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// This file initiliazes the 'circt-bmc' tool, which interfaces with a logical
+/// engine to check whether the `verif` assertions of a circuit can be violated
+/// within a bounded number of cycles from its reset state, and when so
+/// provides the input trace which violates them.
+///
+//===----------------------------------------------------------------------===//
+
+#include "circt/Dialect/Comb/CombDialect.h"
+#include "circt/Dialect/HW/HWDialect.h"
+#include "circt/Dialect/LTL/LTLDialect.h"
+#include "circt/Dialect/Seq/SeqDialect.h"
+#include "circt/Dialect/Verif/VerifDialect.h"
+#include "circt/LogicalEquivalence/LogicExporter.h"
+#include "circt/LogicalEquivalence/Solver.h"
+#include "circt/LogicalEquivalence/Utility.h"
+#include "circt/Support/Version.h"
+#include "mlir/IR/Diagnostics.h"
+#include "mlir/IR/OwningOpRef.h"
+#include "mlir/Parser/Parser.h"
+#include "mlir/Support/LogicalResult.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/SourceMgr.h"
+
+namespace cl = llvm::cl;
+
+using namespace mlir;
+using namespace circt;
+
+//===----------------------------------------------------------------------===//
+// Command-line options declaration
+//===----------------------------------------------------------------------===//
+
+static cl::OptionCategory mainCategory("circt-bmc Options");
+
+static cl::opt<std::string>
+    moduleName("module", cl::desc("Specify a named module to check"),
+               cl::value_desc("module name"), cl::cat(mainCategory));
+
+static cl::opt<std::string> fileName(cl::Positional, cl::Required,
+                                     cl::desc("<input file>"),
+                                     cl::cat(mainCategory));
+
+static cl::opt<bool>
+    verbose("v", cl::init(false),
+            cl::desc("Print extensive execution progress information"),
+            cl::cat(mainCategory));
+
+static cl::opt<unsigned>
+    bound("bound", cl::init(10),
+          cl::desc("Number of cycles from the reset state to check"),
+          cl::value_desc("cycles"), cl::cat(mainCategory));
+
+static cl::opt<unsigned>
+    timeout("timeout", cl::init(0),
+            cl::desc("Time limit in milliseconds for each check of the logical "
+                     "engine, 0 for no limit"),
+            cl::value_desc("milliseconds"), cl::cat(mainCategory));
+
+static cl::opt<Solver::Backend> backend(
+    "backend", cl::init(Solver::Backend::SMT),
+    cl::desc("Select the logical engine"),
+    cl::values(clEnumValN(Solver::Backend::SMT, "smt",
+                          "SMT solver over the theory of bitvectors"),
+               clEnumValN(Solver::Backend::SAT, "sat",
+                          "SAT solver over the bit-blasted constraints")),
+    cl::cat(mainCategory));
+
+static cl::opt<bool> statistics(
+    "s", cl::init(false),
+    cl::desc("Print statistics about the logical engine's execution"),
+    cl::cat(mainCategory));
+
+//===----------------------------------------------------------------------===//
+// Tool implementation
+//===----------------------------------------------------------------------===//
+
+/// This functions parses the input file, exports the logic of the circuit to
+/// be checked, then checks its properties cycle by cycle.
+static LogicalResult executeBMC(MLIRContext &context) {
+  if (verbose)
+    lec::outs() << "Parsing input file\n";
+  OwningOpRef<ModuleOp> file = parseSourceFile<ModuleOp>(fileName, &context);
+  if (!file)
+    return failure();
+
+  Solver s(&context, statistics, timeout, backend, bound);
+  Solver::Circuit *circuit = s.addCircuit(moduleName);
+  if (verbose)
+    lec::outs() << "Analyzing the circuit\n";
+  LogicExporter exporter(moduleName, circuit);
+  if (failed(exporter.run(file.get())))
+    return failure();
+
+  if (verbose)
+    lec::outs() << "Checking properties\n";
+  return s.checkProperties();
+}
+
+/// The entry point for the `circt-bmc` tool:
+/// configures and parses the command-line options,
+/// registers the supported dialects within a MLIR context,
+/// and calls the `executeBMC` function to do the actual work.
+int main(int argc, char **argv) {
+  // Configure the relevant command-line options.
+  cl::HideUnrelatedOptions(mainCategory);
+  registerMLIRContextCLOptions();
+  cl::AddExtraVersionPrinter(
+      [](llvm::raw_ostream &os) { os << circt::getCirctVersion() << '\n'; });
+
+  // Parse the command-line options provided by the user.
+  cl::ParseCommandLineOptions(
+      argc, argv,
+      "circt-bmc - bounded model checker\n\n"
+      "\tThis tool checks whether the assertions of a circuit description can "
+      "be violated within a bounded number of cycles.\n");
+
+  // Set the bug report message to indicate users should file issues on
+  // llvm/circt and not llvm/llvm-project.
+  llvm::setBugReportMsg(circt::circtBugReportMsg);
+
+  // Register the supported CIRCT dialects and create a context to work with.
+  DialectRegistry registry;
+  registry.insert<circt::comb::CombDialect, circt::hw::HWDialect,
+                  circt::ltl::LTLDialect, circt::seq::SeqDialect,
+                  circt::verif::VerifDialect>();
+  MLIRContext context(registry);
+
+  // Setup of diagnostic handling.
+  llvm::SourceMgr sourceMgr;
+  SourceMgrDiagnosticHandler sourceMgrHandler(sourceMgr, &context);
+  // Avoid printing a superfluous note on diagnostic emission.
+  context.printOpOnDiagnostic(false);
+
+  // Perform the model checking; using `exit` to avoid the slow teardown of
+  // the MLIR context.
+  exit(failed(executeBMC(context)));
+}
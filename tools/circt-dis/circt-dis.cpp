@@ -21,8 +21,10 @@
 #include "mlir/Dialect/LLVMIR/LLVMDialect.h"
 #include "mlir/Dialect/MemRef/IR/MemRef.h"
 #include "mlir/Dialect/SCF/IR/SCF.h"
+#include "mlir/IR/SymbolTable.h"
 #include "mlir/Parser/Parser.h"
 #include "mlir/Support/FileUtilities.h"
+#include "llvm/ADT/StringSet.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/InitLLVM.h"
 #include "llvm/Support/SourceMgr.h"
@@ -47,6 +49,12 @@ static cl::opt<std::string> outputFilename("o",
                                            cl::value_desc("filename"),
                                            cl::cat(mainCategory));
 
+static cl::list<std::string> moduleNames(
+    "module",
+    cl::desc("Only load and print the given modules, skipping the bodies of "
+             "all other modules in the input"),
+    cl::value_desc("name"), cl::cat(mainCategory));
+
 /// Print error and return failure.
 static LogicalResult emitError(const Twine &err) {
   WithColor::error(errs(), toolName) << err << "\n";
@@ -61,6 +69,59 @@ struct LeakModule {
 };
 } // end anonymous namespace
 
+/// Lazily read the input bytecode, only materializing the modules selected on
+/// the command line. The bodies of all other modules are never loaded, and
+/// the modules themselves are dropped, such that memory use scales with the
+/// selected part of the design.
+static OwningOpRef<ModuleOp> readSelectedModules(MLIRContext &context,
+                                                 SourceMgr &srcMgr) {
+  std::string err;
+  auto input = openInputFile(inputFilename, &err);
+  if (!input) {
+    (void)emitError(err);
+    return {};
+  }
+  if (!isBytecode(*input)) {
+    (void)emitError("module selection requires bytecode input");
+    return {};
+  }
+  auto bufferRef = input->getMemBufferRef();
+  srcMgr.AddNewSourceBuffer(std::move(input), SMLoc());
+
+  // Lazily loadable operations which are not symbols, such as the
+  // `firrtl.circuit`, contain the modules and are always materialized. The
+  // operations left unmaterialized once the top level is read are erased when
+  // finalizing the reader.
+  llvm::StringSet<> selected(moduleNames.begin(), moduleNames.end());
+  llvm::StringSet<> found;
+  auto shouldMaterialize = [&](Operation *op) {
+    auto symbol = dyn_cast<SymbolOpInterface>(op);
+    if (!symbol || isa<ModuleOp>(op))
+      return true;
+    if (!selected.contains(symbol.getName()))
+      return false;
+    found.insert(symbol.getName());
+    return true;
+  };
+
+  ParserConfig config(&context);
+  BytecodeReader reader(bufferRef, config, /*lazyLoad=*/true);
+  Block block;
+  if (failed(reader.readTopLevel(&block, shouldMaterialize)) ||
+      failed(reader.finalize([](Operation *) { return false; })))
+    return {};
+
+  for (auto &name : moduleNames) {
+    if (!found.contains(name)) {
+      (void)emitError("module '" + name + "' not found in the input");
+      return {};
+    }
+  }
+
+  return detail::constructContainerOpForParserIfNecessary<ModuleOp>(
+      &block, &context, FileLineColLoc::get(&context, inputFilename, 0, 0));
+}
+
 static LogicalResult execute(MLIRContext &context) {
   // Figure out where we're writing the output.
   if (outputFilename.empty()) {
@@ -84,13 +145,19 @@ static LogicalResult execute(MLIRContext &context) {
   SourceMgrDiagnosticHandler handler(srcMgr, &context);
 
   LeakModule leakMod{
-      parseSourceFile<ModuleOp>(inputFilename, srcMgr, &context)};
+      moduleNames.empty()
+          ? parseSourceFile<ModuleOp>(inputFilename, srcMgr, &context)
+          : readSelectedModules(context, srcMgr)};
   auto &module = leakMod.module;
   if (!module)
     return failure();
 
-  // Write MLIR.
-  module->print(output->os());
+  // Write MLIR. A selection of modules may refer to modules which have been
+  // dropped, so it is printed without verifying it first.
+  OpPrintingFlags flags;
+  if (!moduleNames.empty())
+    flags.assumeVerified();
+  module->print(output->os(), flags);
   output->keep();
 
   return success();
@@ -14,11 +14,13 @@
 
 #include "circt/InitAllDialects.h"
 #include "circt/LogicalEquivalence/LogicExporter.h"
+#include "circt/LogicalEquivalence/Simulator.h"
 #include "circt/LogicalEquivalence/Solver.h"
 #include "circt/LogicalEquivalence/Utility.h"
 #include "circt/Support/Version.h"
 #include "mlir/IR/Diagnostics.h"
 #include "mlir/IR/OwningOpRef.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/Parser/Parser.h"
 #include "mlir/Support/LogicalResult.h"
 #include "llvm/Support/CommandLine.h"
@@ -58,6 +60,50 @@ static cl::opt<bool>
             cl::desc("Print extensive execution progress information"),
             cl::cat(mainCategory));
 
+static cl::opt<bool>
+    parallel("parallel", cl::init(false),
+             cl::desc("Check the fan-in cone of each output with its own "
+                      "logical engine, in parallel"),
+             cl::cat(mainCategory));
+
+static cl::opt<unsigned>
+    timeout("timeout", cl::init(0),
+            cl::desc("Time limit in milliseconds for each check of the logical "
+                     "engine, 0 for no limit"),
+            cl::value_desc("milliseconds"), cl::cat(mainCategory));
+
+static cl::opt<Solver::Backend> backend(
+    "backend", cl::init(Solver::Backend::SMT),
+    cl::desc("Select the logical engine"),
+    cl::values(clEnumValN(Solver::Backend::SMT, "smt",
+                          "SMT solver over the theory of bitvectors"),
+               clEnumValN(Solver::Backend::SAT, "sat",
+                          "SAT solver over the bit-blasted constraints")),
+    cl::cat(mainCategory));
+
+static cl::opt<unsigned> bound(
+    "bound", cl::init(0),
+    cl::desc("Number of cycles to unroll sequential circuits whose registers "
+             "don't all match by name, 0 to reject them"),
+    cl::value_desc("cycles"), cl::cat(mainCategory));
+
+static cl::opt<uint64_t> simVectors(
+    "sim-vectors", cl::init(0),
+    cl::desc("Simulate combinational circuits on the given number of random "
+             "input vectors before invoking the logical engine, 0 to disable"),
+    cl::value_desc("vectors"), cl::cat(mainCategory));
+
+static cl::opt<unsigned> simExhaustiveBits(
+    "sim-exhaustive-bits", cl::init(16),
+    cl::desc("Simulate circuits with at most the given number of input bits "
+             "on all input vectors instead, proving their equivalence"),
+    cl::value_desc("bits"), cl::cat(mainCategory));
+
+static cl::opt<uint64_t>
+    simSeed("sim-seed", cl::init(0),
+            cl::desc("Seed of the random input vectors of the simulation"),
+            cl::cat(mainCategory));
+
 // The following options are stored externally for their value to be accessible
 // to other components of the tool.
 bool statisticsOpt;
@@ -70,6 +116,108 @@ static cl::opt<bool, true> statistics(
 // Tool implementation
 //===----------------------------------------------------------------------===//
 
+/// Evaluate the compiled circuits on input vectors, which is much cheaper than
+/// a proof and finds most counterexamples. Returns the result to report when
+/// the simulation finds a mismatch or covers all input vectors, and nothing
+/// when the logical engine still has to decide.
+static std::optional<LogicalResult> executeSimulation(ModuleOp m1,
+                                                      ModuleOp m2) {
+  hw::HWModuleOp top1 = LogicExporter::lookupModule(m1, moduleName1);
+  hw::HWModuleOp top2 = LogicExporter::lookupModule(m2, moduleName2);
+  if (!top1 || !top2)
+    return failure();
+  auto sim = Simulator::create(top1, top2);
+  if (!sim) {
+    if (verbose)
+      lec::outs() << "Circuits not supported by the simulation\n";
+    return std::nullopt;
+  }
+
+  if (verbose)
+    lec::outs() << "Simulating circuits\n";
+  auto result = sim->run(simVectors, simExhaustiveBits, simSeed);
+  if (verbose)
+    lec::outs() << "Simulated " << sim->getNumVectors() << " input vectors\n";
+  switch (result) {
+  case Simulator::Result::Mismatch:
+    lec::outs() << "c1 != c2\n";
+    sim->printMismatch(lec::outs());
+    return failure();
+  case Simulator::Result::Equivalent:
+    lec::outs() << "c1 == c2\n";
+    return success();
+  case Simulator::Result::Inconclusive:
+    return std::nullopt;
+  }
+  llvm_unreachable("unknown simulation result");
+}
+
+/// Check the fan-in cones of the outputs of the two circuits for equivalence
+/// independently, each with its own logical engine, and report the first
+/// counterexample found.
+static LogicalResult executeParallelLEC(MLIRContext &context, ModuleOp m1,
+                                        ModuleOp m2) {
+  hw::HWModuleOp top1 = LogicExporter::lookupModule(m1, moduleName1);
+  hw::HWModuleOp top2 = LogicExporter::lookupModule(m2, moduleName2);
+  if (!top1 || !top2)
+    return failure();
+  size_t numOutputs = top1.getNumResults();
+  if (numOutputs != top2.getNumResults()) {
+    lec::errs() << "circt-lec error: different output arity\n";
+    return failure();
+  }
+
+  // The solvers of the cones are only kept around when their result is to be
+  // reported, as each of them holds its own logical engine.
+  SmallVector<std::unique_ptr<Solver>> solvers(numOutputs);
+  SmallVector<z3::check_result> results(numOutputs, z3::unsat);
+  if (verbose)
+    lec::outs() << "Solving the cones of " << numOutputs << " outputs\n";
+  auto checkCone = [&](size_t i) -> LogicalResult {
+    // Keep the output of each cone together.
+    lec::BufferedOutput bufferedOutput;
+    auto s = std::make_unique<Solver>(&context, statisticsOpt, timeout,
+                                      backend, bound);
+    Solver::Circuit *c1 = s->addCircuit(moduleName1);
+    Solver::Circuit *c2 = s->addCircuit(moduleName2);
+    LogicExporter exporter1(moduleName1, c1);
+    exporter1.setOutputCone(i);
+    if (failed(exporter1.run(m1)))
+      return failure();
+    LogicExporter exporter2(moduleName2, c2);
+    exporter2.setOutputCone(i);
+    if (failed(exporter2.run(m2)))
+      return failure();
+    auto result = s->check();
+    if (failed(result))
+      return failure();
+    results[i] = *result;
+    if (*result != z3::unsat || statisticsOpt)
+      solvers[i] = std::move(s);
+    return success();
+  };
+  if (failed(failableParallelForEachN(&context, 0, numOutputs, checkCone)))
+    return failure();
+
+  // Report a counterexample over an undecided cone, and a timeout over a
+  // proof of equivalence.
+  for (auto reported : {z3::sat, z3::unknown}) {
+    for (size_t i = 0; i < numOutputs; ++i) {
+      if (results[i] != reported)
+        continue;
+      if (verbose)
+        lec::outs() << "Reporting the cone of output #" << i + 1 << "\n";
+      return solvers[i]->report(reported);
+    }
+  }
+  if (numOutputs == 0 || !statisticsOpt) {
+    lec::outs() << "c1 == c2\n";
+    return success();
+  }
+  // Summarize the statistics through the cone of the last output.
+  return solvers.back()->report(z3::unsat);
+}
+
 /// This functions initializes the various components of the tool and
 /// orchestrates the work to be done. It first parses the input files, then it
 /// traverses their IR to export the logical constraints from the given circuit
@@ -93,8 +241,18 @@ static LogicalResult executeLEC(MLIRContext &context) {
   } else if (verbose)
     lec::outs() << "Second input file not specified\n";
 
+  // In case a second input file was not specified, the first input file will
+  // be used instead.
+  ModuleOp m = file1.get();
+  ModuleOp m2 = fileName2.empty() ? m : file2.get();
+  if (simVectors > 0)
+    if (auto result = executeSimulation(m, m2))
+      return *result;
+  if (parallel)
+    return executeParallelLEC(context, m, m2);
+
   // Initiliaze the constraints solver and the circuits to be compared.
-  Solver s(&context, statisticsOpt);
+  Solver s(&context, statisticsOpt, timeout, backend, bound);
   Solver::Circuit *c1 = s.addCircuit(moduleName1);
   Solver::Circuit *c2 = s.addCircuit(moduleName2);
 
@@ -103,7 +261,6 @@ static LogicalResult executeLEC(MLIRContext &context) {
   if (verbose)
     lec::outs() << "Analyzing the first circuit\n";
   auto exporter = std::make_unique<LogicExporter>(moduleName1, c1);
-  ModuleOp m = file1.get();
   if (failed(exporter->run(m)))
     return failure();
 
@@ -111,9 +268,6 @@ static LogicalResult executeLEC(MLIRContext &context) {
   if (verbose)
     lec::outs() << "Analyzing the second circuit\n";
   auto exporter2 = std::make_unique<LogicExporter>(moduleName2, c2);
-  // In case a second input file was not specified, the first input file will
-  // be used instead.
-  ModuleOp m2 = fileName2.empty() ? m : file2.get();
   if (failed(exporter2->run(m2)))
     return failure();
 
@@ -148,7 +302,8 @@ int main(int argc, char **argv) {
 
   // Register the supported CIRCT dialects and create a context to work with.
   DialectRegistry registry;
-  registry.insert<circt::comb::CombDialect, circt::hw::HWDialect>();
+  registry.insert<circt::comb::CombDialect, circt::hw::HWDialect,
+                  circt::seq::SeqDialect>();
   MLIRContext context(registry);
 
   // Setup of diagnostic handling.
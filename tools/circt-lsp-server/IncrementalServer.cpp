@@ -0,0 +1,659 @@
+//===- IncrementalServer.cpp - Incremental CIRCT language server ----------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// The upstream MLIR language server parses and verifies the entire document
+// on every edit, which does not scale to the multi-hundred megabyte dumps of
+// large designs. This server instead indexes the `hw` and `firrtl` modules of
+// a document with a lightweight scan of its text, never parsing the document
+// as a whole:
+//
+// - An edit within a module only rescans and reparses that module.
+// - A module is only parsed and verified once it is edited or viewed, which
+//   is when a hover request is made within it.
+// - The document outline is served from the index without any parsing.
+//
+// Modules are verified without their surroundings, so checks spanning
+// several modules, like the ports of instances, are not performed, and the
+// text outside of modules is not diagnosed.
+//
+//===----------------------------------------------------------------------===//
+
+#include "IncrementalServer.h"
+#include "mlir/IR/Diagnostics.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/Verifier.h"
+#include "mlir/Parser/Parser.h"
+#include "mlir/Tools/lsp-server-support/Logging.h"
+#include "mlir/Tools/lsp-server-support/Protocol.h"
+#include "mlir/Tools/lsp-server-support/Transport.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Program.h"
+
+using namespace mlir;
+
+namespace cl = llvm::cl;
+
+//===----------------------------------------------------------------------===//
+// Module Index
+//===----------------------------------------------------------------------===//
+
+namespace {
+
+/// A module of a document, which is parsed and verified on its own.
+struct ModuleChunk {
+  /// The symbol name of the module.
+  std::string name;
+  /// The range of the module's text in the document.
+  size_t begin = 0, end = 0;
+  /// The zero-based line and column the module starts at, and the line it
+  /// ends on.
+  unsigned line = 0, column = 0, endLine = 0;
+  /// The bracket nesting depth the module is at.
+  unsigned depth = 0;
+  /// A hash of the module's text, telling whether it changed on a reindex.
+  llvm::hash_code hash = 0;
+  /// Whether the module was edited and has to be checked again.
+  bool edited = false;
+  /// Whether the diagnostics of the module are up to date with its text.
+  bool checked = false;
+  /// The diagnostics of the module, with line numbers relative to its start.
+  std::vector<lsp::Diagnostic> diagnostics;
+};
+
+} // namespace
+
+/// The operations which start the modules of a document.
+static constexpr llvm::StringLiteral moduleKeywords[] = {
+    "hw.module ",       "hw.module.extern ", "hw.module.generated ",
+    "firrtl.module ",   "firrtl.extmodule ", "firrtl.intmodule ",
+    "firrtl.memmodule "};
+
+/// Return the symbol name on the first line of a module, or an empty string if
+/// there is none.
+static StringRef getModuleName(StringRef line) {
+  auto at = line.find('@');
+  if (at == StringRef::npos)
+    return {};
+  auto name = line.drop_front(at + 1);
+  if (name.startswith("\""))
+    return name.drop_front().take_until([](char c) { return c == '"'; });
+  return name.take_while([](char c) {
+    return llvm::isAlnum(c) || StringRef("_$.-").contains(c);
+  });
+}
+
+/// Scan the text of a document for modules, starting at the beginning of the
+/// line at `pos`, which is line `line` at bracket nesting depth `depth`. A
+/// module ends at the next line starting at its own depth, or at the bracket
+/// closing the operation it is nested in. If `single` is set, the scan stops
+/// after the module starting at `pos`. The alias definitions at the top level
+/// of the document are appended to `aliases` if it is given.
+///
+/// This only tracks brackets, string literals, and comments, which is enough
+/// to find the boundaries of the modules in the custom assembly format.
+static void scanModules(StringRef text, size_t pos, unsigned line,
+                        unsigned depth, bool single,
+                        std::vector<ModuleChunk> &chunks,
+                        std::string *aliases) {
+  std::optional<unsigned> moduleDepth;
+  auto closeModule = [&](size_t end, unsigned endLine) {
+    auto &chunk = chunks.back();
+    chunk.end = end;
+    chunk.endLine = endLine;
+    chunk.hash = llvm::hash_value(text.slice(chunk.begin, end));
+    moduleDepth.reset();
+  };
+
+  for (; pos < text.size(); ++line) {
+    size_t lineEnd = std::min(text.find('\n', pos), text.size());
+    auto lineText = text.slice(pos, lineEnd);
+    size_t indent = lineText.find_first_not_of(" \t\r");
+    if (indent == StringRef::npos) {
+      pos = lineEnd + 1;
+      continue;
+    }
+
+    // A line at the depth of the current module starts the op after it,
+    // unless the line closes the brackets the module is nested in.
+    auto stmt = lineText.drop_front(indent);
+    if (moduleDepth && depth == *moduleDepth &&
+        !StringRef(")]}").contains(stmt.front())) {
+      closeModule(pos, line);
+      if (single)
+        return;
+    }
+    if (!moduleDepth) {
+      StringRef name;
+      if (llvm::any_of(moduleKeywords,
+                       [&](StringRef kw) { return stmt.startswith(kw); }))
+        name = getModuleName(stmt);
+      if (!name.empty()) {
+        ModuleChunk chunk;
+        chunk.name = name.str();
+        chunk.begin = pos + indent;
+        chunk.line = line;
+        chunk.column = indent;
+        chunk.depth = depth;
+        chunks.push_back(std::move(chunk));
+        moduleDepth = depth;
+      } else if (single) {
+        return;
+      } else if (aliases && depth == 0 &&
+                 (stmt.front() == '!' || stmt.front() == '#')) {
+        *aliases += stmt;
+        *aliases += '\n';
+      }
+    }
+
+    bool inString = false;
+    for (size_t i = pos + indent; i < lineEnd; ++i) {
+      char c = text[i];
+      if (inString) {
+        if (c == '\\')
+          ++i;
+        else if (c == '"')
+          inString = false;
+        continue;
+      }
+      if (c == '"') {
+        inString = true;
+      } else if (c == '/' && i + 1 < lineEnd && text[i + 1] == '/') {
+        break;
+      } else if (c == '(' || c == '[' || c == '{') {
+        ++depth;
+      } else if (c == ')' || c == ']' || c == '}') {
+        if (depth > 0)
+          --depth;
+        if (moduleDepth && depth < *moduleDepth) {
+          closeModule(i, line);
+          if (single)
+            return;
+        }
+      }
+    }
+    pos = lineEnd + 1;
+  }
+  if (moduleDepth)
+    closeModule(text.size(), line);
+}
+
+//===----------------------------------------------------------------------===//
+// Document
+//===----------------------------------------------------------------------===//
+
+namespace {
+
+/// An open document, and the index of its modules.
+class Document {
+public:
+  Document(MLIRContext &context, const lsp::URIForFile &uri, StringRef text,
+           int64_t version)
+      : context(context), uri(uri), contents(text.str()), version(version) {
+    reindex();
+  }
+
+  /// Apply the edits of a change notification, and check the modules they
+  /// touch.
+  LogicalResult update(ArrayRef<lsp::TextDocumentContentChangeEvent> changes,
+                       int64_t newVersion);
+
+  /// Check the module containing `pos` if it has not been checked yet, and
+  /// return it. `checkedNow` tells whether the module was checked by this.
+  ModuleChunk *view(const lsp::Position &pos, bool &checkedNow);
+
+  void getDiagnostics(std::vector<lsp::Diagnostic> &diagnostics) const;
+  void getSymbols(std::vector<lsp::DocumentSymbol> &symbols) const;
+
+  const lsp::URIForFile &getURI() const { return uri; }
+  int64_t getVersion() const { return version; }
+
+private:
+  void reindex();
+  LogicalResult rescan(size_t index, ptrdiff_t delta);
+  ModuleChunk *findLastModuleBefore(unsigned line);
+  ModuleChunk *findModule(const lsp::Range &range);
+  void check(ModuleChunk &chunk);
+  lsp::Diagnostic convertDiagnostic(Diagnostic &diag,
+                                    const ModuleChunk &chunk) const;
+
+  MLIRContext &context;
+  lsp::URIForFile uri;
+  std::string contents;
+  int64_t version;
+
+  /// The modules of the document, in order.
+  std::vector<ModuleChunk> modules;
+  /// The alias definitions at the top level of the document, which every
+  /// module is parsed with.
+  std::string aliases;
+  unsigned numAliasLines = 0;
+};
+
+} // namespace
+
+/// Index the modules of the entire document. The diagnostics of the modules
+/// whose text is unchanged are kept.
+void Document::reindex() {
+  std::vector<ModuleChunk> newModules;
+  std::string newAliases;
+  scanModules(contents, 0, 0, 0, /*single=*/false, newModules, &newAliases);
+
+  // Modules are parsed with the aliases, so a change of them changes every
+  // module.
+  if (newAliases == aliases) {
+    llvm::StringMap<ModuleChunk *> oldModules;
+    for (auto &chunk : modules)
+      oldModules[chunk.name] = &chunk;
+    for (auto &chunk : newModules) {
+      auto *old = oldModules.lookup(chunk.name);
+      if (!old || old->hash != chunk.hash) {
+        chunk.edited = !modules.empty();
+        continue;
+      }
+      chunk.edited = old->edited;
+      chunk.checked = old->checked;
+      chunk.diagnostics = std::move(old->diagnostics);
+    }
+  }
+  modules = std::move(newModules);
+  aliases = std::move(newAliases);
+  numAliasLines = llvm::count(aliases, '\n');
+}
+
+/// Rescan the module at `index` after an edit within it, which changed the
+/// size of the document by `delta`, and shift the modules after it. Fails if
+/// the edit moved the boundaries of the module.
+LogicalResult Document::rescan(size_t index, ptrdiff_t delta) {
+  auto &chunk = modules[index];
+  std::vector<ModuleChunk> rescanned;
+  scanModules(contents, chunk.begin - chunk.column, chunk.line, chunk.depth,
+              /*single=*/true, rescanned, nullptr);
+  if (rescanned.size() != 1 || rescanned[0].end != chunk.end + delta)
+    return failure();
+
+  int lineDelta = int(rescanned[0].endLine) - int(chunk.endLine);
+  chunk = std::move(rescanned[0]);
+  chunk.edited = true;
+  for (auto &later : llvm::drop_begin(modules, index + 1)) {
+    later.begin += delta;
+    later.end += delta;
+    later.line += lineDelta;
+    later.endLine += lineDelta;
+  }
+  return success();
+}
+
+/// Return the last module starting at or before `line`, or null if there is
+/// none.
+ModuleChunk *Document::findLastModuleBefore(unsigned line) {
+  auto it = llvm::upper_bound(modules, line,
+                              [](unsigned line, const ModuleChunk &chunk) {
+                                return line < chunk.line;
+                              });
+  return it == modules.begin() ? nullptr : &*std::prev(it);
+}
+
+/// Return the module whose text strictly contains `range`, or null if there is
+/// none.
+ModuleChunk *Document::findModule(const lsp::Range &range) {
+  auto *chunk = findLastModuleBefore(range.start.line);
+  if (!chunk || range.end.line >= int(chunk->endLine))
+    return nullptr;
+  if (range.start.line == int(chunk->line) &&
+      range.start.character <= int(chunk->column))
+    return nullptr;
+  return chunk;
+}
+
+LogicalResult
+Document::update(ArrayRef<lsp::TextDocumentContentChangeEvent> changes,
+                 int64_t newVersion) {
+  version = newVersion;
+  for (auto &change : changes) {
+    // Find the module of the edit before the edit moves the text around.
+    ModuleChunk *chunk = change.range ? findModule(*change.range) : nullptr;
+    size_t oldSize = contents.size();
+    if (failed(change.applyTo(contents)))
+      return failure();
+    ptrdiff_t delta = ptrdiff_t(contents.size()) - ptrdiff_t(oldSize);
+    if (!chunk || failed(rescan(chunk - modules.data(), delta)))
+      reindex();
+  }
+
+  for (auto &chunk : modules)
+    if (chunk.edited)
+      check(chunk);
+  return success();
+}
+
+ModuleChunk *Document::view(const lsp::Position &pos, bool &checkedNow) {
+  checkedNow = false;
+  auto *chunk = findLastModuleBefore(pos.line);
+  if (!chunk || pos.line > int(chunk->endLine))
+    return nullptr;
+  if (!chunk->checked) {
+    check(*chunk);
+    checkedNow = true;
+  }
+  return chunk;
+}
+
+/// Parse and verify the text of a module on its own, recording its
+/// diagnostics.
+void Document::check(ModuleChunk &chunk) {
+  chunk.diagnostics.clear();
+  chunk.edited = false;
+  chunk.checked = true;
+
+  std::string buffer = aliases;
+  buffer += StringRef(contents).slice(chunk.begin, chunk.end);
+  ScopedDiagnosticHandler handler(&context, [&](Diagnostic &diag) {
+    chunk.diagnostics.push_back(convertDiagnostic(diag, chunk));
+    return success();
+  });
+
+  // The module itself is not verified since it is parsed without its parent,
+  // like the circuit of a FIRRTL module, which its verifier may require.
+  Block block;
+  ParserConfig config(&context, /*verifyAfterParse=*/false);
+  if (failed(parseSourceString(buffer, &block, config, uri.file())))
+    return;
+  for (auto &module : block)
+    for (auto &region : module.getRegions())
+      for (auto &op : region.getOps())
+        (void)mlir::verify(&op);
+}
+
+/// Convert a diagnostic emitted while checking a module. Locations outside of
+/// the parsed text, like those of the original source of a design, are
+/// reported on the first line of the module.
+lsp::Diagnostic Document::convertDiagnostic(Diagnostic &diag,
+                                            const ModuleChunk &chunk) const {
+  lsp::Diagnostic result;
+  result.source = "circt";
+  result.message = diag.str();
+  switch (diag.getSeverity()) {
+  case DiagnosticSeverity::Error:
+    result.severity = lsp::DiagnosticSeverity::Error;
+    break;
+  case DiagnosticSeverity::Warning:
+    result.severity = lsp::DiagnosticSeverity::Warning;
+    break;
+  case DiagnosticSeverity::Note:
+  case DiagnosticSeverity::Remark:
+    result.severity = lsp::DiagnosticSeverity::Information;
+    break;
+  }
+
+  std::optional<FileLineColLoc> fileLoc;
+  diag.getLocation()->walk([&](Location loc) {
+    if (auto nested = loc.dyn_cast<FileLineColLoc>()) {
+      fileLoc = nested;
+      return WalkResult::interrupt();
+    }
+    return WalkResult::advance();
+  });
+
+  unsigned line = 0, column = chunk.column;
+  if (fileLoc && fileLoc->getFilename().getValue() == uri.file() &&
+      fileLoc->getLine() > numAliasLines) {
+    line = fileLoc->getLine() - 1 - numAliasLines;
+    column = fileLoc->getColumn() ? fileLoc->getColumn() - 1 : 0;
+    if (line == 0)
+      column += chunk.column;
+  } else if (fileLoc) {
+    llvm::raw_string_ostream os(result.message);
+    os << " (at " << *fileLoc << ")";
+  }
+  lsp::Position pos(line, column);
+  result.range = lsp::Range(pos, pos);
+  return result;
+}
+
+void Document::getDiagnostics(
+    std::vector<lsp::Diagnostic> &diagnostics) const {
+  for (auto &chunk : modules) {
+    for (auto diag : chunk.diagnostics) {
+      diag.range.start.line += chunk.line;
+      diag.range.end.line += chunk.line;
+      diagnostics.push_back(std::move(diag));
+    }
+  }
+}
+
+void Document::getSymbols(std::vector<lsp::DocumentSymbol> &symbols) const {
+  for (auto &chunk : modules) {
+    lsp::Position start(chunk.line, chunk.column);
+    lsp::Range range(start, lsp::Position(chunk.endLine, 0));
+    symbols.emplace_back(chunk.name, lsp::SymbolKind::Module, range,
+                         lsp::Range(start, start));
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// Server
+//===----------------------------------------------------------------------===//
+
+namespace {
+
+struct IncrementalLSPServer {
+  IncrementalLSPServer(MLIRContext &context) : context(context) {}
+
+  void onInitialize(const lsp::InitializeParams &params,
+                    lsp::Callback<llvm::json::Value> reply);
+  void onInitialized(const lsp::InitializedParams &params) {}
+  void onShutdown(const lsp::NoParams &params,
+                  lsp::Callback<std::nullptr_t> reply);
+
+  void onDocumentDidOpen(const lsp::DidOpenTextDocumentParams &params);
+  void onDocumentDidClose(const lsp::DidCloseTextDocumentParams &params);
+  void onDocumentDidChange(const lsp::DidChangeTextDocumentParams &params);
+  void onHover(const lsp::TextDocumentPositionParams &params,
+               lsp::Callback<std::optional<lsp::Hover>> reply);
+  void onDocumentSymbol(const lsp::DocumentSymbolParams &params,
+                        lsp::Callback<std::vector<lsp::DocumentSymbol>> reply);
+
+  void publishDiagnostics(const Document &document);
+
+  MLIRContext &context;
+  llvm::StringMap<std::unique_ptr<Document>> documents;
+  lsp::OutgoingNotification<lsp::PublishDiagnosticsParams>
+      publishDiagnosticsNotification;
+  bool shutdownRequestReceived = false;
+};
+
+} // namespace
+
+void IncrementalLSPServer::onInitialize(
+    const lsp::InitializeParams &params,
+    lsp::Callback<llvm::json::Value> reply) {
+  llvm::json::Object serverCaps{
+      {"textDocumentSync",
+       llvm::json::Object{
+           {"openClose", true},
+           {"change", (int)lsp::TextDocumentSyncKind::Incremental},
+           {"save", true},
+       }},
+      {"hoverProvider", true},
+      {"documentSymbolProvider", true},
+  };
+  llvm::json::Object result{
+      {{"serverInfo", llvm::json::Object{{"name", "circt-lsp-server"},
+                                         {"version", "0.0.0"}}},
+       {"capabilities", std::move(serverCaps)}}};
+  reply(std::move(result));
+}
+
+void IncrementalLSPServer::onShutdown(const lsp::NoParams &params,
+                                      lsp::Callback<std::nullptr_t> reply) {
+  shutdownRequestReceived = true;
+  reply(nullptr);
+}
+
+void IncrementalLSPServer::onDocumentDidOpen(
+    const lsp::DidOpenTextDocumentParams &params) {
+  auto &item = params.textDocument;
+  auto &document = documents[item.uri.file()];
+  document =
+      std::make_unique<Document>(context, item.uri, item.text, item.version);
+  publishDiagnostics(*document);
+}
+
+void IncrementalLSPServer::onDocumentDidClose(
+    const lsp::DidCloseTextDocumentParams &params) {
+  auto it = documents.find(params.textDocument.uri.file());
+  if (it == documents.end())
+    return;
+  int64_t version = it->second->getVersion();
+  documents.erase(it);
+  // Clear the diagnostics of the document.
+  publishDiagnosticsNotification(
+      lsp::PublishDiagnosticsParams(params.textDocument.uri, version));
+}
+
+void IncrementalLSPServer::onDocumentDidChange(
+    const lsp::DidChangeTextDocumentParams &params) {
+  auto it = documents.find(params.textDocument.uri.file());
+  if (it == documents.end()) {
+    lsp::Logger::error("Unable to find document '{0}' to update",
+                       params.textDocument.uri.file());
+    return;
+  }
+  auto &document = *it->second;
+  if (failed(document.update(params.contentChanges,
+                             params.textDocument.version))) {
+    lsp::Logger::error("Failed to update '{0}'",
+                       params.textDocument.uri.file());
+    documents.erase(it);
+    return;
+  }
+  publishDiagnostics(document);
+}
+
+void IncrementalLSPServer::onHover(
+    const lsp::TextDocumentPositionParams &params,
+    lsp::Callback<std::optional<lsp::Hover>> reply) {
+  auto it = documents.find(params.textDocument.uri.file());
+  if (it == documents.end())
+    return reply(std::nullopt);
+
+  // Hovering over a module is what makes it viewed, and verified if it was not
+  // yet.
+  auto &document = *it->second;
+  bool checkedNow;
+  auto *chunk = document.view(params.position, checkedNow);
+  if (!chunk)
+    return reply(std::nullopt);
+  if (checkedNow)
+    publishDiagnostics(document);
+
+  lsp::Position start(chunk->line, chunk->column);
+  lsp::Hover hover(lsp::Range(start, start));
+  llvm::raw_string_ostream os(hover.contents.value);
+  os << "Module `@" << chunk->name << "`, lines " << chunk->line + 1 << "-"
+     << chunk->endLine << ", " << chunk->diagnostics.size() << " diagnostics";
+  hover.contents.kind = lsp::MarkupKind::Markdown;
+  reply(std::move(hover));
+}
+
+void IncrementalLSPServer::onDocumentSymbol(
+    const lsp::DocumentSymbolParams &params,
+    lsp::Callback<std::vector<lsp::DocumentSymbol>> reply) {
+  std::vector<lsp::DocumentSymbol> symbols;
+  auto it = documents.find(params.textDocument.uri.file());
+  if (it != documents.end())
+    it->second->getSymbols(symbols);
+  reply(std::move(symbols));
+}
+
+void IncrementalLSPServer::publishDiagnostics(const Document &document) {
+  lsp::PublishDiagnosticsParams diagParams(document.getURI(),
+                                           document.getVersion());
+  document.getDiagnostics(diagParams.diagnostics);
+  publishDiagnosticsNotification(diagParams);
+}
+
+//===----------------------------------------------------------------------===//
+// Entry Point
+//===----------------------------------------------------------------------===//
+
+LogicalResult circt::runIncrementalLspServer(int argc, char **argv,
+                                             DialectRegistry &registry) {
+  cl::opt<bool> incremental(
+      "incremental",
+      cl::desc("Only parse and verify the modules which are edited or viewed"),
+      cl::init(true));
+  cl::opt<lsp::JSONStreamStyle> inputStyle(
+      "input-style", cl::desc("Input JSON stream encoding"),
+      cl::values(clEnumValN(lsp::JSONStreamStyle::Standard, "standard",
+                            "usual LSP protocol"),
+                 clEnumValN(lsp::JSONStreamStyle::Delimited, "delimited",
+                            "messages delimited by `// -----` lines, "
+                            "with // comment support")),
+      cl::init(lsp::JSONStreamStyle::Standard), cl::Hidden);
+  cl::opt<bool> litTest("lit-test",
+                        cl::desc("Abbreviation for -input-style=delimited "
+                                 "-pretty -log=verbose. Intended to simplify "
+                                 "lit tests"),
+                        cl::init(false));
+  cl::opt<lsp::Logger::Level> logLevel(
+      "log", cl::desc("Verbosity of log messages written to stderr"),
+      cl::values(
+          clEnumValN(lsp::Logger::Level::Error, "error", "Error messages only"),
+          clEnumValN(lsp::Logger::Level::Info, "info",
+                     "High level execution tracing"),
+          clEnumValN(lsp::Logger::Level::Debug, "verbose",
+                     "Low level details")),
+      cl::init(lsp::Logger::Level::Info));
+  cl::opt<bool> prettyPrint("pretty", cl::desc("Pretty-print JSON output"),
+                            cl::init(false));
+  cl::ParseCommandLineOptions(argc, argv,
+                              "CIRCT incremental LSP Language Server");
+
+  if (litTest) {
+    inputStyle = lsp::JSONStreamStyle::Delimited;
+    logLevel = lsp::Logger::Level::Debug;
+    prettyPrint = true;
+  }
+  lsp::Logger::setLogLevel(logLevel);
+
+  // Configure the transport used for communication.
+  llvm::sys::ChangeStdinToBinary();
+  lsp::JSONTransport transport(stdin, llvm::outs(), inputStyle, prettyPrint);
+
+  MLIRContext context(registry);
+  IncrementalLSPServer server(context);
+  lsp::MessageHandler messageHandler(transport);
+  messageHandler.method("initialize", &server,
+                        &IncrementalLSPServer::onInitialize);
+  messageHandler.notification("initialized", &server,
+                              &IncrementalLSPServer::onInitialized);
+  messageHandler.method("shutdown", &server, &IncrementalLSPServer::onShutdown);
+  messageHandler.notification("textDocument/didOpen", &server,
+                              &IncrementalLSPServer::onDocumentDidOpen);
+  messageHandler.notification("textDocument/didClose", &server,
+                              &IncrementalLSPServer::onDocumentDidClose);
+  messageHandler.notification("textDocument/didChange", &server,
+                              &IncrementalLSPServer::onDocumentDidChange);
+  messageHandler.method("textDocument/hover", &server,
+                        &IncrementalLSPServer::onHover);
+  messageHandler.method("textDocument/documentSymbol", &server,
+                        &IncrementalLSPServer::onDocumentSymbol);
+  server.publishDiagnosticsNotification =
+      messageHandler.outgoingNotification<lsp::PublishDiagnosticsParams>(
+          "textDocument/publishDiagnostics");
+
+  if (llvm::Error error = transport.run(messageHandler)) {
+    lsp::Logger::error("Transport error: {0}", error);
+    llvm::consumeError(std::move(error));
+    return failure();
+  }
+  return success(server.shutdownRequestReceived);
+}
@@ -0,0 +1,33 @@
+//===- IncrementalServer.h - Incremental CIRCT language server --*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the entry point of the incremental mode of the CIRCT
+// language server, which serves huge MLIR files by indexing their modules and
+// only parsing and verifying the modules which are edited or viewed.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TOOLS_CIRCT_LSP_SERVER_INCREMENTALSERVER_H
+#define TOOLS_CIRCT_LSP_SERVER_INCREMENTALSERVER_H
+
+#include "mlir/Support/LogicalResult.h"
+
+namespace mlir {
+class DialectRegistry;
+} // namespace mlir
+
+namespace circt {
+
+/// Parse the command line and run the incremental language server on stdin
+/// and stdout until it is shut down.
+mlir::LogicalResult runIncrementalLspServer(int argc, char **argv,
+                                            mlir::DialectRegistry &registry);
+
+} // namespace circt
+
+#endif // TOOLS_CIRCT_LSP_SERVER_INCREMENTALSERVER_H
@@ -6,6 +6,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "IncrementalServer.h"
 #include "circt/InitAllDialects.h"
 #include "circt/Support/Version.h"
 #include "mlir/IR/Dialect.h"
@@ -25,5 +26,12 @@ int main(int argc, char **argv) {
 
   registerAllDialects(registry);
   circt::registerAllDialects(registry);
+
+  // The incremental server for huge files has its own command line options, so
+  // it has to be picked before the upstream server parses the command line.
+  if (llvm::any_of(llvm::ArrayRef(argv, argc).drop_front(), [](StringRef arg) {
+        return arg == "-incremental" || arg == "--incremental";
+      }))
+    return failed(circt::runIncrementalLspServer(argc, argv, registry));
   return failed(MlirLspServerMain(argc, argv, registry));
 }
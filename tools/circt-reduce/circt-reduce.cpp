@@ -16,6 +16,7 @@
 #include "circt/Dialect/HW/HWDialect.h"
 #include "circt/Dialect/HW/HWReductions.h"
 #include "circt/InitAllDialects.h"
+#include "circt/InitAllPasses.h"
 #include "circt/Reduce/GenericReductions.h"
 #include "circt/Reduce/Tester.h"
 #include "circt/Support/Version.h"
@@ -24,9 +25,16 @@
 #include "mlir/Dialect/SCF/IR/SCF.h"
 #include "mlir/IR/AsmState.h"
 #include "mlir/Parser/Parser.h"
+#include "mlir/Pass/PassManager.h"
+#include "mlir/Pass/PassRegistry.h"
 #include "mlir/Support/FileUtilities.h"
+#include "mlir/Transforms/Passes.h"
+#include "llvm/ADT/Sequence.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/Regex.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/ToolOutputFile.h"
 
 #define DEBUG_TYPE "circt-reduce"
@@ -82,8 +90,7 @@ static cl::list<std::string>
                       cl::cat(mainCategory));
 
 static cl::opt<std::string> testerCommand(
-    "test", cl::Required,
-    cl::desc("A command or script to check if output is interesting"),
+    "test", cl::desc("A command or script to check if output is interesting"),
     cl::cat(mainCategory));
 
 static cl::list<std::string>
@@ -91,6 +98,23 @@ static cl::list<std::string>
                cl::desc("Additional arguments to the test"),
                cl::cat(mainCategory));
 
+static cl::opt<std::string> testPipeline(
+    "test-pipeline",
+    cl::desc("Check if output is interesting by running this pass pipeline on "
+             "it in a forked process, instead of a test command"),
+    cl::value_desc("pipeline"), cl::cat(mainCategory));
+
+static cl::opt<std::string> testDiagnostic(
+    "test-diagnostic",
+    cl::desc("Consider output interesting if the test pipeline emits a "
+             "diagnostic matching this regex, rather than if it crashes"),
+    cl::value_desc("regex"), cl::cat(mainCategory));
+
+static cl::opt<bool>
+    emitBytecode("emit-bytecode", cl::init(false),
+                 cl::desc("Write the test cases as MLIR bytecode"),
+                 cl::cat(mainCategory));
+
 static cl::opt<bool> verbose("v", cl::init(true),
                              cl::desc("Print reduction progress to stderr"),
                              cl::cat(mainCategory));
@@ -119,6 +143,25 @@ static cl::opt<unsigned>
                           "ops per chunk (granularity upper bound)"),
                  cl::cat(granularityCategory));
 
+static cl::opt<unsigned> numJobs(
+    "j", cl::init(1),
+    cl::desc("Number of reduction attempts to test concurrently. The first "
+             "interesting attempt in chunk order is accepted. Not supported "
+             "with --test-pipeline."),
+    cl::value_desc("N"), cl::cat(mainCategory));
+
+static cl::opt<bool> adaptive(
+    "adaptive", cl::init(false),
+    cl::desc("Try the reductions which removed the most bytes per test so far "
+             "first, and skip those which repeatedly failed to reduce"),
+    cl::cat(mainCategory));
+
+static cl::opt<unsigned> maxFailedRuns(
+    "max-failed-runs", cl::init(2),
+    cl::desc("With `--adaptive`, skip a reduction after this many consecutive "
+             "runs without progress"),
+    cl::cat(mainCategory));
+
 static cl::opt<bool> testMustFail(
     "test-must-fail", cl::init(false),
     cl::desc("Consider an input to be interesting on non-zero exit status."),
@@ -128,6 +171,28 @@ static cl::opt<bool> testMustFail(
 // Tool Implementation
 //===----------------------------------------------------------------------===//
 
+namespace {
+/// Statistics about the effect of a reduction, which guide the adaptive
+/// scheduling of the reductions.
+struct ReductionStats {
+  /// The number of interestingness tests run on its attempts.
+  size_t numTests = 0;
+  /// The number of its attempts which were accepted.
+  size_t numAccepted = 0;
+  /// The number of bytes it removed from the test case.
+  int64_t bytesRemoved = 0;
+  /// The number of consecutive runs in which it did not reduce the test case.
+  unsigned numFailedRuns = 0;
+
+  /// The number of bytes removed per test. Untested reductions come first.
+  double getScore() const {
+    if (numTests == 0)
+      return std::numeric_limits<double>::infinity();
+    return double(bytesRemoved) / numTests;
+  }
+};
+} // namespace
+
 /// Helper function that writes the current MLIR module to the configured output
 /// file. Called for intermediate states if the `keepBest` options has been set,
 /// or at least at the very end of the run.
@@ -184,13 +249,44 @@ static LogicalResult execute(MLIRContext &context) {
     return success();
   }
 
+  // Check the interestingness test before running it.
+  if (testerCommand.empty() == testPipeline.empty()) {
+    mlir::emitError(UnknownLoc::get(&context),
+                    "exactly one of `--test` and `--test-pipeline` is needed");
+    return failure();
+  }
+  if (!testPipeline.empty()) {
+    PassManager pm(&context);
+    if (failed(parsePassPipeline(testPipeline, pm)))
+      return failure();
+    // The test pipeline runs in a process forked from the calling thread,
+    // which is not safe from the worker threads running concurrent tests.
+    if (numJobs > 1) {
+      mlir::emitError(UnknownLoc::get(&context),
+                      "`--test-pipeline` cannot be used with `-j` > 1");
+      return failure();
+    }
+    if (!llvm::Regex(testDiagnostic).isValid(errorMessage)) {
+      mlir::emitError(UnknownLoc::get(&context), "invalid test diagnostic: ")
+          << errorMessage;
+      return failure();
+    }
+  }
+
   // Evaluate the unreduced input.
   VERBOSE({
-    llvm::errs() << "Testing input with `" << testerCommand << "`\n";
-    for (auto &arg : testerArgs)
-      llvm::errs() << "  with argument `" << arg << "`\n";
+    if (!testPipeline.empty()) {
+      llvm::errs() << "Testing input with pipeline `" << testPipeline << "`\n";
+    } else {
+      llvm::errs() << "Testing input with `" << testerCommand << "`\n";
+      for (auto &arg : testerArgs)
+        llvm::errs() << "  with argument `" << arg << "`\n";
+    }
   });
   Tester tester(testerCommand, testerArgs, testMustFail);
+  if (!testPipeline.empty())
+    tester.setInProcessTest(&context, testPipeline, testDiagnostic);
+  tester.setEmitBytecode(emitBytecode);
   auto initialTest = tester.get(module.get());
   if (!skipInitial && !initialTest.isInteresting()) {
     mlir::emitError(UnknownLoc::get(&context), "input is not interesting");
@@ -199,6 +295,12 @@ static LogicalResult execute(MLIRContext &context) {
   auto bestSize = initialTest.getSize();
   VERBOSE(llvm::errs() << "Initial module has size " << bestSize << "\n");
 
+  // The threads running the interestingness tests of several reduction
+  // attempts at once.
+  std::optional<llvm::ThreadPool> threadPool;
+  if (numJobs > 1)
+    threadPool.emplace(llvm::hardware_concurrency(numJobs));
+
   // Mechanism to write over the previous summary line, if it was the last
   // thing written to errs.
   size_t errsPosAfterLastSummary = 0;
@@ -214,12 +316,24 @@ static LogicalResult execute(MLIRContext &context) {
   // that retains the interesting behavior.
   // ModuleExternalizer pattern;
   BitVector appliedOneShotPatterns(patterns.size(), false);
-  for (unsigned patternIdx = 0; patternIdx < patterns.size();) {
+  SmallVector<ReductionStats> patternStats(patterns.size());
+  // The order in which the patterns are tried, as indices into `patterns`.
+  SmallVector<unsigned> patternOrder(llvm::seq<unsigned>(0, patterns.size()));
+  for (unsigned orderIdx = 0; orderIdx < patterns.size();) {
+    unsigned patternIdx = patternOrder[orderIdx];
     auto &pattern = patterns[patternIdx];
+    auto &stats = patternStats[patternIdx];
     if (pattern.isOneShot() && appliedOneShotPatterns[patternIdx]) {
       LLVM_DEBUG(llvm::dbgs()
                  << "Skipping one-shot `" << pattern.getName() << "`\n");
-      ++patternIdx;
+      ++orderIdx;
+      continue;
+    }
+    if (adaptive && stats.numFailedRuns >= maxFailedRuns) {
+      LLVM_DEBUG(llvm::dbgs()
+                 << "Skipping repeatedly failed `" << pattern.getName()
+                 << "`\n");
+      ++orderIdx;
       continue;
     }
     VERBOSE({
@@ -240,35 +354,41 @@ static LogicalResult execute(MLIRContext &context) {
       // Apply the pattern to the subset of operations selected by `rangeBase`
       // and `rangeLength`.
       size_t opIdx = 0;
-      mlir::OwningOpRef<mlir::ModuleOp> newModule = module->clone();
-      pattern.beforeReduction(*newModule);
-      SmallVector<std::pair<Operation *, uint64_t>, 16> opBenefits;
-      SmallDenseSet<Operation *> opsTouched;
-      pattern.notifyOpErasedCallback = [&](Operation *op) {
-        opsTouched.insert(op);
-      };
-      newModule->walk([&](Operation *op) {
-        uint64_t benefit = pattern.match(op);
-        if (benefit > 0) {
-          opIdx++;
-          opBenefits.push_back(std::make_pair(op, benefit));
-        }
-      });
-      std::sort(opBenefits.begin(), opBenefits.end(),
-                [](auto a, auto b) { return a.second > b.second; });
-      for (size_t idx = rangeBase, num = 0;
-           num < rangeLength && idx < opBenefits.size(); ++idx) {
-        auto *op = opBenefits[idx].first;
-        if (opsTouched.contains(op))
-          continue;
-        if (pattern.match(op)) {
-          op->walk([&](Operation *subop) { opsTouched.insert(subop); });
-          (void)pattern.rewrite(op);
-          ++num;
+      auto applyPattern = [&](size_t base, size_t length) {
+        opIdx = 0;
+        mlir::OwningOpRef<mlir::ModuleOp> newModule = module->clone();
+        pattern.beforeReduction(*newModule);
+        SmallVector<std::pair<Operation *, uint64_t>, 16> opBenefits;
+        SmallDenseSet<Operation *> opsTouched;
+        pattern.notifyOpErasedCallback = [&](Operation *op) {
+          opsTouched.insert(op);
+        };
+        newModule->walk([&](Operation *op) {
+          uint64_t benefit = pattern.match(op);
+          if (benefit > 0) {
+            opIdx++;
+            opBenefits.push_back(std::make_pair(op, benefit));
+          }
+        });
+        std::sort(opBenefits.begin(), opBenefits.end(),
+                  [](auto a, auto b) { return a.second > b.second; });
+        for (size_t idx = base, num = 0;
+             num < length && idx < opBenefits.size(); ++idx) {
+          auto *op = opBenefits[idx].first;
+          if (opsTouched.contains(op))
+            continue;
+          if (pattern.match(op)) {
+            op->walk([&](Operation *subop) { opsTouched.insert(subop); });
+            (void)pattern.rewrite(op);
+            ++num;
+          }
         }
-      }
-      pattern.afterReduction(*newModule);
-      pattern.notifyOpErasedCallback = nullptr;
+        pattern.afterReduction(*newModule);
+        pattern.notifyOpErasedCallback = nullptr;
+        return newModule;
+      };
+      SmallVector<mlir::OwningOpRef<mlir::ModuleOp>> newModules;
+      newModules.push_back(applyPattern(rangeBase, rangeLength));
       if (opIdx == 0) {
         VERBOSE({
           clearSummary();
@@ -296,27 +416,69 @@ static LogicalResult execute(MLIRContext &context) {
         errsPosAfterLastSummary = llvm::errs().tell();
       });
 
-      // Check if this reduced module is still interesting, and its overall size
+      // When testing concurrently, also apply the pattern to the chunks which
+      // would be tried next if the first ones turn out not to be interesting.
+      for (size_t base = rangeBase + rangeLength;
+           newModules.size() < numJobs && base < opIdx; base += rangeLength)
+        newModules.push_back(applyPattern(base, rangeLength));
+
+      // Check if a reduced module is still interesting, and its overall size
       // is smaller than what we had before.
-      auto shouldAccept = [&](TestCase &test) {
+      auto shouldTest = [&](TestCase &test) {
         if (!test.isValid())
           return false; // don't write to disk if module is busted
         if (test.getSize() >= bestSize && !pattern.acceptSizeIncrease())
           return false; // don't run test if size already bad
-        return test.isInteresting();
+        return true;
       };
-      auto test = tester.get(newModule.get());
-      if (shouldAccept(test)) {
+      std::vector<TestCase> tests;
+      tests.reserve(newModules.size());
+      for (auto &newModule : newModules)
+        tests.push_back(tester.get(newModule.get()));
+      if (tests.size() > 1) {
+        // The test cases are written to disk up front, such that running the
+        // tests only spawns the tester processes.
+        for (auto &test : tests) {
+          if (!shouldTest(test))
+            continue;
+          ++stats.numTests;
+          threadPool->async([&test] { (void)test.isInteresting(); });
+        }
+        threadPool->wait();
+      }
+
+      // Accept the first interesting module, such that the outcome is the same
+      // as when testing the chunks one after the other.
+      size_t numRejected = 0;
+      for (; numRejected < tests.size(); ++numRejected) {
+        auto &test = tests[numRejected];
+        if (!shouldTest(test))
+          continue;
+        // Concurrent tests have already been counted.
+        if (tests.size() == 1)
+          ++stats.numTests;
+        if (test.isInteresting())
+          break;
+      }
+      if (numRejected > 0) {
+        allDidReduce = false;
+        // Try the pattern on the next `rangeLength` number of operations.
+        rangeBase += numRejected * rangeLength;
+      }
+      if (numRejected < tests.size()) {
         // Make this reduced module the new baseline and reset our search
         // strategy to start again from the beginning, since this reduction may
         // have created additional opportunities.
         patternDidReduce = true;
-        bestSize = test.getSize();
+        ++stats.numAccepted;
+        stats.bytesRemoved +=
+            int64_t(bestSize) - int64_t(tests[numRejected].getSize());
+        bestSize = tests[numRejected].getSize();
         VERBOSE({
           clearSummary();
           llvm::errs() << "- Accepting module of size " << bestSize << "\n";
         });
-        module = std::move(newModule);
+        module = std::move(newModules[numRejected]);
 
         // We leave `rangeBase` and `rangeLength` untouched in this case. This
         // causes the next iteration of the loop to try the same pattern again
@@ -333,10 +495,6 @@ static LogicalResult execute(MLIRContext &context) {
         if (keepBest)
           if (failed(writeOutput(module.get())))
             return failure();
-      } else {
-        allDidReduce = false;
-        // Try the pattern on the next `rangeLength` number of operations.
-        rangeBase += rangeLength;
       }
 
       // If we have gone past the end of the input, reduce the size of the chunk
@@ -377,19 +535,26 @@ static LogicalResult execute(MLIRContext &context) {
     // prevent further reapplication.
     if (pattern.isOneShot())
       appliedOneShotPatterns.set(patternIdx);
+    stats.numFailedRuns = patternDidReduce ? 0 : stats.numFailedRuns + 1;
 
     // If the pattern provided a successful reduction, restart with the first
     // pattern again, since we might have uncovered additional reduction
-    // opportunities. Otherwise we just keep going to try the next pattern.
-    if (patternDidReduce && patternIdx > 0) {
+    // opportunities. Otherwise we just keep going to try the next pattern. The
+    // adaptive scheduling restarts with the most effective patterns so far,
+    // keeping the order by benefit among equally effective ones.
+    if (patternDidReduce && orderIdx > 0) {
       VERBOSE({
         clearSummary();
         llvm::errs() << "- Reduction `" << pattern.getName()
                      << "` was successful, starting at the top\n\n";
       });
-      patternIdx = 0;
+      if (adaptive)
+        llvm::stable_sort(patternOrder, [&](unsigned a, unsigned b) {
+          return patternStats[a].getScore() > patternStats[b].getScore();
+        });
+      orderIdx = 0;
     } else {
-      ++patternIdx;
+      ++orderIdx;
     }
   }
 
@@ -399,6 +564,21 @@ static LogicalResult execute(MLIRContext &context) {
   VERBOSE(llvm::errs() << "Final size: " << bestSize << " ("
                        << (100 - bestSize * 100 / initialTest.getSize())
                        << "% reduction)\n");
+
+  // Report the effect of each reduction which was tested.
+  VERBOSE({
+    llvm::errs() << "Reduction statistics:\n";
+    for (unsigned i = 0; i < patterns.size(); ++i) {
+      auto &stats = patternStats[i];
+      if (stats.numTests == 0)
+        continue;
+      llvm::errs() << llvm::format("  %-36s %6zu tests %6zu accepted %10lld "
+                                   "bytes removed\n",
+                                   patterns[i].getName().c_str(),
+                                   stats.numTests, stats.numAccepted,
+                                   (long long)stats.bytesRemoved);
+    }
+  });
   return writeOutput(module.get());
 }
 
@@ -427,7 +607,17 @@ int main(int argc, char **argv) {
   arc::registerReducePatternDialectInterface(registry);
   firrtl::registerReducePatternDialectInterface(registry);
   hw::registerReducePatternDialectInterface(registry);
-  mlir::MLIRContext context(registry);
+
+  // Register the passes available to in-process tests.
+  circt::registerAllPasses();
+  mlir::registerCSEPass();
+  mlir::registerCanonicalizerPass();
+
+  // In-process tests fork the tool, which only keeps the forking thread.
+  // Multithreading is disabled for the pipelines to run in the child.
+  mlir::MLIRContext context(registry, testPipeline.empty()
+                                          ? MLIRContext::Threading::ENABLED
+                                          : MLIRContext::Threading::DISABLED);
 
   // Do the actual processing and use `exit` to avoid the slow teardown of the
   // context.
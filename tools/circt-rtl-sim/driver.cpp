@@ -7,15 +7,24 @@
 //===----------------------------------------------------------------------===//
 //
 // A fairly standard, boilerplate Verilator C++ simulation driver. Assumes the
-// top level exposes just two signals: 'clk' and 'rst'.
+// top level exposes just two signals: 'clk' and 'rst'. Models built with
+// `--threads` evaluate on their own thread pool; models built with
+// `--trace-fst` and `-DTRACE_FST` write FST instead of VCD waveforms.
 //
 //===----------------------------------------------------------------------===//
 
 #include "Vtop.h"
 
+#ifdef TRACE_FST
+#include "verilated_fst_c.h"
+using TraceFile = VerilatedFstC;
+#else
 #include "verilated_vcd_c.h"
+using TraceFile = VerilatedVcdC;
+#endif
 
 #include "signal.h"
+#include <chrono>
 #include <iostream>
 
 vluint64_t timeStamp;
@@ -35,17 +44,30 @@ int main(int argc, char **argv) {
 
   size_t numCyclesToRun = 0;
   bool runForever = true;
+  // The window of cycles out of reset to write to the waveform file. Reset is
+  // always traced.
+  size_t traceStart = 0;
+  size_t numCyclesToTrace = 0;
+  bool traceForever = true;
   // Search the command line args for those we are sensitive to.
   for (int i = 1; i < argc; ++i) {
-    if (std::string(argv[i]) == "--cycles") {
-      if (i + 1 < argc) {
-        numCyclesToRun = std::strtoull(argv[++i], nullptr, 10);
-        runForever = false;
-      } else {
-        std::cerr << "--cycles must be followed by number of cycles."
-                  << std::endl;
-        return 1;
-      }
+    std::string arg = argv[i];
+    if (arg != "--cycles" && arg != "--trace-start" && arg != "--trace-cycles")
+      continue;
+    if (i + 1 >= argc) {
+      std::cerr << arg << " must be followed by number of cycles."
+                << std::endl;
+      return 1;
+    }
+    size_t value = std::strtoull(argv[++i], nullptr, 10);
+    if (arg == "--cycles") {
+      numCyclesToRun = value;
+      runForever = false;
+    } else if (arg == "--trace-start") {
+      traceStart = value;
+    } else {
+      numCyclesToTrace = value;
+      traceForever = false;
     }
   }
 
@@ -53,10 +75,10 @@ int main(int argc, char **argv) {
   auto &dut = *new Vtop();
   char *waveformFile = getenv("SAVE_WAVE");
 
-  VerilatedVcdC *tfp = nullptr;
+  TraceFile *tfp = nullptr;
   if (waveformFile) {
 #ifdef TRACE
-    tfp = new VerilatedVcdC();
+    tfp = new TraceFile();
     Verilated::traceEverOn(true);
     dut.trace(tfp, 99); // Trace 99 levels of hierarchy
     tfp->open(waveformFile);
@@ -85,16 +107,24 @@ int main(int argc, char **argv) {
   // Take simulation out of reset.
   dut.rst = 0;
 
-  // Run for the specified number of cycles out of reset.
+  // Run for the specified number of cycles out of reset, tracing only the
+  // requested window.
+  vluint64_t startTime = timeStamp;
   vluint64_t endTime = timeStamp + (numCyclesToRun * 2);
+  vluint64_t traceStartTime = startTime + traceStart * 2;
+  vluint64_t traceEndTime = traceStartTime + numCyclesToTrace * 2;
+  auto wallStart = std::chrono::steady_clock::now();
   for (; (runForever || timeStamp <= endTime) && !Verilated::gotFinish() &&
          !stopSimulation;
        timeStamp++) {
     dut.eval();
     dut.clk = !dut.clk;
-    if (tfp)
+    if (tfp && timeStamp >= traceStartTime &&
+        (traceForever || timeStamp < traceEndTime))
       tfp->dump(timeStamp);
   }
+  std::chrono::duration<double> wallTime =
+      std::chrono::steady_clock::now() - wallStart;
 
   // Tell the simulator that we're going to exit. This flushes the output(s) and
   // frees whatever memory may have been allocated.
@@ -103,5 +133,11 @@ int main(int argc, char **argv) {
     tfp->close();
 
   std::cout << "[driver] Ending simulation at tick #" << timeStamp << std::endl;
+  vluint64_t numCycles = (timeStamp - startTime) / 2;
+  std::cout << "[driver] Simulated " << numCycles << " cycles in "
+            << wallTime.count() << " s";
+  if (wallTime.count() > 0)
+    std::cout << " (" << numCycles / wallTime.count() << " cycles/s)";
+  std::cout << std::endl;
   return 0;
 }
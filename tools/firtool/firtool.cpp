@@ -15,6 +15,7 @@
 #include "circt/Conversion/ExportVerilog.h"
 #include "circt/Conversion/Passes.h"
 #include "circt/Dialect/Comb/CombDialect.h"
+#include "circt/Dialect/FIRRTL/AnnotationDetails.h"
 #include "circt/Dialect/FIRRTL/CHIRRTLDialect.h"
 #include "circt/Dialect/FIRRTL/FIRParser.h"
 #include "circt/Dialect/FIRRTL/FIRRTLDialect.h"
@@ -28,6 +29,7 @@
 #include "circt/Support/LoweringOptions.h"
 #include "circt/Support/LoweringOptionsParser.h"
 #include "circt/Support/Passes.h"
+#include "circt/Support/Path.h"
 #include "circt/Support/Version.h"
 #include "circt/Transforms/Passes.h"
 #include "mlir/Bytecode/BytecodeReader.h"
@@ -43,12 +45,18 @@
 #include "mlir/Support/Timing.h"
 #include "mlir/Support/ToolUtilities.h"
 #include "mlir/Transforms/Passes.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringSwitch.h"
 #include "llvm/Support/Chrono.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/LineIterator.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/SHA256.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/ToolOutputFile.h"
 
@@ -85,6 +93,22 @@ static cl::opt<bool>
                             "chunk independently"),
                    cl::init(false), cl::Hidden, cl::cat(mainCategory));
 
+static cl::opt<std::string> batchManifest(
+    "batch",
+    cl::desc("Process every input listed in the given manifest in one "
+             "process. Each line names an input file and its output file or "
+             "directory, separated by whitespace"),
+    cl::value_desc("manifest"), cl::init(""), cl::cat(mainCategory));
+
+static cl::opt<bool> serverMode(
+    "server",
+    cl::desc("Keep running and compile the input named on each line of the "
+             "standard input to the output file separated from it by "
+             "whitespace, answering with `ok` or `error` and the input on the "
+             "standard output. An output whose input and options are "
+             "unchanged since the previous request is reused"),
+    cl::init(false), cl::cat(mainCategory));
+
 static cl::list<std::string> includeDirs(
     "include-dir",
     cl::desc("Directory to search in when resolving source references"),
@@ -168,6 +192,44 @@ static cl::opt<OutputFormatKind> outputFormat(
         clEnumValN(OutputDisabled, "disable-output", "Do not output anything")),
     cl::init(OutputVerilog), cl::cat(mainCategory));
 
+/// The boundaries in the pipeline at which the IR can be written to a
+/// checkpoint, in pipeline order.
+enum CheckpointStage {
+  CheckpointNone,
+  CheckpointLowFIRRTL,
+  CheckpointHW,
+  CheckpointSV
+};
+
+static cl::opt<CheckpointStage> checkpointAfter(
+    "checkpoint-after",
+    cl::desc("Write the IR as bytecode to the checkpoint file after the "
+             "specified stage, to be continued later with --resume-from"),
+    cl::values(clEnumValN(CheckpointLowFIRRTL, "low-firrtl",
+                          "After lowering to low FIRRTL"),
+               clEnumValN(CheckpointHW, "hw", "After lowering to HW"),
+               clEnumValN(CheckpointSV, "sv", "After lowering to SV")),
+    cl::init(CheckpointNone), cl::cat(mainCategory));
+
+static cl::opt<std::string>
+    checkpointFile("checkpoint-file",
+                   cl::desc("The file to write the checkpoint to"),
+                   cl::value_desc("filename"),
+                   cl::init("firtool-checkpoint.mlirbc"),
+                   cl::cat(mainCategory));
+
+static cl::opt<std::string> resumeFrom(
+    "resume-from",
+    cl::desc("Continue the pipeline from a checkpoint written with "
+             "--checkpoint-after instead of processing the input file"),
+    cl::value_desc("filename"), cl::init(""), cl::cat(mainCategory));
+
+static cl::opt<bool> splitVerilogOnlyWriteChanged(
+    "split-verilog-only-write-changed",
+    cl::desc("With split-verilog, do not rewrite files whose contents are "
+             "unchanged, and list the written files in changed-files.f"),
+    cl::init(false), cl::cat(mainCategory));
+
 static cl::opt<bool>
     verifyPasses("verify-each",
                  cl::desc("Run the verifier after each transformation pass"),
@@ -201,6 +263,16 @@ static cl::opt<bool>
                           cl::desc("Log executions of toplevel module passes"),
                           cl::init(false), cl::cat(mainCategory));
 
+static cl::opt<std::string>
+    perfReport("perf-report",
+               cl::desc("Write a JSON report of the time, memory and IR size "
+                        "of every pass execution to the specified file"),
+               cl::value_desc("filename"), cl::init(""),
+               cl::cat(mainCategory));
+
+/// The report filled in by the pass managers if `--perf-report` is given.
+static PassPerfReport passPerfReport;
+
 static cl::opt<bool> stripFirDebugInfo(
     "strip-fir-debug-info",
     cl::desc("Disable source fir locator information in output Verilog"),
@@ -213,6 +285,17 @@ static cl::opt<bool> stripDebugInfo(
 
 static LoweringOptionsOption loweringOptions(mainCategory);
 
+static cl::opt<std::string> cacheDir(
+    "cache-dir",
+    cl::desc("Directory in which to cache the Verilog output for each input, "
+             "set of command line options, and black box source files, as "
+             "well as the Verilog output of each module"),
+    cl::value_desc("directory"), cl::init(""), cl::cat(mainCategory));
+
+/// The command line arguments the tool was invoked with, which are part of the
+/// cache key.
+static std::string commandLine;
+
 /// Check output stream before writing bytecode to it.
 /// Warn and return true if output is known to be displayed.
 static bool checkBytecodeOutputToConsole(raw_ostream &os) {
@@ -226,6 +309,61 @@ static bool checkBytecodeOutputToConsole(raw_ostream &os) {
   return false;
 }
 
+/// The attribute on the root module recording the stage of a checkpoint.
+static constexpr const char *checkpointAttrName = "firtool.checkpoint";
+
+static StringRef getCheckpointStageName(CheckpointStage stage) {
+  switch (stage) {
+  case CheckpointNone:
+    break;
+  case CheckpointLowFIRRTL:
+    return "low-firrtl";
+  case CheckpointHW:
+    return "hw";
+  case CheckpointSV:
+    return "sv";
+  }
+  llvm_unreachable("not a checkpoint stage");
+}
+
+/// Return the last stage of the pipeline which is run for the requested
+/// output format, or `CheckpointNone` if the pipeline stops before any stage.
+static CheckpointStage getFinalStage() {
+  switch (outputFormat) {
+  case OutputParseOnly:
+    return CheckpointNone;
+  case OutputIRFir:
+    return CheckpointLowFIRRTL;
+  case OutputIRHW:
+    return CheckpointHW;
+  default:
+    return CheckpointSV;
+  }
+}
+
+/// Write the module as bytecode to the checkpoint file, recording that the
+/// pipeline completed `stage`.
+static LogicalResult writeCheckpoint(ModuleOp module, CheckpointStage stage,
+                                     TimingScope &ts) {
+  auto checkpointTimer = ts.nest("Write checkpoint");
+  std::string errorMessage;
+  auto file = openOutputFile(checkpointFile, &errorMessage);
+  if (!file) {
+    llvm::errs() << errorMessage << "\n";
+    return failure();
+  }
+  module->setAttr(checkpointAttrName,
+                  StringAttr::get(module.getContext(),
+                                  getCheckpointStageName(stage)));
+  auto result = writeBytecodeToFile(
+      module, file->os(), mlir::BytecodeWriterConfig(getCirctVersion()));
+  module->removeAttr(checkpointAttrName);
+  if (failed(result))
+    return failure();
+  file->keep();
+  return success();
+}
+
 /// Print the operation to the specified stream, emitting bytecode when
 /// requested and politely avoiding dumping to terminal unless forced.
 static LogicalResult printOp(Operation *op, raw_ostream &os) {
@@ -236,6 +374,194 @@ static LogicalResult printOp(Operation *op, raw_ostream &os) {
   return success();
 }
 
+//===----------------------------------------------------------------------===//
+// Output Cache
+//===----------------------------------------------------------------------===//
+
+/// Whether this invocation processes multiple inputs.
+static bool isMultiInput() { return !batchManifest.empty() || serverMode; }
+
+namespace {
+/// A cached output, along with the black box source files it depends on.
+struct CacheEntry {
+  std::string inputKey;
+  SmallVector<std::string> blackBoxPaths;
+  std::string key;
+  std::string output;
+};
+} // namespace
+
+/// The last output written to each output file in server mode.
+static llvm::StringMap<CacheEntry> serverCache;
+
+/// Check whether the output of this invocation can be cached. Only single-file
+/// Verilog output written to a file is cached, and only if no other files are
+/// produced alongside it.
+static bool isCacheable() {
+  return (!cacheDir.empty() || serverMode) && outputFormat == OutputVerilog &&
+         outputFilename != "-" && !verifyDiagnostics && !splitInputFile &&
+         mlirOutFile.empty() && !exportModuleHierarchy &&
+         checkpointAfter == CheckpointNone &&
+         !firtoolOptions.exportChiselInterface &&
+         firtoolOptions.omirOutFile.empty() &&
+         firtoolOptions.outputAnnotationFilename.empty();
+}
+
+/// Hash a buffer along with its size, such that consecutive buffers cannot be
+/// confused with each other.
+static void hashBuffer(llvm::SHA256 &hasher, StringRef buffer) {
+  uint64_t size = buffer.size();
+  hasher.update(
+      ArrayRef<uint8_t>(reinterpret_cast<uint8_t *>(&size), sizeof(size)));
+  hasher.update(buffer);
+}
+
+/// Compute the key of the inputs which are known before parsing: the tool
+/// version, the command line, and every buffer in the source manager, which
+/// includes the annotation and OMIR files.
+static std::string getInputKey(llvm::SourceMgr &sourceMgr) {
+  llvm::SHA256 hasher;
+  hasher.update(getCirctVersion());
+  hasher.update(StringRef(commandLine.c_str(), commandLine.size() + 1));
+  for (unsigned id = 1, e = sourceMgr.getNumBuffers(); id <= e; ++id)
+    hashBuffer(hasher, sourceMgr.getMemoryBuffer(id)->getBuffer());
+  return llvm::toHex(hasher.final(), /*LowerCase=*/true);
+}
+
+/// Collect the source files of black box path annotations, which
+/// BlackBoxReader copies into the output. These are found in the parsed
+/// module, before the annotations are lowered.
+static SmallVector<std::string> getBlackBoxPaths(ModuleOp module) {
+  llvm::SetVector<StringAttr> blackBoxPaths;
+  module.walk([&](Operation *op) {
+    op->getAttrDictionary().walk([&](Attribute attr) {
+      auto dict = dyn_cast<DictionaryAttr>(attr);
+      if (!dict)
+        return;
+      auto cls = dict.getAs<StringAttr>("class");
+      auto path = dict.getAs<StringAttr>("path");
+      if (cls && path && cls.getValue() == firrtl::blackBoxPathAnnoClass)
+        blackBoxPaths.insert(path);
+    });
+  });
+  StringRef blackBoxRoot = firtoolOptions.blackBoxRootPath.empty()
+                               ? llvm::sys::path::parent_path(inputFilename)
+                               : StringRef(firtoolOptions.blackBoxRootPath);
+  SmallVector<std::string> inputPaths;
+  for (auto path : blackBoxPaths) {
+    SmallString<128> inputPath(blackBoxRoot);
+    appendPossiblyAbsolutePath(inputPath, path.getValue());
+    inputPaths.push_back(std::string(inputPath));
+  }
+  return inputPaths;
+}
+
+/// Compute the key under which the output for an input is cached. This covers
+/// the input key and the black box source files the output depends on.
+static std::string getCacheKey(StringRef inputKey,
+                               ArrayRef<std::string> blackBoxPaths) {
+  llvm::SHA256 hasher;
+  hasher.update(inputKey);
+  for (auto &path : blackBoxPaths) {
+    hashBuffer(hasher, path);
+    // A missing file fails the run, which is then not cached.
+    if (auto buffer = llvm::MemoryBuffer::getFile(path))
+      hashBuffer(hasher, (*buffer)->getBuffer());
+  }
+  return llvm::toHex(hasher.final(), /*LowerCase=*/true);
+}
+
+/// Return the path of the cache file with the given key and extension. The
+/// `.deps` file of an input key lists the black box source files of the
+/// output, and the `.v` file of a cache key holds the output itself.
+static std::string getCachePath(StringRef key, StringRef extension) {
+  SmallString<128> path(cacheDir);
+  llvm::sys::path::append(path, key + extension);
+  return std::string(path);
+}
+
+/// Copy the cached output for an input key to the output file. The black box
+/// source files of the output are looked up by the input key, such that the
+/// input does not need to be parsed to find the output. Fails if there is no
+/// cache entry for the key.
+static LogicalResult loadFromCache(StringRef inputKey, raw_ostream &os) {
+  if (serverMode) {
+    auto it = serverCache.find(outputFilename);
+    if (it != serverCache.end() && it->second.inputKey == inputKey &&
+        it->second.key == getCacheKey(inputKey, it->second.blackBoxPaths)) {
+      os << it->second.output;
+      return success();
+    }
+  }
+  if (cacheDir.empty())
+    return failure();
+  auto deps = llvm::MemoryBuffer::getFile(getCachePath(inputKey, ".deps"));
+  if (!deps)
+    return failure();
+  SmallVector<std::string> blackBoxPaths;
+  for (llvm::line_iterator it(**deps, /*SkipBlanks=*/true); !it.is_at_end();
+       ++it)
+    blackBoxPaths.push_back(it->str());
+  auto output = llvm::MemoryBuffer::getFile(
+      getCachePath(getCacheKey(inputKey, blackBoxPaths), ".v"));
+  if (!output)
+    return failure();
+  os << (*output)->getBuffer();
+  return success();
+}
+
+/// Write a file of the cache. The file is written to a temporary file first
+/// and then renamed, such that concurrent runs never observe a partially
+/// written file.
+static LogicalResult writeCacheFile(StringRef path, StringRef contents) {
+  auto error = llvm::writeToOutput(path, [&](raw_ostream &os) {
+    os << contents;
+    return llvm::Error::success();
+  });
+  if (!error)
+    return success();
+  llvm::errs() << "warning: cannot write cache file `" << path
+               << "`: " << toString(std::move(error)) << "\n";
+  return failure();
+}
+
+/// Store the output file in the cache. Failing to update the cache is not an
+/// error.
+static void storeInCache(StringRef inputKey,
+                         ArrayRef<std::string> blackBoxPaths) {
+  auto output = llvm::MemoryBuffer::getFile(outputFilename);
+  if (!output) {
+    llvm::errs() << "warning: cannot read output file `" << outputFilename
+                 << "` for caching: " << output.getError().message() << "\n";
+    return;
+  }
+  auto key = getCacheKey(inputKey, blackBoxPaths);
+  if (serverMode)
+    serverCache[outputFilename] = {
+        inputKey.str(),
+        SmallVector<std::string>(blackBoxPaths.begin(), blackBoxPaths.end()),
+        key, (*output)->getBuffer().str()};
+  if (cacheDir.empty())
+    return;
+  if (auto error = llvm::sys::fs::create_directories(cacheDir)) {
+    llvm::errs() << "warning: cannot create cache directory `" << cacheDir
+                 << "`: " << error.message() << "\n";
+    return;
+  }
+  // Write the output before the list of its dependences, such that a reader
+  // finding the list also finds the output.
+  std::string deps;
+  for (auto &path : blackBoxPaths)
+    deps += path + "\n";
+  if (succeeded(writeCacheFile(getCachePath(key, ".v"),
+                               (*output)->getBuffer())))
+    (void)writeCacheFile(getCachePath(inputKey, ".deps"), deps);
+}
+
+//===----------------------------------------------------------------------===//
+// Tool Driver
+//===----------------------------------------------------------------------===//
+
 /// Process a single buffer of the input.
 static LogicalResult processBuffer(
     MLIRContext &context, TimingScope &ts, llvm::SourceMgr &sourceMgr,
@@ -263,6 +589,16 @@ static LogicalResult processBuffer(
     }
   }
 
+  // Reuse the output for this input from the cache if possible. This is
+  // checked before parsing, such that a cache hit does not pay for it.
+  std::optional<std::string> inputKey;
+  if (isCacheable()) {
+    auto cacheTimer = ts.nest("Load cached output");
+    inputKey = getInputKey(sourceMgr);
+    if (succeeded(loadFromCache(*inputKey, (*outputFile)->os())))
+      return success();
+  }
+
   // Parse the input.
   mlir::OwningOpRef<mlir::ModuleOp> module;
 
@@ -278,6 +614,7 @@ static LogicalResult processBuffer(
     auto parserTimer = ts.nest("FIR Parser");
     firrtl::FIRParserOptions options;
     options.ignoreInfoLocators = ignoreFIRLocations;
+    options.compactInfoLocators = firtoolOptions.compactFIRLocators;
     options.numAnnotationFiles = numAnnotationFiles;
     options.scalarizeTopModule = scalarizeTopModule;
     options.scalarizeExtModules = scalarizeExtModules;
@@ -286,10 +623,49 @@ static LogicalResult processBuffer(
     auto parserTimer = ts.nest("MLIR Parser");
     assert(inputFormat == InputMLIRFile);
     module = parseSourceFile<ModuleOp>(sourceMgr, &context);
+    // Circuits handed off as MLIR, for example as bytecode of the parsed
+    // circuit, skip the .fir front end; attach the annotation files to them
+    // like the .fir parser would.
+    if (module && failed(firrtl::importAnnotationFiles(sourceMgr, *module,
+                                                       numAnnotationFiles)))
+      return failure();
   }
   if (!module)
     return failure();
 
+  // The black box source files are part of the cache key of the output.
+  SmallVector<std::string> blackBoxPaths;
+  if (inputKey)
+    blackBoxPaths = getBlackBoxPaths(*module);
+
+  // A checkpoint records which stages of the pipeline have already been run.
+  CheckpointStage resumedStage = CheckpointNone;
+  if (!resumeFrom.empty()) {
+    auto stageAttr = (*module)->getAttrOfType<StringAttr>(checkpointAttrName);
+    if (stageAttr)
+      resumedStage = llvm::StringSwitch<CheckpointStage>(stageAttr.getValue())
+                         .Case("low-firrtl", CheckpointLowFIRRTL)
+                         .Case("hw", CheckpointHW)
+                         .Case("sv", CheckpointSV)
+                         .Default(CheckpointNone);
+    if (resumedStage == CheckpointNone) {
+      llvm::errs() << "'" << resumeFrom << "' is not a firtool checkpoint\n";
+      return failure();
+    }
+    if (resumedStage > getFinalStage()) {
+      llvm::errs() << "cannot produce the requested output from a checkpoint "
+                      "after stage '"
+                   << stageAttr.getValue() << "'\n";
+      return failure();
+    }
+    if (checkpointAfter != CheckpointNone && checkpointAfter <= resumedStage) {
+      llvm::errs() << "the checkpoint already covers stage '"
+                   << getCheckpointStageName(checkpointAfter) << "'\n";
+      return failure();
+    }
+    (*module)->removeAttr(checkpointAttrName);
+  }
+
   if (verbosePassExecutions) {
     auto elapsed = std::chrono::duration<double>(
                        llvm::sys::TimePoint<>::clock::now() - parseStartTime) /
@@ -307,15 +683,21 @@ static LogicalResult processBuffer(
         std::make_unique<
             VerbosePassInstrumentation<firrtl::CircuitOp, mlir::ModuleOp>>(
             "firtool"));
+  if (!perfReport.empty())
+    pm.addInstrumentation(passPerfReport.createInstrumentation());
   if (failed(applyPassManagerCLOptions(pm)))
     return failure();
 
-  // Legalize away "open" aggregates to hw-only versions.
-  pm.nest<firrtl::CircuitOp>().addPass(firrtl::createLowerOpenAggsPass());
+  if (resumedStage < CheckpointLowFIRRTL) {
+    auto &circuitPm = pm.nest<firrtl::CircuitOp>();
+
+    // Legalize away "open" aggregates to hw-only versions.
+    circuitPm.addPass(firrtl::createLowerOpenAggsPass());
 
-  pm.nest<firrtl::CircuitOp>().addPass(firrtl::createLowerFIRRTLAnnotationsPass(
-      disableAnnotationsUnknown, disableAnnotationsClassless,
-      lowerAnnotationsNoRefTypePorts));
+    circuitPm.addPass(firrtl::createLowerFIRRTLAnnotationsPass(
+        disableAnnotationsUnknown, disableAnnotationsClassless,
+        lowerAnnotationsNoRefTypePorts));
+  }
 
   // If the user asked for --parse-only, stop after running LowerAnnotations.
   if (outputFormat == OutputParseOnly) {
@@ -325,24 +707,41 @@ static LogicalResult processBuffer(
     return printOp(*module, (*outputFile)->os());
   }
 
-  if (failed(firtool::populateCHIRRTLToLowFIRRTL(pm, firtoolOptions, *module,
-                                                 inputFilename)))
-    return failure();
+  // Load the emitter options from the command line. Command line options if
+  // specified will override any module options, including the ones stored in
+  // a checkpoint.
+  if (loweringOptions.getNumOccurrences())
+    loweringOptions.setAsAttribute(module.get());
+
+  // Run the passes added so far and write a checkpoint if the user asked for
+  // one after `stage`.
+  auto checkpoint = [&](CheckpointStage stage) -> LogicalResult {
+    if (checkpointAfter != stage)
+      return success();
+    if (failed(pm.run(module.get())))
+      return failure();
+    pm.clear();
+    return writeCheckpoint(*module, stage, ts);
+  };
+
+  if (resumedStage < CheckpointLowFIRRTL)
+    if (failed(firtool::populateCHIRRTLToLowFIRRTL(pm, firtoolOptions, *module,
+                                                   inputFilename)) ||
+        failed(checkpoint(CheckpointLowFIRRTL)))
+      return failure();
 
   // Lower if we are going to verilog or if lowering was specifically requested.
   if (outputFormat != OutputIRFir) {
-    if (failed(firtool::populateLowFIRRTLToHW(pm, firtoolOptions)))
-      return failure();
-    if (outputFormat != OutputIRHW)
-      if (failed(firtool::populateHWToSV(pm, firtoolOptions)))
+    if (resumedStage < CheckpointHW)
+      if (failed(firtool::populateLowFIRRTLToHW(pm, firtoolOptions)) ||
+          failed(checkpoint(CheckpointHW)))
+        return failure();
+    if (outputFormat != OutputIRHW && resumedStage < CheckpointSV)
+      if (failed(firtool::populateHWToSV(pm, firtoolOptions)) ||
+          failed(checkpoint(CheckpointSV)))
         return failure();
   }
 
-  // Load the emitter options from the command line. Command line options if
-  // specified will override any module options.
-  if (loweringOptions.getNumOccurrences())
-    loweringOptions.setAsAttribute(module.get());
-
   if (failed(pm.run(module.get())))
     return failure();
 
@@ -358,6 +757,8 @@ static LogicalResult processBuffer(
           std::make_unique<
               VerbosePassInstrumentation<firrtl::CircuitOp, mlir::ModuleOp>>(
               "firtool"));
+    if (!perfReport.empty())
+      exportPm.addInstrumentation(passPerfReport.createInstrumentation());
     // Legalize unsupported operations within the modules.
     exportPm.nest<hw::HWModuleOp>().addPass(sv::createHWLegalizeModulesPass());
 
@@ -381,11 +782,21 @@ static LogicalResult processBuffer(
     switch (outputFormat) {
     default:
       llvm_unreachable("can't reach this");
-    case OutputVerilog:
-      exportPm.addPass(createExportVerilogPass((*outputFile)->os()));
+    case OutputVerilog: {
+      // Modules which did not change since an earlier run reuse its output,
+      // even if the output of the whole run cannot be reused.
+      SmallString<128> moduleCacheDir;
+      if (!cacheDir.empty()) {
+        moduleCacheDir = cacheDir;
+        llvm::sys::path::append(moduleCacheDir, "modules");
+      }
+      exportPm.addPass(
+          createExportVerilogPass((*outputFile)->os(), moduleCacheDir));
       break;
+    }
     case OutputSplitVerilog:
-      exportPm.addPass(createExportSplitVerilogPass(outputFilename));
+      exportPm.addPass(createExportSplitVerilogPass(
+          outputFilename, splitVerilogOnlyWriteChanged));
       break;
     case OutputIRVerilog:
       // Run the ExportVerilog pass to get its lowering, but discard the output.
@@ -405,6 +816,11 @@ static LogicalResult processBuffer(
 
     if (failed(exportPm.run(module.get())))
       return failure();
+
+    if (inputKey) {
+      (*outputFile)->os().flush();
+      storeInCache(*inputKey, blackBoxPaths);
+    }
   }
 
   if (outputFormat == OutputIRFir || outputFormat == OutputIRHW ||
@@ -430,8 +846,10 @@ static LogicalResult processBuffer(
 
   // We intentionally "leak" the Module into the MLIRContext instead of
   // deallocating it.  There is no need to deallocate it right before process
-  // exit.
-  (void)module.release();
+  // exit. With multiple inputs the module is destroyed to bound the memory
+  // used across inputs.
+  if (!isMultiInput())
+    (void)module.release();
   return success();
 }
 
@@ -486,22 +904,18 @@ processInput(MLIRContext &context, TimingScope &ts,
       llvm::outs());
 }
 
-/// This implements the top-level logic for the firtool command, invoked once
-/// command line options are parsed and LLVM/MLIR are all set up and ready to
-/// go.
-static LogicalResult executeFirtool(MLIRContext &context) {
-  // Create the timing manager we use to sample execution times.
-  DefaultTimingManager tm;
-  applyDefaultTimingManagerCLOptions(tm);
-  auto ts = tm.getRootScope();
-
-  // Set up the input file.
+/// Process the input file named on the command line and write its output.
+static LogicalResult processFile(MLIRContext &context, TimingScope &ts) {
+  // Set up the input file. A checkpoint replaces the input file.
   std::string errorMessage;
-  auto input = openInputFile(inputFilename, &errorMessage);
+  auto input = openInputFile(resumeFrom.empty() ? inputFilename : resumeFrom,
+                             &errorMessage);
   if (!input) {
     llvm::errs() << errorMessage << "\n";
     return failure();
   }
+  if (!resumeFrom.empty())
+    inputFormat = InputMLIRFile;
 
   // Figure out the input format if unspecified.
   if (inputFormat == InputUnspecified) {
@@ -541,22 +955,199 @@ static LogicalResult executeFirtool(MLIRContext &context) {
     }
   }
 
-  // Register our dialects.
-  context.loadDialect<chirrtl::CHIRRTLDialect, firrtl::FIRRTLDialect,
-                      hw::HWDialect, comb::CombDialect, seq::SeqDialect,
-                      sv::SVDialect>();
-
-  // Process the input.
   if (failed(processInput(context, ts, std::move(input), outputFile)))
     return failure();
 
   // If the result succeeded and we're emitting a file, close it.
   if (outputFile.has_value())
     (*outputFile)->keep();
+  return success();
+}
+
+/// Split a line naming an input and an output file, separated by whitespace.
+static LogicalResult parseInputOutputPair(StringRef line, StringRef &input,
+                                          StringRef &output) {
+  StringRef rest, trailing;
+  std::tie(input, rest) = llvm::getToken(line);
+  std::tie(output, trailing) = llvm::getToken(rest);
+  return success(!output.empty() && trailing.trim().empty());
+}
+
+/// Process the given input file and write its output to the given file, as if
+/// they had been passed on the command line. The input format is detected anew
+/// for every input unless the user specified one.
+static LogicalResult processFileAs(MLIRContext &context, TimingScope &ts,
+                                   StringRef input, StringRef output,
+                                   InputFormatKind format) {
+  inputFilename.setValue(input.str());
+  outputFilename.setValue(output.str());
+  inputFormat.setValue(format);
+  auto inputTimer = ts.nest(input);
+  return processFile(context, inputTimer);
+}
+
+/// Process every input listed in the batch manifest, one after the other.
+/// The inputs share the context, its thread pool, and the registered dialects
+/// and passes, which avoids paying for process start up on each of them. Every
+/// input is still processed with its own source manager and diagnostic
+/// handler, and a failing input does not stop the remaining ones.
+static LogicalResult processBatch(MLIRContext &context, TimingScope &ts) {
+  std::string errorMessage;
+  auto manifest = openInputFile(batchManifest, &errorMessage);
+  if (!manifest) {
+    llvm::errs() << errorMessage << "\n";
+    return failure();
+  }
+
+  SmallVector<std::pair<StringRef, StringRef>> entries;
+  SmallVector<StringRef> lines;
+  manifest->getBuffer().split(lines, '\n');
+  for (auto [lineIdx, line] : llvm::enumerate(lines)) {
+    line = line.trim();
+    if (line.empty() || line.startswith("#"))
+      continue;
+    StringRef input, output;
+    if (failed(parseInputOutputPair(line, input, output))) {
+      llvm::errs() << batchManifest << ":" << lineIdx + 1
+                   << ": expected an input and an output file\n";
+      return failure();
+    }
+    entries.push_back({input, output});
+  }
+
+  auto format = inputFormat.getValue();
+  unsigned numFailed = 0;
+  for (auto [input, output] : entries) {
+    if (succeeded(processFileAs(context, ts, input, output, format)))
+      continue;
+    llvm::errs() << "batch input '" << input << "' failed\n";
+    ++numFailed;
+  }
+
+  if (numFailed == 0)
+    return success();
+  llvm::errs() << numFailed << " of " << entries.size()
+               << " batch inputs failed\n";
+  return failure();
+}
 
+/// Read the next line from the standard input into `line`, without its line
+/// terminator. The input is read in chunks as they become available, such that
+/// a line can be handled as soon as it is complete. The remainder of the last
+/// chunk is kept in `pending`. Returns false once the input is closed and all
+/// of its lines have been read.
+static bool readLineFromStdin(std::string &pending, std::string &line) {
+  size_t newline;
+  while ((newline = pending.find('\n')) == std::string::npos) {
+    char chunk[4096];
+    auto bytesRead =
+        llvm::sys::fs::readNativeFile(llvm::sys::fs::getStdinHandle(), chunk);
+    if (!bytesRead)
+      llvm::errs() << "cannot read from the standard input: "
+                   << toString(bytesRead.takeError()) << "\n";
+    if (!bytesRead || *bytesRead == 0) {
+      if (pending.empty())
+        return false;
+      line = std::move(pending);
+      pending.clear();
+      return true;
+    }
+    pending.append(chunk, *bytesRead);
+  }
+  line = pending.substr(0, newline);
+  pending.erase(0, newline + 1);
+  return true;
+}
+
+/// Serve compile requests read from the standard input until it is closed.
+/// Each request is a line naming an input and an output file. The context and
+/// everything registered in it stay warm across requests, and a request whose
+/// inputs and options match a previous one reuses its output.
+static LogicalResult processServer(MLIRContext &context, TimingScope &ts) {
+  auto format = inputFormat.getValue();
+  std::string pending, line;
+  while (readLineFromStdin(pending, line)) {
+    StringRef request = StringRef(line).trim();
+    if (request.empty() || request.startswith("#"))
+      continue;
+    StringRef input, output;
+    if (failed(parseInputOutputPair(request, input, output))) {
+      llvm::errs() << "expected an input and an output file: '" << request
+                   << "'\n";
+      llvm::outs() << "error " << request << "\n";
+    } else if (output == "-") {
+      llvm::errs() << "server output cannot be written to stdout\n";
+      llvm::outs() << "error " << input << "\n";
+    } else {
+      auto result = processFileAs(context, ts, input, output, format);
+      llvm::outs() << (succeeded(result) ? "ok " : "error ") << input << "\n";
+    }
+    llvm::outs().flush();
+  }
   return success();
 }
 
+/// This implements the top-level logic for the firtool command, invoked once
+/// command line options are parsed and LLVM/MLIR are all set up and ready to
+/// go.
+static LogicalResult executeFirtool(MLIRContext &context) {
+  // Create the timing manager we use to sample execution times.
+  DefaultTimingManager tm;
+  applyDefaultTimingManagerCLOptions(tm);
+  auto ts = tm.getRootScope();
+
+  // Check that the checkpoint options make sense before doing any work.
+  if (checkpointAfter != CheckpointNone) {
+    if (checkpointAfter > getFinalStage()) {
+      llvm::errs() << "the pipeline for the requested output does not reach "
+                      "checkpoint stage '"
+                   << getCheckpointStageName(checkpointAfter) << "'\n";
+      return failure();
+    }
+    if (splitInputFile) {
+      llvm::errs() << "checkpoints cannot be used with split input\n";
+      return failure();
+    }
+  }
+  if (isMultiInput() &&
+      (checkpointAfter != CheckpointNone || !resumeFrom.empty())) {
+    llvm::errs() << "checkpoints cannot be used with batch or server input\n";
+    return failure();
+  }
+  if (!batchManifest.empty() && serverMode) {
+    llvm::errs() << "batch and server mode cannot be combined\n";
+    return failure();
+  }
+
+  // Register our dialects.
+  context.loadDialect<chirrtl::CHIRRTLDialect, firrtl::FIRRTLDialect,
+                      hw::HWDialect, comb::CombDialect, seq::SeqDialect,
+                      sv::SVDialect>();
+
+  // Process the input, all inputs of the batch, or the requests to the server.
+  LogicalResult result = success();
+  if (serverMode)
+    result = processServer(context, ts);
+  else if (!batchManifest.empty())
+    result = processBatch(context, ts);
+  else
+    result = processFile(context, ts);
+
+  // Write the performance report, which is also useful if a pass failed.
+  if (!perfReport.empty()) {
+    std::string errorMessage;
+    auto reportFile = openOutputFile(perfReport, &errorMessage);
+    if (!reportFile) {
+      llvm::errs() << errorMessage << "\n";
+      return failure();
+    }
+    passPerfReport.print(reportFile->os());
+    reportFile->keep();
+  }
+
+  return result;
+}
+
 /// Main driver for firtool command.  This sets up LLVM and MLIR, and parses
 /// command line options before passing off to 'executeFirtool'.  This is set up
 /// so we can `exit(0)` at the end of the program to avoid teardown of the
@@ -600,6 +1191,10 @@ int main(int argc, char **argv) {
   registerAsmPrinterCLOptions();
   cl::AddExtraVersionPrinter(
       [](raw_ostream &os) { os << getCirctVersion() << '\n'; });
+  for (int i = 1; i < argc; ++i) {
+    commandLine += argv[i];
+    commandLine += '\0';
+  }
   // Parse pass names in main to ensure static initialization completed.
   cl::ParseCommandLineOptions(argc, argv, "MLIR-based FIRRTL compiler\n");
 
@@ -0,0 +1,204 @@
+//===- fsm-runner.cpp - FSM machine simulator -----------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Tool which simulates an `fsm.machine` step by step, either with inputs read
+// from a stimulus file or with random inputs, and reports which states and
+// transitions were covered.
+//
+//===----------------------------------------------------------------------===//
+
+#include "circt/Dialect/Comb/CombDialect.h"
+#include "circt/Dialect/FSM/FSMDialect.h"
+#include "circt/Dialect/FSM/FSMSimulator.h"
+#include "circt/Dialect/HW/HWDialect.h"
+#include "circt/Support/Version.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/Parser/Parser.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SourceMgr.h"
+
+#include <random>
+
+using namespace llvm;
+using namespace mlir;
+using namespace circt;
+
+static cl::OptionCategory mainCategory("Application options");
+
+static cl::opt<std::string> inputFileName(cl::Positional,
+                                          cl::desc("<input file>"),
+                                          cl::init("-"), cl::cat(mainCategory));
+
+static cl::opt<std::string>
+    topMachine("top", cl::desc("The machine to simulate"),
+               cl::value_desc("name"), cl::cat(mainCategory));
+
+static cl::opt<std::string> stimulusFileName(
+    "stimulus",
+    cl::desc("A file with the inputs of one step per line, separated by "
+             "spaces; random inputs are used if not given"),
+    cl::value_desc("filename"), cl::cat(mainCategory));
+
+static cl::opt<uint64_t>
+    numSteps("steps",
+             cl::desc("The number of steps to simulate with random inputs"),
+             cl::init(1000), cl::cat(mainCategory));
+
+static cl::opt<uint64_t> seed("seed",
+                              cl::desc("The seed of the random inputs"),
+                              cl::init(0), cl::cat(mainCategory));
+
+static cl::opt<bool> trace("trace",
+                           cl::desc("Print the state and outputs of each step"),
+                           cl::init(false), cl::cat(mainCategory));
+
+static cl::opt<bool>
+    coverage("coverage",
+             cl::desc("Print the state and transition coverage at the end"),
+             cl::init(false), cl::cat(mainCategory));
+
+static void simulateStep(fsm::FSMSimulator &sim, ArrayRef<APInt> inputs) {
+  // The state is printed before the transition, next to the outputs it
+  // produced.
+  if (trace) {
+    uint64_t step = sim.getNumSteps();
+    unsigned state = sim.getCurrentState();
+    sim.step(inputs);
+    outs() << step << " " << sim.getStateName(state);
+    for (auto &output : sim.getOutputs()) {
+      outs() << " ";
+      output.print(outs(), /*isSigned=*/false);
+    }
+    outs() << "\n";
+    return;
+  }
+  sim.step(inputs);
+}
+
+/// Simulate the machine with the inputs in the stimulus file.
+static LogicalResult simulateStimulus(fsm::FSMSimulator &sim) {
+  auto bufferOrErr = MemoryBuffer::getFileOrSTDIN(stimulusFileName);
+  if (std::error_code error = bufferOrErr.getError()) {
+    errs() << "could not open stimulus file '" << stimulusFileName
+           << "': " << error.message() << "\n";
+    return failure();
+  }
+
+  auto widths = sim.getInputWidths();
+  SmallVector<APInt> inputs;
+  SmallVector<StringRef> fields;
+  StringRef rest = (*bufferOrErr)->getBuffer();
+  for (unsigned lineNo = 1; !rest.empty(); ++lineNo) {
+    StringRef line;
+    std::tie(line, rest) = rest.split('\n');
+    line = line.split('#').first.trim();
+    if (line.empty())
+      continue;
+
+    fields.clear();
+    line.split(fields, ' ', -1, /*KeepEmpty=*/false);
+    if (fields.size() != widths.size()) {
+      errs() << stimulusFileName << ":" << lineNo << ": expected "
+             << widths.size() << " inputs, got " << fields.size() << "\n";
+      return failure();
+    }
+    inputs.clear();
+    for (auto [field, width] : llvm::zip(fields, widths)) {
+      APInt value;
+      if (field.getAsInteger(0, value) || value.getActiveBits() > width) {
+        errs() << stimulusFileName << ":" << lineNo << ": invalid " << width
+               << "-bit input '" << field << "'\n";
+        return failure();
+      }
+      inputs.push_back(value.zextOrTrunc(width));
+    }
+    simulateStep(sim, inputs);
+  }
+  return success();
+}
+
+/// Simulate the machine with random inputs.
+static void simulateRandom(fsm::FSMSimulator &sim) {
+  std::mt19937_64 rng(seed);
+  auto widths = sim.getInputWidths();
+  SmallVector<APInt> inputs;
+  SmallVector<uint64_t> words;
+  for (auto width : widths)
+    inputs.push_back(APInt(width, 0));
+  for (uint64_t i = 0; i < numSteps; ++i) {
+    for (auto [input, width] : llvm::zip(inputs, widths)) {
+      words.clear();
+      for (unsigned bit = 0; bit < width; bit += 64)
+        words.push_back(rng());
+      input = APInt(width, words);
+    }
+    simulateStep(sim, inputs);
+  }
+}
+
+int main(int argc, char **argv) {
+  InitLLVM y(argc, argv);
+
+  // Set the bug report message to indicate users should file issues on
+  // llvm/circt and not llvm/llvm-project.
+  setBugReportMsg(circtBugReportMsg);
+
+  cl::HideUnrelatedOptions(mainCategory);
+  cl::ParseCommandLineOptions(argc, argv, "FSM machine simulator\n");
+
+  auto fileOrErr = MemoryBuffer::getFileOrSTDIN(inputFileName);
+  if (std::error_code error = fileOrErr.getError()) {
+    errs() << argv[0] << ": could not open input file '" << inputFileName
+           << "': " << error.message() << "\n";
+    return 1;
+  }
+
+  MLIRContext context;
+  context.loadDialect<arith::ArithDialect, comb::CombDialect, fsm::FSMDialect,
+                      hw::HWDialect>();
+
+  SourceMgr sourceMgr;
+  sourceMgr.AddNewSourceBuffer(std::move(*fileOrErr), SMLoc());
+  OwningOpRef<ModuleOp> module(parseSourceFile<ModuleOp>(sourceMgr, &context));
+  if (!module)
+    return 1;
+
+  // Simulate the named machine, or the first one if no name is given.
+  fsm::MachineOp machine;
+  for (auto machineOp : module->getOps<fsm::MachineOp>()) {
+    if (topMachine.empty() || machineOp.getSymName() == topMachine) {
+      machine = machineOp;
+      break;
+    }
+  }
+  if (!machine) {
+    errs() << "no machine";
+    if (!topMachine.empty())
+      errs() << " named '" << topMachine << "'";
+    errs() << " found\n";
+    return 1;
+  }
+
+  auto sim = fsm::FSMSimulator::create(machine);
+  if (failed(sim))
+    return 1;
+
+  if (!stimulusFileName.empty()) {
+    if (failed(simulateStimulus(**sim)))
+      return 1;
+  } else {
+    simulateRandom(**sim);
+  }
+
+  if (coverage)
+    (*sim)->printCoverage(outs());
+  return 0;
+}
@@ -11,7 +11,9 @@
 //
 //===----------------------------------------------------------------------===//
 
-#include <list>
+#include <deque>
+#include <optional>
+#include <variant>
 
 #include "circt/Dialect/Handshake/HandshakeOps.h"
 #include "circt/Dialect/Handshake/Simulation.h"
@@ -19,10 +21,12 @@
 #include "mlir/Dialect/ControlFlow/IR/ControlFlowOps.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/IR/AsmState.h"
 #include "mlir/IR/BuiltinTypes.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/TypeSwitch.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/Format.h"
 
 #define DEBUG_TYPE "runner"
 
@@ -158,20 +162,63 @@ void printAnyValueWithType(llvm::raw_ostream &out, mlir::Type type,
   }
 }
 
-void scheduleIfNeeded(std::list<mlir::Operation *> &readyList,
-                      llvm::DenseMap<mlir::Value, Any> & /*valueMap*/,
-                      mlir::Operation *op) {
-  if (std::find(readyList.begin(), readyList.end(), op) == readyList.end()) {
-    readyList.push_back(op);
+/// The operations of a handshake function which may be ready to execute, in the
+/// order in which they were scheduled. The operations are numbered once up
+/// front such that scheduling an operation which is already queued is a
+/// constant-time check rather than a search through the queue, and such that
+/// the interface lookup of each operation is done only once.
+class ReadyQueue {
+public:
+  struct Entry {
+    mlir::Operation *op;
+    handshake::ExecutableOpInterface executable;
+  };
+
+  explicit ReadyQueue(mlir::Block &body) {
+    for (auto &op : body) {
+      indices[&op] = entries.size();
+      entries.push_back({&op, dyn_cast<handshake::ExecutableOpInterface>(op)});
+    }
+    queued.resize(entries.size());
   }
-}
-void scheduleUses(std::list<mlir::Operation *> &readyList,
-                  llvm::DenseMap<mlir::Value, Any> &valueMap,
-                  mlir::Value value) {
-  for (auto &use : value.getUses()) {
-    scheduleIfNeeded(readyList, valueMap, use.getOwner());
+
+  bool empty() const { return queue.empty(); }
+
+  /// Queue the operation, unless it is already queued.
+  void schedule(mlir::Operation *op) {
+    auto it = indices.find(op);
+    assert(it != indices.end() && "operation outside of the function");
+    if (queued[it->second])
+      return;
+    queued[it->second] = true;
+    queue.push_back(it->second);
+  }
+
+  /// Queue the users of the value.
+  void scheduleUses(mlir::Value value) {
+    for (auto *user : value.getUsers())
+      schedule(user);
+  }
+
+  /// Remove the next operation from the queue.
+  const Entry &pop() {
+    unsigned index = queue.front();
+    queue.pop_front();
+    queued[index] = false;
+    return entries[index];
   }
-}
+
+  auto getQueuedOps() const {
+    return llvm::map_range(queue,
+                           [&](unsigned index) { return entries[index].op; });
+  }
+
+private:
+  std::vector<Entry> entries;
+  llvm::DenseMap<mlir::Operation *, unsigned> indices;
+  std::vector<bool> queued;
+  std::deque<unsigned> queue;
+};
 
 // Allocate a new matrix with dimensions given by the type, in the
 // given store.  Return the pseudo-pointer to the new matrix in the
@@ -213,6 +260,27 @@ unsigned allocateMemRef(mlir::MemRefType type, std::vector<Any> &in,
 // Handshake executer
 //===----------------------------------------------------------------------===//
 
+enum ExecuteStrategy { Default = 1 << 0, Continue = 1 << 1, Return = 1 << 2 };
+
+/// Throughput statistics of a channel, gathered in cycle-accurate mode.
+struct ChannelStats {
+  /// The number of tokens that passed through the channel.
+  uint64_t tokens = 0;
+  /// The number of cycles at the end of which the channel held a token which
+  /// its consumer had not accepted.
+  uint64_t stallCycles = 0;
+  /// The cycles in which the first and the last token entered the channel.
+  uint64_t firstTokenCycle = 0;
+  uint64_t lastTokenCycle = 0;
+};
+
+/// Occupancy statistics of a buffer, gathered in cycle-accurate mode.
+struct BufferStats {
+  /// The sum over all cycles of the number of occupied slots.
+  uint64_t occupiedSlotCycles = 0;
+  unsigned maxOccupancy = 0;
+};
+
 class HandshakeExecuter {
 public:
   /// Entry point for mlir::func::FuncOp top-level functions
@@ -230,11 +298,24 @@ public:
                     std::vector<Any> &results, std::vector<double> &resultTimes,
                     std::vector<std::vector<Any>> &store,
                     std::vector<double> &storeTimes,
-                    mlir::OwningOpRef<mlir::ModuleOp> &module);
+                    mlir::OwningOpRef<mlir::ModuleOp> &module,
+                    const CycleAccurateOptions *cycleAccurate = nullptr);
 
   bool succeeded() const { return successFlag; }
 
 private:
+  /// Execute an operation which does not implement the ExecutableOpInterface.
+  LogicalResult executeGenericOp(Operation &op, std::vector<Any> &in,
+                                 std::vector<Any> &out,
+                                 ExecuteStrategy &strat);
+
+  /// Execute a handshake function cycle by cycle, until its return operation
+  /// fires.
+  LogicalResult
+  executeCycleAccurate(handshake::FuncOp func,
+                       llvm::DenseMap<unsigned, unsigned> &memoryMap,
+                       const CycleAccurateOptions &options);
+
   /// Operation execution visitors
   LogicalResult execute(mlir::arith::ConstantIndexOp,
                         std::vector<Any> & /*inputs*/,
@@ -289,7 +370,10 @@ private:
                         std::vector<Any> &);
 
 private:
-  /// Execution context variables
+  /// Execution context variables. The tokens are kept as `Any` in maps keyed by
+  /// their channel, since this is how ExecutableOpInterface passes them to the
+  /// handshake operations. Moving to values numbered into typed slots has to
+  /// change that interface and all of its implementations along with these.
   llvm::DenseMap<mlir::Value, Any> &valueMap;
   llvm::DenseMap<mlir::Value, double> &timeMap;
   std::vector<Any> &results;
@@ -688,7 +772,28 @@ LogicalResult HandshakeExecuter::execute(handshake::InstanceOp instanceOp,
   llvm_unreachable("Fatal error reached before this point");
 }
 
-enum ExecuteStrategy { Default = 1 << 0, Continue = 1 << 1, Return = 1 << 2 };
+LogicalResult HandshakeExecuter::executeGenericOp(Operation &op,
+                                                  std::vector<Any> &in,
+                                                  std::vector<Any> &out,
+                                                  ExecuteStrategy &strat) {
+  return llvm::TypeSwitch<Operation *, LogicalResult>(&op)
+      .Case<mlir::arith::ConstantIndexOp, mlir::arith::ConstantIntOp,
+            mlir::arith::AddIOp, mlir::arith::AddFOp, mlir::arith::CmpIOp,
+            mlir::arith::CmpFOp, mlir::arith::SubIOp, mlir::arith::SubFOp,
+            mlir::arith::MulIOp, mlir::arith::MulFOp, mlir::arith::DivSIOp,
+            mlir::arith::DivUIOp, mlir::arith::DivFOp, mlir::arith::IndexCastOp,
+            mlir::arith::ExtSIOp, mlir::arith::ExtUIOp, mlir::arith::XOrIOp,
+            handshake::InstanceOp>([&](auto op) {
+        strat = ExecuteStrategy::Default;
+        return execute(op, in, out);
+      })
+      .Case<handshake::ReturnOp>([&](auto op) {
+        strat = ExecuteStrategy::Return;
+        return execute(op, in, out);
+      })
+      .Default(
+          [](auto op) { return op->emitOpError() << "Unknown operation"; });
+}
 
 HandshakeExecuter::HandshakeExecuter(
     mlir::func::FuncOp &toplevel, llvm::DenseMap<mlir::Value, Any> &valueMap,
@@ -701,12 +806,17 @@ HandshakeExecuter::HandshakeExecuter(
   mlir::Block &entryBlock = toplevel.getBody().front();
   instIter = entryBlock.begin();
 
+  // The operands and results of the instruction being executed, kept across
+  // iterations to avoid reallocating them for every instruction.
+  std::vector<Any> inValues;
+  std::vector<Any> outValues;
+
   // Main executive loop.  Start at the first instruction of the entry
   // block.  Fetch and execute instructions until we hit a terminator.
   while (true) {
     mlir::Operation &op = *instIter;
-    std::vector<Any> inValues(op.getNumOperands());
-    std::vector<Any> outValues(op.getNumResults());
+    inValues.assign(op.getNumOperands(), Any());
+    outValues.assign(op.getNumResults(), Any());
     LLVM_DEBUG(dbgs() << "OP:  " << op.getName() << "\n");
     time = 0.0;
     for (auto in : enumerate(op.getOperands())) {
@@ -768,7 +878,8 @@ HandshakeExecuter::HandshakeExecuter(
     handshake::FuncOp &func, llvm::DenseMap<mlir::Value, Any> &valueMap,
     llvm::DenseMap<mlir::Value, double> &timeMap, std::vector<Any> &results,
     std::vector<double> &resultTimes, std::vector<std::vector<Any>> &store,
-    std::vector<double> &storeTimes, mlir::OwningOpRef<mlir::ModuleOp> &module)
+    std::vector<double> &storeTimes, mlir::OwningOpRef<mlir::ModuleOp> &module,
+    const CycleAccurateOptions *cycleAccurate)
     : valueMap(valueMap), timeMap(timeMap), results(results),
       resultTimes(resultTimes), store(store), storeTimes(storeTimes),
       module(&module) {
@@ -776,8 +887,8 @@ HandshakeExecuter::HandshakeExecuter(
   mlir::Block &entryBlock = func.getBody().front();
   // The arguments of the entry block.
   mlir::Block::BlockArgListType blockArgs = entryBlock.getArguments();
-  // A list of operations which might be ready to execute.
-  std::list<mlir::Operation *> readyList;
+  // The operations which might be ready to execute.
+  ReadyQueue readyList(entryBlock);
   // A map of memory ops
   llvm::DenseMap<unsigned, unsigned> memoryMap;
 
@@ -798,34 +909,47 @@ HandshakeExecuter::HandshakeExecuter(
       Value bufferRes = bufferOp.getResult();
       valueMap[bufferRes] = APInt(bufferRes.getType().getIntOrFloatBitWidth(),
                                   initValues.front());
-      scheduleUses(readyList, valueMap, bufferRes);
+      readyList.scheduleUses(bufferRes);
     }
   }
 
+  if (cycleAccurate) {
+    successFlag =
+        mlir::succeeded(executeCycleAccurate(func, memoryMap, *cycleAccurate));
+    return;
+  }
+
   for (auto blockArg : blockArgs)
-    scheduleUses(readyList, valueMap, blockArg);
+    readyList.scheduleUses(blockArg);
+
+  // The operands and results of the operation being executed, kept across
+  // iterations to avoid reallocating them for every operation.
+  std::vector<Any> inValues;
+  std::vector<Any> outValues;
+  std::vector<mlir::Value> scheduleList;
 
 #define EXTRA_DEBUG
   while (true) {
 #ifdef EXTRA_DEBUG
-    LLVM_DEBUG(
-        for (auto t
-             : readyList) { dbgs() << "READY: " << *t << "\n"; } dbgs()
-            << "Live: " << valueMap.size() << "\n";
-        for (auto t
-             : valueMap) { debugArg("Value:", t.first, t.second, 0.0); });
+    LLVM_DEBUG({
+      for (auto *t : readyList.getQueuedOps())
+        dbgs() << "READY: " << *t << "\n";
+      dbgs() << "Live: " << valueMap.size() << "\n";
+      for (auto t : valueMap)
+        debugArg("Value:", t.first, t.second, 0.0);
+    });
 #endif
-    assert(readyList.size() > 0 &&
+    assert(!readyList.empty() &&
            "Expected some instruction to be ready for execution");
-    mlir::Operation &op = *readyList.front();
-    readyList.pop_front();
+    auto [opPtr, handshakeOp] = readyList.pop();
+    mlir::Operation &op = *opPtr;
 
     // Execute handshake ops through ExecutableOpInterface
-    if (auto handshakeOp = dyn_cast<handshake::ExecutableOpInterface>(op)) {
-      std::vector<mlir::Value> scheduleList;
+    if (handshakeOp) {
+      scheduleList.clear();
       if (!handshakeOp.tryExecute(valueMap, memoryMap, timeMap, store,
                                   scheduleList))
-        readyList.push_back(&op);
+        readyList.schedule(&op);
       else {
         LLVM_DEBUG({
           dbgs() << "EXECUTED: " << op << "\n";
@@ -835,32 +959,38 @@ HandshakeExecuter::HandshakeExecuter(
               debugArg("OUT", out, valueMap[out], time);
           }
         });
+        // Merges forward one of several available tokens at a time, so come
+        // back for the ones left behind.
+        if (llvm::any_of(op.getOperands(),
+                         [&](mlir::Value in) { return valueMap.count(in); }))
+          readyList.schedule(&op);
       }
       for (mlir::Value out : scheduleList)
-        scheduleUses(readyList, valueMap, out);
+        readyList.scheduleUses(out);
       continue;
     }
 
     int64_t i = 0;
-    std::vector<Any> inValues(op.getNumOperands());
-    std::vector<Any> outValues(op.getNumResults());
+    inValues.assign(op.getNumOperands(), Any());
+    outValues.assign(op.getNumResults(), Any());
     bool reschedule = false;
     LLVM_DEBUG(dbgs() << "OP: (" << op.getNumOperands() << "->"
                       << op.getNumResults() << ")" << op << "\n");
     time = 0;
     for (mlir::Value in : op.getOperands()) {
-      if (valueMap.count(in) == 0) {
+      auto valueIt = valueMap.find(in);
+      if (valueIt == valueMap.end()) {
         reschedule = true;
         continue;
       }
-      inValues[i] = valueMap[in];
+      inValues[i] = valueIt->second;
       time = std::max(time, timeMap[in]);
       LLVM_DEBUG(debugArg("IN", in, inValues[i], timeMap[in]));
       ++i;
     }
     if (reschedule) {
       LLVM_DEBUG(dbgs() << "Rescheduling data...\n");
-      readyList.push_back(&op);
+      readyList.schedule(&op);
       continue;
     }
     // Consume the inputs.
@@ -868,26 +998,7 @@ HandshakeExecuter::HandshakeExecuter(
       valueMap.erase(in);
 
     ExecuteStrategy strat = ExecuteStrategy::Default;
-    LogicalResult res =
-        llvm::TypeSwitch<Operation *, LogicalResult>(&op)
-            .Case<mlir::arith::ConstantIndexOp, mlir::arith::ConstantIntOp,
-                  mlir::arith::AddIOp, mlir::arith::AddFOp, mlir::arith::CmpIOp,
-                  mlir::arith::CmpFOp, mlir::arith::SubIOp, mlir::arith::SubFOp,
-                  mlir::arith::MulIOp, mlir::arith::MulFOp,
-                  mlir::arith::DivSIOp, mlir::arith::DivUIOp,
-                  mlir::arith::DivFOp, mlir::arith::IndexCastOp,
-                  mlir::arith::ExtSIOp, mlir::arith::ExtUIOp,
-                  mlir::arith::XOrIOp, handshake::InstanceOp>([&](auto op) {
-              strat = ExecuteStrategy::Default;
-              return execute(op, inValues, outValues);
-            })
-            .Case<handshake::ReturnOp>([&](auto op) {
-              strat = ExecuteStrategy::Return;
-              return execute(op, inValues, outValues);
-            })
-            .Default([](auto op) {
-              return op->emitOpError() << "Unknown operation";
-            });
+    LogicalResult res = executeGenericOp(op, inValues, outValues, strat);
     LLVM_DEBUG(dbgs() << "EXECUTED: " << op << "\n");
 
     if (res.failed()) {
@@ -903,8 +1014,855 @@ HandshakeExecuter::HandshakeExecuter(
       assert(outValues[out.index()].has_value());
       valueMap[out.value()] = outValues[out.index()];
       timeMap[out.value()] = time + 1;
-      scheduleUses(readyList, valueMap, out.value());
+      readyList.scheduleUses(out.value());
+    }
+    ++instructionsExecuted;
+  }
+}
+
+/// Print the throughput statistics gathered during a cycle-accurate
+/// simulation, with one line per channel and per buffer in program order.
+static void
+printThroughputReport(raw_ostream &os, handshake::FuncOp func, uint64_t cycles,
+                      llvm::DenseMap<mlir::Value, ChannelStats> &channelStats,
+                      llvm::DenseMap<Operation *, BufferStats> &bufferStats) {
+  mlir::AsmState state(func);
+  auto printChannel = [&](mlir::Value channel) {
+    auto it = channelStats.find(channel);
+    if (it == channelStats.end())
+      return;
+    auto &stats = it->second;
+    os << "  ";
+    channel.printAsOperand(os, state);
+    os << ": tokens=" << stats.tokens << " stalls=" << stats.stallCycles;
+    // The achieved initiation interval is the average distance between two
+    // consecutive tokens.
+    if (stats.tokens > 1) {
+      uint64_t span = stats.lastTokenCycle - stats.firstTokenCycle;
+      os << " ii=" << format("%.2f", double(span) / (stats.tokens - 1));
+    }
+    os << "\n";
+  };
+
+  os << "Cycles: " << cycles << "\n";
+  os << "Channels:\n";
+  mlir::Block &body = func.getBody().front();
+  for (auto arg : body.getArguments())
+    printChannel(arg);
+  for (auto &op : body)
+    for (auto result : op.getResults())
+      printChannel(result);
+
+  os << "Buffers:\n";
+  for (auto bufferOp : body.getOps<handshake::BufferOp>()) {
+    auto &stats = bufferStats[bufferOp];
+    os << "  ";
+    bufferOp.getResult().printAsOperand(os, state);
+    os << ": slots=" << bufferOp.getNumSlots() << " occupancy="
+       << format("%.2f", double(stats.occupiedSlotCycles) / cycles)
+       << " max-occupancy=" << stats.maxOccupancy << "\n";
+  }
+}
+
+/// Operations fire as soon as their inputs are available and their outputs are
+/// free. Within a cycle, tokens propagate through chains of such operations
+/// like through combinational logic, but each operation fires at most once. A
+/// token entering a buffer leaves it in a later cycle at the earliest, and a
+/// buffer accepts tokens only while it has free slots, which models the
+/// back-pressure of full buffers.
+LogicalResult HandshakeExecuter::executeCycleAccurate(
+    handshake::FuncOp func, llvm::DenseMap<unsigned, unsigned> &memoryMap,
+    const CycleAccurateOptions &options) {
+  SmallVector<Operation *> ops;
+  for (auto &op : func.getBody().front())
+    ops.push_back(&op);
+
+  // The tokens held by each buffer, along with the cycle they entered it.
+  llvm::DenseMap<Operation *, std::deque<std::pair<Any, uint64_t>>>
+      bufferSlots;
+  llvm::DenseMap<mlir::Value, ChannelStats> channelStats;
+  llvm::DenseMap<Operation *, BufferStats> bufferStats;
+  auto recordToken = [&](mlir::Value channel, uint64_t cycle) {
+    auto &stats = channelStats[channel];
+    if (stats.tokens++ == 0)
+      stats.firstTokenCycle = cycle;
+    stats.lastTokenCycle = cycle;
+  };
+
+  // The tokens available at the start of the simulation.
+  for (auto &[channel, value] : valueMap)
+    recordToken(channel, 0);
+
+  std::vector<Any> inValues;
+  std::vector<Any> outValues;
+  std::vector<mlir::Value> scheduleList;
+  std::vector<bool> fired(ops.size());
+  std::vector<bool> bufferEmitted(ops.size());
+  for (uint64_t cycle = 0;; ++cycle) {
+    if (options.maxCycles && cycle == options.maxCycles)
+      return func.emitError() << "simulation did not finish within "
+                              << options.maxCycles << " cycles";
+
+    fired.assign(ops.size(), false);
+    bufferEmitted.assign(ops.size(), false);
+    bool anyFired = false;
+    bool returned = false;
+    for (bool changed = true; changed && !returned;) {
+      changed = false;
+      for (auto [index, op] : llvm::enumerate(ops)) {
+        // Buffers emit and accept tokens independently of each other, at most
+        // once per cycle each.
+        if (auto bufferOp = dyn_cast<handshake::BufferOp>(op)) {
+          auto &slots = bufferSlots[op];
+          mlir::Value in = bufferOp.getOperand();
+          mlir::Value out = bufferOp.getResult();
+          if (!bufferEmitted[index] && !slots.empty() &&
+              slots.front().second < cycle && !valueMap.count(out)) {
+            valueMap[out] = slots.front().first;
+            slots.pop_front();
+            recordToken(out, cycle);
+            bufferEmitted[index] = true;
+            changed = true;
+          }
+          auto inIt = valueMap.find(in);
+          if (!fired[index] && inIt != valueMap.end() &&
+              slots.size() < static_cast<size_t>(bufferOp.getNumSlots())) {
+            slots.push_back({inIt->second, cycle});
+            valueMap.erase(inIt);
+            fired[index] = true;
+            changed = true;
+          }
+          continue;
+        }
+
+        if (fired[index])
+          continue;
+
+        // Executable operations check themselves that the tokens they consume
+        // are available and that the results they produce are free. Memories
+        // may serve some of their ports while reporting that others are not
+        // ready, which still counts as firing.
+        if (auto executable = dyn_cast<handshake::ExecutableOpInterface>(op)) {
+          scheduleList.clear();
+          if (!executable.tryExecute(valueMap, memoryMap, timeMap, store,
+                                     scheduleList) &&
+              scheduleList.empty())
+            continue;
+          for (auto out : scheduleList)
+            recordToken(out, cycle);
+          fired[index] = changed = true;
+          ++instructionsExecuted;
+          continue;
+        }
+
+        // Any other operation fires once all of its operands are available
+        // and all of its results have been consumed.
+        if (!llvm::all_of(op->getOperands(),
+                          [&](auto in) { return valueMap.count(in); }) ||
+            llvm::any_of(op->getResults(),
+                         [&](auto out) { return valueMap.count(out); }))
+          continue;
+        inValues.clear();
+        for (auto in : op->getOperands()) {
+          inValues.push_back(valueMap[in]);
+          valueMap.erase(in);
+        }
+        outValues.assign(op->getNumResults(), Any());
+        ExecuteStrategy strat = ExecuteStrategy::Default;
+        if (failed(executeGenericOp(*op, inValues, outValues, strat)))
+          return failure();
+        fired[index] = changed = true;
+        ++instructionsExecuted;
+        if (strat & ExecuteStrategy::Return) {
+          returned = true;
+          break;
+        }
+        for (auto [out, value] : llvm::zip(op->getResults(), outValues)) {
+          valueMap[out] = value;
+          recordToken(out, cycle);
+        }
+      }
+      anyFired |= changed;
+    }
+
+    if (returned) {
+      for (auto &resultTime : resultTimes)
+        resultTime = cycle;
+      if (options.report)
+        printThroughputReport(*options.report, func, cycle + 1, channelStats,
+                              bufferStats);
+      return success();
+    }
+
+    if (!anyFired)
+      return func.emitError() << "simulation deadlocked in cycle " << cycle;
+
+    // Gather the statistics of the tokens left at the end of the cycle.
+    for (auto &[channel, value] : valueMap)
+      ++channelStats[channel].stallCycles;
+    for (auto &[bufferOp, slots] : bufferSlots) {
+      auto &stats = bufferStats[bufferOp];
+      stats.occupiedSlotCycles += slots.size();
+      stats.maxOccupancy =
+          std::max(stats.maxOccupancy, static_cast<unsigned>(slots.size()));
+    }
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// Typed handshake executer
+//===----------------------------------------------------------------------===//
+
+/// A token held by a channel in the typed executer. This is a tagged union of
+/// the integer and floating point values the handshake-runner supports. APInt
+/// stores integers of up to 64 bits inline, so that most tokens do not
+/// allocate.
+using Token = std::variant<APInt, APFloat>;
+
+/// An executer for handshake functions which works on a pre-compiled form of
+/// the function. The channels are numbered into dense slots holding typed
+/// tokens, and each operation gets a dispatch record with the slots of its
+/// operands and results, instead of keeping the tokens as `Any` in maps keyed
+/// by their channel. Operations are fired in the same order as in the default
+/// executer. The typed executer covers the dataflow subset of the handshake
+/// dialect: it does not support instances, external memories and tuples.
+class TypedHandshakeExecuter {
+public:
+  /// Check whether the function can be executed by the typed executer, and
+  /// emit an error if it cannot.
+  static LogicalResult verifySupported(handshake::FuncOp func);
+
+  explicit TypedHandshakeExecuter(handshake::FuncOp func);
+
+  /// Execute the function. The arguments are taken from `valueMap` and
+  /// `timeMap`, and the results are stored to `results` and `resultTimes`.
+  LogicalResult run(llvm::DenseMap<mlir::Value, Any> &valueMap,
+                    llvm::DenseMap<mlir::Value, double> &timeMap,
+                    std::vector<Any> &results,
+                    std::vector<double> &resultTimes);
+
+private:
+  /// The kinds of operations, in two groups: handshake operations, which
+  /// check themselves whether they can fire, and operations which fire once
+  /// all of their operands are available.
+  enum class OpKind {
+    Fork,
+    Join,
+    Sync,
+    Branch,
+    Buffer,
+    Constant,
+    Store,
+    Merge,
+    Mux,
+    ControlMerge,
+    ConditionalBranch,
+    Sink,
+    Memory,
+    Load,
+    // Operations firing once all of their operands are available.
+    Return,
+    ArithConstant,
+    AddI,
+    SubI,
+    MulI,
+    DivSI,
+    DivUI,
+    XOrI,
+    CmpI,
+    IndexCast,
+    ExtSI,
+    ExtUI,
+  };
+
+  /// The dispatch record of an operation.
+  struct OpRecord {
+    OpKind kind;
+    Operation *op;
+    /// The slots of the operands and results, as ranges of `slotLists`.
+    unsigned operandsBegin = 0;
+    unsigned numOperands = 0;
+    unsigned resultsBegin = 0;
+    unsigned numResults = 0;
+    /// The latency of handshake operations which fire once all of their
+    /// operands are available and all of their results are free.
+    double latency = 0;
+    /// The value of constants.
+    APInt constant;
+    /// The predicate of comparisons.
+    mlir::arith::CmpIPredicate predicate = mlir::arith::CmpIPredicate::eq;
+    /// The result width of casts and extensions.
+    unsigned width = 0;
+    /// The index into `memories` and the number of ports of memories.
+    unsigned memory = 0;
+    unsigned ldCount = 0;
+    unsigned stCount = 0;
+  };
+
+  static std::optional<OpKind> getOpKind(Operation *op);
+  static bool isSupportedType(Type type);
+
+  unsigned getOperand(const OpRecord &record, unsigned index) const {
+    return slotLists[record.operandsBegin + index];
+  }
+  unsigned getResult(const OpRecord &record, unsigned index) const {
+    return slotLists[record.resultsBegin + index];
+  }
+
+  /// Place a token in a slot.
+  void put(unsigned slot, Token token, double time) {
+    tokens[slot] = std::move(token);
+    full[slot] = true;
+    times[slot] = time;
+  }
+
+  /// Queue an operation, unless it is already queued.
+  void schedule(unsigned index) {
+    if (queued[index])
+      return;
+    queued[index] = true;
+    queue.push_back(index);
+  }
+
+  /// Queue the users of a slot.
+  void scheduleUses(unsigned slot) {
+    for (unsigned i = usersBegin[slot], e = usersBegin[slot + 1]; i != e; ++i)
+      schedule(userLists[i]);
+  }
+
+  /// Try to fire a handshake operation, adding the slots it filled to
+  /// `filled`. Returns false if the operation could not fire completely.
+  bool tryExecute(const OpRecord &record, SmallVectorImpl<unsigned> &filled);
+  bool tryExecuteMemory(const OpRecord &record,
+                        SmallVectorImpl<unsigned> &filled);
+  bool tryExecuteLoad(const OpRecord &record,
+                      SmallVectorImpl<unsigned> &filled);
+
+  /// Compute the result of an operation whose operands are all available.
+  FailureOr<Token> execute(const OpRecord &record);
+
+  handshake::FuncOp func;
+  std::vector<OpRecord> records;
+  std::vector<unsigned> slotLists;
+  /// The operations using each slot, as ranges of `userLists`.
+  std::vector<unsigned> usersBegin;
+  std::vector<unsigned> userLists;
+
+  /// The state of the channels, indexed by slot.
+  std::vector<Token> tokens;
+  std::vector<bool> full;
+  std::vector<double> times;
+  std::vector<std::vector<Token>> memories;
+
+  /// The operations which may be ready to execute, in the order in which they
+  /// were scheduled.
+  std::vector<bool> queued;
+  std::deque<unsigned> queue;
+};
+
+std::optional<TypedHandshakeExecuter::OpKind>
+TypedHandshakeExecuter::getOpKind(Operation *op) {
+  using Kind = std::optional<OpKind>;
+  return llvm::TypeSwitch<Operation *, Kind>(op)
+      .Case([](handshake::ForkOp) { return OpKind::Fork; })
+      .Case([](handshake::JoinOp) { return OpKind::Join; })
+      .Case([](handshake::SyncOp) { return OpKind::Sync; })
+      .Case([](handshake::BranchOp) { return OpKind::Branch; })
+      .Case([](handshake::BufferOp) { return OpKind::Buffer; })
+      .Case([](handshake::ConstantOp op) -> Kind {
+        if (!op->getAttrOfType<mlir::IntegerAttr>("value"))
+          return std::nullopt;
+        return OpKind::Constant;
+      })
+      .Case([](handshake::StoreOp) { return OpKind::Store; })
+      .Case([](handshake::MergeOp) { return OpKind::Merge; })
+      .Case([](handshake::MuxOp) { return OpKind::Mux; })
+      .Case([](handshake::ControlMergeOp) { return OpKind::ControlMerge; })
+      .Case([](handshake::ConditionalBranchOp) {
+        return OpKind::ConditionalBranch;
+      })
+      .Case([](handshake::SinkOp) { return OpKind::Sink; })
+      .Case([](handshake::MemoryOp op) -> Kind {
+        auto type = op.getMemRefType();
+        if (!type.hasStaticShape() ||
+            !type.getElementType().isa<mlir::IntegerType, mlir::FloatType>())
+          return std::nullopt;
+        return OpKind::Memory;
+      })
+      .Case([](handshake::LoadOp) { return OpKind::Load; })
+      .Case([](handshake::ReturnOp) { return OpKind::Return; })
+      .Case([](mlir::arith::ConstantOp op) -> Kind {
+        if (!op.getValue().isa<mlir::IntegerAttr>())
+          return std::nullopt;
+        return OpKind::ArithConstant;
+      })
+      .Case([](mlir::arith::AddIOp) { return OpKind::AddI; })
+      .Case([](mlir::arith::SubIOp) { return OpKind::SubI; })
+      .Case([](mlir::arith::MulIOp) { return OpKind::MulI; })
+      .Case([](mlir::arith::DivSIOp) { return OpKind::DivSI; })
+      .Case([](mlir::arith::DivUIOp) { return OpKind::DivUI; })
+      .Case([](mlir::arith::XOrIOp) { return OpKind::XOrI; })
+      .Case([](mlir::arith::CmpIOp) { return OpKind::CmpI; })
+      .Case([](mlir::arith::IndexCastOp op) -> Kind {
+        if (!op.getOut().getType().isIntOrIndex())
+          return std::nullopt;
+        return OpKind::IndexCast;
+      })
+      .Case([](mlir::arith::ExtSIOp) { return OpKind::ExtSI; })
+      .Case([](mlir::arith::ExtUIOp) { return OpKind::ExtUI; })
+      .Default([](Operation *) -> Kind { return std::nullopt; });
+}
+
+bool TypedHandshakeExecuter::isSupportedType(Type type) {
+  return type.isa<mlir::IntegerType, mlir::IndexType, mlir::FloatType,
+                  mlir::NoneType>();
+}
+
+LogicalResult TypedHandshakeExecuter::verifySupported(handshake::FuncOp func) {
+  for (auto arg : func.getArguments())
+    if (!isSupportedType(arg.getType()))
+      return func.emitOpError()
+             << "has an argument of type '" << arg.getType()
+             << "' which the typed core does not support";
+  for (auto &op : func.getBody().front()) {
+    if (!getOpKind(&op))
+      return op.emitOpError() << "is not supported by the typed core";
+    for (auto type : op.getResultTypes())
+      if (!isSupportedType(type))
+        return op.emitOpError()
+               << "has a result of type '" << type
+               << "' which the typed core does not support";
+  }
+  return success();
+}
+
+TypedHandshakeExecuter::TypedHandshakeExecuter(handshake::FuncOp func)
+    : func(func) {
+  mlir::Block &body = func.getBody().front();
+
+  // Number the channels: the arguments first, then the results of the
+  // operations in program order.
+  llvm::DenseMap<mlir::Value, unsigned> slots;
+  std::vector<mlir::Value> values;
+  auto addSlot = [&](mlir::Value value) {
+    slots.insert({value, values.size()});
+    values.push_back(value);
+  };
+  for (auto arg : body.getArguments())
+    addSlot(arg);
+  llvm::DenseMap<Operation *, unsigned> opIndices;
+  for (auto &op : body) {
+    opIndices.insert({&op, opIndices.size()});
+    for (auto result : op.getResults())
+      addSlot(result);
+  }
+
+  // Build the dispatch records.
+  records.reserve(opIndices.size());
+  for (auto &op : body) {
+    OpRecord record;
+    record.kind = *getOpKind(&op);
+    record.op = &op;
+    record.operandsBegin = slotLists.size();
+    record.numOperands = op.getNumOperands();
+    for (auto operand : op.getOperands())
+      slotLists.push_back(slots.lookup(operand));
+    record.resultsBegin = slotLists.size();
+    record.numResults = op.getNumResults();
+    for (auto result : op.getResults())
+      slotLists.push_back(slots.lookup(result));
+
+    llvm::TypeSwitch<Operation *>(&op)
+        .Case<handshake::ForkOp, handshake::JoinOp, handshake::SyncOp,
+              handshake::StoreOp>([&](auto) { record.latency = 1; })
+        .Case([&](handshake::BufferOp op) {
+          record.latency = op.getNumSlots();
+        })
+        .Case([&](handshake::ConstantOp op) {
+          record.constant =
+              op->getAttrOfType<mlir::IntegerAttr>("value").getValue();
+        })
+        .Case([&](handshake::MemoryOp op) {
+          auto type = op.getMemRefType();
+          Type elementType = type.getElementType();
+          unsigned width = elementType.getIntOrFloatBitWidth();
+          Token zero = elementType.isa<mlir::IntegerType>()
+                           ? Token(APInt(width, 0))
+                           : Token(APFloat(0.0));
+          record.memory = memories.size();
+          memories.emplace_back(type.getNumElements(), zero);
+          record.ldCount = op.getLdCount();
+          record.stCount = op.getStCount();
+        })
+        .Case([&](mlir::arith::ConstantOp op) {
+          auto value = op.getValue().cast<mlir::IntegerAttr>().getValue();
+          record.constant = op.getType().isIndex()
+                                ? value.sextOrTrunc(INDEX_WIDTH)
+                                : value;
+        })
+        .Case([&](mlir::arith::CmpIOp op) {
+          record.predicate = op.getPredicate();
+        })
+        .Case([&](mlir::arith::IndexCastOp op) {
+          Type type = op.getOut().getType();
+          record.width = type.isIndex() ? IndexType::kInternalStorageBitWidth
+                                        : type.getIntOrFloatBitWidth();
+        })
+        .Case<mlir::arith::ExtSIOp, mlir::arith::ExtUIOp>([&](auto op) {
+          record.width = op.getType().getIntOrFloatBitWidth();
+        });
+    records.push_back(std::move(record));
+  }
+
+  // Record the users of each slot, in the order in which the default executer
+  // schedules them.
+  usersBegin.reserve(values.size() + 1);
+  for (auto value : values) {
+    usersBegin.push_back(userLists.size());
+    for (auto *user : value.getUsers())
+      userLists.push_back(opIndices.lookup(user));
+  }
+  usersBegin.push_back(userLists.size());
+
+  tokens.resize(values.size());
+  full.resize(values.size());
+  times.resize(values.size());
+  queued.resize(records.size());
+}
+
+bool TypedHandshakeExecuter::tryExecute(const OpRecord &record,
+                                        SmallVectorImpl<unsigned> &filled) {
+  switch (record.kind) {
+  case OpKind::Fork:
+  case OpKind::Join:
+  case OpKind::Sync:
+  case OpKind::Branch:
+  case OpKind::Buffer:
+  case OpKind::Constant:
+  case OpKind::Store: {
+    // These fire once all of their operands are available and all of their
+    // results are free.
+    double time = 0;
+    for (unsigned i = 0; i < record.numOperands; ++i) {
+      unsigned slot = getOperand(record, i);
+      if (!full[slot])
+        return false;
+      time = std::max(time, times[slot]);
+    }
+    for (unsigned i = 0; i < record.numResults; ++i)
+      if (full[getResult(record, i)])
+        return false;
+    time += record.latency;
+    for (unsigned i = 0; i < record.numResults; ++i) {
+      unsigned slot = getResult(record, i);
+      if (record.kind == OpKind::Constant)
+        put(slot, record.constant, time);
+      else if (record.kind == OpKind::Sync)
+        put(slot, tokens[getOperand(record, i)], time);
+      else if (record.kind == OpKind::Store)
+        // Forward the address and data to the memory.
+        put(slot, tokens[getOperand(record, 1 - i)], time);
+      else
+        put(slot, tokens[getOperand(record, 0)], time);
+      filled.push_back(slot);
+    }
+    for (unsigned i = 0; i < record.numOperands; ++i)
+      full[getOperand(record, i)] = false;
+    return true;
+  }
+
+  case OpKind::Merge: {
+    // Forward one token at a time, and only once the previous one has been
+    // consumed.
+    unsigned out = getResult(record, 0);
+    if (full[out])
+      return false;
+    for (unsigned i = 0; i < record.numOperands; ++i) {
+      unsigned in = getOperand(record, i);
+      if (!full[in])
+        continue;
+      put(out, tokens[in], times[in]);
+      full[in] = false;
+      filled.push_back(out);
+      return true;
+    }
+    return false;
+  }
+
+  case OpKind::Mux: {
+    unsigned control = getOperand(record, 0);
+    if (!full[control])
+      return false;
+    uint64_t index = std::get<APInt>(tokens[control]).getZExtValue();
+    assert(index + 1 < record.numOperands &&
+           "Trying to select a non-existing mux operand");
+    unsigned in = getOperand(record, index + 1);
+    unsigned out = getResult(record, 0);
+    if (!full[in] || full[out])
+      return false;
+    put(out, tokens[in], std::max(times[control], times[in]));
+    full[control] = full[in] = false;
+    filled.push_back(out);
+    return true;
+  }
+
+  case OpKind::ControlMerge: {
+    unsigned out = getResult(record, 0);
+    unsigned index = getResult(record, 1);
+    if (full[out] || full[index])
+      return false;
+    for (unsigned i = 0; i < record.numOperands; ++i) {
+      unsigned in = getOperand(record, i);
+      if (!full[in])
+        continue;
+      put(out, tokens[in], times[in]);
+      put(index, APInt(INDEX_WIDTH, i), times[in]);
+      full[in] = false;
+      filled.push_back(out);
+      filled.push_back(index);
+      return true;
+    }
+    return false;
+  }
+
+  case OpKind::ConditionalBranch: {
+    unsigned control = getOperand(record, 0);
+    unsigned in = getOperand(record, 1);
+    if (!full[control] || !full[in])
+      return false;
+    bool condition = std::get<APInt>(tokens[control]) != 0;
+    unsigned out = getResult(record, condition ? 0 : 1);
+    if (full[out])
+      return false;
+    put(out, tokens[in], std::max(times[control], times[in]));
+    full[control] = full[in] = false;
+    filled.push_back(out);
+    return true;
+  }
+
+  case OpKind::Sink: {
+    unsigned in = getOperand(record, 0);
+    if (!full[in])
+      return false;
+    full[in] = false;
+    return true;
+  }
+
+  case OpKind::Memory:
+    return tryExecuteMemory(record, filled);
+
+  case OpKind::Load:
+    return tryExecuteLoad(record, filled);
+
+  default:
+    llvm_unreachable("not a handshake operation");
+  }
+}
+
+bool TypedHandshakeExecuter::tryExecuteMemory(
+    const OpRecord &record, SmallVectorImpl<unsigned> &filled) {
+  auto &memory = memories[record.memory];
+  bool notReady = false;
+  unsigned operandIndex = 0;
+  for (unsigned i = 0; i < record.stCount; ++i) {
+    unsigned data = getOperand(record, operandIndex++);
+    unsigned address = getOperand(record, operandIndex++);
+    unsigned nonceOut = getResult(record, record.ldCount + i);
+    if (!full[data] || !full[address] || full[nonceOut]) {
+      notReady = true;
+      continue;
+    }
+    uint64_t offset = std::get<APInt>(tokens[address]).getZExtValue();
+    assert(offset < memory.size());
+    memory[offset] = tokens[data];
+    put(nonceOut, APInt(1, 0), std::max(times[address], times[data]));
+    filled.push_back(nonceOut);
+    full[data] = full[address] = false;
+  }
+
+  for (unsigned i = 0; i < record.ldCount; ++i) {
+    unsigned address = getOperand(record, operandIndex++);
+    unsigned dataOut = getResult(record, i);
+    unsigned nonceOut =
+        getResult(record, record.ldCount + record.stCount + i);
+    if (!full[address] || full[dataOut] || full[nonceOut]) {
+      notReady = true;
+      continue;
+    }
+    uint64_t offset = std::get<APInt>(tokens[address]).getZExtValue();
+    assert(offset < memory.size());
+    put(dataOut, memory[offset], times[address]);
+    put(nonceOut, APInt(1, 0), times[address]);
+    filled.push_back(dataOut);
+    filled.push_back(nonceOut);
+    full[address] = false;
+  }
+  return !notReady;
+}
+
+bool TypedHandshakeExecuter::tryExecuteLoad(const OpRecord &record,
+                                            SmallVectorImpl<unsigned> &filled) {
+  unsigned address = getOperand(record, 0);
+  unsigned data = getOperand(record, 1);
+  unsigned nonce = getOperand(record, 2);
+  unsigned dataOut = getResult(record, 0);
+  unsigned addressOut = getResult(record, 1);
+  if (full[address] != full[nonce] ||
+      (!full[address] && !full[nonce] && !full[data]))
+    return false;
+  if (full[address] && full[nonce] && !full[addressOut]) {
+    put(addressOut, tokens[address], std::max(times[address], times[nonce]));
+    full[address] = full[nonce] = false;
+    filled.push_back(addressOut);
+    return true;
+  }
+  if (full[data] && !full[dataOut]) {
+    put(dataOut, tokens[data], times[data]);
+    full[data] = false;
+    filled.push_back(dataOut);
+    return true;
+  }
+  // The results are still waiting to be consumed.
+  return false;
+}
+
+FailureOr<Token> TypedHandshakeExecuter::execute(const OpRecord &record) {
+  auto operand = [&](unsigned index) -> const APInt & {
+    return std::get<APInt>(tokens[getOperand(record, index)]);
+  };
+  switch (record.kind) {
+  case OpKind::ArithConstant:
+    return Token(record.constant);
+  case OpKind::AddI:
+    return Token(operand(0) + operand(1));
+  case OpKind::SubI:
+    return Token(operand(0) - operand(1));
+  case OpKind::MulI:
+    return Token(operand(0) * operand(1));
+  case OpKind::DivSI:
+    if (operand(1).isZero()) {
+      record.op->emitOpError() << "Division By Zero!";
+      return failure();
+    }
+    return Token(operand(0).sdiv(operand(1)));
+  case OpKind::DivUI:
+    if (operand(1).isZero()) {
+      record.op->emitOpError() << "Division By Zero!";
+      return failure();
+    }
+    return Token(operand(0).udiv(operand(1)));
+  case OpKind::XOrI:
+    return Token(operand(0) ^ operand(1));
+  case OpKind::CmpI:
+    return Token(APInt(1, mlir::arith::applyCmpPredicate(
+                              record.predicate, operand(0), operand(1))));
+  case OpKind::IndexCast:
+    return Token(APInt(record.width, operand(0).getZExtValue()));
+  case OpKind::ExtSI:
+    return Token(operand(0).sext(record.width));
+  case OpKind::ExtUI:
+    return Token(operand(0).zext(record.width));
+  default:
+    llvm_unreachable("not an operation with a single result");
+  }
+}
+
+LogicalResult
+TypedHandshakeExecuter::run(llvm::DenseMap<mlir::Value, Any> &valueMap,
+                            llvm::DenseMap<mlir::Value, double> &timeMap,
+                            std::vector<Any> &results,
+                            std::vector<double> &resultTimes) {
+  mlir::Block &body = func.getBody().front();
+
+  // Initialize the buffers with initial values.
+  for (auto &record : records) {
+    auto bufferOp = dyn_cast<handshake::BufferOp>(record.op);
+    if (!bufferOp || !bufferOp.getInitValues().has_value())
+      continue;
+    auto initValues = bufferOp.getInitValueArray();
+    assert(initValues.size() == 1 &&
+           "Handshake-runner only supports buffer initialization with a "
+           "single buffer value.");
+    unsigned slot = getResult(record, 0);
+    put(slot,
+        APInt(bufferOp.getResult().getType().getIntOrFloatBitWidth(),
+              initValues.front()),
+        0);
+    scheduleUses(slot);
+  }
+
+  // Take the arguments.
+  for (auto [slot, arg] : llvm::enumerate(body.getArguments())) {
+    auto it = valueMap.find(arg);
+    if (it == valueMap.end())
+      continue;
+    if (auto *value = any_cast<APInt>(&it->second))
+      put(slot, *value, timeMap.lookup(arg));
+    else
+      put(slot, any_cast<APFloat>(it->second), timeMap.lookup(arg));
+  }
+  for (unsigned slot = 0, e = body.getNumArguments(); slot < e; ++slot)
+    scheduleUses(slot);
+
+  SmallVector<unsigned> filled;
+  while (true) {
+    if (queue.empty())
+      return func.emitError() << "no operation is ready to execute";
+    unsigned index = queue.front();
+    queue.pop_front();
+    queued[index] = false;
+    auto &record = records[index];
+
+    if (record.kind < OpKind::Return) {
+      filled.clear();
+      if (!tryExecute(record, filled))
+        schedule(index);
+      // Merges forward one of several available tokens at a time, so come
+      // back for the ones left behind.
+      else if (llvm::any_of(llvm::seq(0u, record.numOperands),
+                            [&](unsigned i) {
+                              return full[getOperand(record, i)];
+                            }))
+        schedule(index);
+      for (unsigned slot : filled)
+        scheduleUses(slot);
+      continue;
     }
+
+    // The remaining operations fire once all of their operands are
+    // available, and consume them.
+    double time = 0;
+    bool ready = true;
+    for (unsigned i = 0; i < record.numOperands; ++i) {
+      unsigned slot = getOperand(record, i);
+      ready &= full[slot];
+      time = std::max(time, times[slot]);
+    }
+    if (!ready) {
+      schedule(index);
+      continue;
+    }
+    for (unsigned i = 0; i < record.numOperands; ++i)
+      full[getOperand(record, i)] = false;
+
+    if (record.kind == OpKind::Return) {
+      for (unsigned i = 0; i < results.size(); ++i) {
+        unsigned slot = getOperand(record, i);
+        if (auto *value = std::get_if<APInt>(&tokens[slot]))
+          results[i] = *value;
+        else
+          results[i] = std::get<APFloat>(tokens[slot]);
+        resultTimes[i] = times[slot];
+      }
+      return success();
+    }
+
+    auto result = execute(record);
+    if (failed(result))
+      return failure();
+    unsigned slot = getResult(record, 0);
+    put(slot, std::move(*result), time + 1);
+    scheduleUses(slot);
     ++instructionsExecuted;
   }
 }
@@ -914,7 +1872,8 @@ HandshakeExecuter::HandshakeExecuter(
 //===----------------------------------------------------------------------===//
 
 bool simulate(StringRef toplevelFunction, ArrayRef<std::string> inputArgs,
-              mlir::OwningOpRef<mlir::ModuleOp> &module, mlir::MLIRContext &) {
+              mlir::OwningOpRef<mlir::ModuleOp> &module, mlir::MLIRContext &,
+              const CycleAccurateOptions *cycleAccurate, bool typedCore) {
   // The store associates each allocation in the program
   // (represented by a int) with a vector of values which can be
   // accessed by it.  Currently values are assumed to be an integer.
@@ -1018,14 +1977,34 @@ bool simulate(StringRef toplevelFunction, ArrayRef<std::string> inputArgs,
   bool succeeded = false;
   if (mlir::func::FuncOp toplevel =
           module->lookupSymbol<mlir::func::FuncOp>(toplevelFunction)) {
+    if (cycleAccurate) {
+      errs() << "Cycle-accurate simulation requires a handshake function.\n";
+      return 1;
+    }
+    if (typedCore) {
+      errs() << "The typed core requires a handshake function.\n";
+      return 1;
+    }
     succeeded = HandshakeExecuter(toplevel, valueMap, timeMap, results,
                                   resultTimes, store, storeTimes)
                     .succeeded();
   } else if (handshake::FuncOp toplevel =
                  module->lookupSymbol<handshake::FuncOp>(toplevelFunction)) {
-    succeeded = HandshakeExecuter(toplevel, valueMap, timeMap, results,
-                                  resultTimes, store, storeTimes, module)
-                    .succeeded();
+    if (typedCore) {
+      if (cycleAccurate) {
+        errs() << "The typed core does not support cycle-accurate "
+                  "simulation.\n";
+        return 1;
+      }
+      if (failed(TypedHandshakeExecuter::verifySupported(toplevel)))
+        return 1;
+      succeeded = mlir::succeeded(TypedHandshakeExecuter(toplevel).run(
+          valueMap, timeMap, results, resultTimes));
+    } else
+        succeeded = HandshakeExecuter(toplevel, valueMap, timeMap, results,
+                                    resultTimes, store, storeTimes, module,
+                                    cycleAccurate)
+                      .succeeded();
   }
 
   if (!succeeded)
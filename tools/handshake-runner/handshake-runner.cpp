@@ -42,6 +42,24 @@ static cl::opt<std::string>
                      cl::desc("The top-level function to execute"),
                      cl::init("main"), cl::cat(mainCategory));
 
+static cl::opt<bool> cycleAccurate(
+    "cycle-accurate",
+    cl::desc("Simulate handshake functions cycle by cycle, respecting buffer "
+             "slot counts, and print throughput statistics to stderr"),
+    cl::init(false), cl::cat(mainCategory));
+
+static cl::opt<uint64_t>
+    maxCycles("max-cycles",
+              cl::desc("Abort the cycle-accurate simulation after this many "
+                       "cycles; 0 means no limit"),
+              cl::init(1000000), cl::cat(mainCategory));
+
+static cl::opt<bool>
+    typedCore("typed-core",
+              cl::desc("Execute handshake functions with the interpreter "
+                       "working on dense, typed value slots"),
+              cl::init(false), cl::cat(mainCategory));
+
 int main(int argc, char **argv) {
   InitLLVM y(argc, argv);
 
@@ -89,5 +107,10 @@ int main(int argc, char **argv) {
     return 1;
   }
 
-  return handshake::simulate(toplevelFunction, inputArgs, module, context);
+  handshake::CycleAccurateOptions cycleAccurateOptions;
+  cycleAccurateOptions.maxCycles = maxCycles;
+  cycleAccurateOptions.report = &errs();
+  return handshake::simulate(toplevelFunction, inputArgs, module, context,
+                             cycleAccurate ? &cycleAccurateOptions : nullptr,
+                             typedCore);
 }
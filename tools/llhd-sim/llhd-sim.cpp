@@ -16,6 +16,7 @@
 #include "circt/Dialect/LLHD/IR/LLHDDialect.h"
 #include "circt/Dialect/LLHD/Simulator/Engine.h"
 #include "circt/Dialect/LLHD/Simulator/Trace.h"
+#include "circt/Dialect/LLHD/Transforms/Passes.h"
 #include "circt/Support/Version.h"
 
 #include "mlir/Dialect/Func/IR/FuncOps.h"
@@ -29,10 +30,17 @@
 #include "mlir/Target/LLVMIR/Export.h"
 #include "mlir/Transforms/Passes.h"
 
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/Module.h"
 #include "llvm/Support/Error.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/SHA256.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/ToolOutputFile.h"
+#include "llvm/Transforms/Utils/Cloning.h"
 
 using namespace llvm;
 using namespace mlir;
@@ -116,6 +124,65 @@ static cl::opt<TraceMode> traceMode(
         clEnumValN(TraceMode::None, "none", "Don't dump a signal trace")),
     cl::cat(mainCategory));
 
+static cl::opt<TraceEncoding> traceEncoding(
+    "trace-encoding", cl::desc("Choose the encoding of the trace output:"),
+    cl::init(TraceEncoding::Text),
+    cl::values(clEnumValN(TraceEncoding::Text, "text",
+                          "Write one textual line per signal change"),
+               clEnumValN(TraceEncoding::Binary, "binary",
+                          "Write a block-compressed binary trace with a "
+                          "signal index, encoded on a background thread")),
+    cl::cat(mainCategory));
+
+static cl::opt<bool> decodeTrace(
+    "decode-trace",
+    cl::desc("Decode the binary trace given as input and print it in the "
+             "textual full format instead of running a simulation"),
+    cl::init(false), cl::cat(mainCategory));
+
+static cl::opt<SchedulerKind> scheduler(
+    "scheduler", cl::desc("Choose the event scheduler:"),
+    cl::init(SchedulerKind::Calendar),
+    cl::values(clEnumValN(SchedulerKind::Calendar, "calendar",
+                          "Bucket near-future delta steps in a time wheel and "
+                          "keep far events in an ordered overflow queue"),
+               clEnumValN(SchedulerKind::Linear, "linear",
+                          "Keep all events in a flat list and search it "
+                          "linearly")),
+    cl::cat(mainCategory));
+
+static cl::opt<std::string> saveState(
+    "save-state",
+    cl::desc("Write a checkpoint of the simulation state to the given file "
+             "when the simulation stops"),
+    cl::value_desc("filename"), cl::cat(mainCategory));
+
+static cl::opt<std::string> restoreState(
+    "restore-state",
+    cl::desc("Resume the simulation from a checkpoint written with "
+             "--save-state for the same design"),
+    cl::value_desc("filename"), cl::cat(mainCategory));
+
+static cl::opt<unsigned> threads(
+    "threads",
+    cl::desc("Number of threads used to evaluate the instances woken up in "
+             "the same delta cycle. The trace is identical to a "
+             "single-threaded run"),
+    cl::init(1), cl::value_desc("N"), cl::cat(mainCategory));
+
+static cl::opt<bool> levelize(
+    "levelize",
+    cl::desc("Evaluate purely combinational entities once per delta cycle in "
+             "a static order instead of through the event queue. Their "
+             "epsilon delays are dropped from the trace"),
+    cl::init(false), cl::cat(mainCategory));
+
+static cl::opt<std::string> cacheDir(
+    "cache-dir",
+    cl::desc("Cache the optimized LLVM IR of the design in the given "
+             "directory and reuse it for later runs on the same input"),
+    cl::value_desc("dir"), cl::cat(mainCategory));
+
 static cl::list<std::string>
     sharedLibs("shared-libs",
                cl::desc("Libraries to link dynamically. Specify absolute path "
@@ -151,6 +218,82 @@ static int dumpLLVM(ModuleOp module, MLIRContext &context) {
   return 0;
 }
 
+//===----------------------------------------------------------------------===//
+// Compilation Cache
+//===----------------------------------------------------------------------===//
+
+/// Compute the key of the cache entry for an input. The optimized LLVM IR
+/// depends on the input, the root, the optimization level, and the version of
+/// the tool that produced it.
+static std::string getCacheKey(StringRef input) {
+  std::string options;
+  llvm::raw_string_ostream os(options);
+  os << getCirctVersion() << "\n"
+     << root << "," << optimizationLevel << "\n";
+
+  llvm::SHA256 hasher;
+  hasher.update(os.str());
+  hasher.update(input);
+  return llvm::toHex(hasher.final(), /*LowerCase=*/true);
+}
+
+/// Return the path of the cache entry with the given key.
+static std::string getCachePath(StringRef key) {
+  SmallString<128> path(cacheDir);
+  llvm::sys::path::append(path, key + ".bc");
+  return std::string(path);
+}
+
+/// Load the optimized module of a cache entry. Returns null if there is no
+/// valid entry for the key.
+static std::unique_ptr<llvm::Module> loadFromCache(StringRef key,
+                                                   llvm::LLVMContext &context) {
+  auto buffer = llvm::MemoryBuffer::getFile(getCachePath(key));
+  if (!buffer)
+    return {};
+  auto module = llvm::parseBitcodeFile((*buffer)->getMemBufferRef(), context);
+  if (!module) {
+    llvm::consumeError(module.takeError());
+    return {};
+  }
+  return std::move(*module);
+}
+
+/// Store an optimized module in the cache. The execution engine adds a
+/// `_mlir_` wrapper with packed arguments for every function before the
+/// module is optimized. The wrappers are dropped from the stored module, since
+/// the engine adds them again when it loads the module. The entry is written
+/// to a temporary file first and then renamed, such that concurrent runs never
+/// observe partially written entries. Failing to update the cache is not an
+/// error.
+static void storeInCache(StringRef key, const llvm::Module &module) {
+  if (auto error = llvm::sys::fs::create_directories(cacheDir)) {
+    llvm::errs() << "warning: cannot create cache directory `" << cacheDir
+                 << "`: " << error.message() << "\n";
+    return;
+  }
+  auto stored = llvm::CloneModule(module);
+  SmallVector<llvm::Function *> wrappers;
+  for (auto &func : *stored)
+    if (func.getName().startswith("_mlir_"))
+      wrappers.push_back(&func);
+  for (auto *func : wrappers)
+    func->eraseFromParent();
+
+  auto path = getCachePath(key);
+  auto error = llvm::writeToOutput(path, [&](raw_ostream &os) {
+    llvm::WriteBitcodeToFile(*stored, os);
+    return llvm::Error::success();
+  });
+  if (error)
+    llvm::errs() << "warning: cannot write cache file `" << path
+                 << "`: " << toString(std::move(error)) << "\n";
+}
+
+//===----------------------------------------------------------------------===//
+// Tool Driver
+//===----------------------------------------------------------------------===//
+
 static LogicalResult applyMLIRPasses(ModuleOp module) {
   PassManager pm(module.getContext());
 
@@ -185,6 +328,15 @@ int main(int argc, char **argv) {
     exit(1);
   }
 
+  if (decodeTrace) {
+    if (auto error = decodeBinaryTrace(file->getBuffer(), output->os())) {
+      llvm::errs() << toString(std::move(error)) << "\n";
+      return 1;
+    }
+    output->keep();
+    return 0;
+  }
+
   // Parse the input file.
   SourceMgr mgr;
   mgr.AddNewSourceBuffer(std::move(file), SMLoc());
@@ -196,6 +348,13 @@ int main(int argc, char **argv) {
   mlir::registerLLVMDialectTranslation(context);
   mlir::registerBuiltinDialectTranslation(context);
 
+  // Compute the cache key before parsing, since the parser does not keep the
+  // input around.
+  std::optional<std::string> cacheKey;
+  if (!cacheDir.empty() && !dumpLLVMDialect && !dumpLLVMIR)
+    cacheKey =
+        getCacheKey(mgr.getMemoryBuffer(mgr.getMainFileID())->getBuffer());
+
   mlir::OwningOpRef<mlir::ModuleOp> module(
       parseSourceFile<ModuleOp>(mgr, &context));
 
@@ -205,13 +364,44 @@ int main(int argc, char **argv) {
     return 0;
   }
 
+  // Find the entities that can be evaluated in a static order.
+  if (levelize) {
+    PassManager pm(&context);
+    pm.nest<llhd::EntityOp>().addPass(llhd::createMarkCombinationalPass());
+    if (failed(pm.run(*module)))
+      return 1;
+  }
+
   SmallVector<StringRef, 1> sharedLibPaths(sharedLibs.begin(),
                                            sharedLibs.end());
 
-  llhd::sim::Engine engine(
-      output->os(), *module, &applyMLIRPasses,
-      makeOptimizingTransformer(optimizationLevel, 0, nullptr), root, traceMode,
-      sharedLibPaths);
+  // The engine calls the transformer when it first looks up a function, so
+  // the transformers have to outlive the engine's construction. On a cache
+  // hit, the cached module is already optimized and is used as is.
+  auto optimizer = makeOptimizingTransformer(optimizationLevel, 0, nullptr);
+  bool cacheHit = false;
+  auto llvmTransformer = [&](llvm::Module *llvmModule) -> llvm::Error {
+    if (cacheHit)
+      return llvm::Error::success();
+    if (auto error = optimizer(llvmModule))
+      return error;
+    if (cacheKey)
+      storeInCache(*cacheKey, *llvmModule);
+    return llvm::Error::success();
+  };
+  auto llvmModuleBuilder = [&](Operation *op, llvm::LLVMContext &llvmContext) {
+    if (cacheKey)
+      if (auto cached = loadFromCache(*cacheKey, llvmContext)) {
+        cacheHit = true;
+        return cached;
+      }
+    return mlir::translateModuleToLLVMIR(op, llvmContext);
+  };
+
+  llhd::sim::Engine engine(output->os(), *module, &applyMLIRPasses,
+                           llvmTransformer, root, traceMode, sharedLibPaths,
+                           scheduler, threads, traceEncoding, levelize,
+                           llvmModuleBuilder);
 
   if (dumpLLVMDialect || dumpLLVMIR) {
     return dumpLLVM(engine.getModule(), context);
@@ -223,7 +413,11 @@ int main(int argc, char **argv) {
     return 0;
   }
 
-  engine.simulate(nSteps, maxTime);
+  if (engine.simulate(nSteps, maxTime, restoreState) != 0)
+    return 1;
+
+  if (!saveState.empty() && engine.saveCheckpoint(saveState))
+    return 1;
 
   output->keep();
   return 0;
@@ -22,4 +22,49 @@ TEST(TypesTest, AnalogContainsAnalog) {
   ASSERT_TRUE(AnalogType::get(&context).containsAnalog());
 }
 
+TEST(TypesTest, AggregateBitWidth) {
+  MLIRContext context;
+  context.loadDialect<FIRRTLDialect>();
+  auto a = StringAttr::get(&context, "a");
+  auto b = StringAttr::get(&context, "b");
+  auto uint8 = UIntType::get(&context, 8);
+
+  // Build a deeply nested bundle of vectors. The widths and field IDs are
+  // cached on every level, so this stays linear in the depth.
+  FIRRTLBaseType type = uint8;
+  int64_t width = 8;
+  uint64_t maxFieldID = 0;
+  for (unsigned i = 0; i < 64; ++i) {
+    auto vector = FVectorType::get(type, 2);
+    type = BundleType::get(&context, {{a, false, vector}, {b, false, uint8}});
+    width = 2 * width + 8;
+    maxFieldID = 2 * maxFieldID + 4;
+    if (width > (int64_t(1) << 40))
+      break;
+  }
+  EXPECT_EQ(getBitWidth(type), width);
+  EXPECT_EQ(type.getMaxFieldID(), maxFieldID);
+
+  // Flips only make the width unknown unless they are ignored, and only on
+  // the outermost level.
+  auto flipped =
+      BundleType::get(&context, {{a, true, uint8}, {b, false, uint8}});
+  EXPECT_EQ(getBitWidth(flipped), std::nullopt);
+  EXPECT_EQ(getBitWidth(flipped, /*ignoreFlip=*/true), 16);
+  auto nested = BundleType::get(&context, {{a, false, flipped}});
+  EXPECT_EQ(getBitWidth(nested, /*ignoreFlip=*/true), std::nullopt);
+
+  // Uninferred widths propagate through all aggregates.
+  auto unknown = FVectorType::get(UIntType::get(&context), 4);
+  EXPECT_EQ(getBitWidth(unknown), std::nullopt);
+  EXPECT_EQ(getBitWidth(BundleType::get(&context, {{a, false, unknown}})),
+            std::nullopt);
+
+  auto fenum = FEnumType::get(&context, {{a, uint8}, {b, unknown}});
+  EXPECT_EQ(getBitWidth(fenum), std::nullopt);
+  auto uint3 = UIntType::get(&context, 3);
+  fenum = FEnumType::get(&context, {{a, uint8}, {b, uint3}});
+  EXPECT_EQ(getBitWidth(fenum), 9);
+}
+
 } // namespace
@@ -77,4 +77,146 @@ TEST(InstanceGraphTest, PostOrderTraversal) {
   ASSERT_EQ(range.end(), it);
 }
 
+struct CountingListener : public InstanceGraphListener {
+  void notifyModuleAdded(InstanceGraphNode *) override { ++modulesAdded; }
+  void notifyModuleErased(InstanceGraphNode *) override { ++modulesErased; }
+  void notifyInstanceAdded(InstanceRecord *) override { ++instancesAdded; }
+  void notifyInstanceErased(InstanceRecord *) override { ++instancesErased; }
+  unsigned modulesAdded = 0;
+  unsigned modulesErased = 0;
+  unsigned instancesAdded = 0;
+  unsigned instancesErased = 0;
+};
+
+TEST(InstanceGraphTest, IncrementalUpdates) {
+  MLIRContext context;
+  context.loadDialect<HWDialect>();
+
+  // Build the following graph:
+  // hw.module @Top() {
+  //   hw.instance "cat" @Cat() -> ()
+  // }
+  // hw.module private @Cat() { }
+
+  LocationAttr loc = UnknownLoc::get(&context);
+  auto module = ModuleOp::create(loc);
+  auto builder = ImplicitLocOpBuilder::atBlockEnd(loc, module.getBody());
+
+  auto top = builder.create<HWModuleOp>(StringAttr::get(&context, "Top"),
+                                        ArrayRef<PortInfo>{});
+  auto cat = builder.create<HWModuleOp>(StringAttr::get(&context, "Cat"),
+                                        ArrayRef<PortInfo>{});
+  SymbolTable::setSymbolVisibility(cat, SymbolTable::Visibility::Private);
+
+  builder.setInsertionPointToStart(top.getBodyBlock());
+  auto catInst = builder.create<InstanceOp>(cat, "cat", ArrayRef<Value>{});
+
+  InstanceGraph graph(module);
+  CountingListener listener;
+  graph.addListener(&listener);
+
+  // Add a new module and instantiate it from the top.
+  builder.setInsertionPointToEnd(module.getBody());
+  auto dog = builder.create<HWModuleOp>(StringAttr::get(&context, "Dog"),
+                                        ArrayRef<PortInfo>{});
+  SymbolTable::setSymbolVisibility(dog, SymbolTable::Visibility::Private);
+  auto *dogNode = graph.addModule(dog);
+  builder.setInsertionPointToStart(top.getBodyBlock());
+  auto dogInst = builder.create<InstanceOp>(dog, "dog", ArrayRef<Value>{});
+  auto *record = graph.addInstance(dogInst);
+  ASSERT_EQ(graph.lookup(top), record->getParent());
+  ASSERT_EQ(dogNode, record->getTarget());
+  ASSERT_TRUE(dogNode->hasOneUse());
+  ASSERT_TRUE(graph.isAncestor(dog, top));
+
+  // Remove the cat instance and its module.
+  auto *catNode = graph.lookup(cat);
+  graph.eraseInstance(catInst);
+  catInst.erase();
+  ASSERT_TRUE(catNode->noUses());
+  graph.erase(catNode);
+  cat.erase();
+  ASSERT_EQ(2u, std::distance(graph.begin(), graph.end()));
+
+  ASSERT_EQ(1u, listener.modulesAdded);
+  ASSERT_EQ(1u, listener.modulesErased);
+  ASSERT_EQ(1u, listener.instancesAdded);
+  ASSERT_EQ(1u, listener.instancesErased);
+  graph.removeListener(&listener);
+}
+
+/// An instance graph rooted at the module named "Top".
+struct TopInstanceGraph : public InstanceGraphBase {
+  TopInstanceGraph(Operation *operation) : InstanceGraphBase(operation) {}
+  InstanceGraphNode *getTopLevelNode() override {
+    return lookup(StringAttr::get(parent->getContext(), "Top"));
+  }
+};
+
+TEST(InstanceGraphTest, InstancePaths) {
+  MLIRContext context;
+  context.loadDialect<HWDialect>();
+
+  // Build the following graph:
+  // hw.module @Top() {
+  //   hw.instance "a1" @Alligator() -> ()
+  //   hw.instance "a2" @Alligator() -> ()
+  // }
+  // hw.module private @Alligator() {
+  //   hw.instance "cat" @Cat() -> ()
+  // }
+  // hw.module private @Cat() { }
+
+  LocationAttr loc = UnknownLoc::get(&context);
+  auto module = ModuleOp::create(loc);
+  auto builder = ImplicitLocOpBuilder::atBlockEnd(loc, module.getBody());
+
+  auto top = builder.create<HWModuleOp>(StringAttr::get(&context, "Top"),
+                                        ArrayRef<PortInfo>{});
+  auto alligator = builder.create<HWModuleOp>(
+      StringAttr::get(&context, "Alligator"), ArrayRef<PortInfo>{});
+  auto cat = builder.create<HWModuleOp>(StringAttr::get(&context, "Cat"),
+                                        ArrayRef<PortInfo>{});
+
+  builder.setInsertionPointToStart(top.getBodyBlock());
+  builder.create<InstanceOp>(alligator, "a1", ArrayRef<Value>{});
+  builder.create<InstanceOp>(alligator, "a2", ArrayRef<Value>{});
+
+  builder.setInsertionPointToStart(alligator.getBodyBlock());
+  auto catInst = builder.create<InstanceOp>(cat, "cat", ArrayRef<Value>{});
+
+  TopInstanceGraph graph(module);
+  InstancePathCache cache(graph);
+
+  auto topPaths = cache.getAbsolutePathIDs(top);
+  ASSERT_EQ(1u, topPaths.size());
+  ASSERT_EQ(0u, cache.getPathSize(topPaths[0]));
+
+  // Both paths to the cat share the prefix of the paths to the alligator.
+  auto alligatorPaths = cache.getAbsolutePathIDs(alligator);
+  auto catPaths = cache.getAbsolutePathIDs(cat);
+  ASSERT_EQ(2u, alligatorPaths.size());
+  ASSERT_EQ(2u, catPaths.size());
+  for (auto path : catPaths) {
+    ASSERT_EQ(2u, cache.getPathSize(path));
+    ASSERT_EQ(catInst.getOperation(),
+              cache.getLeafInstance(path).getOperation());
+    ASSERT_TRUE(llvm::is_contained(alligatorPaths, cache.getParentPath(path)));
+  }
+  ASSERT_NE(cache.getParentPath(catPaths[0]), cache.getParentPath(catPaths[1]));
+
+  // The materialized paths match the path IDs.
+  auto paths = cache.getAbsolutePaths(cat);
+  ASSERT_EQ(2u, paths.size());
+  for (auto [path, pathID] : llvm::zip(paths, catPaths)) {
+    SmallVector<HWInstanceLike> instances;
+    cache.getPath(pathID, instances);
+    ASSERT_TRUE(ArrayRef<HWInstanceLike>(instances) == path);
+  }
+
+  cache.freeze();
+  ASSERT_TRUE(cache.isFrozen());
+  ASSERT_TRUE(catPaths == cache.getAbsolutePathIDs(cat));
+}
+
 } // namespace
@@ -259,6 +259,41 @@ TEST(TypesTest, Resolution) {
   ASSERT_EQ(r1.fullyResolved().toString(), "bit [1:0][2:0] $ [*][4]");
 }
 
+TEST(TypesTest, ResolutionBitSizes) {
+  MLIRContext context;
+  context.loadDialect<MooreDialect>();
+
+  auto loc = UnknownLoc::get(&context);
+  auto t0 = IntType::get(&context, IntType::Bit);
+  auto t1 = PackedRangeDim::get(t0, 3);
+  auto t2 = PackedNamedType::get(t1, "foo", loc);
+  auto t3 = PackedRangeDim::get(t2, 2);
+  auto t4 = PackedNamedType::get(t3, "bar", loc);
+  auto t5 = UnpackedArrayDim::get(t4, 4);
+  auto t6 = UnpackedNamedType::get(t5, "tony", loc);
+  auto t7 = UnpackedAssocDim::get(t6);
+  auto t8 = UnpackedNamedType::get(t7, "ada", loc);
+  auto r0 = PackedRefType::get(t4, loc);
+  auto r1 = UnpackedRefType::get(t8, loc);
+
+  // The sizes of indirections and the element sizes of dimensions are
+  // computed up front and have to match the sizes of the resolved types.
+  ASSERT_EQ(t2.getBitSize(), 3u);
+  ASSERT_EQ(t3.getInnerBitSize(), 3u);
+  ASSERT_EQ(t3.getBitSize(), 6u);
+  ASSERT_EQ(t4.getBitSize(), 6u);
+  ASSERT_EQ(t5.getInnerBitSize(), 6u);
+  ASSERT_EQ(t6.getBitSize(), 24u);
+  ASSERT_EQ(t7.getInnerBitSize(), 24u);
+  ASSERT_EQ(t8.getBitSize(), std::nullopt);
+  ASSERT_EQ(r0.getBitSize(), 6u);
+  ASSERT_EQ(r0.fullyResolved().getBitSize(), 6u);
+  ASSERT_EQ(r1.getBitSize(), std::nullopt);
+
+  ASSERT_FALSE(r0.isSimpleBitVector());
+  ASSERT_EQ(t2.getSimpleBitVectorOrNull().size, 3u);
+}
+
 TEST(TypesTest, NamedStructFormatting) {
   MLIRContext context;
   context.loadDialect<MooreDialect>();
@@ -175,6 +175,49 @@ TEST(EvaluatorTests, GetFieldInvalidName) {
   ASSERT_FALSE(succeeded(fieldValue));
 }
 
+TEST(EvaluatorTests, GetFieldInvalidChildObject) {
+  DialectRegistry registry;
+  registry.insert<OMDialect>();
+
+  MLIRContext context(registry);
+  context.getOrLoadDialect<OMDialect>();
+
+  Location loc(UnknownLoc::get(&context));
+
+  ImplicitLocOpBuilder builder(loc, &context);
+
+  auto mod = builder.create<ModuleOp>(loc);
+
+  builder.setInsertionPointToStart(&mod.getBodyRegion().front());
+  StringRef params[] = {"param"};
+  auto innerCls = builder.create<ClassOp>("MyInnerClass", params);
+  auto &innerBody = innerCls.getBody().emplaceBlock();
+  innerBody.addArgument(builder.getIntegerType(32), innerCls.getLoc());
+
+  builder.setInsertionPointToStart(&mod.getBodyRegion().front());
+  auto cls = builder.create<ClassOp>("MyClass");
+  auto &body = cls.getBody().emplaceBlock();
+  builder.setInsertionPointToStart(&body);
+  auto object = builder.create<ObjectOp>(innerCls, body.getArguments());
+  builder.create<ClassFieldOp>("field", object);
+
+  Evaluator evaluator(mod);
+
+  context.getDiagEngine().registerHandler([&](Diagnostic &diag) {
+    ASSERT_EQ(diag.str(), "actual parameter list length (0) does not match "
+                          "formal parameter list length (1)");
+  });
+
+  // Fields are evaluated lazily, so the error is only reported on access.
+  auto result = evaluator.instantiate(builder.getStringAttr("MyClass"), {});
+
+  ASSERT_TRUE(succeeded(result));
+
+  auto fieldValue = result.value()->getField(builder.getStringAttr("field"));
+
+  ASSERT_FALSE(succeeded(fieldValue));
+}
+
 /// Success scenarios.
 
 TEST(EvaluatorTests, InstantiateObjectWithParamField) {
@@ -283,7 +326,7 @@ TEST(EvaluatorTests, InstantiateObjectWithChildObject) {
 
   ASSERT_TRUE(succeeded(result));
 
-  auto fieldValue = std::get<std::shared_ptr<Object>>(
+  auto fieldValue = std::get<Object *>(
       result.value()->getField(builder.getStringAttr("field")).value());
 
   ASSERT_TRUE(fieldValue);
@@ -376,10 +419,10 @@ TEST(EvaluatorTests, InstantiateObjectWithChildObjectMemoized) {
 
   ASSERT_TRUE(succeeded(result));
 
-  auto field1Value = std::get<std::shared_ptr<Object>>(
+  auto field1Value = std::get<Object *>(
       result.value()->getField(builder.getStringAttr("field1")).value());
 
-  auto field2Value = std::get<std::shared_ptr<Object>>(
+  auto field2Value = std::get<Object *>(
       result.value()->getField(builder.getStringAttr("field2")).value());
 
   ASSERT_TRUE(field1Value);
@@ -388,4 +431,88 @@ TEST(EvaluatorTests, InstantiateObjectWithChildObjectMemoized) {
   ASSERT_EQ(field1Value, field2Value);
 }
 
+TEST(EvaluatorTests, InstantiateObjectHashConsed) {
+  DialectRegistry registry;
+  registry.insert<OMDialect>();
+
+  MLIRContext context(registry);
+  context.getOrLoadDialect<OMDialect>();
+
+  Location loc(UnknownLoc::get(&context));
+
+  ImplicitLocOpBuilder builder(loc, &context);
+
+  auto mod = builder.create<ModuleOp>(loc);
+
+  builder.setInsertionPointToStart(&mod.getBodyRegion().front());
+  StringRef params[] = {"param"};
+  auto cls = builder.create<ClassOp>("MyClass", params);
+  auto &body = cls.getBody().emplaceBlock();
+  body.addArgument(builder.getIntegerType(32), cls.getLoc());
+  builder.setInsertionPointToStart(&body);
+  builder.create<ClassFieldOp>("field", body.getArgument(0));
+
+  Evaluator evaluator(mod);
+
+  auto className = builder.getStringAttr("MyClass");
+  auto first =
+      evaluator.instantiate(className, {builder.getI32IntegerAttr(42)});
+  auto second =
+      evaluator.instantiate(className, {builder.getI32IntegerAttr(42)});
+  auto third =
+      evaluator.instantiate(className, {builder.getI32IntegerAttr(43)});
+
+  ASSERT_TRUE(succeeded(first));
+  ASSERT_TRUE(succeeded(second));
+  ASSERT_TRUE(succeeded(third));
+
+  ASSERT_EQ(first.value(), second.value());
+  ASSERT_NE(first.value(), third.value());
+}
+
+TEST(EvaluatorTests, SerializeObjectWithSharedChildObject) {
+  DialectRegistry registry;
+  registry.insert<OMDialect>();
+
+  MLIRContext context(registry);
+  context.getOrLoadDialect<OMDialect>();
+
+  Location loc(UnknownLoc::get(&context));
+
+  ImplicitLocOpBuilder builder(loc, &context);
+
+  auto mod = builder.create<ModuleOp>(loc);
+
+  builder.setInsertionPointToStart(&mod.getBodyRegion().front());
+  auto innerCls = builder.create<ClassOp>("MyInnerClass");
+  auto &innerBody = innerCls.getBody().emplaceBlock();
+  builder.setInsertionPointToStart(&innerBody);
+  auto constant = builder.create<ConstantOp>(builder.getI32IntegerAttr(42));
+  builder.create<ClassFieldOp>("field", constant);
+
+  builder.setInsertionPointToStart(&mod.getBodyRegion().front());
+  auto cls = builder.create<ClassOp>("MyClass");
+  auto &body = cls.getBody().emplaceBlock();
+  builder.setInsertionPointToStart(&body);
+  auto object = builder.create<ObjectOp>(innerCls, body.getArguments());
+  builder.create<ClassFieldOp>("field1", object);
+  builder.create<ClassFieldOp>("field2", object);
+
+  Evaluator evaluator(mod);
+
+  auto result = evaluator.instantiate(builder.getStringAttr("MyClass"), {});
+
+  ASSERT_TRUE(succeeded(result));
+
+  std::string json;
+  llvm::raw_string_ostream os(json);
+  llvm::json::OStream jsonStream(os);
+
+  ASSERT_TRUE(succeeded(serializeJSON(result.value(), jsonStream)));
+
+  ASSERT_EQ(os.str(), "{\"$id\":0,\"$class\":\"MyClass\","
+                      "\"field1\":{\"$id\":1,\"$class\":\"MyInnerClass\","
+                      "\"field\":42},\"field2\":{\"$ref\":1}}");
+}
+
 } // namespace
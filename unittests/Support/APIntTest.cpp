@@ -0,0 +1,47 @@
+//===- APIntTest.cpp - APInt helper unit tests ----------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "circt/Support/APInt.h"
+#include "llvm/ADT/APSInt.h"
+#include "gtest/gtest.h"
+
+using namespace circt;
+
+namespace {
+
+TEST(APIntTest, SextZeroWidth) {
+  // Zero-width values are zero extended.
+  ASSERT_EQ(APInt(8, 0), sextZeroWidth(APInt(0, 0), 8));
+
+  // Other values are sign extended.
+  ASSERT_EQ(APInt(8, 0xfe), sextZeroWidth(APInt(2, 2), 8));
+  ASSERT_EQ(APInt(128, -2, /*isSigned=*/true),
+            sextZeroWidth(APInt(64, -2, /*isSigned=*/true), 128));
+
+  // Values of the requested width are returned as is.
+  ASSERT_EQ(APInt(0, 0), sextZeroWidth(APInt(0, 0), 0));
+  ASSERT_EQ(APInt(128, 42), sextZeroWidth(APInt(128, 42), 128));
+}
+
+TEST(APIntTest, ExtOrTruncZeroWidth) {
+  // Zero-width values are zero extended, and keep their signedness.
+  auto zero = extOrTruncZeroWidth(APSInt(APInt(0, 0), false), 8);
+  ASSERT_EQ(APInt(8, 0), zero);
+  ASSERT_FALSE(zero.isUnsigned());
+
+  // Signed values are sign extended, unsigned values zero extended.
+  ASSERT_EQ(APInt(8, 0xfe),
+            extOrTruncZeroWidth(APSInt(APInt(2, 2), false), 8));
+  ASSERT_EQ(APInt(8, 2), extOrTruncZeroWidth(APSInt(APInt(2, 2), true), 8));
+
+  // Values are truncated, or returned as is.
+  ASSERT_EQ(APInt(4, 5), extOrTruncZeroWidth(APSInt(APInt(8, 0x25)), 4));
+  ASSERT_EQ(APInt(8, 0x25), extOrTruncZeroWidth(APSInt(APInt(8, 0x25)), 8));
+}
+
+} // namespace
@@ -0,0 +1,53 @@
+//===- BackedgeBuilderTest.cpp - BackedgeBuilder unit tests ---------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "circt/Support/BackedgeBuilder.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "gtest/gtest.h"
+
+using namespace mlir;
+using namespace circt;
+
+namespace {
+
+TEST(BackedgeBuilderTest, BulkBackedges) {
+  MLIRContext context;
+  Location loc = UnknownLoc::get(&context);
+  OwningOpRef<ModuleOp> module = ModuleOp::create(loc);
+  OpBuilder builder = OpBuilder::atBlockEnd(module->getBody());
+  auto i1 = builder.getI1Type();
+  auto i8 = builder.getIntegerType(8);
+
+  BackedgeBuilder bb(builder, loc);
+  SmallVector<Type> types = {i1, i8};
+  auto backedges = bb.get(types);
+  ASSERT_EQ(2u, backedges.size());
+  Value a = backedges[0], b = backedges[1];
+  EXPECT_EQ(i1, a.getType());
+  EXPECT_EQ(i8, b.getType());
+
+  // Both backedges share a single cursor op.
+  EXPECT_EQ(a.getDefiningOp(), b.getDefiningOp());
+  auto user = builder.create<UnrealizedConversionCastOp>(
+      loc, TypeRange{}, ValueRange{a, b});
+
+  // Setting the backedges replaces their uses.
+  auto values = builder.create<UnrealizedConversionCastOp>(
+      loc, TypeRange{i1, i8}, ValueRange{});
+  backedges[0].setValue(values.getResult(0));
+  backedges[1].setValue(values.getResult(1));
+  EXPECT_EQ(values.getResult(0), user.getOperand(0));
+  EXPECT_EQ(values.getResult(1), user.getOperand(1));
+
+  // The cursor op is erased once none of the backedges is in use anymore.
+  EXPECT_TRUE(succeeded(bb.clearOrEmitError()));
+  EXPECT_EQ(2u, module->getBody()->getOperations().size());
+}
+
+} // namespace
@@ -86,4 +86,54 @@ TEST(JSONTest, RoundTripTypes) {
   EXPECT_EQ(2, dictField.getAs<IntegerAttr>("y").getValue());
 }
 
+TEST(JSONTest, ParseToAttribute) {
+  MLIRContext context;
+
+  // Parsing directly to an attribute must agree with going through the JSON
+  // library.
+  StringRef inputs[] = {
+      R"({"class": "a", "target": "~Foo|Bar>baz", "x": [1, -2, 3.5]})",
+      R"([true, false, null, {}, [], "", 1.0, 1e3, 18446744073709551615])",
+      R"({"nested": "{\"a\": [1, \"2\"]}", "number": "0", "str": "{"})",
+      R"(  ["escapes \"\\\/\b\f\n\r\t", "\u00e9\ud83d\ude00\ud800"]  )",
+  };
+  for (auto input : inputs) {
+    auto jsonValue = json::parse(input);
+    ASSERT_TRUE(bool(jsonValue));
+    json::Path::Root root;
+    auto expected = convertJSONToAttribute(&context, jsonValue.get(), root);
+    EXPECT_EQ(expected, parseJSONToAttribute(&context, input)) << input;
+  }
+
+  // Malformed JSON is rejected.
+  EXPECT_FALSE(parseJSONToAttribute(&context, "[1, 2"));
+  EXPECT_FALSE(parseJSONToAttribute(&context, "{\"a\": 1} x"));
+  EXPECT_FALSE(parseJSONToAttribute(&context, "{\"a\": 1, \"a\": 2}"));
+  EXPECT_FALSE(parseJSONToAttribute(&context, "\"tab\there\""));
+}
+
+TEST(JSONTest, ParseArrayToAttributes) {
+  MLIRContext context;
+
+  SmallVector<Attribute> elements;
+  auto collect = [&](Attribute attr) {
+    elements.push_back(attr);
+    return success();
+  };
+  ASSERT_TRUE(succeeded(parseJSONArrayToAttributes(
+      &context, R"([{"class": "a"}, {"class": "b"}])", collect)));
+  ASSERT_EQ(2u, elements.size());
+  EXPECT_EQ("b", elements[1]
+                     .cast<DictionaryAttr>()
+                     .getAs<StringAttr>("class")
+                     .getValue());
+
+  elements.clear();
+  ASSERT_TRUE(succeeded(parseJSONArrayToAttributes(&context, "[]", collect)));
+  EXPECT_TRUE(elements.empty());
+  EXPECT_TRUE(failed(parseJSONArrayToAttributes(&context, "{}", collect)));
+  EXPECT_TRUE(failed(parseJSONArrayToAttributes(
+      &context, "[1, 2]", [](Attribute) { return failure(); })));
+}
+
 } // namespace
@@ -0,0 +1,44 @@
+//===- NamespaceTest.cpp - Namespace unit tests ---------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "circt/Support/Namespace.h"
+#include "gtest/gtest.h"
+
+using namespace circt;
+
+namespace {
+
+TEST(NamespaceTest, NewName) {
+  Namespace ns;
+  ASSERT_EQ("a", ns.newName("a"));
+  ASSERT_EQ("a_0", ns.newName("a"));
+  ASSERT_EQ("a_1", ns.newName("a"));
+
+  // Names which are taken explicitly are skipped.
+  ASSERT_EQ("b_1", ns.newName("b_1"));
+  ASSERT_EQ("b", ns.newName("b"));
+  ASSERT_EQ("b_0", ns.newName("b"));
+  ASSERT_EQ("b_2", ns.newName("b"));
+
+  // Names built from twines are handled like flat strings.
+  ASSERT_EQ("a_2", ns.newName(Twine("a")));
+  ASSERT_EQ("ab_0", ns.newName(Twine("a") + "b_0"));
+  ASSERT_EQ("ab", ns.newName(Twine("a") + "b"));
+  ASSERT_EQ("ab_1", ns.newName(Twine("a") + "b"));
+}
+
+TEST(NamespaceTest, NewNameWithSuffix) {
+  Namespace ns;
+  ASSERT_EQ("a_x", ns.newName("a", "x"));
+  ASSERT_EQ("a_0_x", ns.newName("a", "x"));
+  ASSERT_EQ("a_1_x", ns.newName("a", "x"));
+  ASSERT_EQ("a", ns.newName("a"));
+  ASSERT_EQ("a_0", ns.newName("a"));
+}
+
+} // namespace
@@ -345,6 +345,28 @@ TEST(PrettyPrinterTest, Builder) {
   EXPECT_EQ(out.str(), StringRef("test\ntest\ntest"));
 }
 
+TEST(PrettyPrinterTest, FlushResolvedTokens) {
+  SmallString<128> out;
+  raw_svector_ostream os(out);
+
+  PrettyPrinter pp(os, 20);
+  TokenBuilder<> b(pp);
+  {
+    b.ibox();
+    b.literal("a");
+    b.space();
+    b.literal("b");
+    b.end();
+  }
+  b.space();
+  // The size of the group is known once the outer break is added, so it is
+  // printed right away instead of waiting for more tokens.
+  EXPECT_EQ(out.str(), StringRef("a b"));
+  b.literal("c");
+  b.eof();
+  EXPECT_EQ(out.str(), StringRef("a b c"));
+}
+
 TEST(PrettyPrinterTest, Stream) {
   SmallString<128> out;
   raw_svector_ostream os(out);
@@ -0,0 +1,243 @@
+#!/usr/bin/env python3
+"""
+Measure the throughput of Verilog emission on synthetic designs.
+
+This script generates parametric HW/SV designs that stress different parts of
+ExportVerilog, runs them through `circt-opt`, and reports the wall time,
+throughput, and peak memory of each stage as JSON.  The designs are:
+
+  wide-expr        a single module with a large tree of combinational logic
+  deep-hierarchy   a long chain of modules, each instantiating the next
+  big-always       a single always block assigning many registers
+  many-modules     many small modules instantiated from a top module
+
+The stages are:
+
+  prepare          `prepare-for-emission` on every module
+  export           `export-verilog`, which includes name legalization and
+                   preparation
+
+Example:
+
+  ./utils/benchmark-export-verilog.py --circt-opt build/bin/circt-opt \\
+      --scale 4 -o results.json
+"""
+
+import argparse
+import json
+import os
+import sys
+import tempfile
+
+from benchmark_process import run_process
+
+#===----------------------------------------------------------------------===//
+# Design Generators
+#===----------------------------------------------------------------------===//
+
+
+def gen_wide_expr(scale):
+  """A balanced tree of alternating add/xor over many inputs."""
+  n = 1024 * scale
+  lines = []
+  ports = ", ".join(f"%in{i}: i32" for i in range(n))
+  lines.append(f"hw.module @WideExpr({ports}) -> (out: i32) {{")
+  values = [f"%in{i}" for i in range(n)]
+  ops = 0
+  level = 0
+  while len(values) > 1:
+    op = "comb.add" if level % 2 == 0 else "comb.xor"
+    next_values = []
+    for i in range(0, len(values) - 1, 2):
+      name = f"%l{level}_{i // 2}"
+      lines.append(f"  {name} = {op} {values[i]}, {values[i + 1]} : i32")
+      next_values.append(name)
+      ops += 1
+    if len(values) % 2:
+      next_values.append(values[-1])
+    values = next_values
+    level += 1
+  lines.append(f"  hw.output {values[0]} : i32")
+  lines.append("}")
+  return "\n".join(lines), ops + 2
+
+
+def gen_deep_hierarchy(scale):
+  """A chain of modules, each adding one to the output of the next."""
+  depth = 512 * scale
+  lines = []
+  ops = 0
+  lines.append(f"hw.module @Level{depth}(%a: i16) -> (out: i16) {{")
+  lines.append("  hw.output %a : i16")
+  lines.append("}")
+  for i in reversed(range(depth)):
+    lines.append(f"hw.module @Level{i}(%a: i16) -> (out: i16) {{")
+    lines.append("  %c1 = hw.constant 1 : i16")
+    lines.append("  %0 = comb.add %a, %c1 : i16")
+    lines.append(f"  %1 = hw.instance \"child\" @Level{i + 1}(a: %0: i16) "
+                 "-> (out: i16)")
+    lines.append("  hw.output %1 : i16")
+    lines.append("}")
+    ops += 5
+  return "\n".join(lines), ops + 2
+
+
+def gen_big_always(scale):
+  """A single always block conditionally assigning many registers."""
+  n = 4096 * scale
+  lines = []
+  lines.append("hw.module @BigAlways(%clock: i1, %cond: i1, %a: i8, %b: i8) {")
+  ops = 1
+  for i in range(n):
+    lines.append(f"  %r{i} = sv.reg : !hw.inout<i8>")
+    ops += 1
+  lines.append("  sv.always posedge %clock {")
+  lines.append("    sv.if %cond {")
+  for i in range(n):
+    operand = "%a" if i % 2 == 0 else "%b"
+    lines.append(f"      sv.passign %r{i}, {operand} : i8")
+    ops += 1
+  lines.append("    }")
+  lines.append("  }")
+  lines.append("  hw.output")
+  lines.append("}")
+  return "\n".join(lines), ops + 3
+
+
+def gen_many_modules(scale):
+  """Many small modules, all instantiated from a top module."""
+  n = 2048 * scale
+  lines = []
+  ops = 0
+  for i in range(n):
+    lines.append(f"hw.module @Small{i}(%a: i8, %b: i8) -> (out: i8) {{")
+    lines.append("  %0 = comb.and %a, %b : i8")
+    lines.append("  %1 = comb.xor %0, %a : i8")
+    lines.append("  hw.output %1 : i8")
+    lines.append("}")
+    ops += 4
+  lines.append("hw.module @Top(%a: i8, %b: i8) -> (out: i8) {")
+  value = "%a"
+  for i in range(n):
+    lines.append(f"  %s{i} = hw.instance \"small{i}\" @Small{i}"
+                 f"(a: {value}: i8, b: %b: i8) -> (out: i8)")
+    value = f"%s{i}"
+    ops += 1
+  lines.append(f"  hw.output {value} : i8")
+  lines.append("}")
+  return "\n".join(lines), ops + 2
+
+
+DESIGNS = {
+    "wide-expr": gen_wide_expr,
+    "deep-hierarchy": gen_deep_hierarchy,
+    "big-always": gen_big_always,
+    "many-modules": gen_many_modules,
+}
+
+STAGES = {
+    "prepare": [
+        "--pass-pipeline=builtin.module(hw.module(prepare-for-emission))",
+        "-o", os.devnull
+    ],
+    "export": ["--export-verilog", "-o", os.devnull],
+}
+
+#===----------------------------------------------------------------------===//
+# Measurement
+#===----------------------------------------------------------------------===//
+
+
+def run_stage(circt_opt, input_path, stage_args):
+  """Run `circt-opt` once and return its wall time, peak RSS, and stdout size.
+
+  The Verilog produced by ExportVerilog is written to stdout, so the number of
+  bytes written there is the size of the emitted output.
+  """
+  result = run_process([circt_opt, input_path] + stage_args)
+  if result.returncode != 0:
+    sys.stderr.write(result.stderr)
+    raise RuntimeError(f"circt-opt failed with exit code {result.returncode}")
+  return result.seconds, result.peak_rss_bytes, result.stdout_bytes
+
+
+def benchmark(circt_opt, designs, stages, scale, repeat):
+  results = []
+  with tempfile.TemporaryDirectory() as tmpdir:
+    for design in designs:
+      text, num_ops = DESIGNS[design](scale)
+      input_path = os.path.join(tmpdir, f"{design}.mlir")
+      with open(input_path, "w") as f:
+        f.write(text)
+      input_bytes = len(text)
+      for stage in stages:
+        # Keep the fastest run to reduce noise from the rest of the system.
+        best = None
+        for _ in range(repeat):
+          run = run_stage(circt_opt, input_path, STAGES[stage])
+          if best is None or run[0] < best[0]:
+            best = run
+        elapsed, peak_rss, output_bytes = best
+        result = {
+            "design": design,
+            "stage": stage,
+            "scale": scale,
+            "ops": num_ops,
+            "input_bytes": input_bytes,
+            "output_bytes": output_bytes,
+            "seconds": elapsed,
+            "ops_per_second": num_ops / elapsed,
+            "peak_rss_bytes": peak_rss,
+        }
+        if stage == "export":
+          result["output_mb_per_second"] = output_bytes / elapsed / 1e6
+        results.append(result)
+        print(f"{design:>16} {stage:>8}: {elapsed:8.3f}s "
+              f"{num_ops / elapsed:12.0f} ops/s "
+              f"{peak_rss / 1e6:8.1f} MB peak",
+              file=sys.stderr)
+  return results
+
+
+def main():
+  parser = argparse.ArgumentParser(
+      description=__doc__, formatter_class=argparse.RawTextHelpFormatter)
+  parser.add_argument("--circt-opt",
+                      default="circt-opt",
+                      help="Path to the circt-opt binary")
+  parser.add_argument("--design",
+                      action="append",
+                      choices=sorted(DESIGNS),
+                      help="Design to run; may be repeated (default: all)")
+  parser.add_argument("--stage",
+                      action="append",
+                      choices=sorted(STAGES),
+                      help="Stage to run; may be repeated (default: all)")
+  parser.add_argument("--scale",
+                      type=int,
+                      default=1,
+                      help="Multiplier for the size of the designs")
+  parser.add_argument("--repeat",
+                      type=int,
+                      default=3,
+                      help="Number of runs per measurement; the fastest is "
+                      "reported")
+  parser.add_argument("-o",
+                      "--output",
+                      default="-",
+                      help="File to write the JSON results to (default: "
+                      "stdout)")
+  args = parser.parse_args()
+
+  results = benchmark(args.circt_opt, args.design or list(DESIGNS),
+                      args.stage or list(STAGES), args.scale, args.repeat)
+  report = json.dumps({"benchmarks": results}, indent=2)
+  if args.output == "-":
+    print(report)
+  else:
+    with open(args.output, "w") as f:
+      f.write(report + "\n")
+
+
+if __name__ == "__main__":
+  main()
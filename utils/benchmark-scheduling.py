@@ -0,0 +1,203 @@
+#!/usr/bin/env python3
+"""
+Compare the runtime and solution quality of the schedulers on SSP problems.
+
+This script reads SSP files, runs every scheduler that applies to each problem
+instance in them through `circt-opt -ssp-schedule`, and reports the solve time,
+the objective, and the peak memory of each run as JSON.  Each top-level
+`ssp.instance` is scheduled in isolation.  The objective is the initiation
+interval (for cyclic problems) and the start time of the last operation.
+
+The schedulers and the problems they apply to are:
+
+  asap             Problem
+  simplex          Problem, CyclicProblem, SharedOperatorsProblem,
+                   ModuloProblem, ChainingProblem (requires --cycle-time)
+  lp               Problem, CyclicProblem (requires OR-Tools)
+  cpsat            SharedOperatorsProblem (requires OR-Tools)
+
+Problems from real designs can be dumped with e.g.
+`-convert-affine-to-loopschedule=problem-dump-dir=<dir>`.
+
+Example:
+
+  ./utils/benchmark-scheduling.py --circt-opt build/bin/circt-opt \\
+      --timeout 60 -o results.json problems/*.mlir
+"""
+
+import argparse
+import json
+import os
+import re
+import sys
+import tempfile
+
+from benchmark_process import ProcessTimeout, run_process
+
+SCHEDULERS = {
+    "asap": ["Problem"],
+    "simplex": [
+        "Problem", "CyclicProblem", "SharedOperatorsProblem", "ModuloProblem",
+        "ChainingProblem"
+    ],
+    "lp": ["Problem", "CyclicProblem"],
+    "cpsat": ["SharedOperatorsProblem"],
+}
+
+#===----------------------------------------------------------------------===//
+# Problem Instances
+#===----------------------------------------------------------------------===//
+
+INSTANCE_RE = re.compile(r'^\s*ssp\.instance\s+(?:@(\S+)\s+)?of\s+"(\w+)"')
+
+
+def split_instances(text):
+  """Split the text of an SSP file into its top-level instances.
+
+  Returns a list of (name, problem, text) tuples.  Instances are found by
+  matching braces, starting at each line that begins an `ssp.instance`.
+  """
+  instances = []
+  lines = text.splitlines()
+  i = 0
+  while i < len(lines):
+    match = INSTANCE_RE.match(lines[i])
+    if not match:
+      i += 1
+      continue
+    name = match.group(1) or f"unnamed{len(instances)}"
+    depth = 0
+    body = []
+    while i < len(lines):
+      line = lines[i].split("//")[0]
+      body.append(lines[i])
+      depth += line.count("{") - line.count("}")
+      i += 1
+      if depth == 0 and "{" in "".join(body):
+        break
+    instances.append((name, match.group(2), "\n".join(body)))
+  return instances
+
+
+II_RE = re.compile(r"II<(\d+)>")
+START_TIME_RE = re.compile(r"\bt<(\d+)>")
+
+
+def parse_objective(output):
+  """Return the II and the last operation's start time of a scheduled instance.
+
+  The last operation is the one the schedulers minimize by default, i.e. the
+  last one in the dependence graph.
+  """
+  ii = None
+  last_start_time = None
+  for line in output.splitlines():
+    if INSTANCE_RE.match(line):
+      match = II_RE.search(line)
+      ii = int(match.group(1)) if match else None
+    elif "operation<" in line:
+      match = START_TIME_RE.search(line)
+      last_start_time = int(match.group(1)) if match else None
+  return ii, last_start_time
+
+
+#===----------------------------------------------------------------------===//
+# Measurement
+#===----------------------------------------------------------------------===//
+
+
+def run_scheduler(circt_opt, input_path, scheduler, options, timeout):
+  """Run `circt-opt` once and return its status, wall time, peak RSS and output.
+
+  The status is one of "ok", "failed" or "timeout".
+  """
+  pass_arg = f"-ssp-schedule=scheduler={scheduler}"
+  if options:
+    pass_arg += f" options={options}"
+  try:
+    result = run_process([circt_opt, input_path, pass_arg], timeout)
+  except ProcessTimeout:
+    return "timeout", timeout, None, None
+  if result.returncode != 0:
+    sys.stderr.write(result.stderr)
+    return "failed", result.seconds, result.peak_rss_bytes, None
+  return "ok", result.seconds, result.peak_rss_bytes, result.stdout
+
+
+def benchmark(circt_opt, inputs, schedulers, cycle_time, timeout):
+  results = []
+  with tempfile.TemporaryDirectory() as tmpdir:
+    for input_file in inputs:
+      with open(input_file) as f:
+        instances = split_instances(f.read())
+      for index, (name, problem, text) in enumerate(instances):
+        input_path = os.path.join(tmpdir, f"instance{index}.mlir")
+        with open(input_path, "w") as f:
+          f.write(text + "\n")
+        for scheduler in schedulers:
+          if problem not in SCHEDULERS[scheduler]:
+            continue
+          options = ""
+          if problem == "ChainingProblem":
+            if cycle_time is None:
+              continue
+            options = f"cycle-time={cycle_time}"
+          status, elapsed, peak_rss, output = run_scheduler(
+              circt_opt, input_path, scheduler, options, timeout)
+          result = {
+              "file": input_file,
+              "instance": name,
+              "problem": problem,
+              "scheduler": scheduler,
+              "status": status,
+              "seconds": elapsed,
+              "peak_rss_bytes": peak_rss,
+          }
+          if output is not None:
+            ii, last_start_time = parse_objective(output)
+            result["ii"] = ii
+            result["last_start_time"] = last_start_time
+          results.append(result)
+          print(f"{name:>24} {scheduler:>8}: {status:>7} {elapsed:8.3f}s",
+                file=sys.stderr)
+  return results
+
+
+def main():
+  parser = argparse.ArgumentParser(
+      description=__doc__, formatter_class=argparse.RawTextHelpFormatter)
+  parser.add_argument("inputs", nargs="+", help="SSP files to schedule")
+  parser.add_argument("--circt-opt",
+                      default="circt-opt",
+                      help="Path to the circt-opt binary")
+  parser.add_argument("--scheduler",
+                      action="append",
+                      choices=sorted(SCHEDULERS),
+                      help="Scheduler to run; may be repeated (default: all)")
+  parser.add_argument("--cycle-time",
+                      type=float,
+                      help="Cycle time for ChainingProblem instances; these "
+                      "are skipped if not given")
+  parser.add_argument("--timeout",
+                      type=float,
+                      default=300,
+                      help="Time limit per run in seconds; 0 disables it")
+  parser.add_argument("-o",
+                      "--output",
+                      default="-",
+                      help="File to write the JSON results to (default: "
+                      "stdout)")
+  args = parser.parse_args()
+
+  results = benchmark(args.circt_opt, args.inputs, args.scheduler or
+                      list(SCHEDULERS), args.cycle_time, args.timeout)
+  report = json.dumps({"benchmarks": results}, indent=2)
+  if args.output == "-":
+    print(report)
+  else:
+    with open(args.output, "w") as f:
+      f.write(report + "\n")
+
+
+if __name__ == "__main__":
+  main()
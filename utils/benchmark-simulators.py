@@ -0,0 +1,706 @@
+#!/usr/bin/env python3
+"""
+Compare the throughput of the CIRCT simulators on a shared set of designs.
+
+This script generates parametric designs, runs each of them through every
+simulator that accepts them, and reports the compile time, the simulation
+throughput in cycles per second, and the peak memory of each run as JSON.  The
+designs are:
+
+  counter-array    many independent counters, summed into one output
+  fifo             a register-based FIFO fed and drained by a free-running
+                   counter
+  core             small RISC-V-ish cores (an 8-entry register file, a ROM
+                   program with adds, xors and a backward branch)
+  memory           a large register-based memory written and read at
+                   different strides every cycle
+
+The simulators and the designs they run are:
+
+  arcilator        all designs, through `--run`
+  circt-rtl-sim    all designs, after exporting them to SystemVerilog
+  llhd-sim         counter-array, as one LLHD process per counter
+  handshake-runner counter-array and memory, as loops lowered through
+                   `-lower-std-to-handshake` and run with `--cycle-accurate`
+
+The HW designs are the same for arcilator and circt-rtl-sim, such that their
+numbers are directly comparable.  The LLHD and Handshake versions implement the
+same computation in the style of their dialect.  Compile time covers the
+lowering of the design into an executable model; for llhd-sim, which compiles
+in-process, it is the time of a run that stops after the first step, and is
+subtracted from the simulation time.
+
+Given a `--baseline` from an earlier run, the script exits with an error if the
+throughput of any benchmark dropped by more than `--threshold`.
+
+Example:
+
+  ./utils/benchmark-simulators.py --bin-dir build/bin --cycles 100000 \\
+      -o results.json
+"""
+
+import argparse
+import json
+import os
+import re
+import shutil
+import sys
+import tempfile
+
+from benchmark_process import ProcessTimeout, run_process
+
+#===----------------------------------------------------------------------===//
+# HW Designs
+#===----------------------------------------------------------------------===//
+
+
+def emit_select(lines, prefix, index, index_width, values, width):
+  """Emit a mux chain selecting `values[index]` and return its result."""
+  result = values[0]
+  for k in range(1, len(values)):
+    lines.append(f"  %{prefix}_k{k} = hw.constant {k} : i{index_width}")
+    lines.append(f"  %{prefix}_eq{k} = comb.icmp eq {index}, "
+                 f"%{prefix}_k{k} : i{index_width}")
+    lines.append(f"  %{prefix}_m{k} = comb.mux %{prefix}_eq{k}, {values[k]}, "
+                 f"{result} : i{width}")
+    result = f"%{prefix}_m{k}"
+  return result
+
+
+def hw_counter_array(scale):
+  n = 64 * scale
+  lines = ["hw.module @top(%clk: i1, %rst: i1) -> (out: i32) {"]
+  lines.append("  %c0 = hw.constant 0 : i32")
+  for i in range(n):
+    lines.append(f"  %inc{i} = hw.constant {i + 1} : i32")
+    lines.append(f"  %next{i} = comb.add %r{i}, %inc{i} : i32")
+    lines.append(f"  %r{i} = seq.compreg %next{i}, %clk, %rst, %c0 : i32")
+  counters = ", ".join(f"%r{i}" for i in range(n))
+  lines.append(f"  %out = comb.xor {counters} : i32")
+  lines.append("  hw.output %out : i32")
+  lines.append("}")
+  return "\n".join(lines)
+
+
+def hw_fifo(scale):
+  depth = 16 * scale
+  w = max(1, (depth - 1).bit_length())
+  cw = depth.bit_length()
+  lines = ["hw.module @top(%clk: i1, %rst: i1) -> (out: i32) {"]
+  lines += [
+      "  %true = hw.constant true",
+      "  %c0 = hw.constant 0 : i32",
+      "  %c1 = hw.constant 1 : i32",
+      f"  %p0 = hw.constant 0 : i{w}",
+      f"  %p1 = hw.constant 1 : i{w}",
+      f"  %plast = hw.constant {depth - 1} : i{w}",
+      f"  %n0 = hw.constant 0 : i{cw}",
+      f"  %n1 = hw.constant 1 : i{cw}",
+      f"  %ndepth = hw.constant {depth} : i{cw}",
+      # A free-running counter provides the data and the push/pop pattern.
+      "  %tick_next = comb.add %tick, %c1 : i32",
+      "  %tick = seq.compreg %tick_next, %clk, %rst, %c0 : i32",
+      "  %push = comb.extract %tick from 0 : (i32) -> i1",
+      "  %pop = comb.extract %tick from 1 : (i32) -> i1",
+      f"  %full = comb.icmp eq %count, %ndepth : i{cw}",
+      f"  %empty = comb.icmp eq %count, %n0 : i{cw}",
+      "  %not_full = comb.xor %full, %true : i1",
+      "  %not_empty = comb.xor %empty, %true : i1",
+      "  %do_push = comb.and %push, %not_full : i1",
+      "  %do_pop = comb.and %pop, %not_empty : i1",
+      "  %no_push = comb.xor %do_push, %true : i1",
+      "  %no_pop = comb.xor %do_pop, %true : i1",
+      "  %only_push = comb.and %do_push, %no_pop : i1",
+      "  %only_pop = comb.and %do_pop, %no_push : i1",
+      f"  %count_inc = comb.add %count, %n1 : i{cw}",
+      f"  %count_dec = comb.sub %count, %n1 : i{cw}",
+      f"  %count_pop = comb.mux %only_pop, %count_dec, %count : i{cw}",
+      f"  %count_next = comb.mux %only_push, %count_inc, %count_pop : i{cw}",
+      f"  %count = seq.compreg %count_next, %clk, %rst, %n0 : i{cw}",
+  ]
+  for ptr, enable in (("wptr", "%do_push"), ("rptr", "%do_pop")):
+    lines += [
+        f"  %{ptr}_last = comb.icmp eq %{ptr}, %plast : i{w}",
+        f"  %{ptr}_inc = comb.add %{ptr}, %p1 : i{w}",
+        f"  %{ptr}_wrap = comb.mux %{ptr}_last, %p0, %{ptr}_inc : i{w}",
+        f"  %{ptr}_next = comb.mux {enable}, %{ptr}_wrap, %{ptr} : i{w}",
+        f"  %{ptr} = seq.compreg %{ptr}_next, %clk, %rst, %p0 : i{w}",
+    ]
+  for i in range(depth):
+    lines += [
+        f"  %addr{i} = hw.constant {i} : i{w}",
+        f"  %hit{i} = comb.icmp eq %wptr, %addr{i} : i{w}",
+        f"  %we{i} = comb.and %do_push, %hit{i} : i1",
+        f"  %e{i}_next = comb.mux %we{i}, %tick, %e{i} : i32",
+        f"  %e{i} = seq.compreg %e{i}_next, %clk, %rst, %c0 : i32",
+    ]
+  head = emit_select(lines, "rd", "%rptr", w, [f"%e{i}" for i in range(depth)],
+                     32)
+  lines += [
+      f"  %dout_next = comb.mux %do_pop, {head}, %dout : i32",
+      "  %dout = seq.compreg %dout_next, %clk, %rst, %c0 : i32",
+      "  hw.output %dout : i32",
+      "}",
+  ]
+  return "\n".join(lines)
+
+
+# The program run by each core, as (opcode, rd, rs1, rs2, imm) tuples.  The
+# opcodes are 0 (add), 1 (addi), 2 (xor) and 3 (bne, jumping to imm).
+CORE_PROGRAM = [
+    (1, 1, 1, 0, 1),  # addi r1, r1, 1
+    (0, 2, 2, 1, 0),  # add  r2, r2, r1
+    (2, 3, 3, 2, 0),  # xor  r3, r3, r2
+    (1, 4, 3, 0, 5),  # addi r4, r3, 5
+    (0, 5, 4, 2, 0),  # add  r5, r4, r2
+    (2, 6, 6, 5, 0),  # xor  r6, r6, r5
+    (0, 7, 7, 6, 0),  # add  r7, r7, r6
+    (3, 0, 1, 0, 0),  # bne  r1, r0, 0
+]
+
+
+def encode_instruction(opcode, rd, rs1, rs2, imm):
+  return (opcode << 28) | (rd << 25) | (rs1 << 22) | (rs2 << 19) | imm
+
+
+def emit_core(lines, p):
+  """Emit one core with all its values prefixed by `p`."""
+  program = CORE_PROGRAM + [(0, 0, 0, 0, 0)] * (16 - len(CORE_PROGRAM))
+  rom = []
+  for i, instruction in enumerate(program):
+    lines.append(f"  %{p}_rom{i} = hw.constant "
+                 f"{encode_instruction(*instruction)} : i32")
+    rom.append(f"%{p}_rom{i}")
+  instr = emit_select(lines, f"{p}_fetch", f"%{p}_pc", 4, rom, 32)
+  lines += [
+      f"  %{p}_op = comb.extract {instr} from 28 : (i32) -> i4",
+      f"  %{p}_rd = comb.extract {instr} from 25 : (i32) -> i3",
+      f"  %{p}_rs1 = comb.extract {instr} from 22 : (i32) -> i3",
+      f"  %{p}_rs2 = comb.extract {instr} from 19 : (i32) -> i3",
+      f"  %{p}_imm16 = comb.extract {instr} from 0 : (i32) -> i16",
+      f"  %{p}_target = comb.extract {instr} from 0 : (i32) -> i4",
+      f"  %{p}_imm = comb.concat %z16, %{p}_imm16 : i16, i16",
+  ]
+  regs = ["%c0"] + [f"%{p}_r{i}" for i in range(1, 8)]
+  a = emit_select(lines, f"{p}_a", f"%{p}_rs1", 3, regs, 32)
+  b = emit_select(lines, f"{p}_b", f"%{p}_rs2", 3, regs, 32)
+  lines += [
+      f"  %{p}_is_addi = comb.icmp eq %{p}_op, %op1 : i4",
+      f"  %{p}_is_xor = comb.icmp eq %{p}_op, %op2 : i4",
+      f"  %{p}_is_bne = comb.icmp eq %{p}_op, %op3 : i4",
+      f"  %{p}_sum = comb.add {a}, {b} : i32",
+      f"  %{p}_sumi = comb.add {a}, %{p}_imm : i32",
+      f"  %{p}_xor = comb.xor {a}, {b} : i32",
+      f"  %{p}_res0 = comb.mux %{p}_is_xor, %{p}_xor, %{p}_sum : i32",
+      f"  %{p}_res = comb.mux %{p}_is_addi, %{p}_sumi, %{p}_res0 : i32",
+      f"  %{p}_wen = comb.xor %{p}_is_bne, %true : i1",
+  ]
+  for i in range(1, 8):
+    lines += [
+        f"  %{p}_hit{i} = comb.icmp eq %{p}_rd, %reg{i} : i3",
+        f"  %{p}_we{i} = comb.and %{p}_wen, %{p}_hit{i} : i1",
+        f"  %{p}_r{i}_next = comb.mux %{p}_we{i}, %{p}_res, %{p}_r{i} : i32",
+        f"  %{p}_r{i} = seq.compreg %{p}_r{i}_next, %clk, %rst, %c0 : i32",
+    ]
+  lines += [
+      f"  %{p}_ne = comb.icmp ne {a}, {b} : i32",
+      f"  %{p}_taken = comb.and %{p}_is_bne, %{p}_ne : i1",
+      f"  %{p}_pc_inc = comb.add %{p}_pc, %pc1 : i4",
+      f"  %{p}_pc_next = comb.mux %{p}_taken, %{p}_target, %{p}_pc_inc : i4",
+      f"  %{p}_pc = seq.compreg %{p}_pc_next, %clk, %rst, %pc0 : i4",
+  ]
+  return regs[1:]
+
+
+def hw_core(scale):
+  lines = ["hw.module @top(%clk: i1, %rst: i1) -> (out: i32) {"]
+  lines += [
+      "  %true = hw.constant true",
+      "  %c0 = hw.constant 0 : i32",
+      "  %z16 = hw.constant 0 : i16",
+      "  %pc0 = hw.constant 0 : i4",
+      "  %pc1 = hw.constant 1 : i4",
+      "  %op1 = hw.constant 1 : i4",
+      "  %op2 = hw.constant 2 : i4",
+      "  %op3 = hw.constant 3 : i4",
+  ]
+  lines += [f"  %reg{i} = hw.constant {i} : i3" for i in range(1, 8)]
+  regs = []
+  for core in range(scale):
+    regs += emit_core(lines, f"core{core}")
+  lines.append(f"  %out = comb.xor {', '.join(regs)} : i32")
+  lines.append("  hw.output %out : i32")
+  lines.append("}")
+  return "\n".join(lines)
+
+
+def hw_memory(scale):
+  # Round the number of words up to a power of two, such that the addresses
+  # wrap around naturally.
+  aw = (256 * scale - 1).bit_length()
+  words = 1 << aw
+  lines = ["hw.module @top(%clk: i1, %rst: i1) -> (out: i32) {"]
+  lines += [
+      "  %c0 = hw.constant 0 : i32",
+      "  %c1 = hw.constant 1 : i32",
+      f"  %a0 = hw.constant 0 : i{aw}",
+      f"  %wstride = hw.constant 7 : i{aw}",
+      f"  %rstride = hw.constant 3 : i{aw}",
+      "  %tick_next = comb.add %tick, %c1 : i32",
+      "  %tick = seq.compreg %tick_next, %clk, %rst, %c0 : i32",
+      f"  %waddr_next = comb.add %waddr, %wstride : i{aw}",
+      f"  %waddr = seq.compreg %waddr_next, %clk, %rst, %a0 : i{aw}",
+      f"  %raddr_next = comb.add %raddr, %rstride : i{aw}",
+      f"  %raddr = seq.compreg %raddr_next, %clk, %rst, %a0 : i{aw}",
+  ]
+  for i in range(words):
+    lines += [
+        f"  %addr{i} = hw.constant {i} : i{aw}",
+        f"  %we{i} = comb.icmp eq %waddr, %addr{i} : i{aw}",
+        f"  %m{i}_next = comb.mux %we{i}, %tick, %m{i} : i32",
+        f"  %m{i} = seq.compreg %m{i}_next, %clk, %rst, %c0 : i32",
+    ]
+  memory = [f"%m{i}" for i in range(words)]
+  rdata = emit_select(lines, "rd", "%raddr", aw, memory, 32)
+  lines += [
+      f"  %acc_next = comb.add %acc, {rdata} : i32",
+      "  %acc = seq.compreg %acc_next, %clk, %rst, %c0 : i32",
+      "  hw.output %acc : i32",
+      "}",
+  ]
+  return "\n".join(lines)
+
+
+#===----------------------------------------------------------------------===//
+# LLHD Designs
+#===----------------------------------------------------------------------===//
+
+# One cycle of the LLHD designs is this many picoseconds of simulation time.
+LLHD_PERIOD_PS = 1000
+
+
+def llhd_counter_array(scale):
+  n = 64 * scale
+  lines = [
+      "llhd.proc @counter(%inc: !llhd.sig<i32>) -> (%count: !llhd.sig<i32>) {",
+      "  cf.br ^loop",
+      "^loop:",
+      "  %period = llhd.constant_time #llhd.time<1ns, 0d, 0e>",
+      "  %delta = llhd.constant_time #llhd.time<0ns, 1d, 0e>",
+      "  %0 = llhd.prb %count : !llhd.sig<i32>",
+      "  %1 = llhd.prb %inc : !llhd.sig<i32>",
+      "  %2 = comb.add %0, %1 : i32",
+      "  llhd.drv %count, %2 after %delta : !llhd.sig<i32>",
+      "  llhd.wait for %period, ^loop",
+      "}",
+      "",
+      "llhd.entity @root() -> () {",
+      "  %c0 = hw.constant 0 : i32",
+  ]
+  for i in range(n):
+    lines += [
+        f"  %inc{i} = hw.constant {i + 1} : i32",
+        f"  %inc{i}_sig = llhd.sig \"inc{i}\" %inc{i} : i32",
+        f"  %count{i} = llhd.sig \"count{i}\" %c0 : i32",
+        f"  llhd.inst \"counter{i}\" @counter(%inc{i}_sig) -> (%count{i}) : "
+        "(!llhd.sig<i32>) -> (!llhd.sig<i32>)",
+    ]
+  lines.append("}")
+  return "\n".join(lines)
+
+
+#===----------------------------------------------------------------------===//
+# Standard Designs
+#===----------------------------------------------------------------------===//
+
+
+def std_counter_array(scale, cycles):
+  n = 8 * scale
+  accs = [f"%a{i}" for i in range(n)]
+  lines = ["func.func @main() -> i32 {"]
+  lines += [
+      "  %c0 = arith.constant 0 : index",
+      "  %c1 = arith.constant 1 : index",
+      f"  %cn = arith.constant {cycles} : index",
+      "  %z = arith.constant 0 : i32",
+  ]
+  lines += [f"  %inc{i} = arith.constant {i + 1} : i32" for i in range(n)]
+  init = ", ".join(["%c0"] + ["%z"] * n)
+  types = ", ".join(["index"] + ["i32"] * n)
+  args = ", ".join(["%i: index"] + [f"{acc}: i32" for acc in accs])
+  lines += [
+      f"  cf.br ^loop({init} : {types})",
+      f"^loop({args}):",
+      "  %cond = arith.cmpi slt, %i, %cn : index",
+      "  cf.cond_br %cond, ^body, ^exit",
+      "^body:",
+      "  %i_next = arith.addi %i, %c1 : index",
+  ]
+  lines += [f"  %n{i} = arith.addi %a{i}, %inc{i} : i32" for i in range(n)]
+  next_values = ", ".join(["%i_next"] + [f"%n{i}" for i in range(n)])
+  lines.append(f"  cf.br ^loop({next_values} : {types})")
+  lines.append("^exit:")
+  result = accs[0]
+  for i in range(1, n):
+    lines.append(f"  %x{i} = arith.xori {result}, {accs[i]} : i32")
+    result = f"%x{i}"
+  lines.append(f"  return {result} : i32")
+  lines.append("}")
+  return "\n".join(lines)
+
+
+def std_memory(scale, cycles):
+  words = 64 * scale
+  lines = [
+      "func.func @main() -> i32 {",
+      f"  %mem = memref.alloc() : memref<{words}xi32>",
+      "  %c0 = arith.constant 0 : index",
+      "  %c1 = arith.constant 1 : index",
+      f"  %cwords = arith.constant {words} : index",
+      f"  %cn = arith.constant {cycles} : index",
+      "  %one = arith.constant 1 : i32",
+      "  cf.br ^loop(%c0 : index)",
+      "^loop(%i: index):",
+      "  %cond = arith.cmpi slt, %i, %cn : index",
+      "  cf.cond_br %cond, ^body, ^exit",
+      "^body:",
+      "  %addr = arith.remui %i, %cwords : index",
+      f"  %0 = memref.load %mem[%addr] : memref<{words}xi32>",
+      "  %1 = arith.addi %0, %one : i32",
+      f"  memref.store %1, %mem[%addr] : memref<{words}xi32>",
+      "  %i_next = arith.addi %i, %c1 : index",
+      "  cf.br ^loop(%i_next : index)",
+      "^exit:",
+      f"  %2 = memref.load %mem[%c0] : memref<{words}xi32>",
+      "  return %2 : i32",
+      "}",
+  ]
+  return "\n".join(lines)
+
+
+# The implementation of each design in the input language of the simulators.
+# The Standard designs run a fixed number of loop iterations, which is derived
+# from the requested number of cycles.
+DESIGNS = {
+    "counter-array": {
+        "hw": hw_counter_array,
+        "llhd": llhd_counter_array,
+        "std": std_counter_array,
+    },
+    "fifo": {
+        "hw": hw_fifo
+    },
+    "core": {
+        "hw": hw_core
+    },
+    "memory": {
+        "hw": hw_memory,
+        "std": std_memory,
+    },
+}
+
+#===----------------------------------------------------------------------===//
+# Measurement
+#===----------------------------------------------------------------------===//
+
+
+class ToolError(Exception):
+  pass
+
+
+def run_tool(cmd, timeout, stdout_path=None):
+  """Run a command once and return its wall time, peak RSS, stdout and stderr.
+
+  Raises a ToolError if the command fails or runs into the timeout.
+  """
+  try:
+    result = run_process(cmd, timeout, stdout_path)
+  except ProcessTimeout as error:
+    raise ToolError(str(error))
+  if result.returncode != 0:
+    sys.stderr.write(result.stderr)
+    raise ToolError(f"`{cmd[0]}` failed with exit code {result.returncode}")
+  return result.seconds, result.peak_rss_bytes, result.stdout, result.stderr
+
+
+ARCILATOR_STATS_RE = re.compile(r"ran (\d+) cycles.* \((\d+) cycles/s\)")
+
+
+def bench_arcilator(tools, tmpdir, design_path, cycles, timeout):
+  compile_time, compile_rss, _, _ = run_tool(
+      [tools("arcilator"), design_path, "-o", os.devnull], timeout)
+  run_time, run_rss, _, errors = run_tool(
+      [tools("arcilator"), design_path, "--run", f"--run-cycles={cycles}"],
+      timeout)
+  # Use the throughput reported by arcilator, which does not include the time
+  # spent compiling the model.
+  match = ARCILATOR_STATS_RE.search(errors)
+  if not match:
+    raise ToolError("arcilator did not report its throughput")
+  return {
+      "compile_seconds": compile_time,
+      "run_seconds": run_time,
+      "cycles": int(match.group(1)),
+      "cycles_per_second": float(match.group(2)),
+      "peak_rss_bytes": max(compile_rss, run_rss),
+  }
+
+
+def bench_rtl_sim(tools, tmpdir, design_path, cycles, timeout, rtl_sim):
+  sv_path = os.path.join(tmpdir, "top.sv")
+  objdir = os.path.join(tmpdir, "rtl-sim")
+  export_time, export_rss, _, _ = run_tool(
+      [tools("circt-opt"), design_path, "--export-verilog", "-o", os.devnull],
+      timeout,
+      stdout_path=sv_path)
+  rtl_sim_cmd = [
+      tools("circt-rtl-sim.py"), sv_path, "--sim", rtl_sim, "--objdir", objdir
+  ]
+  compile_time, compile_rss, _, _ = run_tool(rtl_sim_cmd + ["--no-run"],
+                                             timeout)
+  run_time, run_rss, _, _ = run_tool(
+      rtl_sim_cmd + ["--no-compile", "--cycles",
+                     str(cycles)], timeout)
+  return {
+      "compile_seconds": export_time + compile_time,
+      "run_seconds": run_time,
+      "cycles": cycles,
+      "cycles_per_second": cycles / run_time,
+      "peak_rss_bytes": max(export_rss, compile_rss, run_rss),
+  }
+
+
+def bench_llhd_sim(tools, tmpdir, design_path, cycles, timeout, llhd_runtime):
+  sim_cmd = [
+      tools("llhd-sim"), design_path, "--trace-format=none", "-o", os.devnull
+  ]
+  if llhd_runtime:
+    sim_cmd.append(f"--shared-libs={llhd_runtime}")
+  # The design is compiled before the first step is taken.
+  compile_time, compile_rss, _, _ = run_tool(sim_cmd + ["-n", "1"], timeout)
+  run_time, run_rss, _, _ = run_tool(
+      sim_cmd + ["-T", str(cycles * LLHD_PERIOD_PS)], timeout)
+  sim_time = max(run_time - compile_time, 1e-9)
+  return {
+      "compile_seconds": compile_time,
+      "run_seconds": sim_time,
+      "cycles": cycles,
+      "cycles_per_second": cycles / sim_time,
+      "peak_rss_bytes": max(compile_rss, run_rss),
+  }
+
+
+CYCLES_RE = re.compile(r"^Cycles: (\d+)$", re.MULTILINE)
+
+
+def bench_handshake_runner(tools, tmpdir, design_path, cycles, timeout):
+  handshake_path = os.path.join(tmpdir, "handshake.mlir")
+  buffered_path = os.path.join(tmpdir, "buffered.mlir")
+  lower_time, lower_rss, _, _ = run_tool([
+      tools("circt-opt"), design_path, "-lower-std-to-handshake",
+      "-handshake-materialize-forks-sinks", "-o", handshake_path
+  ], timeout)
+  buffer_time, buffer_rss, _, _ = run_tool([
+      tools("circt-opt"), handshake_path,
+      "--handshake-insert-buffers=strategy=all", "-o", buffered_path
+  ], timeout)
+  run_time, run_rss, _, errors = run_tool(
+      [tools("handshake-runner"), buffered_path, "--cycle-accurate"], timeout)
+  match = CYCLES_RE.search(errors)
+  if not match:
+    raise ToolError("handshake-runner did not report the number of cycles")
+  simulated_cycles = int(match.group(1))
+  return {
+      "compile_seconds": lower_time + buffer_time,
+      "run_seconds": run_time,
+      "cycles": simulated_cycles,
+      "cycles_per_second": simulated_cycles / run_time,
+      "peak_rss_bytes": max(lower_rss, buffer_rss, run_rss),
+  }
+
+
+# The input language of each simulator, the binaries it needs, and the function
+# measuring it.
+SIMULATORS = {
+    "arcilator": ("hw", ["arcilator"], bench_arcilator),
+    "circt-rtl-sim": ("hw", ["circt-opt",
+                             "circt-rtl-sim.py"], bench_rtl_sim),
+    "llhd-sim": ("llhd", ["llhd-sim"], bench_llhd_sim),
+    "handshake-runner": ("std", ["circt-opt",
+                                 "handshake-runner"], bench_handshake_runner),
+}
+
+
+def make_tool_finder(bin_dir):
+  """Return a function which maps a tool name to its path, or None."""
+
+  def find(name):
+    if bin_dir:
+      path = os.path.join(bin_dir, name)
+      return path if os.path.exists(path) else None
+    return shutil.which(name)
+
+  return find
+
+
+def benchmark(tools, designs, simulators, scale, cycles, repeat, timeout,
+              extra_args):
+  results = []
+  for design in designs:
+    for simulator in simulators:
+      language, binaries, bench = SIMULATORS[simulator]
+      generator = DESIGNS[design].get(language)
+      if generator is None:
+        continue
+      result = {
+          "design": design,
+          "simulator": simulator,
+          "scale": scale,
+      }
+      missing = [binary for binary in binaries if tools(binary) is None]
+      if missing:
+        result["status"] = "unavailable"
+        results.append(result)
+        print(f"{design:>14} {simulator:>16}: missing {', '.join(missing)}",
+              file=sys.stderr)
+        continue
+
+      with tempfile.TemporaryDirectory() as tmpdir:
+        if language == "std":
+          text = generator(scale, cycles)
+        else:
+          text = generator(scale)
+        design_path = os.path.join(tmpdir, f"{design}.mlir")
+        with open(design_path, "w") as f:
+          f.write(text + "\n")
+        # Keep the run with the highest throughput to reduce noise from the
+        # rest of the system.
+        best = None
+        try:
+          for _ in range(repeat):
+            run = bench(tools, tmpdir, design_path, cycles, timeout,
+                        *extra_args.get(simulator, []))
+            if best is None or run["cycles_per_second"] > best[
+                "cycles_per_second"]:
+              best = run
+        except ToolError as error:
+          result["status"] = "failed"
+          results.append(result)
+          print(f"{design:>14} {simulator:>16}: {error}", file=sys.stderr)
+          continue
+
+      result["status"] = "ok"
+      result.update(best)
+      results.append(result)
+      print(f"{design:>14} {simulator:>16}: "
+            f"{best['compile_seconds']:8.3f}s compile "
+            f"{best['cycles_per_second']:14.0f} cycles/s "
+            f"{best['peak_rss_bytes'] / 1e6:8.1f} MB peak",
+            file=sys.stderr)
+  return results
+
+
+def find_regressions(results, baseline, threshold):
+  """Return the benchmarks whose throughput dropped below the baseline by more
+  than the given fraction."""
+  previous = {(r["design"], r["simulator"], r["scale"]): r
+              for r in baseline["benchmarks"]
+              if r.get("status") == "ok"}
+  regressions = []
+  for result in results:
+    if result["status"] != "ok":
+      continue
+    old = previous.get((result["design"], result["simulator"], result["scale"]))
+    if old is None:
+      continue
+    ratio = result["cycles_per_second"] / old["cycles_per_second"]
+    if ratio < 1 - threshold:
+      regressions.append((result, ratio))
+  return regressions
+
+
+def main():
+  parser = argparse.ArgumentParser(
+      description=__doc__, formatter_class=argparse.RawTextHelpFormatter)
+  parser.add_argument("--bin-dir",
+                      help="Directory containing the CIRCT binaries (default: "
+                      "search PATH)")
+  parser.add_argument("--design",
+                      action="append",
+                      choices=sorted(DESIGNS),
+                      help="Design to run; may be repeated (default: all)")
+  parser.add_argument("--simulator",
+                      action="append",
+                      choices=sorted(SIMULATORS),
+                      help="Simulator to run; may be repeated (default: all)")
+  parser.add_argument("--scale",
+                      type=int,
+                      default=1,
+                      help="Multiplier for the size of the designs")
+  parser.add_argument("--cycles",
+                      type=int,
+                      default=10000,
+                      help="Number of cycles to simulate")
+  parser.add_argument("--repeat",
+                      type=int,
+                      default=3,
+                      help="Number of runs per measurement; the fastest is "
+                      "reported")
+  parser.add_argument("--timeout",
+                      type=float,
+                      default=600,
+                      help="Time limit per tool invocation in seconds; 0 "
+                      "disables it")
+  parser.add_argument("--rtl-sim",
+                      default="verilator",
+                      help="RTL simulator used by circt-rtl-sim")
+  parser.add_argument("--llhd-runtime",
+                      help="Path to the LLHD signals runtime library "
+                      "(default: the one next to --bin-dir)")
+  parser.add_argument("--baseline",
+                      help="JSON results of an earlier run to compare against")
+  parser.add_argument("--threshold",
+                      type=float,
+                      default=0.1,
+                      help="Fraction by which the throughput may drop below "
+                      "the baseline before it is reported as a regression")
+  parser.add_argument("-o",
+                      "--output",
+                      default="-",
+                      help="File to write the JSON results to (default: "
+                      "stdout)")
+  args = parser.parse_args()
+
+  llhd_runtime = args.llhd_runtime
+  if llhd_runtime is None and args.bin_dir:
+    llhd_runtime = os.path.join(args.bin_dir, os.pardir, "lib",
+                                "libcirct-llhd-signals-runtime-wrappers.so")
+  extra_args = {
+      "circt-rtl-sim": [args.rtl_sim],
+      "llhd-sim": [llhd_runtime],
+  }
+
+  results = benchmark(make_tool_finder(args.bin_dir), args.design or
+                      list(DESIGNS), args.simulator or list(SIMULATORS),
+                      args.scale, args.cycles, args.repeat, args.timeout,
+                      extra_args)
+  report = json.dumps({"benchmarks": results}, indent=2)
+  if args.output == "-":
+    print(report)
+  else:
+    with open(args.output, "w") as f:
+      f.write(report + "\n")
+
+  if args.baseline:
+    with open(args.baseline) as f:
+      regressions = find_regressions(results, json.load(f), args.threshold)
+    for result, ratio in regressions:
+      print(f"regression: {result['design']} on {result['simulator']} runs at "
+            f"{ratio:.0%} of the baseline throughput",
+            file=sys.stderr)
+    if regressions:
+      sys.exit(1)
+
+
+if __name__ == "__main__":
+  main()
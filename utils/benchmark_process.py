@@ -0,0 +1,73 @@
+"""
+Run and measure the tools driven by the benchmark scripts in this directory.
+
+The scripts import this module from their own directory, e.g.
+`utils/benchmark-simulators.py`, which Python puts on the module search path
+when running a script.
+"""
+
+import os
+import signal
+import subprocess
+import tempfile
+import time
+
+
+class ProcessTimeout(Exception):
+  pass
+
+
+class ProcessResult:
+  """The outcome of a finished process.
+
+  `stdout` is the decoded output of the process, or an empty string if the
+  output was written to a file.  `stdout_bytes` is the size of the output in
+  either case.
+  """
+
+  def __init__(self, returncode, seconds, peak_rss_bytes, stdout, stdout_bytes,
+               stderr):
+    self.returncode = returncode
+    self.seconds = seconds
+    self.peak_rss_bytes = peak_rss_bytes
+    self.stdout = stdout
+    self.stdout_bytes = stdout_bytes
+    self.stderr = stderr
+
+
+def run_process(cmd, timeout=None, stdout_path=None):
+  """Run a command to completion and return a ProcessResult.
+
+  The peak RSS is the largest of the process and any subprocesses it waited
+  for, such that wrapper scripts report the memory of the tool they run.  The
+  output is written to `stdout_path` if given.  Raises a ProcessTimeout, after
+  killing the process, if it runs for longer than `timeout` seconds.
+  """
+  with tempfile.TemporaryFile() as stdout, tempfile.TemporaryFile() as stderr:
+    out = open(stdout_path, "wb") if stdout_path else stdout
+    try:
+      start = time.perf_counter()
+      proc = subprocess.Popen(cmd, stdout=out, stderr=stderr)
+      # Poll instead of waiting, such that the run can be cut off at the
+      # timeout while still getting the resource usage of the process.
+      while True:
+        pid, status, rusage = os.wait4(proc.pid, os.WNOHANG)
+        if pid != 0:
+          break
+        if timeout and time.perf_counter() - start > timeout:
+          proc.send_signal(signal.SIGKILL)
+          os.wait4(proc.pid, 0)
+          raise ProcessTimeout(f"`{cmd[0]}` timed out after {timeout}s")
+        time.sleep(0.005)
+      elapsed = time.perf_counter() - start
+      stdout_bytes = os.fstat(out.fileno()).st_size
+    finally:
+      if stdout_path:
+        out.close()
+    stderr.seek(0)
+    stdout.seek(0)
+    # `ru_maxrss` is reported in kilobytes on Linux.
+    return ProcessResult(os.waitstatus_to_exitcode(status), elapsed,
+                         rusage.ru_maxrss * 1024,
+                         stdout.read().decode(errors="replace"), stdout_bytes,
+                         stderr.read().decode(errors="replace"))